@@ -20,6 +20,9 @@
 #include "common/logging.h"
 #include "platform/platform.h"
 
+#include <map>
+#include <sstream>
+
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 #	include <jni.h>
 
@@ -109,6 +112,23 @@ inline const CreateAppFunc &get_create_func(const std::string &id)
 
 	return sample_iter->second;
 }
+
+inline std::vector<std::string> split_list(const std::string &list)
+{
+	std::vector<std::string> items;
+	std::stringstream        stream(list);
+	std::string              item;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
+		}
+	}
+
+	return items;
+}
 }        // namespace
 
 VulkanSamples::VulkanSamples()
@@ -117,7 +137,7 @@ VulkanSamples::VulkanSamples()
 	    R"(Vulkan Samples.
 	Usage:
 		vulkan_samples <sample>
-		vulkan_samples (--sample <arg> | --test <arg> | --batch <arg> [<tags>...]) [--benchmark <frames>] [--width <arg>] [--height <arg>] [--headless] 
+		vulkan_samples (--sample <arg> | --test <arg> | --batch <arg> [<tags>...]) [--benchmark <frames> [--warmup <frames>] [--benchmark-report <file>]] [--width <arg>] [--height <arg>] [--headless] [--counters <arg>] [--stats-stream <arg>] [--camera-path <arg>] [--target-fps <arg>] [--shared-context] [--hot-reload] [--defragment-memory] [--descriptor-buffers] [--scene-snapshots] [--async-log] [--render-thread] [--tune] [--no-device-profile] 
 		vulkan_samples --help
 
 	Options:
@@ -126,7 +146,22 @@ VulkanSamples::VulkanSamples()
 		--test TEST_ID            Run test.
 		--batch CATEGORY          Run all samples within a certain category, specify 'all' to run all.
 		--benchmark FRAMES        Run app under benchmark mode for n amount of frames.
-		--headless                Run the app with headless rendering.)"
+		--warmup FRAMES           Frames run before the benchmark of each sample starts recording [default: 0].
+		--benchmark-report FILE   Name of the JSON benchmark report, written in the logs directory [default: benchmark.json].
+		--headless                Run the app with headless rendering.
+		--counters NAMES          Comma separated regular expressions of the Vulkan performance counters to sample.
+		--stats-stream FILE       Stream every sample of the stats to a file in the logs directory, as CSV for a .csv name, otherwise as a Perfetto trace.
+		--camera-path FILE        Play a keyframed camera track, relative to the assets directory, instead of the camera input.
+		--target-fps FPS          Caps the frame rate, the frames are paced to the refresh cycles of the display on Android.
+		--shared-context          Keep the Vulkan instance and device alive across the samples of a batch run.
+		--hot-reload              Reload the shaders when their files change and rebuild the pipelines using them.
+		--defragment-memory       Move the buffers between frames to compact the device memory when it is fragmented.
+		--descriptor-buffers      Write the descriptors into descriptor buffers when the device supports them.
+		--scene-snapshots         Load the scenes from binary snapshots in the temporary directory, written on their first load.
+		--async-log               Write the log messages from a background thread, so that logging does not stall the frames.
+		--render-thread           Run the frames on a thread of their own, while the main thread processes the window events.
+		--tune                    With --batch and --benchmark, store the configuration of each sample with the lowest median frame time in the device profile of the GPU.
+		--no-device-profile       Run the samples with their default configuration, instead of the one tuned for the GPU.)"
 #ifndef VK_USE_PLATFORM_DISPLAY_KHR
 	    R"(
 		--width WIDTH             The width of the screen if visible [default: 1280].
@@ -146,6 +181,16 @@ bool VulkanSamples::prepare(Platform &platform)
 		return false;
 	}
 
+	if (is_benchmark_mode())
+	{
+		benchmark_report = std::make_unique<BenchmarkReport>(static_cast<uint32_t>(options.get_int("--warmup")));
+	}
+
+	if (!options.contains("--no-device-profile") || options.contains("--tune"))
+	{
+		device_profiles = std::make_unique<DeviceProfiles>();
+	}
+
 	auto result = false;
 
 	if (options.contains("--batch"))
@@ -184,6 +229,11 @@ bool VulkanSamples::prepare(Platform &platform)
 
 		this->batch_mode_sample_iter = batch_mode_sample_list.begin();
 
+		if (options.contains("--shared-context"))
+		{
+			shared_context = std::make_unique<SharedContext>();
+		}
+
 		result = prepare_active_app(
 		    sample_create_functions.at(batch_mode_sample_list.begin()->id),
 		    batch_mode_sample_list.begin()->name,
@@ -262,6 +312,32 @@ bool VulkanSamples::prepare_active_app(CreateAppFunc create_app_func, const std:
 		if (auto *active_app = dynamic_cast<vkb::VulkanSample *>(app))
 		{
 			active_app->get_configuration().reset();
+
+			if (shared_context)
+			{
+				active_app->set_shared_context(shared_context.get());
+			}
+
+			// Batch runs go through every configuration themselves
+			if (device_profiles && !batch && !options.contains("--no-device-profile"))
+			{
+				active_app->set_device_profiles(device_profiles.get());
+			}
+
+			if (options.contains("--counters"))
+			{
+				active_app->set_vulkan_counters(split_list(options.get_string("--counters")));
+			}
+
+			if (options.contains("--stats-stream"))
+			{
+				active_app->set_stats_stream(options.get_string("--stats-stream"));
+			}
+
+			active_app->set_shader_hot_reload(options.contains("--hot-reload"));
+			active_app->set_memory_defragmentation(options.contains("--defragment-memory"));
+			active_app->set_descriptor_buffers(options.contains("--descriptor-buffers"));
+			active_app->set_scene_snapshots(options.contains("--scene-snapshots"));
 		}
 	}
 
@@ -269,7 +345,9 @@ bool VulkanSamples::prepare_active_app(CreateAppFunc create_app_func, const std:
 	{
 		this->batch_mode = true;
 	}
-	else if (is_benchmark_mode())
+
+	// Batch runs are benchmarked with a fixed frame time too, so that they are repeatable
+	if (is_benchmark_mode())
 	{
 		active_app->set_benchmark_mode(true);
 	}
@@ -284,6 +362,18 @@ bool VulkanSamples::prepare_active_app(CreateAppFunc create_app_func, const std:
 		return result;
 	}
 
+	if (options.contains("--camera-path"))
+	{
+		if (auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(active_app.get()))
+		{
+			vulkan_app->play_camera_path(options.get_string("--camera-path"));
+		}
+	}
+
+	active_app_name     = name;
+	configuration_index = 0;
+	begin_benchmark_run();
+
 	return result;
 }
 
@@ -291,7 +381,17 @@ void VulkanSamples::update(float delta_time)
 {
 	if (active_app)
 	{
+		frame_timer.start();
+
 		active_app->step();
+
+		auto cpu_time = frame_timer.stop<Timer::Milliseconds>();
+
+		if (benchmark_report)
+		{
+			auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(active_app.get());
+			benchmark_report->add_frame(cpu_time, vulkan_app ? vulkan_app->get_gpu_frame_time() : -1.0);
+		}
 	}
 
 	elapsed_time += skipped_first_frame ? delta_time : 0.0f;
@@ -312,6 +412,9 @@ void VulkanSamples::update(float delta_time)
 				if (configuration.next())
 				{
 					configuration.set();
+
+					++configuration_index;
+					begin_benchmark_run();
 					return;
 				}
 			}
@@ -320,6 +423,13 @@ void VulkanSamples::update(float delta_time)
 			++batch_mode_sample_iter;
 			if (batch_mode_sample_iter == batch_mode_sample_list.end())
 			{
+				// A benchmark report covers every sample once
+				if (benchmark_report)
+				{
+					platform->close();
+					return;
+				}
+
 				batch_mode_sample_iter = batch_mode_sample_list.begin();
 			}
 
@@ -346,6 +456,89 @@ void VulkanSamples::finish()
 		active_app->finish();
 		active_app.reset();
 	}
+
+	// Destroyed before the platform closes the window of the surface
+	shared_context.reset();
+
+	if (benchmark_report)
+	{
+		benchmark_report->end_run();
+		benchmark_report->write_json(options.get_string("--benchmark-report"));
+
+		if (batch_mode && options.contains("--tune"))
+		{
+			store_tuned_configurations();
+		}
+	}
+}
+
+void VulkanSamples::begin_benchmark_run()
+{
+	if (!benchmark_report)
+	{
+		return;
+	}
+
+	std::string name   = active_app_name;
+	std::string device = "";
+
+	if (auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(active_app.get()))
+	{
+		benchmark_device = vulkan_app->get_render_context().get_device().get_gpu().get_properties();
+		device           = benchmark_device.deviceName;
+
+		if (batch_mode)
+		{
+			name += " (configuration " + std::to_string(configuration_index) + ")";
+		}
+	}
+
+	benchmark_report->begin_run(name, device);
+	benchmark_configurations.emplace_back(active_app_name, configuration_index);
+}
+
+void VulkanSamples::store_tuned_configurations()
+{
+	// Median frame time and configuration of the fastest run of each sample, on the GPU if it was timed
+	std::map<std::string, std::pair<double, uint32_t>> fastest;
+	std::map<std::string, uint32_t>                    run_counts;
+
+	const auto &runs = benchmark_report->get_runs();
+	for (size_t i = 0; i < runs.size() && i < benchmark_configurations.size(); ++i)
+	{
+		const auto &times = runs[i].gpu_times.empty() ? runs[i].cpu_times : runs[i].gpu_times;
+		if (times.empty())
+		{
+			continue;
+		}
+
+		const auto &sample = benchmark_configurations[i].first;
+		double      median = BenchmarkReport::compute_statistics(times).p50;
+
+		auto it = fastest.find(sample);
+		if (it == fastest.end() || median < it->second.first)
+		{
+			fastest[sample] = {median, benchmark_configurations[i].second};
+		}
+		++run_counts[sample];
+	}
+
+	for (auto &sample : fastest)
+	{
+		// Nothing to choose from for samples with a single configuration
+		if (run_counts[sample.first] < 2)
+		{
+			continue;
+		}
+
+		LOGI("Tuned {}: configuration {} ({:.3f} ms)", sample.first, sample.second.second, sample.second.first);
+		device_profiles->set_configuration(benchmark_device, sample.first, sample.second.second);
+	}
+
+	if (device_profiles->save())
+	{
+		LOGI("Device profile of {} written", benchmark_device.deviceName);
+	}
 }
 
 void VulkanSamples::resize(const uint32_t width, const uint32_t height)
@@ -20,8 +20,12 @@
 #include <memory>
 
 #include "platform/application.h"
+#include "device_profiles.h"
 #include "samples.h"
+#include "shared_context.h"
+#include "stats/benchmark_report.h"
 #include "tests.h"
+#include "timer.h"
 #include "vulkan_sample.h"
 
 namespace vkb
@@ -53,6 +57,12 @@ class VulkanSamples : public Application
 	bool prepare_active_app(CreateAppFunc create_app_func, const std::string &name, bool test, bool batch);
 
   private:
+	/// Starts the benchmark run of the active app and its configuration
+	void begin_benchmark_run();
+
+	/// Stores the fastest configuration of every benchmarked sample in the device profiles
+	void store_tuned_configurations();
+
 	/// Platform pointer
 	Platform *platform;
 
@@ -76,6 +86,30 @@ class VulkanSamples : public Application
 
 	/// Used to calculate when the sample has exceeded the sample_run_time_per_configuration
 	float elapsed_time{0.0f};
+
+	/// Name of the active app
+	std::string active_app_name;
+
+	/// Index of the batch mode configuration of the active app
+	uint32_t configuration_index{0};
+
+	/// Frame time distribution of each run, when in benchmark mode
+	std::unique_ptr<BenchmarkReport> benchmark_report{nullptr};
+
+	/// Times the frames of the active app
+	Timer frame_timer;
+
+	/// Instance and device handed over between the samples of a batch run, when requested
+	std::unique_ptr<SharedContext> shared_context{nullptr};
+
+	/// The configurations tuned for each device, applied to the samples outside of batch mode
+	std::unique_ptr<DeviceProfiles> device_profiles{nullptr};
+
+	/// Sample and configuration of each benchmark run, in the order of the runs
+	std::vector<std::pair<std::string, uint32_t>> benchmark_configurations;
+
+	/// The GPU the benchmark runs execute on
+	VkPhysicalDeviceProperties benchmark_device{};
 };
 
 }        // namespace vkb
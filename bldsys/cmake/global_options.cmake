@@ -34,9 +34,19 @@ endif()
 set(VKB_WARNINGS_AS_ERRORS ON CACHE BOOL "Enable Warnings as Errors")
 set(VKB_ENTRYPOINTS OFF CACHE BOOL "Enable create entrypoint project for every application.")
 set(VKB_SYMLINKS OFF CACHE BOOL "Enable create symlink folders for every application.")
+set(VKB_ASSET_ARCHIVE OFF CACHE BOOL "Enable packing the assets into assets.pak next to every application, read in place of the assets folder.")
 set(VKB_VALIDATION_LAYERS OFF CACHE BOOL "Enable validation layers for every application.")
+set(VKB_CPU_PROFILING OFF CACHE BOOL "Enable the CPU zone instrumentation of the framework, traced to output/logs/cpu_trace.json.")
+set(VKB_LOG_LEVEL "debug" CACHE STRING "Lowest level of the log messages compiled in: debug, info, warn, error or off.")
 set(VKB_BUILD_SAMPLES ON CACHE BOOL "Enable generation and building of Vulkan best practice samples.")
 set(VKB_BUILD_TESTS OFF CACHE BOOL "Enable generation and building of Vulkan best practice tests.")
+set(VKB_ALLOCATION_TRACKING ${VKB_BUILD_TESTS} CACHE BOOL "Enable counting the heap allocations of every frame and CPU zone, needed by the allocation_free_frames test.")
+
+if(ANDROID)
+    set(VKB_BUILD_TOOLS OFF CACHE BOOL "Enable generation and building of offline tools.")
+else()
+    set(VKB_BUILD_TOOLS ON CACHE BOOL "Enable generation and building of offline tools.")
+endif()
 set(VKB_DIRECT_2_DISPLAY OFF CACHE BOOL "Force using D2D (if available)")
 
 set(CMAKE_RUNTIME_OUTPUT_DIRECTORY "bin/${CMAKE_BUILD_TYPE}/${TARGET_ARCH}")
@@ -67,6 +67,34 @@ function(create_symlink)
     endif()
 endfunction()
 
+function(pack_assets)
+    set(options)
+    set(oneValueArgs NAME DIR OUTPUT)
+    set(multiValueArgs COMPRESS)
+
+    cmake_parse_arguments(TARGET "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    find_package(PythonInterp 3 REQUIRED)
+
+    set(PACK_COMMAND ${PYTHON_EXECUTABLE} ${CMAKE_SOURCE_DIR}/bldsys/scripts/pack_assets.py
+            -i ${TARGET_DIR}
+            -o ${TARGET_OUTPUT})
+
+    if(TARGET_COMPRESS)
+        list(APPEND PACK_COMMAND -c ${TARGET_COMPRESS})
+    endif()
+
+    add_custom_target(
+            pack.${TARGET_NAME}.stamp
+            COMMAND
+            ${PACK_COMMAND}
+            COMMENT
+            "Pack ${TARGET_DIR} into ${TARGET_OUTPUT}"
+            VERBATIM)
+
+    add_dependencies(${TARGET_NAME} pack.${TARGET_NAME}.stamp)
+endfunction()
+
 function(string_join)
     set(options)
     set(oneValueArgs GLUE)
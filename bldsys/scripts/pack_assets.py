@@ -0,0 +1,98 @@
+'''
+Copyright (c) 2026, Arm Limited and Contributors
+
+SPDX-License-Identifier: Apache-2.0
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+'''
+
+import os, sys, struct, zlib, fnmatch, argparse
+
+# Must match vkb::fs::Archive in framework/platform/filesystem.cpp
+archive_magic       = b"VKBA"
+archive_version     = 1
+compression_none    = 0
+compression_deflate = 1
+
+def align(offset, alignment):
+    return (offset + alignment - 1) // alignment * alignment
+
+def collect_files(root):
+    """
+    @brief Lists the files under a directory, as sorted paths relative to it with forward slashes
+    """
+    files = []
+    for directory, _, names in os.walk(root):
+        for name in names:
+            path = os.path.relpath(os.path.join(directory, name), root)
+            files.append(path.replace(os.sep, "/"))
+    return sorted(files)
+
+def pack(root, output, alignment, compress_patterns):
+    """
+    @brief Writes the files of a directory to an archive
+
+    The data of every entry starts on an alignment boundary so that uncompressed entries can be
+    used in place from a memory mapping. Entries matching a compress pattern are deflated, if
+    that makes them smaller. The index follows the data.
+    """
+    header_size = len(archive_magic) + struct.calcsize("<IIIQQ")
+    entries     = []
+
+    with open(output, "wb") as archive:
+        archive.write(b"\0" * header_size)
+
+        for path in collect_files(root):
+            with open(os.path.join(root, path), "rb") as f:
+                data = f.read()
+
+            size        = len(data)
+            compression = compression_none
+            if any(fnmatch.fnmatch(path, pattern) for pattern in compress_patterns):
+                compressed = zlib.compress(data, 9)
+                if len(compressed) < size:
+                    data        = compressed
+                    compression = compression_deflate
+
+            offset = align(archive.tell(), alignment)
+            archive.write(b"\0" * (offset - archive.tell()))
+            archive.write(data)
+
+            entries.append((path.encode("utf-8"), offset, size, len(data), compression))
+
+        index_offset = archive.tell()
+        for path, offset, size, stored_size, compression in entries:
+            archive.write(struct.pack("<QQQII", offset, size, stored_size, compression, len(path)))
+            archive.write(path)
+        index_size = archive.tell() - index_offset
+
+        archive.seek(0)
+        archive.write(archive_magic)
+        archive.write(struct.pack("<IIIQQ", archive_version, alignment, len(entries), index_offset, index_size))
+
+    compressed_count = sum(1 for entry in entries if entry[4] != compression_none)
+    print("Packed {} files into {} ({} compressed)".format(len(entries), output, compressed_count))
+
+if __name__ == "__main__":
+    argparser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter, description="Packs the assets directory into an archive read by vkb::fs")
+    argparser.add_argument("-i", "--input", required=True, help="path to the assets directory")
+    argparser.add_argument("-o", "--output", required=True, help="path to the archive to write")
+    argparser.add_argument("-a", "--alignment", type=int, default=4096, help="alignment of the entries, at least the page size")
+    argparser.add_argument("-c", "--compress", default=[], nargs="+", help="patterns of the paths to deflate, for rarely used data")
+    args = vars(argparser.parse_args())
+
+    if not os.path.isdir(args["input"]):
+        print("Not a directory: {}".format(args["input"]))
+        sys.exit(1)
+
+    pack(args["input"], args["output"], args["alignment"], args["compress"])
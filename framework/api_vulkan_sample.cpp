@@ -17,6 +17,8 @@
 
 #include "api_vulkan_sample.h"
 
+#include <algorithm>
+
 #include "core/device.h"
 #include "core/swapchain.h"
 #include "gltf_loader.h"
@@ -32,19 +34,13 @@ bool ApiVulkanSample::prepare(vkb::Platform &platform)
 		return false;
 	}
 
-	depth_format = vkb::get_suitable_depth_format(device->get_gpu().get_handle());
+	// The samples submit with vkQueueSubmit directly, so their buffer writes are flushed right away
+	device->set_deferred_flushes(false);
 
-	// Create synchronization objects
-	VkSemaphoreCreateInfo semaphore_create_info = vkb::initializers::semaphore_create_info();
-	// Create a semaphore used to synchronize image presentation
-	// Ensures that the current swapchain render target has completed presentation and has been released by the presentation engine, ready for rendering
-	VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &semaphores.acquired_image_ready));
-	// Create a semaphore used to synchronize command submission
-	// Ensures that the image is not presented until all commands have been sumbitted and executed
-	VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &semaphores.render_complete));
+	depth_format = vkb::get_suitable_depth_format(device->get_gpu());
 
 	// Set up submit info structure
-	// Semaphores will stay the same during application lifetime
+	// The semaphores of the current frame are copied to the same members every frame
 	// Command buffer submission info is set by each example
 	submit_info                   = vkb::initializers::submit_info();
 	submit_info.pWaitDstStageMask = &submit_pipeline_stages;
@@ -93,6 +89,9 @@ void ApiVulkanSample::prepare_render_context()
 
 	get_render_context().request_image_format(VK_FORMAT_B8G8R8A8_UNORM);
 
+	// The samples build their viewports and matrices in the orientation of the display
+	get_render_context().set_pre_rotation(false);
+
 	get_render_context().prepare();
 }
 
@@ -162,6 +161,7 @@ void ApiVulkanSample::resize(const uint32_t, const uint32_t)
 	// references to the recreated frame buffer
 	destroy_command_buffers();
 	create_command_buffers();
+	image_fences.assign(draw_cmd_buffers.size(), VK_NULL_HANDLE);
 	build_command_buffers();
 
 	device->wait_idle();
@@ -417,9 +417,8 @@ void ApiVulkanSample::destroy_command_buffers()
 
 void ApiVulkanSample::create_pipeline_cache()
 {
-	VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
-	pipeline_cache_create_info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-	VK_CHECK(vkCreatePipelineCache(device->get_handle(), &pipeline_cache_create_info, nullptr, &pipeline_cache));
+	// The persistent pipeline cache is owned, saved and destroyed by VulkanSample
+	pipeline_cache = persistent_pipeline_cache->get_handle();
 }
 
 VkPipelineShaderStageCreateInfo ApiVulkanSample::load_shader(const std::string &file, VkShaderStageFlagBits stage)
@@ -444,14 +443,25 @@ void ApiVulkanSample::update_overlay(float delta_time)
 
 		gui->update(delta_time);
 
-		if (gui->update_buffers() || gui->get_drawer().is_dirty())
+		// With frames in flight, the geometry is uploaded by prepare_frame() once the GPU is done with the buffers of the acquired image
+		if (serialize_frames)
 		{
-			build_command_buffers();
-			gui->get_drawer().clear();
+			update_overlay_buffers(0);
 		}
 	}
 }
 
+void ApiVulkanSample::update_overlay_buffers(uint32_t frame_index)
+{
+	if (gui->update_buffers(frame_index) || gui->get_drawer().is_dirty())
+	{
+		// The command buffers of the other frames in flight may still be pending execution
+		wait_for_frames_in_flight();
+		build_command_buffers();
+		gui->get_drawer().clear();
+	}
+}
+
 void ApiVulkanSample::draw_ui(const VkCommandBuffer command_buffer)
 {
 	if (gui)
@@ -461,12 +471,24 @@ void ApiVulkanSample::draw_ui(const VkCommandBuffer command_buffer)
 		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
 		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-		gui->draw(command_buffer);
+		// With frames in flight, each swapchain image draws the GUI from its own buffers
+		uint32_t frame_index = 0;
+		if (!serialize_frames)
+		{
+			auto it     = std::find(draw_cmd_buffers.begin(), draw_cmd_buffers.end(), command_buffer);
+			frame_index = it != draw_cmd_buffers.end() ? vkb::to_u32(std::distance(draw_cmd_buffers.begin(), it)) : current_buffer;
+		}
+
+		gui->draw(command_buffer, frame_index);
 	}
 }
 
 void ApiVulkanSample::prepare_frame()
 {
+	// The semaphores of this frame can only be reused once the GPU is done with the frame that last used them
+	VK_CHECK(vkWaitForFences(device->get_handle(), 1, &wait_fences[current_frame], VK_TRUE, UINT64_MAX));
+	semaphores = frame_semaphores[current_frame];
+
 	if (render_context->has_swapchain())
 	{
 		handle_surface_changes();
@@ -482,10 +504,27 @@ void ApiVulkanSample::prepare_frame()
 			VK_CHECK(result);
 		}
 	}
+
+	// An earlier frame may still be rendering to this image, with the same command buffer
+	if (image_fences[current_buffer] != VK_NULL_HANDLE && image_fences[current_buffer] != wait_fences[current_frame])
+	{
+		VK_CHECK(vkWaitForFences(device->get_handle(), 1, &image_fences[current_buffer], VK_TRUE, UINT64_MAX));
+	}
+	image_fences[current_buffer] = wait_fences[current_frame];
+
+	if (gui && !serialize_frames)
+	{
+		update_overlay_buffers(current_buffer);
+	}
+
+	VK_CHECK(vkResetFences(device->get_handle(), 1, &wait_fences[current_frame]));
 }
 
 void ApiVulkanSample::submit_frame()
 {
+	// Samples submit their work without a fence, an empty batch signals the fence of the frame once all of it has completed
+	VK_CHECK(vkQueueSubmit(queue, 0, nullptr, wait_fences[current_frame]));
+
 	if (render_context->has_swapchain())
 	{
 		const auto &queue = device->get_queue_by_present(0);
@@ -507,25 +546,27 @@ void ApiVulkanSample::submit_frame()
 
 		VkResult present_result = queue.present(present_info);
 
-		if (!((present_result == VK_SUCCESS) || (present_result == VK_SUBOPTIMAL_KHR)))
+		if (present_result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
-			if (present_result == VK_ERROR_OUT_OF_DATE_KHR)
-			{
-				// Swap chain is no longer compatible with the surface and needs to be recreated
-				resize(width, height);
-				return;
-			}
-			else
-			{
-				VK_CHECK(present_result);
-			}
+			// Swap chain is no longer compatible with the surface and needs to be recreated
+			resize(width, height);
+		}
+		else if (!((present_result == VK_SUCCESS) || (present_result == VK_SUBOPTIMAL_KHR)))
+		{
+			VK_CHECK(present_result);
 		}
 	}
 
-	// DO NOT USE
-	// vkDeviceWaitIdle and vkQueueWaitIdle are extremely expensive functions, and are used here purely for demonstrating the vulkan API
-	// without having to concern ourselves with proper syncronization. These functions should NEVER be used inside the render loop like this (every frame).
-	VK_CHECK(vkDeviceWaitIdle(device->get_handle()));
+	if (serialize_frames)
+	{
+		// DO NOT USE
+		// vkDeviceWaitIdle and vkQueueWaitIdle are extremely expensive functions, and are used here purely for demonstrating the vulkan API
+		// without having to concern ourselves with proper syncronization. These functions should NEVER be used inside the render loop like this (every frame).
+		// Samples that keep their per-frame resources apart clear serialize_frames instead.
+		VK_CHECK(vkDeviceWaitIdle(device->get_handle()));
+	}
+
+	current_frame = (current_frame + 1) % max_frames_in_flight;
 }
 
 ApiVulkanSample::~ApiVulkanSample()
@@ -559,12 +600,13 @@ ApiVulkanSample::~ApiVulkanSample()
 		vkDestroyImage(device->get_handle(), depth_stencil.image, nullptr);
 		vkFreeMemory(device->get_handle(), depth_stencil.mem, nullptr);
 
-		vkDestroyPipelineCache(device->get_handle(), pipeline_cache, nullptr);
-
 		vkDestroyCommandPool(device->get_handle(), cmd_pool, nullptr);
 
-		vkDestroySemaphore(device->get_handle(), semaphores.acquired_image_ready, nullptr);
-		vkDestroySemaphore(device->get_handle(), semaphores.render_complete, nullptr);
+		for (auto &frame : frame_semaphores)
+		{
+			vkDestroySemaphore(device->get_handle(), frame.acquired_image_ready, nullptr);
+			vkDestroySemaphore(device->get_handle(), frame.render_complete, nullptr);
+		}
 		for (auto &fence : wait_fences)
 		{
 			vkDestroyFence(device->get_handle(), fence, nullptr);
@@ -582,13 +624,33 @@ void ApiVulkanSample::build_command_buffers()
 
 void ApiVulkanSample::create_synchronization_primitives()
 {
-	// Wait fences to sync command buffer access
+	VkSemaphoreCreateInfo semaphore_create_info = vkb::initializers::semaphore_create_info();
+	frame_semaphores.resize(max_frames_in_flight);
+	for (auto &frame : frame_semaphores)
+	{
+		// Create a semaphore used to synchronize image presentation
+		// Ensures that the current swapchain render target has completed presentation and has been released by the presentation engine, ready for rendering
+		VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &frame.acquired_image_ready));
+		// Create a semaphore used to synchronize command submission
+		// Ensures that the image is not presented until all commands have been sumbitted and executed
+		VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &frame.render_complete));
+	}
+	semaphores = frame_semaphores[0];
+
+	// Wait fences to sync the reuse of the semaphores and command buffers of a frame
 	VkFenceCreateInfo fence_create_info = vkb::initializers::fence_create_info(VK_FENCE_CREATE_SIGNALED_BIT);
-	wait_fences.resize(draw_cmd_buffers.size());
+	wait_fences.resize(max_frames_in_flight);
 	for (auto &fence : wait_fences)
 	{
 		VK_CHECK(vkCreateFence(device->get_handle(), &fence_create_info, nullptr, &fence));
 	}
+
+	image_fences.assign(draw_cmd_buffers.size(), VK_NULL_HANDLE);
+}
+
+void ApiVulkanSample::wait_for_frames_in_flight()
+{
+	VK_CHECK(vkWaitForFences(device->get_handle(), vkb::to_u32(wait_fences.size()), wait_fences.data(), VK_TRUE, UINT64_MAX));
 }
 
 void ApiVulkanSample::create_command_pool()
@@ -857,7 +919,7 @@ Texture ApiVulkanSample::load_texture(const std::string &file)
 {
 	Texture texture{};
 
-	texture.image = vkb::sg::Image::load(file, file);
+	texture.image = vkb::sg::Image::load(file, file, device.get());
 	texture.image->create_vk_image(*device);
 
 	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
@@ -955,7 +1017,7 @@ Texture ApiVulkanSample::load_texture_array(const std::string &file)
 {
 	Texture texture{};
 
-	texture.image = vkb::sg::Image::load(file, file);
+	texture.image = vkb::sg::Image::load(file, file, device.get());
 	texture.image->create_vk_image(*device, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
 
 	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
@@ -1056,7 +1118,7 @@ Texture ApiVulkanSample::load_texture_cubemap(const std::string &file)
 {
 	Texture texture{};
 
-	texture.image = vkb::sg::Image::load(file, file);
+	texture.image = vkb::sg::Image::load(file, file, device.get());
 	texture.image->create_vk_image(*device, VK_IMAGE_VIEW_TYPE_CUBE, VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
 
 	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
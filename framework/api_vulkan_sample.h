@@ -140,8 +140,8 @@ class ApiVulkanSample : public vkb::VulkanSample
 	// Pipeline cache object
 	VkPipelineCache pipeline_cache;
 
-	// Synchronization semaphores
-	struct
+	// Synchronization semaphores of the current frame
+	struct Semaphores
 	{
 		// Swap chain image presentation
 		VkSemaphore acquired_image_ready;
@@ -150,9 +150,21 @@ class ApiVulkanSample : public vkb::VulkanSample
 		VkSemaphore render_complete;
 	} semaphores;
 
-	// Synchronization fences
+	// Synchronization fences, one per frame in flight
 	std::vector<VkFence> wait_fences;
 
+	/**
+	 * @brief Compatibility flag for samples whose uniform buffers and command buffers are not per frame yet.
+	 *        If set, submit_frame() waits for the device to be idle at the end of every frame
+	 */
+	bool serialize_frames = true;
+
+	// Number of frames that may be submitted before the GPU has finished the oldest one
+	uint32_t max_frames_in_flight = 2;
+
+	// Index of the current frame in flight, in the range [0, max_frames_in_flight)
+	uint32_t current_frame = 0;
+
 	/**
 	 * @brief Populates the swapchain_buffers vector with the image and imageviews 
 	 */
@@ -228,10 +240,16 @@ class ApiVulkanSample : public vkb::VulkanSample
 	virtual void build_command_buffers() = 0;
 
 	/**
-	 * @brief Creates the fences for rendering
+	 * @brief Creates the semaphores and fences of the frames in flight
 	 */
 	void create_synchronization_primitives();
 
+	/**
+	 * @brief Waits for the GPU to finish all the frames in flight, e.g. before recording command buffers
+	 *        that may still be pending execution
+	 */
+	void wait_for_frames_in_flight();
+
 	/**
 	 * @brief Creates a new (graphics) command pool object storing command buffers
 	 */
@@ -296,11 +314,13 @@ class ApiVulkanSample : public vkb::VulkanSample
 	/**
 	 * @brief Prepare the frame for workload submission, acquires the next image from the swap chain and 
 	 *        sets the default wait and signal semaphores
+	 *        Once it returns, the GPU is done with the command buffer and per-image resources of current_buffer
 	 */
 	void prepare_frame();
 
 	/**
 	 * @brief Submit the frames' workload
+	 *        The work submitted to queue since prepare_frame() is tracked by the fence of the frame
 	 */
 	void submit_frame();
 
@@ -318,8 +338,20 @@ class ApiVulkanSample : public vkb::VulkanSample
 	uint32_t dest_height;
 	bool     resizing = false;
 
+	// Semaphores of each frame in flight, the ones of the current frame are copied to semaphores
+	std::vector<Semaphores> frame_semaphores;
+
+	// Fence of the frame that last rendered to each swapchain image
+	std::vector<VkFence> image_fences;
+
 	void handle_mouse_move(int32_t x, int32_t y);
 
+	/**
+	 * @brief Uploads the GUI geometry of a frame, and records the command buffers again if it changed
+	 * @param frame_index Index of the GUI buffers, which the GPU must no longer be reading
+	 */
+	void update_overlay_buffers(uint32_t frame_index);
+
 #if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
 	/// The debug report callback
 	VkDebugReportCallbackEXT debug_report_callback{VK_NULL_HANDLE};
@@ -362,9 +394,8 @@ class ApiVulkanSample : public vkb::VulkanSample
 	glm::vec3 camera_pos = glm::vec3();
 	glm::vec2 mouse_pos;
 
-	std::string title       = "Vulkan Example";
-	std::string name        = "vulkanExample";
-	uint32_t    api_version = VK_API_VERSION_1_0;
+	std::string title = "Vulkan Example";
+	std::string name  = "vulkanExample";
 
 	struct
 	{
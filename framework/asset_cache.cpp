@@ -0,0 +1,59 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "asset_cache.h"
+
+namespace vkb
+{
+std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> AssetCache::find_image(size_t content_hash)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	auto it = images.find(content_hash);
+
+	if (it == images.end())
+	{
+		return {};
+	}
+
+	auto image      = it->second.image.lock();
+	auto image_view = it->second.image_view.lock();
+
+	if (!image || !image_view)
+	{
+		// The scenes using the image were destroyed
+		images.erase(it);
+		return {};
+	}
+
+	return {std::move(image), std::move(image_view)};
+}
+
+void AssetCache::add_image(size_t content_hash, const std::shared_ptr<core::Image> &image, const std::shared_ptr<core::ImageView> &image_view)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	images[content_hash] = {image, image_view};
+}
+
+void AssetCache::clear()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	images.clear();
+}
+}        // namespace vkb
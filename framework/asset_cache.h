@@ -0,0 +1,80 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+
+namespace vkb
+{
+/**
+ * @brief Vulkan objects of the assets shared by the scenes loaded on a device
+ *
+ * Images are keyed by the hash of their content, the cache only references them so they are destroyed
+ * with the last scene using them. Samplers are shared by ResourceCache::request_sampler(). The cache is thread safe.
+ */
+class AssetCache
+{
+  public:
+	AssetCache() = default;
+
+	AssetCache(const AssetCache &) = delete;
+
+	AssetCache(AssetCache &&) = delete;
+
+	~AssetCache() = default;
+
+	AssetCache &operator=(const AssetCache &) = delete;
+
+	AssetCache &operator=(AssetCache &&) = delete;
+
+	/**
+	 * @brief Finds an uploaded image with the same content
+	 * @return The image and its view, or null pointers if no live image has the content
+	 */
+	std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> find_image(size_t content_hash);
+
+	/**
+	 * @brief Shares an image once its content is uploaded
+	 */
+	void add_image(size_t content_hash, const std::shared_ptr<core::Image> &image, const std::shared_ptr<core::ImageView> &image_view);
+
+	/**
+	 * @brief Forgets the images
+	 */
+	void clear();
+
+  private:
+	struct CachedImage
+	{
+		std::weak_ptr<core::Image> image;
+
+		std::weak_ptr<core::ImageView> image_view;
+	};
+
+	std::mutex mutex;
+
+	std::unordered_map<size_t, CachedImage> images;
+};
+}        // namespace vkb
@@ -17,39 +17,65 @@
 
 #include "buffer_pool.h"
 
+#include <algorithm>
 #include <cstddef>
 
 #include "common/error.h"
 #include "common/logging.h"
+#include "core/command_buffer.h"
 #include "core/device.h"
 
 namespace vkb
 {
-BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
-    buffer{device, size, usage, memory_usage}
+namespace
+{
+// Allocations are at least 16 bytes aligned, so that vector types can be emplaced in them
+constexpr VkDeviceSize MIN_ALIGNMENT = 16;
+
+VkDeviceSize get_alignment(Device &device, VkBufferUsageFlags usage)
 {
 	if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
+		return std::max(device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment, MIN_ALIGNMENT);
 	}
 	else if (usage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment;
+		return std::max(device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment, MIN_ALIGNMENT);
 	}
 	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minTexelBufferOffsetAlignment;
+		return device.get_gpu().get_properties().limits.minTexelBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
 	{
 		// Used to calculate the offset, required when allocating memory (its value should be power of 2)
-		alignment = 16;
+		return 16;
 	}
+#ifdef VK_EXT_descriptor_buffer
+	else if (usage & VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT)
+	{
+		return std::max(device.get_descriptor_buffer_properties().descriptorBufferOffsetAlignment, MIN_ALIGNMENT);
+	}
+#endif
 	else
 	{
 		throw std::runtime_error("Usage not recognised");
 	}
 }
+}        // namespace
+
+BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage, bool staged) :
+    buffer{device, size, staged ? usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT : usage, memory_usage, staged ? 0 : VMA_ALLOCATION_CREATE_MAPPED_BIT},
+    usage{usage},
+    alignment{get_alignment(device, usage)}
+{
+	if (staged)
+	{
+		staging_buffer = std::make_unique<core::Buffer>(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+	}
+
+	device.check_memory_budget(buffer.get_allocation(), "Buffer pool block");
+}
 
 BufferAllocation BufferBlock::allocate(const uint32_t allocate_size)
 {
@@ -65,6 +91,12 @@ BufferAllocation BufferBlock::allocate(const uint32_t allocate_size)
 
 	// Move the current offset and return an allocation
 	offset = aligned_offset + allocate_size;
+
+	if (staging_buffer)
+	{
+		return BufferAllocation{buffer, *staging_buffer, allocate_size, aligned_offset};
+	}
+
 	return BufferAllocation{buffer, allocate_size, aligned_offset};
 }
 
@@ -73,16 +105,67 @@ VkDeviceSize BufferBlock::get_size() const
 	return buffer.get_size();
 }
 
+const core::Buffer &BufferBlock::get_buffer() const
+{
+	return buffer;
+}
+
+const core::Buffer *BufferBlock::get_staging_buffer() const
+{
+	return staging_buffer.get();
+}
+
+bool BufferBlock::record_upload(CommandBuffer &command_buffer)
+{
+	if (!staging_buffer || offset == 0)
+	{
+		return false;
+	}
+
+	// Allocations are contiguous from the start of the block, a single region covers all of them
+	command_buffer.copy_buffer(*staging_buffer, buffer, offset);
+
+	BufferMemoryBarrier memory_barrier{};
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+	{
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_UNIFORM_READ_BIT;
+	}
+	else if (usage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	{
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	}
+	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+	{
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_INDEX_READ_BIT;
+	}
+	else
+	{
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	}
+
+	command_buffer.buffer_memory_barrier(buffer, 0, offset, memory_barrier);
+
+	return true;
+}
+
 void BufferBlock::reset()
 {
 	offset = 0;
 }
 
-BufferPool::BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+BufferPool::BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage, bool staged) :
     device{device},
     block_size{block_size},
     usage{usage},
-    memory_usage{memory_usage}
+    memory_usage{memory_usage},
+    staged{staged}
 {
 }
 
@@ -103,13 +186,26 @@ BufferBlock &BufferPool::request_buffer_block(const VkDeviceSize minimum_size)
 	LOGD("Building #{} buffer block ({})", buffer_blocks.size(), usage);
 
 	// Create a new block, store and return it
-	buffer_blocks.emplace_back(std::make_unique<BufferBlock>(device, std::max(block_size, minimum_size), usage, memory_usage));
+	buffer_blocks.emplace_back(std::make_unique<BufferBlock>(device, std::max(block_size, minimum_size), usage, memory_usage, staged));
 
 	auto &block = buffer_blocks[active_buffer_block_count++];
 
 	return *block.get();
 }
 
+bool BufferPool::record_uploads(CommandBuffer &command_buffer)
+{
+	bool recorded = false;
+
+	// Blocks which were not allocated from since the last reset have nothing to upload
+	for (auto &buffer_block : buffer_blocks)
+	{
+		recorded |= buffer_block->record_upload(command_buffer);
+	}
+
+	return recorded;
+}
+
 void BufferPool::reset()
 {
 	for (auto &buffer_block : buffer_blocks)
@@ -120,6 +216,90 @@ void BufferPool::reset()
 	active_buffer_block_count = 0;
 }
 
+const std::vector<std::unique_ptr<BufferBlock>> &BufferPool::get_buffer_blocks() const
+{
+	return buffer_blocks;
+}
+
+BufferRing::BufferRing(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+    buffer{device, size, usage, memory_usage},
+    usage{usage},
+    alignment{get_alignment(device, usage)}
+{
+	// Allocations wrapping around start at offset zero, so the end of the ring must be aligned too
+	assert(size % alignment == 0 && "Ring size must be a multiple of the buffer alignment");
+}
+
+BufferRing::~BufferRing()
+{
+	LOGI("Buffer ring ({}) high water mark: {} KB of {} KB", usage, high_water_mark / 1024, buffer.get_size() / 1024);
+}
+
+BufferAllocation BufferRing::allocate(const uint32_t allocate_size)
+{
+	assert(allocate_size > 0 && "Allocation size must be greater than zero");
+
+	std::lock_guard<std::mutex> guard(mutex);
+
+	auto size   = buffer.get_size();
+	auto offset = head % size;
+
+	auto aligned_offset = (offset + alignment - 1) & ~(alignment - 1);
+
+	if (aligned_offset + allocate_size > size)
+	{
+		// Not enough space before the end of the buffer, wrap around to its start
+		aligned_offset = size;
+	}
+
+	auto start = head - offset + aligned_offset;
+	auto end   = start + allocate_size;
+
+	if (end - tail > size)
+	{
+		// The frames in flight still use the rest of the ring, return empty allocation
+		return BufferAllocation{};
+	}
+
+	head            = end;
+	high_water_mark = std::max(high_water_mark, head - tail);
+
+	return BufferAllocation{buffer, allocate_size, start % size};
+}
+
+void BufferRing::begin_frame(uint32_t frame_index)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	if (frame_index >= frame_ends.size())
+	{
+		frame_ends.resize(frame_index + 1, tail);
+	}
+
+	// The previous frame will not allocate anymore
+	if (active_frame_index >= 0)
+	{
+		frame_ends[static_cast<size_t>(active_frame_index)] = head;
+	}
+
+	// Frames complete in order, so everything allocated up to the end of this frame's last use is free
+	tail = std::max(tail, frame_ends[frame_index]);
+
+	active_frame_index = frame_index;
+}
+
+VkDeviceSize BufferRing::get_size() const
+{
+	return buffer.get_size();
+}
+
+VkDeviceSize BufferRing::get_high_water_mark() const
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	return high_water_mark;
+}
+
 BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDeviceSize offset) :
     buffer{&buffer},
     size{size},
@@ -127,13 +307,26 @@ BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDe
 {
 }
 
+BufferAllocation::BufferAllocation(core::Buffer &buffer, core::Buffer &staging_buffer, VkDeviceSize size, VkDeviceSize offset) :
+    buffer{&buffer},
+    staging_buffer{&staging_buffer},
+    size{size},
+    base_offset{offset}
+{
+}
+
 void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
 {
 	assert(buffer && "Invalid buffer pointer");
 
 	if (offset + data.size() <= size)
 	{
-		buffer->update(data, to_u32(base_offset) + offset);
+		get_write_buffer().update(data, to_u32(base_offset) + offset);
+
+		if (write_counters)
+		{
+			write_counters->bytes_written.fetch_add(data.size(), std::memory_order_relaxed);
+		}
 	}
 	else
 	{
@@ -141,6 +334,58 @@ void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
 	}
 }
 
+void BufferAllocation::write(const uint8_t *data, size_t data_size, uint32_t offset)
+{
+	assert(buffer && "Invalid buffer pointer");
+
+	if (offset + data_size <= size)
+	{
+		get_write_buffer().update(data, data_size, to_u32(base_offset) + offset);
+
+		if (write_counters)
+		{
+			write_counters->bytes_written.fetch_add(data_size, std::memory_order_relaxed);
+			write_counters->allocations_avoided.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	else
+	{
+		LOGE("Ignore buffer allocation update");
+	}
+}
+
+uint8_t *BufferAllocation::map(size_t data_size, uint32_t offset)
+{
+	assert(buffer && "Invalid buffer pointer");
+	assert(offset + data_size <= size && "Write out of the allocation bounds");
+
+	if (write_counters)
+	{
+		write_counters->bytes_written.fetch_add(data_size, std::memory_order_relaxed);
+		write_counters->allocations_avoided.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Persistently mapped buffers return their mapping, others stay mapped until destroyed
+	return get_write_buffer().map() + base_offset + offset;
+}
+
+void BufferAllocation::flush()
+{
+	assert(buffer && "Invalid buffer pointer");
+
+	get_write_buffer().mark_written(base_offset, size);
+}
+
+core::Buffer &BufferAllocation::get_write_buffer()
+{
+	return staging_buffer ? *staging_buffer : *buffer;
+}
+
+void BufferAllocation::set_write_counters(BufferWriteCounters *counters)
+{
+	write_counters = counters;
+}
+
 bool BufferAllocation::empty() const
 {
 	return size == 0 || buffer == nullptr;
@@ -17,13 +17,30 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <new>
+
 #include "common/helpers.h"
 #include "core/buffer.h"
 
 namespace vkb
 {
+class CommandBuffer;
 class Device;
 
+/**
+ * @brief Counts the writes into the buffer allocations of a frame
+ */
+struct BufferWriteCounters
+{
+	/// Bytes written into the allocations
+	std::atomic<uint64_t> bytes_written{0};
+
+	/// Writes which went straight to the mapped memory instead of through a temporary byte vector
+	std::atomic<uint64_t> allocations_avoided{0};
+};
+
 /**
  * @brief An allocation of vulkan memory; different buffer allocations,
  *        with different offset and size, may come from the same Vulkan buffer
@@ -35,6 +52,15 @@ class BufferAllocation
 
 	BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDeviceSize offset);
 
+	/**
+	 * @brief Creates an allocation written through a staging buffer
+	 * @param buffer The buffer read by the device
+	 * @param staging_buffer The host visible buffer the writes go to, at the same offset
+	 * @param size The size of the allocation
+	 * @param offset The offset of the allocation in both buffers
+	 */
+	BufferAllocation(core::Buffer &buffer, core::Buffer &staging_buffer, VkDeviceSize size, VkDeviceSize offset);
+
 	BufferAllocation(const BufferAllocation &) = delete;
 
 	BufferAllocation(BufferAllocation &&) = default;
@@ -45,12 +71,56 @@ class BufferAllocation
 
 	void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
 
+	/**
+	 * @brief Copies bytes into the allocation without any intermediate copy
+	 * @param data The data to copy from
+	 * @param size The amount of bytes to copy
+	 * @param offset The offset in the allocation to start the copying at
+	 */
+	void write(const uint8_t *data, size_t size, uint32_t offset = 0);
+
 	template <class T>
 	void update(const T &value, uint32_t offset = 0)
 	{
-		update(to_bytes(value), offset);
+		write(reinterpret_cast<const uint8_t *>(&value), sizeof(T), offset);
 	}
 
+	/**
+	 * @brief Constructs an object directly in the mapped memory of the allocation
+	 *        The memory is write-combined on most devices: fill the object in once
+	 *        without reading it back, then call flush().
+	 * @param offset The offset in the allocation to construct the object at
+	 * @return The object, living in the buffer
+	 */
+	template <class T>
+	T &emplace(uint32_t offset = 0)
+	{
+		auto data = map(sizeof(T), offset);
+
+		assert(reinterpret_cast<uintptr_t>(data) % alignof(T) == 0 && "Allocation is not aligned for the type");
+
+		return *new (data) T{};
+	}
+
+	/**
+	 * @brief Maps a range of the allocation for the host to write into directly
+	 *        As with emplace(), fill the range in once without reading it back, then call flush().
+	 * @param size The size of the range in bytes
+	 * @param offset The offset of the range in the allocation
+	 * @return The mapped memory of the range
+	 */
+	uint8_t *map(size_t size, uint32_t offset = 0);
+
+	/**
+	 * @brief Flushes the memory written with emplace() or map(), if it is not host coherent
+	 */
+	void flush();
+
+	/**
+	 * @brief Sets the counters which are updated on every write into the allocation
+	 */
+	void set_write_counters(BufferWriteCounters *counters);
+
 	bool empty() const;
 
 	VkDeviceSize get_size() const;
@@ -60,8 +130,17 @@ class BufferAllocation
 	core::Buffer &get_buffer();
 
   private:
+	/**
+	 * @return The buffer the host writes into
+	 */
+	core::Buffer &get_write_buffer();
+
 	core::Buffer *buffer{nullptr};
 
+	core::Buffer *staging_buffer{nullptr};
+
+	BufferWriteCounters *write_counters{nullptr};
+
 	VkDeviceSize base_offset{0};
 
 	VkDeviceSize size{0};
@@ -73,7 +152,10 @@ class BufferAllocation
 class BufferBlock
 {
   public:
-	BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage);
+	/**
+	 * @param staged Whether the host writes into a staging buffer, copied to the buffer by record_upload()
+	 */
+	BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage, bool staged = false);
 
 	/**
 	 * @return An usable view on a portion of the underlying buffer
@@ -82,11 +164,30 @@ class BufferBlock
 
 	VkDeviceSize get_size() const;
 
+	const core::Buffer &get_buffer() const;
+
+	/**
+	 * @return The staging buffer of a staged block, null otherwise
+	 */
+	const core::Buffer *get_staging_buffer() const;
+
+	/**
+	 * @brief Records the copy of the allocated range from the staging buffer, if any has been allocated
+	 *        The copy is followed by a barrier making it visible to the shaders.
+	 * @return Whether a copy was recorded
+	 */
+	bool record_upload(CommandBuffer &command_buffer);
+
 	void reset();
 
   private:
 	core::Buffer buffer;
 
+	/// Host visible copy of the buffer for staged blocks
+	std::unique_ptr<core::Buffer> staging_buffer;
+
+	VkBufferUsageFlags usage{};
+
 	// Memory alignment, it may change according to the usage
 	VkDeviceSize alignment{0};
 
@@ -113,12 +214,23 @@ class BufferBlock
 class BufferPool
 {
   public:
-	BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU);
+	BufferPool(Device &device, VkDeviceSize block_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU, bool staged = false);
 
 	BufferBlock &request_buffer_block(VkDeviceSize minimum_size);
 
+	/**
+	 * @brief Records the uploads of the staged blocks allocated from since the last reset
+	 * @return Whether any copy was recorded
+	 */
+	bool record_uploads(CommandBuffer &command_buffer);
+
 	void reset();
 
+	/**
+	 * @return Every block created so far, active or not
+	 */
+	const std::vector<std::unique_ptr<BufferBlock>> &get_buffer_blocks() const;
+
   private:
 	Device &device;
 
@@ -132,7 +244,77 @@ class BufferPool
 
 	VmaMemoryUsage memory_usage{};
 
+	bool staged{false};
+
 	/// Numbers of active blocks from the start of buffer_blocks
 	uint32_t active_buffer_block_count{0};
 };
+
+/**
+ * @brief A ring allocator over a single persistently mapped buffer, shared by all the frames in flight.
+ *
+ * Allocations are carved from the head of the ring, wrapping around to the start of the buffer
+ * when they do not fit before its end. The tail only moves forward once the fence of a frame
+ * has been waited on: the memory that frame allocated is then reclaimed. Unlike BufferPool,
+ * the memory used stays flat as a spike only consumes more of the ring instead of adding blocks;
+ * when the ring is full allocations are empty, and the caller should fall back to a BufferPool.
+ *
+ * Allocating is thread safe, so threads recording command buffers in parallel can share the ring.
+ */
+class BufferRing
+{
+  public:
+	BufferRing(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	BufferRing(const BufferRing &) = delete;
+
+	BufferRing(BufferRing &&) = delete;
+
+	~BufferRing();
+
+	BufferRing &operator=(const BufferRing &) = delete;
+
+	BufferRing &operator=(BufferRing &&) = delete;
+
+	/**
+	 * @return A view on the ring, or an empty allocation if the ring is full
+	 */
+	BufferAllocation allocate(uint32_t size);
+
+	/**
+	 * @brief Starts a new frame, once its fence has been waited on
+	 *        The allocations made by the previous use of the frame are reclaimed.
+	 * @param frame_index Index of the frame which starts
+	 */
+	void begin_frame(uint32_t frame_index);
+
+	VkDeviceSize get_size() const;
+
+	/**
+	 * @return The highest amount of memory in use at the same time since the ring was created
+	 */
+	VkDeviceSize get_high_water_mark() const;
+
+  private:
+	core::Buffer buffer;
+
+	VkBufferUsageFlags usage{};
+
+	VkDeviceSize alignment{0};
+
+	mutable std::mutex mutex;
+
+	/// Positions grow indefinitely, their offset in the buffer is modulo its size
+	VkDeviceSize head{0};
+
+	VkDeviceSize tail{0};
+
+	VkDeviceSize high_water_mark{0};
+
+	/// Head position at the end of the last use of each frame
+	std::vector<VkDeviceSize> frame_ends;
+
+	/// Index of the frame allocating from the ring, -1 before the first frame
+	int64_t active_frame_index{-1};
+};
 }        // namespace vkb
@@ -0,0 +1,147 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/debug_utils.h"
+
+#ifdef VKB_DEBUG_UTILS
+
+#	include <atomic>
+#	include <cstdlib>
+#	include <cstring>
+#	include <vector>
+
+namespace vkb
+{
+namespace debug_utils
+{
+namespace
+{
+std::atomic<bool> enabled{false};
+
+VkDebugUtilsLabelEXT make_label(const char *name, const float *color)
+{
+	VkDebugUtilsLabelEXT label{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+	label.pLabelName = name;
+	if (color)
+	{
+		std::memcpy(label.color, color, sizeof(label.color));
+	}
+	return label;
+}
+}        // namespace
+
+bool is_enabled()
+{
+	// Only loaded if VK_EXT_debug_utils is enabled
+	return enabled.load(std::memory_order_relaxed) && vkCmdBeginDebugUtilsLabelEXT != nullptr;
+}
+
+void set_enabled(bool value)
+{
+	enabled.store(value, std::memory_order_relaxed);
+}
+
+void detect_capture_tools(VkPhysicalDevice gpu, bool tooling_info)
+{
+#	ifdef VK_EXT_tooling_info
+	if (tooling_info && vkGetPhysicalDeviceToolPropertiesEXT)
+	{
+		uint32_t tool_count = 0;
+		VK_CHECK(vkGetPhysicalDeviceToolPropertiesEXT(gpu, &tool_count, nullptr));
+
+		std::vector<VkPhysicalDeviceToolPropertiesEXT> tools(tool_count, {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TOOL_PROPERTIES_EXT});
+		VK_CHECK(vkGetPhysicalDeviceToolPropertiesEXT(gpu, &tool_count, tools.data()));
+
+		// The validation layers report themselves as well, only tools that show the labels switch them on
+		for (auto &tool : tools)
+		{
+			if (tool.purposes & (VK_TOOL_PURPOSE_TRACING_BIT_EXT | VK_TOOL_PURPOSE_DEBUG_MARKERS_BIT_EXT))
+			{
+				LOGI("{} is attached, enabling debug labels", tool.name);
+				set_enabled(true);
+				return;
+			}
+		}
+	}
+#	endif
+
+	// RenderDoc sets this for the applications it launches, also on implementations without VK_EXT_tooling_info
+	const char *renderdoc = std::getenv("ENABLE_VULKAN_RENDERDOC_CAPTURE");
+	if (renderdoc && std::strcmp(renderdoc, "1") == 0)
+	{
+		LOGI("RenderDoc is attached, enabling debug labels");
+		set_enabled(true);
+	}
+}
+
+void cmd_begin_label(VkCommandBuffer command_buffer, const char *name, const float *color)
+{
+	VkDebugUtilsLabelEXT label = make_label(name, color);
+	vkCmdBeginDebugUtilsLabelEXT(command_buffer, &label);
+}
+
+void cmd_insert_label(VkCommandBuffer command_buffer, const char *name, const float *color)
+{
+	VkDebugUtilsLabelEXT label = make_label(name, color);
+	vkCmdInsertDebugUtilsLabelEXT(command_buffer, &label);
+}
+
+void cmd_end_label(VkCommandBuffer command_buffer)
+{
+	vkCmdEndDebugUtilsLabelEXT(command_buffer);
+}
+
+void queue_begin_label(VkQueue queue, const char *name, const float *color)
+{
+	VkDebugUtilsLabelEXT label = make_label(name, color);
+	vkQueueBeginDebugUtilsLabelEXT(queue, &label);
+}
+
+void queue_insert_label(VkQueue queue, const char *name, const float *color)
+{
+	VkDebugUtilsLabelEXT label = make_label(name, color);
+	vkQueueInsertDebugUtilsLabelEXT(queue, &label);
+}
+
+void queue_end_label(VkQueue queue)
+{
+	vkQueueEndDebugUtilsLabelEXT(queue);
+}
+
+void set_object_name(VkDevice device, VkObjectType object_type, uint64_t object_handle, const char *name)
+{
+	VkDebugUtilsObjectNameInfoEXT name_info{VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT};
+	name_info.objectType   = object_type;
+	name_info.objectHandle = object_handle;
+	name_info.pObjectName  = name;
+	vkSetDebugUtilsObjectNameEXT(device, &name_info);
+}
+
+void set_object_tag(VkDevice device, VkObjectType object_type, uint64_t object_handle, uint64_t tag_name, const void *tag, size_t tag_size)
+{
+	VkDebugUtilsObjectTagInfoEXT tag_info{VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_TAG_INFO_EXT};
+	tag_info.objectType   = object_type;
+	tag_info.objectHandle = object_handle;
+	tag_info.tagName      = tag_name;
+	tag_info.tagSize      = tag_size;
+	tag_info.pTag         = tag;
+	vkSetDebugUtilsObjectTagEXT(device, &tag_info);
+}
+}        // namespace debug_utils
+}        // namespace vkb
+
+#endif
@@ -0,0 +1,126 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/error.h"
+#include "common/vk_common.h"
+
+// The framework only enables VK_EXT_debug_utils in debug builds or with the validation layers
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#	define VKB_DEBUG_UTILS
+#endif
+
+namespace vkb
+{
+/**
+ * @brief Dispatch of the VK_EXT_debug_utils labels and object names
+ *
+ * Labelling is off until a capture tool is detected or set_enabled() switches it on, so that
+ * runs without a debugger attached do not pay for it. Callers check is_enabled() before building
+ * label or object names; the calls themselves are not gated so that begin and end labels stay paired.
+ * Without VKB_DEBUG_UTILS everything compiles to nothing.
+ */
+namespace debug_utils
+{
+#ifdef VKB_DEBUG_UTILS
+/**
+ * @return Whether labelling is switched on and VK_EXT_debug_utils is loaded
+ */
+bool is_enabled();
+
+/**
+ * @brief Switches labelling on or off at runtime, command buffers pick it up when they begin
+ */
+void set_enabled(bool enabled);
+
+/**
+ * @brief Switches labelling on if a tracing tool such as RenderDoc is attached to the application
+ * @param gpu The physical device, asked for its active tools with VK_EXT_tooling_info
+ * @param tooling_info Whether the physical device supports VK_EXT_tooling_info
+ */
+void detect_capture_tools(VkPhysicalDevice gpu, bool tooling_info);
+
+void cmd_begin_label(VkCommandBuffer command_buffer, const char *name, const float *color = nullptr);
+
+void cmd_insert_label(VkCommandBuffer command_buffer, const char *name, const float *color = nullptr);
+
+void cmd_end_label(VkCommandBuffer command_buffer);
+
+void queue_begin_label(VkQueue queue, const char *name, const float *color = nullptr);
+
+void queue_insert_label(VkQueue queue, const char *name, const float *color = nullptr);
+
+void queue_end_label(VkQueue queue);
+
+void set_object_name(VkDevice device, VkObjectType object_type, uint64_t object_handle, const char *name);
+
+void set_object_tag(VkDevice device, VkObjectType object_type, uint64_t object_handle, uint64_t tag_name, const void *tag, size_t tag_size);
+#else
+inline bool is_enabled()
+{
+	return false;
+}
+
+inline void set_enabled(bool)
+{}
+
+inline void detect_capture_tools(VkPhysicalDevice, bool)
+{}
+
+inline void cmd_begin_label(VkCommandBuffer, const char *, const float * = nullptr)
+{}
+
+inline void cmd_insert_label(VkCommandBuffer, const char *, const float * = nullptr)
+{}
+
+inline void cmd_end_label(VkCommandBuffer)
+{}
+
+inline void queue_begin_label(VkQueue, const char *, const float * = nullptr)
+{}
+
+inline void queue_insert_label(VkQueue, const char *, const float * = nullptr)
+{}
+
+inline void queue_end_label(VkQueue)
+{}
+
+inline void set_object_name(VkDevice, VkObjectType, uint64_t, const char *)
+{}
+
+inline void set_object_tag(VkDevice, VkObjectType, uint64_t, uint64_t, const void *, size_t)
+{}
+#endif
+
+/**
+ * @brief Names an object only while labelling is enabled, the name is not built otherwise
+ * @param get_name Callable returning the name as a std::string
+ */
+template <typename NameFunc>
+inline void set_object_name_lazy(VkDevice device, VkObjectType object_type, uint64_t object_handle, NameFunc &&get_name)
+{
+	if (is_enabled())
+	{
+		set_object_name(device, object_type, object_handle, std::string(get_name()).c_str());
+	}
+}
+}        // namespace debug_utils
+}        // namespace vkb
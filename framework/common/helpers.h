@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
@@ -36,6 +37,10 @@
 
 #include "common/error.h"
 
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 #include <glm/gtx/hash.hpp>
@@ -175,6 +180,23 @@ inline void hash_combine(size_t &seed, const T &v)
 	glm::detail::hash_combine(seed, hasher(v));
 }
 
+/**
+ * @brief Index of the lowest bit set in a mask, to walk the bits set with mask &= mask - 1
+ * @param mask A mask with at least one bit set
+ */
+inline uint32_t lowest_bit_index(uint64_t mask)
+{
+	assert(mask != 0 && "The mask must have a bit set");
+
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+}
+
 /**
  * @brief Helper function to convert a data type
  *        to string using output stream operator.
@@ -0,0 +1,98 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/linear_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace vkb
+{
+LinearAllocator::LinearAllocator(size_t block_size) :
+    block_size{block_size}
+{
+}
+
+void *LinearAllocator::allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0 && "The alignment must be a power of two");
+
+	size = std::max<size_t>(size, 1);
+
+	while (block_index < blocks.size())
+	{
+		auto &block = blocks[block_index];
+
+		auto address = reinterpret_cast<uintptr_t>(block.data.get()) + offset;
+		auto padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+		if (offset + padding + size <= block.size)
+		{
+			offset += padding + size;
+			allocated_size += size;
+
+			return reinterpret_cast<void *>(address + padding);
+		}
+
+		// The rest of the block is wasted until the next reset merges the blocks
+		++block_index;
+		offset = 0;
+	}
+
+	add_block(std::max(block_size, size + alignment));
+
+	return allocate(size, alignment);
+}
+
+void LinearAllocator::reset()
+{
+	// A frame which needed several blocks gets a single block as large next time
+	if (blocks.size() > 1)
+	{
+		auto capacity = get_capacity();
+
+		blocks.clear();
+		add_block(capacity);
+	}
+
+	block_index    = 0;
+	offset         = 0;
+	allocated_size = 0;
+}
+
+size_t LinearAllocator::get_allocated_size() const
+{
+	return allocated_size;
+}
+
+size_t LinearAllocator::get_capacity() const
+{
+	size_t capacity = 0;
+
+	for (auto &block : blocks)
+	{
+		capacity += block.size;
+	}
+
+	return capacity;
+}
+
+void LinearAllocator::add_block(size_t size)
+{
+	blocks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[size]), size});
+}
+}        // namespace vkb
@@ -0,0 +1,165 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Arena handing out memory by bumping an offset in large blocks, released all at once by reset()
+ *
+ * Deallocations do nothing, so the arena suits containers thrown away at the end of a frame.
+ * reset() keeps the memory and merges the blocks into one, so a frame allocating as much as
+ * the previous one does not reach the heap. An arena is not thread safe, each recording thread
+ * of a frame owns its own.
+ */
+class LinearAllocator
+{
+  public:
+	/**
+	 * @param block_size Size of the blocks in bytes, larger allocations get a block of their own size
+	 */
+	LinearAllocator(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	LinearAllocator(const LinearAllocator &) = delete;
+
+	LinearAllocator(LinearAllocator &&) = default;
+
+	~LinearAllocator() = default;
+
+	LinearAllocator &operator=(const LinearAllocator &) = delete;
+
+	LinearAllocator &operator=(LinearAllocator &&) = default;
+
+	/**
+	 * @param alignment A power of two
+	 */
+	void *allocate(size_t size, size_t alignment);
+
+	/**
+	 * @brief Releases all the allocations, the containers using the arena must be gone
+	 */
+	void reset();
+
+	/**
+	 * @return The bytes allocated since the last reset
+	 */
+	size_t get_allocated_size() const;
+
+	/**
+	 * @return The size of the blocks held by the arena
+	 */
+	size_t get_capacity() const;
+
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+  private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+
+		size_t size;
+	};
+
+	void add_block(size_t size);
+
+	size_t block_size;
+
+	std::vector<Block> blocks;
+
+	/// Block allocated from and offset of its first free byte
+	size_t block_index{0};
+
+	size_t offset{0};
+
+	size_t allocated_size{0};
+};
+
+/**
+ * @brief Standard allocator allocating from a LinearAllocator, or from the heap when default constructed
+ *
+ * Containers with the allocator are declared like the ones with std::allocator, and only the ones
+ * constructed with an arena use it. Memory from an arena is reclaimed when the arena is reset.
+ */
+template <typename T>
+class ArenaAllocator
+{
+  public:
+	using value_type = T;
+
+	ArenaAllocator() = default;
+
+	ArenaAllocator(LinearAllocator &arena) :
+	    arena{&arena}
+	{}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) :
+	    arena{other.get_arena()}
+	{}
+
+	T *allocate(size_t count)
+	{
+		if (arena)
+		{
+			return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+		}
+
+		return static_cast<T *>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, size_t)
+	{
+		if (!arena)
+		{
+			::operator delete(pointer);
+		}
+	}
+
+	LinearAllocator *get_arena() const
+	{
+		return arena;
+	}
+
+  private:
+	LinearAllocator *arena{nullptr};
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+	return lhs.get_arena() == rhs.get_arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+	return !(lhs == rhs);
+}
+
+/**
+ * @brief A vector whose storage may come from an arena
+ */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}        // namespace vkb
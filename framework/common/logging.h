@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <iterator>
+
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 
@@ -25,7 +27,69 @@
 
 #define __FILENAME__ (static_cast<const char *>(__FILE__) + ROOT_PATH_SIZE)
 
-#define LOGI(...) spdlog::info(__VA_ARGS__);
-#define LOGW(...) spdlog::warn(__VA_ARGS__);
-#define LOGE(...) spdlog::error("[{}:{}] {}", __FILENAME__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOGD(...) spdlog::debug(__VA_ARGS__);
+#define VKB_LOG_LEVEL_DEBUG 0
+#define VKB_LOG_LEVEL_INFO 1
+#define VKB_LOG_LEVEL_WARN 2
+#define VKB_LOG_LEVEL_ERROR 3
+#define VKB_LOG_LEVEL_OFF 4
+
+// Messages below the level are compiled out, set by the VKB_LOG_LEVEL CMake option
+#ifndef VKB_LOG_LEVEL
+#	define VKB_LOG_LEVEL VKB_LOG_LEVEL_DEBUG
+#endif
+
+namespace vkb
+{
+namespace logging
+{
+/**
+ * @brief Logs an error prefixed with its location
+ * @param message The error, already formatted by LOGE in a stack buffer
+ */
+inline void error(const char *file, int line, const fmt::memory_buffer &message)
+{
+	spdlog::error("[{}:{}] {}", file, line, fmt::string_view(message.data(), message.size()));
+}
+}        // namespace logging
+}        // namespace vkb
+
+// Stripped messages are type checked but never evaluated, the variables only logged are still used
+#define VKB_LOG_DISCARD(...)           \
+	do                                 \
+	{                                  \
+		if (false)                     \
+		{                              \
+			spdlog::info(__VA_ARGS__); \
+		}                              \
+	} while (0);
+
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_INFO
+#	define LOGI(...) spdlog::info(__VA_ARGS__);
+#else
+#	define LOGI(...) VKB_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_WARN
+#	define LOGW(...) spdlog::warn(__VA_ARGS__);
+#else
+#	define LOGW(...) VKB_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+// The format stays a literal at the call site, checked when compiling
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_ERROR
+#	define LOGE(format, ...)                                                                        \
+		do                                                                                          \
+		{                                                                                           \
+			fmt::memory_buffer vkb_log_message;                                                     \
+			fmt::format_to(std::back_inserter(vkb_log_message), FMT_STRING(format), ##__VA_ARGS__); \
+			vkb::logging::error(__FILENAME__, __LINE__, vkb_log_message);                           \
+		} while (0);
+#else
+#	define LOGE(...) VKB_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if VKB_LOG_LEVEL <= VKB_LOG_LEVEL_DEBUG
+#	define LOGD(...) spdlog::debug(__VA_ARGS__);
+#else
+#	define LOGD(...) VKB_LOG_DISCARD(__VA_ARGS__)
+#endif
@@ -0,0 +1,79 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "common/memory_copy.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define VKB_COPY_SSE2
+#	include <emmintrin.h>
+#endif
+
+namespace vkb
+{
+namespace
+{
+/// Smaller copies stay in the write-combining buffers anyway, the fence would cost more than it saves
+constexpr size_t streaming_threshold = 256;
+}        // namespace
+
+void copy_to_write_combined(void *dst, const void *src, size_t size)
+{
+#ifdef VKB_COPY_SSE2
+	if (size >= streaming_threshold)
+	{
+		auto *      out = static_cast<uint8_t *>(dst);
+		const auto *in  = static_cast<const uint8_t *>(src);
+
+		// The streaming stores need an aligned destination
+		size_t head = (16 - (reinterpret_cast<uintptr_t>(out) & 15)) & 15;
+		std::memcpy(out, in, head);
+		out += head;
+		in += head;
+		size -= head;
+
+		for (; size >= 64; size -= 64, out += 64, in += 64)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 16));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 32));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i *>(out), a);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(out + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(out + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i *>(out + 48), d);
+		}
+
+		for (; size >= 16; size -= 16, out += 16, in += 16)
+		{
+			_mm_stream_si128(reinterpret_cast<__m128i *>(out), _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+		}
+
+		std::memcpy(out, in, size);
+
+		// Non-temporal stores are weakly ordered, they must be visible before the queue submission
+		_mm_sfence();
+		return;
+	}
+#endif
+
+	std::memcpy(dst, src, size);
+}
+}        // namespace vkb
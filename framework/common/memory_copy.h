@@ -0,0 +1,34 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+namespace vkb
+{
+/**
+ * @brief Copies to memory which is mapped write-combined, HOST_VISIBLE without HOST_CACHED
+ *        Large copies use non-temporal stores with SSE2, which write whole lines without reading
+ *        them into the cache first. The other copies, and the other instruction sets, use memcpy.
+ * @param dst The mapped memory to write
+ * @param src The data to copy
+ * @param size The amount of bytes to copy
+ */
+void copy_to_write_combined(void *dst, const void *src, size_t size);
+}        // namespace vkb
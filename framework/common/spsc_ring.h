@@ -0,0 +1,122 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Lock-free ring of preallocated slots between one producer thread and one consumer thread
+ *
+ * The slots are constructed once and reused, the producer fills the slot returned by begin_push()
+ * in place and publishes it with end_push(), the consumer reads front() and releases it with pop().
+ * A full ring refuses new items rather than overwriting the unread ones.
+ */
+template <typename T>
+class SpscRing
+{
+  public:
+	/**
+	 * @param capacity Number of slots, rounded up to a power of two
+	 * @param slot The value every slot is initialized with, e.g. with reserved storage
+	 */
+	SpscRing(size_t capacity, const T &slot = T{})
+	{
+		size_t size = 1;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+
+		slots.resize(size, slot);
+		mask = size - 1;
+	}
+
+	SpscRing(const SpscRing &) = delete;
+
+	SpscRing &operator=(const SpscRing &) = delete;
+
+	/**
+	 * @brief Producer only
+	 * @return The slot to fill, nullptr if the ring is full
+	 */
+	T *begin_push()
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) == slots.size())
+		{
+			return nullptr;
+		}
+
+		return &slots[h & mask];
+	}
+
+	/**
+	 * @brief Producer only, publishes the slot returned by begin_push()
+	 */
+	void end_push()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Consumer only
+	 * @return The oldest published slot, nullptr if the ring is empty
+	 */
+	T *front()
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		return &slots[t & mask];
+	}
+
+	/**
+	 * @brief Consumer only, gives the slot returned by front() back to the producer
+	 */
+	void pop()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @return Number of published slots, exact for the consumer
+	 */
+	size_t size() const
+	{
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+	}
+
+  private:
+	std::vector<T> slots;
+
+	size_t mask{0};
+
+	/// Next slot to publish, written by the producer
+	std::atomic<size_t> head{0};
+
+	/// Next slot to read, written by the consumer
+	std::atomic<size_t> tail{0};
+};
+}        // namespace vkb
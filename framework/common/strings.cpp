@@ -1097,6 +1097,36 @@ const std::string to_string(VkBlendOp operation)
 	return "Unkown";
 }
 
+const std::string to_string(VkAttachmentLoadOp operation)
+{
+	if (operation == VK_ATTACHMENT_LOAD_OP_LOAD)
+	{
+		return "LOAD";
+	}
+	if (operation == VK_ATTACHMENT_LOAD_OP_CLEAR)
+	{
+		return "CLEAR";
+	}
+	if (operation == VK_ATTACHMENT_LOAD_OP_DONT_CARE)
+	{
+		return "DONT_CARE";
+	}
+	return "Unknown Attachment Load Op";
+}
+
+const std::string to_string(VkAttachmentStoreOp operation)
+{
+	if (operation == VK_ATTACHMENT_STORE_OP_STORE)
+	{
+		return "STORE";
+	}
+	if (operation == VK_ATTACHMENT_STORE_OP_DONT_CARE)
+	{
+		return "DONT_CARE";
+	}
+	return "Unknown Attachment Store Op";
+}
+
 const std::string to_string(sg::AlphaMode mode)
 {
 	if (mode == sg::AlphaMode::Blend)
@@ -1145,6 +1175,8 @@ const std::string to_string(ShaderResourceType type)
 			return "BufferUniform";
 		case ShaderResourceType::BufferStorage:
 			return "BufferStorage";
+		case ShaderResourceType::AccelerationStructure:
+			return "AccelerationStructure";
 		case ShaderResourceType::PushConstant:
 			return "PushConstant";
 		case ShaderResourceType::SpecializationConstant:
@@ -1229,4 +1261,15 @@ const std::string color_component_to_string(VkColorComponentFlags flags)
 	                                            {VK_COLOR_COMPONENT_B_BIT, "B"},
 	                                            {VK_COLOR_COMPONENT_A_BIT, "A"}});
 }
+
+const std::string memory_property_to_string(VkMemoryPropertyFlags flags)
+{
+	return to_string<VkMemoryPropertyFlagBits>(flags,
+	                                           {{VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT"},
+	                                            {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, "VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT"},
+	                                            {VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "VK_MEMORY_PROPERTY_HOST_COHERENT_BIT"},
+	                                            {VK_MEMORY_PROPERTY_HOST_CACHED_BIT, "VK_MEMORY_PROPERTY_HOST_CACHED_BIT"},
+	                                            {VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, "VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT"},
+	                                            {VK_MEMORY_PROPERTY_PROTECTED_BIT, "VK_MEMORY_PROPERTY_PROTECTED_BIT"}});
+}
 }        // namespace vkb
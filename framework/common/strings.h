@@ -187,6 +187,20 @@ const std::string to_string(VkLogicOp operation);
  */
 const std::string to_string(VkBlendOp operation);
 
+/**
+ * @brief Helper function to convert VkAttachmentLoadOp to a string 
+ * @param operation Vulkan VkAttachmentLoadOp to convert
+ * @return The string to return 
+ */
+const std::string to_string(VkAttachmentLoadOp operation);
+
+/**
+ * @brief Helper function to convert VkAttachmentStoreOp to a string 
+ * @param operation Vulkan VkAttachmentStoreOp to convert
+ * @return The string to return 
+ */
+const std::string to_string(VkAttachmentStoreOp operation);
+
 /**
  * @brief Helper function to convert AlphaMode to a string 
  * @param mode Vulkan AlphaMode to convert
@@ -275,4 +289,11 @@ const std::string cull_mode_to_string(VkCullModeFlags bitmask);
  * @return The converted string to return
  */
 const std::string color_component_to_string(VkColorComponentFlags bitmask);
+
+/**
+ * @brief Helper function to convert VkMemoryPropertyFlags to a string
+ * @param bitmask The memory property bitmask to convert
+ * @return The converted string to return
+ */
+const std::string memory_property_to_string(VkMemoryPropertyFlags bitmask);
 }        // namespace vkb
@@ -330,6 +330,18 @@ bool generate_all(RenderContext &context, sg::Scene &scene)
 	}
 	return success;
 }
+
+bool generate_all(RenderContext &context, sg::Scene &scene, graphing::AsyncGraphWriter &writer)
+{
+	if (writer.is_busy())
+	{
+		return false;
+	}
+
+	writer.write(graphing::framework_graph::capture(context), "framework.json");
+	writer.write(graphing::scene_graph::capture(scene), "scene.json");
+	return true;
+}
 }        // namespace graphs
 
 }        // namespace vkb
@@ -24,6 +24,7 @@ VKBP_DISABLE_WARNINGS()
 #include "glm/gtx/quaternion.hpp"
 VKBP_ENABLE_WARNINGS()
 
+#include "graphing/graph.h"
 #include "platform/filesystem.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_context.h"
@@ -96,6 +97,13 @@ sg::Node &add_free_camera(sg::Scene &scene, const std::string &node_name, VkExte
 namespace graphs
 {
 bool generate_all(RenderContext &context, sg::Scene &scene);
+
+/**
+ * @brief Snapshots the framework and scene graphs and hands them to the writer, so that
+ *        the JSON files are written off the calling thread
+ * @return False if the writer is still busy with a previous request, in which case nothing is captured
+ */
+bool generate_all(RenderContext &context, sg::Scene &scene, graphing::AsyncGraphWriter &writer);
 }
 
 }        // namespace vkb
@@ -20,6 +20,7 @@
 
 #include <spdlog/fmt/fmt.h>
 
+#include "core/physical_device.h"
 #include "glsl_compiler.h"
 #include "platform/filesystem.h"
 
@@ -124,7 +125,10 @@ bool is_depth_stencil_format(VkFormat format)
 	       is_depth_only_format(format);
 }
 
-VkFormat get_suitable_depth_format(VkPhysicalDevice physical_device, bool depth_only, const std::vector<VkFormat> &depth_format_priority_list)
+namespace
+{
+template <class GetFormatProperties>
+VkFormat select_depth_format(GetFormatProperties get_format_properties, bool depth_only, const std::vector<VkFormat> &depth_format_priority_list)
 {
 	VkFormat depth_format{VK_FORMAT_UNDEFINED};
 
@@ -135,8 +139,7 @@ VkFormat get_suitable_depth_format(VkPhysicalDevice physical_device, bool depth_
 			continue;
 		}
 
-		VkFormatProperties properties;
-		vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+		VkFormatProperties properties = get_format_properties(format);
 
 		// Format must support depth stencil attachment for optimal tiling
 		if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
@@ -154,6 +157,27 @@ VkFormat get_suitable_depth_format(VkPhysicalDevice physical_device, bool depth_
 
 	throw std::runtime_error("No suitable depth format could be determined");
 }
+}        // namespace
+
+VkFormat get_suitable_depth_format(VkPhysicalDevice physical_device, bool depth_only, const std::vector<VkFormat> &depth_format_priority_list)
+{
+	auto get_format_properties = [physical_device](VkFormat format) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+		return properties;
+	};
+
+	return select_depth_format(get_format_properties, depth_only, depth_format_priority_list);
+}
+
+VkFormat get_suitable_depth_format(const PhysicalDevice &gpu, bool depth_only, const std::vector<VkFormat> &depth_format_priority_list)
+{
+	auto get_format_properties = [&gpu](VkFormat format) {
+		return gpu.get_format_properties(format);
+	};
+
+	return select_depth_format(get_format_properties, depth_only, depth_format_priority_list);
+}
 
 bool is_dynamic_buffer_descriptor_type(VkDescriptorType descriptor_type)
 {
@@ -161,6 +185,18 @@ bool is_dynamic_buffer_descriptor_type(VkDescriptorType descriptor_type)
 	       descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 }
 
+bool is_write_access(VkAccessFlags access_mask)
+{
+	const VkAccessFlags write_access = VK_ACCESS_SHADER_WRITE_BIT |
+	                                   VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	                                   VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	                                   VK_ACCESS_TRANSFER_WRITE_BIT |
+	                                   VK_ACCESS_HOST_WRITE_BIT |
+	                                   VK_ACCESS_MEMORY_WRITE_BIT;
+
+	return (access_mask & write_access) != 0;
+}
+
 bool is_buffer_descriptor_type(VkDescriptorType descriptor_type)
 {
 	return descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
@@ -548,6 +584,27 @@ void insert_image_memory_barrier(
 }
 namespace gbuffer
 {
+VkFormat get_albedo_format(Layout layout)
+{
+	return layout == Layout::Compact ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+VkFormat get_normal_format(Layout layout)
+{
+	// Two components of a half float are enough for an octahedral normal, and are a required color attachment format
+	return layout == Layout::Compact ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+std::vector<std::string> get_shader_definitions(Layout layout)
+{
+	if (layout == Layout::Compact)
+	{
+		return {"COMPACT_GBUFFER"};
+	}
+
+	return {};
+}
+
 std::vector<LoadStoreInfo> get_load_all_store_swapchain()
 {
 	// Load every attachment and store only swapchain
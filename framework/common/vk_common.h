@@ -40,6 +40,8 @@ using BindingMap = std::map<uint32_t, std::map<uint32_t, T>>;
 
 namespace vkb
 {
+class PhysicalDevice;
+
 /**
  * @brief Helper function to determine if a Vulkan format is depth only.
  * @param format Vulkan format to check.
@@ -69,6 +71,22 @@ VkFormat get_suitable_depth_format(VkPhysicalDevice             physical_device,
                                        VK_FORMAT_D24_UNORM_S8_UINT,
                                        VK_FORMAT_D16_UNORM});
 
+/**
+ * @brief Helper function to determine a suitable supported depth format based on a priority list
+ *        The format properties are looked up in the capability cache of the physical device
+ * @param gpu The physical device to check the depth formats against
+ * @param depth_only (Optional) Wether to include the stencil component in the format or not
+ * @param depth_format_priority_list (Optional) The list of depth formats to prefer over one another
+ *		  By default we start with the highest precision packed format
+ * @return The valid suited depth format
+ */
+VkFormat get_suitable_depth_format(const PhysicalDevice &       gpu,
+                                   bool                         depth_only                 = false,
+                                   const std::vector<VkFormat> &depth_format_priority_list = {
+                                       VK_FORMAT_D32_SFLOAT,
+                                       VK_FORMAT_D24_UNORM_S8_UINT,
+                                       VK_FORMAT_D16_UNORM});
+
 /**
  * @brief Helper function to determine if a Vulkan descriptor type is a dynamic storage buffer or dynamic uniform buffer.
  * @param descriptor_type Vulkan descriptor type to check.
@@ -83,6 +101,11 @@ bool is_dynamic_buffer_descriptor_type(VkDescriptorType descriptor_type);
  */
 bool is_buffer_descriptor_type(VkDescriptorType descriptor_type);
 
+/**
+ * @return Whether an access mask contains memory writes
+ */
+bool is_write_access(VkAccessFlags access_mask);
+
 /**
  * @brief Helper function to get the bits per pixel of a Vulkan format.
  * @param format Vulkan format to check.
@@ -99,6 +122,22 @@ int32_t get_bits_per_pixel(VkFormat format);
  */
 VkShaderModule load_shader(const std::string &filename, VkDevice device, VkShaderStageFlagBits stage);
 
+/**
+ * @brief Use of a resource by the commands of a command buffer, tracked by the resource
+ *        so that the barrier before its next use can be derived from it
+ */
+struct ResourceAccess
+{
+	VkPipelineStageFlags stage_mask{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+
+	VkAccessFlags access_mask{0};
+
+	/// Only used by images
+	VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	uint32_t queue_family{VK_QUEUE_FAMILY_IGNORED};
+};
+
 /**
  * @brief Image memory barrier structure used to define
  *        memory access for an image view during command recording.
@@ -116,6 +155,10 @@ struct ImageMemoryBarrier
 	VkImageLayout old_layout{VK_IMAGE_LAYOUT_UNDEFINED};
 
 	VkImageLayout new_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	uint32_t old_queue_family{VK_QUEUE_FAMILY_IGNORED};
+
+	uint32_t new_queue_family{VK_QUEUE_FAMILY_IGNORED};
 };
 
 /**
@@ -131,6 +174,10 @@ struct BufferMemoryBarrier
 	VkAccessFlags src_access_mask{0};
 
 	VkAccessFlags dst_access_mask{0};
+
+	uint32_t old_queue_family{VK_QUEUE_FAMILY_IGNORED};
+
+	uint32_t new_queue_family{VK_QUEUE_FAMILY_IGNORED};
 };
 
 /**
@@ -183,6 +230,33 @@ struct LoadStoreInfo
 
 namespace gbuffer
 {
+/**
+ * @brief Contents of the albedo and normal attachments of the G-buffer, the position is reconstructed from the depth
+ */
+enum class Layout
+{
+	/// Albedo and normal in RGBA16F, the normal as XYZ remapped to [0, 1]. Narrower formats such as A2B10G10R10 read the same
+	Full,
+
+	/// Albedo in RGBA8 with the metallic and roughness factors packed in its alpha, octahedral normal in RG16F
+	Compact
+};
+
+/**
+ * @return Format of the albedo attachment of a layout
+ */
+VkFormat get_albedo_format(Layout layout);
+
+/**
+ * @return Format of the normal attachment of a layout
+ */
+VkFormat get_normal_format(Layout layout);
+
+/**
+ * @return Definitions of the shader variants writing and reading a layout, COMPACT_GBUFFER for the compact one
+ */
+std::vector<std::string> get_shader_definitions(Layout layout);
+
 /**
   * @return Load store info to load all and store only the swapchain
   */
@@ -0,0 +1,502 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "acceleration_structure.h"
+
+#include <algorithm>
+
+#include "device.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace core
+{
+namespace
+{
+// Conservative alignment of the build regions inside a shared scratch buffer
+constexpr VkDeviceSize SCRATCH_ALIGNMENT = 256;
+
+VkDeviceSize align_scratch(VkDeviceSize size)
+{
+	return (size + SCRATCH_ALIGNMENT - 1) & ~(SCRATCH_ALIGNMENT - 1);
+}
+
+uint64_t get_buffer_device_address(Device &device, VkBuffer buffer)
+{
+	VkBufferDeviceAddressInfoKHR buffer_device_address_info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+	buffer_device_address_info.buffer = buffer;
+	return vkGetBufferDeviceAddressKHR(device.get_handle(), &buffer_device_address_info);
+}
+
+VkDeviceSize get_memory_requirements(Device &device, VkAccelerationStructureKHR handle, VkAccelerationStructureMemoryRequirementsTypeKHR type, VkMemoryRequirements *requirements = nullptr)
+{
+	VkAccelerationStructureMemoryRequirementsInfoKHR requirements_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR};
+	requirements_info.type                  = type;
+	requirements_info.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
+	requirements_info.accelerationStructure = handle;
+
+	VkMemoryRequirements2 memory_requirements{VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &requirements_info, &memory_requirements);
+
+	if (requirements)
+	{
+		*requirements = memory_requirements.memoryRequirements;
+	}
+	return memory_requirements.memoryRequirements.size;
+}
+}        // namespace
+
+AccelerationStructure::AccelerationStructure(Device &device, const VkAccelerationStructureCreateInfoKHR &info) :
+    device{device},
+    type{info.type}
+{
+	VK_CHECK(vkCreateAccelerationStructureKHR(device.get_handle(), &info, nullptr, &handle));
+
+	VkMemoryRequirements requirements{};
+	memory_size = get_memory_requirements(device, handle, VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_OBJECT_KHR, &requirements);
+
+	VmaAllocationCreateInfo memory_info{};
+	memory_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VmaAllocationInfo allocation_info{};
+	VK_CHECK(vmaAllocateMemory(device.get_memory_allocator(), &requirements, &memory_info, &allocation, &allocation_info));
+
+	VkBindAccelerationStructureMemoryInfoKHR bind_info{VK_STRUCTURE_TYPE_BIND_ACCELERATION_STRUCTURE_MEMORY_INFO_KHR};
+	bind_info.accelerationStructure = handle;
+	bind_info.memory                = allocation_info.deviceMemory;
+	bind_info.memoryOffset          = allocation_info.offset;
+	VK_CHECK(vkBindAccelerationStructureMemoryKHR(device.get_handle(), 1, &bind_info));
+
+	VkAccelerationStructureDeviceAddressInfoKHR address_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR};
+	address_info.accelerationStructure = handle;
+	device_address                     = vkGetAccelerationStructureDeviceAddressKHR(device.get_handle(), &address_info);
+}
+
+AccelerationStructure::AccelerationStructure(AccelerationStructure &&other) :
+    device{other.device},
+    handle{other.handle},
+    type{other.type},
+    allocation{other.allocation},
+    memory_size{other.memory_size},
+    device_address{other.device_address}
+{
+	other.handle     = VK_NULL_HANDLE;
+	other.allocation = VK_NULL_HANDLE;
+}
+
+AccelerationStructure::~AccelerationStructure()
+{
+	if (handle != VK_NULL_HANDLE)
+	{
+		vkDestroyAccelerationStructureKHR(device.get_handle(), handle, nullptr);
+	}
+	if (allocation != VK_NULL_HANDLE)
+	{
+		vmaFreeMemory(device.get_memory_allocator(), allocation);
+	}
+}
+
+VkAccelerationStructureKHR AccelerationStructure::get_handle() const
+{
+	assert(handle != VK_NULL_HANDLE && "AccelerationStructure handle is invalid");
+	return handle;
+}
+
+VkAccelerationStructureTypeKHR AccelerationStructure::get_type() const
+{
+	return type;
+}
+
+uint64_t AccelerationStructure::get_device_address() const
+{
+	return device_address;
+}
+
+VkDeviceSize AccelerationStructure::get_memory_size() const
+{
+	return memory_size;
+}
+
+VkDeviceSize AccelerationStructure::get_scratch_size(VkAccelerationStructureMemoryRequirementsTypeKHR scratch_type) const
+{
+	return get_memory_requirements(device, get_handle(), scratch_type);
+}
+
+void BottomLevelGeometry::add_triangles(uint64_t vertex_address, VkDeviceSize vertex_stride, uint32_t vertex_count,
+                                        uint64_t index_address, VkIndexType index_type, uint32_t triangle_count,
+                                        VkGeometryFlagsKHR flags)
+{
+	VkAccelerationStructureCreateGeometryTypeInfoKHR type_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR};
+	type_info.geometryType      = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+	type_info.maxPrimitiveCount = triangle_count;
+	type_info.indexType         = index_type;
+	type_info.maxVertexCount    = vertex_count;
+	type_info.vertexFormat      = VK_FORMAT_R32G32B32_SFLOAT;
+	type_info.allowsTransforms  = VK_FALSE;
+	types.push_back(type_info);
+
+	VkAccelerationStructureGeometryKHR geometry{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR};
+	geometry.flags                                       = flags;
+	geometry.geometryType                                = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+	geometry.geometry.triangles.sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+	geometry.geometry.triangles.vertexFormat             = VK_FORMAT_R32G32B32_SFLOAT;
+	geometry.geometry.triangles.vertexData.deviceAddress = vertex_address;
+	geometry.geometry.triangles.vertexStride             = vertex_stride;
+	geometry.geometry.triangles.indexType                = index_type;
+	geometry.geometry.triangles.indexData.deviceAddress  = index_address;
+	geometries.push_back(geometry);
+
+	VkAccelerationStructureBuildOffsetInfoKHR range{};
+	range.primitiveCount = triangle_count;
+	ranges.push_back(range);
+}
+
+AccelerationStructureBuilder::AccelerationStructureBuilder(Device &device, VkDeviceSize scratch_budget) :
+    device{device},
+    scratch_budget{scratch_budget}
+{
+}
+
+uint32_t AccelerationStructureBuilder::add_bottom_level(BottomLevelGeometry geometry, VkBuildAccelerationStructureFlagsKHR flags)
+{
+	assert(!geometry.geometries.empty() && geometry.geometries.size() == geometry.ranges.size());
+
+	BottomLevel bottom_level;
+	bottom_level.geometry = std::move(geometry);
+	bottom_level.flags    = flags;
+	bottom_levels.push_back(std::move(bottom_level));
+
+	return static_cast<uint32_t>(bottom_levels.size() - 1);
+}
+
+void AccelerationStructureBuilder::build(VkQueue queue)
+{
+	// Structures are created right before their batch is built, so the memory of the uncompacted
+	// structures never exceeds one batch
+	std::unique_ptr<Buffer> scratch;
+
+	size_t       first         = built_count;
+	VkDeviceSize batch_scratch = 0;
+	for (size_t i = built_count; i < bottom_levels.size(); i++)
+	{
+		auto &bottom_level = bottom_levels[i];
+
+		VkAccelerationStructureCreateInfoKHR create_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
+		create_info.type             = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+		create_info.flags            = bottom_level.flags;
+		create_info.maxGeometryCount = to_u32(bottom_level.geometry.types.size());
+		create_info.pGeometryInfos   = bottom_level.geometry.types.data();
+
+		bottom_level.structure    = std::make_unique<AccelerationStructure>(device, create_info);
+		bottom_level.scratch_size = align_scratch(bottom_level.structure->get_scratch_size(VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_KHR));
+		uncompacted_size += bottom_level.structure->get_memory_size();
+
+		if (i > first && batch_scratch + bottom_level.scratch_size > scratch_budget)
+		{
+			build_batch(queue, first, i, scratch, batch_scratch);
+			first         = i;
+			batch_scratch = 0;
+		}
+		batch_scratch += bottom_level.scratch_size;
+	}
+
+	if (first < bottom_levels.size())
+	{
+		build_batch(queue, first, bottom_levels.size(), scratch, batch_scratch);
+	}
+
+	built_count = bottom_levels.size();
+}
+
+void AccelerationStructureBuilder::build_batch(VkQueue queue, size_t first, size_t last, std::unique_ptr<Buffer> &scratch, VkDeviceSize scratch_size)
+{
+	// The previous batch has finished, so its scratch buffer can be replaced
+	if (!scratch || scratch->get_size() < scratch_size)
+	{
+		scratch.reset();
+		scratch = std::make_unique<Buffer>(device, scratch_size, VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0);
+	}
+	uint64_t scratch_address = get_buffer_device_address(device, scratch->get_handle());
+
+	size_t count = last - first;
+
+	std::vector<const VkAccelerationStructureGeometryKHR *>        geometry_arrays(count);
+	std::vector<const VkAccelerationStructureBuildOffsetInfoKHR *> offset_infos(count);
+	std::vector<VkAccelerationStructureBuildGeometryInfoKHR>       build_infos(count);
+	std::vector<VkAccelerationStructureKHR>                        compactable;
+
+	// Every build of the batch uses its own region of the scratch buffer, so they can all run at once
+	VkDeviceSize scratch_offset = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		auto &bottom_level = bottom_levels[first + i];
+
+		geometry_arrays[i] = bottom_level.geometry.geometries.data();
+		offset_infos[i]    = bottom_level.geometry.ranges.data();
+
+		auto &build_info                     = build_infos[i];
+		build_info.sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
+		build_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+		build_info.flags                     = bottom_level.flags;
+		build_info.update                    = VK_FALSE;
+		build_info.srcAccelerationStructure  = VK_NULL_HANDLE;
+		build_info.dstAccelerationStructure  = bottom_level.structure->get_handle();
+		build_info.geometryArrayOfPointers   = VK_FALSE;
+		build_info.geometryCount             = to_u32(bottom_level.geometry.geometries.size());
+		build_info.ppGeometries              = &geometry_arrays[i];
+		build_info.scratchData.deviceAddress = scratch_address + scratch_offset;
+
+		scratch_offset += bottom_level.scratch_size;
+
+		if (bottom_level.flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR)
+		{
+			compactable.push_back(bottom_level.structure->get_handle());
+		}
+	}
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	vkCmdBuildAccelerationStructureKHR(command_buffer, to_u32(count), build_infos.data(), offset_infos.data());
+
+	if (!compactable.empty())
+	{
+		if (query_count < compactable.size())
+		{
+			query_count = to_u32(compactable.size());
+
+			VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+			query_pool_info.queryType  = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+			query_pool_info.queryCount = query_count;
+			query_pool                 = std::make_unique<QueryPool>(device, query_pool_info);
+		}
+
+		// The compacted sizes are only known once the builds have finished
+		VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+		barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+		barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		vkCmdResetQueryPool(command_buffer, query_pool->get_handle(), 0, to_u32(compactable.size()));
+		vkCmdWriteAccelerationStructuresPropertiesKHR(command_buffer, to_u32(compactable.size()), compactable.data(),
+		                                              VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, query_pool->get_handle(), 0);
+	}
+
+	device.flush_command_buffer(command_buffer, queue);
+
+	if (!compactable.empty())
+	{
+		compact_batch(queue, first, last);
+	}
+}
+
+void AccelerationStructureBuilder::compact_batch(VkQueue queue, size_t first, size_t last)
+{
+	std::vector<size_t> indices;
+	for (size_t i = first; i < last; i++)
+	{
+		if (bottom_levels[i].flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR)
+		{
+			indices.push_back(i);
+		}
+	}
+
+	std::vector<VkDeviceSize> compacted_sizes(indices.size());
+	VK_CHECK(query_pool->get_results(0, to_u32(indices.size()), compacted_sizes.size() * sizeof(VkDeviceSize), compacted_sizes.data(),
+	                                 sizeof(VkDeviceSize), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+	std::vector<std::unique_ptr<AccelerationStructure>> compacted;
+	compacted.reserve(indices.size());
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		auto &bottom_level = bottom_levels[indices[i]];
+
+		VkAccelerationStructureCreateInfoKHR create_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
+		create_info.compactedSize = compacted_sizes[i];
+		create_info.type          = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+		create_info.flags         = bottom_level.flags;
+		compacted.push_back(std::make_unique<AccelerationStructure>(device, create_info));
+
+		VkCopyAccelerationStructureInfoKHR copy_info{VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR};
+		copy_info.src  = bottom_level.structure->get_handle();
+		copy_info.dst  = compacted.back()->get_handle();
+		copy_info.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+		vkCmdCopyAccelerationStructureKHR(command_buffer, &copy_info);
+	}
+	device.flush_command_buffer(command_buffer, queue);
+
+	// The uncompacted structures are released right away
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		bottom_levels[indices[i]].structure = std::move(compacted[i]);
+	}
+}
+
+AccelerationStructure &AccelerationStructureBuilder::get_bottom_level(uint32_t index)
+{
+	assert(index < built_count && "Bottom level acceleration structure has not been built");
+	return *bottom_levels[index].structure;
+}
+
+VkDeviceSize AccelerationStructureBuilder::get_uncompacted_size() const
+{
+	return uncompacted_size;
+}
+
+VkDeviceSize AccelerationStructureBuilder::get_compacted_size() const
+{
+	VkDeviceSize size = 0;
+	for (size_t i = 0; i < built_count; i++)
+	{
+		size += bottom_levels[i].structure->get_memory_size();
+	}
+	return size;
+}
+
+TopLevelAccelerationStructure::TopLevelAccelerationStructure(Device &device, std::vector<Instance> instances, bool allow_update, VkPipelineStageFlags trace_stages) :
+    device{device},
+    instances{std::move(instances)},
+    flags{VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR},
+    trace_stages{trace_stages}
+{
+	assert(!this->instances.empty());
+
+	if (allow_update)
+	{
+		flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+	}
+
+	VkAccelerationStructureCreateGeometryTypeInfoKHR type_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR};
+	type_info.geometryType      = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+	type_info.maxPrimitiveCount = to_u32(this->instances.size());
+	type_info.allowsTransforms  = VK_FALSE;
+
+	VkAccelerationStructureCreateInfoKHR create_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
+	create_info.type             = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
+	create_info.flags            = flags;
+	create_info.maxGeometryCount = 1;
+	create_info.pGeometryInfos   = &type_info;
+	structure                    = std::make_unique<AccelerationStructure>(device, create_info);
+
+	instance_buffer = std::make_unique<Buffer>(device,
+	                                           this->instances.size() * sizeof(VkAccelerationStructureInstanceKHR),
+	                                           VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+	                                           VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	// One scratch buffer serves both builds and refits
+	VkDeviceSize scratch_size = structure->get_scratch_size(VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_KHR);
+	if (allow_update)
+	{
+		scratch_size = std::max(scratch_size, structure->get_scratch_size(VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_UPDATE_SCRATCH_KHR));
+	}
+	scratch_buffer = std::make_unique<Buffer>(device, scratch_size, VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0);
+}
+
+void TopLevelAccelerationStructure::build(VkCommandBuffer command_buffer)
+{
+	record(command_buffer, false);
+	built = true;
+}
+
+void TopLevelAccelerationStructure::update(VkCommandBuffer command_buffer)
+{
+	record(command_buffer, built && (flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR));
+	built = true;
+}
+
+void TopLevelAccelerationStructure::record(VkCommandBuffer command_buffer, bool refit)
+{
+	std::vector<VkAccelerationStructureInstanceKHR> instance_data(instances.size());
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		auto &instance = instances[i];
+		assert(instance.bottom_level && "Instance has no bottom level acceleration structure");
+
+		glm::mat4 transform = instance.node ? instance.node->get_transform().get_world_matrix() : instance.transform;
+
+		// The instance transform is a row major 3x4 matrix
+		auto &data = instance_data[i];
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				data.transform.matrix[row][column] = transform[column][row];
+			}
+		}
+		data.instanceCustomIndex                    = instance.custom_index;
+		data.mask                                   = instance.mask;
+		data.instanceShaderBindingTableRecordOffset = instance.shader_binding_table_offset;
+		data.flags                                  = instance.flags;
+		data.accelerationStructureReference         = instance.bottom_level->get_device_address();
+	}
+	instance_buffer->update(reinterpret_cast<const uint8_t *>(instance_data.data()), instance_data.size() * sizeof(VkAccelerationStructureInstanceKHR));
+
+	if (refit)
+	{
+		// The previous traces have to finish before the structure is modified
+		vkCmdPipelineBarrier(command_buffer, trace_stages, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+		                     0, 0, nullptr, 0, nullptr, 0, nullptr);
+	}
+
+	VkAccelerationStructureGeometryKHR geometry{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR};
+	geometry.flags                                 = VK_GEOMETRY_OPAQUE_BIT_KHR;
+	geometry.geometryType                          = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+	geometry.geometry.instances.sType              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
+	geometry.geometry.instances.arrayOfPointers    = VK_FALSE;
+	geometry.geometry.instances.data.deviceAddress = get_buffer_device_address(device, instance_buffer->get_handle());
+
+	const VkAccelerationStructureGeometryKHR *geometries = &geometry;
+
+	VkAccelerationStructureBuildGeometryInfoKHR build_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR};
+	build_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
+	build_info.flags                     = flags;
+	build_info.update                    = refit ? VK_TRUE : VK_FALSE;
+	build_info.srcAccelerationStructure  = refit ? structure->get_handle() : VK_NULL_HANDLE;
+	build_info.dstAccelerationStructure  = structure->get_handle();
+	build_info.geometryArrayOfPointers   = VK_FALSE;
+	build_info.geometryCount             = 1;
+	build_info.ppGeometries              = &geometries;
+	build_info.scratchData.deviceAddress = get_buffer_device_address(device, scratch_buffer->get_handle());
+
+	VkAccelerationStructureBuildOffsetInfoKHR range{};
+	range.primitiveCount = to_u32(instances.size());
+
+	const VkAccelerationStructureBuildOffsetInfoKHR *ranges = &range;
+	vkCmdBuildAccelerationStructureKHR(command_buffer, 1, &build_info, &ranges);
+
+	// Make the structure visible to the traces
+	VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+	barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, trace_stages,
+	                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+AccelerationStructure &TopLevelAccelerationStructure::get_structure()
+{
+	return *structure;
+}
+
+std::vector<TopLevelAccelerationStructure::Instance> &TopLevelAccelerationStructure::get_instances()
+{
+	return instances;
+}
+}        // namespace core
+}        // namespace vkb
@@ -0,0 +1,270 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Node;
+}
+
+namespace core
+{
+/**
+ * @brief A VK_KHR_ray_tracing acceleration structure with its memory allocated through VMA
+ */
+class AccelerationStructure
+{
+  public:
+	/**
+	 * @brief Creates an acceleration structure and binds memory to it
+	 * @param device A valid Vulkan device
+	 * @param info Creation details, a non zero compactedSize creates the destination of a compacting copy
+	 */
+	AccelerationStructure(Device &device, const VkAccelerationStructureCreateInfoKHR &info);
+
+	AccelerationStructure(const AccelerationStructure &) = delete;
+
+	AccelerationStructure(AccelerationStructure &&other);
+
+	~AccelerationStructure();
+
+	AccelerationStructure &operator=(const AccelerationStructure &) = delete;
+
+	AccelerationStructure &operator=(AccelerationStructure &&) = delete;
+
+	VkAccelerationStructureKHR get_handle() const;
+
+	VkAccelerationStructureTypeKHR get_type() const;
+
+	/**
+	 * @return The address used to reference this structure from top level instances
+	 */
+	uint64_t get_device_address() const;
+
+	/**
+	 * @return The size of the memory bound to the structure
+	 */
+	VkDeviceSize get_memory_size() const;
+
+	/**
+	 * @param scratch_type Either VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_KHR or
+	 *                     VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_UPDATE_SCRATCH_KHR
+	 * @return The scratch memory needed to build or update the structure
+	 */
+	VkDeviceSize get_scratch_size(VkAccelerationStructureMemoryRequirementsTypeKHR scratch_type) const;
+
+  private:
+	Device &device;
+
+	VkAccelerationStructureKHR handle{VK_NULL_HANDLE};
+
+	VkAccelerationStructureTypeKHR type{VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR};
+
+	VmaAllocation allocation{VK_NULL_HANDLE};
+
+	VkDeviceSize memory_size{0};
+
+	uint64_t device_address{0};
+};
+
+/**
+ * @brief The geometries of a bottom level acceleration structure
+ */
+struct BottomLevelGeometry
+{
+	std::vector<VkAccelerationStructureCreateGeometryTypeInfoKHR> types;
+
+	std::vector<VkAccelerationStructureGeometryKHR> geometries;
+
+	std::vector<VkAccelerationStructureBuildOffsetInfoKHR> ranges;
+
+	/**
+	 * @brief Adds indexed triangles with R32G32B32_SFLOAT positions
+	 * @param vertex_address Device address of the first vertex
+	 * @param vertex_stride Stride in bytes between vertices
+	 * @param vertex_count Number of vertices
+	 * @param index_address Device address of the first index
+	 * @param index_type Type of the indices
+	 * @param triangle_count Number of triangles
+	 * @param flags Geometry flags, opaque by default
+	 */
+	void add_triangles(uint64_t vertex_address, VkDeviceSize vertex_stride, uint32_t vertex_count,
+	                   uint64_t index_address, VkIndexType index_type, uint32_t triangle_count,
+	                   VkGeometryFlagsKHR flags = VK_GEOMETRY_OPAQUE_BIT_KHR);
+};
+
+/**
+ * @brief Builds bottom level acceleration structures in batches that share one scratch buffer,
+ *        then compacts the structures that allow it
+ *
+ * Each batch is compacted before the next one is built, so at most one batch of uncompacted
+ * structures is alive at any time.
+ */
+class AccelerationStructureBuilder
+{
+  public:
+	/**
+	 * @param device A valid Vulkan device
+	 * @param scratch_budget Scratch memory shared by a batch, a structure needing more is built alone
+	 */
+	AccelerationStructureBuilder(Device &device, VkDeviceSize scratch_budget = 64 * 1024 * 1024);
+
+	/**
+	 * @brief Queues a bottom level structure for the next build
+	 * @param geometry The geometries of the structure, referenced until build returns
+	 * @param flags Build flags, compaction is done when they contain VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR
+	 * @return The index of the structure in the builder
+	 */
+	uint32_t add_bottom_level(BottomLevelGeometry geometry,
+	                          VkBuildAccelerationStructureFlagsKHR flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+	                                                                       VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR);
+
+	/**
+	 * @brief Builds and compacts all queued structures, waiting for the queue to finish each batch
+	 * @param queue A queue supporting compute operations
+	 */
+	void build(VkQueue queue);
+
+	AccelerationStructure &get_bottom_level(uint32_t index);
+
+	/**
+	 * @return The memory of the built structures before compaction
+	 */
+	VkDeviceSize get_uncompacted_size() const;
+
+	/**
+	 * @return The memory of the built structures
+	 */
+	VkDeviceSize get_compacted_size() const;
+
+  private:
+	struct BottomLevel
+	{
+		BottomLevelGeometry geometry;
+
+		VkBuildAccelerationStructureFlagsKHR flags;
+
+		std::unique_ptr<AccelerationStructure> structure;
+
+		VkDeviceSize scratch_size{0};
+	};
+
+	void build_batch(VkQueue queue, size_t first, size_t last, std::unique_ptr<Buffer> &scratch, VkDeviceSize scratch_size);
+
+	void compact_batch(VkQueue queue, size_t first, size_t last);
+
+	Device &device;
+
+	VkDeviceSize scratch_budget;
+
+	std::vector<BottomLevel> bottom_levels;
+
+	size_t built_count{0};
+
+	std::unique_ptr<QueryPool> query_pool;
+
+	uint32_t query_count{0};
+
+	VkDeviceSize uncompacted_size{0};
+};
+
+/**
+ * @brief Top level acceleration structure over a fixed set of instances, which can follow scene graph nodes
+ *
+ * Updates refit the structure in place instead of rebuilding it, which is much cheaper for animated
+ * instances as long as they don't move too far from where they were built.
+ */
+class TopLevelAccelerationStructure
+{
+  public:
+	struct Instance
+	{
+		const AccelerationStructure *bottom_level{nullptr};
+
+		/// Node whose world matrix is used as the instance transform, if set
+		sg::Node *node{nullptr};
+
+		/// Transform used when there is no node
+		glm::mat4 transform{1.0f};
+
+		uint32_t custom_index{0};
+
+		uint32_t mask{0xFF};
+
+		uint32_t shader_binding_table_offset{0};
+
+		VkGeometryInstanceFlagsKHR flags{0};
+	};
+
+	/**
+	 * @param device A valid Vulkan device
+	 * @param instances The instances of the structure, the count can't change afterwards
+	 * @param allow_update Whether the structure can be refit with update
+	 * @param trace_stages Pipeline stages tracing rays against the structure, such as the fragment shader for ray queries
+	 */
+	TopLevelAccelerationStructure(Device &device, std::vector<Instance> instances, bool allow_update = true,
+	                              VkPipelineStageFlags trace_stages = VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+
+	/**
+	 * @brief Records a full build of the structure
+	 */
+	void build(VkCommandBuffer command_buffer);
+
+	/**
+	 * @brief Records a refit of the structure with the current node transforms, or a build if it was never built
+	 *        The instances are written by the host, so the previous build or update must have finished.
+	 */
+	void update(VkCommandBuffer command_buffer);
+
+	AccelerationStructure &get_structure();
+
+	std::vector<Instance> &get_instances();
+
+  private:
+	void record(VkCommandBuffer command_buffer, bool refit);
+
+	Device &device;
+
+	std::vector<Instance> instances;
+
+	VkBuildAccelerationStructureFlagsKHR flags;
+
+	VkPipelineStageFlags trace_stages;
+
+	std::unique_ptr<AccelerationStructure> structure;
+
+	std::unique_ptr<Buffer> instance_buffer;
+
+	std::unique_ptr<Buffer> scratch_buffer;
+
+	bool built{false};
+};
+}        // namespace core
+}        // namespace vkb
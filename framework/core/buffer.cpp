@@ -17,6 +17,7 @@
 
 #include "buffer.h"
 
+#include "common/memory_copy.h"
 #include "device.h"
 
 namespace vkb
@@ -25,18 +26,29 @@ namespace core
 {
 Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags) :
     device{device},
-    size{size}
+    size{size},
+    usage{buffer_usage}
 {
+	// Mapping once avoids a map and unmap driver call on every update
+	if (memory_usage == VMA_MEMORY_USAGE_CPU_ONLY || memory_usage == VMA_MEMORY_USAGE_CPU_TO_GPU || memory_usage == VMA_MEMORY_USAGE_GPU_TO_CPU)
+	{
+		flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	}
+
 #ifdef VK_USE_PLATFORM_MACOS_MVK
 	// Workaround for Mac (MoltenVK requires unmapping https://github.com/KhronosGroup/MoltenVK/issues/175)
 	// Force cleares the flag VMA_ALLOCATION_CREATE_MAPPED_BIT
 	flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
 #endif
 
-	persistent = (flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
+	// Descriptors in descriptor buffers refer to the buffers by their device address
+	if (device.uses_descriptor_buffers() && (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)))
+	{
+		usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+	}
 
 	VkBufferCreateInfo buffer_info{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-	buffer_info.usage = buffer_usage;
+	buffer_info.usage = usage;
 	buffer_info.size  = size;
 
 	VmaAllocationCreateInfo memory_info{};
@@ -56,10 +68,45 @@ Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usag
 
 	memory = allocation_info.deviceMemory;
 
+	// VMA ignores the mapped flag for memory which is not host visible
+	persistent = allocation_info.pMappedData != nullptr;
+
+	VkMemoryPropertyFlags memory_flags{0};
+	vmaGetMemoryTypeProperties(device.get_memory_allocator(), allocation_info.memoryType, &memory_flags);
+
+	if (memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		coherent       = (memory_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		write_combined = (memory_flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) == 0;
+	}
+
+	if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+	{
+		VkBufferDeviceAddressInfoKHR address_info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR};
+		address_info.buffer = handle;
+
+		device_address = vkGetBufferDeviceAddressKHR(device.get_handle(), &address_info);
+	}
+
+	if (flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT)
+	{
+		device.set_memory_priority(allocation, device.get_allocation_policy().buffer_priority);
+	}
+
 	if (persistent)
 	{
 		mapped_data = static_cast<uint8_t *>(allocation_info.pMappedData);
 	}
+
+	// Shaders may hold on to the device address of a buffer, which would change when moved
+	movable = memory_usage == VMA_MEMORY_USAGE_GPU_ONLY &&
+	          (flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) == 0 &&
+	          (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) == 0;
+
+	if (movable)
+	{
+		device.get_memory_defragmenter().add_buffer(*this);
+	}
 }
 
 Buffer::Buffer(Buffer &&other) :
@@ -68,8 +115,17 @@ Buffer::Buffer(Buffer &&other) :
     allocation{other.allocation},
     memory{other.memory},
     size{other.size},
+    usage{other.usage},
+    device_address{other.device_address},
     mapped_data{other.mapped_data},
-    mapped{other.mapped}
+    persistent{other.persistent},
+    coherent{other.coherent},
+    write_combined{other.write_combined},
+    mapped{other.mapped},
+    movable{other.movable},
+    creation_time{other.creation_time},
+    last_use_frame{other.last_use_frame.load(std::memory_order_relaxed)},
+    access{other.access}
 {
 	// Reset other handles to avoid releasing on destruction
 	other.handle      = VK_NULL_HANDLE;
@@ -77,10 +133,34 @@ Buffer::Buffer(Buffer &&other) :
 	other.memory      = VK_NULL_HANDLE;
 	other.mapped_data = nullptr;
 	other.mapped      = false;
+	other.movable     = false;
+
+	// The deferred flush refers to the moved from buffer, this buffer takes it over
+	VkDeviceSize pending_offset{0};
+	VkDeviceSize pending_size{0};
+	if (!coherent && device.take_deferred_flush(other, pending_offset, pending_size))
+	{
+		device.defer_flush(*this, pending_offset, pending_size);
+	}
+
+	if (movable)
+	{
+		device.get_memory_defragmenter().add_buffer(*this);
+	}
 }
 
 Buffer::~Buffer()
 {
+	if (movable)
+	{
+		device.get_memory_defragmenter().remove_buffer(*this);
+	}
+
+	if (!coherent)
+	{
+		device.cancel_deferred_flush(*this);
+	}
+
 	if (handle != VK_NULL_HANDLE && allocation != VK_NULL_HANDLE)
 	{
 		unmap();
@@ -113,11 +193,69 @@ VkDeviceMemory Buffer::get_memory() const
 	return memory;
 }
 
+VkDeviceAddress Buffer::get_device_address() const
+{
+	return device_address;
+}
+
+VkBuffer Buffer::rebind()
+{
+	VkBufferCreateInfo buffer_info{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+	buffer_info.usage = usage;
+	buffer_info.size  = size;
+
+	auto old_handle = handle;
+
+	VK_CHECK(vkCreateBuffer(device.get_handle(), &buffer_info, nullptr, &handle));
+	VK_CHECK(vmaBindBufferMemory(device.get_memory_allocator(), allocation, handle));
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), allocation, &allocation_info);
+
+	memory = allocation_info.deviceMemory;
+
+	if (persistent)
+	{
+		mapped_data = static_cast<uint8_t *>(allocation_info.pMappedData);
+	}
+
+	return old_handle;
+}
+
 VkDeviceSize Buffer::get_size() const
 {
 	return size;
 }
 
+uint64_t Buffer::get_creation_time() const
+{
+	return creation_time;
+}
+
+void Buffer::mark_used(uint64_t frame) const
+{
+	// Only store when it changes, to keep the cache line shared between the recording threads
+	if (last_use_frame.load(std::memory_order_relaxed) != frame)
+	{
+		last_use_frame.store(frame, std::memory_order_relaxed);
+	}
+}
+
+uint64_t Buffer::get_last_use_frame() const
+{
+	return last_use_frame.load(std::memory_order_relaxed);
+}
+
+const ResourceAccess &Buffer::get_access() const
+{
+	return access;
+}
+
+void Buffer::set_access(const ResourceAccess &access_) const
+{
+	access = access_;
+}
+
 uint8_t *Buffer::map()
 {
 	if (!mapped && !mapped_data)
@@ -143,6 +281,28 @@ void Buffer::flush() const
 	vmaFlushAllocation(device.get_memory_allocator(), allocation, 0, size);
 }
 
+void Buffer::mark_written(VkDeviceSize offset, VkDeviceSize size)
+{
+	if (coherent)
+	{
+		return;
+	}
+
+	if (persistent && device.is_deferring_flushes())
+	{
+		device.defer_flush(*this, offset, size);
+	}
+	else
+	{
+		vmaFlushAllocation(device.get_memory_allocator(), allocation, offset, size);
+	}
+}
+
+void Buffer::invalidate() const
+{
+	vmaInvalidateAllocation(device.get_memory_allocator(), allocation, 0, size);
+}
+
 void Buffer::update(const std::vector<uint8_t> &data, size_t offset)
 {
 	update(data.data(), data.size(), offset);
@@ -155,16 +315,21 @@ void Buffer::update(void *data, size_t size, size_t offset)
 
 void Buffer::update(const uint8_t *data, const size_t size, const size_t offset)
 {
-	if (persistent)
+	uint8_t *dst = (persistent ? mapped_data : map()) + offset;
+
+	if (write_combined)
 	{
-		std::copy(data, data + size, mapped_data + offset);
-		flush();
+		copy_to_write_combined(dst, data, size);
 	}
 	else
 	{
-		map();
-		std::copy(data, data + size, mapped_data + offset);
-		flush();
+		std::copy(data, data + size, dst);
+	}
+
+	mark_written(offset, size);
+
+	if (!persistent)
+	{
 		unmap();
 	}
 }
@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
@@ -31,6 +34,7 @@ class Buffer
   public:
 	/**
 	 * @brief Creates a buffer using VMA
+	 *        Buffers in host visible memory usages are always persistently mapped, except with MoltenVK.
 	 * @param device A valid Vulkan device
 	 * @param size The size in bytes of the buffer
 	 * @param buffer_usage The usage flags for the VkBuffer
@@ -63,11 +67,36 @@ class Buffer
 
 	VkDeviceMemory get_memory() const;
 
+	/**
+	 * @return The device address of the buffer, zero unless created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+	 *         Uniform and storage buffers get that usage when the device uses descriptor buffers.
+	 */
+	VkDeviceAddress get_device_address() const;
+
+	/**
+	 * @brief Creates a new handle bound to the allocation, after MemoryDefragmenter moved it
+	 * @return The previous handle, to be destroyed by the caller once it is no longer used
+	 */
+	VkBuffer rebind();
+
 	/**
 	 * @brief Flushes memory if it is HOST_VISIBLE and not HOST_COHERENT
 	 */
 	void flush() const;
 
+	/**
+	 * @brief Makes the host writes to a range visible to the device, if the memory is not HOST_COHERENT
+	 *        The flush is deferred to the next queue submission when the device batches them, see Device::set_deferred_flushes().
+	 * @param offset The offset of the range written
+	 * @param size The size of the range written
+	 */
+	void mark_written(VkDeviceSize offset, VkDeviceSize size);
+
+	/**
+	 * @brief Invalidates memory if it is HOST_VISIBLE and not HOST_COHERENT, so device writes are visible to the host
+	 */
+	void invalidate() const;
+
 	/**
 	 * @brief Maps vulkan memory if it isn't already mapped to an host visible address
 	 * @return Pointer to host visible memory
@@ -84,6 +113,32 @@ class Buffer
 	 */
 	VkDeviceSize get_size() const;
 
+	/**
+	 * @return The time it was created at, on the clock of CpuProfiler::now()
+	 */
+	uint64_t get_creation_time() const;
+
+	/**
+	 * @brief Records that a command buffer used it
+	 * @param frame The current frame, see ResourceCache::get_frame_index()
+	 */
+	void mark_used(uint64_t frame) const;
+
+	/**
+	 * @return The last frame a command buffer used it in
+	 */
+	uint64_t get_last_use_frame() const;
+
+	/**
+	 * @return The last access recorded to the buffer, see CommandBuffer::transition()
+	 */
+	const ResourceAccess &get_access() const;
+
+	/**
+	 * @brief Records the access of the buffer, for the commands which change it without CommandBuffer::transition()
+	 */
+	void set_access(const ResourceAccess &access) const;
+
 	const uint8_t *get_data() const
 	{
 		return mapped_data;
@@ -134,13 +189,34 @@ class Buffer
 
 	VkDeviceSize size{0};
 
+	VkBufferUsageFlags usage{0};
+
+	VkDeviceAddress device_address{0};
+
 	uint8_t *mapped_data{nullptr};
 
 	/// Whether the buffer is persistently mapped or not
 	bool persistent{false};
 
+	/// Whether the memory is HOST_COHERENT, or not host visible at all, so writes need no flush
+	bool coherent{true};
+
+	/// Whether the memory is HOST_VISIBLE but not HOST_CACHED, so writes should not read the cache lines back
+	bool write_combined{false};
+
 	/// Whether the buffer has been mapped with vmaMapMemory
 	bool mapped{false};
+
+	/// Whether the buffer is tracked by the memory defragmenter of the device
+	bool movable{false};
+
+	uint64_t creation_time{CpuProfiler::now()};
+
+	/// Written by the threads recording command buffers
+	mutable std::atomic<uint64_t> last_use_frame{0};
+
+	/// Last access of the whole buffer, in recording order
+	mutable ResourceAccess access;
 };
 }        // namespace core
 }        // namespace vkb
@@ -0,0 +1,314 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "capability_cache.h"
+
+#include <cstring>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+/// Identifies a capability snapshot ("VKBC")
+constexpr uint32_t CAPABILITY_CACHE_MAGIC = 0x43424B56;
+
+/// Must be bumped whenever the layout of the snapshot changes
+constexpr uint32_t CAPABILITY_CACHE_VERSION = 1;
+
+/// Sections of the snapshot present in the data
+enum CapabilityCacheSection : uint32_t
+{
+	CAPABILITY_CACHE_FEATURES       = 1 << 0,
+	CAPABILITY_CACHE_QUEUE_FAMILIES = 1 << 1,
+	CAPABILITY_CACHE_EXTENSIONS     = 1 << 2,
+};
+
+struct CapabilityCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint32_t vendor_id;
+
+	uint32_t device_id;
+
+	uint32_t driver_version;
+
+	uint32_t api_version;
+
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+
+	uint32_t sections;
+
+	uint32_t queue_family_count;
+
+	uint32_t extension_count;
+
+	uint32_t format_count;
+};
+
+struct FormatPropertiesRecord
+{
+	VkFormat format;
+
+	VkFormatProperties properties;
+};
+
+template <class T>
+inline void append(std::vector<uint8_t> &data, const T *values, size_t count = 1)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(values);
+	data.insert(data.end(), bytes, bytes + count * sizeof(T));
+}
+
+template <class T>
+inline bool read(const std::vector<uint8_t> &data, size_t &offset, T *values, size_t count = 1)
+{
+	size_t size = count * sizeof(T);
+
+	if (offset > data.size() || size > data.size() - offset)
+	{
+		return false;
+	}
+
+	std::memcpy(values, data.data() + offset, size);
+	offset += size;
+
+	return true;
+}
+}        // namespace
+
+CapabilityCache::CapabilityCache(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties &properties) :
+    handle{physical_device},
+    properties{properties},
+    filename{fmt::format("capabilities_{:08x}_{:08x}.cache", properties.vendorID, properties.deviceID)}
+{
+	if (!fs::is_file(fs::path::get(fs::path::Type::Temp) + filename))
+	{
+		return;
+	}
+
+	try
+	{
+		loaded = decode(fs::read_temp(filename));
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to read capability cache file {}: {}", filename, e.what());
+	}
+
+	if (!loaded)
+	{
+		LOGI("Capability cache of {} was written by a different driver, discarding it", properties.deviceName);
+	}
+}
+
+CapabilityCache::~CapabilityCache()
+{
+	save();
+}
+
+bool CapabilityCache::is_loaded() const
+{
+	return loaded;
+}
+
+const VkPhysicalDeviceFeatures &CapabilityCache::get_features()
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	if (!has_features)
+	{
+		vkGetPhysicalDeviceFeatures(handle, &features);
+
+		has_features = true;
+		dirty        = true;
+	}
+
+	return features;
+}
+
+const std::vector<VkQueueFamilyProperties> &CapabilityCache::get_queue_family_properties()
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	if (!has_queue_family_properties)
+	{
+		uint32_t queue_family_properties_count = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(handle, &queue_family_properties_count, nullptr);
+		queue_family_properties = std::vector<VkQueueFamilyProperties>(queue_family_properties_count);
+		vkGetPhysicalDeviceQueueFamilyProperties(handle, &queue_family_properties_count, queue_family_properties.data());
+
+		has_queue_family_properties = true;
+		dirty                       = true;
+	}
+
+	return queue_family_properties;
+}
+
+const std::vector<VkExtensionProperties> &CapabilityCache::get_extension_properties()
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	if (!has_extension_properties)
+	{
+		uint32_t extension_count;
+		VK_CHECK(vkEnumerateDeviceExtensionProperties(handle, nullptr, &extension_count, nullptr));
+		extension_properties = std::vector<VkExtensionProperties>(extension_count);
+		VK_CHECK(vkEnumerateDeviceExtensionProperties(handle, nullptr, &extension_count, extension_properties.data()));
+
+		has_extension_properties = true;
+		dirty                    = true;
+	}
+
+	return extension_properties;
+}
+
+VkFormatProperties CapabilityCache::get_format_properties(VkFormat format)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	auto it = format_properties.find(format);
+
+	if (it == format_properties.end())
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(handle, format, &properties);
+
+		it    = format_properties.emplace(format, properties).first;
+		dirty = true;
+	}
+
+	return it->second;
+}
+
+void CapabilityCache::save()
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	if (!dirty)
+	{
+		return;
+	}
+
+	try
+	{
+		fs::write_temp(encode(), filename);
+
+		dirty = false;
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to store capability cache file {}: {}", filename, e.what());
+	}
+}
+
+std::vector<uint8_t> CapabilityCache::encode() const
+{
+	std::vector<uint8_t> data;
+
+	CapabilityCacheHeader header{};
+	header.magic          = CAPABILITY_CACHE_MAGIC;
+	header.version        = CAPABILITY_CACHE_VERSION;
+	header.vendor_id      = properties.vendorID;
+	header.device_id      = properties.deviceID;
+	header.driver_version = properties.driverVersion;
+	header.api_version    = properties.apiVersion;
+	std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	header.sections = (has_features ? CAPABILITY_CACHE_FEATURES : 0) |
+	                  (has_queue_family_properties ? CAPABILITY_CACHE_QUEUE_FAMILIES : 0) |
+	                  (has_extension_properties ? CAPABILITY_CACHE_EXTENSIONS : 0);
+
+	header.queue_family_count = to_u32(queue_family_properties.size());
+	header.extension_count    = to_u32(extension_properties.size());
+	header.format_count       = to_u32(format_properties.size());
+
+	append(data, &header);
+
+	if (has_features)
+	{
+		append(data, &features);
+	}
+
+	append(data, queue_family_properties.data(), queue_family_properties.size());
+
+	append(data, extension_properties.data(), extension_properties.size());
+
+	for (auto &it : format_properties)
+	{
+		FormatPropertiesRecord record{it.first, it.second};
+		append(data, &record);
+	}
+
+	return data;
+}
+
+bool CapabilityCache::decode(const std::vector<uint8_t> &data)
+{
+	size_t offset{0};
+
+	CapabilityCacheHeader header{};
+	if (!read(data, offset, &header) ||
+	    header.magic != CAPABILITY_CACHE_MAGIC ||
+	    header.version != CAPABILITY_CACHE_VERSION ||
+	    header.vendor_id != properties.vendorID ||
+	    header.device_id != properties.deviceID ||
+	    header.driver_version != properties.driverVersion ||
+	    header.api_version != properties.apiVersion ||
+	    std::memcmp(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceFeatures             cached_features{};
+	std::vector<VkQueueFamilyProperties> cached_queue_family_properties(header.queue_family_count);
+	std::vector<VkExtensionProperties>   cached_extension_properties(header.extension_count);
+	std::vector<FormatPropertiesRecord>  records(header.format_count);
+
+	if ((header.sections & CAPABILITY_CACHE_FEATURES && !read(data, offset, &cached_features)) ||
+	    !read(data, offset, cached_queue_family_properties.data(), cached_queue_family_properties.size()) ||
+	    !read(data, offset, cached_extension_properties.data(), cached_extension_properties.size()) ||
+	    !read(data, offset, records.data(), records.size()) ||
+	    offset != data.size())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(mutex);
+
+	has_features = (header.sections & CAPABILITY_CACHE_FEATURES) != 0;
+	features     = cached_features;
+
+	has_queue_family_properties = (header.sections & CAPABILITY_CACHE_QUEUE_FAMILIES) != 0;
+	queue_family_properties     = std::move(cached_queue_family_properties);
+
+	has_extension_properties = (header.sections & CAPABILITY_CACHE_EXTENSIONS) != 0;
+	extension_properties     = std::move(cached_extension_properties);
+
+	for (auto &record : records)
+	{
+		format_properties[record.format] = record.properties;
+	}
+
+	return true;
+}
+}        // namespace vkb
@@ -0,0 +1,114 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+/**
+ * @brief Snapshot of the capabilities of a physical device persisted across runs
+ *        The snapshot is loaded from a temporary file when created, and is only used if it was
+ *        written for the same device and driver version. Capabilities missing from it are queried
+ *        on first use and added to it, so later runs skip their queries. The snapshot is written
+ *        back when destroyed if it changed.
+ */
+class CapabilityCache
+{
+  public:
+	/**
+	 * @brief Loads the snapshot of a physical device written by a previous run, if any
+	 * @param physical_device The physical device to query on a miss
+	 * @param properties The properties of the physical device, identifying the snapshot
+	 */
+	CapabilityCache(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties &properties);
+
+	CapabilityCache(const CapabilityCache &) = delete;
+
+	CapabilityCache(CapabilityCache &&) = delete;
+
+	~CapabilityCache();
+
+	CapabilityCache &operator=(const CapabilityCache &) = delete;
+
+	CapabilityCache &operator=(CapabilityCache &&) = delete;
+
+	/**
+	 * @return True if a valid snapshot was written by a previous run
+	 */
+	bool is_loaded() const;
+
+	const VkPhysicalDeviceFeatures &get_features();
+
+	const std::vector<VkQueueFamilyProperties> &get_queue_family_properties();
+
+	const std::vector<VkExtensionProperties> &get_extension_properties();
+
+	/**
+	 * @brief Can be called from any thread
+	 */
+	VkFormatProperties get_format_properties(VkFormat format);
+
+	/**
+	 * @brief Writes the snapshot to the temporary file if it changed since it was loaded
+	 */
+	void save();
+
+	/**
+	 * @brief Serializes the snapshot
+	 */
+	std::vector<uint8_t> encode() const;
+
+	/**
+	 * @brief Deserializes a snapshot
+	 * @return False if the data is truncated or was written for another device or driver
+	 */
+	bool decode(const std::vector<uint8_t> &data);
+
+  private:
+	VkPhysicalDevice handle{VK_NULL_HANDLE};
+
+	VkPhysicalDeviceProperties properties;
+
+	std::string filename;
+
+	std::mutex mutex;
+
+	bool loaded{false};
+
+	bool dirty{false};
+
+	bool has_features{false};
+
+	VkPhysicalDeviceFeatures features{};
+
+	bool has_queue_family_properties{false};
+
+	std::vector<VkQueueFamilyProperties> queue_family_properties;
+
+	bool has_extension_properties{false};
+
+	std::vector<VkExtensionProperties> extension_properties;
+
+	std::map<VkFormat, VkFormatProperties> format_properties;
+};
+}        // namespace vkb
@@ -18,30 +18,233 @@
 #include "command_buffer.h"
 
 #include "command_pool.h"
+#include "common/debug_utils.h"
 #include "common/error.h"
 #include "device.h"
 #include "rendering/render_frame.h"
 #include "rendering/subpass.h"
+#include "stats/cpu_profiler.h"
+#include "stats/gpu_profiler.h"
 
 namespace vkb
 {
-CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level) :
-    command_pool{command_pool},
-    max_push_constants_size{command_pool.get_device().get_gpu().get_properties().limits.maxPushConstantsSize},
-    level{level}
+namespace
+{
+bool is_same(const VkViewport &lhs, const VkViewport &rhs)
+{
+	return lhs.x == rhs.x && lhs.y == rhs.y && lhs.width == rhs.width && lhs.height == rhs.height &&
+	       lhs.minDepth == rhs.minDepth && lhs.maxDepth == rhs.maxDepth;
+}
+
+bool is_same(const VkRect2D &lhs, const VkRect2D &rhs)
+{
+	return lhs.offset.x == rhs.offset.x && lhs.offset.y == rhs.offset.y &&
+	       lhs.extent.width == rhs.extent.width && lhs.extent.height == rhs.extent.height;
+}
+
+/**
+ * @brief Stores the values set from first onwards in the bound values
+ * @return False if the bound values were already the same
+ */
+template <class T>
+bool update_bound_range(std::vector<T> &bound, uint32_t first, const std::vector<T> &values)
+{
+	if (first + values.size() <= bound.size() && std::equal(values.begin(), values.end(), bound.begin() + first, [](const T &lhs, const T &rhs) { return is_same(lhs, rhs); }))
+	{
+		return false;
+	}
+
+	// Only track contiguous values from the first index, so that every tracked value was set
+	if (first <= bound.size())
+	{
+		bound.resize(std::max(bound.size(), first + values.size()));
+		std::copy(values.begin(), values.end(), bound.begin() + first);
+	}
+
+	return true;
+}
+
+/**
+ * @return The layout an image view is read with by a descriptor, or VK_IMAGE_LAYOUT_UNDEFINED if the type is not supported
+ */
+VkImageLayout find_descriptor_image_layout(VkDescriptorType descriptor_type, const core::ImageView &image_view)
+{
+	switch (descriptor_type)
+	{
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			if (is_depth_stencil_format(image_view.get_format()))
+			{
+				return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			}
+			return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			return VK_IMAGE_LAYOUT_GENERAL;
+		default:
+			return VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+}
+
+VkImageSubresourceRange get_barrier_subresource_range(const core::ImageView &image_view)
+{
+	// Adjust barrier's subresource range for depth images
+	auto subresource_range = image_view.get_subresource_range();
+	auto format            = image_view.get_format();
+	if (is_depth_only_format(format))
+	{
+		subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	}
+	else if (is_depth_stencil_format(format))
+	{
+		subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	}
+
+	return subresource_range;
+}
+
+VkImageMemoryBarrier get_image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
+{
+	auto subresource_range = get_barrier_subresource_range(image_view);
+
+	VkImageMemoryBarrier image_memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	image_memory_barrier.oldLayout           = memory_barrier.old_layout;
+	image_memory_barrier.newLayout           = memory_barrier.new_layout;
+	image_memory_barrier.image               = image_view.get_image().get_handle();
+	image_memory_barrier.subresourceRange    = subresource_range;
+	image_memory_barrier.srcAccessMask       = memory_barrier.src_access_mask;
+	image_memory_barrier.dstAccessMask       = memory_barrier.dst_access_mask;
+	image_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	image_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
+
+	return image_memory_barrier;
+}
+
+bool is_same_access(const ResourceAccess &lhs, const ResourceAccess &rhs)
+{
+	return lhs.stage_mask == rhs.stage_mask && lhs.access_mask == rhs.access_mask && lhs.layout == rhs.layout && lhs.queue_family == rhs.queue_family;
+}
+
+/**
+ * @brief Whether the next access has to wait for the previous one, which is only skipped when both read
+ *        with the same layout and queue family, from stages the previous access already made them visible to
+ * @param[out] tracked The access to record for the resource
+ */
+bool needs_barrier(const ResourceAccess &previous, const ResourceAccess &next, ResourceAccess &tracked)
+{
+	bool reads = !is_write_access(previous.access_mask) && !is_write_access(next.access_mask) &&
+	             previous.layout == next.layout && previous.queue_family == next.queue_family;
+
+	if (reads && (next.stage_mask & ~previous.stage_mask) == 0 && (next.access_mask & ~previous.access_mask) == 0)
+	{
+		tracked = previous;
+		return false;
+	}
+
+	tracked = next;
+
+	if (reads)
+	{
+		// Later writes have to wait for all the readers
+		tracked.stage_mask  |= previous.stage_mask;
+		tracked.access_mask |= previous.access_mask;
+	}
+
+	return true;
+}
+
+bool is_queue_family_transfer(const ResourceAccess &previous, const ResourceAccess &next)
+{
+	return previous.queue_family != next.queue_family && previous.queue_family != VK_QUEUE_FAMILY_IGNORED && next.queue_family != VK_QUEUE_FAMILY_IGNORED;
+}
+
+VkAccessFlags get_write_access(VkAccessFlags access_mask)
 {
-	VkCommandBufferAllocateInfo allocate_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+	VkAccessFlags write_mask = 0;
 
-	allocate_info.commandPool        = command_pool.get_handle();
-	allocate_info.commandBufferCount = 1;
-	allocate_info.level              = level;
+	// Only writes have to be made available, split the mask bit by bit
+	for (VkAccessFlags bit = 1; bit != 0 && bit <= access_mask; bit <<= 1)
+	{
+		if ((access_mask & bit) && is_write_access(bit))
+		{
+			write_mask |= bit;
+		}
+	}
+
+	return write_mask;
+}
+
+#ifdef VK_KHR_synchronization2
+/**
+ * @brief The barriers of a VkDependencyInfoKHR, which keeps the stages of each barrier
+ */
+template <typename T_BufferBarrier, typename T_ImageBarrier>
+struct Dependency2
+{
+	Dependency2(const std::vector<T_BufferBarrier> &buffer_barriers, const std::vector<T_ImageBarrier> &image_barriers)
+	{
+		for (auto &buffer_barrier : buffer_barriers)
+		{
+			VkBufferMemoryBarrier2KHR barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR};
+			barrier.srcStageMask        = buffer_barrier.src_stage_mask;
+			barrier.srcAccessMask       = buffer_barrier.barrier.srcAccessMask;
+			barrier.dstStageMask        = buffer_barrier.dst_stage_mask;
+			barrier.dstAccessMask       = buffer_barrier.barrier.dstAccessMask;
+			barrier.srcQueueFamilyIndex = buffer_barrier.barrier.srcQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = buffer_barrier.barrier.dstQueueFamilyIndex;
+			barrier.buffer              = buffer_barrier.barrier.buffer;
+			barrier.offset              = buffer_barrier.barrier.offset;
+			barrier.size                = buffer_barrier.barrier.size;
+
+			this->buffer_barriers.push_back(barrier);
+		}
 
-	VkResult result = vkAllocateCommandBuffers(command_pool.get_device().get_handle(), &allocate_info, &handle);
+		for (auto &image_barrier : image_barriers)
+		{
+			VkImageMemoryBarrier2KHR barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR};
+			barrier.srcStageMask        = image_barrier.src_stage_mask;
+			barrier.srcAccessMask       = image_barrier.barrier.srcAccessMask;
+			barrier.dstStageMask        = image_barrier.dst_stage_mask;
+			barrier.dstAccessMask       = image_barrier.barrier.dstAccessMask;
+			barrier.oldLayout           = image_barrier.barrier.oldLayout;
+			barrier.newLayout           = image_barrier.barrier.newLayout;
+			barrier.srcQueueFamilyIndex = image_barrier.barrier.srcQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = image_barrier.barrier.dstQueueFamilyIndex;
+			barrier.image               = image_barrier.barrier.image;
+			barrier.subresourceRange    = image_barrier.barrier.subresourceRange;
+
+			this->image_barriers.push_back(barrier);
+		}
+	}
 
-	if (result != VK_SUCCESS)
+	/**
+	 * @return The dependency info, pointing to the barriers of this object
+	 */
+	VkDependencyInfoKHR get_info() const
 	{
-		throw VulkanException{result, "Failed to allocate command buffer"};
+		VkDependencyInfoKHR dependency_info{VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR};
+		dependency_info.bufferMemoryBarrierCount = to_u32(buffer_barriers.size());
+		dependency_info.pBufferMemoryBarriers    = buffer_barriers.data();
+		dependency_info.imageMemoryBarrierCount  = to_u32(image_barriers.size());
+		dependency_info.pImageMemoryBarriers     = image_barriers.data();
+
+		return dependency_info;
 	}
+
+	std::vector<VkBufferMemoryBarrier2KHR> buffer_barriers;
+
+	std::vector<VkImageMemoryBarrier2KHR> image_barriers;
+};
+#endif
+}        // namespace
+
+CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level, VkCommandBuffer handle) :
+    level{level},
+    command_pool{command_pool},
+    table{command_pool.get_device().get_table()},
+    handle{handle},
+    max_push_constants_size{command_pool.get_device().get_gpu().get_properties().limits.maxPushConstantsSize}
+{
 }
 
 CommandBuffer::~CommandBuffer()
@@ -49,12 +252,13 @@ CommandBuffer::~CommandBuffer()
 	// Destroy command buffer
 	if (handle != VK_NULL_HANDLE)
 	{
-		vkFreeCommandBuffers(command_pool.get_device().get_handle(), command_pool.get_handle(), 1, &handle);
+		table.vkFreeCommandBuffers(command_pool.get_device().get_handle(), command_pool.get_handle(), 1, &handle);
 	}
 }
 
 CommandBuffer::CommandBuffer(CommandBuffer &&other) :
     command_pool{other.command_pool},
+    table{other.table},
     level{other.level},
     handle{other.handle},
     state{other.state},
@@ -81,7 +285,7 @@ bool CommandBuffer::is_recording() const
 
 void CommandBuffer::clear(VkClearAttachment attachment, VkClearRect rect)
 {
-	vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
+	table.vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
 }
 
 VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf)
@@ -96,31 +300,69 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *pr
 	state = State::Recording;
 
 	// Reset state
+	pending_image_barriers.clear();
+	pending_buffer_barriers.clear();
+	set_synchronization2(true);
 	pipeline_state.reset();
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
+	external_descriptor_sets.clear();
 	stored_push_constants.clear();
+	gpu_profiler         = nullptr;
+	debug_labels         = debug_utils::is_enabled();
+	fallback_pipeline    = nullptr;
+	redundant_call_count = 0;
+	invalidate_bound_state();
 
 	VkCommandBufferBeginInfo       begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 	VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
 	begin_info.flags                           = flags;
 
+#ifdef VK_KHR_dynamic_rendering
+	VkCommandBufferInheritanceRenderingInfoKHR inheritance_rendering{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR};
+#endif
+
 	if (level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
 	{
 		assert(primary_cmd_buf && "A primary command buffer pointer must be provided when calling begin from a secondary one");
 
-		auto render_pass_binding        = primary_cmd_buf->get_current_render_pass();
-		current_render_pass.render_pass = render_pass_binding.render_pass;
-		current_render_pass.framebuffer = render_pass_binding.framebuffer;
-
-		inheritance.renderPass  = current_render_pass.render_pass->get_handle();
-		inheritance.framebuffer = current_render_pass.framebuffer->get_handle();
-		inheritance.subpass     = primary_cmd_buf->get_current_subpass_index();
+		current_render_pass = primary_cmd_buf->get_current_render_pass();
 
 		begin_info.pInheritanceInfo = &inheritance;
+
+		if (current_render_pass.dynamic_rendering)
+		{
+#ifdef VK_KHR_dynamic_rendering
+			// The secondary inherits the formats of the rendering scope instead of a subpass
+			inheritance_rendering.colorAttachmentCount    = to_u32(current_render_pass.color_formats.size());
+			inheritance_rendering.pColorAttachmentFormats = current_render_pass.color_formats.data();
+			inheritance_rendering.depthAttachmentFormat   = current_render_pass.depth_stencil_format;
+			inheritance_rendering.stencilAttachmentFormat = is_depth_only_format(current_render_pass.depth_stencil_format) ? VK_FORMAT_UNDEFINED : current_render_pass.depth_stencil_format;
+			inheritance_rendering.rasterizationSamples    = current_render_pass.samples;
+
+			inheritance.pNext = &inheritance_rendering;
+#endif
+
+			auto blend_state = pipeline_state.get_color_blend_state();
+			blend_state.attachments.resize(current_render_pass.color_formats.size());
+			pipeline_state.set_color_blend_state(blend_state);
+		}
+		else
+		{
+			inheritance.renderPass  = current_render_pass.render_pass->get_handle();
+			inheritance.framebuffer = current_render_pass.framebuffer->get_handle();
+			inheritance.subpass     = primary_cmd_buf->get_current_subpass_index();
+
+			// Pipelines recorded in the secondary are created for the inherited subpass
+			pipeline_state.set_subpass_index(inheritance.subpass);
+
+			auto blend_state = pipeline_state.get_color_blend_state();
+			blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(inheritance.subpass));
+			pipeline_state.set_color_blend_state(blend_state);
+		}
 	}
 
-	return vkBeginCommandBuffer(get_handle(), &begin_info);
+	return table.vkBeginCommandBuffer(get_handle(), &begin_info);
 }
 
 VkResult CommandBuffer::end()
@@ -132,29 +374,39 @@ VkResult CommandBuffer::end()
 		return VK_NOT_READY;
 	}
 
-	vkEndCommandBuffer(get_handle());
+	flush_barriers();
+
+	table.vkEndCommandBuffer(get_handle());
 
 	state = State::Executable;
 
+	if (auto render_frame = command_pool.get_render_frame())
+	{
+		render_frame->add_redundant_call_count(redundant_call_count);
+	}
+
 	return VK_SUCCESS;
 }
 
-void CommandBuffer::flush(VkPipelineBindPoint pipeline_bind_point)
+bool CommandBuffer::flush(VkPipelineBindPoint pipeline_bind_point)
 {
-	flush_pipeline_state(pipeline_bind_point);
+	if (!flush_pipeline_state(pipeline_bind_point))
+	{
+		// Drop the push constants of the skipped draw so they do not accumulate
+		stored_push_constants.clear();
+		return false;
+	}
 
 	flush_push_constants();
 
 	flush_descriptor_state(pipeline_bind_point);
+
+	return true;
 }
 
-void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents)
+void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents,
+                                      const VkExtent2D &render_area)
 {
-	// Reset state
-	pipeline_state.reset();
-	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
-
 	// Create render pass
 	assert(subpasses.size() > 0 && "Cannot create a render pass without any subpass");
 	std::vector<SubpassInfo> subpass_infos(subpasses.size());
@@ -167,17 +419,44 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 		subpass_info_it->disable_depth_stencil_attachment = subpass->get_disable_depth_stencil_attachment();
 		subpass_info_it->depth_stencil_resolve_mode       = subpass->get_depth_stencil_resolve_mode();
 		subpass_info_it->depth_stencil_resolve_attachment = subpass->get_depth_stencil_resolve_attachment();
+		subpass_info_it->shading_rate_attachment          = subpass->get_shading_rate_attachment();
+		subpass_info_it->shading_rate_texel_size          = subpass->get_shading_rate_texel_size();
+		subpass_info_it->view_mask                        = subpass->get_view_mask();
 
 		++subpass_info_it;
 	}
-	current_render_pass.render_pass = &get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), load_store_infos, subpass_infos);
-	current_render_pass.framebuffer = &get_device().get_resource_cache().request_framebuffer(render_target, *current_render_pass.render_pass);
+	auto &render_pass = get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), load_store_infos, subpass_infos);
+	auto &framebuffer = get_device().get_resource_cache().request_framebuffer(render_target, render_pass);
+
+	begin_render_pass(render_target, render_pass, framebuffer, clear_values, contents, render_area);
+}
+
+void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const RenderPass &render_pass, const Framebuffer &framebuffer, const std::vector<VkClearValue> &clear_values, VkSubpassContents contents,
+                                      const VkExtent2D &render_area)
+{
+	// Reset state
+	pipeline_state.reset();
+	resource_binding_state.reset();
+	descriptor_set_layout_binding_state.fill(nullptr);
+	external_descriptor_sets.clear();
+
+	current_render_pass             = {};
+	current_render_pass.render_pass = &render_pass;
+	current_render_pass.framebuffer = &framebuffer;
+
+	auto frame = get_device().get_resource_cache().get_frame_index();
+	for (auto &view : render_target.get_views())
+	{
+		view.get_image().mark_used(frame);
+	}
+
+	flush_barriers();
 
 	// Begin render pass
 	VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
 	begin_info.renderPass        = current_render_pass.render_pass->get_handle();
 	begin_info.framebuffer       = current_render_pass.framebuffer->get_handle();
-	begin_info.renderArea.extent = render_target.get_extent();
+	begin_info.renderArea.extent = render_area.width != 0 && render_area.height != 0 ? render_area : render_target.get_extent();
 	begin_info.clearValueCount   = to_u32(clear_values.size());
 	begin_info.pClearValues      = clear_values.data();
 
@@ -197,7 +476,9 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 		last_render_area_extent = begin_info.renderArea.extent;
 	}
 
-	vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
+	table.vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
+
+	set_attachment_accesses(render_target, render_pass.get_final_layouts());
 
 	// Update blend state attachments for first subpass
 	auto blend_state = pipeline_state.get_color_blend_state();
@@ -205,7 +486,105 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	pipeline_state.set_color_blend_state(blend_state);
 }
 
-void CommandBuffer::next_subpass()
+void CommandBuffer::begin_rendering(const RenderTarget &render_target, const std::vector<uint32_t> &color_attachments, bool depth_stencil_attachment,
+                                    const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, VkSubpassContents contents,
+                                    const VkExtent2D &render_area)
+{
+#ifdef VK_KHR_dynamic_rendering
+	// Reset state
+	pipeline_state.reset();
+	resource_binding_state.reset();
+	descriptor_set_layout_binding_state.fill(nullptr);
+	external_descriptor_sets.clear();
+
+	current_render_pass                   = {};
+	current_render_pass.dynamic_rendering = true;
+
+	auto frame = get_device().get_resource_cache().get_frame_index();
+	for (auto &view : render_target.get_views())
+	{
+		view.get_image().mark_used(frame);
+	}
+
+	flush_barriers();
+
+	auto &attachments = render_target.get_attachments();
+	auto &views       = render_target.get_views();
+
+	std::vector<VkImageLayout> attachment_layouts(views.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+
+	auto get_attachment_info = [&](uint32_t index, VkImageLayout layout) {
+		VkRenderingAttachmentInfoKHR attachment_info{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+		attachment_info.imageView   = views.at(index).get_handle();
+		attachment_info.imageLayout = layout;
+
+		if (index < load_store_infos.size())
+		{
+			attachment_info.loadOp  = load_store_infos[index].load_op;
+			attachment_info.storeOp = load_store_infos[index].store_op;
+		}
+
+		if (index < clear_values.size())
+		{
+			attachment_info.clearValue = clear_values[index];
+		}
+
+		current_render_pass.samples = attachments.at(index).samples;
+
+		attachment_layouts.at(index) = layout;
+
+		return attachment_info;
+	};
+
+	std::vector<VkRenderingAttachmentInfoKHR> color_attachment_infos;
+
+	for (auto index : color_attachments)
+	{
+		color_attachment_infos.push_back(get_attachment_info(index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+		current_render_pass.color_formats.push_back(attachments.at(index).format);
+	}
+
+	VkRenderingAttachmentInfoKHR depth_stencil_attachment_info{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+
+	if (depth_stencil_attachment)
+	{
+		// The first depth attachment, as in the render passes of the subpasses
+		auto attachment_it = std::find_if(attachments.begin(), attachments.end(), [](const Attachment &attachment) { return is_depth_stencil_format(attachment.format); });
+
+		if (attachment_it != attachments.end())
+		{
+			auto index = to_u32(std::distance(attachments.begin(), attachment_it));
+
+			depth_stencil_attachment_info = get_attachment_info(index, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+			current_render_pass.depth_stencil_format = attachment_it->format;
+		}
+	}
+
+	auto depth_stencil_format = current_render_pass.depth_stencil_format;
+
+	VkRenderingInfoKHR rendering_info{VK_STRUCTURE_TYPE_RENDERING_INFO_KHR};
+	rendering_info.flags                = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+	rendering_info.renderArea.extent    = render_area.width != 0 && render_area.height != 0 ? render_area : render_target.get_extent();
+	rendering_info.layerCount           = 1;
+	rendering_info.colorAttachmentCount = to_u32(color_attachment_infos.size());
+	rendering_info.pColorAttachments    = color_attachment_infos.data();
+	rendering_info.pDepthAttachment     = depth_stencil_format != VK_FORMAT_UNDEFINED ? &depth_stencil_attachment_info : nullptr;
+	rendering_info.pStencilAttachment   = depth_stencil_format != VK_FORMAT_UNDEFINED && !is_depth_only_format(depth_stencil_format) ? &depth_stencil_attachment_info : nullptr;
+
+	table.vkCmdBeginRenderingKHR(get_handle(), &rendering_info);
+
+	set_attachment_accesses(render_target, attachment_layouts);
+
+	auto blend_state = pipeline_state.get_color_blend_state();
+	blend_state.attachments.resize(color_attachment_infos.size());
+	pipeline_state.set_color_blend_state(blend_state);
+#else
+	throw std::runtime_error("Dynamic rendering is not available in the Vulkan headers");
+#endif
+}
+
+void CommandBuffer::next_subpass(VkSubpassContents contents)
 {
 	// Increment subpass index
 	pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
@@ -217,30 +596,49 @@ void CommandBuffer::next_subpass()
 
 	// Reset descriptor sets
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
+	external_descriptor_sets.clear();
 
 	// Clear stored push constants
 	stored_push_constants.clear();
 
-	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
+	table.vkCmdNextSubpass(get_handle(), contents);
 }
 
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
 {
-	vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+	flush_barriers();
+
+	table.vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+
+	invalidate_bound_state();
 }
 
 void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_command_buffers)
 {
+	flush_barriers();
+
 	std::vector<VkCommandBuffer> sec_cmd_buf_handles(secondary_command_buffers.size(), VK_NULL_HANDLE);
 	std::transform(secondary_command_buffers.begin(), secondary_command_buffers.end(), sec_cmd_buf_handles.begin(),
 	               [](const vkb::CommandBuffer *sec_cmd_buf) { return sec_cmd_buf->get_handle(); });
-	vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+	table.vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+
+	invalidate_bound_state();
 }
 
 void CommandBuffer::end_render_pass()
 {
-	vkCmdEndRenderPass(get_handle());
+#ifdef VK_KHR_dynamic_rendering
+	if (current_render_pass.dynamic_rendering)
+	{
+		table.vkCmdEndRenderingKHR(get_handle());
+
+		current_render_pass.dynamic_rendering = false;
+		return;
+	}
+#endif
+
+	table.vkCmdEndRenderPass(get_handle());
 }
 
 void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
@@ -248,11 +646,21 @@ void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
 	pipeline_state.set_pipeline_layout(pipeline_layout);
 }
 
+void CommandBuffer::set_fallback_pipeline(const GraphicsPipeline *pipeline)
+{
+	fallback_pipeline = pipeline;
+}
+
 void CommandBuffer::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
 {
 	pipeline_state.set_specialization_constant(constant_id, data);
 }
 
+void CommandBuffer::set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size)
+{
+	pipeline_state.set_specialization_constant(constant_id, data, size);
+}
+
 void CommandBuffer::push_constants(const std::vector<uint8_t> &values)
 {
 	uint32_t push_constant_size = to_u32(stored_push_constants.size() + values.size());
@@ -270,30 +678,116 @@ void CommandBuffer::push_constants(const std::vector<uint8_t> &values)
 
 void CommandBuffer::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
+	buffer.mark_used(get_device().get_resource_cache().get_frame_index());
+
 	resource_binding_state.bind_buffer(buffer, offset, range, set, binding, array_element);
 }
 
 void CommandBuffer::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
+	image_view.get_image().mark_used(get_device().get_resource_cache().get_frame_index());
+
 	resource_binding_state.bind_image(image_view, sampler, set, binding, array_element);
 }
 
 void CommandBuffer::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
+	image_view.get_image().mark_used(get_device().get_resource_cache().get_frame_index());
+
 	resource_binding_state.bind_input(image_view, set, binding, array_element);
 }
 
+void CommandBuffer::bind_descriptor_set(uint32_t set, VkDescriptorSet descriptor_set)
+{
+	// Pipelines created for descriptor buffers cannot bind descriptor sets
+	if (get_device().uses_descriptor_buffers())
+	{
+		throw std::runtime_error("Cannot bind a descriptor set when the device uses descriptor buffers");
+	}
+
+	external_descriptor_sets[set] = descriptor_set;
+}
+
 void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets)
 {
-	std::vector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE);
-	std::transform(buffers.begin(), buffers.end(), buffer_handles.begin(),
-	               [](const core::Buffer &buffer) { return buffer.get_handle(); });
-	vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+	uint32_t last_binding = first_binding + to_u32(buffers.size());
+
+	if (bound_vertex_buffers.size() < last_binding)
+	{
+		bound_vertex_buffers.resize(last_binding, VK_NULL_HANDLE);
+		bound_vertex_offsets.resize(last_binding, 0);
+	}
+
+	// Only bind the range of bindings which changed
+	uint32_t first_changed = last_binding;
+	uint32_t last_changed  = first_binding;
+
+	auto frame = get_device().get_resource_cache().get_frame_index();
+
+	for (uint32_t binding = first_binding; binding < last_binding; ++binding)
+	{
+		buffers[binding - first_binding].get().mark_used(frame);
+
+		auto buffer = buffers[binding - first_binding].get().get_handle();
+		auto offset = offsets[binding - first_binding];
+
+		if (bound_vertex_buffers[binding] != buffer || bound_vertex_offsets[binding] != offset)
+		{
+			bound_vertex_buffers[binding] = buffer;
+			bound_vertex_offsets[binding] = offset;
+
+			first_changed = std::min(first_changed, binding);
+			last_changed  = binding + 1;
+		}
+	}
+
+	if (first_changed >= last_changed)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	table.vkCmdBindVertexBuffers(get_handle(), first_changed, last_changed - first_changed, &bound_vertex_buffers[first_changed], &bound_vertex_offsets[first_changed]);
+}
+
+void CommandBuffer::bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset)
+{
+	if (bound_vertex_buffers.size() <= binding)
+	{
+		bound_vertex_buffers.resize(binding + 1, VK_NULL_HANDLE);
+		bound_vertex_offsets.resize(binding + 1, 0);
+	}
+
+	buffer.mark_used(get_device().get_resource_cache().get_frame_index());
+
+	if (bound_vertex_buffers[binding] == buffer.get_handle() && bound_vertex_offsets[binding] == offset)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	bound_vertex_buffers[binding] = buffer.get_handle();
+	bound_vertex_offsets[binding] = offset;
+
+	table.vkCmdBindVertexBuffers(get_handle(), binding, 1, &bound_vertex_buffers[binding], &bound_vertex_offsets[binding]);
 }
 
 void CommandBuffer::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
 {
-	vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+	buffer.mark_used(get_device().get_resource_cache().get_frame_index());
+
+	// Draws from a shared index buffer only change their first index
+	if (bound_index_buffer == buffer.get_handle() && bound_index_offset == offset && bound_index_type == index_type)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	table.vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+
+	bound_index_buffer = buffer.get_handle();
+	bound_index_offset = offset;
+	bound_index_type   = index_type;
 }
 
 void CommandBuffer::set_viewport_state(const ViewportState &state_info)
@@ -331,210 +825,689 @@ void CommandBuffer::set_color_blend_state(const ColorBlendState &state_info)
 	pipeline_state.set_color_blend_state(state_info);
 }
 
+void CommandBuffer::set_fragment_shading_rate_state(const FragmentShadingRateState &state_info)
+{
+	pipeline_state.set_fragment_shading_rate_state(state_info);
+}
+
 void CommandBuffer::set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports)
 {
-	vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
+	if (update_bound_range(bound_viewports, first_viewport, viewports))
+	{
+		table.vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
+	}
+	else
+	{
+		++redundant_call_count;
+	}
 }
 
 void CommandBuffer::set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors)
 {
-	vkCmdSetScissor(get_handle(), first_scissor, to_u32(scissors.size()), scissors.data());
+	if (update_bound_range(bound_scissors, first_scissor, scissors))
+	{
+		table.vkCmdSetScissor(get_handle(), first_scissor, to_u32(scissors.size()), scissors.data());
+	}
+	else
+	{
+		++redundant_call_count;
+	}
 }
 
 void CommandBuffer::set_line_width(float line_width)
 {
-	vkCmdSetLineWidth(get_handle(), line_width);
+	if ((bound_dynamic_states & LineWidthBit) && bound_line_width == line_width)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	bound_line_width = line_width;
+	bound_dynamic_states |= LineWidthBit;
+
+	table.vkCmdSetLineWidth(get_handle(), line_width);
 }
 
 void CommandBuffer::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
 {
-	vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	std::array<float, 3> depth_bias{depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor};
+
+	if ((bound_dynamic_states & DepthBiasBit) && bound_depth_bias == depth_bias)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	bound_depth_bias = depth_bias;
+	bound_dynamic_states |= DepthBiasBit;
+
+	table.vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
 }
 
 void CommandBuffer::set_blend_constants(const std::array<float, 4> &blend_constants)
 {
-	vkCmdSetBlendConstants(get_handle(), blend_constants.data());
-}
+	if ((bound_dynamic_states & BlendConstantsBit) && bound_blend_constants == blend_constants)
+	{
+		++redundant_call_count;
+		return;
+	}
 
-void CommandBuffer::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
-{
-	vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
+	bound_blend_constants = blend_constants;
+	bound_dynamic_states |= BlendConstantsBit;
+
+	table.vkCmdSetBlendConstants(get_handle(), blend_constants.data());
 }
 
-void CommandBuffer::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+void CommandBuffer::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
 {
-	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	std::array<float, 2> depth_bounds{min_depth_bounds, max_depth_bounds};
 
-	vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
-}
+	if ((bound_dynamic_states & DepthBoundsBit) && bound_depth_bounds == depth_bounds)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	bound_depth_bounds = depth_bounds;
+	bound_dynamic_states |= DepthBoundsBit;
+
+	table.vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
+}
+
+void CommandBuffer::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
+
+	table.vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
+}
 
 void CommandBuffer::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
-	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
+
+	table.vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
+}
+
+void CommandBuffer::draw_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
-	vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
+	table.vkCmdDrawIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
 }
 
 void CommandBuffer::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
 {
-	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
-	vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
+	table.vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
 }
 
+void CommandBuffer::draw_indexed_indirect_count(const core::Buffer &buffer, VkDeviceSize offset, const core::Buffer &count_buffer, VkDeviceSize count_offset, uint32_t max_draw_count, uint32_t stride)
+{
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
+
+	table.vkCmdDrawIndexedIndirectCountKHR(get_handle(), buffer.get_handle(), offset, count_buffer.get_handle(), count_offset, max_draw_count, stride);
+}
+
+#ifdef VK_EXT_mesh_shader
+void CommandBuffer::draw_mesh_tasks(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
+
+	table.vkCmdDrawMeshTasksEXT(get_handle(), group_count_x, group_count_y, group_count_z);
+}
+#endif
+
 void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
+	flush_barriers();
+
 	flush(VK_PIPELINE_BIND_POINT_COMPUTE);
 
-	vkCmdDispatch(get_handle(), group_count_x, group_count_y, group_count_z);
+	table.vkCmdDispatch(get_handle(), group_count_x, group_count_y, group_count_z);
 }
 
 void CommandBuffer::dispatch_indirect(const core::Buffer &buffer, VkDeviceSize offset)
 {
+	flush_barriers();
+
 	flush(VK_PIPELINE_BIND_POINT_COMPUTE);
 
-	vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
+	table.vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
 }
 
 void CommandBuffer::update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data)
 {
-	vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
+	flush_barriers();
+
+	table.vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
 }
 
 void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions)
 {
-	vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	flush_barriers();
+
+	table.vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                     dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                     to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
 }
 
 void CommandBuffer::resolve_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageResolve> &regions)
 {
-	vkCmdResolveImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	                  dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	                  to_u32(regions.size()), regions.data());
+	flush_barriers();
+
+	table.vkCmdResolveImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                        dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                        to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, VkDeviceSize size)
 {
+	flush_barriers();
+
 	VkBufferCopy copy_region = {};
 	copy_region.size         = size;
-	vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
+	table.vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
 }
 
 void CommandBuffer::copy_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageCopy> &regions)
 {
-	vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data());
+	flush_barriers();
+
+	table.vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                     dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                     to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions)
 {
-	vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
-	                       image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	                       to_u32(regions.size()), regions.data());
+	flush_barriers();
+
+	table.vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
+	                             image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                             to_u32(regions.size()), regions.data());
+}
+
+void CommandBuffer::copy_image_to_buffer(const core::Image &image, VkImageLayout image_layout, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions)
+{
+	flush_barriers();
+
+	table.vkCmdCopyImageToBuffer(get_handle(), image.get_handle(), image_layout,
+	                             buffer.get_handle(), to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
 {
-	// Adjust barrier's subresource range for depth images
-	auto subresource_range = image_view.get_subresource_range();
-	auto format            = image_view.get_format();
-	if (is_depth_only_format(format))
-	{
-		subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	}
-	else if (is_depth_stencil_format(format))
+	image_memory_barriers({&image_view}, {memory_barrier});
+}
+
+void CommandBuffer::image_memory_barriers(const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers)
+{
+	assert(image_views.size() == memory_barriers.size() && "Each image view should have a barrier");
+
+	if (image_views.empty())
 	{
-		subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		return;
 	}
 
-	VkImageMemoryBarrier image_memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-	image_memory_barrier.oldLayout        = memory_barrier.old_layout;
-	image_memory_barrier.newLayout        = memory_barrier.new_layout;
-	image_memory_barrier.image            = image_view.get_image().get_handle();
-	image_memory_barrier.subresourceRange = subresource_range;
-	image_memory_barrier.srcAccessMask    = memory_barrier.src_access_mask;
-	image_memory_barrier.dstAccessMask    = memory_barrier.dst_access_mask;
+	// Queued transitions may touch the same subresources, they come first
+	flush_barriers();
 
-	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
-	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
+	pipeline_barrier({}, get_image_barriers(image_views, memory_barriers));
 
-	vkCmdPipelineBarrier(
-	    get_handle(),
-	    src_stage_mask,
-	    dst_stage_mask,
-	    0,
-	    0, nullptr,
-	    0, nullptr,
-	    1,
-	    &image_memory_barrier);
+	for (size_t i = 0; i < image_views.size(); ++i)
+	{
+		auto &memory_barrier = memory_barriers[i];
+		image_views[i]->get_image().set_access(image_views[i]->get_subresource_range(), {memory_barrier.dst_stage_mask, memory_barrier.dst_access_mask, memory_barrier.new_layout, memory_barrier.new_queue_family});
+	}
 }
 
 void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
 {
+	flush_barriers();
+
 	VkBufferMemoryBarrier buffer_memory_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
-	buffer_memory_barrier.srcAccessMask = memory_barrier.src_access_mask;
-	buffer_memory_barrier.dstAccessMask = memory_barrier.dst_access_mask;
-	buffer_memory_barrier.buffer        = buffer.get_handle();
-	buffer_memory_barrier.offset        = offset;
-	buffer_memory_barrier.size          = size;
+	buffer_memory_barrier.srcAccessMask       = memory_barrier.src_access_mask;
+	buffer_memory_barrier.dstAccessMask       = memory_barrier.dst_access_mask;
+	buffer_memory_barrier.buffer              = buffer.get_handle();
+	buffer_memory_barrier.offset              = offset;
+	buffer_memory_barrier.size                = size;
+	buffer_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	buffer_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
+
+	pipeline_barrier({{buffer_memory_barrier, memory_barrier.src_stage_mask, memory_barrier.dst_stage_mask}}, {});
+
+	// Buffers are tracked as a whole, a barrier on a range stands for all of it
+	buffer.set_access({memory_barrier.dst_stage_mask, memory_barrier.dst_access_mask, VK_IMAGE_LAYOUT_UNDEFINED, memory_barrier.new_queue_family});
+}
+
+void CommandBuffer::transition(const core::ImageView &image_view, const ResourceAccess &access)
+{
+	auto &image = image_view.get_image();
+
+	// Two barriers on the same subresources in one pipeline barrier are not ordered
+	for (auto &pending : pending_image_barriers)
+	{
+		if (pending.barrier.image == image.get_handle())
+		{
+			flush_barriers();
+			break;
+		}
+	}
 
-	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
-	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
+	auto range = get_barrier_subresource_range(image_view);
 
-	vkCmdPipelineBarrier(
+	auto subresource = image.get_subresource();
+	auto level_count = range.levelCount == VK_REMAINING_MIP_LEVELS ? subresource.mipLevel - range.baseMipLevel : range.levelCount;
+	auto layer_count = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? subresource.arrayLayer - range.baseArrayLayer : range.layerCount;
+
+	for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layer_count; ++layer)
+	{
+		// Contiguous mip levels with the same previous access share a barrier
+		ResourceAccess run_access{};
+		bool           in_run = false;
+
+		for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + level_count; ++level)
+		{
+			ResourceAccess previous = image.get_access(level, layer);
+			ResourceAccess tracked;
+
+			if (!needs_barrier(previous, access, tracked))
+			{
+				in_run = false;
+				image.set_access({range.aspectMask, level, 1, layer, 1}, tracked);
+				continue;
+			}
+
+			if (in_run && is_same_access(previous, run_access))
+			{
+				pending_image_barriers.back().barrier.subresourceRange.levelCount++;
+			}
+			else
+			{
+				VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+				barrier.srcAccessMask       = get_write_access(previous.access_mask);
+				barrier.dstAccessMask       = access.access_mask;
+				barrier.oldLayout           = previous.layout;
+				barrier.newLayout           = access.layout;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image               = image.get_handle();
+				barrier.subresourceRange    = {range.aspectMask, level, 1, layer, 1};
+
+				if (is_queue_family_transfer(previous, access))
+				{
+					barrier.srcQueueFamilyIndex = previous.queue_family;
+					barrier.dstQueueFamilyIndex = access.queue_family;
+				}
+
+				pending_image_barriers.push_back({barrier, previous.stage_mask, access.stage_mask});
+
+				run_access = previous;
+				in_run     = true;
+			}
+
+			image.set_access({range.aspectMask, level, 1, layer, 1}, tracked);
+		}
+	}
+}
+
+void CommandBuffer::transition(const core::Buffer &buffer, const ResourceAccess &access)
+{
+	for (auto &pending : pending_buffer_barriers)
+	{
+		if (pending.barrier.buffer == buffer.get_handle())
+		{
+			flush_barriers();
+			break;
+		}
+	}
+
+	ResourceAccess previous = buffer.get_access();
+	ResourceAccess tracked;
+
+	bool barrier_needed = needs_barrier(previous, access, tracked);
+
+	buffer.set_access(tracked);
+
+	if (!barrier_needed)
+	{
+		return;
+	}
+
+	VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	barrier.srcAccessMask       = get_write_access(previous.access_mask);
+	barrier.dstAccessMask       = access.access_mask;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer              = buffer.get_handle();
+	barrier.offset              = 0;
+	barrier.size                = VK_WHOLE_SIZE;
+
+	if (is_queue_family_transfer(previous, access))
+	{
+		barrier.srcQueueFamilyIndex = previous.queue_family;
+		barrier.dstQueueFamilyIndex = access.queue_family;
+	}
+
+	pending_buffer_barriers.push_back({barrier, previous.stage_mask, access.stage_mask});
+}
+
+void CommandBuffer::flush_barriers()
+{
+	if (pending_image_barriers.empty() && pending_buffer_barriers.empty())
+	{
+		return;
+	}
+
+	pipeline_barrier(pending_buffer_barriers, pending_image_barriers);
+
+	pending_image_barriers.clear();
+	pending_buffer_barriers.clear();
+}
+
+void CommandBuffer::set_event(VkEvent event, const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers)
+{
+	assert(image_views.size() == memory_barriers.size() && "Each image view should have a barrier");
+
+	flush_barriers();
+
+	auto image_barriers = get_image_barriers(image_views, memory_barriers);
+
+#ifdef VK_KHR_synchronization2
+	if (synchronization2)
+	{
+		Dependency2<BufferBarrier, ImageBarrier> dependency{{}, image_barriers};
+
+		auto dependency_info = dependency.get_info();
+		table.vkCmdSetEvent2KHR(get_handle(), event, &dependency_info);
+		return;
+	}
+#endif
+
+	VkPipelineStageFlags src_stage_mask = 0;
+	for (auto &image_barrier : image_barriers)
+	{
+		src_stage_mask |= image_barrier.src_stage_mask;
+	}
+
+	table.vkCmdSetEvent(get_handle(), event, src_stage_mask);
+}
+
+void CommandBuffer::wait_event(VkEvent event, const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers)
+{
+	assert(image_views.size() == memory_barriers.size() && "Each image view should have a barrier");
+
+	flush_barriers();
+
+	auto image_barriers = get_image_barriers(image_views, memory_barriers);
+
+	VkPipelineStageFlags src_stage_mask = 0;
+	VkPipelineStageFlags dst_stage_mask = 0;
+
+	std::vector<VkImageMemoryBarrier> vk_image_barriers;
+	vk_image_barriers.reserve(image_barriers.size());
+
+	for (auto &image_barrier : image_barriers)
+	{
+		vk_image_barriers.push_back(image_barrier.barrier);
+
+		src_stage_mask |= image_barrier.src_stage_mask;
+		dst_stage_mask |= image_barrier.dst_stage_mask;
+	}
+
+#ifdef VK_KHR_synchronization2
+	if (synchronization2)
+	{
+		Dependency2<BufferBarrier, ImageBarrier> dependency{{}, image_barriers};
+
+		auto dependency_info = dependency.get_info();
+		table.vkCmdWaitEvents2KHR(get_handle(), 1, &event, &dependency_info);
+		table.vkCmdResetEvent2KHR(get_handle(), event, dst_stage_mask);
+	}
+	else
+#endif
+	{
+		table.vkCmdWaitEvents(
+		    get_handle(),
+		    1, &event,
+		    src_stage_mask,
+		    dst_stage_mask,
+		    0, nullptr,
+		    0, nullptr,
+		    to_u32(vk_image_barriers.size()), vk_image_barriers.data());
+
+		table.vkCmdResetEvent(get_handle(), event, dst_stage_mask);
+	}
+
+	for (size_t i = 0; i < image_views.size(); ++i)
+	{
+		auto &memory_barrier = memory_barriers[i];
+		image_views[i]->get_image().set_access(image_views[i]->get_subresource_range(), {memory_barrier.dst_stage_mask, memory_barrier.dst_access_mask, memory_barrier.new_layout, memory_barrier.new_queue_family});
+	}
+}
+
+void CommandBuffer::set_synchronization2(bool enable)
+{
+#ifdef VK_KHR_synchronization2
+	synchronization2 = enable && get_device().is_enabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+#else
+	synchronization2 = false;
+#endif
+}
+
+bool CommandBuffer::is_using_synchronization2() const
+{
+	return synchronization2;
+}
+
+void CommandBuffer::pipeline_barrier(const std::vector<BufferBarrier> &buffer_barriers, const std::vector<ImageBarrier> &image_barriers)
+{
+	if (buffer_barriers.empty() && image_barriers.empty())
+	{
+		return;
+	}
+
+#ifdef VK_KHR_synchronization2
+	if (synchronization2)
+	{
+		// Each barrier keeps its own stages instead of waiting for the stages of all of them
+		Dependency2<BufferBarrier, ImageBarrier> dependency{buffer_barriers, image_barriers};
+
+		auto dependency_info = dependency.get_info();
+		table.vkCmdPipelineBarrier2KHR(get_handle(), &dependency_info);
+		return;
+	}
+#endif
+
+	VkPipelineStageFlags src_stage_mask = 0;
+	VkPipelineStageFlags dst_stage_mask = 0;
+
+	std::vector<VkBufferMemoryBarrier> vk_buffer_barriers;
+	vk_buffer_barriers.reserve(buffer_barriers.size());
+
+	for (auto &buffer_barrier : buffer_barriers)
+	{
+		vk_buffer_barriers.push_back(buffer_barrier.barrier);
+
+		src_stage_mask |= buffer_barrier.src_stage_mask;
+		dst_stage_mask |= buffer_barrier.dst_stage_mask;
+	}
+
+	std::vector<VkImageMemoryBarrier> vk_image_barriers;
+	vk_image_barriers.reserve(image_barriers.size());
+
+	for (auto &image_barrier : image_barriers)
+	{
+		vk_image_barriers.push_back(image_barrier.barrier);
+
+		src_stage_mask |= image_barrier.src_stage_mask;
+		dst_stage_mask |= image_barrier.dst_stage_mask;
+	}
+
+	table.vkCmdPipelineBarrier(
 	    get_handle(),
 	    src_stage_mask,
 	    dst_stage_mask,
 	    0,
 	    0, nullptr,
-	    1, &buffer_memory_barrier,
-	    0, nullptr);
+	    to_u32(vk_buffer_barriers.size()), vk_buffer_barriers.data(),
+	    to_u32(vk_image_barriers.size()), vk_image_barriers.data());
+}
+
+std::vector<CommandBuffer::ImageBarrier> CommandBuffer::get_image_barriers(const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers) const
+{
+	std::vector<ImageBarrier> image_barriers;
+	image_barriers.reserve(image_views.size());
+
+	for (size_t i = 0; i < image_views.size(); ++i)
+	{
+		image_barriers.push_back({get_image_memory_barrier(*image_views[i], memory_barriers[i]), memory_barriers[i].src_stage_mask, memory_barriers[i].dst_stage_mask});
+	}
+
+	return image_barriers;
+}
+
+void CommandBuffer::set_attachment_accesses(const RenderTarget &render_target, const std::vector<VkImageLayout> &layouts)
+{
+	auto &views = render_target.get_views();
+
+	for (size_t i = 0; i < views.size() && i < layouts.size(); ++i)
+	{
+		if (layouts[i] == VK_IMAGE_LAYOUT_UNDEFINED)
+		{
+			continue;
+		}
+
+		ResourceAccess access;
+		access.layout = layouts[i];
+
+		// Attachments may also be read as input attachments in the fragment shader
+		if (is_depth_stencil_format(views[i].get_format()))
+		{
+			access.stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			access.access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		}
+		else
+		{
+			access.stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			access.access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		}
+
+		views[i].get_image().set_access(views[i].get_subresource_range(), access);
+	}
 }
 
-void CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
+bool CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
 {
+	VKB_PROFILE_ZONE("CommandBuffer::flush_pipeline_state");
+
 	// Create a new pipeline only if the graphics state changed
 	if (!pipeline_state.is_dirty())
 	{
-		return;
+		return true;
 	}
 
-	pipeline_state.clear_dirty();
-
 	// Create and bind pipeline
 	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
 	{
-		pipeline_state.set_render_pass(*current_render_pass.render_pass);
-		auto &pipeline = get_device().get_resource_cache().request_graphics_pipeline(pipeline_state);
+		if (current_render_pass.render_pass)
+		{
+			pipeline_state.set_render_pass(*current_render_pass.render_pass);
+		}
+		else
+		{
+			pipeline_state.set_rendering_formats(current_render_pass.color_formats, current_render_pass.depth_stencil_format);
+		}
+
+		auto &resource_cache = get_device().get_resource_cache();
+
+		if (resource_cache.is_async_pipeline_compilation_enabled())
+		{
+			auto pipeline = resource_cache.request_graphics_pipeline_async(pipeline_state);
+
+			if (!pipeline)
+			{
+				// Keep the state dirty so that the next draw checks whether the pipeline is ready
+				// A fallback with vertex input cannot stand in for a mesh shading pipeline
+				if (!fallback_pipeline || uses_mesh_shading(pipeline_state))
+				{
+					return false;
+				}
+
+				fallback_pipeline->mark_used(resource_cache.get_frame_index());
+
+				bind_pipeline(pipeline_bind_point, fallback_pipeline->get_handle());
+
+				return true;
+			}
+
+			pipeline_state.clear_dirty();
+
+			pipeline->mark_used(resource_cache.get_frame_index());
+
+			bind_pipeline(pipeline_bind_point, pipeline->get_handle());
+
+			return true;
+		}
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		pipeline_state.clear_dirty();
+
+		auto &pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
+
+		pipeline.mark_used(resource_cache.get_frame_index());
+
+		bind_pipeline(pipeline_bind_point, pipeline.get_handle());
 	}
 	else if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)
 	{
-		auto &pipeline = get_device().get_resource_cache().request_compute_pipeline(pipeline_state);
+		pipeline_state.clear_dirty();
+
+		auto &resource_cache = get_device().get_resource_cache();
+		auto &pipeline       = resource_cache.request_compute_pipeline(pipeline_state);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		pipeline.mark_used(resource_cache.get_frame_index());
+
+		bind_pipeline(pipeline_bind_point, pipeline.get_handle());
 	}
 	else
 	{
 		throw "Only graphics and compute pipeline bind points are supported now";
 	}
+
+	return true;
 }
 
 void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point)
 {
+	VKB_PROFILE_ZONE("CommandBuffer::flush_descriptor_state");
+
 	assert(command_pool.get_render_frame() && "The command pool must be associated to a render frame");
 
 	const auto &pipeline_layout = pipeline_state.get_pipeline_layout();
 
-	std::unordered_set<uint32_t> update_descriptor_sets;
+	auto &linear_allocator = command_pool.get_render_frame()->get_thread_context(command_pool.get_thread_index()).get_linear_allocator();
+
+	// Only needed for this flush, allocated from the arena of the frame
+	ArenaVector<uint32_t> update_descriptor_sets(linear_allocator);
 
 	// Iterate over the shader sets to check if they have already been bound
 	// If they have, add the set so that the command buffer later updates it
@@ -542,49 +1515,63 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 	{
 		uint32_t descriptor_set_id = set_it.first;
 
-		auto descriptor_set_layout_it = descriptor_set_layout_binding_state.find(descriptor_set_id);
+		auto descriptor_set_layout = descriptor_set_id < ResourceBindingState::MAX_SETS ? descriptor_set_layout_binding_state[descriptor_set_id] : nullptr;
 
-		if (descriptor_set_layout_it != descriptor_set_layout_binding_state.end())
+		if (descriptor_set_layout)
 		{
-			if (descriptor_set_layout_it->second->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
+			if (descriptor_set_layout->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
 			{
-				update_descriptor_sets.emplace(descriptor_set_id);
+				update_descriptor_sets.push_back(descriptor_set_id);
 			}
 		}
 	}
 
 	// Validate that the bound descriptor set layouts exist in the pipeline layout
-	for (auto set_it = descriptor_set_layout_binding_state.begin(); set_it != descriptor_set_layout_binding_state.end();)
+	for (uint32_t descriptor_set_id = 0; descriptor_set_id < ResourceBindingState::MAX_SETS; ++descriptor_set_id)
 	{
-		if (!pipeline_layout.has_descriptor_set_layout(set_it->first))
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
 		{
-			set_it = descriptor_set_layout_binding_state.erase(set_it);
+			descriptor_set_layout_binding_state[descriptor_set_id] = nullptr;
 		}
-		else
+	}
+
+	// Only update the resource sets whose state changed, or which are in the update list
+	uint32_t update_set_mask = resource_binding_state.get_dirty_sets();
+	for (auto descriptor_set_id : update_descriptor_sets)
+	{
+		if (descriptor_set_id < ResourceBindingState::MAX_SETS)
 		{
-			++set_it;
+			update_set_mask |= 1u << descriptor_set_id;
 		}
 	}
 
+	// Binding the same resources again does not dirty a set, so sets bound with another pipeline layout are rebound here
+	if (bound_descriptor_layout != pipeline_layout.get_handle() || bound_descriptor_bind_point != pipeline_bind_point)
+	{
+		update_set_mask = ~0u;
+	}
+
+	update_set_mask &= resource_binding_state.get_bound_sets();
+
+	// Descriptors are written into a buffer instead, there are no descriptor sets nor external sets to bind
+	if (get_device().uses_descriptor_buffers())
+	{
+		write_descriptor_buffers(pipeline_bind_point, pipeline_layout, update_set_mask);
+		return;
+	}
+
 	// Check if a descriptor set needs to be created
-	if (resource_binding_state.is_dirty() || !update_descriptor_sets.empty())
+	if (update_set_mask)
 	{
 		resource_binding_state.clear_dirty();
 
-		// Iterate over all of the resource sets bound by the command buffer
-		for (auto &resource_set_it : resource_binding_state.get_resource_sets())
-		{
-			uint32_t descriptor_set_id = resource_set_it.first;
-			auto &   resource_set      = resource_set_it.second;
+		auto render_frame = command_pool.get_render_frame();
+		auto thread_index = command_pool.get_thread_index();
 
-			// Don't update resource set if it's not in the update list OR its state hasn't changed
-			if (!resource_set.is_dirty() && (update_descriptor_sets.find(descriptor_set_id) == update_descriptor_sets.end()))
-			{
-				continue;
-			}
-
-			// Clear dirty flag for resource set
-			resource_binding_state.clear_dirty(descriptor_set_id);
+		for (; update_set_mask; update_set_mask &= update_set_mask - 1)
+		{
+			uint32_t descriptor_set_id = lowest_bit_index(update_set_mask);
+			auto &   resource_set      = resource_binding_state.get_resource_set(descriptor_set_id);
 
 			// Skip resource set if a descriptor set layout doesn't exist for it
 			if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
@@ -597,120 +1584,438 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 			// Make descriptor set layout bound for current set
 			descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
 
-			BindingMap<VkDescriptorBufferInfo> buffer_infos;
-			BindingMap<VkDescriptorImageInfo>  image_infos;
+			// Sets bound with another layout may have been disturbed, only trust the ones bound with this layout
+			if (bound_descriptor_layout != pipeline_layout.get_handle() || bound_descriptor_bind_point != pipeline_bind_point)
+			{
+				reset_bound_descriptor_sets();
+				bound_descriptor_layout     = pipeline_layout.get_handle();
+				bound_descriptor_bind_point = pipeline_bind_point;
+			}
 
-			std::vector<uint32_t> dynamic_offsets;
+			// Push descriptor sets are written into the command buffer, without any descriptor set to allocate or cache
+			if (descriptor_set_layout.is_push_descriptor())
+			{
+				push_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_layout, resource_set);
 
-			// The bindings we want to update before binding, if empty we update all bindings
-			std::vector<uint32_t> bindings_to_update;
+				auto bound_it = bound_descriptor_sets.find(descriptor_set_id);
+				if (bound_it != bound_descriptor_sets.end())
+				{
+					bound_it->second.first = VK_NULL_HANDLE;
+					bound_it->second.second.clear();
+				}
+				continue;
+			}
+
+			// Identical bindings of the same layout resolve to the same descriptor set, skip building their infos
+			size_t binding_hash = resource_set.get_hash();
+			hash_combine(binding_hash, descriptor_set_layout.get_handle());
+			hash_combine(binding_hash, update_after_bind);
+
+			auto cached_descriptor_set = render_frame->find_descriptor_set(binding_hash, thread_index);
 
-			// Iterate over all resource bindings
-			for (auto &binding_it : resource_set.get_resource_bindings())
+			if (!cached_descriptor_set)
 			{
-				auto  binding_index     = binding_it.first;
-				auto &binding_resources = binding_it.second;
+				BindingMap<VkDescriptorBufferInfo> buffer_infos;
+				BindingMap<VkDescriptorImageInfo>  image_infos;
 
-				// Check if binding exists in the pipeline layout
-				if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
+				std::vector<uint32_t> dynamic_offsets;
+
+				// The bindings we want to update before binding, if empty we update all bindings
+				ArenaVector<uint32_t> bindings_to_update(linear_allocator);
+
+				// Iterate over all resource bindings
+				for (auto binding_mask = resource_set.get_bound_bindings(); binding_mask; binding_mask &= binding_mask - 1)
 				{
-					// If update after bind is enabled, we store the binding index of each binding that need to be updated before being bound
-					if (update_after_bind && !(descriptor_set_layout.get_layout_binding_flag(binding_index) & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT))
-					{
-						bindings_to_update.push_back(binding_index);
-					}
+					auto binding_index = lowest_bit_index(binding_mask);
 
-					// Iterate over all binding resources
-					for (auto &element_it : binding_resources)
+					// Check if binding exists in the pipeline layout
+					if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
 					{
-						auto  array_element = element_it.first;
-						auto &resource_info = element_it.second;
-
-						// Pointer references
-						auto &buffer     = resource_info.buffer;
-						auto &sampler    = resource_info.sampler;
-						auto &image_view = resource_info.image_view;
+						// If update after bind is enabled, we store the binding index of each binding that need to be updated before being bound
+						if (update_after_bind && !(descriptor_set_layout.get_layout_binding_flag(binding_index) & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT))
+						{
+							bindings_to_update.push_back(binding_index);
+						}
 
-						// Get buffer info
-						if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+						// Iterate over all binding resources
+						for (auto element_mask = resource_set.get_bound_array_elements(binding_index); element_mask; element_mask &= element_mask - 1)
 						{
-							VkDescriptorBufferInfo buffer_info{};
+							auto  array_element = lowest_bit_index(element_mask);
+							auto &resource_info = resource_set.get_resource(binding_index, array_element);
 
-							buffer_info.buffer = resource_info.buffer->get_handle();
-							buffer_info.offset = resource_info.offset;
-							buffer_info.range  = resource_info.range;
+							// Pointer references
+							auto &buffer     = resource_info.buffer;
+							auto &sampler    = resource_info.sampler;
+							auto &image_view = resource_info.image_view;
 
-							if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
+							// Get buffer info
+							if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
 							{
-								dynamic_offsets.push_back(to_u32(buffer_info.offset));
+								VkDescriptorBufferInfo buffer_info{};
 
-								buffer_info.offset = 0;
-							}
+								buffer_info.buffer = resource_info.buffer->get_handle();
+								buffer_info.offset = resource_info.offset;
+								buffer_info.range  = resource_info.range;
 
-							buffer_infos[binding_index][array_element] = std::move(buffer_info);
-						}
+								if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
+								{
+									dynamic_offsets.push_back(to_u32(buffer_info.offset));
 
-						// Get image info
-						else if (image_view != nullptr || sampler != VK_NULL_HANDLE)
-						{
-							// Can be null for input attachments
-							VkDescriptorImageInfo image_info{};
-							image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
-							image_info.imageView = image_view->get_handle();
+									buffer_info.offset = 0;
+								}
+
+								buffer_infos[binding_index][array_element] = std::move(buffer_info);
+							}
 
-							if (image_view != nullptr)
+							// Get image info
+							else if (image_view != nullptr || sampler != VK_NULL_HANDLE)
 							{
-								// Add image layout info based on descriptor type
-								switch (binding_info->descriptorType)
+								// Can be null for input attachments
+								VkDescriptorImageInfo image_info{};
+								image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
+								image_info.imageView = image_view->get_handle();
+
+								if (image_view != nullptr)
 								{
-									case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										break;
-									case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-										if (is_depth_stencil_format(image_view->get_format()))
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-										}
-										else
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										}
-										break;
-									case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-										break;
-
-									default:
+									// Add image layout info based on descriptor type
+									image_info.imageLayout = find_descriptor_image_layout(binding_info->descriptorType, *image_view);
+
+									if (image_info.imageLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+									{
 										continue;
+									}
 								}
-							}
 
-							image_infos[binding_index][array_element] = std::move(image_info);
+								image_infos[binding_index][array_element] = std::move(image_info);
+							}
 						}
 					}
 				}
+
+				// Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
+				auto &descriptor_set = render_frame->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, thread_index);
+				descriptor_set.update(bindings_to_update);
+
+				cached_descriptor_set = &render_frame->cache_descriptor_set(binding_hash, descriptor_set, std::move(dynamic_offsets), thread_index);
 			}
 
-			// Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
-			auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index());
-			descriptor_set.update(bindings_to_update);
+			auto &dynamic_offsets = cached_descriptor_set->dynamic_offsets;
+
+			VkDescriptorSet descriptor_set_handle = cached_descriptor_set->descriptor_set->get_handle();
+
+			auto &bound_descriptor_set = bound_descriptor_sets[descriptor_set_id];
+
+			// A set whose resources changed and changed back since the last draw resolves to the descriptor set already bound
+			if (bound_descriptor_set.first == descriptor_set_handle && bound_descriptor_set.second == dynamic_offsets)
+			{
+				++redundant_call_count;
+				continue;
+			}
 
-			VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
+			bound_descriptor_set.first  = descriptor_set_handle;
+			bound_descriptor_set.second = dynamic_offsets;
 
 			// Bind descriptor set
-			vkCmdBindDescriptorSets(get_handle(),
-			                        pipeline_bind_point,
-			                        pipeline_layout.get_handle(),
-			                        descriptor_set_id,
-			                        1, &descriptor_set_handle,
-			                        to_u32(dynamic_offsets.size()),
-			                        dynamic_offsets.data());
+			table.vkCmdBindDescriptorSets(get_handle(),
+			                              pipeline_bind_point,
+			                              pipeline_layout.get_handle(),
+			                              descriptor_set_id,
+			                              1, &descriptor_set_handle,
+			                              to_u32(dynamic_offsets.size()),
+			                              dynamic_offsets.data());
 		}
 	}
+
+	// External sets are bound as they are, again only when another pipeline layout disturbed them
+	for (auto &external_set : external_descriptor_sets)
+	{
+		if (!pipeline_layout.has_descriptor_set_layout(external_set.first))
+		{
+			continue;
+		}
+
+		if (bound_descriptor_layout != pipeline_layout.get_handle() || bound_descriptor_bind_point != pipeline_bind_point)
+		{
+			reset_bound_descriptor_sets();
+			bound_descriptor_layout     = pipeline_layout.get_handle();
+			bound_descriptor_bind_point = pipeline_bind_point;
+		}
+
+		auto &bound_descriptor_set = bound_descriptor_sets[external_set.first];
+
+		if (bound_descriptor_set.first == external_set.second && bound_descriptor_set.second.empty())
+		{
+			++redundant_call_count;
+			continue;
+		}
+
+		bound_descriptor_set.first = external_set.second;
+		bound_descriptor_set.second.clear();
+
+		table.vkCmdBindDescriptorSets(get_handle(), pipeline_bind_point, pipeline_layout.get_handle(), external_set.first,
+		                              1, &external_set.second, 0, nullptr);
+	}
+}
+
+void CommandBuffer::push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, const DescriptorSetLayout &descriptor_set_layout, const ResourceSet &resource_set)
+{
+	constexpr uint32_t max_writes = ResourceSet::MAX_BINDINGS * ResourceSet::MAX_ARRAY_ELEMENTS;
+
+	// The infos only need to live until the push, so they stay on the stack
+	std::array<VkWriteDescriptorSet, max_writes>   write_descriptor_sets;
+	std::array<VkDescriptorBufferInfo, max_writes> buffer_infos;
+	std::array<VkDescriptorImageInfo, max_writes>  image_infos;
+
+	uint32_t write_count = 0;
+
+	for (auto binding_mask = resource_set.get_bound_bindings(); binding_mask; binding_mask &= binding_mask - 1)
+	{
+		auto binding_index = lowest_bit_index(binding_mask);
+
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_index);
+
+		if (!binding_info)
+		{
+			continue;
+		}
+
+		for (auto element_mask = resource_set.get_bound_array_elements(binding_index); element_mask; element_mask &= element_mask - 1)
+		{
+			auto  array_element = lowest_bit_index(element_mask);
+			auto &resource_info = resource_set.get_resource(binding_index, array_element);
+
+			VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+
+			write_descriptor_set.dstBinding      = binding_index;
+			write_descriptor_set.dstArrayElement = array_element;
+			write_descriptor_set.descriptorCount = 1;
+			write_descriptor_set.descriptorType  = binding_info->descriptorType;
+
+			if (resource_info.buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+			{
+				auto &buffer_info = buffer_infos[write_count];
+
+				buffer_info.buffer = resource_info.buffer->get_handle();
+				buffer_info.offset = resource_info.offset;
+				buffer_info.range  = resource_info.range;
+
+				write_descriptor_set.pBufferInfo = &buffer_info;
+			}
+			else if (resource_info.image_view != nullptr)
+			{
+				auto &image_info = image_infos[write_count];
+
+				image_info.sampler     = resource_info.sampler ? resource_info.sampler->get_handle() : VK_NULL_HANDLE;
+				image_info.imageView   = resource_info.image_view->get_handle();
+				image_info.imageLayout = find_descriptor_image_layout(binding_info->descriptorType, *resource_info.image_view);
+
+				if (image_info.imageLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					continue;
+				}
+
+				write_descriptor_set.pImageInfo = &image_info;
+			}
+			else
+			{
+				continue;
+			}
+
+			write_descriptor_sets[write_count++] = write_descriptor_set;
+		}
+	}
+
+	if (write_count > 0)
+	{
+		table.vkCmdPushDescriptorSetKHR(get_handle(), pipeline_bind_point, pipeline_layout.get_handle(), descriptor_set_layout.get_index(), write_count, write_descriptor_sets.data());
+	}
+}
+
+void CommandBuffer::write_descriptor_buffers(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, uint32_t update_set_mask)
+{
+#ifdef VK_EXT_descriptor_buffer
+	// Sets without a layout in the pipeline layout have nothing to write
+	auto get_layout_sets = [&pipeline_layout](uint32_t set_mask) {
+		for (auto mask = set_mask; mask; mask &= mask - 1)
+		{
+			uint32_t descriptor_set_id = lowest_bit_index(mask);
+
+			if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+			{
+				set_mask &= ~(1u << descriptor_set_id);
+			}
+		}
+
+		return set_mask;
+	};
+
+	update_set_mask = get_layout_sets(update_set_mask);
+
+	if (!update_set_mask)
+	{
+		return;
+	}
+
+	resource_binding_state.clear_dirty();
+
+	bound_descriptor_layout     = pipeline_layout.get_handle();
+	bound_descriptor_bind_point = pipeline_bind_point;
+
+	auto &device       = get_device();
+	auto  render_frame = command_pool.get_render_frame();
+	auto  thread_index = command_pool.get_thread_index();
+	auto  alignment    = std::max<VkDeviceSize>(device.get_descriptor_buffer_properties().descriptorBufferOffsetAlignment, 1);
+
+	// The sets written together share one allocation, each at an aligned offset
+	auto allocate = [&](uint32_t set_mask) {
+		VkDeviceSize size = 0;
+
+		for (; set_mask; set_mask &= set_mask - 1)
+		{
+			auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(lowest_bit_index(set_mask));
+
+			size += (descriptor_set_layout.get_descriptor_buffer_size() + alignment - 1) & ~(alignment - 1);
+		}
+
+		return render_frame->allocate_buffer(RenderFrame::DESCRIPTOR_BUFFER_USAGE, size, thread_index);
+	};
+
+	auto allocation = allocate(update_set_mask);
+
+	// The offsets of the sets written before point into the bound buffer, which binding another one replaces
+	auto bound_sets = get_layout_sets(resource_binding_state.get_bound_sets());
+
+	if (!allocation.empty() && bound_descriptor_buffer && &allocation.get_buffer() != bound_descriptor_buffer && update_set_mask != bound_sets)
+	{
+		update_set_mask = bound_sets;
+		allocation      = allocate(update_set_mask);
+	}
+
+	if (allocation.empty())
+	{
+		LOGE("Cannot allocate the descriptors of the sets in a descriptor buffer");
+		return;
+	}
+
+	if (&allocation.get_buffer() != bound_descriptor_buffer)
+	{
+		VkDescriptorBufferBindingInfoEXT binding_info{VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT};
+		binding_info.address = allocation.get_buffer().get_device_address();
+		binding_info.usage   = RenderFrame::DESCRIPTOR_BUFFER_USAGE;
+
+		table.vkCmdBindDescriptorBuffersEXT(get_handle(), 1, &binding_info);
+
+		bound_descriptor_buffer = &allocation.get_buffer();
+	}
+
+	// Descriptors are written straight into the mapped allocation
+	auto         data       = allocation.map(to_u32(allocation.get_size()));
+	VkDeviceSize set_offset = 0;
+
+	for (; update_set_mask; update_set_mask &= update_set_mask - 1)
+	{
+		uint32_t descriptor_set_id     = lowest_bit_index(update_set_mask);
+		auto &   descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+		auto &   resource_set          = resource_binding_state.get_resource_set(descriptor_set_id);
+
+		descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+
+		for (auto binding_mask = resource_set.get_bound_bindings(); binding_mask; binding_mask &= binding_mask - 1)
+		{
+			auto binding_index = lowest_bit_index(binding_mask);
+			auto binding_info  = descriptor_set_layout.get_layout_binding(binding_index);
+
+			if (!binding_info)
+			{
+				continue;
+			}
+
+			auto descriptor_type   = binding_info->descriptorType;
+			auto descriptor_size   = device.get_descriptor_size(descriptor_type);
+			auto descriptors_start = data + set_offset + descriptor_set_layout.get_descriptor_buffer_offset(binding_index);
+
+			for (auto element_mask = resource_set.get_bound_array_elements(binding_index); element_mask; element_mask &= element_mask - 1)
+			{
+				auto  array_element = lowest_bit_index(element_mask);
+				auto &resource_info = resource_set.get_resource(binding_index, array_element);
+
+				VkDescriptorGetInfoEXT     get_info{VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT};
+				VkDescriptorAddressInfoEXT address_info{VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
+				VkDescriptorImageInfo      image_info{};
+				VkSampler                  sampler = resource_info.sampler ? resource_info.sampler->get_handle() : VK_NULL_HANDLE;
+
+				get_info.type = descriptor_type;
+
+				if (resource_info.buffer != nullptr && is_buffer_descriptor_type(descriptor_type))
+				{
+					address_info.address = resource_info.buffer->get_device_address() + resource_info.offset;
+					address_info.range   = resource_info.range == VK_WHOLE_SIZE ? resource_info.buffer->get_size() - resource_info.offset : resource_info.range;
+
+					if (descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+					{
+						get_info.data.pUniformBuffer = &address_info;
+					}
+					else
+					{
+						get_info.data.pStorageBuffer = &address_info;
+					}
+				}
+				else if (resource_info.image_view != nullptr)
+				{
+					image_info.sampler     = sampler;
+					image_info.imageView   = resource_info.image_view->get_handle();
+					image_info.imageLayout = find_descriptor_image_layout(descriptor_type, *resource_info.image_view);
+
+					if (image_info.imageLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+					{
+						continue;
+					}
+
+					switch (descriptor_type)
+					{
+						case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+							get_info.data.pCombinedImageSampler = &image_info;
+							break;
+						case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+							get_info.data.pStorageImage = &image_info;
+							break;
+						case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+							get_info.data.pInputAttachmentImage = &image_info;
+							break;
+						default:
+							get_info.data.pSampledImage = &image_info;
+							break;
+					}
+				}
+				else if (sampler != VK_NULL_HANDLE && descriptor_type == VK_DESCRIPTOR_TYPE_SAMPLER)
+				{
+					get_info.data.pSampler = &sampler;
+				}
+				else
+				{
+					continue;
+				}
+
+				table.vkGetDescriptorEXT(device.get_handle(), &get_info, descriptor_size, descriptors_start + array_element * descriptor_size);
+			}
+		}
+
+		uint32_t     buffer_index  = 0;
+		VkDeviceSize buffer_offset = allocation.get_offset() + set_offset;
+
+		table.vkCmdSetDescriptorBufferOffsetsEXT(get_handle(), pipeline_bind_point, pipeline_layout.get_handle(), descriptor_set_id, 1, &buffer_index, &buffer_offset);
+
+		set_offset += (descriptor_set_layout.get_descriptor_buffer_size() + alignment - 1) & ~(alignment - 1);
+	}
+
+	allocation.flush();
+#endif
 }
 
 void CommandBuffer::flush_push_constants()
 {
+	VKB_PROFILE_ZONE("CommandBuffer::flush_push_constants");
+
 	if (stored_push_constants.empty())
 	{
 		return;
@@ -722,7 +2027,7 @@ void CommandBuffer::flush_push_constants()
 
 	if (shader_stage)
 	{
-		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, 0, to_u32(stored_push_constants.size()), stored_push_constants.data());
+		table.vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, 0, to_u32(stored_push_constants.size()), stored_push_constants.data());
 	}
 	else
 	{
@@ -763,23 +2068,115 @@ const bool CommandBuffer::is_render_size_optimal(const VkExtent2D &framebuffer_e
 
 void CommandBuffer::reset_query_pool(const QueryPool &query_pool, uint32_t first_query, uint32_t query_count)
 {
-	vkCmdResetQueryPool(get_handle(), query_pool.get_handle(), first_query, query_count);
+	table.vkCmdResetQueryPool(get_handle(), query_pool.get_handle(), first_query, query_count);
 }
 
 void CommandBuffer::begin_query(const QueryPool &query_pool, uint32_t query, VkQueryControlFlags flags)
 {
-	vkCmdBeginQuery(get_handle(), query_pool.get_handle(), query, flags);
+	table.vkCmdBeginQuery(get_handle(), query_pool.get_handle(), query, flags);
 }
 
 void CommandBuffer::end_query(const QueryPool &query_pool, uint32_t query)
 {
-	vkCmdEndQuery(get_handle(), query_pool.get_handle(), query);
+	table.vkCmdEndQuery(get_handle(), query_pool.get_handle(), query);
 }
 
 void CommandBuffer::write_timestamp(VkPipelineStageFlagBits pipeline_stage,
                                     const QueryPool &query_pool, uint32_t query)
 {
-	vkCmdWriteTimestamp(get_handle(), pipeline_stage, query_pool.get_handle(), query);
+	table.vkCmdWriteTimestamp(get_handle(), pipeline_stage, query_pool.get_handle(), query);
+}
+
+void CommandBuffer::set_gpu_profiler(GpuProfiler *profiler)
+{
+	gpu_profiler = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? profiler : nullptr;
+}
+
+void CommandBuffer::push_gpu_scope(const std::string &name)
+{
+	if (debug_labels)
+	{
+		debug_utils::cmd_begin_label(get_handle(), name.c_str());
+	}
+
+	if (gpu_profiler)
+	{
+		gpu_profiler->push_scope(*this, name);
+	}
+}
+
+void CommandBuffer::pop_gpu_scope()
+{
+	if (gpu_profiler)
+	{
+		gpu_profiler->pop_scope(*this);
+	}
+
+	if (debug_labels)
+	{
+		debug_utils::cmd_end_label(get_handle());
+	}
+}
+
+bool CommandBuffer::has_gpu_scopes() const
+{
+	return debug_labels || gpu_profiler;
+}
+
+const CommandBuffer::ResetMode CommandBuffer::get_reset_mode() const
+{
+	return command_pool.get_reset_mode();
+}
+
+uint32_t CommandBuffer::get_redundant_call_count() const
+{
+	return redundant_call_count;
+}
+
+void CommandBuffer::bind_pipeline(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline)
+{
+	auto &bound_pipeline = pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? bound_compute_pipeline : bound_graphics_pipeline;
+
+	// Different states may resolve to the same pipeline
+	if (bound_pipeline == pipeline)
+	{
+		++redundant_call_count;
+		return;
+	}
+
+	bound_pipeline = pipeline;
+
+	table.vkCmdBindPipeline(get_handle(), pipeline_bind_point, pipeline);
+}
+
+void CommandBuffer::invalidate_bound_state()
+{
+	bound_index_buffer = VK_NULL_HANDLE;
+
+	bound_graphics_pipeline = VK_NULL_HANDLE;
+	bound_compute_pipeline  = VK_NULL_HANDLE;
+
+	bound_descriptor_layout = VK_NULL_HANDLE;
+	reset_bound_descriptor_sets();
+	bound_descriptor_buffer = nullptr;
+
+	bound_vertex_buffers.clear();
+	bound_vertex_offsets.clear();
+
+	bound_viewports.clear();
+	bound_scissors.clear();
+
+	bound_dynamic_states = 0;
+}
+
+void CommandBuffer::reset_bound_descriptor_sets()
+{
+	// Clearing the map would free its nodes, and the next flush allocate them again
+	for (auto &bound_descriptor_set : bound_descriptor_sets)
+	{
+		bound_descriptor_set.second.first = VK_NULL_HANDLE;
+		bound_descriptor_set.second.second.clear();
+	}
 }
 
 VkResult CommandBuffer::reset(ResetMode reset_mode)
@@ -792,7 +2189,7 @@ VkResult CommandBuffer::reset(ResetMode reset_mode)
 
 	if (reset_mode == ResetMode::ResetIndividually)
 	{
-		result = vkResetCommandBuffer(handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+		result = table.vkResetCommandBuffer(handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
 	}
 
 	return result;
@@ -34,7 +34,10 @@ namespace vkb
 {
 class CommandPool;
 class DescriptorSet;
+class DescriptorSetLayout;
 class Framebuffer;
+class GpuProfiler;
+class GraphicsPipeline;
 class Pipeline;
 class PipelineLayout;
 class PipelineState;
@@ -68,12 +71,26 @@ class CommandBuffer
 	 */
 	struct RenderPassBinding
 	{
-		const RenderPass *render_pass;
+		const RenderPass *render_pass{nullptr};
 
-		const Framebuffer *framebuffer;
+		const Framebuffer *framebuffer{nullptr};
+
+		/// Whether the commands are recorded in a dynamic rendering scope, without render pass and framebuffer
+		bool dynamic_rendering{false};
+
+		/// Formats of the color attachments of dynamic rendering
+		std::vector<VkFormat> color_formats;
+
+		/// Format of the depth stencil attachment of dynamic rendering, undefined without one
+		VkFormat depth_stencil_format{VK_FORMAT_UNDEFINED};
+
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
 	};
 
-	CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level);
+	/**
+	 * @brief Wraps a command buffer allocated by the pool, the command buffer is freed with the wrapper
+	 */
+	CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level, VkCommandBuffer handle);
 
 	CommandBuffer(const CommandBuffer &) = delete;
 
@@ -94,8 +111,9 @@ class CommandBuffer
 	/**
 	 * @brief Flushes the command buffer, pushing the new changes
 	 * @param pipeline_bind_point The type of pipeline we want to flush
+	 * @return False if no pipeline could be bound, in which case the following draw must be skipped
 	 */
-	void flush(VkPipelineBindPoint pipeline_bind_point);
+	bool flush(VkPipelineBindPoint pipeline_bind_point);
 
 	/**
 	 * @brief Sets the command buffer so that it is ready for recording
@@ -111,9 +129,30 @@ class CommandBuffer
 
 	void clear(VkClearAttachment info, VkClearRect rect);
 
-	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+	/**
+	 * @param render_area Extent of the region of the render target drawn by the render pass, the whole target when empty
+	 */
+	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE,
+	                       const VkExtent2D &render_area = {});
 
-	void next_subpass();
+	/**
+	 * @brief Begins a render pass requested from the resource cache, for passes recorded without Subpass objects
+	 */
+	void begin_render_pass(const RenderTarget &render_target, const RenderPass &render_pass, const Framebuffer &framebuffer, const std::vector<VkClearValue> &clear_values, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE,
+	                       const VkExtent2D &render_area = {});
+
+	/**
+	 * @brief Begins a dynamic rendering scope with VK_KHR_dynamic_rendering, instead of a render pass
+	 *        The attachments must already be in the attachment layouts, as there is no render pass to transition them.
+	 *        The scope ends with end_render_pass().
+	 * @param color_attachments Indices of the attachments of the render target written as color attachments
+	 * @param depth_stencil_attachment Whether the first depth attachment of the render target is used
+	 */
+	void begin_rendering(const RenderTarget &render_target, const std::vector<uint32_t> &color_attachments, bool depth_stencil_attachment,
+	                     const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values,
+	                     VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE, const VkExtent2D &render_area = {});
+
+	void next_subpass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
 	void execute_commands(CommandBuffer &secondary_command_buffer);
 
@@ -123,11 +162,22 @@ class CommandBuffer
 
 	void bind_pipeline_layout(PipelineLayout &pipeline_layout);
 
+	/**
+	 * @brief Sets the pipeline to bind while the graphics pipeline for the current state
+	 *        is still being compiled asynchronously by the resource cache.
+	 *        The fallback must use a pipeline layout compatible with the current one.
+	 *        Without a fallback, draws are skipped until the pipeline is ready.
+	 * @param pipeline The fallback pipeline, nullptr to skip draws instead
+	 */
+	void set_fallback_pipeline(const GraphicsPipeline *pipeline);
+
 	template <class T>
 	void set_specialization_constant(uint32_t constant_id, const T &data);
 
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
+	void set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size);
+
 	/**
 	 * @brief Records byte data into the command buffer to be pushed as push constants to each draw call
 	 * @param values The byte data to store
@@ -137,9 +187,10 @@ class CommandBuffer
 	template <typename T>
 	void push_constants(const T &value)
 	{
-		auto data = to_bytes(value);
+		// Copied straight into the stored bytes, without a vector for each push
+		auto data = reinterpret_cast<const uint8_t *>(&value);
 
-		uint32_t size = to_u32(stored_push_constants.size() + data.size());
+		uint32_t size = to_u32(stored_push_constants.size() + sizeof(T));
 
 		if (size > max_push_constants_size)
 		{
@@ -147,7 +198,7 @@ class CommandBuffer
 			throw std::runtime_error("Cannot overflow push constant limit");
 		}
 
-		stored_push_constants.insert(stored_push_constants.end(), data.begin(), data.end());
+		stored_push_constants.insert(stored_push_constants.end(), data, data + sizeof(T));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
@@ -156,8 +207,21 @@ class CommandBuffer
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
+	/**
+	 * @brief Binds a descriptor set allocated outside of the render frame, such as a bindless table, to a set index
+	 *        The set is bound to the draws whose pipeline layout has the set, after the sets of the bound resources.
+	 *        Its layout must be compatible with the set layout of these pipeline layouts.
+	 *        Not supported when the device uses descriptor buffers.
+	 */
+	void bind_descriptor_set(uint32_t set, VkDescriptorSet descriptor_set);
+
 	void bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets);
 
+	/**
+	 * @brief Binds a single vertex buffer, without building the vectors of bind_vertex_buffers() for each draw
+	 */
+	void bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset);
+
 	void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
 
 	void set_viewport_state(const ViewportState &state_info);
@@ -174,6 +238,8 @@ class CommandBuffer
 
 	void set_color_blend_state(const ColorBlendState &state_info);
 
+	void set_fragment_shading_rate_state(const FragmentShadingRateState &state_info);
+
 	void set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports);
 
 	void set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors);
@@ -190,8 +256,22 @@ class CommandBuffer
 
 	void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
 
+	void draw_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
+
 	void draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
 
+	/**
+	 * @brief Draws indexed with a draw count read from a buffer, needs VK_KHR_draw_indirect_count
+	 */
+	void draw_indexed_indirect_count(const core::Buffer &buffer, VkDeviceSize offset, const core::Buffer &count_buffer, VkDeviceSize count_offset, uint32_t max_draw_count, uint32_t stride);
+
+#ifdef VK_EXT_mesh_shader
+	/**
+	 * @brief Launches task shader workgroups, or mesh shader workgroups if the pipeline has no task shader, needs VK_EXT_mesh_shader
+	 */
+	void draw_mesh_tasks(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+#endif
+
 	void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
 
 	void dispatch_indirect(const core::Buffer &buffer, VkDeviceSize offset);
@@ -208,10 +288,66 @@ class CommandBuffer
 
 	void copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions);
 
+	void copy_image_to_buffer(const core::Image &image, VkImageLayout image_layout, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions);
+
 	void image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier);
 
+	/**
+	 * @brief Records the barriers of several images with a single pipeline barrier
+	 *        It waits for the union of the source stages and blocks the union of the destination stages.
+	 * @param image_views The image of each barrier
+	 * @param memory_barriers A barrier for each image view
+	 */
+	void image_memory_barriers(const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers);
+
 	void buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier);
 
+	/**
+	 * @brief Queues the barrier needed before the subresources of an image view are accessed as described,
+	 *        from the last access recorded to them. Read after read with the same layout needs no barrier.
+	 *        Queued barriers are recorded by the next command using resources or flush_barriers(),
+	 *        so transitions have to be queued outside of render passes.
+	 *        Tracking follows the recording order, command buffers recorded in parallel must not share resources.
+	 *        A queue family ownership transfer is only recorded as the release, the acquire on the other queue
+	 *        has to be recorded with image_memory_barrier().
+	 * @param image_view The subresources about to be accessed
+	 * @param access The stages, accesses, layout and queue family of the next access
+	 */
+	void transition(const core::ImageView &image_view, const ResourceAccess &access);
+
+	/**
+	 * @brief Queues the barrier needed before the whole buffer is accessed as described, see transition() for images
+	 */
+	void transition(const core::Buffer &buffer, const ResourceAccess &access);
+
+	/**
+	 * @brief Records the queued transitions with a single pipeline barrier
+	 */
+	void flush_barriers();
+
+	/**
+	 * @brief Signals an event once the source stages of the barriers are done, the first half of a split barrier.
+	 *        The work recorded until wait_event() can overlap with the stages being waited for.
+	 * @param event An event which is unsignaled, or reset by a previous wait_event()
+	 * @param image_views The image of each barrier
+	 * @param memory_barriers A barrier for each image view, the same as passed to wait_event()
+	 */
+	void set_event(VkEvent event, const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers);
+
+	/**
+	 * @brief Waits for an event signaled by set_event() with the same barriers, recording their layout transitions,
+	 *        then resets it so that it can be signaled again
+	 */
+	void wait_event(VkEvent event, const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers);
+
+	/**
+	 * @brief Records barriers and events with VK_KHR_synchronization2 until the command buffer begins again,
+	 *        so that each barrier only waits for its own stages. It is used by default when the extension is enabled.
+	 */
+	void set_synchronization2(bool enable);
+
+	bool is_using_synchronization2() const;
+
 	const State get_state() const;
 
 	void set_update_after_bind(bool update_after_bind_);
@@ -224,12 +360,41 @@ class CommandBuffer
 
 	void write_timestamp(VkPipelineStageFlagBits pipeline_stage, const QueryPool &query_pool, uint32_t query);
 
+	/**
+	 * @brief Sets the profiler timing the GPU scopes of the command buffer until it begins again
+	 *        Only primary command buffers are timed, the scopes of the others are only labelled
+	 */
+	void set_gpu_profiler(GpuProfiler *profiler);
+
+	/**
+	 * @brief Opens a named region, labelled with VK_EXT_debug_utils and timed by the GPU profiler if one is set
+	 */
+	void push_gpu_scope(const std::string &name);
+
+	void pop_gpu_scope();
+
+	/**
+	 * @return Whether the GPU scopes are labelled or timed, callers can skip building their names otherwise
+	 */
+	bool has_gpu_scopes() const;
+
 	/**
 	 * @brief Reset the command buffer to a state where it can be recorded to
 	 * @param reset_mode How to reset the buffer, should match the one used by the pool to allocate it
 	 */
 	VkResult reset(ResetMode reset_mode);
 
+	/**
+	 * @return The reset mode of the pool the buffer was allocated from
+	 */
+	const ResetMode get_reset_mode() const;
+
+	/**
+	 * @return The number of binding and dynamic state calls skipped since the last begin,
+	 *         because they set the same value as the previous call
+	 */
+	uint32_t get_redundant_call_count() const;
+
 	const VkCommandBufferLevel level;
 
   private:
@@ -237,6 +402,9 @@ class CommandBuffer
 
 	CommandPool &command_pool;
 
+	/// Device level function pointers, the commands are recorded without going through the loader
+	const VolkDeviceTable &table;
+
 	VkCommandBuffer handle{VK_NULL_HANDLE};
 
 	RenderPassBinding current_render_pass;
@@ -257,7 +425,97 @@ class CommandBuffer
 	// that contain update after bind, as they wont be implicitly updated
 	bool update_after_bind{false};
 
-	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
+	/// Layouts of the sets bound by the last flush, nullptr for the sets without one
+	std::array<DescriptorSetLayout *, ResourceBindingState::MAX_SETS> descriptor_set_layout_binding_state{};
+
+	/// Descriptor sets bound with bind_descriptor_set(), by set index
+	std::unordered_map<uint32_t, VkDescriptorSet> external_descriptor_sets;
+
+	/// Profiler of the GPU scopes, set for the current recording only
+	GpuProfiler *gpu_profiler{nullptr};
+
+	/// Whether debug labels were enabled when the recording began, keeps the labels of a recording paired
+	bool debug_labels{false};
+
+	const GraphicsPipeline *fallback_pipeline{nullptr};
+
+	/// Last index buffer binding, redundant binds are skipped
+	VkBuffer bound_index_buffer{VK_NULL_HANDLE};
+
+	VkDeviceSize bound_index_offset{0};
+
+	VkIndexType bound_index_type{VK_INDEX_TYPE_UINT16};
+
+	/// Last states sent to Vulkan, redundant calls setting the same value are skipped
+	VkPipeline bound_graphics_pipeline{VK_NULL_HANDLE};
+
+	VkPipeline bound_compute_pipeline{VK_NULL_HANDLE};
+
+	/// Descriptor sets bound per set index, only valid for the layout they were bound with
+	VkPipelineLayout bound_descriptor_layout{VK_NULL_HANDLE};
+
+	VkPipelineBindPoint bound_descriptor_bind_point{VK_PIPELINE_BIND_POINT_GRAPHICS};
+
+	/// Entries are only reset, so that the same sets bound in every recording don't reallocate them
+	std::unordered_map<uint32_t, std::pair<VkDescriptorSet, std::vector<uint32_t>>> bound_descriptor_sets;
+
+	/// Buffer bound with vkCmdBindDescriptorBuffersEXT, the offsets of the sets point into it
+	const core::Buffer *bound_descriptor_buffer{nullptr};
+
+	std::vector<VkBuffer> bound_vertex_buffers;
+
+	std::vector<VkDeviceSize> bound_vertex_offsets;
+
+	std::vector<VkViewport> bound_viewports;
+
+	std::vector<VkRect2D> bound_scissors;
+
+	float bound_line_width{0.0f};
+
+	std::array<float, 3> bound_depth_bias{};
+
+	std::array<float, 4> bound_blend_constants{};
+
+	std::array<float, 2> bound_depth_bounds{};
+
+	enum DynamicStateBit : uint32_t
+	{
+		LineWidthBit      = 1 << 0,
+		DepthBiasBit      = 1 << 1,
+		BlendConstantsBit = 1 << 2,
+		DepthBoundsBit    = 1 << 3
+	};
+
+	/// DynamicStateBit of the states set since the last begin
+	uint32_t bound_dynamic_states{0};
+
+	uint32_t redundant_call_count{0};
+
+	/// A barrier with the stages it waits for and blocks, combined for all the barriers without synchronization2
+	struct ImageBarrier
+	{
+		VkImageMemoryBarrier barrier;
+
+		VkPipelineStageFlags src_stage_mask;
+
+		VkPipelineStageFlags dst_stage_mask;
+	};
+
+	struct BufferBarrier
+	{
+		VkBufferMemoryBarrier barrier;
+
+		VkPipelineStageFlags src_stage_mask;
+
+		VkPipelineStageFlags dst_stage_mask;
+	};
+
+	/// Barriers queued by transition(), recorded together by flush_barriers()
+	std::vector<ImageBarrier> pending_image_barriers;
+
+	std::vector<BufferBarrier> pending_buffer_barriers;
+
+	bool synchronization2{false};
 
 	const RenderPassBinding &get_current_render_pass() const;
 
@@ -270,29 +528,69 @@ class CommandBuffer
 
 	/**
 	 * @brief Flush the piplines state
+	 * @return False if the pipeline is not ready and there is no fallback to bind
 	 */
-	void flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
+	bool flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
 
 	/**
 	 * @brief Flush the descriptor set state
 	 */
 	void flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point);
 
+	/**
+	 * @brief Writes the resources of a push descriptor set straight into the command buffer
+	 */
+	void push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, const DescriptorSetLayout &descriptor_set_layout, const ResourceSet &resource_set);
+
+	/**
+	 * @brief Writes the descriptors of the sets in the mask into the descriptor buffer of the render frame,
+	 *        and sets their offsets in it
+	 */
+	void write_descriptor_buffers(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, uint32_t update_set_mask);
+
 	/**
 	 * @brief Flush the push constant state
 	 */
 	void flush_push_constants();
+
+	void bind_pipeline(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline);
+
+	/**
+	 * @brief Forgets the states sent to Vulkan, e.g. after executing secondary command buffers
+	 *        which leave the state of the primary undefined
+	 */
+	void invalidate_bound_state();
+
+	/**
+	 * @brief Forgets the descriptor sets bound per set index, keeping the entries for the next binds
+	 */
+	void reset_bound_descriptor_sets();
+
+	/**
+	 * @brief Records the access of the attachments of a render target, as left by the render pass
+	 * @param render_target The attachments
+	 * @param layouts The layout of each attachment after the render pass
+	 */
+	void set_attachment_accesses(const RenderTarget &render_target, const std::vector<VkImageLayout> &layouts);
+
+	/**
+	 * @brief Records barriers with vkCmdPipelineBarrier2KHR if synchronization2 is used, vkCmdPipelineBarrier otherwise
+	 */
+	void pipeline_barrier(const std::vector<BufferBarrier> &buffer_barriers, const std::vector<ImageBarrier> &image_barriers);
+
+	std::vector<ImageBarrier> get_image_barriers(const std::vector<const core::ImageView *> &image_views, const std::vector<ImageMemoryBarrier> &memory_barriers) const;
 };
 
 template <class T>
 inline void CommandBuffer::set_specialization_constant(uint32_t constant_id, const T &data)
 {
-	set_specialization_constant(constant_id, to_bytes(data));
+	set_specialization_constant(constant_id, reinterpret_cast<const uint8_t *>(&data), sizeof(T));
 }
 
 template <>
 inline void CommandBuffer::set_specialization_constant<bool>(std::uint32_t constant_id, const bool &data)
 {
-	set_specialization_constant(constant_id, to_bytes(to_u32(data)));
+	auto value = to_u32(data);
+	set_specialization_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), sizeof(value));
 }
 }        // namespace vkb
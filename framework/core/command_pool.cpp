@@ -17,6 +17,8 @@
 
 #include "command_pool.h"
 
+#include <algorithm>
+
 #include "device.h"
 #include "rendering/render_frame.h"
 
@@ -189,30 +191,51 @@ CommandBuffer &CommandPool::request_command_buffer(VkCommandBufferLevel level)
 {
 	if (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY)
 	{
-		if (active_primary_command_buffer_count < primary_command_buffers.size())
-		{
-			return *primary_command_buffers.at(active_primary_command_buffer_count++);
-		}
-
-		primary_command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, level));
-
-		active_primary_command_buffer_count++;
-
-		return *primary_command_buffers.back();
+		return request_command_buffer(primary_command_buffers, active_primary_command_buffer_count, level);
 	}
 	else
 	{
-		if (active_secondary_command_buffer_count < secondary_command_buffers.size())
-		{
-			return *secondary_command_buffers.at(active_secondary_command_buffer_count++);
-		}
+		return request_command_buffer(secondary_command_buffers, active_secondary_command_buffer_count, level);
+	}
+}
+
+CommandBuffer &CommandPool::request_command_buffer(std::vector<std::unique_ptr<CommandBuffer>> &command_buffers, uint32_t &active_count, VkCommandBufferLevel level)
+{
+	if (active_count < command_buffers.size())
+	{
+		return *command_buffers.at(active_count++);
+	}
+
+	// Allocating every frame is what the mode measures, the command buffers are allocated one by one
+	uint32_t batch_size = 1;
+	if (reset_mode != CommandBuffer::ResetMode::AlwaysAllocate)
+	{
+		batch_size = std::max(MIN_BATCH_SIZE, to_u32(command_buffers.size()));
+	}
 
-		secondary_command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, level));
+	std::vector<VkCommandBuffer> handles(batch_size, VK_NULL_HANDLE);
 
-		active_secondary_command_buffer_count++;
+	VkCommandBufferAllocateInfo allocate_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
 
-		return *secondary_command_buffers.back();
+	allocate_info.commandPool        = handle;
+	allocate_info.commandBufferCount = batch_size;
+	allocate_info.level              = level;
+
+	VkResult result = vkAllocateCommandBuffers(device.get_handle(), &allocate_info, handles.data());
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Failed to allocate command buffers"};
+	}
+
+	command_buffers.reserve(command_buffers.size() + batch_size);
+
+	for (auto command_buffer_handle : handles)
+	{
+		command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, level, command_buffer_handle));
 	}
+
+	return *command_buffers.at(active_count++);
 }
 
 CommandBuffer::ResetMode const CommandPool::get_reset_mode() const
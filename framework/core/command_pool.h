@@ -59,6 +59,9 @@ class CommandPool
 
 	const CommandBuffer::ResetMode get_reset_mode() const;
 
+	/// Smallest number of command buffers allocated at once, the batches then double with the count of the level
+	static constexpr uint32_t MIN_BATCH_SIZE = 4;
+
   private:
 	Device &device;
 
@@ -81,5 +84,11 @@ class CommandPool
 	CommandBuffer::ResetMode reset_mode{CommandBuffer::ResetMode::ResetPool};
 
 	VkResult reset_command_buffers();
+
+	/**
+	 * @brief Returns the next inactive command buffer of a level, allocating a batch of them with one call when none is left
+	 *        The command buffers are kept across resets with the capacity of their state.
+	 */
+	CommandBuffer &request_command_buffer(std::vector<std::unique_ptr<CommandBuffer>> &command_buffers, uint32_t &active_count, VkCommandBufferLevel level);
 };
 }        // namespace vkb
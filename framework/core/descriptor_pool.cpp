@@ -17,6 +17,8 @@
 
 #include "descriptor_pool.h"
 
+#include <numeric>
+
 #include "common/error.h"
 #include "descriptor_set_layout.h"
 #include "device.h"
@@ -97,6 +99,8 @@ VkDescriptorSet DescriptorPool::allocate()
 {
 	pool_index = find_available_pool(pool_index);
 
+	last_use_frame = device.get_resource_cache().get_frame_index();
+
 	// Increment allocated set count for the current pool
 	++pool_sets_count[pool_index];
 
@@ -153,6 +157,36 @@ VkResult DescriptorPool::free(VkDescriptorSet descriptor_set)
 	return VK_SUCCESS;
 }
 
+size_t DescriptorPool::get_pool_count() const
+{
+	return pools.size();
+}
+
+uint32_t DescriptorPool::get_max_sets_per_pool() const
+{
+	return pool_max_sets;
+}
+
+size_t DescriptorPool::get_allocated_set_count() const
+{
+	return std::accumulate(pool_sets_count.begin(), pool_sets_count.end(), size_t{0});
+}
+
+const std::vector<VkDescriptorPoolSize> &DescriptorPool::get_pool_sizes() const
+{
+	return pool_sizes;
+}
+
+uint64_t DescriptorPool::get_creation_time() const
+{
+	return creation_time;
+}
+
+uint64_t DescriptorPool::get_last_use_frame() const
+{
+	return last_use_frame;
+}
+
 std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
 {
 	// Create a new pool
@@ -21,6 +21,7 @@
 
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
@@ -59,6 +60,36 @@ class DescriptorPool
 
 	VkResult free(VkDescriptorSet descriptor_set);
 
+	/**
+	 * @return The number of VkDescriptorPool created so far
+	 */
+	size_t get_pool_count() const;
+
+	/**
+	 * @return The number of sets each VkDescriptorPool can allocate
+	 */
+	uint32_t get_max_sets_per_pool() const;
+
+	/**
+	 * @return The number of sets currently allocated
+	 */
+	size_t get_allocated_set_count() const;
+
+	/**
+	 * @return The descriptors each VkDescriptorPool is created with
+	 */
+	const std::vector<VkDescriptorPoolSize> &get_pool_sizes() const;
+
+	/**
+	 * @return The time it was created at, on the clock of CpuProfiler::now()
+	 */
+	uint64_t get_creation_time() const;
+
+	/**
+	 * @return The last frame a set was allocated in, see ResourceCache::get_frame_index()
+	 */
+	uint64_t get_last_use_frame() const;
+
   private:
 	Device &device;
 
@@ -82,6 +113,10 @@ class DescriptorPool
 	// Map between descriptor set and pool index
 	std::unordered_map<VkDescriptorSet, uint32_t> set_pool_mapping;
 
+	uint64_t creation_time{CpuProfiler::now()};
+
+	uint64_t last_use_frame{0};
+
 	// Find next pool index or create new pool
 	uint32_t find_available_pool(uint32_t pool_index);
 };
@@ -148,7 +148,7 @@ void DescriptorSet::prepare()
 	}
 }
 
-void DescriptorSet::update(const std::vector<uint32_t> &bindings_to_update)
+void DescriptorSet::update(const ArenaVector<uint32_t> &bindings_to_update)
 {
 	std::vector<VkWriteDescriptorSet> write_operations;
 
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "common/helpers.h"
+#include "common/linear_allocator.h"
 #include "common/vk_common.h"
 
 namespace vkb
@@ -74,7 +75,7 @@ class DescriptorSet
 	 * @brief Updates the contents of the DescriptorSet by performing the write operations
 	 * @param bindings_to_update If empty. we update all bindings. Otherwise, only write the specified bindings if they haven't already been written
 	 */
-	void update(const std::vector<uint32_t> &bindings_to_update = {});
+	void update(const ArenaVector<uint32_t> &bindings_to_update = {});
 
 	const DescriptorSetLayout &get_layout() const;
 
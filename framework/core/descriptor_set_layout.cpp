@@ -64,6 +64,9 @@ inline VkDescriptorType find_descriptor_type(ShaderResourceType resource_type, b
 				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 			}
 			break;
+		case ShaderResourceType::AccelerationStructure:
+			return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			break;
 		default:
 			throw std::runtime_error("No conversion possible for the shader resource type.");
 			break;
@@ -96,7 +99,8 @@ inline bool validate_flags(const PhysicalDevice &gpu, const std::vector<VkDescri
 
 DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_index, const std::vector<ShaderResource> &resource_set) :
     device{device},
-    set_index{set_index}
+    set_index{set_index},
+    descriptor_buffer{device.uses_descriptor_buffers()}
 {
 	for (auto &resource : resource_set)
 	{
@@ -110,9 +114,11 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_inde
 		}
 
 		// Convert from ShaderResourceType to VkDescriptorType.
-		auto descriptor_type = find_descriptor_type(resource.type, resource.mode == ShaderResourceMode::Dynamic);
+		// Descriptor buffers have no dynamic descriptors, the offsets are written in the descriptors instead
+		auto descriptor_type = find_descriptor_type(resource.type, resource.mode == ShaderResourceMode::Dynamic && !descriptor_buffer);
 
-		if (resource.mode == ShaderResourceMode::UpdateAfterBind)
+		// Descriptors in a descriptor buffer may always be written after they are bound
+		if (resource.mode == ShaderResourceMode::UpdateAfterBind && !descriptor_buffer)
 		{
 			binding_flags.push_back(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT);
 		}
@@ -147,6 +153,14 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_inde
 	create_info.bindingCount = to_u32(bindings.size());
 	create_info.pBindings    = bindings.data();
 
+#ifdef VK_EXT_descriptor_buffer
+	// Neither update-after-bind pools nor push descriptors apply to the sets of a descriptor buffer
+	if (descriptor_buffer)
+	{
+		create_info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+	}
+#endif
+
 	// Handle update-after-bind extensions
 	if (std::find_if(resource_set.begin(), resource_set.end(),
 	                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::UpdateAfterBind; }) != resource_set.end())
@@ -171,6 +185,22 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_inde
 		create_info.flags |= std::find(binding_flags.begin(), binding_flags.end(), VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) != binding_flags.end() ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0;
 	}
 
+	// A single push descriptor resource makes the whole set pushed, so it is never allocated from a pool
+	if (!descriptor_buffer &&
+	    std::find_if(resource_set.begin(), resource_set.end(),
+	                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::PushDescriptor; }) != resource_set.end())
+	{
+		if (std::find_if(resource_set.begin(), resource_set.end(),
+		                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::Dynamic || shader_resource.mode == ShaderResourceMode::UpdateAfterBind; }) != resource_set.end())
+		{
+			throw std::runtime_error("Cannot create descriptor set layout, dynamic and update-after-bind resources are not allowed in a push descriptor set.");
+		}
+
+		create_info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+
+		push_descriptor = true;
+	}
+
 	// Create the Vulkan descriptor set layout handle
 	VkResult result = vkCreateDescriptorSetLayout(device.get_handle(), &create_info, nullptr, &handle);
 
@@ -178,6 +208,21 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_inde
 	{
 		throw VulkanException{result, "Cannot create DescriptorSetLayout"};
 	}
+
+#ifdef VK_EXT_descriptor_buffer
+	if (descriptor_buffer)
+	{
+		vkGetDescriptorSetLayoutSizeEXT(device.get_handle(), handle, &descriptor_buffer_size);
+
+		for (auto &binding : bindings)
+		{
+			VkDeviceSize offset{0};
+			vkGetDescriptorSetLayoutBindingOffsetEXT(device.get_handle(), handle, binding.binding, &offset);
+
+			descriptor_buffer_offsets.emplace(binding.binding, offset);
+		}
+	}
+#endif
 }
 
 DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
@@ -188,7 +233,11 @@ DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
     binding_flags{std::move(other.binding_flags)},
     bindings_lookup{std::move(other.bindings_lookup)},
     binding_flags_lookup{std::move(other.binding_flags_lookup)},
-    resources_lookup{std::move(other.resources_lookup)}
+    resources_lookup{std::move(other.resources_lookup)},
+    push_descriptor{other.push_descriptor},
+    descriptor_buffer{other.descriptor_buffer},
+    descriptor_buffer_size{other.descriptor_buffer_size},
+    descriptor_buffer_offsets{std::move(other.descriptor_buffer_offsets)}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -258,4 +307,28 @@ VkDescriptorBindingFlagsEXT DescriptorSetLayout::get_layout_binding_flag(const u
 	return it->second;
 }
 
+bool DescriptorSetLayout::is_push_descriptor() const
+{
+	return push_descriptor;
+}
+
+bool DescriptorSetLayout::is_descriptor_buffer() const
+{
+	return descriptor_buffer;
+}
+
+VkDeviceSize DescriptorSetLayout::get_descriptor_buffer_size() const
+{
+	return descriptor_buffer_size;
+}
+
+VkDeviceSize DescriptorSetLayout::get_descriptor_buffer_offset(uint32_t binding_index) const
+{
+	auto it = descriptor_buffer_offsets.find(binding_index);
+
+	assert(it != descriptor_buffer_offsets.end() && "Binding not in the descriptor set layout");
+
+	return it->second;
+}
+
 }        // namespace vkb
@@ -66,6 +66,26 @@ class DescriptorSetLayout
 
 	VkDescriptorBindingFlagsEXT get_layout_binding_flag(const uint32_t binding_index) const;
 
+	/**
+	 * @return True if the set is pushed into command buffers with vkCmdPushDescriptorSetKHR
+	 */
+	bool is_push_descriptor() const;
+
+	/**
+	 * @return True if the descriptors of the set are written into a descriptor buffer, see Device::uses_descriptor_buffers()
+	 */
+	bool is_descriptor_buffer() const;
+
+	/**
+	 * @return The size in bytes of the descriptors of the set in a descriptor buffer
+	 */
+	VkDeviceSize get_descriptor_buffer_size() const;
+
+	/**
+	 * @return The offset in bytes of the descriptors of a binding from the start of the set in a descriptor buffer
+	 */
+	VkDeviceSize get_descriptor_buffer_offset(uint32_t binding_index) const;
+
   private:
 	Device &device;
 
@@ -82,5 +102,13 @@ class DescriptorSetLayout
 	std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT> binding_flags_lookup;
 
 	std::unordered_map<std::string, uint32_t> resources_lookup;
+
+	bool push_descriptor{false};
+
+	bool descriptor_buffer{false};
+
+	VkDeviceSize descriptor_buffer_size{0};
+
+	std::unordered_map<uint32_t, VkDeviceSize> descriptor_buffer_offsets;
 };
 }        // namespace vkb
@@ -18,6 +18,10 @@
 
 #include "device.h"
 
+#include <algorithm>
+
+#include "common/debug_utils.h"
+
 VKBP_DISABLE_WARNINGS()
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
@@ -27,7 +31,8 @@ namespace vkb
 {
 Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<const char *, bool> requested_extensions) :
     gpu{gpu},
-    resource_cache{*this}
+    resource_cache{*this},
+    memory_defragmenter{*this}
 {
 	LOGI("Selected GPU: {}", gpu.get_properties().deviceName);
 
@@ -50,10 +55,7 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 	}
 
 	// Check extensions to enable Vma Dedicated Allocation
-	uint32_t device_extension_count;
-	VK_CHECK(vkEnumerateDeviceExtensionProperties(gpu.get_handle(), nullptr, &device_extension_count, nullptr));
-	device_extensions = std::vector<VkExtensionProperties>(device_extension_count);
-	VK_CHECK(vkEnumerateDeviceExtensionProperties(gpu.get_handle(), nullptr, &device_extension_count, device_extensions.data()));
+	device_extensions = gpu.get_extension_properties();
 
 	// Display supported extensions
 	if (device_extensions.size() > 0)
@@ -65,6 +67,9 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		}
 	}
 
+	// Debug labels are only recorded when a tool is there to show them
+	debug_utils::detect_capture_tools(gpu.get_handle(), is_extension_supported("VK_EXT_tooling_info"));
+
 	bool can_get_memory_requirements = is_extension_supported("VK_KHR_get_memory_requirements2");
 	bool has_dedicated_allocation    = is_extension_supported("VK_KHR_dedicated_allocation");
 
@@ -92,6 +97,229 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		}
 	}
 
+	// The memory budget reports the actual budgets of the heaps, instead of estimates based on their size
+	bool has_memory_budget = is_extension_supported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) &&
+	                         gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
+	if (has_memory_budget)
+	{
+		enabled_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		LOGI("Memory budget enabled");
+	}
+
+	// Timeline semaphores let render frames track their submissions with a counter instead of fences
+	if (is_extension_supported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto timeline_semaphore_features = gpu.request_extension_features<VkPhysicalDeviceTimelineSemaphoreFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR);
+
+		if (timeline_semaphore_features.timelineSemaphore)
+		{
+			enabled_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			LOGI("Timeline semaphores enabled");
+		}
+	}
+
+#ifdef VK_EXT_graphics_pipeline_library
+	// Pipeline libraries let the resource cache link pipelines from separately cached parts
+	if (is_extension_supported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+	    is_extension_supported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+	{
+		auto pipeline_library_features = gpu.request_extension_features<VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT);
+
+		if (pipeline_library_features.graphicsPipelineLibrary)
+		{
+			enabled_extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+			LOGI("Graphics pipeline library enabled");
+		}
+	}
+#endif
+
+#ifdef VK_KHR_synchronization2
+	// Lets the render context submit a frame with vkQueueSubmit2KHR, timeline values included in the semaphore infos
+	if (is_extension_supported(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto synchronization2_features = gpu.request_extension_features<VkPhysicalDeviceSynchronization2FeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR);
+
+		if (synchronization2_features.synchronization2)
+		{
+			enabled_extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+			LOGI("Synchronization2 enabled");
+		}
+	}
+#endif
+
+#ifdef VK_EXT_pageable_device_local_memory
+	// Lets the allocations be paged out of device local memory by their priority when it is oversubscribed,
+	// instead of the driver evicting whole allocations at random
+	if (is_extension_supported(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME) &&
+	    is_extension_supported(VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto memory_priority_features = gpu.request_extension_features<VkPhysicalDeviceMemoryPriorityFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PRIORITY_FEATURES_EXT);
+		auto pageable_memory_features = gpu.request_extension_features<VkPhysicalDevicePageableDeviceLocalMemoryFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PAGEABLE_DEVICE_LOCAL_MEMORY_FEATURES_EXT);
+
+		if (memory_priority_features.memoryPriority && pageable_memory_features.pageableDeviceLocalMemory)
+		{
+			enabled_extensions.push_back(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME);
+			LOGI("Pageable device local memory enabled");
+		}
+	}
+#endif
+
+#ifdef VK_EXT_image_compression_control
+	// Lets the attachments request a fixed-rate compression, or no compression
+	if (is_extension_supported(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto compression_control_features = gpu.request_extension_features<VkPhysicalDeviceImageCompressionControlFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_COMPRESSION_CONTROL_FEATURES_EXT);
+
+		if (compression_control_features.imageCompressionControl)
+		{
+			enabled_extensions.push_back(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME);
+			LOGI("Image compression control enabled");
+		}
+	}
+#endif
+
+#ifdef VK_KHR_dynamic_rendering
+	// Lets the render pipeline record its subpasses without render pass and framebuffer objects
+	if (is_extension_supported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_MULTIVIEW_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_MAINTENANCE2_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto dynamic_rendering_features = gpu.request_extension_features<VkPhysicalDeviceDynamicRenderingFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR);
+
+		if (dynamic_rendering_features.dynamicRendering)
+		{
+			// The device is created with a 1.0 API version, so the extensions it depends on are enabled too
+			enabled_extensions.push_back(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			LOGI("Dynamic rendering enabled");
+		}
+	}
+#endif
+
+#ifdef VK_KHR_fragment_shading_rate
+	// Lets subpasses shade several pixels per fragment, from the pipeline or from a shading rate attachment
+	if (is_extension_supported(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_MULTIVIEW_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_MAINTENANCE2_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto shading_rate_features = gpu.request_extension_features<VkPhysicalDeviceFragmentShadingRateFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR);
+
+		if (shading_rate_features.pipelineFragmentShadingRate && shading_rate_features.attachmentFragmentShadingRate)
+		{
+			// Shading rate attachments are only referenced by VkSubpassDescription2
+			if (!is_enabled(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME))
+			{
+				enabled_extensions.push_back(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+				enabled_extensions.push_back(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
+				enabled_extensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+			}
+
+			enabled_extensions.push_back(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+			LOGI("Fragment shading rate enabled");
+		}
+	}
+#endif
+
+#if defined(VK_KHR_present_id) && defined(VK_KHR_present_wait)
+	// Lets the render context wait until a presented image is displayed, only with a surface to present to
+	if (surface != VK_NULL_HANDLE &&
+	    is_extension_supported(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto present_id_features   = gpu.request_extension_features<VkPhysicalDevicePresentIdFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR);
+		auto present_wait_features = gpu.request_extension_features<VkPhysicalDevicePresentWaitFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR);
+
+		if (present_id_features.presentId && present_wait_features.presentWait)
+		{
+			enabled_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+			LOGI("Present wait enabled");
+		}
+	}
+#endif
+
+#ifdef VK_EXT_swapchain_maintenance1
+	// Lets the swapchain switch present modes at present time and release acquired images
+	if (surface != VK_NULL_HANDLE &&
+	    is_extension_supported(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto swapchain_maintenance_features = gpu.request_extension_features<VkPhysicalDeviceSwapchainMaintenance1FeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SWAPCHAIN_MAINTENANCE_1_FEATURES_EXT);
+
+		if (swapchain_maintenance_features.swapchainMaintenance1)
+		{
+			enabled_extensions.push_back(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
+			LOGI("Swapchain maintenance enabled");
+		}
+	}
+#endif
+
+#ifdef VK_EXT_display_control
+	// Lets the render context wait for the refresh cycles of a direct-to-display surface and count them
+	if (surface != VK_NULL_HANDLE &&
+	    is_extension_supported(VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_EXT_DISPLAY_SURFACE_COUNTER_EXTENSION_NAME))
+	{
+		enabled_extensions.push_back(VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME);
+		LOGI("Display control enabled");
+	}
+#endif
+
+#ifdef VK_GOOGLE_display_timing
+	// Lets the render context schedule its presentations and read back when they were displayed
+	if (surface != VK_NULL_HANDLE && is_extension_supported(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME))
+	{
+		enabled_extensions.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+		LOGI("Display timing enabled");
+	}
+#endif
+
+#ifdef VK_EXT_descriptor_buffer
+	// Lets the command buffers write descriptors straight into buffers, only when the sample asks for it,
+	// as every descriptor set layout and pipeline is created for descriptor buffers then
+	auto is_requested = [&requested_extensions](const char *name) {
+		return std::find_if(requested_extensions.begin(), requested_extensions.end(),
+		                    [name](const std::pair<const char *const, bool> &extension) { return std::strcmp(extension.first, name) == 0; }) != requested_extensions.end();
+	};
+
+	if (is_requested(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) &&
+	    is_requested(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME) &&
+	    is_extension_supported(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto descriptor_buffer_features     = gpu.request_extension_features<VkPhysicalDeviceDescriptorBufferFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT);
+		auto buffer_device_address_features = gpu.request_extension_features<VkPhysicalDeviceBufferDeviceAddressFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR);
+
+		if (descriptor_buffer_features.descriptorBuffer && buffer_device_address_features.bufferDeviceAddress)
+		{
+			VkPhysicalDeviceProperties2KHR properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR};
+			properties.pNext = &descriptor_buffer_properties;
+			vkGetPhysicalDeviceProperties2KHR(gpu.get_handle(), &properties);
+
+			descriptor_buffers = true;
+			LOGI("Descriptor buffers enabled");
+		}
+	}
+#endif
+
 	// Check that extensions are supported before trying to create the device
 	std::vector<const char *> unsupported_extensions{};
 	for (auto &extension : requested_extensions)
@@ -138,11 +366,38 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		}
 	}
 
+	// Views are rendered by the subpasses whether the sample or one of the extensions above enabled multiview
+	if (is_enabled(VK_KHR_MULTIVIEW_EXTENSION_NAME) &&
+	    gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto multiview_features = gpu.request_extension_features<VkPhysicalDeviceMultiviewFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES_KHR);
+
+		multiview = multiview_features.multiview == VK_TRUE;
+	}
+
 	VkDeviceCreateInfo create_info{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
 
 	// Latest requested feature will have the pNext's all set up for device creation.
 	create_info.pNext = gpu.get_extension_feature_chain();
 
+	// Memory is then allocated on every GPU of the group, and submissions run on the GPUs of their device mask
+	VkDeviceGroupDeviceCreateInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_DEVICE_CREATE_INFO_KHR};
+
+	auto &device_group = gpu.get_device_group();
+
+	if (is_enabled(VK_KHR_DEVICE_GROUP_EXTENSION_NAME) && device_group.size() > 1)
+	{
+		device_group_info.physicalDeviceCount = to_u32(device_group.size());
+		device_group_info.pPhysicalDevices    = device_group.data();
+		device_group_info.pNext               = create_info.pNext;
+
+		create_info.pNext = &device_group_info;
+
+		physical_device_count = to_u32(device_group.size());
+
+		LOGI("Device created over {} GPUs", physical_device_count);
+	}
+
 	create_info.pQueueCreateInfos       = queue_create_infos.data();
 	create_info.queueCreateInfoCount    = to_u32(queue_create_infos.size());
 	create_info.enabledExtensionCount   = to_u32(enabled_extensions.size());
@@ -158,6 +413,9 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		throw VulkanException{result, "Cannot create device"};
 	}
 
+	// Load the device functions straight from the driver, the global ones go through the loader's trampolines
+	volkLoadDeviceTable(&table, handle);
+
 	queues.resize(queue_family_properties_count);
 
 	for (uint32_t queue_family_index = 0U; queue_family_index < queue_family_properties_count; ++queue_family_index)
@@ -214,6 +472,12 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		allocator_info.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 	}
 
+	if (has_memory_budget)
+	{
+		allocator_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+		vma_vulkan_func.vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR;
+	}
+
 	allocator_info.pVulkanFunctions = &vma_vulkan_func;
 
 	result = vmaCreateAllocator(&allocator_info, &memory_allocator);
@@ -230,6 +494,8 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 Device::~Device()
 {
 	resource_cache.clear();
+	asset_cache.clear();
+	deletion_queue.clear();
 
 	command_pool.reset();
 	fence_pool.reset();
@@ -263,6 +529,57 @@ bool Device::is_enabled(const char *extension)
 	return std::find_if(enabled_extensions.begin(), enabled_extensions.end(), [extension](const char *enabled_extension) { return strcmp(extension, enabled_extension) == 0; }) != enabled_extensions.end();
 }
 
+bool Device::uses_descriptor_buffers() const
+{
+	return descriptor_buffers;
+}
+
+bool Device::supports_multiview() const
+{
+	return multiview;
+}
+
+uint32_t Device::get_physical_device_count() const
+{
+	return physical_device_count;
+}
+
+#ifdef VK_EXT_descriptor_buffer
+const VkPhysicalDeviceDescriptorBufferPropertiesEXT &Device::get_descriptor_buffer_properties() const
+{
+	return descriptor_buffer_properties;
+}
+
+size_t Device::get_descriptor_size(VkDescriptorType type) const
+{
+	switch (type)
+	{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			return descriptor_buffer_properties.samplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return descriptor_buffer_properties.combinedImageSamplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			return descriptor_buffer_properties.sampledImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			return descriptor_buffer_properties.storageImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+			return descriptor_buffer_properties.uniformTexelBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			return descriptor_buffer_properties.storageTexelBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			return descriptor_buffer_properties.uniformBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			return descriptor_buffer_properties.storageBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return descriptor_buffer_properties.inputAttachmentDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+			return descriptor_buffer_properties.accelerationStructureDescriptorSize;
+		default:
+			throw std::runtime_error("Descriptor type not supported in descriptor buffers");
+	}
+}
+#endif
+
 const PhysicalDevice &Device::get_gpu() const
 {
 	return gpu;
@@ -273,6 +590,11 @@ VkDevice Device::get_handle() const
 	return handle;
 }
 
+const VolkDeviceTable &Device::get_table() const
+{
+	return table;
+}
+
 VmaAllocator Device::get_memory_allocator() const
 {
 	return memory_allocator;
@@ -575,6 +897,8 @@ void Device::flush_command_buffer(VkCommandBuffer command_buffer, VkQueue queue,
 	VkFence fence;
 	VK_CHECK(vkCreateFence(handle, &fence_info, nullptr, &fence));
 
+	flush_deferred_writes();
+
 	// Submit to the queue
 	VkResult result = vkQueueSubmit(queue, 1, &submit_info, fence);
 	// Wait for the fence to signal that command buffer has finished executing
@@ -610,11 +934,234 @@ VkFence Device::request_fence()
 
 VkResult Device::wait_idle()
 {
-	return vkDeviceWaitIdle(handle);
+	VkResult result = vkDeviceWaitIdle(handle);
+
+	if (result == VK_SUCCESS)
+	{
+		deletion_queue.complete_all();
+	}
+
+	return result;
 }
 
 ResourceCache &Device::get_resource_cache()
 {
 	return resource_cache;
 }
+
+AssetCache &Device::get_asset_cache()
+{
+	return asset_cache;
+}
+
+MemoryDefragmenter &Device::get_memory_defragmenter()
+{
+	return memory_defragmenter;
+}
+
+DeletionQueue &Device::get_deletion_queue()
+{
+	return deletion_queue;
+}
+
+void Device::set_attachment_compression(core::ImageCompressionPolicy policy)
+{
+#ifdef VK_EXT_image_compression_control
+	if (policy != core::ImageCompressionPolicy::Default && !is_enabled(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME))
+	{
+		LOGW("Attachment compression requested but {} is not enabled, using the default compression", VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME);
+		policy = core::ImageCompressionPolicy::Default;
+	}
+
+	compression_control       = {VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT};
+	compression_control.flags = policy == core::ImageCompressionPolicy::FixedRate ? VK_IMAGE_COMPRESSION_FIXED_RATE_DEFAULT_EXT : VK_IMAGE_COMPRESSION_DISABLED_EXT;
+#else
+	if (policy != core::ImageCompressionPolicy::Default)
+	{
+		LOGW("Attachment compression requested but the Vulkan headers do not have VK_EXT_image_compression_control, using the default compression");
+		policy = core::ImageCompressionPolicy::Default;
+	}
+#endif
+
+	attachment_compression = policy;
+}
+
+core::ImageCompressionPolicy Device::get_attachment_compression() const
+{
+	return attachment_compression;
+}
+
+const void *Device::get_compression_control(VkImageUsageFlags usage) const
+{
+	if (attachment_compression == core::ImageCompressionPolicy::Default ||
+	    !(usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)))
+	{
+		return nullptr;
+	}
+
+#ifdef VK_EXT_image_compression_control
+	return &compression_control;
+#else
+	return nullptr;
+#endif
+}
+
+void Device::set_allocation_policy(const AllocationPolicy &policy)
+{
+	allocation_policy = policy;
+}
+
+const AllocationPolicy &Device::get_allocation_policy() const
+{
+	return allocation_policy;
+}
+
+float Device::prepare_image_allocation(const VkImageCreateInfo &image_info, VmaAllocationCreateInfo &memory_info) const
+{
+	bool attachment = (image_info.usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) != 0;
+
+	// Lazily allocated attachments may never be backed by memory
+	if (attachment && !(image_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT))
+	{
+		VkDeviceSize texels = static_cast<VkDeviceSize>(image_info.extent.width) * image_info.extent.height * image_info.extent.depth *
+		                      image_info.arrayLayers * image_info.samples;
+
+		// Large render targets do not share a block with resources the driver could evict along with them
+		if (texels >= allocation_policy.dedicated_attachment_texels)
+		{
+			memory_info.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+		}
+	}
+
+	return attachment ? allocation_policy.attachment_priority : allocation_policy.image_priority;
+}
+
+void Device::set_memory_priority(VmaAllocation allocation, float priority)
+{
+#ifdef VK_EXT_pageable_device_local_memory
+	if (!is_enabled(VK_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(memory_allocator, allocation, &allocation_info);
+
+	vkSetDeviceMemoryPriorityEXT(handle, allocation_info.deviceMemory, std::min(std::max(priority, 0.0f), 1.0f));
+#endif
+}
+
+void Device::set_memory_budget_warning(float fraction)
+{
+	memory_budget_warning = fraction;
+}
+
+void Device::check_memory_budget(VmaAllocation allocation, const char *name)
+{
+	if (memory_budget_warning <= 0.0f)
+	{
+		return;
+	}
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(memory_allocator, allocation, &allocation_info);
+
+	const VkPhysicalDeviceMemoryProperties *memory_properties{nullptr};
+	vmaGetMemoryProperties(memory_allocator, &memory_properties);
+
+	auto heap_index = memory_properties->memoryTypes[allocation_info.memoryType].heapIndex;
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+	vmaGetBudget(memory_allocator, budgets);
+
+	const auto &budget = budgets[heap_index];
+
+	bool over_budget = budget.budget > 0 && budget.usage > memory_budget_warning * budget.budget;
+
+	uint32_t heap_bit = 1u << heap_index;
+
+	std::lock_guard<std::mutex> guard(memory_budget_mutex);
+
+	if (over_budget && (heaps_over_budget & heap_bit) == 0)
+	{
+		LOGW("{} allocation pushed memory heap {} to {} MiB, above {:.0f}% of its {} MiB budget",
+		     name, heap_index, budget.usage / (1024 * 1024), memory_budget_warning * 100.0f, budget.budget / (1024 * 1024));
+
+		heaps_over_budget |= heap_bit;
+	}
+	else if (!over_budget)
+	{
+		heaps_over_budget &= ~heap_bit;
+	}
+}
+
+void Device::set_deferred_flushes(bool enabled)
+{
+	if (!enabled)
+	{
+		flush_deferred_writes();
+	}
+
+	deferred_flushes = enabled;
+}
+
+bool Device::is_deferring_flushes() const
+{
+	return deferred_flushes;
+}
+
+void Device::defer_flush(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	std::lock_guard<std::mutex> guard(deferred_flush_mutex);
+
+	auto it = pending_flushes.find(&buffer);
+	if (it == pending_flushes.end())
+	{
+		pending_flushes.emplace(&buffer, std::make_pair(offset, offset + size));
+	}
+	else
+	{
+		it->second.first  = std::min(it->second.first, offset);
+		it->second.second = std::max(it->second.second, offset + size);
+	}
+}
+
+void Device::cancel_deferred_flush(const core::Buffer &buffer)
+{
+	std::lock_guard<std::mutex> guard(deferred_flush_mutex);
+
+	pending_flushes.erase(&buffer);
+}
+
+bool Device::take_deferred_flush(const core::Buffer &buffer, VkDeviceSize &offset, VkDeviceSize &size)
+{
+	std::lock_guard<std::mutex> guard(deferred_flush_mutex);
+
+	auto it = pending_flushes.find(&buffer);
+	if (it == pending_flushes.end())
+	{
+		return false;
+	}
+
+	offset = it->second.first;
+	size   = it->second.second - it->second.first;
+
+	pending_flushes.erase(it);
+
+	return true;
+}
+
+void Device::flush_deferred_writes()
+{
+	std::lock_guard<std::mutex> guard(deferred_flush_mutex);
+
+	// The VMA version in use has no vmaFlushAllocations, the merged range of each buffer is flushed on its own
+	for (auto &pending_flush : pending_flushes)
+	{
+		const auto &range = pending_flush.second;
+		vmaFlushAllocation(memory_allocator, pending_flush.first->get_allocation(), range.first, range.second - range.first);
+	}
+
+	pending_flushes.clear();
+}
 }        // namespace vkb
@@ -18,6 +18,10 @@
 
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
+
+#include "asset_cache.h"
 #include "common/helpers.h"
 #include "common/logging.h"
 #include "common/vk_common.h"
@@ -35,7 +39,9 @@
 #include "core/render_pass.h"
 #include "core/shader_module.h"
 #include "core/swapchain.h"
+#include "deletion_queue.h"
 #include "fence_pool.h"
+#include "memory_defragmenter.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_cache.h"
@@ -49,6 +55,28 @@ struct DriverVersion
 	uint16_t patch;
 };
 
+/**
+ * @brief How the device memory of images and buffers is allocated, by usage
+ *
+ * Priorities range from 0 to 1, the driver moves the lowest priority allocations out of device local
+ * memory first when it is oversubscribed. They apply to the allocations with their own device memory,
+ * with VK_EXT_pageable_device_local_memory, as the other allocations share their memory blocks.
+ */
+struct AllocationPolicy
+{
+	/// Attachments with at least this many texels, counting samples and layers, get their own device memory, zero for all of them
+	VkDeviceSize dedicated_attachment_texels{1024 * 1024};
+
+	/// Priority of color and depth stencil attachments, the ones evicted at the cost of a stutter
+	float attachment_priority{1.0f};
+
+	/// Priority of the other images, such as textures which can be streamed again
+	float image_priority{0.5f};
+
+	/// Priority of the buffers allocated with VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+	float buffer_priority{0.5f};
+};
+
 class Device
 {
   public:
@@ -74,6 +102,11 @@ class Device
 
 	VkDevice get_handle() const;
 
+	/**
+	 * @return The device level function pointers of this device, calls through them skip the dispatch of the loader
+	 */
+	const VolkDeviceTable &get_table() const;
+
 	VmaAllocator get_memory_allocator() const;
 
 	/**
@@ -102,6 +135,32 @@ class Device
 
 	bool is_enabled(const char *extension);
 
+	/**
+	 * @return Whether the command buffers write descriptors into descriptor buffers instead of descriptor sets,
+	 *         when the sample requests VK_EXT_descriptor_buffer and VK_KHR_buffer_device_address
+	 */
+	bool uses_descriptor_buffers() const;
+
+	/**
+	 * @return Whether subpasses can render several views, when VK_KHR_multiview is enabled and its multiview feature supported
+	 */
+	bool supports_multiview() const;
+
+	/**
+	 * @return The number of GPUs of the device, more than one when the sample requests VK_KHR_device_group
+	 *         and created the device over the device group of its GPU, see PhysicalDevice::get_device_group()
+	 */
+	uint32_t get_physical_device_count() const;
+
+#ifdef VK_EXT_descriptor_buffer
+	const VkPhysicalDeviceDescriptorBufferPropertiesEXT &get_descriptor_buffer_properties() const;
+
+	/**
+	 * @return The size in bytes of a descriptor of a type in a descriptor buffer
+	 */
+	size_t get_descriptor_size(VkDescriptorType type) const;
+#endif
+
 	uint32_t get_queue_family_index(VkQueueFlagBits queue_flag);
 
 	CommandPool &get_command_pool();
@@ -177,6 +236,103 @@ class Device
 
 	ResourceCache &get_resource_cache();
 
+	/**
+	 * @return The Vulkan objects of the assets shared by the scenes loaded on the device
+	 */
+	AssetCache &get_asset_cache();
+
+	/**
+	 * @return The defragmenter of the buffers allocated on the device, disabled by default
+	 */
+	MemoryDefragmenter &get_memory_defragmenter();
+
+	/**
+	 * @return The queue destroying the objects retired by the caches once the frames using them have completed
+	 */
+	DeletionQueue &get_deletion_queue();
+
+	/**
+	 * @brief Sets the compression of the images created next with a color or depth attachment usage
+	 *        The images created before keep their compression, so render targets should be created again.
+	 *        Ignored if the device does not have VK_EXT_image_compression_control enabled.
+	 */
+	void set_attachment_compression(core::ImageCompressionPolicy policy);
+
+	core::ImageCompressionPolicy get_attachment_compression() const;
+
+	/**
+	 * @return The structure to chain to the create info of an image with a usage, for the attachment compression,
+	 *         nullptr for the default compression
+	 */
+	const void *get_compression_control(VkImageUsageFlags usage) const;
+
+	/**
+	 * @brief Sets how the images and buffers created next are allocated
+	 */
+	void set_allocation_policy(const AllocationPolicy &policy);
+
+	const AllocationPolicy &get_allocation_policy() const;
+
+	/**
+	 * @brief Adds the flags of the allocation policy to the allocation of an image
+	 * @return The priority of the image memory
+	 */
+	float prepare_image_allocation(const VkImageCreateInfo &image_info, VmaAllocationCreateInfo &memory_info) const;
+
+	/**
+	 * @brief Sets the priority of an allocation with its own device memory
+	 *        Ignored if the device does not have VK_EXT_pageable_device_local_memory enabled.
+	 */
+	void set_memory_priority(VmaAllocation allocation, float priority);
+
+	/**
+	 * @brief Sets the fraction of a heap's budget above which new allocations log a warning
+	 * @param fraction Fraction of the budget, zero to disable the warnings
+	 */
+	void set_memory_budget_warning(float fraction);
+
+	/**
+	 * @brief Logs a warning if the heap of an allocation is used above the warning fraction of its budget
+	 *        Each heap warns once, until its usage drops back under the fraction.
+	 * @param allocation The allocation which was just made
+	 * @param name What the allocation is for, shown in the warning
+	 */
+	void check_memory_budget(VmaAllocation allocation, const char *name);
+
+	/**
+	 * @brief Sets whether the flushes of the buffer writes to non-coherent memory wait for the next queue submission
+	 *        The ranges written to a buffer are then merged and flushed once, by core::Queue::submit() and flush_command_buffer().
+	 *        Code submitting with vkQueueSubmit directly must call flush_deferred_writes() first, or leave it disabled.
+	 *        Disabling flushes the pending writes.
+	 */
+	void set_deferred_flushes(bool enabled);
+
+	bool is_deferring_flushes() const;
+
+	/**
+	 * @brief Records a range written to a persistently mapped buffer, to flush with flush_deferred_writes()
+	 */
+	void defer_flush(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size);
+
+	/**
+	 * @brief Drops the pending flush of a buffer, when it is destroyed or moved
+	 */
+	void cancel_deferred_flush(const core::Buffer &buffer);
+
+	/**
+	 * @brief Removes the pending flush of a buffer, so that a buffer it is moved to can take it over
+	 * @param buffer The buffer whose flush is removed
+	 * @param offset Set to the offset of the pending range
+	 * @param size Set to the size of the pending range
+	 * @return Whether the buffer had a pending flush
+	 */
+	bool take_deferred_flush(const core::Buffer &buffer, VkDeviceSize &offset, VkDeviceSize &size);
+
+	/**
+	 * @brief Flushes the ranges written since the last call, one flush per buffer
+	 */
+	void flush_deferred_writes();
+
   private:
 	const PhysicalDevice &gpu;
 
@@ -184,12 +340,28 @@ class Device
 
 	VkDevice handle{VK_NULL_HANDLE};
 
+	VolkDeviceTable table{};
+
 	std::vector<VkExtensionProperties> device_extensions;
 
 	std::vector<const char *> enabled_extensions{};
 
 	VmaAllocator memory_allocator{VK_NULL_HANDLE};
 
+	float memory_budget_warning{0.9f};
+
+	std::mutex memory_budget_mutex;
+
+	/// One bit per heap currently used above the warning fraction
+	uint32_t heaps_over_budget{0};
+
+	bool deferred_flushes{false};
+
+	std::mutex deferred_flush_mutex;
+
+	/// Range written to each buffer since the last flush, as its begin and end offsets
+	std::unordered_map<const core::Buffer *, std::pair<VkDeviceSize, VkDeviceSize>> pending_flushes;
+
 	std::vector<std::vector<Queue>> queues;
 
 	/// A command pool associated to the primary queue
@@ -199,5 +371,29 @@ class Device
 	std::unique_ptr<FencePool> fence_pool;
 
 	ResourceCache resource_cache;
+
+	AssetCache asset_cache;
+
+	MemoryDefragmenter memory_defragmenter;
+
+	DeletionQueue deletion_queue;
+
+	core::ImageCompressionPolicy attachment_compression{core::ImageCompressionPolicy::Default};
+
+	AllocationPolicy allocation_policy;
+
+	bool descriptor_buffers{false};
+
+	bool multiview{false};
+
+	uint32_t physical_device_count{1};
+
+#ifdef VK_EXT_descriptor_buffer
+	VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptor_buffer_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+#endif
+
+#ifdef VK_EXT_image_compression_control
+	VkImageCompressionControlEXT compression_control{VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT};
+#endif
 };
 }        // namespace vkb
@@ -103,6 +103,9 @@ Image::Image(Device &              device,
 	image_info.tiling      = tiling;
 	image_info.usage       = image_usage;
 
+	// Attachments follow the compression policy of the device
+	image_info.pNext = device.get_compression_control(image_usage);
+
 	VmaAllocationCreateInfo memory_info{};
 	memory_info.usage = memory_usage;
 
@@ -111,6 +114,8 @@ Image::Image(Device &              device,
 		memory_info.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
 	}
 
+	float priority = device.prepare_image_allocation(image_info, memory_info);
+
 	auto result = vmaCreateImage(device.get_memory_allocator(),
 	                             &image_info, &memory_info,
 	                             &handle, &memory,
@@ -120,6 +125,13 @@ Image::Image(Device &              device,
 	{
 		throw VulkanException{result, "Cannot create Image"};
 	}
+
+	if (memory_info.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT)
+	{
+		device.set_memory_priority(memory, priority);
+	}
+
+	device.check_memory_budget(memory, "Image");
 }
 
 Image::Image(Device &device, VkImage handle, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage, VkSampleCountFlagBits sample_count) :
@@ -135,6 +147,22 @@ Image::Image(Device &device, VkImage handle, const VkExtent3D &extent, VkFormat
 	subresource.arrayLayer = 1;
 }
 
+Image::Image(Device &device, VkImage handle, VmaAllocation aliased_memory, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage, VkSampleCountFlagBits sample_count) :
+    device{device},
+    handle{handle},
+    memory{aliased_memory},
+    type{find_image_type(extent)},
+    extent{extent},
+    format{format},
+    sample_count{sample_count},
+    usage{image_usage},
+    tiling{VK_IMAGE_TILING_OPTIMAL},
+    aliased{true}
+{
+	subresource.mipLevel   = 1;
+	subresource.arrayLayer = 1;
+}
+
 Image::Image(Image &&other) :
     device{other.device},
     handle{other.handle},
@@ -146,13 +174,19 @@ Image::Image(Image &&other) :
     usage{other.usage},
     tiling{other.tiling},
     subresource{other.subresource},
+    views{std::move(other.views)},
     mapped_data{other.mapped_data},
-    mapped{other.mapped}
+    mapped{other.mapped},
+    aliased{other.aliased},
+    creation_time{other.creation_time},
+    last_use_frame{other.last_use_frame.load(std::memory_order_relaxed)},
+    subresource_accesses{std::move(other.subresource_accesses)}
 {
 	other.handle      = VK_NULL_HANDLE;
 	other.memory      = VK_NULL_HANDLE;
 	other.mapped_data = nullptr;
 	other.mapped      = false;
+	other.aliased     = false;
 
 	// Update image views references to this image to avoid dangling pointers
 	for (auto &view : views)
@@ -163,7 +197,17 @@ Image::Image(Image &&other) :
 
 Image::~Image()
 {
-	if (handle != VK_NULL_HANDLE && memory != VK_NULL_HANDLE)
+	if (handle != VK_NULL_HANDLE)
+	{
+		// Views shared through the resource cache cannot outlive the image
+		device.get_resource_cache().release_image_views(*this);
+	}
+
+	if (aliased)
+	{
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+	}
+	else if (handle != VK_NULL_HANDLE && memory != VK_NULL_HANDLE)
 	{
 		unmap();
 		vmaDestroyImage(device.get_memory_allocator(), handle, memory);
@@ -175,6 +219,11 @@ Device &Image::get_device()
 	return device;
 }
 
+const Device &Image::get_device() const
+{
+	return device;
+}
+
 VkImage Image::get_handle() const
 {
 	return handle;
@@ -185,6 +234,11 @@ VmaAllocation Image::get_memory() const
 	return memory;
 }
 
+bool Image::is_aliased() const
+{
+	return aliased;
+}
+
 uint8_t *Image::map()
 {
 	if (!mapped_data)
@@ -239,6 +293,33 @@ VkImageTiling Image::get_tiling() const
 	return tiling;
 }
 
+ImageCompression Image::query_compression() const
+{
+	ImageCompression compression{};
+
+#ifdef VK_EXT_image_compression_control
+	if (!device.is_enabled(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME))
+	{
+		return compression;
+	}
+
+	VkImageSubresource2EXT image_subresource{VK_STRUCTURE_TYPE_IMAGE_SUBRESOURCE_2_EXT};
+	image_subresource.imageSubresource.aspectMask = is_depth_stencil_format(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+
+	VkImageCompressionPropertiesEXT compression_properties{VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_PROPERTIES_EXT};
+
+	VkSubresourceLayout2EXT subresource_layout{VK_STRUCTURE_TYPE_SUBRESOURCE_LAYOUT_2_EXT};
+	subresource_layout.pNext = &compression_properties;
+
+	vkGetImageSubresourceLayout2EXT(device.get_handle(), handle, &image_subresource, &subresource_layout);
+
+	compression.flags            = compression_properties.imageCompressionFlags;
+	compression.fixed_rate_flags = compression_properties.imageCompressionFixedRateFlags;
+#endif
+
+	return compression;
+}
+
 VkImageSubresource Image::get_subresource() const
 {
 	return subresource;
@@ -254,5 +335,55 @@ std::unordered_set<ImageView *> &Image::get_views()
 	return views;
 }
 
+uint64_t Image::get_creation_time() const
+{
+	return creation_time;
+}
+
+void Image::mark_used(uint64_t frame) const
+{
+	// Only store when it changes, to keep the cache line shared between the recording threads
+	if (last_use_frame.load(std::memory_order_relaxed) != frame)
+	{
+		last_use_frame.store(frame, std::memory_order_relaxed);
+	}
+}
+
+uint64_t Image::get_last_use_frame() const
+{
+	return last_use_frame.load(std::memory_order_relaxed);
+}
+
+const ResourceAccess &Image::get_access(uint32_t mip_level, uint32_t array_layer) const
+{
+	static const ResourceAccess initial_access{};
+
+	size_t index = static_cast<size_t>(array_layer) * subresource.mipLevel + mip_level;
+
+	if (index >= subresource_accesses.size())
+	{
+		return initial_access;
+	}
+
+	return subresource_accesses[index];
+}
+
+void Image::set_access(const VkImageSubresourceRange &range, const ResourceAccess &access) const
+{
+	uint32_t level_count = range.levelCount == VK_REMAINING_MIP_LEVELS ? subresource.mipLevel - range.baseMipLevel : range.levelCount;
+	uint32_t layer_count = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? subresource.arrayLayer - range.baseArrayLayer : range.layerCount;
+
+	// Subresources start undefined, the storage is only allocated once an access is recorded
+	subresource_accesses.resize(static_cast<size_t>(subresource.mipLevel) * subresource.arrayLayer);
+
+	for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layer_count; ++layer)
+	{
+		for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + level_count; ++level)
+		{
+			subresource_accesses[static_cast<size_t>(layer) * subresource.mipLevel + level] = access;
+		}
+	}
+}
+
 }        // namespace core
 }        // namespace vkb
@@ -17,10 +17,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <unordered_set>
+#include <vector>
 
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
@@ -29,6 +32,32 @@ class Device;
 namespace core
 {
 class ImageView;
+
+/**
+ * @brief Compression requested for the images used as attachments, with VK_EXT_image_compression_control
+ */
+enum class ImageCompressionPolicy
+{
+	/// Lets the implementation choose, usually a lossless compression such as AFBC
+	Default,
+	/// Allows a lossy fixed-rate compression at a rate chosen by the implementation
+	FixedRate,
+	/// Disables the compression, e.g. to measure the bandwidth it saves
+	Disabled
+};
+
+/**
+ * @brief Compression of an image reported by the implementation
+ */
+struct ImageCompression
+{
+	/// VkImageCompressionFlagsEXT, zero when it cannot be queried
+	uint32_t flags{0};
+
+	/// VkImageCompressionFixedRateFlagsEXT, the bits per component of a fixed-rate compression
+	uint32_t fixed_rate_flags{0};
+};
+
 class Image
 {
   public:
@@ -39,6 +68,18 @@ class Image
 	      VkImageUsageFlags     image_usage,
 	      VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT);
 
+	/**
+	 * @brief Wraps an image bound to a range of memory shared with other images
+	 *        The image handle is owned and destroyed with the image, the memory is not.
+	 */
+	Image(Device &              device,
+	      VkImage               handle,
+	      VmaAllocation         aliased_memory,
+	      const VkExtent3D &    extent,
+	      VkFormat              format,
+	      VkImageUsageFlags     image_usage,
+	      VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT);
+
 	Image(Device &              device,
 	      const VkExtent3D &    extent,
 	      VkFormat              format,
@@ -62,10 +103,17 @@ class Image
 
 	Device &get_device();
 
+	const Device &get_device() const;
+
 	VkImage get_handle() const;
 
 	VmaAllocation get_memory() const;
 
+	/**
+	 * @return Whether the memory of the image is shared with other images
+	 */
+	bool is_aliased() const;
+
 	/**
 	 * @brief Maps vulkan memory to an host visible address
 	 * @return Pointer to host visible memory
@@ -95,6 +143,38 @@ class Image
 
 	std::unordered_set<ImageView *> &get_views();
 
+	/**
+	 * @return The compression the implementation selected for the image, needs VK_EXT_image_compression_control
+	 */
+	ImageCompression query_compression() const;
+
+	/**
+	 * @return The time it was created at, on the clock of CpuProfiler::now()
+	 */
+	uint64_t get_creation_time() const;
+
+	/**
+	 * @brief Records that a command buffer used it
+	 * @param frame The current frame, see ResourceCache::get_frame_index()
+	 */
+	void mark_used(uint64_t frame) const;
+
+	/**
+	 * @return The last frame a command buffer used it in
+	 */
+	uint64_t get_last_use_frame() const;
+
+	/**
+	 * @return The last access recorded to a subresource, see CommandBuffer::transition()
+	 */
+	const ResourceAccess &get_access(uint32_t mip_level, uint32_t array_layer) const;
+
+	/**
+	 * @brief Records the access of a range of subresources, for the commands which change it without
+	 *        CommandBuffer::transition(), such as uploads recorded with raw Vulkan calls
+	 */
+	void set_access(const VkImageSubresourceRange &range, const ResourceAccess &access) const;
+
   private:
 	Device &device;
 
@@ -125,6 +205,17 @@ class Image
 
 	/// Whether it was mapped with vmaMapMemory
 	bool mapped{false};
+
+	/// Whether the memory is owned by an external allocator
+	bool aliased{false};
+
+	uint64_t creation_time{CpuProfiler::now()};
+
+	/// Written by the threads recording command buffers
+	mutable std::atomic<uint64_t> last_use_frame{0};
+
+	/// Last access of each subresource, at array_layer * mip levels + mip_level, in recording order
+	mutable std::vector<ResourceAccess> subresource_accesses;
 };
 }        // namespace core
 }        // namespace vkb
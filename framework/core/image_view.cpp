@@ -24,7 +24,7 @@ namespace vkb
 {
 namespace core
 {
-ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format) :
+ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format, uint32_t base_mip_level, uint32_t mip_levels) :
     device{img.get_device()},
     image{&img},
     format{format}
@@ -34,8 +34,11 @@ ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format) :
 		this->format = format = image->get_format();
 	}
 
-	subresource_range.levelCount = image->get_subresource().mipLevel;
-	subresource_range.layerCount = image->get_subresource().arrayLayer;
+	assert(base_mip_level + mip_levels <= image->get_subresource().mipLevel && "View mip levels should be within the image");
+
+	subresource_range.baseMipLevel = base_mip_level;
+	subresource_range.levelCount   = mip_levels ? mip_levels : image->get_subresource().mipLevel - base_mip_level;
+	subresource_range.layerCount   = image->get_subresource().arrayLayer;
 
 	if (is_depth_stencil_format(format))
 	{
@@ -28,7 +28,11 @@ namespace core
 class ImageView
 {
   public:
-	ImageView(Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED);
+	/**
+	 * @param base_mip_level First mip level of the view
+	 * @param mip_levels Number of mip levels of the view, 0 for all the levels from the first one
+	 */
+	ImageView(Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED, uint32_t base_mip_level = 0, uint32_t mip_levels = 0);
 
 	ImageView(ImageView &) = delete;
 
@@ -132,7 +132,9 @@ std::vector<const char *> get_optimal_validation_layers(const std::vector<VkLaye
 Instance::Instance(const std::string &                           application_name,
                    const std::unordered_map<const char *, bool> &required_extensions,
                    const std::vector<const char *> &             required_validation_layers,
-                   bool                                          headless)
+                   bool                                          headless,
+                   uint32_t                                      api_version) :
+    api_version{api_version}
 {
 	VkResult result = volkInitialize();
 	if (result)
@@ -140,6 +142,20 @@ Instance::Instance(const std::string &                           application_nam
 		throw VulkanException(result, "Failed to initialize volk.");
 	}
 
+	// Loaders older than Vulkan 1.1 don't have vkEnumerateInstanceVersion and only accept 1.0
+	uint32_t instance_version = VK_API_VERSION_1_0;
+	if (vkEnumerateInstanceVersion)
+	{
+		VK_CHECK(vkEnumerateInstanceVersion(&instance_version));
+	}
+	if (instance_version < this->api_version)
+	{
+		LOGW("Vulkan {}.{} requested, the instance is created with {}.{}",
+		     VK_VERSION_MAJOR(this->api_version), VK_VERSION_MINOR(this->api_version),
+		     VK_VERSION_MAJOR(instance_version), VK_VERSION_MINOR(instance_version));
+		this->api_version = instance_version;
+	}
+
 	uint32_t instance_extension_count;
 	VK_CHECK(vkEnumerateInstanceExtensionProperties(nullptr, &instance_extension_count, nullptr));
 
@@ -198,6 +214,22 @@ Instance::Instance(const std::string &                           application_nam
 		}
 	}
 
+#ifdef VK_EXT_surface_maintenance1
+	auto is_available = [&available_instance_extensions](const char *extension_name) {
+		return std::find_if(available_instance_extensions.begin(), available_instance_extensions.end(),
+		                    [extension_name](const VkExtensionProperties &available_extension) { return strcmp(available_extension.extensionName, extension_name) == 0; }) != available_instance_extensions.end();
+	};
+
+	// VK_EXT_surface_maintenance1 is a prerequisite of VK_EXT_swapchain_maintenance1,
+	// which lets the swapchain switch present modes without being recreated
+	if (!headless && is_available(VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME) && is_available(VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME))
+	{
+		LOGI("{} is available, enabling it", VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME);
+		enabled_extensions.push_back(VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME);
+		enabled_extensions.push_back(VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME);
+	}
+#endif
+
 	auto extension_error = false;
 	for (auto extension : required_extensions)
 	{
@@ -227,13 +259,21 @@ Instance::Instance(const std::string &                           application_nam
 		throw std::runtime_error("Required instance extensions are missing.");
 	}
 
-	uint32_t instance_layer_count;
-	VK_CHECK(vkEnumerateInstanceLayerProperties(&instance_layer_count, nullptr));
+	std::vector<const char *> requested_validation_layers(required_validation_layers);
 
-	std::vector<VkLayerProperties> supported_validation_layers(instance_layer_count);
-	VK_CHECK(vkEnumerateInstanceLayerProperties(&instance_layer_count, supported_validation_layers.data()));
+	// Enumerating the layers loads all of their manifests, which is skipped when none can be enabled
+	std::vector<VkLayerProperties> supported_validation_layers;
 
-	std::vector<const char *> requested_validation_layers(required_validation_layers);
+#ifndef VKB_VALIDATION_LAYERS
+	if (!requested_validation_layers.empty())
+#endif
+	{
+		uint32_t instance_layer_count;
+		VK_CHECK(vkEnumerateInstanceLayerProperties(&instance_layer_count, nullptr));
+
+		supported_validation_layers.resize(instance_layer_count);
+		VK_CHECK(vkEnumerateInstanceLayerProperties(&instance_layer_count, supported_validation_layers.data()));
+	}
 
 #ifdef VKB_VALIDATION_LAYERS
 	// Determine the optimal validation layers to enable that are necessary for useful debugging
@@ -260,7 +300,7 @@ Instance::Instance(const std::string &                           application_nam
 	app_info.applicationVersion = 0;
 	app_info.pEngineName        = "Vulkan Samples";
 	app_info.engineVersion      = 0;
-	app_info.apiVersion         = VK_MAKE_VERSION(1, 0, 0);
+	app_info.apiVersion         = this->api_version;
 
 	VkInstanceCreateInfo instance_info = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
 
@@ -376,6 +416,36 @@ void Instance::query_gpus()
 	{
 		gpus.push_back(std::make_unique<PhysicalDevice>(*this, physical_device));
 	}
+
+	if (!is_enabled(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	// Linked GPUs can be driven by one logical device
+	uint32_t group_count{0};
+	VK_CHECK(vkEnumeratePhysicalDeviceGroupsKHR(handle, &group_count, nullptr));
+
+	std::vector<VkPhysicalDeviceGroupPropertiesKHR> groups(group_count, {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES_KHR});
+	VK_CHECK(vkEnumeratePhysicalDeviceGroupsKHR(handle, &group_count, groups.data()));
+
+	for (auto &group : groups)
+	{
+		std::vector<VkPhysicalDevice> group_devices(group.physicalDevices, group.physicalDevices + group.physicalDeviceCount);
+
+		for (auto &gpu : gpus)
+		{
+			if (std::find(group_devices.begin(), group_devices.end(), gpu->get_handle()) != group_devices.end())
+			{
+				gpu->set_device_group(group_devices);
+			}
+		}
+
+		if (group_devices.size() > 1)
+		{
+			LOGI("Found a device group of {} GPUs", group_devices.size());
+		}
+	}
 }
 
 PhysicalDevice &Instance::get_suitable_gpu()
@@ -410,4 +480,9 @@ const std::vector<const char *> &Instance::get_extensions()
 {
 	return enabled_extensions;
 }
+
+uint32_t Instance::get_api_version() const
+{
+	return api_version;
+}
 }        // namespace vkb
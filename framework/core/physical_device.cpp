@@ -21,18 +21,23 @@ namespace vkb
 {
 PhysicalDevice::PhysicalDevice(Instance &instance, VkPhysicalDevice physical_device) :
     instance{instance},
-    handle{physical_device}
+    handle{physical_device},
+    device_group{physical_device}
 {
-	vkGetPhysicalDeviceFeatures(physical_device, &features);
 	vkGetPhysicalDeviceProperties(physical_device, &properties);
 	vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
 
 	LOGI("Found GPU: {}", properties.deviceName);
 
-	uint32_t queue_family_properties_count = 0;
-	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, nullptr);
-	queue_family_properties = std::vector<VkQueueFamilyProperties>(queue_family_properties_count);
-	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, queue_family_properties.data());
+	// Subgroup properties are core in Vulkan 1.1, which the instance has to be created with too
+	if (instance.get_api_version() >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1)
+	{
+		VkPhysicalDeviceProperties2 properties2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+		properties2.pNext = &subgroup_properties;
+		vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+	}
+
+	capabilities = std::make_unique<CapabilityCache>(physical_device, properties);
 }
 
 Instance &PhysicalDevice::get_instance() const
@@ -54,11 +59,7 @@ VkBool32 PhysicalDevice::is_present_supported(VkSurfaceKHR surface, uint32_t que
 
 const VkFormatProperties PhysicalDevice::get_format_properties(VkFormat format) const
 {
-	VkFormatProperties format_properties;
-
-	vkGetPhysicalDeviceFormatProperties(handle, format, &format_properties);
-
-	return format_properties;
+	return capabilities->get_format_properties(format);
 }
 
 VkPhysicalDevice PhysicalDevice::get_handle() const
@@ -68,7 +69,7 @@ VkPhysicalDevice PhysicalDevice::get_handle() const
 
 const VkPhysicalDeviceFeatures &PhysicalDevice::get_features() const
 {
-	return features;
+	return capabilities->get_features();
 }
 
 const VkPhysicalDeviceProperties PhysicalDevice::get_properties() const
@@ -81,9 +82,40 @@ const VkPhysicalDeviceMemoryProperties PhysicalDevice::get_memory_properties() c
 	return memory_properties;
 }
 
+const VkPhysicalDeviceSubgroupProperties &PhysicalDevice::get_subgroup_properties() const
+{
+	return subgroup_properties;
+}
+
+bool PhysicalDevice::is_subgroup_supported(VkShaderStageFlags stages, VkSubgroupFeatureFlags operations) const
+{
+	return (subgroup_properties.supportedStages & stages) == stages &&
+	       (subgroup_properties.supportedOperations & operations) == operations;
+}
+
 const std::vector<VkQueueFamilyProperties> &PhysicalDevice::get_queue_family_properties() const
 {
-	return queue_family_properties;
+	return capabilities->get_queue_family_properties();
+}
+
+const std::vector<VkExtensionProperties> &PhysicalDevice::get_extension_properties() const
+{
+	return capabilities->get_extension_properties();
+}
+
+bool PhysicalDevice::is_capability_cache_loaded() const
+{
+	return capabilities->is_loaded();
+}
+
+void PhysicalDevice::set_device_group(const std::vector<VkPhysicalDevice> &physical_devices)
+{
+	device_group = physical_devices;
+}
+
+const std::vector<VkPhysicalDevice> &PhysicalDevice::get_device_group() const
+{
+	return device_group;
 }
 
 uint32_t PhysicalDevice::get_queue_family_performance_query_passes(
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "core/capability_cache.h"
 #include "core/instance.h"
 
 namespace vkb
@@ -45,6 +46,9 @@ class PhysicalDevice
 
 	VkBool32 is_present_supported(VkSurfaceKHR surface, uint32_t queue_family_index) const;
 
+	/**
+	 * @brief Can be called from any thread, the properties are cached across runs
+	 */
 	const VkFormatProperties get_format_properties(VkFormat format) const;
 
 	VkPhysicalDevice get_handle() const;
@@ -55,8 +59,37 @@ class PhysicalDevice
 
 	const VkPhysicalDeviceMemoryProperties get_memory_properties() const;
 
+	/**
+	 * @return The subgroup size, stages and operations of the GPU, all zero unless both
+	 *         the instance and the GPU are Vulkan 1.1
+	 */
+	const VkPhysicalDeviceSubgroupProperties &get_subgroup_properties() const;
+
+	/**
+	 * @return True if the shaders of the stages can use all the subgroup operations
+	 */
+	bool is_subgroup_supported(VkShaderStageFlags stages, VkSubgroupFeatureFlags operations) const;
+
 	const std::vector<VkQueueFamilyProperties> &get_queue_family_properties() const;
 
+	const std::vector<VkExtensionProperties> &get_extension_properties() const;
+
+	/**
+	 * @return True if the capabilities were cached by a previous run with the same driver
+	 */
+	bool is_capability_cache_loaded() const;
+
+	/**
+	 * @brief Sets the physical devices of the device group of the GPU, the GPU included
+	 */
+	void set_device_group(const std::vector<VkPhysicalDevice> &physical_devices);
+
+	/**
+	 * @return The physical devices a logical device can be created over with this GPU, in the order of their
+	 *         device indices, only the GPU if it is in no group or VK_KHR_device_group_creation is not enabled
+	 */
+	const std::vector<VkPhysicalDevice> &get_device_group() const;
+
 	uint32_t get_queue_family_performance_query_passes(
 	    const VkQueryPoolPerformanceCreateInfoKHR *perf_query_create_info) const;
 
@@ -135,17 +168,20 @@ class PhysicalDevice
 	// Handle to the Vulkan physical device
 	VkPhysicalDevice handle{VK_NULL_HANDLE};
 
-	// The features that this GPU supports
-	VkPhysicalDeviceFeatures features{};
-
 	// The GPU properties
 	VkPhysicalDeviceProperties properties;
 
 	// The GPU memory properties
 	VkPhysicalDeviceMemoryProperties memory_properties;
 
-	// The GPU queue family properties
-	std::vector<VkQueueFamilyProperties> queue_family_properties;
+	// The GPU subgroup properties
+	VkPhysicalDeviceSubgroupProperties subgroup_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+
+	// The features, queue families, extensions and format properties of the GPU, queried on first use
+	std::unique_ptr<CapabilityCache> capabilities;
+
+	// The physical devices of the device group of the GPU
+	std::vector<VkPhysicalDevice> device_group;
 
 	// The features that will be requested to be enabled in the logical device
 	VkPhysicalDeviceFeatures requested_features{};
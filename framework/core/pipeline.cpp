@@ -17,12 +17,32 @@
 
 #include "pipeline.h"
 
+#include <algorithm>
+
 #include "device.h"
 #include "pipeline_layout.h"
 #include "shader_module.h"
 
 namespace vkb
 {
+namespace
+{
+/**
+ * @return The flags of the pipelines for the way the device binds descriptors
+ */
+VkPipelineCreateFlags get_descriptor_flags(const Device &device)
+{
+#ifdef VK_EXT_descriptor_buffer
+	if (device.uses_descriptor_buffers())
+	{
+		return VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+	}
+#endif
+
+	return 0;
+}
+}        // namespace
+
 Pipeline::Pipeline(Device &device) :
     device{device}
 {}
@@ -30,7 +50,9 @@ Pipeline::Pipeline(Device &device) :
 Pipeline::Pipeline(Pipeline &&other) :
     device{other.device},
     handle{other.handle},
-    state{other.state}
+    state{other.state},
+    creation_time{other.creation_time},
+    last_use_frame{other.last_use_frame.load(std::memory_order_relaxed)}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -54,6 +76,38 @@ const PipelineState &Pipeline::get_state() const
 	return state;
 }
 
+uint64_t Pipeline::get_creation_time() const
+{
+	return creation_time;
+}
+
+void Pipeline::mark_used(uint64_t frame) const
+{
+	// Only store when it changes, to keep the cache line shared between the recording threads
+	if (last_use_frame.load(std::memory_order_relaxed) != frame)
+	{
+		last_use_frame.store(frame, std::memory_order_relaxed);
+	}
+}
+
+uint64_t Pipeline::get_last_use_frame() const
+{
+	return last_use_frame.load(std::memory_order_relaxed);
+}
+
+bool uses_mesh_shading(const PipelineState &pipeline_state)
+{
+#ifdef VK_EXT_mesh_shader
+	auto &shader_modules = pipeline_state.get_pipeline_layout().get_shader_modules();
+
+	return std::any_of(shader_modules.begin(), shader_modules.end(), [](const ShaderModule *shader_module) {
+		return shader_module->get_stage() == VK_SHADER_STAGE_MESH_BIT_EXT;
+	});
+#else
+	return false;
+#endif
+}
+
 ComputePipeline::ComputePipeline(Device &        device,
                                  VkPipelineCache pipeline_cache,
                                  PipelineState & pipeline_state) :
@@ -106,6 +160,7 @@ ComputePipeline::ComputePipeline(Device &        device,
 
 	VkComputePipelineCreateInfo create_info{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
 
+	create_info.flags  = get_descriptor_flags(device);
 	create_info.layout = pipeline_state.get_pipeline_layout().get_handle();
 	create_info.stage  = stage;
 
@@ -119,19 +174,82 @@ ComputePipeline::ComputePipeline(Device &        device,
 	vkDestroyShaderModule(device.get_handle(), stage.module, nullptr);
 }
 
-GraphicsPipeline::GraphicsPipeline(Device &        device,
-                                   VkPipelineCache pipeline_cache,
-                                   PipelineState & pipeline_state) :
-    Pipeline{device}
+namespace
+{
+/**
+ * @brief Create infos of a graphics pipeline, filled from a pipeline state
+ *        The shader modules are destroyed with the builder, once the pipeline is created.
+ */
+struct GraphicsPipelineBuilder
 {
+	GraphicsPipelineBuilder(Device &device, const PipelineState &pipeline_state);
+
+	GraphicsPipelineBuilder(const GraphicsPipelineBuilder &) = delete;
+
+	~GraphicsPipelineBuilder();
+
+	GraphicsPipelineBuilder &operator=(const GraphicsPipelineBuilder &) = delete;
+
+	/**
+	 * @brief Only keeps the shader stages in the mask, used for pipeline libraries
+	 */
+	void select_stages(VkShaderStageFlags stages);
+
+	Device &device;
+
 	std::vector<VkShaderModule> shader_modules;
 
 	std::vector<VkPipelineShaderStageCreateInfo> stage_create_infos;
 
-	// Create specialization info from tracked state. This is shared by all shaders.
-	std::vector<uint8_t>                  data{};
+	std::vector<uint8_t> data{};
+
 	std::vector<VkSpecializationMapEntry> map_entries{};
 
+	VkSpecializationInfo specialization_info{};
+
+	VkPipelineVertexInputStateCreateInfo vertex_input_state{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_state{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+
+	VkPipelineViewportStateCreateInfo viewport_state{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+
+	VkPipelineRasterizationStateCreateInfo rasterization_state{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+
+	VkPipelineMultisampleStateCreateInfo multisample_state{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_state{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+
+	VkPipelineColorBlendStateCreateInfo color_blend_state{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+
+	VkPipelineDynamicStateCreateInfo dynamic_state{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+
+	std::array<VkDynamicState, 9> dynamic_states{
+	    VK_DYNAMIC_STATE_VIEWPORT,
+	    VK_DYNAMIC_STATE_SCISSOR,
+	    VK_DYNAMIC_STATE_LINE_WIDTH,
+	    VK_DYNAMIC_STATE_DEPTH_BIAS,
+	    VK_DYNAMIC_STATE_BLEND_CONSTANTS,
+	    VK_DYNAMIC_STATE_DEPTH_BOUNDS,
+	    VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK,
+	    VK_DYNAMIC_STATE_STENCIL_WRITE_MASK,
+	    VK_DYNAMIC_STATE_STENCIL_REFERENCE,
+	};
+
+#ifdef VK_KHR_dynamic_rendering
+	VkPipelineRenderingCreateInfoKHR rendering_info{VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR};
+#endif
+
+#ifdef VK_KHR_fragment_shading_rate
+	VkPipelineFragmentShadingRateStateCreateInfoKHR fragment_shading_rate_state{VK_STRUCTURE_TYPE_PIPELINE_FRAGMENT_SHADING_RATE_STATE_CREATE_INFO_KHR};
+#endif
+
+	VkGraphicsPipelineCreateInfo create_info{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+};
+
+GraphicsPipelineBuilder::GraphicsPipelineBuilder(Device &device, const PipelineState &pipeline_state) :
+    device{device}
+{
+	// Create specialization info from tracked state. This is shared by all shaders.
 	const auto specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
 
 	for (const auto specialization_constant : specialization_constant_state)
@@ -140,7 +258,6 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 		data.insert(data.end(), specialization_constant.second.begin(), specialization_constant.second.end());
 	}
 
-	VkSpecializationInfo specialization_info{};
 	specialization_info.mapEntryCount = to_u32(map_entries.size());
 	specialization_info.pMapEntries   = map_entries.data();
 	specialization_info.dataSize      = data.size();
@@ -172,31 +289,21 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 		shader_modules.push_back(stage_create_info.module);
 	}
 
-	VkGraphicsPipelineCreateInfo create_info{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-
 	create_info.stageCount = to_u32(stage_create_infos.size());
 	create_info.pStages    = stage_create_infos.data();
 
-	VkPipelineVertexInputStateCreateInfo vertex_input_state{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-
 	vertex_input_state.pVertexAttributeDescriptions    = pipeline_state.get_vertex_input_state().attributes.data();
 	vertex_input_state.vertexAttributeDescriptionCount = to_u32(pipeline_state.get_vertex_input_state().attributes.size());
 
 	vertex_input_state.pVertexBindingDescriptions    = pipeline_state.get_vertex_input_state().bindings.data();
 	vertex_input_state.vertexBindingDescriptionCount = to_u32(pipeline_state.get_vertex_input_state().bindings.size());
 
-	VkPipelineInputAssemblyStateCreateInfo input_assembly_state{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
-
 	input_assembly_state.topology               = pipeline_state.get_input_assembly_state().topology;
 	input_assembly_state.primitiveRestartEnable = pipeline_state.get_input_assembly_state().primitive_restart_enable;
 
-	VkPipelineViewportStateCreateInfo viewport_state{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
-
 	viewport_state.viewportCount = pipeline_state.get_viewport_state().viewport_count;
 	viewport_state.scissorCount  = pipeline_state.get_viewport_state().scissor_count;
 
-	VkPipelineRasterizationStateCreateInfo rasterization_state{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
-
 	rasterization_state.depthClampEnable        = pipeline_state.get_rasterization_state().depth_clamp_enable;
 	rasterization_state.rasterizerDiscardEnable = pipeline_state.get_rasterization_state().rasterizer_discard_enable;
 	rasterization_state.polygonMode             = pipeline_state.get_rasterization_state().polygon_mode;
@@ -207,8 +314,6 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	rasterization_state.depthBiasSlopeFactor    = 1.0f;
 	rasterization_state.lineWidth               = 1.0f;
 
-	VkPipelineMultisampleStateCreateInfo multisample_state{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
-
 	multisample_state.sampleShadingEnable   = pipeline_state.get_multisample_state().sample_shading_enable;
 	multisample_state.rasterizationSamples  = pipeline_state.get_multisample_state().rasterization_samples;
 	multisample_state.minSampleShading      = pipeline_state.get_multisample_state().min_sample_shading;
@@ -220,8 +325,6 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 		multisample_state.pSampleMask = &pipeline_state.get_multisample_state().sample_mask;
 	}
 
-	VkPipelineDepthStencilStateCreateInfo depth_stencil_state{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
-
 	depth_stencil_state.depthTestEnable       = pipeline_state.get_depth_stencil_state().depth_test_enable;
 	depth_stencil_state.depthWriteEnable      = pipeline_state.get_depth_stencil_state().depth_write_enable;
 	depth_stencil_state.depthCompareOp        = pipeline_state.get_depth_stencil_state().depth_compare_op;
@@ -242,8 +345,6 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	depth_stencil_state.back.writeMask        = ~0U;
 	depth_stencil_state.back.reference        = ~0U;
 
-	VkPipelineColorBlendStateCreateInfo color_blend_state{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
-
 	color_blend_state.logicOpEnable     = pipeline_state.get_color_blend_state().logic_op_enable;
 	color_blend_state.logicOp           = pipeline_state.get_color_blend_state().logic_op;
 	color_blend_state.attachmentCount   = to_u32(pipeline_state.get_color_blend_state().attachments.size());
@@ -253,25 +354,19 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	color_blend_state.blendConstants[2] = 1.0f;
 	color_blend_state.blendConstants[3] = 1.0f;
 
-	std::array<VkDynamicState, 9> dynamic_states{
-	    VK_DYNAMIC_STATE_VIEWPORT,
-	    VK_DYNAMIC_STATE_SCISSOR,
-	    VK_DYNAMIC_STATE_LINE_WIDTH,
-	    VK_DYNAMIC_STATE_DEPTH_BIAS,
-	    VK_DYNAMIC_STATE_BLEND_CONSTANTS,
-	    VK_DYNAMIC_STATE_DEPTH_BOUNDS,
-	    VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK,
-	    VK_DYNAMIC_STATE_STENCIL_WRITE_MASK,
-	    VK_DYNAMIC_STATE_STENCIL_REFERENCE,
-	};
-
-	VkPipelineDynamicStateCreateInfo dynamic_state{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
-
 	dynamic_state.pDynamicStates    = dynamic_states.data();
 	dynamic_state.dynamicStateCount = to_u32(dynamic_states.size());
 
 	create_info.pVertexInputState   = &vertex_input_state;
 	create_info.pInputAssemblyState = &input_assembly_state;
+
+	// Mesh shaders generate their primitives, the pipeline has no vertex input
+	if (uses_mesh_shading(pipeline_state))
+	{
+		create_info.pVertexInputState   = nullptr;
+		create_info.pInputAssemblyState = nullptr;
+	}
+
 	create_info.pViewportState      = &viewport_state;
 	create_info.pRasterizationState = &rasterization_state;
 	create_info.pMultisampleState   = &multisample_state;
@@ -279,20 +374,208 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	create_info.pColorBlendState    = &color_blend_state;
 	create_info.pDynamicState       = &dynamic_state;
 
-	create_info.layout     = pipeline_state.get_pipeline_layout().get_handle();
-	create_info.renderPass = pipeline_state.get_render_pass()->get_handle();
-	create_info.subpass    = pipeline_state.get_subpass_index();
+	create_info.flags  = get_descriptor_flags(device);
+	create_info.layout = pipeline_state.get_pipeline_layout().get_handle();
+
+	if (pipeline_state.get_render_pass())
+	{
+		create_info.renderPass = pipeline_state.get_render_pass()->get_handle();
+		create_info.subpass    = pipeline_state.get_subpass_index();
+	}
+	else
+	{
+#ifdef VK_KHR_dynamic_rendering
+		// Created for dynamic rendering, the attachment formats replace the render pass
+		auto depth_stencil_format = pipeline_state.get_depth_stencil_attachment_format();
+
+		rendering_info.colorAttachmentCount    = to_u32(pipeline_state.get_color_attachment_formats().size());
+		rendering_info.pColorAttachmentFormats = pipeline_state.get_color_attachment_formats().data();
+		rendering_info.depthAttachmentFormat   = depth_stencil_format;
+		rendering_info.stencilAttachmentFormat = is_depth_only_format(depth_stencil_format) ? VK_FORMAT_UNDEFINED : depth_stencil_format;
+
+		create_info.pNext = &rendering_info;
+#endif
+
+		create_info.renderPass = VK_NULL_HANDLE;
+		create_info.subpass    = 0;
+	}
+
+#ifdef VK_KHR_fragment_shading_rate
+	if (device.is_enabled(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME))
+	{
+		auto &shading_rate_state = pipeline_state.get_fragment_shading_rate_state();
+
+		fragment_shading_rate_state.fragmentSize   = shading_rate_state.fragment_size;
+		fragment_shading_rate_state.combinerOps[0] = shading_rate_state.combiner_ops[0];
+		fragment_shading_rate_state.combinerOps[1] = shading_rate_state.combiner_ops[1];
+
+		fragment_shading_rate_state.pNext = create_info.pNext;
+		create_info.pNext                 = &fragment_shading_rate_state;
+	}
+#endif
+}
+
+GraphicsPipelineBuilder::~GraphicsPipelineBuilder()
+{
+	for (auto shader_module : shader_modules)
+	{
+		vkDestroyShaderModule(device.get_handle(), shader_module, nullptr);
+	}
+}
+
+void GraphicsPipelineBuilder::select_stages(VkShaderStageFlags stages)
+{
+	stage_create_infos.erase(std::remove_if(stage_create_infos.begin(), stage_create_infos.end(),
+	                                        [stages](const VkPipelineShaderStageCreateInfo &stage_create_info) {
+		                                        return (stage_create_info.stage & stages) == 0;
+	                                        }),
+	                         stage_create_infos.end());
+
+	create_info.stageCount = to_u32(stage_create_infos.size());
+	create_info.pStages    = stage_create_infos.empty() ? nullptr : stage_create_infos.data();
+}
+}        // namespace
+
+GraphicsPipelineLibrary::GraphicsPipelineLibrary(Device &            device,
+                                                 VkPipelineCache     pipeline_cache,
+                                                 PipelineState &     pipeline_state,
+                                                 PipelineLibraryType type) :
+    Pipeline{device},
+    type{type}
+{
+#ifdef VK_EXT_graphics_pipeline_library
+	GraphicsPipelineBuilder builder{device, pipeline_state};
+
+	VkGraphicsPipelineLibraryCreateInfoEXT library_info{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT};
+
+	auto &create_info = builder.create_info;
+
+	// Only keep the state belonging to this part of the pipeline
+	switch (type)
+	{
+		case PipelineLibraryType::VertexInput:
+			library_info.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+
+			builder.select_stages(0);
+			create_info.pViewportState      = nullptr;
+			create_info.pRasterizationState = nullptr;
+			create_info.pMultisampleState   = nullptr;
+			create_info.pDepthStencilState  = nullptr;
+			create_info.pColorBlendState    = nullptr;
+			create_info.layout              = VK_NULL_HANDLE;
+			create_info.renderPass          = VK_NULL_HANDLE;
+			create_info.subpass             = 0;
+			break;
+		case PipelineLibraryType::PreRasterization:
+			library_info.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+
+			builder.select_stages(VK_SHADER_STAGE_ALL_GRAPHICS & ~VK_SHADER_STAGE_FRAGMENT_BIT);
+			create_info.pVertexInputState   = nullptr;
+			create_info.pInputAssemblyState = nullptr;
+			create_info.pMultisampleState   = nullptr;
+			create_info.pDepthStencilState  = nullptr;
+			create_info.pColorBlendState    = nullptr;
+			break;
+		case PipelineLibraryType::FragmentShader:
+			library_info.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+
+			builder.select_stages(VK_SHADER_STAGE_FRAGMENT_BIT);
+			create_info.pVertexInputState   = nullptr;
+			create_info.pInputAssemblyState = nullptr;
+			create_info.pViewportState      = nullptr;
+			create_info.pRasterizationState = nullptr;
+			create_info.pColorBlendState    = nullptr;
+			break;
+		case PipelineLibraryType::FragmentOutput:
+			library_info.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+
+			builder.select_stages(0);
+			create_info.pVertexInputState   = nullptr;
+			create_info.pInputAssemblyState = nullptr;
+			create_info.pViewportState      = nullptr;
+			create_info.pRasterizationState = nullptr;
+			create_info.pDepthStencilState  = nullptr;
+			create_info.layout              = VK_NULL_HANDLE;
+			break;
+	}
+
+	// Keep the information needed to run link time optimization when linking in the background
+	create_info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+	library_info.pNext = create_info.pNext;
+	create_info.pNext  = &library_info;
 
 	auto result = vkCreateGraphicsPipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
 
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create graphics pipeline library"};
+	}
+
+	state = pipeline_state;
+#else
+	throw VulkanException{VK_ERROR_EXTENSION_NOT_PRESENT, "Graphics pipeline libraries are not supported by the Vulkan headers"};
+#endif
+}
+
+PipelineLibraryType GraphicsPipelineLibrary::get_type() const
+{
+	return type;
+}
+
+GraphicsPipeline::GraphicsPipeline(Device &        device,
+                                   VkPipelineCache pipeline_cache,
+                                   PipelineState & pipeline_state) :
+    Pipeline{device}
+{
+	GraphicsPipelineBuilder builder{device, pipeline_state};
+
+	auto result = vkCreateGraphicsPipelines(device.get_handle(), pipeline_cache, 1, &builder.create_info, nullptr, &handle);
+
 	if (result != VK_SUCCESS)
 	{
 		throw VulkanException{result, "Cannot create GraphicsPipelines"};
 	}
 
-	for (auto shader_module : shader_modules)
+	state = pipeline_state;
+}
+
+GraphicsPipeline::GraphicsPipeline(Device &                                            device,
+                                   VkPipelineCache                                     pipeline_cache,
+                                   PipelineState &                                     pipeline_state,
+                                   const std::vector<const GraphicsPipelineLibrary *> &libraries,
+                                   bool                                                optimize) :
+    Pipeline{device}
+{
+	std::vector<VkPipeline> library_handles;
+
+	for (auto library : libraries)
 	{
-		vkDestroyShaderModule(device.get_handle(), shader_module, nullptr);
+		library_handles.push_back(library->get_handle());
+	}
+
+	VkPipelineLibraryCreateInfoKHR library_info{VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR};
+
+	library_info.libraryCount = to_u32(library_handles.size());
+	library_info.pLibraries   = library_handles.data();
+
+	VkGraphicsPipelineCreateInfo create_info{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+
+	create_info.pNext  = &library_info;
+	create_info.flags  = get_descriptor_flags(device);
+	create_info.layout = pipeline_state.get_pipeline_layout().get_handle();
+
+#ifdef VK_EXT_graphics_pipeline_library
+	if (optimize)
+	{
+		create_info.flags |= VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+	}
+#endif
+
+	auto result = vkCreateGraphicsPipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot link GraphicsPipelines"};
 	}
 
 	state = pipeline_state;
@@ -17,14 +17,22 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "rendering/pipeline_state.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
 class Device;
 
+/**
+ * @return Whether the pipeline layout of a state has a mesh shader stage, in which case the pipeline has no vertex input
+ */
+bool uses_mesh_shading(const PipelineState &pipeline_state);
+
 class Pipeline
 {
   public:
@@ -44,12 +52,34 @@ class Pipeline
 
 	const PipelineState &get_state() const;
 
+	/**
+	 * @return The time it was created at, on the clock of CpuProfiler::now()
+	 */
+	uint64_t get_creation_time() const;
+
+	/**
+	 * @brief Records that a command buffer bound it
+	 * @param frame The current frame, see ResourceCache::get_frame_index()
+	 */
+	void mark_used(uint64_t frame) const;
+
+	/**
+	 * @return The last frame a command buffer bound it in
+	 */
+	uint64_t get_last_use_frame() const;
+
   protected:
 	Device &device;
 
 	VkPipeline handle = VK_NULL_HANDLE;
 
 	PipelineState state;
+
+  private:
+	uint64_t creation_time{CpuProfiler::now()};
+
+	/// Written by the threads recording command buffers
+	mutable std::atomic<uint64_t> last_use_frame{0};
 };
 
 class ComputePipeline : public Pipeline
@@ -64,6 +94,28 @@ class ComputePipeline : public Pipeline
 	                PipelineState & pipeline_state);
 };
 
+/**
+ * @brief One part of a graphics pipeline, created as a pipeline library
+ *        Requires VK_EXT_graphics_pipeline_library to be enabled on the device.
+ */
+class GraphicsPipelineLibrary : public Pipeline
+{
+  public:
+	GraphicsPipelineLibrary(GraphicsPipelineLibrary &&) = default;
+
+	virtual ~GraphicsPipelineLibrary() = default;
+
+	GraphicsPipelineLibrary(Device &            device,
+	                        VkPipelineCache     pipeline_cache,
+	                        PipelineState &     pipeline_state,
+	                        PipelineLibraryType type);
+
+	PipelineLibraryType get_type() const;
+
+  private:
+	PipelineLibraryType type;
+};
+
 class GraphicsPipeline : public Pipeline
 {
   public:
@@ -74,5 +126,20 @@ class GraphicsPipeline : public Pipeline
 	GraphicsPipeline(Device &        device,
 	                 VkPipelineCache pipeline_cache,
 	                 PipelineState & pipeline_state);
+
+	/**
+	 * @brief Links a graphics pipeline from pipeline libraries of every type
+	 * @param device A valid device with VK_EXT_graphics_pipeline_library enabled
+	 * @param pipeline_cache The pipeline cache to use for linking
+	 * @param pipeline_state The state the libraries were created from
+	 * @param libraries One library of each PipelineLibraryType
+	 * @param optimize Whether to run link time optimization, which is slower to link
+	 *                 but as fast as a monolithic pipeline to execute
+	 */
+	GraphicsPipeline(Device &                                            device,
+	                 VkPipelineCache                                     pipeline_cache,
+	                 PipelineState &                                     pipeline_state,
+	                 const std::vector<const GraphicsPipelineLibrary *> &libraries,
+	                 bool                                                optimize);
 };
 }        // namespace vkb
@@ -0,0 +1,177 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipeline_cache.h"
+
+#include <cstring>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "device.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+// Offsets of the fields of VkPipelineCacheHeaderVersionOne
+constexpr size_t header_size_offset    = 0;
+constexpr size_t header_version_offset = 4;
+constexpr size_t vendor_id_offset      = 8;
+constexpr size_t device_id_offset      = 12;
+constexpr size_t uuid_offset           = 16;
+constexpr size_t header_min_size       = uuid_offset + VK_UUID_SIZE;
+
+inline uint32_t read_u32(const std::vector<uint8_t> &data, size_t offset)
+{
+	uint32_t value{0};
+	std::memcpy(&value, data.data() + offset, sizeof(uint32_t));
+	return value;
+}
+}        // namespace
+
+PipelineCache::PipelineCache(Device &device, const std::string &filename) :
+    device{device},
+    filename{filename}
+{
+	std::vector<uint8_t> data;
+
+	try
+	{
+		data = fs::read_temp(filename);
+	}
+	catch (const std::runtime_error &)
+	{
+		LOGI("No pipeline cache found, starting with an empty one");
+	}
+
+	if (!data.empty() && !is_compatible(data, device.get_gpu().get_properties()))
+	{
+		LOGW("Pipeline cache was written by a different device or driver, discarding it");
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	create_info.initialDataSize = data.size();
+	create_info.pInitialData    = data.data();
+
+	VkResult result = vkCreatePipelineCache(device.get_handle(), &create_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS && !data.empty())
+	{
+		LOGW("Pipeline cache data rejected by the driver ({}), discarding it", to_string(result));
+
+		create_info.initialDataSize = 0;
+		create_info.pInitialData    = nullptr;
+
+		result = vkCreatePipelineCache(device.get_handle(), &create_info, nullptr, &handle);
+	}
+
+	VK_CHECK(result);
+}
+
+PipelineCache::~PipelineCache()
+{
+	for (auto thread_cache : thread_caches)
+	{
+		if (thread_cache != VK_NULL_HANDLE)
+		{
+			vkDestroyPipelineCache(device.get_handle(), thread_cache, nullptr);
+		}
+	}
+
+	if (handle != VK_NULL_HANDLE)
+	{
+		vkDestroyPipelineCache(device.get_handle(), handle, nullptr);
+	}
+}
+
+VkPipelineCache PipelineCache::get_handle() const
+{
+	return handle;
+}
+
+VkPipelineCache PipelineCache::get_thread_cache(size_t thread_index)
+{
+	std::lock_guard<std::mutex> guard(thread_caches_mutex);
+
+	if (thread_index >= thread_caches.size())
+	{
+		thread_caches.resize(thread_index + 1, VK_NULL_HANDLE);
+	}
+
+	auto &thread_cache = thread_caches[thread_index];
+
+	if (thread_cache == VK_NULL_HANDLE)
+	{
+		VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+		VK_CHECK(vkCreatePipelineCache(device.get_handle(), &create_info, nullptr, &thread_cache));
+	}
+
+	return thread_cache;
+}
+
+void PipelineCache::merge_thread_caches()
+{
+	std::lock_guard<std::mutex> guard(thread_caches_mutex);
+
+	std::vector<VkPipelineCache> src_caches;
+	for (auto thread_cache : thread_caches)
+	{
+		if (thread_cache != VK_NULL_HANDLE)
+		{
+			src_caches.push_back(thread_cache);
+		}
+	}
+
+	if (!src_caches.empty())
+	{
+		VK_CHECK(vkMergePipelineCaches(device.get_handle(), handle, to_u32(src_caches.size()), src_caches.data()));
+	}
+}
+
+void PipelineCache::save()
+{
+	merge_thread_caches();
+
+	size_t size{0};
+	VK_CHECK(vkGetPipelineCacheData(device.get_handle(), handle, &size, nullptr));
+
+	std::vector<uint8_t> data(size);
+	VK_CHECK(vkGetPipelineCacheData(device.get_handle(), handle, &size, data.data()));
+	data.resize(size);
+
+	fs::write_temp(data, filename);
+}
+
+bool PipelineCache::is_compatible(const std::vector<uint8_t> &data, const VkPhysicalDeviceProperties &properties)
+{
+	if (data.size() < header_min_size)
+	{
+		return false;
+	}
+
+	uint32_t header_size    = read_u32(data, header_size_offset);
+	uint32_t header_version = read_u32(data, header_version_offset);
+
+	return header_size >= header_min_size && header_size <= data.size() &&
+	       header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+	       read_u32(data, vendor_id_offset) == properties.vendorID &&
+	       read_u32(data, device_id_offset) == properties.deviceID &&
+	       std::memcmp(data.data() + uuid_offset, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+}        // namespace vkb
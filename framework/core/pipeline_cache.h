@@ -0,0 +1,94 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief Represents a Vulkan Pipeline Cache persisted across runs
+ *        The cache data is loaded from a temporary file when created and is only used
+ *        if its header matches the device it was created for. Worker threads creating
+ *        pipelines concurrently can each get their own cache, which is merged back into
+ *        the main cache before saving.
+ */
+class PipelineCache
+{
+  public:
+	/**
+	 * @brief Creates a Vulkan Pipeline Cache, initialized from a previous run if possible
+	 * @param device The device to use
+	 * @param filename The name of the temporary file storing the cache data
+	 */
+	PipelineCache(Device &device, const std::string &filename = "pipeline_cache.data");
+
+	PipelineCache(const PipelineCache &) = delete;
+
+	PipelineCache(PipelineCache &&) = delete;
+
+	~PipelineCache();
+
+	PipelineCache &operator=(const PipelineCache &) = delete;
+
+	PipelineCache &operator=(PipelineCache &&) = delete;
+
+	/**
+	 * @return The vulkan pipeline cache handle
+	 */
+	VkPipelineCache get_handle() const;
+
+	/**
+	 * @brief Get the pipeline cache of a worker thread, created on first use
+	 * @param thread_index Index of the worker thread
+	 */
+	VkPipelineCache get_thread_cache(size_t thread_index);
+
+	/**
+	 * @brief Merges the pipeline caches of the worker threads into the main cache
+	 *        The worker threads must not be creating pipelines while merging
+	 */
+	void merge_thread_caches();
+
+	/**
+	 * @brief Writes the cache data to the temporary file
+	 */
+	void save();
+
+	/**
+	 * @return True if the header of the cache data matches the given device
+	 */
+	static bool is_compatible(const std::vector<uint8_t> &data, const VkPhysicalDeviceProperties &properties);
+
+  private:
+	Device &device;
+
+	std::string filename;
+
+	VkPipelineCache handle{VK_NULL_HANDLE};
+
+	std::mutex thread_caches_mutex;
+
+	std::vector<VkPipelineCache> thread_caches;
+};
+}        // namespace vkb
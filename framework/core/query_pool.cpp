@@ -17,10 +17,23 @@
 
 #include "query_pool.h"
 
+#include "command_buffer.h"
+#include "common/logging.h"
+#include "common/strings.h"
 #include "device.h"
 
 namespace vkb
 {
+namespace
+{
+VkQueryPoolCreateInfo get_ring_info(const VkQueryPoolCreateInfo &info, uint32_t range_count)
+{
+	VkQueryPoolCreateInfo ring_info = info;
+	ring_info.queryCount            = info.queryCount * range_count;
+	return ring_info;
+}
+}        // namespace
+
 QueryPool::QueryPool(Device &d, const VkQueryPoolCreateInfo &info) :
     device{d}
 {
@@ -64,4 +77,88 @@ VkResult QueryPool::get_results(uint32_t first_query, uint32_t num_queries,
 	                             result_bytes, results, stride, flags);
 }
 
+QueryPoolRing::QueryPoolRing(Device &device, const VkQueryPoolCreateInfo &info, uint32_t range_count) :
+    pool{device, get_ring_info(info, range_count)},
+    query_type{info.queryType},
+    range_size{info.queryCount},
+    host_reset{device.is_enabled("VK_EXT_host_query_reset")},
+    pending(range_count, false)
+{
+	if (query_type == VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR && !host_reset)
+	{
+		throw std::runtime_error("Performance query rings need VK_EXT_host_query_reset");
+	}
+}
+
+QueryPool &QueryPoolRing::get_pool()
+{
+	return pool;
+}
+
+uint32_t QueryPoolRing::get_range_size() const
+{
+	return range_size;
+}
+
+uint32_t QueryPoolRing::begin_range(CommandBuffer &command_buffer, uint32_t range)
+{
+	assert(range < pending.size() && "Query range out of bounds");
+
+	uint32_t first_query = range * range_size;
+
+	// Results which were not read by now are dropped
+	if (host_reset)
+	{
+		pool.host_reset(first_query, range_size);
+	}
+	else
+	{
+		command_buffer.reset_query_pool(pool, first_query, range_size);
+	}
+
+	pending[range] = false;
+
+	return first_query;
+}
+
+void QueryPoolRing::end_range(uint32_t range)
+{
+	assert(range < pending.size() && "Query range out of bounds");
+
+	pending[range] = true;
+}
+
+bool QueryPoolRing::is_pending(uint32_t range) const
+{
+	return range < pending.size() && pending[range];
+}
+
+bool QueryPoolRing::get_results(uint32_t range, void *results, size_t result_bytes, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+	assert(!(flags & VK_QUERY_RESULT_WAIT_BIT) && "Query rings are polled without waiting");
+
+	if (!is_pending(range))
+	{
+		return false;
+	}
+
+	// Nothing is written and VK_NOT_READY returned while any query of the range is unavailable
+	VkResult result = pool.get_results(range * range_size, range_size, result_bytes, results, stride, flags);
+
+	if (result == VK_NOT_READY)
+	{
+		return false;
+	}
+
+	pending[range] = false;
+
+	if (result != VK_SUCCESS)
+	{
+		LOGW("Cannot read query results: {}", to_string(result));
+		return false;
+	}
+
+	return true;
+}
+
 }        // namespace vkb
@@ -17,11 +17,14 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 
 namespace vkb
 {
+class CommandBuffer;
 class Device;
 
 /**
@@ -77,4 +80,66 @@ class QueryPool
 
 	VkQueryPool handle{VK_NULL_HANDLE};
 };
+
+/**
+ * @brief A query pool split in ranges of queries, one per frame in flight, which are reused in turn
+ *
+ * A range is reset when it is begun again, from the host if VK_EXT_host_query_reset is enabled and
+ * in the command buffer otherwise. Its results are read without waiting on the GPU: they are only
+ * returned once all the queries of the range are available.
+ */
+class QueryPoolRing
+{
+  public:
+	/**
+	 * @param info Creation details, queryCount is the number of queries of each range
+	 * @param range_count Number of ranges, usually the number of render frames
+	 */
+	QueryPoolRing(Device &device, const VkQueryPoolCreateInfo &info, uint32_t range_count);
+
+	QueryPool &get_pool();
+
+	/**
+	 * @return The number of queries of each range
+	 */
+	uint32_t get_range_size() const;
+
+	/**
+	 * @brief Resets a range before its queries are recorded again
+	 *        Performance queries cannot be reset in the command buffer using them, they need VK_EXT_host_query_reset.
+	 *        The GPU must be done with the previous use of the range, as for the resources of a render frame.
+	 * @param command_buffer The command buffer recording the queries, outside of a render pass
+	 * @return The index of the first query of the range in the pool
+	 */
+	uint32_t begin_range(CommandBuffer &command_buffer, uint32_t range);
+
+	/**
+	 * @brief Marks the queries of a range as recorded, their results can be read from then on
+	 */
+	void end_range(uint32_t range);
+
+	/**
+	 * @return Whether a range was recorded and its results were not read yet
+	 */
+	bool is_pending(uint32_t range) const;
+
+	/**
+	 * @brief Reads the results of a recorded range if they are all available, without waiting
+	 * @param results Array of get_range_size() results, stride bytes apart
+	 * @param flags A bitmask of VkQueryResultFlagBits, without VK_QUERY_RESULT_WAIT_BIT
+	 * @return True if the results were written, the range is then no longer pending
+	 */
+	bool get_results(uint32_t range, void *results, size_t result_bytes, VkDeviceSize stride, VkQueryResultFlags flags);
+
+  private:
+	QueryPool pool;
+
+	VkQueryType query_type;
+
+	uint32_t range_size;
+
+	bool host_reset;
+
+	std::vector<bool> pending;
+};
 }        // namespace vkb
@@ -27,7 +27,8 @@ Queue::Queue(Device &device, uint32_t family_index, VkQueueFamilyProperties prop
     family_index{family_index},
     index{index},
     can_present{can_present},
-    properties{properties}
+    properties{properties},
+    submit_mutex{std::make_shared<std::mutex>()}
 {
 	vkGetDeviceQueue(device.get_handle(), family_index, index, &handle);
 }
@@ -38,7 +39,8 @@ Queue::Queue(Queue &&other) :
     family_index{other.family_index},
     index{other.index},
     can_present{other.can_present},
-    properties{other.properties}
+    properties{other.properties},
+    submit_mutex{std::move(other.submit_mutex)}
 {
 	other.handle       = VK_NULL_HANDLE;
 	other.family_index = {};
@@ -79,6 +81,10 @@ VkBool32 Queue::support_present() const
 
 VkResult Queue::submit(const std::vector<VkSubmitInfo> &submit_infos, VkFence fence) const
 {
+	device.flush_deferred_writes();
+
+	std::lock_guard<std::mutex> guard(*submit_mutex);
+
 	return vkQueueSubmit(handle, to_u32(submit_infos.size()), submit_infos.data(), fence);
 }
 
@@ -91,6 +97,17 @@ VkResult Queue::submit(const CommandBuffer &command_buffer, VkFence fence) const
 	return submit({submit_info}, fence);
 }
 
+#ifdef VK_KHR_synchronization2
+VkResult Queue::submit(const VkSubmitInfo2KHR &submit_info, VkFence fence) const
+{
+	device.flush_deferred_writes();
+
+	std::lock_guard<std::mutex> guard(*submit_mutex);
+
+	return vkQueueSubmit2KHR(handle, 1, &submit_info, fence);
+}
+#endif
+
 VkResult Queue::present(const VkPresentInfoKHR &present_info) const
 {
 	if (!can_present)
@@ -98,11 +115,15 @@ VkResult Queue::present(const VkPresentInfoKHR &present_info) const
 		return VK_ERROR_INCOMPATIBLE_DISPLAY_KHR;
 	}
 
+	std::lock_guard<std::mutex> guard(*submit_mutex);
+
 	return vkQueuePresentKHR(handle, &present_info);
 }        // namespace vkb
 
 VkResult Queue::wait_idle() const
 {
+	std::lock_guard<std::mutex> guard(*submit_mutex);
+
 	return vkQueueWaitIdle(handle);
 }
 }        // namespace vkb
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/swapchain.h"
@@ -26,6 +29,9 @@ namespace vkb
 class Device;
 class CommandBuffer;
 
+/**
+ * @brief A device queue, its submissions are serialized so that render contexts on several threads can share it
+ */
 class Queue
 {
   public:
@@ -55,6 +61,13 @@ class Queue
 
 	VkResult submit(const CommandBuffer &command_buffer, VkFence fence) const;
 
+#ifdef VK_KHR_synchronization2
+	/**
+	 * @brief Submits with vkQueueSubmit2KHR, the device must have VK_KHR_synchronization2 enabled
+	 */
+	VkResult submit(const VkSubmitInfo2KHR &submit_info, VkFence fence) const;
+#endif
+
 	VkResult present(const VkPresentInfoKHR &present_infos) const;
 
 	VkResult wait_idle() const;
@@ -71,5 +84,8 @@ class Queue
 	VkBool32 can_present{VK_FALSE};
 
 	VkQueueFamilyProperties properties{};
+
+	/// Shared by the copies of the queue, vkQueueSubmit and vkQueuePresentKHR need external synchronization
+	std::shared_ptr<std::mutex> submit_mutex;
 };
 }        // namespace vkb
@@ -90,7 +90,14 @@ inline const VkAttachmentReference2KHR *get_depth_resolve_reference(const VkSubp
 
 inline const VkAttachmentReference2KHR *get_depth_resolve_reference(const VkSubpassDescription2KHR &subpass_description)
 {
-	auto description_depth_resolve = static_cast<const VkSubpassDescriptionDepthStencilResolveKHR *>(subpass_description.pNext);
+	// The depth resolve may follow other structures in the chain, such as the shading rate attachment
+	auto next = static_cast<const VkBaseInStructure *>(subpass_description.pNext);
+	while (next && next->sType != VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_DEPTH_STENCIL_RESOLVE_KHR)
+	{
+		next = next->pNext;
+	}
+
+	auto description_depth_resolve = reinterpret_cast<const VkSubpassDescriptionDepthStencilResolveKHR *>(next);
 
 	const VkAttachmentReference2KHR *depth_resolve_attachment = nullptr;
 	if (description_depth_resolve)
@@ -101,6 +108,46 @@ inline const VkAttachmentReference2KHR *get_depth_resolve_reference(const VkSubp
 	return depth_resolve_attachment;
 }
 
+#ifdef VK_KHR_fragment_shading_rate
+inline bool set_shading_rate_attachment(VkSubpassDescription &subpass_description, VkFragmentShadingRateAttachmentInfoKHR &shading_rate, VkAttachmentReference &shading_rate_attachment)
+{
+	// VkSubpassDescription cannot have pNext point to a VkFragmentShadingRateAttachmentInfoKHR containing a VkAttachmentReference
+	return false;
+}
+
+inline bool set_shading_rate_attachment(VkSubpassDescription2KHR &subpass_description, VkFragmentShadingRateAttachmentInfoKHR &shading_rate, VkAttachmentReference2KHR &shading_rate_attachment)
+{
+	shading_rate.pFragmentShadingRateAttachment = &shading_rate_attachment;
+	shading_rate.pNext                          = subpass_description.pNext;
+	subpass_description.pNext                   = &shading_rate;
+
+	return true;
+}
+#endif
+
+inline void set_view_masks(VkRenderPassCreateInfo &create_info, std::vector<VkSubpassDescription> &subpass_descriptions, VkRenderPassMultiviewCreateInfoKHR &multiview,
+                           const std::vector<uint32_t> &view_masks, const uint32_t &correlation_mask)
+{
+	// VkSubpassDescription has no view mask, the masks of all subpasses are chained to the create info
+	multiview.subpassCount         = to_u32(view_masks.size());
+	multiview.pViewMasks           = view_masks.data();
+	multiview.correlationMaskCount = 1;
+	multiview.pCorrelationMasks    = &correlation_mask;
+	create_info.pNext              = &multiview;
+}
+
+inline void set_view_masks(VkRenderPassCreateInfo2KHR &create_info, std::vector<VkSubpassDescription2KHR> &subpass_descriptions, VkRenderPassMultiviewCreateInfoKHR &multiview,
+                           const std::vector<uint32_t> &view_masks, const uint32_t &correlation_mask)
+{
+	for (size_t i = 0; i < view_masks.size(); ++i)
+	{
+		subpass_descriptions[i].viewMask = view_masks[i];
+	}
+
+	create_info.correlatedViewMaskCount = 1;
+	create_info.pCorrelatedViewMasks    = &correlation_mask;
+}
+
 inline VkResult create_vk_renderpass(VkDevice device, VkRenderPassCreateInfo &create_info, VkRenderPass *handle)
 {
 	return vkCreateRenderPass(device, &create_info, nullptr, handle);
@@ -249,7 +296,7 @@ void set_attachment_layouts(std::vector<T_SubpassDescription> &subpass_descripti
 }
 
 template <typename T>
-std::vector<T> get_subpass_dependencies(const size_t subpass_count)
+std::vector<T> get_subpass_dependencies(const size_t subpass_count, bool multiview)
 {
 	std::vector<T> dependencies(subpass_count - 1);
 
@@ -265,6 +312,12 @@ std::vector<T> get_subpass_dependencies(const size_t subpass_count)
 			dependencies[i].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 			dependencies[i].dstAccessMask   = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
 			dependencies[i].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+			// Each view of a subpass only reads the same view of the previous one
+			if (multiview)
+			{
+				dependencies[i].dependencyFlags |= VK_DEPENDENCY_VIEW_LOCAL_BIT_KHR;
+			}
 		}
 	}
 
@@ -294,6 +347,7 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 	std::vector<std::vector<T_AttachmentReference>> depth_stencil_attachments{subpass_count};
 	std::vector<std::vector<T_AttachmentReference>> color_resolve_attachments{subpass_count};
 	std::vector<std::vector<T_AttachmentReference>> depth_resolve_attachments{subpass_count};
+	std::vector<std::vector<T_AttachmentReference>> shading_rate_attachments{subpass_count};
 
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
@@ -342,11 +396,21 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 				}
 			}
 		}
+
+#ifdef VK_KHR_fragment_shading_rate
+		if (subpass.shading_rate_texel_size.width != 0 && subpass.shading_rate_texel_size.height != 0)
+		{
+			shading_rate_attachments[i].push_back(get_attachment_reference<T_AttachmentReference>(subpass.shading_rate_attachment, VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR));
+		}
+#endif
 	}
 
 	std::vector<T_SubpassDescription> subpass_descriptions;
 	subpass_descriptions.reserve(subpass_count);
 	VkSubpassDescriptionDepthStencilResolveKHR depth_resolve{};
+#ifdef VK_KHR_fragment_shading_rate
+	std::vector<VkFragmentShadingRateAttachmentInfoKHR> shading_rates(subpasses.size(), {VK_STRUCTURE_TYPE_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR});
+#endif
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		auto &subpass = subpasses[i];
@@ -385,6 +449,25 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 			}
 		}
 
+#ifdef VK_KHR_fragment_shading_rate
+		if (!shading_rate_attachments[i].empty())
+		{
+			auto &reference = shading_rate_attachments[i][0];
+
+			shading_rates[i].shadingRateAttachmentTexelSize = subpass.shading_rate_texel_size;
+
+			if (set_shading_rate_attachment(subpass_description, shading_rates[i], reference))
+			{
+				// The rates are written before the render pass, which only reads them
+				auto &description         = attachment_descriptions[reference.attachment];
+				description.initialLayout = reference.layout;
+				description.finalLayout   = reference.layout;
+				description.loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+				description.storeOp       = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			}
+		}
+#endif
+
 		subpass_descriptions.push_back(subpass_description);
 	}
 
@@ -430,7 +513,30 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 		color_output_count.push_back(to_u32(color_attachments[i].size()));
 	}
 
-	const auto &subpass_dependencies = get_subpass_dependencies<T_SubpassDependency>(subpass_count);
+	final_layouts.reserve(attachment_descriptions.size());
+	for (auto &attachment_description : attachment_descriptions)
+	{
+		final_layouts.push_back(attachment_description.finalLayout);
+	}
+
+	// Multiview render passes render the views of every subpass, which are rendered together as they are close
+	std::vector<uint32_t> view_masks;
+	uint32_t              correlation_mask{0};
+
+	for (auto &subpass : subpasses)
+	{
+		view_masks.push_back(subpass.view_mask);
+		correlation_mask |= subpass.view_mask;
+	}
+
+	bool multiview = correlation_mask != 0;
+
+	if (multiview && std::find(view_masks.begin(), view_masks.end(), 0u) != view_masks.end())
+	{
+		throw std::runtime_error("Either all or none of the subpasses of a render pass must have a view mask");
+	}
+
+	const auto &subpass_dependencies = get_subpass_dependencies<T_SubpassDependency>(subpass_count, multiview);
 
 	T_RenderPassCreateInfo create_info{};
 	set_structure_type(create_info);
@@ -441,6 +547,13 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 	create_info.dependencyCount = to_u32(subpass_dependencies.size());
 	create_info.pDependencies   = subpass_dependencies.data();
 
+	VkRenderPassMultiviewCreateInfoKHR multiview_info{VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO_KHR};
+
+	if (multiview)
+	{
+		set_view_masks(create_info, subpass_descriptions, multiview_info, view_masks, correlation_mask);
+	}
+
 	auto result = create_vk_renderpass(device.get_handle(), create_info, &handle);
 
 	if (result != VK_SUCCESS)
@@ -468,7 +581,8 @@ RenderPass::RenderPass(RenderPass &&other) :
     device{other.device},
     handle{other.handle},
     subpass_count{other.subpass_count},
-    color_output_count{other.color_output_count}
+    color_output_count{other.color_output_count},
+    final_layouts{std::move(other.final_layouts)}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -494,4 +608,9 @@ const VkExtent2D RenderPass::get_render_area_granularity() const
 
 	return render_area_granularity;
 }
+
+const std::vector<VkImageLayout> &RenderPass::get_final_layouts() const
+{
+	return final_layouts;
+}
 }        // namespace vkb
@@ -38,6 +38,15 @@ struct SubpassInfo
 	uint32_t depth_stencil_resolve_attachment;
 
 	VkResolveModeFlagBits depth_stencil_resolve_mode;
+
+	/// Attachment setting the fragment shading rate of the subpass, only used with a non-zero texel size
+	uint32_t shading_rate_attachment;
+
+	/// Framebuffer pixels covered by each texel of the shading rate attachment
+	VkExtent2D shading_rate_texel_size;
+
+	/// Views rendered by the subpass with VK_KHR_multiview, into the layers of the attachments, 0 for a single view
+	uint32_t view_mask;
 };
 
 class RenderPass
@@ -64,6 +73,11 @@ class RenderPass
 
 	const VkExtent2D get_render_area_granularity() const;
 
+	/**
+	 * @return The layout each attachment is left in when the render pass ends
+	 */
+	const std::vector<VkImageLayout> &get_final_layouts() const;
+
   private:
 	Device &device;
 
@@ -75,5 +89,7 @@ class RenderPass
 	void create_renderpass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses);
 
 	std::vector<uint32_t> color_output_count;
+
+	std::vector<VkImageLayout> final_layouts;
 };
 }        // namespace vkb
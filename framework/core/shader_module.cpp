@@ -17,10 +17,13 @@
 
 #include "shader_module.h"
 
+#include <algorithm>
+
 #include "common/logging.h"
 #include "device.h"
 #include "glsl_compiler.h"
 #include "platform/filesystem.h"
+#include "spirv_cache.h"
 #include "spirv_reflection.h"
 
 namespace vkb
@@ -42,22 +45,32 @@ ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const Sh
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
 	}
 
-	GLSLCompiler glsl_compiler;
+	SPIRVCache spirv_cache;
+
+	auto cache_key = spirv_cache.get_key(stage, glsl_source, entry_point, shader_variant);
 
-	// Compile the GLSL source
-	if (!glsl_compiler.compile_to_spirv(stage, glsl_source.get_data(), entry_point, shader_variant, spirv, info_log))
+	// Skip the compilation and reflection if a previous run already did them
+	if (!spirv_cache.load(cache_key, spirv, resources))
 	{
-		LOGE("Shader compilation failed for shader \"{}\"", glsl_source.get_filename());
-		LOGE("{}", info_log);
-		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
-	}
+		GLSLCompiler glsl_compiler;
 
-	SPIRVReflection spirv_reflection;
+		// Compile the GLSL source
+		if (!glsl_compiler.compile_to_spirv(stage, glsl_source.get_data(), entry_point, shader_variant, spirv, info_log))
+		{
+			LOGE("Shader compilation failed for shader \"{}\"", glsl_source.get_filename());
+			LOGE("{}", info_log);
+			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		}
 
-	// Reflect all shader resouces
-	if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
-	{
-		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		SPIRVReflection spirv_reflection;
+
+		// Reflect all shader resouces
+		if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+		{
+			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		}
+
+		spirv_cache.store(cache_key, stage, glsl_source, entry_point, shader_variant, spirv, resources);
 	}
 
 	// Generate a unique id, determined by source and variant
@@ -157,6 +170,12 @@ void ShaderVariant::add_definitions(const std::vector<std::string> &definitions)
 
 void ShaderVariant::add_define(const std::string &def)
 {
+	// Subpasses sharing the meshes of a scene add the same definitions to their variants
+	if (std::find(processes.begin(), processes.end(), "D" + def) != processes.end())
+	{
+		return;
+	}
+
 	processes.push_back("D" + def);
 
 	std::string tmp_def = def;
@@ -257,4 +276,26 @@ const std::vector<uint8_t> &ShaderSource::get_data() const
 {
 	return data;
 }
+
+bool ShaderSource::reload()
+{
+	if (filename.empty())
+	{
+		return false;
+	}
+
+	auto new_data = fs::read_shader(filename);
+
+	if (new_data == data)
+	{
+		return false;
+	}
+
+	data = std::move(new_data);
+
+	std::hash<std::string> hasher{};
+	id = hasher(std::string{data.cbegin(), data.cend()});
+
+	return true;
+}
 }        // namespace vkb
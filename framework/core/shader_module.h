@@ -36,6 +36,7 @@ enum class ShaderResourceType
 	Sampler,
 	BufferUniform,
 	BufferStorage,
+	AccelerationStructure,
 	PushConstant,
 	SpecializationConstant,
 	All
@@ -46,7 +47,9 @@ enum class ShaderResourceMode
 {
 	Static,
 	Dynamic,
-	UpdateAfterBind
+	UpdateAfterBind,
+	/// The whole set of the resource is pushed into the command buffer instead of being allocated
+	PushDescriptor
 };
 
 /// Store shader resource data.
@@ -102,7 +105,7 @@ class ShaderVariant
 	void add_definitions(const std::vector<std::string> &definitions);
 
 	/**
-	 * @brief Adds a define macro to the shader
+	 * @brief Adds a define macro to the shader, unless the variant already defines it
 	 * @param def String which should go to the right of a define directive
 	 */
 	void add_define(const std::string &def);
@@ -158,6 +161,12 @@ class ShaderSource
 
 	const std::vector<uint8_t> &get_data() const;
 
+	/**
+	 * @brief Reads the file of the source again, only sources loaded from a file can be reloaded
+	 * @return Whether the content changed, which also changes the id
+	 */
+	bool reload();
+
   private:
 	size_t id;
 
@@ -304,6 +304,14 @@ Swapchain::Swapchain(Swapchain &old_swapchain, const VkExtent2D &extent, const V
 	create();
 }
 
+Swapchain::Swapchain(Swapchain &old_swapchain, const VkPresentModeKHR present_mode) :
+    Swapchain{old_swapchain, old_swapchain.device, old_swapchain.surface, old_swapchain.properties.extent, old_swapchain.properties.image_count, old_swapchain.properties.pre_transform, present_mode, old_swapchain.image_usage_flags}
+{
+	present_mode_priority_list   = old_swapchain.present_mode_priority_list;
+	surface_format_priority_list = old_swapchain.surface_format_priority_list;
+	create();
+}
+
 Swapchain::Swapchain(Device &                              device,
                      VkSurfaceKHR                          surface,
                      const VkExtent2D &                    extent,
@@ -359,8 +367,7 @@ Swapchain::Swapchain(Swapchain &                           old_swapchain,
 	properties.extent         = choose_extent(extent, surface_capabilities.minImageExtent, surface_capabilities.maxImageExtent, surface_capabilities.currentExtent);
 	properties.array_layers   = choose_image_array_layers(1U, surface_capabilities.maxImageArrayLayers);
 	properties.surface_format = choose_surface_format(properties.surface_format, surface_formats, surface_format_priority_list);
-	VkFormatProperties format_properties;
-	vkGetPhysicalDeviceFormatProperties(this->device.get_gpu().get_handle(), properties.surface_format.format, &format_properties);
+	VkFormatProperties format_properties = this->device.get_gpu().get_format_properties(properties.surface_format.format);
 	this->image_usage_flags    = choose_image_usage(image_usage_flags, surface_capabilities.supportedUsageFlags, format_properties.optimalTilingFeatures);
 	properties.image_usage     = composite_image_flags(this->image_usage_flags);
 	properties.pre_transform   = choose_transform(transform, surface_capabilities.supportedTransforms, surface_capabilities.currentTransform);
@@ -385,6 +392,9 @@ Swapchain::Swapchain(Swapchain &&other) :
     handle{other.handle},
     image_usage_flags{std::move(other.image_usage_flags)},
     images{std::move(other.images)},
+    compatible_present_modes{std::move(other.compatible_present_modes)},
+    vblank_counter{other.vblank_counter},
+    device_group_present_mode{other.device_group_present_mode},
     properties{std::move(other.properties)}
 {
 	other.handle  = VK_NULL_HANDLE;
@@ -410,6 +420,49 @@ void Swapchain::create()
 	create_info.oldSwapchain     = properties.old_swapchain;
 	create_info.surface          = surface;
 
+#ifdef VK_EXT_swapchain_maintenance1
+	VkSwapchainPresentModesCreateInfoEXT present_modes_info{VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_MODES_CREATE_INFO_EXT};
+
+	query_compatible_present_modes();
+
+	// Presentations may then switch between these modes
+	if (!compatible_present_modes.empty())
+	{
+		present_modes_info.presentModeCount = to_u32(compatible_present_modes.size());
+		present_modes_info.pPresentModes    = compatible_present_modes.data();
+
+		create_info.pNext = &present_modes_info;
+	}
+#endif
+
+#ifdef VK_EXT_display_control
+	VkSwapchainCounterCreateInfoEXT counter_info{VK_STRUCTURE_TYPE_SWAPCHAIN_COUNTER_CREATE_INFO_EXT};
+
+	vblank_counter = is_vblank_counter_supported();
+
+	// Counts the refresh cycles of the display, to find the ones that presented no new frame
+	if (vblank_counter)
+	{
+		counter_info.surfaceCounters = VK_SURFACE_COUNTER_VBLANK_BIT_EXT;
+		counter_info.pNext           = create_info.pNext;
+
+		create_info.pNext = &counter_info;
+	}
+#endif
+
+	VkDeviceGroupSwapchainCreateInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_SWAPCHAIN_CREATE_INFO_KHR};
+
+	device_group_present_mode = choose_device_group_present_mode();
+
+	// Each GPU of the device may then present the images it rendered
+	if (device_group_present_mode != 0)
+	{
+		device_group_info.modes = device_group_present_mode;
+		device_group_info.pNext = create_info.pNext;
+
+		create_info.pNext = &device_group_info;
+	}
+
 	VkResult result = vkCreateSwapchainKHR(device.get_handle(), &create_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
@@ -445,11 +498,28 @@ SwapchainProperties &Swapchain::get_properties()
 	return properties;
 }
 
-VkResult Swapchain::acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence)
+VkResult Swapchain::acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence, uint32_t device_mask)
 {
+	if (device_mask != 0 && device_group_present_mode != 0)
+	{
+		VkAcquireNextImageInfoKHR acquire_info{VK_STRUCTURE_TYPE_ACQUIRE_NEXT_IMAGE_INFO_KHR};
+		acquire_info.swapchain  = handle;
+		acquire_info.timeout    = std::numeric_limits<uint64_t>::max();
+		acquire_info.semaphore  = image_acquired_semaphore;
+		acquire_info.fence      = fence;
+		acquire_info.deviceMask = device_mask;
+
+		return vkAcquireNextImage2KHR(device.get_handle(), &acquire_info, &image_index);
+	}
+
 	return vkAcquireNextImageKHR(device.get_handle(), handle, std::numeric_limits<uint64_t>::max(), image_acquired_semaphore, fence, &image_index);
 }
 
+VkDeviceGroupPresentModeFlagBitsKHR Swapchain::get_device_group_present_mode() const
+{
+	return device_group_present_mode;
+}
+
 const VkExtent2D &Swapchain::get_extent() const
 {
 	return properties.extent;
@@ -491,6 +561,225 @@ void Swapchain::set_surface_format_priority(const std::vector<VkSurfaceFormatKHR
 }
 VkPresentModeKHR Swapchain::get_present_mode() const
 {
-	return present_mode;
+	return properties.present_mode;
+}
+
+const std::vector<VkPresentModeKHR> &Swapchain::get_compatible_present_modes() const
+{
+	return compatible_present_modes;
+}
+
+bool Swapchain::is_present_mode_compatible(VkPresentModeKHR present_mode) const
+{
+	return std::find(compatible_present_modes.begin(), compatible_present_modes.end(), present_mode) != compatible_present_modes.end();
+}
+
+bool Swapchain::can_release_images() const
+{
+#ifdef VK_EXT_swapchain_maintenance1
+	return device.is_enabled(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
+#else
+	return false;
+#endif
+}
+
+VkResult Swapchain::release_images(const std::vector<uint32_t> &image_indices) const
+{
+#ifdef VK_EXT_swapchain_maintenance1
+	if (can_release_images())
+	{
+		VkReleaseSwapchainImagesInfoEXT release_info{VK_STRUCTURE_TYPE_RELEASE_SWAPCHAIN_IMAGES_INFO_EXT};
+		release_info.swapchain       = handle;
+		release_info.imageIndexCount = to_u32(image_indices.size());
+		release_info.pImageIndices   = image_indices.data();
+
+		return vkReleaseSwapchainImagesEXT(device.get_handle(), &release_info);
+	}
+#endif
+
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+bool Swapchain::has_vblank_counter() const
+{
+	return vblank_counter;
+}
+
+VkResult Swapchain::get_vblank_counter(uint64_t &counter) const
+{
+#ifdef VK_EXT_display_control
+	if (vblank_counter)
+	{
+		return vkGetSwapchainCounterEXT(device.get_handle(), handle, VK_SURFACE_COUNTER_VBLANK_BIT_EXT, &counter);
+	}
+#endif
+
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+VkResult Swapchain::get_refresh_duration(uint64_t &duration) const
+{
+#ifdef VK_GOOGLE_display_timing
+	if (device.is_enabled(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME))
+	{
+		VkRefreshCycleDurationGOOGLE refresh_cycle{};
+
+		VkResult result = vkGetRefreshCycleDurationGOOGLE(device.get_handle(), handle, &refresh_cycle);
+
+		duration = refresh_cycle.refreshDuration;
+
+		return result;
+	}
+#endif
+
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+VkResult Swapchain::get_past_presentation_timings(std::vector<VkPastPresentationTimingGOOGLE> &timings) const
+{
+	timings.clear();
+
+#ifdef VK_GOOGLE_display_timing
+	if (device.is_enabled(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME))
+	{
+		uint32_t count{0};
+
+		VkResult result = vkGetPastPresentationTimingGOOGLE(device.get_handle(), handle, &count, nullptr);
+
+		if (result != VK_SUCCESS || count == 0)
+		{
+			return result;
+		}
+
+		timings.resize(count);
+
+		result = vkGetPastPresentationTimingGOOGLE(device.get_handle(), handle, &count, timings.data());
+
+		timings.resize(count);
+
+		return result;
+	}
+#endif
+
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+bool Swapchain::is_vblank_counter_supported() const
+{
+#ifdef VK_EXT_display_control
+	if (!device.is_enabled(VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME))
+	{
+		return false;
+	}
+
+	VkSurfaceCapabilities2EXT surface_capabilities{VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_EXT};
+
+	VkResult result = vkGetPhysicalDeviceSurfaceCapabilities2EXT(device.get_gpu().get_handle(), surface, &surface_capabilities);
+
+	// Only display surfaces count their refresh cycles
+	return result == VK_SUCCESS && (surface_capabilities.supportedSurfaceCounters & VK_SURFACE_COUNTER_VBLANK_BIT_EXT);
+#else
+	return false;
+#endif
+}
+
+VkDeviceGroupPresentModeFlagBitsKHR Swapchain::choose_device_group_present_mode() const
+{
+	auto physical_device_count = device.get_physical_device_count();
+
+	if (physical_device_count < 2)
+	{
+		return {};
+	}
+
+	VkDeviceGroupPresentCapabilitiesKHR present_capabilities{VK_STRUCTURE_TYPE_DEVICE_GROUP_PRESENT_CAPABILITIES_KHR};
+	VK_CHECK(vkGetDeviceGroupPresentCapabilitiesKHR(device.get_handle(), &present_capabilities));
+
+	VkDeviceGroupPresentModeFlagsKHR surface_modes{0};
+	VK_CHECK(vkGetDeviceGroupSurfacePresentModesKHR(device.get_handle(), surface, &surface_modes));
+
+	auto modes = present_capabilities.modes & surface_modes;
+
+	// Every GPU presents the images it rendered itself
+	bool local = (modes & VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_BIT_KHR) != 0;
+
+	// A GPU with a presentation engine presents the images of the GPUs in its present mask, e.g. the one the display is connected to
+	bool remote = (modes & VK_DEVICE_GROUP_PRESENT_MODE_REMOTE_BIT_KHR) != 0;
+
+	for (uint32_t i = 0; i < physical_device_count; ++i)
+	{
+		local = local && (present_capabilities.presentMask[i] & (1u << i)) != 0;
+
+		bool presented = false;
+		for (uint32_t j = 0; j < physical_device_count; ++j)
+		{
+			presented = presented || (present_capabilities.presentMask[j] & (1u << i)) != 0;
+		}
+		remote = remote && presented;
+	}
+
+	if (local)
+	{
+		return VK_DEVICE_GROUP_PRESENT_MODE_LOCAL_BIT_KHR;
+	}
+
+	if (remote)
+	{
+		return VK_DEVICE_GROUP_PRESENT_MODE_REMOTE_BIT_KHR;
+	}
+
+	LOGW("The surface cannot present the images of every GPU of the device");
+	return {};
+}
+
+void Swapchain::query_compatible_present_modes()
+{
+	compatible_present_modes.clear();
+
+#ifdef VK_EXT_swapchain_maintenance1
+	if (!device.is_enabled(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	VkPhysicalDeviceSurfaceInfo2KHR surface_info{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SURFACE_INFO_2_KHR};
+	VkSurfacePresentModeEXT         surface_present_mode{VK_STRUCTURE_TYPE_SURFACE_PRESENT_MODE_EXT};
+
+	surface_info.surface = surface;
+	surface_info.pNext   = &surface_present_mode;
+
+	VkSurfacePresentModeCompatibilityEXT compatibility{VK_STRUCTURE_TYPE_SURFACE_PRESENT_MODE_COMPATIBILITY_EXT};
+	VkSurfaceCapabilities2KHR            capabilities{VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_KHR};
+
+	capabilities.pNext = &compatibility;
+
+	surface_present_mode.presentMode = properties.present_mode;
+
+	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilities2KHR(device.get_gpu().get_handle(), &surface_info, &capabilities));
+
+	std::vector<VkPresentModeKHR> candidates(compatibility.presentModeCount);
+	compatibility.pPresentModes = candidates.data();
+
+	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilities2KHR(device.get_gpu().get_handle(), &surface_info, &capabilities));
+
+	candidates.resize(compatibility.presentModeCount);
+
+	// The swapchain needs as many images as the most demanding of its present modes
+	for (auto candidate : candidates)
+	{
+		VkSurfaceCapabilities2KHR candidate_capabilities{VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_KHR};
+
+		surface_present_mode.presentMode = candidate;
+
+		VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilities2KHR(device.get_gpu().get_handle(), &surface_info, &candidate_capabilities));
+
+		if (candidate == properties.present_mode || candidate_capabilities.surfaceCapabilities.minImageCount <= properties.image_count)
+		{
+			compatible_present_modes.push_back(candidate);
+		}
+	}
+
+	LOGI("Swapchain can switch between {} present modes", compatible_present_modes.size());
+#endif
 }
 }        // namespace vkb
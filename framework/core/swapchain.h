@@ -70,6 +70,12 @@ class Swapchain
 	 */
 	Swapchain(Swapchain &swapchain, const VkExtent2D &extent, const VkSurfaceTransformFlagBitsKHR transform);
 
+	/**
+	 * @brief Constructor to create a swapchain by changing the present mode
+	 *        only and preserving the configuration from the old swapchain.
+	 */
+	Swapchain(Swapchain &old_swapchain, const VkPresentModeKHR present_mode);
+
 	/**
 	 * @brief Constructor to create a swapchain.
 	 */
@@ -114,7 +120,10 @@ class Swapchain
 
 	SwapchainProperties &get_properties();
 
-	VkResult acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence = VK_NULL_HANDLE);
+	/**
+	 * @param device_mask The GPU which renders to the image on a device of several GPUs, all of them if 0
+	 */
+	VkResult acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence = VK_NULL_HANDLE, uint32_t device_mask = 0);
 
 	const VkExtent2D &get_extent() const;
 
@@ -130,6 +139,57 @@ class Swapchain
 
 	VkPresentModeKHR get_present_mode() const;
 
+	/**
+	 * @return The present modes which presentations can switch to without recreating the swapchain,
+	 *         including the one it was created with, empty without VK_EXT_swapchain_maintenance1
+	 */
+	const std::vector<VkPresentModeKHR> &get_compatible_present_modes() const;
+
+	/**
+	 * @return Whether presentations can switch to a present mode without recreating the swapchain
+	 */
+	bool is_present_mode_compatible(VkPresentModeKHR present_mode) const;
+
+	/**
+	 * @return Whether acquired images can be released without presenting them
+	 */
+	bool can_release_images() const;
+
+	/**
+	 * @brief Gives acquired images back to the presentation engine without presenting them
+	 *        Needs VK_EXT_swapchain_maintenance1, the semaphores and fences of the acquisitions
+	 *        are still signaled.
+	 * @param image_indices The indices of the acquired images
+	 */
+	VkResult release_images(const std::vector<uint32_t> &image_indices) const;
+
+	/**
+	 * @return How each GPU of a device of several GPUs presents the images it rendered, either itself or through
+	 *         another GPU, 0 if the device has one GPU or the surface cannot be presented from each of them
+	 */
+	VkDeviceGroupPresentModeFlagBitsKHR get_device_group_present_mode() const;
+
+	/**
+	 * @return Whether the swapchain counts the refresh cycles of its display,
+	 *         needs VK_EXT_display_control and a display surface
+	 */
+	bool has_vblank_counter() const;
+
+	/**
+	 * @brief Gets the number of refresh cycles of the display since the swapchain was created
+	 */
+	VkResult get_vblank_counter(uint64_t &counter) const;
+
+	/**
+	 * @brief Gets the duration of a refresh cycle of the display in nanoseconds, needs VK_GOOGLE_display_timing
+	 */
+	VkResult get_refresh_duration(uint64_t &duration) const;
+
+	/**
+	 * @brief Gets the timings of the presentations completed since the last call, needs VK_GOOGLE_display_timing
+	 */
+	VkResult get_past_presentation_timings(std::vector<VkPastPresentationTimingGOOGLE> &timings) const;
+
 	/**
 	 * @brief Sets the order in which the swapchain prioritizes selecting its present mode
 	 */
@@ -153,6 +213,14 @@ class Swapchain
 
 	std::vector<VkPresentModeKHR> present_modes{};
 
+	/// Present modes the swapchain was created to switch between at present time
+	std::vector<VkPresentModeKHR> compatible_present_modes{};
+
+	/// Whether the swapchain was created with a vblank counter
+	bool vblank_counter{false};
+
+	VkDeviceGroupPresentModeFlagBitsKHR device_group_present_mode{};
+
 	SwapchainProperties properties;
 
 	// A list of present modes in order of priority (vector[0] has high priority, vector[size-1] has low priority)
@@ -167,8 +235,15 @@ class Swapchain
 	    {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
 	    {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR}};
 
-	VkPresentModeKHR present_mode{};
-
 	std::set<VkImageUsageFlagBits> image_usage_flags;
+
+	/// Queries the present modes compatible with the chosen one which need no more images than it
+	void query_compatible_present_modes();
+
+	/// Whether the surface supports counting its refresh cycles
+	bool is_vblank_counter_supported() const;
+
+	/// Chooses how the GPUs of the device present the images they render
+	VkDeviceGroupPresentModeFlagBitsKHR choose_device_group_present_mode() const;
 };
 }        // namespace vkb
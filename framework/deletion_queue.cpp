@@ -0,0 +1,113 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "deletion_queue.h"
+
+namespace vkb
+{
+void DeletionQueue::retire_function(std::function<void()> &&destroy)
+{
+	push(std::unique_ptr<Entry>(new Function(std::move(destroy))));
+}
+
+void DeletionQueue::push(std::unique_ptr<Entry> &&entry)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	entry->number = submission_count + 1;
+	entries.push_back(std::move(entry));
+}
+
+uint64_t DeletionQueue::submit()
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	pending_submissions.insert(++submission_count);
+
+	return submission_count;
+}
+
+void DeletionQueue::complete(uint64_t number)
+{
+	std::deque<std::unique_ptr<Entry>> completed;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+
+		pending_submissions.erase(number);
+
+		completed = collect();
+	}
+
+	// Destructors may retire other objects
+	completed.clear();
+}
+
+void DeletionQueue::complete_all()
+{
+	std::deque<std::unique_ptr<Entry>> completed;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+
+		pending_submissions.clear();
+
+		completed = collect();
+	}
+
+	completed.clear();
+}
+
+void DeletionQueue::clear()
+{
+	std::deque<std::unique_ptr<Entry>> retired;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+
+		pending_submissions.clear();
+
+		std::swap(retired, entries);
+	}
+
+	retired.clear();
+}
+
+size_t DeletionQueue::get_pending_count() const
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	return entries.size();
+}
+
+std::deque<std::unique_ptr<DeletionQueue::Entry>> DeletionQueue::collect()
+{
+	// Submissions complete out of order across render contexts, so only those before the oldest pending one are done
+	uint64_t completed_number = pending_submissions.empty() ? submission_count : *pending_submissions.begin() - 1;
+
+	std::deque<std::unique_ptr<Entry>> completed;
+
+	while (!entries.empty() && entries.front()->number <= completed_number)
+	{
+		completed.push_back(std::move(entries.front()));
+		entries.pop_front();
+	}
+
+	return completed;
+}
+}        // namespace vkb
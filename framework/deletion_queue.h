@@ -0,0 +1,150 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <type_traits>
+
+namespace vkb
+{
+/**
+ * @brief Destroys objects of the device once the submissions which may use them have completed
+ *
+ * Retired objects are tagged with the number of the next frame submission, as the command buffers
+ * being recorded may still use them. Render contexts number their submissions with submit() and
+ * report their completion with complete(), when they wait for the fence of a frame. Objects are
+ * destroyed once every submission up to their number has completed, so that caches can evict or
+ * replace resources without waiting for the device to be idle.
+ *
+ * Submissions made outside of render contexts are not tracked, they must complete on their own,
+ * as with Device::flush_command_buffer().
+ */
+class DeletionQueue
+{
+  public:
+	DeletionQueue() = default;
+
+	DeletionQueue(const DeletionQueue &) = delete;
+
+	DeletionQueue(DeletionQueue &&) = delete;
+
+	~DeletionQueue() = default;
+
+	DeletionQueue &operator=(const DeletionQueue &) = delete;
+
+	DeletionQueue &operator=(DeletionQueue &&) = delete;
+
+	/**
+	 * @brief Takes ownership of an object, such as a core::Buffer or a GraphicsPipeline, until it is no longer used
+	 */
+	template <class T>
+	void retire(T &&object)
+	{
+		static_assert(!std::is_lvalue_reference<T>::value, "Retired objects must be moved into the queue");
+
+		push(std::unique_ptr<Entry>(new Object<T>(std::move(object))));
+	}
+
+	/**
+	 * @brief Calls a function once the submissions which may use an object have completed,
+	 *        for the raw Vulkan handles such as the one returned by core::Buffer::rebind()
+	 */
+	void retire_function(std::function<void()> &&destroy);
+
+	/**
+	 * @brief Numbers a frame submission, called after it was submitted
+	 * @return The number to pass to complete()
+	 */
+	uint64_t submit();
+
+	/**
+	 * @brief Records that a submission has completed, and destroys the objects no longer used
+	 */
+	void complete(uint64_t number);
+
+	/**
+	 * @brief Records that every submission so far has completed, after the device waited to be idle
+	 */
+	void complete_all();
+
+	/**
+	 * @brief Destroys every retired object, the device must be idle
+	 */
+	void clear();
+
+	/**
+	 * @return The number of objects waiting for their submissions
+	 */
+	size_t get_pending_count() const;
+
+  private:
+	struct Entry
+	{
+		virtual ~Entry() = default;
+
+		/// Submission which may use the object, it is destroyed once it completes
+		uint64_t number{0};
+	};
+
+	template <class T>
+	struct Object : Entry
+	{
+		explicit Object(T &&object) :
+		    object{std::move(object)}
+		{}
+
+		T object;
+	};
+
+	struct Function : Entry
+	{
+		explicit Function(std::function<void()> &&destroy) :
+		    destroy{std::move(destroy)}
+		{}
+
+		~Function() override
+		{
+			destroy();
+		}
+
+		std::function<void()> destroy;
+	};
+
+	void push(std::unique_ptr<Entry> &&entry);
+
+	/**
+	 * @brief Removes the entries whose submissions have completed, to be destroyed outside of the lock
+	 */
+	std::deque<std::unique_ptr<Entry>> collect();
+
+	mutable std::mutex mutex;
+
+	/// Retired entries, in ascending number order
+	std::deque<std::unique_ptr<Entry>> entries;
+
+	/// Submissions not known to be complete yet
+	std::set<uint64_t> pending_submissions;
+
+	uint64_t submission_count{0};
+};
+}        // namespace vkb
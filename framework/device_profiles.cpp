@@ -0,0 +1,96 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "device_profiles.h"
+
+#include <fstream>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+DeviceProfiles::DeviceProfiles(const std::string &filename_) :
+    filename{fs::path::get(fs::path::Type::Storage) + filename_}
+{
+	std::ifstream file{filename};
+
+	if (!file.good())
+	{
+		return;
+	}
+
+	profiles = nlohmann::json::parse(file, nullptr, false);
+
+	if (!profiles.is_object())
+	{
+		LOGW("Device profiles ignored, {} is not valid", filename);
+		profiles = nlohmann::json::object();
+	}
+}
+
+std::string DeviceProfiles::get_key(const VkPhysicalDeviceProperties &properties)
+{
+	return fmt::format("{:04x}-{:04x}-{:08x}", properties.vendorID, properties.deviceID, properties.driverVersion);
+}
+
+int32_t DeviceProfiles::get_configuration(const VkPhysicalDeviceProperties &properties, const std::string &sample) const
+{
+	auto device_it = profiles.find(get_key(properties));
+	if (device_it == profiles.end())
+	{
+		return -1;
+	}
+
+	auto samples_it = device_it->find("samples");
+	if (samples_it == device_it->end())
+	{
+		return -1;
+	}
+
+	auto sample_it = samples_it->find(sample);
+	if (sample_it == samples_it->end() || !sample_it->is_number_unsigned())
+	{
+		return -1;
+	}
+
+	return sample_it->get<int32_t>();
+}
+
+void DeviceProfiles::set_configuration(const VkPhysicalDeviceProperties &properties, const std::string &sample, uint32_t configuration)
+{
+	auto &device = profiles[get_key(properties)];
+
+	device["device"]          = properties.deviceName;
+	device["samples"][sample] = configuration;
+}
+
+bool DeviceProfiles::save() const
+{
+	std::ofstream file{filename, std::ios::out | std::ios::trunc};
+
+	if (!file.good())
+	{
+		LOGE("Failed to open {} for writing", filename);
+		return false;
+	}
+
+	file << profiles.dump(4);
+
+	return file.good();
+}
+}        // namespace vkb
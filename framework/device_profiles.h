@@ -0,0 +1,66 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <json.hpp>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+/**
+ * @brief The configuration of each sample found to be the fastest on a device, by a tuning run
+ *
+ *        Profiles are keyed by the vendor, device and driver version of the GPU, so a driver update
+ *        needs a new tuning run. They are stored as JSON in the storage directory.
+ */
+class DeviceProfiles
+{
+  public:
+	/**
+	 * @brief Loads the profiles, if the file exists
+	 * @param filename The path to the file, relative to the storage directory
+	 */
+	DeviceProfiles(const std::string &filename = "device_profiles.json");
+
+	/**
+	 * @return The key of the profile of a GPU, made of its vendor, device and driver version
+	 */
+	static std::string get_key(const VkPhysicalDeviceProperties &properties);
+
+	/**
+	 * @return The configuration tuned for the sample on the GPU, negative if it was not tuned
+	 */
+	int32_t get_configuration(const VkPhysicalDeviceProperties &properties, const std::string &sample) const;
+
+	void set_configuration(const VkPhysicalDeviceProperties &properties, const std::string &sample, uint32_t configuration);
+
+	/**
+	 * @brief Writes the profiles to the file they were loaded from
+	 * @return Whether the file was written
+	 */
+	bool save() const;
+
+  private:
+	std::string filename;
+
+	nlohmann::json profiles = nlohmann::json::object();
+};
+}        // namespace vkb
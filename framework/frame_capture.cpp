@@ -0,0 +1,272 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_capture.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "core/command_buffer.h"
+#include "platform/filesystem.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+bool is_bgra_format(VkFormat format)
+{
+	return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SNORM;
+}
+
+bool is_rgba_format(VkFormat format)
+{
+	return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SNORM;
+}
+}        // namespace
+
+FrameCapture::FrameCapture(RenderContext &render_context, JobSystem *job_system, uint32_t slot_count) :
+    render_context{render_context},
+    job_system{job_system}
+{
+	assert(slot_count > 0 && "Frame capture needs a readback buffer");
+
+	if (job_system)
+	{
+		encodings = std::make_unique<JobSystem::TaskGroup>(*job_system);
+	}
+
+	for (uint32_t i = 0; i < slot_count; ++i)
+	{
+		slots.emplace_back(std::make_unique<Slot>());
+	}
+}
+
+FrameCapture::~FrameCapture()
+{
+	// Jobs reference the slots
+	encodings.reset();
+}
+
+void FrameCapture::request(const std::string &filename, Format format)
+{
+	requests.push_back({filename, format});
+}
+
+void FrameCapture::set_wait_for_slots(bool enabled)
+{
+	assert((!enabled || slots.size() >= render_context.get_render_frames().size()) && "Frame capture needs a readback buffer per frame to wait");
+
+	wait_for_slots = enabled;
+}
+
+bool FrameCapture::is_pending() const
+{
+	if (!requests.empty())
+	{
+		return true;
+	}
+
+	for (auto &slot : slots)
+	{
+		if (slot->copying || slot->encoding)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FrameCapture::record(CommandBuffer &command_buffer)
+{
+	auto frame_index = render_context.get_active_frame_index();
+
+	// The fence of the active frame was waited on, so the copies it recorded last time are complete
+	for (auto &slot : slots)
+	{
+		if (slot->copying && slot->frame_index == frame_index)
+		{
+			encode(*slot);
+		}
+	}
+
+	if (requests.empty())
+	{
+		return;
+	}
+
+	auto &image_view = render_context.get_active_frame().get_render_target().get_views().at(0);
+	auto &image      = image_view.get_image();
+	auto  format     = image_view.get_format();
+
+	if (!is_bgra_format(format) && !is_rgba_format(format))
+	{
+		LOGW("Frame capture does not support swapchain format {}, dropping {}", to_string(format), requests.front().filename);
+		requests.pop_front();
+		return;
+	}
+
+	auto is_free = [](const std::unique_ptr<Slot> &slot) { return !slot->copying && !slot->encoding; };
+
+	auto it = std::find_if(slots.begin(), slots.end(), is_free);
+
+	if (it == slots.end() && wait_for_slots && encodings)
+	{
+		encodings->wait();
+
+		it = std::find_if(slots.begin(), slots.end(), is_free);
+	}
+
+	if (it == slots.end())
+	{
+		// Try again next frame rather than waiting for an encoding
+		return;
+	}
+
+	auto &slot = **it;
+
+	VkExtent2D   extent{image.get_extent().width, image.get_extent().height};
+	VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+	if (!slot.buffer || slot.buffer->get_size() < size)
+	{
+		slot.buffer = std::make_unique<core::Buffer>(render_context.get_device(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	}
+
+	slot.filename    = requests.front().filename;
+	slot.format      = requests.front().format;
+	slot.extent      = extent;
+	slot.swizzle     = is_bgra_format(format);
+	slot.frame_index = frame_index;
+	slot.copying     = true;
+
+	requests.pop_front();
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(image_view, memory_barrier);
+	}
+
+	VkBufferImageCopy region{};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent                 = {extent.width, extent.height, 1};
+
+	command_buffer.copy_image_to_buffer(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, *slot.buffer, {region});
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(image_view, memory_barrier);
+	}
+
+	{
+		BufferMemoryBarrier memory_barrier{};
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_HOST_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+
+		command_buffer.buffer_memory_barrier(*slot.buffer, 0, size, memory_barrier);
+	}
+}
+
+void FrameCapture::flush()
+{
+	// Only the frames of this context, which may share the device with contexts on other threads
+	for (auto &frame : render_context.get_render_frames())
+	{
+		frame->wait();
+	}
+
+	for (auto &slot : slots)
+	{
+		if (slot->copying)
+		{
+			encode(*slot);
+		}
+	}
+
+	if (encodings)
+	{
+		encodings->wait();
+	}
+}
+
+void FrameCapture::encode(Slot &slot)
+{
+	slot.copying  = false;
+	slot.encoding = true;
+
+	if (encodings)
+	{
+		encodings->run([&slot]() { write(slot); });
+	}
+	else
+	{
+		write(slot);
+	}
+}
+
+void FrameCapture::write(Slot &slot)
+{
+	slot.buffer->invalidate();
+
+	// The buffer is persistently mapped and tightly packed
+	auto data = const_cast<uint8_t *>(slot.buffer->get_data());
+
+	auto pixel_count = static_cast<size_t>(slot.extent.width) * slot.extent.height;
+
+	// Swap R and B of BGR formats, and replace A with 255 (remove transparency)
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		auto pixel = data + i * 4;
+
+		if (slot.swizzle)
+		{
+			std::swap(pixel[0], pixel[2]);
+		}
+
+		pixel[3] = 255;
+	}
+
+	if (slot.format == Format::PPM)
+	{
+		fs::write_ppm(data, slot.filename, slot.extent.width, slot.extent.height, 4, slot.extent.width * 4);
+	}
+	else
+	{
+		fs::write_image(data, slot.filename, slot.extent.width, slot.extent.height, 4, slot.extent.width * 4);
+	}
+
+	slot.encoding = false;
+}
+}        // namespace vkb
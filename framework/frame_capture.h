@@ -0,0 +1,147 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "job_system.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Captures rendered frames to image files without stalling the frame loop
+ *
+ * The swapchain image of a frame is copied into a host visible buffer at the end of its command buffer.
+ * The copy is read back once the render frame comes around again, as its fence has been waited on by then,
+ * and the image is encoded on a worker of the job system. A ring of readback buffers bounds the captures in flight,
+ * requests wait for the next frame while every buffer is busy.
+ */
+class FrameCapture
+{
+  public:
+	enum class Format
+	{
+		PNG,
+		PPM
+	};
+
+	static constexpr uint32_t DEFAULT_SLOT_COUNT = 3;
+
+	/**
+	 * @param render_context The context whose frames are captured
+	 * @param job_system Optional job system encoding the images, they are encoded on the calling thread otherwise
+	 * @param slot_count Number of readback buffers
+	 */
+	FrameCapture(RenderContext &render_context, JobSystem *job_system = nullptr, uint32_t slot_count = DEFAULT_SLOT_COUNT);
+
+	FrameCapture(const FrameCapture &) = delete;
+
+	FrameCapture(FrameCapture &&) = delete;
+
+	/**
+	 * @brief Waits for the pending encodings, the device must be idle
+	 */
+	~FrameCapture();
+
+	FrameCapture &operator=(const FrameCapture &) = delete;
+
+	FrameCapture &operator=(FrameCapture &&) = delete;
+
+	/**
+	 * @brief Captures the next frame recorded with record()
+	 * @param filename The name of the image file in the screenshots directory, without an extension
+	 * @param format The format of the image file
+	 */
+	void request(const std::string &filename, Format format = Format::PNG);
+
+	/**
+	 * @brief Waits for an encoding when every readback buffer is busy, so that a request captures the next recorded frame
+	 *        rather than a later one. The buffers of the frames in flight are never waited on, so it needs as many
+	 *        buffers as the render context has frames.
+	 */
+	void set_wait_for_slots(bool enabled);
+
+	/**
+	 * @brief Encodes the captures the active frame completed, and records the capture of the frame if one is requested
+	 *        It must be recorded after the last render pass of the active frame, which leaves the swapchain image in present layout
+	 * @param command_buffer The command buffer of the active frame
+	 */
+	void record(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Waits for the frames of the render context, then encodes the captures in flight and waits for them to be written
+	 *        Other contexts sharing the device keep rendering, it must not be called while a frame is active
+	 */
+	void flush();
+
+	/**
+	 * @return Whether requests or captures are still in flight
+	 */
+	bool is_pending() const;
+
+  private:
+	struct Slot
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		std::string filename;
+
+		Format format{Format::PNG};
+
+		VkExtent2D extent{};
+
+		bool swizzle{false};
+
+		uint32_t frame_index{0};
+
+		bool copying{false};
+
+		std::atomic<bool> encoding{false};
+	};
+
+	struct Request
+	{
+		std::string filename;
+
+		Format format;
+	};
+
+	void encode(Slot &slot);
+
+	static void write(Slot &slot);
+
+	RenderContext &render_context;
+
+	JobSystem *job_system;
+
+	std::unique_ptr<JobSystem::TaskGroup> encodings;
+
+	std::vector<std::unique_ptr<Slot>> slots;
+
+	std::deque<Request> requests;
+
+	bool wait_for_slots{false};
+};
+}        // namespace vkb
@@ -0,0 +1,512 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry/bounds_kernels.h"
+
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define VKB_BOUNDS_SSE
+#	include <immintrin.h>
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#		define VKB_BOUNDS_AVX2
+#		define VKB_TARGET_AVX2
+#	elif defined(__GNUC__) && !defined(_MSC_VER)
+#		define VKB_BOUNDS_AVX2
+#		define VKB_TARGET_AVX2 __attribute__((target("avx2")))
+#	endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define VKB_BOUNDS_NEON
+#	include <arm_neon.h>
+#endif
+
+namespace vkb
+{
+namespace bounds
+{
+namespace
+{
+std::atomic<bool> scalar_forced{false};
+
+#ifdef VKB_BOUNDS_AVX2
+bool is_avx2_supported()
+{
+#	if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	// The OS must also save the upper halves of the registers
+	__cpuid(info, 1);
+	bool has_avx     = (info[2] & (1 << 28)) != 0;
+	bool has_osxsave = (info[2] & (1 << 27)) != 0;
+	if (!has_avx || !has_osxsave || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#	else
+	return __builtin_cpu_supports("avx2");
+#	endif
+}
+#endif
+
+InstructionSet detect_instruction_set()
+{
+#if defined(VKB_BOUNDS_AVX2)
+	return is_avx2_supported() ? InstructionSet::AVX2 : InstructionSet::SSE;
+#elif defined(VKB_BOUNDS_SSE)
+	return InstructionSet::SSE;
+#elif defined(VKB_BOUNDS_NEON)
+	return InstructionSet::NEON;
+#else
+	return InstructionSet::Scalar;
+#endif
+}
+
+/**
+ * @brief The coordinates of the box corners the furthest along a plane normal
+ */
+struct PlaneCorners
+{
+	const float *xs;
+
+	const float *ys;
+
+	const float *zs;
+};
+
+std::array<PlaneCorners, 6> get_plane_corners(const std::array<glm::vec4, 6> &planes, const BoxArrays &boxes)
+{
+	std::array<PlaneCorners, 6> corners;
+
+	for (size_t p = 0; p < planes.size(); ++p)
+	{
+		corners[p].xs = planes[p].x > 0.0f ? boxes.max_x : boxes.min_x;
+		corners[p].ys = planes[p].y > 0.0f ? boxes.max_y : boxes.min_y;
+		corners[p].zs = planes[p].z > 0.0f ? boxes.max_z : boxes.min_z;
+	}
+
+	return corners;
+}
+
+void transform_boxes_scalar(const glm::mat4 *matrices, const glm::vec3 *centers, const glm::vec3 *extents, size_t count, const BoxArrays &boxes)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto &matrix = matrices[i];
+		const auto &extent = extents[i];
+
+		auto center = glm::vec3(matrix * glm::vec4(centers[i], 1.0f));
+
+		auto world_extent = glm::abs(glm::vec3(matrix[0])) * extent.x +
+		                    glm::abs(glm::vec3(matrix[1])) * extent.y +
+		                    glm::abs(glm::vec3(matrix[2])) * extent.z;
+
+		boxes.min_x[i] = center.x - world_extent.x;
+		boxes.min_y[i] = center.y - world_extent.y;
+		boxes.min_z[i] = center.z - world_extent.z;
+		boxes.max_x[i] = center.x + world_extent.x;
+		boxes.max_y[i] = center.y + world_extent.y;
+		boxes.max_z[i] = center.z + world_extent.z;
+	}
+}
+
+void test_boxes_scalar(const std::array<glm::vec4, 6> &planes, const std::array<PlaneCorners, 6> &corners, size_t first, size_t count, uint8_t *visible)
+{
+	for (size_t p = 0; p < planes.size(); ++p)
+	{
+		const auto &plane = planes[p];
+		const auto &c     = corners[p];
+
+		for (size_t i = first; i < count; ++i)
+		{
+			visible[i] &= static_cast<uint8_t>(plane.x * c.xs[i] + plane.y * c.ys[i] + plane.z * c.zs[i] + plane.w >= 0.0f);
+		}
+	}
+}
+
+void compute_bounds_scalar(const glm::vec3 *points, size_t count, glm::vec3 &min, glm::vec3 &max)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		min = glm::min(min, points[i]);
+		max = glm::max(max, points[i]);
+	}
+}
+
+#ifdef VKB_BOUNDS_SSE
+void transform_boxes_sse(const glm::mat4 *matrices, const glm::vec3 *centers, const glm::vec3 *extents, size_t count, const BoxArrays &boxes)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	alignas(16) float lower[4];
+	alignas(16) float upper[4];
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float *m = &matrices[i][0][0];
+
+		__m128 c0 = _mm_loadu_ps(m);
+		__m128 c1 = _mm_loadu_ps(m + 4);
+		__m128 c2 = _mm_loadu_ps(m + 8);
+		__m128 c3 = _mm_loadu_ps(m + 12);
+
+		const auto &c = centers[i];
+		const auto &e = extents[i];
+
+		__m128 center = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(c.x)),
+		                                                 _mm_mul_ps(c1, _mm_set1_ps(c.y))),
+		                                      _mm_mul_ps(c2, _mm_set1_ps(c.z))),
+		                           c3);
+
+		__m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(c0, abs_mask), _mm_set1_ps(e.x)),
+		                                      _mm_mul_ps(_mm_and_ps(c1, abs_mask), _mm_set1_ps(e.y))),
+		                           _mm_mul_ps(_mm_and_ps(c2, abs_mask), _mm_set1_ps(e.z)));
+
+		_mm_store_ps(lower, _mm_sub_ps(center, extent));
+		_mm_store_ps(upper, _mm_add_ps(center, extent));
+
+		boxes.min_x[i] = lower[0];
+		boxes.min_y[i] = lower[1];
+		boxes.min_z[i] = lower[2];
+		boxes.max_x[i] = upper[0];
+		boxes.max_y[i] = upper[1];
+		boxes.max_z[i] = upper[2];
+	}
+}
+
+size_t test_boxes_sse(const std::array<glm::vec4, 6> &planes, const std::array<PlaneCorners, 6> &corners, size_t count, uint8_t *visible)
+{
+	__m128 px[6], py[6], pz[6], pw[6];
+
+	for (size_t p = 0; p < planes.size(); ++p)
+	{
+		px[p] = _mm_set1_ps(planes[p].x);
+		py[p] = _mm_set1_ps(planes[p].y);
+		pz[p] = _mm_set1_ps(planes[p].z);
+		pw[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	size_t i = 0;
+
+	// Four boxes against all the planes at once
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (size_t p = 0; p < planes.size(); ++p)
+		{
+			const auto &c = corners[p];
+
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], _mm_loadu_ps(c.xs + i)),
+			                                                   _mm_mul_ps(py[p], _mm_loadu_ps(c.ys + i))),
+			                                        _mm_mul_ps(pz[p], _mm_loadu_ps(c.zs + i))),
+			                             pw[p]);
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+
+		for (size_t k = 0; k < 4; ++k)
+		{
+			visible[i + k] &= static_cast<uint8_t>((mask >> k) & 1);
+		}
+	}
+
+	return i;
+}
+
+void compute_bounds_sse(const glm::vec3 *points, size_t count, glm::vec3 &min, glm::vec3 &max)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	__m128 lower = _mm_set_ps(0.0f, min.z, min.y, min.x);
+	__m128 upper = _mm_set_ps(0.0f, max.z, max.y, max.x);
+
+	// Each load reads one float of the next point into the unused lane, so the last point is left to the scalar path
+	for (size_t i = 0; i + 1 < count; ++i)
+	{
+		__m128 point = _mm_loadu_ps(&points[i].x);
+
+		lower = _mm_min_ps(lower, point);
+		upper = _mm_max_ps(upper, point);
+	}
+
+	alignas(16) float result[4];
+
+	_mm_store_ps(result, lower);
+	min = glm::vec3(result[0], result[1], result[2]);
+
+	_mm_store_ps(result, upper);
+	max = glm::vec3(result[0], result[1], result[2]);
+
+	compute_bounds_scalar(points + count - 1, 1, min, max);
+}
+#endif
+
+#ifdef VKB_BOUNDS_AVX2
+VKB_TARGET_AVX2 size_t test_boxes_avx2(const std::array<glm::vec4, 6> &planes, const std::array<PlaneCorners, 6> &corners, size_t count, uint8_t *visible)
+{
+	__m256 px[6], py[6], pz[6], pw[6];
+
+	for (size_t p = 0; p < planes.size(); ++p)
+	{
+		px[p] = _mm256_set1_ps(planes[p].x);
+		py[p] = _mm256_set1_ps(planes[p].y);
+		pz[p] = _mm256_set1_ps(planes[p].z);
+		pw[p] = _mm256_set1_ps(planes[p].w);
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+
+	// Eight boxes against all the planes at once
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (size_t p = 0; p < planes.size(); ++p)
+		{
+			const auto &c = corners[p];
+
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], _mm256_loadu_ps(c.xs + i)),
+			                                                            _mm256_mul_ps(py[p], _mm256_loadu_ps(c.ys + i))),
+			                                              _mm256_mul_ps(pz[p], _mm256_loadu_ps(c.zs + i))),
+			                                pw[p]);
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+
+		for (size_t k = 0; k < 8; ++k)
+		{
+			visible[i + k] &= static_cast<uint8_t>((mask >> k) & 1);
+		}
+	}
+
+	return i;
+}
+#endif
+
+#ifdef VKB_BOUNDS_NEON
+void transform_boxes_neon(const glm::mat4 *matrices, const glm::vec3 *centers, const glm::vec3 *extents, size_t count, const BoxArrays &boxes)
+{
+	float lower[4];
+	float upper[4];
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float *m = &matrices[i][0][0];
+
+		float32x4_t c0 = vld1q_f32(m);
+		float32x4_t c1 = vld1q_f32(m + 4);
+		float32x4_t c2 = vld1q_f32(m + 8);
+		float32x4_t c3 = vld1q_f32(m + 12);
+
+		const auto &c = centers[i];
+		const auto &e = extents[i];
+
+		float32x4_t center = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(c0, c.x), vmulq_n_f32(c1, c.y)), vmulq_n_f32(c2, c.z)), c3);
+
+		float32x4_t extent = vaddq_f32(vaddq_f32(vmulq_n_f32(vabsq_f32(c0), e.x), vmulq_n_f32(vabsq_f32(c1), e.y)), vmulq_n_f32(vabsq_f32(c2), e.z));
+
+		vst1q_f32(lower, vsubq_f32(center, extent));
+		vst1q_f32(upper, vaddq_f32(center, extent));
+
+		boxes.min_x[i] = lower[0];
+		boxes.min_y[i] = lower[1];
+		boxes.min_z[i] = lower[2];
+		boxes.max_x[i] = upper[0];
+		boxes.max_y[i] = upper[1];
+		boxes.max_z[i] = upper[2];
+	}
+}
+
+size_t test_boxes_neon(const std::array<glm::vec4, 6> &planes, const std::array<PlaneCorners, 6> &corners, size_t count, uint8_t *visible)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	uint32_t lanes[4];
+
+	size_t i = 0;
+
+	// Four boxes against all the planes at once
+	for (; i + 4 <= count; i += 4)
+	{
+		uint32x4_t inside = vdupq_n_u32(~0u);
+
+		for (size_t p = 0; p < planes.size(); ++p)
+		{
+			const auto &plane = planes[p];
+			const auto &c     = corners[p];
+
+			float32x4_t distance = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(vld1q_f32(c.xs + i), plane.x),
+			                                                     vmulq_n_f32(vld1q_f32(c.ys + i), plane.y)),
+			                                           vmulq_n_f32(vld1q_f32(c.zs + i), plane.z)),
+			                                 vdupq_n_f32(plane.w));
+
+			inside = vandq_u32(inside, vcgeq_f32(distance, zero));
+		}
+
+		vst1q_u32(lanes, inside);
+
+		for (size_t k = 0; k < 4; ++k)
+		{
+			visible[i + k] &= static_cast<uint8_t>(lanes[k] & 1);
+		}
+	}
+
+	return i;
+}
+
+void compute_bounds_neon(const glm::vec3 *points, size_t count, glm::vec3 &min, glm::vec3 &max)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	float result[4] = {min.x, min.y, min.z, 0.0f};
+
+	float32x4_t lower = vld1q_f32(result);
+
+	result[0] = max.x;
+	result[1] = max.y;
+	result[2] = max.z;
+
+	float32x4_t upper = vld1q_f32(result);
+
+	// Each load reads one float of the next point into the unused lane, so the last point is left to the scalar path
+	for (size_t i = 0; i + 1 < count; ++i)
+	{
+		float32x4_t point = vld1q_f32(&points[i].x);
+
+		lower = vminq_f32(lower, point);
+		upper = vmaxq_f32(upper, point);
+	}
+
+	vst1q_f32(result, lower);
+	min = glm::vec3(result[0], result[1], result[2]);
+
+	vst1q_f32(result, upper);
+	max = glm::vec3(result[0], result[1], result[2]);
+
+	compute_bounds_scalar(points + count - 1, 1, min, max);
+}
+#endif
+}        // namespace
+
+InstructionSet get_instruction_set()
+{
+	static const InstructionSet instruction_set = detect_instruction_set();
+	return scalar_forced.load(std::memory_order_relaxed) ? InstructionSet::Scalar : instruction_set;
+}
+
+void force_scalar(bool enabled)
+{
+	scalar_forced.store(enabled, std::memory_order_relaxed);
+}
+
+void transform_boxes(const glm::mat4 *matrices, const glm::vec3 *centers, const glm::vec3 *extents, size_t count, const BoxArrays &boxes)
+{
+	switch (get_instruction_set())
+	{
+#ifdef VKB_BOUNDS_SSE
+		case InstructionSet::AVX2:
+		case InstructionSet::SSE:
+			transform_boxes_sse(matrices, centers, extents, count, boxes);
+			break;
+#endif
+#ifdef VKB_BOUNDS_NEON
+		case InstructionSet::NEON:
+			transform_boxes_neon(matrices, centers, extents, count, boxes);
+			break;
+#endif
+		default:
+			transform_boxes_scalar(matrices, centers, extents, count, boxes);
+			break;
+	}
+}
+
+void test_boxes(const std::array<glm::vec4, 6> &planes, const BoxArrays &boxes, size_t count, uint8_t *visible)
+{
+	auto corners = get_plane_corners(planes, boxes);
+
+	size_t tested = 0;
+
+	switch (get_instruction_set())
+	{
+#ifdef VKB_BOUNDS_AVX2
+		case InstructionSet::AVX2:
+			tested = test_boxes_avx2(planes, corners, count, visible);
+			break;
+#endif
+#ifdef VKB_BOUNDS_SSE
+		case InstructionSet::SSE:
+			tested = test_boxes_sse(planes, corners, count, visible);
+			break;
+#endif
+#ifdef VKB_BOUNDS_NEON
+		case InstructionSet::NEON:
+			tested = test_boxes_neon(planes, corners, count, visible);
+			break;
+#endif
+		default:
+			break;
+	}
+
+	// The boxes left over from the last full batch
+	test_boxes_scalar(planes, corners, tested, count, visible);
+}
+
+void compute_bounds(const glm::vec3 *points, size_t count, glm::vec3 &min, glm::vec3 &max)
+{
+	switch (get_instruction_set())
+	{
+#ifdef VKB_BOUNDS_SSE
+		case InstructionSet::AVX2:
+		case InstructionSet::SSE:
+			compute_bounds_sse(points, count, min, max);
+			break;
+#endif
+#ifdef VKB_BOUNDS_NEON
+		case InstructionSet::NEON:
+			compute_bounds_neon(points, count, min, max);
+			break;
+#endif
+		default:
+			compute_bounds_scalar(points, count, min, max);
+			break;
+	}
+}
+}        // namespace bounds
+}        // namespace vkb
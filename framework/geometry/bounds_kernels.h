@@ -0,0 +1,103 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Batched kernels over axis aligned boxes, vectorized with SSE or AVX2 on x86 and NEON on ARM.
+ *        The widest instruction set the CPU supports is selected at runtime, with a scalar fallback.
+ */
+namespace bounds
+{
+enum class InstructionSet
+{
+	Scalar,
+	SSE,
+	AVX2,
+	NEON
+};
+
+/**
+ * @return The instruction set used by the kernels
+ */
+InstructionSet get_instruction_set();
+
+/**
+ * @brief Makes the kernels use the scalar fallback, or the widest supported instruction set again,
+ *        so that both can be compared
+ */
+void force_scalar(bool enabled);
+
+/**
+ * @brief Boxes laid out as one array per coordinate, so that the kernels load several boxes at once
+ */
+struct BoxArrays
+{
+	float *min_x;
+
+	float *min_y;
+
+	float *min_z;
+
+	float *max_x;
+
+	float *max_y;
+
+	float *max_z;
+};
+
+/**
+ * @brief Computes the world space boxes around boxes transformed by affine matrices
+ * @param matrices The transform of each box
+ * @param centers The center of each box
+ * @param extents The half extent of each box
+ * @param count The number of boxes
+ * @param boxes The arrays receiving the transformed boxes
+ */
+void transform_boxes(const glm::mat4 *matrices, const glm::vec3 *centers, const glm::vec3 *extents, size_t count, const BoxArrays &boxes);
+
+/**
+ * @brief Tests boxes against the planes of a frustum
+ * @param planes The frustum planes, with normals pointing inside
+ * @param boxes The arrays of the boxes to test
+ * @param count The number of boxes
+ * @param visible Cleared for the boxes fully outside one of the planes, left untouched otherwise
+ */
+void test_boxes(const std::array<glm::vec4, 6> &planes, const BoxArrays &boxes, size_t count, uint8_t *visible);
+
+/**
+ * @brief Grows a box to contain a range of points
+ * @param points The points to contain
+ * @param count The number of points
+ * @param min The minimum corner of the box, updated in place
+ * @param max The maximum corner of the box, updated in place
+ */
+void compute_bounds(const glm::vec3 *points, size_t count, glm::vec3 &min, glm::vec3 &max);
+}        // namespace bounds
+}        // namespace vkb
@@ -0,0 +1,188 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry/meshlet_builder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Computes the bounding sphere and normal cone of the last meshlet, from its vertices and triangles
+ */
+void compute_meshlet_bounds(const std::vector<glm::vec3> &positions, MeshletData &data)
+{
+	auto &meshlet = data.meshlets.back();
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+	{
+		auto &position = positions[data.vertices[meshlet.vertex_offset + i]];
+
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+
+	auto  center = (min + max) * 0.5f;
+	float radius = 0.0f;
+
+	for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+	{
+		radius = std::max(radius, glm::length(positions[data.vertices[meshlet.vertex_offset + i]] - center));
+	}
+
+	meshlet.bounding_sphere = glm::vec4(center, radius);
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.triangle_count);
+
+	// Area weighted, so that slivers barely move the axis
+	glm::vec3 axis{0.0f};
+
+	for (uint32_t i = 0; i < meshlet.triangle_count; ++i)
+	{
+		auto triangle = data.triangles[meshlet.triangle_offset + i];
+
+		auto &a = positions[data.vertices[meshlet.vertex_offset + (triangle & 0xFF)]];
+		auto &b = positions[data.vertices[meshlet.vertex_offset + ((triangle >> 8) & 0xFF)]];
+		auto &c = positions[data.vertices[meshlet.vertex_offset + ((triangle >> 16) & 0xFF)]];
+
+		auto  normal = glm::cross(b - a, c - a);
+		float area   = glm::length(normal);
+
+		// Degenerate triangles are never rasterized
+		if (area <= 0.0f)
+		{
+			continue;
+		}
+
+		axis += normal;
+		normals.push_back(normal / area);
+	}
+
+	float axis_length = glm::length(axis);
+
+	if (normals.empty() || axis_length <= 0.0f)
+	{
+		meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		return;
+	}
+
+	axis /= axis_length;
+
+	float min_dot = 1.0f;
+	for (auto &normal : normals)
+	{
+		min_dot = std::min(min_dot, glm::dot(axis, normal));
+	}
+
+	// Past a half space of normals, the meshlet always has a triangle facing the camera
+	float cutoff = min_dot <= 0.0f ? 1.0f : std::sqrt(1.0f - min_dot * min_dot);
+
+	meshlet.cone = glm::vec4(axis, cutoff);
+}
+}        // namespace
+
+MeshletData build_meshlets(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices, uint32_t max_vertices, uint32_t max_triangles)
+{
+	assert(max_vertices > 0 && max_vertices <= 256 && "Meshlet vertex indices are packed in 8 bits");
+	assert(max_triangles > 0 && "Meshlets need at least one triangle");
+
+	MeshletData data;
+
+	// Index of each vertex in the vertex list of the current meshlet, if it is in it
+	constexpr uint32_t    NOT_IN_MESHLET = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> local_indices(positions.size(), NOT_IN_MESHLET);
+
+	auto flush_meshlet = [&]() {
+		auto &meshlet = data.meshlets.back();
+
+		for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+		{
+			local_indices[data.vertices[meshlet.vertex_offset + i]] = NOT_IN_MESHLET;
+		}
+
+		compute_meshlet_bounds(positions, data);
+	};
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		uint32_t triangle[3] = {indices[i], indices[i + 1], indices[i + 2]};
+
+		if (triangle[0] >= positions.size() || triangle[1] >= positions.size() || triangle[2] >= positions.size())
+		{
+			continue;
+		}
+
+		uint32_t new_vertices = 0;
+		for (auto vertex : triangle)
+		{
+			new_vertices += local_indices[vertex] == NOT_IN_MESHLET ? 1 : 0;
+		}
+
+		if (data.meshlets.empty() ||
+		    data.meshlets.back().vertex_count + new_vertices > max_vertices ||
+		    data.meshlets.back().triangle_count + 1 > max_triangles)
+		{
+			if (!data.meshlets.empty())
+			{
+				flush_meshlet();
+			}
+
+			Meshlet meshlet{};
+			meshlet.vertex_offset   = static_cast<uint32_t>(data.vertices.size());
+			meshlet.triangle_offset = static_cast<uint32_t>(data.triangles.size());
+
+			data.meshlets.push_back(meshlet);
+		}
+
+		auto &meshlet = data.meshlets.back();
+
+		uint32_t packed = 0;
+
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			auto &local_index = local_indices[triangle[corner]];
+
+			if (local_index == NOT_IN_MESHLET)
+			{
+				local_index = meshlet.vertex_count++;
+				data.vertices.push_back(triangle[corner]);
+			}
+
+			packed |= local_index << (corner * 8);
+		}
+
+		data.triangles.push_back(packed);
+		meshlet.triangle_count++;
+	}
+
+	if (!data.meshlets.empty())
+	{
+		flush_meshlet();
+	}
+
+	return data;
+}
+}        // namespace vkb
@@ -0,0 +1,89 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/// Maximum number of vertices of a meshlet, the output vertices of a mesh shader workgroup
+constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+
+/// Maximum number of triangles of a meshlet, the output primitives of a mesh shader workgroup
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+/**
+ * @brief A cluster of triangles of a mesh, laid out as the meshlets read by the meshlet shaders (std430)
+ */
+struct alignas(16) Meshlet
+{
+	/// Center of the sphere bounding the vertices in xyz and its radius in w
+	glm::vec4 bounding_sphere;
+
+	/// Average normal of the triangles in xyz, and in w the sine of the angle of the cone bounding their normals,
+	/// 1 if the triangles face too many directions to be culled together
+	glm::vec4 cone;
+
+	/// First entry of the meshlet in the vertex list
+	uint32_t vertex_offset;
+
+	/// First entry of the meshlet in the triangle list
+	uint32_t triangle_offset;
+
+	uint32_t vertex_count;
+
+	uint32_t triangle_count;
+};
+
+/**
+ * @brief The meshlets of a triangle list
+ */
+struct MeshletData
+{
+	std::vector<Meshlet> meshlets;
+
+	/// Indices of the vertices of the meshlets, in the vertex buffers of the triangle list
+	std::vector<uint32_t> vertices;
+
+	/// Triangles of the meshlets, the 3 indices in the vertex list of their meshlet packed in 8 bits each
+	std::vector<uint32_t> triangles;
+};
+
+/**
+ * @brief Splits a triangle list into meshlets, with the bounds used to cull them
+ *
+ * Triangles are added in order to the current meshlet until it runs out of vertices or triangles,
+ * so the indices should already be ordered for the vertex cache, see optimize_vertex_cache().
+ * A meshlet of a front facing triangle list is back facing from a point p when
+ * dot(center - p, cone.xyz) >= cone.w * length(center - p) + radius.
+ *
+ * @param positions Positions of the vertices
+ * @param indices Indices of the triangle list, counter clockwise triangles face forward
+ * @param max_vertices Maximum number of vertices of a meshlet, at most 256
+ * @param max_triangles Maximum number of triangles of a meshlet
+ */
+MeshletData build_meshlets(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices,
+                           uint32_t max_vertices = MAX_MESHLET_VERTICES, uint32_t max_triangles = MAX_MESHLET_TRIANGLES);
+}        // namespace vkb
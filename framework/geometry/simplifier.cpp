@@ -0,0 +1,91 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry/simplifier.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace vkb
+{
+std::vector<uint32_t> simplify_by_clustering(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices, uint32_t grid_resolution)
+{
+	if (positions.empty() || grid_resolution == 0)
+	{
+		return indices;
+	}
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	for (auto &position : positions)
+	{
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+
+	auto  extent    = max - min;
+	float cell_size = std::max(std::max(extent.x, extent.y), extent.z) / grid_resolution;
+
+	if (cell_size <= 0.0f)
+	{
+		return indices;
+	}
+
+	// One more cell so that the vertices on the max bounds stay in the grid
+	uint64_t cells = grid_resolution + 1;
+
+	std::unordered_map<uint64_t, uint32_t> cell_vertices;
+
+	std::vector<uint32_t> remap(positions.size(), std::numeric_limits<uint32_t>::max());
+
+	auto get_representative = [&](uint32_t vertex) {
+		if (remap[vertex] == std::numeric_limits<uint32_t>::max())
+		{
+			auto cell = glm::min(glm::uvec3((positions[vertex] - min) / cell_size), glm::uvec3(grid_resolution));
+			auto key  = cell.x + cells * (cell.y + cells * cell.z);
+
+			remap[vertex] = cell_vertices.emplace(key, vertex).first->second;
+		}
+
+		return remap[vertex];
+	};
+
+	std::vector<uint32_t> simplified;
+	simplified.reserve(indices.size());
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		auto a = get_representative(indices[i]);
+		auto b = get_representative(indices[i + 1]);
+		auto c = get_representative(indices[i + 2]);
+
+		// Triangles whose vertices fell in the same cells collapsed
+		if (a == b || b == c || c == a)
+		{
+			continue;
+		}
+
+		simplified.push_back(a);
+		simplified.push_back(b);
+		simplified.push_back(c);
+	}
+
+	return simplified;
+}
+}        // namespace vkb
@@ -0,0 +1,44 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Simplifies a triangle list by clustering its vertices in a uniform grid
+ *
+ * Every vertex is replaced by the first vertex of its grid cell, and the triangles which collapse
+ * are dropped. No vertex is created, so the simplified indices still index the original vertex
+ * buffers and can share their index buffer with the original ones.
+ *
+ * @param positions Positions of the vertices
+ * @param indices Indices of the triangle list
+ * @param grid_resolution Number of cells along the largest side of the bounds
+ * @return The indices of the simplified triangle list
+ */
+std::vector<uint32_t> simplify_by_clustering(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices, uint32_t grid_resolution);
+}        // namespace vkb
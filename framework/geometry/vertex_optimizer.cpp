@@ -0,0 +1,274 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry/vertex_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t SCORED_CACHE_SIZE = 32;
+
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+
+constexpr float CACHE_DECAY_POWER = 1.5f;
+
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+float get_vertex_score(int32_t cache_position, uint32_t live_triangles)
+{
+	// Vertices without triangles left are never used again
+	if (live_triangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	if (cache_position >= 0)
+	{
+		if (cache_position < 3)
+		{
+			// The vertices of the last triangle are penalized, so strips do not turn back on themselves
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			float scale = 1.0f / (SCORED_CACHE_SIZE - 3);
+			score       = std::pow(1.0f - (cache_position - 3) * scale, CACHE_DECAY_POWER);
+		}
+	}
+
+	// Vertices with few triangles left are boosted, so they are finished before leaving the cache
+	return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(live_triangles), -VALENCE_BOOST_POWER);
+}
+}        // namespace
+
+std::vector<uint32_t> optimize_vertex_cache(const std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return indices;
+	}
+
+	// The triangles of each vertex, the live ones first
+	std::vector<uint32_t> live_triangles(vertex_count, 0);
+
+	for (auto index : indices)
+	{
+		++live_triangles[index];
+	}
+
+	std::vector<uint32_t> triangle_offsets(vertex_count + 1, 0);
+
+	for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+	{
+		triangle_offsets[vertex + 1] = triangle_offsets[vertex] + live_triangles[vertex];
+	}
+
+	std::vector<uint32_t> vertex_triangles(indices.size());
+	std::vector<uint32_t> fill_counts(vertex_count, 0);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		auto vertex = indices[i];
+		vertex_triangles[triangle_offsets[vertex] + fill_counts[vertex]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int32_t> cache_positions(vertex_count, -1);
+	std::vector<float>   vertex_scores(vertex_count);
+
+	for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+	{
+		vertex_scores[vertex] = get_vertex_score(-1, live_triangles[vertex]);
+	}
+
+	std::vector<float>   triangle_scores(triangle_count);
+	std::vector<uint8_t> emitted(triangle_count, 0);
+
+	uint32_t best_triangle = 0;
+
+	for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+	{
+		triangle_scores[triangle] = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+
+		if (triangle_scores[triangle] > triangle_scores[best_triangle])
+		{
+			best_triangle = static_cast<uint32_t>(triangle);
+		}
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> next_cache;
+
+	// Triangles are searched linearly from here when the cache has no candidate
+	size_t search_cursor = 0;
+
+	for (size_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count)
+	{
+		const uint32_t *triangle_vertices = &indices[best_triangle * 3];
+
+		result.insert(result.end(), triangle_vertices, triangle_vertices + 3);
+		emitted[best_triangle] = 1;
+
+		// Remove the triangle from the live triangles of its vertices
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			auto  vertex = triangle_vertices[i];
+			auto *first  = &vertex_triangles[triangle_offsets[vertex]];
+			auto *last   = first + live_triangles[vertex];
+
+			std::iter_swap(std::find(first, last, best_triangle), last - 1);
+			--live_triangles[vertex];
+		}
+
+		// The vertices of the triangle move to the front of the cache
+		next_cache.assign(triangle_vertices, triangle_vertices + 3);
+
+		for (auto vertex : cache)
+		{
+			if (vertex != triangle_vertices[0] && vertex != triangle_vertices[1] && vertex != triangle_vertices[2])
+			{
+				next_cache.push_back(vertex);
+			}
+		}
+
+		for (size_t i = SCORED_CACHE_SIZE; i < next_cache.size(); ++i)
+		{
+			cache_positions[next_cache[i]] = -1;
+			vertex_scores[next_cache[i]]   = get_vertex_score(-1, live_triangles[next_cache[i]]);
+		}
+
+		if (next_cache.size() > SCORED_CACHE_SIZE)
+		{
+			next_cache.resize(SCORED_CACHE_SIZE);
+		}
+
+		std::swap(cache, next_cache);
+
+		for (size_t i = 0; i < cache.size(); ++i)
+		{
+			cache_positions[cache[i]] = static_cast<int32_t>(i);
+			vertex_scores[cache[i]]   = get_vertex_score(static_cast<int32_t>(i), live_triangles[cache[i]]);
+		}
+
+		// The next triangle is the best one using a vertex of the cache
+		float best_score = -1.0f;
+
+		for (auto vertex : cache)
+		{
+			for (uint32_t i = 0; i < live_triangles[vertex]; ++i)
+			{
+				auto triangle = vertex_triangles[triangle_offsets[vertex] + i];
+
+				float score = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+
+				triangle_scores[triangle] = score;
+
+				if (score > best_score)
+				{
+					best_score    = score;
+					best_triangle = triangle;
+				}
+			}
+		}
+
+		if (best_score < 0.0f)
+		{
+			while (search_cursor < triangle_count && emitted[search_cursor])
+			{
+				++search_cursor;
+			}
+
+			if (search_cursor == triangle_count)
+			{
+				break;
+			}
+
+			best_triangle = static_cast<uint32_t>(search_cursor);
+		}
+	}
+
+	return result;
+}
+
+std::vector<uint32_t> optimize_vertex_fetch(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+
+	std::vector<uint32_t> remap(vertex_count, UNUSED);
+
+	uint32_t next_vertex = 0;
+
+	for (auto &index : indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = next_vertex++;
+		}
+
+		index = remap[index];
+	}
+
+	for (auto &new_index : remap)
+	{
+		if (new_index == UNUSED)
+		{
+			new_index = next_vertex++;
+		}
+	}
+
+	return remap;
+}
+
+float calculate_acmr(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size)
+{
+	size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return 0.0f;
+	}
+
+	// Time at which each vertex entered the FIFO cache
+	std::vector<size_t> cache_times(vertex_count, 0);
+
+	size_t misses = 0;
+
+	for (auto index : indices)
+	{
+		if (cache_times[index] == 0 || misses + 1 - cache_times[index] > cache_size)
+		{
+			++misses;
+			cache_times[index] = misses;
+		}
+	}
+
+	return static_cast<float>(misses) / triangle_count;
+}
+}        // namespace vkb
@@ -0,0 +1,50 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Reorders the triangles of a triangle list so consecutive triangles share vertices, for the post-transform vertex cache
+ *        Greedy selection of the next triangle from the scores of its vertices, after Tom Forsyth's linear-speed
+ *        vertex cache optimisation, which does not depend on the exact size of the cache.
+ * @param indices Indices of the triangle list
+ * @param vertex_count Number of vertices indexed
+ * @return The indices of the reordered triangle list
+ */
+std::vector<uint32_t> optimize_vertex_cache(const std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Computes the order of the vertices in which the indices first use them, so vertex fetches walk the buffers forward
+ *        The vertices which are not indexed come last, in their original order.
+ * @param indices Indices of the triangle list, remapped to the new order
+ * @param vertex_count Number of vertices indexed
+ * @return The new index of each vertex
+ */
+std::vector<uint32_t> optimize_vertex_fetch(std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Average cache miss ratio, the number of vertices transformed per triangle with a FIFO cache
+ *        Ranges from about 0.5 for an ideal order of a regular mesh to 3 when no vertices are shared.
+ */
+float calculate_acmr(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size = 16);
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "glsl_compiler.h"
 
+#include <mutex>
+
 VKBP_DISABLE_WARNINGS()
 #include <SPIRV/GLSL.std.450.h>
 #include <SPIRV/GlslangToSpv.h>
@@ -61,12 +63,35 @@ inline EShLanguage FindShaderLanguage(VkShaderStageFlagBits stage)
 		case VK_SHADER_STAGE_CLOSEST_HIT_BIT_NV:
 			return EShLangClosestHitNV;
 
+#ifdef VK_EXT_mesh_shader
+		case VK_SHADER_STAGE_TASK_BIT_EXT:
+			return EShLangTaskNV;
+
+		case VK_SHADER_STAGE_MESH_BIT_EXT:
+			return EShLangMeshNV;
+#endif
+
 		default:
 			return EShLangVertex;
 	}
 }
 }        // namespace
 
+glslang::EShTargetLanguage        GLSLCompiler::env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
+glslang::EShTargetLanguageVersion GLSLCompiler::env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+
+void GLSLCompiler::set_target_environment(glslang::EShTargetLanguage target_language, glslang::EShTargetLanguageVersion target_language_version)
+{
+	GLSLCompiler::env_target_language         = target_language;
+	GLSLCompiler::env_target_language_version = target_language_version;
+}
+
+void GLSLCompiler::reset_target_environment()
+{
+	GLSLCompiler::env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
+	GLSLCompiler::env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+}
+
 bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     const std::vector<uint8_t> &glsl_source,
                                     const std::string &         entry_point,
@@ -74,8 +99,9 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     std::vector<std::uint32_t> &spirv,
                                     std::string &               info_log)
 {
-	// Initialize glslang library.
-	glslang::InitializeProcess();
+	// Initialize glslang library once for the process, modules may be compiled on several threads at once
+	static std::once_flag glslang_initialized;
+	std::call_once(glslang_initialized, []() { glslang::InitializeProcess(); });
 
 	EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 
@@ -91,6 +117,10 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 	shader.setSourceEntryPoint(entry_point.c_str());
 	shader.setPreamble(shader_variant.get_preamble().c_str());
 	shader.addProcesses(shader_variant.get_processes());
+	if (GLSLCompiler::env_target_language != glslang::EShTargetLanguage::EShTargetNone)
+	{
+		shader.setEnvTarget(GLSLCompiler::env_target_language, GLSLCompiler::env_target_language_version);
+	}
 
 	if (!shader.parse(&glslang::DefaultTBuiltInResource, 100, false, messages))
 	{
@@ -135,9 +165,6 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 
 	info_log += logger.getAllMessages() + "\n";
 
-	// Shutdown glslang library.
-	glslang::FinalizeProcess();
-
 	return true;
 }
 }        // namespace vkb
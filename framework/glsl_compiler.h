@@ -36,6 +36,19 @@ namespace vkb
 class GLSLCompiler
 {
   public:
+	/**
+	 * @brief Sets the SPIR-V version the shaders are compiled for, instead of the default of glslang
+	 *        Extensions such as GL_EXT_ray_query need SPIR-V 1.4, which the device must support.
+	 * @param target_language The language to generate, glslang::EShTargetSpv
+	 * @param target_language_version The version of the language
+	 */
+	static void set_target_environment(glslang::EShTargetLanguage target_language, glslang::EShTargetLanguageVersion target_language_version);
+
+	/**
+	 * @brief Compiles the shaders for the default SPIR-V version of glslang again
+	 */
+	static void reset_target_environment();
+
 	/**
 	 * @brief Compiles GLSL to SPIRV code
 	 * @param stage The Vulkan shader stage flag
@@ -51,5 +64,10 @@ class GLSLCompiler
 	                      const ShaderVariant &       shader_variant,
 	                      std::vector<std::uint32_t> &spirv,
 	                      std::string &               info_log);
+
+  private:
+	static glslang::EShTargetLanguage env_target_language;
+
+	static glslang::EShTargetLanguageVersion env_target_language_version;
 };
 }        // namespace vkb
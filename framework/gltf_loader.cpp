@@ -19,13 +19,17 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "gltf_loader.h"
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <numeric>
 #include <queue>
 
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 VKBP_ENABLE_WARNINGS()
 
@@ -35,8 +39,15 @@ VKBP_ENABLE_WARNINGS()
 #include "common/vk_common.h"
 #include "core/device.h"
 #include "core/image.h"
+#include "job_system.h"
+#include "geometry/meshlet_builder.h"
+#include "geometry/simplifier.h"
+#include "geometry/vertex_optimizer.h"
+#include "platform/async_io.h"
 #include "platform/filesystem.h"
+#include "scene_graph/components/animation.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/geometry_arena.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/image/astc.h"
 #include "scene_graph/components/light.h"
@@ -44,11 +55,16 @@ VKBP_ENABLE_WARNINGS()
 #include "scene_graph/components/pbr_material.h"
 #include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/sampler.h"
+#include "scene_graph/components/skin.h"
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/components/transform.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "scene_snapshot.h"
+#include "stats/cpu_profiler.h"
+#include "texture_streamer.h"
+#include "upload_manager.h"
 
 #include <ctpl_stl.h>
 
@@ -56,6 +72,32 @@ namespace vkb
 {
 namespace
 {
+/**
+ * @brief Destroys the fence of an upload when leaving its scope, also when the submission throws
+ */
+struct ScopedFence
+{
+	explicit ScopedFence(VkDevice device) :
+	    device{device}
+	{}
+
+	ScopedFence(const ScopedFence &) = delete;
+
+	ScopedFence &operator=(const ScopedFence &) = delete;
+
+	~ScopedFence()
+	{
+		if (handle != VK_NULL_HANDLE)
+		{
+			vkDestroyFence(device, handle, nullptr);
+		}
+	}
+
+	VkDevice device;
+
+	VkFence handle{VK_NULL_HANDLE};
+};
+
 inline VkFilter find_min_filter(int min_filter)
 {
 	switch (min_filter)
@@ -277,295 +319,2107 @@ inline std::vector<uint8_t> convert_underlying_data_stride(const std::vector<uin
 	return result;
 }
 
-inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &staging_buffer, sg::Image &image)
+// Geometry is packed into arenas of this size, larger only for primitives which do not fit
+constexpr size_t GEOMETRY_ARENA_SIZE = 32 * 1024 * 1024;
+
+// The first generated level of detail clusters the vertices in a grid of this resolution, halved for each next level
+constexpr uint32_t LOD_GRID_RESOLUTION = 64;
+
+// The first generated level of detail is drawn under this screen size, halved for each next level
+constexpr float LOD_SCREEN_SIZE = 0.5f;
+
+inline size_t align_arena_offset(size_t offset)
 {
-	// Clean up the image data, as they are copied in the staging buffer
-	image.clear_data();
+	return (offset + sg::GeometryArena::RANGE_ALIGNMENT - 1) & ~(sg::GeometryArena::RANGE_ALIGNMENT - 1);
+}
 
+/**
+ * @brief Finds the arena with room for size more bytes, adding one if the last arena is full
+ * @return Index of the arena in arenas
+ */
+inline size_t reserve_arena_range(std::vector<std::vector<uint8_t>> &arenas, size_t size)
+{
+	if (arenas.empty() || (!arenas.back().empty() && align_arena_offset(arenas.back().size()) + size > GEOMETRY_ARENA_SIZE))
 	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
-		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		memory_barrier.src_access_mask = 0;
-		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
-		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-		command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
+		arenas.emplace_back();
 	}
 
-	// Create a buffer image copy for every mip level
-	auto &mipmaps = image.get_mipmaps();
+	return arenas.size() - 1;
+}
+
+/**
+ * @brief Appends data to an arena
+ * @return The offset of the data in the arena
+ */
+inline size_t append_to_arena(std::vector<uint8_t> &arena, const std::vector<uint8_t> &data)
+{
+	auto offset = align_arena_offset(arena.size());
+
+	arena.resize(offset);
+	arena.insert(arena.end(), data.begin(), data.end());
+
+	return offset;
+}
+
+/**
+ * @brief The geometry of a primitive, extracted from the glTF buffers before it is packed into the arenas
+ */
+struct PrimitiveData
+{
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> attribute_data;
+
+	size_t attribute_data_size{0};
+
+	std::vector<uint8_t> index_data;
 
-	std::vector<VkBufferImageCopy> buffer_copy_regions(mipmaps.size());
+	/// Levels of detail appended to the index data, their first indices are relative to the start of the data
+	std::vector<sg::SubMeshLod> lods;
 
-	for (size_t i = 0; i < mipmaps.size(); ++i)
+	/// Meshlets of the full detail indices
+	MeshletData meshlets;
+
+	/// Position and normal offsets of each vertex, target after target
+	std::vector<glm::vec4> morph_targets;
+
+	uint32_t morph_target_count{0};
+};
+
+/**
+ * @brief The processing of the geometry of the primitives at import, set on the loader
+ */
+struct GeometryProcessing
+{
+	uint32_t lod_levels{0};
+
+	bool optimize_vertex_order{false};
+
+	bool quantize_attributes{false};
+
+	bool generate_meshlets{false};
+};
+
+// Texture coordinates quantized to half floats keep their range, so repeating textures keep working
+constexpr VkFormat QUANTIZED_TEXCOORD_FORMAT = VK_FORMAT_R16G16_SFLOAT;
+
+// 3 component 16 bit formats are rarely supported for vertex input
+constexpr VkFormat QUANTIZED_NORMAL_FORMAT = VK_FORMAT_R16G16B16A16_SNORM;
+
+/**
+ * @return The format an attribute is quantized to, VK_FORMAT_UNDEFINED if it is kept as it is
+ */
+inline VkFormat get_quantized_format(const std::string &name, VkFormat format)
+{
+	if (name == "normal" && format == VK_FORMAT_R32G32B32_SFLOAT)
 	{
-		auto &mipmap      = mipmaps[i];
-		auto &copy_region = buffer_copy_regions[i];
+		return QUANTIZED_NORMAL_FORMAT;
+	}
 
-		copy_region.bufferOffset     = mipmap.offset;
-		copy_region.imageSubresource = image.get_vk_image_view().get_subresource_layers();
-		// Update miplevel
-		copy_region.imageSubresource.mipLevel = mipmap.level;
-		copy_region.imageExtent               = mipmap.extent;
+	if (name.compare(0, 9, "texcoord_") == 0 && format == VK_FORMAT_R32G32_SFLOAT)
+	{
+		return QUANTIZED_TEXCOORD_FORMAT;
 	}
 
-	command_buffer.copy_buffer_to_image(staging_buffer, image.get_vk_image(), buffer_copy_regions);
+	return VK_FORMAT_UNDEFINED;
+}
+
+/**
+ * @brief Converts float attribute data to a quantized format
+ */
+inline std::vector<uint8_t> quantize_attribute(const std::vector<uint8_t> &data, size_t stride, VkFormat format)
+{
+	auto vertex_count = data.size() / stride;
+
+	std::vector<uint8_t> quantized;
+
+	if (format == QUANTIZED_NORMAL_FORMAT)
+	{
+		quantized.resize(vertex_count * sizeof(uint64_t));
+
+		for (size_t i = 0; i < vertex_count; ++i)
+		{
+			glm::vec3 normal;
+			std::memcpy(&normal, data.data() + i * stride, sizeof(glm::vec3));
 
+			uint64_t packed = glm::packSnorm4x16(glm::vec4(normal, 0.0f));
+			std::memcpy(quantized.data() + i * sizeof(uint64_t), &packed, sizeof(uint64_t));
+		}
+	}
+	else if (format == QUANTIZED_TEXCOORD_FORMAT)
 	{
-		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
-		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		quantized.resize(vertex_count * sizeof(uint32_t));
 
-		command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
+		for (size_t i = 0; i < vertex_count; ++i)
+		{
+			glm::vec2 texcoord;
+			std::memcpy(&texcoord, data.data() + i * stride, sizeof(glm::vec2));
+
+			uint32_t packed = glm::packHalf2x16(texcoord);
+			std::memcpy(quantized.data() + i * sizeof(uint32_t), &packed, sizeof(uint32_t));
+		}
 	}
+
+	return quantized;
 }
-}        // namespace
 
-std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
-    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
+/**
+ * @brief Reads 16 or 32 bit index data
+ */
+inline std::vector<uint32_t> decode_indices(const std::vector<uint8_t> &index_data, bool wide_indices)
+{
+	size_t index_size = wide_indices ? sizeof(uint32_t) : sizeof(uint16_t);
 
-GLTFLoader::GLTFLoader(Device &device) :
-    device{device}
+	std::vector<uint32_t> indices(index_data.size() / index_size);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (wide_indices)
+		{
+			std::memcpy(&indices[i], index_data.data() + i * index_size, sizeof(uint32_t));
+		}
+		else
+		{
+			uint16_t index;
+			std::memcpy(&index, index_data.data() + i * index_size, sizeof(uint16_t));
+			indices[i] = index;
+		}
+	}
+
+	return indices;
+}
+
+/**
+ * @brief Appends indices to 16 or 32 bit index data
+ */
+inline void encode_indices(const std::vector<uint32_t> &indices, bool wide_indices, std::vector<uint8_t> &index_data)
 {
+	size_t index_size = wide_indices ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	auto offset = index_data.size();
+	index_data.resize(offset + indices.size() * index_size);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (wide_indices)
+		{
+			std::memcpy(index_data.data() + offset + i * index_size, &indices[i], sizeof(uint32_t));
+		}
+		else
+		{
+			auto index = static_cast<uint16_t>(indices[i]);
+			std::memcpy(index_data.data() + offset + i * index_size, &index, sizeof(uint16_t));
+		}
+	}
 }
 
-std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
+/**
+ * @brief Sets the attributes, counts and index type of a submesh from the accessors of a primitive, without reading its buffers
+ */
+/**
+ * @brief Computes the bounds of a float position accessor that does not store them
+ * @return False if the accessor holds no positions to compute the bounds from
+ */
+inline bool compute_position_bounds(const tinygltf::Model &model, const tinygltf::Accessor &accessor, JobSystem *job_system, sg::AABB &bounds)
 {
-	std::string err;
-	std::string warn;
+	if (accessor.bufferView < 0 || accessor.count == 0 ||
+	    accessor.type != TINYGLTF_TYPE_VEC3 || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+	{
+		return false;
+	}
 
-	tinygltf::TinyGLTF gltf_loader;
+	auto &buffer_view = model.bufferViews.at(accessor.bufferView);
+	auto &buffer      = model.buffers.at(buffer_view.buffer);
 
-	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+	size_t         stride = accessor.ByteStride(buffer_view);
+	const uint8_t *data   = buffer.data.data() + accessor.byteOffset + buffer_view.byteOffset;
+
+	if (stride == sizeof(glm::vec3))
+	{
+		// Tightly packed positions are reduced in place
+		bounds.update(reinterpret_cast<const glm::vec3 *>(data), accessor.count, job_system);
+	}
+	else
+	{
+		for (size_t i = 0; i < accessor.count; ++i)
+		{
+			glm::vec3 position;
+			std::memcpy(&position, data + i * stride, sizeof(glm::vec3));
+			bounds.update(position);
+		}
+	}
 
-	bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
+	return true;
+}
 
-	if (!importResult)
+inline void parse_primitive_layout(const tinygltf::Model &model, const tinygltf::Primitive &gltf_primitive, const GeometryProcessing &processing, sg::SubMesh &submesh)
+{
+	for (auto &attribute : gltf_primitive.attributes)
 	{
-		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+		std::string attrib_name = attribute.first;
+		std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
 
-		return nullptr;
+		if (attrib_name == "position")
+		{
+			submesh.vertices_count = to_u32(model.accessors.at(attribute.second).count);
+		}
+
+		sg::VertexAttribute attrib;
+		attrib.format = get_attribute_format(&model, attribute.second);
+		attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+
+		auto quantized_format = processing.quantize_attributes ? get_quantized_format(attrib_name, attrib.format) : VK_FORMAT_UNDEFINED;
+
+		if (quantized_format != VK_FORMAT_UNDEFINED)
+		{
+			// Quantized attributes are tightly packed
+			attrib.format = quantized_format;
+			attrib.stride = to_u32(get_bits_per_pixel(quantized_format) / 8);
+		}
+
+		submesh.set_attribute(attrib_name, attrib);
 	}
 
-	if (!err.empty())
+	if (gltf_primitive.indices >= 0)
 	{
-		LOGE("Error loading gltf model: {}.", err.c_str());
+		submesh.vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
 
-		return nullptr;
-	}
+		auto format = get_attribute_format(&model, gltf_primitive.indices);
 
-	if (!warn.empty())
+		switch (format)
+		{
+			case VK_FORMAT_R8_UINT:
+			case VK_FORMAT_R16_UINT:
+				// uint8 indices are converted to uint16
+				submesh.index_type = VK_INDEX_TYPE_UINT16;
+				break;
+			case VK_FORMAT_R32_UINT:
+				submesh.index_type = VK_INDEX_TYPE_UINT32;
+				break;
+			default:
+				LOGE("gltf primitive has invalid format type");
+				break;
+		}
+	}
+	else
 	{
-		LOGI("{}", warn.c_str());
+		submesh.vertices_count = to_u32(get_attribute_size(&model, gltf_primitive.attributes.at("POSITION")));
 	}
+}
 
-	size_t pos = file_name.find_last_of('/');
+/**
+ * @brief Reorders the triangles of an indexed triangle list for the vertex cache, then its vertices in the order the triangles use them
+ * @return The average cache miss ratios before and after
+ */
+inline std::pair<float, float> optimize_vertex_order(const std::vector<size_t> &attribute_strides, size_t vertex_count, bool wide_indices, PrimitiveData &primitive)
+{
+	auto indices = decode_indices(primitive.index_data, wide_indices);
 
-	model_path = file_name.substr(0, pos);
+	float acmr_before = calculate_acmr(indices, vertex_count);
 
-	if (pos == std::string::npos)
+	indices = optimize_vertex_cache(indices, vertex_count);
+
+	auto remap = optimize_vertex_fetch(indices, vertex_count);
+
+	for (size_t i = 0; i < primitive.attribute_data.size(); ++i)
 	{
-		model_path.clear();
+		auto &data   = primitive.attribute_data[i].second;
+		auto  stride = attribute_strides[i];
+
+		std::vector<uint8_t> reordered(data.size());
+
+		for (size_t vertex = 0; vertex < vertex_count && (vertex + 1) * stride <= data.size(); ++vertex)
+		{
+			std::memcpy(reordered.data() + remap[vertex] * stride, data.data() + vertex * stride, stride);
+		}
+
+		data = std::move(reordered);
 	}
 
-	return std::make_unique<sg::Scene>(load_scene(scene_index));
+	primitive.index_data.clear();
+	encode_indices(indices, wide_indices, primitive.index_data);
+
+	return {acmr_before, calculate_acmr(indices, vertex_count)};
 }
 
-std::unique_ptr<sg::SubMesh> GLTFLoader::read_model_from_file(const std::string &file_name, uint32_t index)
+/**
+ * @brief Simplifies the indices of a triangle list primitive into lower levels of detail, appended to its index data
+ * @param positions The positions of the vertices of the primitive
+ */
+inline void generate_lods(const std::vector<glm::vec3> &positions, bool wide_indices, uint32_t lod_levels, PrimitiveData &primitive)
 {
-	std::string err;
-	std::string warn;
+	size_t index_size = wide_indices ? sizeof(uint32_t) : sizeof(uint16_t);
 
-	tinygltf::TinyGLTF gltf_loader;
-
-	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+	auto indices = decode_indices(primitive.index_data, wide_indices);
 
-	bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
+	auto previous_count = indices.size();
 
-	if (!importResult)
+	for (uint32_t level = 0; level < lod_levels; ++level)
 	{
-		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+		auto lod_indices = simplify_by_clustering(positions, indices, LOD_GRID_RESOLUTION >> level);
 
-		return nullptr;
+		// Levels which barely simplify the previous one are not worth their memory
+		if (lod_indices.empty() || lod_indices.size() * 5 > previous_count * 4)
+		{
+			continue;
+		}
+
+		sg::SubMeshLod lod;
+		lod.first_index     = to_u32(primitive.index_data.size() / index_size);
+		lod.index_count     = to_u32(lod_indices.size());
+		lod.max_screen_size = LOD_SCREEN_SIZE / static_cast<float>(1 << level);
+
+		encode_indices(lod_indices, wide_indices, primitive.index_data);
+
+		primitive.lods.push_back(lod);
+
+		previous_count = lod_indices.size();
 	}
+}
 
-	if (!err.empty())
-	{
-		LOGE("Error loading gltf model: {}.", err.c_str());
+/**
+ * @brief Sets the levels of detail of a submesh, once its first index is known
+ */
+inline void set_submesh_lods(sg::SubMesh &submesh, const PrimitiveData &primitive)
+{
+	submesh.lods = primitive.lods;
 
-		return nullptr;
+	for (auto &lod : submesh.lods)
+	{
+		lod.first_index += submesh.first_index;
 	}
+}
 
-	if (!warn.empty())
+/**
+ * @brief Uploads the meshlets of a primitive to the meshlet buffer of its submesh
+ *        The vertex and triangle lists follow the meshlets, at offsets suitable for storage buffer bindings.
+ */
+inline void create_meshlet_buffer(Device &device, sg::SubMesh &submesh, const MeshletData &meshlets)
+{
+	if (meshlets.meshlets.empty())
 	{
-		LOGI("{}", warn.c_str());
+		return;
 	}
 
-	size_t pos = file_name.find_last_of('/');
+	auto alignment = device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment;
 
-	model_path = file_name.substr(0, pos);
+	auto align = [alignment](VkDeviceSize offset) {
+		return (offset + alignment - 1) / alignment * alignment;
+	};
 
-	if (pos == std::string::npos)
+	auto meshlets_size  = meshlets.meshlets.size() * sizeof(Meshlet);
+	auto vertices_size  = meshlets.vertices.size() * sizeof(uint32_t);
+	auto triangles_size = meshlets.triangles.size() * sizeof(uint32_t);
+
+	submesh.meshlet_count            = to_u32(meshlets.meshlets.size());
+	submesh.meshlet_vertices_offset  = align(meshlets_size);
+	submesh.meshlet_triangles_offset = align(submesh.meshlet_vertices_offset + vertices_size);
+
+	std::vector<uint8_t> data(submesh.meshlet_triangles_offset + triangles_size);
+	std::memcpy(data.data(), meshlets.meshlets.data(), meshlets_size);
+	std::memcpy(data.data() + submesh.meshlet_vertices_offset, meshlets.vertices.data(), vertices_size);
+	std::memcpy(data.data() + submesh.meshlet_triangles_offset, meshlets.triangles.data(), triangles_size);
+
+	submesh.meshlet_buffer = std::make_unique<core::Buffer>(device,
+	                                                        data.size(),
+	                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                        VMA_MEMORY_USAGE_GPU_TO_CPU);
+	submesh.meshlet_buffer->update(data);
+}
+
+/**
+ * @brief Uploads the morph targets of a primitive to the morph target buffer of its submesh
+ */
+inline void create_morph_target_buffer(Device &device, sg::SubMesh &submesh, const PrimitiveData &primitive)
+{
+	if (primitive.morph_targets.empty())
 	{
-		model_path.clear();
+		return;
 	}
 
-	return std::move(load_model(index));
+	auto size = primitive.morph_targets.size() * sizeof(glm::vec4);
+
+	submesh.morph_target_count  = primitive.morph_target_count;
+	submesh.morph_target_buffer = std::make_unique<core::Buffer>(device,
+	                                                             size,
+	                                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                             VMA_MEMORY_USAGE_GPU_TO_CPU);
+	submesh.morph_target_buffer->update(reinterpret_cast<const uint8_t *>(primitive.morph_targets.data()), size);
 }
 
-sg::Scene GLTFLoader::load_scene(int scene_index)
+/**
+ * @brief Reads the elements of an accessor as floats, normalized integers are converted to their value
+ */
+inline std::vector<float> read_accessor_floats(const tinygltf::Model &model, int accessor_id)
 {
-	auto scene = sg::Scene();
+	auto &accessor        = model.accessors.at(accessor_id);
+	auto  component_count = static_cast<size_t>(tinygltf::GetNumComponentsInType(accessor.type));
 
-	scene.set_name("gltf_scene");
+	std::vector<float> values(accessor.count * component_count, 0.0f);
 
-	// Check extensions
-	for (auto &used_extension : model.extensionsUsed)
+	// Sparse accessors without a buffer view are all zeros
+	if (accessor.bufferView < 0)
 	{
-		auto it = supported_extensions.find(used_extension);
+		return values;
+	}
 
-		// Check if extension isn't supported by the GLTFLoader
-		if (it == supported_extensions.end())
+	auto &buffer_view    = model.bufferViews.at(accessor.bufferView);
+	auto &buffer         = model.buffers.at(buffer_view.buffer);
+	auto  component_size = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType));
+	auto  stride         = static_cast<size_t>(accessor.ByteStride(buffer_view));
+	auto  data           = buffer.data.data() + buffer_view.byteOffset + accessor.byteOffset;
+
+	for (size_t i = 0; i < accessor.count; i++)
+	{
+		for (size_t c = 0; c < component_count; c++)
 		{
-			// If extension is required then we shouldn't allow the scene to be loaded
-			if (std::find(model.extensionsRequired.begin(), model.extensionsRequired.end(), used_extension) != model.extensionsRequired.end())
-			{
-				throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
-			}
-			else
+			auto element = data + i * stride + c * component_size;
+			auto &value  = values[i * component_count + c];
+
+			switch (accessor.componentType)
 			{
-				// Otherwise, if extension isn't required (but is in the file) then print a warning to the user
-				LOGW("glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+				case TINYGLTF_COMPONENT_TYPE_FLOAT:
+					std::memcpy(&value, element, sizeof(float));
+					break;
+				case TINYGLTF_COMPONENT_TYPE_BYTE:
+					value = std::max(*reinterpret_cast<const int8_t *>(element) / 127.0f, -1.0f);
+					break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+					value = *element / 255.0f;
+					break;
+				case TINYGLTF_COMPONENT_TYPE_SHORT:
+				{
+					int16_t integer;
+					std::memcpy(&integer, element, sizeof(integer));
+					value = std::max(integer / 32767.0f, -1.0f);
+					break;
+				}
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				{
+					uint16_t integer;
+					std::memcpy(&integer, element, sizeof(integer));
+					value = integer / 65535.0f;
+					break;
+				}
+				default:
+					LOGW("Unsupported component type of an animation or skin accessor: {}", accessor.componentType);
+					break;
 			}
 		}
-		else
+	}
+
+	return values;
+}
+
+/**
+ * @brief Copies and converts the attributes and indices of a primitive, only reading the model so it can run on any thread
+ * @param name Name of the primitive in the logs
+ * @param processing The processing of the geometry, matching the layout of the submesh
+ */
+inline PrimitiveData parse_primitive(const tinygltf::Model &model, const tinygltf::Primitive &gltf_primitive, const std::string &name, const GeometryProcessing &processing)
+{
+	PrimitiveData primitive;
+
+	std::vector<size_t> attribute_strides;
+	std::vector<VkFormat> attribute_formats;
+
+	size_t vertex_count = 0;
+
+	for (auto &attribute : gltf_primitive.attributes)
+	{
+		std::string attrib_name = attribute.first;
+		std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+
+		if (attrib_name == "position")
 		{
-			// Extension is supported, so enable it
-			LOGI("glTF file contains extension: {}", used_extension);
-			it->second = true;
+			vertex_count = get_attribute_size(&model, attribute.second);
 		}
+
+		attribute_strides.push_back(get_attribute_stride(&model, attribute.second));
+		attribute_formats.push_back(get_attribute_format(&model, attribute.second));
+
+		primitive.attribute_data.emplace_back(attrib_name, get_attribute_data(&model, attribute.second));
 	}
 
-	// Load lights
-	std::vector<std::unique_ptr<sg::Light>> light_components = parse_khr_lights_punctual();
+	bool triangle_list = gltf_primitive.mode == TINYGLTF_MODE_TRIANGLES;
 
-	scene.set_components(std::move(light_components));
+	if (gltf_primitive.indices >= 0)
+	{
+		primitive.index_data = get_attribute_data(&model, gltf_primitive.indices);
 
-	// Load samplers
-	std::vector<std::unique_ptr<sg::Sampler>>
-	    sampler_components(model.samplers.size());
+		if (get_attribute_format(&model, gltf_primitive.indices) == VK_FORMAT_R8_UINT)
+		{
+			// Converts uint8 data into uint16 data, still represented by a uint8 vector
+			primitive.index_data = convert_underlying_data_stride(primitive.index_data, 1, 2);
+		}
+
+		bool wide_indices = get_attribute_format(&model, gltf_primitive.indices) == VK_FORMAT_R32_UINT;
+
+		// Reordering the vertices would also have to reorder the morph targets
+		if (processing.optimize_vertex_order && triangle_list && vertex_count > 0 && gltf_primitive.targets.empty())
+		{
+			auto acmr = optimize_vertex_order(attribute_strides, vertex_count, wide_indices, primitive);
+
+			LOGI("Vertex cache of {}: ACMR {:.3f} -> {:.3f}", name, acmr.first, acmr.second);
+		}
+
+		auto position_it = std::find_if(primitive.attribute_data.begin(), primitive.attribute_data.end(),
+		                                [](const std::pair<std::string, std::vector<uint8_t>> &attribute) { return attribute.first == "position"; });
+
+		if ((processing.lod_levels > 0 || processing.generate_meshlets) && triangle_list && position_it != primitive.attribute_data.end() &&
+		    attribute_formats[position_it - primitive.attribute_data.begin()] == VK_FORMAT_R32G32B32_SFLOAT)
+		{
+			auto position_stride = attribute_strides[position_it - primitive.attribute_data.begin()];
+
+			std::vector<glm::vec3> positions(vertex_count);
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				std::memcpy(&positions[i], position_it->second.data() + i * position_stride, sizeof(glm::vec3));
+			}
+
+			// Built before the levels of detail are appended to the indices
+			if (processing.generate_meshlets)
+			{
+				primitive.meshlets = build_meshlets(positions, decode_indices(primitive.index_data, wide_indices));
+
+				LOGD("Meshlets of {}: {}", name, primitive.meshlets.meshlets.size());
+			}
+
+			generate_lods(positions, wide_indices, processing.lod_levels, primitive);
+		}
+	}
+
+	for (size_t i = 0; i < primitive.attribute_data.size(); ++i)
+	{
+		auto &attribute = primitive.attribute_data[i];
+
+		auto quantized_format = processing.quantize_attributes ? get_quantized_format(attribute.first, attribute_formats[i]) : VK_FORMAT_UNDEFINED;
+
+		if (quantized_format != VK_FORMAT_UNDEFINED)
+		{
+			attribute.second = quantize_attribute(attribute.second, attribute_strides[i], quantized_format);
+		}
+
+		primitive.attribute_data_size += align_arena_offset(attribute.second.size());
+	}
+
+	for (auto &target : gltf_primitive.targets)
+	{
+		auto read_target = [&](const char *attribute) {
+			auto it = target.find(attribute);
+			return it != target.end() ? read_accessor_floats(model, it->second) : std::vector<float>(vertex_count * 3, 0.0f);
+		};
+
+		auto positions = read_target("POSITION");
+		auto normals   = read_target("NORMAL");
+
+		for (size_t vertex = 0; vertex < vertex_count && (vertex + 1) * 3 <= positions.size() && (vertex + 1) * 3 <= normals.size(); vertex++)
+		{
+			primitive.morph_targets.emplace_back(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2], 0.0f);
+			primitive.morph_targets.emplace_back(normals[vertex * 3], normals[vertex * 3 + 1], normals[vertex * 3 + 2], 0.0f);
+		}
+	}
+
+	if (primitive.morph_targets.size() == gltf_primitive.targets.size() * vertex_count * 2)
+	{
+		primitive.morph_target_count = to_u32(gltf_primitive.targets.size());
+	}
+	else
+	{
+		LOGW("Morph targets of {} do not match its vertices, they are ignored", name);
+		primitive.morph_targets.clear();
+	}
+
+	return primitive;
+}
+
+/**
+ * @brief Parses a glTF file from a memory mapping of it, instead of a copy read by tinygltf
+ *        Buffers in separate files are still read by tinygltf into the model.
+ */
+inline bool load_gltf_file(tinygltf::TinyGLTF &gltf_loader, tinygltf::Model &model, std::string &err, std::string &warn, const std::string &gltf_file)
+{
+	std::unique_ptr<fs::MappedFile> file;
+
+	try
+	{
+		file = std::make_unique<fs::MappedFile>(gltf_file);
+	}
+	catch (const std::runtime_error &e)
+	{
+		err = e.what();
+		return false;
+	}
+
+	auto base_dir = gltf_file.substr(0, gltf_file.find_last_of('/') + 1);
+
+	return gltf_loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char *>(file->data()), to_u32(file->size()), base_dir);
+}
+
+template <typename T>
+inline bool is_ready(const std::future<T> &future)
+{
+	return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+/**
+ * @return Whether the mip chain of images of a format can be blitted with linear filtering
+ */
+inline bool supports_gpu_mipmaps(const Device &device, VkFormat format)
+{
+	VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+	return (device.get_gpu().get_format_properties(format).optimalTilingFeatures & required_features) == required_features;
+}
+
+/**
+ * @return Usage added to the vertex and index buffers of a scene, so that acceleration structures can be built from them
+ */
+inline VkBufferUsageFlags get_geometry_buffer_usage(Device &device)
+{
+	VkBufferUsageFlags usage = 0;
+
+	if (device.is_enabled(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME))
+	{
+		usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+	}
+
+	if (device.is_enabled(VK_KHR_RAY_TRACING_EXTENSION_NAME))
+	{
+		usage |= VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR;
+	}
+
+#ifdef VK_EXT_mesh_shader
+	// Mesh shaders fetch the vertices of the meshlets from storage buffers
+	if (device.is_enabled(VK_EXT_MESH_SHADER_EXTENSION_NAME))
+	{
+		usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	}
+#endif
+
+	return usage;
+}
+
+/**
+ * @brief Creates an image of a single texel, shown by the textures whose image is streamed
+ */
+inline std::unique_ptr<sg::Image> create_placeholder_image(Device &device, const std::string &name, const std::array<uint8_t, 4> &color)
+{
+	std::vector<sg::Mipmap> mipmaps{{/* .level = */ 0, /* .offset = */ 0, /* .extent = */ {1, 1, 1}}};
+
+	auto image = std::make_unique<sg::Image>(name, std::vector<uint8_t>(color.begin(), color.end()), std::move(mipmaps));
+	image->create_vk_image(device);
+
+	return image;
+}
+
+inline void upload_image_to_gpu(UploadManager &upload_manager, sg::Image &image, TextureStreamer *texture_streamer, AssetCache *asset_cache)
+{
+	// Images sharing the Vulkan image of an earlier image are already uploaded
+	if (image.get_data().empty())
+	{
+		return;
+	}
+
+	image.upload(upload_manager);
+
+	if (texture_streamer && texture_streamer->can_stream(image))
+	{
+		// The data of the finer levels is uploaded once they are requested
+		texture_streamer->add_image(image);
+	}
+	else
+	{
+		if (asset_cache)
+		{
+			auto shared = image.get_shared_vk_image();
+			asset_cache->add_image(image.get_content_hash(), shared.first, shared.second);
+		}
+
+		// Clean up the image data, as they are copied in the staging buffer
+		image.clear_data();
+	}
+}
+
+/**
+ * @brief An image restored from a scene snapshot, with the format and layout it was recorded with
+ */
+class SnapshotImage : public sg::Image
+{
+  public:
+	SnapshotImage(SceneSnapshot::ImageRecord &&record) :
+	    sg::Image{record.name, std::move(record.data), std::move(record.mipmaps)}
+	{
+		set_format(record.format);
+		set_layers(record.layers);
+		set_offsets(record.offsets);
+	}
+};
+
+/**
+ * @brief Copies a decoded image into a snapshot record
+ */
+inline SceneSnapshot::ImageRecord record_image(const sg::Image &image)
+{
+	SceneSnapshot::ImageRecord record;
+	record.name    = image.get_name();
+	record.format  = image.get_format();
+	record.layers  = image.get_layers();
+	record.mipmaps = image.get_mipmaps();
+	record.offsets = image.get_offsets();
+	record.data    = image.get_data();
+
+	return record;
+}
+
+/**
+ * @return Whether a glTF URI refers to a file, rather than embedding its data
+ */
+inline bool is_file_uri(const std::string &uri)
+{
+	return !uri.empty() && uri.compare(0, 5, "data:") != 0;
+}
+}        // namespace
+
+struct GLTFLoader::StreamingState
+{
+	StreamingState(Device &device) :
+	    upload_manager{device}
+	{}
+
+	~StreamingState()
+	{
+		// Cancels the pending reads first, so that the running image tasks waiting on them complete
+		async_io.reset();
+
+		// Drops the queued tasks, the running ones complete
+		if (thread_pool)
+		{
+			thread_pool->stop(false);
+		}
+	}
+
+	/**
+	 * @brief Creates the buffers of the arenas being packed, and draws their submeshes from them
+	 */
+	void flush_arenas(Device &device);
+
+	sg::Scene *scene{nullptr};
+
+	UploadManager upload_manager;
+
+	/// Reads the files of the images in the background, those used by the most primitives first
+	std::unique_ptr<fs::AsyncIO> async_io{std::make_unique<fs::AsyncIO>()};
+
+	std::vector<std::future<std::unique_ptr<sg::Image>>> image_futures;
+
+	/// Textures showing a placeholder, by index of the glTF image they show once loaded
+	std::vector<std::vector<sg::Texture *>> image_textures;
+
+	size_t pending_image_count{0};
+
+	std::vector<std::future<PrimitiveData>> primitive_futures;
+
+	/// Submeshes waiting for their geometry, in the order of primitive_futures
+	std::vector<sg::SubMesh *> primitive_submeshes;
+
+	/// Primitives are packed in order, as in load_scene()
+	size_t next_primitive{0};
+
+	std::vector<uint8_t> vertex_arena;
+
+	std::vector<uint8_t> index_arena;
+
+	std::vector<sg::SubMesh *> arena_submeshes;
+
+	size_t arena_count{0};
+
+	Timer timer;
+
+	std::unique_ptr<ctpl::thread_pool> thread_pool;
+};
+
+void GLTFLoader::StreamingState::flush_arenas(Device &device)
+{
+	if (arena_submeshes.empty())
+	{
+		return;
+	}
+
+	core::Buffer vertex_buffer{device,
+	                           std::max<VkDeviceSize>(vertex_arena.size(), 1),
+	                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | get_geometry_buffer_usage(device),
+	                           VMA_MEMORY_USAGE_GPU_TO_CPU};
+	vertex_buffer.update(vertex_arena);
+
+	core::Buffer index_buffer{device,
+	                          std::max<VkDeviceSize>(index_arena.size(), 1),
+	                          VK_BUFFER_USAGE_INDEX_BUFFER_BIT | get_geometry_buffer_usage(device),
+	                          VMA_MEMORY_USAGE_GPU_TO_CPU};
+	index_buffer.update(index_arena);
+
+	auto vertex_arena_component = std::make_unique<sg::GeometryArena>("vertex_arena_" + std::to_string(arena_count), std::move(vertex_buffer));
+	auto index_arena_component  = std::make_unique<sg::GeometryArena>("index_arena_" + std::to_string(arena_count), std::move(index_buffer));
+
+	for (auto submesh : arena_submeshes)
+	{
+		submesh->vertex_arena = vertex_arena_component.get();
+
+		if (submesh->vertex_indices != 0)
+		{
+			submesh->index_arena = index_arena_component.get();
+		}
+	}
+
+	scene->add_component(std::move(vertex_arena_component));
+	scene->add_component(std::move(index_arena_component));
+
+	vertex_arena.clear();
+	index_arena.clear();
+	arena_submeshes.clear();
+
+	++arena_count;
+}
+
+std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
+    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false},
+    {KHR_TEXTURE_BASISU_EXTENSION, false}};
+
+GLTFLoader::GLTFLoader(Device &device) :
+    device{device}
+{
+}
+
+GLTFLoader::~GLTFLoader() = default;
+
+std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
+{
+	snapshot.reset();
+
+	uint64_t snapshot_key{0};
+
+	if (scene_snapshots && !streaming)
+	{
+		snapshot_key = get_snapshot_key(file_name, scene_index);
+
+		Timer timer;
+		timer.start();
+
+		SceneSnapshot cached_snapshot;
+		if (cached_snapshot.load(snapshot_key))
+		{
+			auto scene = std::make_unique<sg::Scene>(load_scene_snapshot(cached_snapshot));
+
+			LOGI("Loaded {} from its scene snapshot in {} seconds", file_name, vkb::to_string(timer.stop()));
+
+			return scene;
+		}
+
+		// Recorded by load_scene()
+		snapshot = std::make_unique<SceneSnapshot>();
+	}
+
+	std::string err;
+	std::string warn;
+
+	tinygltf::TinyGLTF gltf_loader;
+
+	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+
+	bool importResult = load_gltf_file(gltf_loader, model, err, warn, gltf_file);
+
+	if (!importResult)
+	{
+		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+
+		return nullptr;
+	}
+
+	if (!err.empty())
+	{
+		LOGE("Error loading gltf model: {}.", err.c_str());
+
+		return nullptr;
+	}
+
+	if (!warn.empty())
+	{
+		LOGI("{}", warn.c_str());
+	}
+
+	size_t pos = file_name.find_last_of('/');
+
+	model_path = file_name.substr(0, pos);
+
+	if (pos == std::string::npos)
+	{
+		model_path.clear();
+	}
+
+	auto scene = std::make_unique<sg::Scene>(load_scene(scene_index));
+
+	if (snapshot)
+	{
+		// The snapshot is stale once any of the files the scene was read from changes
+		auto base_dir = gltf_file.substr(0, gltf_file.find_last_of('/') + 1);
+
+		snapshot->add_source_file(gltf_file);
+
+		for (auto &buffer : model.buffers)
+		{
+			if (is_file_uri(buffer.uri))
+			{
+				snapshot->add_source_file(base_dir + buffer.uri);
+			}
+		}
+
+		for (auto &image : model.images)
+		{
+			if (is_file_uri(image.uri))
+			{
+				snapshot->add_source_file(base_dir + image.uri);
+			}
+		}
+
+		snapshot->store(snapshot_key);
+		snapshot.reset();
+	}
+
+	return scene;
+}
+
+std::unique_ptr<sg::Scene> GLTFLoader::stream_scene_from_file(const std::string &file_name, int scene_index)
+{
+	streaming = std::make_unique<StreamingState>(device);
+	streaming->timer.start();
+
+	auto scene = read_scene_from_file(file_name, scene_index);
+
+	if (!scene)
+	{
+		streaming.reset();
+
+		return nullptr;
+	}
+
+	streaming->scene = scene.get();
+
+	return scene;
+}
+
+bool GLTFLoader::update_streaming()
+{
+	if (!streaming)
+	{
+		return false;
+	}
+
+	auto &state   = *streaming;
+	bool  changed = false;
+
+	for (size_t image_index = 0; image_index < state.image_futures.size(); image_index++)
+	{
+		auto &fut = state.image_futures[image_index];
+
+		if (!is_ready(fut))
+		{
+			continue;
+		}
+
+		auto image = fut.get();
+
+		upload_image_to_gpu(state.upload_manager, *image, texture_streamer, &device.get_asset_cache());
+
+		for (auto texture : state.image_textures[image_index])
+		{
+			texture->set_image(*image);
+		}
+
+		state.scene->add_component(std::move(image));
+
+		--state.pending_image_count;
+		changed = true;
+	}
+
+	while (state.next_primitive < state.primitive_futures.size() && is_ready(state.primitive_futures[state.next_primitive]))
+	{
+		auto  primitive = state.primitive_futures[state.next_primitive].get();
+		auto &submesh   = *state.primitive_submeshes[state.next_primitive];
+
+		++state.next_primitive;
+
+		// Full arenas are swapped in, so that the geometry shows up progressively
+		if (align_arena_offset(state.vertex_arena.size()) + primitive.attribute_data_size > GEOMETRY_ARENA_SIZE ||
+		    align_arena_offset(state.index_arena.size()) + primitive.index_data.size() > GEOMETRY_ARENA_SIZE)
+		{
+			state.flush_arenas(device);
+			changed = true;
+		}
+
+		for (auto &attribute : primitive.attribute_data)
+		{
+			submesh.vertex_arena_offsets[attribute.first] = append_to_arena(state.vertex_arena, attribute.second);
+		}
+
+		if (submesh.vertex_indices != 0)
+		{
+			auto index_offset = append_to_arena(state.index_arena, primitive.index_data);
+
+			// The index arena is bound at offset zero, ranges are aligned to any index size
+			auto index_size     = submesh.index_type == VK_INDEX_TYPE_UINT32 ? 4 : 2;
+			submesh.first_index = to_u32(index_offset / index_size);
+
+			set_submesh_lods(submesh, primitive);
+
+			create_meshlet_buffer(device, submesh, primitive.meshlets);
+		}
+
+		create_morph_target_buffer(device, submesh, primitive);
+
+		state.arena_submeshes.push_back(&submesh);
+	}
+
+	bool geometry_loaded = state.next_primitive == state.primitive_futures.size();
+
+	if (geometry_loaded && !state.arena_submeshes.empty())
+	{
+		state.flush_arenas(device);
+		changed = true;
+	}
+
+	// Submissions made after the flush see the uploaded images
+	state.upload_manager.flush();
+
+	if (changed)
+	{
+		// Recorded draws still use the placeholders
+		state.scene->invalidate();
+	}
+
+	if (geometry_loaded && state.pending_image_count == 0)
+	{
+		LOGI("Streamed {} images ({} MB read) and {} arenas in {} seconds.", state.image_futures.size(),
+		     vkb::to_string(state.async_io->get_read_bytes() / (1024.0 * 1024.0)), state.arena_count, vkb::to_string(state.timer.stop()));
+
+		streaming.reset();
+
+		return false;
+	}
+
+	return true;
+}
+
+void GLTFLoader::cancel_streaming()
+{
+	if (streaming)
+	{
+		LOGI("Cancelled streaming with {} images left.", streaming->pending_image_count);
+
+		streaming.reset();
+	}
+}
+
+std::unique_ptr<sg::SubMesh> GLTFLoader::read_model_from_file(const std::string &file_name, uint32_t index)
+{
+	std::string err;
+	std::string warn;
+
+	tinygltf::TinyGLTF gltf_loader;
+
+	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+
+	bool importResult = load_gltf_file(gltf_loader, model, err, warn, gltf_file);
+
+	if (!importResult)
+	{
+		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+
+		return nullptr;
+	}
+
+	if (!err.empty())
+	{
+		LOGE("Error loading gltf model: {}.", err.c_str());
+
+		return nullptr;
+	}
+
+	if (!warn.empty())
+	{
+		LOGI("{}", warn.c_str());
+	}
+
+	size_t pos = file_name.find_last_of('/');
+
+	model_path = file_name.substr(0, pos);
+
+	if (pos == std::string::npos)
+	{
+		model_path.clear();
+	}
+
+	return std::move(load_model(index));
+}
+
+void GLTFLoader::set_lod_levels(uint32_t levels)
+{
+	lod_levels = levels;
+}
+
+void GLTFLoader::set_job_system(JobSystem *job_system_)
+{
+	job_system = job_system_;
+}
+
+void GLTFLoader::set_texture_streamer(TextureStreamer *texture_streamer_)
+{
+	texture_streamer = texture_streamer_;
+}
+
+void GLTFLoader::set_astc_bc_transcoding(bool enabled)
+{
+	astc_bc_transcoding = enabled;
+}
+
+void GLTFLoader::set_vertex_optimization(bool enabled)
+{
+	optimize_vertex_order = enabled;
+}
+
+void GLTFLoader::set_attribute_quantization(bool enabled)
+{
+	quantize_attributes = enabled;
+}
+
+void GLTFLoader::set_meshlet_generation(bool enabled)
+{
+	generate_meshlets = enabled;
+}
+
+void GLTFLoader::set_scene_snapshots(bool enabled)
+{
+	scene_snapshots = enabled;
+}
+
+uint64_t GLTFLoader::get_snapshot_key(const std::string &file_name, int scene_index) const
+{
+	// The images are transcoded to the formats supported by the device
+	auto &properties = device.get_gpu().get_properties();
+
+	std::vector<uint32_t> settings{lod_levels,
+	                               optimize_vertex_order ? 1u : 0u,
+	                               quantize_attributes ? 1u : 0u,
+	                               generate_meshlets ? 1u : 0u,
+	                               astc_bc_transcoding ? 1u : 0u,
+	                               properties.vendorID,
+	                               properties.deviceID,
+	                               properties.driverVersion};
+
+	return SceneSnapshot::get_key(file_name, scene_index, settings);
+}
+
+sg::Scene GLTFLoader::load_scene(int scene_index)
+{
+	VKB_PROFILE_ZONE("GLTFLoader::load_scene");
+
+	auto scene = sg::Scene();
+
+	scene.set_name("gltf_scene");
+
+	bool has_morph_targets = std::any_of(model.meshes.begin(), model.meshes.end(), [](const tinygltf::Mesh &gltf_mesh) {
+		return std::any_of(gltf_mesh.primitives.begin(), gltf_mesh.primitives.end(),
+		                   [](const tinygltf::Primitive &gltf_primitive) { return !gltf_primitive.targets.empty(); });
+	});
+
+	if (snapshot && (!model.skins.empty() || !model.animations.empty() || has_morph_targets))
+	{
+		// Snapshots do not record skins, animations nor morph targets
+		LOGI("Scene snapshots are not supported by animated scenes");
+		snapshot.reset();
+	}
+
+	// Check extensions
+	for (auto &used_extension : model.extensionsUsed)
+	{
+		auto it = supported_extensions.find(used_extension);
+
+		// Check if extension isn't supported by the GLTFLoader
+		if (it == supported_extensions.end())
+		{
+			// If extension is required then we shouldn't allow the scene to be loaded
+			if (std::find(model.extensionsRequired.begin(), model.extensionsRequired.end(), used_extension) != model.extensionsRequired.end())
+			{
+				throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
+			}
+			else
+			{
+				// Otherwise, if extension isn't required (but is in the file) then print a warning to the user
+				LOGW("glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+			}
+		}
+		else
+		{
+			// Extension is supported, so enable it
+			LOGI("glTF file contains extension: {}", used_extension);
+			it->second = true;
+		}
+	}
+
+	// Load lights
+	std::vector<std::unique_ptr<sg::Light>> light_components = parse_khr_lights_punctual();
+
+	if (snapshot)
+	{
+		for (auto &light : light_components)
+		{
+			snapshot->lights.push_back({light->get_name(), light->get_light_type(), light->get_properties()});
+		}
+	}
+
+	scene.set_components(std::move(light_components));
+
+	// Load samplers
+	std::vector<std::unique_ptr<sg::Sampler>>
+	    sampler_components(model.samplers.size());
+
+	for (size_t sampler_index = 0; sampler_index < model.samplers.size(); sampler_index++)
+	{
+		auto &gltf_sampler                = model.samplers.at(sampler_index);
+		auto  sampler                     = parse_sampler(gltf_sampler);
+		sampler_components[sampler_index] = std::move(sampler);
+
+		if (snapshot)
+		{
+			snapshot->samplers.push_back({gltf_sampler.name, gltf_sampler.minFilter, gltf_sampler.magFilter,
+			                              gltf_sampler.wrapS, gltf_sampler.wrapT, gltf_sampler.wrapR});
+		}
+	}
+
+	scene.set_components(std::move(sampler_components));
+
+	Timer timer;
+	timer.start();
+
+	auto thread_count = std::thread::hardware_concurrency();
+	thread_count      = thread_count == 0 ? 1 : thread_count;
+	auto thread_pool  = std::make_unique<ctpl::thread_pool>(thread_count);
+
+	GeometryProcessing processing;
+	processing.lod_levels            = lod_levels;
+	processing.optimize_vertex_order = optimize_vertex_order;
+	processing.quantize_attributes   = quantize_attributes;
+	processing.generate_meshlets     = generate_meshlets;
+
+	// Extract the geometry of the primitives, queued first so that streamed scenes show their meshes early
+	std::vector<std::vector<std::future<PrimitiveData>>> primitive_futures(model.meshes.size());
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); mesh_index++)
+	{
+		for (size_t primitive_index = 0; primitive_index < model.meshes[mesh_index].primitives.size(); primitive_index++)
+		{
+			auto fut = thread_pool->push(
+			    [this, mesh_index, primitive_index, processing](size_t) {
+				    auto &gltf_mesh = model.meshes[mesh_index];
+
+				    return parse_primitive(model, gltf_mesh.primitives[primitive_index], fmt::format("{} #{}", gltf_mesh.name, primitive_index), processing);
+			    });
+
+			primitive_futures[mesh_index].push_back(std::move(fut));
+		}
+	}
+
+	// Load images
+	auto image_count = to_u32(model.images.size());
+
+	if (snapshot)
+	{
+		// Each image task fills its own record
+		snapshot->images.resize(image_count);
+	}
+
+	// Images are decoded from those used by the most primitives, which are the most likely to be visible
+	std::vector<int32_t> image_priorities(image_count, 0);
+	for (auto &gltf_mesh : model.meshes)
+	{
+		for (auto &gltf_primitive : gltf_mesh.primitives)
+		{
+			if (gltf_primitive.material < 0)
+			{
+				continue;
+			}
+
+			auto &gltf_material = model.materials.at(gltf_primitive.material);
+			for (auto *values : {&gltf_material.values, &gltf_material.additionalValues})
+			{
+				for (auto &gltf_value : *values)
+				{
+					if (gltf_value.first.find("Texture") == std::string::npos || gltf_value.second.TextureIndex() < 0)
+					{
+						continue;
+					}
+
+					auto source = get_texture_source(model.textures.at(gltf_value.second.TextureIndex()));
+					if (source >= 0 && static_cast<uint32_t>(source) < image_count)
+					{
+						++image_priorities[source];
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<size_t> image_order(image_count);
+	std::iota(image_order.begin(), image_order.end(), 0);
+	std::stable_sort(image_order.begin(), image_order.end(), [&image_priorities](size_t a, size_t b) {
+		return image_priorities[a] > image_priorities[b];
+	});
+
+	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures(image_count);
+	for (auto image_index : image_order)
+	{
+		// Streamed image files are read ahead of their decode, while the geometry is extracted
+		std::shared_ptr<fs::AsyncIO::Request> request;
+		if (streaming && is_file_uri(model.images[image_index].uri))
+		{
+			request = streaming->async_io->read_asset(model_path + "/" + model.images[image_index].uri, image_priorities[image_index]);
+		}
+
+		auto fut = thread_pool->push(
+		    [this, image_index, request](size_t) {
+			    std::unique_ptr<sg::Image> image;
+
+			    if (request)
+			    {
+				    if (request->wait() != fs::AsyncIO::Status::Complete)
+				    {
+					    throw std::runtime_error{"Failed to read gltf image #" + std::to_string(image_index) + ": " + request->get_path()};
+				    }
+
+				    image = parse_image(model.images.at(image_index), &request->get_data());
+			    }
+			    else
+			    {
+				    image = parse_image(model.images.at(image_index));
+			    }
+
+			    // Recorded before sharing the Vulkan image of an identical image drops its data
+			    if (snapshot)
+			    {
+				    snapshot->images[image_index] = record_image(*image);
+			    }
+
+			    prepare_image(*image);
+
+			    LOGI("Loaded gltf image #{} ({})", image_index, model.images.at(image_index).uri.c_str());
+
+			    return image;
+		    });
+
+		image_component_futures[image_index] = std::move(fut);
+	}
+
+	std::vector<std::unique_ptr<sg::Image>> image_components;
+
+	if (streaming)
+	{
+		// Textures show placeholders until update_streaming() swaps in their images
+		image_components.push_back(create_placeholder_image(device, "placeholder_white", {255, 255, 255, 255}));
+		image_components.push_back(create_placeholder_image(device, "placeholder_normal", {128, 128, 255, 255}));
+
+		for (auto &image : image_components)
+		{
+			upload_image_to_gpu(streaming->upload_manager, *image, nullptr, nullptr);
+		}
+
+		streaming->upload_manager.flush();
+
+		streaming->image_futures       = std::move(image_component_futures);
+		streaming->pending_image_count = image_count;
+		streaming->image_textures.resize(image_count);
+	}
+	else
+	{
+		// Upload images to GPU as soon as they are loaded, so that the copies overlap the remaining decodes
+		UploadManager upload_manager{device};
+
+		for (auto &fut : image_component_futures)
+		{
+			image_components.push_back(fut.get());
+
+			upload_image_to_gpu(upload_manager, *image_components.back(), texture_streamer, &device.get_asset_cache());
+		}
+
+		upload_manager.wait();
+
+		LOGI("Uploaded {} MB of images at {} MB/s{}",
+		     vkb::to_string(upload_manager.get_uploaded_bytes() / (1024.0 * 1024.0)),
+		     vkb::to_string(upload_manager.get_throughput()),
+		     upload_manager.uses_dedicated_transfer_queue() ? " on a dedicated transfer queue" : "");
+
+		LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(timer.elapsed()), thread_count);
+	}
+
+	scene.set_components(std::move(image_components));
+
+	// Load textures
+	auto images          = scene.get_components<sg::Image>();
+	auto samplers        = scene.get_components<sg::Sampler>();
+	auto default_sampler = create_default_sampler();
+
+	for (auto &gltf_texture : model.textures)
+	{
+		auto texture = parse_texture(gltf_texture);
+
+		auto source = get_texture_source(gltf_texture);
+
+		if (streaming)
+		{
+			texture->set_image(*images.at(0));
+
+			streaming->image_textures.at(source).push_back(texture.get());
+		}
+		else
+		{
+			texture->set_image(*images.at(source));
+		}
+
+		bool has_sampler = gltf_texture.sampler >= 0 && gltf_texture.sampler < static_cast<int>(samplers.size());
+
+		if (has_sampler)
+		{
+			texture->set_sampler(*samplers.at(gltf_texture.sampler));
+		}
+		else
+		{
+			if (gltf_texture.name.empty())
+			{
+				gltf_texture.name = model.images.at(source).name;
+			}
+
+			texture->set_sampler(*default_sampler);
+		}
+
+		if (snapshot)
+		{
+			snapshot->textures.push_back({texture->get_name(), to_u32(source), has_sampler ? gltf_texture.sampler : -1});
+		}
+
+		scene.add_component(std::move(texture));
+	}
+
+	scene.add_component(std::move(default_sampler));
+
+	// Load materials
+	bool                            has_textures = scene.has_component<sg::Texture>();
+	std::vector<vkb::sg::Texture *> textures;
+	if (has_textures)
+	{
+		textures = scene.get_components<sg::Texture>();
+	}
+
+	for (auto &gltf_material : model.materials)
+	{
+		auto material = parse_material(gltf_material);
+
+		for (auto &gltf_value : gltf_material.values)
+		{
+			if (gltf_value.first.find("Texture") != std::string::npos)
+			{
+				std::string tex_name = to_snake_case(gltf_value.first);
+
+				material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
+			}
+		}
+
+		for (auto &gltf_value : gltf_material.additionalValues)
+		{
+			if (gltf_value.first.find("Texture") != std::string::npos)
+			{
+				std::string tex_name = to_snake_case(gltf_value.first);
+
+				material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
+			}
+		}
+
+		if (streaming)
+		{
+			// Normal maps show a flat normal until they are loaded
+			auto normal_texture_it = material->textures.find("normal_texture");
+
+			if (normal_texture_it != material->textures.end())
+			{
+				normal_texture_it->second->set_image(*images.at(1));
+			}
+		}
+
+		if (snapshot)
+		{
+			SceneSnapshot::MaterialRecord record;
+			record.name              = material->get_name();
+			record.base_color_factor = material->base_color_factor;
+			record.metallic_factor   = material->metallic_factor;
+			record.roughness_factor  = material->roughness_factor;
+			record.emissive          = material->emissive;
+			record.double_sided      = material->double_sided;
+			record.alpha_cutoff      = material->alpha_cutoff;
+			record.alpha_mode        = material->alpha_mode;
+
+			for (auto &texture : material->textures)
+			{
+				auto texture_index = std::find(textures.begin(), textures.end(), texture.second) - textures.begin();
+				record.textures.emplace_back(texture.first, to_u32(texture_index));
+			}
+
+			snapshot->materials.push_back(std::move(record));
+		}
+
+		scene.add_component(std::move(material));
+	}
+
+	auto default_material = create_default_material();
+
+	// Load meshes
+	auto materials = scene.get_components<sg::PBRMaterial>();
+
+	// The vertex and index data of all the submeshes is packed into a few large arenas,
+	// each submesh records the arena it lives in and its offsets
+	std::vector<std::vector<uint8_t>>             vertex_arenas;
+	std::vector<std::vector<uint8_t>>             index_arenas;
+	std::vector<std::pair<sg::SubMesh *, size_t>> submesh_vertex_arenas;
+	std::vector<std::pair<sg::SubMesh *, size_t>> submesh_index_arenas;
+
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); mesh_index++)
+	{
+		auto &gltf_mesh = model.meshes[mesh_index];
+
+		auto mesh = parse_mesh(gltf_mesh);
+
+		if (!gltf_mesh.weights.empty())
+		{
+			std::vector<float> weights(gltf_mesh.weights.begin(), gltf_mesh.weights.end());
+			mesh->set_morph_weights(weights.data(), weights.size());
+		}
+
+		for (size_t primitive_index = 0; primitive_index < gltf_mesh.primitives.size(); primitive_index++)
+		{
+			auto &gltf_primitive = gltf_mesh.primitives[primitive_index];
+
+			auto submesh = std::make_unique<sg::SubMesh>();
+
+			parse_primitive_layout(model, gltf_primitive, processing, *submesh);
+
+			// The position accessor holds the bounds of the primitive
+			auto position_it = gltf_primitive.attributes.find("POSITION");
+			if (position_it != gltf_primitive.attributes.end())
+			{
+				auto &accessor = model.accessors.at(position_it->second);
+
+				if (accessor.minValues.size() >= 3 && accessor.maxValues.size() >= 3)
+				{
+					mesh->update_bounds(sg::AABB{glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]),
+					                             glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2])});
+				}
+				else
+				{
+					// Without the accessor bounds, the positions are reduced from the buffer
+					sg::AABB position_bounds;
+					if (compute_position_bounds(model, accessor, job_system, position_bounds))
+					{
+						mesh->update_bounds(position_bounds);
+					}
+				}
+			}
+
+			if (gltf_primitive.material < 0)
+			{
+				submesh->set_material(*default_material);
+			}
+			else
+			{
+				submesh->set_material(*materials.at(gltf_primitive.material));
+			}
+
+			mesh->add_submesh(*submesh);
+
+			if (streaming)
+			{
+				// The submesh is drawn once update_streaming() packed its geometry into an arena
+				streaming->primitive_futures.push_back(std::move(primitive_futures[mesh_index][primitive_index]));
+				streaming->primitive_submeshes.push_back(submesh.get());
+
+				scene.add_component(std::move(submesh));
+
+				continue;
+			}
+
+			// Primitives are packed in order, so that the arenas do not depend on the thread scheduling
+			auto primitive = primitive_futures[mesh_index][primitive_index].get();
+
+			// All the attributes of a submesh live in the same arena
+			auto vertex_arena_index = reserve_arena_range(vertex_arenas, primitive.attribute_data_size);
+
+			for (auto &attribute : primitive.attribute_data)
+			{
+				submesh->vertex_arena_offsets[attribute.first] = append_to_arena(vertex_arenas[vertex_arena_index], attribute.second);
+			}
+
+			submesh_vertex_arenas.emplace_back(submesh.get(), vertex_arena_index);
+
+			create_morph_target_buffer(device, *submesh, primitive);
+
+			int32_t index_arena_index{-1};
+
+			if (gltf_primitive.indices >= 0)
+			{
+				index_arena_index = static_cast<int32_t>(reserve_arena_range(index_arenas, primitive.index_data.size()));
+				auto index_offset = append_to_arena(index_arenas[index_arena_index], primitive.index_data);
+
+				// The index arena is bound at offset zero, ranges are aligned to any index size
+				auto index_size      = submesh->index_type == VK_INDEX_TYPE_UINT32 ? 4 : 2;
+				submesh->first_index = to_u32(index_offset / index_size);
+
+				set_submesh_lods(*submesh, primitive);
+
+				create_meshlet_buffer(device, *submesh, primitive.meshlets);
+
+				submesh_index_arenas.emplace_back(submesh.get(), index_arena_index);
+			}
+
+			if (snapshot)
+			{
+				SceneSnapshot::SubMeshRecord record;
+				record.material       = gltf_primitive.material;
+				record.vertex_arena   = to_u32(vertex_arena_index);
+				record.index_arena    = index_arena_index;
+				record.index_type     = submesh->index_type;
+				record.vertices_count = submesh->vertices_count;
+				record.vertex_indices = submesh->vertex_indices;
+				record.first_index    = submesh->first_index;
+				record.lods           = submesh->lods;
+				record.meshlets       = std::move(primitive.meshlets);
+
+				for (auto &gltf_attribute : gltf_primitive.attributes)
+				{
+					std::string attrib_name = gltf_attribute.first;
+					std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+
+					sg::VertexAttribute attribute;
+					if (submesh->get_attribute(attrib_name, attribute))
+					{
+						record.attributes.emplace_back(attrib_name, attribute);
+					}
+				}
+
+				record.vertex_arena_offsets.assign(submesh->vertex_arena_offsets.begin(), submesh->vertex_arena_offsets.end());
+
+				snapshot->submeshes.push_back(std::move(record));
+			}
+
+			scene.add_component(std::move(submesh));
+		}
+
+		if (snapshot)
+		{
+			snapshot->meshes.push_back({mesh->get_name(), mesh->get_bounds().get_min(), mesh->get_bounds().get_max(), to_u32(gltf_mesh.primitives.size())});
+		}
+
+		scene.add_component(std::move(mesh));
+	}
+
+	// Fill the arena buffers in parallel, each one is a copy of up to GEOMETRY_ARENA_SIZE bytes
+	auto create_arena_buffers = [this, &thread_pool](const std::vector<std::vector<uint8_t>> &arenas, VkBufferUsageFlags usage) {
+		std::vector<std::future<core::Buffer>> buffer_futures;
+
+		for (auto &arena_data : arenas)
+		{
+			auto fut = thread_pool->push(
+			    [this, &arena_data, usage](size_t) {
+				    core::Buffer buffer{device,
+				                        std::max<VkDeviceSize>(arena_data.size(), 1),
+				                        usage,
+				                        VMA_MEMORY_USAGE_GPU_TO_CPU};
+				    buffer.update(arena_data);
+
+				    return buffer;
+			    });
+
+			buffer_futures.push_back(std::move(fut));
+		}
+
+		return buffer_futures;
+	};
+
+	auto vertex_buffer_futures = create_arena_buffers(vertex_arenas, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | get_geometry_buffer_usage(device));
+	auto index_buffer_futures  = create_arena_buffers(index_arenas, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | get_geometry_buffer_usage(device));
+
+	std::vector<sg::GeometryArena *> vertex_arena_components;
+	for (auto &fut : vertex_buffer_futures)
+	{
+		auto arena = std::make_unique<sg::GeometryArena>("vertex_arena_" + std::to_string(vertex_arena_components.size()), fut.get());
+		vertex_arena_components.push_back(arena.get());
+		scene.add_component(std::move(arena));
+	}
+
+	std::vector<sg::GeometryArena *> index_arena_components;
+	for (auto &fut : index_buffer_futures)
+	{
+		auto arena = std::make_unique<sg::GeometryArena>("index_arena_" + std::to_string(index_arena_components.size()), fut.get());
+		index_arena_components.push_back(arena.get());
+		scene.add_component(std::move(arena));
+	}
+
+	for (auto &submesh_arena : submesh_vertex_arenas)
+	{
+		submesh_arena.first->vertex_arena = vertex_arena_components.at(submesh_arena.second);
+	}
+
+	for (auto &submesh_arena : submesh_index_arenas)
+	{
+		submesh_arena.first->index_arena = index_arena_components.at(submesh_arena.second);
+	}
+
+	if (streaming)
+	{
+		LOGI("Loaded the scene structure in {} seconds, streaming {} images and {} primitives.",
+		     vkb::to_string(timer.stop()), image_count, streaming->primitive_futures.size());
+
+		streaming->thread_pool = std::move(thread_pool);
+	}
+	else
+	{
+		LOGI("Packed geometry into {} vertex and {} index arenas", vertex_arenas.size(), index_arenas.size());
+
+		LOGI("Time spent loading images and geometry: {} seconds.", vkb::to_string(timer.stop()));
+
+		if (snapshot)
+		{
+			snapshot->vertex_arenas = std::move(vertex_arenas);
+			snapshot->index_arenas  = std::move(index_arenas);
+		}
+	}
+
+	scene.add_component(std::move(default_material));
+
+	// Load cameras
+	for (auto &gltf_camera : model.cameras)
+	{
+		auto camera = parse_camera(gltf_camera);
+		scene.add_component(std::move(camera));
+
+		if (snapshot)
+		{
+			snapshot->cameras.push_back({gltf_camera.name, gltf_camera.type,
+			                             static_cast<float>(gltf_camera.perspective.aspectRatio),
+			                             static_cast<float>(gltf_camera.perspective.yfov),
+			                             static_cast<float>(gltf_camera.perspective.znear),
+			                             static_cast<float>(gltf_camera.perspective.zfar)});
+		}
+	}
+
+	// Load nodes
+	auto meshes = scene.get_components<sg::Mesh>();
+
+	std::vector<std::unique_ptr<sg::Node>> nodes;
+
+	for (size_t node_index = 0; node_index < model.nodes.size(); ++node_index)
+	{
+		auto gltf_node = model.nodes[node_index];
+		auto node      = parse_node(gltf_node, node_index);
+
+		if (gltf_node.mesh >= 0)
+		{
+			auto mesh = meshes.at(gltf_node.mesh);
+
+			node->set_component(*mesh);
+
+			mesh->add_node(*node);
+
+			// The weights of the node override those of its mesh
+			if (!gltf_node.weights.empty())
+			{
+				std::vector<float> weights(gltf_node.weights.begin(), gltf_node.weights.end());
+				mesh->set_morph_weights(weights.data(), weights.size());
+			}
+		}
+
+		if (gltf_node.camera >= 0)
+		{
+			auto cameras = scene.get_components<sg::Camera>();
+			auto camera  = cameras.at(gltf_node.camera);
+
+			node->set_component(*camera);
+
+			camera->set_node(*node);
+		}
+
+		int32_t light_index{-1};
+
+		if (auto extension = get_extension(gltf_node.extensions, KHR_LIGHTS_PUNCTUAL_EXTENSION))
+		{
+			auto lights = scene.get_components<sg::Light>();
+			light_index = extension->Get("light").Get<int>();
+			auto light  = lights.at(static_cast<size_t>(light_index));
+
+			node->set_component(*light);
+
+			light->set_node(*node);
+		}
+
+		if (snapshot)
+		{
+			auto &transform = node->get_transform();
+			snapshot->nodes.push_back({gltf_node.name, transform.get_translation(), transform.get_rotation(), transform.get_scale(),
+			                           gltf_node.mesh, gltf_node.camera, light_index});
+		}
+
+		nodes.push_back(std::move(node));
+	}
+
+	// Load skins
+	for (auto &gltf_skin : model.skins)
+	{
+		auto skin = std::make_unique<sg::Skin>(gltf_skin.name);
+
+		std::vector<sg::Node *> joints;
+		for (auto joint : gltf_skin.joints)
+		{
+			joints.push_back(nodes.at(joint).get());
+		}
+
+		std::vector<glm::mat4> inverse_bind_matrices;
+		if (gltf_skin.inverseBindMatrices >= 0)
+		{
+			auto values = read_accessor_floats(model, gltf_skin.inverseBindMatrices);
+
+			inverse_bind_matrices.resize(values.size() / 16);
+			std::memcpy(inverse_bind_matrices.data(), values.data(), inverse_bind_matrices.size() * sizeof(glm::mat4));
+		}
+
+		skin->set_joints(joints, inverse_bind_matrices);
+
+		scene.add_component(std::move(skin));
+	}
+
+	auto skins = scene.get_components<sg::Skin>();
+
+	for (size_t node_index = 0; node_index < model.nodes.size(); ++node_index)
+	{
+		auto skin_index = model.nodes[node_index].skin;
+
+		if (skin_index >= 0 && model.nodes[node_index].mesh >= 0)
+		{
+			nodes[node_index]->set_component(*skins.at(skin_index));
+		}
+	}
+
+	// Load animations
+	for (auto &gltf_animation : model.animations)
+	{
+		auto animation = std::make_unique<sg::Animation>(gltf_animation.name);
+
+		for (auto &gltf_channel : gltf_animation.channels)
+		{
+			if (gltf_channel.target_node < 0 || gltf_channel.sampler < 0)
+			{
+				continue;
+			}
+
+			static const std::map<std::string, sg::AnimationTarget> targets = {{"translation", sg::AnimationTarget::Translation},
+			                                                                   {"rotation", sg::AnimationTarget::Rotation},
+			                                                                   {"scale", sg::AnimationTarget::Scale},
+			                                                                   {"weights", sg::AnimationTarget::Weights}};
+
+			auto target = targets.find(gltf_channel.target_path);
+			if (target == targets.end())
+			{
+				LOGW("Unsupported animation target of {}: {}", gltf_animation.name, gltf_channel.target_path);
+				continue;
+			}
+
+			auto &gltf_sampler = gltf_animation.samplers.at(gltf_channel.sampler);
+
+			auto interpolation = sg::AnimationInterpolation::Linear;
+			if (gltf_sampler.interpolation == "STEP")
+			{
+				interpolation = sg::AnimationInterpolation::Step;
+			}
+			else if (gltf_sampler.interpolation == "CUBICSPLINE")
+			{
+				interpolation = sg::AnimationInterpolation::CubicSpline;
+			}
+
+			animation->add_track(*nodes.at(gltf_channel.target_node), target->second, interpolation,
+			                     read_accessor_floats(model, gltf_sampler.input), read_accessor_floats(model, gltf_sampler.output));
+		}
+
+		LOGI("Loaded animation {} with {} tracks over {} seconds", gltf_animation.name, animation->get_track_count(), vkb::to_string(animation->get_duration()));
+
+		scene.add_component(std::move(animation));
+	}
+
+	// Load scenes
+	std::queue<std::pair<sg::Node &, int>> traverse_nodes;
+
+	tinygltf::Scene *gltf_scene{nullptr};
+
+	if (scene_index >= 0 && scene_index < static_cast<int>(model.scenes.size()))
+	{
+		gltf_scene = &model.scenes[scene_index];
+	}
+	else if (model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size()))
+	{
+		gltf_scene = &model.scenes[model.defaultScene];
+	}
+	else if (model.scenes.size() > 0)
+	{
+		gltf_scene = &model.scenes[0];
+	}
+
+	if (!gltf_scene)
+	{
+		throw std::runtime_error("Couldn't determine which scene to load!");
+	}
+
+	auto root_node = std::make_unique<sg::Node>(0, gltf_scene->name);
+
+	if (snapshot)
+	{
+		snapshot->root_name = gltf_scene->name;
+	}
+
+	for (auto node_index : gltf_scene->nodes)
+	{
+		traverse_nodes.push(std::make_pair(std::ref(*root_node), node_index));
+	}
+
+	while (!traverse_nodes.empty())
+	{
+		auto node_it = traverse_nodes.front();
+		traverse_nodes.pop();
+
+		auto &current_node       = *nodes.at(node_it.second);
+		auto &traverse_root_node = node_it.first;
+
+		current_node.set_parent(traverse_root_node);
+		traverse_root_node.add_child(current_node);
 
-	for (size_t sampler_index = 0; sampler_index < model.samplers.size(); sampler_index++)
-	{
-		auto sampler                      = parse_sampler(model.samplers.at(sampler_index));
-		sampler_components[sampler_index] = std::move(sampler);
-	}
+		if (snapshot)
+		{
+			// The parents other than the root are glTF nodes, whose id is their index
+			int32_t parent_index = &traverse_root_node == root_node.get() ? -1 : static_cast<int32_t>(traverse_root_node.get_id());
+			snapshot->links.push_back({parent_index, to_u32(node_it.second)});
+		}
 
-	scene.set_components(std::move(sampler_components));
+		for (auto child_node_index : model.nodes[node_it.second].children)
+		{
+			traverse_nodes.push(std::make_pair(std::ref(traverse_root_node), child_node_index));
+		}
+	}
 
-	Timer timer;
-	timer.start();
+	scene.set_root_node(*root_node);
+	nodes.push_back(std::move(root_node));
 
-	// Load images
-	auto thread_count = std::thread::hardware_concurrency();
-	thread_count      = thread_count == 0 ? 1 : thread_count;
-	ctpl::thread_pool thread_pool(thread_count);
+	// Store nodes into the scene
+	scene.set_nodes(std::move(nodes));
 
-	auto image_count = to_u32(model.images.size());
+	add_default_components(scene);
 
-	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
-	for (size_t image_index = 0; image_index < image_count; image_index++)
-	{
-		auto fut = thread_pool.push(
-		    [this, image_index](size_t) {
-			    auto image = parse_image(model.images.at(image_index));
+	return scene;
+}
 
-			    LOGI("Loaded gltf image #{} ({})", image_index, model.images.at(image_index).uri.c_str());
+void GLTFLoader::add_default_components(sg::Scene &scene)
+{
+	// Create node for the default camera
+	auto camera_node = std::make_unique<sg::Node>(-1, "default_camera");
 
-			    return image;
-		    });
+	auto default_camera = create_default_camera();
+	default_camera->set_node(*camera_node);
+	camera_node->set_component(*default_camera);
+	scene.add_component(std::move(default_camera));
 
-		image_component_futures.push_back(std::move(fut));
-	}
+	scene.get_root_node().add_child(*camera_node);
+	scene.add_node(std::move(camera_node));
 
-	std::vector<std::unique_ptr<sg::Image>> image_components;
-	for (auto &fut : image_component_futures)
+	if (!scene.has_component<vkb::sg::Light>())
 	{
-		image_components.push_back(fut.get());
+		// Add a default light if none are present
+		vkb::add_directional_light(scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
 	}
+}
 
-	// Upload images to GPU
-	std::vector<core::Buffer> transient_buffers;
+sg::Scene GLTFLoader::load_scene_snapshot(SceneSnapshot &snapshot)
+{
+	VKB_PROFILE_ZONE("GLTFLoader::load_scene_snapshot");
+
+	auto scene = sg::Scene();
 
-	auto &command_buffer = device.request_command_buffer();
+	scene.set_name("gltf_scene");
 
-	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+	// Load lights
+	std::vector<std::unique_ptr<sg::Light>> light_components;
 
-	for (size_t image_index = 0; image_index < image_count; image_index++)
+	for (auto &record : snapshot.lights)
 	{
-		auto &image = image_components.at(image_index);
+		auto light = std::make_unique<sg::Light>(record.name);
+		light->set_light_type(record.type);
+		light->set_properties(record.properties);
 
-		core::Buffer stage_buffer{device,
-		                          image->get_data().size(),
-		                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		                          VMA_MEMORY_USAGE_CPU_ONLY};
+		light_components.push_back(std::move(light));
+	}
 
-		stage_buffer.update(image->get_data());
+	scene.set_components(std::move(light_components));
 
-		upload_image_to_gpu(command_buffer, stage_buffer, *image);
+	// Load samplers, from the glTF description so that they are created as in load_scene()
+	std::vector<std::unique_ptr<sg::Sampler>> sampler_components;
 
-		transient_buffers.push_back(std::move(stage_buffer));
+	for (auto &record : snapshot.samplers)
+	{
+		tinygltf::Sampler gltf_sampler;
+		gltf_sampler.name      = record.name;
+		gltf_sampler.minFilter = record.min_filter;
+		gltf_sampler.magFilter = record.mag_filter;
+		gltf_sampler.wrapS     = record.wrap_s;
+		gltf_sampler.wrapT     = record.wrap_t;
+		gltf_sampler.wrapR     = record.wrap_r;
+
+		sampler_components.push_back(parse_sampler(gltf_sampler));
 	}
 
-	command_buffer.end();
+	scene.set_components(std::move(sampler_components));
 
-	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	// Load images, which are already decoded and transcoded
+	std::vector<std::unique_ptr<sg::Image>> image_components;
 
-	queue.submit(command_buffer, device.request_fence());
+	{
+		UploadManager upload_manager{device};
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
-	device.wait_idle();
+		for (auto &record : snapshot.images)
+		{
+			auto image = std::make_unique<SnapshotImage>(std::move(record));
 
-	transient_buffers.clear();
+			prepare_image(*image);
 
-	scene.set_components(std::move(image_components));
+			upload_image_to_gpu(upload_manager, *image, texture_streamer, &device.get_asset_cache());
 
-	auto elapsed_time = timer.stop();
+			image_components.push_back(std::move(image));
+		}
+
+		upload_manager.wait();
+	}
 
-	LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time), thread_count);
+	scene.set_components(std::move(image_components));
 
 	// Load textures
 	auto images          = scene.get_components<sg::Image>();
 	auto samplers        = scene.get_components<sg::Sampler>();
 	auto default_sampler = create_default_sampler();
 
-	for (auto &gltf_texture : model.textures)
+	for (auto &record : snapshot.textures)
 	{
-		auto texture = parse_texture(gltf_texture);
+		tinygltf::Texture gltf_texture;
+		gltf_texture.name = record.name;
 
-		texture->set_image(*images.at(gltf_texture.source));
-
-		if (gltf_texture.sampler >= 0 && gltf_texture.sampler < static_cast<int>(samplers.size()))
-		{
-			texture->set_sampler(*samplers.at(gltf_texture.sampler));
-		}
-		else
-		{
-			if (gltf_texture.name.empty())
-			{
-				gltf_texture.name = images.at(gltf_texture.source)->get_name();
-			}
+		auto texture = parse_texture(gltf_texture);
 
-			texture->set_sampler(*default_sampler);
-		}
+		texture->set_image(*images.at(record.image));
+		texture->set_sampler(record.sampler >= 0 ? *samplers.at(record.sampler) : *default_sampler);
 
 		scene.add_component(std::move(texture));
 	}
@@ -573,35 +2427,27 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	scene.add_component(std::move(default_sampler));
 
 	// Load materials
-	bool                            has_textures = scene.has_component<sg::Texture>();
-	std::vector<vkb::sg::Texture *> textures;
-	if (has_textures)
+	std::vector<sg::Texture *> textures;
+	if (scene.has_component<sg::Texture>())
 	{
 		textures = scene.get_components<sg::Texture>();
 	}
 
-	for (auto &gltf_material : model.materials)
+	for (auto &record : snapshot.materials)
 	{
-		auto material = parse_material(gltf_material);
-
-		for (auto &gltf_value : gltf_material.values)
-		{
-			if (gltf_value.first.find("Texture") != std::string::npos)
-			{
-				std::string tex_name = to_snake_case(gltf_value.first);
+		auto material = std::make_unique<sg::PBRMaterial>(record.name);
 
-				material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
-			}
-		}
+		material->base_color_factor = record.base_color_factor;
+		material->metallic_factor   = record.metallic_factor;
+		material->roughness_factor  = record.roughness_factor;
+		material->emissive          = record.emissive;
+		material->double_sided      = record.double_sided;
+		material->alpha_cutoff      = record.alpha_cutoff;
+		material->alpha_mode        = record.alpha_mode;
 
-		for (auto &gltf_value : gltf_material.additionalValues)
+		for (auto &texture : record.textures)
 		{
-			if (gltf_value.first.find("Texture") != std::string::npos)
-			{
-				std::string tex_name = to_snake_case(gltf_value.first);
-
-				material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
-			}
+			material->textures[texture.first] = textures.at(texture.second);
 		}
 
 		scene.add_component(std::move(material));
@@ -609,92 +2455,76 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 
 	auto default_material = create_default_material();
 
-	// Load meshes
 	auto materials = scene.get_components<sg::PBRMaterial>();
 
-	for (auto &gltf_mesh : model.meshes)
-	{
-		auto mesh = parse_mesh(gltf_mesh);
+	// Load the arenas
+	auto create_arenas = [this, &scene](const std::vector<std::vector<uint8_t>> &arenas, VkBufferUsageFlags usage, const std::string &name) {
+		std::vector<sg::GeometryArena *> arena_components;
 
-		for (auto &gltf_primitive : gltf_mesh.primitives)
+		for (auto &arena_data : arenas)
 		{
-			auto submesh = std::make_unique<sg::SubMesh>();
-
-			for (auto &attribute : gltf_primitive.attributes)
-			{
-				std::string attrib_name = attribute.first;
-				std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+			core::Buffer buffer{device,
+			                    std::max<VkDeviceSize>(arena_data.size(), 1),
+			                    usage,
+			                    VMA_MEMORY_USAGE_GPU_TO_CPU};
+			buffer.update(arena_data);
+
+			auto arena = std::make_unique<sg::GeometryArena>(name + std::to_string(arena_components.size()), std::move(buffer));
+			arena_components.push_back(arena.get());
+			scene.add_component(std::move(arena));
+		}
 
-				auto vertex_data = get_attribute_data(&model, attribute.second);
+		return arena_components;
+	};
 
-				if (attrib_name == "position")
-				{
-					submesh->vertices_count = to_u32(model.accessors.at(attribute.second).count);
-				}
+	auto vertex_arenas = create_arenas(snapshot.vertex_arenas, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | get_geometry_buffer_usage(device), "vertex_arena_");
+	auto index_arenas  = create_arenas(snapshot.index_arenas, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | get_geometry_buffer_usage(device), "index_arena_");
 
-				core::Buffer buffer{device,
-				                    vertex_data.size(),
-				                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				                    VMA_MEMORY_USAGE_GPU_TO_CPU};
-				buffer.update(vertex_data);
+	// Load meshes
+	size_t submesh_index{0};
 
-				submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+	for (auto &mesh_record : snapshot.meshes)
+	{
+		tinygltf::Mesh gltf_mesh;
+		gltf_mesh.name = mesh_record.name;
 
-				sg::VertexAttribute attrib;
-				attrib.format = get_attribute_format(&model, attribute.second);
-				attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+		auto mesh = parse_mesh(gltf_mesh);
 
-				submesh->set_attribute(attrib_name, attrib);
-			}
+		// Meshes without positions have empty bounds
+		if (glm::all(glm::lessThanEqual(mesh_record.bounds_min, mesh_record.bounds_max)))
+		{
+			mesh->update_bounds(sg::AABB{mesh_record.bounds_min, mesh_record.bounds_max});
+		}
 
-			if (gltf_primitive.indices >= 0)
-			{
-				submesh->vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
+		for (uint32_t i = 0; i < mesh_record.submesh_count; ++i)
+		{
+			auto &record = snapshot.submeshes.at(submesh_index++);
 
-				auto format = get_attribute_format(&model, gltf_primitive.indices);
+			auto submesh = std::make_unique<sg::SubMesh>();
 
-				auto vertex_data = get_attribute_data(&model, gltf_primitive.indices);
-				auto index_data  = get_attribute_data(&model, gltf_primitive.indices);
+			for (auto &attribute : record.attributes)
+			{
+				submesh->set_attribute(attribute.first, attribute.second);
+			}
 
-				switch (format)
-				{
-					case VK_FORMAT_R8_UINT:
-						// Converts uint8 data into uint16 data, still represented by a uint8 vector
-						index_data          = convert_underlying_data_stride(index_data, 1, 2);
-						submesh->index_type = VK_INDEX_TYPE_UINT16;
-						break;
-					case VK_FORMAT_R16_UINT:
-						submesh->index_type = VK_INDEX_TYPE_UINT16;
-						break;
-					case VK_FORMAT_R32_UINT:
-						submesh->index_type = VK_INDEX_TYPE_UINT32;
-						break;
-					default:
-						LOGE("gltf primitive has invalid format type");
-						break;
-				}
+			submesh->index_type     = record.index_type;
+			submesh->vertices_count = record.vertices_count;
+			submesh->vertex_indices = record.vertex_indices;
+			submesh->first_index    = record.first_index;
+			submesh->lods           = record.lods;
+			submesh->vertex_arena   = vertex_arenas.at(record.vertex_arena);
 
-				submesh->index_buffer = std::make_unique<core::Buffer>(device,
-				                                                       index_data.size(),
-				                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-				                                                       VMA_MEMORY_USAGE_GPU_TO_CPU);
+			submesh->vertex_arena_offsets.insert(record.vertex_arena_offsets.begin(), record.vertex_arena_offsets.end());
 
-				submesh->index_buffer->update(index_data);
-			}
-			else
+			if (record.index_arena >= 0)
 			{
-				submesh->vertices_count = to_u32(get_attribute_size(&model, gltf_primitive.attributes.at("POSITION")));
-			}
+				submesh->index_arena = index_arenas.at(record.index_arena);
 
-			if (gltf_primitive.material < 0)
-			{
-				submesh->set_material(*default_material);
-			}
-			else
-			{
-				submesh->set_material(*materials.at(gltf_primitive.material));
+				create_meshlet_buffer(device, *submesh, record.meshlets);
 			}
 
+			submesh->set_material(record.material >= 0 ? *materials.at(record.material) : *default_material);
+
 			mesh->add_submesh(*submesh);
 
 			scene.add_component(std::move(submesh));
@@ -703,54 +2533,61 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		scene.add_component(std::move(mesh));
 	}
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
-
-	transient_buffers.clear();
-
 	scene.add_component(std::move(default_material));
 
 	// Load cameras
-	for (auto &gltf_camera : model.cameras)
+	for (auto &record : snapshot.cameras)
 	{
-		auto camera = parse_camera(gltf_camera);
-		scene.add_component(std::move(camera));
+		tinygltf::Camera gltf_camera;
+		gltf_camera.name                    = record.name;
+		gltf_camera.type                    = record.type;
+		gltf_camera.perspective.aspectRatio = record.aspect_ratio;
+		gltf_camera.perspective.yfov        = record.field_of_view;
+		gltf_camera.perspective.znear       = record.near_plane;
+		gltf_camera.perspective.zfar        = record.far_plane;
+
+		scene.add_component(parse_camera(gltf_camera));
 	}
 
 	// Load nodes
-	auto meshes = scene.get_components<sg::Mesh>();
+	auto meshes  = scene.get_components<sg::Mesh>();
+	auto cameras = scene.get_components<sg::Camera>();
+	auto lights  = scene.get_components<sg::Light>();
 
 	std::vector<std::unique_ptr<sg::Node>> nodes;
 
-	for (size_t node_index = 0; node_index < model.nodes.size(); ++node_index)
+	for (size_t node_index = 0; node_index < snapshot.nodes.size(); ++node_index)
 	{
-		auto gltf_node = model.nodes[node_index];
-		auto node      = parse_node(gltf_node, node_index);
+		auto &record = snapshot.nodes[node_index];
 
-		if (gltf_node.mesh >= 0)
+		auto node = std::make_unique<sg::Node>(node_index, record.name);
+
+		auto &transform = node->get_transform();
+		transform.set_translation(record.translation);
+		transform.set_rotation(record.rotation);
+		transform.set_scale(record.scale);
+
+		if (record.mesh >= 0)
 		{
-			auto mesh = meshes.at(gltf_node.mesh);
+			auto mesh = meshes.at(record.mesh);
 
 			node->set_component(*mesh);
 
 			mesh->add_node(*node);
 		}
 
-		if (gltf_node.camera >= 0)
+		if (record.camera >= 0)
 		{
-			auto cameras = scene.get_components<sg::Camera>();
-			auto camera  = cameras.at(gltf_node.camera);
+			auto camera = cameras.at(record.camera);
 
 			node->set_component(*camera);
 
 			camera->set_node(*node);
 		}
 
-		if (auto extension = get_extension(gltf_node.extensions, KHR_LIGHTS_PUNCTUAL_EXTENSION))
+		if (record.light >= 0)
 		{
-			auto lights = scene.get_components<sg::Light>();
-			auto light  = lights.at(static_cast<size_t>(extension->Get("light").Get<int>()));
+			auto light = lights.at(record.light);
 
 			node->set_component(*light);
 
@@ -760,51 +2597,16 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		nodes.push_back(std::move(node));
 	}
 
-	// Load scenes
-	std::queue<std::pair<sg::Node &, int>> traverse_nodes;
-
-	tinygltf::Scene *gltf_scene{nullptr};
-
-	if (scene_index >= 0 && scene_index < static_cast<int>(model.scenes.size()))
-	{
-		gltf_scene = &model.scenes[scene_index];
-	}
-	else if (model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size()))
-	{
-		gltf_scene = &model.scenes[model.defaultScene];
-	}
-	else if (model.scenes.size() > 0)
-	{
-		gltf_scene = &model.scenes[0];
-	}
-
-	if (!gltf_scene)
-	{
-		throw std::runtime_error("Couldn't determine which scene to load!");
-	}
-
-	auto root_node = std::make_unique<sg::Node>(0, gltf_scene->name);
-
-	for (auto node_index : gltf_scene->nodes)
-	{
-		traverse_nodes.push(std::make_pair(std::ref(*root_node), node_index));
-	}
+	// Load the hierarchy, in the order it was built
+	auto root_node = std::make_unique<sg::Node>(0, snapshot.root_name);
 
-	while (!traverse_nodes.empty())
+	for (auto &link : snapshot.links)
 	{
-		auto node_it = traverse_nodes.front();
-		traverse_nodes.pop();
-
-		auto &current_node       = *nodes.at(node_it.second);
-		auto &traverse_root_node = node_it.first;
+		auto &parent_node = link.parent < 0 ? *root_node : *nodes.at(link.parent);
+		auto &child_node  = *nodes.at(link.child);
 
-		current_node.set_parent(traverse_root_node);
-		traverse_root_node.add_child(current_node);
-
-		for (auto child_node_index : model.nodes[node_it.second].children)
-		{
-			traverse_nodes.push(std::make_pair(std::ref(traverse_root_node), child_node_index));
-		}
+		child_node.set_parent(parent_node);
+		parent_node.add_child(child_node);
 	}
 
 	scene.set_root_node(*root_node);
@@ -813,22 +2615,7 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	// Store nodes into the scene
 	scene.set_nodes(std::move(nodes));
 
-	// Create node for the default camera
-	auto camera_node = std::make_unique<sg::Node>(-1, "default_camera");
-
-	auto default_camera = create_default_camera();
-	default_camera->set_node(*camera_node);
-	camera_node->set_component(*default_camera);
-	scene.add_component(std::move(default_camera));
-
-	scene.get_root_node().add_child(*camera_node);
-	scene.add_node(std::move(camera_node));
-
-	if (!scene.has_component<vkb::sg::Light>())
-	{
-		// Add a default light if none are present
-		vkb::add_directional_light(scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
-	}
+	add_default_components(scene);
 
 	return scene;
 }
@@ -841,7 +2628,11 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 
 	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 
-	auto &command_buffer = device.request_command_buffer();
+	// The copies are recorded in a pool of their own and waited on with a fence of their own,
+	// so that loading does not wait for, or reset, work submitted by others to the device's pools
+	CommandPool command_pool{device, queue.get_family_index()};
+
+	auto &command_buffer = command_pool.request_command_buffer();
 
 	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
@@ -916,7 +2707,7 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 
 	core::Buffer buffer{device,
 	                    vertex_data.size() * sizeof(Vertex),
-	                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 	                    VMA_MEMORY_USAGE_GPU_ONLY};
 
 	command_buffer.copy_buffer(stage_buffer, buffer, vertex_data.size() * sizeof(Vertex));
@@ -968,7 +2759,7 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 
 		submesh->index_buffer = std::make_unique<core::Buffer>(device,
 		                                                       index_data.size(),
-		                                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		                                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 		                                                       VMA_MEMORY_USAGE_GPU_ONLY);
 
 		command_buffer.copy_buffer(stage_buffer, *submesh->index_buffer, index_data.size());
@@ -978,11 +2769,13 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 
 	command_buffer.end();
 
-	queue.submit(command_buffer, device.request_fence());
+	VkFenceCreateInfo fence_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+	ScopedFence       fence{device.get_handle()};
+	VK_CHECK(vkCreateFence(device.get_handle(), &fence_info, nullptr, &fence.handle));
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
+	VK_CHECK(queue.submit(command_buffer, fence.handle));
+
+	VK_CHECK(vkWaitForFences(device.get_handle(), 1, &fence.handle, VK_TRUE, std::numeric_limits<uint64_t>::max()));
 
 	return std::move(submesh);
 }
@@ -1117,7 +2910,7 @@ std::unique_ptr<sg::PBRMaterial> GLTFLoader::parse_material(const tinygltf::Mate
 	return material;
 }
 
-std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image) const
+std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image, const std::vector<uint8_t> *file_data) const
 {
 	std::unique_ptr<sg::Image> image{nullptr};
 
@@ -1137,7 +2930,14 @@ std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image)
 	{
 		// Load image from uri
 		auto image_uri = model_path + "/" + gltf_image.uri;
-		image          = sg::Image::load(gltf_image.name, image_uri);
+		if (file_data)
+		{
+			image = sg::Image::load(gltf_image.name, image_uri, file_data->data(), file_data->size(), &device);
+		}
+		else
+		{
+			image = sg::Image::load(gltf_image.name, image_uri, &device);
+		}
 	}
 
 	// Check whether the format is supported by the GPU
@@ -1146,16 +2946,56 @@ std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image)
 		if (!device.is_image_format_supported(image->get_format()))
 		{
 			LOGW("ASTC not supported: decoding {}", image->get_name());
-			image = std::make_unique<sg::Astc>(*image);
-			image->generate_mipmaps();
+			auto astc = std::make_unique<sg::Astc>(*image, job_system);
+
+			if (astc_bc_transcoding && astc->get_extent().depth == 1 &&
+			    device.is_image_format_supported(VK_FORMAT_BC1_RGB_SRGB_BLOCK) && device.is_image_format_supported(VK_FORMAT_BC3_SRGB_BLOCK))
+			{
+				astc->compress_to_bc(job_system);
+			}
+			else if (!supports_gpu_mipmaps(device, astc->get_format()))
+			{
+				astc->generate_mipmaps();
+			}
+
+			image = std::move(astc);
 		}
 	}
 
-	image->create_vk_image(device);
-
 	return image;
 }
 
+void GLTFLoader::prepare_image(sg::Image &image) const
+{
+	// Images without a mip chain get one blitted once they are uploaded
+	if (image.get_mipmaps().size() == 1 && supports_gpu_mipmaps(device, image.get_format()))
+	{
+		image.reserve_gpu_mipmaps();
+	}
+
+	// Streamed images start with their coarsest levels resident
+	if (texture_streamer && texture_streamer->can_stream(image))
+	{
+		image.set_base_level(texture_streamer->get_initial_base_level(image));
+	}
+	else
+	{
+		// Reuses the Vulkan image of an identical image loaded earlier on this device
+		auto shared = device.get_asset_cache().find_image(image.get_content_hash());
+
+		if (shared.first)
+		{
+			LOGI("Sharing the Vulkan image of an identical image for {}", image.get_name());
+
+			image.share_vk_image(shared.first, shared.second);
+
+			return;
+		}
+	}
+
+	image.create_vk_image(device);
+}
+
 std::unique_ptr<sg::Sampler> GLTFLoader::parse_sampler(const tinygltf::Sampler &gltf_sampler) const
 {
 	auto name = gltf_sampler.name;
@@ -1180,9 +3020,10 @@ std::unique_ptr<sg::Sampler> GLTFLoader::parse_sampler(const tinygltf::Sampler &
 	sampler_info.borderColor  = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 	sampler_info.maxLod       = std::numeric_limits<float>::max();
 
-	core::Sampler vk_sampler{device, sampler_info};
+	// Scenes loaded on the same device share their identical samplers
+	auto &vk_sampler = device.get_resource_cache().request_sampler(sampler_info);
 
-	return std::make_unique<sg::Sampler>(name, std::move(vk_sampler));
+	return std::make_unique<sg::Sampler>(name, vk_sampler);
 }
 
 std::unique_ptr<sg::Texture> GLTFLoader::parse_texture(const tinygltf::Texture &gltf_texture) const
@@ -1354,4 +3195,19 @@ tinygltf::Value *GLTFLoader::get_extension(tinygltf::ExtensionMap &tinygltf_exte
 		return nullptr;
 	}
 }
+
+int GLTFLoader::get_texture_source(tinygltf::Texture &gltf_texture)
+{
+	if (is_extension_enabled(KHR_TEXTURE_BASISU_EXTENSION))
+	{
+		auto extension = get_extension(gltf_texture.extensions, KHR_TEXTURE_BASISU_EXTENSION);
+
+		if (extension && extension->Has("source"))
+		{
+			return extension->Get("source").Get<int>();
+		}
+	}
+
+	return gltf_texture.source;
+}
 }        // namespace vkb
@@ -29,10 +29,14 @@
 #include "timer.h"
 
 #define KHR_LIGHTS_PUNCTUAL_EXTENSION "KHR_lights_punctual"
+#define KHR_TEXTURE_BASISU_EXTENSION "KHR_texture_basisu"
 
 namespace vkb
 {
 class Device;
+class JobSystem;
+class SceneSnapshot;
+class TextureStreamer;
 
 namespace sg
 {
@@ -71,16 +75,85 @@ class GLTFLoader
   public:
 	GLTFLoader(Device &device);
 
-	virtual ~GLTFLoader() = default;
+	virtual ~GLTFLoader();
 
 	std::unique_ptr<sg::Scene> read_scene_from_file(const std::string &file_name, int scene_index = -1);
 
+	/**
+	 * @brief Loads the nodes, meshes and materials of a scene, and streams its images and geometry in the background
+	 *        Textures show a placeholder image and submeshes are not drawn until update_streaming()
+	 *        swaps in their data. The loader must outlive the streaming.
+	 */
+	std::unique_ptr<sg::Scene> stream_scene_from_file(const std::string &file_name, int scene_index = -1);
+
+	/**
+	 * @brief Swaps the streamed assets which are loaded into the scene, and uploads them to the GPU
+	 *        Called once per frame, before the frame's submissions to the graphics queue
+	 * @return Whether assets are still streaming
+	 */
+	bool update_streaming();
+
+	/**
+	 * @brief Stops streaming, cancelling the pending file reads
+	 *        Textures whose image is not loaded yet keep their placeholder, and submeshes whose geometry is not loaded stay hidden.
+	 */
+	void cancel_streaming();
+
 	/**
 	 * @brief Loads the first model from a GLTF file for use in simpler samples
 	 *        makes use of the Vertex struct in vulkan_example_base.h
 	 */
 	std::unique_ptr<sg::SubMesh> read_model_from_file(const std::string &file_name, uint32_t index);
 
+	/**
+	 * @brief Generates lower levels of detail for the indexed triangle lists of the next scenes read
+	 *        The levels simplify the indices by vertex clustering and share the vertices of the submesh.
+	 * @param lod_levels Number of levels to generate, 0 to disable
+	 */
+	void set_lod_levels(uint32_t lod_levels);
+
+	/**
+	 * @brief Sets the job system parallelizing the work within an image, such as the software decoding of ASTC images
+	 */
+	void set_job_system(JobSystem *job_system);
+
+	/**
+	 * @brief Compresses the ASTC images decoded by software to BC1 or BC3 when the device supports them,
+	 *        instead of keeping them as RGBA8
+	 */
+	void set_astc_bc_transcoding(bool enabled);
+
+	/**
+	 * @brief Sets the streamer of the levels of the images with mipmaps, the images start with their coarsest levels
+	 *        resident and keep their data to upload the finer levels later
+	 */
+	void set_texture_streamer(TextureStreamer *texture_streamer);
+
+	/**
+	 * @brief Reorders the triangles of the indexed triangle lists of the next scenes read for the post-transform vertex cache,
+	 *        then their vertices in the order the triangles fetch them. The cache miss ratios are logged per primitive.
+	 */
+	void set_vertex_optimization(bool enabled);
+
+	/**
+	 * @brief Quantizes the normals of the next scenes read to 16 bit snorm and their texture coordinates to half floats
+	 */
+	void set_attribute_quantization(bool enabled);
+
+	/**
+	 * @brief Splits the indexed triangle lists of the next scenes read into meshlets of MAX_MESHLET_VERTICES vertices and
+	 *        MAX_MESHLET_TRIANGLES triangles, with the bounding spheres and normal cones the mesh shading path of the
+	 *        geometry subpass culls them with, see GeometrySubpass::set_mesh_shading()
+	 */
+	void set_meshlet_generation(bool enabled);
+
+	/**
+	 * @brief Reads the scenes from a binary snapshot in the temporary directory when one is up to date with their
+	 *        source files, otherwise writes one after loading the glTF file, see SceneSnapshot.
+	 *        Streamed scenes are always loaded from the glTF file.
+	 */
+	void set_scene_snapshots(bool enabled);
+
   protected:
 	virtual std::unique_ptr<sg::Node> parse_node(const tinygltf::Node &gltf_node, size_t index) const;
 
@@ -90,7 +163,17 @@ class GLTFLoader
 
 	virtual std::unique_ptr<sg::PBRMaterial> parse_material(const tinygltf::Material &gltf_material) const;
 
-	virtual std::unique_ptr<sg::Image> parse_image(tinygltf::Image &gltf_image) const;
+	/**
+	 * @brief Decodes an image, and transcodes it to a format the device supports
+	 *        Its Vulkan image is created by prepare_image().
+	 * @param file_data Content of the file of an image with a uri, already read by the caller, the file is mapped otherwise
+	 */
+	virtual std::unique_ptr<sg::Image> parse_image(tinygltf::Image &gltf_image, const std::vector<uint8_t> *file_data = nullptr) const;
+
+	/**
+	 * @brief Creates the Vulkan image of a decoded image, or shares the one of an identical image
+	 */
+	void prepare_image(sg::Image &image) const;
 
 	virtual std::unique_ptr<sg::Sampler> parse_sampler(const tinygltf::Sampler &gltf_sampler) const;
 
@@ -122,18 +205,62 @@ class GLTFLoader
 	 */
 	tinygltf::Value *get_extension(tinygltf::ExtensionMap &tinygltf_extensions, const std::string &extension);
 
+	/**
+	 * @return The index of the image of a texture, its KTX2 image if it has one and KHR_texture_basisu is enabled
+	 */
+	int get_texture_source(tinygltf::Texture &gltf_texture);
+
 	Device &device;
 
 	tinygltf::Model model;
 
 	std::string model_path;
 
+	uint32_t lod_levels{0};
+
+	JobSystem *job_system{nullptr};
+
+	bool astc_bc_transcoding{false};
+
+	TextureStreamer *texture_streamer{nullptr};
+
+	bool optimize_vertex_order{false};
+
+	bool quantize_attributes{false};
+
+	bool generate_meshlets{false};
+
+	bool scene_snapshots{false};
+
 	/// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
 	static std::unordered_map<std::string, bool> supported_extensions;
 
   private:
+	struct StreamingState;
+
 	sg::Scene load_scene(int scene_index = -1);
 
+	/**
+	 * @brief Builds a scene from a snapshot, moving the image data out of it
+	 */
+	sg::Scene load_scene_snapshot(SceneSnapshot &snapshot);
+
+	/**
+	 * @brief Adds the default camera, and a default light to a scene without lights
+	 */
+	void add_default_components(sg::Scene &scene);
+
+	/**
+	 * @return The key of the snapshot of a scene loaded with the current settings on the device
+	 */
+	uint64_t get_snapshot_key(const std::string &file_name, int scene_index) const;
+
 	std::unique_ptr<sg::SubMesh> load_model(uint32_t index);
+
+	/// The assets left to stream, only set by stream_scene_from_file()
+	std::unique_ptr<StreamingState> streaming;
+
+	/// The snapshot recorded while a scene is loaded from its glTF file, see set_scene_snapshots()
+	std::unique_ptr<SceneSnapshot> snapshot;
 };
 }        // namespace vkb
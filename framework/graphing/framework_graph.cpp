@@ -28,9 +28,22 @@ namespace graphing
 {
 namespace framework_graph
 {
+void MemoryCensus::add(const std::string &category, uint64_t bytes)
+{
+	auto &totals = categories[category];
+	totals.count++;
+	totals.bytes += bytes;
+}
+
 bool generate(RenderContext &context)
 {
-	Graph graph("Framework");
+	return capture(context)->dump_to_file("framework.json");
+}
+
+std::unique_ptr<Graph> capture(RenderContext &context)
+{
+	auto   graph_ptr = std::make_unique<Graph>("Framework");
+	Graph &graph     = *graph_ptr;
 	graph.new_style("Core", "#00BCD4");
 	graph.new_style("Rendering", "#4CAF50");
 	graph.new_style("Framework", "#FFC107");
@@ -47,6 +60,8 @@ bool generate(RenderContext &context)
 
 	const auto &resource_cache_state = resource_cache.get_internal_state();
 
+	MemoryCensus census;
+
 	auto it_pipeline_layouts = resource_cache_state.pipeline_layouts.begin();
 	while (it_pipeline_layouts != resource_cache_state.pipeline_layouts.end())
 	{
@@ -85,6 +100,7 @@ bool generate(RenderContext &context)
 
 		size_t graphics_pipelines_id = graphics_pipeline_node(graph, it_graphics_pipelines->second);
 		graph.add_edge(pipeline_layout, graphics_pipelines_id);
+		census.add("Graphics Pipelines");
 
 		size_t graphics_pipelines_state_id = pipeline_state_node(graph, it_graphics_pipelines->second.get_state());
 		graph.add_edge(graphics_pipelines_id, graphics_pipelines_state_id);
@@ -122,9 +138,17 @@ bool generate(RenderContext &context)
 	{
 		size_t compute_pipelines_id = compute_pipeline_node(graph, it_compute_pipelines->second);
 		graph.add_edge(resource_cache_id, compute_pipelines_id);
+		census.add("Compute Pipelines");
 		it_compute_pipelines++;
 	}
 
+	for (const auto &descriptor_pool : resource_cache_state.descriptor_pools)
+	{
+		size_t descriptor_pool_id = descriptor_pool_node(graph, descriptor_pool.second);
+		graph.add_edge(resource_cache_id, descriptor_pool_id);
+		census.add("Descriptor Pools");
+	}
+
 	auto it_framebuffers = resource_cache_state.framebuffers.begin();
 	while (it_framebuffers != resource_cache_state.framebuffers.end())
 	{
@@ -174,15 +198,36 @@ bool generate(RenderContext &context)
 			graph.add_edge(render_target_id, image_view_id);
 			graph.add_edge(image_view_id, image_id);
 
+			// Aliased memory belongs to another image, it would be counted twice
+			census.add(image.get_memory() != VK_NULL_HANDLE ? "Images" : "Swapchain Images",
+			           image.is_aliased() ? 0 : allocation_size(device, image.get_memory()));
+
 			size_t vkimage_id = create_vk_image(graph, image.get_handle());
 			graph.add_edge(image_id, vkimage_id);
 
 			size_t vkimageview_id = create_vk_image_view(graph, view.get_handle());
 			graph.add_edge(image_view_id, vkimageview_id);
 		}
+
+		for (const auto *buffer : frame->get_buffers())
+		{
+			size_t buffer_id = buffer_node(graph, *buffer);
+			graph.add_edge(frame_id, buffer_id);
+			census.add("Buffers", allocation_size(device, buffer->get_allocation()));
+		}
+
+		for (const auto *descriptor_pool : frame->get_descriptor_pools())
+		{
+			size_t descriptor_pool_id = descriptor_pool_node(graph, *descriptor_pool);
+			graph.add_edge(frame_id, descriptor_pool_id);
+			census.add("Descriptor Pools");
+		}
 	}
 
-	return graph.dump_to_file("framework.json");
+	size_t census_id = memory_census_node(graph, census, resource_cache.get_frame_index());
+	graph.add_edge(device_id, census_id);
+
+	return graph_ptr;
 }
 
 size_t create_vk_image(Graph &graph, const VkImage &image)
@@ -296,7 +341,11 @@ size_t image_node(Graph &graph, const core::Image &image)
 	                       {"VkSampleCountFlagBits", to_string(image.get_sample_count())},
 	                       {"VkImageTiling", to_string(image.get_tiling())},
 	                       {"VkImageType", to_string(image.get_type())},
-	                       {"VkSubresource", {{"VkImageAspectFlags", image_aspect_to_string(subresource.aspectMask)}, {"mip_level", subresource.mipLevel}, {"array_layer", subresource.arrayLayer}}}};
+	                       {"VkSubresource", {{"VkImageAspectFlags", image_aspect_to_string(subresource.aspectMask)}, {"mip_level", subresource.mipLevel}, {"array_layer", subresource.arrayLayer}}},
+	                       {"memory", allocation_data(image.get_device(), image.get_memory())},
+	                       {"aliased", image.is_aliased()},
+	                       {"creation_time_us", image.get_creation_time() / 1000.0},
+	                       {"last_use_frame", image.get_last_use_frame()}};
 
 	return graph.create_node(result.c_str(), "Core", data);
 }
@@ -406,7 +455,9 @@ size_t pipeline_layout_node(Graph &graph, const PipelineLayout &pipeline_layout)
 size_t graphics_pipeline_node(Graph &graph, const GraphicsPipeline &graphics_pipeline)
 {
 	nlohmann::json data = {
-	    {"handle", Node::handle_to_uintptr_t(graphics_pipeline.get_handle())}};
+	    {"handle", Node::handle_to_uintptr_t(graphics_pipeline.get_handle())},
+	    {"creation_time_us", graphics_pipeline.get_creation_time() / 1000.0},
+	    {"last_use_frame", graphics_pipeline.get_last_use_frame()}};
 
 	return graph.create_node("Graphics Pipeline", "Core", data);
 }
@@ -414,7 +465,9 @@ size_t graphics_pipeline_node(Graph &graph, const GraphicsPipeline &graphics_pip
 size_t compute_pipeline_node(Graph &graph, const ComputePipeline &compute_pipeline)
 {
 	nlohmann::json data = {
-	    {"handle", Node::handle_to_uintptr_t(compute_pipeline.get_handle())}};
+	    {"handle", Node::handle_to_uintptr_t(compute_pipeline.get_handle())},
+	    {"creation_time_us", compute_pipeline.get_creation_time() / 1000.0},
+	    {"last_use_frame", compute_pipeline.get_last_use_frame()}};
 
 	return graph.create_node("Compute Pipeline", "Core", data);
 }
@@ -560,6 +613,92 @@ size_t color_blend_attachment_state_node(Graph &graph, const ColorBlendAttachmen
 	return graph.create_node("Color Blend Attachment State", "Core", data);
 }
 
+size_t buffer_node(Graph &graph, const core::Buffer &buffer)
+{
+	nlohmann::json data = {
+	    {"handle", Node::handle_to_uintptr_t(buffer.get_handle())},
+	    {"size", buffer.get_size()},
+	    {"memory", allocation_data(buffer.get_device(), buffer.get_allocation())},
+	    {"creation_time_us", buffer.get_creation_time() / 1000.0},
+	    {"last_use_frame", buffer.get_last_use_frame()}};
+
+	return graph.create_node("Buffer", "Core", data);
+}
+
+size_t descriptor_pool_node(Graph &graph, const DescriptorPool &descriptor_pool)
+{
+	std::vector<nlohmann::json> pool_sizes;
+
+	for (auto &pool_size : descriptor_pool.get_pool_sizes())
+	{
+		pool_sizes.push_back({{"VkDescriptorType", pool_size.type},
+		                      {"descriptorCount", pool_size.descriptorCount}});
+	}
+
+	nlohmann::json data = {
+	    {"pool_count", descriptor_pool.get_pool_count()},
+	    {"max_sets_per_pool", descriptor_pool.get_max_sets_per_pool()},
+	    {"allocated_set_count", descriptor_pool.get_allocated_set_count()},
+	    {"VkDescriptorPoolSize", pool_sizes},
+	    {"creation_time_us", descriptor_pool.get_creation_time() / 1000.0},
+	    {"last_use_frame", descriptor_pool.get_last_use_frame()}};
+
+	return graph.create_node("Descriptor Pool", "Core", data);
+}
+
+size_t memory_census_node(Graph &graph, const MemoryCensus &census, uint64_t frame)
+{
+	// Pipelines and descriptor pools live in driver memory which cannot be queried, only their count is known
+	nlohmann::json data = {{"frame", frame}};
+
+	uint64_t total_bytes = 0;
+
+	for (auto &category : census.categories)
+	{
+		data[category.first] = {{"count", category.second.count},
+		                        {"bytes", category.second.bytes}};
+
+		total_bytes += category.second.bytes;
+	}
+
+	data["total_bytes"] = total_bytes;
+
+	return graph.create_node("Memory Census", "Framework", data);
+}
+
+nlohmann::json allocation_data(const Device &device, VmaAllocation allocation)
+{
+	if (allocation == VK_NULL_HANDLE)
+	{
+		return {{"allocation_type", "External"}, {"size", 0}};
+	}
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), allocation, &allocation_info);
+
+	VkMemoryPropertyFlags memory_flags{0};
+	vmaGetMemoryTypeProperties(device.get_memory_allocator(), allocation_info.memoryType, &memory_flags);
+
+	return {{"allocation_type", "VMA"},
+	        {"size", allocation_info.size},
+	        {"offset", allocation_info.offset},
+	        {"memory_type", allocation_info.memoryType},
+	        {"VkMemoryPropertyFlags", memory_property_to_string(memory_flags)}};
+}
+
+VkDeviceSize allocation_size(const Device &device, VmaAllocation allocation)
+{
+	if (allocation == VK_NULL_HANDLE)
+	{
+		return 0;
+	}
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), allocation, &allocation_info);
+
+	return allocation_info.size;
+}
+
 }        // namespace framework_graph
 }        // namespace graphing
 }        // namespace vkb
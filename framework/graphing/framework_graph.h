@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "core/device.h"
 #include "core/image_view.h"
 #include "core/shader_module.h"
@@ -39,14 +41,37 @@ namespace graphing
 {
 namespace framework_graph
 {
+/**
+ * @brief Number and memory size of the objects of each category dumped in the graph
+ */
+struct MemoryCensus
+{
+	struct Category
+	{
+		uint64_t count{0};
+
+		uint64_t bytes{0};
+	};
+
+	std::map<std::string, Category> categories;
+
+	void add(const std::string &category, uint64_t bytes = 0);
+};
+
+/**
+ * @brief Captures the framework graph and writes it to framework.json
+ */
 bool generate(RenderContext &context);
 
+/**
+ * @brief Captures the state of the framework objects into a graph, which can be written later from another thread
+ */
+std::unique_ptr<Graph> capture(RenderContext &context);
+
 template <typename T>
 size_t create_vk_node(Graph &graph, const char *name, const T &handle)
 {
-	std::stringstream temp;
-	temp << Node::handle_to_uintptr_t(handle);
-	std::string tag = "VK_HANDLE-" + temp.str();
+	std::string tag = "VK_HANDLE-" + std::to_string(Node::handle_to_uintptr_t(handle));
 
 	size_t id = graph.find_ref(tag);
 
@@ -92,6 +117,22 @@ size_t multisample_state_node(Graph &graph, const MultisampleState &multisample_
 size_t depth_stencil_state_node(Graph &graph, const DepthStencilState &depth_stencil_state);
 size_t color_blend_state_node(Graph &graph, const ColorBlendState &color_blend_state);
 size_t color_blend_attachment_state_node(Graph &graph, const ColorBlendAttachmentState &state);
+size_t buffer_node(Graph &graph, const core::Buffer &buffer);
+size_t descriptor_pool_node(Graph &graph, const DescriptorPool &descriptor_pool);
+size_t memory_census_node(Graph &graph, const MemoryCensus &census, uint64_t frame);
+
+/**
+ * @brief Describes the memory bound to a resource
+ * @param device The device which allocated the memory
+ * @param allocation The allocation, null if the memory is owned outside of the framework, e.g. by the swapchain
+ * @return The size, memory type and memory properties of the allocation
+ */
+nlohmann::json allocation_data(const Device &device, VmaAllocation allocation);
+
+/**
+ * @return The size of the allocation, zero if it is null
+ */
+VkDeviceSize allocation_size(const Device &device, VmaAllocation allocation);
 
 }        // namespace framework_graph
 }        // namespace graphing
@@ -17,6 +17,7 @@
 
 #include "graph.h"
 
+#include "common/logging.h"
 #include "platform/filesystem.h"
 
 namespace vkb
@@ -70,10 +71,14 @@ void Graph::remove_ref(std::string &name)
 	}
 }
 
+uint64_t Graph::edge_key(size_t from, size_t to)
+{
+	return (static_cast<uint64_t>(from) << 32) ^ static_cast<uint64_t>(to);
+}
+
 void Graph::add_edge(size_t from, size_t to)
 {
-	auto it = std::find_if(adj.begin(), adj.end(), [from, to](auto &e) -> bool { return e.from == from && e.to == to; });
-	if (it == adj.end())
+	if (edge_keys.insert(edge_key(from, to)).second)
 	{
 		adj.push_back({new_id(), from, to});
 	}
@@ -81,6 +86,11 @@ void Graph::add_edge(size_t from, size_t to)
 
 void Graph::remove_edge(size_t from, size_t to)
 {
+	if (edge_keys.erase(edge_key(from, to)) == 0)
+	{
+		return;
+	}
+
 	auto it = std::find_if(adj.begin(), adj.end(), [from, to](auto &e) -> bool { return e.from == from && e.to == to; });
 	if (it != adj.end())
 	{
@@ -119,7 +129,65 @@ bool Graph::dump_to_file(std::string file)
 	    {"styles", style_colors}};
 
 	return fs::write_json(j, file);
-}        // namespace graphing
+}
+
+AsyncGraphWriter::AsyncGraphWriter() :
+    worker{&AsyncGraphWriter::run, this}
+{
+}
+
+AsyncGraphWriter::~AsyncGraphWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		stopping = true;
+	}
+	condition.notify_one();
+	worker.join();
+}
+
+void AsyncGraphWriter::write(std::unique_ptr<Graph> graph, const std::string &file_name)
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		queue.emplace_back(std::move(graph), file_name);
+	}
+	condition.notify_one();
+}
+
+bool AsyncGraphWriter::is_busy() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	return writing || !queue.empty();
+}
+
+void AsyncGraphWriter::run()
+{
+	std::unique_lock<std::mutex> lock{mutex};
+	while (true)
+	{
+		condition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+		if (queue.empty())
+		{
+			// Stopping with nothing left to write
+			return;
+		}
+
+		auto job = std::move(queue.front());
+		queue.pop_front();
+		writing = true;
+
+		lock.unlock();
+		if (!job.first->dump_to_file(job.second))
+		{
+			LOGE("Failed to save graph {}", job.second);
+		}
+		lock.lock();
+
+		writing = false;
+	}
+}
 
 }        // namespace graphing
 }        // namespace vkb
\ No newline at end of file
@@ -18,8 +18,13 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include <json.hpp>
@@ -127,10 +132,64 @@ class Graph
   private:
 	size_t                                            next_id = 1;
 	std::vector<Edge>                                 adj;
+	std::unordered_set<uint64_t>                      edge_keys;
 	std::unordered_map<size_t, std::unique_ptr<Node>> nodes;
 	std::unordered_map<std::string, size_t>           refs;
 	std::string                                       name;
 	std::unordered_map<std::string, std::string>      style_colors;
+
+	/// Key of an edge in edge_keys, so that adding an edge does not search every edge
+	static uint64_t edge_key(size_t from, size_t to);
+};
+
+/**
+ * @brief Writes graphs to file on a background thread
+ *
+ * The graph is built by the caller, which copies what it needs from the live objects,
+ * while the serialization to JSON and the file write happen on the writer's thread.
+ * Pending graphs are still written when the writer is destroyed.
+ */
+class AsyncGraphWriter
+{
+  public:
+	AsyncGraphWriter();
+
+	AsyncGraphWriter(const AsyncGraphWriter &) = delete;
+
+	AsyncGraphWriter(AsyncGraphWriter &&) = delete;
+
+	~AsyncGraphWriter();
+
+	AsyncGraphWriter &operator=(const AsyncGraphWriter &) = delete;
+
+	AsyncGraphWriter &operator=(AsyncGraphWriter &&) = delete;
+
+	/**
+	 * @brief Queues a graph to be written
+	 * @param graph The graph, owned by the writer from now on
+	 * @param file_name The file to dump it to
+	 */
+	void write(std::unique_ptr<Graph> graph, const std::string &file_name);
+
+	/**
+	 * @return Whether graphs are queued or being written
+	 */
+	bool is_busy() const;
+
+  private:
+	void run();
+
+	mutable std::mutex mutex;
+
+	std::condition_variable condition;
+
+	std::deque<std::pair<std::unique_ptr<Graph>, std::string>> queue;
+
+	bool writing{false};
+
+	bool stopping{false};
+
+	std::thread worker;
 };
 }        // namespace graphing
 }        // namespace vkb
\ No newline at end of file
@@ -36,16 +36,21 @@ std::string label(const T &node, const std::string &type)
 
 bool generate(sg::Scene &scene)
 {
-	Graph scene_graph("Scene");
-	scene_graph.new_style("Scene", "#00BCD4");
-	scene_graph.new_style("Component", "#FFC107");
-	scene_graph.new_style("Node", "#F44336");
+	return capture(scene)->dump_to_file("scene.json");
+}
+
+std::unique_ptr<Graph> capture(sg::Scene &scene)
+{
+	auto scene_graph = std::make_unique<Graph>("Scene");
+	scene_graph->new_style("Scene", "#00BCD4");
+	scene_graph->new_style("Component", "#FFC107");
+	scene_graph->new_style("Node", "#F44336");
 
-	size_t scene_id = sg_scene_node(scene_graph, scene);
+	size_t scene_id = sg_scene_node(*scene_graph, scene);
 
-	scrape_scene_node(scene_graph, scene.get_root_node().get_children(), scene_id);
+	scrape_scene_node(*scene_graph, scene.get_root_node().get_children(), scene_id);
 
-	return scene_graph.dump_to_file("scene.json");
+	return scene_graph;
 }
 
 void scrape_scene_node(Graph &graph, const std::vector<sg::Node *> &children, size_t owner)
@@ -36,8 +36,16 @@ namespace scene_graph
 {
 void scrape_scene_node(Graph &graph, const std::vector<sg::Node *> &children, size_t owner);
 
+/**
+ * @brief Captures the scene graph and writes it to scene.json
+ */
 bool generate(sg::Scene &scene);
 
+/**
+ * @brief Captures the scene into a graph, which can be written later from another thread
+ */
+std::unique_ptr<Graph> capture(sg::Scene &scene);
+
 size_t sg_scene_node(Graph &graph, const sg::Scene &scene);
 size_t sg_node_node(Graph &graph, const sg::Node &node);
 size_t sg_component_node(Graph &graph, const sg::Component &component);
@@ -18,6 +18,7 @@
 
 #include "gui.h"
 
+#include <cstring>
 #include <map>
 #include <numeric>
 
@@ -42,6 +43,7 @@ VKBP_ENABLE_WARNINGS()
 #include "platform/filesystem.h"
 #include "platform/window.h"
 #include "rendering/render_context.h"
+#include "stats/frame_breakdown_stats_provider.h"
 #include "timer.h"
 #include "vulkan_sample.h"
 
@@ -49,7 +51,7 @@ namespace vkb
 {
 namespace
 {
-void upload_draw_data(ImDrawData *draw_data, const uint8_t *vertex_data, const uint8_t *index_data)
+void upload_draw_data(ImDrawData *draw_data, uint8_t *vertex_data, uint8_t *index_data)
 {
 	ImDrawVert *vtx_dst = (ImDrawVert *) vertex_data;
 	ImDrawIdx * idx_dst = (ImDrawIdx *) index_data;
@@ -64,6 +66,175 @@ void upload_draw_data(ImDrawData *draw_data, const uint8_t *vertex_data, const u
 	}
 }
 
+/// Identifies a cached font atlas ("VKBF")
+constexpr uint32_t FONT_ATLAS_CACHE_MAGIC = 0x46424B56;
+
+struct FontAtlasCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t imgui_version;
+
+	uint32_t glyph_size;
+
+	uint32_t font_count;
+
+	int32_t tex_width;
+
+	int32_t tex_height;
+
+	ImVec2 tex_uv_scale;
+
+	ImVec2 tex_uv_white_pixel;
+};
+
+/// Followed by the glyphs of the font
+struct FontCacheRecord
+{
+	float ascent;
+
+	float descent;
+
+	uint32_t glyph_count;
+};
+
+/**
+ * @return The name of the file caching the atlas rasterized for the fonts at their DPI scaled sizes
+ */
+std::string get_font_atlas_filename(const std::vector<Font> &fonts, float dpi_factor)
+{
+	size_t key{0};
+
+	hash_combine(key, IMGUI_VERSION_NUM);
+	hash_combine(key, dpi_factor);
+
+	for (auto &font : fonts)
+	{
+		hash_combine(key, font.name);
+		hash_combine(key, font.size);
+		hash_combine(key, font.data.size());
+	}
+
+	return fmt::format("gui_fonts_{:016x}.cache", static_cast<uint64_t>(key));
+}
+
+std::vector<uint8_t> encode_font_atlas(const ImFontAtlas &atlas)
+{
+	std::vector<uint8_t> data;
+
+	auto append = [&data](const void *values, size_t size) {
+		auto bytes = reinterpret_cast<const uint8_t *>(values);
+		data.insert(data.end(), bytes, bytes + size);
+	};
+
+	FontAtlasCacheHeader header{};
+	header.magic              = FONT_ATLAS_CACHE_MAGIC;
+	header.imgui_version      = IMGUI_VERSION_NUM;
+	header.glyph_size         = sizeof(ImFontGlyph);
+	header.font_count         = to_u32(atlas.Fonts.Size);
+	header.tex_width          = atlas.TexWidth;
+	header.tex_height         = atlas.TexHeight;
+	header.tex_uv_scale       = atlas.TexUvScale;
+	header.tex_uv_white_pixel = atlas.TexUvWhitePixel;
+
+	append(&header, sizeof(header));
+
+	for (auto font : atlas.Fonts)
+	{
+		FontCacheRecord record{font->Ascent, font->Descent, to_u32(font->Glyphs.Size)};
+
+		append(&record, sizeof(record));
+		append(font->Glyphs.Data, font->Glyphs.Size * sizeof(ImFontGlyph));
+	}
+
+	append(atlas.TexPixelsRGBA32, static_cast<size_t>(atlas.TexWidth) * atlas.TexHeight * 4);
+
+	return data;
+}
+
+/**
+ * @brief Restores the glyphs and pixels of the fonts added to the atlas, instead of rasterizing them
+ * @return False if the data is truncated or was written by another version of ImGui
+ */
+bool decode_font_atlas(ImFontAtlas &atlas, const std::vector<uint8_t> &data)
+{
+	size_t offset{0};
+
+	auto read = [&data, &offset](void *values, size_t size) {
+		if (offset > data.size() || size > data.size() - offset)
+		{
+			return false;
+		}
+
+		std::memcpy(values, data.data() + offset, size);
+		offset += size;
+
+		return true;
+	};
+
+	FontAtlasCacheHeader header{};
+	if (!read(&header, sizeof(header)) ||
+	    header.magic != FONT_ATLAS_CACHE_MAGIC ||
+	    header.imgui_version != IMGUI_VERSION_NUM ||
+	    header.glyph_size != sizeof(ImFontGlyph) ||
+	    header.font_count != to_u32(atlas.Fonts.Size) ||
+	    header.font_count != to_u32(atlas.ConfigData.Size))
+	{
+		return false;
+	}
+
+	std::vector<FontCacheRecord>          records(header.font_count);
+	std::vector<std::vector<ImFontGlyph>> glyphs(header.font_count);
+
+	for (uint32_t i = 0; i < header.font_count; ++i)
+	{
+		if (!read(&records[i], sizeof(FontCacheRecord)))
+		{
+			return false;
+		}
+
+		glyphs[i].resize(records[i].glyph_count);
+
+		if (!read(glyphs[i].data(), glyphs[i].size() * sizeof(ImFontGlyph)))
+		{
+			return false;
+		}
+	}
+
+	size_t pixels_size = static_cast<size_t>(header.tex_width) * header.tex_height * 4;
+
+	if (header.tex_width <= 0 || header.tex_height <= 0 || data.size() - offset != pixels_size)
+	{
+		return false;
+	}
+
+	// The atlas frees its pixels with the ImGui allocator
+	atlas.ClearTexData();
+	atlas.TexPixelsRGBA32 = static_cast<unsigned int *>(IM_ALLOC(pixels_size));
+	read(atlas.TexPixelsRGBA32, pixels_size);
+
+	atlas.TexWidth        = header.tex_width;
+	atlas.TexHeight       = header.tex_height;
+	atlas.TexUvScale      = header.tex_uv_scale;
+	atlas.TexUvWhitePixel = header.tex_uv_white_pixel;
+
+	for (uint32_t i = 0; i < header.font_count; ++i)
+	{
+		auto font = atlas.Fonts[i];
+
+		ImFontAtlasBuildSetupFont(&atlas, font, &atlas.ConfigData[i], records[i].ascent, records[i].descent);
+
+		for (auto &glyph : glyphs[i])
+		{
+			font->Glyphs.push_back(glyph);
+		}
+
+		font->BuildLookupTable();
+	}
+
+	return true;
+}
+
 inline void reset_graph_max_value(StatGraphData &graph_data)
 {
 	// If it does not have a fixed max
@@ -146,16 +317,47 @@ Gui::Gui(VulkanSample &sample_, const Window &window, const Stats *stats,
 	io.KeyMap[ImGuiKey_DownArrow]  = static_cast<int>(KeyCode::Down);
 	io.KeyMap[ImGuiKey_Tab]        = static_cast<int>(KeyCode::Tab);
 
+#ifdef IM_DRAWLIST_TEX_LINES_WIDTH_MAX
+	// Lines baked into the atlas are not restored from the cache
+	io.Fonts->Flags |= ImFontAtlasFlags_NoBakedLines;
+#endif
+
 	// Default font
 	fonts.emplace_back(default_font, font_size * dpi_factor);
 
 	// Debug window font
 	fonts.emplace_back("RobotoMono-Regular", (font_size / 2) * dpi_factor);
 
+	// Rasterizing the fonts is done once per size, the atlas is cached in the temporary directory
+	auto font_atlas_filename = get_font_atlas_filename(fonts, dpi_factor);
+	bool font_atlas_cached   = false;
+
+	try
+	{
+		font_atlas_cached = fs::is_file(fs::path::get(fs::path::Type::Temp) + font_atlas_filename) &&
+		                    decode_font_atlas(*io.Fonts, fs::read_temp(font_atlas_filename));
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to read font atlas cache file {}: {}", font_atlas_filename, e.what());
+	}
+
 	// Create font texture
 	unsigned char *font_data;
 	int            tex_width, tex_height;
 	io.Fonts->GetTexDataAsRGBA32(&font_data, &tex_width, &tex_height);
+
+	if (!font_atlas_cached)
+	{
+		try
+		{
+			fs::write_temp(encode_font_atlas(*io.Fonts), font_atlas_filename);
+		}
+		catch (const std::runtime_error &e)
+		{
+			LOGW("Failed to store font atlas cache file {}: {}", font_atlas_filename, e.what());
+		}
+	}
 	size_t upload_size = tex_width * tex_height * 4 * sizeof(char);
 
 	auto &device = sample.get_render_context().get_device();
@@ -246,12 +448,12 @@ Gui::Gui(VulkanSample &sample_, const Window &window, const Stats *stats,
 
 	pipeline_layout = &device.get_resource_cache().request_pipeline_layout(shader_modules);
 
-	sampler = std::make_unique<core::Sampler>(device, sampler_info);
+	sampler = &device.get_resource_cache().request_sampler(sampler_info);
 
 	if (explicit_update)
 	{
-		vertex_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
-		index_buffer  = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+		vertex_buffers.push_back(std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU));
+		index_buffers.push_back(std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU));
 	}
 }
 
@@ -372,10 +574,9 @@ void Gui::update(const float delta_time)
 	ImGui::Render();
 }
 
-bool Gui::update_buffers()
+bool Gui::update_buffers(uint32_t frame_index)
 {
 	ImDrawData *draw_data = ImGui::GetDrawData();
-	bool        updated   = false;
 
 	if (!draw_data)
 	{
@@ -390,26 +591,42 @@ bool Gui::update_buffers()
 		return false;
 	}
 
-	if ((vertex_buffer->get_handle() == VK_NULL_HANDLE) || (vertex_buffer_size != last_vertex_buffer_size))
+	// The command buffers recorded with the previous draw counts have to be rebuilt
+	bool updated = (vertex_buffer_size != last_vertex_buffer_size) || (index_buffer_size != last_index_buffer_size);
+
+	last_vertex_buffer_size = vertex_buffer_size;
+	last_index_buffer_size  = index_buffer_size;
+
+	// The buffers of a frame are created the first time it updates them
+	if (frame_index >= vertex_buffers.size())
 	{
-		last_vertex_buffer_size = vertex_buffer_size;
-		updated                 = true;
+		vertex_buffers.resize(frame_index + 1);
+		index_buffers.resize(frame_index + 1);
+	}
+
+	auto &vertex_buffer = vertex_buffers[frame_index];
+	auto &index_buffer  = index_buffers[frame_index];
 
-		vertex_buffer.reset();
-		vertex_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), vertex_buffer_size,
+	auto &device = sample.get_render_context().get_device();
+
+	// The buffers only grow, with some headroom so that a growing overlay does not reallocate them every frame.
+	// A replaced buffer is destroyed once the submissions which may read it have completed.
+	if (!vertex_buffer || vertex_buffer->get_size() < vertex_buffer_size)
+	{
+		device.get_deletion_queue().retire(std::move(vertex_buffer));
+		vertex_buffer = std::make_unique<core::Buffer>(device, vertex_buffer_size + vertex_buffer_size / 2,
 		                                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		                                               VMA_MEMORY_USAGE_GPU_TO_CPU);
+		                                               VMA_MEMORY_USAGE_CPU_TO_GPU);
+		updated = true;
 	}
 
-	if ((index_buffer->get_handle() == VK_NULL_HANDLE) || (index_buffer_size != last_index_buffer_size))
+	if (!index_buffer || index_buffer->get_size() < index_buffer_size)
 	{
-		last_index_buffer_size = index_buffer_size;
-		updated                = true;
-
-		index_buffer.reset();
-		index_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), index_buffer_size,
+		device.get_deletion_queue().retire(std::move(index_buffer));
+		index_buffer = std::make_unique<core::Buffer>(device, index_buffer_size + index_buffer_size / 2,
 		                                              VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		                                              VMA_MEMORY_USAGE_GPU_TO_CPU);
+		                                              VMA_MEMORY_USAGE_CPU_TO_GPU);
+		updated = true;
 	}
 
 	// Upload data
@@ -424,13 +641,13 @@ bool Gui::update_buffers()
 	return updated;
 }
 
-void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_frame)
+bool Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_frame)
 {
 	ImDrawData *draw_data = ImGui::GetDrawData();
 
 	if (!draw_data)
 	{
-		return;
+		return false;
 	}
 
 	size_t vertex_buffer_size = draw_data->TotalVtxCount * sizeof(ImDrawVert);
@@ -438,17 +655,24 @@ void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_fram
 
 	if ((vertex_buffer_size == 0) || (index_buffer_size == 0))
 	{
-		return;
+		return false;
 	}
 
-	std::vector<uint8_t> vertex_data(vertex_buffer_size);
-	std::vector<uint8_t> index_data(index_buffer_size);
+	// Allocated from the rings of the render context when it has some, otherwise from the buffer pools of the frame
+	auto vertex_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer_size);
+	auto index_allocation  = render_frame.allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
 
-	upload_draw_data(draw_data, vertex_data.data(), index_data.data());
+	if (vertex_allocation.empty() || index_allocation.empty())
+	{
+		LOGE("Failed to allocate the GUI geometry");
+		return false;
+	}
 
-	auto vertex_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer_size);
+	// The draw lists are copied in a single pass straight into the mapped memory
+	upload_draw_data(draw_data, vertex_allocation.map(vertex_buffer_size), index_allocation.map(index_buffer_size));
 
-	vertex_allocation.update(vertex_data);
+	vertex_allocation.flush();
+	index_allocation.flush();
 
 	std::vector<std::reference_wrapper<const core::Buffer>> buffers;
 	buffers.emplace_back(std::ref(vertex_allocation.get_buffer()));
@@ -457,11 +681,9 @@ void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_fram
 
 	command_buffer.bind_vertex_buffers(0, buffers, offsets);
 
-	auto index_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
-
-	index_allocation.update(index_data);
-
 	command_buffer.bind_index_buffer(index_allocation.get_buffer(), index_allocation.get_offset(), VK_INDEX_TYPE_UINT16);
+
+	return true;
 }
 
 void Gui::resize(const uint32_t width, const uint32_t height) const
@@ -534,26 +756,7 @@ void Gui::draw(CommandBuffer &command_buffer)
 
 	// Pre-rotation
 	auto &io             = ImGui::GetIO();
-	auto  push_transform = glm::mat4(1.0f);
-
-	if (sample.get_render_context().has_swapchain())
-	{
-		auto transform = sample.get_render_context().get_swapchain().get_transform();
-
-		glm::vec3 rotation_axis = glm::vec3(0.0f, 0.0f, 1.0f);
-		if (transform & VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR)
-		{
-			push_transform = glm::rotate(push_transform, glm::radians(90.0f), rotation_axis);
-		}
-		else if (transform & VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
-		{
-			push_transform = glm::rotate(push_transform, glm::radians(270.0f), rotation_axis);
-		}
-		else if (transform & VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR)
-		{
-			push_transform = glm::rotate(push_transform, glm::radians(180.0f), rotation_axis);
-		}
-	}
+	auto  push_transform = sample.get_render_context().get_pre_rotation();
 
 	// GUI coordinate space to screen space
 	push_transform = glm::translate(push_transform, glm::vec3(-1.0f, -1.0f, 0.0f));
@@ -565,15 +768,18 @@ void Gui::draw(CommandBuffer &command_buffer)
 	// If a render context is used, then use the frames buffer pools to allocate GUI vertex/index data from
 	if (!explicit_update)
 	{
-		update_buffers(command_buffer, sample.get_render_context().get_active_frame());
+		if (!update_buffers(command_buffer, sample.get_render_context().get_active_frame()))
+		{
+			return;
+		}
 	}
 	else
 	{
 		std::vector<std::reference_wrapper<const vkb::core::Buffer>> buffers;
-		buffers.push_back(*vertex_buffer);
+		buffers.push_back(*vertex_buffers[0]);
 		command_buffer.bind_vertex_buffers(0, buffers, {0});
 
-		command_buffer.bind_index_buffer(*index_buffer, 0, VK_INDEX_TYPE_UINT16);
+		command_buffer.bind_index_buffer(*index_buffers[0], 0, VK_INDEX_TYPE_UINT16);
 	}
 
 	// Render commands
@@ -633,13 +839,19 @@ void Gui::draw(CommandBuffer &command_buffer)
 	}
 }
 
-void Gui::draw(VkCommandBuffer command_buffer)
+void Gui::draw(VkCommandBuffer command_buffer, uint32_t frame_index)
 {
 	if (!visible)
 	{
 		return;
 	}
 
+	// A frame that has not updated its buffers yet has nothing to draw, it records again once it has
+	if (frame_index >= vertex_buffers.size() || !vertex_buffers[frame_index] || !index_buffers[frame_index])
+	{
+		return;
+	}
+
 	auto &      io            = ImGui::GetIO();
 	ImDrawData *draw_data     = ImGui::GetDrawData();
 	int32_t     vertex_offset = 0;
@@ -661,10 +873,10 @@ void Gui::draw(VkCommandBuffer command_buffer)
 
 	VkDeviceSize offsets[1] = {0};
 
-	VkBuffer vertex_buffer_handle = vertex_buffer->get_handle();
+	VkBuffer vertex_buffer_handle = vertex_buffers[frame_index]->get_handle();
 	vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_buffer_handle, offsets);
 
-	VkBuffer index_buffer_handle = index_buffer->get_handle();
+	VkBuffer index_buffer_handle = index_buffers[frame_index]->get_handle();
 	vkCmdBindIndexBuffer(command_buffer, index_buffer_handle, 0, VK_INDEX_TYPE_UINT16);
 
 	for (int32_t i = 0; i < draw_data->CmdListsCount; i++)
@@ -902,8 +1114,16 @@ void Gui::show_debug_window(DebugInfo &debug_info, const ImVec2 &position)
 
 void Gui::show_stats(const Stats &stats)
 {
+	const auto &breakdown_stats = FrameBreakdownStatsProvider::get_breakdown_stats();
+
 	for (const auto &stat_index : stats.get_requested_stats())
 	{
+		// The frame time breakdown is drawn as a single graph below
+		if (std::find(breakdown_stats.begin(), breakdown_stats.end(), stat_index) != breakdown_stats.end())
+		{
+			continue;
+		}
+
 		// Find the graph data of this stat index
 		auto pr = stats_view.graph_map.find(stat_index);
 
@@ -945,6 +1165,135 @@ void Gui::show_stats(const Stats &stats)
 			ImGui::Text("%s", graph_label.str().c_str());
 		}
 	}
+
+	show_frame_breakdown(stats);
+
+	// Vulkan performance counters selected by name, as of the last frame that collected them
+	for (const auto &counter : stats.get_vulkan_counters())
+	{
+		if (counter.has_value)
+		{
+			ImGui::Text("%s: %.0f %s", counter.name.c_str(), counter.value, counter.unit.c_str());
+		}
+	}
+
+	// GPU time of the scopes of the frame, indented by nesting
+	for (const auto &timing : stats.get_gpu_profiler().get_timings())
+	{
+		ImGui::Text("%*s%s: %.3f ms", static_cast<int>(timing.depth * 2), "", timing.name.c_str(), timing.gpu_time_ms);
+	}
+}
+
+void Gui::show_frame_breakdown(const Stats &stats)
+{
+	static const ImU32 part_colors[] = {IM_COL32(150, 150, 150, 255),
+	                                    IM_COL32(90, 160, 230, 255),
+	                                    IM_COL32(230, 90, 90, 255),
+	                                    IM_COL32(110, 200, 110, 255),
+	                                    IM_COL32(230, 200, 80, 255),
+	                                    IM_COL32(190, 110, 220, 255)};
+	static const ImU32 gpu_color     = IM_COL32(255, 255, 255, 255);
+
+	std::vector<StatIndex> parts;
+	bool                   has_gpu_time = false;
+
+	for (auto stat_index : FrameBreakdownStatsProvider::get_breakdown_stats())
+	{
+		if (!stats.get_requested_stats().count(stat_index) || !stats.is_available(stat_index))
+		{
+			continue;
+		}
+
+		if (stat_index == StatIndex::frame_gpu_time)
+		{
+			has_gpu_time = true;
+		}
+		else
+		{
+			parts.push_back(stat_index);
+		}
+	}
+
+	if (parts.empty() && !has_gpu_time)
+	{
+		return;
+	}
+
+	size_t sample_count = stats.get_data(parts.empty() ? StatIndex::frame_gpu_time : parts.front()).size();
+	if (sample_count < 2)
+	{
+		return;
+	}
+
+	// Scale to the highest stack or GPU time in the buffers
+	float graph_max = 0.0f;
+	for (size_t i = 0; i < sample_count; ++i)
+	{
+		float total = 0.0f;
+		for (auto part : parts)
+		{
+			total += stats.get_data(part)[i];
+		}
+		graph_max = std::max(graph_max, total);
+
+		if (has_gpu_time)
+		{
+			graph_max = std::max(graph_max, stats.get_data(StatIndex::frame_gpu_time)[i]);
+		}
+	}
+	graph_max = std::max(graph_max * stats_view.top_padding, 1e-6f);
+
+	const ImVec2 graph_size = ImVec2{
+	    ImGui::GetIO().DisplaySize.x,
+	    stats_view.graph_height /* dpi */ * dpi_factor};
+
+	ImVec2      origin    = ImGui::GetCursorScreenPos();
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	float       step      = graph_size.x / static_cast<float>(sample_count - 1);
+
+	auto to_y = [&](float value) { return origin.y + graph_size.y * (1.0f - value / graph_max); };
+
+	for (size_t i = 0; i + 1 < sample_count; ++i)
+	{
+		float x0 = origin.x + step * static_cast<float>(i);
+		float x1 = x0 + step;
+
+		float bottom = 0.0f;
+		for (size_t p = 0; p < parts.size(); ++p)
+		{
+			float top = bottom + stats.get_data(parts[p])[i];
+			draw_list->AddRectFilled(ImVec2{x0, to_y(top)}, ImVec2{x1, to_y(bottom)}, part_colors[p % IM_ARRAYSIZE(part_colors)]);
+			bottom = top;
+		}
+
+		if (has_gpu_time)
+		{
+			const auto &gpu_times = stats.get_data(StatIndex::frame_gpu_time);
+			draw_list->AddLine(ImVec2{x0, to_y(gpu_times[i])}, ImVec2{x1, to_y(gpu_times[i + 1])}, gpu_color, 2.0f);
+		}
+	}
+
+	ImGui::Dummy(graph_size);
+
+	// Legend with the average of each part
+	auto show_legend = [&](StatIndex stat_index, ImU32 color) {
+		const auto &graph_data = stats.get_graph_data(stat_index);
+		const auto &values     = stats.get_data(stat_index);
+		float       avg        = std::accumulate(values.begin(), values.end(), 0.0f) / values.size();
+
+		ImGui::SameLine();
+		ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(color), "%s", fmt::format(graph_data.name + ": " + graph_data.format, avg * graph_data.scale_factor).c_str());
+	};
+
+	ImGui::Text("Frame:");
+	for (size_t p = 0; p < parts.size(); ++p)
+	{
+		show_legend(parts[p], part_colors[p % IM_ARRAYSIZE(part_colors)]);
+	}
+	if (has_gpu_time)
+	{
+		show_legend(StatIndex::frame_gpu_time, gpu_color);
+	}
 }
 
 void Gui::show_options_window(std::function<void()> body, const uint32_t lines)
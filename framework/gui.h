@@ -271,7 +271,12 @@ class Gui
 	 */
 	void update(const float delta_time);
 
-	bool update_buffers();
+	/**
+	 * @brief Copies the draw lists to the buffers of a GUI updated explicitly
+	 * @param frame_index Index of the frame whose buffers are written, the GPU must no longer be reading them
+	 * @return True if the draw counts changed or the buffers were recreated, so the command buffers drawing the GUI must be recorded again
+	 */
+	bool update_buffers(uint32_t frame_index = 0);
 
 	/**
 	 * @brief Draws the Gui
@@ -282,8 +287,9 @@ class Gui
 	/**
 	 * @brief Draws the Gui
 	 * @param command_buffer Command buffer to register draw-commands
+	 * @param frame_index Index of the frame whose buffers are drawn, see update_buffers(uint32_t)
 	 */
-	void draw(VkCommandBuffer command_buffer);
+	void draw(VkCommandBuffer command_buffer, uint32_t frame_index = 0);
 
 	/**
 	 * @brief Shows an overlay top window with app info and maybe stats
@@ -317,6 +323,12 @@ class Gui
 	 */
 	void show_stats(const Stats &stats);
 
+	/**
+	 * @brief Shows the CPU parts of the frame time stacked in one graph, with the GPU time as a line over them
+	 * @param stats Statistics to show
+	 */
+	void show_frame_breakdown(const Stats &stats);
+
 	/**
 	 * @brief Shows an options windows, to be filled by the sample,
 	 *        which will be positioned at the top
@@ -348,10 +360,11 @@ class Gui
 	static constexpr uint32_t BUFFER_POOL_BLOCK_SIZE = 256;
 
 	/**
-	 * @brief Updates Vulkan buffers
+	 * @brief Allocates the geometry of the frame from its buffers, and binds it
 	 * @param frame Frame to render into
+	 * @return False if there is nothing to draw
 	 */
-	void update_buffers(CommandBuffer &command_buffer, RenderFrame &render_frame);
+	bool update_buffers(CommandBuffer &command_buffer, RenderFrame &render_frame);
 
 	static const double press_time_ms;
 
@@ -365,13 +378,14 @@ class Gui
 
 	VulkanSample &sample;
 
-	std::unique_ptr<core::Buffer> vertex_buffer;
+	/// Geometry of a GUI updated explicitly, one buffer per frame that can be in flight
+	std::vector<std::unique_ptr<core::Buffer>> vertex_buffers;
 
-	std::unique_ptr<core::Buffer> index_buffer;
+	std::vector<std::unique_ptr<core::Buffer>> index_buffers;
 
-	size_t last_vertex_buffer_size;
+	size_t last_vertex_buffer_size{0};
 
-	size_t last_index_buffer_size;
+	size_t last_index_buffer_size{0};
 
 	///  Scale factor to apply due to a difference between the window and GL pixel sizes
 	float content_scale_factor{1.0f};
@@ -388,7 +402,7 @@ class Gui
 	std::unique_ptr<core::Image>     font_image;
 	std::unique_ptr<core::ImageView> font_image_view;
 
-	std::unique_ptr<core::Sampler> sampler{nullptr};
+	const core::Sampler *sampler{nullptr};
 
 	PipelineLayout *pipeline_layout{nullptr};
 
@@ -17,53 +17,316 @@
 
 #include "heightmap.h"
 
+#include <algorithm>
 #include <cstring>
-#include <ktx.h>
-
-#include "common/error.h"
-
-VKBP_DISABLE_WARNINGS()
-#include "common/glm_common.h"
-VKBP_ENABLE_WARNINGS()
+#include <stdexcept>
 
 #include "platform/filesystem.h"
 
 namespace vkb
 {
-HeightMap::HeightMap(const std::string &file_name, const uint32_t patchsize)
+namespace
+{
+const uint8_t KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+constexpr uint32_t KTX_ENDIANNESS = 0x04030201;
+
+/// KTX 1 file header, followed by the key value data and the image of each level prefixed by its size
+struct KtxHeader
+{
+	uint8_t  identifier[12];
+	uint32_t endianness;
+	uint32_t gl_type;
+	uint32_t gl_type_size;
+	uint32_t gl_format;
+	uint32_t gl_internal_format;
+	uint32_t gl_base_internal_format;
+	uint32_t pixel_width;
+	uint32_t pixel_height;
+	uint32_t pixel_depth;
+	uint32_t array_element_count;
+	uint32_t face_count;
+	uint32_t mip_level_count;
+	uint32_t key_value_size;
+};
+
+uint32_t floor_log2(uint32_t value)
 {
-	std::string file_path = fs::path::get(fs::path::Assets, file_name);
+	uint32_t result = 0;
+	while (value > 1)
+	{
+		value >>= 1;
+		++result;
+	}
+	return result;
+}
+
+/**
+ * @brief Applies mirrored repeat addressing to a texel coordinate
+ */
+int32_t mirror(int32_t coordinate, int32_t size)
+{
+	int32_t period = 2 * size;
+
+	coordinate %= period;
+	if (coordinate < 0)
+	{
+		coordinate += period;
+	}
+
+	return coordinate < size ? coordinate : period - 1 - coordinate;
+}
+}        // namespace
+
+constexpr uint32_t HeightMap::TILE_SIZE;
+
+HeightMap::HeightMap(const std::string &file_name, const uint32_t patchsize) :
+    file{std::make_unique<fs::MappedFile>(fs::map_asset(file_name))}
+{
+	const uint8_t *bytes = file->data();
+
+	KtxHeader header;
+	if (file->size() < sizeof(KtxHeader))
+	{
+		throw std::runtime_error("Heightmap is not a ktx file: " + file_name);
+	}
+	std::memcpy(&header, bytes, sizeof(KtxHeader));
+
+	if (std::memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 || header.endianness != KTX_ENDIANNESS)
+	{
+		throw std::runtime_error("Heightmap is not a ktx file: " + file_name);
+	}
 
-	ktxTexture *ktx_texture;
-	ktxResult   ktx_result;
-	ktx_result = ktxTexture_CreateFromNamedFile(file_path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktx_texture);
+	if (header.gl_type_size != sizeof(uint16_t) || header.pixel_width == 0 || header.pixel_width != header.pixel_height)
+	{
+		throw std::runtime_error("Heightmap is not a square 16-bit texture: " + file_name);
+	}
 
-	assert(ktx_result == KTX_SUCCESS);
+	dim = header.pixel_width;
 
-	ktx_size_t   ktx_size  = ktxTexture_GetImageSize(ktx_texture, 0);
-	ktx_uint8_t *ktx_image = ktxTexture_GetData(ktx_texture);
+	// The first level starts after its size
+	size_t image_offset = sizeof(KtxHeader) + header.key_value_size + sizeof(uint32_t);
+	if (image_offset + static_cast<size_t>(dim) * dim * sizeof(uint16_t) > file->size())
+	{
+		throw std::runtime_error("Heightmap is truncated: " + file_name);
+	}
 
-	dim  = ktx_texture->baseWidth;
-	data = new uint16_t[dim * dim];
+	data = reinterpret_cast<const uint16_t *>(bytes + image_offset);
 
-	memcpy(data, ktx_image, ktx_size);
+	this->scale = std::max(dim / patchsize, 1u);
 
-	this->scale = dim / patchsize;
+	patch_level = floor_log2(scale);
 
-	ktxTexture_Destroy(ktx_texture);
+	build_pyramid();
 }
 
-HeightMap::~HeightMap()
+HeightMap::~HeightMap() = default;
+
+void HeightMap::build_pyramid()
 {
-	delete[] data;
+	Level tiles;
+	tiles.dim = (dim + TILE_SIZE - 1) / TILE_SIZE;
+	tiles.texels.resize(static_cast<size_t>(tiles.dim) * tiles.dim);
+
+	for (uint32_t tile_y = 0; tile_y < tiles.dim; ++tile_y)
+	{
+		for (uint32_t tile_x = 0; tile_x < tiles.dim; ++tile_x)
+		{
+			uint32_t last_x = std::min((tile_x + 1) * TILE_SIZE, dim);
+			uint32_t last_y = std::min((tile_y + 1) * TILE_SIZE, dim);
+
+			uint32_t sum   = 0;
+			uint32_t count = 0;
+			Texel    texel{0, 0xFFFF, 0};
+
+			for (uint32_t y = tile_y * TILE_SIZE; y < last_y; ++y)
+			{
+				for (uint32_t x = tile_x * TILE_SIZE; x < last_x; ++x)
+				{
+					uint16_t height = data[x + static_cast<size_t>(y) * dim];
+
+					sum += height;
+					++count;
+					texel.min = std::min(texel.min, height);
+					texel.max = std::max(texel.max, height);
+				}
+			}
+
+			texel.mean = static_cast<uint16_t>(sum / count);
+
+			tiles.texels[tile_x + tile_y * tiles.dim] = texel;
+		}
+	}
+
+	pyramid.push_back(std::move(tiles));
+
+	// Each coarser level summarizes 2x2 texels of the previous one
+	while (pyramid.back().dim > 1)
+	{
+		const Level &fine = pyramid.back();
+
+		Level coarse;
+		coarse.dim = (fine.dim + 1) / 2;
+		coarse.texels.resize(static_cast<size_t>(coarse.dim) * coarse.dim);
+
+		for (uint32_t y = 0; y < coarse.dim; ++y)
+		{
+			for (uint32_t x = 0; x < coarse.dim; ++x)
+			{
+				uint32_t sum   = 0;
+				uint32_t count = 0;
+				Texel    texel{0, 0xFFFF, 0};
+
+				for (uint32_t fine_y = 2 * y; fine_y < std::min(2 * y + 2, fine.dim); ++fine_y)
+				{
+					for (uint32_t fine_x = 2 * x; fine_x < std::min(2 * x + 2, fine.dim); ++fine_x)
+					{
+						const Texel &fine_texel = fine.texels[fine_x + fine_y * fine.dim];
+
+						sum += fine_texel.mean;
+						++count;
+						texel.min = std::min(texel.min, fine_texel.min);
+						texel.max = std::max(texel.max, fine_texel.max);
+					}
+				}
+
+				texel.mean = static_cast<uint16_t>(sum / count);
+
+				coarse.texels[x + y * coarse.dim] = texel;
+			}
+		}
+
+		pyramid.push_back(std::move(coarse));
+	}
 }
 
-float HeightMap::get_height(const uint32_t x, const uint32_t y)
+float HeightMap::get_height(const int32_t x, const int32_t y) const
 {
-	glm::ivec2 rpos = glm::ivec2(x, y) * glm::ivec2(scale);
-	rpos.x          = std::max(0, std::min(rpos.x, (int) dim - 1));
-	rpos.y          = std::max(0, std::min(rpos.y, (int) dim - 1));
-	rpos /= glm::ivec2(scale);
-	return *(data + (rpos.x + rpos.y * dim) * scale) / 65535.0f;
+	// Patch coordinates are texels of the patch level, the vertices sit on their corners
+	return sample(glm::vec2(x, y) * (static_cast<float>(scale) / dim), patch_level);
+}
+
+void HeightMap::get_height_range(const uint32_t x, const uint32_t y, float &min, float &max) const
+{
+	glm::uvec2 first{std::min(x * scale, dim - 1), std::min(y * scale, dim - 1)};
+	glm::uvec2 last{std::min((x + 1) * scale, dim - 1), std::min((y + 1) * scale, dim - 1)};
+
+	uint16_t lowest;
+	uint16_t highest;
+	get_texel_range(first, last, lowest, highest);
+
+	min = lowest / 65535.0f;
+	max = highest / 65535.0f;
+}
+
+float HeightMap::sample(const glm::vec2 &uv, const uint32_t level) const
+{
+	uint32_t sampled_level = std::min(level, floor_log2(TILE_SIZE) + static_cast<uint32_t>(pyramid.size()) - 1);
+	uint32_t level_dim     = std::max((dim + (1u << sampled_level) - 1) >> sampled_level, 1u);
+
+	glm::vec2 texel  = uv * static_cast<float>(level_dim) - 0.5f;
+	glm::vec2 base   = glm::floor(texel);
+	glm::vec2 weight = texel - base;
+
+	int32_t x = static_cast<int32_t>(base.x);
+	int32_t y = static_cast<int32_t>(base.y);
+
+	float top    = glm::mix(get_texel(sampled_level, x, y), get_texel(sampled_level, x + 1, y), weight.x);
+	float bottom = glm::mix(get_texel(sampled_level, x, y + 1), get_texel(sampled_level, x + 1, y + 1), weight.x);
+
+	return glm::mix(top, bottom, weight.y);
+}
+
+void HeightMap::sample(const glm::vec2 *uvs, size_t count, float *heights, const uint32_t level) const
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		heights[i] = sample(uvs[i], level);
+	}
+}
+
+float HeightMap::get_texel(uint32_t level, int32_t x, int32_t y) const
+{
+	uint32_t tile_level = floor_log2(TILE_SIZE);
+
+	if (level >= tile_level)
+	{
+		const Level &mip = pyramid[level - tile_level];
+
+		x = mirror(x, static_cast<int32_t>(mip.dim));
+		y = mirror(y, static_cast<int32_t>(mip.dim));
+
+		return mip.texels[x + y * mip.dim].mean / 65535.0f;
+	}
+
+	// Levels finer than the tiles are box filtered from the full resolution
+	int32_t level_dim = std::max((dim + (1u << level) - 1) >> level, 1u);
+
+	uint32_t first_x = mirror(x, level_dim) << level;
+	uint32_t first_y = mirror(y, level_dim) << level;
+	uint32_t last_x  = std::min(first_x + (1u << level), dim);
+	uint32_t last_y  = std::min(first_y + (1u << level), dim);
+
+	uint32_t sum = 0;
+	for (uint32_t texel_y = first_y; texel_y < last_y; ++texel_y)
+	{
+		for (uint32_t texel_x = first_x; texel_x < last_x; ++texel_x)
+		{
+			sum += data[texel_x + static_cast<size_t>(texel_y) * dim];
+		}
+	}
+
+	return sum / static_cast<float>((last_x - first_x) * (last_y - first_y)) / 65535.0f;
+}
+
+void HeightMap::get_texel_range(glm::uvec2 first, glm::uvec2 last, uint16_t &min, uint16_t &max) const
+{
+	min = 0xFFFF;
+	max = 0;
+
+	// The tiles fully inside the range are read from their summaries
+	glm::uvec2 first_tile = (first + TILE_SIZE - 1u) / TILE_SIZE;
+	glm::uvec2 end_tile   = (last + 1u) / TILE_SIZE;
+
+	bool has_tiles = first_tile.x < end_tile.x && first_tile.y < end_tile.y;
+
+	if (has_tiles)
+	{
+		const Level &tiles = pyramid.front();
+
+		for (uint32_t tile_y = first_tile.y; tile_y < end_tile.y; ++tile_y)
+		{
+			for (uint32_t tile_x = first_tile.x; tile_x < end_tile.x; ++tile_x)
+			{
+				const Texel &texel = tiles.texels[tile_x + tile_y * tiles.dim];
+
+				min = std::min(min, texel.min);
+				max = std::max(max, texel.max);
+			}
+		}
+	}
+
+	glm::uvec2 inner_first = first_tile * TILE_SIZE;
+	glm::uvec2 inner_last  = end_tile * TILE_SIZE - 1u;
+
+	// The texels around the tiles are read at full resolution
+	for (uint32_t y = first.y; y <= last.y; ++y)
+	{
+		const uint16_t *row = data + static_cast<size_t>(y) * dim;
+
+		bool crosses_tiles = has_tiles && y >= inner_first.y && y <= inner_last.y;
+
+		for (uint32_t x = first.x; x <= last.x; ++x)
+		{
+			if (crosses_tiles && x == inner_first.x)
+			{
+				x = inner_last.x;
+				continue;
+			}
+
+			min = std::min(min, row[x]);
+			max = std::max(max, row[x]);
+		}
+	}
 }
 }        // namespace vkb
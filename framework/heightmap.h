@@ -17,38 +17,119 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+namespace fs
+{
+class MappedFile;
+}
+
 /**
  * @brief Class representing a heightmap loaded from a ktx texture
+ *
+ * The texture is mapped in memory rather than loaded, so the full resolution heights are paged in by the OS
+ * as they are accessed. Summaries of tiles of texels form a mip pyramid kept in memory for coarse queries.
  */
 class HeightMap
 {
   public:
+	/// Texels per side of the tiles summarized by the first level of the pyramid
+	static constexpr uint32_t TILE_SIZE = 16;
+
 	/**
-	 * @brief Loads in a ktx texture as a heightmap
+	 * @brief Maps a 16-bit single channel ktx texture as a heightmap
 	 * @param filename The ktx file to load
 	 * @param patchsize The patch size
+	 * @throws runtime_error if the file is not a square 16-bit ktx texture
 	 */
 	HeightMap(const std::string &filename, const uint32_t patchsize);
 
 	~HeightMap();
 
 	/**
-	 * @brief Retrieves a value from the heightmap at a specific coordinates
+	 * @brief Retrieves the height at patch coordinates, filtered from the mip level matching the patch size
+	 *        Coordinates outside of the heightmap are mirrored, as the terrain sampler does.
 	 * @param x The x coordinate
 	 * @param y The y coordinate
 	 * @returns A float height value
 	 */
-	float get_height(const uint32_t x, const uint32_t y);
+	float get_height(const int32_t x, const int32_t y) const;
+
+	/**
+	 * @brief Retrieves the range of heights over a patch, at the full resolution of the heightmap
+	 * @param x The x coordinate of the first corner of the patch
+	 * @param y The y coordinate of the first corner of the patch
+	 * @param min The lowest height over the patch
+	 * @param max The highest height over the patch
+	 */
+	void get_height_range(const uint32_t x, const uint32_t y, float &min, float &max) const;
+
+	/**
+	 * @brief Samples the heightmap with bilinear filtering and mirrored repeat addressing
+	 * @param uv The texture coordinates
+	 * @param level The mip level, levels finer than the tiles are box filtered from the full resolution
+	 * @returns A float height value
+	 */
+	float sample(const glm::vec2 &uv, const uint32_t level = 0) const;
+
+	/**
+	 * @brief Samples the heightmap at several texture coordinates, see sample()
+	 */
+	void sample(const glm::vec2 *uvs, size_t count, float *heights, const uint32_t level = 0) const;
 
   private:
-	uint16_t *data;
+	/// Summary of a block of texels at one level of the pyramid
+	struct Texel
+	{
+		uint16_t mean;
+
+		uint16_t min;
+
+		uint16_t max;
+	};
+
+	struct Level
+	{
+		uint32_t dim;
+
+		std::vector<Texel> texels;
+	};
+
+	/**
+	 * @brief Fetches a texel of a level, with mirrored repeat addressing
+	 */
+	float get_texel(uint32_t level, int32_t x, int32_t y) const;
+
+	/**
+	 * @brief Finds the range of the full resolution texels in [first, last], summarized tiles are read at once
+	 */
+	void get_texel_range(glm::uvec2 first, glm::uvec2 last, uint16_t &min, uint16_t &max) const;
+
+	void build_pyramid();
+
+	std::unique_ptr<fs::MappedFile> file;
+
+	/// The full resolution heights, inside the mapped file
+	const uint16_t *data{nullptr};
 
 	uint32_t dim;
 
 	uint32_t scale;
+
+	/// Mip level of a texel per patch
+	uint32_t patch_level{0};
+
+	/// Levels from the tiles up to a single texel, the first one is at log2(TILE_SIZE)
+	std::vector<Level> pyramid;
 };
 }        // namespace vkb
@@ -0,0 +1,324 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "job_system.h"
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+thread_local size_t job_thread_index{0};
+
+thread_local const JobSystem *job_thread_owner{nullptr};
+}        // namespace
+
+JobSystem::TaskGroup::TaskGroup(JobSystem &job_system) :
+    job_system{job_system}
+{
+}
+
+JobSystem::TaskGroup::~TaskGroup()
+{
+	wait();
+}
+
+void JobSystem::TaskGroup::run(Job job)
+{
+	++pending_jobs;
+
+	job_system.push({std::move(job), this});
+}
+
+void JobSystem::TaskGroup::then(Job continuation, TaskGroup *next_group)
+{
+	if (next_group)
+	{
+		++next_group->pending_jobs;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{continuation_mutex};
+
+		if (pending_jobs > 0)
+		{
+			continuations.push_back({std::move(continuation), next_group});
+			return;
+		}
+	}
+
+	// Every job has already finished
+	job_system.push({std::move(continuation), next_group});
+}
+
+void JobSystem::TaskGroup::wait()
+{
+	auto thread_index = job_thread_owner == &job_system ? job_thread_index : 0;
+
+	while (pending_jobs > 0)
+	{
+		if (!job_system.run_one(thread_index))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The last job may still be releasing the lock, the group must outlive it
+	std::lock_guard<std::mutex> lock{continuation_mutex};
+}
+
+bool JobSystem::TaskGroup::is_done() const
+{
+	return pending_jobs == 0;
+}
+
+void JobSystem::TaskGroup::finish()
+{
+	// The group may be destroyed as soon as the lock is released
+	auto &system = job_system;
+
+	std::vector<Continuation> ready_continuations;
+
+	{
+		// Decrementing under the lock lets then() know whether it can still defer the continuation
+		std::lock_guard<std::mutex> lock{continuation_mutex};
+
+		if (--pending_jobs == 0)
+		{
+			ready_continuations = std::move(continuations);
+			continuations.clear();
+		}
+	}
+
+	for (auto &continuation : ready_continuations)
+	{
+		system.push({std::move(continuation.job), continuation.group});
+	}
+}
+
+JobSystem::JobSystem(size_t worker_count, std::function<void(size_t)> thread_init) :
+    thread_init{std::move(thread_init)}
+{
+	for (size_t i = 0; i < worker_count + 1; ++i)
+	{
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	worker_cpu_timers.resize(worker_count);
+
+	for (size_t i = 1; i < worker_count + 1; ++i)
+	{
+		workers.emplace_back(&JobSystem::worker_loop, this, i);
+	}
+
+	// The timers are created by the workers they measure
+	{
+		std::unique_lock<std::mutex> lock{sleep_mutex};
+		start_condition.wait(lock, [this, worker_count]() { return started_workers == worker_count; });
+	}
+
+	LOGI("Job system started with {} worker threads", worker_count);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{sleep_mutex};
+		running = false;
+	}
+
+	wake_condition.notify_all();
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+size_t JobSystem::get_default_worker_count()
+{
+	auto hardware_threads = std::thread::hardware_concurrency();
+
+	return hardware_threads > 1 ? hardware_threads - 1 : 1;
+}
+
+size_t JobSystem::get_thread_count() const
+{
+	return queues.size();
+}
+
+size_t JobSystem::get_thread_index()
+{
+	return job_thread_index;
+}
+
+const std::vector<std::unique_ptr<ThreadCpuTimer>> &JobSystem::get_worker_cpu_timers() const
+{
+	return worker_cpu_timers;
+}
+
+void JobSystem::parallel_for(uint32_t begin, uint32_t end, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &func)
+{
+	assert(grain_size > 0 && "Grain size should not be zero");
+
+	TaskGroup group{*this};
+
+	for (uint32_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain_size)
+	{
+		auto chunk_end = std::min(end, chunk_begin + grain_size);
+
+		group.run([&func, chunk_begin, chunk_end]() { func(chunk_begin, chunk_end); });
+	}
+
+	group.wait();
+}
+
+void JobSystem::push(Task &&task)
+{
+	size_t queue_index;
+
+	if (job_thread_owner == this)
+	{
+		// Workers keep their jobs local, other threads steal them if idle
+		queue_index = job_thread_index;
+	}
+	else if (workers.empty())
+	{
+		queue_index = 0;
+	}
+	else
+	{
+		queue_index = 1 + next_queue++ % workers.size();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{queues[queue_index]->mutex};
+		queues[queue_index]->tasks.push_back(std::move(task));
+	}
+
+	++queued_jobs;
+
+	{
+		// Synchronizes with a worker about to sleep, so the notification is not lost
+		std::lock_guard<std::mutex> lock{sleep_mutex};
+	}
+
+	wake_condition.notify_one();
+}
+
+bool JobSystem::run_one(size_t thread_index)
+{
+	Task task;
+
+	if (pop(thread_index, task) || steal(thread_index, task))
+	{
+		execute(task);
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::pop(size_t queue_index, Task &task)
+{
+	auto &queue = *queues[queue_index];
+
+	std::lock_guard<std::mutex> lock{queue.mutex};
+
+	if (queue.tasks.empty())
+	{
+		return false;
+	}
+
+	// The most recent job is the most likely to have its data in cache
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+
+	--queued_jobs;
+
+	return true;
+}
+
+bool JobSystem::steal(size_t thief_index, Task &task)
+{
+	for (size_t i = 1; i < queues.size(); ++i)
+	{
+		auto &queue = *queues[(thief_index + i) % queues.size()];
+
+		std::lock_guard<std::mutex> lock{queue.mutex};
+
+		if (!queue.tasks.empty())
+		{
+			// Steal the oldest job, which tends to be the largest one left
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+
+			--queued_jobs;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Task &task)
+{
+	try
+	{
+		task.job();
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Job failed: {}", e.what());
+	}
+
+	if (task.group)
+	{
+		task.group->finish();
+	}
+}
+
+void JobSystem::worker_loop(size_t thread_index)
+{
+	job_thread_index = thread_index;
+	job_thread_owner = this;
+
+	{
+		std::lock_guard<std::mutex> lock{sleep_mutex};
+		worker_cpu_timers[thread_index - 1] = std::make_unique<ThreadCpuTimer>();
+		++started_workers;
+	}
+
+	start_condition.notify_one();
+
+	if (thread_init)
+	{
+		thread_init(thread_index);
+	}
+
+	while (running)
+	{
+		if (!run_one(thread_index))
+		{
+			std::unique_lock<std::mutex> lock{sleep_mutex};
+			wake_condition.wait(lock, [this]() { return !running || queued_jobs > 0; });
+		}
+	}
+}
+}        // namespace vkb
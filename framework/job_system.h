@@ -0,0 +1,204 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "common/helpers.h"
+#include "stats/thread_cpu_timer.h"
+
+namespace vkb
+{
+/**
+ * @brief A work-stealing job system shared by the framework
+ *
+ * Each thread owns a deque of jobs: it pushes and pops its own jobs at the back, while
+ * idle threads steal from the front of the others. Jobs are submitted through a TaskGroup,
+ * which can be waited on or continued with another job.
+ *
+ * Thread index 0 is any thread which is not a worker, usually the main thread, while the
+ * workers have indices from 1 to get_thread_count() - 1. The thread indices line up with
+ * the RenderFrame thread indices, so a RenderContext prepared with get_thread_count()
+ * threads provides per-thread resources to every job.
+ */
+class JobSystem
+{
+  public:
+	using Job = std::function<void()>;
+
+	/**
+	 * @brief A set of jobs which can be waited on as a whole
+	 */
+	class TaskGroup
+	{
+	  public:
+		TaskGroup(JobSystem &job_system);
+
+		TaskGroup(const TaskGroup &) = delete;
+
+		TaskGroup(TaskGroup &&) = delete;
+
+		/**
+		 * @brief Waits for the jobs of the group
+		 */
+		~TaskGroup();
+
+		TaskGroup &operator=(const TaskGroup &) = delete;
+
+		TaskGroup &operator=(TaskGroup &&) = delete;
+
+		void run(Job job);
+
+		/**
+		 * @brief Runs a job once every job of the group has finished
+		 * @param continuation The job to run
+		 * @param next_group Optional group the continuation is accounted in, so it can be waited on
+		 */
+		void then(Job continuation, TaskGroup *next_group = nullptr);
+
+		/**
+		 * @brief Waits for the jobs of the group, running queued jobs meanwhile
+		 */
+		void wait();
+
+		bool is_done() const;
+
+	  private:
+		friend class JobSystem;
+
+		struct Continuation
+		{
+			Job job;
+
+			TaskGroup *group;
+		};
+
+		/// Called when a job of the group has finished
+		void finish();
+
+		JobSystem &job_system;
+
+		std::atomic<uint32_t> pending_jobs{0};
+
+		std::mutex continuation_mutex;
+
+		std::vector<Continuation> continuations;
+	};
+
+	/**
+	 * @param worker_count Number of worker threads, by default one less than the hardware threads
+	 * @param thread_init Called by each worker with its thread index before running any job
+	 */
+	JobSystem(size_t worker_count = get_default_worker_count(), std::function<void(size_t)> thread_init = {});
+
+	JobSystem(const JobSystem &) = delete;
+
+	JobSystem(JobSystem &&) = delete;
+
+	~JobSystem();
+
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	JobSystem &operator=(JobSystem &&) = delete;
+
+	static size_t get_default_worker_count();
+
+	/**
+	 * @return The number of threads which may run jobs, including thread index 0
+	 */
+	size_t get_thread_count() const;
+
+	/**
+	 * @return The index of the calling thread, 0 if it is not a worker of a job system
+	 */
+	static size_t get_thread_index();
+
+	/**
+	 * @return The CPU timers of the workers, the timer of thread index i at i - 1
+	 */
+	const std::vector<std::unique_ptr<ThreadCpuTimer>> &get_worker_cpu_timers() const;
+
+	/**
+	 * @brief Splits [begin, end) into chunks of at most grain_size elements and runs them in parallel
+	 *        Returns once every chunk has been processed.
+	 * @param func Called with the first and one past the last index of each chunk
+	 */
+	void parallel_for(uint32_t begin, uint32_t end, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &func);
+
+  private:
+	struct Task
+	{
+		Job job;
+
+		TaskGroup *group{nullptr};
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+
+		std::deque<Task> tasks;
+	};
+
+	void push(Task &&task);
+
+	/**
+	 * @brief Runs a job from the thread's own queue, or steals one from another queue
+	 * @return Whether a job was run
+	 */
+	bool run_one(size_t thread_index);
+
+	bool pop(size_t queue_index, Task &task);
+
+	bool steal(size_t thief_index, Task &task);
+
+	void execute(Task &task);
+
+	void worker_loop(size_t thread_index);
+
+	std::function<void(size_t)> thread_init;
+
+	/// One queue per thread index, queue 0 is shared by the threads which are not workers
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+
+	std::vector<std::thread> workers;
+
+	std::vector<std::unique_ptr<ThreadCpuTimer>> worker_cpu_timers;
+
+	/// Workers which created their CPU timer, the constructor waits for all of them
+	size_t started_workers{0};
+
+	std::condition_variable start_condition;
+
+	std::atomic<bool> running{true};
+
+	/// Jobs pushed and not yet popped, workers sleep while it is zero
+	std::atomic<size_t> queued_jobs{0};
+
+	/// Spreads the jobs submitted by non-worker threads across the workers
+	std::atomic<size_t> next_queue{0};
+
+	std::mutex sleep_mutex;
+
+	std::condition_variable wake_condition;
+};
+}        // namespace vkb
@@ -0,0 +1,238 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_defragmenter.h"
+
+#include <vector>
+
+#include "common/logging.h"
+#include "core/buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+float FragmentationStats::get_fragmentation() const
+{
+	if (unused_bytes == 0)
+	{
+		return 0.0f;
+	}
+
+	return 1.0f - static_cast<float>(largest_unused_range) / static_cast<float>(unused_bytes);
+}
+
+MemoryDefragmenter::MemoryDefragmenter(Device &device) :
+    device{device}
+{
+}
+
+void MemoryDefragmenter::add_buffer(core::Buffer &buffer)
+{
+	std::lock_guard<std::mutex> guard(buffers_mutex);
+
+	// A moved buffer replaces the entry of the one it was moved from
+	buffers[buffer.get_allocation()] = &buffer;
+
+	++buffers_revision;
+}
+
+void MemoryDefragmenter::remove_buffer(core::Buffer &buffer)
+{
+	std::lock_guard<std::mutex> guard(buffers_mutex);
+
+	auto it = buffers.find(buffer.get_allocation());
+
+	if (it != buffers.end() && it->second == &buffer)
+	{
+		buffers.erase(it);
+
+		++buffers_revision;
+	}
+}
+
+void MemoryDefragmenter::set_enabled(bool enabled)
+{
+	this->enabled = enabled;
+}
+
+bool MemoryDefragmenter::is_enabled() const
+{
+	return enabled;
+}
+
+void MemoryDefragmenter::set_threshold(float threshold)
+{
+	this->threshold = threshold;
+}
+
+float MemoryDefragmenter::get_threshold() const
+{
+	return threshold;
+}
+
+FragmentationStats MemoryDefragmenter::get_stats() const
+{
+	VmaStats stats{};
+	vmaCalculateStats(device.get_memory_allocator(), &stats);
+
+	FragmentationStats result;
+	result.used_bytes           = stats.total.usedBytes;
+	result.unused_bytes         = stats.total.unusedBytes;
+	result.largest_unused_range = stats.total.unusedRangeCount > 0 ? stats.total.unusedRangeSizeMax : 0;
+	result.block_count          = stats.total.blockCount;
+	result.allocation_count     = stats.total.allocationCount;
+	result.unused_range_count   = stats.total.unusedRangeCount;
+
+	return result;
+}
+
+bool MemoryDefragmenter::update()
+{
+	if (!enabled || ++update_count < CHECK_INTERVAL)
+	{
+		return false;
+	}
+
+	update_count = 0;
+
+	{
+		// The last pass could not move anything, and no buffer came or went since
+		std::lock_guard<std::mutex> guard(buffers_mutex);
+
+		if (buffers.empty() || settled_revision == buffers_revision)
+		{
+			return false;
+		}
+	}
+
+	auto before = get_stats();
+
+	if (before.get_fragmentation() <= threshold)
+	{
+		return false;
+	}
+
+	auto moved = defragment();
+
+	if (moved == 0)
+	{
+		return false;
+	}
+
+	auto after = get_stats();
+
+	LOGI("Defragmentation moved {} buffers: {} blocks, {} KiB unused in {} ranges, fragmentation {:.2f} -> {} blocks, {} KiB unused in {} ranges, fragmentation {:.2f}",
+	     moved,
+	     before.block_count, before.unused_bytes / 1024, before.unused_range_count, before.get_fragmentation(),
+	     after.block_count, after.unused_bytes / 1024, after.unused_range_count, after.get_fragmentation());
+
+	// Check again at the next interval, if there is more to move
+	update_count = CHECK_INTERVAL;
+
+	return true;
+}
+
+uint32_t MemoryDefragmenter::defragment()
+{
+	std::lock_guard<std::mutex> guard(buffers_mutex);
+
+	std::vector<VmaAllocation> allocations;
+	allocations.reserve(buffers.size());
+
+	for (auto &allocation_buffer : buffers)
+	{
+		allocations.push_back(allocation_buffer.first);
+	}
+
+	std::vector<VkBool32> allocations_changed(allocations.size(), VK_FALSE);
+
+	// The old ranges can be reused by the next allocations once the pass ends,
+	// the moved buffers must not be in use by any queue
+	device.wait_idle();
+
+	auto command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	// Makes the last writes to the buffers available to the copies
+	VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VmaDefragmentationInfo2 info{};
+	info.allocationCount         = to_u32(allocations.size());
+	info.pAllocations            = allocations.data();
+	info.pAllocationsChanged     = allocations_changed.data();
+	info.maxCpuBytesToMove       = 0;
+	info.maxCpuAllocationsToMove = 0;
+	info.maxGpuBytesToMove       = MAX_MOVE_SIZE;
+	info.maxGpuAllocationsToMove = MAX_MOVE_COUNT;
+	info.commandBuffer           = command_buffer;
+
+	VmaDefragmentationStats   stats{};
+	VmaDefragmentationContext context{VK_NULL_HANDLE};
+	auto                      result = vmaDefragmentationBegin(device.get_memory_allocator(), &info, &stats, &context);
+
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		device.flush_command_buffer(command_buffer, device.get_suitable_graphics_queue().get_handle());
+		throw VulkanException{result, "Cannot begin defragmentation"};
+	}
+
+	// Makes the copies visible to the next frames
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+	                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	device.flush_command_buffer(command_buffer, device.get_suitable_graphics_queue().get_handle());
+
+	VK_CHECK(vmaDefragmentationEnd(device.get_memory_allocator(), context));
+
+	if (stats.allocationsMoved == 0)
+	{
+		settled_revision = buffers_revision;
+		return 0;
+	}
+
+	// Binds new buffers to the moved allocations, then updates the descriptor sets bound to the old ones
+	std::unordered_map<VkBuffer, VkBuffer> moved_buffers;
+
+	for (size_t i = 0; i < allocations.size(); ++i)
+	{
+		if (allocations_changed[i])
+		{
+			auto &buffer = *buffers[allocations[i]];
+
+			auto old_handle = buffer.rebind();
+
+			moved_buffers.emplace(old_handle, buffer.get_handle());
+		}
+	}
+
+	device.get_resource_cache().update_descriptor_sets(moved_buffers);
+
+	for (auto &old_new : moved_buffers)
+	{
+		vkDestroyBuffer(device.get_handle(), old_new.first, nullptr);
+	}
+
+	return to_u32(moved_buffers.size());
+}
+}        // namespace vkb
@@ -0,0 +1,159 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+namespace core
+{
+class Buffer;
+}
+
+/**
+ * @brief Summary of how the device memory blocks of VMA are used
+ */
+struct FragmentationStats
+{
+	VkDeviceSize used_bytes{0};
+
+	VkDeviceSize unused_bytes{0};
+
+	/// Largest range of a block not used by any allocation
+	VkDeviceSize largest_unused_range{0};
+
+	uint32_t block_count{0};
+
+	uint32_t allocation_count{0};
+
+	uint32_t unused_range_count{0};
+
+	/**
+	 * @return Share of the unused bytes outside of the largest unused range, from 0 when the free
+	 *         memory is in one range to close to 1 when it is scattered in small ranges
+	 */
+	float get_fragmentation() const;
+};
+
+/**
+ * @brief Compacts the device memory blocks of VMA, moving the allocations of buffers a bit at a time
+ *
+ * Buffers in device local memory register themselves on creation, apart from those with their own
+ * device memory or a device address, which shaders may hold on to. When enabled, update() checks the
+ * fragmentation of the blocks every few calls, and above the threshold records the copies of a pass
+ * moving at most MAX_MOVE_SIZE bytes. The moved buffers are recreated at their new place, and the
+ * descriptor sets of the resource cache bound to them are updated.
+ *
+ * A pass waits for the device to be idle, as the old ranges are reused once it ends. Images are not
+ * moved, as the defragmentation of VMA does not support images with optimal tiling.
+ */
+class MemoryDefragmenter
+{
+  public:
+	/**
+	 * @brief Maximum number of bytes moved by a pass, so that it does not stall a frame for long
+	 */
+	static constexpr VkDeviceSize MAX_MOVE_SIZE = 32 * 1024 * 1024;
+
+	/**
+	 * @brief Maximum number of allocations moved by a pass
+	 */
+	static constexpr uint32_t MAX_MOVE_COUNT = 256;
+
+	/**
+	 * @brief Number of updates between two checks of the fragmentation, as calculating it walks all the allocations
+	 */
+	static constexpr uint32_t CHECK_INTERVAL = 60;
+
+	MemoryDefragmenter(Device &device);
+
+	MemoryDefragmenter(const MemoryDefragmenter &) = delete;
+
+	MemoryDefragmenter(MemoryDefragmenter &&) = delete;
+
+	~MemoryDefragmenter() = default;
+
+	MemoryDefragmenter &operator=(const MemoryDefragmenter &) = delete;
+
+	MemoryDefragmenter &operator=(MemoryDefragmenter &&) = delete;
+
+	/**
+	 * @brief Tracks a buffer which can be moved, called by the buffer itself
+	 */
+	void add_buffer(core::Buffer &buffer);
+
+	/**
+	 * @brief Stops tracking a buffer, before it is destroyed
+	 */
+	void remove_buffer(core::Buffer &buffer);
+
+	void set_enabled(bool enabled);
+
+	bool is_enabled() const;
+
+	/**
+	 * @param threshold Fragmentation above which update() moves allocations, see FragmentationStats::get_fragmentation()
+	 */
+	void set_threshold(float threshold);
+
+	float get_threshold() const;
+
+	/**
+	 * @return The current usage of the memory blocks of the allocator
+	 */
+	FragmentationStats get_stats() const;
+
+	/**
+	 * @brief Runs a defragmentation pass if enabled and the memory is fragmented, between two frames
+	 * @return Whether buffers were moved, so that recorded draws need to be invalidated
+	 */
+	bool update();
+
+  private:
+	/**
+	 * @brief Moves the tracked buffers within the limits of a pass
+	 * @return The number of buffers moved
+	 */
+	uint32_t defragment();
+
+	Device &device;
+
+	std::mutex buffers_mutex;
+
+	std::unordered_map<VmaAllocation, core::Buffer *> buffers;
+
+	/// Incremented when a buffer is added or removed, to find out whether a pass may move more
+	uint64_t buffers_revision{0};
+
+	/// Revision of the buffers when a pass last moved nothing
+	uint64_t settled_revision{~0ULL};
+
+	bool enabled{false};
+
+	float threshold{0.25f};
+
+	uint32_t update_count{0};
+};
+}        // namespace vkb
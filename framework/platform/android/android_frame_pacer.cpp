@@ -0,0 +1,316 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "platform/android/android_frame_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <dlfcn.h>
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+/// The thermal headroom is only updated about once a second, checking it more often returns NaN
+constexpr int64_t THERMAL_CHECK_PERIOD = 2000000000;
+
+/// Seconds ahead the headroom forecasts the thermal state
+constexpr int THERMAL_FORECAST_SECONDS = 10;
+
+/// Headroom from which the device is about to throttle, 1 being severe throttling
+constexpr float THROTTLE_HEADROOM = 0.9f;
+
+/// Headroom below which the device has cooled down enough to raise the frame rate again
+constexpr float RECOVER_HEADROOM = 0.7f;
+
+/// Time between two steps of the thermal control, recovering slower than throttling to avoid oscillating
+constexpr int64_t THROTTLE_HOLD_TIME = 5000000000;
+
+constexpr int64_t RECOVER_HOLD_TIME = 15000000000;
+
+/// Refresh cycles the thermal control may add between the frames
+constexpr uint32_t MAX_THERMAL_INTERVAL = 3;
+
+/// ATHERMAL_STATUS_LIGHT and ATHERMAL_STATUS_MODERATE
+constexpr int THERMAL_STATUS_LIGHT = 1;
+
+constexpr int THERMAL_STATUS_MODERATE = 2;
+
+constexpr double REFRESH_PERIOD_SMOOTHING = 0.1;
+}        // namespace
+
+AndroidFramePacer::AndroidFramePacer()
+{
+	library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+
+	if (!library)
+	{
+		LOGW("Frame pacing: libandroid.so not found");
+		return;
+	}
+
+	using GetInstance    = void *(*) ();
+	using AcquireManager = void *(*) ();
+
+	auto get_instance    = reinterpret_cast<GetInstance>(dlsym(library, "AChoreographer_getInstance"));
+	auto acquire_manager = reinterpret_cast<AcquireManager>(dlsym(library, "AThermal_acquireManager"));
+
+	post_frame_callback_64 = reinterpret_cast<PostFrameCallback64>(dlsym(library, "AChoreographer_postFrameCallback64"));
+	post_frame_callback    = reinterpret_cast<PostFrameCallback>(dlsym(library, "AChoreographer_postFrameCallback"));
+
+	// The choreographer of the looper of the calling thread
+	if (get_instance && (post_frame_callback_64 || post_frame_callback))
+	{
+		choreographer = get_instance();
+	}
+
+	if (!choreographer)
+	{
+		LOGW("Frame pacing: AChoreographer is not available");
+		return;
+	}
+
+	auto register_refresh_rate_callback = reinterpret_cast<RefreshRateCallback>(dlsym(library, "AChoreographer_registerRefreshRateCallback"));
+	unregister_refresh_rate_callback    = reinterpret_cast<RefreshRateCallback>(dlsym(library, "AChoreographer_unregisterRefreshRateCallback"));
+
+	if (register_refresh_rate_callback && unregister_refresh_rate_callback)
+	{
+		register_refresh_rate_callback(choreographer, on_refresh_rate_callback, this);
+	}
+
+	if (acquire_manager)
+	{
+		thermal_manager = acquire_manager();
+	}
+
+	if (thermal_manager)
+	{
+		get_thermal_headroom       = reinterpret_cast<GetThermalHeadroom>(dlsym(library, "AThermal_getThermalHeadroom"));
+		get_current_thermal_status = reinterpret_cast<GetCurrentThermalStatus>(dlsym(library, "AThermal_getCurrentThermalStatus"));
+		release_thermal_manager    = reinterpret_cast<ReleaseThermalManager>(dlsym(library, "AThermal_releaseManager"));
+	}
+	else
+	{
+		LOGI("Frame pacing: AThermal is not available, the frame rate is not thermally controlled");
+	}
+}
+
+AndroidFramePacer::~AndroidFramePacer()
+{
+	if (choreographer && unregister_refresh_rate_callback)
+	{
+		unregister_refresh_rate_callback(choreographer, on_refresh_rate_callback, this);
+	}
+
+	if (thermal_manager && release_thermal_manager)
+	{
+		release_thermal_manager(thermal_manager);
+	}
+
+	if (library)
+	{
+		dlclose(library);
+	}
+}
+
+bool AndroidFramePacer::is_supported() const
+{
+	return choreographer != nullptr;
+}
+
+void AndroidFramePacer::set_target_frame_rate(float frame_rate)
+{
+	target_frame_rate = std::max(frame_rate, 0.0f);
+}
+
+void AndroidFramePacer::set_thermal_control(bool enabled)
+{
+	thermal_control = enabled;
+
+	if (!thermal_control)
+	{
+		thermal_interval = 0;
+	}
+}
+
+float AndroidFramePacer::get_frame_rate() const
+{
+	if (refresh_period == 0.0)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(1e9 / refresh_period / get_swap_interval());
+}
+
+float AndroidFramePacer::get_refresh_rate() const
+{
+	return refresh_period == 0.0 ? 0.0f : static_cast<float>(1e9 / refresh_period);
+}
+
+void AndroidFramePacer::request_frame()
+{
+	if (!choreographer || callback_pending || frame_due)
+	{
+		return;
+	}
+
+	if (post_frame_callback_64)
+	{
+		post_frame_callback_64(choreographer, on_frame_callback, this);
+	}
+	else
+	{
+		// The 32-bit frame time of the callback wraps around on 32-bit devices, the intervals stay valid
+		post_frame_callback(choreographer, on_frame_callback_32, this);
+	}
+
+	callback_pending = true;
+}
+
+bool AndroidFramePacer::is_frame_due() const
+{
+	return frame_due;
+}
+
+bool AndroidFramePacer::acquire_frame()
+{
+	bool due  = frame_due;
+	frame_due = false;
+
+	return due;
+}
+
+void AndroidFramePacer::on_frame_callback(int64_t frame_time_nanos, void *data)
+{
+	static_cast<AndroidFramePacer *>(data)->on_frame(frame_time_nanos);
+}
+
+void AndroidFramePacer::on_frame_callback_32(long frame_time_nanos, void *data)
+{
+	static_cast<AndroidFramePacer *>(data)->on_frame(frame_time_nanos);
+}
+
+void AndroidFramePacer::on_refresh_rate_callback(int64_t vsync_period_nanos, void *data)
+{
+	auto pacer = static_cast<AndroidFramePacer *>(data);
+
+	pacer->refresh_period        = static_cast<double>(vsync_period_nanos);
+	pacer->refresh_rate_reported = true;
+
+	LOGI("Frame pacing: display refreshes at {:.1f} Hz", pacer->get_refresh_rate());
+}
+
+void AndroidFramePacer::on_frame(int64_t frame_time)
+{
+	callback_pending = false;
+
+	if (last_callback_time != 0 && !refresh_rate_reported)
+	{
+		double interval = static_cast<double>(frame_time - last_callback_time);
+
+		// Callbacks are posted for the next refresh cycle, longer intervals skipped cycles while a frame was recorded
+		if (refresh_period == 0.0 || interval < refresh_period * 0.75)
+		{
+			refresh_period = interval;
+		}
+		else if (interval < refresh_period * 1.5)
+		{
+			refresh_period += REFRESH_PERIOD_SMOOTHING * (interval - refresh_period);
+		}
+	}
+
+	last_callback_time = frame_time;
+
+	update_thermal_control(frame_time);
+
+	// Half a refresh cycle early, so that a late callback does not push the frame to the next cycle
+	double due_interval = (get_swap_interval() - 0.5) * refresh_period;
+
+	if (last_frame_time == 0 || refresh_period == 0.0 || static_cast<double>(frame_time - last_frame_time) >= due_interval)
+	{
+		frame_due       = true;
+		last_frame_time = frame_time;
+	}
+}
+
+void AndroidFramePacer::update_thermal_control(int64_t frame_time)
+{
+	if (!thermal_control || !thermal_manager || frame_time - last_thermal_check_time < THERMAL_CHECK_PERIOD)
+	{
+		return;
+	}
+
+	last_thermal_check_time = frame_time;
+
+	float headroom = NAN;
+
+	if (get_thermal_headroom)
+	{
+		headroom = get_thermal_headroom(thermal_manager, THERMAL_FORECAST_SECONDS);
+	}
+
+	// Before API 31 the current status stands in for the forecast, light throttling holds the frame rate
+	if (std::isnan(headroom) && get_current_thermal_status)
+	{
+		int status = get_current_thermal_status(thermal_manager);
+
+		headroom = status >= THERMAL_STATUS_MODERATE ? 1.0f : (status == THERMAL_STATUS_LIGHT ? RECOVER_HEADROOM : 0.0f);
+	}
+
+	if (std::isnan(headroom))
+	{
+		return;
+	}
+
+	int64_t since_change = frame_time - last_thermal_change_time;
+
+	if (headroom >= THROTTLE_HEADROOM && thermal_interval < MAX_THERMAL_INTERVAL && since_change >= THROTTLE_HOLD_TIME)
+	{
+		++thermal_interval;
+	}
+	else if (headroom < RECOVER_HEADROOM && thermal_interval > 0 && since_change >= RECOVER_HOLD_TIME)
+	{
+		--thermal_interval;
+	}
+	else
+	{
+		return;
+	}
+
+	last_thermal_change_time = frame_time;
+
+	LOGI("Frame pacing: thermal headroom {:.2f}, pacing to {:.1f} fps", headroom, get_frame_rate());
+}
+
+uint32_t AndroidFramePacer::get_swap_interval() const
+{
+	uint32_t interval = 1;
+
+	if (target_frame_rate > 0.0f && refresh_period > 0.0)
+	{
+		// The smallest interval which does not exceed the target frame rate
+		double cycles = 1e9 / refresh_period / target_frame_rate;
+
+		interval = std::max(1u, static_cast<uint32_t>(std::ceil(cycles - 0.01)));
+	}
+
+	return interval + thermal_interval;
+}
+}        // namespace vkb
@@ -0,0 +1,166 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace vkb
+{
+/**
+ * @brief Paces the frames to the refresh cycles of the display with AChoreographer, and lowers the frame rate
+ *        as the device heats up with the thermal headroom of AThermal
+ *
+ * A frame callback is posted to the looper of the thread which constructed the pacer, so the main loop blocks
+ * in the looper until the refresh cycle a frame is due at. Frames are due every swap interval refresh cycles,
+ * the smallest interval which does not exceed the target frame rate. The thermal control adds to the interval
+ * while the headroom forecasts throttling, and removes it once the device has cooled down, so that the frame
+ * rate can be sustained rather than peaking before the device throttles.
+ *
+ * The functions are loaded from libandroid at runtime, the choreographer needs API 24 and the thermal
+ * headroom API 31, falling back to the thermal status of API 30. Posted frame callbacks cannot be cancelled,
+ * so the pacer must outlive the polling of its looper.
+ */
+class AndroidFramePacer
+{
+  public:
+	AndroidFramePacer();
+
+	AndroidFramePacer(const AndroidFramePacer &) = delete;
+
+	AndroidFramePacer(AndroidFramePacer &&) = delete;
+
+	~AndroidFramePacer();
+
+	AndroidFramePacer &operator=(const AndroidFramePacer &) = delete;
+
+	AndroidFramePacer &operator=(AndroidFramePacer &&) = delete;
+
+	/**
+	 * @return Whether the choreographer is available to pace the frames
+	 */
+	bool is_supported() const;
+
+	/**
+	 * @brief Sets the frame rate the frames are paced to, 0 for the refresh rate of the display
+	 */
+	void set_target_frame_rate(float frame_rate);
+
+	/**
+	 * @brief Lowers the frame rate while the device forecasts thermal throttling
+	 */
+	void set_thermal_control(bool enabled);
+
+	/**
+	 * @return The frame rate the frames are paced to, the thermal control included, 0 before the refresh rate is measured
+	 */
+	float get_frame_rate() const;
+
+	/**
+	 * @return The refresh rate of the display measured from the frame callbacks, 0 before it is measured
+	 */
+	float get_refresh_rate() const;
+
+	/**
+	 * @brief Posts a frame callback for the next refresh cycle, unless one is pending or a frame is due
+	 */
+	void request_frame();
+
+	/**
+	 * @return Whether a frame is due, which the looper has to wait for if not
+	 */
+	bool is_frame_due() const;
+
+	/**
+	 * @brief Starts the frame which is due
+	 * @return Whether a frame was due
+	 */
+	bool acquire_frame();
+
+  private:
+	static void on_frame_callback(int64_t frame_time_nanos, void *data);
+
+	static void on_frame_callback_32(long frame_time_nanos, void *data);
+
+	static void on_refresh_rate_callback(int64_t vsync_period_nanos, void *data);
+
+	void on_frame(int64_t frame_time);
+
+	void update_thermal_control(int64_t frame_time);
+
+	/// Refresh cycles between the frames
+	uint32_t get_swap_interval() const;
+
+	void *library{nullptr};
+
+	void *choreographer{nullptr};
+
+	void *thermal_manager{nullptr};
+
+	using PostFrameCallback64 = void (*)(void *choreographer, void (*callback)(int64_t, void *), void *data);
+
+	using PostFrameCallback = void (*)(void *choreographer, void (*callback)(long, void *), void *data);
+
+	using GetThermalHeadroom = float (*)(void *manager, int forecast_seconds);
+
+	using GetCurrentThermalStatus = int (*)(void *manager);
+
+	using ReleaseThermalManager = void (*)(void *manager);
+
+	using RefreshRateCallback = void (*)(void *choreographer, void (*callback)(int64_t, void *), void *data);
+
+	PostFrameCallback64 post_frame_callback_64{nullptr};
+
+	PostFrameCallback post_frame_callback{nullptr};
+
+	GetThermalHeadroom get_thermal_headroom{nullptr};
+
+	GetCurrentThermalStatus get_current_thermal_status{nullptr};
+
+	ReleaseThermalManager release_thermal_manager{nullptr};
+
+	RefreshRateCallback unregister_refresh_rate_callback{nullptr};
+
+	/// Whether the choreographer reports the refresh period, which is measured from the frame callbacks otherwise
+	bool refresh_rate_reported{false};
+
+	float target_frame_rate{0.0f};
+
+	bool thermal_control{true};
+
+	bool callback_pending{false};
+
+	bool frame_due{false};
+
+	/// Time of the last frame callback, in nanoseconds
+	int64_t last_callback_time{0};
+
+	/// Time of the refresh cycle the last frame was due at
+	int64_t last_frame_time{0};
+
+	/// Smoothed duration of a refresh cycle in nanoseconds, 0 before it is measured
+	double refresh_period{0.0};
+
+	/// Refresh cycles the thermal control adds between the frames
+	uint32_t thermal_interval{0};
+
+	/// Time the thermal state was last checked, and the thermal interval last changed
+	int64_t last_thermal_check_time{0};
+
+	int64_t last_thermal_change_time{0};
+};
+}        // namespace vkb
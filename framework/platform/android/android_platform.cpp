@@ -391,7 +391,20 @@ bool AndroidPlatform::initialize(std::unique_ptr<Application> &&application)
 	app->activity->callbacks->onContentRectChanged = on_content_rect_changed;
 	app->userData                                  = this;
 
-	return Platform::initialize(std::move(application));
+	if (!Platform::initialize(std::move(application)))
+	{
+		return false;
+	}
+
+	// Posts its frame callbacks to the looper of this thread, polled by the main loop
+	frame_pacer = std::make_unique<AndroidFramePacer>();
+
+	if (active_app->get_options().contains("--target-fps"))
+	{
+		frame_pacer->set_target_frame_rate(static_cast<float>(active_app->get_options().get_int("--target-fps")));
+	}
+
+	return true;
 }
 
 void AndroidPlatform::create_window()
@@ -404,28 +417,46 @@ void AndroidPlatform::main_loop()
 {
 	while (true)
 	{
-		poll_events();
+		bool paced = is_frame_paced();
+
+		if (paced)
+		{
+			frame_pacer->request_frame();
+		}
+
+		poll_events(paced);
 
 		if (app->destroyRequested != 0)
 		{
 			break;
 		}
 
-		if (!window->should_close())
+		// A frame callback which was not due yet is posted again for the next refresh cycle
+		if (!window->should_close() && (!paced || frame_pacer->acquire_frame()))
 		{
 			run();
 		}
 	}
 }
 
-void AndroidPlatform::poll_events()
+bool AndroidPlatform::is_frame_paced() const
+{
+	// Benchmarks run as fast as they can, and unfocused apps do not render
+	return frame_pacer && frame_pacer->is_supported() && !window->should_close() &&
+	       active_app && active_app->is_focused() && !active_app->is_benchmark_mode();
+}
+
+void AndroidPlatform::poll_events(bool wait_for_frame)
 {
 	android_poll_source *source;
 
 	int ident;
 	int events;
 
-	while ((ident = ALooper_pollAll(0, nullptr, &events,
+	// The frame callback of the choreographer returns ALOOPER_POLL_CALLBACK, which ends the wait
+	int timeout = wait_for_frame && !frame_pacer->is_frame_due() ? -1 : 0;
+
+	while ((ident = ALooper_pollAll(timeout, nullptr, &events,
 	                                (void **) &source)) >= 0)
 	{
 		if (source)
@@ -481,6 +512,12 @@ ANativeActivity *AndroidPlatform::get_activity()
 	return app->activity;
 }
 
+AndroidFramePacer &AndroidPlatform::get_frame_pacer()
+{
+	assert(frame_pacer && "Frame pacer is created by initialize");
+	return *frame_pacer;
+}
+
 android_app *AndroidPlatform::get_android_app()
 {
 	return app;
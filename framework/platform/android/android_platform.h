@@ -19,6 +19,7 @@
 
 #include <android_native_app_glue.h>
 
+#include "platform/android/android_frame_pacer.h"
 #include "platform/platform.h"
 
 namespace vkb
@@ -56,8 +57,21 @@ class AndroidPlatform : public Platform
 
 	ANativeActivity *get_activity();
 
+	/**
+	 * @return The pacer scheduling the frames at the refresh cycles of the display
+	 */
+	AndroidFramePacer &get_frame_pacer();
+
   private:
-	void poll_events();
+	/**
+	 * @param wait_for_frame Blocks until the frame pacer has a frame due, processing the events meanwhile
+	 */
+	void poll_events(bool wait_for_frame = false);
+
+	/// Whether the next frame waits for the frame pacer
+	bool is_frame_paced() const;
+
+	std::unique_ptr<AndroidFramePacer> frame_pacer;
 
 	android_app *app{nullptr};
 
@@ -0,0 +1,356 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "platform/async_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace vkb
+{
+namespace fs
+{
+AsyncIO::Request::Request(const std::string &path, int32_t priority, uint64_t sequence) :
+    path{path},
+    priority{priority},
+    sequence{sequence}
+{}
+
+AsyncIO::Status AsyncIO::Request::wait()
+{
+	std::unique_lock<std::mutex> lock{done_mutex};
+
+	done_condition.wait(lock, [this] { return is_done(); });
+
+	return status;
+}
+
+bool AsyncIO::Request::is_done() const
+{
+	auto current = status.load();
+	return current != Status::Queued && current != Status::Reading;
+}
+
+AsyncIO::Status AsyncIO::Request::get_status() const
+{
+	return status;
+}
+
+const std::string &AsyncIO::Request::get_path() const
+{
+	return path;
+}
+
+std::vector<uint8_t> &AsyncIO::Request::get_data()
+{
+	if (status != Status::Complete)
+	{
+		throw std::runtime_error{"Request of " + path + " is not complete"};
+	}
+
+	return data;
+}
+
+const std::string &AsyncIO::Request::get_error() const
+{
+	return error;
+}
+
+void AsyncIO::Request::finish(Status final_status)
+{
+	{
+		std::lock_guard<std::mutex> lock{done_mutex};
+		status = final_status;
+	}
+
+	done_condition.notify_all();
+}
+
+AsyncIO::AsyncIO(uint32_t thread_count)
+{
+	thread_count = std::max(thread_count, 1u);
+
+	for (uint32_t i = 0; i < thread_count; i++)
+	{
+		workers.emplace_back(&AsyncIO::run_worker, this);
+	}
+}
+
+AsyncIO::~AsyncIO()
+{
+	{
+		std::lock_guard<std::mutex> lock{queue_mutex};
+		stopping = true;
+	}
+
+	cancel_all();
+
+	queue_condition.notify_all();
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+std::shared_ptr<AsyncIO::Request> AsyncIO::read(const std::string &path, int32_t priority)
+{
+	std::shared_ptr<Request> request;
+
+	{
+		std::lock_guard<std::mutex> lock{queue_mutex};
+
+		request = std::make_shared<Request>(path, priority, next_sequence++);
+
+		if (stopping)
+		{
+			request->finish(Status::Cancelled);
+			return request;
+		}
+
+		queue.push_back(request);
+	}
+
+	queue_condition.notify_one();
+
+	return request;
+}
+
+std::shared_ptr<AsyncIO::Request> AsyncIO::read_asset(const std::string &filename, int32_t priority)
+{
+	return read(path::get(path::Type::Assets) + filename, priority);
+}
+
+void AsyncIO::set_priority(Request &request, int32_t priority)
+{
+	std::lock_guard<std::mutex> lock{queue_mutex};
+
+	request.priority = priority;
+}
+
+void AsyncIO::cancel(Request &request)
+{
+	request.cancelled = true;
+
+	std::shared_ptr<Request> queued;
+
+	{
+		std::lock_guard<std::mutex> lock{queue_mutex};
+
+		auto it = std::find_if(queue.begin(), queue.end(), [&request](const std::shared_ptr<Request> &r) { return r.get() == &request; });
+		if (it != queue.end())
+		{
+			queued = std::move(*it);
+			queue.erase(it);
+		}
+	}
+
+	// A read in progress finishes the request itself
+	if (queued)
+	{
+		queued->finish(Status::Cancelled);
+	}
+}
+
+void AsyncIO::cancel_all()
+{
+	std::vector<std::shared_ptr<Request>> cancelled;
+
+	{
+		std::lock_guard<std::mutex> lock{queue_mutex};
+		cancelled.swap(queue);
+	}
+
+	for (auto &request : cancelled)
+	{
+		request->cancelled = true;
+		request->finish(Status::Cancelled);
+	}
+}
+
+size_t AsyncIO::get_queued_count() const
+{
+	std::lock_guard<std::mutex> lock{queue_mutex};
+
+	return queue.size();
+}
+
+uint64_t AsyncIO::get_read_bytes() const
+{
+	return read_bytes;
+}
+
+void AsyncIO::run_worker()
+{
+	while (true)
+	{
+		std::shared_ptr<Request> request;
+
+		{
+			std::unique_lock<std::mutex> lock{queue_mutex};
+
+			queue_condition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+			if (queue.empty())
+			{
+				return;
+			}
+
+			// Priorities change while queued, so the queue is searched rather than kept as a heap
+			auto it = std::min_element(queue.begin(), queue.end(), [](const std::shared_ptr<Request> &a, const std::shared_ptr<Request> &b) {
+				return a->priority != b->priority ? a->priority > b->priority : a->sequence < b->sequence;
+			});
+
+			request = std::move(*it);
+			queue.erase(it);
+
+			request->status = Status::Reading;
+		}
+
+		try
+		{
+			if (read_file(*request))
+			{
+				read_bytes += request->data.size();
+				request->finish(Status::Complete);
+			}
+			else
+			{
+				request->data.clear();
+				request->finish(Status::Cancelled);
+			}
+		}
+		catch (const std::runtime_error &e)
+		{
+			LOGW("Failed to read {}: {}", request->path, e.what());
+
+			request->data.clear();
+			request->error = e.what();
+			request->finish(Status::Failed);
+		}
+	}
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+bool AsyncIO::read_file(Request &request)
+{
+	HANDLE handle = CreateFileA(request.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error{"Failed to open file"};
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size))
+	{
+		CloseHandle(handle);
+		throw std::runtime_error{"Failed to get the file size"};
+	}
+
+	request.data.resize(static_cast<size_t>(size.QuadPart));
+
+	size_t offset = 0;
+	while (offset < request.data.size())
+	{
+		if (request.cancelled)
+		{
+			CloseHandle(handle);
+			return false;
+		}
+
+		// The offset of each read is given in its OVERLAPPED structure
+		OVERLAPPED overlapped{};
+		overlapped.Offset     = static_cast<DWORD>(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+
+		DWORD chunk_size = static_cast<DWORD>(std::min(CHUNK_SIZE, request.data.size() - offset));
+		DWORD read_size  = 0;
+		if (!ReadFile(handle, request.data.data() + offset, chunk_size, &read_size, &overlapped) || read_size == 0)
+		{
+			CloseHandle(handle);
+			throw std::runtime_error{"Failed to read file"};
+		}
+
+		offset += read_size;
+	}
+
+	CloseHandle(handle);
+
+	return true;
+}
+#else
+bool AsyncIO::read_file(Request &request)
+{
+	int fd = open(request.path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error{"Failed to open file"};
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0)
+	{
+		close(fd);
+		throw std::runtime_error{"Failed to get the file size"};
+	}
+
+	request.data.resize(static_cast<size_t>(file_stat.st_size));
+
+	size_t offset = 0;
+	while (offset < request.data.size())
+	{
+		if (request.cancelled)
+		{
+			close(fd);
+			return false;
+		}
+
+		auto chunk_size = std::min(CHUNK_SIZE, request.data.size() - offset);
+		auto read_size  = pread(fd, request.data.data() + offset, chunk_size, static_cast<off_t>(offset));
+		if (read_size < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (read_size <= 0)
+		{
+			close(fd);
+			throw std::runtime_error{"Failed to read file"};
+		}
+
+		offset += static_cast<size_t>(read_size);
+	}
+
+	close(fd);
+
+	return true;
+}
+#endif
+}        // namespace fs
+}        // namespace vkb
@@ -0,0 +1,203 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vkb
+{
+namespace fs
+{
+/**
+ * @brief Reads files in the background, in the order of their priorities
+ *
+ * Reads are queued as requests, which worker threads serve from the highest priority,
+ * the requests of a same priority in the order they were made. A request can be given
+ * another priority or cancelled while it is queued, and a cancelled read in progress stops
+ * at its next chunk. Files are read with positional reads at increasing offsets, pread on
+ * POSIX platforms and ReadFile with an offset on Windows, so a worker never seeks a shared
+ * file position.
+ *
+ * The service is thread safe. Pending requests are cancelled when it is destroyed.
+ */
+class AsyncIO
+{
+  public:
+	/**
+	 * @brief Default number of worker threads, reads are bound by the storage rather than the CPU
+	 */
+	static constexpr uint32_t DEFAULT_THREAD_COUNT = 2;
+
+	/**
+	 * @brief Size of the reads a file is split into, cancellation is checked between them
+	 */
+	static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+	enum class Status
+	{
+		Queued,
+		Reading,
+		Complete,
+		Cancelled,
+		Failed
+	};
+
+	/**
+	 * @brief A read of a whole file, shared by the service and the caller
+	 */
+	class Request
+	{
+	  public:
+		Request(const std::string &path, int32_t priority, uint64_t sequence);
+
+		/**
+		 * @brief Blocks until the read has completed, failed or was cancelled
+		 * @return The final status of the request
+		 */
+		Status wait();
+
+		/**
+		 * @return Whether the read has completed, failed or was cancelled
+		 */
+		bool is_done() const;
+
+		Status get_status() const;
+
+		const std::string &get_path() const;
+
+		/**
+		 * @return The content of the file, once the request is complete
+		 */
+		std::vector<uint8_t> &get_data();
+
+		/**
+		 * @return The reason of the failure of a failed request
+		 */
+		const std::string &get_error() const;
+
+	  private:
+		friend class AsyncIO;
+
+		void finish(Status status);
+
+		std::string path;
+
+		int32_t priority;
+
+		uint64_t sequence;
+
+		std::atomic<Status> status{Status::Queued};
+
+		std::atomic<bool> cancelled{false};
+
+		std::vector<uint8_t> data;
+
+		std::string error;
+
+		std::mutex done_mutex;
+
+		std::condition_variable done_condition;
+	};
+
+	/**
+	 * @param thread_count Number of worker threads
+	 */
+	AsyncIO(uint32_t thread_count = DEFAULT_THREAD_COUNT);
+
+	AsyncIO(const AsyncIO &) = delete;
+
+	AsyncIO(AsyncIO &&) = delete;
+
+	/**
+	 * @brief Cancels the pending requests and waits for the workers
+	 */
+	~AsyncIO();
+
+	AsyncIO &operator=(const AsyncIO &) = delete;
+
+	AsyncIO &operator=(AsyncIO &&) = delete;
+
+	/**
+	 * @brief Queues the read of a file
+	 * @param path Path of the file
+	 * @param priority Requests with higher priorities are read first
+	 */
+	std::shared_ptr<Request> read(const std::string &path, int32_t priority = 0);
+
+	/**
+	 * @brief Queues the read of a file in the assets folder
+	 */
+	std::shared_ptr<Request> read_asset(const std::string &filename, int32_t priority = 0);
+
+	/**
+	 * @brief Changes the priority of a request, ignored once its read has started
+	 */
+	void set_priority(Request &request, int32_t priority);
+
+	/**
+	 * @brief Cancels a request, a read in progress stops at its next chunk
+	 */
+	void cancel(Request &request);
+
+	/**
+	 * @brief Cancels every pending request
+	 */
+	void cancel_all();
+
+	/**
+	 * @return Number of requests waiting for a worker
+	 */
+	size_t get_queued_count() const;
+
+	/**
+	 * @return Number of bytes read by the completed requests
+	 */
+	uint64_t get_read_bytes() const;
+
+  private:
+	void run_worker();
+
+	/**
+	 * @brief Reads the whole file of a request, in chunks of CHUNK_SIZE
+	 * @return Whether the file was read, rather than cancelled
+	 */
+	static bool read_file(Request &request);
+
+	mutable std::mutex queue_mutex;
+
+	std::condition_variable queue_condition;
+
+	std::vector<std::shared_ptr<Request>> queue;
+
+	uint64_t next_sequence{0};
+
+	bool stopping{false};
+
+	std::atomic<uint64_t> read_bytes{0};
+
+	std::vector<std::thread> workers;
+};
+}        // namespace fs
+}        // namespace vkb
@@ -97,6 +97,24 @@ void Configuration::reset()
 	current_configuration = configs.begin();
 }
 
+bool Configuration::select(uint32_t config_index)
+{
+	reset();
+
+	if (config_index >= configs.size())
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < config_index; ++i)
+	{
+		next();
+		set();
+	}
+
+	return true;
+}
+
 void Configuration::insert_setting(uint32_t config_index, std::unique_ptr<Setting> setting)
 {
 	settings.push_back(std::move(setting));
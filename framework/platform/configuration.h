@@ -111,6 +111,14 @@ class Configuration
 	 */
 	void reset();
 
+	/**
+	 * @brief Moves to a configuration and configures every configuration after the first up to it,
+	 *        which leaves the settings as a batch run does when it reaches the configuration
+	 * @param config_index The position of the configuration
+	 * @returns True if the configuration exists
+	 */
+	bool select(uint32_t config_index);
+
 	/**
 	 * @brief Inserts a setting into the current configuration
 	 * @param config_index The configuration to insert the setting into
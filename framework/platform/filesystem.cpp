@@ -20,12 +20,25 @@
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
+#include <stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 VKBP_ENABLE_WARNINGS()
 
+#include <cstring>
+#include <mutex>
+
 #include "platform/platform.h"
 
+#if defined(_WIN32) || defined(_WIN64)
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
 namespace vkb
 {
 namespace fs
@@ -161,8 +174,276 @@ static void write_binary_file(const std::vector<uint8_t> &data, const std::strin
 	file.close();
 }
 
+MappedFile::MappedFile(const std::string &filename)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open file: " + filename);
+	}
+
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get the size of file: " + filename);
+	}
+
+	mapped_size = static_cast<size_t>(file_size.QuadPart);
+
+	if (mapped_size > 0)
+	{
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping)
+		{
+			mapped_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+			// The view keeps the mapping alive
+			CloseHandle(mapping);
+		}
+	}
+
+	CloseHandle(file);
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open file: " + filename);
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close(file);
+		throw std::runtime_error("Failed to get the size of file: " + filename);
+	}
+
+	mapped_size = static_cast<size_t>(info.st_size);
+
+	if (mapped_size > 0)
+	{
+		void *mapping = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (mapping != MAP_FAILED)
+		{
+			mapped_data = static_cast<const uint8_t *>(mapping);
+		}
+	}
+
+	// The mapping keeps the file alive
+	close(file);
+#endif
+
+	if (mapped_size > 0 && !mapped_data)
+	{
+		throw std::runtime_error("Failed to map file: " + filename);
+	}
+}
+
+MappedFile::MappedFile(std::shared_ptr<const void> owner, const uint8_t *data, size_t size) :
+    mapped_data{data},
+    mapped_size{size},
+    owner{std::move(owner)}
+{
+}
+
+MappedFile::MappedFile(MappedFile &&other) :
+    mapped_data{other.mapped_data},
+    mapped_size{other.mapped_size},
+    owner{std::move(other.owner)}
+{
+	other.mapped_data = nullptr;
+	other.mapped_size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	if (mapped_data && !owner)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		UnmapViewOfFile(mapped_data);
+#else
+		munmap(const_cast<uint8_t *>(mapped_data), mapped_size);
+#endif
+	}
+}
+
+const uint8_t *MappedFile::data() const
+{
+	return mapped_data;
+}
+
+size_t MappedFile::size() const
+{
+	return mapped_size;
+}
+
+namespace
+{
+const char     archive_magic[4] = {'V', 'K', 'B', 'A'};
+const uint32_t archive_version  = 1;
+
+// Reads a little endian value of the index, which has no alignment
+template <typename T>
+T read_value(const uint8_t *&cursor)
+{
+	T value;
+	std::memcpy(&value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return value;
+}
+}        // namespace
+
+Archive::Archive(const std::string &filename) :
+    file{std::make_shared<MappedFile>(filename)}
+{
+	// Magic, version, alignment, entry count, index offset and index size
+	const size_t header_size = 4 + 3 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+	if (file->size() < header_size || std::memcmp(file->data(), archive_magic, sizeof(archive_magic)) != 0)
+	{
+		throw std::runtime_error("Not an asset archive: " + filename);
+	}
+
+	const uint8_t *cursor = file->data() + sizeof(archive_magic);
+
+	auto version = read_value<uint32_t>(cursor);
+	if (version != archive_version)
+	{
+		throw std::runtime_error("Unsupported asset archive version " + std::to_string(version) + ": " + filename);
+	}
+
+	read_value<uint32_t>(cursor);        // Alignment of the entries, only used by the packer
+	auto entry_count  = read_value<uint32_t>(cursor);
+	auto index_offset = read_value<uint64_t>(cursor);
+	auto index_size   = read_value<uint64_t>(cursor);
+
+	if (index_offset > file->size() || index_size > file->size() - index_offset)
+	{
+		throw std::runtime_error("Asset archive index out of bounds: " + filename);
+	}
+
+	// Offset, size, stored size, compression and path length
+	const size_t record_size = 3 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+	cursor             = file->data() + index_offset;
+	const uint8_t *end = cursor + index_size;
+
+	entries.reserve(entry_count);
+
+	for (uint32_t i = 0; i < entry_count; ++i)
+	{
+		if (static_cast<size_t>(end - cursor) < record_size)
+		{
+			throw std::runtime_error("Asset archive index truncated: " + filename);
+		}
+
+		Entry entry;
+		entry.offset      = read_value<uint64_t>(cursor);
+		entry.size        = read_value<uint64_t>(cursor);
+		entry.stored_size = read_value<uint64_t>(cursor);
+		entry.compression = static_cast<Compression>(read_value<uint32_t>(cursor));
+
+		auto path_length = read_value<uint32_t>(cursor);
+
+		if (static_cast<size_t>(end - cursor) < path_length ||
+		    entry.offset > file->size() || entry.stored_size > file->size() - entry.offset)
+		{
+			throw std::runtime_error("Asset archive entry out of bounds: " + filename);
+		}
+
+		entries.emplace(std::string{reinterpret_cast<const char *>(cursor), path_length}, entry);
+		cursor += path_length;
+	}
+}
+
+const Archive::Entry *Archive::find(const std::string &path) const
+{
+	auto it = entries.find(path);
+	return it != entries.end() ? &it->second : nullptr;
+}
+
+MappedFile Archive::open(const Entry &entry) const
+{
+	const uint8_t *stored = file->data() + entry.offset;
+
+	switch (entry.compression)
+	{
+		case Compression::None:
+			return MappedFile{file, stored, static_cast<size_t>(entry.size)};
+		case Compression::Deflate:
+		{
+			auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry.size));
+
+			int size = stbi_zlib_decode_buffer(reinterpret_cast<char *>(data->data()), static_cast<int>(data->size()),
+			                                   reinterpret_cast<const char *>(stored), static_cast<int>(entry.stored_size));
+			if (size != static_cast<int>(data->size()))
+			{
+				throw std::runtime_error("Failed to decompress an asset archive entry");
+			}
+
+			return MappedFile{data, data->data(), data->size()};
+		}
+		default:
+			throw std::runtime_error("Unsupported compression of an asset archive entry");
+	}
+}
+
+const Archive *get_asset_archive()
+{
+	static std::unique_ptr<Archive> archive;
+	static std::once_flag           opened;
+
+	std::call_once(opened, []() {
+		auto filename = path::get(path::Type::WorkingDir) + "assets.pak";
+		if (!is_file(filename))
+		{
+			return;
+		}
+
+		try
+		{
+			archive = std::make_unique<Archive>(filename);
+			LOGI("Reading assets from {}", filename);
+		}
+		catch (const std::runtime_error &e)
+		{
+			LOGE("Asset archive ignored: {}", e.what());
+		}
+	});
+
+	return archive.get();
+}
+
+MappedFile map_asset(const std::string &filename)
+{
+	if (auto archive = get_asset_archive())
+	{
+		if (auto entry = archive->find(filename))
+		{
+			return archive->open(*entry);
+		}
+	}
+
+	return MappedFile{path::get(path::Type::Assets) + filename};
+}
+
 std::vector<uint8_t> read_asset(const std::string &filename, const uint32_t count)
 {
+	if (auto archive = get_asset_archive())
+	{
+		if (auto entry = archive->find(filename))
+		{
+			auto   file = archive->open(*entry);
+			size_t size = count == 0 ? file.size() : std::min(static_cast<size_t>(count), file.size());
+			return {file.data(), file.data() + size};
+		}
+	}
+
 	return read_binary_file(path::get(path::Type::Assets) + filename, count);
 }
 
@@ -186,6 +467,38 @@ void write_image(const uint8_t *data, const std::string &filename, const uint32_
 	stbi_write_png((path::get(path::Type::Screenshots) + filename + ".png").c_str(), width, height, components, data, row_stride);
 }
 
+void write_ppm(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride)
+{
+	assert(components >= 3 && "PPM images need RGB components");
+
+	std::ofstream file(path::get(path::Type::Screenshots) + filename + ".ppm", std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!file.good())
+	{
+		LOGE("Failed to open file for writing: {}", filename);
+		return;
+	}
+
+	file << "P6\n"
+	     << width << " " << height << "\n255\n";
+
+	std::vector<char> row(width * 3);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		auto pixel = data + y * row_stride;
+
+		for (uint32_t x = 0; x < width; ++x, pixel += components)
+		{
+			row[x * 3]     = static_cast<char>(pixel[0]);
+			row[x * 3 + 1] = static_cast<char>(pixel[1]);
+			row[x * 3 + 2] = static_cast<char>(pixel[2]);
+		}
+
+		file.write(row.data(), row.size());
+	}
+}
+
 bool write_json(nlohmann::json &data, const std::string &filename)
 {
 	std::stringstream json;
@@ -198,7 +511,7 @@ bool write_json(nlohmann::json &data, const std::string &filename)
 	catch (std::exception &e)
 	{
 		// JSON dump errors
-		LOGE(e.what());
+		LOGE("{}", e.what());
 		return false;
 	}
 
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sys/stat.h>
 #include <unordered_map>
@@ -90,6 +91,121 @@ void create_directory(const std::string &path);
  */
 void create_path(const std::string &root, const std::string &path);
 
+/**
+ * @brief A read-only view of a file mapped in memory, the file is unmapped on destruction
+ */
+class MappedFile
+{
+  public:
+	/**
+	 * @brief Maps a file in memory
+	 * @param filename The path to the file
+	 * @throws runtime_error if the file cannot be opened or mapped
+	 */
+	MappedFile(const std::string &filename);
+
+	MappedFile(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&other);
+
+	~MappedFile();
+
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	MappedFile &operator=(MappedFile &&) = delete;
+
+	/**
+	 * @return The content of the file, nullptr if it is empty
+	 */
+	const uint8_t *data() const;
+
+	size_t size() const;
+
+  private:
+	friend class Archive;
+
+	/**
+	 * @brief A view of memory kept alive by the owner, such as an entry of an archive
+	 */
+	MappedFile(std::shared_ptr<const void> owner, const uint8_t *data, size_t size);
+
+	const uint8_t *mapped_data{nullptr};
+
+	size_t mapped_size{0};
+
+	/// Holds the memory of a view, which is not unmapped by this file if set
+	std::shared_ptr<const void> owner;
+};
+
+/**
+ * @brief A read-only archive of files, mapped in memory
+ *
+ *        Archives are written by bldsys/scripts/pack_assets.py. The data of each entry starts on
+ *        a page boundary so that stored entries are read in place, and a central index at the end
+ *        of the archive lists the paths, so that opening an entry doesn't touch the file system.
+ *        Entries may be deflated, these are decompressed when opened.
+ */
+class Archive
+{
+  public:
+	enum class Compression : uint32_t
+	{
+		None,
+		Deflate
+	};
+
+	struct Entry
+	{
+		uint64_t offset{0};
+
+		uint64_t size{0};
+
+		uint64_t stored_size{0};
+
+		Compression compression{Compression::None};
+	};
+
+	/**
+	 * @brief Maps an archive in memory and reads its index
+	 * @param filename The path to the archive
+	 * @throws runtime_error if the archive cannot be mapped or is not valid
+	 */
+	Archive(const std::string &filename);
+
+	/**
+	 * @return The entry of a path, nullptr if the archive doesn't have it
+	 */
+	const Entry *find(const std::string &path) const;
+
+	/**
+	 * @brief Opens an entry, without a copy if it is stored uncompressed
+	 * @throws runtime_error if the entry cannot be decompressed
+	 * @return A view of the entry, valid until it is destroyed
+	 */
+	MappedFile open(const Entry &entry) const;
+
+  private:
+	std::shared_ptr<MappedFile> file;
+
+	std::unordered_map<std::string, Entry> entries;
+};
+
+/**
+ * @return The archive of the assets, nullptr if there is none
+ *
+ *         The archive is "assets.pak" in the working directory, opened on first use. Assets are
+ *         looked up in it before the assets directory.
+ */
+const Archive *get_asset_archive();
+
+/**
+ * @brief Helper to map an asset file in memory, without copying it
+ *
+ * @param filename The path to the file (relative to the assets directory)
+ * @return A view of the file, valid until it is destroyed
+ */
+MappedFile map_asset(const std::string &filename);
+
 /**
  * @brief Helper to read an asset file into a byte-array
  *
@@ -140,6 +256,18 @@ void write_temp(const std::vector<uint8_t> &data, const std::string &filename, c
  */
 void write_image(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride);
 
+/**
+ * @brief Writes an image as a binary PPM to the screenshots directory, dropping the components after RGB
+ *        Unlike write_image it does not compress, so it is cheap enough to dump a frame sequence
+ * @param data       The data to write
+ * @param filename   The name of the image file without an extension
+ * @param width      The width of the image
+ * @param height     The height of the image
+ * @param components The number of bytes per element, at least 3
+ * @param row_stride The stride in bytes of a row of pixels
+ */
+void write_ppm(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride);
+
 /**
  * @brief Helper to output a json graph
  * 
@@ -48,9 +48,11 @@ void window_size_callback(GLFWwindow *window, int width, int height)
 {
 	if (auto glfw_window = reinterpret_cast<GlfwWindow *>(glfwGetWindowUserPointer(window)))
 	{
-		auto &platform = glfw_window->get_platform();
-		platform.get_app().resize(width, height);
-		glfw_window->resize(width, height);
+		GlfwWindow::Event event{GlfwWindow::Event::Type::Resize};
+		event.width  = static_cast<uint32_t>(width);
+		event.height = static_cast<uint32_t>(height);
+
+		glfw_window->handle_event(event);
 	}
 }
 
@@ -58,8 +60,10 @@ void window_focus_callback(GLFWwindow *window, int focused)
 {
 	if (auto glfw_window = reinterpret_cast<GlfwWindow *>(glfwGetWindowUserPointer(window)))
 	{
-		auto &platform = glfw_window->get_platform();
-		platform.get_app().set_focus(focused ? true : false);
+		GlfwWindow::Event event{GlfwWindow::Event::Type::Focus};
+		event.focused = focused ? true : false;
+
+		glfw_window->handle_event(event);
 	}
 }
 
@@ -206,8 +210,11 @@ void key_callback(GLFWwindow *window, int key, int /*scancode*/, int action, int
 
 	if (auto glfw_window = reinterpret_cast<GlfwWindow *>(glfwGetWindowUserPointer(window)))
 	{
-		auto &platform = glfw_window->get_platform();
-		platform.get_app().input_event(KeyInputEvent{platform, key_code, key_action});
+		GlfwWindow::Event event{GlfwWindow::Event::Type::Key};
+		event.key_code   = key_code;
+		event.key_action = key_action;
+
+		glfw_window->handle_event(event);
 	}
 }
 
@@ -239,13 +246,13 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
 {
 	if (auto glfw_window = reinterpret_cast<GlfwWindow *>(glfwGetWindowUserPointer(window)))
 	{
-		auto &platform = glfw_window->get_platform();
-		platform.get_app().input_event(MouseButtonInputEvent{
-		    platform,
-		    MouseButton::Unknown,
-		    MouseAction::Move,
-		    static_cast<float>(xpos),
-		    static_cast<float>(ypos)});
+		GlfwWindow::Event event{GlfwWindow::Event::Type::Mouse};
+		event.mouse_button = MouseButton::Unknown;
+		event.mouse_action = MouseAction::Move;
+		event.x            = static_cast<float>(xpos);
+		event.y            = static_cast<float>(ypos);
+
+		glfw_window->handle_event(event);
 	}
 }
 
@@ -255,16 +262,16 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int /*mod
 
 	if (auto glfw_window = reinterpret_cast<GlfwWindow *>(glfwGetWindowUserPointer(window)))
 	{
-		auto & platform = glfw_window->get_platform();
 		double xpos, ypos;
 		glfwGetCursorPos(window, &xpos, &ypos);
 
-		platform.get_app().input_event(MouseButtonInputEvent{
-		    platform,
-		    translate_mouse_button(button),
-		    mouse_action,
-		    static_cast<float>(xpos),
-		    static_cast<float>(ypos)});
+		GlfwWindow::Event event{GlfwWindow::Event::Type::Mouse};
+		event.mouse_button = translate_mouse_button(button);
+		event.mouse_action = mouse_action;
+		event.x            = static_cast<float>(xpos);
+		event.y            = static_cast<float>(ypos);
+
+		glfw_window->handle_event(event);
 	}
 }
 }        // namespace
@@ -347,14 +354,207 @@ void GlfwWindow::process_events()
 	glfwPollEvents();
 }
 
+bool GlfwWindow::supports_event_queue() const
+{
+	return true;
+}
+
+void GlfwWindow::set_event_queue(bool enabled)
+{
+	if (enabled == queue_events)
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		dpi_factor           = read_dpi_factor();
+		content_scale_factor = read_content_scale_factor();
+
+		event_queue = std::make_unique<SpscRing<Event>>(EVENT_QUEUE_SIZE, Event{Event::Type::Focus});
+		queue_events = true;
+	}
+	else
+	{
+		// The application thread has stopped, the events left are delivered here, then those kept aside
+		queue_events = false;
+		dispatch_events();
+		push_pending_events();
+		dispatch_events();
+		event_queue.reset();
+	}
+}
+
+void GlfwWindow::wait_events()
+{
+	if (has_pending_events())
+	{
+		// The events kept aside are queued as soon as the application frees some room
+		glfwWaitEventsTimeout(0.001);
+		push_pending_events();
+	}
+	else
+	{
+		glfwWaitEvents();
+	}
+}
+
+void GlfwWindow::wake_events()
+{
+	glfwPostEmptyEvent();
+}
+
+void GlfwWindow::dispatch_events()
+{
+	if (!event_queue)
+	{
+		return;
+	}
+
+	while (auto event = event_queue->front())
+	{
+		deliver_event(*event);
+		event_queue->pop();
+	}
+}
+
+void GlfwWindow::handle_event(const Event &event)
+{
+	if (!queue_events)
+	{
+		deliver_event(event);
+		return;
+	}
+
+	// The events kept aside go first, so that they are not overtaken
+	if (push_pending_events() && push_event(event))
+	{
+		dropped_events = false;
+		return;
+	}
+
+	// Only the latest cursor position, size and focus matter, they are kept until there is room
+	switch (event.type)
+	{
+		case Event::Type::Mouse:
+			if (event.mouse_action == MouseAction::Move)
+			{
+				pending_move     = event;
+				has_pending_move = true;
+				return;
+			}
+			break;
+		case Event::Type::Resize:
+			pending_resize     = event;
+			has_pending_resize = true;
+			return;
+		case Event::Type::Focus:
+			pending_focus     = event;
+			has_pending_focus = true;
+			return;
+		default:
+			break;
+	}
+
+	if (!dropped_events)
+	{
+		LOGW("Window event queue is full, dropping key and button events until the application catches up");
+		dropped_events = true;
+	}
+}
+
+bool GlfwWindow::push_event(const Event &event)
+{
+	auto slot = event_queue->begin_push();
+
+	if (!slot)
+	{
+		return false;
+	}
+
+	*slot = event;
+	event_queue->end_push();
+
+	return true;
+}
+
+bool GlfwWindow::push_pending_events()
+{
+	if (has_pending_focus)
+	{
+		if (!push_event(pending_focus))
+		{
+			return false;
+		}
+		has_pending_focus = false;
+	}
+
+	if (has_pending_resize)
+	{
+		if (!push_event(pending_resize))
+		{
+			return false;
+		}
+		has_pending_resize = false;
+	}
+
+	if (has_pending_move)
+	{
+		if (!push_event(pending_move))
+		{
+			return false;
+		}
+		has_pending_move = false;
+	}
+
+	return true;
+}
+
+bool GlfwWindow::has_pending_events() const
+{
+	return has_pending_move || has_pending_resize || has_pending_focus;
+}
+
+void GlfwWindow::deliver_event(const Event &event)
+{
+	auto &app = platform.get_app();
+
+	switch (event.type)
+	{
+		case Event::Type::Key:
+			app.input_event(KeyInputEvent{platform, event.key_code, event.key_action});
+			break;
+		case Event::Type::Mouse:
+			app.input_event(MouseButtonInputEvent{platform, event.mouse_button, event.mouse_action, event.x, event.y});
+			break;
+		case Event::Type::Resize:
+			app.resize(event.width, event.height);
+			resize(event.width, event.height);
+			break;
+		case Event::Type::Focus:
+			app.set_focus(event.focused);
+			break;
+	}
+}
+
 void GlfwWindow::close()
 {
 	glfwSetWindowShouldClose(handle, GLFW_TRUE);
 }
 
+float GlfwWindow::get_dpi_factor() const
+{
+	return queue_events ? dpi_factor : read_dpi_factor();
+}
+
+float GlfwWindow::get_content_scale_factor() const
+{
+	return queue_events ? content_scale_factor : read_content_scale_factor();
+}
+
 /// @brief It calculates the dpi factor using the density from GLFW physical size
 /// <a href="https://www.glfw.org/docs/latest/monitor_guide.html#monitor_size">GLFW docs for dpi</a>
-float GlfwWindow::get_dpi_factor() const
+float GlfwWindow::read_dpi_factor() const
 {
 	auto primary_monitor = glfwGetPrimaryMonitor();
 	auto vidmode         = glfwGetVideoMode(primary_monitor);
@@ -371,7 +571,7 @@ float GlfwWindow::get_dpi_factor() const
 	return dpi_factor;
 }
 
-float GlfwWindow::get_content_scale_factor() const
+float GlfwWindow::read_content_scale_factor() const
 {
 	float xscale, yscale;
 	glfwGetWindowContentScale(handle, &xscale, &yscale);
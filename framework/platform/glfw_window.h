@@ -17,7 +17,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
+#include "common/spsc_ring.h"
 #include "common/vk_common.h"
+#include "platform/input_events.h"
 #include "platform/window.h"
 
 struct GLFWwindow;
@@ -30,6 +35,44 @@ namespace vkb
 class GlfwWindow : public Window
 {
   public:
+	/**
+	 * @brief An event of the window, as queued for the thread running the application
+	 */
+	struct Event
+	{
+		enum class Type
+		{
+			Key,
+			Mouse,
+			Resize,
+			Focus
+		};
+
+		Type type;
+
+		KeyCode key_code{KeyCode::Unknown};
+
+		KeyAction key_action{KeyAction::Unknown};
+
+		MouseButton mouse_button{MouseButton::Unknown};
+
+		MouseAction mouse_action{MouseAction::Unknown};
+
+		float x{0.0f};
+
+		float y{0.0f};
+
+		uint32_t width{0};
+
+		uint32_t height{0};
+
+		bool focused{false};
+	};
+
+	/// Events queued for the application thread. Once full, the latest cursor move, resize and focus
+	/// events are kept aside until there is room again, the key and button events are dropped.
+	static constexpr size_t EVENT_QUEUE_SIZE = 4096;
+
 	GlfwWindow(Platform &platform, uint32_t width = 1280, uint32_t height = 720);
 
 	virtual ~GlfwWindow();
@@ -40,6 +83,24 @@ class GlfwWindow : public Window
 
 	virtual void process_events() override;
 
+	bool supports_event_queue() const override;
+
+	/**
+	 * @brief The monitor and content scale factors are read once enabled, as GLFW only reads them on the thread owning the window
+	 */
+	void set_event_queue(bool enabled) override;
+
+	void wait_events() override;
+
+	void wake_events() override;
+
+	void dispatch_events() override;
+
+	/**
+	 * @brief Delivers an event to the application, or queues it while the event queue is enabled
+	 */
+	void handle_event(const Event &event);
+
 	virtual void close() override;
 
 	float get_dpi_factor() const override;
@@ -47,6 +108,50 @@ class GlfwWindow : public Window
 	float get_content_scale_factor() const override;
 
   private:
+	void deliver_event(const Event &event);
+
+	/**
+	 * @return Whether the event was queued, false if the queue is full
+	 */
+	bool push_event(const Event &event);
+
+	/**
+	 * @brief Queues the events kept aside while the queue was full
+	 * @return Whether none are left aside
+	 */
+	bool push_pending_events();
+
+	bool has_pending_events() const;
+
+	float read_dpi_factor() const;
+
+	float read_content_scale_factor() const;
+
 	GLFWwindow *handle = nullptr;
+
+	/// Filled by the thread owning the window, emptied by the thread running the application
+	std::unique_ptr<SpscRing<Event>> event_queue;
+
+	std::atomic<bool> queue_events{false};
+
+	/// Whether an event was dropped since the queue was last found full
+	bool dropped_events{false};
+
+	/// The latest events of each kind which cannot be dropped, kept aside by the thread owning the window while the queue is full
+	Event pending_move{Event::Type::Mouse};
+
+	Event pending_resize{Event::Type::Resize};
+
+	Event pending_focus{Event::Type::Focus};
+
+	bool has_pending_move{false};
+
+	bool has_pending_resize{false};
+
+	bool has_pending_focus{false};
+
+	float dpi_factor{1.0f};
+
+	float content_scale_factor{1.0f};
 };
 }        // namespace vkb
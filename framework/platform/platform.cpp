@@ -18,9 +18,12 @@
 #include "platform.h"
 
 #include <ctime>
+#include <exception>
 #include <mutex>
+#include <thread>
 #include <vector>
 
+#include <spdlog/async.h>
 #include <spdlog/async_logger.h>
 #include <spdlog/details/thread_pool.h>
 #include <spdlog/sinks/basic_file_sink.h>
@@ -44,7 +47,19 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 
 	auto sinks = get_platform_sinks();
 
-	auto logger = std::make_shared<spdlog::logger>("logger", sinks.begin(), sinks.end());
+	std::shared_ptr<spdlog::logger> logger;
+
+	if (active_app->get_options().contains("--async-log"))
+	{
+		// The messages are written to the sinks by a background thread, from a queue allocated once.
+		// A full queue drops its oldest messages rather than blocking the frame.
+		spdlog::init_thread_pool(ASYNC_LOG_QUEUE_SIZE, 1);
+		logger = std::make_shared<spdlog::async_logger>("logger", sinks.begin(), sinks.end(), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+	}
+	else
+	{
+		logger = std::make_shared<spdlog::logger>("logger", sinks.begin(), sinks.end());
+	}
 
 #ifdef VKB_DEBUG
 	logger->set_level(spdlog::level::debug);
@@ -69,6 +84,8 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 	// Set the app as headless
 	active_app->set_headless(active_app->get_options().contains("--headless"));
 
+	render_thread = active_app->get_options().contains("--render-thread");
+
 	create_window();
 
 	if (!window)
@@ -92,6 +109,54 @@ bool Platform::prepare()
 
 void Platform::main_loop()
 {
+	if (render_thread && !window->supports_event_queue())
+	{
+		LOGW("The window cannot queue its events, the frames run on the main thread");
+	}
+	else if (render_thread)
+	{
+		// Slow frames no longer delay the events, which the render thread picks up before each frame
+		window->set_event_queue(true);
+
+		// Errors of the frames are rethrown on the main thread, as they would be without the render thread
+		std::exception_ptr frame_exception;
+
+		std::thread frame_thread([this, &frame_exception]() {
+			try
+			{
+				while (!window->should_close())
+				{
+					window->dispatch_events();
+
+					run();
+				}
+			}
+			catch (...)
+			{
+				frame_exception = std::current_exception();
+				window->close();
+			}
+
+			// The main thread may be waiting for events
+			window->wake_events();
+		});
+
+		while (!window->should_close())
+		{
+			window->wait_events();
+		}
+
+		frame_thread.join();
+
+		window->set_event_queue(false);
+
+		if (frame_exception)
+		{
+			std::rethrow_exception(frame_exception);
+		}
+		return;
+	}
+
 	while (!window->should_close())
 	{
 		run();
@@ -132,7 +197,8 @@ void Platform::terminate(ExitCode code)
 	active_app.reset();
 	window.reset();
 
-	spdlog::drop_all();
+	// Writes the messages left in the queue of the asynchronous logger
+	spdlog::shutdown();
 }
 
 void Platform::close() const
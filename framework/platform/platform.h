@@ -57,6 +57,7 @@ class Platform
 	/**
 	 * @brief Handles the main loop of the platform
 	 * This should be overriden if a platform requires a specific main loop setup.
+	 * With --render-thread, the frames run on a render thread and the window events are queued for it.
 	 */
 	virtual void main_loop();
 
@@ -117,12 +118,18 @@ class Platform
 
 	bool benchmark_mode{false};
 
+	/// Whether the application runs on a thread of its own, while the calling thread processes the window events
+	bool render_thread{false};
+
 	uint32_t total_benchmark_frames{0};
 
 	uint32_t remaining_benchmark_frames{0};
 
 	Timer timer;
 
+	/// Number of messages the asynchronous logger queues for its thread
+	static constexpr size_t ASYNC_LOG_QUEUE_SIZE = 8192;
+
 	virtual std::vector<spdlog::sink_ptr> get_platform_sinks();
 
 	/**
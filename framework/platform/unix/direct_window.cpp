@@ -251,7 +251,7 @@ VkSurfaceKHR DirectWindow::create_surface(Instance &instance)
 	num_displays = 1;
 	VK_CHECK(vkGetPhysicalDeviceDisplayPropertiesKHR(phys_dev, &num_displays, &display_properties));
 
-	VkDisplayKHR display = display_properties.display;
+	display = display_properties.display;
 
 	// Calculate the display DPI
 	dpi = 25.4f * display_properties.physicalResolution.width / display_properties.physicalDimensions.width;
@@ -390,6 +390,11 @@ void DirectWindow::close()
 	keep_running = false;
 }
 
+VkDisplayKHR DirectWindow::get_display() const
+{
+	return display;
+}
+
 float DirectWindow::get_dpi_factor() const
 {
 	const float win_base_density = 96.0f;
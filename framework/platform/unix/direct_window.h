@@ -46,6 +46,8 @@ class DirectWindow : public Window
 
 	float get_dpi_factor() const override;
 
+	VkDisplayKHR get_display() const override;
+
   private:
 	void poll_terminal();
 
@@ -54,6 +56,7 @@ class DirectWindow : public Window
 
   private:
 	mutable bool   keep_running = true;
+	VkDisplayKHR   display      = VK_NULL_HANDLE;
 	float          dpi;
 	int            tty_fd;
 	struct termios termio;
@@ -32,6 +32,28 @@ void Window::process_events()
 {
 }
 
+bool Window::supports_event_queue() const
+{
+	return false;
+}
+
+void Window::set_event_queue(bool enabled)
+{
+}
+
+void Window::wait_events()
+{
+	process_events();
+}
+
+void Window::wake_events()
+{
+}
+
+void Window::dispatch_events()
+{
+}
+
 Platform &Window::get_platform()
 {
 	return platform;
@@ -58,4 +80,9 @@ float Window::get_content_scale_factor() const
 	return 1.0f;
 }
 
+VkDisplayKHR Window::get_display() const
+{
+	return VK_NULL_HANDLE;
+}
+
 }        // namespace vkb
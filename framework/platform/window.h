@@ -57,6 +57,32 @@ class Window
 	 */
 	virtual void process_events();
 
+	/**
+	 * @return Whether the window can queue its events for another thread, see set_event_queue()
+	 */
+	virtual bool supports_event_queue() const;
+
+	/**
+	 * @brief Queues the events processed by wait_events() on the thread owning the window, for dispatch_events() to
+	 *        deliver them on the thread running the application. Only the thread owning the window may change it.
+	 */
+	virtual void set_event_queue(bool enabled);
+
+	/**
+	 * @brief Waits for events and processes them, on the thread owning the window
+	 */
+	virtual void wait_events();
+
+	/**
+	 * @brief Wakes wait_events() up, from any thread
+	 */
+	virtual void wake_events();
+
+	/**
+	 * @brief Delivers the queued events to the application, on the thread running it
+	 */
+	virtual void dispatch_events();
+
 	/**
 	 * @brief Requests to close the window
 	 */
@@ -72,6 +98,11 @@ class Window
      */
 	virtual float get_content_scale_factor() const;
 
+	/**
+	 * @return The display a direct-to-display surface presents to, VK_NULL_HANDLE for other surfaces
+	 */
+	virtual VkDisplayKHR get_display() const;
+
 	Platform &get_platform();
 
 	void resize(uint32_t width, uint32_t height);
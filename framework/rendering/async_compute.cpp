@@ -0,0 +1,180 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/async_compute.h"
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "rendering/submit_batch.h"
+
+namespace vkb
+{
+AsyncCompute::AsyncCompute(RenderContext &render_context) :
+    render_context{render_context},
+    graphics_queue{render_context.get_device().get_suitable_graphics_queue()},
+    compute_queue{render_context.get_device().get_queue(render_context.get_device().get_queue_family_index(VK_QUEUE_COMPUTE_BIT), 0)}
+{
+	if (is_async())
+	{
+		LOGI("Async compute on queue family {}", compute_queue.get_family_index());
+	}
+}
+
+bool AsyncCompute::is_async() const
+{
+	return compute_queue.get_family_index() != graphics_queue.get_family_index();
+}
+
+const Queue &AsyncCompute::get_queue() const
+{
+	return is_async() ? compute_queue : graphics_queue;
+}
+
+CommandBuffer &AsyncCompute::request_command_buffer(CommandBuffer &graphics_command_buffer)
+{
+	if (!is_async())
+	{
+		return graphics_command_buffer;
+	}
+
+	auto &frame = render_context.get_active_frame();
+
+	if (command_buffer && recording_frame != &frame)
+	{
+		// The frame was not submitted with RenderContext::submit(), its reset freed the command buffer
+		LOGW("Async compute work of a previous frame was never submitted");
+
+		command_buffer  = nullptr;
+		wait_stage_mask = 0;
+	}
+
+	if (!command_buffer)
+	{
+		command_buffer  = &frame.request_command_buffer(compute_queue);
+		recording_frame = &frame;
+
+		command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	}
+
+	return *command_buffer;
+}
+
+void AsyncCompute::transfer_buffer(CommandBuffer &graphics_command_buffer, const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
+{
+	if (!is_async())
+	{
+		graphics_command_buffer.buffer_memory_barrier(buffer, offset, size, memory_barrier);
+		return;
+	}
+
+	assert(command_buffer && "Transfers should follow the work writing the buffer");
+
+	// The release makes the writes available, the acquire makes them visible to the graphics stages
+	BufferMemoryBarrier release = memory_barrier;
+	release.dst_stage_mask      = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	release.dst_access_mask     = 0;
+	release.old_queue_family    = compute_queue.get_family_index();
+	release.new_queue_family    = graphics_queue.get_family_index();
+
+	command_buffer->buffer_memory_barrier(buffer, offset, size, release);
+
+	BufferMemoryBarrier acquire = memory_barrier;
+	acquire.src_stage_mask      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	acquire.src_access_mask     = 0;
+	acquire.old_queue_family    = release.old_queue_family;
+	acquire.new_queue_family    = release.new_queue_family;
+
+	graphics_command_buffer.buffer_memory_barrier(buffer, offset, size, acquire);
+
+	wait_stage_mask |= memory_barrier.dst_stage_mask;
+}
+
+void AsyncCompute::transfer_image(CommandBuffer &graphics_command_buffer, const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
+{
+	if (!is_async())
+	{
+		graphics_command_buffer.image_memory_barrier(image_view, memory_barrier);
+		return;
+	}
+
+	assert(command_buffer && "Transfers should follow the work writing the image");
+
+	// Both halves of the transfer perform the same layout transition
+	ImageMemoryBarrier release = memory_barrier;
+	release.dst_stage_mask     = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	release.dst_access_mask    = 0;
+	release.old_queue_family   = compute_queue.get_family_index();
+	release.new_queue_family   = graphics_queue.get_family_index();
+
+	command_buffer->image_memory_barrier(image_view, release);
+
+	ImageMemoryBarrier acquire = memory_barrier;
+	acquire.src_stage_mask     = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	acquire.src_access_mask    = 0;
+	acquire.old_queue_family   = release.old_queue_family;
+	acquire.new_queue_family   = release.new_queue_family;
+
+	graphics_command_buffer.image_memory_barrier(image_view, acquire);
+
+	wait_stage_mask |= memory_barrier.dst_stage_mask;
+}
+
+void AsyncCompute::submit(SubmitBatch &batch)
+{
+	if (!command_buffer)
+	{
+		return;
+	}
+
+	auto &frame = render_context.get_active_frame();
+
+	assert(recording_frame == &frame && "Async compute work should be submitted with the frame recording it");
+
+	command_buffer->end();
+
+	VkCommandBuffer compute_command_buffer = command_buffer->get_handle();
+
+	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers    = &compute_command_buffer;
+
+	// Work whose results are not read by the graphics queue needs no semaphore
+	VkSemaphore signal_semaphore = VK_NULL_HANDLE;
+
+	if (wait_stage_mask)
+	{
+		signal_semaphore = frame.request_semaphore();
+
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores    = &signal_semaphore;
+	}
+
+	// The frame waits for its fences before being reset
+	VK_CHECK(compute_queue.submit({submit_info}, frame.request_fence()));
+
+	if (signal_semaphore != VK_NULL_HANDLE)
+	{
+		batch.add_wait_semaphore(signal_semaphore, wait_stage_mask);
+	}
+
+	command_buffer  = nullptr;
+	recording_frame = nullptr;
+	wait_stage_mask = 0;
+}
+}        // namespace vkb
@@ -0,0 +1,121 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Queue;
+class RenderContext;
+class RenderFrame;
+class SubmitBatch;
+
+namespace core
+{
+class Buffer;
+class ImageView;
+}        // namespace core
+
+/**
+ * @brief Runs compute work of a frame on a queue family without graphics, overlapping the raster work
+ *
+ * The work is recorded into a command buffer of the active frame, submitted by RenderContext::submit()
+ * ahead of the frame's graphics submission, which waits on it. The resources the work writes for the
+ * graphics queue are transferred with a release barrier on the compute family and an acquire barrier
+ * recorded into the graphics command buffer, the graphics submission waiting at the stages of the acquires.
+ *
+ * Resources must not be read by the graphics queue of an earlier frame while the work writes them,
+ * so they are usually per frame. Without a separate compute family the work is recorded into the
+ * graphics command buffer with plain barriers.
+ */
+class AsyncCompute
+{
+  public:
+	AsyncCompute(RenderContext &render_context);
+
+	AsyncCompute(const AsyncCompute &) = delete;
+
+	AsyncCompute(AsyncCompute &&) = delete;
+
+	~AsyncCompute() = default;
+
+	AsyncCompute &operator=(const AsyncCompute &) = delete;
+
+	AsyncCompute &operator=(AsyncCompute &&) = delete;
+
+	/**
+	 * @return Whether the work runs on a compute family separate from the graphics one
+	 */
+	bool is_async() const;
+
+	/**
+	 * @return The queue the work is submitted to
+	 */
+	const Queue &get_queue() const;
+
+	/**
+	 * @brief Returns the command buffer to record compute work of the active frame into
+	 * @param graphics_command_buffer The frame's command buffer, returned if the work is not async
+	 */
+	CommandBuffer &request_command_buffer(CommandBuffer &graphics_command_buffer);
+
+	/**
+	 * @brief Makes a buffer written by the compute work available to the graphics queue
+	 * @param graphics_command_buffer The frame's command buffer, which records the acquire
+	 * @param buffer The buffer written by the work
+	 * @param offset Start of the range written
+	 * @param size Size of the range written
+	 * @param memory_barrier Stages and accesses of the compute writes and of the graphics reads
+	 */
+	void transfer_buffer(CommandBuffer &graphics_command_buffer, const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier);
+
+	/**
+	 * @brief Makes an image written by the compute work available to the graphics queue
+	 * @param graphics_command_buffer The frame's command buffer, which records the acquire
+	 * @param image_view The view of the image written by the work
+	 * @param memory_barrier Stages, accesses and layouts of the compute writes and of the graphics reads
+	 */
+	void transfer_image(CommandBuffer &graphics_command_buffer, const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier);
+
+	/**
+	 * @brief Submits the work recorded in the active frame, and makes the batch wait for it
+	 *        Called by RenderContext::submit().
+	 * @param batch The graphics submission of the frame
+	 */
+	void submit(SubmitBatch &batch);
+
+  private:
+	RenderContext &render_context;
+
+	const Queue &graphics_queue;
+
+	const Queue &compute_queue;
+
+	/// Command buffer recording the work of the active frame, if any
+	CommandBuffer *command_buffer{nullptr};
+
+	/// Frame the command buffer belongs to
+	RenderFrame *recording_frame{nullptr};
+
+	/// Stages of the graphics submission waiting for the work
+	VkPipelineStageFlags wait_stage_mask{0};
+};
+}        // namespace vkb
@@ -0,0 +1,244 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/attachment_allocator.h"
+
+#include <numeric>
+
+#include "common/strings.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+inline bool lifetimes_overlap(const AttachmentAllocator::Request &a, const AttachmentAllocator::Request &b)
+{
+	return a.first_pass <= b.last_pass && b.first_pass <= a.last_pass;
+}
+
+inline bool ranges_overlap(VkDeviceSize a_offset, VkDeviceSize a_size, VkDeviceSize b_offset, VkDeviceSize b_size)
+{
+	return a_offset < b_offset + b_size && b_offset < a_offset + a_size;
+}
+
+inline VkDeviceSize align_offset(VkDeviceSize offset, VkDeviceSize alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+}        // namespace
+
+AttachmentAllocator::AttachmentAllocator(Device &device, const VkExtent3D &extent) :
+    device{device},
+    extent{extent}
+{
+}
+
+AttachmentAllocator::~AttachmentAllocator()
+{
+	// Images which were never handed out are still owned by the allocator
+	for (auto &placement : placements)
+	{
+		if (placement.image != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(device.get_handle(), placement.image, nullptr);
+		}
+	}
+
+	for (auto block : blocks)
+	{
+		vmaFreeMemory(device.get_memory_allocator(), block);
+	}
+}
+
+uint32_t AttachmentAllocator::request(VkFormat format, VkImageUsageFlags usage, uint32_t first_pass, uint32_t last_pass, VkSampleCountFlagBits samples)
+{
+	assert(blocks.empty() && "Attachments should be requested before allocating");
+	assert(first_pass <= last_pass && "Attachment lifetime should not be empty");
+
+	Request request{};
+	request.format     = format;
+	request.usage      = usage;
+	request.samples    = samples;
+	request.first_pass = first_pass;
+	request.last_pass  = last_pass;
+
+	requests.push_back(request);
+
+	return to_u32(requests.size() - 1);
+}
+
+std::vector<VkMemoryRequirements> AttachmentAllocator::plan()
+{
+	std::vector<size_t> order(placements.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return placements[a].requirements.size > placements[b].requirements.size;
+	});
+
+	std::vector<VkMemoryRequirements> block_requirements;
+	std::vector<std::vector<size_t>>  block_attachments;
+
+	for (auto i : order)
+	{
+		auto &placement    = placements[i];
+		auto &requirements = placement.requirements;
+
+		bool placed = false;
+
+		for (size_t block = 0; block < block_requirements.size() && !placed; ++block)
+		{
+			if ((block_requirements[block].memoryTypeBits & requirements.memoryTypeBits) == 0)
+			{
+				continue;
+			}
+
+			// Candidate offsets are the block start and the end of every placed range, lowest first
+			std::vector<VkDeviceSize> candidates{0};
+			for (auto other : block_attachments[block])
+			{
+				candidates.push_back(placements[other].offset + placements[other].requirements.size);
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			for (auto candidate : candidates)
+			{
+				auto offset = align_offset(candidate, requirements.alignment);
+
+				bool fits = std::none_of(block_attachments[block].begin(), block_attachments[block].end(), [&](size_t other) {
+					return lifetimes_overlap(requests[i], requests[other]) &&
+					       ranges_overlap(offset, requirements.size, placements[other].offset, placements[other].requirements.size);
+				});
+
+				if (fits)
+				{
+					placement.block  = block;
+					placement.offset = offset;
+					placed           = true;
+					break;
+				}
+			}
+		}
+
+		if (!placed)
+		{
+			placement.block  = block_requirements.size();
+			placement.offset = 0;
+
+			block_requirements.push_back({0, requirements.alignment, requirements.memoryTypeBits});
+			block_attachments.emplace_back();
+		}
+
+		auto &block_requirement = block_requirements[placement.block];
+
+		block_requirement.size           = std::max(block_requirement.size, placement.offset + requirements.size);
+		block_requirement.alignment      = std::max(block_requirement.alignment, requirements.alignment);
+		block_requirement.memoryTypeBits = block_requirement.memoryTypeBits & requirements.memoryTypeBits;
+
+		block_attachments[placement.block].push_back(i);
+	}
+
+	return block_requirements;
+}
+
+std::vector<core::Image> AttachmentAllocator::allocate()
+{
+	assert(blocks.empty() && "Attachments have already been allocated");
+
+	for (auto &request : requests)
+	{
+		VkImageCreateInfo image_info{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+		image_info.imageType   = VK_IMAGE_TYPE_2D;
+		image_info.format      = request.format;
+		image_info.extent      = extent;
+		image_info.mipLevels   = 1;
+		image_info.arrayLayers = 1;
+		image_info.samples     = request.samples;
+		image_info.tiling      = VK_IMAGE_TILING_OPTIMAL;
+		image_info.usage       = request.usage;
+		image_info.pNext       = device.get_compression_control(request.usage);
+
+		Placement placement{};
+
+		auto result = vkCreateImage(device.get_handle(), &image_info, nullptr, &placement.image);
+
+		if (result != VK_SUCCESS)
+		{
+			throw VulkanException{result, "Cannot create aliased Image"};
+		}
+
+		vkGetImageMemoryRequirements(device.get_handle(), placement.image, &placement.requirements);
+
+		naive_size += placement.requirements.size;
+
+		placements.push_back(placement);
+	}
+
+	auto block_requirements = plan();
+
+	for (auto &requirements : block_requirements)
+	{
+		VmaAllocationCreateInfo memory_info{};
+		memory_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		VmaAllocation block{VK_NULL_HANDLE};
+
+		VK_CHECK(vmaAllocateMemory(device.get_memory_allocator(), &requirements, &memory_info, &block, nullptr));
+
+		device.check_memory_budget(block, "Aliased attachments");
+
+		blocks.push_back(block);
+
+		aliased_size += requirements.size;
+	}
+
+	std::vector<core::Image> images;
+
+	for (size_t i = 0; i < placements.size(); ++i)
+	{
+		auto &request   = requests[i];
+		auto &placement = placements[i];
+
+		VK_CHECK(vmaBindImageMemory2(device.get_memory_allocator(), blocks[placement.block], placement.offset, placement.image, nullptr));
+
+		LOGI("Attachment {} ({}) uses passes {}-{}: {} KB at offset {} KB of block {}",
+		     i, to_string(request.format), request.first_pass, request.last_pass,
+		     placement.requirements.size / 1024, placement.offset / 1024, placement.block);
+
+		images.emplace_back(device, placement.image, blocks[placement.block], extent, request.format, request.usage, request.samples);
+
+		// The image now owns the handle
+		placement.image = VK_NULL_HANDLE;
+	}
+
+	LOGI("Aliased attachments use {} KB in {} block(s) instead of {} KB, saving {} KB",
+	     aliased_size / 1024, blocks.size(), naive_size / 1024, (naive_size - aliased_size) / 1024);
+
+	return images;
+}
+
+VkDeviceSize AttachmentAllocator::get_aliased_size() const
+{
+	return aliased_size;
+}
+
+VkDeviceSize AttachmentAllocator::get_naive_size() const
+{
+	return naive_size;
+}
+}        // namespace vkb
@@ -0,0 +1,124 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief Places render target images whose lifetimes do not overlap in the same memory
+ *        Each attachment declares the range of passes of the RenderPipeline which use it.
+ *        Attachments with disjoint ranges share memory, so their contents do not survive
+ *        across passes: they should be cleared or not loaded at the start of their lifetime.
+ */
+class AttachmentAllocator
+{
+  public:
+	/**
+	 * @brief Description of an attachment and of the passes using it
+	 */
+	struct Request
+	{
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		VkImageUsageFlags usage{0};
+
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+
+		/// First pass reading or writing the attachment
+		uint32_t first_pass{0};
+
+		/// Last pass reading or writing the attachment
+		uint32_t last_pass{0};
+	};
+
+	AttachmentAllocator(Device &device, const VkExtent3D &extent);
+
+	AttachmentAllocator(const AttachmentAllocator &) = delete;
+
+	AttachmentAllocator(AttachmentAllocator &&) = delete;
+
+	~AttachmentAllocator();
+
+	AttachmentAllocator &operator=(const AttachmentAllocator &) = delete;
+
+	AttachmentAllocator &operator=(AttachmentAllocator &&) = delete;
+
+	/**
+	 * @brief Requests an attachment used from the first to the last pass, both included
+	 * @return The index of the image returned by allocate
+	 */
+	uint32_t request(VkFormat format, VkImageUsageFlags usage, uint32_t first_pass, uint32_t last_pass, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
+
+	/**
+	 * @brief Plans the memory of the requested attachments, allocates it and creates the images
+	 *        The allocator owns the memory, so it must outlive the images.
+	 * @return The images in the order they were requested
+	 */
+	std::vector<core::Image> allocate();
+
+	/**
+	 * @return The memory allocated for the attachments
+	 */
+	VkDeviceSize get_aliased_size() const;
+
+	/**
+	 * @return The memory the attachments would use with an allocation each
+	 */
+	VkDeviceSize get_naive_size() const;
+
+  private:
+	struct Placement
+	{
+		VkImage image{VK_NULL_HANDLE};
+
+		VkMemoryRequirements requirements{};
+
+		/// Index of the memory block the image is bound to
+		size_t block{0};
+
+		VkDeviceSize offset{0};
+	};
+
+	/**
+	 * @brief Assigns a block and an offset to every attachment, largest first
+	 *        An attachment goes at the lowest offset of the first compatible block which does
+	 *        not overlap the memory of any attachment living in the same passes.
+	 * @return The size, alignment and memory types of each block
+	 */
+	std::vector<VkMemoryRequirements> plan();
+
+	Device &device;
+
+	VkExtent3D extent{};
+
+	std::vector<Request> requests;
+
+	std::vector<Placement> placements;
+
+	std::vector<VmaAllocation> blocks;
+
+	VkDeviceSize aliased_size{0};
+
+	VkDeviceSize naive_size{0};
+};
+}        // namespace vkb
@@ -0,0 +1,283 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/bindless_materials.h"
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/sampler.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+BindlessMaterials::BindlessMaterials(RenderContext &render_context, sg::Scene &scene) :
+    render_context{render_context},
+    scene{scene},
+    textures{scene.get_components<sg::Texture>()}
+{
+	auto &device = render_context.get_device();
+
+	for (auto texture : textures)
+	{
+		texture_slots.emplace(texture, to_u32(texture_slots.size()));
+	}
+
+	for (auto material : scene.get_components<sg::PBRMaterial>())
+	{
+		material_indices.emplace(material, to_u32(materials.size()));
+		materials.push_back(material);
+	}
+
+	compile_materials();
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			auto variant = sub_mesh->get_shader_variant();
+			variant.add_define("BINDLESS_MATERIALS");
+			variant.add_define("BINDLESS_TEXTURE_COUNT=" + std::to_string(textures.size()));
+
+			shader_variants.emplace(sub_mesh, std::move(variant));
+		}
+	}
+
+	// Matches the set reflected from the fragment shaders, so that the layouts are compatible
+	std::vector<ShaderResource> resources;
+
+	if (!textures.empty())
+	{
+		ShaderResource texture_resource{};
+		texture_resource.stages     = VK_SHADER_STAGE_FRAGMENT_BIT;
+		texture_resource.type       = ShaderResourceType::ImageSampler;
+		texture_resource.mode       = ShaderResourceMode::Static;
+		texture_resource.set        = SET_INDEX;
+		texture_resource.binding    = TEXTURES_BINDING;
+		texture_resource.array_size = to_u32(textures.size());
+		texture_resource.name       = "bindless_textures";
+
+		resources.push_back(texture_resource);
+	}
+
+	ShaderResource material_resource{};
+	material_resource.stages     = VK_SHADER_STAGE_FRAGMENT_BIT;
+	material_resource.type       = ShaderResourceType::BufferStorage;
+	material_resource.mode       = ShaderResourceMode::Static;
+	material_resource.set        = SET_INDEX;
+	material_resource.binding    = MATERIALS_BINDING;
+	material_resource.array_size = 1;
+	material_resource.name       = "BindlessMaterials";
+
+	resources.push_back(material_resource);
+
+	descriptor_set_layout = std::make_unique<DescriptorSetLayout>(device, SET_INDEX, resources);
+
+	descriptor_pool = std::make_unique<DescriptorPool>(device, *descriptor_set_layout, to_u32(render_context.get_render_frames().size()));
+
+	LOGI("Bindless table of {} textures and {} materials", textures.size(), materials.size());
+}
+
+bool BindlessMaterials::is_supported(Device &device, sg::Scene &scene)
+{
+	if (!device.get_gpu().get_requested_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		return false;
+	}
+
+	auto &limits = device.get_gpu().get_properties().limits;
+
+	auto max_texture_count = std::min({limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages,
+	                                   limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages});
+
+	return scene.get_components<sg::Texture>().size() <= max_texture_count;
+}
+
+void BindlessMaterials::update()
+{
+	auto &device = render_context.get_device();
+
+	frame_resources.resize(render_context.get_render_frames().size());
+
+	// The frame's previous submission completed, its resources are free
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	if (material_revision != scene.get_component_revision<sg::PBRMaterial>())
+	{
+		compile_materials();
+	}
+
+	auto material_size = material_data.size() * sizeof(Material);
+
+	if (!resources.material_buffer)
+	{
+		resources.material_buffer = std::make_unique<core::Buffer>(device, material_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+
+	if (resources.material_revision != material_revision)
+	{
+		resources.material_buffer->update(reinterpret_cast<const uint8_t *>(material_data.data()), material_size);
+
+		resources.material_revision = material_revision;
+	}
+
+	// Every element of the array needs a valid descriptor, textures without an image show the first one with an image
+	std::vector<VkDescriptorImageInfo> texture_infos(textures.size());
+	VkDescriptorImageInfo              fallback_info{};
+
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		auto image   = textures[i]->get_image();
+		auto sampler = textures[i]->get_sampler();
+
+		if (image && sampler)
+		{
+			texture_infos[i].sampler     = sampler->vk_sampler.get_handle();
+			texture_infos[i].imageView   = image->get_vk_image_view().get_handle();
+			texture_infos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			if (fallback_info.imageView == VK_NULL_HANDLE)
+			{
+				fallback_info = texture_infos[i];
+			}
+		}
+	}
+
+	std::vector<VkImageView> image_views(textures.size());
+
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		if (texture_infos[i].imageView == VK_NULL_HANDLE)
+		{
+			texture_infos[i] = fallback_info;
+		}
+
+		image_views[i] = texture_infos[i].imageView;
+	}
+
+	if (resources.descriptor_set && resources.image_views == image_views)
+	{
+		return;
+	}
+
+	if (!textures.empty() && fallback_info.imageView == VK_NULL_HANDLE)
+	{
+		LOGW("Bindless table has no texture with an image to write");
+	}
+
+	BindingMap<VkDescriptorBufferInfo> buffer_infos;
+	buffer_infos[MATERIALS_BINDING][0] = {resources.material_buffer->get_handle(), 0, material_size};
+
+	BindingMap<VkDescriptorImageInfo> image_infos;
+
+	for (size_t i = 0; i < texture_infos.size(); ++i)
+	{
+		if (texture_infos[i].imageView != VK_NULL_HANDLE)
+		{
+			image_infos[TEXTURES_BINDING][to_u32(i)] = texture_infos[i];
+		}
+	}
+
+	if (resources.descriptor_set)
+	{
+		resources.descriptor_set->reset(buffer_infos, image_infos);
+	}
+	else
+	{
+		resources.descriptor_set = std::make_unique<DescriptorSet>(device, *descriptor_set_layout, *descriptor_pool, buffer_infos, image_infos);
+	}
+
+	resources.descriptor_set->update();
+
+	resources.image_views = std::move(image_views);
+}
+
+VkDescriptorSet BindlessMaterials::get_descriptor_set() const
+{
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	assert(resources.descriptor_set && "The active frame must be updated before drawing");
+
+	return resources.descriptor_set->get_handle();
+}
+
+uint32_t BindlessMaterials::get_material_index(const sg::Material &material) const
+{
+	auto index_it = material_indices.find(&material);
+
+	assert(index_it != material_indices.end() && "Material is not in the scene of the table");
+
+	return index_it->second;
+}
+
+const ShaderVariant &BindlessMaterials::get_shader_variant(const sg::SubMesh &sub_mesh) const
+{
+	auto variant_it = shader_variants.find(&sub_mesh);
+
+	assert(variant_it != shader_variants.end() && "Submesh is not in the scene of the table");
+
+	return variant_it->second;
+}
+
+void BindlessMaterials::compile_materials()
+{
+	material_data.assign(std::max<size_t>(materials.size(), 1), Material{});
+
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(materials[i]);
+
+		auto &material_entry             = material_data[i];
+		material_entry.base_color_factor = pbr_material->base_color_factor;
+		material_entry.emissive_factor   = pbr_material->emissive;
+		material_entry.alpha_cutoff      = pbr_material->alpha_cutoff;
+		material_entry.metallic_factor   = pbr_material->metallic_factor;
+		material_entry.roughness_factor  = pbr_material->roughness_factor;
+
+		material_entry.base_color_texture         = find_texture_slot(*pbr_material, "base_color_texture");
+		material_entry.normal_texture             = find_texture_slot(*pbr_material, "normal_texture");
+		material_entry.metallic_roughness_texture = find_texture_slot(*pbr_material, "metallic_roughness_texture");
+		material_entry.occlusion_texture          = find_texture_slot(*pbr_material, "occlusion_texture");
+		material_entry.emissive_texture           = find_texture_slot(*pbr_material, "emissive_texture");
+
+		material_entry.flags = (pbr_material->alpha_mode == sg::AlphaMode::Mask ? ALPHA_MASK : 0u) |
+		                       (pbr_material->alpha_mode == sg::AlphaMode::Blend ? ALPHA_BLEND : 0u) |
+		                       (pbr_material->double_sided ? DOUBLE_SIDED : 0u);
+	}
+
+	material_revision = scene.get_component_revision<sg::PBRMaterial>();
+}
+
+uint32_t BindlessMaterials::find_texture_slot(const sg::Material &material, const std::string &name) const
+{
+	auto texture_it = material.textures.find(name);
+
+	if (texture_it == material.textures.end())
+	{
+		return NO_TEXTURE;
+	}
+
+	auto slot_it = texture_slots.find(texture_it->second);
+
+	return slot_it == texture_slots.end() ? NO_TEXTURE : slot_it->second;
+}
+}        // namespace vkb
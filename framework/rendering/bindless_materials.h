@@ -0,0 +1,198 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/descriptor_pool.h"
+#include "core/descriptor_set.h"
+#include "core/descriptor_set_layout.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class Device;
+class RenderContext;
+
+namespace sg
+{
+class Material;
+class Scene;
+class SubMesh;
+class Texture;
+}        // namespace sg
+
+/**
+ * @brief Table of all the textures and materials of a scene, bound once for all the draws of a subpass
+ *
+ * The textures are written into an array of combined image samplers, and the materials into a
+ * storage buffer whose entries refer to the array. A draw only pushes the index of its material,
+ * so draws with different materials share their descriptor sets. The shaders read the table when
+ * compiled with the variants of get_shader_variant(), which define BINDLESS_MATERIALS and the
+ * BINDLESS_TEXTURE_COUNT size of the array.
+ *
+ * The materials are compiled into their packed entries once, and again when the scene marks a material
+ * changed. Each render frame has its own descriptor set and material buffer, written by update() before
+ * the frame's draws are recorded when they are out of date, so a frame never updates a set in use by the
+ * previous ones. Textures whose image changes, such as streamed textures, are written again into the next frames.
+ */
+class BindlessMaterials
+{
+  public:
+	/// Set of the table in the shaders
+	static constexpr uint32_t SET_INDEX = 1;
+
+	static constexpr uint32_t TEXTURES_BINDING = 0;
+
+	static constexpr uint32_t MATERIALS_BINDING = 1;
+
+	/// Texture index of the materials without the texture
+	static constexpr uint32_t NO_TEXTURE = ~0u;
+
+	/// Flags of the materials
+	static constexpr uint32_t ALPHA_MASK = 1u << 0;
+
+	static constexpr uint32_t ALPHA_BLEND = 1u << 1;
+
+	static constexpr uint32_t DOUBLE_SIDED = 1u << 2;
+
+	BindlessMaterials(RenderContext &render_context, sg::Scene &scene);
+
+	BindlessMaterials(const BindlessMaterials &) = delete;
+
+	BindlessMaterials(BindlessMaterials &&) = delete;
+
+	~BindlessMaterials() = default;
+
+	BindlessMaterials &operator=(const BindlessMaterials &) = delete;
+
+	BindlessMaterials &operator=(BindlessMaterials &&) = delete;
+
+	/**
+	 * @return Whether the device can index the textures of a scene from a shader
+	 */
+	static bool is_supported(Device &device, sg::Scene &scene);
+
+	/**
+	 * @brief Writes the materials, and the textures whose image changed, into the resources of the active frame
+	 *        Must be called before the draws of the frame are recorded.
+	 */
+	void update();
+
+	/**
+	 * @return The descriptor set of the active frame
+	 */
+	VkDescriptorSet get_descriptor_set() const;
+
+	/**
+	 * @return The index of a material in the table, pushed as a push constant by its draws
+	 */
+	uint32_t get_material_index(const sg::Material &material) const;
+
+	/**
+	 * @return The shader variant of a submesh with the defines of the table
+	 */
+	const ShaderVariant &get_shader_variant(const sg::SubMesh &sub_mesh) const;
+
+  private:
+	/// Layout of the materials in the shaders
+	struct alignas(16) Material
+	{
+		glm::vec4 base_color_factor;
+
+		glm::vec3 emissive_factor;
+
+		float alpha_cutoff;
+
+		float metallic_factor;
+
+		float roughness_factor;
+
+		uint32_t base_color_texture;
+
+		uint32_t normal_texture;
+
+		uint32_t metallic_roughness_texture;
+
+		uint32_t occlusion_texture;
+
+		uint32_t emissive_texture;
+
+		uint32_t flags;
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr<core::Buffer> material_buffer;
+
+		/// Revision of the materials in the buffer
+		uint64_t material_revision{~0ull};
+
+		std::unique_ptr<DescriptorSet> descriptor_set;
+
+		/// Image views of the textures written into the set
+		std::vector<VkImageView> image_views;
+	};
+
+	/**
+	 * @return The slot of a texture of a material, NO_TEXTURE if the material does not have it
+	 */
+	uint32_t find_texture_slot(const sg::Material &material, const std::string &name) const;
+
+	/**
+	 * @brief Packs the materials into their entries in the shaders
+	 */
+	void compile_materials();
+
+	RenderContext &render_context;
+
+	sg::Scene &scene;
+
+	std::vector<sg::Texture *> textures;
+
+	std::unordered_map<const sg::Texture *, uint32_t> texture_slots;
+
+	std::vector<const sg::Material *> materials;
+
+	std::unordered_map<const sg::Material *, uint32_t> material_indices;
+
+	/// Entries of the materials, by material index
+	std::vector<Material> material_data;
+
+	/// Revision of the materials of the scene which were compiled
+	uint64_t material_revision{0};
+
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> shader_variants;
+
+	std::unique_ptr<DescriptorSetLayout> descriptor_set_layout;
+
+	std::unique_ptr<DescriptorPool> descriptor_pool;
+
+	/// Resources of each render frame, by frame index
+	std::vector<FrameResources> frame_resources;
+};
+}        // namespace vkb
@@ -0,0 +1,415 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/command_stream.h"
+
+#include "core/buffer.h"
+#include "core/command_buffer.h"
+#include "core/image_view.h"
+#include "core/pipeline_layout.h"
+#include "core/sampler.h"
+
+namespace vkb
+{
+namespace
+{
+template <class T>
+void append_range(std::vector<T> &arena, const std::vector<T> &values, uint32_t &first, uint32_t &count)
+{
+	first = to_u32(arena.size());
+	count = to_u32(values.size());
+
+	arena.insert(arena.end(), values.begin(), values.end());
+}
+}        // namespace
+
+void CommandStream::reset()
+{
+	current_state = {};
+
+	current_bindings.clear();
+	bindings_dirty = true;
+
+	current_vertex_buffers.clear();
+	vertex_buffers_dirty = true;
+
+	current_push_constants.clear();
+
+	current_index_buffer = nullptr;
+
+	states.clear();
+	draws.clear();
+	binding_arena.clear();
+	vertex_buffer_arena.clear();
+	push_constant_arena.clear();
+}
+
+void CommandStream::bind_pipeline_layout(PipelineLayout &pipeline_layout)
+{
+	current_state.pipeline_layout = &pipeline_layout;
+	current_state.pipeline_state.set_pipeline_layout(pipeline_layout);
+}
+
+void CommandStream::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
+{
+	current_state.pipeline_state.set_specialization_constant(constant_id, data);
+}
+
+void CommandStream::set_vertex_input_state(const VertexInputState &state_info)
+{
+	current_state.pipeline_state.set_vertex_input_state(state_info);
+}
+
+void CommandStream::set_input_assembly_state(const InputAssemblyState &state_info)
+{
+	current_state.pipeline_state.set_input_assembly_state(state_info);
+}
+
+void CommandStream::set_rasterization_state(const RasterizationState &state_info)
+{
+	current_state.pipeline_state.set_rasterization_state(state_info);
+}
+
+void CommandStream::set_viewport_state(const ViewportState &state_info)
+{
+	current_state.pipeline_state.set_viewport_state(state_info);
+}
+
+void CommandStream::set_multisample_state(const MultisampleState &state_info)
+{
+	current_state.pipeline_state.set_multisample_state(state_info);
+}
+
+void CommandStream::set_depth_stencil_state(const DepthStencilState &state_info)
+{
+	current_state.pipeline_state.set_depth_stencil_state(state_info);
+}
+
+void CommandStream::set_color_blend_state(const ColorBlendState &state_info)
+{
+	current_state.pipeline_state.set_color_blend_state(state_info);
+}
+
+void CommandStream::push_constants(const std::vector<uint8_t> &values)
+{
+	current_push_constants.insert(current_push_constants.end(), values.begin(), values.end());
+}
+
+void CommandStream::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
+{
+	bind({BindingType::Buffer, set, binding, array_element, &buffer, offset, range, nullptr, nullptr});
+}
+
+void CommandStream::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
+{
+	bind({BindingType::Image, set, binding, array_element, nullptr, 0, 0, &image_view, &sampler});
+}
+
+void CommandStream::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
+{
+	bind({BindingType::Input, set, binding, array_element, nullptr, 0, 0, &image_view, nullptr});
+}
+
+void CommandStream::bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets)
+{
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		VertexBufferPacket packet{first_binding + to_u32(i), &buffers[i].get(), offsets[i]};
+
+		auto it = std::find_if(current_vertex_buffers.begin(), current_vertex_buffers.end(),
+		                       [&packet](const VertexBufferPacket &bound) { return bound.binding == packet.binding; });
+
+		if (it == current_vertex_buffers.end())
+		{
+			current_vertex_buffers.push_back(packet);
+		}
+		else
+		{
+			*it = packet;
+		}
+	}
+
+	vertex_buffers_dirty = true;
+}
+
+void CommandStream::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
+{
+	current_index_buffer = &buffer;
+	current_index_offset = offset;
+	current_index_type   = index_type;
+}
+
+void CommandStream::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+	DrawPacket packet{};
+	packet.indexed        = false;
+	packet.count          = vertex_count;
+	packet.instance_count = instance_count;
+	packet.first          = first_vertex;
+	packet.first_instance = first_instance;
+
+	append_draw(packet);
+}
+
+void CommandStream::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+{
+	assert(current_index_buffer && "An index buffer must be bound for indexed draws");
+
+	DrawPacket packet{};
+	packet.indexed        = true;
+	packet.count          = index_count;
+	packet.instance_count = instance_count;
+	packet.first          = first_index;
+	packet.vertex_offset  = vertex_offset;
+	packet.first_instance = first_instance;
+
+	append_draw(packet);
+}
+
+size_t CommandStream::get_draw_count() const
+{
+	return draws.size();
+}
+
+void CommandStream::bind(const BindingPacket &packet)
+{
+	auto it = std::find_if(current_bindings.begin(), current_bindings.end(), [&packet](const BindingPacket &bound) {
+		return bound.set == packet.set && bound.binding == packet.binding && bound.array_element == packet.array_element;
+	});
+
+	if (it == current_bindings.end())
+	{
+		current_bindings.push_back(packet);
+	}
+	else
+	{
+		*it = packet;
+	}
+
+	bindings_dirty = true;
+}
+
+void CommandStream::append_draw(DrawPacket &packet)
+{
+	assert(current_state.pipeline_layout && "A pipeline layout must be bound before drawing");
+
+	// Consecutive draws with the same state share their entry
+	auto &pipeline_state = current_state.pipeline_state;
+
+	if (states.empty() || pipeline_state.is_dirty())
+	{
+		pipeline_state.clear_dirty();
+
+		states.push_back(current_state);
+	}
+
+	if (bindings_dirty)
+	{
+		append_range(binding_arena, current_bindings, last_bindings.first, last_bindings.count);
+
+		bindings_dirty = false;
+	}
+
+	if (vertex_buffers_dirty)
+	{
+		append_range(vertex_buffer_arena, current_vertex_buffers, last_vertex_buffers.first, last_vertex_buffers.count);
+
+		vertex_buffers_dirty = false;
+	}
+
+	// Push constants only apply to the next draw
+	append_range(push_constant_arena, current_push_constants, packet.push_constants.first, packet.push_constants.count);
+	current_push_constants.clear();
+
+	size_t sort_key = pipeline_state.get_hash();
+	hash_combine(sort_key, pipeline_state.get_specialization_constant_state().get_hash());
+
+	packet.sort_key       = sort_key;
+	packet.state_index    = to_u32(states.size() - 1);
+	packet.bindings       = last_bindings;
+	packet.vertex_buffers = last_vertex_buffers;
+
+	if (packet.indexed)
+	{
+		packet.index_buffer = current_index_buffer;
+		packet.index_offset = current_index_offset;
+		packet.index_type   = current_index_type;
+	}
+
+	draws.push_back(packet);
+}
+
+void CommandStream::replay(CommandBuffer &command_buffer, bool sort_draws) const
+{
+	replay({this}, command_buffer, sort_draws);
+}
+
+void CommandStream::replay(const std::vector<const CommandStream *> &streams, CommandBuffer &command_buffer, bool sort_draws)
+{
+	struct DrawRef
+	{
+		uint32_t stream_index;
+
+		const DrawPacket *packet;
+	};
+
+	std::vector<DrawRef> order;
+	for (uint32_t stream_index = 0; stream_index < streams.size(); ++stream_index)
+	{
+		for (auto &packet : streams[stream_index]->draws)
+		{
+			order.push_back({stream_index, &packet});
+		}
+	}
+
+	if (sort_draws)
+	{
+		// Group the draws by pipeline, then by bindings, keeping the recording order otherwise
+		std::stable_sort(order.begin(), order.end(), [](const DrawRef &lhs, const DrawRef &rhs) {
+			if (lhs.packet->sort_key != rhs.packet->sort_key)
+			{
+				return lhs.packet->sort_key < rhs.packet->sort_key;
+			}
+			if (lhs.stream_index != rhs.stream_index)
+			{
+				return lhs.stream_index < rhs.stream_index;
+			}
+			return lhs.packet->bindings.first < rhs.packet->bindings.first;
+		});
+	}
+
+	auto same_binding = [](const BindingPacket &lhs, const BindingPacket &rhs) {
+		return lhs.type == rhs.type && lhs.set == rhs.set && lhs.binding == rhs.binding && lhs.array_element == rhs.array_element &&
+		       lhs.buffer == rhs.buffer && lhs.offset == rhs.offset && lhs.range == rhs.range &&
+		       lhs.image_view == rhs.image_view && lhs.sampler == rhs.sampler;
+	};
+
+	auto same_vertex_buffer = [](const VertexBufferPacket &lhs, const VertexBufferPacket &rhs) {
+		return lhs.binding == rhs.binding && lhs.buffer == rhs.buffer && lhs.offset == rhs.offset;
+	};
+
+	const StateEntry *        applied_state{nullptr};
+	const BindingPacket *     applied_bindings{nullptr};
+	size_t                    applied_binding_count{0};
+	const VertexBufferPacket *applied_vertex_buffers{nullptr};
+	size_t                    applied_vertex_buffer_count{0};
+
+	std::vector<uint8_t> push_constant_data;
+
+	for (auto &draw_ref : order)
+	{
+		auto &stream = *streams[draw_ref.stream_index];
+		auto &packet = *draw_ref.packet;
+
+		// The command buffer only marks its pipeline dirty for the states which changed
+		auto &state = stream.states[packet.state_index];
+		if (&state != applied_state)
+		{
+			auto &pipeline_state = state.pipeline_state;
+
+			command_buffer.bind_pipeline_layout(*state.pipeline_layout);
+			for (auto &constant : pipeline_state.get_specialization_constant_state().get_specialization_constant_state())
+			{
+				command_buffer.set_specialization_constant(constant.first, constant.second);
+			}
+			command_buffer.set_vertex_input_state(pipeline_state.get_vertex_input_state());
+			command_buffer.set_input_assembly_state(pipeline_state.get_input_assembly_state());
+			command_buffer.set_rasterization_state(pipeline_state.get_rasterization_state());
+			command_buffer.set_viewport_state(pipeline_state.get_viewport_state());
+			command_buffer.set_multisample_state(pipeline_state.get_multisample_state());
+			command_buffer.set_depth_stencil_state(pipeline_state.get_depth_stencil_state());
+			command_buffer.set_color_blend_state(pipeline_state.get_color_blend_state());
+
+			applied_state = &state;
+		}
+
+		// Only forward the bindings which differ from the previous draw, so that
+		// the descriptor sets are not looked up again for unchanged sets
+		auto bindings = stream.binding_arena.data() + packet.bindings.first;
+		if (bindings != applied_bindings || packet.bindings.count != applied_binding_count)
+		{
+			for (uint32_t i = 0; i < packet.bindings.count; ++i)
+			{
+				auto &binding = bindings[i];
+
+				auto applied_end = applied_bindings + applied_binding_count;
+				auto applied     = std::find_if(applied_bindings, applied_end, [&](const BindingPacket &other) { return same_binding(binding, other); });
+				if (applied != applied_end)
+				{
+					continue;
+				}
+
+				switch (binding.type)
+				{
+					case BindingType::Buffer:
+						command_buffer.bind_buffer(*binding.buffer, binding.offset, binding.range, binding.set, binding.binding, binding.array_element);
+						break;
+					case BindingType::Image:
+						command_buffer.bind_image(*binding.image_view, *binding.sampler, binding.set, binding.binding, binding.array_element);
+						break;
+					case BindingType::Input:
+						command_buffer.bind_input(*binding.image_view, binding.set, binding.binding, binding.array_element);
+						break;
+				}
+			}
+
+			applied_bindings      = bindings;
+			applied_binding_count = packet.bindings.count;
+		}
+
+		auto vertex_buffers = stream.vertex_buffer_arena.data() + packet.vertex_buffers.first;
+		if (vertex_buffers != applied_vertex_buffers || packet.vertex_buffers.count != applied_vertex_buffer_count)
+		{
+			for (uint32_t i = 0; i < packet.vertex_buffers.count; ++i)
+			{
+				auto &vertex_buffer = vertex_buffers[i];
+
+				auto applied_end = applied_vertex_buffers + applied_vertex_buffer_count;
+				auto applied     = std::find_if(applied_vertex_buffers, applied_end, [&](const VertexBufferPacket &other) { return same_vertex_buffer(vertex_buffer, other); });
+				if (applied != applied_end)
+				{
+					continue;
+				}
+
+				command_buffer.bind_vertex_buffers(vertex_buffer.binding, {*vertex_buffer.buffer}, {vertex_buffer.offset});
+			}
+
+			applied_vertex_buffers      = vertex_buffers;
+			applied_vertex_buffer_count = packet.vertex_buffers.count;
+		}
+
+		if (packet.push_constants.count > 0)
+		{
+			auto push_constants = stream.push_constant_arena.begin() + packet.push_constants.first;
+			push_constant_data.assign(push_constants, push_constants + packet.push_constants.count);
+
+			command_buffer.push_constants(push_constant_data);
+		}
+
+		if (packet.indexed)
+		{
+			command_buffer.bind_index_buffer(*packet.index_buffer, packet.index_offset, packet.index_type);
+
+			command_buffer.draw_indexed(packet.count, packet.instance_count, packet.first, packet.vertex_offset, packet.first_instance);
+		}
+		else
+		{
+			command_buffer.draw(packet.count, packet.instance_count, packet.first, packet.first_instance);
+		}
+	}
+}
+}        // namespace vkb
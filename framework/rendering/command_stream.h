@@ -0,0 +1,250 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "rendering/pipeline_state.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class PipelineLayout;
+
+namespace core
+{
+class Buffer;
+class ImageView;
+class Sampler;
+}        // namespace core
+
+/**
+ * @brief CPU side list of draws, replayed later into a CommandBuffer
+ *        Appending a draw only copies plain packets into linear arenas, without any
+ *        pipeline or descriptor cache lookup, so that one stream per thread can be
+ *        recorded without contention. The replay sorts the draws by pipeline state and
+ *        bindings, and only forwards to the command buffer what changes between draws.
+ *        Bindings and states persist between draws like they do in a CommandBuffer;
+ *        dynamic states such as the viewport are set on the command buffer directly.
+ */
+class CommandStream
+{
+  public:
+	CommandStream() = default;
+
+	CommandStream(const CommandStream &) = delete;
+
+	CommandStream(CommandStream &&) = default;
+
+	CommandStream &operator=(const CommandStream &) = delete;
+
+	CommandStream &operator=(CommandStream &&) = default;
+
+	/**
+	 * @brief Removes all the draws, keeping the memory of the arenas for the next recording
+	 */
+	void reset();
+
+	void bind_pipeline_layout(PipelineLayout &pipeline_layout);
+
+	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
+
+	void set_vertex_input_state(const VertexInputState &state_info);
+
+	void set_input_assembly_state(const InputAssemblyState &state_info);
+
+	void set_rasterization_state(const RasterizationState &state_info);
+
+	void set_viewport_state(const ViewportState &state_info);
+
+	void set_multisample_state(const MultisampleState &state_info);
+
+	void set_depth_stencil_state(const DepthStencilState &state_info);
+
+	void set_color_blend_state(const ColorBlendState &state_info);
+
+	/**
+	 * @brief Stores push constants for the next draw only, like CommandBuffer::push_constants
+	 */
+	void push_constants(const std::vector<uint8_t> &values);
+
+	template <typename T>
+	void push_constants(const T &value)
+	{
+		push_constants(to_bytes(value));
+	}
+
+	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
+
+	void bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element);
+
+	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
+
+	void bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets);
+
+	void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
+
+	void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
+
+	void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
+
+	size_t get_draw_count() const;
+
+	/**
+	 * @brief Records the draws of the stream into a command buffer
+	 * @param command_buffer The command buffer, inside the render pass the draws belong to
+	 * @param sort_draws Whether to reorder the draws to group state changes,
+	 *        the order of the recording is kept otherwise (e.g. for blended draws)
+	 */
+	void replay(CommandBuffer &command_buffer, bool sort_draws = true) const;
+
+	/**
+	 * @brief Records the draws of several streams, as if they had been appended to a single one
+	 *        in the order of the vector
+	 */
+	static void replay(const std::vector<const CommandStream *> &streams, CommandBuffer &command_buffer, bool sort_draws = true);
+
+  private:
+	/**
+	 * @brief Pipeline state shared by consecutive draws
+	 */
+	struct StateEntry
+	{
+		PipelineLayout *pipeline_layout{nullptr};
+
+		PipelineState pipeline_state;
+	};
+
+	enum class BindingType : uint8_t
+	{
+		Buffer,
+		Image,
+		Input
+	};
+
+	struct BindingPacket
+	{
+		BindingType type;
+
+		uint32_t set;
+
+		uint32_t binding;
+
+		uint32_t array_element;
+
+		const core::Buffer *buffer;
+
+		VkDeviceSize offset;
+
+		VkDeviceSize range;
+
+		const core::ImageView *image_view;
+
+		const core::Sampler *sampler;
+	};
+
+	struct VertexBufferPacket
+	{
+		uint32_t binding;
+
+		const core::Buffer *buffer;
+
+		VkDeviceSize offset;
+	};
+
+	/**
+	 * @brief A range of packets in one of the arenas
+	 */
+	struct Range
+	{
+		uint32_t first{0};
+
+		uint32_t count{0};
+	};
+
+	struct DrawPacket
+	{
+		/// Draws with the same key share their pipeline state
+		uint64_t sort_key;
+
+		uint32_t state_index;
+
+		Range bindings;
+
+		Range vertex_buffers;
+
+		Range push_constants;
+
+		const core::Buffer *index_buffer;
+
+		VkDeviceSize index_offset;
+
+		VkIndexType index_type;
+
+		bool indexed;
+
+		uint32_t count;
+
+		uint32_t instance_count;
+
+		uint32_t first;
+
+		int32_t vertex_offset;
+
+		uint32_t first_instance;
+	};
+
+	void bind(const BindingPacket &packet);
+
+	void append_draw(DrawPacket &packet);
+
+	StateEntry current_state;
+
+	bool state_dirty{true};
+
+	std::vector<BindingPacket> current_bindings;
+
+	bool bindings_dirty{true};
+
+	std::vector<VertexBufferPacket> current_vertex_buffers;
+
+	bool vertex_buffers_dirty{true};
+
+	std::vector<uint8_t> current_push_constants;
+
+	const core::Buffer *current_index_buffer{nullptr};
+
+	VkDeviceSize current_index_offset{0};
+
+	VkIndexType current_index_type{VK_INDEX_TYPE_UINT16};
+
+	std::vector<StateEntry> states;
+
+	std::vector<DrawPacket> draws;
+
+	std::vector<BindingPacket> binding_arena;
+
+	std::vector<VertexBufferPacket> vertex_buffer_arena;
+
+	std::vector<uint8_t> push_constant_arena;
+
+	Range last_bindings;
+
+	Range last_vertex_buffers;
+};
+}        // namespace vkb
@@ -0,0 +1,287 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/cpu_culling.h"
+
+#include <algorithm>
+#include <array>
+
+#include "geometry/bounds_kernels.h"
+#include "geometry/frustum.h"
+#include "job_system.h"
+#include "scene_graph/bvh.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t RADIX_BITS = 8;
+
+constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+}        // namespace
+
+void CpuCulling::cull(const std::vector<sg::Mesh *> &meshes, const glm::mat4 &view_proj, const glm::vec3 &camera_position,
+                      DrawList &opaque_draws, DrawList &transparent_draws,
+                      JobSystem *job_system, bool frustum_test)
+{
+	instance_meshes.clear();
+	instance_nodes.clear();
+	world_matrices.clear();
+
+	// The world matrices are cached lazily by the transforms, so they are read on this thread
+	for (auto &mesh : meshes)
+	{
+		for (auto &node : mesh->get_nodes())
+		{
+			instance_meshes.push_back(mesh);
+			instance_nodes.push_back(node);
+			world_matrices.push_back(node->get_transform().get_world_matrix());
+		}
+	}
+
+	auto instance_count = to_u32(instance_meshes.size());
+
+	resize_instances(instance_count);
+
+	Frustum frustum;
+	frustum.update(view_proj);
+
+	const auto *planes = frustum_test ? &frustum.get_planes() : nullptr;
+
+	if (job_system && instance_count > GRAIN_SIZE)
+	{
+		job_system->parallel_for(0, instance_count, GRAIN_SIZE, [&](uint32_t first, uint32_t last) {
+			cull_instances(first, last, planes, camera_position);
+		});
+	}
+	else
+	{
+		cull_instances(0, instance_count, planes, camera_position);
+	}
+
+	sort_visible_draws(opaque_draws, transparent_draws);
+}
+
+void CpuCulling::cull(const sg::BVH &bvh, const glm::mat4 &view_proj, const glm::vec3 &camera_position,
+                      DrawList &opaque_draws, DrawList &transparent_draws)
+{
+	Frustum frustum;
+	frustum.update(view_proj);
+
+	visible_instances.clear();
+	bvh.query_frustum(frustum, visible_instances);
+
+	instance_meshes.clear();
+	instance_nodes.clear();
+	world_matrices.clear();
+
+	for (auto &instance : visible_instances)
+	{
+		instance_meshes.push_back(instance.second);
+		instance_nodes.push_back(instance.first);
+		world_matrices.push_back(instance.first->get_transform().get_world_matrix());
+	}
+
+	auto instance_count = to_u32(instance_meshes.size());
+
+	resize_instances(instance_count);
+
+	// The tree already culled the instances, only their distances are needed
+	cull_instances(0, instance_count, nullptr, camera_position);
+
+	sort_visible_draws(opaque_draws, transparent_draws);
+}
+
+void CpuCulling::resize_instances(uint32_t instance_count)
+{
+	min_x.resize(instance_count);
+	min_y.resize(instance_count);
+	min_z.resize(instance_count);
+	max_x.resize(instance_count);
+	max_y.resize(instance_count);
+	max_z.resize(instance_count);
+	local_centers.resize(instance_count);
+	local_extents.resize(instance_count);
+	distances.resize(instance_count);
+	visible.resize(instance_count);
+	unbounded.resize(instance_count);
+}
+
+void CpuCulling::set_transparent_sorting(bool enabled)
+{
+	transparent_sorting = enabled;
+}
+
+void CpuCulling::sort_visible_draws(DrawList &opaque_draws, DrawList &transparent_draws)
+{
+	auto instance_count = to_u32(instance_meshes.size());
+
+	opaque_draws.clear();
+	transparent_draws.clear();
+	opaque_distances.clear();
+	transparent_distances.clear();
+
+	for (uint32_t i = 0; i < instance_count; ++i)
+	{
+		if (!visible[i])
+		{
+			continue;
+		}
+
+		for (auto &sub_mesh : instance_meshes[i]->get_submeshes())
+		{
+			// Streamed submeshes are drawn once their geometry is loaded
+			if (!sub_mesh->has_geometry())
+			{
+				continue;
+			}
+
+			if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
+			{
+				transparent_draws.emplace_back(instance_nodes[i], sub_mesh);
+				transparent_distances.push_back(distances[i]);
+			}
+			else
+			{
+				opaque_draws.emplace_back(instance_nodes[i], sub_mesh);
+				opaque_distances.push_back(distances[i]);
+			}
+		}
+	}
+
+	sort_draws(opaque_draws, opaque_distances);
+
+	if (!transparent_sorting)
+	{
+		return;
+	}
+
+	sort_draws(transparent_draws, transparent_distances);
+
+	// Transparent objects are drawn in back-to-front order
+	std::reverse(transparent_draws.begin(), transparent_draws.end());
+}
+
+void CpuCulling::cull_instances(uint32_t first, uint32_t last, const std::array<glm::vec4, 6> *planes, const glm::vec3 &camera_position)
+{
+	for (uint32_t i = first; i < last; ++i)
+	{
+		const auto &bounds = instance_meshes[i]->get_bounds();
+
+		local_centers[i] = bounds.get_center();
+		local_extents[i] = bounds.get_scale() * 0.5f;
+
+		visible[i] = 1;
+
+		// Meshes without bounds are never culled
+		unbounded[i] = local_extents[i] == glm::vec3(0.0f);
+	}
+
+	bounds::BoxArrays boxes{min_x.data() + first, min_y.data() + first, min_z.data() + first,
+	                        max_x.data() + first, max_y.data() + first, max_z.data() + first};
+
+	// The world space boxes around the transformed boxes, from their centers and half extents
+	bounds::transform_boxes(world_matrices.data() + first, local_centers.data() + first, local_extents.data() + first, last - first, boxes);
+
+	for (uint32_t i = first; i < last; ++i)
+	{
+		auto center = glm::vec3(min_x[i] + max_x[i], min_y[i] + max_y[i], min_z[i] + max_z[i]) * 0.5f;
+
+		distances[i] = glm::length(camera_position - center);
+	}
+
+	if (!planes)
+	{
+		return;
+	}
+
+	bounds::test_boxes(*planes, boxes, last - first, visible.data() + first);
+
+	for (uint32_t i = first; i < last; ++i)
+	{
+		visible[i] |= unbounded[i];
+	}
+}
+
+void CpuCulling::sort_draws(DrawList &draws, std::vector<float> &draw_distances)
+{
+	auto draw_count = to_u32(draws.size());
+
+	if (draw_count < 2)
+	{
+		return;
+	}
+
+	auto range = std::minmax_element(draw_distances.begin(), draw_distances.end());
+
+	float min_distance = *range.first;
+	float scale        = *range.second > min_distance ? 65535.0f / (*range.second - min_distance) : 0.0f;
+
+	keys.resize(draw_count);
+	sorted_keys.resize(draw_count);
+	order.resize(draw_count);
+	sorted_order.resize(draw_count);
+
+	for (uint32_t i = 0; i < draw_count; ++i)
+	{
+		keys[i]  = static_cast<uint16_t>((draw_distances[i] - min_distance) * scale);
+		order[i] = i;
+	}
+
+	// Least significant digit first, each pass is stable
+	for (uint32_t shift = 0; shift < 16; shift += RADIX_BITS)
+	{
+		std::array<uint32_t, RADIX_SIZE + 1> offsets{};
+
+		for (auto key : keys)
+		{
+			++offsets[((key >> shift) & (RADIX_SIZE - 1)) + 1];
+		}
+
+		for (uint32_t digit = 1; digit <= RADIX_SIZE; ++digit)
+		{
+			offsets[digit] += offsets[digit - 1];
+		}
+
+		for (uint32_t i = 0; i < draw_count; ++i)
+		{
+			auto position = offsets[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+
+			sorted_keys[position]  = keys[i];
+			sorted_order[position] = order[i];
+		}
+
+		std::swap(keys, sorted_keys);
+		std::swap(order, sorted_order);
+	}
+
+	sorted_draws.resize(draw_count);
+
+	for (uint32_t i = 0; i < draw_count; ++i)
+	{
+		sorted_draws[i] = draws[order[i]];
+	}
+
+	// Copied back rather than swapped, the draws may live in the arena of the frame
+	std::copy(sorted_draws.begin(), sorted_draws.end(), draws.begin());
+}
+}        // namespace vkb
@@ -0,0 +1,160 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "common/linear_allocator.h"
+
+namespace vkb
+{
+class JobSystem;
+
+namespace sg
+{
+class BVH;
+class Mesh;
+class Node;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Culls the mesh instances of a scene against the camera frustum and sorts the visible
+ *        draws by distance to the camera
+ *
+ * The world space bounds of the instances are kept in structure of arrays form, so the plane
+ * tests run over contiguous floats the compiler can vectorize. Chunks of instances are culled
+ * in parallel on the job system. The visible draws are sorted with a radix sort on their
+ * distance quantized to 16 bits, instead of inserting them one by one in a sorted container.
+ *
+ * The arrays are kept between calls, so culling the same scene again does not allocate.
+ */
+class CpuCulling
+{
+  public:
+	using Draw = std::pair<sg::Node *, sg::SubMesh *>;
+
+	/// Draws of a frame, usually allocated from the arena of the recording thread
+	using DrawList = ArenaVector<Draw>;
+
+	/**
+	 * @brief Culls and sorts the draws of the meshes
+	 * @param meshes The meshes to draw, with their nodes and submeshes
+	 * @param view_proj The view projection matrix of the camera, the planes of the frustum are taken from it
+	 * @param camera_position The world space position of the camera
+	 * @param opaque_draws Receives the opaque draws in front-to-back order
+	 * @param transparent_draws Receives the transparent draws in back-to-front order
+	 * @param job_system Optional job system culling the instances in parallel
+	 * @param frustum_test Whether to cull the instances, otherwise only sorts them
+	 */
+	void cull(const std::vector<sg::Mesh *> &meshes, const glm::mat4 &view_proj, const glm::vec3 &camera_position,
+	          DrawList &opaque_draws, DrawList &transparent_draws,
+	          JobSystem *job_system = nullptr, bool frustum_test = true);
+
+	/**
+	 * @brief Culls the draws hierarchically with the bounding volume hierarchy of a scene, then sorts them
+	 */
+	void cull(const sg::BVH &bvh, const glm::mat4 &view_proj, const glm::vec3 &camera_position,
+	          DrawList &opaque_draws, DrawList &transparent_draws);
+
+	/**
+	 * @brief Sorts the transparent draws back-to-front, otherwise they are kept in the order of the instances
+	 *        Only order independent blending of the transparent draws can skip the sort.
+	 */
+	void set_transparent_sorting(bool enabled);
+
+	/// Minimum number of instances culled by each job
+	static constexpr uint32_t GRAIN_SIZE = 1024;
+
+  private:
+	/**
+	 * @brief Computes the world space bounds and distances of the instances in [first, last), then tests them against the planes
+	 */
+	void cull_instances(uint32_t first, uint32_t last, const std::array<glm::vec4, 6> *planes, const glm::vec3 &camera_position);
+
+	void resize_instances(uint32_t instance_count);
+
+	/**
+	 * @brief Splits the submeshes of the visible instances into opaque and transparent draws, then sorts them
+	 */
+	void sort_visible_draws(DrawList &opaque_draws, DrawList &transparent_draws);
+
+	/**
+	 * @brief Sorts the draws by distance, nearest first
+	 */
+	void sort_draws(DrawList &draws, std::vector<float> &distances);
+
+	/// Instances in the order of the meshes and their nodes
+	std::vector<const sg::Mesh *> instance_meshes;
+
+	std::vector<sg::Node *> instance_nodes;
+
+	std::vector<glm::mat4> world_matrices;
+
+	/// Instances returned by the bounding volume hierarchy
+	std::vector<std::pair<sg::Node *, sg::Mesh *>> visible_instances;
+
+	/// Mesh space centers and half extents of the instances
+	std::vector<glm::vec3> local_centers;
+
+	std::vector<glm::vec3> local_extents;
+
+	/// World space bounds of the instances
+	std::vector<float> min_x;
+
+	std::vector<float> min_y;
+
+	std::vector<float> min_z;
+
+	std::vector<float> max_x;
+
+	std::vector<float> max_y;
+
+	std::vector<float> max_z;
+
+	std::vector<float> distances;
+
+	std::vector<uint8_t> visible;
+
+	std::vector<uint8_t> unbounded;
+
+	std::vector<float> opaque_distances;
+
+	std::vector<float> transparent_distances;
+
+	bool transparent_sorting{true};
+
+	/// Radix sort buffers
+	std::vector<uint16_t> keys;
+
+	std::vector<uint16_t> sorted_keys;
+
+	std::vector<uint32_t> order;
+
+	std::vector<uint32_t> sorted_order;
+
+	std::vector<Draw> sorted_draws;
+};
+}        // namespace vkb
@@ -0,0 +1,104 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "stats/gpu_profiler.h"
+
+namespace vkb
+{
+namespace
+{
+/// Weight of the last frame in the smoothed frame time
+constexpr float SMOOTHING = 0.1f;
+
+/// Relative deviation from the budget within which the scale is kept
+constexpr float TOLERANCE = 0.05f;
+
+/// Largest change of the scale in one frame
+constexpr float MAX_STEP = 0.02f;
+
+constexpr uint32_t ALIGNMENT = 8;
+}        // namespace
+
+DynamicResolution::DynamicResolution(float target_frame_time, float min_scale, float max_scale) :
+    target_frame_time{target_frame_time},
+    min_scale{std::min(min_scale, max_scale)},
+    max_scale{max_scale},
+    scale{max_scale}
+{
+}
+
+void DynamicResolution::set_target_frame_time(float new_target_frame_time)
+{
+	target_frame_time = new_target_frame_time;
+}
+
+float DynamicResolution::get_target_frame_time() const
+{
+	return target_frame_time;
+}
+
+void DynamicResolution::update(float gpu_frame_time)
+{
+	if (gpu_frame_time <= 0.0f || target_frame_time <= 0.0f)
+	{
+		return;
+	}
+
+	smoothed_frame_time = smoothed_frame_time == 0.0f ? gpu_frame_time : smoothed_frame_time + SMOOTHING * (gpu_frame_time - smoothed_frame_time);
+
+	float ratio = target_frame_time / smoothed_frame_time;
+
+	if (std::abs(ratio - 1.0f) < TOLERANCE)
+	{
+		return;
+	}
+
+	// The time follows the pixel count, which is the square of the scale
+	float desired_scale = scale * std::sqrt(ratio);
+
+	scale = std::max(min_scale, std::min(max_scale, scale + std::max(-MAX_STEP, std::min(MAX_STEP, desired_scale - scale))));
+}
+
+void DynamicResolution::update(const GpuProfiler &gpu_profiler)
+{
+	if (gpu_profiler.is_supported())
+	{
+		update(gpu_profiler.get_frame_time());
+	}
+}
+
+float DynamicResolution::get_scale() const
+{
+	return scale;
+}
+
+VkExtent2D DynamicResolution::get_render_area(const VkExtent2D &extent) const
+{
+	auto scale_dimension = [this](uint32_t dimension) {
+		auto scaled = (static_cast<uint32_t>(static_cast<float>(dimension) * scale) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+		return std::max(1u, std::min(dimension, scaled));
+	};
+
+	return {scale_dimension(extent.width), scale_dimension(extent.height)};
+}
+}        // namespace vkb
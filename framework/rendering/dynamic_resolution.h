@@ -0,0 +1,82 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class GpuProfiler;
+
+/**
+ * @brief Chooses the scale of the resolution the scene is rendered at, so the GPU frame time stays within a budget
+ *
+ * The GPU time of the frames is smoothed, then the scale moves towards the one which would meet the budget,
+ * assuming the time is proportional to the number of pixels. Small deviations from the budget are ignored,
+ * and the scale changes by a bounded step per frame, so it does not oscillate around the budget.
+ *
+ * The scaled extent is given to RenderPipeline::set_render_area, which draws into a region of render targets
+ * allocated at the full extent, so changing the scale never reallocates images. A post-processing pass then
+ * upscales the region, see PostProcessingSubpass::set_source_area.
+ */
+class DynamicResolution
+{
+  public:
+	/**
+	 * @param target_frame_time GPU frame time budget, in milliseconds
+	 * @param min_scale Lowest scale of each dimension of the render targets
+	 * @param max_scale Highest scale of each dimension of the render targets
+	 */
+	DynamicResolution(float target_frame_time, float min_scale = 0.5f, float max_scale = 1.0f);
+
+	void set_target_frame_time(float target_frame_time);
+
+	float get_target_frame_time() const;
+
+	/**
+	 * @brief Updates the scale from the GPU time of a frame
+	 * @param gpu_frame_time The GPU time of the last profiled frame in milliseconds, ignored when zero
+	 */
+	void update(float gpu_frame_time);
+
+	/**
+	 * @brief Updates the scale from the last frame resolved by the profiler
+	 */
+	void update(const GpuProfiler &gpu_profiler);
+
+	float get_scale() const;
+
+	/**
+	 * @return The scaled extent, in multiples of 8 pixels which keep the tiles of the render area aligned
+	 */
+	VkExtent2D get_render_area(const VkExtent2D &extent) const;
+
+  private:
+	float target_frame_time;
+
+	float min_scale;
+
+	float max_scale;
+
+	float scale;
+
+	/// Exponential moving average of the GPU frame time, zero before the first frame
+	float smoothed_frame_time{0.0f};
+};
+}        // namespace vkb
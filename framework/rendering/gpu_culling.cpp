@@ -0,0 +1,540 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/gpu_culling.h"
+
+#include <cmath>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "geometry/frustum.h"
+#include "rendering/async_compute.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t WORKGROUP_SIZE = 64;
+
+/**
+ * @brief Push constants of the culling shader
+ */
+struct CullingPushConstants
+{
+	std::array<glm::vec4, 6> planes;
+
+	uint32_t instance_count;
+};
+
+/**
+ * @brief Uniform of the occlusion test
+ */
+struct OcclusionUniform
+{
+	glm::mat4 view_proj;
+
+	glm::vec2 pyramid_extent;
+
+	uint32_t pyramid_levels;
+};
+
+/**
+ * @brief Push constants of the depth pyramid reduction
+ */
+struct PyramidPushConstants
+{
+	glm::uvec2 source_extent;
+
+	glm::uvec2 extent;
+};
+
+constexpr uint32_t PYRAMID_WORKGROUP_SIZE = 8;
+}        // namespace
+
+GpuCulling::GpuCulling(RenderContext &render_context) :
+    render_context{render_context},
+    shader_source{"gpu_culling/cull.comp"},
+    pyramid_shader_source{"gpu_culling/depth_pyramid.comp"},
+    draw_indirect_count{render_context.get_device().is_enabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)}
+{
+	occluder_variant.add_define("OCCLUDERS");
+	occlusion_variant.add_define("OCCLUSION_CULLING");
+
+	// Texels are fetched, the sampler only has to allow the depth pyramid to be sampled
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_NEAREST;
+	sampler_info.minFilter     = VK_FILTER_NEAREST;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.maxLod        = VK_LOD_CLAMP_NONE;
+	pyramid_sampler            = &render_context.get_device().get_resource_cache().request_sampler(sampler_info);
+}
+
+void GpuCulling::set_instances(const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &draws)
+{
+	instances.clear();
+	slots.clear();
+
+	for (auto &draw : draws)
+	{
+		auto &node     = *draw.first;
+		auto &sub_mesh = *draw.second;
+
+		if (sub_mesh.vertex_indices == 0 || slots.count({&node, &sub_mesh}))
+		{
+			continue;
+		}
+
+		// Submeshes share the bounds of their mesh
+		auto &mesh = node.get_component<sg::Mesh>();
+
+		// Meshes without bounds are drawn directly
+		if (mesh.get_bounds().get_scale() == glm::vec3(0.0f))
+		{
+			continue;
+		}
+
+		sg::AABB bounds{mesh.get_bounds().get_min(), mesh.get_bounds().get_max()};
+
+		auto world_matrix = node.get_transform().get_world_matrix();
+		bounds.transform(world_matrix);
+
+		Instance instance{};
+		instance.bounds_min    = glm::vec4(bounds.get_min(), 1.0f);
+		instance.bounds_max    = glm::vec4(bounds.get_max(), 1.0f);
+		instance.index_count   = sub_mesh.vertex_indices;
+		instance.first_index   = sub_mesh.first_index;
+		instance.vertex_offset = 0;
+
+		slots.emplace(std::make_pair(&node, &sub_mesh), to_u32(instances.size()));
+		instances.push_back(instance);
+	}
+
+	++revision;
+	layout_revision = revision;
+
+	instance_revisions.assign(instances.size(), revision);
+}
+
+void GpuCulling::update_nodes(const std::vector<sg::Node *> &nodes)
+{
+	bool updated = false;
+
+	for (auto node : nodes)
+	{
+		// The slots of a node are adjacent in the map
+		auto slot_it = slots.lower_bound({node, nullptr});
+
+		if (slot_it == slots.end() || slot_it->first.first != node)
+		{
+			continue;
+		}
+
+		if (!updated)
+		{
+			++revision;
+			updated = true;
+		}
+
+		auto &mesh = node->get_component<sg::Mesh>();
+
+		sg::AABB bounds{mesh.get_bounds().get_min(), mesh.get_bounds().get_max()};
+		bounds.transform(node->get_transform().get_world_matrix());
+
+		for (; slot_it != slots.end() && slot_it->first.first == node; ++slot_it)
+		{
+			auto &instance      = instances[slot_it->second];
+			instance.bounds_min = glm::vec4(bounds.get_min(), 1.0f);
+			instance.bounds_max = glm::vec4(bounds.get_max(), 1.0f);
+
+			instance_revisions[slot_it->second] = revision;
+		}
+	}
+}
+
+uint32_t GpuCulling::find_slot(const sg::Node &node, const sg::SubMesh &sub_mesh) const
+{
+	auto slot_it = slots.find({&node, &sub_mesh});
+
+	return slot_it == slots.end() ? NO_SLOT : slot_it->second;
+}
+
+GpuCulling::FrameResources &GpuCulling::prepare_frame_resources()
+{
+	auto &device = render_context.get_device();
+
+	frame_resources.resize(render_context.get_render_frames().size());
+
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	if (resources.layout_revision == layout_revision && resources.revision != revision)
+	{
+		// Only the instances which moved since the last upload to the frame are written
+		for (size_t slot = 0; slot < instances.size(); slot++)
+		{
+			if (instance_revisions[slot] > resources.revision)
+			{
+				resources.instance_buffer->update(reinterpret_cast<const uint8_t *>(&instances[slot]), sizeof(Instance), slot * sizeof(Instance));
+			}
+		}
+
+		resources.revision = revision;
+	}
+	else if (resources.revision != revision)
+	{
+		// The frame's previous submission completed, its buffers are free
+		auto instance_size = instances.size() * sizeof(Instance);
+
+		if (!resources.instance_buffer || resources.instance_buffer->get_size() < instance_size)
+		{
+			auto command_size = instances.size() * sizeof(VkDrawIndexedIndirectCommand);
+			auto count_size   = instances.size() * sizeof(uint32_t);
+
+			resources.instance_buffer         = std::make_unique<core::Buffer>(device, instance_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+			resources.draw_command_buffer     = std::make_unique<core::Buffer>(device, command_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+			resources.draw_count_buffer       = std::make_unique<core::Buffer>(device, count_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+			resources.visibility_buffer       = std::make_unique<core::Buffer>(device, count_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+			resources.occluder_command_buffer = std::make_unique<core::Buffer>(device, command_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+			resources.occluder_count_buffer   = std::make_unique<core::Buffer>(device, count_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+		}
+
+		resources.instance_buffer->update(reinterpret_cast<const uint8_t *>(instances.data()), instance_size);
+
+		// New instances are all occluders until the first occlusion test
+		std::vector<uint32_t> visibility(instances.size(), 1u);
+		resources.visibility_buffer->update(reinterpret_cast<const uint8_t *>(visibility.data()), visibility.size() * sizeof(uint32_t));
+
+		resources.revision        = revision;
+		resources.layout_revision = layout_revision;
+	}
+
+	return resources;
+}
+
+void GpuCulling::dispatch(CommandBuffer &command_buffer, CommandBuffer &graphics_command_buffer, FrameResources &resources, const ShaderVariant &variant,
+                          const glm::mat4 &view_proj, core::Buffer &command_buffer_out, core::Buffer &count_buffer_out)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader_source, variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_buffer(*resources.instance_buffer, 0, instances.size() * sizeof(Instance), 0, 0, 0);
+	command_buffer.bind_buffer(command_buffer_out, 0, instances.size() * sizeof(VkDrawIndexedIndirectCommand), 0, 1, 0);
+	command_buffer.bind_buffer(count_buffer_out, 0, instances.size() * sizeof(uint32_t), 0, 2, 0);
+
+	Frustum frustum;
+	frustum.update(view_proj);
+
+	CullingPushConstants push_constants{};
+	push_constants.instance_count = to_u32(instances.size());
+	std::copy(frustum.get_planes().begin(), frustum.get_planes().end(), push_constants.planes.begin());
+
+	command_buffer.push_constants(push_constants);
+
+	command_buffer.dispatch((to_u32(instances.size()) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	// The commands are read by the draws of this frame
+	BufferMemoryBarrier memory_barrier{};
+	memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+
+	if (&command_buffer != &graphics_command_buffer)
+	{
+		async_compute->transfer_buffer(graphics_command_buffer, command_buffer_out, 0, VK_WHOLE_SIZE, memory_barrier);
+		async_compute->transfer_buffer(graphics_command_buffer, count_buffer_out, 0, VK_WHOLE_SIZE, memory_barrier);
+		return;
+	}
+
+	command_buffer.buffer_memory_barrier(command_buffer_out, 0, VK_WHOLE_SIZE, memory_barrier);
+	command_buffer.buffer_memory_barrier(count_buffer_out, 0, VK_WHOLE_SIZE, memory_barrier);
+}
+
+void GpuCulling::cull(CommandBuffer &command_buffer, const glm::mat4 &view_proj)
+{
+	if (instances.empty())
+	{
+		return;
+	}
+
+	auto &resources = prepare_frame_resources();
+
+	if (!occlusion_culling || !depth_pyramid.ready)
+	{
+		// The buffers are per frame, so the cull does not wait for the draws of the previous frames
+		auto &cull_command_buffer = async_compute ? async_compute->request_command_buffer(command_buffer) : command_buffer;
+
+		dispatch(cull_command_buffer, command_buffer, resources, ShaderVariant{}, view_proj, *resources.draw_command_buffer, *resources.draw_count_buffer);
+		return;
+	}
+
+	OcclusionUniform uniform{};
+	uniform.view_proj      = view_proj;
+	uniform.pyramid_extent = glm::vec2(depth_pyramid.extent.width, depth_pyramid.extent.height);
+	uniform.pyramid_levels = to_u32(depth_pyramid.level_views.size());
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(OcclusionUniform));
+	allocation.update(uniform);
+
+	command_buffer.bind_buffer(*resources.visibility_buffer, 0, instances.size() * sizeof(uint32_t), 0, 3, 0);
+	command_buffer.bind_image(*depth_pyramid.view, *pyramid_sampler, 0, 4, 0);
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 5, 0);
+
+	dispatch(command_buffer, command_buffer, resources, occlusion_variant, view_proj, *resources.draw_command_buffer, *resources.draw_count_buffer);
+
+	depth_pyramid.ready = false;
+}
+
+void GpuCulling::draw(CommandBuffer &command_buffer, uint32_t slot) const
+{
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	assert(resources.revision == revision && "The active frame must be culled before drawing");
+
+	draw(command_buffer, *resources.draw_command_buffer, *resources.draw_count_buffer, slot);
+}
+
+void GpuCulling::draw(CommandBuffer &command_buffer, const core::Buffer &draw_commands, const core::Buffer &draw_counts, uint32_t slot) const
+{
+	auto stride = to_u32(sizeof(VkDrawIndexedIndirectCommand));
+
+	if (draw_indirect_count)
+	{
+		command_buffer.draw_indexed_indirect_count(draw_commands, slot * stride, draw_counts, slot * sizeof(uint32_t), 1, stride);
+	}
+	else
+	{
+		command_buffer.draw_indexed_indirect(draw_commands, slot * stride, 1, stride);
+	}
+}
+
+bool GpuCulling::uses_draw_indirect_count() const
+{
+	return draw_indirect_count;
+}
+
+void GpuCulling::set_async_compute(AsyncCompute *async_compute_)
+{
+	async_compute = async_compute_;
+}
+
+void GpuCulling::set_occlusion_culling(bool enabled)
+{
+	occlusion_culling = enabled;
+}
+
+bool GpuCulling::is_using_occlusion_culling() const
+{
+	return occlusion_culling;
+}
+
+void GpuCulling::cull_occluders(CommandBuffer &command_buffer, const glm::mat4 &view_proj)
+{
+	if (instances.empty())
+	{
+		return;
+	}
+
+	auto &resources = prepare_frame_resources();
+
+	command_buffer.bind_buffer(*resources.visibility_buffer, 0, instances.size() * sizeof(uint32_t), 0, 3, 0);
+
+	dispatch(command_buffer, command_buffer, resources, occluder_variant, view_proj, *resources.occluder_command_buffer, *resources.occluder_count_buffer);
+}
+
+void GpuCulling::prepare_depth_pyramid(const VkExtent2D &extent)
+{
+	if (depth_pyramid.depth_target && depth_pyramid.depth_target->get_extent().width == extent.width &&
+	    depth_pyramid.depth_target->get_extent().height == extent.height)
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	// The depth is sampled by the reduction, so it has no stencil aspect
+	auto depth_format = get_suitable_depth_format(device.get_gpu(), true);
+
+	std::vector<core::Image> images;
+	images.emplace_back(device, VkExtent3D{extent.width, extent.height, 1}, depth_format,
+	                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+	depth_pyramid.depth_target = std::make_unique<RenderTarget>(std::move(images));
+
+	// Each texel of the first level covers at least a 2x2 block of the depth
+	depth_pyramid.extent = {std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u)};
+
+	auto level_count = to_u32(std::floor(std::log2(std::max(depth_pyramid.extent.width, depth_pyramid.extent.height)))) + 1;
+
+	depth_pyramid.level_views.clear();
+	depth_pyramid.view = nullptr;
+
+	depth_pyramid.image = std::make_unique<core::Image>(device, VkExtent3D{depth_pyramid.extent.width, depth_pyramid.extent.height, 1}, VK_FORMAT_R32_SFLOAT,
+	                                                    VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+	                                                    VK_SAMPLE_COUNT_1_BIT, level_count);
+
+	// A single level pyramid shares its view with its level
+	auto &resource_cache = device.get_resource_cache();
+
+	depth_pyramid.view = &resource_cache.request_image_view(*depth_pyramid.image, VK_IMAGE_VIEW_TYPE_2D);
+
+	depth_pyramid.level_views.reserve(level_count);
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		depth_pyramid.level_views.push_back(&resource_cache.request_image_view(*depth_pyramid.image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_UNDEFINED, level, 1));
+	}
+
+	depth_pyramid.ready = false;
+}
+
+void GpuCulling::begin_depth_prepass(CommandBuffer &command_buffer, const VkExtent2D &extent)
+{
+	prepare_depth_pyramid(extent);
+
+	auto &render_target = *depth_pyramid.depth_target;
+	auto &depth_view    = render_target.get_views().at(0);
+
+	// The previous reduction sampled the depth
+	ImageMemoryBarrier memory_barrier{};
+	memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+	memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	memory_barrier.src_access_mask = 0;
+	memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+	command_buffer.image_memory_barrier(depth_view, memory_barrier);
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &render_pass = resource_cache.request_render_pass(render_target.get_attachments(), {LoadStoreInfo{VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE}}, {SubpassInfo{}});
+	auto &framebuffer = resource_cache.request_framebuffer(render_target, render_pass);
+
+	// Reversed depth, the far plane is at zero
+	VkClearValue clear_value{};
+	clear_value.depthStencil = {0.0f, 0};
+
+	command_buffer.begin_render_pass(render_target, render_pass, framebuffer, {clear_value});
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	command_buffer.set_scissor(0, {scissor});
+}
+
+void GpuCulling::draw_occluder(CommandBuffer &command_buffer, uint32_t slot) const
+{
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	assert(resources.revision == revision && "The occluders of the active frame must be culled before drawing them");
+
+	draw(command_buffer, *resources.occluder_command_buffer, *resources.occluder_count_buffer, slot);
+}
+
+void GpuCulling::end_depth_prepass(CommandBuffer &command_buffer)
+{
+	command_buffer.end_render_pass();
+
+	auto &depth_view = depth_pyramid.depth_target->get_views().at(0);
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(depth_view, memory_barrier);
+	}
+
+	{
+		// The previous cull read the whole pyramid
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(*depth_pyramid.view, memory_barrier);
+	}
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, pyramid_shader_source);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	VkExtent2D source_extent = depth_pyramid.depth_target->get_extent();
+
+	for (uint32_t level = 0; level < depth_pyramid.level_views.size(); ++level)
+	{
+		auto &level_view = *depth_pyramid.level_views[level];
+
+		VkExtent2D extent{std::max(depth_pyramid.extent.width >> level, 1u), std::max(depth_pyramid.extent.height >> level, 1u)};
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		command_buffer.bind_image(level == 0 ? depth_view : *depth_pyramid.level_views[level - 1], *pyramid_sampler, 0, 0, 0);
+		command_buffer.bind_input(level_view, 0, 1, 0);
+
+		PyramidPushConstants push_constants{};
+		push_constants.source_extent = {source_extent.width, source_extent.height};
+		push_constants.extent        = {extent.width, extent.height};
+
+		command_buffer.push_constants(push_constants);
+
+		command_buffer.dispatch((extent.width + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+		                        (extent.height + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE, 1);
+
+		// The level is sampled by the reduction of the next level and the cull
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(level_view, memory_barrier);
+
+		source_extent = extent;
+	}
+
+	depth_pyramid.ready = true;
+}
+}        // namespace vkb
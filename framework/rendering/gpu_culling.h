@@ -0,0 +1,273 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+class AsyncCompute;
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Node;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Culls draws against the camera frustum in a compute shader, which writes the indirect
+ *        draw commands of the instances
+ *
+ * An instance is an indexed submesh drawn at a node, whose world space bounds are uploaded when
+ * the instances change. Each draw keeps the state recorded by the CPU and draws indirectly from
+ * the slot of its instance, with an instance count of zero once culled. With VK_KHR_draw_indirect_count
+ * the draw count of a culled instance is zero as well, so the GPU skips its command entirely.
+ *
+ * Each render frame has its own buffers, so culling a frame does not wait on the previous ones.
+ *
+ * With occlusion culling, the instances found visible by the last cull of the frame's buffers are
+ * drawn again in a depth pre-pass, before any culling of the frame. A compute shader reduces that
+ * depth into a hierarchical-Z pyramid, keeping the farthest depth of each texel with reversed depth.
+ * cull() then also culls the instances whose bounds are behind the pyramid texels they cover, and
+ * records which instances are visible for the next pre-pass. The occluders are geometry drawn with
+ * the current camera, so an instance is only culled when it is hidden in the current frame.
+ */
+class GpuCulling
+{
+  public:
+	/// Slot of the draws which are not culled on the GPU
+	static constexpr uint32_t NO_SLOT = ~0u;
+
+	GpuCulling(RenderContext &render_context);
+
+	GpuCulling(const GpuCulling &) = delete;
+
+	GpuCulling(GpuCulling &&) = delete;
+
+	~GpuCulling() = default;
+
+	GpuCulling &operator=(const GpuCulling &) = delete;
+
+	GpuCulling &operator=(GpuCulling &&) = delete;
+
+	/**
+	 * @brief Sets the instances to cull, uploaded to each frame's buffers before its next cull()
+	 *        Submeshes without indices are not culled. The bounds are taken from the meshes and
+	 *        the transforms of the nodes at the time of the call.
+	 */
+	void set_instances(const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &instances);
+
+	/**
+	 * @brief Updates the bounds of the instances drawn at nodes which moved, uploaded to each frame's buffers
+	 *        before its next cull() without uploading the other instances. Nodes without instances are skipped.
+	 */
+	void update_nodes(const std::vector<sg::Node *> &nodes);
+
+	/**
+	 * @return The slot of a submesh drawn at a node, NO_SLOT if it is not culled on the GPU
+	 */
+	uint32_t find_slot(const sg::Node &node, const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Writes the draw commands of the active frame, must be recorded outside of a render pass
+	 * @param command_buffer Command buffer recording the frame
+	 * @param view_proj The view projection matrix of the camera
+	 */
+	void cull(CommandBuffer &command_buffer, const glm::mat4 &view_proj);
+
+	/**
+	 * @brief Draws the instance of a slot with the indirect command written by cull()
+	 *        The index buffer of the submesh must be bound.
+	 */
+	void draw(CommandBuffer &command_buffer, uint32_t slot) const;
+
+	bool uses_draw_indirect_count() const;
+
+	/**
+	 * @brief Runs the frustum culls on the compute queue of the scheduler, overlapping the raster work
+	 *        Culls testing the occlusion read the depth of the frame, so they stay on the graphics queue.
+	 * @param async_compute The scheduler, nullptr to cull on the graphics queue
+	 */
+	void set_async_compute(AsyncCompute *async_compute);
+
+	/**
+	 * @brief Enables the depth pre-pass and the hierarchical-Z occlusion test of cull()
+	 */
+	void set_occlusion_culling(bool enabled);
+
+	bool is_using_occlusion_culling() const;
+
+	/**
+	 * @brief Writes the draw commands of the depth pre-pass, the instances in the frustum which were visible
+	 *        in the last cull of the active frame, must be recorded outside of a render pass
+	 */
+	void cull_occluders(CommandBuffer &command_buffer, const glm::mat4 &view_proj);
+
+	/**
+	 * @brief Begins the render pass of the depth pre-pass, drawn with draw_occluder()
+	 * @param extent Extent of the render target the frame is drawn to
+	 */
+	void begin_depth_prepass(CommandBuffer &command_buffer, const VkExtent2D &extent);
+
+	/**
+	 * @brief Draws the instance of a slot with the depth pre-pass command written by cull_occluders()
+	 *        The index buffer of the submesh must be bound.
+	 */
+	void draw_occluder(CommandBuffer &command_buffer, uint32_t slot) const;
+
+	/**
+	 * @brief Ends the depth pre-pass and builds the depth pyramid read by the next cull()
+	 */
+	void end_depth_prepass(CommandBuffer &command_buffer);
+
+  private:
+	/// Layout of the instances in the compute shader
+	struct alignas(16) Instance
+	{
+		glm::vec4 bounds_min;
+
+		glm::vec4 bounds_max;
+
+		uint32_t index_count;
+
+		uint32_t first_index;
+
+		int32_t vertex_offset;
+
+		uint32_t padding;
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr<core::Buffer> instance_buffer;
+
+		std::unique_ptr<core::Buffer> draw_command_buffer;
+
+		std::unique_ptr<core::Buffer> draw_count_buffer;
+
+		/// Whether each instance passed the last occlusion test of the frame
+		std::unique_ptr<core::Buffer> visibility_buffer;
+
+		std::unique_ptr<core::Buffer> occluder_command_buffer;
+
+		std::unique_ptr<core::Buffer> occluder_count_buffer;
+
+		/// Revision of the instances in the buffers
+		uint64_t revision{0};
+
+		/// Revision of the set of instances in the buffers
+		uint64_t layout_revision{0};
+	};
+
+	/**
+	 * @brief Depth of the pre-pass and its hierarchical-Z pyramid, shared by the frames as the queue orders their uses
+	 */
+	struct DepthPyramid
+	{
+		std::unique_ptr<RenderTarget> depth_target;
+
+		std::unique_ptr<core::Image> image;
+
+		/// Views of the image, shared through the resource cache
+		const core::ImageView *view{nullptr};
+
+		/// A view of each level, written by the reduction
+		std::vector<const core::ImageView *> level_views;
+
+		/// Extent of the first level, half the extent of the depth
+		VkExtent2D extent{};
+
+		/// Whether the pyramid was built for the next cull
+		bool ready{false};
+	};
+
+	/**
+	 * @return The resources of the active frame, with the instances uploaded
+	 */
+	FrameResources &prepare_frame_resources();
+
+	/**
+	 * @brief Dispatches the culling shader, writing draw commands to the given buffers
+	 *        The visibility and occlusion resources are bound by the caller if the variant reads them.
+	 */
+	/**
+	 * @brief Records the cull into command_buffer, graphics_command_buffer acquires the commands if it is another one
+	 */
+	void dispatch(CommandBuffer &command_buffer, CommandBuffer &graphics_command_buffer, FrameResources &resources, const ShaderVariant &variant,
+	              const glm::mat4 &view_proj, core::Buffer &command_buffer_out, core::Buffer &count_buffer_out);
+
+	void draw(CommandBuffer &command_buffer, const core::Buffer &draw_commands, const core::Buffer &draw_counts, uint32_t slot) const;
+
+	/**
+	 * @brief Creates the depth target and the pyramid for an extent, unless they already have it
+	 */
+	void prepare_depth_pyramid(const VkExtent2D &extent);
+
+	RenderContext &render_context;
+
+	ShaderSource shader_source;
+
+	ShaderSource pyramid_shader_source;
+
+	ShaderVariant occluder_variant;
+
+	ShaderVariant occlusion_variant;
+
+	bool occlusion_culling{false};
+
+	AsyncCompute *async_compute{nullptr};
+
+	DepthPyramid depth_pyramid;
+
+	const core::Sampler *pyramid_sampler{nullptr};
+
+	bool draw_indirect_count{false};
+
+	std::vector<Instance> instances;
+
+	std::map<std::pair<const sg::Node *, const sg::SubMesh *>, uint32_t> slots;
+
+	/// Revision at which each instance last changed
+	std::vector<uint64_t> instance_revisions;
+
+	uint64_t revision{0};
+
+	/// Revision of the last set_instances()
+	uint64_t layout_revision{0};
+
+	/// Resources of each render frame, by frame index
+	std::vector<FrameResources> frame_resources;
+};
+}        // namespace vkb
@@ -0,0 +1,280 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "rendering/gpu_primitives.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t RADIX_SIZE = 1u << GpuPrimitives::RADIX_BITS;
+
+struct ScanPushConstants
+{
+	uint32_t count;
+};
+
+struct SortPushConstants
+{
+	uint32_t count;
+	uint32_t shift;
+	uint32_t group_count;
+};
+
+uint32_t get_group_count(uint32_t count, uint32_t block_size)
+{
+	return (count + block_size - 1) / block_size;
+}
+
+/**
+ * @brief Makes the writes of a pass visible to the compute shaders that follow
+ */
+void compute_barrier(CommandBuffer &command_buffer, const core::Buffer &buffer)
+{
+	BufferMemoryBarrier memory_barrier{};
+	memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	command_buffer.buffer_memory_barrier(buffer, 0, VK_WHOLE_SIZE, memory_barrier);
+}
+}        // namespace
+
+GpuPrimitives::GpuPrimitives(Device &device_, uint32_t max_count_) :
+    device{device_},
+    max_count{std::max(max_count_, 1u)}
+{
+	uint32_t sort_group_count = get_group_count(max_count, SORT_BLOCK_SIZE);
+
+	// The scan processes either the flags of a compaction or the histograms of a sort pass
+	uint32_t scan_count = std::max(max_count, RADIX_SIZE * sort_group_count);
+	while (scan_count > SCAN_BLOCK_SIZE)
+	{
+		scan_count = get_group_count(scan_count, SCAN_BLOCK_SIZE);
+		block_sums.push_back(std::make_unique<core::Buffer>(device, scan_count * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY));
+	}
+
+	offsets     = std::make_unique<core::Buffer>(device, max_count * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	histograms  = std::make_unique<core::Buffer>(device, RADIX_SIZE * sort_group_count * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	sort_keys   = std::make_unique<core::Buffer>(device, max_count * sizeof(uint64_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	sort_values = std::make_unique<core::Buffer>(device, max_count * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+}
+
+uint32_t GpuPrimitives::get_max_count() const
+{
+	return max_count;
+}
+
+void GpuPrimitives::bind_pipeline(CommandBuffer &command_buffer, const ShaderSource &shader_source, const ShaderVariant &variant)
+{
+	auto &resource_cache = device.get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader_source, variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+}
+
+void GpuPrimitives::exclusive_scan(CommandBuffer &command_buffer, const core::Buffer &input, VkDeviceSize input_offset,
+                                   const core::Buffer &output, VkDeviceSize output_offset, uint32_t count)
+{
+	if (count > std::max(max_count, RADIX_SIZE * get_group_count(max_count, SORT_BLOCK_SIZE)))
+	{
+		throw std::runtime_error("Cannot scan more values than the maximum count of the primitives");
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	scan_level(command_buffer, input, input_offset, output, output_offset, count, 0);
+}
+
+void GpuPrimitives::scan_level(CommandBuffer &command_buffer, const core::Buffer &input, VkDeviceSize input_offset,
+                               const core::Buffer &output, VkDeviceSize output_offset, uint32_t count, size_t level)
+{
+	uint32_t group_count = get_group_count(count, SCAN_BLOCK_SIZE);
+	VkDeviceSize size    = count * sizeof(uint32_t);
+
+	// A single block needs no sums, its scan is final
+	ShaderVariant variant;
+	if (group_count > 1)
+	{
+		variant.add_define("BLOCK_SUMS");
+	}
+
+	bind_pipeline(command_buffer, scan_shader, variant);
+
+	command_buffer.bind_buffer(input, input_offset, size, 0, 0, 0);
+	command_buffer.bind_buffer(output, output_offset, size, 0, 1, 0);
+	if (group_count > 1)
+	{
+		command_buffer.bind_buffer(*block_sums[level], 0, group_count * sizeof(uint32_t), 0, 2, 0);
+	}
+
+	command_buffer.push_constants(ScanPushConstants{count});
+	command_buffer.dispatch(group_count, 1, 1);
+
+	compute_barrier(command_buffer, output);
+
+	if (group_count == 1)
+	{
+		return;
+	}
+
+	compute_barrier(command_buffer, *block_sums[level]);
+
+	// The scanned sums of the previous blocks are the offsets of each block
+	scan_level(command_buffer, *block_sums[level], 0, *block_sums[level], 0, group_count, level + 1);
+
+	bind_pipeline(command_buffer, scan_add_shader, ShaderVariant{});
+
+	command_buffer.bind_buffer(output, output_offset, size, 0, 1, 0);
+	command_buffer.bind_buffer(*block_sums[level], 0, group_count * sizeof(uint32_t), 0, 2, 0);
+
+	command_buffer.push_constants(ScanPushConstants{count});
+	command_buffer.dispatch(group_count, 1, 1);
+
+	compute_barrier(command_buffer, output);
+}
+
+void GpuPrimitives::compact(CommandBuffer &command_buffer, const core::Buffer &values, const core::Buffer &flags,
+                            const core::Buffer &output, const core::Buffer &count_buffer, uint32_t count)
+{
+	if (count > max_count)
+	{
+		throw std::runtime_error("Cannot compact more values than the maximum count of the primitives");
+	}
+
+	if (count == 0)
+	{
+		command_buffer.update_buffer(count_buffer, 0, to_bytes(0u));
+
+		BufferMemoryBarrier memory_barrier{};
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.buffer_memory_barrier(count_buffer, 0, VK_WHOLE_SIZE, memory_barrier);
+		return;
+	}
+
+	exclusive_scan(command_buffer, flags, 0, *offsets, 0, count);
+
+	bind_pipeline(command_buffer, compact_shader, ShaderVariant{});
+
+	VkDeviceSize size = count * sizeof(uint32_t);
+	command_buffer.bind_buffer(values, 0, size, 0, 0, 0);
+	command_buffer.bind_buffer(flags, 0, size, 0, 1, 0);
+	command_buffer.bind_buffer(*offsets, 0, size, 0, 2, 0);
+	command_buffer.bind_buffer(output, 0, size, 0, 3, 0);
+	command_buffer.bind_buffer(count_buffer, 0, sizeof(uint32_t), 0, 4, 0);
+
+	command_buffer.push_constants(ScanPushConstants{count});
+	command_buffer.dispatch(get_group_count(count, SORT_BLOCK_SIZE), 1, 1);
+
+	compute_barrier(command_buffer, output);
+	compute_barrier(command_buffer, count_buffer);
+}
+
+void GpuPrimitives::radix_sort(CommandBuffer &command_buffer, const core::Buffer &keys, const core::Buffer *values, uint32_t count, KeyType key_type)
+{
+	if (count > max_count)
+	{
+		throw std::runtime_error("Cannot sort more keys than the maximum count of the primitives");
+	}
+
+	if (count <= 1)
+	{
+		return;
+	}
+
+	ShaderVariant histogram_variant;
+	if (key_type == KeyType::Uint64)
+	{
+		histogram_variant.add_define("KEY_64");
+	}
+
+	ShaderVariant scatter_variant = histogram_variant;
+	if (values)
+	{
+		scatter_variant.add_define("VALUES");
+	}
+
+	uint32_t     group_count = get_group_count(count, SORT_BLOCK_SIZE);
+	uint32_t     key_bits    = key_type == KeyType::Uint64 ? 64 : 32;
+	VkDeviceSize key_size    = count * (key_type == KeyType::Uint64 ? sizeof(uint64_t) : sizeof(uint32_t));
+	VkDeviceSize value_size  = count * sizeof(uint32_t);
+
+	// The passes alternate between the keys and the scratch buffers, an even number of passes ends in the keys
+	std::array<const core::Buffer *, 2> key_buffers{&keys, sort_keys.get()};
+	std::array<const core::Buffer *, 2> value_buffers{values, sort_values.get()};
+
+	for (uint32_t shift = 0; shift < key_bits; shift += RADIX_BITS)
+	{
+		uint32_t pass = shift / RADIX_BITS;
+		uint32_t src  = pass % 2;
+		uint32_t dst  = 1 - src;
+
+		SortPushConstants push_constants{count, shift, group_count};
+
+		bind_pipeline(command_buffer, histogram_shader, histogram_variant);
+
+		command_buffer.bind_buffer(*key_buffers[src], 0, key_size, 0, 0, 0);
+		command_buffer.bind_buffer(*histograms, 0, RADIX_SIZE * group_count * sizeof(uint32_t), 0, 1, 0);
+
+		command_buffer.push_constants(push_constants);
+		command_buffer.dispatch(group_count, 1, 1);
+
+		compute_barrier(command_buffer, *histograms);
+
+		// The offset of the keys of a digit in a workgroup follows the ones of the smaller digits and of the previous workgroups
+		exclusive_scan(command_buffer, *histograms, 0, *histograms, 0, RADIX_SIZE * group_count);
+
+		bind_pipeline(command_buffer, scatter_shader, scatter_variant);
+
+		command_buffer.bind_buffer(*key_buffers[src], 0, key_size, 0, 0, 0);
+		command_buffer.bind_buffer(*key_buffers[dst], 0, key_size, 0, 2, 0);
+		if (values)
+		{
+			command_buffer.bind_buffer(*value_buffers[src], 0, value_size, 0, 1, 0);
+			command_buffer.bind_buffer(*value_buffers[dst], 0, value_size, 0, 3, 0);
+		}
+		command_buffer.bind_buffer(*histograms, 0, RADIX_SIZE * group_count * sizeof(uint32_t), 0, 4, 0);
+
+		command_buffer.push_constants(push_constants);
+		command_buffer.dispatch(group_count, 1, 1);
+
+		compute_barrier(command_buffer, *key_buffers[dst]);
+		if (values)
+		{
+			compute_barrier(command_buffer, *value_buffers[dst]);
+		}
+	}
+}
+}        // namespace vkb
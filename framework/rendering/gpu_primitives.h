@@ -0,0 +1,157 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+/**
+ * @brief Data parallel primitives recorded as compute dispatches: exclusive scan, stream compaction
+ *        and radix sort of 32 or 64 bit keys
+ *
+ * The element counts are known when recording. The scan works on blocks of SCAN_BLOCK_SIZE values,
+ * the sums of the blocks being scanned recursively and added back. The compaction copies the values
+ * whose flag is one, in order, to the offsets given by the scan of the flags, and writes their count
+ * so that the following work can be sized with an indirect dispatch. The radix sort is stable and
+ * sorts four bits per pass, with a histogram of the digits per workgroup, a scan of the histograms
+ * and a scatter ranking the keys of each digit within its workgroup.
+ *
+ * Every pass is followed by a barrier making its writes visible to the next compute shaders, which
+ * includes the ones reading the results. The scratch buffers are sized for the maximum count at
+ * creation and shared by every call, so the command buffers recording with one instance must not
+ * execute concurrently.
+ */
+class GpuPrimitives
+{
+  public:
+	/// Number of values scanned by a workgroup
+	static constexpr uint32_t SCAN_BLOCK_SIZE = 512;
+
+	/// Number of keys ranked by a workgroup of the radix sort
+	static constexpr uint32_t SORT_BLOCK_SIZE = 256;
+
+	/// Bits of the keys sorted by each pass
+	static constexpr uint32_t RADIX_BITS = 4;
+
+	enum class KeyType
+	{
+		Uint32,
+		Uint64
+	};
+
+	/**
+	 * @param device Device the buffers are created on
+	 * @param max_count Maximum number of elements processed by a call
+	 */
+	GpuPrimitives(Device &device, uint32_t max_count);
+
+	GpuPrimitives(const GpuPrimitives &) = delete;
+
+	GpuPrimitives(GpuPrimitives &&) = delete;
+
+	~GpuPrimitives() = default;
+
+	GpuPrimitives &operator=(const GpuPrimitives &) = delete;
+
+	GpuPrimitives &operator=(GpuPrimitives &&) = delete;
+
+	/**
+	 * @brief Writes the exclusive prefix sums of a range of uint32 values, the output may be the input
+	 * @param command_buffer Command buffer recording the dispatches, outside of a render pass
+	 * @param input Buffer of the values
+	 * @param input_offset Offset of the values in the input buffer
+	 * @param output Buffer the sums are written to
+	 * @param output_offset Offset of the sums in the output buffer
+	 * @param count Number of values
+	 */
+	void exclusive_scan(CommandBuffer &command_buffer, const core::Buffer &input, VkDeviceSize input_offset,
+	                    const core::Buffer &output, VkDeviceSize output_offset, uint32_t count);
+
+	/**
+	 * @brief Copies the uint32 values whose flag is one to the front of the output, keeping their order
+	 * @param command_buffer Command buffer recording the dispatches, outside of a render pass
+	 * @param values Buffer of the values
+	 * @param flags Buffer of one uint32 flag per value, zero or one
+	 * @param output Buffer the selected values are written to
+	 * @param count_buffer Buffer the number of selected values is written to, as a uint32
+	 * @param count Number of values
+	 */
+	void compact(CommandBuffer &command_buffer, const core::Buffer &values, const core::Buffer &flags,
+	             const core::Buffer &output, const core::Buffer &count_buffer, uint32_t count);
+
+	/**
+	 * @brief Sorts keys in ascending order, in place
+	 * @param command_buffer Command buffer recording the dispatches, outside of a render pass
+	 * @param keys Buffer of the keys, uint32 or uint64 depending on the key type
+	 * @param values Optional buffer of one uint32 value per key, reordered with the keys
+	 * @param count Number of keys
+	 * @param key_type Size of the keys
+	 */
+	void radix_sort(CommandBuffer &command_buffer, const core::Buffer &keys, const core::Buffer *values, uint32_t count, KeyType key_type = KeyType::Uint32);
+
+	uint32_t get_max_count() const;
+
+  private:
+	/**
+	 * @brief Scans a range, using the block sums buffer of a level and the ones after it
+	 */
+	void scan_level(CommandBuffer &command_buffer, const core::Buffer &input, VkDeviceSize input_offset,
+	                const core::Buffer &output, VkDeviceSize output_offset, uint32_t count, size_t level);
+
+	void bind_pipeline(CommandBuffer &command_buffer, const ShaderSource &shader_source, const ShaderVariant &variant);
+
+	Device &device;
+
+	uint32_t max_count;
+
+	ShaderSource scan_shader{"primitives/scan.comp"};
+
+	ShaderSource scan_add_shader{"primitives/scan_add.comp"};
+
+	ShaderSource compact_shader{"primitives/compact.comp"};
+
+	ShaderSource histogram_shader{"primitives/radix_histogram.comp"};
+
+	ShaderSource scatter_shader{"primitives/radix_scatter.comp"};
+
+	/// Block sums of the scan, one buffer per level of the recursion
+	std::vector<std::unique_ptr<core::Buffer>> block_sums;
+
+	/// Scan of the flags of the compaction
+	std::unique_ptr<core::Buffer> offsets;
+
+	/// Digit counts of every workgroup of a sort pass, digit major
+	std::unique_ptr<core::Buffer> histograms;
+
+	/// Keys and values of the odd sort passes
+	std::unique_ptr<core::Buffer> sort_keys;
+
+	std::unique_ptr<core::Buffer> sort_values;
+};
+}        // namespace vkb
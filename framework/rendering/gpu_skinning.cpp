@@ -0,0 +1,456 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/gpu_skinning.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/geometry_arena.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/skin.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+#include "upload_manager.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Push constants of the deformation of a submesh
+ */
+struct SkinningPushConstants
+{
+	uint32_t vertex_count;
+
+	uint32_t first_vertex;
+
+	uint32_t first_joint;
+
+	uint32_t first_weight;
+
+	uint32_t morph_target_count;
+
+	uint32_t position_offset;
+
+	uint32_t normal_offset;
+
+	uint32_t has_normals;
+};
+
+/**
+ * @brief Decodes an attribute of every vertex of a submesh from its vertex arena
+ * @param normalized Whether unsigned integers are normalized, as glTF weights are
+ * @return Whether the submesh has the attribute in a supported format
+ */
+bool decode_attribute(const sg::SubMesh &submesh, const std::string &name, bool normalized, std::vector<glm::vec4> &values)
+{
+	sg::VertexAttribute attribute;
+	auto                offset_it = submesh.vertex_arena_offsets.find(name);
+	if (!submesh.get_attribute(name, attribute) || offset_it == submesh.vertex_arena_offsets.end())
+	{
+		return false;
+	}
+
+	auto data = submesh.vertex_arena->buffer.get_data() + offset_it->second + attribute.offset;
+
+	values.assign(submesh.vertices_count, glm::vec4(0.0f));
+
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		auto  element = data + i * attribute.stride;
+		auto &value   = values[i];
+
+		switch (attribute.format)
+		{
+			case VK_FORMAT_R32G32B32_SFLOAT:
+				std::memcpy(&value, element, 3 * sizeof(float));
+				break;
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+				std::memcpy(&value, element, 4 * sizeof(float));
+				break;
+			case VK_FORMAT_R16G16B16A16_SNORM:
+			{
+				int16_t integers[4];
+				std::memcpy(integers, element, sizeof(integers));
+				value = glm::max(glm::vec4(integers[0], integers[1], integers[2], integers[3]) / 32767.0f, glm::vec4(-1.0f));
+				break;
+			}
+			case VK_FORMAT_R8G8B8A8_UINT:
+				value = glm::vec4(element[0], element[1], element[2], element[3]) / (normalized ? 255.0f : 1.0f);
+				break;
+			case VK_FORMAT_R16G16B16A16_UINT:
+			{
+				uint16_t integers[4];
+				std::memcpy(integers, element, sizeof(integers));
+				value = glm::vec4(integers[0], integers[1], integers[2], integers[3]) / (normalized ? 65535.0f : 1.0f);
+				break;
+			}
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Appends a range to the data of an arena, aligned as the ranges of the geometry arenas
+ * @param data The content of the range, left zeroed when null
+ * @return The offset of the range
+ */
+VkDeviceSize append_range(std::vector<uint8_t> &arena_data, const uint8_t *data, size_t size)
+{
+	auto alignment = sg::GeometryArena::RANGE_ALIGNMENT;
+	auto offset    = (arena_data.size() + alignment - 1) / alignment * alignment;
+
+	arena_data.resize(offset + size);
+
+	if (data)
+	{
+		std::memcpy(arena_data.data() + offset, data, size);
+	}
+
+	return offset;
+}
+}        // namespace
+
+GpuSkinning::GpuSkinning(RenderContext &render_context) :
+    render_context{render_context},
+    shader_source{"skinning/skinning.comp"}
+{
+	variants[1].add_define("SKIN");
+	variants[2].add_define("MORPH_TARGETS");
+	variants[3].add_define("SKIN");
+	variants[3].add_define("MORPH_TARGETS");
+}
+
+bool GpuSkinning::read_bind_pose(const sg::SubMesh &submesh, bool skinned, std::vector<BindPoseVertex> &vertices)
+{
+	if (!submesh.vertex_arena->buffer.get_data())
+	{
+		return false;
+	}
+
+	std::vector<glm::vec4> positions;
+	std::vector<glm::vec4> normals;
+	std::vector<glm::vec4> joints;
+	std::vector<glm::vec4> weights;
+
+	if (!decode_attribute(submesh, "position", false, positions))
+	{
+		return false;
+	}
+
+	if (skinned && (!decode_attribute(submesh, "joints_0", false, joints) || !decode_attribute(submesh, "weights_0", true, weights)))
+	{
+		return false;
+	}
+
+	// Submeshes without normals only have their positions deformed
+	decode_attribute(submesh, "normal", false, normals);
+
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		BindPoseVertex vertex{};
+		vertex.position = glm::vec4(glm::vec3(positions[i]), 1.0f);
+		vertex.normal   = normals.empty() ? glm::vec4(0.0f) : glm::vec4(glm::vec3(normals[i]), 0.0f);
+
+		if (skinned)
+		{
+			vertex.joints  = glm::uvec4(joints[i]);
+			vertex.weights = weights[i];
+		}
+
+		vertices.push_back(vertex);
+	}
+
+	return true;
+}
+
+size_t GpuSkinning::prepare(sg::Scene &scene)
+{
+	instances.clear();
+	bind_pose_buffer.reset();
+	arena = nullptr;
+
+	std::vector<BindPoseVertex> bind_pose;
+	std::vector<uint8_t>        arena_data;
+
+	// Offsets of the attributes of the submeshes in the new arena, applied once it is created
+	std::vector<std::unordered_map<std::string, VkDeviceSize>> arena_offsets;
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		if (mesh->get_nodes().empty())
+		{
+			continue;
+		}
+
+		auto &node = *mesh->get_nodes().front();
+		auto  skin = node.has_component<sg::Skin>() ? &node.get_component<sg::Skin>() : nullptr;
+
+		for (auto submesh : mesh->get_submeshes())
+		{
+			sg::VertexAttribute attribute;
+			bool skinned = skin && submesh->get_attribute("joints_0", attribute) && submesh->get_attribute("weights_0", attribute);
+
+			if ((!skinned && submesh->morph_target_count == 0) || !submesh->has_geometry() || !submesh->vertex_arena)
+			{
+				continue;
+			}
+
+			Instance instance{};
+			instance.node         = &node;
+			instance.skin         = skinned ? skin : nullptr;
+			instance.mesh         = mesh;
+			instance.submesh      = submesh;
+			instance.vertex_count = submesh->vertices_count;
+			instance.first_vertex = to_u32(bind_pose.size());
+
+			if (!read_bind_pose(*submesh, skinned, bind_pose))
+			{
+				LOGW("Cannot deform {}: its vertex data is not readable or in unsupported formats", mesh->get_name());
+				continue;
+			}
+
+			auto source = submesh->vertex_arena->buffer.get_data();
+
+			// The attributes which are not deformed are copied as they are
+			std::unordered_map<std::string, VkDeviceSize> offsets;
+			for (auto &arena_offset : submesh->vertex_arena_offsets)
+			{
+				if (arena_offset.first == "position" || arena_offset.first == "normal" || !submesh->get_attribute(arena_offset.first, attribute))
+				{
+					continue;
+				}
+
+				offsets[arena_offset.first] = append_range(arena_data, source + arena_offset.second, attribute.stride * instance.vertex_count);
+			}
+
+			// Deformed attributes start from the bind pose, tightly packed as floats
+			std::vector<float> packed(instance.vertex_count * 3);
+			for (uint32_t i = 0; i < instance.vertex_count; i++)
+			{
+				std::memcpy(&packed[i * 3], &bind_pose[instance.first_vertex + i].position, 3 * sizeof(float));
+			}
+
+			offsets["position"]      = append_range(arena_data, reinterpret_cast<const uint8_t *>(packed.data()), packed.size() * sizeof(float));
+			instance.position_offset = to_u32(offsets["position"] / sizeof(float));
+
+			instance.has_normals = submesh->get_attribute("normal", attribute);
+			if (instance.has_normals)
+			{
+				for (uint32_t i = 0; i < instance.vertex_count; i++)
+				{
+					std::memcpy(&packed[i * 3], &bind_pose[instance.first_vertex + i].normal, 3 * sizeof(float));
+				}
+
+				offsets["normal"]      = append_range(arena_data, reinterpret_cast<const uint8_t *>(packed.data()), packed.size() * sizeof(float));
+				instance.normal_offset = to_u32(offsets["normal"] / sizeof(float));
+			}
+
+			instances.push_back(instance);
+			arena_offsets.push_back(std::move(offsets));
+		}
+	}
+
+	if (instances.empty())
+	{
+		return 0;
+	}
+
+	auto &device = render_context.get_device();
+
+	bind_pose_buffer = std::make_unique<core::Buffer>(device,
+	                                                  bind_pose.size() * sizeof(BindPoseVertex),
+	                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                  VMA_MEMORY_USAGE_GPU_ONLY);
+
+	// The vertices are written every frame by the GPU, so they stay in device memory
+	auto arena_component = std::make_unique<sg::GeometryArena>("deformed_vertex_arena",
+	                                                           core::Buffer{device,
+	                                                                        arena_data.size(),
+	                                                                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                                        VMA_MEMORY_USAGE_GPU_ONLY});
+	arena = arena_component.get();
+
+	{
+		UploadManager upload_manager{device};
+
+		upload_manager.upload_buffer(*bind_pose_buffer, reinterpret_cast<const uint8_t *>(bind_pose.data()), bind_pose_buffer->get_size(), 0,
+		                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		upload_manager.upload_buffer(arena->buffer, arena_data.data(), arena_data.size(), 0,
+		                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+		upload_manager.wait();
+	}
+
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		auto &submesh = *instances[i].submesh;
+
+		submesh.vertex_arena         = arena;
+		submesh.vertex_arena_offsets = std::move(arena_offsets[i]);
+
+		sg::VertexAttribute deformed_attribute;
+		deformed_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+		deformed_attribute.stride = 3 * sizeof(float);
+
+		submesh.set_attribute("position", deformed_attribute);
+
+		if (instances[i].has_normals)
+		{
+			submesh.set_attribute("normal", deformed_attribute);
+		}
+	}
+
+	scene.add_component(std::move(arena_component));
+
+	// Recorded draws still bind the previous vertex arenas
+	scene.invalidate();
+
+	LOGI("Deforming {} submeshes on the GPU, {} vertices", instances.size(), bind_pose.size());
+
+	return instances.size();
+}
+
+void GpuSkinning::update(CommandBuffer &command_buffer)
+{
+	if (instances.empty())
+	{
+		return;
+	}
+
+	// The joint matrices and morph weights of all the submeshes are uploaded together
+	joint_matrices.clear();
+	morph_weights.clear();
+
+	std::vector<SkinningPushConstants> push_constants(instances.size());
+	std::vector<glm::mat4>             skin_matrices;
+
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		auto &instance = instances[i];
+		auto &constants = push_constants[i];
+
+		constants.vertex_count       = instance.vertex_count;
+		constants.first_vertex       = instance.first_vertex;
+		constants.first_joint        = to_u32(joint_matrices.size());
+		constants.first_weight       = to_u32(morph_weights.size());
+		constants.morph_target_count = instance.submesh->morph_target_count;
+		constants.position_offset    = instance.position_offset;
+		constants.normal_offset      = instance.normal_offset;
+		constants.has_normals        = instance.has_normals ? 1 : 0;
+
+		if (instance.skin)
+		{
+			instance.skin->compute_joint_matrices(*instance.node, skin_matrices);
+			joint_matrices.insert(joint_matrices.end(), skin_matrices.begin(), skin_matrices.end());
+		}
+
+		if (constants.morph_target_count > 0)
+		{
+			// Targets without a weight are not blended
+			auto &weights = instance.mesh->get_morph_weights();
+			for (uint32_t target = 0; target < constants.morph_target_count; target++)
+			{
+				morph_weights.push_back(target < weights.size() ? weights[target] : 0.0f);
+			}
+		}
+	}
+
+	auto &frame = render_context.get_active_frame();
+
+	auto joint_allocation = frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, std::max<size_t>(joint_matrices.size(), 1) * sizeof(glm::mat4));
+	auto weight_allocation = frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, std::max<size_t>(morph_weights.size(), 1) * sizeof(float));
+
+	if (!joint_matrices.empty())
+	{
+		joint_allocation.write(reinterpret_cast<const uint8_t *>(joint_matrices.data()), joint_matrices.size() * sizeof(glm::mat4));
+	}
+
+	if (!morph_weights.empty())
+	{
+		weight_allocation.write(reinterpret_cast<const uint8_t *>(morph_weights.data()), morph_weights.size() * sizeof(float));
+	}
+
+	// The draws of the previous frames read the vertices before they are rewritten
+	BufferMemoryBarrier write_barrier{};
+	write_barrier.src_access_mask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	write_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	write_barrier.src_stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	write_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	command_buffer.buffer_memory_barrier(arena->buffer, 0, VK_WHOLE_SIZE, write_barrier);
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		auto &instance = instances[i];
+		bool  morph    = instance.submesh->morph_target_count > 0;
+
+		auto &variant         = variants[(instance.skin ? 1 : 0) + (morph ? 2 : 0)];
+		auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader_source, variant);
+		auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		command_buffer.bind_buffer(*bind_pose_buffer, 0, bind_pose_buffer->get_size(), 0, 0, 0);
+
+		if (instance.skin)
+		{
+			command_buffer.bind_buffer(joint_allocation.get_buffer(), joint_allocation.get_offset(), joint_allocation.get_size(), 0, 1, 0);
+		}
+
+		if (morph)
+		{
+			auto &morph_targets = *instance.submesh->morph_target_buffer;
+			command_buffer.bind_buffer(morph_targets, 0, morph_targets.get_size(), 0, 2, 0);
+			command_buffer.bind_buffer(weight_allocation.get_buffer(), weight_allocation.get_offset(), weight_allocation.get_size(), 0, 3, 0);
+		}
+
+		command_buffer.bind_buffer(arena->buffer, 0, arena->buffer.get_size(), 0, 4, 0);
+
+		command_buffer.push_constants(push_constants[i]);
+
+		command_buffer.dispatch((instance.vertex_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	}
+
+	// Every pass of the frame draws the deformed vertices
+	BufferMemoryBarrier read_barrier{};
+	read_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	read_barrier.dst_access_mask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	read_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	read_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+
+	command_buffer.buffer_memory_barrier(arena->buffer, 0, VK_WHOLE_SIZE, read_barrier);
+}
+
+size_t GpuSkinning::get_instance_count() const
+{
+	return instances.size();
+}
+}        // namespace vkb
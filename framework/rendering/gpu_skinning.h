@@ -0,0 +1,153 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "core/buffer.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class GeometryArena;
+class Mesh;
+class Node;
+class Scene;
+class Skin;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Deforms the skinned meshes and the meshes with morph targets of a scene in a compute shader
+ *
+ * prepare() moves the vertices of each deformed submesh to a vertex arena added to the scene, and keeps
+ * their bind pose in a buffer of its own. Every update() rewrites the positions and normals of the arena
+ * from the bind pose: the morph targets are blended with the weights of the mesh, then the vertices are
+ * skinned by up to four joints of the skin of the node. Every pass drawing the submeshes, the geometry
+ * and the shadows alike, reads the deformed vertices from the arena as any other vertex data.
+ *
+ * A submesh is deformed for the first node drawing its mesh, the other nodes draw the same pose.
+ * The bounds of the meshes stay those of their bind pose.
+ */
+class GpuSkinning
+{
+  public:
+	static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+	GpuSkinning(RenderContext &render_context);
+
+	GpuSkinning(const GpuSkinning &) = delete;
+
+	GpuSkinning(GpuSkinning &&) = delete;
+
+	~GpuSkinning() = default;
+
+	GpuSkinning &operator=(const GpuSkinning &) = delete;
+
+	GpuSkinning &operator=(GpuSkinning &&) = delete;
+
+	/**
+	 * @brief Finds the deformed submeshes of a scene, and moves their vertices to the deformed vertex arena
+	 *        Called once the geometry of the scene is loaded, submeshes still streaming are not deformed.
+	 * @return The number of deformed submeshes
+	 */
+	size_t prepare(sg::Scene &scene);
+
+	/**
+	 * @brief Deforms the vertices to the current pose of the scene, must be recorded outside of a render pass
+	 *        before the draws of the frame. The world matrices of the scene must be up to date.
+	 */
+	void update(CommandBuffer &command_buffer);
+
+	size_t get_instance_count() const;
+
+  private:
+	/// Layout of the bind pose vertices in the compute shader
+	struct alignas(16) BindPoseVertex
+	{
+		glm::vec4 position;
+
+		glm::vec4 normal;
+
+		glm::uvec4 joints;
+
+		glm::vec4 weights;
+	};
+
+	struct Instance
+	{
+		sg::Node *node;
+
+		const sg::Skin *skin;
+
+		const sg::Mesh *mesh;
+
+		sg::SubMesh *submesh;
+
+		uint32_t vertex_count;
+
+		/// Index of the first vertex in the bind pose buffer
+		uint32_t first_vertex;
+
+		/// Offsets of the deformed positions and normals in the arena, in floats
+		uint32_t position_offset;
+
+		uint32_t normal_offset;
+
+		bool has_normals;
+	};
+
+	/**
+	 * @brief Converts the vertices of a submesh to the bind pose layout
+	 * @return Whether the formats of the attributes of the submesh are supported
+	 */
+	static bool read_bind_pose(const sg::SubMesh &submesh, bool skinned, std::vector<BindPoseVertex> &vertices);
+
+	RenderContext &render_context;
+
+	ShaderSource shader_source;
+
+	/// Variants of the shader, indexed by whether they skin plus twice whether they blend morph targets
+	std::array<ShaderVariant, 4> variants;
+
+	std::unique_ptr<core::Buffer> bind_pose_buffer;
+
+	/// The arena of the deformed vertices, owned by the scene
+	sg::GeometryArena *arena{nullptr};
+
+	std::vector<Instance> instances;
+
+	std::vector<glm::mat4> joint_matrices;
+
+	std::vector<float> morph_weights;
+};
+}        // namespace vkb
@@ -0,0 +1,264 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace
+{
+Light to_shader_light(sg::Light &light)
+{
+	const auto &properties = light.get_properties();
+	auto &      transform  = light.get_node()->get_transform();
+
+	return {{transform.get_translation(), static_cast<float>(light.get_light_type())},
+	        {properties.color, properties.intensity},
+	        {transform.get_rotation() * properties.direction, properties.range},
+	        {properties.inner_cone_angle, properties.outer_cone_angle}};
+}
+
+uint32_t to_tile(float ndc, uint32_t tile_count)
+{
+	// Projections close to the camera plane may be huge, clamp them before converting to an integer
+	ndc = std::min(std::max(ndc, -1.0f), 1.0f);
+
+	auto tile = static_cast<int32_t>(std::floor((ndc * 0.5f + 0.5f) * tile_count));
+
+	return static_cast<uint32_t>(std::min(std::max(tile, 0), static_cast<int32_t>(tile_count) - 1));
+}
+}        // namespace
+
+LightClusters::LightClusters(RenderContext &render_context) :
+    render_context{render_context},
+    cluster_lists(CLUSTER_COUNT)
+{
+}
+
+std::vector<std::string> LightClusters::get_shader_definitions()
+{
+	return {"CLUSTERED_LIGHTS",
+	        "LIGHT_CLUSTER_TILE_COUNT_X " + std::to_string(TILE_COUNT_X),
+	        "LIGHT_CLUSTER_TILE_COUNT_Y " + std::to_string(TILE_COUNT_Y),
+	        "LIGHT_CLUSTER_SLICE_COUNT " + std::to_string(SLICE_COUNT),
+	        "LIGHT_CLUSTER_COUNT " + std::to_string(CLUSTER_COUNT)};
+}
+
+void LightClusters::update(const std::vector<sg::Light *> &lights, sg::Camera &camera, const VkExtent2D &extent)
+{
+	if (auto perspective_camera = dynamic_cast<sg::PerspectiveCamera *>(&camera))
+	{
+		near_plane = perspective_camera->get_near_plane();
+		far_plane  = perspective_camera->get_far_plane();
+	}
+
+	// Slices are exponential: slice = log(depth) * scale + bias, 0 at the near plane and SLICE_COUNT at the far plane
+	depth_scale = SLICE_COUNT / std::log(far_plane / near_plane);
+	depth_bias  = -std::log(near_plane) * depth_scale;
+
+	auto view       = camera.get_view();
+	auto projection = camera.get_pre_rotation() * vulkan_style_projection(camera.get_projection());
+
+	shader_lights.clear();
+	light_ranges.clear();
+
+	// Lights reaching every cluster go first, the shaders apply them without looking up the clusters
+	for (auto light : lights)
+	{
+		if (light->get_light_type() == sg::LightType::Directional || light->get_properties().range <= 0.0f)
+		{
+			shader_lights.push_back(to_shader_light(*light));
+		}
+	}
+
+	auto global_light_count = to_u32(shader_lights.size());
+
+	for (auto light : lights)
+	{
+		float radius = light->get_properties().range;
+
+		if (light->get_light_type() == sg::LightType::Directional || radius <= 0.0f)
+		{
+			continue;
+		}
+
+		auto         center = glm::vec3(view * glm::vec4(light->get_node()->get_transform().get_translation(), 1.0f));
+		ClusterRange range;
+
+		if (get_cluster_range(center, radius, projection, range))
+		{
+			shader_lights.push_back(to_shader_light(*light));
+			light_ranges.push_back(range);
+		}
+	}
+
+	// Count the lights of each cluster, then turn the counts into offsets and fill the lists
+	std::fill(cluster_lists.begin(), cluster_lists.end(), glm::uvec2{0, 0});
+
+	for (auto &range : light_ranges)
+	{
+		for (uint32_t z = range.min.z; z <= range.max.z; ++z)
+		{
+			for (uint32_t y = range.min.y; y <= range.max.y; ++y)
+			{
+				for (uint32_t x = range.min.x; x <= range.max.x; ++x)
+				{
+					cluster_lists[(z * TILE_COUNT_Y + y) * TILE_COUNT_X + x].y++;
+				}
+			}
+		}
+	}
+
+	uint32_t index_count = 0;
+	for (auto &list : cluster_lists)
+	{
+		list.x = index_count;
+		index_count += list.y;
+		list.y = 0;
+	}
+
+	light_indices.resize(index_count);
+
+	for (uint32_t i = 0; i < to_u32(light_ranges.size()); ++i)
+	{
+		const auto &range       = light_ranges[i];
+		uint32_t    light_index = global_light_count + i;
+
+		for (uint32_t z = range.min.z; z <= range.max.z; ++z)
+		{
+			for (uint32_t y = range.min.y; y <= range.max.y; ++y)
+			{
+				for (uint32_t x = range.min.x; x <= range.max.x; ++x)
+				{
+					auto &list = cluster_lists[(z * TILE_COUNT_Y + y) * TILE_COUNT_X + x];
+
+					light_indices[list.x + list.y++] = light_index;
+				}
+			}
+		}
+	}
+
+	auto &render_frame = render_context.get_active_frame();
+
+	// Empty buffers cannot be bound, so there is always room for one light and one index
+	lights_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, std::max<size_t>(shader_lights.size(), 1) * sizeof(Light));
+	if (!shader_lights.empty())
+	{
+		lights_buffer.write(reinterpret_cast<const uint8_t *>(shader_lights.data()), shader_lights.size() * sizeof(Light));
+	}
+
+	auto lists_size = cluster_lists.size() * sizeof(glm::uvec2);
+
+	clusters_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, lists_size + std::max<size_t>(light_indices.size(), 1) * sizeof(uint32_t));
+	clusters_buffer.write(reinterpret_cast<const uint8_t *>(cluster_lists.data()), lists_size);
+	if (!light_indices.empty())
+	{
+		clusters_buffer.write(reinterpret_cast<const uint8_t *>(light_indices.data()), light_indices.size() * sizeof(uint32_t), to_u32(lists_size));
+	}
+
+	LightClusterUniform uniform;
+	uniform.view               = view;
+	uniform.inv_resolution     = {1.0f / extent.width, 1.0f / extent.height};
+	uniform.depth_scale        = depth_scale;
+	uniform.depth_bias         = depth_bias;
+	uniform.global_light_count = global_light_count;
+
+	uniform_buffer = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(LightClusterUniform));
+	uniform_buffer.update(uniform);
+}
+
+void LightClusters::bind(CommandBuffer &command_buffer)
+{
+	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, LIGHTS_BINDING, 0);
+	command_buffer.bind_buffer(uniform_buffer.get_buffer(), uniform_buffer.get_offset(), uniform_buffer.get_size(), 0, UNIFORM_BINDING, 0);
+	command_buffer.bind_buffer(clusters_buffer.get_buffer(), clusters_buffer.get_offset(), clusters_buffer.get_size(), 0, CLUSTERS_BINDING, 0);
+}
+
+size_t LightClusters::get_index_count() const
+{
+	return light_indices.size();
+}
+
+bool LightClusters::get_cluster_range(const glm::vec3 &view_center, float radius, const glm::mat4 &projection, ClusterRange &range) const
+{
+	// The camera looks down -Z in view space
+	float min_depth = -view_center.z - radius;
+	float max_depth = -view_center.z + radius;
+
+	if (max_depth < near_plane || min_depth > far_plane)
+	{
+		return false;
+	}
+
+	range.min.z = get_slice(std::max(min_depth, near_plane));
+	range.max.z = get_slice(std::min(max_depth, far_plane));
+
+	// Project the corners of the bounding box of the sphere, which bound its projection
+	glm::vec2 min_ndc{1.0f};
+	glm::vec2 max_ndc{-1.0f};
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		glm::vec3 offset{corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius};
+
+		auto clip = projection * glm::vec4(view_center + offset, 1.0f);
+
+		// A corner behind the camera projects to infinity, the sphere may cover any tile
+		if (clip.w <= std::numeric_limits<float>::epsilon())
+		{
+			min_ndc = glm::vec2{-1.0f};
+			max_ndc = glm::vec2{1.0f};
+			break;
+		}
+
+		auto ndc = glm::vec2(clip) / clip.w;
+		min_ndc  = glm::min(min_ndc, ndc);
+		max_ndc  = glm::max(max_ndc, ndc);
+	}
+
+	if (min_ndc.x > 1.0f || min_ndc.y > 1.0f || max_ndc.x < -1.0f || max_ndc.y < -1.0f)
+	{
+		return false;
+	}
+
+	range.min.x = to_tile(min_ndc.x, TILE_COUNT_X);
+	range.max.x = to_tile(max_ndc.x, TILE_COUNT_X);
+	range.min.y = to_tile(min_ndc.y, TILE_COUNT_Y);
+	range.max.y = to_tile(max_ndc.y, TILE_COUNT_Y);
+
+	return true;
+}
+
+uint32_t LightClusters::get_slice(float depth) const
+{
+	auto slice = static_cast<int32_t>(std::floor(std::log(depth) * depth_scale + depth_bias));
+
+	return static_cast<uint32_t>(std::min(std::max(slice, 0), static_cast<int32_t>(SLICE_COUNT) - 1));
+}
+}        // namespace vkb
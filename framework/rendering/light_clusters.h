@@ -0,0 +1,158 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "buffer_pool.h"
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "rendering/subpass.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Camera;
+class Light;
+}        // namespace sg
+
+/**
+ * @brief Uniform of the light clusters, the view is used to find the depth slice of a fragment
+ */
+struct alignas(16) LightClusterUniform
+{
+	glm::mat4 view;
+
+	glm::vec2 inv_resolution;
+
+	float depth_scale;
+
+	float depth_bias;
+
+	/// Lights at the start of the light buffer which reach every cluster, such as directional lights
+	uint32_t global_light_count;
+};
+
+/**
+ * @brief Assigns the lights of a scene to the clusters of the view frustum, so fragments only shade the lights reaching them
+ *
+ * The frustum is split into TILE_COUNT_X x TILE_COUNT_Y screen tiles and SLICE_COUNT depth slices, which
+ * grow exponentially from the near plane. The bounding sphere of each point and spot light is projected to
+ * the range of clusters it overlaps, then the lights of each cluster are written as a list of indices.
+ * Directional lights and lights without range reach every cluster, they are kept at the start of the light
+ * buffer instead.
+ *
+ * The assignment runs on the CPU in two passes over the light ranges, counting and then filling the lists,
+ * without any allocation once the vectors have grown. The lights, the uniform and the lists are written into
+ * buffers of the active frame, read by the shaders compiled with the variants of get_shader_definitions().
+ * Lights live in a storage buffer, so their number is only bounded by the size of the frame's buffer pools.
+ */
+class LightClusters
+{
+  public:
+	static constexpr uint32_t TILE_COUNT_X = 16;
+
+	static constexpr uint32_t TILE_COUNT_Y = 9;
+
+	static constexpr uint32_t SLICE_COUNT = 24;
+
+	static constexpr uint32_t CLUSTER_COUNT = TILE_COUNT_X * TILE_COUNT_Y * SLICE_COUNT;
+
+	/// Bindings in set 0, the lights replace the light uniform of the shaders
+	static constexpr uint32_t LIGHTS_BINDING = 4;
+
+	static constexpr uint32_t UNIFORM_BINDING = 5;
+
+	static constexpr uint32_t CLUSTERS_BINDING = 6;
+
+	LightClusters(RenderContext &render_context);
+
+	/**
+	 * @return The definitions of the shader variants reading the clusters
+	 */
+	static std::vector<std::string> get_shader_definitions();
+
+	/**
+	 * @brief Assigns the lights to the clusters of the camera, and writes them into buffers of the active frame
+	 * @param lights The lights of the scene
+	 * @param camera The camera looking at the scene
+	 * @param extent The extent of the render target
+	 */
+	void update(const std::vector<sg::Light *> &lights, sg::Camera &camera, const VkExtent2D &extent);
+
+	/**
+	 * @brief Binds the buffers written by the last update
+	 */
+	void bind(CommandBuffer &command_buffer);
+
+	/**
+	 * @return The number of light indices written by the last update, over all the clusters
+	 */
+	size_t get_index_count() const;
+
+  private:
+	/// Range of clusters overlapped by a light, inclusive
+	struct ClusterRange
+	{
+		glm::uvec3 min;
+
+		glm::uvec3 max;
+	};
+
+	/**
+	 * @return Whether the sphere is inside the frustum, in which case range holds the clusters it overlaps
+	 */
+	bool get_cluster_range(const glm::vec3 &view_center, float radius, const glm::mat4 &projection, ClusterRange &range) const;
+
+	uint32_t get_slice(float depth) const;
+
+	RenderContext &render_context;
+
+	float near_plane{0.1f};
+
+	float far_plane{1000.0f};
+
+	float depth_scale{0.0f};
+
+	float depth_bias{0.0f};
+
+	std::vector<Light> shader_lights;
+
+	std::vector<ClusterRange> light_ranges;
+
+	/// Offset and count of the indices of each cluster
+	std::vector<glm::uvec2> cluster_lists;
+
+	std::vector<uint32_t> light_indices;
+
+	BufferAllocation lights_buffer;
+
+	BufferAllocation uniform_buffer;
+
+	BufferAllocation clusters_buffer;
+};
+}        // namespace vkb
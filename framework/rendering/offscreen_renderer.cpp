@@ -0,0 +1,66 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/offscreen_renderer.h"
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+OffscreenRenderer::OffscreenRenderer(Device &device, const VkExtent2D &extent, uint32_t frame_count, JobSystem *job_system, RenderTarget::CreateFunc create_render_target_func)
+{
+	render_context = std::make_unique<RenderContext>(device, VK_NULL_HANDLE, extent.width, extent.height);
+	render_context->set_offscreen_frame_count(frame_count);
+	render_context->prepare(1, create_render_target_func);
+
+	// A readback buffer per frame, so that each request captures its own frame
+	frame_capture = std::make_unique<FrameCapture>(*render_context, job_system, frame_count);
+	frame_capture->set_wait_for_slots(true);
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+	flush();
+}
+
+RenderContext &OffscreenRenderer::get_render_context()
+{
+	return *render_context;
+}
+
+void OffscreenRenderer::render(const RecordFunc &record_func, const std::string &filename, FrameCapture::Format format)
+{
+	auto &command_buffer = render_context->begin();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	record_func(command_buffer, render_context->get_active_frame().get_render_target());
+
+	frame_capture->request(filename, format);
+	frame_capture->record(command_buffer);
+
+	command_buffer.end();
+
+	render_context->submit(command_buffer);
+}
+
+void OffscreenRenderer::flush()
+{
+	frame_capture->flush();
+}
+}        // namespace vkb
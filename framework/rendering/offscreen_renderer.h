@@ -0,0 +1,95 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "frame_capture.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class JobSystem;
+
+/**
+ * @brief Renders batches of frames into image files without a surface, for throughput rather than presentation
+ *
+ * It owns a render context without a swapchain, whose frames are rendered in turn, and reads each frame back
+ * through a FrameCapture. Several renderers can share a device, each rendering on a thread of its own:
+ * the queue serializes their submissions and each only waits on its own frames. They must be created
+ * and destroyed while no other renderer is rendering, as preparing a render context waits for the device.
+ */
+class OffscreenRenderer
+{
+  public:
+	/**
+	 * @brief Records a frame into the render target of the active frame
+	 *        The color attachment, view 0, must be left in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, as VulkanSample::draw does.
+	 */
+	using RecordFunc = std::function<void(CommandBuffer &command_buffer, RenderTarget &render_target)>;
+
+	static constexpr uint32_t DEFAULT_FRAME_COUNT = 3;
+
+	/**
+	 * @param device The device, shared with the other renderers
+	 * @param extent The extent of the rendered images
+	 * @param frame_count Number of frames in flight, and of readback buffers
+	 * @param job_system Optional job system encoding the images, they are encoded on the rendering thread otherwise
+	 * @param create_render_target_func Creates the render target of each frame from its color image
+	 */
+	OffscreenRenderer(Device &device, const VkExtent2D &extent, uint32_t frame_count = DEFAULT_FRAME_COUNT, JobSystem *job_system = nullptr,
+	                  RenderTarget::CreateFunc create_render_target_func = RenderTarget::DEFAULT_CREATE_FUNC);
+
+	OffscreenRenderer(const OffscreenRenderer &) = delete;
+
+	OffscreenRenderer(OffscreenRenderer &&) = delete;
+
+	/**
+	 * @brief Writes the frames still in flight
+	 */
+	~OffscreenRenderer();
+
+	OffscreenRenderer &operator=(const OffscreenRenderer &) = delete;
+
+	OffscreenRenderer &operator=(OffscreenRenderer &&) = delete;
+
+	RenderContext &get_render_context();
+
+	/**
+	 * @brief Records and submits a frame, its image is written once the frame comes around again
+	 * @param record_func Records the frame
+	 * @param filename The name of the image file in the screenshots directory, without an extension
+	 * @param format The format of the image file
+	 */
+	void render(const RecordFunc &record_func, const std::string &filename, FrameCapture::Format format = FrameCapture::Format::PNG);
+
+	/**
+	 * @brief Waits for the frames in flight and writes their images
+	 */
+	void flush();
+
+  private:
+	std::unique_ptr<RenderContext> render_context;
+
+	std::unique_ptr<FrameCapture> frame_capture;
+};
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "pipeline_state.h"
 
+#include "common/resource_caching.h"
+
 bool operator==(const VkVertexInputAttributeDescription &lhs, const VkVertexInputAttributeDescription &rhs)
 {
 	return std::tie(lhs.binding, lhs.format, lhs.location, lhs.offset) == std::tie(rhs.binding, rhs.format, rhs.location, rhs.offset);
@@ -72,6 +74,16 @@ bool operator!=(const vkb::DepthStencilState &lhs, const vkb::DepthStencilState
 	       lhs.back != rhs.back || lhs.front != rhs.front;
 }
 
+bool operator!=(const vkb::FragmentShadingRateState &lhs, const vkb::FragmentShadingRateState &rhs)
+{
+#ifdef VK_KHR_fragment_shading_rate
+	return std::tie(lhs.fragment_size.width, lhs.fragment_size.height, lhs.combiner_ops[0], lhs.combiner_ops[1]) !=
+	       std::tie(rhs.fragment_size.width, rhs.fragment_size.height, rhs.combiner_ops[0], rhs.combiner_ops[1]);
+#else
+	return std::tie(lhs.fragment_size.width, lhs.fragment_size.height) != std::tie(rhs.fragment_size.width, rhs.fragment_size.height);
+#endif
+}
+
 bool operator!=(const vkb::ColorBlendState &lhs, const vkb::ColorBlendState &rhs)
 {
 	return std::tie(lhs.logic_op, lhs.logic_op_enable) != std::tie(rhs.logic_op, rhs.logic_op_enable) ||
@@ -89,6 +101,8 @@ void SpecializationConstantState::reset()
 	if (dirty)
 	{
 		specialization_constant_state.clear();
+
+		update_hash();
 	}
 
 	dirty = false;
@@ -105,22 +119,32 @@ void SpecializationConstantState::clear_dirty()
 }
 
 void SpecializationConstantState::set_constant(uint32_t constant_id, const std::vector<uint8_t> &value)
+{
+	set_constant(constant_id, value.data(), value.size());
+}
+
+void SpecializationConstantState::set_constant(uint32_t constant_id, const uint8_t *value, size_t size)
 {
 	auto data = specialization_constant_state.find(constant_id);
 
-	if (data != specialization_constant_state.end() && data->second == value)
+	if (data != specialization_constant_state.end() && data->second.size() == size && std::equal(value, value + size, data->second.begin()))
 	{
 		return;
 	}
 
 	dirty = true;
 
-	specialization_constant_state[constant_id] = value;
+	// Assigned in place, the vector of a constant set every frame keeps its storage
+	specialization_constant_state[constant_id].assign(value, value + size);
+
+	update_hash();
 }
 
 void SpecializationConstantState::set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state)
 {
 	specialization_constant_state = state;
+
+	update_hash();
 }
 
 const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get_specialization_constant_state() const
@@ -128,6 +152,27 @@ const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get
 	return specialization_constant_state;
 }
 
+size_t SpecializationConstantState::get_hash() const
+{
+	return hash;
+}
+
+void SpecializationConstantState::update_hash()
+{
+	hash = 0;
+
+	for (auto &constant : specialization_constant_state)
+	{
+		hash_combine(hash, constant.first);
+		hash_combine(hash, std::string{constant.second.begin(), constant.second.end()});
+	}
+}
+
+PipelineState::PipelineState()
+{
+	reset();
+}
+
 void PipelineState::reset()
 {
 	clear_dirty();
@@ -136,9 +181,15 @@ void PipelineState::reset()
 
 	render_pass = nullptr;
 
+	color_attachment_formats.clear();
+
+	depth_stencil_attachment_format = VK_FORMAT_UNDEFINED;
+
 	specialization_constant_state.reset();
 
-	vertex_input_sate = {};
+	// The vectors of the states keep their capacity for the next recording
+	vertex_input_sate.bindings.clear();
+	vertex_input_sate.attributes.clear();
 
 	input_assembly_state = {};
 
@@ -148,52 +199,99 @@ void PipelineState::reset()
 
 	depth_stencil_state = {};
 
-	color_blend_state = {};
+	color_blend_state.logic_op_enable = VK_FALSE;
+	color_blend_state.logic_op        = VK_LOGIC_OP_CLEAR;
+	color_blend_state.attachments.clear();
+
+	fragment_shading_rate_state = {};
 
 	subpass_index = {0U};
+
+	state_hashes = {};
+
+	state_hashes[SubpassIndexHash]  = std::hash<uint32_t>{}(subpass_index);
+	state_hashes[VertexInputHash]   = std::hash<VertexInputState>{}(vertex_input_sate);
+	state_hashes[InputAssemblyHash] = std::hash<InputAssemblyState>{}(input_assembly_state);
+	state_hashes[RasterizationHash] = std::hash<RasterizationState>{}(rasterization_state);
+	state_hashes[ViewportHash]      = std::hash<ViewportState>{}(viewport_state);
+	state_hashes[MultisampleHash]   = std::hash<MultisampleState>{}(multisample_state);
+	state_hashes[DepthStencilHash]  = std::hash<DepthStencilState>{}(depth_stencil_state);
+	state_hashes[ColorBlendHash]    = std::hash<ColorBlendState>{}(color_blend_state);
+
+	state_hashes[FragmentShadingRateHash] = std::hash<FragmentShadingRateState>{}(fragment_shading_rate_state);
 }
 
 void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 {
-	if (pipeline_layout)
+	if (pipeline_layout && pipeline_layout->get_handle() == new_pipeline_layout.get_handle())
 	{
-		if (pipeline_layout->get_handle() != new_pipeline_layout.get_handle())
-		{
-			pipeline_layout = &new_pipeline_layout;
-
-			dirty = true;
-		}
+		return;
 	}
-	else
-	{
-		pipeline_layout = &new_pipeline_layout;
 
-		dirty = true;
+	pipeline_layout = &new_pipeline_layout;
+
+	size_t hash = 0;
+	hash_combine(hash, pipeline_layout->get_handle());
+	for (auto shader_module : pipeline_layout->get_shader_modules())
+	{
+		hash_combine(hash, shader_module->get_id());
 	}
+	state_hashes[PipelineLayoutHash] = hash;
+
+	dirty = true;
 }
 
 void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 {
-	if (render_pass)
+	if (render_pass && render_pass->get_handle() == new_render_pass.get_handle())
 	{
-		if (render_pass->get_handle() != new_render_pass.get_handle())
-		{
-			render_pass = &new_render_pass;
-
-			dirty = true;
-		}
+		return;
 	}
-	else
+
+	render_pass = &new_render_pass;
+
+	color_attachment_formats.clear();
+
+	depth_stencil_attachment_format = VK_FORMAT_UNDEFINED;
+
+	state_hashes[RenderPassHash] = std::hash<VkRenderPass>{}(render_pass->get_handle());
+
+	dirty = true;
+}
+
+void PipelineState::set_rendering_formats(const std::vector<VkFormat> &color_formats, VkFormat depth_stencil_format)
+{
+	if (!render_pass && color_attachment_formats == color_formats && depth_stencil_attachment_format == depth_stencil_format)
 	{
-		render_pass = &new_render_pass;
+		return;
+	}
 
-		dirty = true;
+	render_pass = nullptr;
+
+	color_attachment_formats = color_formats;
+
+	depth_stencil_attachment_format = depth_stencil_format;
+
+	// The formats take the place of the render pass in the hash
+	size_t hash = 0;
+	for (auto format : color_attachment_formats)
+	{
+		hash_combine(hash, format);
 	}
+	hash_combine(hash, depth_stencil_attachment_format);
+	state_hashes[RenderPassHash] = hash;
+
+	dirty = true;
 }
 
 void PipelineState::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
 {
-	specialization_constant_state.set_constant(constant_id, data);
+	set_specialization_constant(constant_id, data.data(), data.size());
+}
+
+void PipelineState::set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size)
+{
+	specialization_constant_state.set_constant(constant_id, data, size);
 
 	if (specialization_constant_state.is_dirty())
 	{
@@ -207,6 +305,8 @@ void PipelineState::set_vertex_input_state(const VertexInputState &new_vertex_in
 	{
 		vertex_input_sate = new_vertex_input_sate;
 
+		state_hashes[VertexInputHash] = std::hash<VertexInputState>{}(vertex_input_sate);
+
 		dirty = true;
 	}
 }
@@ -217,6 +317,8 @@ void PipelineState::set_input_assembly_state(const InputAssemblyState &new_input
 	{
 		input_assembly_state = new_input_assembly_state;
 
+		state_hashes[InputAssemblyHash] = std::hash<InputAssemblyState>{}(input_assembly_state);
+
 		dirty = true;
 	}
 }
@@ -227,6 +329,8 @@ void PipelineState::set_rasterization_state(const RasterizationState &new_raster
 	{
 		rasterization_state = new_rasterization_state;
 
+		state_hashes[RasterizationHash] = std::hash<RasterizationState>{}(rasterization_state);
+
 		dirty = true;
 	}
 }
@@ -237,6 +341,8 @@ void PipelineState::set_viewport_state(const ViewportState &new_viewport_state)
 	{
 		viewport_state = new_viewport_state;
 
+		state_hashes[ViewportHash] = std::hash<ViewportState>{}(viewport_state);
+
 		dirty = true;
 	}
 }
@@ -247,6 +353,8 @@ void PipelineState::set_multisample_state(const MultisampleState &new_multisampl
 	{
 		multisample_state = new_multisample_state;
 
+		state_hashes[MultisampleHash] = std::hash<MultisampleState>{}(multisample_state);
+
 		dirty = true;
 	}
 }
@@ -257,6 +365,8 @@ void PipelineState::set_depth_stencil_state(const DepthStencilState &new_depth_s
 	{
 		depth_stencil_state = new_depth_stencil_state;
 
+		state_hashes[DepthStencilHash] = std::hash<DepthStencilState>{}(depth_stencil_state);
+
 		dirty = true;
 	}
 }
@@ -267,6 +377,20 @@ void PipelineState::set_color_blend_state(const ColorBlendState &new_color_blend
 	{
 		color_blend_state = new_color_blend_state;
 
+		state_hashes[ColorBlendHash] = std::hash<ColorBlendState>{}(color_blend_state);
+
+		dirty = true;
+	}
+}
+
+void PipelineState::set_fragment_shading_rate_state(const FragmentShadingRateState &new_fragment_shading_rate_state)
+{
+	if (fragment_shading_rate_state != new_fragment_shading_rate_state)
+	{
+		fragment_shading_rate_state = new_fragment_shading_rate_state;
+
+		state_hashes[FragmentShadingRateHash] = std::hash<FragmentShadingRateState>{}(fragment_shading_rate_state);
+
 		dirty = true;
 	}
 }
@@ -277,6 +401,8 @@ void PipelineState::set_subpass_index(uint32_t new_subpass_index)
 	{
 		subpass_index = new_subpass_index;
 
+		state_hashes[SubpassIndexHash] = std::hash<uint32_t>{}(subpass_index);
+
 		dirty = true;
 	}
 }
@@ -292,6 +418,16 @@ const RenderPass *PipelineState::get_render_pass() const
 	return render_pass;
 }
 
+const std::vector<VkFormat> &PipelineState::get_color_attachment_formats() const
+{
+	return color_attachment_formats;
+}
+
+VkFormat PipelineState::get_depth_stencil_attachment_format() const
+{
+	return depth_stencil_attachment_format;
+}
+
 const SpecializationConstantState &PipelineState::get_specialization_constant_state() const
 {
 	return specialization_constant_state;
@@ -332,6 +468,11 @@ const ColorBlendState &PipelineState::get_color_blend_state() const
 	return color_blend_state;
 }
 
+const FragmentShadingRateState &PipelineState::get_fragment_shading_rate_state() const
+{
+	return fragment_shading_rate_state;
+}
+
 uint32_t PipelineState::get_subpass_index() const
 {
 	return subpass_index;
@@ -347,4 +488,57 @@ void PipelineState::clear_dirty()
 	dirty = false;
 	specialization_constant_state.clear_dirty();
 }
+
+size_t PipelineState::get_hash() const
+{
+	size_t result = specialization_constant_state.get_hash();
+
+	for (auto state_hash : state_hashes)
+	{
+		hash_combine(result, state_hash);
+	}
+
+	return result;
+}
+
+size_t PipelineState::get_library_hash(PipelineLibraryType type) const
+{
+	size_t result = 0;
+
+	hash_combine(result, static_cast<std::underlying_type<PipelineLibraryType>::type>(type));
+
+	switch (type)
+	{
+		case PipelineLibraryType::VertexInput:
+			hash_combine(result, state_hashes[VertexInputHash]);
+			hash_combine(result, state_hashes[InputAssemblyHash]);
+			break;
+		case PipelineLibraryType::PreRasterization:
+			hash_combine(result, state_hashes[PipelineLayoutHash]);
+			hash_combine(result, state_hashes[RenderPassHash]);
+			hash_combine(result, state_hashes[SubpassIndexHash]);
+			hash_combine(result, state_hashes[ViewportHash]);
+			hash_combine(result, state_hashes[RasterizationHash]);
+			hash_combine(result, state_hashes[FragmentShadingRateHash]);
+			hash_combine(result, specialization_constant_state.get_hash());
+			break;
+		case PipelineLibraryType::FragmentShader:
+			hash_combine(result, state_hashes[PipelineLayoutHash]);
+			hash_combine(result, state_hashes[RenderPassHash]);
+			hash_combine(result, state_hashes[SubpassIndexHash]);
+			hash_combine(result, state_hashes[MultisampleHash]);
+			hash_combine(result, state_hashes[DepthStencilHash]);
+			hash_combine(result, state_hashes[FragmentShadingRateHash]);
+			hash_combine(result, specialization_constant_state.get_hash());
+			break;
+		case PipelineLibraryType::FragmentOutput:
+			hash_combine(result, state_hashes[RenderPassHash]);
+			hash_combine(result, state_hashes[SubpassIndexHash]);
+			hash_combine(result, state_hashes[MultisampleHash]);
+			hash_combine(result, state_hashes[ColorBlendHash]);
+			break;
+	}
+
+	return result;
+}
 }        // namespace vkb
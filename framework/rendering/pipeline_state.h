@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "common/vk_common.h"
@@ -133,6 +134,20 @@ struct ColorBlendState
 	std::vector<ColorBlendAttachmentState> attachments;
 };
 
+/**
+ * @brief Rate of the fragment shading (VK_KHR_fragment_shading_rate), only used when the device enabled the extension
+ *        The first combiner op merges the pipeline rate with the primitive one, the second merges the result
+ *        with the rate of the shading rate attachment of the subpass.
+ */
+struct FragmentShadingRateState
+{
+	VkExtent2D fragment_size{1, 1};
+
+#ifdef VK_KHR_fragment_shading_rate
+	std::array<VkFragmentShadingRateCombinerOpKHR, 2> combiner_ops{VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR, VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR};
+#endif
+};
+
 /// Helper class to create specialization constants for a Vulkan pipeline. The state tracks a pipeline globally, and not per shader. Two shaders using the same constant_id will have the same data.
 class SpecializationConstantState
 {
@@ -148,39 +163,77 @@ class SpecializationConstantState
 
 	void set_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
+	void set_constant(uint32_t constant_id, const uint8_t *data, size_t size);
+
 	void set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state);
 
 	const std::map<uint32_t, std::vector<uint8_t>> &get_specialization_constant_state() const;
 
+	/// @brief Hash of the constants, updated whenever a constant changes
+	size_t get_hash() const;
+
+	/**
+	 * @brief Combines the hashes of the states used by one part of the pipeline,
+	 *        so that pipelines only differing in other states share that library
+	 */
+	size_t get_library_hash(PipelineLibraryType type) const;
+
   private:
+	void update_hash();
+
 	bool dirty{false};
 	// Map tracking state of the Specialization Constants
 	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state;
+
+	size_t hash{0};
 };
 
 template <class T>
 inline void SpecializationConstantState::set_constant(std::uint32_t constant_id, const T &data)
 {
-	set_constant(constant_id, to_bytes(static_cast<std::uint32_t>(data)));
+	auto value = static_cast<std::uint32_t>(data);
+	set_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), sizeof(value));
 }
 
 template <>
 inline void SpecializationConstantState::set_constant<bool>(std::uint32_t constant_id, const bool &data)
 {
-	set_constant(constant_id, to_bytes(static_cast<std::uint32_t>(data)));
+	auto value = static_cast<std::uint32_t>(data);
+	set_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), sizeof(value));
 }
 
+/**
+ * @brief Parts of a graphics pipeline which can be created separately as
+ *        pipeline libraries with VK_EXT_graphics_pipeline_library
+ */
+enum class PipelineLibraryType
+{
+	VertexInput,
+	PreRasterization,
+	FragmentShader,
+	FragmentOutput
+};
+
 class PipelineState
 {
   public:
+	PipelineState();
+
 	void reset();
 
 	void set_pipeline_layout(PipelineLayout &pipeline_layout);
 
 	void set_render_pass(const RenderPass &render_pass);
 
+	/**
+	 * @brief Sets the attachment formats of a dynamic rendering scope, which replace the render pass of the pipeline
+	 */
+	void set_rendering_formats(const std::vector<VkFormat> &color_formats, VkFormat depth_stencil_format);
+
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
+	void set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size);
+
 	void set_vertex_input_state(const VertexInputState &vertex_input_sate);
 
 	void set_input_assembly_state(const InputAssemblyState &input_assembly_state);
@@ -195,12 +248,18 @@ class PipelineState
 
 	void set_color_blend_state(const ColorBlendState &color_blend_state);
 
+	void set_fragment_shading_rate_state(const FragmentShadingRateState &fragment_shading_rate_state);
+
 	void set_subpass_index(uint32_t subpass_index);
 
 	const PipelineLayout &get_pipeline_layout() const;
 
 	const RenderPass *get_render_pass() const;
 
+	const std::vector<VkFormat> &get_color_attachment_formats() const;
+
+	VkFormat get_depth_stencil_attachment_format() const;
+
 	const SpecializationConstantState &get_specialization_constant_state() const;
 
 	const VertexInputState &get_vertex_input_state() const;
@@ -217,19 +276,57 @@ class PipelineState
 
 	const ColorBlendState &get_color_blend_state() const;
 
+	const FragmentShadingRateState &get_fragment_shading_rate_state() const;
+
 	uint32_t get_subpass_index() const;
 
 	bool is_dirty() const;
 
 	void clear_dirty();
 
+	/**
+	 * @brief Combines the hashes of the pipeline layout, render pass and fixed function states
+	 *        The setters rehash a state only when it changes, so a pipeline lookup
+	 *        combines a few words instead of walking every field.
+	 */
+	size_t get_hash() const;
+
+	/**
+	 * @brief Combines the hashes of the states used by one part of the pipeline,
+	 *        so that pipelines only differing in other states share that library
+	 */
+	size_t get_library_hash(PipelineLibraryType type) const;
+
   private:
+	enum StateHash
+	{
+		PipelineLayoutHash,
+		RenderPassHash,
+		SubpassIndexHash,
+		VertexInputHash,
+		InputAssemblyHash,
+		RasterizationHash,
+		ViewportHash,
+		MultisampleHash,
+		DepthStencilHash,
+		ColorBlendHash,
+		FragmentShadingRateHash,
+		StateHashCount
+	};
+
 	bool dirty{false};
 
+	std::array<size_t, StateHashCount> state_hashes{};
+
 	PipelineLayout *pipeline_layout{nullptr};
 
 	const RenderPass *render_pass{nullptr};
 
+	/// Attachment formats of the pipelines created without a render pass
+	std::vector<VkFormat> color_attachment_formats;
+
+	VkFormat depth_stencil_attachment_format{VK_FORMAT_UNDEFINED};
+
 	SpecializationConstantState specialization_constant_state{};
 
 	VertexInputState vertex_input_sate{};
@@ -246,6 +343,8 @@ class PipelineState
 
 	ColorBlendState color_blend_state{};
 
+	FragmentShadingRateState fragment_shading_rate_state{};
+
 	uint32_t subpass_index{0U};
 };
 }        // namespace vkb
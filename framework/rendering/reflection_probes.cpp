@@ -0,0 +1,468 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/reflection_probes.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Direction and up vector of the cameras of the faces, in the order of the layers of a cube map
+ *        With the flipped projection of Vulkan each face is rendered upside down, the copy to the cube map flips it.
+ */
+const std::array<std::pair<glm::vec3, glm::vec3>, ReflectionProbes::FACE_COUNT> FACE_ORIENTATIONS{{
+    {{1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+    {{-1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+    {{0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    {{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+    {{0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},
+    {{0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}},
+}};
+
+/**
+ * @brief Push constants of the prefilter
+ */
+struct PrefilterPushConstants
+{
+	uint32_t size;
+
+	/// Width of the lobe convolving the previous level into this one
+	float alpha;
+};
+
+constexpr uint32_t PREFILTER_WORKGROUP_SIZE = 8;
+}        // namespace
+
+ReflectionProbes::ReflectionProbes(RenderContext &render_context, sg::Scene &scene, uint32_t face_size) :
+    render_context{render_context},
+    scene{scene},
+    face_size{face_size},
+    prefilter_shader{"reflection_probes/prefilter.comp"}
+{
+	// Down to a few texels, smaller levels are too coarse to hold the lobes of the rough surfaces
+	level_count = static_cast<uint32_t>(std::log2(face_size / std::min(face_size, MIN_LEVEL_SIZE))) + 1;
+
+	for (uint32_t face = 0; face < FACE_COUNT; ++face)
+	{
+		auto node   = std::make_unique<sg::Node>(face, "reflection_probe_face");
+		auto camera = std::make_unique<sg::PerspectiveCamera>("reflection_probe_camera");
+
+		camera->set_field_of_view(glm::radians(90.0f));
+		camera->set_aspect_ratio(1.0f);
+		camera->set_node(*node);
+		node->set_component(*camera);
+
+		auto &orientation = FACE_ORIENTATIONS[face];
+		node->get_transform().set_rotation(glm::quat_cast(glm::inverse(glm::lookAt(glm::vec3(0.0f), orientation.first, orientation.second))));
+
+		face_nodes.push_back(std::move(node));
+		face_cameras.push_back(std::move(camera));
+	}
+
+	auto multiview = render_context.get_device().supports_multiview();
+
+	if (!multiview)
+	{
+		LOGW("Multiview is not supported, the reflection probes are rendered in a pass per face");
+	}
+
+	for (uint32_t face = 0; face < (multiview ? 1 : FACE_COUNT); ++face)
+	{
+		capture_targets.push_back(create_capture_target(multiview ? FACE_COUNT : 1));
+
+		auto subpass = std::make_unique<ForwardSubpass>(render_context, ShaderSource{"base.vert"}, ShaderSource{"base.frag"}, scene, *face_cameras[face]);
+
+		// The views are set before the pipeline prepares the shader variants
+		if (multiview)
+		{
+			std::vector<sg::Camera *> views;
+			for (auto &camera : face_cameras)
+			{
+				views.push_back(camera.get());
+			}
+
+			subpass->set_views(views);
+		}
+
+		auto pipeline = std::make_unique<RenderPipeline>();
+		pipeline->add_subpass(std::move(subpass));
+		pipeline->set_load_store({{VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE}, {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE}});
+
+		capture_pipelines.push_back(std::move(pipeline));
+	}
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.maxLod        = VK_LOD_CLAMP_NONE;
+	sampler                    = &render_context.get_device().get_resource_cache().request_sampler(sampler_info);
+}
+
+// The subpasses reference the cameras, they are destroyed first
+ReflectionProbes::~ReflectionProbes()
+{
+	capture_pipelines.clear();
+}
+
+std::unique_ptr<RenderTarget> ReflectionProbes::create_capture_target(uint32_t layer_count)
+{
+	auto &device = render_context.get_device();
+
+	VkExtent3D extent{face_size, face_size, 1};
+
+	std::vector<core::Image> images;
+	images.emplace_back(device, extent, FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+	                    VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, 1, layer_count);
+	// The depth needs the layers of the views as well
+	images.emplace_back(device, extent, get_suitable_depth_format(device.get_gpu()), VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+	                    VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, 1, layer_count);
+
+	return std::make_unique<RenderTarget>(std::move(images));
+}
+
+uint32_t ReflectionProbes::add_probe(const glm::vec3 &position)
+{
+	auto &device = render_context.get_device();
+
+	Probe probe;
+	probe.position = position;
+	probe.image    = std::make_unique<core::Image>(device, VkExtent3D{face_size, face_size, 1}, FORMAT,
+	                                               VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                               VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, level_count, FACE_COUNT,
+	                                               VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+
+	auto &resource_cache = device.get_resource_cache();
+
+	probe.view = &resource_cache.request_image_view(*probe.image, VK_IMAGE_VIEW_TYPE_CUBE);
+
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		probe.level_views.push_back(&resource_cache.request_image_view(*probe.image, VK_IMAGE_VIEW_TYPE_CUBE, FORMAT, level, 1));
+		probe.storage_views.push_back(&resource_cache.request_image_view(*probe.image, VK_IMAGE_VIEW_TYPE_2D_ARRAY, FORMAT, level, 1));
+	}
+
+	probes.push_back(std::move(probe));
+
+	return to_u32(probes.size() - 1);
+}
+
+void ReflectionProbes::set_probe_position(uint32_t probe, const glm::vec3 &position)
+{
+	auto &target = probes.at(probe);
+
+	if (target.position != position)
+	{
+		target.position = position;
+		target.outdated = true;
+	}
+}
+
+uint32_t ReflectionProbes::get_probe_count() const
+{
+	return to_u32(probes.size());
+}
+
+void ReflectionProbes::invalidate()
+{
+	for (auto &probe : probes)
+	{
+		probe.outdated = true;
+	}
+}
+
+void ReflectionProbes::set_continuous_updates(bool enabled)
+{
+	continuous_updates = enabled;
+}
+
+void ReflectionProbes::set_probes_per_frame(uint32_t count)
+{
+	probes_per_frame = std::max(count, 1u);
+}
+
+void ReflectionProbes::set_clip_planes(float near_plane, float far_plane)
+{
+	for (auto &camera : face_cameras)
+	{
+		camera->set_near_plane(near_plane);
+		camera->set_far_plane(far_plane);
+	}
+}
+
+void ReflectionProbes::update(CommandBuffer &command_buffer)
+{
+	rendered_probe_count = 0;
+
+	if (probes.empty())
+	{
+		return;
+	}
+
+	// The outdated probes go first, they would reflect a wrong scene otherwise
+	std::vector<uint32_t> selected;
+	for (uint32_t i = 0; i < probes.size() && selected.size() < probes_per_frame; ++i)
+	{
+		if (probes[i].outdated)
+		{
+			selected.push_back(i);
+		}
+	}
+
+	if (selected.empty() && continuous_updates)
+	{
+		for (uint32_t i = 0; i < std::min(probes_per_frame, to_u32(probes.size())); ++i)
+		{
+			selected.push_back(next_probe);
+			next_probe = (next_probe + 1) % to_u32(probes.size());
+		}
+	}
+
+	for (auto index : selected)
+	{
+		auto &probe = probes[index];
+
+		render_probe(command_buffer, probe);
+		prefilter(command_buffer, probe);
+
+		probe.outdated = false;
+		probe.ready    = true;
+	}
+
+	rendered_probe_count = to_u32(selected.size());
+}
+
+void ReflectionProbes::render_probe(CommandBuffer &command_buffer, Probe &probe)
+{
+	for (auto &node : face_nodes)
+	{
+		node->get_transform().set_translation(probe.position);
+	}
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(face_size);
+	viewport.height   = static_cast<float>(face_size);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.extent = {face_size, face_size};
+
+	for (size_t i = 0; i < capture_targets.size(); ++i)
+	{
+		auto &views = capture_targets[i]->get_views();
+
+		{
+			// The last copy read the color, the depth is not kept
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			memory_barrier.src_access_mask = 0;
+			memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+			command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+		}
+
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			memory_barrier.src_access_mask = 0;
+			memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+			command_buffer.image_memory_barrier(views.at(1), memory_barrier);
+		}
+
+		command_buffer.set_viewport(0, {viewport});
+		command_buffer.set_scissor(0, {scissor});
+
+		capture_pipelines[i]->draw(command_buffer, *capture_targets[i]);
+
+		command_buffer.end_render_pass();
+
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+			command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+		}
+	}
+
+	auto &level_view = *probe.level_views[0];
+
+	{
+		// The last frames sampled the cube map
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(level_view, memory_barrier);
+	}
+
+	// Flips the faces vertically into the orientation of the cube map
+	auto size = static_cast<int32_t>(face_size);
+
+	for (uint32_t face = 0; face < FACE_COUNT; ++face)
+	{
+		auto  layered = capture_targets.size() == 1;
+		auto &source  = capture_targets[layered ? 0 : face]->get_views().at(0).get_image();
+
+		VkImageBlit region{};
+		region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, layered ? face : 0, 1};
+		region.srcOffsets[1]  = {size, size, 1};
+		region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, face, 1};
+		region.dstOffsets[0]  = {0, size, 0};
+		region.dstOffsets[1]  = {size, 0, 1};
+
+		command_buffer.blit_image(source, *probe.image, {region});
+	}
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(level_view, memory_barrier);
+	}
+}
+
+void ReflectionProbes::prefilter(CommandBuffer &command_buffer, Probe &probe)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, prefilter_shader);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	float previous_alpha = 0.0f;
+
+	for (uint32_t level = 1; level < level_count; ++level)
+	{
+		auto &storage_view = *probe.storage_views[level];
+
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+			memory_barrier.src_access_mask = 0;
+			memory_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+			command_buffer.image_memory_barrier(storage_view, memory_barrier);
+		}
+
+		// Each level convolves the previous one, its lobe widens the previous lobe to the one of its roughness
+		float roughness = static_cast<float>(level) / static_cast<float>(level_count - 1);
+		float alpha     = roughness * roughness;
+
+		PrefilterPushConstants push_constants{};
+		push_constants.size  = std::max(face_size >> level, 1u);
+		push_constants.alpha = std::sqrt(std::max(alpha * alpha - previous_alpha * previous_alpha, 0.0f));
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		command_buffer.bind_image(*probe.level_views[level - 1], *sampler, 0, 0, 0);
+		command_buffer.bind_input(storage_view, 0, 1, 0);
+
+		command_buffer.push_constants(push_constants);
+
+		auto group_count = (push_constants.size + PREFILTER_WORKGROUP_SIZE - 1) / PREFILTER_WORKGROUP_SIZE;
+		command_buffer.dispatch(group_count, group_count, FACE_COUNT);
+
+		// The level is sampled by the filter of the next level and the passes reflecting the probe
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+			memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+			command_buffer.image_memory_barrier(storage_view, memory_barrier);
+		}
+
+		previous_alpha = alpha;
+	}
+}
+
+bool ReflectionProbes::is_ready(uint32_t probe) const
+{
+	return probes.at(probe).ready;
+}
+
+const core::ImageView &ReflectionProbes::get_environment(uint32_t probe) const
+{
+	return *probes.at(probe).view;
+}
+
+void ReflectionProbes::bind(CommandBuffer &command_buffer, uint32_t probe, uint32_t set, uint32_t binding) const
+{
+	command_buffer.bind_image(*probes.at(probe).view, *sampler, set, binding, 0);
+}
+
+uint32_t ReflectionProbes::get_level_count() const
+{
+	return level_count;
+}
+
+uint32_t ReflectionProbes::get_rendered_probe_count() const
+{
+	return rendered_probe_count;
+}
+}        // namespace vkb
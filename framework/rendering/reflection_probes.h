@@ -0,0 +1,201 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Node;
+class PerspectiveCamera;
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Environment cube maps of the scene rendered at probe positions, for dynamic reflections
+ *        The faces of a probe are drawn in a single multiview pass by a ForwardSubpass, or in a pass per face on devices
+ *        without multiview. The levels of the cube map are then prefiltered in compute for an increasing roughness,
+ *        the first level being the mirror reflection. The updates are time-sliced, a few probes are rendered each frame.
+ */
+class ReflectionProbes
+{
+  public:
+	/**
+	 * @param face_size Width and height of the faces of the cube maps in texels
+	 */
+	ReflectionProbes(RenderContext &render_context, sg::Scene &scene, uint32_t face_size = DEFAULT_FACE_SIZE);
+
+	ReflectionProbes(const ReflectionProbes &) = delete;
+
+	ReflectionProbes(ReflectionProbes &&) = delete;
+
+	~ReflectionProbes();
+
+	ReflectionProbes &operator=(const ReflectionProbes &) = delete;
+
+	ReflectionProbes &operator=(ReflectionProbes &&) = delete;
+
+	/**
+	 * @return The index of the probe, rendered by one of the next updates
+	 */
+	uint32_t add_probe(const glm::vec3 &position);
+
+	void set_probe_position(uint32_t probe, const glm::vec3 &position);
+
+	uint32_t get_probe_count() const;
+
+	/**
+	 * @brief Renders every probe again before the others, e.g. after the lights changed
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Renders the probes again in turn when none is outdated, so that they reflect the objects moving
+	 *        through the scene. Enabled by default, probes of a static scene are only rendered when outdated.
+	 */
+	void set_continuous_updates(bool enabled);
+
+	/**
+	 * @brief Sets how many probes an update renders, the cost of a probe being its faces and prefiltering
+	 */
+	void set_probes_per_frame(uint32_t count);
+
+	void set_clip_planes(float near_plane, float far_plane);
+
+	/**
+	 * @brief Renders the outdated probes, or the next ones with continuous updates, then prefilters them
+	 *        Must be recorded outside of a render pass, before the passes sampling the probes.
+	 */
+	void update(CommandBuffer &command_buffer);
+
+	/**
+	 * @return Whether the probe was rendered at least once, its cube map is undefined before
+	 */
+	bool is_ready(uint32_t probe) const;
+
+	/**
+	 * @return The cube view of the prefiltered levels of a probe, level i filtered for a roughness of i / (levels - 1)
+	 */
+	const core::ImageView &get_environment(uint32_t probe) const;
+
+	/**
+	 * @brief Binds the cube map of a probe with a trilinear sampler
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t probe, uint32_t set, uint32_t binding) const;
+
+	uint32_t get_level_count() const;
+
+	/**
+	 * @return The number of probes rendered by the last update
+	 */
+	uint32_t get_rendered_probe_count() const;
+
+	static constexpr uint32_t DEFAULT_FACE_SIZE = 128;
+
+	static constexpr uint32_t FACE_COUNT = 6;
+
+	/// Width of the smallest prefiltered level
+	static constexpr uint32_t MIN_LEVEL_SIZE = 4;
+
+	static constexpr VkFormat FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+  private:
+	struct Probe
+	{
+		glm::vec3 position;
+
+		std::unique_ptr<core::Image> image;
+
+		/// Cube view of all the levels
+		const core::ImageView *view{nullptr};
+
+		/// Cube view of each level, sampled to filter the next one
+		std::vector<const core::ImageView *> level_views;
+
+		/// Array view of the faces of each level, written by the filter
+		std::vector<const core::ImageView *> storage_views;
+
+		bool outdated{true};
+
+		bool ready{false};
+	};
+
+	std::unique_ptr<RenderTarget> create_capture_target(uint32_t layer_count);
+
+	/**
+	 * @brief Draws the faces of the probe into the capture targets, then copies them to the first level
+	 */
+	void render_probe(CommandBuffer &command_buffer, Probe &probe);
+
+	/**
+	 * @brief Filters the other levels of the probe, each from the previous one
+	 */
+	void prefilter(CommandBuffer &command_buffer, Probe &probe);
+
+	RenderContext &render_context;
+
+	sg::Scene &scene;
+
+	uint32_t face_size;
+
+	uint32_t level_count;
+
+	/// Node and camera of each face, looking along the axis of the face from the probe being rendered
+	std::vector<std::unique_ptr<sg::Node>> face_nodes;
+
+	std::vector<std::unique_ptr<sg::PerspectiveCamera>> face_cameras;
+
+	/// A layered target drawn by a multiview pass, or a target per face
+	std::vector<std::unique_ptr<RenderTarget>> capture_targets;
+
+	std::vector<std::unique_ptr<RenderPipeline>> capture_pipelines;
+
+	ShaderSource prefilter_shader;
+
+	const core::Sampler *sampler{nullptr};
+
+	std::vector<Probe> probes;
+
+	uint32_t probes_per_frame{1};
+
+	bool continuous_updates{true};
+
+	/// Next probe rendered by the continuous updates
+	uint32_t next_probe{0};
+
+	uint32_t rendered_probe_count{0};
+};
+}        // namespace vkb
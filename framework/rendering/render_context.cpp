@@ -17,8 +17,27 @@
 
 #include "render_context.h"
 
+#include <thread>
+
+#include "stats/cpu_profiler.h"
+
 namespace vkb
 {
+namespace
+{
+/// Bounds the wait for a display, in nanoseconds, so that a surface which stopped displaying does not block
+constexpr uint64_t PRESENT_WAIT_TIMEOUT = 100000000;
+
+/// Weight of the last measurement in the smoothed display interval and frame work time
+constexpr double PACING_SMOOTHING = 0.1;
+
+/// Whether the images of a swapchain in the transform have the width and height of the display swapped
+bool is_rotated_by_quarter_turn(VkSurfaceTransformFlagBitsKHR transform)
+{
+	return transform == VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR || transform == VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR;
+}
+}        // namespace
+
 VkFormat RenderContext::DEFAULT_VK_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
 
 RenderContext::RenderContext(Device &device, VkSurfaceKHR surface, uint32_t window_width, uint32_t window_height) :
@@ -30,6 +49,8 @@ RenderContext::RenderContext(Device &device, VkSurfaceKHR surface, uint32_t wind
 	{
 		swapchain = std::make_unique<Swapchain>(device, surface);
 	}
+
+	latency_timer.start();
 }
 
 void RenderContext::request_present_mode(const VkPresentModeKHR present_mode)
@@ -50,18 +71,51 @@ void RenderContext::request_image_format(const VkFormat format)
 	}
 }
 
+void RenderContext::set_offscreen_frame_count(uint32_t count)
+{
+	assert(!prepared && "The offscreen frames are created by prepare");
+	assert(count > 0 && "A render context needs a frame");
+
+	offscreen_frame_count = count;
+}
+
 void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create_render_target_func)
 {
-	device.wait_idle();
+	// The frames of a previous prepare are replaced
+	wait_frames();
 
 	if (swapchain)
 	{
 		swapchain->set_present_mode_priority(present_mode_priority_list);
 		swapchain->set_surface_format_priority(surface_format_priority_list);
+
+		if (pre_rotation)
+		{
+			VkSurfaceCapabilitiesKHR surface_properties;
+			VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.get_gpu().get_handle(), swapchain->get_surface(), &surface_properties));
+
+			// The images keep the native orientation of the display, the frames are rendered rotated
+			auto &properties         = swapchain->get_properties();
+			properties.pre_transform = surface_properties.currentTransform;
+
+			if (is_rotated_by_quarter_turn(properties.pre_transform))
+			{
+				std::swap(properties.extent.width, properties.extent.height);
+			}
+		}
+
 		swapchain->create();
 
+		active_present_mode = swapchain->get_present_mode();
+		pre_transform       = swapchain->get_transform();
+
 		surface_extent = swapchain->get_extent();
 
+		if (is_rotated_by_quarter_turn(pre_transform))
+		{
+			std::swap(surface_extent.width, surface_extent.height);
+		}
+
 		VkExtent3D extent{surface_extent.width, surface_extent.height, 1};
 
 		for (auto &image_handle : swapchain->get_images())
@@ -77,22 +131,33 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 	}
 	else
 	{
-		// Otherwise, create a single RenderFrame
+		// Otherwise, create the offscreen RenderFrames
 		swapchain = nullptr;
 
-		auto color_image = core::Image{device,
-		                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
-		                               DEFAULT_VK_FORMAT,        // We can use any format here that we like
-		                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-		                               VMA_MEMORY_USAGE_GPU_ONLY};
+		for (uint32_t i = 0; i < offscreen_frame_count; ++i)
+		{
+			auto color_image = core::Image{device,
+			                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
+			                               DEFAULT_VK_FORMAT,        // We can use any format here that we like
+			                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			                               VMA_MEMORY_USAGE_GPU_ONLY};
 
-		auto render_target = create_render_target_func(std::move(color_image));
-		frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+			auto render_target = create_render_target_func(std::move(color_image));
+			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+		}
 	}
 
 	this->create_render_target_func = create_render_target_func;
 	this->thread_count              = thread_count;
 	this->prepared                  = true;
+
+	frame_submission_numbers.assign(frames.size(), 0);
+	frame_completed_numbers.assign(frames.size(), 0);
+	frame_deletion_numbers.assign(frames.size(), 0);
+
+	update_frame_buffer_rings();
+
+	report_lazily_allocated_memory();
 }
 
 void RenderContext::set_present_mode_priority(const std::vector<VkPresentModeKHR> &new_present_mode_priority_list)
@@ -125,11 +190,7 @@ void RenderContext::update_swapchain(const VkExtent2D &extent)
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, extent);
-
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, extent));
 }
 
 void RenderContext::update_swapchain(const uint32_t image_count)
@@ -140,13 +201,7 @@ void RenderContext::update_swapchain(const uint32_t image_count)
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	device.wait_idle();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, image_count);
-
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, image_count));
 }
 
 void RenderContext::update_swapchain(const std::set<VkImageUsageFlagBits> &image_usage_flags)
@@ -157,11 +212,7 @@ void RenderContext::update_swapchain(const std::set<VkImageUsageFlagBits> &image
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, image_usage_flags);
-
-	recreate();
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, image_usage_flags));
 }
 
 void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTransformFlagBitsKHR transform)
@@ -172,22 +223,100 @@ void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTr
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
 	auto width  = extent.width;
 	auto height = extent.height;
-	if (transform == VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR || transform == VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
+	if (is_rotated_by_quarter_turn(transform))
 	{
 		// Pre-rotation: always use native orientation i.e. if rotated, use width and height of identity transform
 		std::swap(width, height);
 	}
 
-	swapchain = std::make_unique<Swapchain>(*swapchain, VkExtent2D{width, height}, transform);
-
 	// Save the preTransform attribute for future rotations
 	pre_transform = transform;
 
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, VkExtent2D{width, height}, transform));
+}
+
+void RenderContext::replace_swapchain(std::unique_ptr<Swapchain> &&new_swapchain)
+{
+	// The new swapchain was created with the old one as oldSwapchain, which is destroyed,
+	// with the framebuffers of its images, once the frames submitted so far have completed
+	RetiredSwapchain retired;
+	retired.swapchain          = std::move(swapchain);
+	retired.framebuffers       = device.get_resource_cache().release_framebuffers();
+	retired.submission_numbers = frame_submission_numbers;
+
+	retired_swapchains.push_back(std::move(retired));
+
+	swapchain = std::move(new_swapchain);
+
+	// The new swapchain is created with its predecessor's mode, presentations keep the switched one if they can
+	if (!swapchain->is_present_mode_compatible(active_present_mode))
+	{
+		active_present_mode = swapchain->get_present_mode();
+	}
+
 	recreate();
+
+	release_retired_swapchains();
+}
+
+void RenderContext::release_retired_swapchains()
+{
+	auto is_drained = [this](size_t frame_index) {
+		// A frame acquired again is reset, and completed, as usual
+		if (swapchain && frame_index < swapchain->get_images().size())
+		{
+			return true;
+		}
+
+		if (!frames.at(frame_index)->is_complete())
+		{
+			return false;
+		}
+
+		complete_frame(frame_index);
+		return true;
+	};
+
+	draining_frames.erase(std::remove_if(draining_frames.begin(), draining_frames.end(), is_drained), draining_frames.end());
+
+	auto is_complete = [this](const RetiredSwapchain &retired) {
+		for (size_t i = 0; i < retired.submission_numbers.size(); ++i)
+		{
+			if (frame_completed_numbers.at(i) < retired.submission_numbers[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	retired_swapchains.erase(std::remove_if(retired_swapchains.begin(), retired_swapchains.end(), is_complete), retired_swapchains.end());
+}
+
+void RenderContext::wait_frames()
+{
+	for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index)
+	{
+		frames[frame_index]->wait();
+
+		complete_frame(frame_index);
+	}
+
+	release_retired_swapchains();
+}
+
+void RenderContext::complete_frame(size_t frame_index)
+{
+	frame_completed_numbers.at(frame_index) = frame_submission_numbers.at(frame_index);
+
+	if (frame_deletion_numbers.at(frame_index) != 0)
+	{
+		device.get_deletion_queue().complete(frame_deletion_numbers.at(frame_index));
+		frame_deletion_numbers.at(frame_index) = 0;
+	}
 }
 
 void RenderContext::recreate()
@@ -220,6 +349,28 @@ void RenderContext::recreate()
 
 		++frame_it;
 	}
+
+	frame_submission_numbers.resize(frames.size(), 0);
+	frame_completed_numbers.resize(frames.size(), 0);
+	frame_deletion_numbers.resize(frames.size(), 0);
+
+	// Frames past the new image count are not acquired anymore, so they are not reset either,
+	// their completion is polled instead of waited for
+	for (auto frame_index = swapchain->get_images().size(); frame_index < frames.size(); ++frame_index)
+	{
+		if (std::find(draining_frames.begin(), draining_frames.end(), frame_index) == draining_frames.end())
+		{
+			draining_frames.push_back(frame_index);
+		}
+	}
+
+	// The presentations of the new swapchain start over
+	pending_presents.clear();
+	last_display_time = 0.0;
+
+	update_frame_buffer_rings();
+
+	report_lazily_allocated_memory();
 }
 
 void RenderContext::handle_surface_changes()
@@ -230,28 +381,142 @@ void RenderContext::handle_surface_changes()
 		return;
 	}
 
+	// Only recreate the swapchain if the dimensions have changed;
+	// handle_surface_changes() is called on VK_SUBOPTIMAL_KHR,
+	// which might not be due to a surface resize
+	VkExtent2D                    current_extent{};
+	VkSurfaceTransformFlagBitsKHR current_transform{};
+	if (has_surface_changed(current_extent, current_transform))
+	{
+		// Frames in flight keep rendering to the old swapchain, which is retired instead of waiting for the device
+		update_swapchain(current_extent, current_transform);
+
+		surface_extent = current_extent;
+	}
+}
+
+bool RenderContext::has_surface_changed(VkExtent2D &current_extent, VkSurfaceTransformFlagBitsKHR &current_transform) const
+{
 	VkSurfaceCapabilitiesKHR surface_properties;
 	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.get_gpu().get_handle(),
 	                                                   swapchain->get_surface(),
 	                                                   &surface_properties));
 
-	// Only recreate the swapchain if the dimensions have changed;
-	// handle_surface_changes() is called on VK_SUBOPTIMAL_KHR,
-	// which might not be due to a surface resize
-	if (surface_properties.currentExtent.width != surface_extent.width ||
-	    surface_properties.currentExtent.height != surface_extent.height)
+	current_extent = surface_properties.currentExtent;
+
+	// A half turn keeps the extent, only the transform of the surface changes
+	current_transform = pre_rotation ? surface_properties.currentTransform : pre_transform;
+
+	return current_extent.width != surface_extent.width || current_extent.height != surface_extent.height || current_transform != pre_transform;
+}
+
+void RenderContext::set_pre_rotation(bool enabled)
+{
+	if (enabled == pre_rotation)
+	{
+		return;
+	}
+
+	pre_rotation = enabled;
+
+	if (!prepared || !swapchain)
+	{
+		return;
+	}
+
+	if (pre_rotation)
+	{
+		handle_surface_changes();
+	}
+	else if (pre_transform != VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+	{
+		// The presentation engine rotates the images again
+		update_swapchain(surface_extent, VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR);
+	}
+}
+
+bool RenderContext::is_using_pre_rotation() const
+{
+	return pre_rotation;
+}
+
+void RenderContext::set_alternate_frame_rendering(bool enabled)
+{
+	alternate_frame_rendering = enabled;
+}
+
+bool RenderContext::is_using_alternate_frame_rendering() const
+{
+	return alternate_frame_rendering;
+}
+
+uint32_t RenderContext::get_frame_device_mask() const
+{
+	return frame_device_mask;
+}
+
+glm::mat4 RenderContext::get_pre_rotation() const
+{
+	glm::mat4 rotation{1.0f};
+
+	if (!swapchain)
+	{
+		return rotation;
+	}
+
+	glm::vec3 rotation_axis{0.0f, 0.0f, 1.0f};
+
+	auto transform = swapchain->get_transform();
+
+	if (transform & VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR)
+	{
+		rotation = glm::rotate(rotation, glm::radians(90.0f), rotation_axis);
+	}
+	else if (transform & VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
+	{
+		rotation = glm::rotate(rotation, glm::radians(270.0f), rotation_axis);
+	}
+	else if (transform & VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR)
+	{
+		rotation = glm::rotate(rotation, glm::radians(180.0f), rotation_axis);
+	}
+
+	return rotation;
+}
+
+void RenderContext::set_present_mode(VkPresentModeKHR present_mode)
+{
+	if (!swapchain)
 	{
-		// Recreate swapchain
-		device.wait_idle();
+		LOGW("Can't set the present mode in headless mode, skipping.");
+		return;
+	}
 
-		update_swapchain(surface_properties.currentExtent, pre_transform);
+	if (present_mode == active_present_mode)
+	{
+		return;
+	}
 
-		surface_extent = surface_properties.currentExtent;
+	if (swapchain->is_present_mode_compatible(present_mode))
+	{
+		// Applied by the next presentation
+		active_present_mode = present_mode;
+		return;
 	}
+
+	// Without VK_EXT_swapchain_maintenance1 the present mode is fixed at creation
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, present_mode));
+}
+
+VkPresentModeKHR RenderContext::get_present_mode() const
+{
+	return active_present_mode;
 }
 
 CommandBuffer &RenderContext::begin(CommandBuffer::ResetMode reset_mode)
 {
+	VKB_PROFILE_ZONE("RenderContext::begin");
+
 	assert(prepared && "RenderContext not prepared for rendering, call prepare()");
 
 	acquired_semaphore = begin_frame();
@@ -267,123 +532,676 @@ CommandBuffer &RenderContext::begin(CommandBuffer::ResetMode reset_mode)
 
 void RenderContext::submit(CommandBuffer &command_buffer)
 {
+	single_batch.clear();
+	single_batch.add_command_buffer(command_buffer);
+
+	submit(single_batch);
+}
+
+void RenderContext::submit(SubmitBatch &batch)
+{
+	VKB_PROFILE_ZONE("RenderContext::submit");
+
 	assert(frame_active && "RenderContext is inactive, cannot submit command buffer. Please call begin()");
 
+	frame_timings.cpu_record = frame_timer.tick();
+
 	VkSemaphore render_semaphore = VK_NULL_HANDLE;
 
 	if (swapchain)
 	{
-		render_semaphore = submit(queue, command_buffer, acquired_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		render_semaphore = get_active_frame().request_semaphore();
+
+		batch.add_wait_semaphore(acquired_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		batch.add_signal_semaphore(render_semaphore);
 	}
-	else
+
+	// The compute work is queued first, the batch waits on it
+	if (async_compute)
+	{
+		async_compute->submit(batch);
+	}
+
+	submit(queue, batch);
+
+	frame_submission_numbers.at(active_frame_index) = ++submission_count;
+
+	// Later submissions of the frame complete with its first one, the objects retired since then wait for the next number
+	if (frame_deletion_numbers.at(active_frame_index) == 0)
+	{
+		frame_deletion_numbers.at(active_frame_index) = device.get_deletion_queue().submit();
+	}
+
+	if (latency_mode.max_frames_in_flight > 0)
 	{
-		submit(queue, command_buffer);
+		frames_in_flight.push_back({active_frame_index, submission_count});
 	}
 
+	frame_timings.submit = frame_timer.tick();
+
 	end_frame(render_semaphore);
 
 	acquired_semaphore = VK_NULL_HANDLE;
 }
 
-VkSemaphore RenderContext::begin_frame()
+void RenderContext::set_latency_mode(const LatencyMode &mode)
 {
-	// Only handle surface changes if a swapchain exists
-	if (swapchain)
+	latency_mode = mode;
+
+	if (latency_mode.max_frames_in_flight == 0)
 	{
-		handle_surface_changes();
+		frames_in_flight.clear();
 	}
 
-	assert(!frame_active && "Frame is still active, please call end_frame");
-
-	auto &prev_frame = *frames.at(active_frame_index);
-
-	auto aquired_semaphore = prev_frame.request_semaphore();
+#ifdef VK_KHR_present_wait
+	bool has_present_wait = device.is_enabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+#else
+	bool has_present_wait = false;
+#endif
 
-	if (swapchain)
+	if (latency_mode.wait_for_present && !has_present_wait)
 	{
-		auto fence = prev_frame.request_fence();
-
-		auto result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence);
+		LOGW("VK_KHR_present_wait is not enabled, frames will not wait for presentation");
+	}
 
-		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
-		{
-			handle_surface_changes();
+	if (latency_mode.measure_latency && !has_present_wait)
+	{
+		LOGW("VK_KHR_present_wait is not enabled, the latency will not be measured");
+	}
 
-			result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence);
-		}
+#ifdef VK_EXT_display_control
+	bool has_display_control = display != VK_NULL_HANDLE && device.is_enabled(VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME);
+#else
+	bool has_display_control = false;
+#endif
 
-		if (result != VK_SUCCESS)
-		{
-			prev_frame.reset();
+#ifdef VK_GOOGLE_display_timing
+	bool has_display_timing = device.is_enabled(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+#else
+	bool has_display_timing = false;
+#endif
 
-			return VK_NULL_HANDLE;
-		}
+	if (latency_mode.lock_to_vblank && !has_display_control && !has_display_timing)
+	{
+		LOGW("Neither display control nor display timing is available, frames will not lock to the refresh cycles");
 	}
 
-	// Now the frame is active again
-	frame_active = true;
-
-	wait_frame();
+	pending_presents.clear();
+	pacing_delay = 0.0;
+}
 
-	return aquired_semaphore;
+const RenderContext::LatencyMode &RenderContext::get_latency_mode() const
+{
+	return latency_mode;
 }
 
-VkSemaphore RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
+void RenderContext::pace_frame()
 {
-	RenderFrame &frame = get_active_frame();
+	VKB_PROFILE_ZONE("RenderContext::pace_frame");
 
-	VkSemaphore signal_semaphore = frame.request_semaphore();
+	assert(!frame_active && "Frame is still active, please call end_frame");
 
-	VkCommandBuffer cmd_buf = command_buffer.get_handle();
+	wait_frames_in_flight();
 
-	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	wait_present();
 
-	submit_info.commandBufferCount   = 1;
-	submit_info.pCommandBuffers      = &cmd_buf;
-	submit_info.waitSemaphoreCount   = 1;
-	submit_info.pWaitSemaphores      = &wait_semaphore;
-	submit_info.pWaitDstStageMask    = &wait_pipeline_stage;
-	submit_info.signalSemaphoreCount = 1;
-	submit_info.pSignalSemaphores    = &signal_semaphore;
+	wait_vblank();
 
-	VkFence fence = frame.request_fence();
+	frame_timings.pacing = frame_timer.tick();
 
-	queue.submit({submit_info}, fence);
+	start_frame_latency();
+	frame_paced = true;
+}
 
-	return signal_semaphore;
+void RenderContext::record_input()
+{
+	if (pending_input_time < 0.0)
+	{
+		pending_input_time = latency_timer.elapsed();
+	}
 }
 
-void RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer)
+void RenderContext::start_frame_latency()
 {
-	RenderFrame &frame = get_active_frame();
+	poll_presents();
 
-	VkCommandBuffer cmd_buf = command_buffer.get_handle();
+	frame_start_time   = latency_timer.elapsed();
+	frame_input_time   = pending_input_time;
+	pending_input_time = -1.0;
+}
 
-	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+void RenderContext::set_display(VkDisplayKHR display_)
+{
+	display = display_;
+}
 
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers    = &cmd_buf;
+bool RenderContext::is_measuring_vblanks() const
+{
+	if (!swapchain)
+	{
+		return false;
+	}
 
-	VkFence fence = frame.request_fence();
+#ifdef VK_GOOGLE_display_timing
+	if (device.is_enabled(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME))
+	{
+		return true;
+	}
+#endif
 
-	queue.submit({submit_info}, fence);
+	return swapchain->has_vblank_counter();
 }
 
-void RenderContext::wait_frame()
+void RenderContext::wait_vblank()
 {
-	RenderFrame &frame = get_active_frame();
-	frame.reset();
-}
+#ifdef VK_EXT_display_control
+	if (!latency_mode.lock_to_vblank || display == VK_NULL_HANDLE || !device.is_enabled(VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME))
+	{
+		return;
+	}
 
-void RenderContext::end_frame(VkSemaphore semaphore)
-{
-	assert(frame_active && "Frame is not active, please call begin_frame");
+	VkDisplayEventInfoEXT event_info{VK_STRUCTURE_TYPE_DISPLAY_EVENT_INFO_EXT};
+	event_info.displayEvent = VK_DISPLAY_EVENT_TYPE_FIRST_PIXEL_OUT_EXT;
 
-	if (swapchain)
+	VkFence fence{VK_NULL_HANDLE};
+
+	if (vkRegisterDisplayEventEXT(device.get_handle(), display, &event_info, nullptr, &fence) != VK_SUCCESS)
 	{
-		VkSwapchainKHR vk_swapchain = swapchain->get_handle();
+		return;
+	}
 
-		VkPresentInfoKHR present_info{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+	// The fence is signaled as the next refresh cycle starts scanning out, a timeout only skips the wait
+	vkWaitForFences(device.get_handle(), 1, &fence, VK_TRUE, PRESENT_WAIT_TIMEOUT);
+
+	vkDestroyFence(device.get_handle(), fence, nullptr);
+#endif
+}
+
+void RenderContext::update_vblank_timings()
+{
+	frame_timings.missed_vblanks = 0;
+
+	if (swapchain->get_handle() != timed_swapchain)
+	{
+		timed_swapchain          = swapchain->get_handle();
+		last_vblank_count        = 0;
+		refresh_duration         = 0;
+		scheduled_present_time   = 0;
+		last_actual_present_time = 0;
+	}
+
+	uint64_t vblank_count{0};
+
+	bool has_vblank_counter = swapchain->has_vblank_counter() && swapchain->get_vblank_counter(vblank_count) == VK_SUCCESS;
+
+	if (has_vblank_counter)
+	{
+		// A new frame at every refresh cycle, the other cycles showed the previous frame again
+		if (last_vblank_count > 0 && vblank_count > last_vblank_count + 1)
+		{
+			frame_timings.missed_vblanks = to_u32(vblank_count - last_vblank_count - 1);
+		}
+
+		last_vblank_count = vblank_count;
+	}
+
+#ifdef VK_GOOGLE_display_timing
+	if (!device.is_enabled(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	if (refresh_duration == 0 && swapchain->get_refresh_duration(refresh_duration) != VK_SUCCESS)
+	{
+		refresh_duration = 0;
+	}
+
+	if (refresh_duration == 0 || swapchain->get_past_presentation_timings(past_presentation_timings) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	for (const auto &timing : past_presentation_timings)
+	{
+		if (!has_vblank_counter && last_actual_present_time > 0 && timing.presentID > last_timed_present_id &&
+		    timing.actualPresentTime > last_actual_present_time)
+		{
+			uint64_t cycles      = (timing.actualPresentTime - last_actual_present_time + refresh_duration / 2) / refresh_duration;
+			uint64_t frame_count = timing.presentID - last_timed_present_id;
+
+			if (cycles > frame_count)
+			{
+				frame_timings.missed_vblanks += to_u32(cycles - frame_count);
+			}
+		}
+
+		// Starts the schedule from the displays, or restarts it once a presentation landed after its refresh cycle
+		if (scheduled_present_time == 0 || timing.actualPresentTime > timing.desiredPresentTime + refresh_duration)
+		{
+			scheduled_present_time = timing.actualPresentTime + (timed_present_id - timing.presentID) * refresh_duration;
+		}
+
+		last_actual_present_time = timing.actualPresentTime;
+		last_timed_present_id    = timing.presentID;
+	}
+#endif
+}
+
+void RenderContext::wait_frames_in_flight()
+{
+	if (latency_mode.max_frames_in_flight == 0)
+	{
+		return;
+	}
+
+	while (frames_in_flight.size() >= latency_mode.max_frames_in_flight)
+	{
+		const auto &submission = frames_in_flight.front();
+
+		// A frame reset since then has completed the submission
+		if (frame_completed_numbers.at(submission.frame_index) < submission.number)
+		{
+			frames.at(submission.frame_index)->wait();
+		}
+
+		frames_in_flight.pop_front();
+	}
+}
+
+void RenderContext::wait_present()
+{
+#ifdef VK_KHR_present_wait
+	if (!latency_mode.wait_for_present || !swapchain || !device.is_enabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	// As many frames as may be in flight are queued ahead of the display
+	uint64_t frames_ahead = std::max(latency_mode.max_frames_in_flight, 1u);
+
+	if (pending_presents.empty() || present_id < frames_ahead)
+	{
+		return;
+	}
+
+	uint64_t wait_id = present_id + 1 - frames_ahead;
+
+	if (pending_presents.front().id > wait_id)
+	{
+		return;
+	}
+
+	// Timeouts and out of date swapchains only skip the wait, begin_frame() handles surface changes
+	if (vkWaitForPresentKHR(device.get_handle(), swapchain->get_handle(), wait_id, PRESENT_WAIT_TIMEOUT) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	double display_time = latency_timer.elapsed();
+	bool   measured     = false;
+
+	while (!pending_presents.empty() && pending_presents.front().id <= wait_id)
+	{
+		if (pending_presents.front().id == wait_id)
+		{
+			frame_timings.latency = display_time - pending_presents.front().start_time;
+			measured              = true;
+		}
+
+		if (pending_presents.front().input_time >= 0.0)
+		{
+			frame_timings.input_latency = display_time - pending_presents.front().input_time;
+		}
+
+		pending_presents.pop_front();
+	}
+
+	if (measured && last_display_time > 0.0)
+	{
+		double interval = display_time - last_display_time;
+
+		if (display_interval == 0.0)
+		{
+			display_interval = interval;
+		}
+		else if (interval > display_interval * 1.5)
+		{
+			// A display was missed, the frames start too late
+			pacing_delay *= 0.5;
+		}
+		else
+		{
+			display_interval += PACING_SMOOTHING * (interval - display_interval);
+		}
+	}
+
+	last_display_time = measured ? display_time : 0.0;
+
+	if (!latency_mode.pace_frame_start || display_interval == 0.0)
+	{
+		return;
+	}
+
+	// The frame should be submitted by three quarters of the interval, leaving the rest to the GPU
+	double target_delay = std::max(0.0, display_interval * 0.75 - frame_work_time);
+
+	pacing_delay += PACING_SMOOTHING * (target_delay - pacing_delay);
+
+	if (pacing_delay > 0.0)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double>(pacing_delay));
+	}
+#endif
+}
+
+void RenderContext::poll_presents()
+{
+#ifdef VK_KHR_present_wait
+	// Waiting for presentation measures the latency already
+	if (!latency_mode.measure_latency || latency_mode.wait_for_present || !swapchain || !device.is_enabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	double poll_time = latency_timer.elapsed();
+
+	// A wait for a presentation succeeds once it or a later one is displayed, so the first one not displayed ends the poll
+	while (!pending_presents.empty() &&
+	       vkWaitForPresentKHR(device.get_handle(), swapchain->get_handle(), pending_presents.front().id, 0) == VK_SUCCESS)
+	{
+		frame_timings.latency = poll_time - pending_presents.front().start_time;
+
+		if (pending_presents.front().input_time >= 0.0)
+		{
+			frame_timings.input_latency = poll_time - pending_presents.front().input_time;
+		}
+
+		pending_presents.pop_front();
+	}
+#endif
+}
+
+VkSemaphore RenderContext::begin_frame()
+{
+	if (!frame_paced)
+	{
+		wait_frames_in_flight();
+
+		wait_vblank();
+
+		frame_timings.pacing = 0.0;
+
+		start_frame_latency();
+	}
+
+	frame_paced = false;
+
+	frame_timings.cpu_update = frame_timer.tick();
+
+	// Only handle surface changes if a swapchain exists
+	if (swapchain)
+	{
+		handle_surface_changes();
+	}
+
+	assert(!frame_active && "Frame is still active, please call end_frame");
+
+	auto &prev_frame = *frames.at(active_frame_index);
+
+	auto aquired_semaphore = prev_frame.request_semaphore();
+
+	if (swapchain)
+	{
+		// With a timeline the submission waiting on the acquired semaphore already tracks the acquisition
+		VkFence fence = prev_frame.get_timeline_semaphore() ? VK_NULL_HANDLE : prev_frame.request_fence();
+
+		// The frames are rendered by the GPUs in turn, the image is acquired for the one rendering it
+		frame_device_mask = 0;
+
+		if (alternate_frame_rendering && swapchain->get_device_group_present_mode() != 0)
+		{
+			frame_device_mask = 1u << next_frame_device;
+			next_frame_device = (next_frame_device + 1) % device.get_physical_device_count();
+		}
+
+		auto result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence, frame_device_mask);
+
+		// A suboptimal image is rendered and the surface change handled after presenting it,
+		// unless it can be given back to recreate the swapchain at once
+		VkExtent2D                    current_extent{};
+		VkSurfaceTransformFlagBitsKHR current_transform{};
+
+		if (result == VK_SUBOPTIMAL_KHR && swapchain->can_release_images() && has_surface_changed(current_extent, current_transform))
+		{
+			// Give the image back instead of rendering a frame at the previous size or orientation
+			VK_CHECK(swapchain->release_images({active_frame_index}));
+
+			// The acquisition still signals its semaphore, a submission waits on it before the frame reuses it
+			VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+			submit_info.waitSemaphoreCount = 1;
+			submit_info.pWaitSemaphores    = &aquired_semaphore;
+			submit_info.pWaitDstStageMask  = &wait_stage;
+
+			queue.submit({submit_info}, prev_frame.request_fence());
+
+			handle_surface_changes();
+
+			aquired_semaphore = prev_frame.request_semaphore();
+			fence             = prev_frame.get_timeline_semaphore() ? VK_NULL_HANDLE : prev_frame.request_fence();
+
+			result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence, frame_device_mask);
+		}
+		else if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			handle_surface_changes();
+
+			result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence, frame_device_mask);
+		}
+
+		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			prev_frame.reset();
+
+			return VK_NULL_HANDLE;
+		}
+	}
+	else
+	{
+		// Without a swapchain the offscreen frames are rendered in turn
+		active_frame_index = (active_frame_index + 1) % to_u32(frames.size());
+	}
+
+	// Now the frame is active again
+	frame_active = true;
+
+	wait_frame();
+
+	// The reset frame has completed its submissions
+	complete_frame(active_frame_index);
+
+	release_retired_swapchains();
+
+	for (auto &buffer_ring : buffer_rings)
+	{
+		buffer_ring.second->begin_frame(active_frame_index);
+	}
+
+	// Resources not used by the frames in flight can be evicted now
+	device.get_resource_cache().begin_frame(to_u32(frames.size()));
+
+	frame_timings.acquire_wait = frame_timer.tick();
+
+	return aquired_semaphore;
+}
+
+VkSemaphore RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
+{
+	VkSemaphore signal_semaphore = get_active_frame().request_semaphore();
+
+	single_batch.clear();
+	single_batch.add_command_buffer(command_buffer);
+	single_batch.add_wait_semaphore(wait_semaphore, wait_pipeline_stage);
+	single_batch.add_signal_semaphore(signal_semaphore);
+
+	submit(queue, single_batch);
+
+	return signal_semaphore;
+}
+
+void RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer)
+{
+	single_batch.clear();
+	single_batch.add_command_buffer(command_buffer);
+
+	submit(queue, single_batch);
+}
+
+void RenderContext::submit(const Queue &queue, const SubmitBatch &batch)
+{
+	RenderFrame &frame = get_active_frame();
+
+	submit_command_buffers.clear();
+
+	// Staged uniforms are copied ahead of the commands reading them, the transfers do not wait on the semaphores
+	if (auto upload_command_buffer = frame.record_staged_uploads(queue))
+	{
+		submit_command_buffers.push_back(upload_command_buffer->get_handle());
+	}
+
+	batch.get_command_buffers(submit_command_buffers);
+
+	auto &wait_semaphores = batch.get_wait_semaphores();
+	auto &wait_stages     = batch.get_wait_stages();
+
+	// Binary semaphores are signaled with a value that is ignored
+	submit_signal_semaphores = batch.get_signal_semaphores();
+	submit_signal_values.assign(submit_signal_semaphores.size(), 0);
+
+	auto timeline_semaphore = frame.get_timeline_semaphore();
+
+	if (timeline_semaphore)
+	{
+		submit_signal_semaphores.push_back(timeline_semaphore->get_handle());
+		submit_signal_values.push_back(timeline_semaphore->request_value());
+	}
+
+	// With a timeline the frame tracks its submissions without a fence
+	VkFence fence = timeline_semaphore ? VK_NULL_HANDLE : frame.request_fence();
+
+#ifdef VK_KHR_synchronization2
+	if (device.is_enabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+	{
+		std::vector<VkCommandBufferSubmitInfoKHR> command_buffer_infos(submit_command_buffers.size(), {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR});
+		for (size_t i = 0; i < submit_command_buffers.size(); ++i)
+		{
+			command_buffer_infos[i].commandBuffer = submit_command_buffers[i];
+			command_buffer_infos[i].deviceMask    = frame_device_mask;
+		}
+
+		std::vector<VkSemaphoreSubmitInfoKHR> wait_infos(wait_semaphores.size(), {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR});
+		for (size_t i = 0; i < wait_semaphores.size(); ++i)
+		{
+			wait_infos[i].semaphore = wait_semaphores[i];
+			wait_infos[i].stageMask = wait_stages[i];
+		}
+
+		// The semaphores are waited on and signaled by the GPU rendering the frame
+		uint32_t device_index = frame_device_mask ? lowest_bit_index(frame_device_mask) : 0;
+		for (auto &wait_info : wait_infos)
+		{
+			wait_info.deviceIndex = device_index;
+		}
+
+		std::vector<VkSemaphoreSubmitInfoKHR> signal_infos(submit_signal_semaphores.size(), {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR});
+		for (size_t i = 0; i < submit_signal_semaphores.size(); ++i)
+		{
+			signal_infos[i].semaphore = submit_signal_semaphores[i];
+			signal_infos[i].value     = submit_signal_values[i];
+			signal_infos[i].stageMask   = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+			signal_infos[i].deviceIndex = device_index;
+		}
+
+		VkSubmitInfo2KHR submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR};
+
+		submit_info.commandBufferInfoCount   = to_u32(command_buffer_infos.size());
+		submit_info.pCommandBufferInfos      = command_buffer_infos.data();
+		submit_info.waitSemaphoreInfoCount   = to_u32(wait_infos.size());
+		submit_info.pWaitSemaphoreInfos      = wait_infos.data();
+		submit_info.signalSemaphoreInfoCount = to_u32(signal_infos.size());
+		submit_info.pSignalSemaphoreInfos    = signal_infos.data();
+
+		queue.submit(submit_info, fence);
+
+		return;
+	}
+#endif
+
+	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+
+	submit_info.commandBufferCount   = to_u32(submit_command_buffers.size());
+	submit_info.pCommandBuffers      = submit_command_buffers.data();
+	submit_info.waitSemaphoreCount   = to_u32(wait_semaphores.size());
+	submit_info.pWaitSemaphores      = wait_semaphores.data();
+	submit_info.pWaitDstStageMask    = wait_stages.data();
+	submit_info.signalSemaphoreCount = to_u32(submit_signal_semaphores.size());
+	submit_info.pSignalSemaphores    = submit_signal_semaphores.data();
+
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+
+	if (timeline_semaphore)
+	{
+		timeline_info.signalSemaphoreValueCount = to_u32(submit_signal_values.size());
+		timeline_info.pSignalSemaphoreValues    = submit_signal_values.data();
+
+		submit_info.pNext = &timeline_info;
+	}
+
+	// Only the GPU rendering the frame executes its commands
+	VkDeviceGroupSubmitInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO_KHR};
+
+	std::vector<uint32_t> device_masks;
+	std::vector<uint32_t> wait_device_indices;
+	std::vector<uint32_t> signal_device_indices;
+
+	if (frame_device_mask != 0)
+	{
+		uint32_t device_index = lowest_bit_index(frame_device_mask);
+
+		device_masks.assign(submit_command_buffers.size(), frame_device_mask);
+		wait_device_indices.assign(wait_semaphores.size(), device_index);
+		signal_device_indices.assign(submit_signal_semaphores.size(), device_index);
+
+		device_group_info.commandBufferCount            = to_u32(device_masks.size());
+		device_group_info.pCommandBufferDeviceMasks     = device_masks.data();
+		device_group_info.waitSemaphoreCount            = to_u32(wait_device_indices.size());
+		device_group_info.pWaitSemaphoreDeviceIndices   = wait_device_indices.data();
+		device_group_info.signalSemaphoreCount          = to_u32(signal_device_indices.size());
+		device_group_info.pSignalSemaphoreDeviceIndices = signal_device_indices.data();
+		device_group_info.pNext                         = submit_info.pNext;
+
+		submit_info.pNext = &device_group_info;
+	}
+
+	queue.submit({submit_info}, fence);
+}
+
+void RenderContext::wait_frame()
+{
+	RenderFrame &frame = get_active_frame();
+	frame.reset();
+}
+
+void RenderContext::end_frame(VkSemaphore semaphore)
+{
+	assert(frame_active && "Frame is not active, please call begin_frame");
+
+	if (swapchain)
+	{
+		VkSwapchainKHR vk_swapchain = swapchain->get_handle();
+
+		VkPresentInfoKHR present_info{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
 
 		present_info.waitSemaphoreCount = 1;
 		present_info.pWaitSemaphores    = &semaphore;
@@ -391,8 +1209,96 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 		present_info.pSwapchains        = &vk_swapchain;
 		present_info.pImageIndices      = &active_frame_index;
 
+#ifdef VK_EXT_swapchain_maintenance1
+		// Switches the present mode without recreating the swapchain
+		VkSwapchainPresentModeInfoEXT present_mode_info{VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_MODE_INFO_EXT};
+
+		if (swapchain->is_present_mode_compatible(active_present_mode))
+		{
+			present_mode_info.swapchainCount = 1;
+			present_mode_info.pPresentModes  = &active_present_mode;
+
+			present_info.pNext = &present_mode_info;
+		}
+#endif
+
+		// The GPU which rendered the frame presents it, itself or through the GPU the surface is connected to
+		VkDeviceGroupPresentInfoKHR device_group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_PRESENT_INFO_KHR};
+
+		if (frame_device_mask != 0)
+		{
+			device_group_info.swapchainCount = 1;
+			device_group_info.pDeviceMasks   = &frame_device_mask;
+			device_group_info.mode           = swapchain->get_device_group_present_mode();
+			device_group_info.pNext          = present_info.pNext;
+
+			present_info.pNext = &device_group_info;
+		}
+
+		update_vblank_timings();
+
+#ifdef VK_GOOGLE_display_timing
+		// Schedules the presentation a refresh cycle after the previous one
+		VkPresentTimeGOOGLE      present_time{};
+		VkPresentTimesInfoGOOGLE present_times_info{VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE};
+
+		if (device.is_enabled(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME))
+		{
+			present_time.presentID = ++timed_present_id;
+
+			if (latency_mode.lock_to_vblank && scheduled_present_time > 0)
+			{
+				scheduled_present_time += refresh_duration;
+
+				// Half a cycle early, so that the presentation lands on the refresh cycle it is scheduled for
+				present_time.desiredPresentTime = scheduled_present_time - refresh_duration / 2;
+			}
+
+			present_times_info.swapchainCount = 1;
+			present_times_info.pTimes         = &present_time;
+			present_times_info.pNext          = present_info.pNext;
+
+			present_info.pNext = &present_times_info;
+		}
+#endif
+
+#ifdef VK_KHR_present_id
+		// Identifies the presentation for vkWaitForPresentKHR
+		VkPresentIdKHR present_id_info{VK_STRUCTURE_TYPE_PRESENT_ID_KHR};
+		uint64_t       next_present_id = present_id + 1;
+
+		bool has_present_id = device.is_enabled(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+
+		if (has_present_id)
+		{
+			present_id_info.swapchainCount = 1;
+			present_id_info.pPresentIds    = &next_present_id;
+			present_id_info.pNext          = present_info.pNext;
+
+			present_info.pNext = &present_id_info;
+		}
+#endif
+
 		VkResult result = queue.present(present_info);
 
+#ifdef VK_KHR_present_id
+		if (has_present_id)
+		{
+			present_id = next_present_id;
+
+			if (latency_mode.wait_for_present || latency_mode.measure_latency)
+			{
+				pending_presents.push_back({present_id, frame_start_time, frame_input_time});
+
+				// Presentations whose waits timed out are not measured
+				while (pending_presents.size() > frames.size())
+				{
+					pending_presents.pop_front();
+				}
+			}
+		}
+#endif
+
 		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			handle_surface_changes();
@@ -401,6 +1307,14 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 
 	// Frame is not active anymore
 	frame_active = false;
+
+	frame_timings.present_wait = frame_timer.tick();
+	last_frame_timings         = frame_timings;
+
+	// The CPU work the frame start is paced by, the waits excluded
+	double work_time = frame_timings.cpu_update + frame_timings.cpu_record + frame_timings.submit;
+
+	frame_work_time = frame_work_time == 0.0 ? work_time : frame_work_time + PACING_SMOOTHING * (work_time - frame_work_time);
 }
 
 RenderFrame &RenderContext::get_active_frame()
@@ -434,7 +1348,8 @@ Device &RenderContext::get_device()
 
 void RenderContext::recreate_swapchain()
 {
-	device.wait_idle();
+	// The framebuffers are only used by the frames
+	wait_frames();
 	device.get_resource_cache().clear_framebuffers();
 
 	VkExtent2D swapchain_extent = swapchain->get_extent();
@@ -482,4 +1397,93 @@ std::vector<std::unique_ptr<RenderFrame>> &RenderContext::get_render_frames()
 	return frames;
 }
 
+void RenderContext::set_buffer_ring_size(VkDeviceSize size)
+{
+	assert(!frame_active && "Buffer rings cannot be changed while a frame is active");
+
+	// The frames in flight may still read from the current rings
+	wait_frames();
+
+	buffer_rings.clear();
+
+	if (size > 0)
+	{
+		// Offset alignments are powers of two no larger than 256 bytes, round up so that allocations wrapping around stay aligned
+		auto aligned_size = (size + 255) & ~static_cast<VkDeviceSize>(255);
+
+		for (auto usage : {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT})
+		{
+			buffer_rings.emplace(usage, std::make_unique<BufferRing>(device, aligned_size, usage));
+		}
+
+#ifdef VK_EXT_descriptor_buffer
+		// The descriptors of all the frames go into one ring too, so that command buffers rarely bind another descriptor buffer
+		if (device.uses_descriptor_buffers())
+		{
+			buffer_rings.emplace(RenderFrame::DESCRIPTOR_BUFFER_USAGE, std::make_unique<BufferRing>(device, aligned_size, RenderFrame::DESCRIPTOR_BUFFER_USAGE));
+		}
+#endif
+	}
+
+	update_frame_buffer_rings();
+}
+
+const std::map<VkBufferUsageFlags, std::unique_ptr<BufferRing>> &RenderContext::get_buffer_rings() const
+{
+	return buffer_rings;
+}
+
+void RenderContext::set_device_local_uniforms(bool enabled)
+{
+	device_local_uniforms = enabled;
+
+	update_frame_buffer_rings();
+}
+
+const RenderContext::FrameTimings &RenderContext::get_last_frame_timings() const
+{
+	return last_frame_timings;
+}
+
+AsyncCompute &RenderContext::get_async_compute()
+{
+	if (!async_compute)
+	{
+		async_compute = std::make_unique<AsyncCompute>(*this);
+	}
+
+	return *async_compute;
+}
+
+void RenderContext::report_lazily_allocated_memory()
+{
+	VkDeviceSize size{0};
+
+	for (auto &frame : frames)
+	{
+		size += frame->get_render_target_const().get_lazily_allocated_size();
+	}
+
+	if (size > 0)
+	{
+		LOGI("Render targets keep {} KB of transient attachments in lazily allocated memory", size / 1024);
+	}
+}
+
+void RenderContext::update_frame_buffer_rings()
+{
+	std::map<VkBufferUsageFlags, BufferRing *> rings;
+
+	for (auto &buffer_ring : buffer_rings)
+	{
+		rings.emplace(buffer_ring.first, buffer_ring.second.get());
+	}
+
+	for (auto &frame : frames)
+	{
+		frame->set_buffer_rings(rings);
+		frame->set_device_local_uniforms(device_local_uniforms);
+	}
+}
+
 }        // namespace vkb
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "common/glm_common.h"
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/command_buffer.h"
@@ -30,10 +31,13 @@
 #include "core/render_pass.h"
 #include "core/shader_module.h"
 #include "core/swapchain.h"
+#include "rendering/async_compute.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_frame.h"
 #include "rendering/render_target.h"
+#include "rendering/submit_batch.h"
 #include "resource_cache.h"
+#include "timer.h"
 
 namespace vkb
 {
@@ -58,6 +62,65 @@ class RenderContext
 	// The format to use for the RenderTargets if a swapchain isn't created
 	static VkFormat DEFAULT_VK_FORMAT;
 
+	/**
+	 * @brief CPU time spent in each part of a frame, in seconds, the parts add up to the frame time
+	 */
+	struct FrameTimings
+	{
+		/// From the end of the previous frame to the end of pace_frame(), waiting as the latency mode asks
+		double pacing{0.0};
+
+		/// From pace_frame() or the end of the previous frame to begin_frame(), e.g. updating the scene
+		double cpu_update{0.0};
+
+		/// Acquiring the swapchain image and waiting for the frame's previous submissions
+		double acquire_wait{0.0};
+
+		/// From begin_frame() to the submission, mostly recording the command buffers
+		double cpu_record{0.0};
+
+		/// Submitting the command buffers to the queue
+		double submit{0.0};
+
+		/// Presenting the swapchain image
+		double present_wait{0.0};
+
+		/// Not a part of the frame: from the start of the last displayed frame to its display,
+		/// measured only while the latency mode waits for presentation or measures the latency, 0 otherwise
+		double latency{0.0};
+
+		/// Not a part of the frame: from the first input event recorded before the start of a displayed frame
+		/// to its display, the last one measured, measured like the latency
+		double input_latency{0.0};
+
+		/// Not a part of the frame: refresh cycles of the display that showed no new frame, since the previous frame
+		/// was measured, only counted if is_measuring_vblanks()
+		uint32_t missed_vblanks{0};
+	};
+
+	/**
+	 * @brief How far the CPU may run ahead of the display
+	 */
+	struct LatencyMode
+	{
+		/// Frames recorded or executing at once, 0 to only be bound by the swapchain images
+		uint32_t max_frames_in_flight{0};
+
+		/// Waits for the display of the frame max_frames_in_flight frames ago, needs VK_KHR_present_wait
+		bool wait_for_present{false};
+
+		/// Delays the start of each frame so that it completes just before its display, needs wait_for_present
+		bool pace_frame_start{false};
+
+		/// Starts each frame at a refresh cycle of the display, needs VK_EXT_display_control and a display set with set_display,
+		/// and schedules each presentation a refresh cycle after the previous one, needs VK_GOOGLE_display_timing
+		bool lock_to_vblank{false};
+
+		/// Measures the latency without waiting for presentation, needs VK_KHR_present_wait
+		/// The display is polled once per frame, so the latency is up to a frame longer than the actual one
+		bool measure_latency{false};
+	};
+
 	/**
 	 * @brief Constructor
 	 * @param device A valid device
@@ -82,11 +145,61 @@ class RenderContext
 	 */
 	void request_present_mode(const VkPresentModeKHR present_mode);
 
+	/**
+	 * @brief Switches the present mode of a prepared swapchain
+	 *        The next presentation applies it if VK_EXT_swapchain_maintenance1 created the swapchain
+	 *        compatible with it, otherwise the swapchain is recreated.
+	 */
+	void set_present_mode(VkPresentModeKHR present_mode);
+
+	/**
+	 * @return The present mode of the presentations
+	 */
+	VkPresentModeKHR get_present_mode() const;
+
 	/**
 	 * @brief Requests to set a specific image format for the swapchain
 	 */
 	void request_image_format(const VkFormat format);
 
+	/**
+	 * @brief Sets the number of images a context without a surface renders into, must be called before prepare
+	 *        The frames are rendered in turn, so the CPU records a frame while the GPU renders the previous ones.
+	 *        Contexts without a surface can render on threads of their own sharing the device,
+	 *        as long as they are prepared before the threads start.
+	 */
+	void set_offscreen_frame_count(uint32_t count);
+
+	/**
+	 * @brief Creates the swapchain in the current transform of the surface, so that the presentation engine
+	 *        displays the images without rotating them in a composition pass. The frames are rendered rotated
+	 *        instead: VulkanSample applies get_pre_rotation() to the cameras, and the GUI rotates its scissors.
+	 *        Enabled by default, a prepared swapchain is recreated in the new transform.
+	 */
+	void set_pre_rotation(bool enabled);
+
+	bool is_using_pre_rotation() const;
+
+	/**
+	 * @return The rotation of the clip space from the orientation of the display to the one of the swapchain images
+	 */
+	glm::mat4 get_pre_rotation() const;
+
+	/**
+	 * @brief Renders each frame on one GPU of a device created over several GPUs, the GPUs in turn
+	 *        Each GPU presents the frames it rendered, or another GPU presents them if the surface
+	 *        is connected to it. Ignored on a device of a single GPU, or if the surface cannot present
+	 *        the images of every GPU.
+	 */
+	void set_alternate_frame_rendering(bool enabled);
+
+	bool is_using_alternate_frame_rendering() const;
+
+	/**
+	 * @return The mask of the GPU rendering the active frame, 0 if every GPU of the device executes its commands
+	 */
+	uint32_t get_frame_device_mask() const;
+
 	/**
 	 * @brief Sets the order in which the swapchain prioritizes selecting its present mode
 	 */
@@ -157,6 +270,46 @@ class RenderContext
 	 */
 	void submit(CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Submits all the command buffers of a frame with a single queue submission, then presents it
+	 *        With a swapchain the batch additionally waits on the acquired image and signals the presentation.
+	 * @param batch The command buffers and semaphores of the frame, semaphores are added to it
+	 */
+	void submit(SubmitBatch &batch);
+
+	/**
+	 * @brief Sets how far the CPU may run ahead of the display, applied from the next frame
+	 *        Fewer frames in flight lower the input to photon latency at the cost of overlapping
+	 *        less CPU and GPU work.
+	 */
+	void set_latency_mode(const LatencyMode &mode);
+
+	const LatencyMode &get_latency_mode() const;
+
+	/**
+	 * @brief Waits as the latency mode asks before a new frame starts
+	 *        Call it before sampling the input and updating the scene, as late as possible
+	 *        input is what keeps the latency low. begin_frame() bounds the frames in flight
+	 *        without waiting for presentation if it was not called.
+	 */
+	void pace_frame();
+
+	/**
+	 * @brief Records the time of an input event, the input latency of the next frame started is measured from it
+	 */
+	void record_input();
+
+	/**
+	 * @brief Sets the display of a direct-to-display surface, whose refresh cycles the latency mode can lock to
+	 */
+	void set_display(VkDisplayKHR display);
+
+	/**
+	 * @return Whether the refresh cycles missed by the frames are counted, with a vblank counter
+	 *         of the swapchain or the presentation timings of VK_GOOGLE_display_timing
+	 */
+	bool is_measuring_vblanks() const;
+
 	/**
 	 * @brief begin_frame
 	 *
@@ -171,6 +324,12 @@ class RenderContext
 	 */
 	void submit(const Queue &queue, const CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Submits a batch related to a frame to a queue, with the frame's staged uploads ahead of it
+	 *        Uses vkQueueSubmit2KHR if VK_KHR_synchronization2 is enabled.
+	 */
+	void submit(const Queue &queue, const SubmitBatch &batch);
+
 	/**
 	 * @brief Waits a frame to finish its rendering
 	 */
@@ -216,11 +375,43 @@ class RenderContext
 
 	std::vector<std::unique_ptr<RenderFrame>> &get_render_frames();
 
+	/**
+	 * @brief Allocates the buffers of all frames from one ring per usage instead of per frame
+	 *        buffer pools, so that peak frames do not permanently grow the pools
+	 * @param size Size of each ring in bytes, zero to only use the buffer pools
+	 */
+	void set_buffer_ring_size(VkDeviceSize size);
+
+	/**
+	 * @return The rings used by the frames, by usage
+	 */
+	const std::map<VkBufferUsageFlags, std::unique_ptr<BufferRing>> &get_buffer_rings() const;
+
+	/**
+	 * @brief Allocates the uniform buffers of all frames from device local memory
+	 *        The uniforms are staged in host visible memory and copied by a command buffer
+	 *        submitted ahead of the frame's command buffer. The mode applies to the
+	 *        allocations made after the call, including in the active frame.
+	 * @param enabled Whether to stage the uniforms in device local buffers
+	 */
+	void set_device_local_uniforms(bool enabled);
+
 	/**
 	 * @brief Handles surface changes, only applicable if the render_context makes use of a swapchain
 	 */
 	virtual void handle_surface_changes();
 
+	/**
+	 * @return The timings of the last frame that ended
+	 */
+	const FrameTimings &get_last_frame_timings() const;
+
+	/**
+	 * @return The scheduler of the compute work overlapping the frames' raster work,
+	 *         submitted by submit(SubmitBatch &) ahead of the frame
+	 */
+	AsyncCompute &get_async_compute();
+
   protected:
 	VkExtent2D surface_extent;
 
@@ -258,11 +449,209 @@ class RenderContext
 	/// Whether a frame is active or not
 	bool frame_active{false};
 
+	/// Ticked at the boundaries of the parts of the frame
+	Timer frame_timer;
+
+	/// Timings of the frame being recorded
+	FrameTimings frame_timings;
+
+	FrameTimings last_frame_timings;
+
+	LatencyMode latency_mode;
+
+	/// A frame submission, in submission order
+	struct FrameSubmission
+	{
+		uint32_t frame_index;
+
+		uint64_t number;
+	};
+
+	std::deque<FrameSubmission> frames_in_flight;
+
+	/// Number of the last submission of each frame
+	std::vector<uint64_t> frame_submission_numbers;
+
+	/// Number of the last submission of each frame known to be complete, when the frame was last reset
+	std::vector<uint64_t> frame_completed_numbers;
+
+	/// Number of the last submission of each frame in the deletion queue of the device
+	std::vector<uint64_t> frame_deletion_numbers;
+
+	uint64_t submission_count{0};
+
+	/// Whether pace_frame() was called for the next frame
+	bool frame_paced{false};
+
+	bool alternate_frame_rendering{false};
+
+	/// The GPU rendering the active frame, 0 for all of them
+	uint32_t frame_device_mask{0};
+
+	/// Index of the GPU rendering the next frame
+	uint32_t next_frame_device{0};
+
+	/// Measures the latency, from the construction of the context
+	Timer latency_timer;
+
+	/// Start of the frame being recorded on the latency timer
+	double frame_start_time{0.0};
+
+	/// Identifier of the last presentation, 0 for none
+	uint64_t present_id{0};
+
+	/// First input event recorded since the start of the frame being recorded, negative for none
+	double pending_input_time{-1.0};
+
+	/// First input event recorded before the start of the frame being recorded, negative for none
+	double frame_input_time{-1.0};
+
+	/// A presentation not known to be displayed yet
+	struct PendingPresent
+	{
+		uint64_t id;
+
+		double start_time;
+
+		double input_time;
+	};
+
+	std::deque<PendingPresent> pending_presents;
+
+	/// Time of the last display on the latency timer
+	double last_display_time{0.0};
+
+	/// Smoothed time between displays, 0 before two were measured
+	double display_interval{0.0};
+
+	/// Smoothed CPU time of the frames, from their start to their submission
+	double frame_work_time{0.0};
+
+	/// Delay of the frame start after the display of the previous frame
+	double pacing_delay{0.0};
+
+	VkDisplayKHR display{VK_NULL_HANDLE};
+
+	/// The swapchain the refresh cycles are measured on, the measures restart with a new one
+	VkSwapchainKHR timed_swapchain{VK_NULL_HANDLE};
+
+	/// Refresh cycles counted by the swapchain at the last presentation, 0 before the first one
+	uint64_t last_vblank_count{0};
+
+	/// Duration of a refresh cycle in nanoseconds, 0 before it is queried
+	uint64_t refresh_duration{0};
+
+	/// Identifier of the last presentation timed with VK_GOOGLE_display_timing
+	uint32_t timed_present_id{0};
+
+	/// Display time the last presentation was scheduled for, 0 before a presentation was timed
+	uint64_t scheduled_present_time{0};
+
+	/// The last presentation whose timing was read back
+	uint32_t last_timed_present_id{0};
+
+	uint64_t last_actual_present_time{0};
+
+#ifdef VK_GOOGLE_display_timing
+	std::vector<VkPastPresentationTimingGOOGLE> past_presentation_timings;
+#endif
+
+	/// A swapchain replaced while the frames in flight may still use its images
+	struct RetiredSwapchain
+	{
+		std::unique_ptr<Swapchain> swapchain;
+
+		std::unordered_map<std::size_t, Framebuffer> framebuffers;
+
+		/// Submission number of each frame when the swapchain was replaced
+		std::vector<uint64_t> submission_numbers;
+	};
+
+	std::vector<RetiredSwapchain> retired_swapchains;
+
+	/// Frames past the image count of the swapchain whose last submissions have not been seen to complete
+	std::vector<size_t> draining_frames;
+
+	/// Present mode of the presentations, which may differ from the one the swapchain was created with
+	VkPresentModeKHR active_present_mode{VK_PRESENT_MODE_FIFO_KHR};
+
+	/**
+	 * @brief Checks the current extent of the surface against the one of the swapchain, and with pre-rotation
+	 *        its current transform against the one of the swapchain
+	 * @param current_extent The current extent of the surface
+	 * @param current_transform The transform the swapchain should be created in
+	 */
+	bool has_surface_changed(VkExtent2D &current_extent, VkSurfaceTransformFlagBitsKHR &current_transform) const;
+
+	/// Retires the current swapchain and recreates the frames' render targets for the new one
+	void replace_swapchain(std::unique_ptr<Swapchain> &&new_swapchain);
+
+	/// Records the completion of the frames no longer acquired, then destroys the retired swapchains whose frames have completed
+	void release_retired_swapchains();
+
+	/**
+	 * @brief Records that the submissions of a frame have completed, after waiting for its fence
+	 */
+	void complete_frame(size_t frame_index);
+
+	/// Waits for the submissions of the frames only, work submitted outside of the render context keeps running
+	void wait_frames();
+
+	/// Waits until at most max_frames_in_flight - 1 frames are executing
+	void wait_frames_in_flight();
+
+	/// Waits for the display of the frame the latency mode waits for, and paces the frame start
+	void wait_present();
+
+	/// Measures the latency of the presentations displayed since the last frame, without waiting
+	void poll_presents();
+
+	/// Starts the frame being recorded on the latency timer
+	void start_frame_latency();
+
+	/// Waits for the next refresh cycle of the display if the latency mode locks to it
+	void wait_vblank();
+
+	/// Counts the refresh cycles missed since the last presentation, and reschedules the presentations behind
+	void update_vblank_timings();
+
+	std::map<VkBufferUsageFlags, std::unique_ptr<BufferRing>> buffer_rings;
+
+	std::unique_ptr<AsyncCompute> async_compute;
+
+	bool device_local_uniforms{false};
+
+	/// Batch reused by the single command buffer submissions
+	SubmitBatch single_batch;
+
+	/// Storage reused by each submission
+	std::vector<VkCommandBuffer> submit_command_buffers;
+
+	std::vector<VkSemaphore> submit_signal_semaphores;
+
+	std::vector<uint64_t> submit_signal_values;
+
+	/**
+	 * @brief Hands the rings and the uniform allocation mode to all the frames,
+	 *        called whenever frames or rings are created
+	 */
+	void update_frame_buffer_rings();
+
+	/**
+	 * @brief Logs the memory the render targets of the frames keep out of device memory
+	 */
+	void report_lazily_allocated_memory();
+
 	RenderTarget::CreateFunc create_render_target_func = RenderTarget::DEFAULT_CREATE_FUNC;
 
 	VkSurfaceTransformFlagBitsKHR pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
 
+	bool pre_rotation{true};
+
 	size_t thread_count{1};
+
+	/// Number of frames created without a swapchain
+	uint32_t offscreen_frame_count{1};
 };
 
 }        // namespace vkb
@@ -22,6 +22,247 @@
 
 namespace vkb
 {
+namespace
+{
+thread_local size_t registered_thread_index{0};
+
+template <class T>
+uint64_t count_descriptors(const BindingMap<T> &binding_map)
+{
+	uint64_t count = 0;
+
+	for (auto &binding_it : binding_map)
+	{
+		count += binding_it.second.size();
+	}
+
+	return count;
+}
+}        // namespace
+
+RenderFrame::ThreadContext::ThreadContext(RenderFrame &frame, size_t thread_index) :
+    frame{frame},
+    thread_index{thread_index}
+{
+	for (auto &buffer_pool_it : frame.buffer_pools)
+	{
+		auto &buffer_pool = buffer_pool_it.second.at(thread_index);
+
+		BufferSlot slot{};
+		slot.usage    = buffer_pool_it.first;
+		slot.max_size = BUFFER_POOL_BLOCK_SIZE * 1024 * frame.supported_usage_map.at(buffer_pool_it.first);
+		slot.pool     = &buffer_pool.first;
+		slot.block    = &buffer_pool.second;
+		slot.ring     = nullptr;
+
+		if (buffer_pool_it.first == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+		{
+			auto &staged_pool = frame.staged_uniform_pools.at(thread_index);
+
+			slot.staged_pool  = &staged_pool.first;
+			slot.staged_block = &staged_pool.second;
+		}
+
+		buffer_slots.push_back(slot);
+	}
+}
+
+BufferAllocation RenderFrame::ThreadContext::allocate_buffer(const VkBufferUsageFlags usage, const VkDeviceSize size)
+{
+	// Only a handful of usages are supported, a linear scan beats a map lookup
+	auto slot_it = std::find_if(buffer_slots.begin(), buffer_slots.end(), [usage](const BufferSlot &slot) { return slot.usage == usage; });
+	if (slot_it == buffer_slots.end())
+	{
+		LOGE("No buffer pool for buffer usage {}", usage);
+		return BufferAllocation{};
+	}
+
+	auto &slot = *slot_it;
+
+	if (size > slot.max_size)
+	{
+		LOGE("Trying to allocate {} buffer of size {}KB which is larger than the buffer pool block size ({} KB)!", buffer_usage_to_string(usage), size / 1024, slot.max_size / 1024);
+		throw std::runtime_error("Couldn't allocate render frame buffer.");
+	}
+
+	bool one_allocation_per_buffer = frame.buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer;
+
+	bool staged = slot.staged_pool && frame.device_local_uniforms;
+
+	if (slot.ring && !staged && !one_allocation_per_buffer)
+	{
+		auto data = slot.ring->allocate(to_u32(size));
+
+		if (!data.empty())
+		{
+			data.set_write_counters(&frame.buffer_write_counters);
+			return data;
+		}
+	}
+
+	auto &buffer_pool  = staged ? *slot.staged_pool : *slot.pool;
+	auto &buffer_block = staged ? *slot.staged_block : *slot.block;
+
+	if (one_allocation_per_buffer || !buffer_block)
+	{
+		// If there is no block associated with the pool or we are creating a buffer for each allocation,
+		// request a new buffer block
+		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+	}
+
+	auto data = buffer_block->allocate(to_u32(size));
+
+	// Check if the buffer block can allocate the requested size
+	if (data.empty())
+	{
+		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+
+		data = buffer_block->allocate(to_u32(size));
+	}
+
+	data.set_write_counters(&frame.buffer_write_counters);
+
+	return data;
+}
+
+CommandBuffer &RenderFrame::ThreadContext::request_command_buffer(const Queue &queue, CommandBuffer::ResetMode reset_mode, VkCommandBufferLevel level)
+{
+	if (!command_pool || command_pool_family_index != queue.get_family_index() || command_pool_reset_mode != reset_mode)
+	{
+		auto &command_pools = frame.get_command_pools(queue, reset_mode);
+
+		auto command_pool_it = std::find_if(command_pools.begin(), command_pools.end(), [this](std::unique_ptr<CommandPool> &cmd_pool) { return cmd_pool->get_thread_index() == thread_index; });
+
+		command_pool              = command_pool_it->get();
+		command_pool_family_index = queue.get_family_index();
+		command_pool_reset_mode   = reset_mode;
+	}
+
+	return command_pool->request_command_buffer(level);
+}
+
+DescriptorSet &RenderFrame::ThreadContext::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
+{
+	auto &descriptor_pool = request_resource(frame.device, nullptr, *frame.descriptor_pools[thread_index], descriptor_set_layout);
+
+	if (!frame.descriptor_set_recycling)
+	{
+		return request_resource(frame.device, nullptr, *frame.descriptor_sets[thread_index], descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	}
+
+	auto &thread_descriptor_sets = *frame.descriptor_sets[thread_index];
+
+	// Same hash as request_resource, so the sets it creates are found here
+	std::size_t hash{0U};
+	hash_param(hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	descriptor_set_last_use[hash] = frame.reset_count;
+
+	auto descriptor_count = count_descriptors(buffer_infos) + count_descriptors(image_infos);
+
+	auto descriptor_set_it = thread_descriptor_sets.find(hash);
+
+	if (descriptor_set_it != thread_descriptor_sets.end())
+	{
+		frame.descriptor_write_counters.writes_skipped += descriptor_count;
+
+		return descriptor_set_it->second;
+	}
+
+	frame.descriptor_write_counters.writes += descriptor_count;
+
+	auto free_sets_it = free_descriptor_sets.find(&descriptor_set_layout);
+
+	if (free_sets_it == free_descriptor_sets.end() || free_sets_it->second.empty())
+	{
+		return request_resource(frame.device, nullptr, thread_descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	}
+
+	// Rewrite a set of the same layout which is no longer requested
+	auto &free_sets = free_sets_it->second;
+
+	auto res_ins_it = thread_descriptor_sets.emplace(hash, std::move(free_sets.back()));
+	free_sets.pop_back();
+
+	auto &descriptor_set = res_ins_it.first->second;
+	descriptor_set.reset(buffer_infos, image_infos);
+
+	++frame.descriptor_write_counters.sets_recycled;
+
+	return descriptor_set;
+}
+
+const CachedDescriptorSet *RenderFrame::ThreadContext::find_descriptor_set(size_t binding_hash)
+{
+	auto cached_it = cached_descriptor_sets.find(binding_hash);
+
+	if (cached_it == cached_descriptor_sets.end())
+	{
+		return nullptr;
+	}
+
+	if (frame.descriptor_set_recycling)
+	{
+		// The cache is cleared on each reset, so the set was already marked as used this frame
+		frame.descriptor_write_counters.writes_skipped += cached_it->second.descriptor_count;
+	}
+
+	return &cached_it->second;
+}
+
+const CachedDescriptorSet &RenderFrame::ThreadContext::cache_descriptor_set(size_t binding_hash, DescriptorSet &descriptor_set, std::vector<uint32_t> &&dynamic_offsets)
+{
+	auto &cached = cached_descriptor_sets[binding_hash];
+
+	cached.descriptor_set   = &descriptor_set;
+	cached.dynamic_offsets  = std::move(dynamic_offsets);
+	cached.descriptor_count = count_descriptors(descriptor_set.get_buffer_infos()) + count_descriptors(descriptor_set.get_image_infos());
+
+	return cached;
+}
+
+void RenderFrame::ThreadContext::recycle_descriptor_sets()
+{
+	auto &thread_descriptor_sets = *frame.descriptor_sets[thread_index];
+
+	// Sets are moved to the free lists, drop the pointers to them
+	cached_descriptor_sets.clear();
+
+	for (auto descriptor_set_it = thread_descriptor_sets.begin(); descriptor_set_it != thread_descriptor_sets.end();)
+	{
+		auto last_use_it = descriptor_set_last_use.find(descriptor_set_it->first);
+
+		// The frame has been waited on, so the sets it did not request in its last use can be rewritten
+		if (last_use_it == descriptor_set_last_use.end() || last_use_it->second < frame.reset_count)
+		{
+			auto &descriptor_set = descriptor_set_it->second;
+
+			free_descriptor_sets[&descriptor_set.get_layout()].push_back(std::move(descriptor_set));
+
+			if (last_use_it != descriptor_set_last_use.end())
+			{
+				descriptor_set_last_use.erase(last_use_it);
+			}
+
+			descriptor_set_it = thread_descriptor_sets.erase(descriptor_set_it);
+		}
+		else
+		{
+			++descriptor_set_it;
+		}
+	}
+}
+
+size_t RenderFrame::ThreadContext::get_thread_index() const
+{
+	return thread_index;
+}
+
+LinearAllocator &RenderFrame::ThreadContext::get_linear_allocator()
+{
+	return linear_allocator;
+}
+
 RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count) :
     device{device},
     fence_pool{device},
@@ -29,6 +270,11 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
     swapchain_render_target{std::move(render_target)},
     thread_count{thread_count}
 {
+	if (device.is_enabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		timeline_semaphore = std::make_unique<TimelineSemaphore>(device);
+	}
+
 	for (auto &usage_it : supported_usage_map)
 	{
 		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
@@ -45,11 +291,22 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
 		}
 	}
 
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		auto block_size = BUFFER_POOL_BLOCK_SIZE * 1024 * supported_usage_map.at(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		staged_uniform_pools.push_back(std::make_pair(BufferPool{device, block_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, true}, nullptr));
+	}
+
 	for (size_t i = 0; i < thread_count; ++i)
 	{
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
 		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
 	}
+
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		thread_contexts.push_back(std::make_unique<ThreadContext>(*this, i));
+	}
 }
 
 Device &RenderFrame::get_device()
@@ -59,12 +316,47 @@ Device &RenderFrame::get_device()
 
 void RenderFrame::update_render_target(std::unique_ptr<RenderTarget> &&render_target)
 {
+	// The submissions of the frame so far may still render to the previous target
+	device.get_deletion_queue().retire(std::move(swapchain_render_target));
+
 	swapchain_render_target = std::move(render_target);
+
+	render_target_replaced = true;
 }
 
-void RenderFrame::reset()
+bool RenderFrame::is_complete() const
 {
+	VkResult result = timeline_semaphore ? timeline_semaphore->wait(0) : VK_SUCCESS;
+
+	if (result == VK_SUCCESS)
+	{
+		result = fence_pool.wait(0);
+	}
+
+	if (result == VK_TIMEOUT)
+	{
+		return false;
+	}
+
+	VK_CHECK(result);
+
+	return true;
+}
+
+void RenderFrame::wait() const
+{
+	if (timeline_semaphore)
+	{
+		VK_CHECK(timeline_semaphore->wait());
+	}
+
+	// Fences may still be requested by code submitting outside of the render context
 	VK_CHECK(fence_pool.wait());
+}
+
+void RenderFrame::reset()
+{
+	wait();
 
 	fence_pool.reset();
 
@@ -85,6 +377,45 @@ void RenderFrame::reset()
 		}
 	}
 
+	for (auto &buffer_pool : staged_uniform_pools)
+	{
+		buffer_pool.first.reset();
+		buffer_pool.second = nullptr;
+	}
+
+	buffer_write_counters.bytes_written       = 0;
+	buffer_write_counters.allocations_avoided = 0;
+
+	if (descriptor_set_recycling)
+	{
+		for (auto &thread_context : thread_contexts)
+		{
+			thread_context->recycle_descriptor_sets();
+		}
+	}
+
+	descriptor_write_counters.writes         = 0;
+	descriptor_write_counters.writes_skipped = 0;
+	descriptor_write_counters.sets_recycled  = 0;
+
+	// The containers of the previous recording of the frame are gone
+	for (auto &thread_context : thread_contexts)
+	{
+		thread_context->linear_allocator.reset();
+	}
+
+	// Bundles reference the framebuffers of the previous images
+	if (descriptor_set_recycling || render_target_replaced)
+	{
+		clear_bundles();
+	}
+
+	render_target_replaced = false;
+
+	bundle_reuse_count = 0;
+
+	++reset_count;
+
 	semaphore_pool.reset();
 }
 
@@ -98,6 +429,15 @@ std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const
 		{
 			device.wait_idle();
 
+			// Forget the pools cached by the threads before deleting them
+			for (auto &thread_context : thread_contexts)
+			{
+				if (thread_context->command_pool_family_index == queue.get_family_index())
+				{
+					thread_context->command_pool = nullptr;
+				}
+			}
+
 			// Delete pools
 			command_pools.erase(command_pool_it);
 		}
@@ -145,6 +485,11 @@ VkSemaphore RenderFrame::request_semaphore()
 	return semaphore_pool.request_semaphore();
 }
 
+TimelineSemaphore *RenderFrame::get_timeline_semaphore()
+{
+	return timeline_semaphore.get();
+}
+
 RenderTarget &RenderFrame::get_render_target()
 {
 	return *swapchain_render_target;
@@ -157,21 +502,22 @@ const RenderTarget &RenderFrame::get_render_target_const() const
 
 CommandBuffer &RenderFrame::request_command_buffer(const Queue &queue, CommandBuffer::ResetMode reset_mode, VkCommandBufferLevel level, size_t thread_index)
 {
-	assert(thread_index < thread_count && "Thread index is out of bounds");
-
-	auto &command_pools = get_command_pools(queue, reset_mode);
-
-	auto command_pool_it = std::find_if(command_pools.begin(), command_pools.end(), [&thread_index](std::unique_ptr<CommandPool> &cmd_pool) { return cmd_pool->get_thread_index() == thread_index; });
-
-	return (*command_pool_it)->request_command_buffer(level);
+	return get_thread_context(thread_index).request_command_buffer(queue, reset_mode, level);
 }
 
 DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index)
 {
-	assert(thread_index < thread_count && "Thread index is out of bounds");
+	return get_thread_context(thread_index).request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos);
+}
+
+const CachedDescriptorSet *RenderFrame::find_descriptor_set(size_t binding_hash, size_t thread_index)
+{
+	return get_thread_context(thread_index).find_descriptor_set(binding_hash);
+}
 
-	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
-	return request_resource(device, nullptr, *descriptor_sets.at(thread_index), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+const CachedDescriptorSet &RenderFrame::cache_descriptor_set(size_t binding_hash, DescriptorSet &descriptor_set, std::vector<uint32_t> &&dynamic_offsets, size_t thread_index)
+{
+	return get_thread_context(thread_index).cache_descriptor_set(binding_hash, descriptor_set, std::move(dynamic_offsets));
 }
 
 void RenderFrame::update_descriptor_sets(size_t thread_index)
@@ -190,6 +536,14 @@ void RenderFrame::clear_descriptors()
 		desc_sets_per_thread->clear();
 	}
 
+	// The free sets are released in bulk with their pools
+	for (auto &thread_context : thread_contexts)
+	{
+		thread_context->descriptor_set_last_use.clear();
+		thread_context->free_descriptor_sets.clear();
+		thread_context->cached_descriptor_sets.clear();
+	}
+
 	for (auto &desc_pools_per_thread : descriptor_pools)
 	{
 		for (auto &desc_pool : *desc_pools_per_thread)
@@ -199,6 +553,68 @@ void RenderFrame::clear_descriptors()
 	}
 }
 
+void RenderFrame::set_descriptor_set_recycling(bool enabled)
+{
+	descriptor_set_recycling = enabled;
+}
+
+size_t RenderFrame::get_thread_count() const
+{
+	return thread_count;
+}
+
+std::vector<const core::Buffer *> RenderFrame::get_buffers() const
+{
+	std::vector<const core::Buffer *> buffers;
+
+	auto add_pool = [&buffers](const BufferPool &pool) {
+		for (auto &block : pool.get_buffer_blocks())
+		{
+			buffers.push_back(&block->get_buffer());
+
+			if (auto staging_buffer = block->get_staging_buffer())
+			{
+				buffers.push_back(staging_buffer);
+			}
+		}
+	};
+
+	for (auto &usage_pools : buffer_pools)
+	{
+		for (auto &pool : usage_pools.second)
+		{
+			add_pool(pool.first);
+		}
+	}
+
+	for (auto &pool : staged_uniform_pools)
+	{
+		add_pool(pool.first);
+	}
+
+	return buffers;
+}
+
+std::vector<const DescriptorPool *> RenderFrame::get_descriptor_pools() const
+{
+	std::vector<const DescriptorPool *> pools;
+
+	for (auto &thread_pools : descriptor_pools)
+	{
+		for (auto &pool : *thread_pools)
+		{
+			pools.push_back(&pool.second);
+		}
+	}
+
+	return pools;
+}
+
+const DescriptorWriteCounters &RenderFrame::get_descriptor_write_counters() const
+{
+	return descriptor_write_counters;
+}
+
 void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy)
 {
 	buffer_allocation_strategy = new_strategy;
@@ -206,44 +622,158 @@ void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_st
 
 BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, const VkDeviceSize size, size_t thread_index)
 {
-	assert(thread_index < thread_count && "Thread index is out of bounds");
+	return get_thread_context(thread_index).allocate_buffer(usage, size);
+}
 
-	uint32_t block_multiplier = supported_usage_map.at(usage);
+void RenderFrame::set_buffer_rings(const std::map<VkBufferUsageFlags, BufferRing *> &rings)
+{
+	buffer_rings = rings;
 
-	if (size > BUFFER_POOL_BLOCK_SIZE * 1024 * block_multiplier)
+	for (auto &thread_context : thread_contexts)
 	{
-		LOGE("Trying to allocate {} buffer of size {}KB which is larger than the buffer pool block size ({} KB)!", buffer_usage_to_string(usage), size / 1024, BUFFER_POOL_BLOCK_SIZE * block_multiplier);
-		throw std::runtime_error("Couldn't allocate render frame buffer.");
+		for (auto &slot : thread_context->buffer_slots)
+		{
+			auto buffer_ring_it = buffer_rings.find(slot.usage);
+			slot.ring           = buffer_ring_it != buffer_rings.end() ? buffer_ring_it->second : nullptr;
+		}
+	}
+}
+
+void RenderFrame::set_device_local_uniforms(bool enabled)
+{
+	device_local_uniforms = enabled;
+}
+
+bool RenderFrame::is_device_local_uniforms() const
+{
+	return device_local_uniforms;
+}
+
+CommandBuffer *RenderFrame::record_staged_uploads(const Queue &queue)
+{
+	// Blocks are only requested by allocations, so no block means nothing to upload
+	bool uploads_pending = std::any_of(staged_uniform_pools.begin(), staged_uniform_pools.end(),
+	                                   [](const std::pair<BufferPool, BufferBlock *> &buffer_pool) { return buffer_pool.second != nullptr; });
+
+	if (!uploads_pending)
+	{
+		return nullptr;
 	}
 
-	// Find a pool for this usage
-	auto buffer_pool_it = buffer_pools.find(usage);
-	if (buffer_pool_it == buffer_pools.end())
+	// Keep the reset mode of the existing pools, a different one would recreate them
+	auto reset_mode      = CommandBuffer::ResetMode::ResetPool;
+	auto command_pool_it = command_pools.find(queue.get_family_index());
+	if (command_pool_it != command_pools.end())
 	{
-		LOGE("No buffer pool for buffer usage {}", usage);
-		return BufferAllocation{};
+		reset_mode = command_pool_it->second.at(0)->get_reset_mode();
 	}
 
-	auto &buffer_pool  = buffer_pool_it->second.at(thread_index).first;
-	auto &buffer_block = buffer_pool_it->second.at(thread_index).second;
+	auto &command_buffer = request_command_buffer(queue, reset_mode);
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
-	if (buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer || !buffer_block)
+	for (auto &buffer_pool : staged_uniform_pools)
 	{
-		// If there is no block associated with the pool or we are creating a buffer for each allocation,
-		// request a new buffer block
-		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+		buffer_pool.first.record_uploads(command_buffer);
 	}
 
-	auto data = buffer_block->allocate(to_u32(size));
+	command_buffer.end();
 
-	// Check if the buffer block can allocate the requested size
-	if (data.empty())
+	return &command_buffer;
+}
+
+void RenderFrame::set_thread_index(size_t thread_index)
+{
+	registered_thread_index = thread_index;
+}
+
+size_t RenderFrame::get_thread_index()
+{
+	return registered_thread_index;
+}
+
+RenderFrame::ThreadContext &RenderFrame::get_thread_context()
+{
+	return get_thread_context(registered_thread_index);
+}
+
+RenderFrame::ThreadContext &RenderFrame::get_thread_context(size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	return *thread_contexts[thread_index];
+}
+
+const BufferWriteCounters &RenderFrame::get_buffer_write_counters() const
+{
+	return buffer_write_counters;
+}
+
+CommandBuffer *RenderFrame::find_bundle(const Subpass &subpass, size_t key)
+{
+	auto bundle_it = bundles.find(&subpass);
+
+	if (bundle_it == bundles.end() || bundle_it->second.key != key)
 	{
-		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+		return nullptr;
+	}
 
-		data = buffer_block->allocate(to_u32(size));
+	++bundle_reuse_count;
+
+	return bundle_it->second.command_buffer;
+}
+
+CommandBuffer &RenderFrame::request_bundle(const Subpass &subpass, size_t key, const Queue &queue)
+{
+	if (!bundle_pool)
+	{
+		bundle_pool = std::make_unique<CommandPool>(device, queue.get_family_index(), this, 0, CommandBuffer::ResetMode::ResetIndividually);
 	}
 
-	return data;
+	assert(bundle_pool->get_queue_family_index() == queue.get_family_index() && "Bundles must be submitted on the same queue family");
+
+	auto bundle_it = bundles.find(&subpass);
+
+	// The previous bundle of the subpass is no longer executed, record over it
+	if (bundle_it != bundles.end())
+	{
+		bundle_it->second.key = key;
+
+		auto &command_buffer = *bundle_it->second.command_buffer;
+		VK_CHECK(command_buffer.reset(CommandBuffer::ResetMode::ResetIndividually));
+
+		return command_buffer;
+	}
+
+	auto &command_buffer = bundle_pool->request_command_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+	bundles.emplace(&subpass, Bundle{key, &command_buffer});
+
+	return command_buffer;
+}
+
+void RenderFrame::clear_bundles()
+{
+	if (bundle_pool)
+	{
+		VK_CHECK(bundle_pool->reset_pool());
+	}
+
+	bundles.clear();
+}
+
+uint32_t RenderFrame::get_bundle_reuse_count() const
+{
+	return bundle_reuse_count;
+}
+
+void RenderFrame::add_redundant_call_count(uint32_t count)
+{
+	redundant_call_count.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint64_t RenderFrame::get_redundant_call_count() const
+{
+	return redundant_call_count.load(std::memory_order_relaxed);
 }
 }        // namespace vkb
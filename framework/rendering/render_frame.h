@@ -19,6 +19,7 @@
 
 #include "buffer_pool.h"
 #include "common/helpers.h"
+#include "common/linear_allocator.h"
 #include "common/resource_caching.h"
 #include "common/vk_common.h"
 #include "core/buffer.h"
@@ -31,15 +32,45 @@
 #include "fence_pool.h"
 #include "rendering/render_target.h"
 #include "semaphore_pool.h"
+#include "timeline_semaphore.h"
 
 namespace vkb
 {
+class Subpass;
+
 enum BufferAllocationStrategy
 {
 	OneAllocationPerBuffer,
 	MultipleAllocationsPerBuffer
 };
 
+/**
+ * @brief Counters of the descriptor writes of a frame
+ */
+struct DescriptorWriteCounters
+{
+	/// Descriptors written to new or recycled descriptor sets
+	std::atomic<uint64_t> writes{0};
+
+	/// Descriptors not written because a descriptor set with the same bindings was reused
+	std::atomic<uint64_t> writes_skipped{0};
+
+	/// Descriptor sets taken from a free list instead of being allocated
+	std::atomic<uint64_t> sets_recycled{0};
+};
+
+/**
+ * @brief A descriptor set found from the hash of its bindings, with the dynamic offsets to bind it with
+ */
+struct CachedDescriptorSet
+{
+	DescriptorSet *descriptor_set;
+
+	std::vector<uint32_t> dynamic_offsets;
+
+	uint64_t descriptor_count;
+};
+
 /**
  * @brief RenderFrame is a container for per-frame data, including BufferPool objects,
  * synchronization primitives (semaphores, fences) and the swapchain RenderTarget.
@@ -61,12 +92,132 @@ class RenderFrame
 	 */
 	static constexpr uint32_t BUFFER_POOL_BLOCK_SIZE = 256;
 
+#ifdef VK_EXT_descriptor_buffer
+	/**
+	 * @brief Usage of the buffers the command buffers write descriptors into, see Device::uses_descriptor_buffers()
+	 */
+	static constexpr VkBufferUsageFlags DESCRIPTOR_BUFFER_USAGE = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+	                                                              VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+	                                                              VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+#endif
+
+	/**
+	 * @brief The resources of the frame owned by one recording thread
+	 *
+	 * The context keeps pointers to the thread's buffer pools, rings and command pool,
+	 * so that allocating from a worker thread does not look them up in the frame maps
+	 * every time. Workers register their index once with RenderFrame::set_thread_index,
+	 * then get_thread_context() returns their context in any frame.
+	 */
+	class ThreadContext
+	{
+	  public:
+		ThreadContext(RenderFrame &frame, size_t thread_index);
+
+		ThreadContext(const ThreadContext &) = delete;
+
+		ThreadContext(ThreadContext &&) = delete;
+
+		ThreadContext &operator=(const ThreadContext &) = delete;
+
+		ThreadContext &operator=(ThreadContext &&) = delete;
+
+		/**
+		 * @param usage Usage of the buffer
+		 * @param size Amount of memory required
+		 * @return The requested allocation, it may be empty
+		 */
+		BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size);
+
+		CommandBuffer &request_command_buffer(const Queue &            queue,
+		                                      CommandBuffer::ResetMode reset_mode = CommandBuffer::ResetMode::ResetPool,
+		                                      VkCommandBufferLevel     level      = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
+		                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
+		                                      const BindingMap<VkDescriptorImageInfo> & image_infos);
+
+		/**
+		 * @param binding_hash Hash of the descriptor set layout and of the resources bound to the set
+		 * @return The descriptor set cached for the hash, or nullptr if none was cached
+		 */
+		const CachedDescriptorSet *find_descriptor_set(size_t binding_hash);
+
+		/**
+		 * @brief Caches a requested descriptor set, so that the same bindings find it without building their infos
+		 */
+		const CachedDescriptorSet &cache_descriptor_set(size_t binding_hash, DescriptorSet &descriptor_set, std::vector<uint32_t> &&dynamic_offsets);
+
+		size_t get_thread_index() const;
+
+		/**
+		 * @brief Arena of the transient CPU containers recorded by the thread, reset with the frame
+		 */
+		LinearAllocator &get_linear_allocator();
+
+	  private:
+		friend class RenderFrame;
+
+		/**
+		 * @brief Moves the descriptor sets not requested since the last reset to the free lists
+		 */
+		void recycle_descriptor_sets();
+
+		struct BufferSlot
+		{
+			VkBufferUsageFlags usage;
+
+			VkDeviceSize max_size;
+
+			BufferPool *pool;
+
+			/// Block currently allocated from, shared with RenderFrame::buffer_pools
+			BufferBlock **block;
+
+			BufferRing *ring;
+
+			/// Device local pool used in place of pool when the frame stages the usage
+			BufferPool *staged_pool;
+
+			BufferBlock **staged_block;
+		};
+
+		RenderFrame &frame;
+
+		size_t thread_index;
+
+		std::vector<BufferSlot> buffer_slots;
+
+		CommandPool *command_pool{nullptr};
+
+		uint32_t command_pool_family_index{0};
+
+		CommandBuffer::ResetMode command_pool_reset_mode{CommandBuffer::ResetMode::ResetPool};
+
+		/// Frame count at which each cached descriptor set was last requested
+		std::unordered_map<std::size_t, uint64_t> descriptor_set_last_use;
+
+		/// Descriptor sets which are still allocated but no longer requested, per layout
+		std::unordered_map<const DescriptorSetLayout *, std::vector<DescriptorSet>> free_descriptor_sets;
+
+		/// Descriptor sets by binding hash, cleared whenever the sets they point to may move
+		std::unordered_map<std::size_t, CachedDescriptorSet> cached_descriptor_sets;
+
+		LinearAllocator linear_allocator;
+	};
+
 	// A map of the supported usages to a multiplier for the BUFFER_POOL_BLOCK_SIZE
 	const std::unordered_map<VkBufferUsageFlags, uint32_t> supported_usage_map = {
 	    {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 1},
 	    {VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 2},        // x2 the size of BUFFER_POOL_BLOCK_SIZE since SSBOs are normally much larger than other types of buffers
 	    {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1},
-	    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1}};
+	    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1},
+	    {VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 1},
+#ifdef VK_EXT_descriptor_buffer
+	    // Blocks are only created when allocated from, so only with descriptor buffers
+	    {DESCRIPTOR_BUFFER_USAGE, 1},
+#endif
+	};
 
 	RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count = 1);
 
@@ -78,6 +229,16 @@ class RenderFrame
 
 	RenderFrame &operator=(RenderFrame &&) = delete;
 
+	/**
+	 * @brief Waits for the submissions of the frame to complete, without resetting it
+	 */
+	void wait() const;
+
+	/**
+	 * @brief Checks without blocking whether the submissions of the frame have completed
+	 */
+	bool is_complete() const;
+
 	void reset();
 
 	Device &get_device();
@@ -90,8 +251,17 @@ class RenderFrame
 
 	VkSemaphore request_semaphore();
 
+	/**
+	 * @return The timeline semaphore signaled by the submissions of the frame,
+	 *         or nullptr if the device does not support them and fences are used instead
+	 */
+	TimelineSemaphore *get_timeline_semaphore();
+
 	/**
 	 * @brief Called when the swapchain changes
+	 *        The previous target goes to the deletion queue of the device, which destroys it once
+	 *        the submissions which may use it have completed. The bundles recorded for it are
+	 *        released by the next reset.
 	 * @param render_target A new render target with updated images
 	 */
 	void update_render_target(std::unique_ptr<RenderTarget> &&render_target);
@@ -120,8 +290,22 @@ class RenderFrame
 	                                      const BindingMap<VkDescriptorImageInfo> & image_infos,
 	                                      size_t                                    thread_index = 0);
 
+	const CachedDescriptorSet *find_descriptor_set(size_t binding_hash, size_t thread_index = 0);
+
+	const CachedDescriptorSet &cache_descriptor_set(size_t binding_hash, DescriptorSet &descriptor_set, std::vector<uint32_t> &&dynamic_offsets, size_t thread_index = 0);
+
 	void clear_descriptors();
 
+	/**
+	 * @brief Enables recycling of the descriptor sets
+	 *        Sets with the same bindings are reused across frames without being written again,
+	 *        and sets no longer requested are rewritten for new bindings of the same layout,
+	 *        so the descriptor pools stop growing.
+	 */
+	void set_descriptor_set_recycling(bool enabled);
+
+	const DescriptorWriteCounters &get_descriptor_write_counters() const;
+
 	/**
 	 * @brief Sets a new buffer allocation strategy
 	 * @param new_strategy The new buffer allocation strategy
@@ -136,11 +320,115 @@ class RenderFrame
 	 */
 	BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index = 0);
 
+	/**
+	 * @brief Sets the rings shared with the other frames to allocate buffers from
+	 *        Allocations fall back to the buffer pools for usages without a ring, when
+	 *        the ring is full, or with the OneAllocationPerBuffer strategy.
+	 * @param rings The ring to use for each usage, empty to only use the buffer pools
+	 */
+	void set_buffer_rings(const std::map<VkBufferUsageFlags, BufferRing *> &rings);
+
+	/**
+	 * @brief Allocates uniform buffers from device local memory
+	 *        The uniforms are written to host visible staging buffers, and copied to the
+	 *        device local buffers by the command buffer from record_staged_uploads().
+	 *        Staged allocations never come from the buffer rings.
+	 * @param enabled Whether to allocate uniform buffers from device local memory
+	 */
+	void set_device_local_uniforms(bool enabled);
+
+	bool is_device_local_uniforms() const;
+
+	/**
+	 * @brief Records the copies of the uniforms staged since the frame was reset
+	 *        It must be submitted before the command buffers reading the uniforms.
+	 * @param queue The queue the command buffer will be submitted on
+	 * @return The command buffer with the copies, or nullptr if there is nothing to upload
+	 */
+	CommandBuffer *record_staged_uploads(const Queue &queue);
+
+	/**
+	 * @brief Registers the index of the calling thread, returned by get_thread_index()
+	 *        Threads which never register use index 0.
+	 * @param thread_index Index of the thread, less than the thread count of the frames
+	 */
+	static void set_thread_index(size_t thread_index);
+
+	/**
+	 * @return The index registered by the calling thread
+	 */
+	static size_t get_thread_index();
+
+	/**
+	 * @return The context of the calling thread, as registered with set_thread_index
+	 */
+	ThreadContext &get_thread_context();
+
+	ThreadContext &get_thread_context(size_t thread_index);
+
+	/**
+	 * @return The writes into the buffers allocated by the frame since it was last reset
+	 */
+	const BufferWriteCounters &get_buffer_write_counters() const;
+
 	/**
 	 * @brief Updates all the descriptor sets in the current frame at a specific thread index
 	 */
 	void update_descriptor_sets(size_t thread_index = 0);
 
+	/**
+	 * @return The number of threads the frame holds resources for
+	 */
+	size_t get_thread_count() const;
+
+	/**
+	 * @return The buffers of the blocks in the buffer pools of every thread, including staging buffers
+	 */
+	std::vector<const core::Buffer *> get_buffers() const;
+
+	/**
+	 * @return The descriptor pools of every thread
+	 */
+	std::vector<const DescriptorPool *> get_descriptor_pools() const;
+
+	/**
+	 * @brief Looks for the secondary command buffer recorded for a subpass in a previous use of the frame
+	 * @param subpass The subpass owning the bundle
+	 * @param key Hash of what the recorded content depends on
+	 * @return The bundle, or nullptr if none was recorded with this key
+	 */
+	CommandBuffer *find_bundle(const Subpass &subpass, size_t key);
+
+	/**
+	 * @brief Requests a secondary command buffer to record the bundle of a subpass into,
+	 *        replacing the previous one of the subpass
+	 *        Bundles come from a pool which is not reset with the frame, they stay valid
+	 *        until the swapchain changes or clear_bundles() is called. As descriptor set
+	 *        recycling rewrites the sets not requested in the last frame, bundles are cleared
+	 *        on every reset while it is enabled.
+	 * @param subpass The subpass owning the bundle
+	 * @param key Hash of what the recorded content depends on
+	 * @param queue The queue the bundle will be submitted on
+	 */
+	CommandBuffer &request_bundle(const Subpass &subpass, size_t key, const Queue &queue);
+
+	void clear_bundles();
+
+	/**
+	 * @return The number of bundles executed again without being recorded since the frame was reset
+	 */
+	uint32_t get_bundle_reuse_count() const;
+
+	/**
+	 * @brief Adds the calls a command buffer of the frame skipped as they set the state already bound
+	 */
+	void add_redundant_call_count(uint32_t count);
+
+	/**
+	 * @return The redundant calls skipped by the command buffers of the frame since it was created
+	 */
+	uint64_t get_redundant_call_count() const;
+
   private:
 	Device &device;
 
@@ -166,12 +454,53 @@ class RenderFrame
 
 	SemaphorePool semaphore_pool;
 
+	std::unique_ptr<TimelineSemaphore> timeline_semaphore;
+
 	size_t thread_count;
 
 	std::unique_ptr<RenderTarget> swapchain_render_target;
 
+	/// Whether update_render_target was called since the last reset, the bundles recorded for the previous target are then cleared
+	bool render_target_replaced{false};
+
 	BufferAllocationStrategy buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 
 	std::map<VkBufferUsageFlags, std::vector<std::pair<BufferPool, BufferBlock *>>> buffer_pools;
+
+	/// Device local uniform buffer pools, per thread
+	std::vector<std::pair<BufferPool, BufferBlock *>> staged_uniform_pools;
+
+	bool device_local_uniforms{false};
+
+	/// Rings owned by the RenderContext
+	std::map<VkBufferUsageFlags, BufferRing *> buffer_rings;
+
+	BufferWriteCounters buffer_write_counters;
+
+	bool descriptor_set_recycling{false};
+
+	/// Number of resets, used to find descriptor sets which were not requested in the last frame
+	uint64_t reset_count{0};
+
+	DescriptorWriteCounters descriptor_write_counters;
+
+	std::vector<std::unique_ptr<ThreadContext>> thread_contexts;
+
+	struct Bundle
+	{
+		size_t key;
+
+		CommandBuffer *command_buffer;
+	};
+
+	/// Pool of the bundles, which is not reset with the frame
+	std::unique_ptr<CommandPool> bundle_pool;
+
+	std::unordered_map<const Subpass *, Bundle> bundles;
+
+	uint32_t bundle_reuse_count{0};
+
+	/// Command buffers of different threads end concurrently
+	std::atomic<uint64_t> redundant_call_count{0};
 };
 }        // namespace vkb
@@ -0,0 +1,624 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/render_graph.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/attachment_allocator.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Layout, stages and memory accesses of an image used by a pass
+ */
+struct AccessInfo
+{
+	VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	VkPipelineStageFlags stage_mask{0};
+
+	VkAccessFlags access_mask{0};
+
+	VkImageUsageFlags usage{0};
+
+	bool write{false};
+
+	/// Whether the subpass refers to the image as an attachment
+	bool attachment{true};
+};
+
+AccessInfo get_access_info(RenderGraph::Access access, VkFormat format)
+{
+	AccessInfo info{};
+
+	switch (access)
+	{
+		case RenderGraph::Access::ColorWrite:
+			info.layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			info.stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			info.access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			info.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			info.write       = true;
+			break;
+		case RenderGraph::Access::DepthWrite:
+			info.layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			info.stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			info.access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			info.usage       = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			info.write       = true;
+			break;
+		case RenderGraph::Access::InputRead:
+			info.layout      = is_depth_stencil_format(format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			info.stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			info.access_mask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			info.usage       = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+			break;
+		case RenderGraph::Access::SampledRead:
+			info.layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			info.stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			info.access_mask = VK_ACCESS_SHADER_READ_BIT;
+			info.usage       = VK_IMAGE_USAGE_SAMPLED_BIT;
+			info.attachment  = false;
+			break;
+	}
+
+	return info;
+}
+
+/**
+ * @brief Layout a render pass leaves an attachment in when its last subpass does not refer to it, see RenderPass
+ */
+VkImageLayout get_default_final_layout(VkFormat format)
+{
+	return is_depth_stencil_format(format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+}
+
+const VkAccessFlags write_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+// Stages of whatever used the memory of an image before its first use in the frame:
+// the previous frame, the presentation engine, or an image aliasing the same memory
+const VkPipelineStageFlags previous_use_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                                                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+}        // namespace
+
+RenderGraph::Pass::Pass(RenderGraph &graph, std::unique_ptr<Subpass> &&subpass) :
+    graph{graph},
+    subpass{std::move(subpass)}
+{
+}
+
+RenderGraph::Pass &RenderGraph::Pass::write_color(const std::string &name)
+{
+	return access(name, Access::ColorWrite);
+}
+
+RenderGraph::Pass &RenderGraph::Pass::write_depth(const std::string &name)
+{
+	return access(name, Access::DepthWrite);
+}
+
+RenderGraph::Pass &RenderGraph::Pass::read_input(const std::string &name)
+{
+	return access(name, Access::InputRead);
+}
+
+RenderGraph::Pass &RenderGraph::Pass::read_sampled(const std::string &name)
+{
+	return access(name, Access::SampledRead);
+}
+
+RenderGraph::Pass &RenderGraph::Pass::access(const std::string &name, Access access)
+{
+	uint32_t index = graph.find_image(name);
+
+	auto it = std::find_if(accesses.begin(), accesses.end(), [index](const std::pair<uint32_t, Access> &use) { return use.first == index; });
+	if (it != accesses.end())
+	{
+		throw std::runtime_error("Render graph image used twice by the same pass: " + name);
+	}
+
+	accesses.emplace_back(index, access);
+
+	return *this;
+}
+
+RenderGraph::RenderGraph(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+uint32_t RenderGraph::add_image(const std::string &name, VkFormat format, VkClearValue clear_value)
+{
+	ImageInfo image{};
+	image.name        = name;
+	image.format      = format;
+	image.clear_value = clear_value;
+
+	return add_image(std::move(image));
+}
+
+uint32_t RenderGraph::add_swapchain_image(const std::string &name, VkImageLayout final_layout, VkClearValue clear_value)
+{
+	assert(std::none_of(images.begin(), images.end(), [](const ImageInfo &image) { return image.swapchain; }) && "Render graph should have one swapchain image");
+
+	ImageInfo image{};
+	image.name         = name;
+	image.format       = render_context.get_format();
+	image.clear_value  = clear_value;
+	image.swapchain    = true;
+	image.final_layout = final_layout;
+
+	return add_image(std::move(image));
+}
+
+uint32_t RenderGraph::add_image(ImageInfo &&image)
+{
+	assert(!compiled && "Images should be added before compiling the render graph");
+
+	uint32_t index = to_u32(images.size());
+
+	if (!image_indices.emplace(image.name, index).second)
+	{
+		throw std::runtime_error("Render graph image already exists: " + image.name);
+	}
+
+	images.push_back(std::move(image));
+
+	return index;
+}
+
+uint32_t RenderGraph::find_image(const std::string &name) const
+{
+	auto it = image_indices.find(name);
+	if (it == image_indices.end())
+	{
+		throw std::runtime_error("Render graph image not found: " + name);
+	}
+
+	return it->second;
+}
+
+RenderGraph::Pass &RenderGraph::add_pass(std::unique_ptr<Subpass> &&subpass)
+{
+	assert(!compiled && "Passes should be added before compiling the render graph");
+
+	passes.push_back(std::make_unique<Pass>(*this, std::move(subpass)));
+
+	return *passes.back();
+}
+
+std::vector<std::vector<size_t>> RenderGraph::merge_passes() const
+{
+	std::vector<std::vector<size_t>> groups;
+
+	// Images the subpasses of the current group refer to as attachments, and images they sample
+	std::vector<bool> attached(images.size(), false);
+	std::vector<bool> sampled(images.size(), false);
+
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		// An image cannot be sampled in the render pass writing it, nor be an attachment of the one sampling it
+		bool split = groups.empty();
+		for (auto &access : passes[i]->accesses)
+		{
+			if (access.second == Access::SampledRead ? attached[access.first] : sampled[access.first])
+			{
+				split = true;
+			}
+		}
+
+		if (split || !subpass_merging)
+		{
+			groups.emplace_back();
+			std::fill(attached.begin(), attached.end(), false);
+			std::fill(sampled.begin(), sampled.end(), false);
+		}
+
+		groups.back().push_back(i);
+
+		for (auto &access : passes[i]->accesses)
+		{
+			(access.second == Access::SampledRead ? sampled : attached)[access.first] = true;
+		}
+	}
+
+	return groups;
+}
+
+void RenderGraph::set_subpass_merging(bool enabled)
+{
+	assert(!compiled && "Subpass merging should be set before compiling the render graph");
+
+	subpass_merging = enabled;
+}
+
+void RenderGraph::compile()
+{
+	assert(!compiled && "Render graph should be compiled once");
+
+	// The render pass uses the first depth attachment of the target as depth stencil attachment
+	auto depth_it    = std::find_if(images.begin(), images.end(), [](const ImageInfo &image) { return is_depth_stencil_format(image.format); });
+	auto depth_index = to_u32(std::distance(images.begin(), depth_it));
+
+	auto groups = merge_passes();
+
+	for (uint32_t g = 0; g < to_u32(groups.size()); ++g)
+	{
+		for (auto pass_index : groups[g])
+		{
+			for (auto &access : passes[pass_index]->accesses)
+			{
+				auto &image = images[access.first];
+
+				if (access.second == Access::DepthWrite && access.first != depth_index)
+				{
+					throw std::runtime_error("Render graph image is not the first depth image of the graph: " + image.name);
+				}
+
+				image.usage |= get_access_info(access.second, image.format).usage;
+				image.first_render_pass = std::min(image.first_render_pass, g);
+				image.last_render_pass  = std::max(image.last_render_pass, g);
+			}
+		}
+	}
+
+	// State of each image at the current point of the frame
+	struct State
+	{
+		VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+		VkPipelineStageFlags stage_mask{0};
+
+		VkAccessFlags access_mask{0};
+
+		bool valid{false};
+	};
+
+	std::vector<State> states(images.size());
+
+	for (uint32_t g = 0; g < to_u32(groups.size()); ++g)
+	{
+		CompiledPass compiled_pass{};
+		compiled_pass.layouts.resize(images.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+
+		std::vector<LoadStoreInfo> load_store(images.size());
+		std::vector<VkClearValue>  clear_values(images.size());
+
+		// First access of each image in the render pass, and its access in the last subpass
+		std::vector<const Access *> first_accesses(images.size(), nullptr);
+		std::vector<const Access *> last_accesses(images.size(), nullptr);
+		std::vector<const Access *> final_accesses(images.size(), nullptr);
+
+		std::vector<std::unique_ptr<Subpass>> subpasses;
+
+		std::string pass_names;
+
+		for (auto pass_index : groups[g])
+		{
+			auto &pass = *passes[pass_index];
+
+			auto &debug_name = pass.subpass->get_debug_name();
+			pass_names += (pass_names.empty() ? "" : " + ") + (debug_name.empty() ? "Pass " + std::to_string(pass_index) : debug_name);
+
+			std::vector<uint32_t> input_attachments;
+			std::vector<uint32_t> output_attachments;
+			bool                  depth_attachment = false;
+
+			for (auto &access : pass.accesses)
+			{
+				switch (access.second)
+				{
+					case Access::ColorWrite:
+						output_attachments.push_back(access.first);
+						break;
+					case Access::DepthWrite:
+						depth_attachment = true;
+						break;
+					case Access::InputRead:
+						input_attachments.push_back(access.first);
+						break;
+					case Access::SampledRead:
+						break;
+				}
+
+				if (!first_accesses[access.first])
+				{
+					first_accesses[access.first] = &access.second;
+				}
+				last_accesses[access.first] = &access.second;
+
+				if (pass_index == groups[g].back())
+				{
+					final_accesses[access.first] = &access.second;
+				}
+			}
+
+			pass.subpass->set_input_attachments(input_attachments);
+			pass.subpass->set_output_attachments(output_attachments);
+			pass.subpass->set_disable_depth_stencil_attachment(!depth_attachment);
+
+			subpasses.push_back(std::move(pass.subpass));
+		}
+
+		for (uint32_t i = 0; i < to_u32(images.size()); ++i)
+		{
+			auto &image = images[i];
+			auto &state = states[i];
+
+			bool used_later = image.swapchain || (image.first_render_pass != ~0U && image.last_render_pass > g);
+
+			clear_values[i] = image.clear_value;
+
+			if (!first_accesses[i])
+			{
+				// Images the render pass does not touch keep their contents if a later one needs them
+				if (state.valid && used_later)
+				{
+					load_store[i]            = {VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE};
+					compiled_pass.layouts[i] = state.layout;
+				}
+				else
+				{
+					load_store[i] = {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE};
+					state.valid   = false;
+				}
+
+				state.layout = get_default_final_layout(image.format);
+				continue;
+			}
+
+			auto first = get_access_info(*first_accesses[i], image.format);
+			auto last  = get_access_info(*last_accesses[i], image.format);
+
+			if (!state.valid && !first.write)
+			{
+				LOGW("Render graph image {} is read before being written", image.name);
+			}
+
+			// Written first and with no contents yet, it is cleared
+			bool load = state.valid || !first.write;
+
+			load_store[i].load_op  = load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+			load_store[i].store_op = used_later ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+			// Sampled images are no attachment of the subpasses, so the render pass must know their layout
+			if (!first.attachment)
+			{
+				compiled_pass.layouts[i] = first.layout;
+			}
+
+			VkImageLayout old_layout = load && state.valid ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+			// Reading an image again in the same layout needs no barrier
+			bool read_after_read = state.valid && !first.write && (state.access_mask & write_access_mask) == 0;
+
+			if (old_layout != first.layout || !read_after_read)
+			{
+				ImageMemoryBarrier barrier{};
+				barrier.old_layout      = old_layout;
+				barrier.new_layout      = first.layout;
+				barrier.src_stage_mask  = state.stage_mask ? state.stage_mask : previous_use_stage_mask;
+				barrier.src_access_mask = state.stage_mask ? state.access_mask & write_access_mask : write_access_mask;
+				barrier.dst_stage_mask  = first.stage_mask;
+				barrier.dst_access_mask = first.access_mask;
+
+				compiled_pass.barrier_attachments.push_back(i);
+				compiled_pass.barriers.push_back(barrier);
+			}
+
+			// The render pass leaves an image in the layout of its last subpass, see RenderPass
+			state.layout      = final_accesses[i] && first.attachment ? get_access_info(*final_accesses[i], image.format).layout : get_default_final_layout(image.format);
+			state.stage_mask  = last.stage_mask;
+			state.access_mask = last.access_mask;
+			state.valid       = used_later;
+		}
+
+		std::string load_stores;
+		for (uint32_t i = 0; i < to_u32(images.size()); ++i)
+		{
+			load_stores += fmt::format("{}{} {}/{}", i ? ", " : "", images[i].name, to_string(load_store[i].load_op), to_string(load_store[i].store_op));
+		}
+
+		report.push_back(fmt::format("Render pass {}: {} ({})", g, pass_names, load_stores));
+		LOGI("Render graph {}", report.back());
+
+		compiled_pass.pipeline = std::make_unique<RenderPipeline>(std::move(subpasses));
+		compiled_pass.pipeline->set_load_store(load_store);
+		compiled_pass.pipeline->set_clear_value(clear_values);
+
+		compiled_passes.push_back(std::move(compiled_pass));
+	}
+
+	for (uint32_t i = 0; i < to_u32(images.size()); ++i)
+	{
+		auto &image = images[i];
+		auto &state = states[i];
+
+		if (!image.swapchain)
+		{
+			continue;
+		}
+
+		if (!state.valid)
+		{
+			LOGW("Render graph swapchain image {} is never written", image.name);
+		}
+
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = state.valid ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.new_layout      = image.final_layout;
+		barrier.src_stage_mask  = state.stage_mask ? state.stage_mask : previous_use_stage_mask;
+		barrier.src_access_mask = state.access_mask & write_access_mask;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		final_barrier_attachments.push_back(i);
+		final_barriers.push_back(barrier);
+	}
+
+	compiled = true;
+}
+
+std::unique_ptr<RenderTarget> RenderGraph::create_render_target(core::Image &&swapchain_image)
+{
+	assert(compiled && "Render graph should be compiled before creating its render targets");
+
+	auto &device = swapchain_image.get_device();
+	auto  extent = swapchain_image.get_extent();
+
+	auto attachment_allocator = std::make_unique<AttachmentAllocator>(device, extent);
+
+	// Images living in a single render pass are transient, the others alias the memory of images with disjoint lifetimes
+	std::vector<bool> aliased(images.size(), false);
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		auto &image = images[i];
+
+		if (!image.swapchain && image.first_render_pass != image.last_render_pass)
+		{
+			attachment_allocator->request(image.format, image.usage, image.first_render_pass, image.last_render_pass);
+			aliased[i] = true;
+		}
+	}
+
+	bool has_aliased_images = std::find(aliased.begin(), aliased.end(), true) != aliased.end();
+
+	std::vector<core::Image> aliased_images;
+	if (has_aliased_images)
+	{
+		aliased_images = attachment_allocator->allocate();
+	}
+
+	std::vector<core::Image> target_images;
+	auto                     aliased_it = aliased_images.begin();
+
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		auto &image = images[i];
+
+		if (image.swapchain)
+		{
+			target_images.push_back(std::move(swapchain_image));
+		}
+		else if (aliased[i])
+		{
+			target_images.push_back(std::move(*aliased_it++));
+		}
+		else
+		{
+			// Sampled images cannot be transient, but a single render pass cannot sample the image it writes
+			auto usage = image.usage ? image.usage : get_access_info(is_depth_stencil_format(image.format) ? Access::DepthWrite : Access::ColorWrite, image.format).usage;
+			target_images.push_back(RenderTarget::create_attachment_image(device, extent, image.format, usage, true));
+		}
+	}
+
+	if (has_aliased_images)
+	{
+		return std::make_unique<RenderTarget>(std::move(target_images), std::move(attachment_allocator));
+	}
+
+	return std::make_unique<RenderTarget>(std::move(target_images));
+}
+
+void RenderGraph::draw(CommandBuffer &command_buffer, RenderTarget &render_target, const std::function<void(CommandBuffer &)> &record_last_render_pass)
+{
+	assert(compiled && "Render graph should be compiled before drawing");
+
+	auto &views  = render_target.get_views();
+	auto &extent = render_target.get_extent();
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	command_buffer.set_scissor(0, {scissor});
+
+	std::vector<const core::ImageView *> barrier_views;
+
+	for (auto &compiled_pass : compiled_passes)
+	{
+		for (uint32_t i = 0; i < to_u32(compiled_pass.layouts.size()); ++i)
+		{
+			render_target.set_layout(i, compiled_pass.layouts[i]);
+		}
+
+		barrier_views.clear();
+		for (auto attachment : compiled_pass.barrier_attachments)
+		{
+			barrier_views.push_back(&views.at(attachment));
+		}
+		command_buffer.image_memory_barriers(barrier_views, compiled_pass.barriers);
+
+		compiled_pass.pipeline->draw(command_buffer, render_target);
+
+		if (record_last_render_pass && &compiled_pass == &compiled_passes.back())
+		{
+			record_last_render_pass(command_buffer);
+		}
+
+		command_buffer.end_render_pass();
+	}
+
+	barrier_views.clear();
+	for (auto attachment : final_barrier_attachments)
+	{
+		barrier_views.push_back(&views.at(attachment));
+	}
+	command_buffer.image_memory_barriers(barrier_views, final_barriers);
+}
+
+std::vector<RenderPipeline *> RenderGraph::get_render_pipelines() const
+{
+	std::vector<RenderPipeline *> pipelines;
+	for (auto &compiled_pass : compiled_passes)
+	{
+		pipelines.push_back(compiled_pass.pipeline.get());
+	}
+
+	return pipelines;
+}
+
+const std::vector<std::string> &RenderGraph::get_report() const
+{
+	return report;
+}
+
+size_t RenderGraph::get_barrier_count() const
+{
+	size_t count = final_barriers.size();
+	for (auto &compiled_pass : compiled_passes)
+	{
+		count += compiled_pass.barriers.size();
+	}
+
+	return count;
+}
+}        // namespace vkb
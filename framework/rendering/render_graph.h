@@ -0,0 +1,241 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief Builds a frame from passes declaring which images they read and write
+ *        The images of the graph are the attachments of a single RenderTarget, the swapchain image
+ *        optionally among them. Passes are recorded in the order they were added. Compiling the graph:
+ *        - merges consecutive passes into the subpasses of one render pass, unless a pass samples an
+ *          image written in that render pass, so that tile-based GPUs keep the intermediate images on chip
+ *        - derives the load and store operations and the layout of every attachment of each render pass
+ *        - derives the barriers to record before each render pass, batched in one pipeline barrier
+ *        - places images whose lifetimes do not overlap in the same memory, and makes the images living
+ *          in a single render pass transient
+ */
+class RenderGraph
+{
+  public:
+	/**
+	 * @brief How a pass uses an image
+	 */
+	enum class Access
+	{
+		ColorWrite,
+		DepthWrite,
+		InputRead,
+		SampledRead
+	};
+
+	/**
+	 * @brief A Subpass along with the images it uses
+	 */
+	class Pass
+	{
+	  public:
+		Pass(RenderGraph &graph, std::unique_ptr<Subpass> &&subpass);
+
+		/**
+		 * @brief Declares an image written as a color attachment, in the order of the shader outputs
+		 */
+		Pass &write_color(const std::string &name);
+
+		/**
+		 * @brief Declares the image written as depth stencil attachment
+		 *        A render pass uses the first depth format attachment of the render target for depth, so it must be that image.
+		 */
+		Pass &write_depth(const std::string &name);
+
+		/**
+		 * @brief Declares an image read as input attachment, in the order of the shader input attachment indices
+		 */
+		Pass &read_input(const std::string &name);
+
+		/**
+		 * @brief Declares an image sampled in the shaders
+		 *        The subpass binds the image by itself, using the attachment index returned when the image was added.
+		 */
+		Pass &read_sampled(const std::string &name);
+
+	  private:
+		friend class RenderGraph;
+
+		Pass &access(const std::string &name, Access access);
+
+		RenderGraph &graph;
+
+		std::unique_ptr<Subpass> subpass;
+
+		std::vector<std::pair<uint32_t, Access>> accesses;
+	};
+
+	RenderGraph(RenderContext &render_context);
+
+	RenderGraph(const RenderGraph &) = delete;
+
+	RenderGraph(RenderGraph &&) = delete;
+
+	RenderGraph &operator=(const RenderGraph &) = delete;
+
+	RenderGraph &operator=(RenderGraph &&) = delete;
+
+	/**
+	 * @brief Declares an image created by the graph, at the extent of the swapchain
+	 * @param name Name used by the passes to refer to the image
+	 * @param format Format of the image
+	 * @param clear_value Value the image is cleared to, if a render pass writes it first
+	 * @return The attachment index of the image in the render target
+	 */
+	uint32_t add_image(const std::string &name, VkFormat format, VkClearValue clear_value = {});
+
+	/**
+	 * @brief Declares the swapchain image, handed over to the graph by create_render_target
+	 * @param name Name used by the passes to refer to the image
+	 * @param final_layout Layout the image is transitioned to by the end of the frame
+	 * @param clear_value Value the image is cleared to, if a render pass writes it first
+	 * @return The attachment index of the image in the render target
+	 */
+	uint32_t add_swapchain_image(const std::string &name, VkImageLayout final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VkClearValue clear_value = {});
+
+	/**
+	 * @brief Appends a pass, whose images are declared with the returned Pass
+	 */
+	Pass &add_pass(std::unique_ptr<Subpass> &&subpass);
+
+	/**
+	 * @brief Sets whether consecutive passes may be merged in the same render pass, the default
+	 *        Without merging every pass has its own render pass, which stores and loads the images the next one reads.
+	 *        It must be set before compile().
+	 */
+	void set_subpass_merging(bool enabled);
+
+	/**
+	 * @brief Merges the passes into render pipelines and derives their load stores, layouts and barriers
+	 *        It logs the passes merged in each render pass, along with the load and store operations of its attachments.
+	 *        It sets the attachments of the subpasses, so it must be called once all the passes were added,
+	 *        and before create_render_target.
+	 */
+	void compile();
+
+	/**
+	 * @brief Creates the images of the graph, to be used as the RenderTarget::CreateFunc of the render context
+	 */
+	std::unique_ptr<RenderTarget> create_render_target(core::Image &&swapchain_image);
+
+	/**
+	 * @brief Records the render pipelines with their barriers, and transitions the swapchain image to its final layout
+	 * @param record_last_render_pass Records additional commands at the end of the last render pass, e.g. the GUI
+	 */
+	void draw(CommandBuffer &command_buffer, RenderTarget &render_target, const std::function<void(CommandBuffer &)> &record_last_render_pass = nullptr);
+
+	/**
+	 * @return The render pipelines, one for each render pass of the compiled graph
+	 */
+	std::vector<RenderPipeline *> get_render_pipelines() const;
+
+	/**
+	 * @return The number of image barriers recorded every frame
+	 */
+	size_t get_barrier_count() const;
+
+	/**
+	 * @return For each render pass of the compiled graph, the passes it merges and the load and store operations of its attachments
+	 */
+	const std::vector<std::string> &get_report() const;
+
+  private:
+	struct ImageInfo
+	{
+		std::string name;
+
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		VkClearValue clear_value{};
+
+		bool swapchain{false};
+
+		VkImageLayout final_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+		VkImageUsageFlags usage{0};
+
+		/// First and last render pass of the compiled graph using the image
+		uint32_t first_render_pass{~0U};
+
+		uint32_t last_render_pass{0};
+	};
+
+	/**
+	 * @brief Render pass of the compiled graph, along with what to record before it
+	 */
+	struct CompiledPass
+	{
+		std::unique_ptr<RenderPipeline> pipeline;
+
+		/// Layout of each attachment at the start of the render pass, undefined for those the subpasses refer to
+		std::vector<VkImageLayout> layouts;
+
+		std::vector<uint32_t> barrier_attachments;
+
+		std::vector<ImageMemoryBarrier> barriers;
+	};
+
+	uint32_t add_image(ImageInfo &&image);
+
+	uint32_t find_image(const std::string &name) const;
+
+	/**
+	 * @return The groups of consecutive passes merged in the same render pass
+	 */
+	std::vector<std::vector<size_t>> merge_passes() const;
+
+	RenderContext &render_context;
+
+	std::vector<ImageInfo> images;
+
+	std::unordered_map<std::string, uint32_t> image_indices;
+
+	std::vector<std::unique_ptr<Pass>> passes;
+
+	std::vector<CompiledPass> compiled_passes;
+
+	std::vector<uint32_t> final_barrier_attachments;
+
+	std::vector<ImageMemoryBarrier> final_barriers;
+
+	std::vector<std::string> report;
+
+	bool subpass_merging{true};
+
+	bool compiled{false};
+};
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "render_pipeline.h"
 
+#include "common/resource_caching.h"
+#include "common/strings.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
@@ -26,6 +28,7 @@
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/node.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
@@ -50,9 +53,20 @@ void RenderPipeline::prepare()
 void RenderPipeline::add_subpass(std::unique_ptr<Subpass> &&subpass)
 {
 	subpass->prepare();
+	subpass->set_shader_watcher(shader_watcher);
 	subpasses.emplace_back(std::move(subpass));
 }
 
+void RenderPipeline::set_shader_watcher(ShaderWatcher *watcher)
+{
+	shader_watcher = watcher;
+
+	for (auto &subpass : subpasses)
+	{
+		subpass->set_shader_watcher(shader_watcher);
+	}
+}
+
 std::vector<std::unique_ptr<Subpass>> &RenderPipeline::get_subpasses()
 {
 	return subpasses;
@@ -68,6 +82,119 @@ void RenderPipeline::set_load_store(const std::vector<LoadStoreInfo> &ls)
 	load_store = ls;
 }
 
+void RenderPipeline::set_load_store_inference(bool enable)
+{
+	load_store_inference = enable;
+}
+
+bool RenderPipeline::is_using_load_store_inference() const
+{
+	return load_store_inference;
+}
+
+std::vector<LoadStoreInfo> RenderPipeline::infer_load_store(const RenderTarget &render_target) const
+{
+	auto &attachments = render_target.get_attachments();
+	auto &views       = render_target.get_views();
+
+	// The render pass uses the first depth attachment for the subpasses with depth, see RenderPass
+	auto depth_it = std::find_if(attachments.begin(), attachments.end(), [](const Attachment &attachment) { return is_depth_stencil_format(attachment.format); });
+
+	// Whether each attachment is used by a subpass, and whether it is read before any subpass writes it
+	std::vector<bool> used(attachments.size(), false);
+	std::vector<bool> read_first(attachments.size(), false);
+
+	auto write = [&used](uint32_t index) {
+		if (index < used.size())
+		{
+			used[index] = true;
+		}
+	};
+
+	for (auto &subpass : subpasses)
+	{
+		for (auto index : subpass->get_input_attachments())
+		{
+			if (index < used.size() && !used[index])
+			{
+				used[index]       = true;
+				read_first[index] = true;
+			}
+		}
+
+		for (auto index : subpass->get_output_attachments())
+		{
+			write(index);
+		}
+
+		for (auto index : subpass->get_color_resolve_attachments())
+		{
+			write(index);
+		}
+
+		if (!subpass->get_disable_depth_stencil_attachment() && depth_it != attachments.end())
+		{
+			write(to_u32(std::distance(attachments.begin(), depth_it)));
+
+			if (subpass->get_depth_stencil_resolve_mode() != VK_RESOLVE_MODE_NONE)
+			{
+				write(subpass->get_depth_stencil_resolve_attachment());
+			}
+		}
+	}
+
+	const VkImageUsageFlags later_usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+	std::vector<LoadStoreInfo> inferred(attachments.size());
+
+	for (size_t i = 0; i < attachments.size(); ++i)
+	{
+		auto &image = views[i].get_image();
+
+		bool external   = image.get_memory() == VK_NULL_HANDLE && !image.is_aliased();
+		bool transient  = (attachments[i].usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+		bool used_later = !transient && (external || (attachments[i].usage & later_usage) != 0);
+
+		if (!used[i])
+		{
+			inferred[i].load_op = used_later ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		}
+		else
+		{
+			inferred[i].load_op = read_first[i] ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		}
+		inferred[i].store_op = used_later ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	}
+
+	return inferred;
+}
+
+void RenderPipeline::report_load_store(const std::vector<LoadStoreInfo> &inferred)
+{
+	load_store_reported = true;
+
+	std::string differences;
+	for (size_t i = 0; i < inferred.size(); ++i)
+	{
+		// Missing operations default to clear and store, as in RenderPass
+		LoadStoreInfo specified = i < load_store.size() ? load_store[i] : LoadStoreInfo{};
+
+		if (specified.load_op != inferred[i].load_op || specified.store_op != inferred[i].store_op)
+		{
+			differences += fmt::format("{}attachment {} {}/{} (inferred {}/{})", differences.empty() ? "" : ", ", i,
+			                           to_string(specified.load_op), to_string(specified.store_op),
+			                           to_string(inferred[i].load_op), to_string(inferred[i].store_op));
+		}
+	}
+
+	if (!differences.empty())
+	{
+		auto &name = subpasses[0]->get_debug_name();
+		LOGI("Render pipeline{} {}: {}", name.empty() ? "" : " " + name,
+		     load_store_inference ? "uses inferred load store operations" : "load store operations differ from the inferred ones", differences);
+	}
+}
+
 const std::vector<VkClearValue> &RenderPipeline::get_clear_value() const
 {
 	return clear_value;
@@ -88,6 +215,58 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 		clear_value.push_back({0.0f, 0.0f, 0.0f, 1.0f});
 	}
 
+	if (load_store_inference || !load_store_reported)
+	{
+		auto inferred = infer_load_store(render_target);
+
+		if (!load_store_reported)
+		{
+			report_load_store(inferred);
+		}
+
+		if (load_store_inference)
+		{
+			inferred_load_store = std::move(inferred);
+		}
+	}
+
+	auto area = get_render_area(render_target);
+
+	for (auto &subpass : subpasses)
+	{
+		subpass->set_render_area(area);
+		subpass->pre_draw(command_buffer);
+	}
+
+	if (area.width != render_target.get_extent().width || area.height != render_target.get_extent().height)
+	{
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(area.width);
+		viewport.height   = static_cast<float>(area.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+
+		VkRect2D scissor{};
+		scissor.extent = area;
+		command_buffer.set_scissor(0, {scissor});
+	}
+
+	if (dynamic_rendering)
+	{
+		if (supports_dynamic_rendering())
+		{
+			draw_dynamic_rendering(command_buffer, render_target, contents);
+			return;
+		}
+
+		if (!dynamic_rendering_fallback_logged)
+		{
+			LOGW("Render pipeline has input or resolve attachments or several views, recording it with a render pass");
+			dynamic_rendering_fallback_logged = true;
+		}
+	}
+
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		active_subpass_index = i;
@@ -96,21 +275,289 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 
 		subpass->update_render_target_attachments();
 
+		auto subpass_contents = subpass->records_secondary_command_buffers() ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : contents;
+
 		if (i == 0)
 		{
-			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, contents);
+			command_buffer.begin_render_pass(render_target, load_store_inference ? inferred_load_store : load_store, clear_value, subpasses, subpass_contents, area);
 		}
 		else
 		{
-			command_buffer.next_subpass();
+			command_buffer.next_subpass(subpass_contents);
+		}
+
+		draw_subpass(command_buffer, render_target, *subpass, i, subpass_contents);
+	}
+
+	active_subpass_index = 0;
+}
+
+void RenderPipeline::draw_dynamic_rendering(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents)
+{
+	auto &attachments = render_target.get_attachments();
+	auto &views       = render_target.get_views();
+
+	auto depth_it = std::find_if(attachments.begin(), attachments.end(), [](const Attachment &attachment) { return is_depth_stencil_format(attachment.format); });
+
+	// Attachments written by each scope, the depth one being the first depth attachment as in the render passes
+	std::vector<std::vector<uint32_t>> scope_attachments(subpasses.size());
+	std::vector<size_t>                last_scope(attachments.size(), 0);
+
+	for (size_t i = 0; i < subpasses.size(); ++i)
+	{
+		for (auto index : subpasses[i]->get_output_attachments())
+		{
+			if (!is_depth_stencil_format(attachments.at(index).format))
+			{
+				scope_attachments[i].push_back(index);
+			}
+		}
+
+		for (auto index : scope_attachments[i])
+		{
+			last_scope[index] = i;
 		}
 
-		subpass->draw(command_buffer);
+		if (!subpasses[i]->get_disable_depth_stencil_attachment() && depth_it != attachments.end())
+		{
+			last_scope[static_cast<size_t>(std::distance(attachments.begin(), depth_it))] = i;
+		}
+	}
+
+	// Attachments are cleared by the first scope using them and stored for the later ones, which load them
+	auto scope_load_store = load_store_inference ? inferred_load_store : load_store;
+	scope_load_store.resize(std::max(scope_load_store.size(), attachments.size()));
+
+	std::vector<bool> written(attachments.size(), false);
+
+	for (size_t i = 0; i < subpasses.size(); ++i)
+	{
+		active_subpass_index = i;
+
+		auto &subpass = subpasses[i];
+
+		subpass->update_render_target_attachments();
+
+		auto subpass_contents = subpass->records_secondary_command_buffers() ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : contents;
+
+		auto &color_attachments = scope_attachments[i];
+
+		bool depth_stencil_attachment = !subpass->get_disable_depth_stencil_attachment();
+
+		auto current_load_store = scope_load_store;
+		for (uint32_t index = 0; index < last_scope.size(); ++index)
+		{
+			if (last_scope[index] > i)
+			{
+				current_load_store[index].store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+		}
+
+		if (i > 0)
+		{
+			command_buffer.end_render_pass();
+
+			// The previous scopes wrote the attachments this one may read or write again
+			std::vector<const core::ImageView *> barrier_views;
+			std::vector<ImageMemoryBarrier>      barriers;
+
+			for (uint32_t index = 0; index < written.size(); ++index)
+			{
+				if (!written[index])
+				{
+					continue;
+				}
+
+				ImageMemoryBarrier barrier{};
+
+				if (is_depth_stencil_format(attachments[index].format))
+				{
+					barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+					barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+					barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+					barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+					barrier.src_stage_mask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+					barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				}
+				else
+				{
+					barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+					barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+					barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+					barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				}
+
+				barrier_views.push_back(&views[index]);
+				barriers.push_back(barrier);
+			}
+
+			command_buffer.image_memory_barriers(barrier_views, barriers);
+		}
+
+		command_buffer.begin_rendering(render_target, color_attachments, depth_stencil_attachment, current_load_store, clear_value, subpass_contents, subpass->get_render_area());
+
+		for (auto index : color_attachments)
+		{
+			written[index] = true;
+		}
+
+		if (depth_stencil_attachment && depth_it != attachments.end())
+		{
+			written[static_cast<size_t>(std::distance(attachments.begin(), depth_it))] = true;
+		}
+
+		for (uint32_t index = 0; index < written.size(); ++index)
+		{
+			if (written[index])
+			{
+				scope_load_store[index].load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+			}
+		}
+
+		draw_subpass(command_buffer, render_target, *subpass, i, subpass_contents);
 	}
 
 	active_subpass_index = 0;
 }
 
+void RenderPipeline::draw_subpass(CommandBuffer &command_buffer, RenderTarget &render_target, Subpass &subpass, size_t index, VkSubpassContents subpass_contents)
+{
+	// Subpasses of secondary command buffers may only execute them, and the name is only built if a scope is recorded
+	bool scoped = subpass_contents == VK_SUBPASS_CONTENTS_INLINE && command_buffer.has_gpu_scopes();
+
+	if (scoped)
+	{
+		command_buffer.push_gpu_scope(subpass.get_debug_name().empty() ? "Subpass " + std::to_string(index) : subpass.get_debug_name());
+	}
+
+	command_buffer.set_fragment_shading_rate_state(subpass.get_fragment_shading_rate_state());
+
+	if (subpass.has_static_content())
+	{
+		draw_static_content(command_buffer, render_target, subpass);
+	}
+	else
+	{
+		VKB_PROFILE_ZONE("Subpass::draw");
+
+		subpass.draw(command_buffer);
+	}
+
+	// Draws recorded after the subpass, such as the GUI, shade every pixel
+	command_buffer.set_fragment_shading_rate_state({});
+
+	if (scoped)
+	{
+		command_buffer.pop_gpu_scope();
+	}
+}
+
+bool RenderPipeline::supports_dynamic_rendering() const
+{
+	for (auto &subpass : subpasses)
+	{
+		if (!subpass->get_input_attachments().empty() ||
+		    !subpass->get_color_resolve_attachments().empty() ||
+		    subpass->get_depth_stencil_resolve_attachment() != VK_ATTACHMENT_UNUSED ||
+		    subpass->get_view_mask() != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void RenderPipeline::set_dynamic_rendering(bool enable)
+{
+#ifdef VK_KHR_dynamic_rendering
+	if (enable && !subpasses.empty() && !subpasses[0]->get_render_context().get_device().is_enabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		LOGW("Dynamic rendering is not supported by the device, recording the render pipeline with a render pass");
+		return;
+	}
+
+	dynamic_rendering = enable;
+#else
+	if (enable)
+	{
+		LOGW("Dynamic rendering is not available in the Vulkan headers, recording the render pipeline with a render pass");
+	}
+#endif
+}
+
+bool RenderPipeline::is_using_dynamic_rendering() const
+{
+	return dynamic_rendering;
+}
+
+void RenderPipeline::set_render_area(const VkExtent2D &area)
+{
+	render_area = area;
+}
+
+VkExtent2D RenderPipeline::get_render_area(const RenderTarget &render_target) const
+{
+	auto &extent = render_target.get_extent();
+
+	if (render_area.width == 0 || render_area.height == 0)
+	{
+		return extent;
+	}
+
+	return {std::min(render_area.width, extent.width), std::min(render_area.height, extent.height)};
+}
+
+void RenderPipeline::draw_static_content(CommandBuffer &command_buffer, RenderTarget &render_target, Subpass &subpass)
+{
+	auto &render_context = subpass.get_render_context();
+	auto &render_frame   = render_context.get_active_frame();
+
+	size_t key = 0;
+	hash_combine(key, &render_target);
+	hash_combine(key, subpass.get_content_revision());
+	hash_combine(key, std::hash<FragmentShadingRateState>{}(subpass.get_fragment_shading_rate_state()));
+
+	auto bundle = render_frame.find_bundle(subpass, key);
+
+	if (!bundle)
+	{
+		const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+		bundle = &render_frame.request_bundle(subpass, key, queue);
+
+		// Not a one time submit, the bundle is executed again in the next uses of the frame
+		bundle->begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &command_buffer);
+
+		auto extent = subpass.get_render_area();
+
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(extent.width);
+		viewport.height   = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		bundle->set_viewport(0, {viewport});
+
+		VkRect2D scissor{};
+		scissor.extent = extent;
+		bundle->set_scissor(0, {scissor});
+
+		bundle->set_fragment_shading_rate_state(subpass.get_fragment_shading_rate_state());
+
+		{
+			VKB_PROFILE_ZONE("Subpass::draw");
+
+			subpass.draw(*bundle);
+		}
+
+		bundle->end();
+	}
+
+	command_buffer.execute_commands(*bundle);
+}
+
 std::unique_ptr<Subpass> &RenderPipeline::get_active_subpass()
 {
 	return subpasses[active_subpass_index];
@@ -66,6 +66,27 @@ class RenderPipeline
 	 */
 	void set_load_store(const std::vector<LoadStoreInfo> &load_store);
 
+	/**
+	 * @brief Records the render passes with the load store operations inferred from the attachment usage
+	 *        of the subpasses, instead of the ones set. Off by default: the inference only sees this
+	 *        pipeline, so it cannot know that an earlier pipeline drew to an attachment read back here
+	 *        only through blending or depth testing.
+	 */
+	void set_load_store_inference(bool enable);
+
+	bool is_using_load_store_inference() const;
+
+	/**
+	 * @brief Infers the load store operations of the attachments of a render target
+	 *
+	 *        Attachments read as input attachments before any subpass writes them are loaded,
+	 *        the other ones are cleared. They are stored if they may be used after the render pass:
+	 *        images owned elsewhere, such as the swapchain images, and images that can be sampled,
+	 *        copied from or used as storage, unless they are transient. Attachments the subpasses
+	 *        do not use are preserved if they are stored, else neither loaded nor stored.
+	 */
+	std::vector<LoadStoreInfo> infer_load_store(const RenderTarget &render_target) const;
+
 	/**
 	 * @return Clear values
 	 */
@@ -84,6 +105,11 @@ class RenderPipeline
 
 	std::vector<std::unique_ptr<Subpass>> &get_subpasses();
 
+	/**
+	 * @brief Reloads the shaders of the subpasses, including the ones added later, when their files change
+	 */
+	void set_shader_watcher(ShaderWatcher *watcher);
+
 	/**
 	 * @brief Record draw commands for each Subpass
 	 */
@@ -95,15 +121,82 @@ class RenderPipeline
 	 */
 	std::unique_ptr<Subpass> &get_active_subpass();
 
+	/**
+	 * @brief Records each subpass in its own dynamic rendering scope (VK_KHR_dynamic_rendering),
+	 *        so no render pass nor framebuffer has to be created for the render targets.
+	 *        Off by default: on tile-based GPUs the subpasses of a render pass keep the attachments on chip,
+	 *        while separate scopes store them to memory and load them back.
+	 *        Pipelines with input or resolve attachments keep using a render pass.
+	 */
+	void set_dynamic_rendering(bool enable);
+
+	bool is_using_dynamic_rendering() const;
+
+	/**
+	 * @brief Draws into the top left region of the render targets, clamped to their extent,
+	 *        so the scene can be rendered at a lower resolution without reallocating the attachments.
+	 *        The render pass, the viewport and the scissor cover the region, which later passes must rescale.
+	 * @param render_area Extent of the region, the whole render target when empty
+	 */
+	void set_render_area(const VkExtent2D &render_area);
+
+	/**
+	 * @return The extent of the region drawn in the render target
+	 */
+	VkExtent2D get_render_area(const RenderTarget &render_target) const;
+
   private:
+	/**
+	 * @brief Records the subpasses with dynamic rendering, each in a scope writing its output attachments
+	 */
+	void draw_dynamic_rendering(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents);
+
+	/**
+	 * @brief Records a subpass in the current render pass or rendering scope
+	 */
+	void draw_subpass(CommandBuffer &command_buffer, RenderTarget &render_target, Subpass &subpass, size_t index, VkSubpassContents subpass_contents);
+
+	/**
+	 * @return Whether the subpasses can be recorded without a render pass
+	 */
+	bool supports_dynamic_rendering() const;
+
+	/**
+	 * @brief Logs the attachments whose set load store operations differ from the inferred ones, once
+	 */
+	void report_load_store(const std::vector<LoadStoreInfo> &inferred);
+
+	/**
+	 * @brief Executes the secondary command buffer holding the static content of a subpass,
+	 *        recording it first if the frame has none for the current render target and revision
+	 */
+	void draw_static_content(CommandBuffer &command_buffer, RenderTarget &render_target, Subpass &subpass);
+
 	std::vector<std::unique_ptr<Subpass>> subpasses;
 
+	ShaderWatcher *shader_watcher{nullptr};
+
 	/// Default to two load store
 	std::vector<LoadStoreInfo> load_store = std::vector<LoadStoreInfo>(2);
 
+	/// Inferred from the render target drawn last, if the inference is enabled
+	std::vector<LoadStoreInfo> inferred_load_store;
+
+	bool load_store_inference{false};
+
+	/// Whether the set and inferred load store operations have been compared
+	bool load_store_reported{false};
+
 	/// Default to two clear values
 	std::vector<VkClearValue> clear_value = std::vector<VkClearValue>(2);
 
 	size_t active_subpass_index{0};
+
+	bool dynamic_rendering{false};
+
+	VkExtent2D render_area{0, 0};
+
+	/// Whether the fall back to a render pass has been reported
+	bool dynamic_rendering_fallback_logged{false};
 };
 }        // namespace vkb
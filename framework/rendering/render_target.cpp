@@ -38,8 +38,55 @@ Attachment::Attachment(VkFormat format, VkSampleCountFlagBits samples, VkImageUs
     usage{usage}
 {
 }
+
+std::vector<bool> RenderTarget::find_transient_attachments(const std::vector<std::vector<LoadStoreInfo>> &load_stores)
+{
+	size_t attachment_count = 0;
+	for (auto &load_store : load_stores)
+	{
+		attachment_count = std::max(attachment_count, load_store.size());
+	}
+
+	std::vector<bool> transient(attachment_count, !load_stores.empty());
+
+	for (auto &load_store : load_stores)
+	{
+		for (size_t i = 0; i < attachment_count; ++i)
+		{
+			if (i >= load_store.size() ||
+			    load_store[i].load_op == VK_ATTACHMENT_LOAD_OP_LOAD ||
+			    load_store[i].store_op == VK_ATTACHMENT_STORE_OP_STORE)
+			{
+				transient[i] = false;
+			}
+		}
+	}
+
+	return transient;
+}
+
+core::Image RenderTarget::create_attachment_image(Device &device, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags usage, bool transient)
+{
+	if (!transient)
+	{
+		return core::Image{device, extent, format, usage & ~VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, VMA_MEMORY_USAGE_GPU_ONLY};
+	}
+
+	auto memory_properties = device.get_gpu().get_memory_properties();
+
+	bool has_lazy_memory = false;
+	for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+	{
+		has_lazy_memory |= (memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+	}
+
+	// Lazily allocated memory must be requested explicitly, the other devices still get transient images
+	return core::Image{device, extent, format, usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+	                   has_lazy_memory ? VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED : VMA_MEMORY_USAGE_GPU_ONLY};
+}
+
 const RenderTarget::CreateFunc RenderTarget::DEFAULT_CREATE_FUNC = [](core::Image &&swapchain_image) -> std::unique_ptr<RenderTarget> {
-	VkFormat depth_format = get_suitable_depth_format(swapchain_image.get_device().get_gpu().get_handle());
+	VkFormat depth_format = get_suitable_depth_format(swapchain_image.get_device().get_gpu());
 
 	core::Image depth_image{swapchain_image.get_device(), swapchain_image.get_extent(),
 	                        depth_format,
@@ -65,7 +112,18 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 	auto get_image_extent = [](const core::Image &image) { return VkExtent2D{image.get_extent().width, image.get_extent().height}; };
 
 	// Constructs a set of unique image extens given a vector of images
-	std::transform(this->images.begin(), this->images.end(), std::inserter(unique_extent, unique_extent.end()), get_image_extent);
+	for (auto &image : this->images)
+	{
+#ifdef VK_KHR_fragment_shading_rate
+		// Each texel of a shading rate attachment covers several pixels of the other attachments
+		if (image.get_usage() & VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR)
+		{
+			continue;
+		}
+#endif
+
+		unique_extent.insert(get_image_extent(image));
+	}
 
 	// Allow only one extent size for a render target
 	if (unique_extent.size() != 1)
@@ -82,10 +140,27 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Image type is not 2D"};
 		}
 
-		views.emplace_back(image, VK_IMAGE_VIEW_TYPE_2D);
+		// Layered images are rendered by the views of multiview subpasses
+		views.emplace_back(image, image.get_subresource().arrayLayer > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D);
 
 		attachments.emplace_back(Attachment{image.get_format(), image.get_sample_count(), image.get_usage()});
 	}
+
+	if (device.get_attachment_compression() != core::ImageCompressionPolicy::Default)
+	{
+		auto compression = query_compression();
+
+		for (size_t i = 0; i < compression.size(); ++i)
+		{
+			LOGD("Attachment {} compression flags {:#x}, fixed rate flags {:#x}", i, compression[i].flags, compression[i].fixed_rate_flags);
+		}
+	}
+}
+
+vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images, std::unique_ptr<AttachmentAllocator> &&attachment_allocator) :
+    RenderTarget{std::move(images)}
+{
+	this->attachment_allocator = std::move(attachment_allocator);
 }
 
 const VkExtent2D &RenderTarget::get_extent() const
@@ -128,4 +203,43 @@ void RenderTarget::set_layout(uint32_t attachment, VkImageLayout layout)
 	attachments[attachment].initial_layout = layout;
 }
 
+std::vector<core::ImageCompression> RenderTarget::query_compression() const
+{
+	std::vector<core::ImageCompression> compression;
+
+	for (auto &image : images)
+	{
+		compression.push_back(image.query_compression());
+	}
+
+	return compression;
+}
+
+VkDeviceSize RenderTarget::get_lazily_allocated_size() const
+{
+	VkDeviceSize size{0};
+
+	for (auto &image : images)
+	{
+		// Swapchain images are not allocated by the render target
+		if (image.get_memory() == VK_NULL_HANDLE || image.is_aliased())
+		{
+			continue;
+		}
+
+		VmaAllocationInfo allocation_info{};
+		vmaGetAllocationInfo(device.get_memory_allocator(), image.get_memory(), &allocation_info);
+
+		VkMemoryPropertyFlags memory_flags{0};
+		vmaGetMemoryTypeProperties(device.get_memory_allocator(), allocation_info.memoryType, &memory_flags);
+
+		if (memory_flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+		{
+			size += allocation_info.size;
+		}
+	}
+
+	return size;
+}
+
 }        // namespace vkb
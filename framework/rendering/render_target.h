@@ -21,6 +21,7 @@
 #include "common/vk_common.h"
 #include "core/image.h"
 #include "core/image_view.h"
+#include "rendering/attachment_allocator.h"
 
 namespace vkb
 {
@@ -63,6 +64,13 @@ class RenderTarget
 
 	RenderTarget(std::vector<core::Image> &&images);
 
+	/**
+	 * @brief Creates a render target whose images alias memory owned by the allocator
+	 * @param images Images created by the allocator, optionally along with external images
+	 * @param attachment_allocator The allocator owning the memory, destroyed after the images
+	 */
+	RenderTarget(std::vector<core::Image> &&images, std::unique_ptr<AttachmentAllocator> &&attachment_allocator);
+
 	RenderTarget(const RenderTarget &) = delete;
 
 	RenderTarget(RenderTarget &&) = delete;
@@ -71,6 +79,22 @@ class RenderTarget
 
 	RenderTarget &operator=(RenderTarget &&other) noexcept = delete;
 
+	/**
+	 * @brief Finds the attachments whose contents never outlive a render pass
+	 *        They are neither loaded nor stored by any of the render passes drawing to the target,
+	 *        so their images can be transient and lazily allocated.
+	 * @param load_stores The load store operations of each render pass using the target
+	 * @return Whether each attachment can be transient, attachments missing from a render pass cannot
+	 */
+	static std::vector<bool> find_transient_attachments(const std::vector<std::vector<LoadStoreInfo>> &load_stores);
+
+	/**
+	 * @brief Creates the image of an attachment
+	 *        Transient images are lazily allocated when the device has such memory.
+	 * @param transient Whether the attachment is transient, see find_transient_attachments
+	 */
+	static core::Image create_attachment_image(Device &device, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags usage, bool transient);
+
 	const VkExtent2D &get_extent() const;
 
 	const std::vector<core::ImageView> &get_views() const;
@@ -97,11 +121,25 @@ class RenderTarget
 
 	void set_layout(uint32_t attachment, VkImageLayout layout);
 
+	/**
+	 * @return The size of the images in lazily allocated memory, which tile-based GPUs may never back
+	 */
+	VkDeviceSize get_lazily_allocated_size() const;
+
+	/**
+	 * @return The compression the implementation selected for the image of each attachment,
+	 *         see Device::set_attachment_compression
+	 */
+	std::vector<core::ImageCompression> query_compression() const;
+
   private:
 	Device &device;
 
 	VkExtent2D extent{};
 
+	/// Owns the memory of aliased images, so it is declared before them
+	std::unique_ptr<AttachmentAllocator> attachment_allocator;
+
 	std::vector<core::Image> images;
 
 	std::vector<core::ImageView> views;
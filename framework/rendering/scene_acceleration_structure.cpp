@@ -0,0 +1,150 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/scene_acceleration_structure.h"
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+uint64_t get_buffer_device_address(Device &device, VkBuffer buffer)
+{
+	VkBufferDeviceAddressInfoKHR buffer_device_address_info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+	buffer_device_address_info.buffer = buffer;
+	return vkGetBufferDeviceAddressKHR(device.get_handle(), &buffer_device_address_info);
+}
+}        // namespace
+
+SceneAccelerationStructure::SceneAccelerationStructure(Device &device, sg::Scene &scene, VkPipelineStageFlags trace_stages) :
+    device{device},
+    builder{device}
+{
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		core::BottomLevelGeometry geometry;
+
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			add_sub_mesh(geometry, *sub_mesh);
+		}
+
+		if (geometry.geometries.empty() || mesh->get_nodes().empty())
+		{
+			continue;
+		}
+
+		mesh_bottom_levels.emplace_back(mesh, builder.add_bottom_level(std::move(geometry)));
+	}
+
+	if (mesh_bottom_levels.empty())
+	{
+		throw std::runtime_error("The scene has no geometry to build acceleration structures from");
+	}
+
+	auto &queue = device.get_suitable_graphics_queue();
+
+	builder.build(queue.get_handle());
+
+	std::vector<core::TopLevelAccelerationStructure::Instance> instances;
+
+	for (auto &mesh_bottom_level : mesh_bottom_levels)
+	{
+		for (auto node : mesh_bottom_level.first->get_nodes())
+		{
+			core::TopLevelAccelerationStructure::Instance instance;
+			instance.bottom_level = &builder.get_bottom_level(mesh_bottom_level.second);
+			instance.node         = node;
+
+			instances.push_back(instance);
+		}
+	}
+
+	top_level = std::make_unique<core::TopLevelAccelerationStructure>(device, std::move(instances), true, trace_stages);
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	top_level->build(command_buffer);
+	device.flush_command_buffer(command_buffer, queue.get_handle());
+
+	LOGI("Scene acceleration structures of {} meshes and {} instances, {} KiB compacted from {} KiB",
+	     mesh_bottom_levels.size(), top_level->get_instances().size(),
+	     builder.get_compacted_size() / 1024, builder.get_uncompacted_size() / 1024);
+}
+
+bool SceneAccelerationStructure::is_supported(Device &device)
+{
+	return device.is_enabled(VK_KHR_RAY_TRACING_EXTENSION_NAME) && device.is_enabled(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+}
+
+void SceneAccelerationStructure::refit()
+{
+	auto &queue = device.get_suitable_graphics_queue();
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	top_level->update(command_buffer);
+	device.flush_command_buffer(command_buffer, queue.get_handle());
+}
+
+core::AccelerationStructure &SceneAccelerationStructure::get_top_level()
+{
+	return top_level->get_structure();
+}
+
+bool SceneAccelerationStructure::add_sub_mesh(core::BottomLevelGeometry &geometry, const sg::SubMesh &sub_mesh)
+{
+	sg::VertexAttribute position;
+	const core::Buffer *vertex_buffer{nullptr};
+	VkDeviceSize        vertex_offset{0};
+
+	if (!sub_mesh.has_geometry() ||
+	    !sub_mesh.get_attribute("position", position) ||
+	    position.format != VK_FORMAT_R32G32B32_SFLOAT ||
+	    !sub_mesh.get_vertex_buffer("position", vertex_buffer, vertex_offset))
+	{
+		return false;
+	}
+
+	vertex_offset += position.offset;
+
+	uint64_t vertex_address = get_buffer_device_address(device, vertex_buffer->get_handle()) + vertex_offset;
+
+	if (sub_mesh.vertex_indices == 0)
+	{
+		geometry.add_triangles(vertex_address, position.stride, sub_mesh.vertices_count,
+		                       0, VK_INDEX_TYPE_NONE_KHR, sub_mesh.vertices_count / 3);
+
+		return true;
+	}
+
+	// Indexed submeshes don't record their vertex count, the rest of the buffer bounds it
+	uint32_t max_vertex_count = to_u32((vertex_buffer->get_size() - vertex_offset) / position.stride);
+
+	auto     index_size    = sub_mesh.index_type == VK_INDEX_TYPE_UINT32 ? 4 : 2;
+	uint64_t index_address = get_buffer_device_address(device, sub_mesh.get_index_buffer().get_handle()) +
+	                         sub_mesh.index_offset + sub_mesh.first_index * index_size;
+
+	geometry.add_triangles(vertex_address, position.stride, max_vertex_count,
+	                       index_address, sub_mesh.index_type, sub_mesh.vertex_indices / 3);
+
+	return true;
+}
+}        // namespace vkb
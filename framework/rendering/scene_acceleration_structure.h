@@ -0,0 +1,97 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/acceleration_structure.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Mesh;
+class Scene;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Ray tracing acceleration structures of the meshes of a scene
+ *
+ * Each mesh gets a bottom level structure built from the vertex and index buffers of its submeshes, which
+ * are referenced in place, and each node of a mesh an instance of it in the top level structure. The
+ * buffers need device addresses, which the glTF loader gives them when VK_KHR_buffer_device_address and
+ * VK_KHR_ray_tracing are enabled. All the geometry is traced as opaque. Submeshes which are still streamed,
+ * or whose positions are not R32G32B32_SFLOAT such as quantized ones, are left out.
+ */
+class SceneAccelerationStructure
+{
+  public:
+	/**
+	 * @brief Builds the structures, waiting for the device to finish
+	 * @param device A valid Vulkan device
+	 * @param scene The scene whose meshes are traced
+	 * @param trace_stages Pipeline stages tracing rays against the top level structure
+	 */
+	SceneAccelerationStructure(Device &device, sg::Scene &scene, VkPipelineStageFlags trace_stages);
+
+	SceneAccelerationStructure(const SceneAccelerationStructure &) = delete;
+
+	SceneAccelerationStructure(SceneAccelerationStructure &&) = delete;
+
+	~SceneAccelerationStructure() = default;
+
+	SceneAccelerationStructure &operator=(const SceneAccelerationStructure &) = delete;
+
+	SceneAccelerationStructure &operator=(SceneAccelerationStructure &&) = delete;
+
+	/**
+	 * @return Whether the extensions needed to build the structures of a scene are enabled
+	 */
+	static bool is_supported(Device &device);
+
+	/**
+	 * @brief Refits the top level structure to the current transforms of the nodes, waiting for the device to finish
+	 *        The structure must not be in use by a pending submission.
+	 */
+	void refit();
+
+	core::AccelerationStructure &get_top_level();
+
+  private:
+	/**
+	 * @return Whether the submesh could be added to the geometry
+	 */
+	bool add_sub_mesh(core::BottomLevelGeometry &geometry, const sg::SubMesh &sub_mesh);
+
+	Device &device;
+
+	core::AccelerationStructureBuilder builder;
+
+	/// Meshes with traceable geometry, with the index of their bottom level structure in the builder
+	std::vector<std::pair<sg::Mesh *, uint32_t>> mesh_bottom_levels;
+
+	std::unique_ptr<core::TopLevelAccelerationStructure> top_level;
+};
+}        // namespace vkb
@@ -0,0 +1,215 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/shading_rate_generator.h"
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t WORKGROUP_SIZE = 8;
+
+/**
+ * @brief Push constants of the shading rate shader
+ */
+struct ShadingRatePushConstants
+{
+	glm::uvec2 extent;
+
+	glm::vec2 focus_center;
+
+	float aspect_ratio;
+
+	float inner_radius;
+
+	float outer_radius;
+
+	float luminance_threshold;
+
+	uint32_t max_rate_log2;
+};
+}        // namespace
+
+ShadingRateGenerator::ShadingRateGenerator(RenderContext &render_context) :
+    render_context{render_context},
+    shader_source{"shading_rate/shading_rate.comp"}
+{
+	luminance_variant.add_define("LUMINANCE");
+
+	auto &device = render_context.get_device();
+
+#ifdef VK_KHR_fragment_shading_rate
+	supported = device.is_enabled(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+
+	if (supported)
+	{
+		VkPhysicalDeviceFragmentShadingRatePropertiesKHR shading_rate_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_PROPERTIES_KHR};
+
+		VkPhysicalDeviceProperties2KHR properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR};
+		properties.pNext = &shading_rate_properties;
+		vkGetPhysicalDeviceProperties2KHR(device.get_gpu().get_handle(), &properties);
+
+		// The finest texel size follows the content closest
+		texel_size = shading_rate_properties.minFragmentShadingRateAttachmentTexelSize;
+
+		uint32_t rate_count = 0;
+		vkGetPhysicalDeviceFragmentShadingRatesKHR(device.get_gpu().get_handle(), &rate_count, nullptr);
+
+		std::vector<VkPhysicalDeviceFragmentShadingRateKHR> rates(rate_count, {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_KHR});
+		vkGetPhysicalDeviceFragmentShadingRatesKHR(device.get_gpu().get_handle(), &rate_count, rates.data());
+
+		// Square fragments up to 2x2 are always supported, 4x4 is optional
+		for (auto &rate : rates)
+		{
+			if (rate.fragmentSize.width == 4 && rate.fragmentSize.height == 4 && (rate.sampleCounts & VK_SAMPLE_COUNT_1_BIT))
+			{
+				max_rate_log2 = 2;
+			}
+		}
+
+		LOGI("Shading rate attachment texel size {}x{}, coarsest rate {}x{}", texel_size.width, texel_size.height, 1u << max_rate_log2, 1u << max_rate_log2);
+	}
+#endif
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	color_sampler              = &device.get_resource_cache().request_sampler(sampler_info);
+}
+
+bool ShadingRateGenerator::is_supported() const
+{
+	return supported;
+}
+
+const VkExtent2D &ShadingRateGenerator::get_texel_size() const
+{
+	return texel_size;
+}
+
+core::Image ShadingRateGenerator::create_attachment(const VkExtent2D &extent) const
+{
+	if (!supported)
+	{
+		throw std::runtime_error("Shading rate attachments are not supported by the device");
+	}
+
+#ifdef VK_KHR_fragment_shading_rate
+	VkExtent3D attachment_extent{(extent.width + texel_size.width - 1) / texel_size.width,
+	                             (extent.height + texel_size.height - 1) / texel_size.height,
+	                             1};
+
+	return core::Image{render_context.get_device(), attachment_extent, VK_FORMAT_R8_UINT,
+	                   VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR, VMA_MEMORY_USAGE_GPU_ONLY};
+#else
+	throw std::runtime_error("Shading rate attachments are not available in the Vulkan headers");
+#endif
+}
+
+void ShadingRateGenerator::set_mode(Mode new_mode)
+{
+	mode = new_mode;
+}
+
+ShadingRateGenerator::Mode ShadingRateGenerator::get_mode() const
+{
+	return mode;
+}
+
+void ShadingRateGenerator::set_foveation(const glm::vec2 &center, float inner, float outer)
+{
+	focus_center = center;
+	inner_radius = inner;
+	outer_radius = std::max(inner, outer);
+}
+
+void ShadingRateGenerator::set_luminance_threshold(float threshold)
+{
+	luminance_threshold = threshold;
+}
+
+void ShadingRateGenerator::generate(CommandBuffer &command_buffer, const core::ImageView &attachment, const core::ImageView *previous_color)
+{
+#ifdef VK_KHR_fragment_shading_rate
+	auto &extent = attachment.get_image().get_extent();
+
+	{
+		// The previous render pass read the rates
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(attachment, memory_barrier);
+	}
+
+	bool luminance = mode == Mode::Luminance && previous_color;
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader_source, luminance ? luminance_variant : ShaderVariant{});
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_input(attachment, 0, 0, 0);
+
+	if (luminance)
+	{
+		command_buffer.bind_image(*previous_color, *color_sampler, 0, 1, 0);
+	}
+
+	ShadingRatePushConstants push_constants{};
+	push_constants.extent              = glm::uvec2(extent.width, extent.height);
+	push_constants.focus_center        = focus_center;
+	push_constants.aspect_ratio        = static_cast<float>(extent.width * texel_size.width) / static_cast<float>(extent.height * texel_size.height);
+	push_constants.inner_radius        = inner_radius;
+	push_constants.outer_radius        = outer_radius;
+	push_constants.luminance_threshold = luminance_threshold;
+	push_constants.max_rate_log2       = max_rate_log2;
+
+	command_buffer.push_constants(push_constants);
+
+	command_buffer.dispatch((extent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (extent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+		memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+
+		command_buffer.image_memory_barrier(attachment, memory_barrier);
+	}
+#endif
+}
+}        // namespace vkb
@@ -0,0 +1,139 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Writes the shading rate attachment read by subpasses with VK_KHR_fragment_shading_rate
+ *
+ * Each texel of the attachment sets the fragment size of the pixels it covers. A compute shader either
+ * coarsens the rate away from a focus point (fixed foveation), or coarsens the tiles where the color of
+ * the previous frame has little contrast, which are unlikely to show the lower rate.
+ *
+ * The attachment is an R8_UINT image of the render target, created with create_attachment(), and given
+ * to the subpasses with Subpass::set_shading_rate_attachment() and get_texel_size(). generate() must be
+ * recorded before the render pass reading it, as it leaves the attachment in the layout the render pass
+ * expects. Comparing the GPU scopes of the subpasses with and without the attachment shows the savings.
+ */
+class ShadingRateGenerator
+{
+  public:
+	enum class Mode
+	{
+		Foveation,
+		Luminance
+	};
+
+	ShadingRateGenerator(RenderContext &render_context);
+
+	ShadingRateGenerator(const ShadingRateGenerator &) = delete;
+
+	ShadingRateGenerator(ShadingRateGenerator &&) = delete;
+
+	~ShadingRateGenerator() = default;
+
+	ShadingRateGenerator &operator=(const ShadingRateGenerator &) = delete;
+
+	ShadingRateGenerator &operator=(ShadingRateGenerator &&) = delete;
+
+	/**
+	 * @return Whether the device enabled the shading rate attachments
+	 */
+	bool is_supported() const;
+
+	/**
+	 * @return Pixels covered by each texel of the attachment
+	 */
+	const VkExtent2D &get_texel_size() const;
+
+	/**
+	 * @brief Creates a shading rate attachment for a render target
+	 * @param extent Extent of the other attachments of the render target
+	 */
+	core::Image create_attachment(const VkExtent2D &extent) const;
+
+	void set_mode(Mode mode);
+
+	Mode get_mode() const;
+
+	/**
+	 * @brief Sets the foveation pattern
+	 * @param center Focus point, in normalized coordinates of the render target
+	 * @param inner_radius Radius shaded at full rate, relative to the render target height
+	 * @param outer_radius Radius shaded at half rate, the rest using the coarsest rate
+	 */
+	void set_foveation(const glm::vec2 &center, float inner_radius, float outer_radius);
+
+	/**
+	 * @param threshold Luminance contrast of a tile below which it is shaded at half rate,
+	 *                  and at the coarsest rate below half of it
+	 */
+	void set_luminance_threshold(float threshold);
+
+	/**
+	 * @brief Writes the rates into the attachment
+	 * @param attachment View of the attachment created with create_attachment()
+	 * @param previous_color Color of the previous frame in the shader read only layout, used in luminance mode.
+	 *                       Without it the rates follow the foveation pattern.
+	 */
+	void generate(CommandBuffer &command_buffer, const core::ImageView &attachment, const core::ImageView *previous_color = nullptr);
+
+  private:
+	RenderContext &render_context;
+
+	bool supported{false};
+
+	VkExtent2D texel_size{16, 16};
+
+	/// Log2 of the coarsest supported fragment size along each axis
+	uint32_t max_rate_log2{1};
+
+	Mode mode{Mode::Foveation};
+
+	glm::vec2 focus_center{0.5f, 0.5f};
+
+	float inner_radius{0.25f};
+
+	float outer_radius{0.5f};
+
+	float luminance_threshold{0.05f};
+
+	ShaderSource shader_source;
+
+	ShaderVariant luminance_variant;
+
+	const core::Sampler *color_sampler{nullptr};
+};
+}        // namespace vkb
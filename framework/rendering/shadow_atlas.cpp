@@ -0,0 +1,757 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/shadow_atlas.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/aabb.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Layout of a tile in the ShadowUniform of the shaders
+ */
+struct alignas(16) ShadowTileUniform
+{
+	glm::mat4 view_proj;
+
+	/// Offset and size of the tile in the UVs of the atlas
+	glm::vec4 rect;
+};
+
+/**
+ * @brief Layout of the ShadowUniform of the SHADOWS variant of the lighting shaders
+ */
+struct alignas(16) ShadowUniform
+{
+	glm::mat4 view;
+
+	glm::vec4 cascade_splits;
+
+	glm::vec2 texel_size;
+
+	float normal_offset;
+
+	/// First tile and tile count of each light
+	alignas(16) glm::uvec4 light_tiles[ShadowAtlas::MAX_LIGHT_COUNT];
+
+	ShadowTileUniform tiles[ShadowAtlas::MAX_TILE_COUNT];
+};
+
+/// Directions of the cube faces of point lights, in the order the shaders select them
+const std::array<glm::vec3, 6> CUBE_FACE_DIRECTIONS = {glm::vec3{1.0f, 0.0f, 0.0f}, glm::vec3{-1.0f, 0.0f, 0.0f},
+                                                       glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec3{0.0f, -1.0f, 0.0f},
+                                                       glm::vec3{0.0f, 0.0f, 1.0f}, glm::vec3{0.0f, 0.0f, -1.0f}};
+
+/**
+ * @return An up vector which is not parallel to a direction
+ */
+glm::vec3 get_up_vector(const glm::vec3 &direction)
+{
+	return std::abs(direction.y) > 0.99f ? glm::vec3{0.0f, 0.0f, 1.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+}
+
+/**
+ * @brief Fits an orthographic projection along a light direction to a slice of the camera view
+ *        The projection bounds a sphere around the slice, snapped to texels, and extends towards
+ *        the light to the bounds of the casters.
+ */
+glm::mat4 fit_cascade(sg::PerspectiveCamera &camera, float near_depth, float far_depth, const glm::vec3 &direction,
+                      const glm::vec3 &caster_min, const glm::vec3 &caster_max, uint32_t tile_size)
+{
+	auto inv_view = glm::inverse(camera.get_view());
+
+	float tan_y = std::tan(camera.get_field_of_view() * 0.5f);
+	float tan_x = tan_y * camera.get_aspect_ratio();
+
+	std::array<glm::vec3, 8> corners;
+	glm::vec3                center{0.0f};
+
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		float depth = i < 4 ? near_depth : far_depth;
+		float x     = (i & 1 ? 1.0f : -1.0f) * depth * tan_x;
+		float y     = (i & 2 ? 1.0f : -1.0f) * depth * tan_y;
+
+		corners[i] = glm::vec3(inv_view * glm::vec4{x, y, -depth, 1.0f});
+		center += corners[i] / 8.0f;
+	}
+
+	float radius = 0.0f;
+	for (auto &corner : corners)
+	{
+		radius = std::max(radius, glm::length(corner - center));
+	}
+
+	// Rounded, so the extent of the cascade does not change with the precision of the corners
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	auto light_view = glm::lookAt(glm::vec3{0.0f}, direction, get_up_vector(direction));
+
+	// Moving by whole texels keeps the rasterization of the casters stable as the camera moves
+	auto  light_center = glm::vec3(light_view * glm::vec4{center, 1.0f});
+	float texel        = 2.0f * radius / static_cast<float>(tile_size);
+	light_center.x     = std::floor(light_center.x / texel) * texel;
+	light_center.y     = std::floor(light_center.y / texel) * texel;
+
+	// The casters between the light and the slice are looking at it along -z
+	float max_z = light_center.z + radius;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		glm::vec3 corner{i & 1 ? caster_max.x : caster_min.x, i & 2 ? caster_max.y : caster_min.y, i & 4 ? caster_max.z : caster_min.z};
+		max_z = std::max(max_z, (light_view * glm::vec4{corner, 1.0f}).z);
+	}
+
+	// Reversed depth, as the scene, the planes are flipped
+	auto projection = glm::ortho(light_center.x - radius, light_center.x + radius, light_center.y - radius, light_center.y + radius,
+	                             radius - light_center.z, -max_z);
+
+	return projection * light_view;
+}
+}        // namespace
+
+ShadowAtlas::ShadowAtlas(RenderContext &render_context, sg::Scene &scene, uint32_t atlas_size, uint32_t tile_size) :
+    render_context{render_context},
+    scene{scene},
+    atlas_size{atlas_size},
+    tile_size{tile_size},
+    tiles_per_row{tile_size > 0 ? atlas_size / tile_size : 0},
+    shader_source{"shadows/shadow.vert"}
+{
+	if (tiles_per_row == 0 || tiles_per_row * tiles_per_row > MAX_TILE_COUNT)
+	{
+		throw std::runtime_error("A shadow atlas holds 1 to " + std::to_string(MAX_TILE_COUNT) + " tiles, not " + std::to_string(tiles_per_row * tiles_per_row));
+	}
+
+	tiles.resize(tiles_per_row * tiles_per_row);
+
+	auto &device = render_context.get_device();
+
+	// The atlas is sampled, so it has no stencil aspect
+	depth_format = get_suitable_depth_format(device.get_gpu(), true);
+
+	auto create_atlas = [&](VkImageUsageFlags usage) {
+		std::vector<core::Image> images;
+		images.emplace_back(device, VkExtent3D{atlas_size, atlas_size, 1}, depth_format,
+		                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | usage, VMA_MEMORY_USAGE_GPU_ONLY);
+
+		auto render_target = std::make_unique<RenderTarget>(std::move(images));
+
+		// Render passes loading the tiles find them in the attachment layout
+		render_target->set_layout(0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+		return render_target;
+	};
+
+	atlas        = create_atlas(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+	static_atlas = create_atlas(VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(device.get_gpu().get_handle(), depth_format, &format_properties);
+
+	// Linear filtering of the comparisons smooths the edges, where the format supports it
+	bool linear = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	sampler_info.minFilter     = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.compareEnable = VK_TRUE;
+	sampler_info.compareOp     = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	shadow_sampler             = &device.get_resource_cache().request_sampler(sampler_info);
+
+	LOGI("Shadow atlas of {} tiles of {}x{}", tiles.size(), tile_size, tile_size);
+}
+
+void ShadowAtlas::set_caching(bool enabled)
+{
+	if (enabled && !caching)
+	{
+		// The static casters moved freely while the tiles were not cached
+		for (auto &tile : tiles)
+		{
+			tile.cached = false;
+		}
+	}
+
+	caching = enabled;
+}
+
+bool ShadowAtlas::is_using_caching() const
+{
+	return caching;
+}
+
+void ShadowAtlas::set_cascades(float distance, float split_lambda)
+{
+	cascade_distance     = distance;
+	cascade_split_lambda = glm::clamp(split_lambda, 0.0f, 1.0f);
+}
+
+void ShadowAtlas::set_normal_offset(float offset)
+{
+	normal_offset = offset;
+}
+
+std::vector<std::string> ShadowAtlas::get_shader_definitions()
+{
+	return {"SHADOWS",
+	        "SHADOW_TILE_COUNT " + std::to_string(MAX_TILE_COUNT),
+	        "SHADOW_LIGHT_COUNT " + std::to_string(MAX_LIGHT_COUNT)};
+}
+
+uint32_t ShadowAtlas::get_rendered_tile_count() const
+{
+	return rendered_tile_count;
+}
+
+uint32_t ShadowAtlas::get_used_tile_count() const
+{
+	return used_tile_count;
+}
+
+void ShadowAtlas::update_casters()
+{
+	++update_count;
+
+	if (scene.get_revision() != scene_revision)
+	{
+		// Nodes may have been added or removed, which the cached tiles do not know about
+		for (auto &tile : tiles)
+		{
+			tile.cached = false;
+		}
+
+		node_states.clear();
+
+		scene_revision = scene.get_revision();
+	}
+
+	casters.clear();
+
+	caster_min = glm::vec3{std::numeric_limits<float>::max()};
+	caster_max = glm::vec3{std::numeric_limits<float>::lowest()};
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			auto &transform = node->get_transform();
+			auto  model     = transform.get_world_matrix();
+			auto &state     = node_states[node];
+
+			if (model != transform.get_previous_world_matrix())
+			{
+				state.last_motion = update_count;
+			}
+
+			bool dynamic = state.last_motion != 0 && update_count - state.last_motion < STATIC_FRAME_COUNT;
+
+			sg::AABB bounds{mesh->get_bounds().get_min(), mesh->get_bounds().get_max()};
+			bounds.transform(model);
+
+			glm::vec3 center = bounds.get_center();
+			float     radius = glm::length(bounds.get_scale()) * 0.5f;
+
+			if (dynamic != state.dynamic)
+			{
+				// A caster turning dynamic is still in the static atlas where it was, one turning static is not in it yet
+				auto previous_model = transform.get_previous_world_matrix();
+
+				sg::AABB previous_bounds{mesh->get_bounds().get_min(), mesh->get_bounds().get_max()};
+				previous_bounds.transform(previous_model);
+
+				invalidate_tiles(previous_bounds.get_center(), glm::length(previous_bounds.get_scale()) * 0.5f);
+				invalidate_tiles(center, radius);
+
+				state.dynamic = dynamic;
+			}
+
+			caster_min = glm::min(caster_min, bounds.get_min());
+			caster_max = glm::max(caster_max, bounds.get_max());
+
+			for (auto sub_mesh : mesh->get_submeshes())
+			{
+				if (sub_mesh->get_material()->alpha_mode != sg::AlphaMode::Blend)
+				{
+					casters.push_back({node, sub_mesh, model, center, radius, dynamic});
+				}
+			}
+		}
+	}
+}
+
+void ShadowAtlas::invalidate_tiles(const glm::vec3 &center, float radius)
+{
+	for (auto &tile : tiles)
+	{
+		if (tile.cached && tile.frustum.check_sphere(center, radius))
+		{
+			tile.cached = false;
+		}
+	}
+}
+
+bool ShadowAtlas::assign_tiles(const sg::Light &light, sg::Camera &camera, uint32_t &next_tile)
+{
+	auto &light_node = *const_cast<sg::Light &>(light).get_node();
+	auto &properties = const_cast<sg::Light &>(light).get_properties();
+	auto  light_type = const_cast<sg::Light &>(light).get_light_type();
+
+	// Same position and direction as the light uniform
+	auto &transform = light_node.get_transform();
+	auto  position  = transform.get_translation();
+	auto  direction = glm::normalize(transform.get_rotation() * properties.direction);
+
+	float range = properties.range > 0.0f ? properties.range : cascade_distance;
+
+	std::vector<glm::mat4> view_projs;
+
+	switch (light_type)
+	{
+		case sg::LightType::Directional:
+		{
+			auto perspective_camera = dynamic_cast<sg::PerspectiveCamera *>(&camera);
+			if (!perspective_camera)
+			{
+				return false;
+			}
+
+			float near_depth = perspective_camera->get_near_plane();
+			for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+			{
+				view_projs.push_back(fit_cascade(*perspective_camera, near_depth, cascade_splits[i], direction, caster_min, caster_max, tile_size));
+				near_depth = cascade_splits[i];
+			}
+			break;
+		}
+		case sg::LightType::Point:
+		{
+			// Reversed depth, as the scene, the planes are flipped
+			auto projection = glm::perspective(glm::radians(90.0f), 1.0f, range, range * 0.01f);
+
+			for (auto &face_direction : CUBE_FACE_DIRECTIONS)
+			{
+				view_projs.push_back(projection * glm::lookAt(position, position + face_direction, get_up_vector(face_direction)));
+			}
+			break;
+		}
+		case sg::LightType::Spot:
+		{
+			float cone_angle = properties.outer_cone_angle > 0.0f ? std::min(properties.outer_cone_angle, glm::radians(85.0f)) : glm::radians(45.0f);
+
+			auto projection = glm::perspective(2.0f * cone_angle, 1.0f, range, range * 0.01f);
+
+			view_projs.push_back(projection * glm::lookAt(position, position + direction, get_up_vector(direction)));
+			break;
+		}
+	}
+
+	auto tile_count = to_u32(view_projs.size());
+
+	if (next_tile + tile_count > tiles.size())
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < tile_count; ++i)
+	{
+		auto &tile = tiles[next_tile + i];
+
+		// The static casters are rendered again for another light or a moved projection
+		if (tile.light != &light || tile.view_proj != view_projs[i])
+		{
+			tile.light     = &light;
+			tile.view_proj = view_projs[i];
+			tile.frustum.update(view_projs[i]);
+			tile.cached = false;
+		}
+	}
+
+	light_tiles[&light] = {next_tile, tile_count};
+
+	next_tile += tile_count;
+
+	return true;
+}
+
+VkRect2D ShadowAtlas::get_tile_rect(uint32_t tile) const
+{
+	VkRect2D rect{};
+	rect.offset.x      = static_cast<int32_t>((tile % tiles_per_row) * tile_size);
+	rect.offset.y      = static_cast<int32_t>((tile / tiles_per_row) * tile_size);
+	rect.extent.width  = tile_size;
+	rect.extent.height = tile_size;
+	return rect;
+}
+
+void ShadowAtlas::update(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights, sg::Camera &camera)
+{
+	update_casters();
+
+	camera_view = camera.get_view();
+
+	if (auto perspective_camera = dynamic_cast<sg::PerspectiveCamera *>(&camera))
+	{
+		float near_depth = perspective_camera->get_near_plane();
+		float far_depth  = std::min(perspective_camera->get_far_plane(), cascade_distance);
+
+		// Logarithmic splits keep the texel density of the cascades even, uniform splits give more to the distance
+		for (uint32_t i = 0; i < CASCADE_COUNT; ++i)
+		{
+			float fraction      = static_cast<float>(i + 1) / static_cast<float>(CASCADE_COUNT);
+			float log_split     = near_depth * std::pow(far_depth / near_depth, fraction);
+			float uniform_split = near_depth + (far_depth - near_depth) * fraction;
+
+			cascade_splits[i] = glm::mix(uniform_split, log_split, cascade_split_lambda);
+		}
+	}
+
+	light_tiles.clear();
+
+	uint32_t next_tile = 0;
+
+	for (auto light : lights)
+	{
+		assign_tiles(*light, camera, next_tile);
+	}
+
+	// The tiles left are free, the next light assigned to them renders them again
+	for (uint32_t i = next_tile; i < tiles.size(); ++i)
+	{
+		tiles[i].light = nullptr;
+	}
+
+	used_tile_count     = next_tile;
+	rendered_tile_count = 0;
+
+	auto &atlas_view        = atlas->get_views().at(0);
+	auto &static_atlas_view = static_atlas->get_views().at(0);
+
+	if (!caching)
+	{
+		{
+			// The last frame sampled the atlas
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			memory_barrier.src_access_mask = 0;
+			memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+			command_buffer.image_memory_barrier(atlas_view, memory_barrier);
+		}
+
+		// Cleared as a whole by the render pass
+		begin_render_pass(command_buffer, *atlas, false);
+
+		for (uint32_t i = 0; i < next_tile; ++i)
+		{
+			draw_tile(command_buffer, i, false, false);
+			draw_tile(command_buffer, i, true, false);
+		}
+
+		command_buffer.end_render_pass();
+
+		rendered_tile_count = next_tile;
+	}
+	else
+	{
+		std::vector<uint32_t> stale_tiles;
+		for (uint32_t i = 0; i < next_tile; ++i)
+		{
+			if (!tiles[i].cached)
+			{
+				stale_tiles.push_back(i);
+			}
+		}
+
+		if (!stale_tiles.empty())
+		{
+			{
+				// The cached tiles are kept, unless the static atlas was never rendered
+				ImageMemoryBarrier memory_barrier{};
+				memory_barrier.old_layout      = static_atlas_initialized ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+				memory_barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				memory_barrier.src_access_mask = 0;
+				memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+				command_buffer.image_memory_barrier(static_atlas_view, memory_barrier);
+			}
+
+			begin_render_pass(command_buffer, *static_atlas, static_atlas_initialized);
+
+			for (auto tile : stale_tiles)
+			{
+				draw_tile(command_buffer, tile, false, static_atlas_initialized);
+				tiles[tile].cached = true;
+			}
+
+			command_buffer.end_render_pass();
+
+			{
+				ImageMemoryBarrier memory_barrier{};
+				memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+				memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+				command_buffer.image_memory_barrier(static_atlas_view, memory_barrier);
+			}
+
+			static_atlas_initialized = true;
+			rendered_tile_count      = to_u32(stale_tiles.size());
+		}
+
+		{
+			// The last frame sampled the atlas, the copy replaces the tiles in use
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			memory_barrier.src_access_mask = 0;
+			memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+			command_buffer.image_memory_barrier(atlas_view, memory_barrier);
+		}
+
+		if (static_atlas_initialized && next_tile > 0)
+		{
+			std::vector<VkImageCopy> regions;
+			regions.reserve(next_tile);
+
+			for (uint32_t i = 0; i < next_tile; ++i)
+			{
+				auto rect = get_tile_rect(i);
+
+				VkImageCopy region{};
+				region.srcSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1};
+				region.dstSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1};
+				region.srcOffset      = {rect.offset.x, rect.offset.y, 0};
+				region.dstOffset      = {rect.offset.x, rect.offset.y, 0};
+				region.extent         = {rect.extent.width, rect.extent.height, 1};
+
+				regions.push_back(region);
+			}
+
+			command_buffer.copy_image(static_atlas_view.get_image(), atlas_view.get_image(), regions);
+		}
+
+		bool dynamic_casters = std::any_of(casters.begin(), casters.end(), [](const Caster &caster) { return caster.dynamic; });
+
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			memory_barrier.new_layout      = dynamic_casters ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memory_barrier.dst_access_mask = dynamic_casters ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			memory_barrier.dst_stage_mask  = dynamic_casters ? VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+			command_buffer.image_memory_barrier(atlas_view, memory_barrier);
+		}
+
+		if (!dynamic_casters)
+		{
+			return;
+		}
+
+		// The dynamic casters are drawn over the copy of the static ones
+		begin_render_pass(command_buffer, *atlas, true);
+
+		for (uint32_t i = 0; i < next_tile; ++i)
+		{
+			draw_tile(command_buffer, i, true, false);
+		}
+
+		command_buffer.end_render_pass();
+	}
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(atlas_view, memory_barrier);
+	}
+}
+
+void ShadowAtlas::begin_render_pass(CommandBuffer &command_buffer, RenderTarget &render_target, bool load)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	LoadStoreInfo load_store{load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE};
+
+	auto &render_pass = resource_cache.request_render_pass(render_target.get_attachments(), {load_store}, {SubpassInfo{}});
+	auto &framebuffer = resource_cache.request_framebuffer(render_target, render_pass);
+
+	// Reversed depth, the far plane is at zero
+	VkClearValue clear_value{};
+	clear_value.depthStencil = {0.0f, 0};
+
+	command_buffer.begin_render_pass(render_target, render_pass, framebuffer, {clear_value});
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, shader_source);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	// Both faces cast shadows, the bias keeps the lit surfaces from shadowing themselves
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode         = VK_CULL_MODE_NONE;
+	rasterization_state.depth_bias_enable = VK_TRUE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	// Reversed depth, the bias moves the casters away from the light
+	command_buffer.set_depth_bias(-1.25f, 0.0f, -1.75f);
+}
+
+void ShadowAtlas::draw_tile(CommandBuffer &command_buffer, uint32_t tile_index, bool dynamic, bool clear)
+{
+	auto &tile = tiles[tile_index];
+	auto  rect = get_tile_rect(tile_index);
+
+	VkViewport viewport{};
+	viewport.x        = static_cast<float>(rect.offset.x);
+	viewport.y        = static_cast<float>(rect.offset.y);
+	viewport.width    = static_cast<float>(rect.extent.width);
+	viewport.height   = static_cast<float>(rect.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+	command_buffer.set_scissor(0, {rect});
+
+	if (clear)
+	{
+		VkClearAttachment clear_attachment{};
+		clear_attachment.aspectMask              = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clear_attachment.clearValue.depthStencil = {0.0f, 0};
+
+		VkClearRect clear_rect{};
+		clear_rect.rect           = rect;
+		clear_rect.baseArrayLayer = 0;
+		clear_rect.layerCount     = 1;
+
+		command_buffer.clear(clear_attachment, clear_rect);
+	}
+
+	for (auto &caster : casters)
+	{
+		if (caster.dynamic != dynamic || !tile.frustum.check_sphere(caster.center, caster.radius))
+		{
+			continue;
+		}
+
+		auto &sub_mesh = *caster.sub_mesh;
+
+		sg::VertexAttribute attribute;
+		const core::Buffer *buffer{nullptr};
+		VkDeviceSize        offset{0};
+
+		if (!sub_mesh.get_attribute("position", attribute) || !sub_mesh.get_vertex_buffer("position", buffer, offset))
+		{
+			continue;
+		}
+
+		VertexInputState vertex_input_state;
+		vertex_input_state.attributes.push_back({0, 0, attribute.format, attribute.offset});
+		vertex_input_state.bindings.push_back({0, attribute.stride, VK_VERTEX_INPUT_RATE_VERTEX});
+		command_buffer.set_vertex_input_state(vertex_input_state);
+
+		std::vector<std::reference_wrapper<const core::Buffer>> buffers;
+		buffers.emplace_back(std::ref(*buffer));
+		command_buffer.bind_vertex_buffers(0, std::move(buffers), {offset});
+
+		command_buffer.push_constants(tile.view_proj * caster.model);
+
+		if (sub_mesh.vertex_indices != 0)
+		{
+			command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
+			command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, sub_mesh.first_index, 0, 0);
+		}
+		else
+		{
+			command_buffer.draw(sub_mesh.vertices_count, 1, 0, 0);
+		}
+	}
+}
+
+void ShadowAtlas::bind(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights, uint32_t set, uint32_t atlas_binding, uint32_t uniform_binding) const
+{
+	ShadowUniform uniform{};
+	uniform.view           = camera_view;
+	uniform.cascade_splits = cascade_splits;
+	uniform.texel_size     = glm::vec2(1.0f / static_cast<float>(atlas_size));
+	uniform.normal_offset  = normal_offset;
+
+	for (uint32_t i = 0; i < lights.size() && i < MAX_LIGHT_COUNT; ++i)
+	{
+		auto tiles_it = light_tiles.find(lights[i]);
+		if (tiles_it != light_tiles.end())
+		{
+			uniform.light_tiles[i] = glm::uvec4{tiles_it->second.first, tiles_it->second.second, 0, 0};
+		}
+	}
+
+	float tile_uv = static_cast<float>(tile_size) / static_cast<float>(atlas_size);
+
+	for (uint32_t i = 0; i < used_tile_count; ++i)
+	{
+		uniform.tiles[i].view_proj = tiles[i].view_proj;
+		uniform.tiles[i].rect      = glm::vec4{static_cast<float>(i % tiles_per_row) * tile_uv, static_cast<float>(i / tiles_per_row) * tile_uv, tile_uv, tile_uv};
+	}
+
+	auto &render_frame = render_context.get_active_frame();
+	auto  allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ShadowUniform));
+	allocation.update(uniform);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), set, uniform_binding, 0);
+	command_buffer.bind_image(atlas->get_views().at(0), *shadow_sampler, set, atlas_binding, 0);
+}
+}        // namespace vkb
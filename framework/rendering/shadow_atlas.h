@@ -0,0 +1,269 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+#include "geometry/frustum.h"
+#include "rendering/render_target.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Camera;
+class Light;
+class Node;
+class Scene;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Shadow maps of the lights of a scene, rendered into the tiles of a depth atlas
+ *
+ * Each light gets tiles of the same size: directional lights one per cascade of the camera view,
+ * point lights one per cube face, and spot lights one. The lights past the free tiles cast no shadows.
+ * The cascades are fitted to bounding spheres of the slices of the view and snapped to texels, so
+ * they keep their size and do not shimmer as the camera moves.
+ *
+ * With caching, the casters which did not move for STATIC_FRAME_COUNT frames are static, and their
+ * depth is kept in a second atlas. A tile of it is only rendered again when the projection of its light
+ * changes, or a caster in its frustum turns static or dynamic. Each frame the tiles are copied from it
+ * and the dynamic casters are drawn on top, so the cost follows the moving casters rather than the lights.
+ * Cascades move with the camera and render their static casters again, caching pays off mostly for
+ * the tiles of point and spot lights.
+ *
+ * update() must be recorded before the render pass sampling the atlas, then bind() binds it along
+ * with the ShadowUniform of the lights, for the SHADOWS variant of deferred/lighting.frag.
+ * Casters are drawn opaque, ignoring blended submeshes and alpha masks.
+ */
+class ShadowAtlas
+{
+  public:
+	/**
+	 * @param atlas_size Width and height of the atlas in texels
+	 * @param tile_size Width and height of each tile, the atlas holds at most MAX_TILE_COUNT of them
+	 */
+	ShadowAtlas(RenderContext &render_context, sg::Scene &scene, uint32_t atlas_size = DEFAULT_ATLAS_SIZE, uint32_t tile_size = DEFAULT_TILE_SIZE);
+
+	ShadowAtlas(const ShadowAtlas &) = delete;
+
+	ShadowAtlas(ShadowAtlas &&) = delete;
+
+	~ShadowAtlas() = default;
+
+	ShadowAtlas &operator=(const ShadowAtlas &) = delete;
+
+	ShadowAtlas &operator=(ShadowAtlas &&) = delete;
+
+	/**
+	 * @brief Keeps the depth of the static casters between frames, enabled by default
+	 */
+	void set_caching(bool enabled);
+
+	bool is_using_caching() const;
+
+	/**
+	 * @param distance View depth up to which the cascades of the directional lights cast shadows
+	 * @param split_lambda Blend between uniform (0) and logarithmic (1) splits of the cascades
+	 */
+	void set_cascades(float distance, float split_lambda = 0.75f);
+
+	/**
+	 * @param normal_offset Distance along the normal by which the shaded positions are moved towards the light, in scene units
+	 */
+	void set_normal_offset(float normal_offset);
+
+	/**
+	 * @brief Assigns the tiles of the lights and renders the shadows that changed
+	 * @param lights Lights casting shadows, the first ones get the tiles
+	 * @param camera Camera the cascades are fitted to
+	 */
+	void update(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights, sg::Camera &camera);
+
+	/**
+	 * @brief Binds the atlas and the ShadowUniform of the lights
+	 * @param lights Lights in the order of the light uniform of the shader
+	 */
+	void bind(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights, uint32_t set, uint32_t atlas_binding, uint32_t uniform_binding) const;
+
+	/**
+	 * @return The definitions of the SHADOWS variant of the lighting shaders
+	 */
+	static std::vector<std::string> get_shader_definitions();
+
+	/**
+	 * @return The number of tiles whose static casters were rendered by the last update, all the tiles in use without caching
+	 */
+	uint32_t get_rendered_tile_count() const;
+
+	/**
+	 * @return The number of tiles in use by the last update
+	 */
+	uint32_t get_used_tile_count() const;
+
+	static constexpr uint32_t DEFAULT_ATLAS_SIZE = 4096;
+
+	static constexpr uint32_t DEFAULT_TILE_SIZE = 512;
+
+	static constexpr uint32_t CASCADE_COUNT = 4;
+
+	/// Size of the tile array of the shader
+	static constexpr uint32_t MAX_TILE_COUNT = 64;
+
+	/// Size of the light array of the shader, as MAX_DEFERRED_LIGHT_COUNT
+	static constexpr uint32_t MAX_LIGHT_COUNT = 100;
+
+	/// Frames after a caster last moved until it is static again
+	static constexpr uint32_t STATIC_FRAME_COUNT = 30;
+
+  private:
+	struct Tile
+	{
+		/// Light the tile was last rendered for
+		const sg::Light *light{nullptr};
+
+		glm::mat4 view_proj{1.0f};
+
+		Frustum frustum;
+
+		/// Whether the static atlas holds the static casters of the tile
+		bool cached{false};
+	};
+
+	struct Caster
+	{
+		sg::Node *node;
+
+		sg::SubMesh *sub_mesh;
+
+		glm::mat4 model;
+
+		glm::vec3 center;
+
+		float radius;
+
+		bool dynamic;
+	};
+
+	struct NodeState
+	{
+		/// Update of the last motion of the node
+		uint64_t last_motion{0};
+
+		bool dynamic{false};
+	};
+
+	/**
+	 * @brief Lists the casters of the scene, and invalidates the cached tiles reached by the casters turning static or dynamic
+	 */
+	void update_casters();
+
+	/**
+	 * @brief Computes the projections of the tiles of a light
+	 * @return Whether the light got its tiles
+	 */
+	bool assign_tiles(const sg::Light &light, sg::Camera &camera, uint32_t &next_tile);
+
+	/**
+	 * @brief Invalidates the cached tiles whose frustum contains a sphere
+	 */
+	void invalidate_tiles(const glm::vec3 &center, float radius);
+
+	VkRect2D get_tile_rect(uint32_t tile) const;
+
+	void begin_render_pass(CommandBuffer &command_buffer, RenderTarget &render_target, bool load);
+
+	/**
+	 * @brief Clears the tile, then draws the static or the dynamic casters in its frustum
+	 */
+	void draw_tile(CommandBuffer &command_buffer, uint32_t tile, bool dynamic, bool clear);
+
+	RenderContext &render_context;
+
+	sg::Scene &scene;
+
+	uint32_t atlas_size;
+
+	uint32_t tile_size;
+
+	uint32_t tiles_per_row;
+
+	VkFormat depth_format;
+
+	/// Atlas sampled by the shaders
+	std::unique_ptr<RenderTarget> atlas;
+
+	/// Depth of the static casters of each tile
+	std::unique_ptr<RenderTarget> static_atlas;
+
+	bool static_atlas_initialized{false};
+
+	ShaderSource shader_source;
+
+	const core::Sampler *shadow_sampler{nullptr};
+
+	bool caching{true};
+
+	float cascade_distance{100.0f};
+
+	float cascade_split_lambda{0.75f};
+
+	float normal_offset{0.05f};
+
+	uint64_t update_count{0};
+
+	uint64_t scene_revision{~0ull};
+
+	std::vector<Tile> tiles;
+
+	/// First tile and tile count of each light of the last update
+	std::unordered_map<const sg::Light *, std::pair<uint32_t, uint32_t>> light_tiles;
+
+	/// View depth where each cascade ends
+	glm::vec4 cascade_splits{0.0f};
+
+	glm::mat4 camera_view{1.0f};
+
+	std::vector<Caster> casters;
+
+	std::unordered_map<const sg::Node *, NodeState> node_states;
+
+	/// Bounds of the casters, which the cascades extend towards their light to include
+	glm::vec3 caster_min{0.0f};
+
+	glm::vec3 caster_max{0.0f};
+
+	uint32_t used_tile_count{0};
+
+	uint32_t rendered_tile_count{0};
+};
+}        // namespace vkb
@@ -0,0 +1,87 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "submit_batch.h"
+
+#include "core/command_buffer.h"
+
+namespace vkb
+{
+SubmitBatch::SubmitBatch(size_t thread_count) :
+    thread_command_buffers(std::max<size_t>(thread_count, 1))
+{
+}
+
+void SubmitBatch::add_command_buffer(const CommandBuffer &command_buffer, size_t thread_index)
+{
+	assert(thread_index < thread_command_buffers.size() && "Thread index is out of bounds");
+
+	thread_command_buffers[thread_index].push_back(command_buffer.get_handle());
+}
+
+void SubmitBatch::add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags wait_stage)
+{
+	wait_semaphores.push_back(semaphore);
+	wait_stages.push_back(wait_stage);
+}
+
+void SubmitBatch::add_signal_semaphore(VkSemaphore semaphore)
+{
+	signal_semaphores.push_back(semaphore);
+}
+
+void SubmitBatch::clear()
+{
+	for (auto &command_buffers : thread_command_buffers)
+	{
+		command_buffers.clear();
+	}
+
+	wait_semaphores.clear();
+	wait_stages.clear();
+	signal_semaphores.clear();
+}
+
+bool SubmitBatch::empty() const
+{
+	return std::all_of(thread_command_buffers.begin(), thread_command_buffers.end(), [](const std::vector<VkCommandBuffer> &command_buffers) { return command_buffers.empty(); }) &&
+	       wait_semaphores.empty() && signal_semaphores.empty();
+}
+
+void SubmitBatch::get_command_buffers(std::vector<VkCommandBuffer> &command_buffers) const
+{
+	for (auto &thread_buffers : thread_command_buffers)
+	{
+		command_buffers.insert(command_buffers.end(), thread_buffers.begin(), thread_buffers.end());
+	}
+}
+
+const std::vector<VkSemaphore> &SubmitBatch::get_wait_semaphores() const
+{
+	return wait_semaphores;
+}
+
+const std::vector<VkPipelineStageFlags> &SubmitBatch::get_wait_stages() const
+{
+	return wait_stages;
+}
+
+const std::vector<VkSemaphore> &SubmitBatch::get_signal_semaphores() const
+{
+	return signal_semaphores;
+}
+}        // namespace vkb
@@ -0,0 +1,84 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class CommandBuffer;
+
+/**
+ * @brief Collects the command buffers and semaphores of a frame, so that
+ *        RenderContext::submit() sends them to the queue in a single submission.
+ *
+ * Each thread adds its command buffers to its own list, so no lock is taken. The
+ * lists are submitted in thread index order, the main thread being index 0.
+ * Semaphores are only added by the thread submitting the batch.
+ */
+class SubmitBatch
+{
+  public:
+	/**
+	 * @param thread_count Number of threads adding command buffers to the batch
+	 */
+	explicit SubmitBatch(size_t thread_count = 1);
+
+	/**
+	 * @brief Adds a command buffer, submitted after the ones previously added by the same thread
+	 * @param command_buffer The recorded command buffer
+	 * @param thread_index Index of the thread adding the command buffer, lower than the thread count
+	 */
+	void add_command_buffer(const CommandBuffer &command_buffer, size_t thread_index = 0);
+
+	/**
+	 * @brief Makes the command buffers wait on a semaphore from a pipeline stage
+	 */
+	void add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags wait_stage);
+
+	void add_signal_semaphore(VkSemaphore semaphore);
+
+	/**
+	 * @brief Removes everything added, keeping the storage for the next frame
+	 */
+	void clear();
+
+	bool empty() const;
+
+	/**
+	 * @brief Appends the command buffers of all threads, in submission order
+	 */
+	void get_command_buffers(std::vector<VkCommandBuffer> &command_buffers) const;
+
+	const std::vector<VkSemaphore> &get_wait_semaphores() const;
+
+	const std::vector<VkPipelineStageFlags> &get_wait_stages() const;
+
+	const std::vector<VkSemaphore> &get_signal_semaphores() const;
+
+  private:
+	std::vector<std::vector<VkCommandBuffer>> thread_command_buffers;
+
+	std::vector<VkSemaphore> wait_semaphores;
+
+	std::vector<VkPipelineStageFlags> wait_stages;
+
+	std::vector<VkSemaphore> signal_semaphores;
+};
+}        // namespace vkb
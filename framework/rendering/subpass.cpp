@@ -17,7 +17,9 @@
 
 #include "subpass.h"
 
+#include "core/command_buffer.h"
 #include "render_context.h"
+#include "shader_watcher.h"
 
 namespace vkb
 {
@@ -42,6 +44,15 @@ Subpass::Subpass(RenderContext &render_context, ShaderSource &&vertex_source, Sh
 {
 }
 
+Subpass::~Subpass()
+{
+	if (shader_watcher)
+	{
+		shader_watcher->unwatch(vertex_shader);
+		shader_watcher->unwatch(fragment_shader);
+	}
+}
+
 void Subpass::update_render_target_attachments()
 {
 	auto &render_target = render_context.get_active_frame().get_render_target();
@@ -55,6 +66,16 @@ RenderContext &Subpass::get_render_context()
 	return render_context;
 }
 
+const std::string &Subpass::get_debug_name() const
+{
+	return debug_name;
+}
+
+void Subpass::set_debug_name(const std::string &name)
+{
+	debug_name = name;
+}
+
 const ShaderSource &Subpass::get_vertex_shader() const
 {
 	return vertex_shader;
@@ -65,6 +86,23 @@ const ShaderSource &Subpass::get_fragment_shader() const
 	return fragment_shader;
 }
 
+void Subpass::set_shader_watcher(ShaderWatcher *watcher)
+{
+	if (shader_watcher)
+	{
+		shader_watcher->unwatch(vertex_shader);
+		shader_watcher->unwatch(fragment_shader);
+	}
+
+	shader_watcher = watcher;
+
+	if (shader_watcher)
+	{
+		shader_watcher->watch(vertex_shader);
+		shader_watcher->watch(fragment_shader);
+	}
+}
+
 DepthStencilState &Subpass::get_depth_stencil_state()
 {
 	return depth_stencil_state;
@@ -100,6 +138,35 @@ void Subpass::set_color_resolve_attachments(std::vector<uint32_t> color_resolve)
 	color_resolve_attachments = color_resolve;
 }
 
+void Subpass::pre_draw(CommandBuffer &command_buffer)
+{
+}
+
+bool Subpass::records_secondary_command_buffers()
+{
+	return static_content;
+}
+
+void Subpass::set_static_content(bool enabled)
+{
+	static_content = enabled;
+}
+
+bool Subpass::has_static_content() const
+{
+	return static_content;
+}
+
+void Subpass::invalidate_static_content()
+{
+	++content_revision;
+}
+
+uint64_t Subpass::get_content_revision() const
+{
+	return content_revision;
+}
+
 const bool &Subpass::get_disable_depth_stencil_attachment() const
 {
 	return disable_depth_stencil_attachment;
@@ -130,8 +197,121 @@ void Subpass::set_depth_stencil_resolve_mode(VkResolveModeFlagBits mode)
 	depth_stencil_resolve_mode = mode;
 }
 
+void Subpass::set_shading_rate_attachment(uint32_t attachment, const VkExtent2D &texel_size)
+{
+	shading_rate_attachment = attachment;
+	shading_rate_texel_size = texel_size;
+
+#ifdef VK_KHR_fragment_shading_rate
+	// Without a pipeline rate the attachment alone decides, which needs no support of the other combiner ops
+	if (fragment_shading_rate_state.combiner_ops[1] == VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR)
+	{
+		fragment_shading_rate_state.combiner_ops[1] = VK_FRAGMENT_SHADING_RATE_COMBINER_OP_REPLACE_KHR;
+	}
+#endif
+}
+
+uint32_t Subpass::get_shading_rate_attachment() const
+{
+	return shading_rate_attachment;
+}
+
+const VkExtent2D &Subpass::get_shading_rate_texel_size() const
+{
+	return shading_rate_texel_size;
+}
+
+void Subpass::set_render_area(const VkExtent2D &area)
+{
+	render_area = area;
+}
+
+VkExtent2D Subpass::get_render_area()
+{
+	if (render_area.width == 0 || render_area.height == 0)
+	{
+		return render_context.get_active_frame().get_render_target().get_extent();
+	}
+
+	return render_area;
+}
+
+void Subpass::set_fragment_shading_rate_state(const FragmentShadingRateState &state)
+{
+	fragment_shading_rate_state = state;
+}
+
+const FragmentShadingRateState &Subpass::get_fragment_shading_rate_state() const
+{
+	return fragment_shading_rate_state;
+}
+
+void Subpass::set_view_mask(uint32_t view_mask_)
+{
+	view_mask = view_mask_;
+}
+
+uint32_t Subpass::get_view_mask() const
+{
+	return view_mask;
+}
+
 void Subpass::set_sample_count(VkSampleCountFlagBits sample_count)
 {
 	this->sample_count = sample_count;
 }
+
+void Subpass::set_specialized_lights(bool enabled)
+{
+	specialized_lights = enabled;
+}
+
+bool Subpass::is_using_specialized_lights() const
+{
+	return specialized_lights;
+}
+
+void Subpass::set_half_precision(bool enabled)
+{
+	half_precision = enabled;
+}
+
+bool Subpass::is_using_half_precision() const
+{
+	return half_precision;
+}
+
+std::vector<std::string> Subpass::get_precision_definitions() const
+{
+	if (half_precision)
+	{
+		return {"HALF_PRECISION"};
+	}
+
+	return {};
+}
+
+void Subpass::set_light_specialization_constants(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights, bool bake_count)
+{
+	uint32_t light_count     = ~0u;
+	uint32_t light_type_mask = ~0u;
+
+	if (specialized_lights)
+	{
+		if (bake_count)
+		{
+			light_count = to_u32(lights.size());
+		}
+
+		light_type_mask = 0;
+		for (auto light : lights)
+		{
+			light_type_mask |= 1u << light->get_light_type();
+		}
+	}
+
+	// Always set, so that the values of a previous subpass don't apply
+	command_buffer.set_specialization_constant(LIGHT_COUNT_CONSTANT_ID, light_count);
+	command_buffer.set_specialization_constant(LIGHT_TYPE_MASK_CONSTANT_ID, light_type_mask);
+}
 }        // namespace vkb
@@ -33,6 +33,7 @@ VKBP_ENABLE_WARNINGS()
 namespace vkb
 {
 class CommandBuffer;
+class ShaderWatcher;
 
 struct alignas(16) Light
 {
@@ -51,6 +52,12 @@ glm::mat4 vulkan_style_projection(const glm::mat4 &proj);
 
 extern const std::vector<std::string> light_type_definitions;
 
+/// Specialization constant of the lighting shaders holding the count of the light loops, ~0u reads the count of the light uniform
+constexpr uint32_t LIGHT_COUNT_CONSTANT_ID = 16;
+
+/// Specialization constant of the lighting shaders holding a mask of 1 << sg::LightType bits, the branches of the other types are removed
+constexpr uint32_t LIGHT_TYPE_MASK_CONSTANT_ID = 17;
+
 /**
  * @brief This class defines an interface for subpasses
  *        where they need to implement the draw function.
@@ -65,7 +72,7 @@ class Subpass
 
 	Subpass(Subpass &&) = default;
 
-	virtual ~Subpass() = default;
+	virtual ~Subpass();
 
 	Subpass &operator=(const Subpass &) = delete;
 
@@ -89,12 +96,52 @@ class Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) = 0;
 
+	/**
+	 * @brief Records the work of the subpass which runs outside of the render pass, e.g. compute dispatches
+	 *        Called by the RenderPipeline before beginning the render pass. Work independent of the frame's
+	 *        graphics can be recorded on the compute queue through RenderContext::get_async_compute.
+	 * @param command_buffer Command buffer the render pass is recorded into
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Whether draw records the subpass into secondary command buffers
+	 *        The RenderPipeline then begins the subpass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+	 */
+	virtual bool records_secondary_command_buffers();
+
+	/**
+	 * @brief Records the subpass once per frame into a secondary command buffer, which the
+	 *        RenderPipeline executes again in the next uses of the frame until the content
+	 *        is invalidated or the swapchain changes
+	 *        The draws must only use resources which outlive the frame: buffers allocated
+	 *        from the RenderFrame are reset with it and would be overwritten.
+	 */
+	void set_static_content(bool enabled);
+
+	bool has_static_content() const;
+
+	/**
+	 * @brief Records the static content again in the next frames, e.g. after a scene change
+	 */
+	void invalidate_static_content();
+
+	/**
+	 * @return The number of times the static content was invalidated
+	 */
+	virtual uint64_t get_content_revision() const;
+
 	RenderContext &get_render_context();
 
 	const ShaderSource &get_vertex_shader() const;
 
 	const ShaderSource &get_fragment_shader() const;
 
+	/**
+	 * @brief Reloads the shaders of the subpass when their files change, until the subpass is destroyed
+	 */
+	void set_shader_watcher(ShaderWatcher *watcher);
+
 	DepthStencilState &get_depth_stencil_state();
 
 	const std::vector<uint32_t> &get_input_attachments() const;
@@ -127,6 +174,72 @@ class Subpass
 
 	void set_depth_stencil_resolve_mode(VkResolveModeFlagBits mode);
 
+	/**
+	 * @brief Reads the fragment shading rate of the subpass from an attachment, usually written by a ShadingRateGenerator
+	 * @param attachment Index of the R8_UINT attachment of the render target holding the rates
+	 * @param texel_size Pixels covered by each texel of the attachment, within the texel sizes supported by the device
+	 */
+	void set_shading_rate_attachment(uint32_t attachment, const VkExtent2D &texel_size);
+
+	uint32_t get_shading_rate_attachment() const;
+
+	/**
+	 * @return The texel size of the shading rate attachment, zero without one
+	 */
+	const VkExtent2D &get_shading_rate_texel_size() const;
+
+	/**
+	 * @brief Sets the pipeline shading rate of the draws of the subpass, and how it combines with the attachment
+	 */
+	void set_fragment_shading_rate_state(const FragmentShadingRateState &state);
+
+	const FragmentShadingRateState &get_fragment_shading_rate_state() const;
+
+	/**
+	 * @brief Renders the draws of the subpass once for each view of the mask, into the layers of the render target
+	 *        of the same index, with VK_KHR_multiview. The shaders select their view with gl_ViewIndex.
+	 * @param view_mask Views of the subpass, 0 to render a single view
+	 */
+	void set_view_mask(uint32_t view_mask);
+
+	uint32_t get_view_mask() const;
+
+	/**
+	 * @brief Sets the extent of the region of the render target drawn by the subpass, set by the render pipeline
+	 */
+	void set_render_area(const VkExtent2D &render_area);
+
+	/**
+	 * @return The extent of the region of the render target drawn by the subpass,
+	 *         the whole render target of the active frame unless the render pipeline is scaled
+	 */
+	VkExtent2D get_render_area();
+
+	/**
+	 * @return The name of the GPU scope of the subpass, empty if it is named by its index
+	 */
+	const std::string &get_debug_name() const;
+
+	void set_debug_name(const std::string &name);
+
+	/**
+	 * @brief Bakes the light count and the light types into the lighting shaders as specialization constants, so
+	 *        that the light loops have a constant count and no branches for the types missing from the scene.
+	 *        Each light count and combination of types gets its own pipeline, from the resource cache. Enabled by default.
+	 */
+	void set_specialized_lights(bool enabled);
+
+	bool is_using_specialized_lights() const;
+
+	/**
+	 * @brief Compiles the shaders with the HALF_PRECISION variant, whose shading math defaults to mediump while the
+	 *        positions, depths and texture coordinates stay highp. GPUs with 16-bit ALUs run the relaxed math in half
+	 *        precision, with fewer registers, others in full precision. It must be set before prepare().
+	 */
+	virtual void set_half_precision(bool enabled);
+
+	bool is_using_half_precision() const;
+
 	/**
 	 * @brief Create a buffer allocation from scene graph lights to be bound to shaders
 	 * 
@@ -198,6 +311,20 @@ class Subpass
 	}
 
   protected:
+	/**
+	 * @brief Sets LIGHT_COUNT_CONSTANT_ID and LIGHT_TYPE_MASK_CONSTANT_ID for the lights, or their defaults reading
+	 *        the light uniform when the lights are not specialized
+	 * @param command_buffer Command buffer the draws are recorded into
+	 * @param lights Lights written in the light uniform
+	 * @param bake_count Whether the loops iterate over all the lights, false when they only see a range of them
+	 */
+	void set_light_specialization_constants(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights, bool bake_count);
+
+	/**
+	 * @return The definitions of the precision of the shader variants, HALF_PRECISION when enabled
+	 */
+	std::vector<std::string> get_precision_definitions() const;
+
 	RenderContext &render_context;
 
 	VkSampleCountFlagBits sample_count{VK_SAMPLE_COUNT_1_BIT};
@@ -212,6 +339,10 @@ class Subpass
 
 	DepthStencilState depth_stencil_state{};
 
+	std::string debug_name;
+
+	ShaderWatcher *shader_watcher{nullptr};
+
 	/**
 	 * @brief When creating the renderpass, pDepthStencilAttachment will
 	 *        be set to nullptr, which disables depth testing
@@ -236,6 +367,28 @@ class Subpass
 
 	/// Default to no depth stencil resolve attachment
 	uint32_t depth_stencil_resolve_attachment{VK_ATTACHMENT_UNUSED};
+
+	/// Default to no shading rate attachment
+	uint32_t shading_rate_attachment{VK_ATTACHMENT_UNUSED};
+
+	VkExtent2D shading_rate_texel_size{0, 0};
+
+	/// Default to shading every pixel
+	FragmentShadingRateState fragment_shading_rate_state{};
+
+	/// Default to a single view
+	uint32_t view_mask{0};
+
+	/// Default to the whole render target
+	VkExtent2D render_area{0, 0};
+
+	bool static_content{false};
+
+	uint64_t content_revision{0};
+
+	bool specialized_lights{true};
+
+	bool half_precision{false};
 };
 
 }        // namespace vkb
@@ -35,11 +35,15 @@ namespace vkb
 ForwardSubpass::ForwardSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera}
 {
+	set_debug_name("Forward");
 }
 
 void ForwardSubpass::prepare()
 {
 	auto &device = render_context.get_device();
+
+	std::vector<std::shared_future<ShaderModule *>> shader_modules;
+
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
@@ -47,20 +51,153 @@ void ForwardSubpass::prepare()
 			auto &variant = sub_mesh->get_mut_shader_variant();
 
 			// Same as Geometry except adds lighting definitions to sub mesh variants.
-			variant.add_definitions({"MAX_FORWARD_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
+			if (light_clusters)
+			{
+				variant.add_definitions(LightClusters::get_shader_definitions());
+			}
+			else
+			{
+				variant.add_definitions({"MAX_FORWARD_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
+			}
 			variant.add_definitions(light_type_definitions);
 
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+			if (order_independent_transparency && sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
+			{
+				variant.add_define("WEIGHTED_BLENDED_OIT");
+			}
 		}
 	}
+
+	// The variants of the draws are copies of the submesh variants
+	update_draw_variants();
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &variant = get_draw_variant(*sub_mesh);
+
+			shader_modules.push_back(device.get_resource_cache().request_shader_module_async(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant));
+			shader_modules.push_back(device.get_resource_cache().request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant));
+		}
+	}
+
+	// The variants compile in parallel, wait for all of them
+	for (auto &shader_module : shader_modules)
+	{
+		shader_module.get();
+	}
 }
 
 void ForwardSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto lights_buffer = allocate_lights<ForwardLights>(scene.get_components<sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
-	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	// Lights whose range reaches no mesh are left out of the light loop
+	scene.get_lights_reaching_meshes(lights);
+
+	if (light_clusters)
+	{
+		light_clusters->update(lights, camera, get_render_area());
+	}
+	else
+	{
+		lights_buffer = allocate_lights<ForwardLights>(lights, MAX_FORWARD_LIGHT_COUNT);
+	}
 
 	GeometrySubpass::draw(command_buffer);
 }
+
+void ForwardSubpass::set_clustered_lights(bool enabled)
+{
+	if (enabled)
+	{
+		light_clusters = std::make_unique<LightClusters>(render_context);
+	}
+	else
+	{
+		light_clusters.reset();
+	}
+}
+
+bool ForwardSubpass::is_using_clustered_lights() const
+{
+	return light_clusters != nullptr;
+}
+
+void ForwardSubpass::set_order_independent_transparency(bool enabled)
+{
+	order_independent_transparency = enabled;
+
+	// The transparent draws are grouped like the opaque ones, as their order does not matter
+	set_ordered_transparency(!enabled);
+}
+
+bool ForwardSubpass::is_using_order_independent_transparency() const
+{
+	return order_independent_transparency;
+}
+
+void ForwardSubpass::record_common_state(CommandBuffer &command_buffer)
+{
+	// The clusters only see a range of the lights, their count can't be baked
+	set_light_specialization_constants(command_buffer, lights, !light_clusters);
+
+	if (light_clusters)
+	{
+		light_clusters->bind(command_buffer);
+	}
+	else if (!lights_buffer.empty())
+	{
+		command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	}
+
+	if (order_independent_transparency)
+	{
+		assert(get_output_attachments().size() >= 3 && "Order independent transparency needs accumulation and revealage outputs");
+
+		// The opaque draws do not write the transparency attachments
+		ColorBlendState color_blend_state{};
+		color_blend_state.attachments.resize(get_output_attachments().size());
+		color_blend_state.attachments[1].color_write_mask = 0;
+		color_blend_state.attachments[2].color_write_mask = 0;
+		command_buffer.set_color_blend_state(color_blend_state);
+	}
+}
+
+void ForwardSubpass::set_transparent_state(CommandBuffer &command_buffer)
+{
+	if (!order_independent_transparency)
+	{
+		GeometrySubpass::set_transparent_state(command_buffer);
+		return;
+	}
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+
+	// The composite subpass blends the transparent surfaces over the opaque color
+	color_blend_state.attachments[0].color_write_mask = 0;
+
+	// Sum of the weighted colors and coverages
+	auto &accumulation                  = color_blend_state.attachments[1];
+	accumulation.blend_enable           = VK_TRUE;
+	accumulation.src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	accumulation.dst_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	accumulation.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+	accumulation.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+
+	// Product of the transmittances
+	auto &revealage                  = color_blend_state.attachments[2];
+	revealage.blend_enable           = VK_TRUE;
+	revealage.src_color_blend_factor = VK_BLEND_FACTOR_ZERO;
+	revealage.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+	revealage.src_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+	revealage.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	// The transparent surfaces are tested against the opaque depth, without hiding each other
+	auto depth_stencil_state               = get_depth_stencil_state();
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+}
 }        // namespace vkb
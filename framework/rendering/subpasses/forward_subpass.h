@@ -20,6 +20,7 @@
 #include "common/error.h"
 
 #include "buffer_pool.h"
+#include "rendering/light_clusters.h"
 #include "rendering/subpasses/geometry_subpass.h"
 
 #define MAX_FORWARD_LIGHT_COUNT 16
@@ -33,6 +34,7 @@ class Node;
 class Mesh;
 class SubMesh;
 class Camera;
+class Light;
 }        // namespace sg
 
 struct alignas(16) ForwardLights
@@ -61,10 +63,45 @@ class ForwardSubpass : public GeometrySubpass
 
 	virtual void prepare() override;
 
+	/**
+	 * @brief Shades each fragment with the lights of its cluster, assigned by LightClusters, instead of a loop over
+	 *        the whole light uniform which is capped at MAX_FORWARD_LIGHT_COUNT. The fragment shader must support the
+	 *        CLUSTERED_LIGHTS variant, as base.frag does. It must be set before prepare().
+	 */
+	void set_clustered_lights(bool enabled);
+
+	bool is_using_clustered_lights() const;
+
+	/**
+	 * @brief Blends the transparent draws with weighted blended order independent transparency, so they are neither
+	 *        sorted nor drawn one by one. Their weighted colors and coverages are accumulated into the second and
+	 *        third output attachments, which must be R16G16B16A16_SFLOAT cleared to 0 and R16_SFLOAT cleared to 1,
+	 *        and a TransparencyCompositeSubpass blends them over the first one. The fragment shader must support the
+	 *        WEIGHTED_BLENDED_OIT variant, as base.frag does. It must be set before prepare().
+	 */
+	void set_order_independent_transparency(bool enabled);
+
+	bool is_using_order_independent_transparency() const;
+
 	/**
 	 * @brief Record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
+
+  protected:
+	void record_common_state(CommandBuffer &command_buffer) override;
+
+	void set_transparent_state(CommandBuffer &command_buffer) override;
+
+  private:
+	BufferAllocation lights_buffer;
+
+	/// Lights of the frame, in the order of the light uniform
+	std::vector<sg::Light *> lights;
+
+	std::unique_ptr<LightClusters> light_clusters;
+
+	bool order_independent_transparency{false};
 };
 
 }        // namespace vkb
@@ -16,95 +16,1299 @@
  */
 
 #include "rendering/subpasses/geometry_subpass.h"
+
+#include <limits>
+
+#include "common/logging.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "geometry/frustum.h"
+#include "job_system.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "texture_streamer.h"
+
+namespace vkb
+{
+namespace
+{
+/// Attribute of the mesh shader which a submesh does not have
+constexpr uint32_t NO_ATTRIBUTE = ~0U;
+
+/**
+ * @brief Culling planes and vertex layout of a meshlet draw, as the MeshletDraw uniform of the meshlet shaders
+ *        Offsets and strides of the attributes are in floats of the vertex arena.
+ */
+struct alignas(16) MeshletDrawUniform
+{
+	glm::vec4 planes[6];
+
+	uint32_t meshlet_count;
+
+	uint32_t frustum_culling;
+
+	uint32_t cone_culling;
+
+	uint32_t position_offset;
+
+	uint32_t position_stride;
+
+	uint32_t normal_offset;
+
+	uint32_t normal_stride;
+
+	uint32_t texcoord_offset;
+
+	uint32_t texcoord_stride;
+};
+
+/**
+ * @brief View projections of the MULTIVIEW variant, indexed by gl_ViewIndex
+ */
+struct alignas(16) ViewUniform
+{
+	glm::mat4 view_proj[GeometrySubpass::MAX_VIEWS];
+};
+
+/**
+ * @brief Finds an attribute of a submesh in the vertex arena, if it has the given format
+ */
+bool get_arena_attribute(const sg::SubMesh &sub_mesh, const std::string &name, VkFormat format, uint32_t &offset, uint32_t &stride)
+{
+	sg::VertexAttribute attribute;
+
+	auto offset_it = sub_mesh.vertex_arena_offsets.find(name);
+
+	if (offset_it == sub_mesh.vertex_arena_offsets.end() || !sub_mesh.get_attribute(name, attribute) || attribute.format != format ||
+	    (offset_it->second + attribute.offset) % sizeof(float) != 0 || attribute.stride % sizeof(float) != 0)
+	{
+		offset = NO_ATTRIBUTE;
+		stride = 0;
+		return false;
+	}
+
+	offset = to_u32((offset_it->second + attribute.offset) / sizeof(float));
+	stride = attribute.stride / to_u32(sizeof(float));
+	return true;
+}
+}        // namespace
+
+GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
+    Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
+    meshes{scene_.get_components<sg::Mesh>()},
+    camera{camera},
+    scene{scene_}
+{
+	set_debug_name("Geometry");
+}
+
+void GeometrySubpass::prepare()
+{
+	// Build all shader variance upfront, in parallel
+	auto &device = render_context.get_device();
+
+	std::vector<std::shared_future<ShaderModule *>> shader_modules;
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &variant = get_draw_variant(*sub_mesh);
+			shader_modules.push_back(device.get_resource_cache().request_shader_module_async(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant));
+			shader_modules.push_back(device.get_resource_cache().request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant));
+
+#ifdef VK_EXT_mesh_shader
+			if (mesh_shading && can_draw_meshlets(*sub_mesh))
+			{
+				shader_modules.push_back(device.get_resource_cache().request_shader_module_async(VK_SHADER_STAGE_TASK_BIT_EXT, task_shader, variant));
+				shader_modules.push_back(device.get_resource_cache().request_shader_module_async(VK_SHADER_STAGE_MESH_BIT_EXT, mesh_shader, variant));
+			}
+#endif
+		}
+	}
+
+	for (auto &shader_module : shader_modules)
+	{
+		shader_module.get();
+	}
+}
+
+void GeometrySubpass::get_sorted_nodes(CpuCulling::DrawList &opaque_nodes, CpuCulling::DrawList &transparent_nodes)
+{
+	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+
+	auto view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+
+	// Static content is recorded once for every camera position, the other views see outside of the frustum
+	bool frustum_test = !gpu_culling && !has_static_content() && views.empty();
+
+	if (frustum_test && hierarchical_culling)
+	{
+		cpu_culling.cull(scene.get_bvh(), view_proj, glm::vec3(camera_transform[3]), opaque_nodes, transparent_nodes);
+		return;
+	}
+
+	cpu_culling.cull(meshes, view_proj, glm::vec3(camera_transform[3]), opaque_nodes, transparent_nodes, job_system, frustum_test);
+}
+
+void GeometrySubpass::draw(CommandBuffer &command_buffer)
+{
+	// The lists only live for the recording, they are allocated from the arena of the frame
+	auto &linear_allocator = render_context.get_active_frame().get_thread_context().get_linear_allocator();
+
+	CpuCulling::DrawList sorted_opaque_nodes(linear_allocator);
+	CpuCulling::DrawList sorted_transparent_nodes(linear_allocator);
+
+	get_sorted_nodes(sorted_opaque_nodes, sorted_transparent_nodes);
+
+	if (motion_vectors)
+	{
+		update_motion_view();
+	}
+
+	if (!views.empty())
+	{
+		update_views();
+	}
+
+	if (transform_buffer)
+	{
+		update_transforms();
+	}
+
+	// Selected before recording, the draws only read the levels from any thread
+	update_lod_levels(sorted_opaque_nodes);
+	update_lod_levels(sorted_transparent_nodes);
+
+	if (texture_streamer)
+	{
+		request_texture_levels(sorted_opaque_nodes);
+		request_texture_levels(sorted_transparent_nodes);
+	}
+
+	// Written before recording, the draws only read the descriptor set of the frame
+	if (bindless_materials)
+	{
+		bindless_materials->update();
+	}
+
+	// The static content of the subpass is recorded inline into its secondary command buffer
+	if (command_buffer.level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && is_recording_in_parallel())
+	{
+		draw_parallel(command_buffer, sorted_opaque_nodes, sorted_transparent_nodes);
+		return;
+	}
+
+	bind_views(command_buffer);
+
+	record_common_state(command_buffer);
+
+	draw_nodes(command_buffer, sorted_opaque_nodes, 0, sorted_opaque_nodes.size(), false);
+
+	set_transparent_state(command_buffer);
+
+	draw_nodes(command_buffer, sorted_transparent_nodes, 0, sorted_transparent_nodes.size(), true);
+}
+
+void GeometrySubpass::set_parallel_recording(JobSystem *job_system, uint32_t draws_per_command_buffer)
+{
+	assert(draws_per_command_buffer > 0 && "Each command buffer should record at least one draw");
+
+	this->job_system               = job_system;
+	this->draws_per_command_buffer = draws_per_command_buffer;
+}
+
+bool GeometrySubpass::records_secondary_command_buffers()
+{
+	return Subpass::records_secondary_command_buffers() || is_recording_in_parallel();
+}
+
+void GeometrySubpass::set_push_descriptors(bool enabled)
+{
+	if (enabled && !render_context.get_device().is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+	{
+		LOGW("Push descriptors requested but {} is not enabled, using pooled descriptor sets", VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		enabled = false;
+	}
+
+	if (push_descriptors != enabled)
+	{
+		push_descriptors = enabled;
+
+		// Recorded bundles use the pipeline layouts of the previous mode
+		invalidate_static_content();
+	}
+}
+
+bool GeometrySubpass::is_using_push_descriptors() const
+{
+	return push_descriptors;
+}
+
+void GeometrySubpass::set_gpu_culling(bool enabled)
+{
+	if (enabled == is_using_gpu_culling())
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		gpu_culling = std::make_unique<GpuCulling>(render_context);
+		gpu_culling->set_async_compute(async_culling ? &render_context.get_async_compute() : nullptr);
+
+		// The instances are set on the next pre_draw
+		culling_revision = ~0ull;
+	}
+	else
+	{
+		gpu_culling.reset();
+		culling_instances.clear();
+	}
+
+	// Recorded bundles use the draws of the previous mode
+	invalidate_static_content();
+}
+
+bool GeometrySubpass::is_using_gpu_culling() const
+{
+	return gpu_culling != nullptr;
+}
+
+void GeometrySubpass::set_occlusion_culling(bool enabled)
+{
+	if (enabled)
+	{
+		set_gpu_culling(true);
+	}
+
+	if (gpu_culling)
+	{
+		gpu_culling->set_occlusion_culling(enabled);
+	}
+}
+
+bool GeometrySubpass::is_using_occlusion_culling() const
+{
+	return gpu_culling && gpu_culling->is_using_occlusion_culling();
+}
+
+void GeometrySubpass::set_async_culling(bool enabled)
+{
+	async_culling = enabled;
+
+	if (enabled)
+	{
+		set_gpu_culling(true);
+	}
+
+	if (gpu_culling)
+	{
+		gpu_culling->set_async_compute(enabled ? &render_context.get_async_compute() : nullptr);
+	}
+}
+
+bool GeometrySubpass::is_using_async_culling() const
+{
+	return gpu_culling && async_culling;
+}
+
+void GeometrySubpass::set_multi_draw_indirect(bool enabled)
+{
+	auto &features = render_context.get_device().get_gpu().get_requested_features();
+
+	if (enabled && (!features.multiDrawIndirect || !features.drawIndirectFirstInstance))
+	{
+		LOGW("Multi-draw indirect requested but the device features are not enabled, drawing each submesh");
+		enabled = false;
+	}
+
+	if (multi_draw_indirect != enabled)
+	{
+		multi_draw_indirect = enabled;
+
+		// Recorded bundles use the draws of the previous mode
+		invalidate_static_content();
+	}
+}
+
+bool GeometrySubpass::is_using_multi_draw_indirect() const
+{
+	return multi_draw_indirect;
+}
+
+void GeometrySubpass::set_automatic_instancing(bool enabled)
+{
+	if (automatic_instancing != enabled)
+	{
+		automatic_instancing = enabled;
+
+		// Recorded bundles use the draws of the previous mode
+		invalidate_static_content();
+	}
+}
+
+bool GeometrySubpass::is_using_automatic_instancing() const
+{
+	return automatic_instancing;
+}
+
+void GeometrySubpass::set_persistent_transforms(bool enabled)
+{
+	if (enabled == is_using_persistent_transforms())
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		transform_buffer = std::make_unique<TransformBuffer>(render_context);
+
+		// The nodes get their slots on the next pre_draw
+		transform_revision = ~0ull;
+	}
+	else
+	{
+		transform_buffer.reset();
+	}
+
+	update_draw_variants();
+
+	// Recorded bundles use the uniforms of the previous mode
+	invalidate_static_content();
+}
+
+bool GeometrySubpass::is_using_persistent_transforms() const
+{
+	return transform_buffer != nullptr;
+}
+
+void GeometrySubpass::set_ordered_transparency(bool ordered)
+{
+	if (ordered_transparency != ordered)
+	{
+		ordered_transparency = ordered;
+
+		cpu_culling.set_transparent_sorting(ordered);
+
+		// Recorded bundles use the draws of the previous order
+		invalidate_static_content();
+	}
+}
+
+void GeometrySubpass::set_hierarchical_culling(bool enabled)
+{
+	hierarchical_culling = enabled;
+}
+
+bool GeometrySubpass::is_using_hierarchical_culling() const
+{
+	return hierarchical_culling;
+}
+
+void GeometrySubpass::set_bindless_materials(bool enabled)
+{
+	if (enabled && !BindlessMaterials::is_supported(render_context.get_device(), scene))
+	{
+		LOGW("Bindless materials requested but the device cannot index the textures of the scene, binding the textures of each draw");
+		enabled = false;
+	}
+
+	if (enabled == is_using_bindless_materials())
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		bindless_materials = std::make_unique<BindlessMaterials>(render_context, scene);
+	}
+	else
+	{
+		bindless_materials.reset();
+	}
+
+	// The draw variants are based on the material variants
+	update_draw_variants();
+
+	// Recorded bundles use the shader variants of the previous mode
+	invalidate_static_content();
+}
+
+bool GeometrySubpass::is_using_bindless_materials() const
+{
+	return bindless_materials != nullptr;
+}
+
+void GeometrySubpass::set_mesh_shading(bool enabled)
+{
+#ifdef VK_EXT_mesh_shader
+	if (enabled && !render_context.get_device().is_enabled(VK_EXT_MESH_SHADER_EXTENSION_NAME))
+	{
+		LOGW("Mesh shading requested but {} is not enabled, drawing with the vertex pipeline", VK_EXT_MESH_SHADER_EXTENSION_NAME);
+		enabled = false;
+	}
+#else
+	if (enabled)
+	{
+		LOGW("Mesh shading requested but the Vulkan headers lack VK_EXT_mesh_shader, drawing with the vertex pipeline");
+		enabled = false;
+	}
+#endif
+
+	if (enabled == mesh_shading)
+	{
+		return;
+	}
+
+	mesh_shading = enabled;
+
+	if (mesh_shading && task_shader.get_filename().empty())
+	{
+		task_shader = ShaderSource{"meshlet/meshlet.task"};
+		mesh_shader = ShaderSource{"meshlet/meshlet.mesh"};
+	}
+
+	// Recorded bundles draw with the pipeline of the previous mode
+	invalidate_static_content();
+}
+
+bool GeometrySubpass::is_using_mesh_shading() const
+{
+	return mesh_shading;
+}
+
+void GeometrySubpass::set_motion_vectors(bool enabled)
+{
+	if (enabled == motion_vectors)
+	{
+		return;
+	}
+
+	motion_vectors = enabled;
+
+	update_draw_variants();
+
+	// The first frame with motion vectors has no camera motion
+	has_motion_view = false;
+
+	// Recorded bundles use the shader variants of the previous mode
+	invalidate_static_content();
+}
+
+bool GeometrySubpass::is_using_motion_vectors() const
+{
+	return motion_vectors;
+}
+
+void GeometrySubpass::set_gbuffer_layout(gbuffer::Layout layout)
+{
+	if (layout == gbuffer_layout)
+	{
+		return;
+	}
+
+	gbuffer_layout = layout;
+
+	update_draw_variants();
+
+	// Recorded bundles use the shader variants of the previous layout
+	invalidate_static_content();
+}
+
+gbuffer::Layout GeometrySubpass::get_gbuffer_layout() const
+{
+	return gbuffer_layout;
+}
+
+void GeometrySubpass::set_half_precision(bool enabled)
+{
+	if (enabled == is_using_half_precision())
+	{
+		return;
+	}
+
+	Subpass::set_half_precision(enabled);
+
+	update_draw_variants();
+
+	// Recorded bundles use the shader variants of the previous precision
+	invalidate_static_content();
+}
+
+void GeometrySubpass::set_views(const std::vector<sg::Camera *> &views_)
+{
+	if (!views_.empty() && !render_context.get_device().supports_multiview())
+	{
+		throw std::runtime_error("Views set but the device does not support multiview");
+	}
+
+	if (views_.size() > MAX_VIEWS)
+	{
+		throw std::runtime_error(fmt::format("{} views set, the subpass draws up to {}", views_.size(), MAX_VIEWS));
+	}
+
+	views = views_;
+
+	set_view_mask(views.empty() ? 0 : (1u << to_u32(views.size())) - 1);
+
+	update_draw_variants();
+
+	// Recorded bundles use the shader variants and render pass of the previous views
+	invalidate_static_content();
+}
+
+const std::vector<sg::Camera *> &GeometrySubpass::get_views() const
+{
+	return views;
+}
+
+void GeometrySubpass::update_draw_variants()
+{
+	draw_variants.clear();
+	transform_variants.clear();
+
+	auto gbuffer_definitions   = gbuffer::get_shader_definitions(gbuffer_layout);
+	auto precision_definitions = get_precision_definitions();
+
+	if (motion_vectors || !views.empty() || !gbuffer_definitions.empty() || !precision_definitions.empty())
+	{
+		for (auto &mesh : meshes)
+		{
+			for (auto &sub_mesh : mesh->get_submeshes())
+			{
+				auto variant = bindless_materials ? bindless_materials->get_shader_variant(*sub_mesh) : sub_mesh->get_shader_variant();
+
+				if (motion_vectors)
+				{
+					variant.add_define("MOTION_VECTORS");
+				}
+
+				if (!views.empty())
+				{
+					variant.add_define("MULTIVIEW");
+				}
+
+				variant.add_definitions(gbuffer_definitions);
+				variant.add_definitions(precision_definitions);
+
+				draw_variants.emplace(sub_mesh, std::move(variant));
+			}
+		}
+	}
+
+	// The motion and the views are projected from world space by the shaders
+	if (!transform_buffer || motion_vectors || !views.empty())
+	{
+		return;
+	}
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto variant = get_draw_variant(*sub_mesh);
+			variant.add_define("TRANSFORM_BUFFER");
+
+			transform_variants.emplace(sub_mesh, std::move(variant));
+		}
+	}
+}
+
+void GeometrySubpass::update_transforms()
+{
+	transform_buffer->update();
+
+	transform_allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform));
+
+	auto &global_uniform = transform_allocation.emplace<GlobalUniform>();
+
+	// The view keeps its rotation only, the shaders subtract the camera position from the transforms
+	auto view = camera.get_view();
+	view[3]   = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	global_uniform.model            = glm::mat4(1.0f);
+	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * view;
+	global_uniform.camera_position  = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+	transform_allocation.flush();
+}
+
+uint32_t GeometrySubpass::get_transform_slot(const sg::Node &node, const sg::SubMesh &sub_mesh, uint32_t culling_slot) const
+{
+	// Draws culled on the GPU and meshlets have their own first instance
+	if (!transform_buffer || culling_slot != GpuCulling::NO_SLOT || (mesh_shading && can_draw_meshlets(sub_mesh)) ||
+	    !transform_variants.count(&sub_mesh))
+	{
+		return TransformBuffer::NO_SLOT;
+	}
+
+	return transform_buffer->find_slot(node);
+}
+
+void GeometrySubpass::update_views()
+{
+	view_allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ViewUniform));
+
+	auto &view_uniform = view_allocation.emplace<ViewUniform>();
+
+	for (size_t i = 0; i < views.size(); ++i)
+	{
+		auto &view = *views[i];
+
+		view_uniform.view_proj[i] = view.get_pre_rotation() * vkb::vulkan_style_projection(view.get_projection()) * view.get_view();
+	}
+
+	view_allocation.flush();
+}
+
+void GeometrySubpass::bind_views(CommandBuffer &command_buffer)
+{
+	if (!views.empty())
+	{
+		command_buffer.bind_buffer(view_allocation.get_buffer(), view_allocation.get_offset(), view_allocation.get_size(), 0, VIEWS_BINDING, 0);
+	}
+}
+
+const ShaderVariant &GeometrySubpass::get_draw_variant(const sg::SubMesh &sub_mesh) const
+{
+	auto variant_it = draw_variants.find(&sub_mesh);
+	if (variant_it != draw_variants.end())
+	{
+		return variant_it->second;
+	}
+
+	return bindless_materials ? bindless_materials->get_shader_variant(sub_mesh) : sub_mesh.get_shader_variant();
+}
+
+void GeometrySubpass::update_motion_view()
+{
+	auto perspective_camera = dynamic_cast<sg::PerspectiveCamera *>(&camera);
+
+	// The jitter is not motion, only the unjittered projections are compared
+	auto projection = perspective_camera ? perspective_camera->get_unjittered_projection() : camera.get_projection();
+	auto jitter     = perspective_camera ? perspective_camera->get_jitter() : glm::vec2(0.0f);
+
+	auto view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(projection) * camera.get_view();
+
+	previous_motion_view_proj = has_motion_view ? motion_view_proj : view_proj;
+	motion_view_proj          = view_proj;
+	motion_jitter             = glm::vec2(camera.get_pre_rotation() * glm::vec4(jitter, 0.0f, 0.0f));
+	has_motion_view           = true;
+}
+
+void GeometrySubpass::set_texture_streamer(TextureStreamer *texture_streamer_)
+{
+	texture_streamer = texture_streamer_;
+}
+
+void GeometrySubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	scene_changes.clear();
+	moved_nodes.clear();
+
+	bool rebuild = !scene.get_change_journal().read(change_cursor, scene_changes);
+
+	for (auto &change : scene_changes)
+	{
+		switch (change.type)
+		{
+			case sg::ChangeType::Transform:
+				if (change.node->has_component<sg::Mesh>())
+				{
+					moved_nodes.push_back(change.node);
+				}
+				break;
+			case sg::ChangeType::Material:
+				compile_materials(static_cast<const sg::Material *>(change.component));
+
+				// The bundles recorded the parameters of the material
+				invalidate_static_content();
+				break;
+			case sg::ChangeType::MeshAdded:
+			case sg::ChangeType::MeshRemoved:
+				rebuild = true;
+				break;
+		}
+	}
+
+	if (rebuild)
+	{
+		meshes = scene.get_components<sg::Mesh>();
+
+		update_draw_variants();
+
+		materials_outdated = true;
+
+		// The buffers of the submeshes may have changed as well
+		std::lock_guard<std::mutex> guard{vertex_input_mutex};
+		vertex_inputs.clear();
+
+		culling_revision   = ~0ull;
+		transform_revision = ~0ull;
+
+		invalidate_static_content();
+	}
+	else if (!moved_nodes.empty() && has_static_content())
+	{
+		// The bundles recorded the world matrices of the nodes
+		invalidate_static_content();
+	}
+
+	if (materials_outdated)
+	{
+		material_draws.clear();
+		compile_materials();
+
+		materials_outdated = false;
+	}
+
+	if (transform_buffer)
+	{
+		if (transform_revision == scene.get_revision())
+		{
+			transform_buffer->update_nodes(moved_nodes);
+		}
+		else
+		{
+			std::vector<sg::Node *> mesh_nodes;
+
+			for (auto &mesh : meshes)
+			{
+				mesh_nodes.insert(mesh_nodes.end(), mesh->get_nodes().begin(), mesh->get_nodes().end());
+			}
+
+			transform_buffer->set_nodes(mesh_nodes);
+
+			transform_revision = scene.get_revision();
+		}
+	}
+
+	if (!gpu_culling)
+	{
+		return;
+	}
+
+	if (culling_revision == scene.get_revision())
+	{
+		gpu_culling->update_nodes(moved_nodes);
+	}
+	else
+	{
+		culling_instances.clear();
+
+		for (auto &mesh : meshes)
+		{
+			for (auto &node : mesh->get_nodes())
+			{
+				for (auto &sub_mesh : mesh->get_submeshes())
+				{
+					if (sub_mesh->has_geometry())
+					{
+						culling_instances.emplace_back(node, sub_mesh);
+					}
+				}
+			}
+		}
+
+		gpu_culling->set_instances(culling_instances);
+
+		culling_revision = scene.get_revision();
+	}
+
+	auto view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+
+	if (gpu_culling->is_using_occlusion_culling())
+	{
+		gpu_culling->cull_occluders(command_buffer, view_proj);
+
+		gpu_culling->begin_depth_prepass(command_buffer, render_context.get_active_frame().get_render_target().get_extent());
+
+		draw_depth_prepass(command_buffer);
+
+		gpu_culling->end_depth_prepass(command_buffer);
+	}
+
+	gpu_culling->cull(command_buffer, view_proj);
+}
+
+void GeometrySubpass::draw_depth_prepass(CommandBuffer &command_buffer)
+{
+	auto &resource_cache = command_buffer.get_device().get_resource_cache();
+
+	for (auto &instance : culling_instances)
+	{
+		auto &node     = *instance.first;
+		auto &sub_mesh = *instance.second;
+
+		auto slot = gpu_culling->find_slot(node, sub_mesh);
+
+		// Blended and masked draws do not hide what is behind them
+		if (slot == GpuCulling::NO_SLOT || sub_mesh.get_material()->alpha_mode != sg::AlphaMode::Opaque)
+		{
+			continue;
+		}
+
+		update_uniform(command_buffer, node);
+
+		auto &variant = get_draw_variant(sub_mesh);
+
+		auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+
+		auto &pipeline_layout = prepare_pipeline_layout(command_buffer, {&vert_shader_module});
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		const auto &scale      = node.get_transform().get_scale();
+		VkFrontFace front_face = scale.x * scale.y * scale.z < 0 ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		prepare_pipeline_state(command_buffer, front_face, sub_mesh.get_material()->double_sided);
+
+		// The pre-pass depth is single sampled
+		command_buffer.set_multisample_state(MultisampleState{});
+		command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+		bind_vertex_input(command_buffer, pipeline_layout, sub_mesh);
+
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
+
+		gpu_culling->draw_occluder(command_buffer, slot);
+	}
+}
+
+uint64_t GeometrySubpass::get_content_revision() const
+{
+	// Both revisions only increase, so does their sum when the scene changes
+	return Subpass::get_content_revision() + scene.get_revision();
+}
+
+bool GeometrySubpass::is_recording_in_parallel()
+{
+	// Every thread of the job system needs its own resources in the frame
+	return job_system && render_context.get_active_frame().get_thread_count() >= job_system->get_thread_count();
+}
+
+void GeometrySubpass::draw_parallel(CommandBuffer &primary_command_buffer,
+                                    const CpuCulling::DrawList &opaque_nodes,
+                                    const CpuCulling::DrawList &transparent_nodes)
+{
+	const auto &queue      = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	auto        reset_mode = primary_command_buffer.get_reset_mode();
+
+	// Secondary command buffers do not inherit the dynamic state of the primary
+	auto extent = get_render_area();
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+
+	auto opaque_chunks      = (opaque_nodes.size() + draws_per_command_buffer - 1) / draws_per_command_buffer;
+	auto transparent_chunks = (transparent_nodes.size() + draws_per_command_buffer - 1) / draws_per_command_buffer;
+
+	// Jobs may finish in any order, each one stores its buffer at the index of its chunk
+	std::vector<CommandBuffer *> secondary_command_buffers(opaque_chunks + transparent_chunks, nullptr);
+
+	JobSystem::TaskGroup recording_group{*job_system};
+
+	for (size_t chunk = 0; chunk < secondary_command_buffers.size(); ++chunk)
+	{
+		recording_group.run([&, chunk]() {
+			bool transparent = chunk >= opaque_chunks;
+			auto &nodes      = transparent ? transparent_nodes : opaque_nodes;
+			auto first       = (transparent ? chunk - opaque_chunks : chunk) * draws_per_command_buffer;
+			auto last        = std::min(nodes.size(), first + draws_per_command_buffer);
+
+			auto  thread_index   = JobSystem::get_thread_index();
+			auto &thread_context = render_context.get_active_frame().get_thread_context(thread_index);
+
+			auto &secondary_command_buffer = thread_context.request_command_buffer(queue, reset_mode, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+			secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &primary_command_buffer);
+
+			secondary_command_buffer.set_viewport(0, {viewport});
+			secondary_command_buffer.set_scissor(0, {scissor});
+
+			bind_views(secondary_command_buffer);
+
+			record_common_state(secondary_command_buffer);
+
+			if (transparent)
+			{
+				set_transparent_state(secondary_command_buffer);
+			}
+
+			draw_nodes(secondary_command_buffer, nodes, first, last, transparent, thread_index);
+
+			secondary_command_buffer.end();
+
+			secondary_command_buffers[chunk] = &secondary_command_buffer;
+		});
+	}
+
+	recording_group.wait();
+
+	if (!secondary_command_buffers.empty())
+	{
+		primary_command_buffer.execute_commands(secondary_command_buffers);
+	}
+}
+
+void GeometrySubpass::record_common_state(CommandBuffer &command_buffer)
+{
+}
+
+void GeometrySubpass::draw_nodes(CommandBuffer &command_buffer, const CpuCulling::DrawList &nodes, size_t first, size_t last, bool transparent, size_t thread_index)
+{
+	if ((multi_draw_indirect || automatic_instancing) && (!transparent || !ordered_transparency))
+	{
+		draw_nodes_grouped(command_buffer, nodes, first, last, thread_index);
+		return;
+	}
+
+	for (size_t i = first; i < last; ++i)
+	{
+		auto &node     = *nodes[i].first;
+		auto &sub_mesh = *nodes[i].second;
+
+		auto culling_slot   = gpu_culling ? gpu_culling->find_slot(node, sub_mesh) : GpuCulling::NO_SLOT;
+		auto lod_level      = get_lod_level(node, sub_mesh);
+		auto transform_slot = get_transform_slot(node, sub_mesh, culling_slot);
+
+		if (transform_slot == TransformBuffer::NO_SLOT)
+		{
+			update_uniform(command_buffer, node, thread_index);
+		}
+
+		if (transparent)
+		{
+			draw_submesh(command_buffer, sub_mesh, VK_FRONT_FACE_COUNTER_CLOCKWISE, culling_slot, lod_level, thread_index, transform_slot);
+			continue;
+		}
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale      = node.get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		draw_submesh(command_buffer, sub_mesh, front_face, culling_slot, lod_level, thread_index, transform_slot);
+	}
+}
+
+bool GeometrySubpass::can_multi_draw(const DrawGroup &group, const sg::SubMesh &sub_mesh, VkFrontFace front_face, int32_t &vertex_offset) const
+{
+	auto &group_sub_mesh = *group.sub_mesh;
+
+	auto &variant       = get_draw_variant(sub_mesh);
+	auto &group_variant = get_draw_variant(group_sub_mesh);
+
+	if (group.front_face != front_face || variant.get_id() != group_variant.get_id() ||
+	    sub_mesh.get_material() != group_sub_mesh.get_material() ||
+	    sub_mesh.vertex_arena != group_sub_mesh.vertex_arena || sub_mesh.index_arena != group_sub_mesh.index_arena ||
+	    sub_mesh.index_offset != group_sub_mesh.index_offset || sub_mesh.index_type != group_sub_mesh.index_type ||
+	    sub_mesh.vertex_arena_offsets.size() != group_sub_mesh.vertex_arena_offsets.size())
+	{
+		return false;
+	}
+
+	// The vertices are bound at the offsets of the group, so every attribute of the draw must be the same number of vertices away
+	bool has_offset = false;
+
+	for (auto &arena_offset : sub_mesh.vertex_arena_offsets)
+	{
+		auto group_offset_it = group_sub_mesh.vertex_arena_offsets.find(arena_offset.first);
+
+		sg::VertexAttribute attribute;
+		sg::VertexAttribute group_attribute;
+
+		if (group_offset_it == group_sub_mesh.vertex_arena_offsets.end() ||
+		    !sub_mesh.get_attribute(arena_offset.first, attribute) || !group_sub_mesh.get_attribute(arena_offset.first, group_attribute) ||
+		    attribute.format != group_attribute.format || attribute.stride != group_attribute.stride || attribute.stride == 0)
+		{
+			return false;
+		}
+
+		auto delta = static_cast<int64_t>(arena_offset.second + attribute.offset) - static_cast<int64_t>(group_offset_it->second + group_attribute.offset);
+
+		if (delta % attribute.stride != 0)
+		{
+			return false;
+		}
+
+		auto attribute_vertex_offset = delta / attribute.stride;
+
+		if (attribute_vertex_offset < std::numeric_limits<int32_t>::min() || attribute_vertex_offset > std::numeric_limits<int32_t>::max() ||
+		    (has_offset && attribute_vertex_offset != vertex_offset))
+		{
+			return false;
+		}
+
+		vertex_offset = static_cast<int32_t>(attribute_vertex_offset);
+		has_offset    = true;
+	}
+
+	return has_offset;
+}
+
+void GeometrySubpass::draw_nodes_grouped(CommandBuffer &command_buffer, const CpuCulling::DrawList &nodes, size_t first, size_t last, size_t thread_index)
+{
+	std::vector<DrawGroup> groups;
+
+	for (size_t i = first; i < last; ++i)
+	{
+		auto &node     = *nodes[i].first;
+		auto &sub_mesh = *nodes[i].second;
+
+		auto culling_slot = gpu_culling ? gpu_culling->find_slot(node, sub_mesh) : GpuCulling::NO_SLOT;
+		auto lod_level    = get_lod_level(node, sub_mesh);
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale      = node.get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		// Draws culled on the GPU already have their command, meshlets are culled by their own task shader workgroups
+		if (culling_slot != GpuCulling::NO_SLOT || sub_mesh.vertex_indices == 0 || (mesh_shading && can_draw_meshlets(sub_mesh)))
+		{
+			update_uniform(command_buffer, node, thread_index);
 
-namespace vkb
-{
-GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
-    Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
-    meshes{scene_.get_components<sg::Mesh>()},
-    camera{camera},
-    scene{scene_}
+			draw_submesh(command_buffer, sub_mesh, front_face, culling_slot, lod_level, thread_index);
+			continue;
+		}
+
+		auto model          = node.get_transform().get_world_matrix();
+		auto previous_model = node.get_transform().get_previous_world_matrix();
+
+		if (lod_level > sub_mesh.lods.size())
+		{
+			lod_level = 0;
+		}
+
+		std::pair<const sg::SubMesh *, uint32_t> command_draw{&sub_mesh, lod_level};
+
+		if (automatic_instancing)
+		{
+			auto group_it = std::find_if(groups.begin(), groups.end(), [&](const DrawGroup &group) {
+				return group.front_face == front_face &&
+				       std::find(group.command_draws.begin(), group.command_draws.end(), command_draw) != group.command_draws.end();
+			});
+
+			if (group_it != groups.end())
+			{
+				auto command_it    = std::find(group_it->command_draws.begin(), group_it->command_draws.end(), command_draw);
+				auto command_index = static_cast<size_t>(std::distance(group_it->command_draws.begin(), command_it));
+
+				group_it->commands[command_index].instance_count++;
+				group_it->command_models[command_index].push_back(model);
+				group_it->command_previous_models[command_index].push_back(previous_model);
+				continue;
+			}
+		}
+
+		VkDrawIndexedIndirectCommand command{};
+		command.index_count    = lod_level > 0 ? sub_mesh.lods[lod_level - 1].index_count : sub_mesh.vertex_indices;
+		command.instance_count = 1;
+		command.first_index    = lod_level > 0 ? sub_mesh.lods[lod_level - 1].first_index : sub_mesh.first_index;
+
+		auto group_it = groups.end();
+
+		if (multi_draw_indirect)
+		{
+			group_it = std::find_if(groups.begin(), groups.end(), [&](const DrawGroup &group) {
+				return can_multi_draw(group, sub_mesh, front_face, command.vertex_offset);
+			});
+		}
+
+		if (group_it == groups.end())
+		{
+			groups.push_back({&sub_mesh, &node, front_face, {}, {}, {}, {}});
+			group_it = std::prev(groups.end());
+
+			command.vertex_offset = 0;
+		}
+
+		group_it->commands.push_back(command);
+		group_it->command_draws.push_back(command_draw);
+		group_it->command_models.push_back({model});
+		group_it->command_previous_models.push_back({previous_model});
+	}
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	for (auto &group : groups)
+	{
+		auto &sub_mesh = *group.sub_mesh;
+
+		// The view of the uniform is shared, the model matrices come from the buffer
+		update_uniform(command_buffer, *group.node, thread_index);
+
+		ShaderVariant variant = get_draw_variant(sub_mesh);
+		variant.add_define("INSTANCE_MODELS");
+
+		prepare_submesh_draw(command_buffer, sub_mesh, group.front_face, variant);
+
+		// The instances of each command are consecutive models
+		std::vector<glm::mat4> models;
+
+		for (size_t i = 0; i < group.commands.size(); ++i)
+		{
+			group.commands[i].first_instance = to_u32(models.size());
+
+			models.insert(models.end(), group.command_models[i].begin(), group.command_models[i].end());
+		}
+
+		auto model_size       = models.size() * sizeof(glm::mat4);
+		auto model_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, model_size, thread_index);
+		model_allocation.write(reinterpret_cast<const uint8_t *>(models.data()), model_size);
+
+		command_buffer.bind_buffer(model_allocation.get_buffer(), model_allocation.get_offset(), model_allocation.get_size(), 0, 7, 0);
+
+		if (motion_vectors)
+		{
+			std::vector<glm::mat4> previous_models;
+			previous_models.reserve(models.size());
+
+			for (auto &command_previous_models : group.command_previous_models)
+			{
+				previous_models.insert(previous_models.end(), command_previous_models.begin(), command_previous_models.end());
+			}
+
+			auto previous_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, model_size, thread_index);
+			previous_allocation.write(reinterpret_cast<const uint8_t *>(previous_models.data()), model_size);
+
+			command_buffer.bind_buffer(previous_allocation.get_buffer(), previous_allocation.get_offset(), previous_allocation.get_size(), 0, PREVIOUS_MODELS_BINDING, 0);
+		}
+
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
+
+		if (!multi_draw_indirect)
+		{
+			// Without multi-draw, a group is the instances of a single submesh
+			auto &command = group.commands.front();
+
+			command_buffer.draw_indexed(command.index_count, command.instance_count, command.first_index, command.vertex_offset, command.first_instance);
+			continue;
+		}
+
+		auto command_size       = group.commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+		auto command_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, command_size, thread_index);
+		command_allocation.write(reinterpret_cast<const uint8_t *>(group.commands.data()), command_size);
+
+		command_buffer.draw_indexed_indirect(command_allocation.get_buffer(), command_allocation.get_offset(), to_u32(group.commands.size()), to_u32(sizeof(VkDrawIndexedIndirectCommand)));
+	}
+}
+
+float GeometrySubpass::get_screen_size(const sg::Node &node) const
 {
+	auto camera_position = glm::vec3(camera.get_node()->get_transform().get_world_matrix()[3]);
+
+	// Scale from the ratio of the radius to the distance, to the ratio of the diameter to the screen height
+	float projection_scale = camera.get_projection()[1][1];
+
+	auto &mesh_bounds  = node.get_component<sg::Mesh>().get_bounds();
+	auto  world_matrix = node.get_transform().get_world_matrix();
+
+	sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
+	world_bounds.transform(world_matrix);
+
+	float radius   = glm::length(world_bounds.get_scale()) * 0.5f;
+	float distance = glm::length(camera_position - world_bounds.get_center());
+
+	return distance > radius ? radius * projection_scale / distance : std::numeric_limits<float>::max();
 }
 
-void GeometrySubpass::prepare()
+void GeometrySubpass::update_lod_levels(const CpuCulling::DrawList &nodes)
 {
-	// Build all shader variance upfront
-	auto &device = render_context.get_device();
-	for (auto &mesh : meshes)
+	for (auto &node_it : nodes)
 	{
-		for (auto &sub_mesh : mesh->get_submeshes())
+		auto &node     = *node_it.first;
+		auto &sub_mesh = *node_it.second;
+
+		if (sub_mesh.lods.empty() || !node.has_component<sg::Mesh>())
+		{
+			continue;
+		}
+
+		float screen_size = get_screen_size(node);
+
+		auto &lod_level = lod_levels[{&node, &sub_mesh}];
+
+		// Crossing the switch to a coarser level needs a smaller size than crossing it back
+		uint32_t level = 0;
+		while (level < sub_mesh.lods.size() &&
+		       screen_size < sub_mesh.lods[level].max_screen_size * (lod_level > level ? 1.0f + LOD_HYSTERESIS : 1.0f - LOD_HYSTERESIS))
 		{
-			auto &variant     = sub_mesh->get_shader_variant();
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+			++level;
 		}
+
+		lod_level = level;
 	}
 }
 
-void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+void GeometrySubpass::request_texture_levels(const CpuCulling::DrawList &nodes)
 {
-	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+	auto screen_height = static_cast<float>(render_context.get_surface_extent().height);
 
-	for (auto &mesh : meshes)
+	for (auto &node_it : nodes)
 	{
-		for (auto &node : mesh->get_nodes())
-		{
-			auto node_transform = node->get_transform().get_world_matrix();
+		auto &node     = *node_it.first;
+		auto &sub_mesh = *node_it.second;
 
-			const sg::AABB &mesh_bounds = mesh->get_bounds();
+		auto material = sub_mesh.get_material();
+
+		if (!material || !node.has_component<sg::Mesh>())
+		{
+			continue;
+		}
 
-			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
-			world_bounds.transform(node_transform);
+		// A texture spread over the projected bounds needs about one texel per pixel
+		float screen_pixels = std::max(get_screen_size(node) * screen_height, 1.0f);
 
-			float distance = glm::length(glm::vec3(camera_transform[3]) - world_bounds.get_center());
+		for (auto &texture_it : material->textures)
+		{
+			auto image = texture_it.second->get_image();
 
-			for (auto &sub_mesh : mesh->get_submeshes())
+			if (!image)
 			{
-				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
-				{
-					transparent_nodes.emplace(distance, std::make_pair(node, sub_mesh));
-				}
-				else
-				{
-					opaque_nodes.emplace(distance, std::make_pair(node, sub_mesh));
-				}
+				continue;
 			}
+
+			auto &extent     = image->get_extent();
+			float texel_size = static_cast<float>(std::max(extent.width, extent.height));
+
+			auto level = static_cast<uint32_t>(std::max(std::floor(std::log2(texel_size / screen_pixels)), 0.0f));
+
+			texture_streamer->request_level(*image, std::min(level, to_u32(image->get_mipmaps().size()) - 1));
 		}
 	}
 }
 
-void GeometrySubpass::draw(CommandBuffer &command_buffer)
+uint32_t GeometrySubpass::get_lod_level(const sg::Node &node, const sg::SubMesh &sub_mesh) const
 {
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
-
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
-
-	// Draw opaque objects in front-to-back order
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
+	if (sub_mesh.lods.empty())
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		return 0;
+	}
 
-		// Invert the front face if the mesh was flipped
-		const auto &scale      = node_it->second.first->get_transform().get_scale();
-		bool        flipped    = scale.x * scale.y * scale.z < 0;
-		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	auto lod_it = lod_levels.find({&node, &sub_mesh});
 
-		draw_submesh(command_buffer, *node_it->second.second, front_face);
-	}
+	return lod_it == lod_levels.end() ? 0 : lod_it->second;
+}
 
+void GeometrySubpass::set_transparent_state(CommandBuffer &command_buffer)
+{
 	// Enable alpha blending
 	ColorBlendAttachmentState color_blend_attachment{};
 	color_blend_attachment.blend_enable           = VK_TRUE;
@@ -112,44 +1316,106 @@ void GeometrySubpass::draw(CommandBuffer &command_buffer)
 	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 
-	ColorBlendState color_blend_state{};
-	color_blend_state.attachments.resize(get_output_attachments().size());
+	// Each recording thread reuses the attachment states, this runs in every frame
+	thread_local ColorBlendState color_blend_state;
+	color_blend_state.attachments.assign(get_output_attachments().size(), ColorBlendAttachmentState{});
 	color_blend_state.attachments[0] = color_blend_attachment;
 	command_buffer.set_color_blend_state(color_blend_state);
 
 	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
-
-	// Draw transparent objects in back-to-front order
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
-	{
-		update_uniform(command_buffer, *node_it->second.first);
-
-		draw_submesh(command_buffer, *node_it->second.second);
-	}
 }
 
 void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
 {
-	GlobalUniform global_uniform;
-
-	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
-
 	auto &render_frame = get_render_context().get_active_frame();
 
 	auto &transform = node.get_transform();
 
-	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, motion_vectors ? sizeof(MotionGlobalUniform) : sizeof(GlobalUniform), thread_index);
+
+	// The motion uniform starts with the global uniform, written below
+	if (motion_vectors)
+	{
+		auto &motion_uniform = allocation.emplace<MotionGlobalUniform>();
+
+		motion_uniform.previous_model            = transform.get_previous_world_matrix();
+		motion_uniform.previous_camera_view_proj = previous_motion_view_proj;
+		motion_uniform.camera_jitter             = motion_jitter;
+	}
+
+	// Written straight into the mapped buffer, as this runs for every node in every frame
+	auto &global_uniform = allocation.emplace<GlobalUniform>();
+
+	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
 
 	global_uniform.model = transform.get_world_matrix();
 
 	global_uniform.camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
 
-	allocation.update(global_uniform);
+	allocation.flush();
 
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
 }
 
-void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t culling_slot, uint32_t lod_level, size_t thread_index,
+                                   uint32_t transform_slot)
+{
+	auto &variant = get_draw_variant(sub_mesh);
+
+	if (mesh_shading && culling_slot == GpuCulling::NO_SLOT && can_draw_meshlets(sub_mesh))
+	{
+		draw_meshlets(command_buffer, sub_mesh, front_face, variant, thread_index);
+		return;
+	}
+
+	if (transform_slot != TransformBuffer::NO_SLOT)
+	{
+		// Bindings of equal ranges are not flushed again, the draws only differ by their first instance
+		command_buffer.bind_buffer(transform_allocation.get_buffer(), transform_allocation.get_offset(), transform_allocation.get_size(), 0, 1, 0);
+		transform_buffer->bind(command_buffer, 0, TRANSFORMS_BINDING);
+
+		prepare_submesh_draw(command_buffer, sub_mesh, front_face, transform_variants.at(&sub_mesh));
+
+		auto index_count = lod_level > 0 && lod_level <= sub_mesh.lods.size() ? sub_mesh.lods[lod_level - 1].index_count : sub_mesh.vertex_indices;
+		auto first_index = lod_level > 0 && lod_level <= sub_mesh.lods.size() ? sub_mesh.lods[lod_level - 1].first_index : sub_mesh.first_index;
+
+		if (sub_mesh.vertex_indices != 0)
+		{
+			command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
+
+			command_buffer.draw_indexed(index_count, 1, first_index, 0, transform_slot);
+		}
+		else
+		{
+			command_buffer.draw(sub_mesh.vertices_count, 1, 0, transform_slot);
+		}
+		return;
+	}
+
+	prepare_submesh_draw(command_buffer, sub_mesh, front_face, variant);
+
+	if (culling_slot != GpuCulling::NO_SLOT)
+	{
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
+
+		gpu_culling->draw(command_buffer, culling_slot);
+	}
+	else if (lod_level > 0 && lod_level <= sub_mesh.lods.size())
+	{
+		auto &lod = sub_mesh.lods[lod_level - 1];
+
+		// The levels share the index buffer and vertices of the submesh
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
+
+		command_buffer.draw_indexed(lod.index_count, 1, lod.first_index, 0, 0);
+	}
+	else
+	{
+		draw_submesh_command(command_buffer, sub_mesh);
+	}
+}
+
+void GeometrySubpass::prepare_submesh_draw(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &variant)
 {
 	auto &device = command_buffer.get_device();
 
@@ -159,34 +1425,203 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 	multisample_state.rasterization_samples = sample_count;
 	command_buffer.set_multisample_state(multisample_state);
 
-	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), sub_mesh.get_shader_variant());
-	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh.get_shader_variant());
+	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
 
-	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+	// Each recording thread reuses its vector, this runs for every draw
+	thread_local std::vector<ShaderModule *> shader_modules;
+	shader_modules.assign({&vert_shader_module, &frag_shader_module});
 
 	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
 
 	command_buffer.bind_pipeline_layout(pipeline_layout);
 
-	prepare_push_constants(command_buffer, sub_mesh);
+	bind_material(command_buffer, pipeline_layout, sub_mesh);
+
+	bind_vertex_input(command_buffer, pipeline_layout, sub_mesh);
+}
+
+void GeometrySubpass::bind_material(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, sg::SubMesh &sub_mesh)
+{
+	if (bindless_materials)
+	{
+		// The table is bound once per pipeline layout, the draw only selects its material
+		command_buffer.bind_descriptor_set(BindlessMaterials::SET_INDEX, bindless_materials->get_descriptor_set());
+
+		command_buffer.push_constants(bindless_materials->get_material_index(*sub_mesh.get_material()));
+	}
+	else
+	{
+		prepare_push_constants(command_buffer, sub_mesh);
+
+		auto material_it = material_draws.find(&sub_mesh);
+		if (material_it != material_draws.end())
+		{
+			for (auto &texture : material_it->second.textures)
+			{
+				command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+				                          texture.second->get_sampler()->vk_sampler,
+				                          0, texture.first, 0);
+			}
+			return;
+		}
+
+		// Submeshes which are not in the scene of the subpass look their textures up by name
+		DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+
+		for (auto &texture : sub_mesh.get_material()->textures)
+		{
+			if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+			{
+				command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+				                          texture.second->get_sampler()->vk_sampler,
+				                          0, layout_binding->binding, 0);
+			}
+		}
+	}
+}
 
-	DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+void GeometrySubpass::compile_materials(const sg::Material *material)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
 
-	for (auto &texture : sub_mesh.get_material()->textures)
+	for (auto &mesh : meshes)
 	{
-		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+		for (auto &sub_mesh : mesh->get_submeshes())
 		{
-			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
-			                          texture.second->get_sampler()->vk_sampler,
-			                          0, layout_binding->binding, 0);
+			auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh->get_material());
+
+			if (!pbr_material || (material && pbr_material != material))
+			{
+				continue;
+			}
+
+			// The variants of a submesh only add defines, which keep the bindings of the textures
+			auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh->get_shader_variant());
+
+			MaterialDraw material_draw;
+			material_draw.uniform.base_color_factor = pbr_material->base_color_factor;
+			material_draw.uniform.metallic_factor   = pbr_material->metallic_factor;
+			material_draw.uniform.roughness_factor  = pbr_material->roughness_factor;
+
+			for (auto &resource : frag_shader_module.get_resources())
+			{
+				if (resource.set != 0 || resource.type != ShaderResourceType::ImageSampler)
+				{
+					continue;
+				}
+
+				auto texture_it = pbr_material->textures.find(resource.name);
+				if (texture_it != pbr_material->textures.end())
+				{
+					material_draw.textures.emplace_back(resource.binding, texture_it->second);
+				}
+			}
+
+			material_draws[sub_mesh] = std::move(material_draw);
 		}
 	}
+}
+
+bool GeometrySubpass::can_draw_meshlets(const sg::SubMesh &sub_mesh) const
+{
+	uint32_t offset;
+	uint32_t stride;
+
+	// The meshlet shaders do not project the previous frame nor several views
+	return !motion_vectors && views.empty() && sub_mesh.meshlet_count > 0 && sub_mesh.vertex_arena && sub_mesh.get_material()->alpha_mode != sg::AlphaMode::Blend &&
+	       get_arena_attribute(sub_mesh, "position", VK_FORMAT_R32G32B32_SFLOAT, offset, stride);
+}
+
+void GeometrySubpass::draw_meshlets(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &variant, size_t thread_index)
+{
+#ifdef VK_EXT_mesh_shader
+	auto &device = command_buffer.get_device();
+
+	auto &material = *sub_mesh.get_material();
+
+	prepare_pipeline_state(command_buffer, front_face, material.double_sided);
+
+	auto &task_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_TASK_BIT_EXT, task_shader, variant);
+	auto &mesh_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_MESH_BIT_EXT, mesh_shader, variant);
+	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+	std::vector<ShaderModule *> shader_modules{&task_shader_module, &mesh_shader_module, &frag_shader_module};
+
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	bind_material(command_buffer, pipeline_layout, sub_mesh);
+
+	// The meshlets, their vertex and triangle lists share one buffer
+	auto &meshlet_buffer = *sub_mesh.meshlet_buffer;
+
+	command_buffer.bind_buffer(meshlet_buffer, 0, sub_mesh.meshlet_vertices_offset, 0, 8, 0);
+	command_buffer.bind_buffer(meshlet_buffer, sub_mesh.meshlet_vertices_offset, sub_mesh.meshlet_triangles_offset - sub_mesh.meshlet_vertices_offset, 0, 9, 0);
+	command_buffer.bind_buffer(meshlet_buffer, sub_mesh.meshlet_triangles_offset, meshlet_buffer.get_size() - sub_mesh.meshlet_triangles_offset, 0, 10, 0);
+
+	auto &vertex_buffer = sub_mesh.vertex_arena->buffer;
+
+	command_buffer.bind_buffer(vertex_buffer, 0, vertex_buffer.get_size(), 0, 11, 0);
+
+	auto view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+
+	Frustum frustum;
+	frustum.update(view_proj);
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(MeshletDrawUniform), thread_index);
+
+	auto &meshlet_draw = allocation.emplace<MeshletDrawUniform>();
+
+	std::copy(frustum.get_planes().begin(), frustum.get_planes().end(), meshlet_draw.planes);
+
+	// Recorded bundles are replayed from other views, and double sided materials show their back faces
+	meshlet_draw.meshlet_count   = sub_mesh.meshlet_count;
+	meshlet_draw.frustum_culling = has_static_content() ? 0 : 1;
+	meshlet_draw.cone_culling    = has_static_content() || material.double_sided ? 0 : 1;
+
+	get_arena_attribute(sub_mesh, "position", VK_FORMAT_R32G32B32_SFLOAT, meshlet_draw.position_offset, meshlet_draw.position_stride);
+	get_arena_attribute(sub_mesh, "normal", VK_FORMAT_R32G32B32_SFLOAT, meshlet_draw.normal_offset, meshlet_draw.normal_stride);
+	get_arena_attribute(sub_mesh, "texcoord_0", VK_FORMAT_R32G32_SFLOAT, meshlet_draw.texcoord_offset, meshlet_draw.texcoord_stride);
+
+	allocation.flush();
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 12, 0);
+
+	// Each task shader workgroup culls 32 meshlets and launches a mesh shader workgroup for each visible one
+	command_buffer.draw_mesh_tasks((sub_mesh.meshlet_count + 31) / 32, 1, 1);
+#endif
+}
+
+void GeometrySubpass::bind_vertex_input(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, sg::SubMesh &sub_mesh)
+{
+	auto &vertex_input = request_vertex_input(pipeline_layout, sub_mesh);
+
+	command_buffer.set_vertex_input_state(vertex_input.state);
+
+	for (auto &vertex_buffer : vertex_input.buffers)
+	{
+		// Bind vertex buffers only for the attribute locations defined
+		command_buffer.bind_vertex_buffer(std::get<0>(vertex_buffer), *std::get<1>(vertex_buffer), std::get<2>(vertex_buffer));
+	}
+}
 
-	auto vertex_input_resources = pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
+const GeometrySubpass::VertexInput &GeometrySubpass::request_vertex_input(PipelineLayout &pipeline_layout, const sg::SubMesh &sub_mesh)
+{
+	std::lock_guard<std::mutex> guard{vertex_input_mutex};
+
+	auto vertex_input_it = vertex_inputs.find({&pipeline_layout, &sub_mesh});
+	if (vertex_input_it != vertex_inputs.end())
+	{
+		return vertex_input_it->second;
+	}
 
-	VertexInputState vertex_input_state;
+	auto &vertex_input = vertex_inputs[{&pipeline_layout, &sub_mesh}];
 
-	for (auto &input_resource : vertex_input_resources)
+	for (auto &input_resource : pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT))
 	{
 		sg::VertexAttribute attribute;
 
@@ -201,33 +1636,25 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 		vertex_attribute.location = input_resource.location;
 		vertex_attribute.offset   = attribute.offset;
 
-		vertex_input_state.attributes.push_back(vertex_attribute);
+		vertex_input.state.attributes.push_back(vertex_attribute);
 
 		VkVertexInputBindingDescription vertex_binding{};
 		vertex_binding.binding = input_resource.location;
 		vertex_binding.stride  = attribute.stride;
 
-		vertex_input_state.bindings.push_back(vertex_binding);
-	}
-
-	command_buffer.set_vertex_input_state(vertex_input_state);
+		vertex_input.state.bindings.push_back(vertex_binding);
 
-	// Find submesh vertex buffers matching the shader input attribute names
-	for (auto &input_resource : vertex_input_resources)
-	{
-		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
+		// Find submesh vertex buffers matching the shader input attribute names
+		const core::Buffer *buffer{nullptr};
+		VkDeviceSize        offset{0};
 
-		if (buffer_iter != sub_mesh.vertex_buffers.end())
+		if (sub_mesh.get_vertex_buffer(input_resource.name, buffer, offset))
 		{
-			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-			buffers.emplace_back(std::ref(buffer_iter->second));
-
-			// Bind vertex buffers only for the attribute locations defined
-			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
+			vertex_input.buffers.emplace_back(input_resource.location, buffer, offset);
 		}
 	}
 
-	draw_submesh_command(command_buffer, sub_mesh);
+	return vertex_input;
 }
 
 void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
@@ -252,6 +1679,23 @@ PipelineLayout &GeometrySubpass::prepare_pipeline_layout(CommandBuffer &command_
 	// Sets any specified resource modes
 	for (auto &shader_module : shader_modules)
 	{
+		if (push_descriptors)
+		{
+			shader_module->set_resource_mode(PER_DRAW_RESOURCE, ShaderResourceMode::PushDescriptor);
+		}
+		else
+		{
+			// Modules are shared, restore the mode if push descriptors were used before
+			auto &resources = shader_module->get_resources();
+
+			auto resource_it = std::find_if(resources.begin(), resources.end(), [](const ShaderResource &resource) { return resource.name == PER_DRAW_RESOURCE; });
+
+			if (resource_it != resources.end() && resource_it->mode == ShaderResourceMode::PushDescriptor)
+			{
+				shader_module->set_resource_mode(PER_DRAW_RESOURCE, ShaderResourceMode::Static);
+			}
+		}
+
 		for (auto &resource_mode : resource_mode_map)
 		{
 			shader_module->set_resource_mode(resource_mode.first, resource_mode.second);
@@ -263,19 +1707,23 @@ PipelineLayout &GeometrySubpass::prepare_pipeline_layout(CommandBuffer &command_
 
 void GeometrySubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
 {
-	auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
-
 	PBRMaterialUniform pbr_material_uniform{};
-	pbr_material_uniform.base_color_factor = pbr_material->base_color_factor;
-	pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
-	pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
 
-	auto data = to_bytes(pbr_material_uniform);
-
-	if (!data.empty())
+	auto material_it = material_draws.find(&sub_mesh);
+	if (material_it != material_draws.end())
+	{
+		pbr_material_uniform = material_it->second.uniform;
+	}
+	else
 	{
-		command_buffer.push_constants(data);
+		auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
+
+		pbr_material_uniform.base_color_factor = pbr_material->base_color_factor;
+		pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
+		pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
 	}
+
+	command_buffer.push_constants(pbr_material_uniform);
 }
 
 void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
@@ -283,11 +1731,11 @@ void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::Su
 	// Draw submesh indexed if indices exists
 	if (sub_mesh.vertex_indices != 0)
 	{
-		// Bind index buffer of submesh
-		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
+		// Bind index buffer of submesh, submeshes sharing an index arena keep the same binding
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
 
 		// Draw submesh using indexed data
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, 0);
+		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, sub_mesh.first_index, 0, 0);
 	}
 	else
 	{
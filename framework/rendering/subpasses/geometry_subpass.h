@@ -17,16 +17,28 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include "rendering/bindless_materials.h"
+#include "rendering/cpu_culling.h"
+#include "rendering/gpu_culling.h"
 #include "rendering/subpass.h"
+#include "rendering/transform_buffer.h"
+#include "scene_graph/change_journal.h"
 
 namespace vkb
 {
+class JobSystem;
+class TextureStreamer;
+
 namespace sg
 {
 class Scene;
@@ -34,6 +46,8 @@ class Node;
 class Mesh;
 class SubMesh;
 class Camera;
+class Material;
+class Texture;
 }        // namespace sg
 
 /**
@@ -48,6 +62,22 @@ struct alignas(16) GlobalUniform
 	glm::vec3 camera_position;
 };
 
+/**
+ * @brief Global uniform of the MOTION_VECTORS variant of the geometry shaders, which also projects the previous frame
+ */
+struct alignas(16) MotionGlobalUniform
+{
+	GlobalUniform global;
+
+	glm::mat4 previous_model;
+
+	/// Unjittered view projection of the previous frame
+	glm::mat4 previous_camera_view_proj;
+
+	/// Jitter of the projection in normalized device coordinates, removed from the motion
+	glm::vec2 camera_jitter;
+};
+
 /**
  * @brief PBR material uniform for base shader
  */
@@ -85,10 +115,250 @@ class GeometrySubpass : public Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Records the draws in parallel into secondary command buffers
+	 *        The sorted nodes are split in chunks, each recorded by a job with the frame resources
+	 *        of its thread index. Parallel recording needs a render context prepared with at least
+	 *        JobSystem::get_thread_count() threads, otherwise the subpass records inline.
+	 * @param job_system The job system running the recording, nullptr to record inline
+	 * @param draws_per_command_buffer Maximum number of draws recorded into each secondary command buffer
+	 */
+	void set_parallel_recording(JobSystem *job_system, uint32_t draws_per_command_buffer = DEFAULT_DRAWS_PER_COMMAND_BUFFER);
+
+	bool records_secondary_command_buffers() override;
+
+	/**
+	 * @brief Pushes the set of the per-draw uniform into the command buffer instead of allocating descriptor sets
+	 *        The set skips descriptor pools and the frame descriptor caches. Ignored if the device
+	 *        does not have VK_KHR_push_descriptor enabled.
+	 */
+	void set_push_descriptors(bool enabled);
+
+	bool is_using_push_descriptors() const;
+
+	/**
+	 * @brief Culls the indexed draws against the camera frustum on the GPU before the render pass
+	 *        Culled draws keep their state but draw nothing. The bounds of the nodes which moved
+	 *        are updated from the change journal of the scene, the instances are set again when
+	 *        meshes are added or removed.
+	 */
+	void set_gpu_culling(bool enabled);
+
+	bool is_using_gpu_culling() const;
+
+	/**
+	 * @brief Also culls the draws hidden behind the opaque geometry of the frame, enabling GPU culling
+	 *        The instances visible in the last cull of the frame's buffers are drawn first in a depth pre-pass,
+	 *        at the extent of the render target of the active frame, and the cull tests the bounds against its
+	 *        hierarchical-Z pyramid. Disabling GPU culling disables it as well.
+	 */
+	void set_occlusion_culling(bool enabled);
+
+	bool is_using_occlusion_culling() const;
+
+	/**
+	 * @brief Culls on the compute queue of the render context's async compute, enabling GPU culling
+	 *        Has no effect on the culls testing the occlusion, or on devices without a separate compute family.
+	 */
+	void set_async_culling(bool enabled);
+
+	bool is_using_async_culling() const;
+
+	/**
+	 * @brief Draws the opaque submeshes of the geometry arenas with one indirect multi-draw per group of draws
+	 *        Draws sharing a shader variant, material, front face and arenas are grouped, and each draw reads
+	 *        its model matrix from a buffer by its first instance. Draws culled on the GPU are drawn on their own.
+	 *        The vertex shader must support the INSTANCE_MODELS variant, as base.vert does. Ignored if the device does
+	 *        not have the multiDrawIndirect and drawIndirectFirstInstance features enabled.
+	 */
+	void set_multi_draw_indirect(bool enabled);
+
+	bool is_using_multi_draw_indirect() const;
+
+	/**
+	 * @brief Draws the opaque submeshes drawn at several nodes as one instanced draw, instead of a draw per node
+	 *        The instances of a submesh are drawn at the same level of detail and front face, each reading its model
+	 *        matrix from a buffer by its instance index. With multi-draw indirect, the instanced draws are grouped as well.
+	 *        The vertex shader must support the INSTANCE_MODELS variant, as base.vert does.
+	 */
+	void set_automatic_instancing(bool enabled);
+
+	bool is_using_automatic_instancing() const;
+
+	/**
+	 * @brief Reads the world transforms of the draws from a TransformBuffer kept on the GPU, uploaded only when the nodes move
+	 *        The draws share one uniform per frame, whose view projection leaves out the camera translation: the shaders
+	 *        move the translation of each transform by the camera first, so distant scenes keep their precision. Each draw
+	 *        reads its transform by its first instance. The vertex shader must support the TRANSFORM_BUFFER variant, as
+	 *        base.vert does. Draws culled on the GPU, grouped or drawn with meshlets, and draws with motion vectors or views
+	 *        keep their per-draw uniform.
+	 */
+	void set_persistent_transforms(bool enabled);
+
+	bool is_using_persistent_transforms() const;
+
+	/**
+	 * @brief Culls the draws on the CPU with the bounding volume hierarchy of the scene instead of testing every instance
+	 *        Worth it for large scenes whose nodes mostly stay in place, as moving nodes loosen the refit tree.
+	 */
+	void set_hierarchical_culling(bool enabled);
+
+	bool is_using_hierarchical_culling() const;
+
+	/**
+	 * @brief Reads the textures and materials of the draws from a BindlessMaterials table of the whole scene
+	 *        The draws push the index of their material instead of binding its textures, so they share
+	 *        their descriptor sets. The shaders must support the BINDLESS_MATERIALS variant, as base.frag does.
+	 *        Ignored if the device cannot index the textures of the scene.
+	 */
+	void set_bindless_materials(bool enabled);
+
+	bool is_using_bindless_materials() const;
+
+	/**
+	 * @brief Draws the submeshes with meshlets with task and mesh shaders (VK_EXT_mesh_shader), which cull each meshlet
+	 *        against the frustum, and against its normal cone for single sided materials, before rasterization.
+	 *        The meshlets are generated by GLTFLoader::set_meshlet_generation() and always draw the full detail.
+	 *        Blended draws, draws culled on the GPU and submeshes whose attributes are not 32 bit floats keep the vertex
+	 *        pipeline. The device needs the taskShader and meshShader features, and the shaders SPIR-V 1.4, see
+	 *        GLSLCompiler::set_target_environment().
+	 */
+	void set_mesh_shading(bool enabled);
+
+	bool is_using_mesh_shading() const;
+
+	/**
+	 * @brief Writes the motion of each pixel since the previous frame into the output attachment after the
+	 *        others, in normalized device coordinates, as temporal anti-aliasing reprojects its history with
+	 *        The motion of the nodes comes from the previous world matrices of the TransformHierarchy, the
+	 *        motion of the camera from its unjittered projection. The shaders must support the MOTION_VECTORS
+	 *        variant, as deferred/geometry.vert and deferred/geometry.frag do. Submeshes keep the vertex pipeline
+	 *        with mesh shading.
+	 */
+	void set_motion_vectors(bool enabled);
+
+	bool is_using_motion_vectors() const;
+
+	/**
+	 * @brief Sets the layout of the G-buffer written by the deferred shaders, whose formats the render target must match
+	 *        The shaders must support the variant of the layout, as deferred/geometry.frag does, see gbuffer::Layout.
+	 */
+	void set_gbuffer_layout(gbuffer::Layout layout);
+
+	gbuffer::Layout get_gbuffer_layout() const;
+
+	void set_half_precision(bool enabled) override;
+
+	/**
+	 * @brief Draws the scene from several cameras in one pass with VK_KHR_multiview, each into the layer of the render
+	 *        target of its index, e.g. the eyes of a stereo camera or the faces of a cube map capture
+	 *        The nodes are not frustum culled on the CPU, GPU culling still tests them against the camera of the subpass.
+	 *        The shaders must support the MULTIVIEW variant, as base.vert does, and the device multiview, see
+	 *        Device::supports_multiview(). Submeshes keep the vertex pipeline with mesh shading.
+	 * @param views Up to MAX_VIEWS cameras, none to draw the camera of the subpass only
+	 */
+	void set_views(const std::vector<sg::Camera *> &views);
+
+	const std::vector<sg::Camera *> &get_views() const;
+
+	/**
+	 * @brief Requests the mip levels of the textures of the drawn submeshes from a texture streamer, each frame
+	 *        The level is estimated from the projected size of the bounding sphere of the mesh.
+	 */
+	void set_texture_streamer(TextureStreamer *texture_streamer);
+
+	/**
+	 * @brief Reads the changes of the scene since the last frame, then writes the draw commands of the frame
+	 *        when GPU culling is enabled, after the depth pre-pass of occlusion culling
+	 */
+	void pre_draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @return The revision of the static content, which also changes with the revision of the scene
+	 */
+	uint64_t get_content_revision() const override;
+
+	static constexpr uint32_t DEFAULT_DRAWS_PER_COMMAND_BUFFER = 64;
+
+	/// Fraction of the screen size of a level of detail switch by which an instance must cross it to switch again
+	static constexpr float LOD_HYSTERESIS = 0.1f;
+
+	/// Binding of the previous model matrices of the instances, in the MOTION_VECTORS variant with INSTANCE_MODELS
+	static constexpr uint32_t PREVIOUS_MODELS_BINDING = 13;
+
+	/// Views of the MULTIVIEW variant, the minimum maxMultiviewViewCount of the devices
+	static constexpr uint32_t MAX_VIEWS = 6;
+
+	/// Binding of the view projections of the views, in the MULTIVIEW variant
+	static constexpr uint32_t VIEWS_BINDING = 14;
+
+	/// Binding of the world transforms of the nodes, in the TRANSFORM_BUFFER variant
+	static constexpr uint32_t TRANSFORMS_BINDING = 15;
+
+	/// Name of the uniform updated for each draw, whose set is pushed with push descriptors
+	static constexpr const char *PER_DRAW_RESOURCE = "GlobalUniform";
+
   protected:
+	/**
+	 * @brief Records the state shared by every draw of the subpass
+	 *        Called on each command buffer the draws are recorded into, as secondary command buffers
+	 *        do not inherit the bindings of the primary.
+	 */
+	virtual void record_common_state(CommandBuffer &command_buffer);
+
 	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0);
 
-	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	/**
+	 * @param culling_slot Slot of the draw in the GPU culling pass, GpuCulling::NO_SLOT to draw it directly
+	 * @param lod_level Level of detail drawn, 0 for the full detail, ignored for draws culled on the GPU or drawn with meshlets
+	 * @param transform_slot Slot of the node in the transform buffer, TransformBuffer::NO_SLOT for a draw with its own uniform
+	 */
+	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+	                  uint32_t culling_slot = GpuCulling::NO_SLOT, uint32_t lod_level = 0, size_t thread_index = 0,
+	                  uint32_t transform_slot = TransformBuffer::NO_SLOT);
+
+	/**
+	 * @brief Sets the pipeline state, shaders, material and vertex input of a submesh, for the draw that follows
+	 */
+	void prepare_submesh_draw(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &variant);
+
+	/**
+	 * @brief Selects the level of detail of the draws of submeshes with levels, from the projected size of their bounding sphere
+	 *        A draw switches level once it is past the screen size of the switch by LOD_HYSTERESIS, so it does not flicker
+	 *        between two levels around it.
+	 */
+	void update_lod_levels(const CpuCulling::DrawList &nodes);
+
+	/**
+	 * @return The ratio of the projected diameter of the bounding sphere of a node with a mesh to the screen height
+	 */
+	float get_screen_size(const sg::Node &node) const;
+
+	/**
+	 * @brief Requests the levels of the textures of the draws from the texture streamer
+	 */
+	void request_texture_levels(const CpuCulling::DrawList &nodes);
+
+	/**
+	 * @return The level of detail selected for a draw
+	 */
+	uint32_t get_lod_level(const sg::Node &node, const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Draws the nodes in [first, last), opaque nodes get their front face inverted if flipped
+	 */
+	void draw_nodes(CommandBuffer &command_buffer, const CpuCulling::DrawList &nodes, size_t first, size_t last, bool transparent, size_t thread_index = 0);
+
+	/**
+	 * @brief Enables alpha blending and the subpass depth stencil state for transparent draws
+	 */
+	virtual void set_transparent_state(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Draws the transparent submeshes back-to-front when ordered, otherwise leaves them unsorted and groups them
+	 *        like the opaque ones. Only for subclasses whose transparent blending does not depend on the draw order.
+	 */
+	void set_ordered_transparency(bool ordered);
 
 	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material);
 
@@ -99,17 +369,248 @@ class GeometrySubpass : public Subpass
 	virtual void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
 
 	/**
-	 * @brief Sorts objects based on distance from camera and classifies them
-	 *        into opaque and transparent in the arrays provided
+	 * @brief Culls the objects outside of the camera frustum, sorts the others based on distance
+	 *        from camera and classifies them into opaque and transparent in the arrays provided
+	 *        Opaque objects are sorted front-to-back and transparent objects back-to-front. The
+	 *        frustum test is skipped when the draws are culled on the GPU or recorded once as
+	 *        static content. The objects are culled in parallel on the job system of the parallel recording.
+	 */
+	void get_sorted_nodes(CpuCulling::DrawList &opaque_nodes, CpuCulling::DrawList &transparent_nodes);
+
+	/**
+	 * @return The shader variant a submesh is drawn with, for its material table, motion vectors and views
 	 */
-	void get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
-	                      std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+	const ShaderVariant &get_draw_variant(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Adds the MOTION_VECTORS, MULTIVIEW, G-buffer layout and precision definitions to the variant of each submesh,
+	 *        before the draws read them from any thread. Called again by subclasses changing the variants.
+	 */
+	void update_draw_variants();
 
 	sg::Camera &camera;
 
 	std::vector<sg::Mesh *> meshes;
 
 	sg::Scene &scene;
+
+  private:
+	bool is_recording_in_parallel();
+
+	/**
+	 * @brief Writes the view projections of the views of the frame, bound by bind_views()
+	 */
+	void update_views();
+
+	void bind_views(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Uploads the transforms which moved and writes the camera-relative uniform shared by the draws of the frame
+	 */
+	void update_transforms();
+
+	/**
+	 * @return The slot of the transform a draw reads, TransformBuffer::NO_SLOT if it updates its own uniform
+	 */
+	uint32_t get_transform_slot(const sg::Node &node, const sg::SubMesh &sub_mesh, uint32_t culling_slot) const;
+
+	/**
+	 * @brief Keeps the unjittered view projection of the previous frame and computes the one of this frame
+	 */
+	void update_motion_view();
+
+	/**
+	 * @brief Sets the vertex input state of a pipeline layout and binds the matching vertex buffers of a submesh
+	 *        Both are resolved from the names of the attributes on the first draw of the submesh with the layout.
+	 */
+	void bind_vertex_input(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, sg::SubMesh &sub_mesh);
+
+	/**
+	 * @brief Compiles the materials of the submeshes for their draws, resolving the bindings of their textures
+	 *        in the fragment shader of each submesh
+	 * @param material Only compiles the submeshes with this material if not null
+	 */
+	void compile_materials(const sg::Material *material = nullptr);
+
+	/**
+	 * @brief Binds the material of a submesh, as push constants and textures or as an index in the bindless table
+	 */
+	void bind_material(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, sg::SubMesh &sub_mesh);
+
+	/**
+	 * @return Whether a submesh is drawn with its meshlets
+	 */
+	bool can_draw_meshlets(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Draws the meshlets of a submesh, a task shader workgroup culls up to 32 of them
+	 */
+	void draw_meshlets(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const ShaderVariant &variant, size_t thread_index);
+
+	/**
+	 * @brief Draws the depth of the opaque instances with the occluder commands of the GPU culling
+	 */
+	void draw_depth_prepass(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Opaque draws recorded with the state of a single submesh, as instanced draws or an indirect multi-draw
+	 */
+	struct DrawGroup
+	{
+		/// Submesh whose state is set for the whole group
+		sg::SubMesh *sub_mesh;
+
+		/// Node of the first draw, whose uniform is bound for the whole group
+		sg::Node *node;
+
+		VkFrontFace front_face;
+
+		/// Commands of the group, their first instance is set when the models are written
+		std::vector<VkDrawIndexedIndirectCommand> commands;
+
+		/// Submesh and level of detail drawn by each command
+		std::vector<std::pair<const sg::SubMesh *, uint32_t>> command_draws;
+
+		/// Model matrices of the instances of each command
+		std::vector<std::vector<glm::mat4>> command_models;
+
+		/// Model matrices of the previous frame of the instances of each command, with motion vectors
+		std::vector<std::vector<glm::mat4>> command_previous_models;
+	};
+
+	/**
+	 * @return Whether a draw can join a multi-draw group, as it only differs by its indices, vertex offset and model matrix
+	 * @param[out] vertex_offset The vertex offset of the draw, relative to the vertices bound for the group
+	 */
+	bool can_multi_draw(const DrawGroup &group, const sg::SubMesh &sub_mesh, VkFrontFace front_face, int32_t &vertex_offset) const;
+
+	/**
+	 * @brief Groups the opaque draws, or unordered transparent ones, in [first, last) into instanced draws or indirect multi-draws, draws the others directly
+	 */
+	void draw_nodes_grouped(CommandBuffer &command_buffer, const CpuCulling::DrawList &nodes, size_t first, size_t last, size_t thread_index);
+
+	void draw_parallel(CommandBuffer &primary_command_buffer,
+	                   const CpuCulling::DrawList &opaque_nodes,
+	                   const CpuCulling::DrawList &transparent_nodes);
+
+	JobSystem *job_system{nullptr};
+
+	uint32_t draws_per_command_buffer{DEFAULT_DRAWS_PER_COMMAND_BUFFER};
+
+	bool push_descriptors{false};
+
+	bool multi_draw_indirect{false};
+
+	bool automatic_instancing{false};
+
+	bool ordered_transparency{true};
+
+	CpuCulling cpu_culling;
+
+	bool hierarchical_culling{false};
+
+	std::unique_ptr<GpuCulling> gpu_culling;
+
+	bool async_culling{false};
+
+	/// Revision of the scene whose instances are culled
+	uint64_t culling_revision{0};
+
+	/// Instances of the GPU culling, drawn by the depth pre-pass
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> culling_instances;
+
+	/// Cursor in the change journal of the scene
+	uint64_t change_cursor{0};
+
+	std::vector<sg::Change> scene_changes;
+
+	/// Nodes with meshes which moved since the last frame
+	std::vector<sg::Node *> moved_nodes;
+
+	TextureStreamer *texture_streamer{nullptr};
+
+	std::unique_ptr<BindlessMaterials> bindless_materials;
+
+	bool mesh_shading{false};
+
+	ShaderSource task_shader;
+
+	ShaderSource mesh_shader;
+
+	/// Level of detail of the draws of submeshes with levels
+	std::map<std::pair<const sg::Node *, const sg::SubMesh *>, uint32_t> lod_levels;
+
+	bool motion_vectors{false};
+
+	gbuffer::Layout gbuffer_layout{gbuffer::Layout::Full};
+
+	/// Variants of the submeshes with MOTION_VECTORS, MULTIVIEW, the G-buffer layout or the precision defined
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> draw_variants;
+
+	std::vector<sg::Camera *> views;
+
+	/// View projections of the views in the frame
+	BufferAllocation view_allocation;
+
+	std::unique_ptr<TransformBuffer> transform_buffer;
+
+	/// Revision of the scene whose nodes have a transform slot
+	uint64_t transform_revision{0};
+
+	/// Uniform of the draws reading the transform buffer in the frame
+	BufferAllocation transform_allocation;
+
+	/// Variants of the submeshes with TRANSFORM_BUFFER defined, for the draws reading the transform buffer
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> transform_variants;
+
+	/**
+	 * @brief The material of a submesh compiled for its draws, which do not look up its textures by name
+	 */
+	struct MaterialDraw
+	{
+		PBRMaterialUniform uniform;
+
+		/// Textures of the material with their binding in the fragment shader
+		std::vector<std::pair<uint32_t, sg::Texture *>> textures;
+	};
+
+	/**
+	 * @brief The vertex input of a submesh for the vertex shader inputs of a pipeline layout
+	 */
+	struct VertexInput
+	{
+		VertexInputState state;
+
+		/// Location of each attribute with its buffer and offset
+		std::vector<std::tuple<uint32_t, const core::Buffer *, VkDeviceSize>> buffers;
+	};
+
+	/**
+	 * @return The vertex input of a submesh for a pipeline layout, resolved on the first request
+	 */
+	const VertexInput &request_vertex_input(PipelineLayout &pipeline_layout, const sg::SubMesh &sub_mesh);
+
+	/// Vertex inputs of the submeshes drawn, cleared when the meshes of the scene change
+	std::map<std::pair<const PipelineLayout *, const sg::SubMesh *>, VertexInput> vertex_inputs;
+
+	/// Guards vertex_inputs, which draws of several threads request from
+	std::mutex vertex_input_mutex;
+
+	/// Compiled materials of the submeshes, read by the draws of any thread
+	std::unordered_map<const sg::SubMesh *, MaterialDraw> material_draws;
+
+	/// Whether the materials are compiled on the next pre_draw
+	bool materials_outdated{true};
+
+	/// Unjittered view projection of this frame and of the previous one
+	glm::mat4 motion_view_proj{1.0f};
+
+	glm::mat4 previous_motion_view_proj{1.0f};
+
+	glm::vec2 motion_jitter{0.0f, 0.0f};
+
+	/// Whether a frame was drawn with motion vectors, so the first one has no camera motion
+	bool has_motion_view{false};
 };
 
 }        // namespace vkb
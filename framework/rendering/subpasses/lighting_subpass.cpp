@@ -17,9 +17,17 @@
 
 #include "lighting_subpass.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "buffer_pool.h"
 #include "rendering/render_context.h"
+#include "rendering/scene_acceleration_structure.h"
+#include "rendering/shadow_atlas.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
 #include "scene_graph/scene.h"
 
 namespace vkb
@@ -29,22 +37,73 @@ LightingSubpass::LightingSubpass(RenderContext &render_context, ShaderSource &&v
     camera{cam},
     scene{scene_}
 {
+	set_debug_name("Lighting");
 }
 
 void LightingSubpass::prepare()
 {
-	lighting_variant.add_definitions({"MAX_DEFERRED_LIGHT_COUNT " + std::to_string(MAX_DEFERRED_LIGHT_COUNT)});
+	if (light_clusters)
+	{
+		lighting_variant.add_definitions(LightClusters::get_shader_definitions());
+	}
+	else
+	{
+		lighting_variant.add_definitions({"MAX_DEFERRED_LIGHT_COUNT " + std::to_string(MAX_DEFERRED_LIGHT_COUNT)});
+
+		if (light_volumes)
+		{
+			lighting_variant.add_define("LIGHT_VOLUMES");
+		}
+
+		if (shadow_atlas)
+		{
+			lighting_variant.add_definitions(ShadowAtlas::get_shader_definitions());
+		}
+	}
+	if (acceleration_structure)
+	{
+		lighting_variant.add_define("RAY_QUERY");
+	}
 	lighting_variant.add_definitions(light_type_definitions);
-	// Build all shaders upfront
+	lighting_variant.add_definitions(gbuffer::get_shader_definitions(gbuffer_layout));
+	lighting_variant.add_definitions(get_precision_definitions());
+	// Build all shaders upfront, both stages in parallel
 	auto &resource_cache = render_context.get_device().get_resource_cache();
-	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), lighting_variant);
-	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), lighting_variant);
+	auto  vert_module    = resource_cache.request_shader_module_async(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), lighting_variant);
+	auto  frag_module    = resource_cache.request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), lighting_variant);
+	vert_module.get();
+	frag_module.get();
 }
 
 void LightingSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto light_buffer = allocate_lights<DeferredLights>(scene.get_components<sg::Light>(), MAX_DEFERRED_LIGHT_COUNT);
-	command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+	// Lights whose range reaches no mesh are left out of the light loop
+	scene.get_lights_reaching_meshes(lights);
+
+	// Lights shaded by the full screen triangle come first, the ones bounded by a light volume follow
+	auto volume_lights = lights.end();
+	if (light_volumes && !light_clusters)
+	{
+		volume_lights = std::stable_partition(lights.begin(), lights.end(), [](sg::Light *light) {
+			return light->get_light_type() != sg::LightType::Point || light->get_properties().range <= 0.0f;
+		});
+	}
+
+	if (light_clusters)
+	{
+		light_clusters->update(lights, camera, get_render_area());
+		light_clusters->bind(command_buffer);
+	}
+	else
+	{
+		auto light_buffer = allocate_lights<DeferredLights>(lights, MAX_DEFERRED_LIGHT_COUNT);
+		command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+
+		if (shadow_atlas)
+		{
+			shadow_atlas->bind(command_buffer, lights, 0, SHADOW_ATLAS_BINDING, SHADOW_UNIFORM_BINDING);
+		}
+	}
 
 	// Get shaders from cache
 	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
@@ -79,12 +138,24 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 	// Populate uniform values
 	LightUniform light_uniform;
 
-	// Inverse resolution
-	light_uniform.inv_resolution.x = 1.0f / render_target.get_extent().width;
-	light_uniform.inv_resolution.y = 1.0f / render_target.get_extent().height;
+	// Inverse resolution of the drawn region, which maps the fragments to the whole view
+	auto render_area               = get_render_area();
+	light_uniform.inv_resolution.x = 1.0f / render_area.width;
+	light_uniform.inv_resolution.y = 1.0f / render_area.height;
 
 	// Inverse view projection
-	light_uniform.inv_view_proj = glm::inverse(vulkan_style_projection(camera.get_projection()) * camera.get_view());
+	light_uniform.view_proj     = camera.get_pre_rotation() * vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	light_uniform.inv_view_proj = glm::inverse(light_uniform.view_proj);
+
+	light_uniform.ray_bias            = ray_query_options.ray_bias;
+	light_uniform.occlusion_radius    = ray_query_options.occlusion_radius;
+	light_uniform.shadow_rays         = ray_query_options.shadow_rays ? 1 : 0;
+	light_uniform.occlusion_ray_count = ray_query_options.occlusion_ray_count;
+
+	if (acceleration_structure)
+	{
+		command_buffer.bind_descriptor_set(RAY_QUERY_SET_INDEX, ray_query_descriptor_set);
+	}
 
 	// Allocate a buffer using the buffer pool from the active frame to store uniform values and bind it
 	auto &render_frame = get_render_context().get_active_frame();
@@ -92,7 +163,197 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 	allocation.update(light_uniform);
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 3, 0);
 
+	if (light_volumes && !light_clusters)
+	{
+		command_buffer.push_constants(LightVolume{glm::vec4{0.0f}, 0, to_u32(std::distance(lights.begin(), volume_lights))});
+	}
+
+	// The clusters and light volumes only see a range of the lights, their count can't be baked
+	set_light_specialization_constants(command_buffer, lights, !light_clusters && !light_volumes);
+
 	// Draw full screen triangle triangle
 	command_buffer.draw(3, 1, 0, 0);
+
+	if (light_volumes && !light_clusters)
+	{
+		draw_light_volumes(command_buffer, lights);
+	}
+}
+
+void LightingSubpass::draw_light_volumes(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights)
+{
+	// Volumes add their light on top of the full screen triangle
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	color_blend_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	color_blend_state.attachments[0] = color_blend_attachment;
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	// Only the back faces are drawn, so that a volume containing the camera is still shaded, and every pixel once
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_FRONT_BIT;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	// The depth attachment is an input of this subpass, the volumes never write it
+	bool depth_bounds = get_render_context().get_device().get_gpu().get_requested_features().depthBounds;
+
+	DepthStencilState depth_stencil_state;
+	depth_stencil_state.depth_test_enable        = VK_FALSE;
+	depth_stencil_state.depth_write_enable       = VK_FALSE;
+	depth_stencil_state.depth_bounds_test_enable = depth_bounds;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	glm::mat4 view       = camera.get_view();
+	glm::mat4 projection = vulkan_style_projection(camera.get_projection());
+
+	auto to_depth = [&projection](float view_depth) {
+		glm::vec4 clip = projection * glm::vec4{0.0f, 0.0f, view_depth, 1.0f};
+		return glm::clamp(clip.z / clip.w, 0.0f, 1.0f);
+	};
+
+	for (uint32_t i = 0; i < to_u32(lights.size()); ++i)
+	{
+		const auto &light = *lights[i];
+		float       range = light.get_properties().range;
+
+		if (light.get_light_type() != sg::LightType::Point || range <= 0.0f)
+		{
+			continue;
+		}
+
+		glm::vec3 center = light.get_node()->get_transform().get_translation();
+
+		// Lights entirely behind the camera reach no visible pixel
+		float view_depth = (view * glm::vec4{center, 1.0f}).z;
+		if (view_depth - range >= 0.0f)
+		{
+			continue;
+		}
+
+		if (depth_bounds)
+		{
+			// The volume nearest point may lie behind the camera, keep it just in front of it
+			float near_depth = to_depth(std::min(view_depth + range, -std::numeric_limits<float>::epsilon()));
+			float far_depth  = to_depth(view_depth - range);
+			command_buffer.set_depth_bounds(std::min(near_depth, far_depth), std::max(near_depth, far_depth));
+		}
+
+		command_buffer.push_constants(LightVolume{glm::vec4{center, range}, i, 1});
+
+		// Box built by the vertex shader
+		command_buffer.draw(36, 1, 0, 0);
+	}
+}
+
+void LightingSubpass::set_clustered_lights(bool enabled)
+{
+	if (enabled)
+	{
+		light_clusters = std::make_unique<LightClusters>(render_context);
+	}
+	else
+	{
+		light_clusters.reset();
+	}
+}
+
+bool LightingSubpass::is_using_clustered_lights() const
+{
+	return light_clusters != nullptr;
+}
+
+void LightingSubpass::set_light_volumes(bool enabled)
+{
+	light_volumes = enabled;
+}
+
+bool LightingSubpass::is_using_light_volumes() const
+{
+	return light_volumes;
+}
+
+void LightingSubpass::set_gbuffer_layout(gbuffer::Layout layout)
+{
+	gbuffer_layout = layout;
+}
+
+gbuffer::Layout LightingSubpass::get_gbuffer_layout() const
+{
+	return gbuffer_layout;
+}
+
+void LightingSubpass::set_ray_query(SceneAccelerationStructure *acceleration_structure_)
+{
+	acceleration_structure = acceleration_structure_;
+
+	ray_query_descriptor_set = VK_NULL_HANDLE;
+	ray_query_descriptor_pool.reset();
+	ray_query_set_layout.reset();
+
+	if (!acceleration_structure)
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	// Matches the set reflected from the fragment shader, so that the layouts are compatible
+	ShaderResource resource{};
+	resource.stages     = VK_SHADER_STAGE_FRAGMENT_BIT;
+	resource.type       = ShaderResourceType::AccelerationStructure;
+	resource.mode       = ShaderResourceMode::Static;
+	resource.set        = RAY_QUERY_SET_INDEX;
+	resource.binding    = 0;
+	resource.array_size = 1;
+	resource.name       = "scene_acceleration_structure";
+
+	ray_query_set_layout      = std::make_unique<DescriptorSetLayout>(device, RAY_QUERY_SET_INDEX, std::vector<ShaderResource>{resource});
+	ray_query_descriptor_pool = std::make_unique<DescriptorPool>(device, *ray_query_set_layout, 1);
+	ray_query_descriptor_set  = ray_query_descriptor_pool->allocate();
+
+	// Refits keep the handle of the top level structure, the set is written once
+	VkAccelerationStructureKHR top_level = acceleration_structure->get_top_level().get_handle();
+
+	VkWriteDescriptorSetAccelerationStructureKHR acceleration_structure_info{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR};
+	acceleration_structure_info.accelerationStructureCount = 1;
+	acceleration_structure_info.pAccelerationStructures    = &top_level;
+
+	VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+	write.pNext           = &acceleration_structure_info;
+	write.dstSet          = ray_query_descriptor_set;
+	write.dstBinding      = 0;
+	write.descriptorCount = 1;
+	write.descriptorType  = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+
+	vkUpdateDescriptorSets(device.get_handle(), 1, &write, 0, nullptr);
+}
+
+bool LightingSubpass::is_using_ray_query() const
+{
+	return acceleration_structure != nullptr;
+}
+
+void LightingSubpass::set_ray_query_options(const RayQueryOptions &options)
+{
+	ray_query_options = options;
+}
+
+const RayQueryOptions &LightingSubpass::get_ray_query_options() const
+{
+	return ray_query_options;
+}
+
+void LightingSubpass::set_shadow_atlas(ShadowAtlas *shadow_atlas_)
+{
+	shadow_atlas = shadow_atlas_;
+}
+
+ShadowAtlas *LightingSubpass::get_shadow_atlas() const
+{
+	return shadow_atlas;
 }
 }        // namespace vkb
@@ -18,6 +18,9 @@
 #pragma once
 
 #include "buffer_pool.h"
+#include "core/descriptor_pool.h"
+#include "core/descriptor_set_layout.h"
+#include "rendering/light_clusters.h"
 #include "rendering/subpass.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -28,6 +31,9 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+class SceneAccelerationStructure;
+class ShadowAtlas;
+
 namespace sg
 {
 class Camera;
@@ -44,6 +50,48 @@ struct alignas(16) LightUniform
 {
 	glm::mat4 inv_view_proj;
 	glm::vec2 inv_resolution;
+
+	// Only read by the LIGHT_VOLUMES variant, to project the light volumes
+	alignas(16) glm::mat4 view_proj;
+
+	// Only read by the RAY_QUERY variant
+	float ray_bias;
+
+	float occlusion_radius;
+
+	uint32_t shadow_rays;
+
+	uint32_t occlusion_ray_count;
+};
+
+/**
+ * @brief Rays traced by each pixel in the RAY_QUERY variant of the lighting pass
+ *        The distances are in scene units.
+ */
+struct RayQueryOptions
+{
+	/// Whether a shadow ray is traced towards each light
+	bool shadow_rays{true};
+
+	/// Number of ambient occlusion rays, none disables it
+	uint32_t occlusion_ray_count{4};
+
+	/// Offset of the ray origins along the normal, which keeps the rays from hitting their own surface
+	float ray_bias{0.1f};
+
+	/// Length of the ambient occlusion rays
+	float occlusion_radius{50.0f};
+};
+
+/**
+ * @brief Push constants of the LIGHT_VOLUMES variant
+ * A bounds extent of 0 draws the full screen triangle, otherwise a box of that half extent around bounds.xyz
+ */
+struct LightVolume
+{
+	glm::vec4 bounds;
+	uint32_t  first_light;
+	uint32_t  light_count;
 };
 
 struct alignas(16) DeferredLights
@@ -64,12 +112,101 @@ class LightingSubpass : public Subpass
 
 	void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Shades each fragment with the lights of its cluster, assigned by LightClusters, instead of a loop over
+	 *        the whole light uniform which is capped at MAX_DEFERRED_LIGHT_COUNT. The fragment shader must support the
+	 *        CLUSTERED_LIGHTS variant, as deferred/lighting.frag does. It must be set before prepare().
+	 */
+	void set_clustered_lights(bool enabled);
+
+	bool is_using_clustered_lights() const;
+
+	/**
+	 * @brief Shades the directional lights with the full screen triangle, then draws a box bounding the range of
+	 *        each point light with additive blending, so only the pixels it can reach are shaded. When the
+	 *        depthBounds feature is enabled, pixels whose depth lies outside of the light range are rejected as well.
+	 *        The shaders must support the LIGHT_VOLUMES variant, as deferred/lighting.vert/frag do. It must be set
+	 *        before prepare() and it is ignored if clustered lights are enabled.
+	 */
+	void set_light_volumes(bool enabled);
+
+	bool is_using_light_volumes() const;
+
+	/**
+	 * @brief Sets the layout of the G-buffer read from the input attachments, written by a GeometrySubpass with the
+	 *        same layout. The fragment shader must support the variant of the layout, as deferred/lighting.frag does.
+	 *        It must be set before prepare().
+	 */
+	void set_gbuffer_layout(gbuffer::Layout layout);
+
+	gbuffer::Layout get_gbuffer_layout() const;
+
+	/// Set of the scene acceleration structure in the RAY_QUERY variant
+	static constexpr uint32_t RAY_QUERY_SET_INDEX = 1;
+
+	/**
+	 * @brief Traces shadow and ambient occlusion rays against the scene with ray queries, from the positions and
+	 *        normals of the G-buffer. The fragment shader must support the RAY_QUERY variant, as
+	 *        deferred/lighting.frag does, and be compiled for SPIR-V 1.4, see GLSLCompiler::set_target_environment().
+	 *        The device needs the rayQuery feature of VK_KHR_ray_tracing. It must be set before prepare().
+	 * @param acceleration_structure Structures of the scene, which must outlive the subpass, nullptr disables ray queries
+	 */
+	void set_ray_query(SceneAccelerationStructure *acceleration_structure);
+
+	bool is_using_ray_query() const;
+
+	/**
+	 * @brief Sets the rays traced by the RAY_QUERY variant, it can be changed between frames
+	 */
+	void set_ray_query_options(const RayQueryOptions &options);
+
+	const RayQueryOptions &get_ray_query_options() const;
+
+	/// Bindings of the shadow atlas and its uniform in the SHADOWS variant
+	static constexpr uint32_t SHADOW_ATLAS_BINDING = 7;
+
+	static constexpr uint32_t SHADOW_UNIFORM_BINDING = 8;
+
+	/**
+	 * @brief Shades the lights with the shadow maps of an atlas. ShadowAtlas::update() must be recorded before the
+	 *        render pass each frame, with the lights of Scene::get_lights_reaching_meshes(). The fragment shader must
+	 *        support the SHADOWS variant, as deferred/lighting.frag does. It must be set before prepare() and it is
+	 *        ignored if clustered lights are enabled.
+	 * @param shadow_atlas Atlas of the scene, which must outlive the subpass, nullptr disables shadows
+	 */
+	void set_shadow_atlas(ShadowAtlas *shadow_atlas);
+
+	ShadowAtlas *get_shadow_atlas() const;
+
   private:
+	void draw_light_volumes(CommandBuffer &command_buffer, const std::vector<sg::Light *> &lights);
+
 	sg::Camera &camera;
 
 	sg::Scene &scene;
 
+	/// Lights of the frame, in the order of the light uniform
+	std::vector<sg::Light *> lights;
+
 	ShaderVariant lighting_variant;
+
+	std::unique_ptr<LightClusters> light_clusters;
+
+	bool light_volumes{false};
+
+	gbuffer::Layout gbuffer_layout{gbuffer::Layout::Full};
+
+	SceneAccelerationStructure *acceleration_structure{nullptr};
+
+	RayQueryOptions ray_query_options;
+
+	std::unique_ptr<DescriptorSetLayout> ray_query_set_layout;
+
+	std::unique_ptr<DescriptorPool> ray_query_descriptor_pool;
+
+	VkDescriptorSet ray_query_descriptor_set{VK_NULL_HANDLE};
+
+	ShadowAtlas *shadow_atlas{nullptr};
 };
 
 }        // namespace vkb
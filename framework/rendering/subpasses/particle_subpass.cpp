@@ -0,0 +1,289 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "rendering/subpasses/particle_subpass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t WORKGROUP_SIZE = 64;
+
+// Matches the Counters block of the particle compute shaders
+struct ParticleCounters
+{
+	int32_t                   dead_count;
+	uint32_t                  alive_count;
+	VkDispatchIndirectCommand dispatch;
+	VkDrawIndirectCommand     draw;
+};
+
+struct EmissionPushConstants
+{
+	glm::vec4 position_lifetime;
+	glm::vec4 velocity_spread;
+	glm::vec4 gravity_delta_time;
+	uint32_t  emit_count;
+	uint32_t  max_particles;
+	uint32_t  seed;
+};
+
+struct ParticleUniform
+{
+	glm::mat4 view_proj;
+	glm::vec4 camera_right;
+	glm::vec4 camera_up;
+	glm::vec4 color;
+	float     size;
+};
+
+/**
+ * @brief Makes the writes of a compute shader visible to the next one
+ */
+void compute_barrier(CommandBuffer &command_buffer, const core::Buffer &buffer)
+{
+	BufferMemoryBarrier memory_barrier{};
+	memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	command_buffer.buffer_memory_barrier(buffer, 0, VK_WHOLE_SIZE, memory_barrier);
+}
+}        // namespace
+
+ParticleSubpass::ParticleSubpass(RenderContext &render_context, sg::Camera &camera_, uint32_t max_particles_) :
+    Subpass{render_context, ShaderSource{"particles/particle.vert"}, ShaderSource{"particles/particle.frag"}},
+    camera{camera_},
+    max_particles{max_particles_},
+    init_shader{"particles/init.comp"},
+    emit_shader{"particles/emit.comp"},
+    args_shader{"particles/args.comp"},
+    simulate_shader{"particles/simulate.comp"}
+{
+	set_debug_name("Particles");
+}
+
+void ParticleSubpass::prepare()
+{
+	auto &device         = render_context.get_device();
+	auto &resource_cache = device.get_resource_cache();
+
+	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+	for (auto *shader : {&init_shader, &emit_shader, &args_shader, &simulate_shader})
+	{
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, *shader);
+	}
+
+	particle_buffer = std::make_unique<core::Buffer>(device, max_particles * 2 * sizeof(glm::vec4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	dead_buffer     = std::make_unique<core::Buffer>(device, max_particles * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	counter_buffer  = std::make_unique<core::Buffer>(device, sizeof(ParticleCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	for (auto &alive_buffer : alive_buffers)
+	{
+		alive_buffer = std::make_unique<core::Buffer>(device, max_particles * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	}
+
+	initialized = false;
+}
+
+void ParticleSubpass::update(float delta_time_)
+{
+	delta_time += delta_time_;
+	time += delta_time_;
+
+	emit_accumulator += emitter.spawn_rate * delta_time_;
+
+	float whole = std::floor(emit_accumulator);
+	emit_count  = std::min(emit_count + static_cast<uint32_t>(whole), max_particles);
+	emit_accumulator -= whole;
+}
+
+void ParticleSubpass::set_emitter(const ParticleEmitter &emitter_)
+{
+	emitter = emitter_;
+}
+
+const ParticleEmitter &ParticleSubpass::get_emitter() const
+{
+	return emitter;
+}
+
+uint32_t ParticleSubpass::get_max_particles() const
+{
+	return max_particles;
+}
+
+void ParticleSubpass::dispatch(CommandBuffer &command_buffer, const ShaderSource &shader, uint32_t group_count_x)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	// The compute shaders only declare the bindings they use
+	command_buffer.bind_buffer(*particle_buffer, 0, particle_buffer->get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(*dead_buffer, 0, dead_buffer->get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(*alive_buffers[current_list], 0, alive_buffers[current_list]->get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(*alive_buffers[1 - current_list], 0, alive_buffers[1 - current_list]->get_size(), 0, 3, 0);
+	command_buffer.bind_buffer(*counter_buffer, 0, counter_buffer->get_size(), 0, 4, 0);
+
+	EmissionPushConstants push_constants{};
+	push_constants.position_lifetime  = glm::vec4(emitter.position, emitter.lifetime);
+	push_constants.velocity_spread    = glm::vec4(emitter.velocity, emitter.spread);
+	push_constants.gravity_delta_time = glm::vec4(emitter.gravity, delta_time);
+	push_constants.emit_count         = emit_count;
+	push_constants.max_particles      = max_particles;
+	push_constants.seed               = static_cast<uint32_t>(time * 1000.0f);
+
+	command_buffer.push_constants(push_constants);
+
+	if (group_count_x == 0)
+	{
+		// Sized by the arguments the GPU wrote
+		command_buffer.dispatch_indirect(*counter_buffer, offsetof(ParticleCounters, dispatch));
+	}
+	else
+	{
+		command_buffer.dispatch(group_count_x, 1, 1);
+	}
+}
+
+void ParticleSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	// The previous frame simulated into and drew from the buffers this frame rewrites
+	BufferMemoryBarrier start_barrier{};
+	start_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	start_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	start_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+	start_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	for (auto *buffer : {particle_buffer.get(), dead_buffer.get(), alive_buffers[0].get(), alive_buffers[1].get(), counter_buffer.get()})
+	{
+		command_buffer.buffer_memory_barrier(*buffer, 0, VK_WHOLE_SIZE, start_barrier);
+	}
+
+	if (!initialized)
+	{
+		dispatch(command_buffer, init_shader, (max_particles + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE);
+		compute_barrier(command_buffer, *dead_buffer);
+		compute_barrier(command_buffer, *counter_buffer);
+		initialized = true;
+	}
+
+	if (emit_count > 0)
+	{
+		dispatch(command_buffer, emit_shader, (emit_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE);
+		compute_barrier(command_buffer, *particle_buffer);
+		compute_barrier(command_buffer, *alive_buffers[current_list]);
+		compute_barrier(command_buffer, *counter_buffer);
+	}
+
+	dispatch(command_buffer, args_shader, 1);
+
+	// The simulation is dispatched with the arguments written by the previous shader
+	BufferMemoryBarrier args_barrier{};
+	args_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	args_barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	args_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	args_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	command_buffer.buffer_memory_barrier(*counter_buffer, 0, VK_WHOLE_SIZE, args_barrier);
+
+	dispatch(command_buffer, simulate_shader, 0);
+
+	// The survivors and their count are read by the draw
+	BufferMemoryBarrier draw_barrier{};
+	draw_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	draw_barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	draw_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	draw_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+
+	command_buffer.buffer_memory_barrier(*counter_buffer, 0, VK_WHOLE_SIZE, draw_barrier);
+	command_buffer.buffer_memory_barrier(*particle_buffer, 0, VK_WHOLE_SIZE, draw_barrier);
+	command_buffer.buffer_memory_barrier(*alive_buffers[1 - current_list], 0, VK_WHOLE_SIZE, draw_barrier);
+
+	// The compacted list is drawn, then emitted into and simulated from by the next frame
+	current_list = 1 - current_list;
+	emit_count   = 0;
+	delta_time   = 0.0f;
+}
+
+void ParticleSubpass::draw(CommandBuffer &command_buffer)
+{
+	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&vert_shader_module, &frag_shader_module});
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	glm::mat4 view = camera.get_view();
+
+	ParticleUniform particle_uniform{};
+	particle_uniform.view_proj    = camera.get_pre_rotation() * vulkan_style_projection(camera.get_projection()) * view;
+	particle_uniform.camera_right = glm::vec4(view[0][0], view[1][0], view[2][0], 0.0f);
+	particle_uniform.camera_up    = glm::vec4(view[0][1], view[1][1], view[2][1], 0.0f);
+	particle_uniform.color        = emitter.color;
+	particle_uniform.size         = emitter.size;
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ParticleUniform));
+	allocation.update(particle_uniform);
+
+	command_buffer.bind_buffer(*particle_buffer, 0, particle_buffer->get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(*alive_buffers[current_list], 0, alive_buffers[current_list]->get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 2, 0);
+
+	// The quads are generated from the vertex and instance indices
+	command_buffer.set_vertex_input_state({});
+
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	DepthStencilState depth_stencil_state;
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	// Additive blending is order independent, which leaves the particles unsorted
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+	color_blend_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	color_blend_state.attachments[0] = color_blend_attachment;
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	command_buffer.draw_indirect(*counter_buffer, offsetof(ParticleCounters, draw), 1, sizeof(VkDrawIndirectCommand));
+}
+}        // namespace vkb
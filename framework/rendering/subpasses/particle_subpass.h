@@ -0,0 +1,160 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "core/buffer.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Camera;
+}
+
+/**
+ * @brief Spawn parameters of the particles of a ParticleSubpass
+ */
+struct ParticleEmitter
+{
+	/// World space position the particles spawn at
+	glm::vec3 position{0.0f};
+
+	/// Particles spawned per second
+	float spawn_rate{1000.0f};
+
+	/// Seconds a particle lives for
+	float lifetime{2.0f};
+
+	/// Initial velocity of the particles
+	glm::vec3 velocity{0.0f, 2.0f, 0.0f};
+
+	/// Magnitude of the random velocity added to each particle
+	float spread{1.0f};
+
+	/// Acceleration applied to the particles
+	glm::vec3 gravity{0.0f, -1.0f, 0.0f};
+
+	/// World space half extent of the particle quads
+	float size{0.05f};
+
+	/// Color of a newborn particle, which fades out over its lifetime
+	glm::vec4 color{1.0f, 0.5f, 0.2f, 1.0f};
+};
+
+/**
+ * @brief Emits, simulates and draws particles entirely on the GPU
+ *
+ * The particles live in a fixed pool. The indices of the free slots are kept in a dead list and the
+ * indices of the live particles in one of two alive lists. Before the render pass, a compute shader
+ * pops the particles spawned this frame from the dead list and appends them to the current alive list.
+ * The simulation then ages and integrates the current list with an indirect dispatch sized by the GPU,
+ * compacting the survivors into the other list and returning the expired particles to the dead list.
+ * The count of the compacted list is the instance count of the indirect draw, so the CPU never reads
+ * back how many particles are alive.
+ *
+ * Each particle is drawn as a camera facing quad with additive blending. The result does not depend
+ * on the draw order, so the particles need no sorting. They are depth tested against the scene,
+ * without writing depth.
+ */
+class ParticleSubpass : public Subpass
+{
+  public:
+	/**
+	 * @param render_context Render context
+	 * @param camera Camera the particles are drawn with
+	 * @param max_particles Size of the particle pool
+	 */
+	ParticleSubpass(RenderContext &render_context, sg::Camera &camera, uint32_t max_particles);
+
+	virtual ~ParticleSubpass() = default;
+
+	void prepare() override;
+
+	/**
+	 * @brief Emits and simulates the particles of the frame
+	 */
+	void pre_draw(CommandBuffer &command_buffer) override;
+
+	void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Advances the simulation time, the particles to spawn accumulate until the next frame
+	 * @param delta_time Seconds since the last update
+	 */
+	void update(float delta_time);
+
+	void set_emitter(const ParticleEmitter &emitter);
+
+	const ParticleEmitter &get_emitter() const;
+
+	uint32_t get_max_particles() const;
+
+  private:
+	void dispatch(CommandBuffer &command_buffer, const ShaderSource &shader, uint32_t group_count_x);
+
+	sg::Camera &camera;
+
+	uint32_t max_particles;
+
+	ParticleEmitter emitter;
+
+	ShaderSource init_shader;
+
+	ShaderSource emit_shader;
+
+	ShaderSource args_shader;
+
+	ShaderSource simulate_shader;
+
+	/// Position and age, velocity and lifetime of each particle
+	std::unique_ptr<core::Buffer> particle_buffer;
+
+	std::unique_ptr<core::Buffer> dead_buffer;
+
+	/// Indices of the live particles, alternately simulated from and compacted into
+	std::array<std::unique_ptr<core::Buffer>, 2> alive_buffers;
+
+	/// Counts of the lists, then the dispatch and draw arguments
+	std::unique_ptr<core::Buffer> counter_buffer;
+
+	/// Alive list the next frame emits into and simulates from
+	uint32_t current_list{0};
+
+	bool initialized{false};
+
+	/// Particles to spawn, carrying the fraction left over by the last frame
+	float emit_accumulator{0.0f};
+
+	uint32_t emit_count{0};
+
+	float delta_time{0.0f};
+
+	float time{0.0f};
+};
+}        // namespace vkb
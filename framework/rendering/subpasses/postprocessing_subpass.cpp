@@ -29,6 +29,8 @@ PostProcessingSubpass::PostProcessingSubpass(RenderContext &render_context, Shad
     camera{cam},
     scene{scene_}
 {
+	set_debug_name("Post-processing");
+
 	// Create texture samplers
 	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
 	sampler_info.maxAnisotropy = 1.0f;
@@ -39,20 +41,30 @@ PostProcessingSubpass::PostProcessingSubpass(RenderContext &render_context, Shad
 	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 	sampler_info.borderColor   = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-	color_sampler              = std::make_unique<core::Sampler>(get_render_context().get_device(), sampler_info);
-	depth_sampler              = std::make_unique<core::Sampler>(get_render_context().get_device(), sampler_info);
+	color_sampler              = &get_render_context().get_device().get_resource_cache().request_sampler(sampler_info);
+	depth_sampler              = &get_render_context().get_device().get_resource_cache().request_sampler(sampler_info);
 }
 
 void PostProcessingSubpass::prepare()
 {
-	// Build all shaders upfront
+	// Build all shaders upfront, in parallel
 	auto &resource_cache = render_context.get_device().get_resource_cache();
-	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), postprocessing_variant);
-	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), postprocessing_variant);
+
+	postprocessing_variant.add_definitions(get_precision_definitions());
 
 	postprocessing_variant_ms_depth.add_definitions({"MS_DEPTH"});
-	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), postprocessing_variant_ms_depth);
-	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), postprocessing_variant_ms_depth);
+	postprocessing_variant_ms_depth.add_definitions(get_precision_definitions());
+
+	std::vector<std::shared_future<ShaderModule *>> shader_modules{
+	    resource_cache.request_shader_module_async(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), postprocessing_variant),
+	    resource_cache.request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), postprocessing_variant),
+	    resource_cache.request_shader_module_async(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), postprocessing_variant_ms_depth),
+	    resource_cache.request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), postprocessing_variant_ms_depth)};
+
+	for (auto &shader_module : shader_modules)
+	{
+		shader_module.get();
+	}
 }
 
 void PostProcessingSubpass::draw(CommandBuffer &command_buffer)
@@ -75,7 +87,7 @@ void PostProcessingSubpass::draw(CommandBuffer &command_buffer)
 
 	// Bind depth and color to texture samplers
 	command_buffer.bind_image(target_views.at(full_screen_depth), *depth_sampler, 0, 0, 0);
-	command_buffer.bind_image(target_views.at(full_screen_color), *color_sampler, 0, 1, 0);
+	command_buffer.bind_image(full_screen_color_view ? *full_screen_color_view : target_views.at(full_screen_color), *color_sampler, 0, 1, 0);
 
 	// Disable culling
 	RasterizationState rasterization_state;
@@ -87,6 +99,22 @@ void PostProcessingSubpass::draw(CommandBuffer &command_buffer)
 	auto &                d_camera = dynamic_cast<sg::PerspectiveCamera &>(camera);
 	uniform.near_far               = {d_camera.get_far_plane(), d_camera.get_near_plane()};
 
+	auto &extent      = render_target.get_extent();
+	auto  render_area = get_render_area();
+	auto  source      = source_area.width != 0 && source_area.height != 0 ? source_area : extent;
+
+	uniform.source_uv_scale    = glm::vec2(source.width, source.height) / glm::vec2(extent.width, extent.height);
+	uniform.source_uv_max      = (glm::vec2(source.width, source.height) - 0.5f) / glm::vec2(extent.width, extent.height);
+	uniform.source_coord_scale = glm::vec2(source.width, source.height) / glm::vec2(render_area.width, render_area.height);
+
+	if (full_screen_color_view)
+	{
+		auto &color_extent = full_screen_color_view->get_image().get_extent();
+
+		uniform.source_uv_scale = glm::vec2(1.0f);
+		uniform.source_uv_max   = 1.0f - 0.5f / glm::vec2(color_extent.width, color_extent.height);
+	}
+
 	// Allocate a buffer using the buffer pool from the active frame to store uniform values and bind it
 	auto &render_frame = get_render_context().get_active_frame();
 	auto  allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(PostprocessingUniform));
@@ -102,6 +130,11 @@ void PostProcessingSubpass::set_full_screen_color(uint32_t attachment)
 	full_screen_color = attachment;
 }
 
+void PostProcessingSubpass::set_full_screen_color_view(const core::ImageView *view)
+{
+	full_screen_color_view = view;
+}
+
 void PostProcessingSubpass::set_full_screen_depth(uint32_t attachment)
 {
 	full_screen_depth = attachment;
@@ -111,4 +144,9 @@ void PostProcessingSubpass::set_ms_depth(bool enable)
 {
 	ms_depth = enable;
 }
+
+void PostProcessingSubpass::set_source_area(const VkExtent2D &area)
+{
+	source_area = area;
+}
 }        // namespace vkb
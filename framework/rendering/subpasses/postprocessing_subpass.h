@@ -33,6 +33,15 @@ class Scene;
 struct alignas(16) PostprocessingUniform
 {
 	glm::vec2 near_far;
+
+	/// Maps the full screen UVs to the drawn region of the source attachments
+	glm::vec2 source_uv_scale;
+
+	/// Last UV sampled, so filtering does not read outside of the drawn region
+	glm::vec2 source_uv_max;
+
+	/// Maps the fragment coordinates to the texels of the drawn region
+	glm::vec2 source_coord_scale;
 };
 
 /**
@@ -43,6 +52,8 @@ struct alignas(16) PostprocessingUniform
  *        Depth is allowed to be multisampled, and this subpass will create two shader
  *        variants to cope with both cases. It is however not recommended to store
  *        multisampled depth attachments, always resolve before storing if possible
+ *        When the scene was drawn into a region of the attachments, as with dynamic
+ *        resolution, the region is upscaled to the render area of the subpass
  */
 class PostProcessingSubpass : public Subpass
 {
@@ -55,23 +66,41 @@ class PostProcessingSubpass : public Subpass
 
 	void set_full_screen_color(uint32_t attachment);
 
+	/**
+	 * @brief Samples the color from an image outside of the render target, such as the output of TemporalAA,
+	 *        instead of the full screen color attachment
+	 *        The whole image is sampled, the source area then only applies to depth.
+	 * @param view The color in the shader read only layout, nullptr to sample the attachment again
+	 */
+	void set_full_screen_color_view(const core::ImageView *view);
+
 	void set_full_screen_depth(uint32_t attachment);
 
 	void set_ms_depth(bool enable);
 
+	/**
+	 * @brief Sets the region of the color and depth attachments drawn by the scene, upscaled with bilinear filtering
+	 * @param source_area Extent of the region, the whole attachments when empty
+	 */
+	void set_source_area(const VkExtent2D &source_area);
+
   private:
 	sg::Camera &camera;
 
 	sg::Scene &scene;
 
-	std::unique_ptr<core::Sampler> color_sampler{nullptr};
+	const core::Sampler *color_sampler{nullptr};
 
-	std::unique_ptr<core::Sampler> depth_sampler{nullptr};
+	const core::Sampler *depth_sampler{nullptr};
 
 	uint32_t full_screen_color{0};
 
 	uint32_t full_screen_depth{0};
 
+	const core::ImageView *full_screen_color_view{nullptr};
+
+	VkExtent2D source_area{0, 0};
+
 	/**
 	 * @brief If true the full screen depth texture is multisampled.
 	 *        Used to select the fragment shader variant that binds
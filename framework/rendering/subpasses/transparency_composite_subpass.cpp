@@ -0,0 +1,82 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/transparency_composite_subpass.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+TransparencyCompositeSubpass::TransparencyCompositeSubpass(RenderContext &render_context, uint32_t accumulation_attachment_, uint32_t revealage_attachment_) :
+    Subpass{render_context, ShaderSource{"postprocessing/postprocessing.vert"}, ShaderSource{"transparency/composite.frag"}},
+    accumulation_attachment{accumulation_attachment_},
+    revealage_attachment{revealage_attachment_}
+{
+	set_debug_name("Transparency composite");
+
+	set_input_attachments({accumulation_attachment, revealage_attachment});
+	set_output_attachments({0});
+	set_disable_depth_stencil_attachment(true);
+}
+
+void TransparencyCompositeSubpass::prepare()
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+}
+
+void TransparencyCompositeSubpass::draw(CommandBuffer &command_buffer)
+{
+	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&vert_shader_module, &frag_shader_module});
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	auto &target_views = get_render_context().get_active_frame().get_render_target().get_views();
+	command_buffer.bind_input(target_views.at(accumulation_attachment), 0, 0, 0);
+	command_buffer.bind_input(target_views.at(revealage_attachment), 0, 1, 0);
+
+	// Set cull mode to front as full screen triangle is clock-wise
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_FRONT_BIT;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	DepthStencilState depth_stencil_state;
+	depth_stencil_state.depth_test_enable  = VK_FALSE;
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	// Blend the average transparent color by the total coverage, the opaque alpha is kept
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+	color_blend_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	color_blend_state.attachments[0] = color_blend_attachment;
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	// Draw full screen triangle
+	command_buffer.draw(3, 1, 0, 0);
+}
+}        // namespace vkb
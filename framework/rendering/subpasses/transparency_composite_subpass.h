@@ -0,0 +1,50 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+/**
+ * @brief Blends the transparent surfaces accumulated by a ForwardSubpass with order independent transparency
+ *        over the opaque color, with a full screen triangle reading the accumulation and revealage attachments
+ *        written by the previous subpass as input attachments. It writes the first attachment of the render target.
+ */
+class TransparencyCompositeSubpass : public Subpass
+{
+  public:
+	/**
+	 * @param render_context Render context
+	 * @param accumulation_attachment Attachment of the weighted sum of the transparent colors and coverages
+	 * @param revealage_attachment Attachment of the product of the transmittances of the transparent surfaces
+	 */
+	TransparencyCompositeSubpass(RenderContext &render_context, uint32_t accumulation_attachment, uint32_t revealage_attachment);
+
+	virtual ~TransparencyCompositeSubpass() = default;
+
+	void prepare() override;
+
+	void draw(CommandBuffer &command_buffer) override;
+
+  private:
+	uint32_t accumulation_attachment;
+
+	uint32_t revealage_attachment;
+};
+}        // namespace vkb
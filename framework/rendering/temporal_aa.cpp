@@ -0,0 +1,210 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/temporal_aa.h"
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t WORKGROUP_SIZE = 8;
+
+/**
+ * @brief Push constants of the temporal anti-aliasing shader
+ */
+struct TemporalAAPushConstants
+{
+	glm::uvec2 output_extent;
+
+	glm::uvec2 source_extent;
+
+	glm::vec2 source_texel_size;
+
+	glm::vec2 jitter;
+
+	float blend_factor;
+
+	uint32_t has_history;
+};
+
+/**
+ * @return The element of the Halton sequence of a base, in [0, 1)
+ */
+float halton(uint32_t index, uint32_t base)
+{
+	float result   = 0.0f;
+	float fraction = 1.0f;
+
+	while (index > 0)
+	{
+		fraction /= static_cast<float>(base);
+		result += fraction * static_cast<float>(index % base);
+		index /= base;
+	}
+
+	return result;
+}
+}        // namespace
+
+TemporalAA::TemporalAA(RenderContext &render_context) :
+    render_context{render_context},
+    shader_source{"temporal_aa/temporal_aa.comp"}
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	linear_sampler             = &resource_cache.request_sampler(sampler_info);
+
+	// Depth formats may not support linear filtering, depth and motion are only fetched
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	point_sampler          = &resource_cache.request_sampler(sampler_info);
+}
+
+glm::vec2 TemporalAA::next_jitter(const VkExtent2D &render_area)
+{
+	jitter_index = (jitter_index + 1) % JITTER_PHASE_COUNT;
+
+	// The sequence starts at 1, as its first element is 0 in every base
+	glm::vec2 offset{halton(jitter_index + 1, 2) - 0.5f, halton(jitter_index + 1, 3) - 0.5f};
+
+	jitter = offset * 2.0f / glm::vec2(render_area.width, render_area.height);
+
+	return jitter;
+}
+
+void TemporalAA::set_blend_factor(float factor)
+{
+	blend_factor = glm::clamp(factor, 0.01f, 1.0f);
+}
+
+float TemporalAA::get_blend_factor() const
+{
+	return blend_factor;
+}
+
+void TemporalAA::reset_history()
+{
+	has_history = false;
+}
+
+void TemporalAA::prepare_history(const VkExtent2D &extent)
+{
+	if (history_extent.width == extent.width && history_extent.height == extent.height)
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		history_views[i].reset();
+
+		history_images[i] = std::make_unique<core::Image>(device, VkExtent3D{extent.width, extent.height, 1}, HISTORY_FORMAT,
+		                                                  VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+		history_views[i] = std::make_unique<core::ImageView>(*history_images[i], VK_IMAGE_VIEW_TYPE_2D);
+	}
+
+	LOGI("Temporal anti-aliasing history {}x{}", extent.width, extent.height);
+
+	history_extent = extent;
+	has_history    = false;
+}
+
+const core::ImageView &TemporalAA::resolve(CommandBuffer &command_buffer, const core::ImageView &color, const core::ImageView &depth,
+                                           const core::ImageView &motion, const VkExtent2D &render_area, const VkExtent2D &output_extent)
+{
+	prepare_history(output_extent);
+
+	auto &resolved = *history_views[current_history];
+	auto &history  = *history_views[1 - current_history];
+
+	{
+		// The resolved image of two frames ago was read by the post-processing and by the last resolve
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(resolved, memory_barrier);
+	}
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader_source);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_image(color, *linear_sampler, 0, 0, 0);
+	command_buffer.bind_image(depth, *point_sampler, 0, 1, 0);
+	command_buffer.bind_image(motion, *point_sampler, 0, 2, 0);
+
+	// Without history the binding still needs an image, the shader does not read it
+	command_buffer.bind_image(has_history ? history : color, *linear_sampler, 0, 3, 0);
+
+	command_buffer.bind_input(resolved, 0, 4, 0);
+
+	auto &source_extent = color.get_image().get_extent();
+
+	TemporalAAPushConstants push_constants{};
+	push_constants.output_extent     = glm::uvec2(output_extent.width, output_extent.height);
+	push_constants.source_extent     = glm::uvec2(render_area.width, render_area.height);
+	push_constants.source_texel_size = 1.0f / glm::vec2(source_extent.width, source_extent.height);
+	push_constants.jitter            = jitter;
+	push_constants.blend_factor      = blend_factor;
+	push_constants.has_history       = has_history ? 1 : 0;
+
+	command_buffer.push_constants(push_constants);
+
+	command_buffer.dispatch((output_extent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (output_extent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(resolved, memory_barrier);
+	}
+
+	current_history = 1 - current_history;
+	has_history     = true;
+
+	return resolved;
+}
+}        // namespace vkb
@@ -0,0 +1,132 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Temporal anti-aliasing and upscaling, accumulating the jittered frames of the scene into a history
+ *
+ * Each frame the camera projection is offset by a different fraction of a pixel, see next_jitter() and
+ * sg::PerspectiveCamera::set_jitter(). A compute shader reprojects the history of the previous frames with
+ * the motion vectors of GeometrySubpass::set_motion_vectors(), clamps it to the colors around the pixel so
+ * disoccluded areas do not ghost, and blends the current frame into it.
+ *
+ * The scene may be drawn into a region of its attachments smaller than the output, as with DynamicResolution,
+ * in which case the history is accumulated at the output extent and upscales the scene. The resolved image is
+ * sampled by the post-processing, see PostProcessingSubpass::set_full_screen_color_view().
+ */
+class TemporalAA
+{
+  public:
+	TemporalAA(RenderContext &render_context);
+
+	TemporalAA(const TemporalAA &) = delete;
+
+	TemporalAA(TemporalAA &&) = delete;
+
+	~TemporalAA() = default;
+
+	TemporalAA &operator=(const TemporalAA &) = delete;
+
+	TemporalAA &operator=(TemporalAA &&) = delete;
+
+	/**
+	 * @brief Moves to the jitter of the next frame, cycling through JITTER_PHASE_COUNT points of the Halton (2, 3) sequence
+	 * @param render_area Extent the scene is drawn at
+	 * @return The jitter in normalized device coordinates, within half a pixel of the render area
+	 */
+	glm::vec2 next_jitter(const VkExtent2D &render_area);
+
+	/**
+	 * @param blend_factor Weight of the current frame in the history, lower values are smoother but slower to converge
+	 */
+	void set_blend_factor(float blend_factor);
+
+	float get_blend_factor() const;
+
+	/**
+	 * @brief Discards the history, so the next frame does not blend with frames before a cut of the camera
+	 */
+	void reset_history();
+
+	/**
+	 * @brief Blends the scene of the frame into the history
+	 * @param color Color of the scene in the shader read only layout
+	 * @param depth Depth of the scene in the shader read only layout
+	 * @param motion Motion vectors of the scene in the shader read only layout
+	 * @param render_area Extent of the region of the attachments drawn by the scene, from their top left
+	 * @param output_extent Extent of the resolved image, recreating the history when it changes
+	 * @return The resolved image in the shader read only layout, sampled by fragment shaders until the next resolve
+	 */
+	const core::ImageView &resolve(CommandBuffer &command_buffer, const core::ImageView &color, const core::ImageView &depth,
+	                               const core::ImageView &motion, const VkExtent2D &render_area, const VkExtent2D &output_extent);
+
+	static constexpr uint32_t JITTER_PHASE_COUNT = 16;
+
+	/// Format of the history, a storage format every device supports
+	static constexpr VkFormat HISTORY_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+  private:
+	/**
+	 * @brief Creates the two history images, one resolved into while the other is read
+	 */
+	void prepare_history(const VkExtent2D &extent);
+
+	RenderContext &render_context;
+
+	ShaderSource shader_source;
+
+	const core::Sampler *linear_sampler{nullptr};
+
+	const core::Sampler *point_sampler{nullptr};
+
+	float blend_factor{0.1f};
+
+	uint32_t jitter_index{0};
+
+	glm::vec2 jitter{0.0f, 0.0f};
+
+	VkExtent2D history_extent{0, 0};
+
+	std::unique_ptr<core::Image> history_images[2];
+
+	std::unique_ptr<core::ImageView> history_views[2];
+
+	/// Image of the next resolve, the other holds the history
+	uint32_t current_history{0};
+
+	bool has_history{false};
+};
+}        // namespace vkb
@@ -0,0 +1,155 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "rendering/transform_buffer.h"
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+TransformBuffer::TransformBuffer(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+void TransformBuffer::set_nodes(const std::vector<sg::Node *> &nodes)
+{
+	slots.clear();
+	transforms.clear();
+
+	for (auto node : nodes)
+	{
+		if (slots.count(node))
+		{
+			continue;
+		}
+
+		slots.emplace(node, to_u32(transforms.size()));
+		transforms.push_back(get_transform(*node));
+	}
+
+	++revision;
+	++layout_revision;
+
+	transform_revisions.assign(transforms.size(), revision);
+}
+
+void TransformBuffer::update_nodes(const std::vector<sg::Node *> &nodes)
+{
+	bool updated = false;
+
+	for (auto node : nodes)
+	{
+		auto slot_it = slots.find(node);
+
+		if (slot_it == slots.end())
+		{
+			continue;
+		}
+
+		if (!updated)
+		{
+			++revision;
+			updated = true;
+		}
+
+		transforms[slot_it->second]          = get_transform(*node);
+		transform_revisions[slot_it->second] = revision;
+	}
+}
+
+uint32_t TransformBuffer::find_slot(const sg::Node &node) const
+{
+	auto slot_it = slots.find(&node);
+
+	return slot_it == slots.end() ? NO_SLOT : slot_it->second;
+}
+
+void TransformBuffer::update()
+{
+	frame_resources.resize(render_context.get_render_frames().size());
+
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	upload_size = 0;
+
+	if (resources.revision == revision || transforms.empty())
+	{
+		return;
+	}
+
+	if (resources.layout_revision == layout_revision)
+	{
+		// Only the transforms which changed since the last upload to the frame are written
+		for (size_t slot = 0; slot < transforms.size(); slot++)
+		{
+			if (transform_revisions[slot] > resources.revision)
+			{
+				resources.buffer->update(reinterpret_cast<const uint8_t *>(&transforms[slot]), sizeof(Transform), slot * sizeof(Transform));
+
+				upload_size += sizeof(Transform);
+			}
+		}
+	}
+	else
+	{
+		// The frame's previous submission completed, its buffer is free
+		auto size = transforms.size() * sizeof(Transform);
+
+		if (!resources.buffer || resources.buffer->get_size() < size)
+		{
+			resources.buffer = std::make_unique<core::Buffer>(render_context.get_device(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		}
+
+		resources.buffer->update(reinterpret_cast<const uint8_t *>(transforms.data()), size);
+
+		upload_size = size;
+
+		resources.layout_revision = layout_revision;
+	}
+
+	resources.revision = revision;
+}
+
+void TransformBuffer::bind(CommandBuffer &command_buffer, uint32_t set, uint32_t binding) const
+{
+	auto &resources = frame_resources.at(render_context.get_active_frame_index());
+
+	if (resources.buffer)
+	{
+		command_buffer.bind_buffer(*resources.buffer, 0, resources.buffer->get_size(), set, binding, 0);
+	}
+}
+
+size_t TransformBuffer::get_upload_size() const
+{
+	return upload_size;
+}
+
+TransformBuffer::Transform TransformBuffer::get_transform(sg::Node &node)
+{
+	// The columns of the world matrix are the rows of its transpose
+	auto world_matrix = glm::transpose(node.get_transform().get_world_matrix());
+
+	return {{world_matrix[0], world_matrix[1], world_matrix[2]}};
+}
+}        // namespace vkb
@@ -0,0 +1,124 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <unordered_map>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Node;
+}        // namespace sg
+
+/**
+ * @brief The world transforms of the nodes of a scene in a buffer the draws index, kept on the GPU across frames
+ *
+ * Each node has a slot holding the rows of its world matrix, a 3x4 matrix as the last row of an affine transform
+ * is implied. Each render frame has its own buffer, which only gets the slots of the nodes which moved since its
+ * last upload, so a static scene uploads nothing once every frame has its copy.
+ */
+class TransformBuffer
+{
+  public:
+	static constexpr uint32_t NO_SLOT = ~0u;
+
+	TransformBuffer(RenderContext &render_context);
+
+	/**
+	 * @brief Gives a slot to each node, the transforms of every frame are uploaded again
+	 */
+	void set_nodes(const std::vector<sg::Node *> &nodes);
+
+	/**
+	 * @brief Marks the transforms of the nodes which moved, for the next upload of each frame
+	 */
+	void update_nodes(const std::vector<sg::Node *> &nodes);
+
+	/**
+	 * @return The slot of a node, NO_SLOT if it has none
+	 */
+	uint32_t find_slot(const sg::Node &node) const;
+
+	/**
+	 * @brief Uploads the transforms which changed since the last upload to the buffer of the active frame
+	 */
+	void update();
+
+	/**
+	 * @brief Binds the buffer of the active frame, after update()
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t set, uint32_t binding) const;
+
+	/**
+	 * @return The number of bytes written by the last update()
+	 */
+	size_t get_upload_size() const;
+
+  private:
+	/// Layout of a transform in the shaders, the rows of the world matrix
+	struct Transform
+	{
+		glm::vec4 rows[3];
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		/// Revision of the transforms in the buffer
+		uint64_t revision{0};
+
+		/// Revision of the set of nodes in the buffer
+		uint64_t layout_revision{0};
+	};
+
+	static Transform get_transform(sg::Node &node);
+
+	RenderContext &render_context;
+
+	std::unordered_map<const sg::Node *, uint32_t> slots;
+
+	std::vector<Transform> transforms;
+
+	/// Revision at which each transform last changed
+	std::vector<uint64_t> transform_revisions;
+
+	uint64_t revision{0};
+
+	uint64_t layout_revision{0};
+
+	std::vector<FrameResources> frame_resources;
+
+	size_t upload_size{0};
+};
+}        // namespace vkb
@@ -17,108 +17,213 @@
 
 #include "resource_binding_state.h"
 
+#include "common/logging.h"
+
 namespace vkb
 {
+namespace
+{
+size_t hash_resource(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info)
+{
+	size_t result = 0;
+
+	hash_combine(result, binding);
+	hash_combine(result, array_element);
+	hash_combine(result, resource_info.buffer);
+	hash_combine(result, resource_info.offset);
+	hash_combine(result, resource_info.range);
+	hash_combine(result, resource_info.image_view);
+	hash_combine(result, resource_info.sampler);
+
+	return result;
+}
+}        // namespace
+
 void ResourceBindingState::reset()
 {
-	clear_dirty();
+	// The resources of unbound sets are never read, only the masks need clearing
+	for (auto set_mask = bound_sets; set_mask; set_mask &= set_mask - 1)
+	{
+		resource_sets[lowest_bit_index(set_mask)].reset();
+	}
 
-	resource_sets.clear();
+	bound_sets = 0;
+	dirty_sets = 0;
 }
 
-bool ResourceBindingState::is_dirty()
+bool ResourceBindingState::is_dirty() const
 {
-	return dirty;
+	return dirty_sets != 0;
 }
 
 void ResourceBindingState::clear_dirty()
 {
-	dirty = false;
+	dirty_sets = 0;
 }
 
 void ResourceBindingState::clear_dirty(uint32_t set)
 {
-	resource_sets[set].clear_dirty();
+	dirty_sets &= ~(1u << set);
 }
 
 void ResourceBindingState::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_buffer(buffer, offset, range, binding, array_element);
-
-	dirty = true;
+	if (bind(set).bind_buffer(buffer, offset, range, binding, array_element))
+	{
+		dirty_sets |= 1u << set;
+	}
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, sampler, binding, array_element);
-
-	dirty = true;
+	if (bind(set).bind_image(image_view, sampler, binding, array_element))
+	{
+		dirty_sets |= 1u << set;
+	}
 }
 
 void ResourceBindingState::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_input(image_view, binding, array_element);
+	if (bind(set).bind_input(image_view, binding, array_element))
+	{
+		dirty_sets |= 1u << set;
+	}
+}
+
+uint32_t ResourceBindingState::get_bound_sets() const
+{
+	return bound_sets;
+}
 
-	dirty = true;
+uint32_t ResourceBindingState::get_dirty_sets() const
+{
+	return dirty_sets;
 }
 
-const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+const ResourceSet &ResourceBindingState::get_resource_set(uint32_t set) const
 {
-	return resource_sets;
+	assert(set < MAX_SETS && "Set index out of range");
+
+	return resource_sets[set];
 }
 
-void ResourceSet::reset()
+ResourceSet &ResourceBindingState::bind(uint32_t set)
 {
-	clear_dirty();
+	if (set >= MAX_SETS)
+	{
+		LOGE("Descriptor set {} exceeds the {} sets supported by the resource binding state", set, MAX_SETS);
+		throw std::runtime_error("Descriptor set index out of range");
+	}
+
+	bound_sets |= 1u << set;
 
-	resource_bindings.clear();
+	return resource_sets[set];
 }
 
-bool ResourceSet::is_dirty() const
+void ResourceSet::reset()
 {
-	return dirty;
+	for (auto binding_mask = bound_bindings; binding_mask; binding_mask &= binding_mask - 1)
+	{
+		bound_array_elements[lowest_bit_index(binding_mask)] = 0;
+	}
+
+	bound_bindings = 0;
+
+	hash = 0;
 }
 
-void ResourceSet::clear_dirty()
+bool ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
 {
-	dirty = false;
+	ResourceInfo resource_info = get_bound_resource(binding, array_element);
+
+	resource_info.buffer = &buffer;
+	resource_info.offset = offset;
+	resource_info.range  = range;
+
+	return bind(binding, array_element, resource_info);
 }
 
-void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
+bool ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty = false;
+	ResourceInfo resource_info = get_bound_resource(binding, array_element);
+
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = &sampler;
+
+	return bind(binding, array_element, resource_info);
 }
 
-void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
+bool ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty  = true;
-	resource_bindings[binding][array_element].buffer = &buffer;
-	resource_bindings[binding][array_element].offset = offset;
-	resource_bindings[binding][array_element].range  = range;
+	ResourceInfo resource_info = get_bound_resource(binding, array_element);
+
+	resource_info.image_view = &image_view;
 
-	dirty = true;
+	return bind(binding, array_element, resource_info);
 }
 
-void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
+size_t ResourceSet::get_hash() const
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = &sampler;
+	return hash;
+}
 
-	dirty = true;
+uint32_t ResourceSet::get_bound_bindings() const
+{
+	return bound_bindings;
 }
 
-void ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
+uint32_t ResourceSet::get_bound_array_elements(uint32_t binding) const
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
+	return bound_array_elements[binding];
+}
 
-	dirty = true;
+const ResourceInfo &ResourceSet::get_resource(uint32_t binding, uint32_t array_element) const
+{
+	return resources[binding][array_element];
 }
 
-const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
+ResourceInfo ResourceSet::get_bound_resource(uint32_t binding, uint32_t array_element) const
 {
-	return resource_bindings;
+	if (binding >= MAX_BINDINGS || array_element >= MAX_ARRAY_ELEMENTS)
+	{
+		LOGE("Binding {} element {} exceeds the {} bindings of {} elements supported by a resource set", binding, array_element, MAX_BINDINGS, MAX_ARRAY_ELEMENTS);
+		throw std::runtime_error("Binding index out of range");
+	}
+
+	// A slot bound for the first time since the reset may hold the resources of a previous recording
+	if (!(bound_array_elements[binding] & (1u << array_element)))
+	{
+		return {};
+	}
+
+	return resources[binding][array_element];
 }
 
+bool ResourceSet::bind(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info)
+{
+	auto &bound_resource = resources[binding][array_element];
+
+	bool bound = bound_array_elements[binding] & (1u << array_element);
+
+	if (bound)
+	{
+		if (bound_resource.buffer == resource_info.buffer && bound_resource.offset == resource_info.offset && bound_resource.range == resource_info.range &&
+		    bound_resource.image_view == resource_info.image_view && bound_resource.sampler == resource_info.sampler)
+		{
+			return false;
+		}
+
+		// Slots are combined with a xor, so that the hash does not depend on the binding order
+		hash ^= hash_resource(binding, array_element, bound_resource);
+	}
+
+	bound_resource = resource_info;
+
+	bound_array_elements[binding] |= 1u << array_element;
+	bound_bindings |= 1u << binding;
+
+	hash ^= hash_resource(binding, array_element, bound_resource);
+
+	return true;
+}
 }        // namespace vkb
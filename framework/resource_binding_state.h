@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/buffer.h"
 #include "core/image_view.h"
@@ -31,8 +32,6 @@ namespace vkb
  */
 struct ResourceInfo
 {
-	bool dirty{false};
-
 	const core::Buffer *buffer{nullptr};
 
 	VkDeviceSize offset{0};
@@ -48,31 +47,62 @@ struct ResourceInfo
  * @brief A resource set is a set of bindings containing resources that were bound 
  *        by a command buffer.
  *
- * The ResourceSet has a one to one mapping with a DescriptorSet.
+ * The ResourceSet has a one to one mapping with a DescriptorSet. Resources are stored in
+ * a fixed array indexed by binding and array element, and masks of the bound slots
+ * let the command buffer walk only what was bound without any map lookup.
  */
 class ResourceSet
 {
   public:
+	static constexpr uint32_t MAX_BINDINGS = 16;
+
+	static constexpr uint32_t MAX_ARRAY_ELEMENTS = 4;
+
 	void reset();
 
-	bool is_dirty() const;
+	/**
+	 * @return Whether the binding changed, binding the same resources again leaves the set untouched
+	 */
+	bool bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element);
 
-	void clear_dirty();
+	bool bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element);
 
-	void clear_dirty(uint32_t binding, uint32_t array_element);
+	bool bind_input(const core::ImageView &image_view, uint32_t binding, uint32_t array_element);
 
-	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element);
+	/**
+	 * @brief Hash of all the bound resources, updated with each binding
+	 *        Sets with the same resources have the same hash whatever the order they were bound in.
+	 */
+	size_t get_hash() const;
 
-	void bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element);
+	/**
+	 * @return A mask with a bit set for each binding with at least one resource bound
+	 */
+	uint32_t get_bound_bindings() const;
 
-	void bind_input(const core::ImageView &image_view, uint32_t binding, uint32_t array_element);
+	/**
+	 * @return A mask with a bit set for each array element bound to a binding
+	 */
+	uint32_t get_bound_array_elements(uint32_t binding) const;
 
-	const BindingMap<ResourceInfo> &get_resource_bindings() const;
+	const ResourceInfo &get_resource(uint32_t binding, uint32_t array_element) const;
 
   private:
-	bool dirty{false};
+	ResourceInfo get_bound_resource(uint32_t binding, uint32_t array_element) const;
+
+	/**
+	 * @brief Stores the resources of a slot, updating the hash
+	 * @return False if the slot already held these resources
+	 */
+	bool bind(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info);
+
+	size_t hash{0};
+
+	uint32_t bound_bindings{0};
 
-	BindingMap<ResourceInfo> resource_bindings;
+	std::array<uint8_t, MAX_BINDINGS> bound_array_elements{};
+
+	std::array<std::array<ResourceInfo, MAX_ARRAY_ELEMENTS>, MAX_BINDINGS> resources{};
 };
 
 /**
@@ -84,9 +114,11 @@ class ResourceSet
 class ResourceBindingState
 {
   public:
+	static constexpr uint32_t MAX_SETS = 4;
+
 	void reset();
 
-	bool is_dirty();
+	bool is_dirty() const;
 
 	void clear_dirty();
 
@@ -98,11 +130,25 @@ class ResourceBindingState
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+	/**
+	 * @return A mask with a bit set for each set with resources bound
+	 */
+	uint32_t get_bound_sets() const;
+
+	/**
+	 * @return A mask with a bit set for each set with resources changed since its dirty flag was cleared
+	 */
+	uint32_t get_dirty_sets() const;
+
+	const ResourceSet &get_resource_set(uint32_t set) const;
 
   private:
-	bool dirty{false};
+	ResourceSet &bind(uint32_t set);
+
+	uint32_t bound_sets{0};
+
+	uint32_t dirty_sets{0};
 
-	std::unordered_map<uint32_t, ResourceSet> resource_sets;
+	std::array<ResourceSet, MAX_SETS> resource_sets;
 };
 }        // namespace vkb
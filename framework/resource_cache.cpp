@@ -17,96 +17,984 @@
 
 #include "resource_cache.h"
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include <thread>
+
+#include <ctpl_stl.h>
+
+#include "common/logging.h"
 #include "common/resource_caching.h"
 #include "core/device.h"
+#include "core/pipeline_cache.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
 namespace
 {
+template <class L>
+void lock_counting_contention(L &guard, ResourceCacheLock &resource_lock)
+{
+	if (!guard.try_lock())
+	{
+		resource_lock.contentions.fetch_add(1, std::memory_order_relaxed);
+		guard.lock();
+	}
+}
+
+/// Must be called with the lock held, shared if the entry was already stamped
+inline void stamp_usage(ResourceCacheLock &resource_lock, std::size_t hash, uint64_t frame_index, bool exclusive)
+{
+	if (!resource_lock.track_usage)
+	{
+		return;
+	}
+
+	auto it = resource_lock.last_used.find(hash);
+
+	if (it != resource_lock.last_used.end())
+	{
+		it->second.store(frame_index, std::memory_order_relaxed);
+	}
+	else if (exclusive)
+	{
+		resource_lock.last_used[hash].store(frame_index, std::memory_order_relaxed);
+	}
+}
+
+template <class T, class... A>
+T &request_resource(Device &device, ResourceRecord &recorder, ResourceCacheLock &resource_lock, uint64_t frame_index, std::unordered_map<std::size_t, T> &resources, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	// Hit path, readers can look up the map concurrently
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(resource_lock.mutex, std::defer_lock);
+		lock_counting_contention(guard, resource_lock);
+
+		auto res_it = resources.find(hash);
+
+		if (res_it != resources.end())
+		{
+			stamp_usage(resource_lock, hash, frame_index, false);
+			return res_it->second;
+		}
+	}
+
+	// Miss path, another thread may have built the resource in the meantime so look it up again
+	std::unique_lock<std::shared_timed_mutex> guard(resource_lock.mutex, std::defer_lock);
+	lock_counting_contention(guard, resource_lock);
+
+	auto &res = request_resource(device, &recorder, resources, args...);
+
+	stamp_usage(resource_lock, hash, frame_index, true);
+
+	return res;
+}
+
+/**
+ * @brief Same as request_resource, but a miss builds the resource without holding the lock
+ *        so that threads compiling different shaders or pipelines do not wait for each other.
+ *        Only suitable for resources whose construction does not share state with the other
+ *        resources of the map: if two threads build the same resource, one copy is dropped.
+ * @param on_insert Called with the hash and the resource once it is inserted, with the lock held
+ */
+template <class T, class F, class... A>
+T &request_indexed_resource_concurrently(Device &device, ResourceRecord &recorder, ResourceCacheLock &resource_lock, uint64_t frame_index, std::unordered_map<std::size_t, T> &resources, F on_insert, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(resource_lock.mutex, std::defer_lock);
+		lock_counting_contention(guard, resource_lock);
+
+		auto res_it = resources.find(hash);
+
+		if (res_it != resources.end())
+		{
+			stamp_usage(resource_lock, hash, frame_index, false);
+			return res_it->second;
+		}
+	}
+
+	LOGD("Building cache object ({})", typeid(T).name());
+
+	T resource(device, args...);
+
+	std::unique_lock<std::shared_timed_mutex> guard(resource_lock.mutex, std::defer_lock);
+	lock_counting_contention(guard, resource_lock);
+
+	auto res_ins_it = resources.emplace(hash, std::move(resource));
+
+	if (res_ins_it.second)
+	{
+		RecordHelper<T, A...> record_helper;
+
+		size_t index = record_helper.record(recorder, args...);
+		record_helper.index(recorder, index, res_ins_it.first->second);
+
+		on_insert(hash, res_ins_it.first->second);
+	}
+
+	stamp_usage(resource_lock, hash, frame_index, true);
+
+	return res_ins_it.first->second;
+}
+
 template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, A &... args)
+T &request_resource_concurrently(Device &device, ResourceRecord &recorder, ResourceCacheLock &resource_lock, uint64_t frame_index, std::unordered_map<std::size_t, T> &resources, A &... args)
+{
+	return request_indexed_resource_concurrently(
+	    device, recorder, resource_lock, frame_index, resources, [](std::size_t, T &) {}, args...);
+}
+
+/**
+ * @brief Erases the entries of a map whose pipeline uses one of the pipeline layouts
+ * @return The number of erased entries
+ */
+template <class T>
+size_t erase_pipelines(ResourceCacheLock &resource_lock, std::unordered_map<std::size_t, T> &pipelines, const std::unordered_set<const PipelineLayout *> &pipeline_layouts,
+                       DeletionQueue &deletion_queue)
+{
+	size_t erased = 0;
+
+	std::lock_guard<std::shared_timed_mutex> guard(resource_lock.mutex);
+
+	for (auto it = pipelines.begin(); it != pipelines.end();)
+	{
+		if (pipeline_layouts.count(&it->second.get_state().get_pipeline_layout()) > 0)
+		{
+			++erased;
+			resource_lock.last_used.erase(it->first);
+			deletion_queue.retire(std::move(it->second));
+			it = pipelines.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	return erased;
+}
+
+/**
+ * @brief Moves the values of a container of pairs to the deletion queue, as the frames in flight may still use them
+ */
+template <class T>
+void retire_values(T &container, DeletionQueue &deletion_queue)
+{
+	for (auto &entry : container)
+	{
+		deletion_queue.retire(std::move(entry.second));
+	}
+
+	container.clear();
+}
+
+/**
+ * @brief Evicts the least recently used entries of a map until it fits in the budget
+ *        Entries used by one of the frames in flight are always kept
+ * @return The hashes of the evicted entries
+ */
+template <class T>
+std::vector<std::size_t> evict_resources(ResourceCacheLock &resource_lock, std::unordered_map<std::size_t, T> &resources, size_t max_count, uint64_t frame_index, uint32_t frames_in_flight)
+{
+	std::vector<std::size_t> evicted;
+
+	if (max_count == 0)
+	{
+		return evicted;
+	}
+
+	std::lock_guard<std::shared_timed_mutex> guard(resource_lock.mutex);
+
+	if (resources.size() <= max_count)
+	{
+		return evicted;
+	}
+
+	std::vector<std::pair<uint64_t, std::size_t>> candidates;
+
+	for (auto &usage : resource_lock.last_used)
+	{
+		auto last_used = usage.second.load(std::memory_order_relaxed);
+
+		if (last_used + frames_in_flight <= frame_index)
+		{
+			candidates.emplace_back(last_used, usage.first);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	for (auto &candidate : candidates)
+	{
+		if (resources.size() <= max_count)
+		{
+			break;
+		}
+
+		resources.erase(candidate.second);
+		resource_lock.last_used.erase(candidate.second);
+		evicted.push_back(candidate.second);
+	}
+
+	return evicted;
+}
+
+template <class T>
+uint64_t count_entries(ResourceCacheLock &resource_lock, const std::unordered_map<std::size_t, T> &resources, uint64_t &bytes)
+{
+	std::shared_lock<std::shared_timed_mutex> guard(resource_lock.mutex);
+
+	bytes += resources.size() * (sizeof(std::size_t) + sizeof(T));
+
+	return resources.size();
+}
+}        // namespace
+
+ResourceCache::ResourceCache(Device &device) :
+    device{device}
+{
+	graphics_pipeline_lock.track_usage = true;
+	compute_pipeline_lock.track_usage  = true;
+	framebuffer_lock.track_usage       = true;
+}
+
+ResourceCache::~ResourceCache()
+{
+	wait_for_async_pipelines();
+}
+
+void ResourceCache::warmup(const std::vector<uint8_t> &data)
+{
+	warmup(data.data(), data.size());
+}
+
+void ResourceCache::warmup(const uint8_t *data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	if (!replayer.load(data, size))
+	{
+		LOGW("Resource cache data discarded");
+		return;
+	}
+
+	auto &pipeline_cache_data = replayer.get_pipeline_cache_data();
+
+	if (pipeline_cache != VK_NULL_HANDLE && !pipeline_cache_data.empty())
+	{
+		if (replayer.is_compatible(device.get_gpu().get_properties()))
+		{
+			VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+			create_info.initialDataSize = pipeline_cache_data.size();
+			create_info.pInitialData    = pipeline_cache_data.data();
+
+			VkPipelineCache stored_cache{VK_NULL_HANDLE};
+			if (vkCreatePipelineCache(device.get_handle(), &create_info, nullptr, &stored_cache) == VK_SUCCESS)
+			{
+				VK_CHECK(vkMergePipelineCaches(device.get_handle(), pipeline_cache, 1, &stored_cache));
+				vkDestroyPipelineCache(device.get_handle(), stored_cache, nullptr);
+			}
+		}
+		else
+		{
+			LOGI("Resource cache was written by a different device or driver, discarding its pipeline cache data");
+		}
+	}
+
+	try
+	{
+		replayer.play(*this);
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Resource cache warmup stopped: {}", e.what());
+	}
+}
+
+std::vector<uint8_t> ResourceCache::serialize()
+{
+	std::vector<uint8_t> pipeline_cache_data;
+
+	if (persistent_pipeline_cache)
+	{
+		wait_for_async_pipelines();
+
+		persistent_pipeline_cache->merge_thread_caches();
+	}
+
+	if (pipeline_cache != VK_NULL_HANDLE)
+	{
+		size_t data_size{0};
+		VK_CHECK(vkGetPipelineCacheData(device.get_handle(), pipeline_cache, &data_size, nullptr));
+
+		pipeline_cache_data.resize(data_size);
+		VK_CHECK(vkGetPipelineCacheData(device.get_handle(), pipeline_cache, &data_size, pipeline_cache_data.data()));
+		pipeline_cache_data.resize(data_size);
+	}
+
+	return recorder.get_data(device.get_gpu().get_properties(), pipeline_cache_data);
+}
+
+void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
+{
+	wait_for_async_pipelines();
+
+	pipeline_cache            = new_pipeline_cache;
+	persistent_pipeline_cache = nullptr;
+}
+
+void ResourceCache::set_pipeline_cache(PipelineCache &new_pipeline_cache)
+{
+	wait_for_async_pipelines();
+
+	pipeline_cache            = new_pipeline_cache.get_handle();
+	persistent_pipeline_cache = &new_pipeline_cache;
+}
+
+ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
+{
+	VKB_PROFILE_ZONE("ResourceCache::request_shader_module");
+
+	std::string entry_point{"main"};
+
+	auto index_shader_module = [this, stage, &glsl_source, &shader_variant](std::size_t hash, ShaderModule &) {
+		std::lock_guard<std::mutex> guard(shader_dependency_mutex);
+		shader_source_modules[glsl_source.get_id()].push_back({hash, stage, shader_variant});
+	};
+
+	return request_indexed_resource_concurrently(device, recorder, shader_module_lock, frame_index, state.shader_modules, index_shader_module, stage, glsl_source, entry_point, shader_variant);
+}
+
+std::shared_future<ShaderModule *> ResourceCache::request_shader_module_async(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
+{
+	{
+		std::lock_guard<std::mutex> guard(shader_compile_pool_mutex);
+
+		if (!shader_compile_pool)
+		{
+			shader_compile_pool = std::make_unique<ctpl::thread_pool>(std::max(1U, std::thread::hardware_concurrency()));
+		}
+	}
+
+	// A hit only takes the shared lock of the map, so it is cheap on the compile threads too
+	auto compile = [this, stage, glsl_source, shader_variant](size_t) {
+		return &request_shader_module(stage, glsl_source, shader_variant);
+	};
+
+	return shader_compile_pool->push(compile).share();
+}
+
+PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
+{
+	VKB_PROFILE_ZONE("ResourceCache::request_pipeline_layout");
+
+	auto index_pipeline_layout = [this, &shader_modules](std::size_t hash, PipelineLayout &) {
+		std::lock_guard<std::mutex> guard(shader_dependency_mutex);
+
+		for (auto *shader_module : shader_modules)
+		{
+			shader_module_layouts[shader_module].push_back(hash);
+		}
+	};
+
+	return request_indexed_resource_concurrently(device, recorder, pipeline_layout_lock, frame_index, state.pipeline_layouts, index_pipeline_layout, shader_modules);
+}
+
+bool ResourceCache::reload_shader_source(size_t old_source_id, const ShaderSource &new_source)
+{
+	std::vector<ShaderModuleDependency> dependencies;
+
+	{
+		std::lock_guard<std::mutex> guard(shader_dependency_mutex);
+
+		auto source_it = shader_source_modules.find(old_source_id);
+		if (source_it == shader_source_modules.end())
+		{
+			return true;
+		}
+
+		dependencies = source_it->second;
+	}
+
+	// Compile every variant first, so that an error does not leave the cache without them
+	std::vector<std::shared_future<ShaderModule *>> new_modules;
+	for (auto &dependency : dependencies)
+	{
+		new_modules.push_back(request_shader_module_async(dependency.stage, new_source, dependency.shader_variant));
+	}
+
+	try
+	{
+		for (auto &new_module : new_modules)
+		{
+			new_module.get();
+		}
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Failed to reload shader {}: {}", new_source.get_filename(), e.what());
+		return false;
+	}
+
+	// Pipelines being compiled may refer to the old modules, the frames in flight are covered by the deletion queue
+	wait_for_async_pipelines();
+
+	auto &deletion_queue = device.get_deletion_queue();
+
+	std::unordered_set<std::size_t> layout_hashes;
+	std::vector<std::size_t>        module_hashes;
+
+	{
+		std::lock_guard<std::mutex> guard(shader_dependency_mutex);
+
+		for (auto &dependency : shader_source_modules[old_source_id])
+		{
+			module_hashes.push_back(dependency.hash);
+
+			auto module_it = state.shader_modules.find(dependency.hash);
+			if (module_it == state.shader_modules.end())
+			{
+				continue;
+			}
+
+			auto layouts_it = shader_module_layouts.find(&module_it->second);
+			if (layouts_it != shader_module_layouts.end())
+			{
+				layout_hashes.insert(layouts_it->second.begin(), layouts_it->second.end());
+				shader_module_layouts.erase(layouts_it);
+			}
+		}
+
+		shader_source_modules.erase(old_source_id);
+	}
+
+	std::unordered_set<const PipelineLayout *> pipeline_layouts;
+	for (auto hash : layout_hashes)
+	{
+		auto layout_it = state.pipeline_layouts.find(hash);
+		if (layout_it != state.pipeline_layouts.end())
+		{
+			pipeline_layouts.insert(&layout_it->second);
+		}
+	}
+
+	// Pipelines are not indexed, they are found through the layout they were created with
+	auto uses_old_layout = [&pipeline_layouts](const GraphicsPipeline &pipeline) {
+		return pipeline_layouts.count(&pipeline.get_state().get_pipeline_layout()) > 0;
+	};
+
+	{
+		std::lock_guard<std::mutex> guard(optimized_pipeline_mutex);
+
+		// Pipelines cannot be assigned, the kept ones are moved to a new vector
+		std::vector<std::pair<std::size_t, GraphicsPipeline>> kept_pipelines;
+		for (auto &optimized : optimized_pipelines)
+		{
+			if (uses_old_layout(optimized.second))
+			{
+				deletion_queue.retire(std::move(optimized.second));
+			}
+			else
+			{
+				kept_pipelines.emplace_back(optimized.first, std::move(optimized.second));
+			}
+		}
+
+		optimized_pipelines.swap(kept_pipelines);
+	}
+
+	size_t pipeline_count = erase_pipelines(graphics_pipeline_lock, state.graphics_pipelines, pipeline_layouts, deletion_queue);
+	pipeline_count += erase_pipelines(compute_pipeline_lock, state.compute_pipelines, pipeline_layouts, deletion_queue);
+	erase_pipelines(graphics_pipeline_library_lock, state.graphics_pipeline_libraries, pipeline_layouts, deletion_queue);
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(pipeline_layout_lock.mutex);
+
+		for (auto hash : layout_hashes)
+		{
+			auto layout_it = state.pipeline_layouts.find(hash);
+			if (layout_it != state.pipeline_layouts.end())
+			{
+				deletion_queue.retire(std::move(layout_it->second));
+				state.pipeline_layouts.erase(layout_it);
+			}
+			pipeline_layout_lock.last_used.erase(hash);
+		}
+	}
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(shader_module_lock.mutex);
+
+		for (auto hash : module_hashes)
+		{
+			auto module_it = state.shader_modules.find(hash);
+			if (module_it != state.shader_modules.end())
+			{
+				deletion_queue.retire(std::move(module_it->second));
+				state.shader_modules.erase(module_it);
+			}
+			shader_module_lock.last_used.erase(hash);
+		}
+	}
+
+	LOGI("Reloaded shader {}: {} modules, {} pipeline layouts and {} pipelines to rebuild", new_source.get_filename(), module_hashes.size(), layout_hashes.size(), pipeline_count);
+
+	return true;
+}
+
+DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const uint32_t set_index, const std::vector<ShaderResource> &set_resources)
+{
+	VKB_PROFILE_ZONE("ResourceCache::request_descriptor_set_layout");
+
+	return request_resource(device, recorder, descriptor_set_layout_lock, frame_index, state.descriptor_set_layouts, set_index, set_resources);
+}
+
+GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
+{
+	return request_graphics_pipeline(pipeline_state, pipeline_cache);
+}
+
+bool ResourceCache::is_pipeline_library_enabled()
+{
+	return pipeline_library && device.is_enabled("VK_EXT_graphics_pipeline_library");
+}
+
+void ResourceCache::set_pipeline_library(bool enabled)
+{
+	pipeline_library = enabled;
+}
+
+GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state, VkPipelineCache cache)
+{
+	VKB_PROFILE_ZONE("ResourceCache::request_graphics_pipeline");
+
+	// The pre-rasterization libraries only take the vertex processing stages
+	if (is_pipeline_library_enabled() && !uses_mesh_shading(pipeline_state))
+	{
+		return request_linked_graphics_pipeline(pipeline_state, cache);
+	}
+
+	return request_resource_concurrently(device, recorder, graphics_pipeline_lock, frame_index, state.graphics_pipelines, cache, pipeline_state);
+}
+
+GraphicsPipeline &ResourceCache::request_linked_graphics_pipeline(PipelineState &pipeline_state, VkPipelineCache cache)
 {
-	std::lock_guard<std::mutex> guard(resource_mutex);
+	// Hashed like the monolithic pipelines, so that recorded pipelines are replayed the same way
+	std::size_t hash{0U};
+	hash_param(hash, cache, pipeline_state);
+
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(graphics_pipeline_lock.mutex, std::defer_lock);
+		lock_counting_contention(guard, graphics_pipeline_lock);
+
+		auto res_it = state.graphics_pipelines.find(hash);
+
+		if (res_it != state.graphics_pipelines.end())
+		{
+			stamp_usage(graphics_pipeline_lock, hash, frame_index, false);
+			return res_it->second;
+		}
+	}
+
+	std::vector<const GraphicsPipelineLibrary *> libraries{
+	    &request_graphics_pipeline_library(pipeline_state, cache, PipelineLibraryType::VertexInput),
+	    &request_graphics_pipeline_library(pipeline_state, cache, PipelineLibraryType::PreRasterization),
+	    &request_graphics_pipeline_library(pipeline_state, cache, PipelineLibraryType::FragmentShader),
+	    &request_graphics_pipeline_library(pipeline_state, cache, PipelineLibraryType::FragmentOutput)};
+
+	GraphicsPipeline pipeline{device, cache, pipeline_state, libraries, false};
+
+	std::unique_lock<std::shared_timed_mutex> guard(graphics_pipeline_lock.mutex, std::defer_lock);
+	lock_counting_contention(guard, graphics_pipeline_lock);
+
+	auto res_ins_it = state.graphics_pipelines.emplace(hash, std::move(pipeline));
+
+	if (res_ins_it.second)
+	{
+		RecordHelper<GraphicsPipeline, VkPipelineCache, PipelineState> record_helper;
 
-	auto &res = request_resource(device, &recorder, resources, args...);
+		size_t index = record_helper.record(recorder, cache, pipeline_state);
+		record_helper.index(recorder, index, res_ins_it.first->second);
 
-	return res;
+		queue_optimized_pipeline(hash, pipeline_state, libraries);
+	}
+
+	stamp_usage(graphics_pipeline_lock, hash, frame_index, true);
+
+	return res_ins_it.first->second;
 }
-}        // namespace
 
-ResourceCache::ResourceCache(Device &device) :
-    device{device}
+GraphicsPipelineLibrary &ResourceCache::request_graphics_pipeline_library(PipelineState &pipeline_state, VkPipelineCache cache, PipelineLibraryType type)
 {
+	std::size_t hash = pipeline_state.get_library_hash(type);
+
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(graphics_pipeline_library_lock.mutex, std::defer_lock);
+		lock_counting_contention(guard, graphics_pipeline_library_lock);
+
+		auto res_it = state.graphics_pipeline_libraries.find(hash);
+
+		if (res_it != state.graphics_pipeline_libraries.end())
+		{
+			return res_it->second;
+		}
+	}
+
+	LOGD("Building cache object ({})", typeid(GraphicsPipelineLibrary).name());
+
+	GraphicsPipelineLibrary library{device, cache, pipeline_state, type};
+
+	std::unique_lock<std::shared_timed_mutex> guard(graphics_pipeline_library_lock.mutex, std::defer_lock);
+	lock_counting_contention(guard, graphics_pipeline_library_lock);
+
+	return state.graphics_pipeline_libraries.emplace(hash, std::move(library)).first->second;
 }
 
-void ResourceCache::warmup(const std::vector<uint8_t> &data)
+void ResourceCache::queue_optimized_pipeline(std::size_t hash, const PipelineState &pipeline_state, const std::vector<const GraphicsPipelineLibrary *> &libraries)
 {
-	recorder.set_data(data);
+	std::lock_guard<std::mutex> guard(optimized_pipeline_mutex);
+
+	if (!pipeline_link_pool)
+	{
+		pipeline_link_pool = std::make_unique<ctpl::thread_pool>(1);
+	}
+
+	// Libraries are only destroyed by clear_pipelines, which waits for the pending links first
+	auto pending = pipeline_link_pool->push([this, hash, state_copy = pipeline_state, libraries](size_t) mutable {
+		try
+		{
+			GraphicsPipeline optimized{device, pipeline_cache, state_copy, libraries, true};
+
+			std::lock_guard<std::mutex> guard(optimized_pipeline_mutex);
+			optimized_pipelines.emplace_back(hash, std::move(optimized));
+		}
+		catch (const std::exception &e)
+		{
+			// The fast linked pipeline stays in use
+			LOGE("Link time optimization of graphics pipeline failed: {}", e.what());
+		}
+	});
 
-	replayer.play(*this, recorder);
+	pending_optimized_pipelines.push_back(std::move(pending));
 }
 
-std::vector<uint8_t> ResourceCache::serialize()
+void ResourceCache::update_optimized_pipelines()
 {
-	return recorder.get_data();
+	std::vector<std::pair<std::size_t, GraphicsPipeline>> ready_pipelines;
+
+	{
+		std::lock_guard<std::mutex> guard(optimized_pipeline_mutex);
+		ready_pipelines.swap(optimized_pipelines);
+	}
+
+	if (!ready_pipelines.empty())
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_lock.mutex);
+
+		for (auto &ready : ready_pipelines)
+		{
+			auto res_it = state.graphics_pipelines.find(ready.first);
+
+			// The fast linked pipeline may have been evicted in the meantime
+			if (res_it == state.graphics_pipelines.end())
+			{
+				continue;
+			}
+
+			// The fast linked pipeline may be used by the frames in flight
+			device.get_deletion_queue().retire(std::move(res_it->second));
+			state.graphics_pipelines.erase(res_it);
+			state.graphics_pipelines.emplace(ready.first, std::move(ready.second));
+		}
+	}
 }
 
-void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
+GraphicsPipeline *ResourceCache::request_graphics_pipeline_async(PipelineState &pipeline_state)
 {
-	pipeline_cache = new_pipeline_cache;
+	if (!pipeline_compile_pool)
+	{
+		return &request_graphics_pipeline(pipeline_state);
+	}
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(graphics_pipeline_lock.mutex, std::defer_lock);
+		lock_counting_contention(guard, graphics_pipeline_lock);
+
+		auto res_it = state.graphics_pipelines.find(hash);
+
+		if (res_it != state.graphics_pipelines.end())
+		{
+			stamp_usage(graphics_pipeline_lock, hash, frame_index, false);
+			return &res_it->second;
+		}
+	}
+
+	bool compile_here = false;
+
+	{
+		std::lock_guard<std::mutex> guard(pending_pipeline_mutex);
+
+		auto pending_it = pending_graphics_pipelines.find(hash);
+
+		if (pending_it != pending_graphics_pipelines.end() && pending_it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			// Built since the lookup or failed, either way the synchronous request below settles it
+			pending_graphics_pipelines.erase(pending_it);
+			compile_here = true;
+		}
+		else if (failed_graphics_pipelines.erase(hash) > 0)
+		{
+			compile_here = true;
+		}
+		else if (pending_it == pending_graphics_pipelines.end())
+		{
+			// The job owns a copy of the state, as the caller's one will keep changing while recording
+			auto pending = pipeline_compile_pool->push([this, state_copy = pipeline_state](size_t thread_index) mutable {
+				try
+				{
+					// Each worker writes to its own pipeline cache if possible, they are merged when the cache is saved
+					VkPipelineCache worker_cache = persistent_pipeline_cache ? persistent_pipeline_cache->get_thread_cache(thread_index) : pipeline_cache;
+
+					request_graphics_pipeline(state_copy, worker_cache);
+					return true;
+				}
+				catch (const std::exception &e)
+				{
+					// The next request compiles it synchronously, so that the error reaches the caller
+					LOGE("Asynchronous graphics pipeline compilation failed: {}", e.what());
+					return false;
+				}
+			});
+
+			pending_graphics_pipelines.emplace(hash, std::move(pending));
+		}
+	}
+
+	if (compile_here)
+	{
+		return &request_graphics_pipeline(pipeline_state);
+	}
+
+	return nullptr;
 }
 
-ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
+void ResourceCache::collect_async_pipelines()
 {
-	std::string entry_point{"main"};
-	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+	for (auto it = pending_graphics_pipelines.begin(); it != pending_graphics_pipelines.end();)
+	{
+		if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		// A built pipeline is in the cache now, the pending entry is no longer needed
+		if (!it->second.get())
+		{
+			failed_graphics_pipelines.insert(it->first);
+		}
+
+		it = pending_graphics_pipelines.erase(it);
+	}
 }
 
-PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
+void ResourceCache::set_async_pipeline_compilation(uint32_t thread_count)
 {
-	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules);
+	wait_for_async_pipelines();
+
+	if (thread_count > 0)
+	{
+		pipeline_compile_pool = std::make_unique<ctpl::thread_pool>(thread_count);
+	}
+	else
+	{
+		pipeline_compile_pool.reset();
+	}
 }
 
-DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const uint32_t set_index, const std::vector<ShaderResource> &set_resources)
+bool ResourceCache::is_async_pipeline_compilation_enabled() const
 {
-	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_index, set_resources);
+	return pipeline_compile_pool != nullptr;
 }
 
-GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
+void ResourceCache::wait_for_async_pipelines()
 {
-	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache, pipeline_state);
+	std::lock_guard<std::mutex> guard(pending_pipeline_mutex);
+
+	for (auto &pending : pending_graphics_pipelines)
+	{
+		pending.second.wait();
+	}
+
+	collect_async_pipelines();
+
+	// The links lock the mutex to store their result, so wait for them without holding it
+	std::vector<std::future<void>> pending_links;
+
+	{
+		std::lock_guard<std::mutex> link_guard(optimized_pipeline_mutex);
+		pending_links.swap(pending_optimized_pipelines);
+	}
+
+	for (auto &pending : pending_links)
+	{
+		pending.wait();
+	}
 }
 
 ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache, pipeline_state);
+	VKB_PROFILE_ZONE("ResourceCache::request_compute_pipeline");
+
+	return request_resource_concurrently(device, recorder, compute_pipeline_lock, frame_index, state.compute_pipelines, pipeline_cache, pipeline_state);
 }
 
 DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
 {
-	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_set_layout);
-	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	VKB_PROFILE_ZONE("ResourceCache::request_descriptor_set");
+
+	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_lock, frame_index, state.descriptor_pools, descriptor_set_layout);
+	return request_resource(device, recorder, descriptor_set_lock, frame_index, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
 }
 
 RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
-	return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+	VKB_PROFILE_ZONE("ResourceCache::request_render_pass");
+
+	return request_resource_concurrently(device, recorder, render_pass_lock, frame_index, state.render_passes, attachments, load_store_infos, subpasses);
 }
 
 Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
 {
-	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+	VKB_PROFILE_ZONE("ResourceCache::request_framebuffer");
+
+	return request_resource(device, recorder, framebuffer_lock, frame_index, state.framebuffers, render_target, render_pass);
+}
+
+const core::Sampler &ResourceCache::request_sampler(const VkSamplerCreateInfo &info)
+{
+	assert(info.pNext == nullptr && "Samplers with extension structures cannot be shared");
+
+	return request_resource(device, recorder, sampler_lock, frame_index, state.samplers, info);
+}
+
+const core::ImageView &ResourceCache::request_image_view(core::Image &image, VkImageViewType view_type, VkFormat format, uint32_t base_mip_level, uint32_t mip_levels)
+{
+	VKB_PROFILE_ZONE("ResourceCache::request_image_view");
+
+	if (format == VK_FORMAT_UNDEFINED)
+	{
+		format = image.get_format();
+	}
+
+	if (mip_levels == 0)
+	{
+		mip_levels = image.get_subresource().mipLevel - base_mip_level;
+	}
+
+	// The handle identifies the image, core::Image objects move with their handle
+	std::size_t hash{0U};
+	hash_param(hash, image.get_handle(), static_cast<std::underlying_type<VkImageViewType>::type>(view_type),
+	           static_cast<std::underlying_type<VkFormat>::type>(format), base_mip_level, mip_levels);
+
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(image_view_lock.mutex, std::defer_lock);
+		lock_counting_contention(guard, image_view_lock);
+
+		auto view_it = state.image_views.find(hash);
+
+		if (view_it != state.image_views.end())
+		{
+			return view_it->second;
+		}
+	}
+
+	std::unique_lock<std::shared_timed_mutex> guard(image_view_lock.mutex, std::defer_lock);
+	lock_counting_contention(guard, image_view_lock);
+
+	auto view_it = state.image_views.find(hash);
+
+	if (view_it == state.image_views.end())
+	{
+		view_it = state.image_views.emplace(std::piecewise_construct,
+		                                    std::forward_as_tuple(hash),
+		                                    std::forward_as_tuple(image, view_type, format, base_mip_level, mip_levels))
+		              .first;
+
+		image_view_hashes[image.get_handle()].push_back(hash);
+	}
+
+	return view_it->second;
+}
+
+void ResourceCache::release_image_views(const core::Image &image)
+{
+	std::lock_guard<std::shared_timed_mutex> guard(image_view_lock.mutex);
+
+	auto hashes_it = image_view_hashes.find(image.get_handle());
+
+	if (hashes_it == image_view_hashes.end())
+	{
+		return;
+	}
+
+	for (auto hash : hashes_it->second)
+	{
+		state.image_views.erase(hash);
+	}
+
+	image_view_hashes.erase(hashes_it);
 }
 
 void ResourceCache::clear_pipelines()
 {
-	state.graphics_pipelines.clear();
-	state.compute_pipelines.clear();
+	// Pipelines still being compiled would be inserted after the clear
+	wait_for_async_pipelines();
+
+	// The frames in flight may still use the pipelines, the deletion queue destroys them once they complete
+	auto &deletion_queue = device.get_deletion_queue();
+
+	{
+		std::lock_guard<std::mutex> guard(optimized_pipeline_mutex);
+		retire_values(optimized_pipelines, deletion_queue);
+	}
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_lock.mutex);
+		retire_values(state.graphics_pipelines, deletion_queue);
+		graphics_pipeline_lock.last_used.clear();
+	}
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(graphics_pipeline_library_lock.mutex);
+		retire_values(state.graphics_pipeline_libraries, deletion_queue);
+	}
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(compute_pipeline_lock.mutex);
+		retire_values(state.compute_pipelines, deletion_queue);
+		compute_pipeline_lock.last_used.clear();
+	}
 }
 
 void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &old_views, const std::vector<core::ImageView> &new_views)
 {
+	std::lock_guard<std::shared_timed_mutex> guard(descriptor_set_lock.mutex);
+
 	// Find descriptor sets referring to the old image view
 	std::vector<VkWriteDescriptorSet> set_updates;
 	std::set<size_t>                  matches;
@@ -190,13 +1078,117 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 	}
 }
 
+void ResourceCache::update_descriptor_sets(const std::unordered_map<VkBuffer, VkBuffer> &moved_buffers)
+{
+	std::lock_guard<std::shared_timed_mutex> guard(descriptor_set_lock.mutex);
+
+	// Find descriptor sets referring to the old buffers
+	std::vector<VkWriteDescriptorSet> set_updates;
+	std::set<size_t>                  matches;
+
+	for (auto &kd_pair : state.descriptor_sets)
+	{
+		auto &key            = kd_pair.first;
+		auto &descriptor_set = kd_pair.second;
+
+		for (auto &ba_pair : descriptor_set.get_buffer_infos())
+		{
+			auto &binding = ba_pair.first;
+			auto &array   = ba_pair.second;
+
+			for (auto &ai_pair : array)
+			{
+				auto &array_element = ai_pair.first;
+				auto &buffer_info   = ai_pair.second;
+
+				auto it = moved_buffers.find(buffer_info.buffer);
+
+				if (it == moved_buffers.end())
+				{
+					continue;
+				}
+
+				// Save key to remove old descriptor set
+				matches.insert(key);
+
+				// Update buffer info with new buffer
+				buffer_info.buffer = it->second;
+
+				if (auto binding_info = descriptor_set.get_layout().get_layout_binding(binding))
+				{
+					VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+
+					write_descriptor_set.dstBinding      = binding;
+					write_descriptor_set.descriptorType  = binding_info->descriptorType;
+					write_descriptor_set.pBufferInfo     = &buffer_info;
+					write_descriptor_set.dstSet          = descriptor_set.get_handle();
+					write_descriptor_set.dstArrayElement = array_element;
+					write_descriptor_set.descriptorCount = 1;
+
+					set_updates.push_back(write_descriptor_set);
+				}
+				else
+				{
+					LOGE("Shader layout set does not use buffer binding at #{}", binding);
+				}
+			}
+		}
+	}
+
+	if (!set_updates.empty())
+	{
+		vkUpdateDescriptorSets(device.get_handle(), to_u32(set_updates.size()), set_updates.data(),
+		                       0, nullptr);
+	}
+
+	// Rehash the updated descriptor sets
+	for (auto &match : matches)
+	{
+		auto it             = state.descriptor_sets.find(match);
+		auto descriptor_set = std::move(it->second);
+		state.descriptor_sets.erase(match);
+
+		size_t new_key = 0U;
+		hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos());
+
+		state.descriptor_sets.emplace(new_key, std::move(descriptor_set));
+	}
+}
+
 void ResourceCache::clear_framebuffers()
 {
+	std::lock_guard<std::shared_timed_mutex> guard(framebuffer_lock.mutex);
 	state.framebuffers.clear();
+	framebuffer_lock.last_used.clear();
+}
+
+void ResourceCache::clear_descriptor_sets()
+{
+	std::lock_guard<std::shared_timed_mutex> guard(descriptor_set_lock.mutex);
+	state.descriptor_sets.clear();
+	state.descriptor_pools.clear();
+	descriptor_set_lock.last_used.clear();
+}
+
+std::unordered_map<std::size_t, Framebuffer> ResourceCache::release_framebuffers()
+{
+	std::lock_guard<std::shared_timed_mutex> guard(framebuffer_lock.mutex);
+
+	std::unordered_map<std::size_t, Framebuffer> released;
+	released.swap(state.framebuffers);
+	framebuffer_lock.last_used.clear();
+
+	return released;
 }
 
 void ResourceCache::clear()
 {
+	{
+		std::lock_guard<std::mutex> guard(shader_dependency_mutex);
+		shader_source_modules.clear();
+		shader_module_layouts.clear();
+	}
+
 	state.shader_modules.clear();
 	state.pipeline_layouts.clear();
 	state.descriptor_sets.clear();
@@ -204,10 +1196,96 @@ void ResourceCache::clear()
 	state.render_passes.clear();
 	clear_pipelines();
 	clear_framebuffers();
+
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(image_view_lock.mutex);
+		state.image_views.clear();
+		image_view_hashes.clear();
+	}
+
+	state.samplers.clear();
 }
 
 const ResourceCacheState &ResourceCache::get_internal_state() const
 {
 	return state;
 }
+
+ResourceCacheContention ResourceCache::get_contention() const
+{
+	ResourceCacheContention contention;
+
+	contention.shader_modules              = shader_module_lock.contentions.load(std::memory_order_relaxed);
+	contention.pipeline_layouts            = pipeline_layout_lock.contentions.load(std::memory_order_relaxed);
+	contention.descriptor_set_layouts      = descriptor_set_layout_lock.contentions.load(std::memory_order_relaxed);
+	contention.descriptor_sets             = descriptor_set_lock.contentions.load(std::memory_order_relaxed);
+	contention.render_passes               = render_pass_lock.contentions.load(std::memory_order_relaxed);
+	contention.graphics_pipelines          = graphics_pipeline_lock.contentions.load(std::memory_order_relaxed);
+	contention.graphics_pipeline_libraries = graphics_pipeline_library_lock.contentions.load(std::memory_order_relaxed);
+	contention.compute_pipelines           = compute_pipeline_lock.contentions.load(std::memory_order_relaxed);
+	contention.framebuffers                = framebuffer_lock.contentions.load(std::memory_order_relaxed);
+	contention.samplers                    = sampler_lock.contentions.load(std::memory_order_relaxed);
+	contention.image_views                 = image_view_lock.contentions.load(std::memory_order_relaxed);
+
+	return contention;
+}
+
+ResourceCacheEntries ResourceCache::get_entries()
+{
+	ResourceCacheEntries entries;
+
+	entries.shader_modules              = count_entries(shader_module_lock, state.shader_modules, entries.bytes);
+	entries.pipeline_layouts            = count_entries(pipeline_layout_lock, state.pipeline_layouts, entries.bytes);
+	entries.descriptor_set_layouts      = count_entries(descriptor_set_layout_lock, state.descriptor_set_layouts, entries.bytes);
+	entries.descriptor_pools            = count_entries(descriptor_set_lock, state.descriptor_pools, entries.bytes);
+	entries.descriptor_sets             = count_entries(descriptor_set_lock, state.descriptor_sets, entries.bytes);
+	entries.render_passes               = count_entries(render_pass_lock, state.render_passes, entries.bytes);
+	entries.graphics_pipelines          = count_entries(graphics_pipeline_lock, state.graphics_pipelines, entries.bytes);
+	entries.graphics_pipeline_libraries = count_entries(graphics_pipeline_library_lock, state.graphics_pipeline_libraries, entries.bytes);
+	entries.compute_pipelines           = count_entries(compute_pipeline_lock, state.compute_pipelines, entries.bytes);
+	entries.framebuffers                = count_entries(framebuffer_lock, state.framebuffers, entries.bytes);
+	entries.samplers                    = count_entries(sampler_lock, state.samplers, entries.bytes);
+	entries.image_views                 = count_entries(image_view_lock, state.image_views, entries.bytes);
+
+	return entries;
+}
+
+void ResourceCache::set_budget(const ResourceCacheBudget &new_budget)
+{
+	budget = new_budget;
+}
+
+const ResourceCacheBudget &ResourceCache::get_budget() const
+{
+	return budget;
+}
+
+uint64_t ResourceCache::get_frame_index() const
+{
+	return frame_index.load(std::memory_order_relaxed);
+}
+
+void ResourceCache::begin_frame(uint32_t frames_in_flight)
+{
+	auto frame = frame_index.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	update_optimized_pipelines();
+
+	auto evicted_pipelines = evict_resources(graphics_pipeline_lock, state.graphics_pipelines, budget.graphics_pipelines, frame, frames_in_flight);
+
+	{
+		std::lock_guard<std::mutex> guard(pending_pipeline_mutex);
+
+		collect_async_pipelines();
+
+		// Evicted pipelines have finished compiling, forget them so that they are queued again if requested
+		for (auto hash : evicted_pipelines)
+		{
+			pending_graphics_pipelines.erase(hash);
+		}
+	}
+
+	evict_resources(compute_pipeline_lock, state.compute_pipelines, budget.compute_pipelines, frame, frames_in_flight);
+	evict_resources(framebuffer_lock, state.framebuffers, budget.framebuffers, frame, frames_in_flight);
+}
 }        // namespace vkb
@@ -17,8 +17,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <future>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/helpers.h"
@@ -26,18 +30,22 @@
 #include "core/descriptor_set.h"
 #include "core/descriptor_set_layout.h"
 #include "core/framebuffer.h"
+#include "core/image_view.h"
 #include "core/pipeline.h"
+#include "core/sampler.h"
 #include "resource_record.h"
 #include "resource_replay.h"
 
+namespace ctpl
+{
+class thread_pool;
+}
+
 namespace vkb
 {
 class Device;
 
-namespace core
-{
-class ImageView;
-}
+class PipelineCache;
 
 /**
  * @brief Struct to hold the internal state of the Resource Cache
@@ -57,11 +65,113 @@ struct ResourceCacheState
 
 	std::unordered_map<std::size_t, GraphicsPipeline> graphics_pipelines;
 
+	std::unordered_map<std::size_t, GraphicsPipelineLibrary> graphics_pipeline_libraries;
+
 	std::unordered_map<std::size_t, ComputePipeline> compute_pipelines;
 
 	std::unordered_map<std::size_t, DescriptorSet> descriptor_sets;
 
 	std::unordered_map<std::size_t, Framebuffer> framebuffers;
+
+	std::unordered_map<std::size_t, core::Sampler> samplers;
+
+	std::unordered_map<std::size_t, core::ImageView> image_views;
+};
+
+/**
+ * @brief Reader-optimized lock guarding one of the maps in ResourceCacheState
+ *
+ * Cache hits only take a shared lock so that threads recording command buffers
+ * in parallel do not serialize on each other; a miss takes the exclusive lock
+ * to build and insert the new resource. Each time a thread has to wait for the
+ * lock the contention counter is incremented.
+ *
+ * For maps which can be evicted, the frame each entry was last requested in is
+ * tracked as well. Stamps are atomics so that hits can update them under the shared lock.
+ */
+struct ResourceCacheLock
+{
+	std::shared_timed_mutex mutex;
+
+	std::atomic<uint64_t> contentions{0};
+
+	bool track_usage{false};
+
+	std::unordered_map<std::size_t, std::atomic<uint64_t>> last_used;
+};
+
+/**
+ * @brief Maximum number of entries kept in the maps which can be evicted, zero means unlimited
+ *        Descriptor sets are not evicted, as their pools do not support freeing single sets.
+ */
+struct ResourceCacheBudget
+{
+	size_t graphics_pipelines{0};
+
+	size_t compute_pipelines{0};
+
+	size_t framebuffers{0};
+};
+
+/**
+ * @brief Number of entries in each map in ResourceCacheState
+ */
+struct ResourceCacheEntries
+{
+	uint64_t shader_modules{0};
+
+	uint64_t pipeline_layouts{0};
+
+	uint64_t descriptor_set_layouts{0};
+
+	uint64_t descriptor_pools{0};
+
+	uint64_t descriptor_sets{0};
+
+	uint64_t render_passes{0};
+
+	uint64_t graphics_pipelines{0};
+
+	uint64_t graphics_pipeline_libraries{0};
+
+	uint64_t compute_pipelines{0};
+
+	uint64_t framebuffers{0};
+
+	uint64_t samplers{0};
+
+	uint64_t image_views{0};
+
+	/// Host memory used by the cached objects, not including the memory owned by the driver
+	uint64_t bytes{0};
+};
+
+/**
+ * @brief Number of times a thread had to wait on the lock of each map in ResourceCacheState
+ */
+struct ResourceCacheContention
+{
+	uint64_t shader_modules{0};
+
+	uint64_t pipeline_layouts{0};
+
+	uint64_t descriptor_set_layouts{0};
+
+	uint64_t descriptor_sets{0};
+
+	uint64_t render_passes{0};
+
+	uint64_t graphics_pipelines{0};
+
+	uint64_t graphics_pipeline_libraries{0};
+
+	uint64_t compute_pipelines{0};
+
+	uint64_t framebuffers{0};
+
+	uint64_t samplers{0};
+
+	uint64_t image_views{0};
 };
 
 /**
@@ -74,13 +184,22 @@ struct ResourceCacheState
  * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
  * the cache on app startup by creating all necessary objects.
  * The cache holds pointers to objects and has a mapping from such pointers to hashes.
- * It can only be destroyed in bulk, single elements cannot be removed.
+ * Graphics pipelines, compute pipelines and framebuffers which have not been requested for
+ * a while are evicted, least recently used first, once their map goes over its budget.
+ * Image views are destroyed with their image, other elements can only be destroyed in bulk.
+ *
+ * If the device supports VK_EXT_graphics_pipeline_library, graphics pipelines are linked from
+ * vertex input, pre-rasterization, fragment shader and fragment output libraries cached on their
+ * own, so that a change in one state only creates the library it belongs to. The fast link is
+ * replaced by a link time optimized pipeline compiled in the background once it is ready.
  */
 class ResourceCache
 {
   public:
 	ResourceCache(Device &device);
 
+	~ResourceCache();
+
 	ResourceCache(const ResourceCache &) = delete;
 
 	ResourceCache(ResourceCache &&) = delete;
@@ -89,20 +208,89 @@ class ResourceCache
 
 	ResourceCache &operator=(ResourceCache &&) = delete;
 
+	/**
+	 * @brief Creates the resources stored by serialize()
+	 *        The pipeline cache data stored along the resources is merged into the pipeline cache
+	 *        only if it was written by the same device and driver.
+	 */
 	void warmup(const std::vector<uint8_t> &data);
 
+	void warmup(const uint8_t *data, size_t size);
+
+	/**
+	 * @brief Serializes the resources requested so far in a versioned binary format
+	 *        together with the contents of the pipeline cache, if one is set
+	 */
 	std::vector<uint8_t> serialize();
 
 	void set_pipeline_cache(VkPipelineCache pipeline_cache);
 
+	/**
+	 * @brief Uses a persistent pipeline cache, asynchronous compilation threads
+	 *        then write to their own cache which are merged when it is saved
+	 */
+	void set_pipeline_cache(PipelineCache &pipeline_cache);
+
 	ShaderModule &request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
 
+	/**
+	 * @brief Compiles and reflects a shader module on the shader compile threads, so that the stages
+	 *        of many pipelines build in parallel. The source and variant are copied by the task.
+	 * @return The module once it is in the cache, get() rethrows the compilation errors
+	 */
+	std::shared_future<ShaderModule *> request_shader_module_async(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
+
 	PipelineLayout &request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules);
 
+	/**
+	 * @brief Replaces the shader modules built from a source which changed on disk
+	 *        The variants in use are compiled from the new source first, then the modules built from
+	 *        the old source are removed with the pipeline layouts and pipelines depending on them,
+	 *        which are rebuilt by their next request. The removed objects are destroyed by the
+	 *        deletion queue of the device once the frames in flight have completed.
+	 * @param old_source_id The id the source had when its modules were requested
+	 * @param new_source The reloaded source
+	 * @return False if the new source failed to compile, the old modules are then kept
+	 */
+	bool reload_shader_source(size_t old_source_id, const ShaderSource &new_source);
+
 	DescriptorSetLayout &request_descriptor_set_layout(const uint32_t set_index, const std::vector<ShaderResource> &set_resources);
 
 	GraphicsPipeline &request_graphics_pipeline(PipelineState &pipeline_state);
 
+	/**
+	 * @return Whether graphics pipelines are linked from pipeline libraries
+	 */
+	bool is_pipeline_library_enabled();
+
+	/**
+	 * @brief Sets whether graphics pipelines are linked from pipeline libraries when the device supports them, the default
+	 *        Call clear_pipelines() when switching, so that the cache does not keep pipelines of both kinds.
+	 */
+	void set_pipeline_library(bool enabled);
+
+	/**
+	 * @brief Requests a graphics pipeline without blocking on its creation
+	 *        If the pipeline state has not been seen before, the pipeline is queued
+	 *        to the compile threads and will be returned by a later request
+	 * @param pipeline_state The pipeline state to build the pipeline from
+	 * @return The pipeline if it is ready, nullptr otherwise
+	 */
+	GraphicsPipeline *request_graphics_pipeline_async(PipelineState &pipeline_state);
+
+	/**
+	 * @brief Sets the number of threads compiling graphics pipelines in the background
+	 * @param thread_count The number of compile threads, zero disables asynchronous compilation
+	 */
+	void set_async_pipeline_compilation(uint32_t thread_count);
+
+	bool is_async_pipeline_compilation_enabled() const;
+
+	/**
+	 * @brief Blocks until all the graphics pipelines queued for compilation are built
+	 */
+	void wait_for_async_pipelines();
+
 	ComputePipeline &request_compute_pipeline(PipelineState &pipeline_state);
 
 	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
@@ -116,6 +304,30 @@ class ResourceCache
 	Framebuffer &request_framebuffer(const RenderTarget &render_target,
 	                                 const RenderPass &  render_pass);
 
+	/**
+	 * @brief Returns the sampler created with the same info, creating it if needed
+	 *        Samplers live as long as the cache, so that all the users of a sampler state share one handle.
+	 * @param info Creation details, without extension structures
+	 */
+	const core::Sampler &request_sampler(const VkSamplerCreateInfo &info);
+
+	/**
+	 * @brief Returns the view of an image created with the same parameters, creating it if needed
+	 *        The views of an image are destroyed with it, see release_image_views().
+	 * @param base_mip_level First mip level of the view
+	 * @param mip_levels Number of mip levels of the view, 0 for all the levels from the first one
+	 */
+	const core::ImageView &request_image_view(core::Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED,
+	                                          uint32_t base_mip_level = 0, uint32_t mip_levels = 0);
+
+	/**
+	 * @brief Destroys the cached views of an image, called when the image is destroyed
+	 */
+	void release_image_views(const core::Image &image);
+
+	/**
+	 * @brief Removes every pipeline, they are destroyed by the deletion queue of the device once the frames using them have completed
+	 */
 	void clear_pipelines();
 
 	/// @brief Update those descriptor sets referring to old views
@@ -123,13 +335,96 @@ class ResourceCache
 	/// @param new_views New image views to be referred
 	void update_descriptor_sets(const std::vector<core::ImageView> &old_views, const std::vector<core::ImageView> &new_views);
 
+	/// @brief Update those descriptor sets referring to moved buffers
+	/// @param moved_buffers New buffer handles, by the old handle referred by descriptor sets
+	void update_descriptor_sets(const std::unordered_map<VkBuffer, VkBuffer> &moved_buffers);
+
 	void clear_framebuffers();
 
+	/**
+	 * @brief Destroys the descriptor sets and their pools, which refer to the buffers and images of a sample
+	 */
+	void clear_descriptor_sets();
+
+	/**
+	 * @brief Removes the framebuffers from the cache without destroying them
+	 *        The caller keeps them alive until the command buffers using them have completed.
+	 * @return The framebuffers which were cached
+	 */
+	std::unordered_map<std::size_t, Framebuffer> release_framebuffers();
+
 	void clear();
 
 	const ResourceCacheState &get_internal_state() const;
 
+	/**
+	 * @return How many times each map of the cache was contended since creation
+	 */
+	ResourceCacheContention get_contention() const;
+
+	/**
+	 * @return The number of entries in each map and the host memory they use
+	 */
+	ResourceCacheEntries get_entries();
+
+	/**
+	 * @brief Sets the maximum number of entries kept in the maps which can be evicted
+	 *        References to evicted resources become invalid, so a non-zero budget
+	 *        should only be set if no resource is held on to across frames.
+	 */
+	void set_budget(const ResourceCacheBudget &budget);
+
+	const ResourceCacheBudget &get_budget() const;
+
+	/**
+	 * @brief Starts a new frame and evicts the least recently used resources over budget
+	 *        Only resources not requested in the last frames_in_flight frames are evicted,
+	 *        so that they are not in use by the GPU anymore.
+	 * @param frames_in_flight Number of frames which can be submitted before waiting on their fence
+	 */
+	void begin_frame(uint32_t frames_in_flight);
+
+	/**
+	 * @return The number of frames started, used to stamp the last use of resources
+	 */
+	uint64_t get_frame_index() const;
+
   private:
+	GraphicsPipeline &request_graphics_pipeline(PipelineState &pipeline_state, VkPipelineCache pipeline_cache);
+
+	GraphicsPipeline &request_linked_graphics_pipeline(PipelineState &pipeline_state, VkPipelineCache pipeline_cache);
+
+	GraphicsPipelineLibrary &request_graphics_pipeline_library(PipelineState &pipeline_state, VkPipelineCache pipeline_cache, PipelineLibraryType type);
+
+	/**
+	 * @brief Queues the link time optimized version of a linked pipeline to the link thread
+	 */
+	void queue_optimized_pipeline(std::size_t hash, const PipelineState &pipeline_state, const std::vector<const GraphicsPipelineLibrary *> &libraries);
+
+	/**
+	 * @brief Swaps the optimized pipelines which are ready with their fast linked version
+	 *        A replaced pipeline goes to the deletion queue of the device, until the frames in flight which may use it have completed.
+	 */
+	void update_optimized_pipelines();
+
+	/**
+	 * @brief Forgets the asynchronous compilations which have finished, recording those which failed
+	 *        Must be called with pending_pipeline_mutex locked.
+	 */
+	void collect_async_pipelines();
+
+	/**
+	 * @brief A shader module in the cache, with what is needed to build it again from another source
+	 */
+	struct ShaderModuleDependency
+	{
+		std::size_t hash;
+
+		VkShaderStageFlagBits stage;
+
+		ShaderVariant shader_variant;
+	};
+
 	Device &device;
 
 	ResourceRecord recorder;
@@ -138,22 +433,75 @@ class ResourceCache
 
 	VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
 
+	bool pipeline_library{true};
+
+	PipelineCache *persistent_pipeline_cache{nullptr};
+
 	ResourceCacheState state;
 
-	std::mutex descriptor_set_mutex;
+	ResourceCacheLock descriptor_set_lock;
+
+	ResourceCacheLock pipeline_layout_lock;
+
+	ResourceCacheLock shader_module_lock;
+
+	ResourceCacheLock descriptor_set_layout_lock;
+
+	ResourceCacheLock graphics_pipeline_lock;
+
+	ResourceCacheLock graphics_pipeline_library_lock;
+
+	ResourceCacheLock render_pass_lock;
+
+	ResourceCacheLock compute_pipeline_lock;
+
+	ResourceCacheLock framebuffer_lock;
+
+	ResourceCacheLock sampler_lock;
+
+	ResourceCacheLock image_view_lock;
+
+	/// Hashes of the cached views of each image, guarded by the image view lock
+	std::unordered_map<VkImage, std::vector<std::size_t>> image_view_hashes;
+
+	/// Frame counter used to stamp the entries of the maps which can be evicted
+	std::atomic<uint64_t> frame_index{0};
+
+	ResourceCacheBudget budget;
+
+	/// Compile threads for asynchronous graphics pipeline creation, null if disabled
+	std::unique_ptr<ctpl::thread_pool> pipeline_compile_pool;
+
+	/// Compile threads for asynchronous shader module creation, created on first use
+	std::unique_ptr<ctpl::thread_pool> shader_compile_pool;
+
+	std::mutex shader_compile_pool_mutex;
+
+	/// Guards the reverse dependency index, locked after the lock of the map being updated
+	std::mutex shader_dependency_mutex;
+
+	/// Shader modules built from each shader source, by source id
+	std::unordered_map<std::size_t, std::vector<ShaderModuleDependency>> shader_source_modules;
+
+	/// Hashes of the pipeline layouts built from each shader module
+	std::unordered_map<const ShaderModule *, std::vector<std::size_t>> shader_module_layouts;
 
-	std::mutex pipeline_layout_mutex;
+	std::mutex pending_pipeline_mutex;
 
-	std::mutex shader_module_mutex;
+	/// Graphics pipelines which have been queued for compilation, by hash, resolving to whether they were built
+	std::unordered_map<std::size_t, std::future<bool>> pending_graphics_pipelines;
 
-	std::mutex descriptor_set_layout_mutex;
+	/// Graphics pipelines whose asynchronous compilation failed, built synchronously on their next request
+	std::unordered_set<std::size_t> failed_graphics_pipelines;
 
-	std::mutex graphics_pipeline_mutex;
+	/// Link thread for link time optimized graphics pipelines, created on first use
+	std::unique_ptr<ctpl::thread_pool> pipeline_link_pool;
 
-	std::mutex render_pass_mutex;
+	std::mutex optimized_pipeline_mutex;
 
-	std::mutex compute_pipeline_mutex;
+	std::vector<std::future<void>> pending_optimized_pipelines;
 
-	std::mutex framebuffer_mutex;
+	/// Optimized pipelines ready to replace their fast linked version, by hash
+	std::vector<std::pair<std::size_t, GraphicsPipeline>> optimized_pipelines;
 };
 }        // namespace vkb
@@ -17,6 +17,9 @@
 
 #include "resource_record.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "core/pipeline.h"
 #include "core/pipeline_layout.h"
 #include "core/render_pass.h"
@@ -27,141 +30,268 @@ namespace vkb
 {
 namespace
 {
-inline void write_subpass_info(std::ostringstream &os, const std::vector<SubpassInfo> &value)
+inline void pad(std::vector<uint8_t> &data)
 {
-	write(os, value.size());
-	for (const SubpassInfo &item : value)
-	{
-		write(os, item.input_attachments);
-		write(os, item.output_attachments);
-	}
+	data.resize((data.size() + 3) & ~size_t{3}, 0);
+}
+
+template <class T>
+inline void append(std::vector<uint8_t> &data, const T &value)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(&value);
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template <class T>
+inline void append(std::vector<uint8_t> &data, const std::vector<T> &values)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(values.data());
+	data.insert(data.end(), bytes, bytes + values.size() * sizeof(T));
 }
+}        // namespace
 
-inline void write_processes(std::ostringstream &os, const std::vector<std::string> &value)
+std::vector<uint8_t> ResourceRecord::get_data(const VkPhysicalDeviceProperties &properties, const std::vector<uint8_t> &pipeline_cache_data)
 {
-	write(os, value.size());
-	for (const std::string &item : value)
+	std::lock_guard<std::mutex> guard(mutex);
+
+	ResourceRecordHeader header{};
+	header.vendor_id      = properties.vendorID;
+	header.device_id      = properties.deviceID;
+	header.driver_version = properties.driverVersion;
+	std::copy(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), std::begin(header.pipeline_cache_uuid));
+	header.string_count = to_u32(strings.size());
+	header.record_count = record_count;
+
+	std::vector<uint8_t> data(sizeof(ResourceRecordHeader), 0);
+	pad(data);
+
+	header.string_table_offset = data.size();
+	for (auto &value : strings)
 	{
-		write(os, item);
+		append(data, to_u32(value.size()));
+		data.insert(data.end(), value.begin(), value.end());
+		pad(data);
 	}
+
+	header.records_offset = data.size();
+	header.records_size   = records.size();
+	data.insert(data.end(), records.begin(), records.end());
+
+	header.pipeline_cache_offset = data.size();
+	header.pipeline_cache_size   = pipeline_cache_data.size();
+	data.insert(data.end(), pipeline_cache_data.begin(), pipeline_cache_data.end());
+
+	std::memcpy(data.data(), &header, sizeof(ResourceRecordHeader));
+
+	return data;
 }
-}        // namespace
 
-void ResourceRecord::set_data(const std::vector<uint8_t> &data)
+uint32_t ResourceRecord::add_string(const std::string &value)
 {
-	stream.str(std::string{data.begin(), data.end()});
+	auto it = string_indices.find(value);
+
+	if (it != string_indices.end())
+	{
+		return it->second;
+	}
+
+	uint32_t index = to_u32(strings.size());
+
+	strings.push_back(value);
+	string_indices.emplace(value, index);
+
+	return index;
 }
 
-std::vector<uint8_t> ResourceRecord::get_data()
+size_t ResourceRecord::begin_record(ResourceType type)
 {
-	std::string str = stream.str();
+	size_t entry_offset = records.size();
 
-	return std::vector<uint8_t>{str.begin(), str.end()};
+	append(records, ResourceRecordEntry{type, 0});
+
+	return entry_offset;
 }
 
-const std::ostringstream &ResourceRecord::get_stream()
+void ResourceRecord::end_record(size_t entry_offset)
 {
-	return stream;
+	pad(records);
+
+	ResourceRecordEntry entry{};
+	std::memcpy(&entry, records.data() + entry_offset, sizeof(ResourceRecordEntry));
+
+	entry.size = to_u32(records.size() - entry_offset - sizeof(ResourceRecordEntry));
+	std::memcpy(records.data() + entry_offset, &entry, sizeof(ResourceRecordEntry));
+
+	++record_count;
 }
 
 size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_indices.push_back(shader_module_indices.size());
 
-	write(stream, ResourceType::ShaderModule, stage, glsl_source.get_data(), entry_point, shader_variant.get_preamble());
+	ShaderModuleRecord record{};
+	record.stage         = stage;
+	record.source        = add_string(std::string{glsl_source.get_data().begin(), glsl_source.get_data().end()});
+	record.filename      = add_string(glsl_source.get_filename());
+	record.entry_point   = add_string(entry_point);
+	record.preamble      = add_string(shader_variant.get_preamble());
+	record.process_count = to_u32(shader_variant.get_processes().size());
 
-	write_processes(stream, shader_variant.get_processes());
+	std::vector<uint32_t> processes;
+	for (auto &process : shader_variant.get_processes())
+	{
+		processes.push_back(add_string(process));
+	}
+
+	auto entry = begin_record(ResourceType::ShaderModule);
+	append(records, record);
+	append(records, processes);
+	end_record(entry);
 
 	return shader_module_indices.back();
 }
 
 size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_indices.push_back(pipeline_layout_indices.size());
 
-	std::vector<size_t> shader_indices(shader_modules.size());
+	std::vector<uint32_t> shader_indices(shader_modules.size());
 	std::transform(shader_modules.begin(), shader_modules.end(), shader_indices.begin(),
-	               [this](ShaderModule *shader_module) { return shader_module_to_index.at(shader_module); });
+	               [this](ShaderModule *shader_module) { return to_u32(shader_module_to_index.at(shader_module)); });
+
+	PipelineLayoutRecord record{};
+	record.shader_module_count = to_u32(shader_indices.size());
 
-	write(stream,
-	      ResourceType::PipelineLayout,
-	      shader_indices);
+	auto entry = begin_record(ResourceType::PipelineLayout);
+	append(records, record);
+	append(records, shader_indices);
+	end_record(entry);
 
 	return pipeline_layout_indices.back();
 }
 
 size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_indices.push_back(render_pass_indices.size());
 
-	write(stream,
-	      ResourceType::RenderPass,
-	      attachments,
-	      load_store_infos);
+	RenderPassRecord record{};
+	record.attachment_count      = to_u32(attachments.size());
+	record.load_store_info_count = to_u32(load_store_infos.size());
+	record.subpass_count         = to_u32(subpasses.size());
+
+	auto entry = begin_record(ResourceType::RenderPass);
+	append(records, record);
+	append(records, attachments);
+	append(records, load_store_infos);
+
+	for (auto &subpass : subpasses)
+	{
+		SubpassRecord subpass_record{};
+		subpass_record.input_attachment_count           = to_u32(subpass.input_attachments.size());
+		subpass_record.output_attachment_count          = to_u32(subpass.output_attachments.size());
+		subpass_record.color_resolve_attachment_count   = to_u32(subpass.color_resolve_attachments.size());
+		subpass_record.disable_depth_stencil_attachment = subpass.disable_depth_stencil_attachment;
+		subpass_record.depth_stencil_resolve_attachment = subpass.depth_stencil_resolve_attachment;
+		subpass_record.depth_stencil_resolve_mode       = subpass.depth_stencil_resolve_mode;
+		subpass_record.shading_rate_attachment          = subpass.shading_rate_attachment;
+		subpass_record.shading_rate_texel_size          = subpass.shading_rate_texel_size;
+		subpass_record.view_mask                        = subpass.view_mask;
+
+		append(records, subpass_record);
+		append(records, subpass.input_attachments);
+		append(records, subpass.output_attachments);
+		append(records, subpass.color_resolve_attachments);
+	}
 
-	write_subpass_info(stream, subpasses);
+	end_record(entry);
 
 	return render_pass_indices.back();
 }
 
 size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
 {
-	graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
+	std::lock_guard<std::mutex> guard(mutex);
 
-	auto &pipeline_layout = pipeline_state.get_pipeline_layout();
-	auto  render_pass     = pipeline_state.get_render_pass();
+	// Pipelines of dynamic rendering have no render pass to be replayed with
+	if (!pipeline_state.get_render_pass())
+	{
+		return graphics_pipeline_indices.size();
+	}
 
-	write(stream,
-	      ResourceType::GraphicsPipeline,
-	      pipeline_layout_to_index.at(&pipeline_layout),
-	      render_pass_to_index.at(render_pass),
-	      pipeline_state.get_subpass_index());
+	graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
 
 	auto &specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
+	auto &vertex_input_state            = pipeline_state.get_vertex_input_state();
+	auto &color_blend_state             = pipeline_state.get_color_blend_state();
+
+	GraphicsPipelineRecord record{};
+	record.pipeline_layout               = to_u32(pipeline_layout_to_index.at(&pipeline_state.get_pipeline_layout()));
+	record.render_pass                   = to_u32(render_pass_to_index.at(pipeline_state.get_render_pass()));
+	record.subpass_index                 = pipeline_state.get_subpass_index();
+	record.specialization_constant_count = to_u32(specialization_constant_state.size());
+	record.vertex_attribute_count        = to_u32(vertex_input_state.attributes.size());
+	record.vertex_binding_count          = to_u32(vertex_input_state.bindings.size());
+	record.color_blend_attachment_count  = to_u32(color_blend_state.attachments.size());
+	record.logic_op_enable               = color_blend_state.logic_op_enable;
+	record.logic_op                      = color_blend_state.logic_op;
+	record.input_assembly_state          = pipeline_state.get_input_assembly_state();
+	record.rasterization_state           = pipeline_state.get_rasterization_state();
+	record.viewport_state                = pipeline_state.get_viewport_state();
+	record.multisample_state             = pipeline_state.get_multisample_state();
+	record.depth_stencil_state           = pipeline_state.get_depth_stencil_state();
+	record.fragment_shading_rate_state   = pipeline_state.get_fragment_shading_rate_state();
+
+	auto entry = begin_record(ResourceType::GraphicsPipeline);
+	append(records, record);
+
+	for (auto &constant : specialization_constant_state)
+	{
+		append(records, constant.first);
+		append(records, to_u32(constant.second.size()));
+		append(records, constant.second);
+		pad(records);
+	}
 
-	write(stream,
-	      specialization_constant_state);
-
-	auto &vertex_input_state = pipeline_state.get_vertex_input_state();
-
-	write(stream,
-	      vertex_input_state.attributes,
-	      vertex_input_state.bindings);
-
-	write(stream,
-	      pipeline_state.get_input_assembly_state(),
-	      pipeline_state.get_rasterization_state(),
-	      pipeline_state.get_viewport_state(),
-	      pipeline_state.get_multisample_state(),
-	      pipeline_state.get_depth_stencil_state());
-
-	auto &color_blend_state = pipeline_state.get_color_blend_state();
+	append(records, vertex_input_state.attributes);
+	append(records, vertex_input_state.bindings);
+	append(records, color_blend_state.attachments);
 
-	write(stream,
-	      color_blend_state.logic_op,
-	      color_blend_state.logic_op_enable,
-	      color_blend_state.attachments);
+	end_record(entry);
 
 	return graphics_pipeline_indices.back();
 }
 
 void ResourceRecord::set_shader_module(size_t index, const ShaderModule &shader_module)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_to_index[&shader_module] = index;
 }
 
 void ResourceRecord::set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_to_index[&pipeline_layout] = index;
 }
 
 void ResourceRecord::set_render_pass(size_t index, const RenderPass &render_pass)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_to_index[&render_pass] = index;
 }
 
 void ResourceRecord::set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_to_index[&graphics_pipeline] = index;
 }
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include "rendering/pipeline_state.h"
@@ -28,7 +29,7 @@ class PipelineLayout;
 class RenderPass;
 class ShaderModule;
 
-enum class ResourceType
+enum class ResourceType : uint32_t
 {
 	ShaderModule,
 	PipelineLayout,
@@ -36,17 +37,166 @@ enum class ResourceType
 	GraphicsPipeline
 };
 
+/// Identifies serialized resource cache data ("VKBR")
+constexpr uint32_t RESOURCE_RECORD_MAGIC = 0x52424B56;
+
+/// Must be bumped whenever the layout of the records changes
+constexpr uint32_t RESOURCE_RECORD_VERSION = 3;
+
 /**
- * @brief Writes Vulkan objects in a memory stream.
+ * @brief Header at the start of serialized resource cache data.
+ *        All sections are 4-byte aligned and located by their offset from the start of the data.
+ *        The device and driver fields only validate the pipeline cache blob, the records
+ *        themselves are device independent.
  */
-class ResourceRecord
+struct ResourceRecordHeader
 {
-  public:
-	void set_data(const std::vector<uint8_t> &data);
+	uint32_t magic{RESOURCE_RECORD_MAGIC};
+
+	uint32_t version{RESOURCE_RECORD_VERSION};
+
+	uint32_t vendor_id{0};
+
+	uint32_t device_id{0};
+
+	uint32_t driver_version{0};
+
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE]{};
+
+	uint32_t string_count{0};
+
+	uint32_t record_count{0};
+
+	uint32_t reserved{0};
+
+	/// Strings are stored as a uint32_t length followed by the characters
+	uint64_t string_table_offset{0};
+
+	/// Records are stored as a ResourceRecordEntry followed by its payload
+	uint64_t records_offset{0};
+
+	uint64_t records_size{0};
+
+	/// VkPipelineCache data, empty if no pipeline cache was in use
+	uint64_t pipeline_cache_offset{0};
+
+	uint64_t pipeline_cache_size{0};
+};
+
+struct ResourceRecordEntry
+{
+	ResourceType type;
 
-	std::vector<uint8_t> get_data();
+	/// Size in bytes of the payload following the entry
+	uint32_t size;
+};
+
+/// Followed by process_count string indices
+struct ShaderModuleRecord
+{
+	VkShaderStageFlagBits stage;
+
+	/// String indices
+	uint32_t source;
+
+	uint32_t filename;
+
+	uint32_t entry_point;
+
+	uint32_t preamble;
+
+	uint32_t process_count;
+};
+
+/// Followed by shader_module_count shader module record indices
+struct PipelineLayoutRecord
+{
+	uint32_t shader_module_count;
+};
+
+/// Followed by the Attachment array, the LoadStoreInfo array and subpass_count SubpassRecord
+struct RenderPassRecord
+{
+	uint32_t attachment_count;
+
+	uint32_t load_store_info_count;
+
+	uint32_t subpass_count;
+};
+
+/// Followed by the input, output and color resolve attachment indices
+struct SubpassRecord
+{
+	uint32_t input_attachment_count;
 
-	const std::ostringstream &get_stream();
+	uint32_t output_attachment_count;
+
+	uint32_t color_resolve_attachment_count;
+
+	uint32_t disable_depth_stencil_attachment;
+
+	uint32_t depth_stencil_resolve_attachment;
+
+	VkResolveModeFlagBits depth_stencil_resolve_mode;
+
+	uint32_t shading_rate_attachment;
+
+	VkExtent2D shading_rate_texel_size;
+
+	uint32_t view_mask;
+};
+
+/// Followed by the specialization constants (id, size and data padded to 4 bytes),
+/// the vertex attributes, the vertex bindings and the color blend attachments
+struct GraphicsPipelineRecord
+{
+	/// Record indices
+	uint32_t pipeline_layout;
+
+	uint32_t render_pass;
+
+	uint32_t subpass_index;
+
+	uint32_t specialization_constant_count;
+
+	uint32_t vertex_attribute_count;
+
+	uint32_t vertex_binding_count;
+
+	uint32_t color_blend_attachment_count;
+
+	VkBool32 logic_op_enable;
+
+	VkLogicOp logic_op;
+
+	InputAssemblyState input_assembly_state;
+
+	RasterizationState rasterization_state;
+
+	ViewportState viewport_state;
+
+	MultisampleState multisample_state;
+
+	DepthStencilState depth_stencil_state;
+
+	FragmentShadingRateState fragment_shading_rate_state;
+};
+
+/**
+ * @brief Writes Vulkan objects in a versioned binary format.
+ *        Resources are written as fixed-layout records referring to each other by index,
+ *        with all the strings deduplicated in a string table.
+ *        Resources can be registered from several threads at once.
+ */
+class ResourceRecord
+{
+  public:
+	/**
+	 * @brief Serializes the recorded resources
+	 * @param properties Properties of the device the pipeline cache data belongs to
+	 * @param pipeline_cache_data (optional) VkPipelineCache data to store along the records
+	 */
+	std::vector<uint8_t> get_data(const VkPhysicalDeviceProperties &properties, const std::vector<uint8_t> &pipeline_cache_data = {});
 
 	size_t register_shader_module(VkShaderStageFlagBits stage,
 	                              const ShaderSource &  glsl_source,
@@ -71,7 +221,16 @@ class ResourceRecord
 	void set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline);
 
   private:
-	std::ostringstream stream;
+	std::mutex mutex;
+
+	/// Records written so far, without the header and string table
+	std::vector<uint8_t> records;
+
+	uint32_t record_count{0};
+
+	std::vector<std::string> strings;
+
+	std::unordered_map<std::string, uint32_t> string_indices;
 
 	std::vector<size_t> shader_module_indices;
 
@@ -88,5 +247,12 @@ class ResourceRecord
 	std::unordered_map<const RenderPass *, size_t> render_pass_to_index;
 
 	std::unordered_map<const GraphicsPipeline *, size_t> graphics_pipeline_to_index;
+
+	uint32_t add_string(const std::string &value);
+
+	/// Appends a record entry, the payload must be written right after
+	size_t begin_record(ResourceType type);
+
+	void end_record(size_t entry_offset);
 };
 }        // namespace vkb
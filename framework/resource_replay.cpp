@@ -17,196 +17,457 @@
 
 #include "resource_replay.h"
 
+#include <ctpl_stl.h>
+
+
 #include "common/logging.h"
 #include "common/vk_common.h"
 #include "rendering/pipeline_state.h"
 #include "resource_cache.h"
+#include "timer.h"
 
 namespace vkb
 {
 namespace
 {
-inline void read_subpass_info(std::istringstream &is, std::vector<SubpassInfo> &value)
+inline bool is_in_bounds(uint64_t offset, uint64_t count, size_t size)
+{
+	return offset <= size && count <= size - offset;
+}
+}        // namespace
+
+RecordReader::RecordReader(const uint8_t *data, size_t size) :
+    data{data},
+    size{size}
 {
-	std::size_t size;
-	read(is, size);
-	value.resize(size);
-	for (SubpassInfo &subpass : value)
-	{
-		read(is, subpass.input_attachments);
-		read(is, subpass.output_attachments);
-	}
 }
 
-inline void read_processes(std::istringstream &is, std::vector<std::string> &value)
+const uint8_t *RecordReader::read_bytes(size_t count)
 {
-	std::size_t size;
-	read(is, size);
-	value.resize(size);
-	for (std::string &item : value)
+	if (!is_in_bounds(offset, count, size))
 	{
-		read(is, item);
+		throw std::runtime_error("Resource record is truncated");
 	}
+
+	auto bytes = data + offset;
+	offset += count;
+
+	return bytes;
+}
+
+size_t RecordReader::get_remaining() const
+{
+	return size - offset;
+}
+
+void RecordReader::align()
+{
+	offset = std::min((offset + 3) & ~size_t{3}, size);
 }
-}        // namespace
 
 ResourceReplay::ResourceReplay()
 {
-	stream_resources[ResourceType::ShaderModule]     = std::bind(&ResourceReplay::create_shader_module, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::PipelineLayout]   = std::bind(&ResourceReplay::create_pipeline_layout, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::RenderPass]       = std::bind(&ResourceReplay::create_render_pass, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::GraphicsPipeline] = std::bind(&ResourceReplay::create_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::ShaderModule]     = std::bind(&ResourceReplay::decode_shader_module, this, std::placeholders::_1);
+	stream_resources[ResourceType::PipelineLayout]   = std::bind(&ResourceReplay::decode_pipeline_layout, this, std::placeholders::_1);
+	stream_resources[ResourceType::RenderPass]       = std::bind(&ResourceReplay::decode_render_pass, this, std::placeholders::_1);
+	stream_resources[ResourceType::GraphicsPipeline] = std::bind(&ResourceReplay::decode_graphics_pipeline, this, std::placeholders::_1);
 }
 
-void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorder)
+bool ResourceReplay::load(const uint8_t *data, size_t size)
 {
-	std::istringstream stream{recorder.get_stream().str()};
+	strings.clear();
+	records.clear();
+	pipeline_cache_data.clear();
+
+	if (size < sizeof(ResourceRecordHeader))
+	{
+		LOGE("Resource cache data is too small ({} bytes)", size);
+		return false;
+	}
+
+	std::memcpy(&header, data, sizeof(ResourceRecordHeader));
+
+	if (header.magic != RESOURCE_RECORD_MAGIC)
+	{
+		LOGE("Resource cache data has an invalid header");
+		return false;
+	}
+
+	if (header.version != RESOURCE_RECORD_VERSION)
+	{
+		LOGW("Resource cache data version {} is not supported (expected {})", header.version, RESOURCE_RECORD_VERSION);
+		return false;
+	}
+
+	if (!is_in_bounds(header.string_table_offset, 0, size) ||
+	    !is_in_bounds(header.records_offset, header.records_size, size) ||
+	    !is_in_bounds(header.pipeline_cache_offset, header.pipeline_cache_size, size))
+	{
+		LOGE("Resource cache data is truncated");
+		return false;
+	}
 
-	while (true)
+	try
 	{
-		// Read command id
-		ResourceType resource_type;
-		read(stream, resource_type);
+		RecordReader reader{data + header.string_table_offset, static_cast<size_t>(size - header.string_table_offset)};
 
-		if (stream.eof())
+		// Each string takes at least its 4-byte length, a count that can't fit in the table is rejected before allocating
+		if (header.string_count > reader.get_remaining() / sizeof(uint32_t))
 		{
-			break;
+			throw std::runtime_error("Resource cache string count exceeds the string table");
 		}
 
+		strings.resize(header.string_count);
+		for (auto &value : strings)
+		{
+			uint32_t length{0};
+			reader.read(length);
+
+			auto characters = reinterpret_cast<const char *>(reader.read_bytes(length));
+			value.assign(characters, characters + length);
+
+			reader.align();
+		}
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGE("Resource cache string table is invalid: {}", e.what());
+		strings.clear();
+		return false;
+	}
+
+	auto records_begin = data + header.records_offset;
+	records.assign(records_begin, records_begin + header.records_size);
+
+	auto pipeline_cache_begin = data + header.pipeline_cache_offset;
+	pipeline_cache_data.assign(pipeline_cache_begin, pipeline_cache_begin + header.pipeline_cache_size);
+
+	return true;
+}
+
+bool ResourceReplay::is_compatible(const VkPhysicalDeviceProperties &properties) const
+{
+	return header.vendor_id == properties.vendorID &&
+	       header.device_id == properties.deviceID &&
+	       header.driver_version == properties.driverVersion &&
+	       std::memcmp(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+const std::vector<uint8_t> &ResourceReplay::get_pipeline_cache_data() const
+{
+	return pipeline_cache_data;
+}
+
+void ResourceReplay::play(ResourceCache &resource_cache, uint32_t thread_count)
+{
+	Timer timer;
+	timer.start();
+
+	jobs.clear();
+	shader_module_jobs.clear();
+	pipeline_layout_jobs.clear();
+	render_pass_jobs.clear();
+
+	RecordReader stream{records.data(), records.size()};
+
+	for (uint32_t i = 0; i < header.record_count; ++i)
+	{
+		ResourceRecordEntry entry{};
+		stream.read(entry);
+
+		RecordReader reader{stream.read_bytes(entry.size), entry.size};
+
 		// Find command function for the given command id
-		auto cmd_it = stream_resources.find(resource_type);
+		auto cmd_it = stream_resources.find(entry.type);
 
 		// Check if command replayer supports the given command
 		if (cmd_it != stream_resources.end())
 		{
 			// Run command function
-			cmd_it->second(resource_cache, stream);
+			cmd_it->second(reader);
 		}
 		else
 		{
 			LOGE("Replay command not supported.");
 		}
 	}
+
+	shader_modules.assign(shader_module_jobs.size(), nullptr);
+	pipeline_layouts.assign(pipeline_layout_jobs.size(), nullptr);
+	render_passes.assign(render_pass_jobs.size(), nullptr);
+
+	// Records are written after the ones they refer to, so a single pass sorts the jobs in stages
+	std::vector<size_t>              job_stages(jobs.size(), 0);
+	std::vector<std::vector<size_t>> stages;
+
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		for (auto dependency : jobs[i].dependencies)
+		{
+			job_stages[i] = std::max(job_stages[i], job_stages.at(dependency) + 1);
+		}
+
+		if (job_stages[i] >= stages.size())
+		{
+			stages.resize(job_stages[i] + 1);
+		}
+
+		stages[job_stages[i]].push_back(i);
+	}
+
+	LOGI("Resource cache warmup: decoded {} resources in {:.2f} ms", jobs.size(), timer.elapsed<Timer::Milliseconds>());
+
+	std::unique_ptr<ctpl::thread_pool> thread_pool;
+	if (thread_count > 1)
+	{
+		thread_pool = std::make_unique<ctpl::thread_pool>(thread_count);
+	}
+
+	// Time spent creating each type of resource, summed over all threads
+	std::vector<double> job_times(jobs.size(), 0.0);
+
+	auto run_job = [&](size_t job_index) {
+		Timer job_timer;
+		job_timer.start();
+
+		jobs[job_index].create(resource_cache);
+
+		job_times[job_index] = job_timer.stop<Timer::Milliseconds>();
+	};
+
+	for (size_t stage = 0; stage < stages.size(); ++stage)
+	{
+		timer.lap();
+
+		if (thread_pool)
+		{
+			std::vector<std::future<void>> pending;
+			for (auto job_index : stages[stage])
+			{
+				pending.push_back(thread_pool->push([&run_job, job_index](size_t) { run_job(job_index); }));
+			}
+
+			// Wait for the whole stage before rethrowing, the jobs refer to this function's state
+			std::exception_ptr error;
+			for (auto &job : pending)
+			{
+				try
+				{
+					job.get();
+				}
+				catch (...)
+				{
+					if (!error)
+					{
+						error = std::current_exception();
+					}
+				}
+			}
+
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+		}
+		else
+		{
+			for (auto job_index : stages[stage])
+			{
+				run_job(job_index);
+			}
+		}
+
+		LOGI("Resource cache warmup: stage {} created {} resources in {:.2f} ms", stage, stages[stage].size(), timer.elapsed<Timer::Milliseconds>());
+	}
+
+	std::map<ResourceType, std::pair<size_t, double>> type_times;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		auto &type_time = type_times[jobs[i].type];
+		type_time.first += 1;
+		type_time.second += job_times[i];
+	}
+
+	const std::map<ResourceType, const char *> type_names{
+	    {ResourceType::ShaderModule, "shader modules"},
+	    {ResourceType::PipelineLayout, "pipeline layouts"},
+	    {ResourceType::RenderPass, "render passes"},
+	    {ResourceType::GraphicsPipeline, "graphics pipelines"}};
+
+	for (auto &type_time : type_times)
+	{
+		LOGI("Resource cache warmup: {} {} took {:.2f} ms of thread time", type_time.second.first, type_names.at(type_time.first), type_time.second.second);
+	}
+
+	LOGI("Resource cache warmup: {} resources created in {:.2f} ms using {} threads", jobs.size(), timer.stop<Timer::Milliseconds>(), std::max(thread_count, 1U));
+
+	jobs.clear();
 }
 
-void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::istringstream &stream)
+const std::string &ResourceReplay::get_string(uint32_t index) const
 {
-	VkShaderStageFlagBits    stage{};
-	std::vector<uint8_t>     glsl_code;
-	std::string              entry_point;
-	std::string              preamble;
-	std::vector<std::string> processes;
+	if (index >= strings.size())
+	{
+		throw std::runtime_error("Resource record refers to an invalid string");
+	}
 
-	read(stream,
-	     stage,
-	     glsl_code,
-	     entry_point,
-	     preamble);
+	return strings[index];
+}
 
-	read_processes(stream, processes);
+void ResourceReplay::decode_shader_module(RecordReader &reader)
+{
+	ShaderModuleRecord record{};
+	reader.read(record);
 
-	ShaderSource  shader_source(std::move(glsl_code));
-	ShaderVariant shader_variant(std::move(preamble), std::move(processes));
+	std::vector<uint32_t> process_indices;
+	reader.read(process_indices, record.process_count);
 
-	auto &shader_module = resource_cache.request_shader_module(stage, shader_source, shader_variant);
+	auto &source = get_string(record.source);
 
-	shader_modules.push_back(&shader_module);
+	std::vector<std::string> processes;
+	for (auto index : process_indices)
+	{
+		processes.push_back(get_string(index));
+	}
+
+	auto shader_source  = std::make_shared<ShaderSource>(std::vector<uint8_t>{source.begin(), source.end()});
+	auto shader_variant = std::make_shared<ShaderVariant>(std::string{get_string(record.preamble)}, std::move(processes));
+	auto index          = shader_module_jobs.size();
+
+	ReplayJob job{ResourceType::ShaderModule};
+	job.create = [this, index, stage = record.stage, shader_source, shader_variant](ResourceCache &resource_cache) {
+		shader_modules[index] = &resource_cache.request_shader_module(stage, *shader_source, *shader_variant);
+	};
+
+	shader_module_jobs.push_back(jobs.size());
+	jobs.push_back(std::move(job));
 }
 
-void ResourceReplay::create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::decode_pipeline_layout(RecordReader &reader)
 {
-	std::vector<size_t> shader_indices;
+	PipelineLayoutRecord record{};
+	reader.read(record);
 
-	read(stream,
-	     shader_indices);
+	std::vector<uint32_t> shader_indices;
+	reader.read(shader_indices, record.shader_module_count);
 
-	std::vector<ShaderModule *> shader_stages(shader_indices.size());
-	std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
-	               [&](size_t shader_index) { return shader_modules.at(shader_index); });
+	auto index = pipeline_layout_jobs.size();
 
-	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_stages);
+	ReplayJob job{ResourceType::PipelineLayout};
+	for (auto shader_index : shader_indices)
+	{
+		job.dependencies.push_back(shader_module_jobs.at(shader_index));
+	}
+
+	job.create = [this, index, shader_indices](ResourceCache &resource_cache) {
+		std::vector<ShaderModule *> shader_stages(shader_indices.size());
+		std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
+		               [&](uint32_t shader_index) { return shader_modules.at(shader_index); });
 
-	pipeline_layouts.push_back(&pipeline_layout);
+		pipeline_layouts[index] = &resource_cache.request_pipeline_layout(shader_stages);
+	};
+
+	pipeline_layout_jobs.push_back(jobs.size());
+	jobs.push_back(std::move(job));
 }
 
-void ResourceReplay::create_render_pass(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::decode_render_pass(RecordReader &reader)
 {
+	RenderPassRecord record{};
+	reader.read(record);
+
 	std::vector<Attachment>    attachments;
 	std::vector<LoadStoreInfo> load_store_infos;
-	std::vector<SubpassInfo>   subpasses;
+	std::vector<SubpassInfo>   subpasses(record.subpass_count);
 
-	read(stream,
-	     attachments,
-	     load_store_infos);
+	reader.read(attachments, record.attachment_count);
+	reader.read(load_store_infos, record.load_store_info_count);
+
+	for (auto &subpass : subpasses)
+	{
+		SubpassRecord subpass_record{};
+		reader.read(subpass_record);
+
+		reader.read(subpass.input_attachments, subpass_record.input_attachment_count);
+		reader.read(subpass.output_attachments, subpass_record.output_attachment_count);
+		reader.read(subpass.color_resolve_attachments, subpass_record.color_resolve_attachment_count);
+
+		subpass.disable_depth_stencil_attachment = subpass_record.disable_depth_stencil_attachment != 0;
+		subpass.depth_stencil_resolve_attachment = subpass_record.depth_stencil_resolve_attachment;
+		subpass.depth_stencil_resolve_mode       = subpass_record.depth_stencil_resolve_mode;
+		subpass.shading_rate_attachment          = subpass_record.shading_rate_attachment;
+		subpass.shading_rate_texel_size          = subpass_record.shading_rate_texel_size;
+		subpass.view_mask                        = subpass_record.view_mask;
+	}
 
-	read_subpass_info(stream, subpasses);
+	auto index = render_pass_jobs.size();
 
-	auto &render_pass = resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+	ReplayJob job{ResourceType::RenderPass};
+	job.create = [this, index, attachments, load_store_infos, subpasses](ResourceCache &resource_cache) {
+		render_passes[index] = &resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+	};
 
-	render_passes.push_back(&render_pass);
+	render_pass_jobs.push_back(jobs.size());
+	jobs.push_back(std::move(job));
 }
 
-void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::decode_graphics_pipeline(RecordReader &reader)
 {
-	size_t   pipeline_layout_index{};
-	size_t   render_pass_index{};
-	uint32_t subpass_index{};
+	GraphicsPipelineRecord record{};
+	reader.read(record);
 
-	read(stream,
-	     pipeline_layout_index,
-	     render_pass_index,
-	     subpass_index);
+	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state;
 
-	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state{};
-	read(stream,
-	     specialization_constant_state);
-
-	VertexInputState vertex_input_sate{};
+	for (uint32_t i = 0; i < record.specialization_constant_count; ++i)
+	{
+		uint32_t             constant_id{0};
+		uint32_t             constant_size{0};
+		std::vector<uint8_t> data;
 
-	read(stream,
-	     vertex_input_sate.attributes,
-	     vertex_input_sate.bindings);
+		reader.read(constant_id);
+		reader.read(constant_size);
+		reader.read(data, constant_size);
+		reader.align();
 
-	InputAssemblyState input_assembly_state{};
-	RasterizationState rasterization_state{};
-	ViewportState      viewport_state{};
-	MultisampleState   multisample_state{};
-	DepthStencilState  depth_stencil_state{};
+		specialization_constant_state[constant_id] = std::move(data);
+	}
 
-	read(stream,
-	     input_assembly_state,
-	     rasterization_state,
-	     viewport_state,
-	     multisample_state,
-	     depth_stencil_state);
+	VertexInputState vertex_input_state{};
+	reader.read(vertex_input_state.attributes, record.vertex_attribute_count);
+	reader.read(vertex_input_state.bindings, record.vertex_binding_count);
 
 	ColorBlendState color_blend_state{};
+	color_blend_state.logic_op_enable = record.logic_op_enable;
+	color_blend_state.logic_op        = record.logic_op;
+	reader.read(color_blend_state.attachments, record.color_blend_attachment_count);
 
-	read(stream,
-	     color_blend_state.logic_op,
-	     color_blend_state.logic_op_enable,
-	     color_blend_state.attachments);
+	ReplayJob job{ResourceType::GraphicsPipeline};
+	job.dependencies.push_back(pipeline_layout_jobs.at(record.pipeline_layout));
+	job.dependencies.push_back(render_pass_jobs.at(record.render_pass));
 
-	PipelineState pipeline_state{};
-	pipeline_state.set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
-	pipeline_state.set_render_pass(*render_passes.at(render_pass_index));
+	job.create = [this, record, specialization_constant_state, vertex_input_state, color_blend_state](ResourceCache &resource_cache) {
+		PipelineState pipeline_state{};
+		pipeline_state.set_pipeline_layout(*pipeline_layouts.at(record.pipeline_layout));
+		pipeline_state.set_render_pass(*render_passes.at(record.render_pass));
 
-	for (auto &item : specialization_constant_state)
-	{
-		pipeline_state.set_specialization_constant(item.first, item.second);
-	}
+		for (auto &item : specialization_constant_state)
+		{
+			pipeline_state.set_specialization_constant(item.first, item.second);
+		}
 
-	pipeline_state.set_subpass_index(subpass_index);
-	pipeline_state.set_vertex_input_state(vertex_input_sate);
-	pipeline_state.set_input_assembly_state(input_assembly_state);
-	pipeline_state.set_rasterization_state(rasterization_state);
-	pipeline_state.set_viewport_state(viewport_state);
-	pipeline_state.set_multisample_state(multisample_state);
-	pipeline_state.set_depth_stencil_state(depth_stencil_state);
-	pipeline_state.set_color_blend_state(color_blend_state);
+		pipeline_state.set_subpass_index(record.subpass_index);
+		pipeline_state.set_vertex_input_state(vertex_input_state);
+		pipeline_state.set_input_assembly_state(record.input_assembly_state);
+		pipeline_state.set_rasterization_state(record.rasterization_state);
+		pipeline_state.set_viewport_state(record.viewport_state);
+		pipeline_state.set_multisample_state(record.multisample_state);
+		pipeline_state.set_depth_stencil_state(record.depth_stencil_state);
+		pipeline_state.set_color_blend_state(color_blend_state);
+		pipeline_state.set_fragment_shading_rate_state(record.fragment_shading_rate_state);
 
-	auto &graphics_pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
+		resource_cache.request_graphics_pipeline(pipeline_state);
+	};
 
-	graphics_pipelines.push_back(&graphics_pipeline);
+	jobs.push_back(std::move(job));
 }
 }        // namespace vkb
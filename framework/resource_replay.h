@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
 #include "resource_record.h"
 
 namespace vkb
@@ -24,35 +28,132 @@ namespace vkb
 class ResourceCache;
 
 /**
- * @brief Reads Vulkan objects from a memory stream and creates them in the resource cache.
+ * @brief Bounds-checked reader over the payload of a single record.
+ *        Throws a std::runtime_error if the payload is truncated.
+ */
+class RecordReader
+{
+  public:
+	RecordReader(const uint8_t *data, size_t size);
+
+	template <class T>
+	void read(T &value)
+	{
+		std::memcpy(&value, read_bytes(sizeof(T)), sizeof(T));
+	}
+
+	template <class T>
+	void read(std::vector<T> &values, size_t count)
+	{
+		// The count comes from the record, it is checked before allocating for it
+		if (count > get_remaining() / sizeof(T))
+		{
+			throw std::runtime_error("Resource record is truncated");
+		}
+
+		values.resize(count);
+		if (count > 0)
+		{
+			std::memcpy(values.data(), read_bytes(count * sizeof(T)), count * sizeof(T));
+		}
+	}
+
+	const uint8_t *read_bytes(size_t count);
+
+	/// @return The number of bytes left to read
+	size_t get_remaining() const;
+
+	/// Skips to the next 4-byte boundary
+	void align();
+
+  private:
+	const uint8_t *data;
+
+	size_t size;
+
+	size_t offset{0};
+};
+
+/**
+ * @brief Reads Vulkan objects written by ResourceRecord and creates them in the resource cache.
  */
 class ResourceReplay
 {
   public:
 	ResourceReplay();
 
-	void play(ResourceCache &resource_cache, ResourceRecord &recorder);
+	/**
+	 * @brief Validates and loads serialized resource cache data
+	 * @returns False if the data is truncated or was written with an unsupported format version
+	 */
+	bool load(const uint8_t *data, size_t size);
+
+	/**
+	 * @returns True if the pipeline cache data was written by the same device and driver
+	 */
+	bool is_compatible(const VkPhysicalDeviceProperties &properties) const;
+
+	const std::vector<uint8_t> &get_pipeline_cache_data() const;
+
+	/**
+	 * @brief Creates all the loaded resources in the resource cache
+	 *        Resources only wait for the ones they refer to, so that shader modules and render
+	 *        passes, then pipeline layouts, then graphics pipelines are each created concurrently.
+	 * @param resource_cache The cache to create the resources in
+	 * @param thread_count Number of worker threads, resources are created on the calling thread if lower than 2
+	 */
+	void play(ResourceCache &resource_cache, uint32_t thread_count = std::thread::hardware_concurrency());
 
   protected:
-	void create_shader_module(ResourceCache &resource_cache, std::istringstream &stream);
+	/**
+	 * @brief A resource to create, once all its dependencies are created
+	 */
+	struct ReplayJob
+	{
+		ResourceType type;
 
-	void create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream);
+		/// Indices of the jobs creating the resources this one refers to
+		std::vector<size_t> dependencies;
 
-	void create_render_pass(ResourceCache &resource_cache, std::istringstream &stream);
+		std::function<void(ResourceCache &)> create;
+	};
 
-	void create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
+	void decode_shader_module(RecordReader &reader);
+
+	void decode_pipeline_layout(RecordReader &reader);
+
+	void decode_render_pass(RecordReader &reader);
+
+	void decode_graphics_pipeline(RecordReader &reader);
 
   private:
-	using ResourceFunc = std::function<void(ResourceCache &, std::istringstream &)>;
+	using ResourceFunc = std::function<void(RecordReader &)>;
 
 	std::unordered_map<ResourceType, ResourceFunc> stream_resources;
 
+	ResourceRecordHeader header{};
+
+	std::vector<std::string> strings;
+
+	std::vector<uint8_t> records;
+
+	std::vector<uint8_t> pipeline_cache_data;
+
+	std::vector<ReplayJob> jobs;
+
+	/// Job index of each resource, by resource type
+	std::vector<size_t> shader_module_jobs;
+
+	std::vector<size_t> pipeline_layout_jobs;
+
+	std::vector<size_t> render_pass_jobs;
+
 	std::vector<ShaderModule *> shader_modules;
 
 	std::vector<PipelineLayout *> pipeline_layouts;
 
 	std::vector<const RenderPass *> render_passes;
 
-	std::vector<const GraphicsPipeline *> graphics_pipelines;
+	const std::string &get_string(uint32_t index) const;
 };
 }        // namespace vkb
@@ -0,0 +1,261 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/animation_system.h"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <tuple>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/logging.h"
+#include "common/helpers.h"
+#include "job_system.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+void AnimationSystem::build(const std::vector<Animation *> &clips_)
+{
+	clips = clips_;
+	channels.clear();
+
+	std::set<std::pair<const Node *, AnimationTarget>> animated;
+
+	for (uint32_t clip_index = 0; clip_index < clips.size(); clip_index++)
+	{
+		auto &clip = *clips[clip_index];
+
+		for (auto &track : clip.get_tracks())
+		{
+			if (!animated.emplace(track.node, track.target).second)
+			{
+				LOGW("A property of {} is animated by several clips, {} is ignored", track.node->get_name(), clip.get_name());
+				continue;
+			}
+
+			Channel channel;
+			channel.clip            = clip_index;
+			channel.times           = clip.get_key_times().data() + track.first_key;
+			channel.values          = clip.get_key_values().data() + track.first_value;
+			channel.key_count       = to_u32(track.key_count);
+			channel.component_count = track.component_count;
+			channel.target          = track.target;
+			channel.interpolation   = track.interpolation;
+			channel.node            = track.node;
+
+			channels.push_back(channel);
+		}
+	}
+
+	std::stable_sort(channels.begin(), channels.end(), [](const Channel &a, const Channel &b) {
+		return std::tie(a.interpolation, a.target) < std::tie(b.interpolation, b.target);
+	});
+
+	uint32_t pose_size = 0;
+	for (auto &channel : channels)
+	{
+		channel.output = pose_size;
+		pose_size += channel.component_count;
+	}
+
+	// Every channel is written back by the first update
+	pose.assign(pose_size, std::numeric_limits<float>::quiet_NaN());
+	cursors.assign(channels.size(), 0);
+	changed.assign(channels.size(), 0);
+	clip_times.assign(clips.size(), 0.0f);
+}
+
+bool AnimationSystem::update(float delta_time, JobSystem *job_system)
+{
+	if (channels.empty())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < clips.size(); i++)
+	{
+		clips[i]->advance(delta_time);
+		clip_times[i] = clips[i]->get_time();
+	}
+
+	auto channel_count = to_u32(channels.size());
+
+	if (job_system && channel_count > GRAIN_SIZE)
+	{
+		job_system->parallel_for(0, channel_count, GRAIN_SIZE, [this](uint32_t first, uint32_t last) {
+			sample_range(first, last);
+		});
+	}
+	else
+	{
+		sample_range(0, channel_count);
+	}
+
+	bool any_changed = false;
+
+	for (uint32_t i = 0; i < channel_count; i++)
+	{
+		if (changed[i])
+		{
+			apply(channels[i]);
+			any_changed = true;
+		}
+	}
+
+	return any_changed;
+}
+
+size_t AnimationSystem::get_clip_count() const
+{
+	return clips.size();
+}
+
+size_t AnimationSystem::get_channel_count() const
+{
+	return channels.size();
+}
+
+void AnimationSystem::sample_range(uint32_t first, uint32_t last)
+{
+	for (uint32_t i = first; i < last; i++)
+	{
+		auto &channel    = channels[i];
+		auto  time       = clip_times[channel.clip];
+		auto  times      = channel.times;
+		auto  components = channel.component_count;
+		auto  cubic      = channel.interpolation == AnimationInterpolation::CubicSpline;
+		auto *output     = pose.data() + channel.output;
+
+		// Element of a keyframe, the value being element 1 of the in-tangent, value and out-tangent of cubic splines
+		auto value = [&](uint32_t key, uint32_t element) {
+			return channel.values + (cubic ? (key * 3 + element) : key) * components;
+		};
+
+		// The time moves forward by less than a key in most updates, it only moves back when the clip loops
+		auto next = cursors[i];
+		if (next > 0 && times[next - 1] > time)
+		{
+			next = to_u32(std::upper_bound(times, times + channel.key_count, time) - times);
+		}
+		else
+		{
+			while (next < channel.key_count && times[next] <= time)
+			{
+				++next;
+			}
+		}
+		cursors[i] = next;
+
+		bool value_changed = false;
+
+		auto store = [&](uint32_t c, float v) {
+			value_changed |= output[c] != v;
+			output[c] = v;
+		};
+
+		// Outside of the keyframes, the channel holds its first or last value
+		if (next == 0 || next == channel.key_count || channel.interpolation == AnimationInterpolation::Step)
+		{
+			auto key = value(next == 0 ? 0 : next - 1, 1);
+			for (uint32_t c = 0; c < components; c++)
+			{
+				store(c, key[c]);
+			}
+		}
+		else
+		{
+			auto previous = next - 1;
+			auto interval = times[next] - times[previous];
+			auto t        = interval > 0.0f ? (time - times[previous]) / interval : 0.0f;
+
+			auto a = value(previous, 1);
+			auto b = value(next, 1);
+
+			if (cubic)
+			{
+				// Hermite spline between the values, with the out-tangent of the previous key and the in-tangent of the next one
+				auto t2 = t * t;
+				auto t3 = t2 * t;
+
+				auto out_tangent = value(previous, 2);
+				auto in_tangent  = value(next, 0);
+
+				for (uint32_t c = 0; c < components; c++)
+				{
+					store(c, (2.0f * t3 - 3.0f * t2 + 1.0f) * a[c] + (t3 - 2.0f * t2 + t) * interval * out_tangent[c] +
+					             (-2.0f * t3 + 3.0f * t2) * b[c] + (t3 - t2) * interval * in_tangent[c]);
+				}
+			}
+			else if (channel.target == AnimationTarget::Rotation)
+			{
+				auto rotation = glm::slerp(glm::quat(a[3], a[0], a[1], a[2]), glm::quat(b[3], b[0], b[1], b[2]), t);
+
+				store(0, rotation.x);
+				store(1, rotation.y);
+				store(2, rotation.z);
+				store(3, rotation.w);
+			}
+			else
+			{
+				for (uint32_t c = 0; c < components; c++)
+				{
+					store(c, a[c] + (b[c] - a[c]) * t);
+				}
+			}
+		}
+
+		changed[i] = value_changed ? 1 : 0;
+	}
+}
+
+void AnimationSystem::apply(const Channel &channel) const
+{
+	auto *value     = pose.data() + channel.output;
+	auto &transform = channel.node->get_transform();
+
+	switch (channel.target)
+	{
+		case AnimationTarget::Translation:
+			transform.set_translation(glm::vec3(value[0], value[1], value[2]));
+			break;
+		case AnimationTarget::Rotation:
+			transform.set_rotation(glm::normalize(glm::quat(value[3], value[0], value[1], value[2])));
+			break;
+		case AnimationTarget::Scale:
+			transform.set_scale(glm::vec3(value[0], value[1], value[2]));
+			break;
+		case AnimationTarget::Weights:
+			if (channel.node->has_component<Mesh>())
+			{
+				channel.node->get_component<Mesh>().set_morph_weights(value, channel.component_count);
+			}
+			break;
+	}
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,118 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "scene_graph/components/animation.h"
+
+namespace vkb
+{
+class JobSystem;
+
+namespace sg
+{
+class Node;
+
+/**
+ * @brief Samples the animation clips of a scene in one pass over flattened channels
+ *
+ * Each track of the clips becomes a channel, reading the keyframe arrays of its clip and writing its
+ * value to its own range of a flat pose array. The channels are sorted by property and interpolation,
+ * so that consecutive samples take the same path, and sampled in parallel on a job system. Each channel
+ * keeps the key it last sampled from, so the keyframes are only searched when the clip loops.
+ *
+ * Only the properties whose value changed are written back to the nodes, so the transform hierarchy
+ * only recomputes the world matrices of the nodes which moved. A property animated by several clips
+ * is driven by the first one.
+ */
+class AnimationSystem
+{
+  public:
+	/// Minimum number of channels sampled by each job
+	static constexpr uint32_t GRAIN_SIZE = 256;
+
+	/**
+	 * @brief Flattens the tracks of clips into channels, replacing the previous ones
+	 */
+	void build(const std::vector<Animation *> &clips);
+
+	/**
+	 * @brief Advances the clips and poses their nodes
+	 * @param job_system Optional job system sampling the channels in parallel
+	 * @return Whether any animated property changed
+	 */
+	bool update(float delta_time, JobSystem *job_system = nullptr);
+
+	size_t get_clip_count() const;
+
+	size_t get_channel_count() const;
+
+  private:
+	struct Channel
+	{
+		/// Index of the clip in clips
+		uint32_t clip;
+
+		const float *times;
+
+		const float *values;
+
+		uint32_t key_count;
+
+		uint32_t component_count;
+
+		AnimationTarget target;
+
+		AnimationInterpolation interpolation;
+
+		/// Start of the value of the channel in the pose
+		uint32_t output;
+
+		Node *node;
+	};
+
+	/**
+	 * @brief Samples the channels in [first, last) at the times of their clips
+	 */
+	void sample_range(uint32_t first, uint32_t last);
+
+	/**
+	 * @brief Writes the value of a channel to its node
+	 */
+	void apply(const Channel &channel) const;
+
+	std::vector<Animation *> clips;
+
+	/// Times of the clips for the current update
+	std::vector<float> clip_times;
+
+	std::vector<Channel> channels;
+
+	/// Index of the first key after the time of the last sample of each channel
+	std::vector<uint32_t> cursors;
+
+	/// Whether the last sample of each channel changed its value
+	std::vector<uint8_t> changed;
+
+	/// The values of all the channels
+	std::vector<float> pose;
+};
+}        // namespace sg
+}        // namespace vkb
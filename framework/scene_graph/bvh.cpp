@@ -0,0 +1,479 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/bvh.h"
+
+#include <algorithm>
+#include <array>
+
+#include "geometry/frustum.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+float get_surface_area(const glm::vec3 &min, const glm::vec3 &max)
+{
+	auto extent = max - min;
+
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+/**
+ * @brief Distance along the ray to a box, or max_distance if it is not hit closer
+ */
+float intersect_box(const glm::vec3 &origin, const glm::vec3 &inverse_direction, const glm::vec3 &min, const glm::vec3 &max, float max_distance)
+{
+	auto t0 = (min - origin) * inverse_direction;
+	auto t1 = (max - origin) * inverse_direction;
+
+	auto t_near = glm::min(t0, t1);
+	auto t_far  = glm::max(t0, t1);
+
+	float enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+	float exit  = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_distance));
+
+	return enter <= exit ? enter : max_distance;
+}
+
+struct Bin
+{
+	glm::vec3 min{std::numeric_limits<float>::max()};
+
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	uint32_t count{0};
+};
+}        // namespace
+
+void BVH::build(const std::vector<Mesh *> &meshes)
+{
+	tree_nodes.clear();
+	instances.clear();
+	unbounded_instances.clear();
+
+	for (auto mesh : meshes)
+	{
+		bool bounded = mesh->get_bounds().get_scale() != glm::vec3(0.0f);
+
+		for (auto node : mesh->get_nodes())
+		{
+			(bounded ? instances : unbounded_instances).emplace_back(node, mesh);
+		}
+	}
+
+	auto instance_count = static_cast<uint32_t>(instances.size());
+
+	instance_min.resize(instance_count);
+	instance_max.resize(instance_count);
+	instance_order.resize(instance_count);
+
+	for (uint32_t i = 0; i < instance_count; ++i)
+	{
+		update_instance_bounds(i);
+		instance_order[i] = i;
+	}
+
+	if (instance_count == 0)
+	{
+		return;
+	}
+
+	// A binary tree with single instance leaves has 2n - 1 nodes, the references stay valid while splitting
+	tree_nodes.reserve(2 * instance_count - 1);
+	tree_nodes.push_back({glm::vec3{}, 0, glm::vec3{}, instance_count});
+	update_node_bounds(0);
+
+	std::vector<uint32_t> split_nodes{0};
+
+	while (!split_nodes.empty())
+	{
+		auto node = split_nodes.back();
+		split_nodes.pop_back();
+
+		subdivide(node);
+
+		if (tree_nodes[node].count == 0)
+		{
+			split_nodes.push_back(tree_nodes[node].first);
+			split_nodes.push_back(tree_nodes[node].first + 1);
+		}
+	}
+}
+
+void BVH::refit()
+{
+	for (uint32_t i = 0; i < instances.size(); ++i)
+	{
+		update_instance_bounds(i);
+	}
+
+	// Children are always after their parent
+	for (auto node = static_cast<int64_t>(tree_nodes.size()) - 1; node >= 0; --node)
+	{
+		auto &tree_node = tree_nodes[node];
+
+		if (tree_node.count > 0)
+		{
+			update_node_bounds(static_cast<uint32_t>(node));
+		}
+		else
+		{
+			auto &left  = tree_nodes[tree_node.first];
+			auto &right = tree_nodes[tree_node.first + 1];
+
+			tree_node.min = glm::min(left.min, right.min);
+			tree_node.max = glm::max(left.max, right.max);
+		}
+	}
+}
+
+void BVH::query_frustum(const Frustum &frustum, std::vector<Instance> &result) const
+{
+	result.insert(result.end(), unbounded_instances.begin(), unbounded_instances.end());
+
+	if (tree_nodes.empty())
+	{
+		return;
+	}
+
+	auto &planes = frustum.get_planes();
+
+	std::vector<uint32_t> traverse_nodes{0};
+
+	while (!traverse_nodes.empty())
+	{
+		auto  node      = traverse_nodes.back();
+		auto &tree_node = tree_nodes[node];
+		traverse_nodes.pop_back();
+
+		bool outside = false;
+		bool inside  = true;
+
+		for (auto &plane : planes)
+		{
+			auto normal = glm::vec3(plane);
+
+			// The corners of the box the furthest along and against the plane normal
+			auto positive = glm::mix(tree_node.min, tree_node.max, glm::greaterThan(normal, glm::vec3(0.0f)));
+			auto negative = glm::mix(tree_node.max, tree_node.min, glm::greaterThan(normal, glm::vec3(0.0f)));
+
+			if (glm::dot(normal, positive) + plane.w < 0.0f)
+			{
+				outside = true;
+				break;
+			}
+
+			inside = inside && glm::dot(normal, negative) + plane.w >= 0.0f;
+		}
+
+		if (outside)
+		{
+			continue;
+		}
+
+		if (inside || tree_node.count > 0)
+		{
+			collect(node, result);
+		}
+		else
+		{
+			traverse_nodes.push_back(tree_node.first);
+			traverse_nodes.push_back(tree_node.first + 1);
+		}
+	}
+}
+
+bool BVH::overlaps_sphere(const glm::vec3 &center, float radius) const
+{
+	if (!unbounded_instances.empty())
+	{
+		return true;
+	}
+
+	if (tree_nodes.empty())
+	{
+		return false;
+	}
+
+	auto overlaps = [&](const glm::vec3 &min, const glm::vec3 &max) {
+		auto closest = glm::clamp(center, min, max);
+		return glm::dot(closest - center, closest - center) <= radius * radius;
+	};
+
+	std::vector<uint32_t> traverse_nodes{0};
+
+	while (!traverse_nodes.empty())
+	{
+		auto &tree_node = tree_nodes[traverse_nodes.back()];
+		traverse_nodes.pop_back();
+
+		if (!overlaps(tree_node.min, tree_node.max))
+		{
+			continue;
+		}
+
+		if (tree_node.count == 0)
+		{
+			traverse_nodes.push_back(tree_node.first);
+			traverse_nodes.push_back(tree_node.first + 1);
+			continue;
+		}
+
+		for (uint32_t i = tree_node.first; i < tree_node.first + tree_node.count; ++i)
+		{
+			auto instance = instance_order[i];
+
+			if (overlaps(instance_min[instance], instance_max[instance]))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+BVH::RayHit BVH::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance) const
+{
+	RayHit hit{};
+	hit.distance = max_distance;
+
+	if (tree_nodes.empty())
+	{
+		return hit;
+	}
+
+	// Divisions by zero give infinities, which the slab test handles
+	auto inverse_direction = 1.0f / direction;
+
+	std::vector<uint32_t> traverse_nodes{0};
+
+	while (!traverse_nodes.empty())
+	{
+		auto &tree_node = tree_nodes[traverse_nodes.back()];
+		traverse_nodes.pop_back();
+
+		if (intersect_box(origin, inverse_direction, tree_node.min, tree_node.max, hit.distance) >= hit.distance)
+		{
+			continue;
+		}
+
+		if (tree_node.count == 0)
+		{
+			traverse_nodes.push_back(tree_node.first);
+			traverse_nodes.push_back(tree_node.first + 1);
+			continue;
+		}
+
+		for (uint32_t i = tree_node.first; i < tree_node.first + tree_node.count; ++i)
+		{
+			auto instance = instance_order[i];
+
+			float distance = intersect_box(origin, inverse_direction, instance_min[instance], instance_max[instance], hit.distance);
+
+			if (distance < hit.distance)
+			{
+				hit.node     = instances[instance].first;
+				hit.mesh     = instances[instance].second;
+				hit.distance = distance;
+			}
+		}
+	}
+
+	return hit;
+}
+
+size_t BVH::get_instance_count() const
+{
+	return instances.size() + unbounded_instances.size();
+}
+
+size_t BVH::get_node_count() const
+{
+	return tree_nodes.size();
+}
+
+void BVH::update_instance_bounds(uint32_t instance)
+{
+	auto &bounds       = instances[instance].second->get_bounds();
+	auto  world_matrix = instances[instance].first->get_transform().get_world_matrix();
+
+	AABB world_bounds{bounds.get_min(), bounds.get_max()};
+	world_bounds.transform(world_matrix);
+
+	instance_min[instance] = world_bounds.get_min();
+	instance_max[instance] = world_bounds.get_max();
+}
+
+void BVH::update_node_bounds(uint32_t node)
+{
+	auto &tree_node = tree_nodes[node];
+
+	tree_node.min = glm::vec3(std::numeric_limits<float>::max());
+	tree_node.max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	for (uint32_t i = tree_node.first; i < tree_node.first + tree_node.count; ++i)
+	{
+		tree_node.min = glm::min(tree_node.min, instance_min[instance_order[i]]);
+		tree_node.max = glm::max(tree_node.max, instance_max[instance_order[i]]);
+	}
+}
+
+void BVH::subdivide(uint32_t node)
+{
+	auto &tree_node = tree_nodes[node];
+
+	if (tree_node.count <= MAX_LEAF_SIZE)
+	{
+		return;
+	}
+
+	auto first = tree_node.first;
+	auto last  = tree_node.first + tree_node.count;
+
+	auto get_centroid = [this](uint32_t instance) { return (instance_min[instance] + instance_max[instance]) * 0.5f; };
+
+	// The bins split the bounds of the centroids rather than of the boxes
+	glm::vec3 centroid_min{std::numeric_limits<float>::max()};
+	glm::vec3 centroid_max{std::numeric_limits<float>::lowest()};
+
+	for (auto i = first; i < last; ++i)
+	{
+		auto centroid = get_centroid(instance_order[i]);
+		centroid_min  = glm::min(centroid_min, centroid);
+		centroid_max  = glm::max(centroid_max, centroid);
+	}
+
+	float best_cost  = static_cast<float>(tree_node.count) * get_surface_area(tree_node.min, tree_node.max);
+	int   best_axis  = -1;
+	int   best_split = 0;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float extent = centroid_max[axis] - centroid_min[axis];
+
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		float scale = BIN_COUNT / extent;
+
+		std::array<Bin, BIN_COUNT> bins{};
+
+		for (auto i = first; i < last; ++i)
+		{
+			auto instance = instance_order[i];
+			auto bin      = std::min(BIN_COUNT - 1, static_cast<uint32_t>((get_centroid(instance)[axis] - centroid_min[axis]) * scale));
+
+			bins[bin].min = glm::min(bins[bin].min, instance_min[instance]);
+			bins[bin].max = glm::max(bins[bin].max, instance_max[instance]);
+			++bins[bin].count;
+		}
+
+		// The cost of the instances on the right of each split, swept from the right
+		std::array<float, BIN_COUNT> right_costs{};
+
+		Bin right{};
+		for (auto bin = BIN_COUNT - 1; bin > 0; --bin)
+		{
+			right.min = glm::min(right.min, bins[bin].min);
+			right.max = glm::max(right.max, bins[bin].max);
+			right.count += bins[bin].count;
+
+			right_costs[bin] = right.count > 0 ? right.count * get_surface_area(right.min, right.max) : 0.0f;
+		}
+
+		Bin left{};
+		for (uint32_t bin = 0; bin < BIN_COUNT - 1; ++bin)
+		{
+			left.min = glm::min(left.min, bins[bin].min);
+			left.max = glm::max(left.max, bins[bin].max);
+			left.count += bins[bin].count;
+
+			float cost = (left.count > 0 ? left.count * get_surface_area(left.min, left.max) : 0.0f) + right_costs[bin + 1];
+
+			if (cost < best_cost)
+			{
+				best_cost  = cost;
+				best_axis  = axis;
+				best_split = static_cast<int>(bin) + 1;
+			}
+		}
+	}
+
+	// Splitting is not worth it
+	if (best_axis < 0)
+	{
+		return;
+	}
+
+	float scale = BIN_COUNT / (centroid_max[best_axis] - centroid_min[best_axis]);
+
+	auto middle = std::partition(instance_order.begin() + first, instance_order.begin() + last, [&](uint32_t instance) {
+		auto bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((get_centroid(instance)[best_axis] - centroid_min[best_axis]) * scale));
+		return static_cast<int>(bin) < best_split;
+	});
+
+	auto left_count = static_cast<uint32_t>(middle - instance_order.begin()) - first;
+
+	if (left_count == 0 || left_count == tree_node.count)
+	{
+		return;
+	}
+
+	auto left_node = static_cast<uint32_t>(tree_nodes.size());
+
+	tree_nodes.push_back({glm::vec3{}, first, glm::vec3{}, left_count});
+	tree_nodes.push_back({glm::vec3{}, first + left_count, glm::vec3{}, tree_node.count - left_count});
+
+	update_node_bounds(left_node);
+	update_node_bounds(left_node + 1);
+
+	tree_node.first = left_node;
+	tree_node.count = 0;
+}
+
+void BVH::collect(uint32_t node, std::vector<Instance> &result) const
+{
+	std::vector<uint32_t> traverse_nodes{node};
+
+	while (!traverse_nodes.empty())
+	{
+		auto &tree_node = tree_nodes[traverse_nodes.back()];
+		traverse_nodes.pop_back();
+
+		if (tree_node.count == 0)
+		{
+			traverse_nodes.push_back(tree_node.first);
+			traverse_nodes.push_back(tree_node.first + 1);
+			continue;
+		}
+
+		for (uint32_t i = tree_node.first; i < tree_node.first + tree_node.count; ++i)
+		{
+			result.push_back(instances[instance_order[i]]);
+		}
+	}
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,145 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class Frustum;
+
+namespace sg
+{
+class Mesh;
+class Node;
+
+/**
+ * @brief Bounding volume hierarchy over the world space bounds of the mesh instances of a scene
+ *
+ * The tree is built top-down, splitting each node where the surface area heuristic is the lowest
+ * among a fixed number of bins along each axis. When the nodes move, refit() recomputes the bounds
+ * of the instances and of the tree nodes without changing the tree, which stays valid but loosens
+ * as the instances move away from where it was built.
+ *
+ * Meshes without bounds are kept out of the tree. They are returned by every frustum query and
+ * overlap every sphere, but are never hit by rays.
+ */
+class BVH
+{
+  public:
+	/// A mesh drawn at a node
+	using Instance = std::pair<Node *, Mesh *>;
+
+	struct RayHit
+	{
+		Node *node{nullptr};
+
+		Mesh *mesh{nullptr};
+
+		/// Distance along the ray to the bounds of the instance
+		float distance{std::numeric_limits<float>::max()};
+	};
+
+	/**
+	 * @brief Builds the tree over the instances of the meshes, with the current world matrices of their nodes
+	 */
+	void build(const std::vector<Mesh *> &meshes);
+
+	/**
+	 * @brief Updates the bounds of the instances and of the tree with the current world matrices
+	 */
+	void refit();
+
+	/**
+	 * @brief Appends the instances whose bounds are at least partly inside the frustum
+	 */
+	void query_frustum(const Frustum &frustum, std::vector<Instance> &instances) const;
+
+	/**
+	 * @return Whether the bounds of any instance overlap the sphere
+	 */
+	bool overlaps_sphere(const glm::vec3 &center, float radius) const;
+
+	/**
+	 * @brief Finds the nearest instance whose bounds the ray hits
+	 *        Meshes have no geometry on the CPU, so the bounds of the instances are tested rather than their triangles
+	 * @param origin Origin of the ray
+	 * @param direction Direction of the ray, normalized
+	 * @param max_distance Maximum distance along the ray
+	 * @return The nearest hit, whose node is nullptr if nothing was hit
+	 */
+	RayHit raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance = std::numeric_limits<float>::max()) const;
+
+	size_t get_instance_count() const;
+
+	size_t get_node_count() const;
+
+	/// Maximum number of instances in a leaf
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+	/// Number of split positions evaluated along each axis
+	static constexpr uint32_t BIN_COUNT = 12;
+
+  private:
+	/**
+	 * @brief A node of the tree, a leaf if it has instances, otherwise its children are at first and first + 1
+	 */
+	struct TreeNode
+	{
+		glm::vec3 min;
+
+		uint32_t first;
+
+		glm::vec3 max;
+
+		uint32_t count;
+	};
+
+	void update_instance_bounds(uint32_t instance);
+
+	void update_node_bounds(uint32_t node);
+
+	void subdivide(uint32_t node);
+
+	/**
+	 * @brief Appends the instances of a subtree without testing them
+	 */
+	void collect(uint32_t node, std::vector<Instance> &instances) const;
+
+	std::vector<TreeNode> tree_nodes;
+
+	std::vector<Instance> instances;
+
+	std::vector<glm::vec3> instance_min;
+
+	std::vector<glm::vec3> instance_max;
+
+	/// Instances in the order of the leaves
+	std::vector<uint32_t> instance_order;
+
+	std::vector<Instance> unbounded_instances;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,61 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/change_journal.h"
+
+namespace vkb
+{
+namespace sg
+{
+void ChangeJournal::record(ChangeType type, Node *node, Component *component)
+{
+	changes.push_back({type, node, component});
+
+	if (changes.size() > MAX_CHANGES)
+	{
+		changes.pop_front();
+		++first;
+	}
+}
+
+void ChangeJournal::reset()
+{
+	// Skips a cursor, so the consumers which read every change are behind as well
+	first += changes.size() + 1;
+	changes.clear();
+}
+
+uint64_t ChangeJournal::get_cursor() const
+{
+	return first + changes.size();
+}
+
+bool ChangeJournal::read(uint64_t &cursor, std::vector<Change> &changes_out) const
+{
+	if (cursor < first)
+	{
+		cursor = get_cursor();
+		return false;
+	}
+
+	changes_out.insert(changes_out.end(), changes.begin() + static_cast<std::ptrdiff_t>(cursor - first), changes.end());
+
+	cursor = get_cursor();
+	return true;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,95 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace vkb
+{
+namespace sg
+{
+class Component;
+class Node;
+
+enum class ChangeType
+{
+	/// The world matrix of a node changed
+	Transform,
+
+	/// The parameters or textures of a material changed
+	Material,
+
+	MeshAdded,
+
+	/// The mesh is destroyed, its address is only left to compare with
+	MeshRemoved
+};
+
+struct Change
+{
+	ChangeType type;
+
+	Node *node;
+
+	Component *component;
+};
+
+/**
+ * @brief The changes of a scene between frames, for the caches derived from the scene to update
+ *        only the entries they affect
+ *
+ * Each consumer keeps a cursor in the journal and reads the changes recorded since. The journal keeps
+ * a bounded number of changes, a consumer which fell further behind, or is reading a journal which was
+ * reset, is told to rebuild everything it derived from the scene. A consumer which builds its cache
+ * from the scene takes the current cursor at the same time.
+ */
+class ChangeJournal
+{
+  public:
+	/// Number of changes kept for the consumers which are behind
+	static constexpr size_t MAX_CHANGES = 65536;
+
+	void record(ChangeType type, Node *node, Component *component = nullptr);
+
+	/**
+	 * @brief Drops the changes, e.g. when the nodes of the scene are replaced, so every consumer rebuilds
+	 */
+	void reset();
+
+	/**
+	 * @return The cursor after the last change
+	 */
+	uint64_t get_cursor() const;
+
+	/**
+	 * @brief Appends the changes recorded since a cursor to a list, and moves the cursor after them
+	 * @return False if some of the changes were dropped, the consumer then rebuilds instead
+	 */
+	bool read(uint64_t &cursor, std::vector<Change> &changes) const;
+
+  private:
+	std::deque<Change> changes;
+
+	/// Cursor of the first kept change
+	uint64_t first{0};
+};
+}        // namespace sg
+}        // namespace vkb
@@ -17,12 +17,64 @@
 
 #include "aabb.h"
 
+#include "common/helpers.h"
 #include "common/logging.h"
+#include "geometry/bounds_kernels.h"
+#include "job_system.h"
 
 namespace vkb
 {
 namespace sg
 {
+namespace
+{
+/// Positions reduced by each job when the bounds are computed in parallel
+constexpr uint32_t BOUNDS_GRAIN_SIZE = 64 * 1024;
+
+/**
+ * @brief Grows a box to contain the positions in [first, last), or the positions they index if there are indices
+ */
+template <typename T>
+void grow_bounds(const glm::vec3 *vertices, const T *indices, size_t first, size_t last, glm::vec3 &min, glm::vec3 &max)
+{
+	if (!indices)
+	{
+		bounds::compute_bounds(vertices + first, last - first, min, max);
+		return;
+	}
+
+	for (size_t i = first; i < last; ++i)
+	{
+		min = glm::min(min, vertices[indices[i]]);
+		max = glm::max(max, vertices[indices[i]]);
+	}
+}
+
+template <typename T>
+void reduce_bounds(const glm::vec3 *vertices, const T *indices, size_t count, JobSystem *job_system, glm::vec3 &min, glm::vec3 &max)
+{
+	if (!job_system || count <= BOUNDS_GRAIN_SIZE)
+	{
+		grow_bounds(vertices, indices, 0, count, min, max);
+		return;
+	}
+
+	// Each chunk reduces into its own box, merged once all of them are done
+	std::vector<std::pair<glm::vec3, glm::vec3>> partials((count + BOUNDS_GRAIN_SIZE - 1) / BOUNDS_GRAIN_SIZE, std::make_pair(min, max));
+
+	job_system->parallel_for(0, to_u32(count), BOUNDS_GRAIN_SIZE, [&](uint32_t first, uint32_t last) {
+		auto &partial = partials[first / BOUNDS_GRAIN_SIZE];
+		grow_bounds(vertices, indices, first, last, partial.first, partial.second);
+	});
+
+	for (auto &partial : partials)
+	{
+		min = glm::min(min, partial.first);
+		max = glm::max(max, partial.second);
+	}
+}
+}        // namespace
+
 AABB::AABB()
 {
 	reset();
@@ -45,39 +97,30 @@ void AABB::update(const glm::vec3 &point)
 	max = glm::max(max, point);
 }
 
-void AABB::update(const std::vector<glm::vec3> &vertex_data, const std::vector<uint16_t> &index_data)
+void AABB::update(const glm::vec3 *vertices, size_t vertex_count, JobSystem *job_system)
 {
-	// Check if submesh is indexed
-	if (index_data.size() > 0)
-	{
-		// Update bounding box for each indexed vertex
-		for (size_t index_id = 0; index_id < index_data.size(); index_id++)
-		{
-			update(vertex_data[index_data[index_id]]);
-		}
-	}
-	else
-	{
-		// Update bounding box for each vertex
-		for (size_t vertex_id = 0; vertex_id < vertex_data.size(); vertex_id++)
-		{
-			update(vertex_data[vertex_id]);
-		}
-	}
+	reduce_bounds<uint16_t>(vertices, nullptr, vertex_count, job_system, min, max);
+}
+
+void AABB::update(const glm::vec3 *vertices, const uint16_t *indices, size_t index_count, JobSystem *job_system)
+{
+	reduce_bounds(vertices, indices, index_count, job_system, min, max);
+}
+
+void AABB::update(const glm::vec3 *vertices, const uint32_t *indices, size_t index_count, JobSystem *job_system)
+{
+	reduce_bounds(vertices, indices, index_count, job_system, min, max);
 }
 
 void AABB::transform(glm::mat4 &transform)
 {
-	min = max = glm::vec4(min, 1.0f) * transform;
+	// The box around the transformed box, from its center and half extent, as the transforms are affine
+	auto center = get_center();
+	auto extent = get_scale() * 0.5f;
+
+	bounds::BoxArrays box{&min.x, &min.y, &min.z, &max.x, &max.y, &max.z};
 
-	// Update bounding box for the remaining 7 corners of the box
-	update(glm::vec4(min.x, min.y, max.z, 1.0f) * transform);
-	update(glm::vec4(min.x, max.y, min.z, 1.0f) * transform);
-	update(glm::vec4(min.x, max.y, max.z, 1.0f) * transform);
-	update(glm::vec4(max.x, min.y, min.z, 1.0f) * transform);
-	update(glm::vec4(max.x, min.y, max.z, 1.0f) * transform);
-	update(glm::vec4(max.x, max.y, min.z, 1.0f) * transform);
-	update(glm::vec4(max, 1.0f) * transform);
+	bounds::transform_boxes(&transform, &center, &extent, 1, box);
 }
 
 glm::vec3 AABB::get_scale() const
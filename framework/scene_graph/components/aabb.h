@@ -33,6 +33,8 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+class JobSystem;
+
 namespace sg
 {
 /**
@@ -56,11 +58,23 @@ class AABB : public Component
 	void update(const glm::vec3 &point);
 
 	/**
-	 * @brief Update the bounding box based on the given submesh vertices
-	 * @param vertex_data The position vertex data
-	 * @param index_data The index vertex data
+	 * @brief Update the bounding box to contain a range of vertex positions
+	 * @param vertices The vertex positions, read in place
+	 * @param vertex_count The number of vertices
+	 * @param job_system Optional job system reducing large ranges in parallel
 	 */
-	void update(const std::vector<glm::vec3> &vertex_data, const std::vector<uint16_t> &index_data);
+	void update(const glm::vec3 *vertices, size_t vertex_count, JobSystem *job_system = nullptr);
+
+	/**
+	 * @brief Update the bounding box to contain the vertex positions referenced by a range of indices
+	 * @param vertices The vertex positions, read in place
+	 * @param indices The indices of the vertices to contain
+	 * @param index_count The number of indices
+	 * @param job_system Optional job system reducing large ranges in parallel
+	 */
+	void update(const glm::vec3 *vertices, const uint16_t *indices, size_t index_count, JobSystem *job_system = nullptr);
+
+	void update(const glm::vec3 *vertices, const uint32_t *indices, size_t index_count, JobSystem *job_system = nullptr);
 
 	/**
 	 * @brief Apply a given matrix transformation to the bounding box
@@ -0,0 +1,116 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "common/utils.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+Animation::Animation(const std::string &name) :
+    Component{name}
+{}
+
+std::type_index Animation::get_type()
+{
+	return typeid(Animation);
+}
+
+void Animation::add_track(Node &node, AnimationTarget target, AnimationInterpolation interpolation, const std::vector<float> &times, const std::vector<float> &values)
+{
+	if (times.empty())
+	{
+		return;
+	}
+
+	auto values_per_key = interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+
+	if (values.size() % (times.size() * values_per_key) != 0)
+	{
+		throw std::runtime_error{"Animation track of " + node.get_name() + " has a mismatched number of values"};
+	}
+
+	Track track;
+	track.node            = &node;
+	track.target          = target;
+	track.interpolation   = interpolation;
+	track.component_count = to_u32(values.size() / (times.size() * values_per_key));
+	track.first_key       = key_times.size();
+	track.key_count       = times.size();
+	track.first_value     = key_values.size();
+
+	key_times.insert(key_times.end(), times.begin(), times.end());
+	key_values.insert(key_values.end(), values.begin(), values.end());
+
+	tracks.push_back(track);
+
+	duration = std::max(duration, times.back());
+}
+
+size_t Animation::get_track_count() const
+{
+	return tracks.size();
+}
+
+float Animation::get_duration() const
+{
+	return duration;
+}
+
+void Animation::set_time(float time_)
+{
+	time = time_;
+}
+
+float Animation::get_time() const
+{
+	return time;
+}
+
+void Animation::advance(float delta_time)
+{
+	time += delta_time;
+
+	if (duration > 0.0f)
+	{
+		time = std::fmod(time, duration);
+	}
+}
+
+const std::vector<Animation::Track> &Animation::get_tracks() const
+{
+	return tracks;
+}
+
+const std::vector<float> &Animation::get_key_times() const
+{
+	return key_times;
+}
+
+const std::vector<float> &Animation::get_key_values() const
+{
+	return key_values;
+}
+}        // namespace sg
+}        // namespace vkb
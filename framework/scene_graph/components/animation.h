@@ -0,0 +1,124 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+
+enum class AnimationTarget
+{
+	Translation,
+	Rotation,
+	Scale,
+	Weights
+};
+
+enum class AnimationInterpolation
+{
+	Linear,
+	Step,
+	CubicSpline
+};
+
+/**
+ * @brief A clip of keyframed tracks animating the transforms and morph target weights of nodes, as imported from glTF
+ *
+ * The keyframes of all the tracks are stored as structures of arrays: the times in one array and the values
+ * in another, each track owning a range of both. The clips of a scene are sampled together by its AnimationSystem.
+ *
+ * The clip loops over the duration of its longest track.
+ */
+class Animation : public Component
+{
+  public:
+	struct Track
+	{
+		Node *node;
+
+		AnimationTarget target;
+
+		AnimationInterpolation interpolation;
+
+		/// Floats of a value
+		uint32_t component_count;
+
+		/// Range of the track in the key times
+		size_t first_key;
+
+		size_t key_count;
+
+		/// Start of the track in the key values
+		size_t first_value;
+	};
+
+	Animation(const std::string &name);
+
+	virtual ~Animation() = default;
+
+	virtual std::type_index get_type() override;
+
+	/**
+	 * @brief Adds a track animating a property of a node
+	 * @param node The animated node, morph target weights are set on its mesh
+	 * @param times Times of the keyframes in seconds, in increasing order
+	 * @param values The same number of floats for each keyframe, three times as many with cubic spline
+	 *        interpolation for the in-tangent, value and out-tangent. Rotations are quaternions stored as x, y, z, w.
+	 */
+	void add_track(Node &node, AnimationTarget target, AnimationInterpolation interpolation, const std::vector<float> &times, const std::vector<float> &values);
+
+	size_t get_track_count() const;
+
+	float get_duration() const;
+
+	void set_time(float time);
+
+	float get_time() const;
+
+	/**
+	 * @brief Advances the time of the clip, looping over its duration
+	 */
+	void advance(float delta_time);
+
+	const std::vector<Track> &get_tracks() const;
+
+	const std::vector<float> &get_key_times() const;
+
+	const std::vector<float> &get_key_values() const;
+
+  private:
+	std::vector<Track> tracks;
+
+	std::vector<float> key_times;
+
+	std::vector<float> key_values;
+
+	float duration{0.0f};
+
+	float time{0.0f};
+};
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,34 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry_arena.h"
+
+namespace vkb
+{
+namespace sg
+{
+GeometryArena::GeometryArena(const std::string &name, core::Buffer &&buffer) :
+    Component{name},
+    buffer{std::move(buffer)}
+{}
+
+std::type_index GeometryArena::get_type()
+{
+	return typeid(GeometryArena);
+}
+}        // namespace sg
+}        // namespace vkb
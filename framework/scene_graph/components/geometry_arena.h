@@ -0,0 +1,56 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "core/buffer.h"
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief A buffer holding the vertex or index data of many submeshes
+ *
+ * Submeshes reference a range of the arena instead of owning small buffers, so that
+ * consecutive draws share the same buffers and only change offsets.
+ */
+class GeometryArena : public Component
+{
+  public:
+	/**
+	 * @brief Alignment of the ranges in an arena, suitable for any vertex format and index type
+	 */
+	static constexpr size_t RANGE_ALIGNMENT = 16;
+
+	GeometryArena(const std::string &name, core::Buffer &&buffer);
+
+	GeometryArena(GeometryArena &&other) = default;
+
+	virtual ~GeometryArena() = default;
+
+	virtual std::type_index get_type() override;
+
+	core::Buffer buffer;
+};
+}        // namespace sg
+}        // namespace vkb
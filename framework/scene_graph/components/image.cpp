@@ -17,6 +17,7 @@
 
 #include "image.h"
 
+#include <cstring>
 #include <mutex>
 
 #include "common/error.h"
@@ -28,6 +29,7 @@ VKBP_ENABLE_WARNINGS()
 
 #include "common/utils.h"
 #include "platform/filesystem.h"
+#include "upload_manager.h"
 #include "scene_graph/components/image/astc.h"
 #include "scene_graph/components/image/ktx.h"
 #include "scene_graph/components/image/stb.h"
@@ -121,18 +123,147 @@ void Image::create_vk_image(Device &device, VkImageViewType image_view_type, VkI
 {
 	assert(!vk_image && !vk_image_view && "Vulkan image already constructed");
 
-	vk_image = std::make_unique<core::Image>(device,
-	                                         get_extent(),
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	if (gpu_mipmaps)
+	{
+		// The levels are blitted from one another
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+
+	vk_image = std::make_shared<core::Image>(device,
+	                                         mipmaps.at(base_level).extent,
 	                                         format,
-	                                         VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                         usage,
 	                                         VMA_MEMORY_USAGE_GPU_ONLY,
 	                                         VK_SAMPLE_COUNT_1_BIT,
-	                                         to_u32(mipmaps.size()),
+	                                         to_u32(mipmaps.size()) - base_level,
 	                                         layers,
 	                                         VK_IMAGE_TILING_OPTIMAL,
 	                                         flags);
 
-	vk_image_view = std::make_unique<core::ImageView>(*vk_image, image_view_type);
+	vk_image_view = std::make_shared<core::ImageView>(*vk_image, image_view_type);
+}
+
+std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> Image::recreate_vk_image(Device &device, uint32_t base_level_)
+{
+	assert(vk_image && !gpu_mipmaps && layers == 1 && "Only created 2D images with their mipmaps can be recreated");
+
+	std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> previous{std::move(vk_image), std::move(vk_image_view)};
+
+	base_level = base_level_;
+	create_vk_image(device);
+
+	return previous;
+}
+
+void Image::share_vk_image(const std::shared_ptr<core::Image> &image, const std::shared_ptr<core::ImageView> &image_view)
+{
+	assert(!vk_image && !vk_image_view && "Vulkan image already constructed");
+
+	vk_image      = image;
+	vk_image_view = image_view;
+
+	clear_data();
+}
+
+std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> Image::get_shared_vk_image() const
+{
+	return {vk_image, vk_image_view};
+}
+
+size_t Image::get_content_hash() const
+{
+	if (content_hash != 0)
+	{
+		return content_hash;
+	}
+
+	assert(!data.empty() && "The content hash needs the data of the image");
+
+	size_t hash{0};
+	hash_combine(hash, format);
+	hash_combine(hash, layers);
+	hash_combine(hash, base_level);
+
+	for (auto &mipmap : mipmaps)
+	{
+		hash_combine(hash, mipmap.offset);
+		hash_combine(hash, mipmap.extent.width);
+		hash_combine(hash, mipmap.extent.height);
+		hash_combine(hash, mipmap.extent.depth);
+	}
+
+	// Hashes whole words, then the remaining bytes
+	size_t word_count = data.size() / sizeof(uint64_t);
+
+	for (size_t i = 0; i < word_count; ++i)
+	{
+		uint64_t word;
+		std::memcpy(&word, data.data() + i * sizeof(uint64_t), sizeof(uint64_t));
+		hash_combine(hash, word);
+	}
+
+	for (size_t i = word_count * sizeof(uint64_t); i < data.size(); ++i)
+	{
+		hash_combine(hash, data[i]);
+	}
+
+	content_hash = hash;
+
+	return content_hash;
+}
+
+void Image::upload(UploadManager &upload_manager) const
+{
+	// The data of the resident levels is contiguous, as the levels are stored from the finest
+	auto base_offset = mipmaps.at(base_level).offset;
+
+	std::vector<VkBufferImageCopy> copy_regions(gpu_mipmaps ? 1 : mipmaps.size() - base_level);
+
+	for (size_t i = 0; i < copy_regions.size(); ++i)
+	{
+		auto &mipmap      = mipmaps[base_level + i];
+		auto &copy_region = copy_regions[i];
+
+		copy_region.bufferOffset              = mipmap.offset - base_offset;
+		copy_region.imageSubresource          = vk_image_view->get_subresource_layers();
+		copy_region.imageSubresource.mipLevel = to_u32(i);
+		copy_region.imageExtent               = mipmap.extent;
+	}
+
+	if (base_level == 0)
+	{
+		upload_manager.upload_image(*vk_image_view, data, copy_regions, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, gpu_mipmaps);
+	}
+	else
+	{
+		std::vector<uint8_t> level_data{data.begin() + base_offset, data.end()};
+
+		upload_manager.upload_image(*vk_image_view, level_data, copy_regions);
+	}
+}
+
+void Image::set_base_level(uint32_t base_level_)
+{
+	assert(!vk_image && base_level_ < mipmaps.size() && "Base level can only be set before the image is created");
+
+	base_level = base_level_;
+}
+
+uint32_t Image::get_base_level() const
+{
+	return base_level;
+}
+
+size_t Image::get_level_data_size(uint32_t level) const
+{
+	if (data.empty())
+	{
+		return 0;
+	}
+
+	return data.size() - mipmaps.at(level).offset;
 }
 
 const core::Image &Image::get_vk_image() const
@@ -147,6 +278,39 @@ const core::ImageView &Image::get_vk_image_view() const
 	return *vk_image_view;
 }
 
+void Image::reserve_gpu_mipmaps()
+{
+	assert(mipmaps.size() == 1 && !vk_image && "Mipmaps already generated");
+
+	if (mipmaps.size() > 1)
+	{
+		return;
+	}
+
+	auto extent = get_extent();
+
+	while (extent.width > 1 || extent.height > 1)
+	{
+		extent.width  = std::max<uint32_t>(1u, extent.width / 2);
+		extent.height = std::max<uint32_t>(1u, extent.height / 2);
+
+		// The levels have no data to upload
+		Mipmap mipmap{};
+		mipmap.level  = mipmaps.back().level + 1;
+		mipmap.offset = to_u32(data.size());
+		mipmap.extent = extent;
+
+		mipmaps.push_back(mipmap);
+	}
+
+	gpu_mipmaps = mipmaps.size() > 1;
+}
+
+bool Image::has_gpu_mipmaps() const
+{
+	return gpu_mipmaps;
+}
+
 Mipmap &Image::get_mipmap(const size_t index)
 {
 	return mipmaps.at(index);
@@ -244,26 +408,34 @@ void Image::set_offsets(const std::vector<std::vector<VkDeviceSize>> &o)
 	offsets = o;
 }
 
-std::unique_ptr<Image> Image::load(const std::string &name, const std::string &uri)
+std::unique_ptr<Image> Image::load(const std::string &name, const std::string &uri, const Device *device)
 {
 	std::unique_ptr<Image> image{nullptr};
 
-	auto data = fs::read_asset(uri);
+	// Decoders read the mapped file directly, it is unmapped once decoded
+	auto file = fs::map_asset(uri);
+
+	return load(name, uri, file.data(), file.size(), device);
+}
+
+std::unique_ptr<Image> Image::load(const std::string &name, const std::string &uri, const uint8_t *data, size_t size, const Device *device)
+{
+	std::unique_ptr<Image> image{nullptr};
 
 	// Get extension
 	auto extension = get_extension(uri);
 
 	if (extension == "png" || extension == "jpg")
 	{
-		image = std::make_unique<Stb>(name, data);
+		image = std::make_unique<Stb>(name, data, size);
 	}
 	else if (extension == "astc")
 	{
-		image = std::make_unique<Astc>(name, data);
+		image = std::make_unique<Astc>(name, data, size);
 	}
-	else if (extension == "ktx")
+	else if (extension == "ktx" || extension == "ktx2")
 	{
-		image = std::make_unique<Ktx>(name, data);
+		image = std::make_unique<Ktx>(name, data, size, device);
 	}
 
 	return image;
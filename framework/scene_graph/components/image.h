@@ -30,6 +30,8 @@
 
 namespace vkb
 {
+class UploadManager;
+
 namespace sg
 {
 /**
@@ -58,7 +60,16 @@ class Image : public Component
   public:
 	Image(const std::string &name, std::vector<uint8_t> &&data = {}, std::vector<Mipmap> &&mipmaps = {{}});
 
-	static std::unique_ptr<Image> load(const std::string &name, const std::string &uri);
+	/**
+	 * @brief Loads an image from a png, jpg, astc, ktx or ktx2 asset
+	 * @param device Optional device, whose supported formats supercompressed KTX2 textures are transcoded to
+	 */
+	static std::unique_ptr<Image> load(const std::string &name, const std::string &uri, const Device *device = nullptr);
+
+	/**
+	 * @brief Decodes an image from the content of a png, jpg, astc, ktx or ktx2 file already read, whose format is given by the extension of its uri
+	 */
+	static std::unique_ptr<Image> load(const std::string &name, const std::string &uri, const uint8_t *data, size_t size, const Device *device = nullptr);
 
 	virtual ~Image() = default;
 
@@ -80,8 +91,61 @@ class Image : public Component
 
 	void generate_mipmaps();
 
+	/**
+	 * @brief Adds the mip chain of a single level image without data, the levels are blitted from the first one once it is uploaded
+	 *        Must be called before create_vk_image(), and only for formats supporting blits and linear filtering
+	 */
+	void reserve_gpu_mipmaps();
+
+	/**
+	 * @return Whether the levels after the first are generated on the GPU, only the first level has data
+	 */
+	bool has_gpu_mipmaps() const;
+
+	/**
+	 * @brief Creates the Vulkan image with the levels from the base level on
+	 */
 	void create_vk_image(Device &device, VkImageViewType image_view_type = VK_IMAGE_VIEW_TYPE_2D, VkImageCreateFlags flags = 0);
 
+	/**
+	 * @brief Recreates the Vulkan image of a 2D image with the levels from another base level on, with undefined content
+	 * @return The previous image and view, to be destroyed once the GPU no longer uses them
+	 */
+	std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> recreate_vk_image(Device &device, uint32_t base_level);
+
+	/**
+	 * @brief Uses the Vulkan image of another image with the same content, then drops the data
+	 */
+	void share_vk_image(const std::shared_ptr<core::Image> &image, const std::shared_ptr<core::ImageView> &image_view);
+
+	/**
+	 * @return The Vulkan image and view, to be shared with images with the same content
+	 */
+	std::pair<std::shared_ptr<core::Image>, std::shared_ptr<core::ImageView>> get_shared_vk_image() const;
+
+	/**
+	 * @return Hash of the data, format and layout of the image, computed on the first call while the image has its data
+	 */
+	size_t get_content_hash() const;
+
+	/**
+	 * @brief Uploads the data of the levels of the Vulkan image, generating them from the first one if they have no data
+	 */
+	void upload(UploadManager &upload_manager) const;
+
+	/**
+	 * @brief Sets the first level of the Vulkan image, the finer levels are not resident
+	 *        Must be called before create_vk_image().
+	 */
+	void set_base_level(uint32_t base_level);
+
+	uint32_t get_base_level() const;
+
+	/**
+	 * @return Size in bytes of the data of the levels from a base level on
+	 */
+	size_t get_level_data_size(uint32_t base_level) const;
+
 	const core::Image &get_vk_image() const;
 
 	const core::ImageView &get_vk_image_view() const;
@@ -116,12 +180,19 @@ class Image : public Component
 
 	std::vector<Mipmap> mipmaps{{}};
 
+	bool gpu_mipmaps{false};
+
+	uint32_t base_level{0};
+
 	// Offsets stored like offsets[array_layer][mipmap_layer]
 	std::vector<std::vector<VkDeviceSize>> offsets;
 
-	std::unique_ptr<core::Image> vk_image;
+	/// Shared by the images with the same content, see AssetCache
+	std::shared_ptr<core::Image> vk_image;
+
+	std::shared_ptr<core::ImageView> vk_image_view;
 
-	std::unique_ptr<core::ImageView> vk_image_view;
+	mutable size_t content_hash{0};
 };
 
 }        // namespace sg
@@ -20,8 +20,12 @@
 #include <mutex>
 
 #include "common/error.h"
+#include "job_system.h"
 
 VKBP_DISABLE_WARNINGS()
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
 #include "common/glm_common.h"
 #if defined(_WIN32) || defined(_WIN64)
 // Windows.h defines IGNORE, so we must #undef it to avoid clashes with astc header
@@ -36,6 +40,27 @@ namespace vkb
 {
 namespace sg
 {
+namespace
+{
+/// Rows of blocks decoded or compressed by each job
+constexpr uint32_t ROWS_PER_JOB = 4;
+
+/**
+ * @brief Runs func over chunks of [0, count) on the job system, or serially without one
+ */
+void for_each_row(JobSystem *job_system, uint32_t count, const std::function<void(uint32_t, uint32_t)> &func)
+{
+	if (job_system)
+	{
+		job_system->parallel_for(0, count, ROWS_PER_JOB, func);
+	}
+	else
+	{
+		func(0, count);
+	}
+}
+}        // namespace
+
 BlockDim to_blockdim(const VkFormat format)
 {
 	switch (format)
@@ -113,7 +138,7 @@ void Astc::init()
 	}
 }
 
-void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
+void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_, JobSystem *job_system)
 {
 	// Actual decoding
 	astc_decode_mode decode_mode = DECODE_LDR_SRGB;
@@ -147,11 +172,15 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 	auto astc_image = allocate_image(bitness, xsize, ysize, zsize, 0);
 	initialize_image(astc_image);
 
-	imageblock pb;
-	for (int z = 0; z < zblocks; z++)
-	{
-		for (int y = 0; y < yblocks; y++)
+	// Rows of blocks write disjoint texels, each job decodes in its own scratch block
+	for_each_row(job_system, to_u32(zblocks * yblocks), [&](uint32_t begin, uint32_t end) {
+		imageblock pb;
+
+		for (uint32_t row = begin; row < end; row++)
 		{
+			int z = static_cast<int>(row) / yblocks;
+			int y = static_cast<int>(row) % yblocks;
+
 			for (int x = 0; x < xblocks; x++)
 			{
 				int            offset = (((z * yblocks + y) * xblocks) + x) * 16;
@@ -165,7 +194,7 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 				write_imageblock(astc_image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
 			}
 		}
-	}
+	});
 
 	set_data(astc_image->imagedata8[0][0], astc_image->xsize * astc_image->ysize * astc_image->zsize * 4);
 	set_format(VK_FORMAT_R8G8B8A8_SRGB);
@@ -176,25 +205,25 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 	destroy_image(astc_image);
 }
 
-Astc::Astc(const Image &image) :
+Astc::Astc(const Image &image, JobSystem *job_system) :
     Image{image.get_name()}
 {
 	init();
-	decode(to_blockdim(image.get_format()), image.get_extent(), image.get_data().data());
+	decode(to_blockdim(image.get_format()), image.get_extent(), image.get_data().data(), job_system);
 }
 
-Astc::Astc(const std::string &name, const std::vector<uint8_t> &data) :
+Astc::Astc(const std::string &name, const uint8_t *data, size_t size, JobSystem *job_system) :
     Image{name}
 {
 	init();
 
 	// Read header
-	if (data.size() < sizeof(AstcHeader))
+	if (size < sizeof(AstcHeader))
 	{
 		throw std::runtime_error{"Error reading astc: invalid memory"};
 	}
 	AstcHeader header{};
-	std::memcpy(&header, data.data(), sizeof(AstcHeader));
+	std::memcpy(&header, data, sizeof(AstcHeader));
 	uint32_t magicval = header.magic[0] + 256 * static_cast<uint32_t>(header.magic[1]) + 65536 * static_cast<uint32_t>(header.magic[2]) + 16777216 * static_cast<uint32_t>(header.magic[3]);
 	if (magicval != MAGIC_FILE_CONSTANT)
 	{
@@ -211,7 +240,84 @@ Astc::Astc(const std::string &name, const std::vector<uint8_t> &data) :
 	    /* height = */ static_cast<uint32_t>(header.ysize[0] + 256 * header.ysize[1] + 65536 * header.ysize[2]),
 	    /* depth  = */ static_cast<uint32_t>(header.zsize[0] + 256 * header.zsize[1] + 65536 * header.zsize[2])};
 
-	decode(blockdim, extent, data.data() + sizeof(AstcHeader));
+	decode(blockdim, extent, data + sizeof(AstcHeader), job_system);
+}
+
+void Astc::compress_to_bc(JobSystem *job_system)
+{
+	assert(get_format() == VK_FORMAT_R8G8B8A8_SRGB && get_extent().depth == 1 && "Only decoded 2D images can be compressed");
+
+	if (get_mipmaps().size() == 1)
+	{
+		generate_mipmaps();
+	}
+
+	auto &texels = get_data();
+
+	bool translucent = false;
+	for (size_t i = 3; i < texels.size(); i += 4)
+	{
+		if (texels[i] != 255)
+		{
+			translucent = true;
+			break;
+		}
+	}
+
+	// BC3 adds an alpha block in front of each BC1 block
+	uint32_t block_size = translucent ? 16 : 8;
+
+	std::vector<Mipmap> compressed_mipmaps = get_mipmaps();
+
+	uint32_t compressed_size = 0;
+	for (auto &mipmap : compressed_mipmaps)
+	{
+		mipmap.offset = compressed_size;
+		compressed_size += ((mipmap.extent.width + 3) / 4) * ((mipmap.extent.height + 3) / 4) * block_size;
+	}
+
+	std::vector<uint8_t> compressed(compressed_size);
+
+	for (size_t level = 0; level < compressed_mipmaps.size(); ++level)
+	{
+		auto &mipmap = get_mipmaps()[level];
+
+		uint32_t width   = mipmap.extent.width;
+		uint32_t height  = mipmap.extent.height;
+		uint32_t xblocks = (width + 3) / 4;
+		uint32_t yblocks = (height + 3) / 4;
+
+		const uint8_t *src = texels.data() + mipmap.offset;
+		uint8_t *      dst = compressed.data() + compressed_mipmaps[level].offset;
+
+		for_each_row(job_system, yblocks, [&](uint32_t begin, uint32_t end) {
+			uint8_t block[4 * 4 * 4];
+
+			for (uint32_t y = begin; y < end; ++y)
+			{
+				for (uint32_t x = 0; x < xblocks; ++x)
+				{
+					// Blocks crossing the edges of the level repeat its last texels
+					for (uint32_t j = 0; j < 4; ++j)
+					{
+						for (uint32_t i = 0; i < 4; ++i)
+						{
+							uint32_t src_x = std::min(x * 4 + i, width - 1);
+							uint32_t src_y = std::min(y * 4 + j, height - 1);
+
+							std::memcpy(block + (j * 4 + i) * 4, src + (src_y * width + src_x) * 4, 4);
+						}
+					}
+
+					stb_compress_dxt_block(dst + (y * xblocks + x) * block_size, block, translucent ? 1 : 0, STB_DXT_HIGHQUAL);
+				}
+			}
+		});
+	}
+
+	get_mut_data() = std::move(compressed);
+	get_mut_mipmaps() = std::move(compressed_mipmaps);
+	set_format(translucent ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK);
 }
 
 }        // namespace sg
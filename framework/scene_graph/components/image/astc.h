@@ -22,6 +22,8 @@
 
 namespace vkb
 {
+class JobSystem;
+
 namespace sg
 {
 struct BlockDim
@@ -37,26 +39,38 @@ class Astc : public Image
 	/**
 	 * @brief Decodes an ASTC image
 	 * @param image Image to decode
+	 * @param job_system Optional job system decoding the rows of blocks in parallel
 	 */
-	Astc(const Image &image);
+	Astc(const Image &image, JobSystem *job_system = nullptr);
 
 	/**
 	 * @brief Decodes ASTC data with an ASTC header
 	 * @param name Name of the component
 	 * @param data ASTC data with header
+	 * @param size Size of the data in bytes
+	 * @param job_system Optional job system decoding the rows of blocks in parallel
 	 */
-	Astc(const std::string &name, const std::vector<uint8_t> &data);
+	Astc(const std::string &name, const uint8_t *data, size_t size, JobSystem *job_system = nullptr);
 
 	virtual ~Astc() = default;
 
+	/**
+	 * @brief Compresses the decoded image and its mipmaps to BC1, or to BC3 if any texel is translucent,
+	 *        so that it takes a quarter or an eighth of the memory of the decoded texels
+	 *        A single level image gets its mipmaps generated first, as compressed formats cannot be blitted.
+	 * @param job_system Optional job system compressing the rows of blocks in parallel
+	 */
+	void compress_to_bc(JobSystem *job_system = nullptr);
+
   private:
 	/**
 	 * @brief Decodes ASTC data
 	 * @param blockdim Dimensions of the block
 	 * @param extent Extent of the image
 	 * @param data Pointer to ASTC image data
+	 * @param job_system Optional job system decoding the rows of blocks in parallel
 	 */
-	void decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data);
+	void decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data, JobSystem *job_system);
 
 	/**
 	 * @brief Initializes ASTC library
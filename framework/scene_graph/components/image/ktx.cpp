@@ -19,6 +19,8 @@
 #include "scene_graph/components/image/ktx.h"
 
 #include "common/error.h"
+#include "common/logging.h"
+#include "core/device.h"
 
 VKBP_DISABLE_WARNINGS()
 #include <ktx.h>
@@ -61,11 +63,38 @@ static KTX_error_code KTXAPIENTRY optimal_tiling_callback(int mip_level,
 	return KTX_SUCCESS;
 }
 
-Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
+/**
+ * @brief Chooses the format a Basis Universal texture is transcoded to, the best block compressed format sampled by the device
+ */
+static ktx_transcode_fmt_e choose_transcode_format(const Device *device)
+{
+	if (device)
+	{
+		// The sRGB variants are supported along with the UNORM ones
+		if (device->is_image_format_supported(VK_FORMAT_ASTC_4x4_UNORM_BLOCK))
+		{
+			return KTX_TTF_ASTC_4x4_RGBA;
+		}
+
+		if (device->is_image_format_supported(VK_FORMAT_BC7_UNORM_BLOCK))
+		{
+			return KTX_TTF_BC7_RGBA;
+		}
+
+		if (device->is_image_format_supported(VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK))
+		{
+			return KTX_TTF_ETC2_RGBA;
+		}
+	}
+
+	return KTX_TTF_RGBA32;
+}
+
+Ktx::Ktx(const std::string &name, const uint8_t *data, size_t size, const Device *device) :
     Image{name}
 {
-	auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data.data());
-	auto data_size   = static_cast<ktx_size_t>(data.size());
+	auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data);
+	auto data_size   = static_cast<ktx_size_t>(size);
 
 	ktxTexture *texture;
 	auto        load_ktx_result = ktxTexture_CreateFromMemory(data_buffer,
@@ -77,6 +106,21 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 		throw std::runtime_error{"Error loading KTX texture: " + name};
 	}
 
+	if (texture->classId == ktxTexture2_c && ktxTexture2_NeedsTranscoding(reinterpret_cast<ktxTexture2 *>(texture)))
+	{
+		auto transcode_format = choose_transcode_format(device);
+
+		// Transcodes in the image data owned by the texture, along with the format and level sizes
+		auto transcode_result = ktxTexture2_TranscodeBasis(reinterpret_cast<ktxTexture2 *>(texture), transcode_format, 0);
+		if (transcode_result != KTX_SUCCESS)
+		{
+			ktxTexture_Destroy(texture);
+			throw std::runtime_error{"Error transcoding KTX texture: " + name};
+		}
+
+		LOGI("Transcoded {} to {}", name, ktxTranscodeFormatString(transcode_format));
+	}
+
 	if (texture->pData)
 	{
 		// Already loaded
@@ -111,8 +155,14 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 	}
 
 	// Update format
-	auto updated_format = vkGetFormatFromOpenGLInternalFormat(texture->glInternalformat);
-	set_format(updated_format);
+	if (texture->classId == ktxTexture2_c)
+	{
+		set_format(static_cast<VkFormat>(reinterpret_cast<ktxTexture2 *>(texture)->vkFormat));
+	}
+	else
+	{
+		set_format(vkGetFormatFromOpenGLInternalFormat(reinterpret_cast<ktxTexture1 *>(texture)->glInternalformat));
+	}
 
 	// Update mip levels
 	auto &mipmap_levels = get_mut_mipmaps();
@@ -27,7 +27,15 @@ namespace sg
 class Ktx : public Image
 {
   public:
-	Ktx(const std::string &name, const std::vector<uint8_t> &data);
+	/**
+	 * @brief Loads a KTX1 or KTX2 texture
+	 * @param name Name of the component
+	 * @param data KTX data
+	 * @param size Size of the data in bytes
+	 * @param device Optional device, whose supported block compressed formats Basis Universal textures are transcoded to,
+	 *        in order ASTC, BC7 and ETC2. Without one, or without support, they are transcoded to RGBA8.
+	 */
+	Ktx(const std::string &name, const uint8_t *data, size_t size, const Device *device = nullptr);
 
 	virtual ~Ktx() = default;
 };
@@ -27,7 +27,14 @@ Mesh::Mesh(const std::string &name) :
 
 void Mesh::update_bounds(const std::vector<glm::vec3> &vertex_data, const std::vector<uint16_t> &index_data)
 {
-	bounds.update(vertex_data, index_data);
+	if (index_data.empty())
+	{
+		bounds.update(vertex_data.data(), vertex_data.size());
+	}
+	else
+	{
+		bounds.update(vertex_data.data(), index_data.data(), index_data.size());
+	}
 }
 
 std::type_index Mesh::get_type()
@@ -35,6 +42,12 @@ std::type_index Mesh::get_type()
 	return typeid(Mesh);
 }
 
+void Mesh::update_bounds(const AABB &submesh_bounds)
+{
+	bounds.update(submesh_bounds.get_min());
+	bounds.update(submesh_bounds.get_max());
+}
+
 const AABB &Mesh::get_bounds() const
 {
 	return bounds;
@@ -59,5 +72,15 @@ const std::vector<Node *> &Mesh::get_nodes() const
 {
 	return nodes;
 }
+
+void Mesh::set_morph_weights(const float *weights, size_t count)
+{
+	morph_weights.assign(weights, weights + count);
+}
+
+const std::vector<float> &Mesh::get_morph_weights() const
+{
+	return morph_weights;
+}
 }        // namespace sg
 }        // namespace vkb
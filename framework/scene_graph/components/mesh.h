@@ -40,6 +40,11 @@ class Mesh : public Component
 
 	void update_bounds(const std::vector<glm::vec3> &vertex_data, const std::vector<uint16_t> &index_data = {});
 
+	/**
+	 * @brief Grows the bounds to contain a box, e.g. the bounds of a submesh known without its vertices
+	 */
+	void update_bounds(const AABB &submesh_bounds);
+
 	virtual std::type_index get_type() override;
 
 	const AABB &get_bounds() const;
@@ -52,12 +57,21 @@ class Mesh : public Component
 
 	const std::vector<Node *> &get_nodes() const;
 
+	/**
+	 * @brief Sets the weights of the morph targets of the submeshes, one per target
+	 */
+	void set_morph_weights(const float *weights, size_t count);
+
+	const std::vector<float> &get_morph_weights() const;
+
   private:
 	AABB bounds;
 
 	std::vector<SubMesh *> submeshes;
 
 	std::vector<Node *> nodes;
+
+	std::vector<float> morph_weights;
 };
 }        // namespace sg
 }        // namespace vkb
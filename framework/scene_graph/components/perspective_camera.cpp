@@ -70,6 +70,27 @@ float PerspectiveCamera::get_aspect_ratio()
 }
 
 glm::mat4 PerspectiveCamera::get_projection()
+{
+	if (jitter.x == 0.0f && jitter.y == 0.0f)
+	{
+		return get_unjittered_projection();
+	}
+
+	// Translated in clip space, so every depth is offset by the same amount in normalized device coordinates
+	return glm::translate(glm::mat4(1.0f), glm::vec3(jitter, 0.0f)) * get_unjittered_projection();
+}
+
+void PerspectiveCamera::set_jitter(const glm::vec2 &new_jitter)
+{
+	jitter = new_jitter;
+}
+
+const glm::vec2 &PerspectiveCamera::get_jitter() const
+{
+	return jitter;
+}
+
+glm::mat4 PerspectiveCamera::get_unjittered_projection() const
 {
 	// Note: Using Revsered depth-buffer for increased precision, so Znear and Zfar are flipped
 	return glm::perspective(fov, aspect_ratio, far_plane, near_plane);
@@ -60,6 +60,20 @@ class PerspectiveCamera : public Camera
 
 	virtual glm::mat4 get_projection() override;
 
+	/**
+	 * @brief Offsets the projection by a fraction of a pixel, so successive frames sample different
+	 *        positions within each pixel, as temporal anti-aliasing needs
+	 * @param jitter Offset in normalized device coordinates, zero to disable
+	 */
+	void set_jitter(const glm::vec2 &jitter);
+
+	const glm::vec2 &get_jitter() const;
+
+	/**
+	 * @return The projection without the jitter, which motion vectors are computed with
+	 */
+	glm::mat4 get_unjittered_projection() const;
+
   private:
 	/**
 	 * @brief Screen size aspect ratio
@@ -74,6 +88,8 @@ class PerspectiveCamera : public Camera
 	float far_plane{100.0};
 
 	float near_plane{0.1f};
+
+	glm::vec2 jitter{0.0f, 0.0f};
 };
 }        // namespace sg
 }        // namespace vkb
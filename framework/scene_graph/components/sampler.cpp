@@ -23,7 +23,13 @@ namespace sg
 {
 Sampler::Sampler(const std::string &name, core::Sampler &&vk_sampler) :
     Component{name},
-    vk_sampler{std::move(vk_sampler)}
+    owned_vk_sampler{std::make_unique<core::Sampler>(std::move(vk_sampler))},
+    vk_sampler{*owned_vk_sampler}
+{}
+
+Sampler::Sampler(const std::string &name, const core::Sampler &shared_vk_sampler) :
+    Component{name},
+    vk_sampler{shared_vk_sampler}
 {}
 
 std::type_index Sampler::get_type()
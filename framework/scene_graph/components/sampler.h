@@ -34,13 +34,22 @@ class Sampler : public Component
   public:
 	Sampler(const std::string &name, core::Sampler &&vk_sampler);
 
+	/**
+	 * @brief Refers to a sampler owned elsewhere, such as a sampler of the AssetCache
+	 */
+	Sampler(const std::string &name, const core::Sampler &shared_vk_sampler);
+
 	Sampler(Sampler &&other) = default;
 
 	virtual ~Sampler() = default;
 
 	virtual std::type_index get_type() override;
 
-	core::Sampler vk_sampler;
+  private:
+	std::unique_ptr<core::Sampler> owned_vk_sampler;
+
+  public:
+	const core::Sampler &vk_sampler;
 };
 }        // namespace sg
 }        // namespace vkb
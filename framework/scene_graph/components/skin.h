@@ -0,0 +1,75 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+
+/**
+ * @brief The joints deforming the vertices of a skinned mesh, set on the nodes drawing it
+ *
+ * Vertices reference joints by their index in the skin, through their joints_0 and weights_0 attributes.
+ */
+class Skin : public Component
+{
+  public:
+	Skin(const std::string &name);
+
+	virtual ~Skin() = default;
+
+	virtual std::type_index get_type() override;
+
+	/**
+	 * @param joints The nodes of the joints
+	 * @param inverse_bind_matrices Matrices moving the vertices from the bind pose to the space of each joint,
+	 *        identities when empty
+	 */
+	void set_joints(const std::vector<Node *> &joints, const std::vector<glm::mat4> &inverse_bind_matrices);
+
+	const std::vector<Node *> &get_joints() const;
+
+	/**
+	 * @brief Computes the matrices moving the vertices of the bind pose to their pose, in the space of the node drawing the mesh
+	 *        The world matrices of the joints and the node must be up to date.
+	 * @param node The node drawing the skinned mesh
+	 * @param[out] joint_matrices A matrix per joint
+	 */
+	void compute_joint_matrices(Node &node, std::vector<glm::mat4> &joint_matrices) const;
+
+  private:
+	std::vector<Node *> joints;
+
+	std::vector<glm::mat4> inverse_bind_matrices;
+};
+}        // namespace sg
+}        // namespace vkb
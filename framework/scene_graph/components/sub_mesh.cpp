@@ -17,6 +17,7 @@
 
 #include "sub_mesh.h"
 
+#include "geometry_arena.h"
 #include "material.h"
 #include "rendering/subpass.h"
 
@@ -29,6 +30,56 @@ std::type_index SubMesh::get_type()
 	return typeid(SubMesh);
 }
 
+bool SubMesh::get_vertex_buffer(const std::string &name, const core::Buffer *&buffer, VkDeviceSize &offset) const
+{
+	if (vertex_arena)
+	{
+		auto offset_it = vertex_arena_offsets.find(name);
+
+		if (offset_it == vertex_arena_offsets.end())
+		{
+			return false;
+		}
+
+		buffer = &vertex_arena->buffer;
+		offset = offset_it->second;
+
+		return true;
+	}
+
+	auto buffer_it = vertex_buffers.find(name);
+
+	if (buffer_it == vertex_buffers.end())
+	{
+		return false;
+	}
+
+	buffer = &buffer_it->second;
+	offset = 0;
+
+	return true;
+}
+
+const core::Buffer &SubMesh::get_index_buffer() const
+{
+	if (index_arena)
+	{
+		return index_arena->buffer;
+	}
+
+	assert(index_buffer && "Submesh has no index buffer");
+
+	return *index_buffer;
+}
+
+bool SubMesh::has_geometry() const
+{
+	bool has_vertices = vertex_arena || !vertex_buffers.empty();
+	bool has_indices  = vertex_indices == 0 || index_arena || index_buffer;
+
+	return has_vertices && has_indices;
+}
+
 void SubMesh::set_attribute(const std::string &attribute_name, const VertexAttribute &attribute)
 {
 	vertex_attributes[attribute_name] = attribute;
@@ -32,6 +32,7 @@ namespace vkb
 {
 namespace sg
 {
+class GeometryArena;
 class Material;
 
 struct VertexAttribute
@@ -43,6 +44,20 @@ struct VertexAttribute
 	std::uint32_t offset = 0;
 };
 
+/**
+ * @brief A range of the index buffer of a submesh drawing it at a lower level of detail
+ */
+struct SubMeshLod
+{
+	/// Index of the first index of the level, in the index buffer of the submesh
+	std::uint32_t first_index = 0;
+
+	std::uint32_t index_count = 0;
+
+	/// Projected diameter of the bounding sphere, as a fraction of the screen height, under which the level is drawn
+	float max_screen_size = 0.0f;
+};
+
 class SubMesh : public Component
 {
   public:
@@ -62,6 +77,55 @@ class SubMesh : public Component
 
 	std::unique_ptr<core::Buffer> index_buffer;
 
+	/// Arena holding the vertex data, used instead of vertex_buffers when set
+	const GeometryArena *vertex_arena{nullptr};
+
+	/// Offsets of the attributes in the vertex arena, by attribute name
+	std::unordered_map<std::string, VkDeviceSize> vertex_arena_offsets;
+
+	/// Arena holding the indices, used instead of index_buffer when set
+	const GeometryArena *index_arena{nullptr};
+
+	/// Index of the first index of the submesh, in the index buffer bound at index_offset
+	std::uint32_t first_index = 0;
+
+	/// Lower levels of detail of an indexed submesh, from the most to the least detailed
+	std::vector<SubMeshLod> lods;
+
+	/// Meshlets of the full detail triangle list followed by their vertex and triangle lists, see build_meshlets()
+	std::unique_ptr<core::Buffer> meshlet_buffer;
+
+	std::uint32_t meshlet_count = 0;
+
+	/// Offsets of the vertex and triangle lists of the meshlets in the meshlet buffer
+	VkDeviceSize meshlet_vertices_offset = 0;
+
+	VkDeviceSize meshlet_triangles_offset = 0;
+
+	/// Position and normal offsets of the morph targets for each vertex, target after target, see GpuSkinning
+	std::unique_ptr<core::Buffer> morph_target_buffer;
+
+	std::uint32_t morph_target_count = 0;
+
+	/**
+	 * @brief Finds the buffer holding an attribute, in the vertex arena or in vertex_buffers
+	 * @param name Name of the attribute
+	 * @param[out] buffer The buffer holding the attribute
+	 * @param[out] offset The offset of the attribute in the buffer
+	 * @return Whether the submesh has data for the attribute
+	 */
+	bool get_vertex_buffer(const std::string &name, const core::Buffer *&buffer, VkDeviceSize &offset) const;
+
+	/**
+	 * @return The buffer holding the indices, from the index arena or index_buffer
+	 */
+	const core::Buffer &get_index_buffer() const;
+
+	/**
+	 * @return Whether the vertex and index data of the submesh is in buffers, false while it is streamed
+	 */
+	bool has_geometry() const;
+
 	void set_attribute(const std::string &name, const VertexAttribute &attribute);
 
 	bool get_attribute(const std::string &name, VertexAttribute &attribute) const;
@@ -108,6 +108,27 @@ void Transform::invalidate_world_matrix()
 	update_world_matrix = true;
 }
 
+bool Transform::has_local_changes() const
+{
+	return update_world_matrix;
+}
+
+void Transform::set_world_matrix(const glm::mat4 &new_world_matrix)
+{
+	previous_world_matrix = has_world_matrix ? world_matrix : new_world_matrix;
+
+	world_matrix = new_world_matrix;
+
+	has_world_matrix = true;
+
+	update_world_matrix = false;
+}
+
+const glm::mat4 &Transform::get_previous_world_matrix() const
+{
+	return previous_world_matrix;
+}
+
 void Transform::update_world_transform()
 {
 	if (!update_world_matrix)
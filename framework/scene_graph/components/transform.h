@@ -73,6 +73,22 @@ class Transform : public Component
 	 */
 	void invalidate_world_matrix();
 
+	/**
+	 * @return Whether the local transform changed since the world matrix was last computed
+	 */
+	bool has_local_changes() const;
+
+	/**
+	 * @brief Stores a world matrix computed from the local transform and the parent world matrix,
+	 *        as done by the TransformHierarchy of the scene
+	 */
+	void set_world_matrix(const glm::mat4 &world_matrix);
+
+	/**
+	 * @return The world matrix before the last update of the TransformHierarchy, to compute the motion of the node
+	 */
+	const glm::mat4 &get_previous_world_matrix() const;
+
   private:
 	Node &node;
 
@@ -84,6 +100,11 @@ class Transform : public Component
 
 	glm::mat4 world_matrix = glm::mat4(1.0);
 
+	glm::mat4 previous_world_matrix = glm::mat4(1.0);
+
+	/// Whether the world matrix was set, so the first one has no motion
+	bool has_world_matrix = false;
+
 	bool update_world_matrix = false;
 
 	void update_world_transform();
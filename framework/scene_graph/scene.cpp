@@ -20,9 +20,14 @@
 #include <queue>
 
 #include "common/error.h"
+#include "common/logging.h"
 #include "component.h"
+#include "components/animation.h"
+#include "components/material.h"
 #include "components/sub_mesh.h"
+#include "components/mesh.h"
 #include "node.h"
+#include "timer.h"
 
 namespace vkb
 {
@@ -46,21 +51,42 @@ void Scene::set_nodes(std::vector<std::unique_ptr<Node>> &&n)
 {
 	assert(nodes.empty() && "Scene nodes were already set");
 	nodes = std::move(n);
+
+	rebuild_hierarchy = true;
+
+	invalidate_node_indices();
+
+	change_journal.reset();
 }
 
 void Scene::add_node(std::unique_ptr<Node> &&n)
 {
 	nodes.emplace_back(std::move(n));
+
+	rebuild_hierarchy = true;
+
+	invalidate_node_indices();
+
+	change_journal.reset();
 }
 
 void Scene::add_child(Node &child)
 {
 	root->add_child(child);
+
+	rebuild_hierarchy = true;
+
+	invalidate_node_indices();
+
+	change_journal.reset();
 }
 
 std::unique_ptr<Component> Scene::get_model(uint32_t index)
 {
-	auto meshes = std::move(components.at(typeid(SubMesh)));
+	auto &pool = component_pools.at(typeid(SubMesh));
+
+	auto meshes = std::move(pool.owned);
+	pool.components.clear();
 
 	return std::move(meshes.at(index));
 }
@@ -71,7 +97,7 @@ void Scene::add_component(std::unique_ptr<Component> &&component, Node &node)
 
 	if (component)
 	{
-		components[component->get_type()].push_back(std::move(component));
+		add_to_pool(component->get_type(), std::move(component));
 	}
 }
 
@@ -79,61 +105,290 @@ void Scene::add_component(std::unique_ptr<Component> &&component)
 {
 	if (component)
 	{
-		components[component->get_type()].push_back(std::move(component));
+		add_to_pool(component->get_type(), std::move(component));
 	}
 }
 
 void Scene::set_components(const std::type_index &type_info, std::vector<std::unique_ptr<Component>> &&new_components)
 {
-	components[type_info] = std::move(new_components);
+	auto &pool = component_pools[type_info];
+
+	if (type_info == typeid(Mesh))
+	{
+		for (auto &component : pool.owned)
+		{
+			change_journal.record(ChangeType::MeshRemoved, nullptr, component.get());
+		}
+		for (auto &component : new_components)
+		{
+			change_journal.record(ChangeType::MeshAdded, nullptr, component.get());
+		}
+	}
+
+	pool.owned = std::move(new_components);
+	++pool.revision;
+
+	if (type_info == typeid(Animation))
+	{
+		rebuild_animations = true;
+	}
+
+	pool.components.resize(pool.owned.size());
+	std::transform(pool.owned.begin(), pool.owned.end(), pool.components.begin(),
+	               [](const std::unique_ptr<Component> &component) { return component.get(); });
 }
 
 const std::vector<std::unique_ptr<Component>> &Scene::get_components(const std::type_index &type_info) const
 {
-	return components.at(type_info);
+	return component_pools.at(type_info).owned;
 }
 
 bool Scene::has_component(const std::type_index &type_info) const
 {
-	auto component = components.find(type_info);
-	return (component != components.end() && !component->second.empty());
+	auto pool_it = component_pools.find(type_info);
+	return (pool_it != component_pools.end() && !pool_it->second.owned.empty());
+}
+
+void Scene::add_to_pool(const std::type_index &type_info, std::unique_ptr<Component> &&component)
+{
+	auto &pool = component_pools[type_info];
+
+	pool.components.push_back(component.get());
+	pool.owned.push_back(std::move(component));
+	++pool.revision;
+
+	if (type_info == typeid(Mesh))
+	{
+		change_journal.record(ChangeType::MeshAdded, nullptr, pool.components.back());
+	}
+
+	if (type_info == typeid(Animation))
+	{
+		rebuild_animations = true;
+	}
+}
+
+uint64_t Scene::get_component_revision(const std::type_index &type_info) const
+{
+	auto pool_it = component_pools.find(type_info);
+	return pool_it == component_pools.end() ? 0 : pool_it->second.revision;
+}
+
+void Scene::invalidate_node_indices()
+{
+	rebuild_name_index = true;
+
+	rebuild_path_index = true;
 }
 
 Node *Scene::find_node(const std::string &node_name)
 {
-	for (auto root_node : root->get_children())
+	if (!root)
 	{
-		std::queue<sg::Node *> traverse_nodes{};
-		traverse_nodes.push(root_node);
+		return nullptr;
+	}
 
-		while (!traverse_nodes.empty())
+	if (rebuild_name_index)
+	{
+		nodes_by_name.clear();
+		nodes_by_name.reserve(nodes.size());
+
+		// Breadth first from each child of the root in turn, a name keeps the first node reaching it
+		for (auto root_node : root->get_children())
 		{
-			auto node = traverse_nodes.front();
-			traverse_nodes.pop();
+			std::queue<sg::Node *> traverse_nodes{};
+			traverse_nodes.push(root_node);
 
-			if (node->get_name() == node_name)
+			while (!traverse_nodes.empty())
 			{
-				return node;
+				auto node = traverse_nodes.front();
+				traverse_nodes.pop();
+
+				nodes_by_name.emplace(node->get_name(), node);
+
+				for (auto child_node : node->get_children())
+				{
+					traverse_nodes.push(child_node);
+				}
 			}
+		}
+
+		rebuild_name_index = false;
+	}
+
+	auto it = nodes_by_name.find(node_name);
+
+	return it != nodes_by_name.end() ? it->second : nullptr;
+}
+
+Node *Scene::find_node_by_path(const std::string &path)
+{
+	if (!root)
+	{
+		return nullptr;
+	}
+
+	if (rebuild_path_index)
+	{
+		nodes_by_path.clear();
+		nodes_by_path.reserve(nodes.size());
+
+		std::queue<std::pair<sg::Node *, std::string>> traverse_nodes{};
+		for (auto root_node : root->get_children())
+		{
+			traverse_nodes.emplace(root_node, root_node->get_name());
+		}
+
+		while (!traverse_nodes.empty())
+		{
+			auto node      = traverse_nodes.front().first;
+			auto node_path = std::move(traverse_nodes.front().second);
+			traverse_nodes.pop();
 
 			for (auto child_node : node->get_children())
 			{
-				traverse_nodes.push(child_node);
+				traverse_nodes.emplace(child_node, node_path + "/" + child_node->get_name());
 			}
+
+			nodes_by_path.emplace(std::move(node_path), node);
 		}
+
+		rebuild_path_index = false;
 	}
 
-	return nullptr;
+	auto it = nodes_by_path.find(path);
+
+	return it != nodes_by_path.end() ? it->second : nullptr;
 }
 
 void Scene::set_root_node(Node &node)
 {
 	root = &node;
+
+	rebuild_hierarchy = true;
+
+	invalidate_node_indices();
+
+	change_journal.reset();
 }
 
 Node &Scene::get_root_node()
 {
 	return *root;
 }
+
+void Scene::invalidate()
+{
+	++revision;
+
+	rebuild_hierarchy = true;
+
+	invalidate_node_indices();
+
+	change_journal.reset();
+
+	rebuild_animations = true;
+
+	rebuild_bvh = true;
+}
+
+uint64_t Scene::get_revision() const
+{
+	return revision;
+}
+
+void Scene::mark_changed(Material &material)
+{
+	++component_pools[material.get_type()].revision;
+
+	change_journal.record(ChangeType::Material, nullptr, &material);
+}
+
+const ChangeJournal &Scene::get_change_journal() const
+{
+	return change_journal;
+}
+
+void Scene::update_transforms(JobSystem *job_system)
+{
+	if (!root)
+	{
+		return;
+	}
+
+	if (rebuild_hierarchy)
+	{
+		transform_hierarchy.build(*root);
+
+		rebuild_hierarchy = false;
+	}
+
+	bool transforms_changed = transform_hierarchy.update(job_system);
+
+	if (transforms_changed)
+	{
+		changed_nodes.clear();
+		transform_hierarchy.get_changed_nodes(changed_nodes);
+
+		for (auto node : changed_nodes)
+		{
+			change_journal.record(ChangeType::Transform, node);
+		}
+	}
+
+	if (transforms_changed && !rebuild_bvh)
+	{
+		bvh.refit();
+	}
+}
+
+void Scene::update_animations(float delta_time, JobSystem *job_system)
+{
+	if (rebuild_animations)
+	{
+		animation_system.build(get_components<Animation>());
+
+		rebuild_animations = false;
+	}
+
+	animation_system.update(delta_time, job_system);
+}
+
+const BVH &Scene::get_bvh()
+{
+	if (rebuild_bvh)
+	{
+		Timer timer;
+		timer.start();
+
+		bvh.build(get_components<Mesh>());
+
+		LOGI("Built the scene BVH over {} instances with {} nodes in {:.3f} ms", bvh.get_instance_count(), bvh.get_node_count(), timer.stop<Timer::Milliseconds>());
+
+		rebuild_bvh = false;
+	}
+
+	return bvh;
+}
+
+void Scene::get_lights_reaching_meshes(std::vector<Light *> &lights)
+{
+	auto &scene_bvh = get_bvh();
+
+	lights.clear();
+
+	for (auto light : get_component_view<Light>())
+	{
+		const auto &properties = light->get_properties();
+
+		// The shaders place the lights at their local translation
+		auto position = light->get_node()->get_transform().get_translation();
+
+		if (light->get_light_type() == LightType::Directional || properties.range <= 0.0f || scene_bvh.overlaps_sphere(position, properties.range))
+		{
+			lights.push_back(light);
+		}
+	}
+}
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
@@ -25,16 +25,101 @@
 #include <vector>
 
 #include "scene_graph/components/light.h"
+#include "scene_graph/animation_system.h"
+#include "scene_graph/bvh.h"
+#include "scene_graph/change_journal.h"
 #include "scene_graph/components/texture.h"
+#include "scene_graph/transform_hierarchy.h"
 
 namespace vkb
 {
+class JobSystem;
+
 namespace sg
 {
 class Node;
 class Component;
+class Material;
 class SubMesh;
 
+/**
+ * @brief A view over the components of a type stored by a scene, iterated without allocating or casting dynamically
+ *        Invalidated when components of the type are added or set.
+ */
+template <class T>
+class ComponentView
+{
+  public:
+	class Iterator
+	{
+	  public:
+		Iterator(Component *const *component) :
+		    component{component}
+		{}
+
+		T *operator*() const
+		{
+			return static_cast<T *>(*component);
+		}
+
+		Iterator &operator++()
+		{
+			++component;
+			return *this;
+		}
+
+		bool operator!=(const Iterator &other) const
+		{
+			return component != other.component;
+		}
+
+		bool operator==(const Iterator &other) const
+		{
+			return component == other.component;
+		}
+
+	  private:
+		Component *const *component;
+	};
+
+	ComponentView() = default;
+
+	ComponentView(const std::vector<Component *> &components) :
+	    first{components.data()},
+	    last{components.data() + components.size()}
+	{}
+
+	Iterator begin() const
+	{
+		return {first};
+	}
+
+	Iterator end() const
+	{
+		return {last};
+	}
+
+	size_t size() const
+	{
+		return static_cast<size_t>(last - first);
+	}
+
+	bool empty() const
+	{
+		return first == last;
+	}
+
+	T *operator[](size_t index) const
+	{
+		return static_cast<T *>(first[index]);
+	}
+
+  private:
+	Component *const *first{nullptr};
+
+	Component *const *last{nullptr};
+};
+
 /// @brief A collection of nodes organized in a tree structure.
 ///		   It can contain more than one root node.
 class Scene
@@ -116,6 +201,25 @@ class Scene
 	 */
 	const std::vector<std::unique_ptr<Component>> &get_components(const std::type_index &type_info) const;
 
+	/**
+	 * @brief Iterates the components of a type in place, for the systems running every frame
+	 *        T must be the type the components are stored as, either given to set_components()
+	 *        or returned by Component::get_type(), as the components are not cast dynamically.
+	 * @return A view over the components, empty if there are none
+	 */
+	template <class T>
+	ComponentView<T> get_component_view() const
+	{
+		auto pool_it = component_pools.find(typeid(T));
+
+		if (pool_it == component_pools.end())
+		{
+			return {};
+		}
+
+		return {pool_it->second.components};
+	}
+
 	template <class T>
 	bool has_component() const
 	{
@@ -124,12 +228,81 @@ class Scene
 
 	bool has_component(const std::type_index &type_info) const;
 
+	/**
+	 * @return The number of times components of a type were added, set or marked changed
+	 */
+	uint64_t get_component_revision(const std::type_index &type_info) const;
+
+	template <class T>
+	uint64_t get_component_revision() const
+	{
+		return get_component_revision(typeid(T));
+	}
+
+	/**
+	 * @brief Finds a node under the root by name, the shallowest one if several share it
+	 *        The nodes are indexed on first use, and again after nodes are added or the scene is invalidated.
+	 */
 	Node *find_node(const std::string &name);
 
+	/**
+	 * @brief Finds a node by the names of its ancestors below the root and its own, joined by '/', e.g. "body/arm/hand"
+	 *        Indexed separately from the names, on first use of a path.
+	 */
+	Node *find_node_by_path(const std::string &path);
+
 	void set_root_node(Node &node);
 
 	Node &get_root_node();
 
+	/**
+	 * @brief Marks the content of the scene as changed without a change of its nodes, e.g. when streamed assets are swapped in
+	 */
+	void invalidate();
+
+	/**
+	 * @return The number of times the scene was invalidated
+	 */
+	uint64_t get_revision() const;
+
+	/**
+	 * @brief Records that the parameters or textures of a material changed, for the caches depending on it
+	 */
+	void mark_changed(Material &material);
+
+	/**
+	 * @brief The changes of the scene for the caches derived from it, reset when the nodes change or the scene is invalidated
+	 *        The transforms which moved are recorded by update_transforms().
+	 */
+	const ChangeJournal &get_change_journal() const;
+
+	/**
+	 * @brief Updates the world matrices of the nodes under the root whose transforms changed
+	 *        The hierarchy is flattened again after nodes are added or the scene is invalidated.
+	 * @param job_system Optional job system updating the subtrees in parallel
+	 */
+	void update_transforms(JobSystem *job_system = nullptr);
+
+	/**
+	 * @brief Advances the animation clips of the scene and poses the animated nodes
+	 *        The channels are gathered again after clips are added or the scene is invalidated.
+	 * @param job_system Optional job system sampling the channels in parallel
+	 */
+	void update_animations(float delta_time, JobSystem *job_system = nullptr);
+
+	/**
+	 * @brief Bounding volume hierarchy over the mesh instances
+	 *        Built on first use and after the scene is invalidated, then refit when transforms change in update_transforms().
+	 */
+	const BVH &get_bvh();
+
+	/**
+	 * @brief Culls the point and spot lights whose range does not reach the bounds of any mesh
+	 *        Directional lights and lights without a range are kept.
+	 * @param lights Replaced by the kept lights, its capacity is reused so that culling every frame does not allocate
+	 */
+	void get_lights_reaching_meshes(std::vector<Light *> &lights);
+
   private:
 	std::string name;
 
@@ -138,7 +311,52 @@ class Scene
 
 	Node *root{nullptr};
 
-	std::unordered_map<std::type_index, std::vector<std::unique_ptr<Component>>> components;
+	/**
+	 * @brief The components of a type, whose addresses are stable as they are owned separately
+	 */
+	struct ComponentPool
+	{
+		std::vector<std::unique_ptr<Component>> owned;
+
+		/// Dense array of the owned components, iterated by the views
+		std::vector<Component *> components;
+
+		uint64_t revision{0};
+	};
+
+	void add_to_pool(const std::type_index &type_info, std::unique_ptr<Component> &&component);
+
+	std::unordered_map<std::type_index, ComponentPool> component_pools;
+
+	uint64_t revision{0};
+
+	ChangeJournal change_journal;
+
+	/// Nodes whose world matrix changed in the last update of the transforms
+	std::vector<Node *> changed_nodes;
+
+	TransformHierarchy transform_hierarchy;
+
+	bool rebuild_hierarchy{true};
+
+	/// Invalidates the node indices, with the transform hierarchy
+	void invalidate_node_indices();
+
+	std::unordered_map<std::string, Node *> nodes_by_name;
+
+	bool rebuild_name_index{true};
+
+	std::unordered_map<std::string, Node *> nodes_by_path;
+
+	bool rebuild_path_index{true};
+
+	AnimationSystem animation_system;
+
+	bool rebuild_animations{true};
+
+	BVH bvh;
+
+	bool rebuild_bvh{true};
 };
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
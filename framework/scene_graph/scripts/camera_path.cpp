@@ -0,0 +1,146 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "camera_path.h"
+
+#include <algorithm>
+#include <cmath>
+
+VKBP_DISABLE_WARNINGS()
+#include <glm/gtx/quaternion.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include "platform/filesystem.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+const float CameraPath::DEFAULT_TIMESTEP = 1.0f / 60.0f;
+
+CameraPath::CameraPath(Node &node, std::vector<Keyframe> keyframes, float timestep, bool loop) :
+    Script{node, "CameraPath"},
+    keyframes{std::move(keyframes)},
+    timestep{timestep},
+    loop{loop}
+{
+	if (this->keyframes.empty())
+	{
+		throw std::runtime_error("Camera path has no keyframes");
+	}
+}
+
+std::unique_ptr<CameraPath> CameraPath::load(Node &node, const std::string &filename)
+{
+	auto data = fs::read_asset(filename);
+
+	auto json = nlohmann::json::parse(data.begin(), data.end(), nullptr, false);
+	if (json.is_discarded() || !json.contains("keyframes"))
+	{
+		throw std::runtime_error("Invalid camera path: " + filename);
+	}
+
+	std::vector<Keyframe> keyframes;
+
+	for (const auto &entry : json["keyframes"])
+	{
+		Keyframe keyframe;
+		keyframe.time = entry.value("time", 0.0f);
+
+		if (entry.contains("translation"))
+		{
+			const auto &t        = entry["translation"];
+			keyframe.translation = glm::vec3{t.at(0).get<float>(), t.at(1).get<float>(), t.at(2).get<float>()};
+		}
+
+		if (entry.contains("rotation"))
+		{
+			const auto &r     = entry["rotation"];
+			keyframe.rotation = glm::normalize(glm::quat{r.at(3).get<float>(), r.at(0).get<float>(), r.at(1).get<float>(), r.at(2).get<float>()});
+		}
+
+		keyframes.push_back(keyframe);
+	}
+
+	if (!std::is_sorted(keyframes.begin(), keyframes.end(), [](const Keyframe &a, const Keyframe &b) { return a.time < b.time; }))
+	{
+		throw std::runtime_error("Camera path keyframes are not sorted by time: " + filename);
+	}
+
+	return std::make_unique<CameraPath>(node, std::move(keyframes), json.value("timestep", DEFAULT_TIMESTEP), json.value("loop", true));
+}
+
+void CameraPath::update(float /*delta_time*/)
+{
+	// Derive the time from the step count rather than accumulating it, so it does not drift
+	time = static_cast<float>(static_cast<double>(step_count) * timestep);
+	++step_count;
+
+	float duration = keyframes.back().time;
+	if (loop && duration > 0.0f)
+	{
+		time = std::fmod(time, duration);
+	}
+
+	auto keyframe = sample(time);
+
+	auto &transform = get_node().get_component<Transform>();
+	transform.set_translation(keyframe.translation);
+	transform.set_rotation(keyframe.rotation);
+}
+
+float CameraPath::get_time() const
+{
+	return time;
+}
+
+uint64_t CameraPath::get_step_count() const
+{
+	return step_count;
+}
+
+CameraPath::Keyframe CameraPath::sample(float track_time) const
+{
+	if (track_time <= keyframes.front().time)
+	{
+		return keyframes.front();
+	}
+
+	if (track_time >= keyframes.back().time)
+	{
+		return keyframes.back();
+	}
+
+	// The first keyframe after the time, there is one before it as it is within the track
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), track_time,
+	                             [](float t, const Keyframe &keyframe) { return t < keyframe.time; });
+	auto prev = next - 1;
+
+	float span = next->time - prev->time;
+	float t    = span > 0.0f ? (track_time - prev->time) / span : 0.0f;
+
+	Keyframe keyframe;
+	keyframe.time        = track_time;
+	keyframe.translation = glm::mix(prev->translation, next->translation, t);
+	keyframe.rotation    = glm::slerp(prev->rotation, next->rotation, t);
+
+	return keyframe;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,117 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/script.h"
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief Plays a keyframed track back on the transform of its node, so every run renders the same frames
+ *
+ * The track advances by a fixed timestep every update, whatever the delta time of the frame. It sets the
+ * whole transform of the node, so it overrides any other script moving the node, e.g. a FreeCamera.
+ *
+ * Tracks are JSON files relative to the assets directory:
+ *
+ *     {
+ *         "timestep": 0.016667,
+ *         "loop": true,
+ *         "keyframes": [
+ *             {"time": 0.0, "translation": [0.0, 1.0, 5.0], "rotation": [0.0, 0.0, 0.0, 1.0]},
+ *             ...
+ *         ]
+ *     }
+ *
+ * Rotations are quaternions stored as x, y, z, w. Keyframes must be sorted by time.
+ */
+class CameraPath : public Script
+{
+  public:
+	struct Keyframe
+	{
+		float time{0.0f};
+
+		glm::vec3 translation{0.0f};
+
+		glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+	};
+
+	/// Timestep of the tracks which do not specify one
+	static const float DEFAULT_TIMESTEP;
+
+	/**
+	 * @param node The node to move, it must have a transform
+	 * @param keyframes The track, sorted by time
+	 * @param timestep Time the track advances by every update, in seconds
+	 * @param loop Whether the track restarts after its last keyframe, otherwise it holds it
+	 */
+	CameraPath(Node &node, std::vector<Keyframe> keyframes, float timestep = DEFAULT_TIMESTEP, bool loop = true);
+
+	virtual ~CameraPath() = default;
+
+	/**
+	 * @brief Loads a track from a JSON file
+	 * @param node The node to move
+	 * @param filename The path to the file, relative to the assets directory
+	 * @throws std::runtime_error if the file is not a valid track
+	 */
+	static std::unique_ptr<CameraPath> load(Node &node, const std::string &filename);
+
+	/**
+	 * @brief Moves the node to the next step of the track, the delta time is ignored
+	 */
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @return The time of the track the last update sampled
+	 */
+	float get_time() const;
+
+	/**
+	 * @return The total number of updates since construction
+	 */
+	uint64_t get_step_count() const;
+
+  private:
+	Keyframe sample(float track_time) const;
+
+	std::vector<Keyframe> keyframes;
+
+	float timestep;
+
+	bool loop;
+
+	uint64_t step_count{0};
+
+	float time{0.0f};
+};
+}        // namespace sg
+}        // namespace vkb
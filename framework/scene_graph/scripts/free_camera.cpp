@@ -221,6 +221,8 @@ void FreeCamera::resize(uint32_t width, uint32_t height)
 {
 	auto &camera_node = get_node();
 
+	viewport_size = glm::vec2(width, height);
+
 	if (camera_node.has_component<Camera>())
 	{
 		if (auto camera = dynamic_cast<PerspectiveCamera *>(&camera_node.get_component<Camera>()))
@@ -230,5 +232,30 @@ void FreeCamera::resize(uint32_t width, uint32_t height)
 	}
 }
 
+BVH::RayHit FreeCamera::pick(const BVH &bvh, const glm::vec2 &screen_pos)
+{
+	auto &camera_node = get_node();
+
+	if (!camera_node.has_component<Camera>())
+	{
+		return {};
+	}
+
+	auto &camera = camera_node.get_component<Camera>();
+
+	// Screen positions go down, while the y axis of the projection goes up
+	glm::vec2 ndc{2.0f * screen_pos.x / viewport_size.x - 1.0f, 1.0f - 2.0f * screen_pos.y / viewport_size.y};
+
+	auto inverse_view_proj = glm::inverse(camera.get_projection() * camera.get_view());
+
+	auto near_point = inverse_view_proj * glm::vec4(ndc, -1.0f, 1.0f);
+	auto far_point  = inverse_view_proj * glm::vec4(ndc, 1.0f, 1.0f);
+
+	auto origin    = glm::vec3(near_point) / near_point.w;
+	auto direction = glm::normalize(glm::vec3(far_point) / far_point.w - origin);
+
+	return bvh.raycast(origin, direction);
+}
+
 }        // namespace sg
 }        // namespace vkb
@@ -29,6 +29,7 @@ VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include "scene_graph/bvh.h"
 #include "scene_graph/script.h"
 
 namespace vkb
@@ -60,9 +61,19 @@ class FreeCamera : public Script
 
 	virtual void resize(uint32_t width, uint32_t height) override;
 
+	/**
+	 * @brief Picks the nearest mesh instance under a position on the screen
+	 * @param bvh Bounding volume hierarchy of the scene, see Scene::get_bvh()
+	 * @param screen_pos Position in pixels from the top left of the last resized viewport
+	 * @return The hit, whose node is nullptr if no bounds are under the position
+	 */
+	BVH::RayHit pick(const BVH &bvh, const glm::vec2 &screen_pos);
+
   private:
 	float speed_multiplier{3.0f};
 
+	glm::vec2 viewport_size{1.0f};
+
 	glm::vec2 mouse_move_delta{0.0f};
 
 	glm::vec2 mouse_last_pos{0.0f};
@@ -36,6 +36,10 @@ namespace vkb
 {
 namespace sg
 {
+/**
+ * @brief Animates a node procedurally with a callback
+ *        Keyframed clips are instead played by the AnimationSystem of the scene.
+ */
 class NodeAnimation : public Script
 {
   public:
@@ -0,0 +1,178 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/transform_hierarchy.h"
+
+#include "job_system.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+void TransformHierarchy::build(Node &root)
+{
+	transforms.clear();
+	parents.clear();
+	subtrees.clear();
+
+	std::vector<std::pair<Node *, int32_t>> traverse_nodes{{&root, -1}};
+
+	while (!traverse_nodes.empty())
+	{
+		auto node_it = traverse_nodes.back();
+		traverse_nodes.pop_back();
+
+		auto &node  = *node_it.first;
+		auto  index = static_cast<int32_t>(transforms.size());
+
+		// Nodes may be listed as children without a parent, their world matrix is then their local one
+		auto parent = node.get_parent() ? node_it.second : -1;
+
+		if (node_it.second == 0)
+		{
+			if (!subtrees.empty())
+			{
+				subtrees.back().second = transforms.size();
+			}
+			subtrees.emplace_back(transforms.size(), transforms.size());
+		}
+
+		transforms.push_back(&node.get_transform());
+		parents.push_back(parent);
+
+		// Pushed in reverse, so the children are visited in their order
+		auto &children = node.get_children();
+		for (auto child_it = children.rbegin(); child_it != children.rend(); ++child_it)
+		{
+			traverse_nodes.emplace_back(*child_it, index);
+		}
+	}
+
+	if (!subtrees.empty())
+	{
+		subtrees.back().second = transforms.size();
+	}
+
+	world_matrices.assign(transforms.size(), glm::mat4(1.0f));
+
+	// Every world matrix is computed on the first update
+	changed.assign(transforms.size(), 1);
+	for (auto transform : transforms)
+	{
+		transform->invalidate_world_matrix();
+	}
+}
+
+bool TransformHierarchy::update(JobSystem *job_system)
+{
+	if (transforms.empty())
+	{
+		return false;
+	}
+
+	// The root comes before every subtree
+	bool root_changed = update_range(0, 1);
+
+	if (!job_system || transforms.size() <= GRAIN_SIZE)
+	{
+		return update_range(1, transforms.size()) || root_changed;
+	}
+
+	std::atomic<bool> any_changed{root_changed};
+
+	JobSystem::TaskGroup update_group{*job_system};
+
+	// Consecutive subtrees are batched until they are worth a job
+	size_t first = 1;
+
+	for (auto &subtree : subtrees)
+	{
+		if (subtree.second - first >= GRAIN_SIZE)
+		{
+			auto last = subtree.second;
+			update_group.run([this, first, last, &any_changed]() {
+				if (update_range(first, last))
+				{
+					any_changed = true;
+				}
+			});
+			first = last;
+		}
+	}
+
+	if (first < transforms.size() && update_range(first, transforms.size()))
+	{
+		any_changed = true;
+	}
+
+	update_group.wait();
+
+	return any_changed;
+}
+
+void TransformHierarchy::get_changed_nodes(std::vector<Node *> &nodes) const
+{
+	for (size_t i = 0; i < transforms.size(); ++i)
+	{
+		if (changed[i])
+		{
+			nodes.push_back(&transforms[i]->get_node());
+		}
+	}
+}
+
+size_t TransformHierarchy::size() const
+{
+	return transforms.size();
+}
+
+bool TransformHierarchy::update_range(size_t first, size_t last)
+{
+	bool any_changed = false;
+
+	for (size_t i = first; i < last; ++i)
+	{
+		auto &transform = *transforms[i];
+		auto  parent    = parents[i];
+		bool  moved     = changed[i] != 0;
+
+		changed[i] = transform.has_local_changes() || (parent >= 0 && changed[parent]);
+
+		if (!changed[i])
+		{
+			// A node which stopped moving has no motion from the previous update on
+			if (moved)
+			{
+				transform.set_world_matrix(world_matrices[i]);
+			}
+			continue;
+		}
+
+		// Same order as Transform::get_world_matrix
+		world_matrices[i] = parent >= 0 ? transform.get_matrix() * world_matrices[parent] : transform.get_matrix();
+
+		transform.set_world_matrix(world_matrices[i]);
+
+		any_changed = true;
+	}
+
+	return any_changed;
+}
+}        // namespace sg
+}        // namespace vkb
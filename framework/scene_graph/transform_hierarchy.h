@@ -0,0 +1,95 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class JobSystem;
+
+namespace sg
+{
+class Node;
+class Transform;
+
+/**
+ * @brief The transforms of a node tree flattened into arrays, whose world matrices are updated
+ *        in one linear pass
+ *
+ * The nodes are stored depth-first, so each parent comes before its children and each subtree
+ * is contiguous. A world matrix is recomputed when the local transform of its node or the world
+ * matrix of its parent changed, then stored in the Transform so get_world_matrix() does not walk
+ * up the parents. The subtrees under the root are updated in parallel on a job system.
+ *
+ * The Transform also keeps its world matrix of the previous update, which the motion vectors of
+ * temporal anti-aliasing are computed from. It catches up on the update after the node stops moving.
+ */
+class TransformHierarchy
+{
+  public:
+	/**
+	 * @brief Flattens the tree under a root node, replacing the previous one
+	 */
+	void build(Node &root);
+
+	/**
+	 * @brief Updates the world matrices which changed since the last update
+	 * @param job_system Optional job system updating the subtrees in parallel
+	 * @return Whether any world matrix changed
+	 */
+	bool update(JobSystem *job_system = nullptr);
+
+	/**
+	 * @brief Appends the nodes whose world matrix changed in the last update to a list
+	 */
+	void get_changed_nodes(std::vector<Node *> &nodes) const;
+
+	size_t size() const;
+
+	/// Minimum number of transforms updated by each job
+	static constexpr size_t GRAIN_SIZE = 256;
+
+  private:
+	/**
+	 * @brief Updates the transforms in [first, last), whose parents are in the range or before it
+	 * @return Whether any world matrix of the range changed
+	 */
+	bool update_range(size_t first, size_t last);
+
+	std::vector<Transform *> transforms;
+
+	/// Index of the parent of each transform, -1 for the roots
+	std::vector<int32_t> parents;
+
+	std::vector<glm::mat4> world_matrices;
+
+	/// Whether each world matrix changed in the current update
+	std::vector<uint8_t> changed;
+
+	/// Ranges of the subtrees under the root, sorted
+	std::vector<std::pair<size_t, size_t>> subtrees;
+};
+}        // namespace sg
+}        // namespace vkb
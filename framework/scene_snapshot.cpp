@@ -0,0 +1,671 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_snapshot.h"
+
+#include <cstring>
+#include <sys/stat.h>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+/// Identifies a scene snapshot ("VKSS")
+constexpr uint32_t SCENE_SNAPSHOT_MAGIC = 0x53534B56;
+
+/// Must be bumped whenever the layout of the records or the import processing changes
+constexpr uint32_t SCENE_SNAPSHOT_VERSION = 2;
+
+/// 64-bit FNV-1a, so that the keys do not depend on the standard library
+inline void hash_bytes(uint64_t &hash, const void *data, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+}
+
+inline bool get_source_file(const std::string &path, SceneSnapshot::SourceFile &source_file)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+
+	source_file.path          = path;
+	source_file.size          = static_cast<uint64_t>(info.st_size);
+	source_file.modified_time = static_cast<int64_t>(info.st_mtime);
+
+	return true;
+}
+
+struct SceneSnapshotHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint64_t key;
+};
+
+/**
+ * @brief Appends values to the serialized snapshot, the records are written field by field
+ */
+class Writer
+{
+  public:
+	template <class T>
+	void write(const T &value)
+	{
+		auto bytes = reinterpret_cast<const uint8_t *>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	void write(const std::string &value)
+	{
+		write(static_cast<uint64_t>(value.size()));
+		data.insert(data.end(), value.begin(), value.end());
+	}
+
+	template <class T>
+	void write(const std::vector<T> &values)
+	{
+		write(static_cast<uint64_t>(values.size()));
+
+		auto bytes = reinterpret_cast<const uint8_t *>(values.data());
+		data.insert(data.end(), bytes, bytes + values.size() * sizeof(T));
+	}
+
+	std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Reads the values written by a Writer, failing on truncated data
+ */
+class Reader
+{
+  public:
+	Reader(const uint8_t *data, size_t size) :
+	    data{data},
+	    size{size}
+	{}
+
+	template <class T>
+	bool read(T &value)
+	{
+		return read_bytes(&value, sizeof(T));
+	}
+
+	bool read(std::string &value)
+	{
+		uint64_t length{0};
+		if (!read(length) || length > size - offset)
+		{
+			return false;
+		}
+
+		value.assign(reinterpret_cast<const char *>(data + offset), static_cast<size_t>(length));
+		offset += static_cast<size_t>(length);
+
+		return true;
+	}
+
+	template <class T>
+	bool read(std::vector<T> &values)
+	{
+		uint64_t count{0};
+		if (!read(count) || count > (size - offset) / sizeof(T))
+		{
+			return false;
+		}
+
+		values.resize(static_cast<size_t>(count));
+
+		return read_bytes(values.data(), values.size() * sizeof(T));
+	}
+
+  private:
+	bool read_bytes(void *values, size_t count)
+	{
+		if (offset > size || count > size - offset)
+		{
+			return false;
+		}
+
+		if (count > 0)
+		{
+			std::memcpy(values, data + offset, count);
+		}
+		offset += count;
+
+		return true;
+	}
+
+	const uint8_t *data;
+
+	size_t size;
+
+	size_t offset{0};
+};
+
+/// Reads a count of records, which are larger than one byte each, so a count past the data fails early
+inline bool read_count(Reader &reader, uint64_t &count, size_t remaining_size)
+{
+	return reader.read(count) && count <= remaining_size;
+}
+}        // namespace
+
+uint64_t SceneSnapshot::get_key(const std::string &file_name, int scene_index, const std::vector<uint32_t> &settings)
+{
+	uint64_t key{0xcbf29ce484222325ULL};
+
+	hash_bytes(key, file_name.data(), file_name.size());
+	hash_bytes(key, &scene_index, sizeof(scene_index));
+	hash_bytes(key, settings.data(), settings.size() * sizeof(uint32_t));
+
+	return key;
+}
+
+std::string SceneSnapshot::get_filename(uint64_t key)
+{
+	return fmt::format("scene_{:016x}.snapshot", key);
+}
+
+bool SceneSnapshot::add_source_file(const std::string &path)
+{
+	SourceFile source_file;
+	if (!get_source_file(path, source_file))
+	{
+		return false;
+	}
+
+	source_files.push_back(source_file);
+
+	return true;
+}
+
+bool SceneSnapshot::is_up_to_date() const
+{
+	for (auto &source_file : source_files)
+	{
+		SourceFile current;
+		if (!get_source_file(source_file.path, current) ||
+		    current.size != source_file.size ||
+		    current.modified_time != source_file.modified_time)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool SceneSnapshot::load(uint64_t key)
+{
+	auto filename = fs::path::get(fs::path::Type::Temp) + get_filename(key);
+
+	if (!fs::is_file(filename))
+	{
+		return false;
+	}
+
+	try
+	{
+		fs::MappedFile file{filename};
+
+		if (!decode(key, file.data(), file.size()))
+		{
+			LOGW("Ignoring the invalid scene snapshot {}", filename);
+			return false;
+		}
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to read the scene snapshot {}: {}", filename, e.what());
+		return false;
+	}
+
+	if (!is_up_to_date())
+	{
+		LOGI("Ignoring the scene snapshot {}, its source files changed", filename);
+		return false;
+	}
+
+	return true;
+}
+
+void SceneSnapshot::store(uint64_t key) const
+{
+	try
+	{
+		fs::write_temp(encode(key), get_filename(key));
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to store the scene snapshot: {}", e.what());
+	}
+}
+
+std::vector<uint8_t> SceneSnapshot::encode(uint64_t key) const
+{
+	Writer writer;
+
+	SceneSnapshotHeader header{};
+	header.magic   = SCENE_SNAPSHOT_MAGIC;
+	header.version = SCENE_SNAPSHOT_VERSION;
+	header.key     = key;
+	writer.write(header);
+
+	writer.write(static_cast<uint64_t>(source_files.size()));
+	for (auto &source_file : source_files)
+	{
+		writer.write(source_file.path);
+		writer.write(source_file.size);
+		writer.write(source_file.modified_time);
+	}
+
+	writer.write(root_name);
+
+	writer.write(static_cast<uint64_t>(lights.size()));
+	for (auto &light : lights)
+	{
+		writer.write(light.name);
+		writer.write(light.type);
+		writer.write(light.properties);
+	}
+
+	writer.write(static_cast<uint64_t>(samplers.size()));
+	for (auto &sampler : samplers)
+	{
+		writer.write(sampler.name);
+		writer.write(sampler.min_filter);
+		writer.write(sampler.mag_filter);
+		writer.write(sampler.wrap_s);
+		writer.write(sampler.wrap_t);
+		writer.write(sampler.wrap_r);
+	}
+
+	writer.write(static_cast<uint64_t>(images.size()));
+	for (auto &image : images)
+	{
+		writer.write(image.name);
+		writer.write(image.format);
+		writer.write(image.layers);
+		writer.write(image.mipmaps);
+
+		writer.write(static_cast<uint64_t>(image.offsets.size()));
+		for (auto &layer_offsets : image.offsets)
+		{
+			writer.write(layer_offsets);
+		}
+
+		writer.write(image.data);
+	}
+
+	writer.write(static_cast<uint64_t>(textures.size()));
+	for (auto &texture : textures)
+	{
+		writer.write(texture.name);
+		writer.write(texture.image);
+		writer.write(texture.sampler);
+	}
+
+	writer.write(static_cast<uint64_t>(materials.size()));
+	for (auto &material : materials)
+	{
+		writer.write(material.name);
+		writer.write(material.base_color_factor);
+		writer.write(material.metallic_factor);
+		writer.write(material.roughness_factor);
+		writer.write(material.emissive);
+		writer.write(material.double_sided);
+		writer.write(material.alpha_cutoff);
+		writer.write(material.alpha_mode);
+
+		writer.write(static_cast<uint64_t>(material.textures.size()));
+		for (auto &texture : material.textures)
+		{
+			writer.write(texture.first);
+			writer.write(texture.second);
+		}
+	}
+
+	writer.write(static_cast<uint64_t>(vertex_arenas.size()));
+	for (auto &arena : vertex_arenas)
+	{
+		writer.write(arena);
+	}
+
+	writer.write(static_cast<uint64_t>(index_arenas.size()));
+	for (auto &arena : index_arenas)
+	{
+		writer.write(arena);
+	}
+
+	writer.write(static_cast<uint64_t>(meshes.size()));
+	for (auto &mesh : meshes)
+	{
+		writer.write(mesh.name);
+		writer.write(mesh.bounds_min);
+		writer.write(mesh.bounds_max);
+		writer.write(mesh.submesh_count);
+	}
+
+	writer.write(static_cast<uint64_t>(submeshes.size()));
+	for (auto &submesh : submeshes)
+	{
+		writer.write(submesh.material);
+
+		writer.write(static_cast<uint64_t>(submesh.attributes.size()));
+		for (auto &attribute : submesh.attributes)
+		{
+			writer.write(attribute.first);
+			writer.write(attribute.second);
+		}
+
+		writer.write(submesh.vertex_arena);
+
+		writer.write(static_cast<uint64_t>(submesh.vertex_arena_offsets.size()));
+		for (auto &offset : submesh.vertex_arena_offsets)
+		{
+			writer.write(offset.first);
+			writer.write(offset.second);
+		}
+
+		writer.write(submesh.index_arena);
+		writer.write(submesh.index_type);
+		writer.write(submesh.vertices_count);
+		writer.write(submesh.vertex_indices);
+		writer.write(submesh.first_index);
+		writer.write(submesh.lods);
+		writer.write(submesh.meshlets.meshlets);
+		writer.write(submesh.meshlets.vertices);
+		writer.write(submesh.meshlets.triangles);
+	}
+
+	writer.write(static_cast<uint64_t>(cameras.size()));
+	for (auto &camera : cameras)
+	{
+		writer.write(camera.name);
+		writer.write(camera.type);
+		writer.write(camera.aspect_ratio);
+		writer.write(camera.field_of_view);
+		writer.write(camera.near_plane);
+		writer.write(camera.far_plane);
+	}
+
+	writer.write(static_cast<uint64_t>(nodes.size()));
+	for (auto &node : nodes)
+	{
+		writer.write(node.name);
+		writer.write(node.translation);
+		writer.write(node.rotation);
+		writer.write(node.scale);
+		writer.write(node.mesh);
+		writer.write(node.camera);
+		writer.write(node.light);
+	}
+
+	writer.write(links);
+
+	return std::move(writer.data);
+}
+
+bool SceneSnapshot::decode(uint64_t key, const uint8_t *data, size_t size)
+{
+	Reader reader{data, size};
+
+	SceneSnapshotHeader header{};
+	if (!reader.read(header) ||
+	    header.magic != SCENE_SNAPSHOT_MAGIC ||
+	    header.version != SCENE_SNAPSHOT_VERSION ||
+	    header.key != key)
+	{
+		return false;
+	}
+
+	uint64_t count{0};
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	source_files.resize(static_cast<size_t>(count));
+	for (auto &source_file : source_files)
+	{
+		if (!reader.read(source_file.path) || !reader.read(source_file.size) || !reader.read(source_file.modified_time))
+		{
+			return false;
+		}
+	}
+
+	if (!reader.read(root_name) || !read_count(reader, count, size))
+	{
+		return false;
+	}
+	lights.resize(static_cast<size_t>(count));
+	for (auto &light : lights)
+	{
+		if (!reader.read(light.name) || !reader.read(light.type) || !reader.read(light.properties))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	samplers.resize(static_cast<size_t>(count));
+	for (auto &sampler : samplers)
+	{
+		if (!reader.read(sampler.name) || !reader.read(sampler.min_filter) || !reader.read(sampler.mag_filter) ||
+		    !reader.read(sampler.wrap_s) || !reader.read(sampler.wrap_t) || !reader.read(sampler.wrap_r))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	images.resize(static_cast<size_t>(count));
+	for (auto &image : images)
+	{
+		uint64_t layer_count{0};
+		if (!reader.read(image.name) || !reader.read(image.format) || !reader.read(image.layers) || !reader.read(image.mipmaps) ||
+		    !read_count(reader, layer_count, size))
+		{
+			return false;
+		}
+
+		image.offsets.resize(static_cast<size_t>(layer_count));
+		for (auto &layer_offsets : image.offsets)
+		{
+			if (!reader.read(layer_offsets))
+			{
+				return false;
+			}
+		}
+
+		if (!reader.read(image.data))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	textures.resize(static_cast<size_t>(count));
+	for (auto &texture : textures)
+	{
+		if (!reader.read(texture.name) || !reader.read(texture.image) || !reader.read(texture.sampler))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	materials.resize(static_cast<size_t>(count));
+	for (auto &material : materials)
+	{
+		uint64_t texture_count{0};
+		if (!reader.read(material.name) || !reader.read(material.base_color_factor) || !reader.read(material.metallic_factor) ||
+		    !reader.read(material.roughness_factor) || !reader.read(material.emissive) || !reader.read(material.double_sided) ||
+		    !reader.read(material.alpha_cutoff) || !reader.read(material.alpha_mode) || !read_count(reader, texture_count, size))
+		{
+			return false;
+		}
+
+		material.textures.resize(static_cast<size_t>(texture_count));
+		for (auto &texture : material.textures)
+		{
+			if (!reader.read(texture.first) || !reader.read(texture.second))
+			{
+				return false;
+			}
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	vertex_arenas.resize(static_cast<size_t>(count));
+	for (auto &arena : vertex_arenas)
+	{
+		if (!reader.read(arena))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	index_arenas.resize(static_cast<size_t>(count));
+	for (auto &arena : index_arenas)
+	{
+		if (!reader.read(arena))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	meshes.resize(static_cast<size_t>(count));
+	for (auto &mesh : meshes)
+	{
+		if (!reader.read(mesh.name) || !reader.read(mesh.bounds_min) || !reader.read(mesh.bounds_max) || !reader.read(mesh.submesh_count))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	submeshes.resize(static_cast<size_t>(count));
+	for (auto &submesh : submeshes)
+	{
+		uint64_t attribute_count{0};
+		if (!reader.read(submesh.material) || !read_count(reader, attribute_count, size))
+		{
+			return false;
+		}
+
+		submesh.attributes.resize(static_cast<size_t>(attribute_count));
+		for (auto &attribute : submesh.attributes)
+		{
+			if (!reader.read(attribute.first) || !reader.read(attribute.second))
+			{
+				return false;
+			}
+		}
+
+		uint64_t offset_count{0};
+		if (!reader.read(submesh.vertex_arena) || !read_count(reader, offset_count, size))
+		{
+			return false;
+		}
+
+		submesh.vertex_arena_offsets.resize(static_cast<size_t>(offset_count));
+		for (auto &offset : submesh.vertex_arena_offsets)
+		{
+			if (!reader.read(offset.first) || !reader.read(offset.second))
+			{
+				return false;
+			}
+		}
+
+		if (!reader.read(submesh.index_arena) || !reader.read(submesh.index_type) || !reader.read(submesh.vertices_count) ||
+		    !reader.read(submesh.vertex_indices) || !reader.read(submesh.first_index) || !reader.read(submesh.lods) ||
+		    !reader.read(submesh.meshlets.meshlets) || !reader.read(submesh.meshlets.vertices) || !reader.read(submesh.meshlets.triangles))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	cameras.resize(static_cast<size_t>(count));
+	for (auto &camera : cameras)
+	{
+		if (!reader.read(camera.name) || !reader.read(camera.type) || !reader.read(camera.aspect_ratio) ||
+		    !reader.read(camera.field_of_view) || !reader.read(camera.near_plane) || !reader.read(camera.far_plane))
+		{
+			return false;
+		}
+	}
+
+	if (!read_count(reader, count, size))
+	{
+		return false;
+	}
+	nodes.resize(static_cast<size_t>(count));
+	for (auto &node : nodes)
+	{
+		if (!reader.read(node.name) || !reader.read(node.translation) || !reader.read(node.rotation) || !reader.read(node.scale) ||
+		    !reader.read(node.mesh) || !reader.read(node.camera) || !reader.read(node.light))
+		{
+			return false;
+		}
+	}
+
+	return reader.read(links);
+}
+}        // namespace vkb
@@ -0,0 +1,291 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "geometry/meshlet_builder.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/sub_mesh.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Binary snapshot of a glTF scene as GLTFLoader builds it, stored in the temporary directory
+ *
+ * The records hold the result of the import: images decoded and transcoded for the device, geometry
+ * packed into arenas with its levels of detail and meshlets, and the nodes, materials and textures
+ * referring to them by index. Loading a snapshot maps the file and copies the records out, so that
+ * it is bound by I/O rather than by parsing and processing the glTF assets.
+ *
+ * A snapshot is keyed by the glTF file, the scene, the import settings and the device, and is stale
+ * once the size or modification time of one of its source files changes.
+ */
+class SceneSnapshot
+{
+  public:
+	struct SourceFile
+	{
+		/// Absolute path of the file
+		std::string path;
+
+		uint64_t size{0};
+
+		int64_t modified_time{0};
+	};
+
+	/// Sampler as described by the glTF file, with the filters and wrap modes of tinygltf
+	struct SamplerRecord
+	{
+		std::string name;
+
+		int32_t min_filter{-1};
+
+		int32_t mag_filter{-1};
+
+		int32_t wrap_s{0};
+
+		int32_t wrap_t{0};
+
+		int32_t wrap_r{0};
+	};
+
+	/// Image data after the decoding and transcoding of the import, before the mip chain is reserved on the GPU
+	struct ImageRecord
+	{
+		std::string name;
+
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		uint32_t layers{1};
+
+		std::vector<sg::Mipmap> mipmaps;
+
+		std::vector<std::vector<VkDeviceSize>> offsets;
+
+		std::vector<uint8_t> data;
+	};
+
+	struct TextureRecord
+	{
+		std::string name;
+
+		uint32_t image{0};
+
+		/// Index of the sampler, -1 for the default sampler
+		int32_t sampler{-1};
+	};
+
+	struct MaterialRecord
+	{
+		std::string name;
+
+		glm::vec4 base_color_factor{0.0f};
+
+		float metallic_factor{0.0f};
+
+		float roughness_factor{0.0f};
+
+		glm::vec3 emissive{0.0f};
+
+		bool double_sided{false};
+
+		float alpha_cutoff{0.5f};
+
+		sg::AlphaMode alpha_mode{sg::AlphaMode::Opaque};
+
+		/// Index of the texture of each texture name
+		std::vector<std::pair<std::string, uint32_t>> textures;
+	};
+
+	struct SubMeshRecord
+	{
+		/// Index of the material, -1 for the default material
+		int32_t material{-1};
+
+		std::vector<std::pair<std::string, sg::VertexAttribute>> attributes;
+
+		uint32_t vertex_arena{0};
+
+		std::vector<std::pair<std::string, VkDeviceSize>> vertex_arena_offsets;
+
+		/// Index of the index arena, -1 for a submesh without indices
+		int32_t index_arena{-1};
+
+		VkIndexType index_type{VK_INDEX_TYPE_UINT16};
+
+		uint32_t vertices_count{0};
+
+		uint32_t vertex_indices{0};
+
+		uint32_t first_index{0};
+
+		std::vector<sg::SubMeshLod> lods;
+
+		MeshletData meshlets;
+	};
+
+	/// A mesh owns the submesh_count submeshes following the ones of the previous meshes
+	struct MeshRecord
+	{
+		std::string name;
+
+		glm::vec3 bounds_min{0.0f};
+
+		glm::vec3 bounds_max{0.0f};
+
+		uint32_t submesh_count{0};
+	};
+
+	struct CameraRecord
+	{
+		std::string name;
+
+		std::string type;
+
+		float aspect_ratio{0.0f};
+
+		float field_of_view{0.0f};
+
+		float near_plane{0.0f};
+
+		float far_plane{0.0f};
+	};
+
+	struct LightRecord
+	{
+		std::string name;
+
+		sg::LightType type{sg::LightType::Directional};
+
+		sg::LightProperties properties;
+	};
+
+	struct NodeRecord
+	{
+		std::string name;
+
+		glm::vec3 translation{0.0f};
+
+		glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+
+		glm::vec3 scale{1.0f};
+
+		/// Indices of the components of the node, -1 for none
+		int32_t mesh{-1};
+
+		int32_t camera{-1};
+
+		int32_t light{-1};
+	};
+
+	/// A node added as a child, in the order the hierarchy was built
+	struct NodeLink
+	{
+		/// Index of the parent in the nodes, -1 for the root node
+		int32_t parent{-1};
+
+		uint32_t child{0};
+	};
+
+	/**
+	 * @brief Computes the key of the snapshot of a scene
+	 * @param file_name The glTF file, relative to the assets directory
+	 * @param scene_index The scene of the file
+	 * @param settings The import settings and properties of the device the result depends on
+	 */
+	static uint64_t get_key(const std::string &file_name, int scene_index, const std::vector<uint32_t> &settings);
+
+	/**
+	 * @return The name of the file storing a snapshot, in the temporary directory
+	 */
+	static std::string get_filename(uint64_t key);
+
+	/**
+	 * @brief Adds a file the scene is loaded from, with its current size and modification time
+	 * @return False if the file cannot be found
+	 */
+	bool add_source_file(const std::string &path);
+
+	/**
+	 * @brief Loads the snapshot stored for a key
+	 * @return False if no snapshot is stored for the key, or if it is stale or invalid
+	 */
+	bool load(uint64_t key);
+
+	/**
+	 * @brief Stores the snapshot for a key in the temporary directory
+	 */
+	void store(uint64_t key) const;
+
+	/**
+	 * @brief Serializes the snapshot
+	 */
+	std::vector<uint8_t> encode(uint64_t key) const;
+
+	/**
+	 * @brief Deserializes a snapshot
+	 * @return False if the data is truncated or does not belong to the key
+	 */
+	bool decode(uint64_t key, const uint8_t *data, size_t size);
+
+	/**
+	 * @return Whether the source files still have the size and modification time they had when recorded
+	 */
+	bool is_up_to_date() const;
+
+	std::vector<SourceFile> source_files;
+
+	/// Name of the root node, the name of the glTF scene
+	std::string root_name;
+
+	std::vector<LightRecord> lights;
+
+	std::vector<SamplerRecord> samplers;
+
+	std::vector<ImageRecord> images;
+
+	std::vector<TextureRecord> textures;
+
+	std::vector<MaterialRecord> materials;
+
+	std::vector<std::vector<uint8_t>> vertex_arenas;
+
+	std::vector<std::vector<uint8_t>> index_arenas;
+
+	std::vector<MeshRecord> meshes;
+
+	std::vector<SubMeshRecord> submeshes;
+
+	std::vector<CameraRecord> cameras;
+
+	std::vector<NodeRecord> nodes;
+
+	std::vector<NodeLink> links;
+};
+}        // namespace vkb
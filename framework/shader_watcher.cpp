@@ -0,0 +1,106 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shader_watcher.h"
+
+#include <sys/stat.h>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+ShaderWatcher::ShaderWatcher(ResourceCache &resource_cache, float poll_interval) :
+    resource_cache{resource_cache},
+    poll_interval{poll_interval}
+{
+}
+
+void ShaderWatcher::watch(ShaderSource &source)
+{
+	if (source.get_filename().empty())
+	{
+		return;
+	}
+
+	sources[&source] = get_modification_time(source);
+}
+
+void ShaderWatcher::unwatch(const ShaderSource &source)
+{
+	sources.erase(const_cast<ShaderSource *>(&source));
+}
+
+size_t ShaderWatcher::update(float delta_time)
+{
+	elapsed_time += delta_time;
+
+	if (elapsed_time < poll_interval)
+	{
+		return 0;
+	}
+
+	elapsed_time = 0.0f;
+
+	size_t reloaded = 0;
+
+	for (auto &watched : sources)
+	{
+		auto modification_time = get_modification_time(*watched.first);
+
+		// A file being saved may be missing for a moment
+		if (modification_time == 0 || modification_time == watched.second)
+		{
+			continue;
+		}
+
+		watched.second = modification_time;
+
+		auto &source   = *watched.first;
+		auto  previous = source;
+
+		if (!source.reload())
+		{
+			continue;
+		}
+
+		if (resource_cache.reload_shader_source(previous.get_id(), source))
+		{
+			++reloaded;
+		}
+		else
+		{
+			// Keep the source matching the modules in the cache until the file is fixed
+			source = previous;
+		}
+	}
+
+	return reloaded;
+}
+
+std::time_t ShaderWatcher::get_modification_time(const ShaderSource &source) const
+{
+	struct stat info;
+	if (stat((fs::path::get(fs::path::Type::Shaders) + source.get_filename()).c_str(), &info) != 0)
+	{
+		return 0;
+	}
+
+	return info.st_mtime;
+}
+}        // namespace vkb
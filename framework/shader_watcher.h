@@ -0,0 +1,75 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ctime>
+#include <unordered_map>
+
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class ResourceCache;
+
+/**
+ * @brief Watches the files of shader sources and reloads them when they change on disk
+ *        The resource cache then rebuilds the shader modules, pipeline layouts and pipelines
+ *        depending on a reloaded source. Only the sources loaded from a file can be watched.
+ */
+class ShaderWatcher
+{
+  public:
+	/**
+	 * @param resource_cache The cache holding the resources built from the watched sources
+	 * @param poll_interval The number of seconds between two checks of the files
+	 */
+	ShaderWatcher(ResourceCache &resource_cache, float poll_interval = 0.5f);
+
+	ShaderWatcher(const ShaderWatcher &) = delete;
+
+	ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+	/**
+	 * @brief Starts watching a source, which must outlive the watcher or be unwatched
+	 */
+	void watch(ShaderSource &source);
+
+	void unwatch(const ShaderSource &source);
+
+	/**
+	 * @brief Checks the watched files once the poll interval has elapsed
+	 * @return The number of sources which were reloaded
+	 */
+	size_t update(float delta_time);
+
+  private:
+	/**
+	 * @return The last modification time of the file of a source, zero if it cannot be read
+	 */
+	std::time_t get_modification_time(const ShaderSource &source) const;
+
+	ResourceCache &resource_cache;
+
+	float poll_interval;
+
+	float elapsed_time{0.0f};
+
+	/// Watched sources, with the modification time of their file when they were last loaded
+	std::unordered_map<ShaderSource *, std::time_t> sources;
+};
+}        // namespace vkb
@@ -0,0 +1,75 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shared_context.h"
+
+#include <algorithm>
+
+namespace vkb
+{
+SharedContext::~SharedContext()
+{
+	reset();
+}
+
+void SharedContext::reset()
+{
+	if (device)
+	{
+		device->wait_idle();
+	}
+
+	if (pipeline_cache)
+	{
+		device->get_resource_cache().set_pipeline_cache(VK_NULL_HANDLE);
+		pipeline_cache->save();
+		pipeline_cache.reset();
+	}
+
+	device.reset();
+
+	if (surface != VK_NULL_HANDLE)
+	{
+		vkDestroySurfaceKHR(instance->get_handle(), surface, nullptr);
+		surface = VK_NULL_HANDLE;
+	}
+
+	instance.reset();
+}
+
+bool SharedContext::is_instance_compatible(const std::unordered_map<const char *, bool> &extensions,
+                                           const std::vector<const char *> &             layers,
+                                           bool                                          headless,
+                                           uint32_t                                      api_version) const
+{
+	if (!instance || headless != this->headless || layers.size() != validation_layers.size() ||
+	    instance->get_api_version() < api_version)
+	{
+		return false;
+	}
+
+	if (!std::equal(layers.begin(), layers.end(), validation_layers.begin(),
+	                [](const char *layer, const std::string &validation_layer) { return validation_layer == layer; }))
+	{
+		return false;
+	}
+
+	// Optional extensions count too, as they were possibly unavailable when the instance was created
+	return std::all_of(extensions.begin(), extensions.end(),
+	                   [this](const std::pair<const char *const, bool> &extension) { return instance->is_enabled(extension.first); });
+}
+}        // namespace vkb
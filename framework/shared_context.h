@@ -0,0 +1,86 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/device.h"
+#include "core/instance.h"
+#include "core/pipeline_cache.h"
+
+namespace vkb
+{
+/**
+ * @brief Vulkan objects handed over from one sample to the next, so that a batch run
+ *        does not create and destroy the instance and device for every sample
+ *
+ *        A VulkanSample takes the objects when prepared, if they were created with the
+ *        extensions, layers and features it requests, and gives them back when destroyed,
+ *        after releasing the resources of its own. The shader modules, pipelines and
+ *        pipeline cache of the resource cache are kept, so later samples reuse them.
+ */
+struct SharedContext
+{
+	SharedContext() = default;
+
+	SharedContext(const SharedContext &) = delete;
+
+	SharedContext(SharedContext &&) = delete;
+
+	~SharedContext();
+
+	SharedContext &operator=(const SharedContext &) = delete;
+
+	SharedContext &operator=(SharedContext &&) = delete;
+
+	/**
+	 * @brief Destroys the objects, saving the pipeline cache first
+	 */
+	void reset();
+
+	/**
+	 * @return True if the instance was created with the extensions, validation layers and headless mode,
+	 *         and with at least the Vulkan version
+	 */
+	bool is_instance_compatible(const std::unordered_map<const char *, bool> &extensions,
+	                            const std::vector<const char *> &             layers,
+	                            bool                                          headless,
+	                            uint32_t                                      api_version) const;
+
+	std::unique_ptr<Instance> instance;
+
+	/// The surface of the window, created from the instance
+	VkSurfaceKHR surface{VK_NULL_HANDLE};
+
+	/// The validation layers the instance was created with
+	std::vector<std::string> validation_layers;
+
+	bool headless{false};
+
+	std::unique_ptr<Device> device;
+
+	/// The features the device was created with
+	VkPhysicalDeviceFeatures device_features{};
+
+	std::unique_ptr<PipelineCache> pipeline_cache;
+};
+}        // namespace vkb
@@ -0,0 +1,408 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "spirv_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+/// Identifies cached SPIRV code ("VKBS")
+constexpr uint32_t SPIRV_CACHE_MAGIC = 0x53424B56;
+
+/// Must be bumped whenever the layout of the cached data or the reflection changes
+constexpr uint32_t SPIRV_CACHE_VERSION = 2;
+
+/// Directory of the precompiled entries, relative to the shaders directory
+const std::string precompiled_directory = "spirv/";
+
+/// Variants compiled at runtime, to be fed to the offline precompiler
+const std::string manifest_filename = "spirv_manifest.txt";
+
+std::mutex manifest_mutex;
+
+const std::map<VkShaderStageFlagBits, std::string> stage_names{
+    {VK_SHADER_STAGE_VERTEX_BIT, "vert"},
+    {VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, "tesc"},
+    {VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, "tese"},
+    {VK_SHADER_STAGE_GEOMETRY_BIT, "geom"},
+    {VK_SHADER_STAGE_FRAGMENT_BIT, "frag"},
+    {VK_SHADER_STAGE_COMPUTE_BIT, "comp"}};
+
+/// 64-bit FNV-1a, unlike std::hash the result does not depend on the standard library
+inline void hash_bytes(uint64_t &hash, const void *data, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+}
+
+inline void hash_string(uint64_t &hash, const std::string &value)
+{
+	uint64_t size = value.size();
+	hash_bytes(hash, &size, sizeof(size));
+	hash_bytes(hash, value.data(), value.size());
+}
+
+inline std::vector<std::string> split(const std::string &line, char delimiter)
+{
+	std::vector<std::string> fields;
+	std::stringstream        stream{line};
+	std::string              field;
+
+	while (std::getline(stream, field, delimiter))
+	{
+		fields.push_back(field);
+	}
+
+	return fields;
+}
+
+struct SPIRVCacheHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint64_t key;
+
+	uint32_t spirv_size;
+
+	uint32_t resource_count;
+};
+
+/// Followed by the name of the resource, padded to 4 bytes
+struct ShaderResourceRecord
+{
+	VkShaderStageFlags stages;
+
+	ShaderResourceType type;
+
+	ShaderResourceMode mode;
+
+	uint32_t set;
+
+	uint32_t binding;
+
+	uint32_t location;
+
+	uint32_t input_attachment_index;
+
+	uint32_t vec_size;
+
+	uint32_t columns;
+
+	uint32_t array_size;
+
+	uint32_t offset;
+
+	uint32_t size;
+
+	uint32_t constant_id;
+
+	uint32_t name_size;
+};
+
+template <class T>
+inline void append(std::vector<uint8_t> &data, const T &value)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(&value);
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template <class T>
+inline bool read(const std::vector<uint8_t> &data, size_t &offset, T *values, size_t count = 1)
+{
+	size_t size = count * sizeof(T);
+
+	if (offset > data.size() || size > data.size() - offset)
+	{
+		return false;
+	}
+
+	std::memcpy(values, data.data() + offset, size);
+	offset += size;
+
+	return true;
+}
+}        // namespace
+
+uint64_t SPIRVCache::get_key(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	uint64_t key{0xcbf29ce484222325ULL};
+
+	uint32_t stage_value = static_cast<uint32_t>(stage);
+	hash_bytes(key, &stage_value, sizeof(stage_value));
+	hash_bytes(key, glsl_source.get_data().data(), glsl_source.get_data().size());
+	hash_string(key, entry_point);
+	hash_string(key, shader_variant.get_preamble());
+
+	for (auto &process : shader_variant.get_processes())
+	{
+		hash_string(key, process);
+	}
+
+	// Runtime array sizes change the reflected resources, sort them for a stable key
+	std::map<std::string, size_t> runtime_array_sizes{shader_variant.get_runtime_array_sizes().begin(),
+	                                                  shader_variant.get_runtime_array_sizes().end()};
+
+	for (auto &runtime_array_size : runtime_array_sizes)
+	{
+		uint64_t size = runtime_array_size.second;
+		hash_string(key, runtime_array_size.first);
+		hash_bytes(key, &size, sizeof(size));
+	}
+
+	return key;
+}
+
+std::string SPIRVCache::get_filename(uint64_t key)
+{
+	return fmt::format("spirv_{:016x}.cache", key);
+}
+
+bool SPIRVCache::load(uint64_t key, std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources)
+{
+	auto filename = get_filename(key);
+
+	try
+	{
+		if (fs::is_file(fs::path::get(fs::path::Type::Shaders) + precompiled_directory + filename) &&
+		    decode(key, fs::read_shader(precompiled_directory + filename), spirv, resources))
+		{
+			return true;
+		}
+
+		if (fs::is_file(fs::path::get(fs::path::Type::Temp) + filename) &&
+		    decode(key, fs::read_temp(filename), spirv, resources))
+		{
+			return true;
+		}
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to read SPIRV cache file {}: {}", filename, e.what());
+	}
+
+	return false;
+}
+
+void SPIRVCache::store(uint64_t key, VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant,
+                       const std::vector<uint32_t> &spirv, const std::vector<ShaderResource> &resources)
+{
+	try
+	{
+		fs::write_temp(encode(key, spirv, resources), get_filename(key));
+
+		if (!glsl_source.get_filename().empty())
+		{
+			std::lock_guard<std::mutex> guard(manifest_mutex);
+
+			std::ofstream manifest{fs::path::get(fs::path::Type::Temp) + manifest_filename, std::ios::out | std::ios::app};
+			manifest << get_manifest_entry(stage, glsl_source.get_filename(), entry_point, shader_variant) << "\n";
+		}
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Failed to store SPIRV cache file: {}", e.what());
+	}
+}
+
+std::vector<uint8_t> SPIRVCache::encode(uint64_t key, const std::vector<uint32_t> &spirv, const std::vector<ShaderResource> &resources)
+{
+	std::vector<uint8_t> data;
+
+	SPIRVCacheHeader header{};
+	header.magic          = SPIRV_CACHE_MAGIC;
+	header.version        = SPIRV_CACHE_VERSION;
+	header.key            = key;
+	header.spirv_size     = to_u32(spirv.size());
+	header.resource_count = to_u32(resources.size());
+
+	append(data, header);
+
+	auto spirv_bytes = reinterpret_cast<const uint8_t *>(spirv.data());
+	data.insert(data.end(), spirv_bytes, spirv_bytes + spirv.size() * sizeof(uint32_t));
+
+	for (auto &resource : resources)
+	{
+		ShaderResourceRecord record{};
+		record.stages                 = resource.stages;
+		record.type                   = resource.type;
+		record.mode                   = resource.mode;
+		record.set                    = resource.set;
+		record.binding                = resource.binding;
+		record.location               = resource.location;
+		record.input_attachment_index = resource.input_attachment_index;
+		record.vec_size               = resource.vec_size;
+		record.columns                = resource.columns;
+		record.array_size             = resource.array_size;
+		record.offset                 = resource.offset;
+		record.size                   = resource.size;
+		record.constant_id            = resource.constant_id;
+		record.name_size              = to_u32(resource.name.size());
+
+		append(data, record);
+		data.insert(data.end(), resource.name.begin(), resource.name.end());
+		data.resize((data.size() + 3) & ~size_t{3}, 0);
+	}
+
+	return data;
+}
+
+bool SPIRVCache::decode(uint64_t key, const std::vector<uint8_t> &data, std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources)
+{
+	size_t offset{0};
+
+	SPIRVCacheHeader header{};
+	if (!read(data, offset, &header) ||
+	    header.magic != SPIRV_CACHE_MAGIC ||
+	    header.version != SPIRV_CACHE_VERSION ||
+	    header.key != key)
+	{
+		return false;
+	}
+
+	std::vector<uint32_t>       cached_spirv(header.spirv_size);
+	std::vector<ShaderResource> cached_resources(header.resource_count);
+
+	if (!read(data, offset, cached_spirv.data(), cached_spirv.size()))
+	{
+		return false;
+	}
+
+	for (auto &resource : cached_resources)
+	{
+		ShaderResourceRecord record{};
+		if (!read(data, offset, &record))
+		{
+			return false;
+		}
+
+		resource.stages                 = record.stages;
+		resource.type                   = record.type;
+		resource.mode                   = record.mode;
+		resource.set                    = record.set;
+		resource.binding                = record.binding;
+		resource.location               = record.location;
+		resource.input_attachment_index = record.input_attachment_index;
+		resource.vec_size               = record.vec_size;
+		resource.columns                = record.columns;
+		resource.array_size             = record.array_size;
+		resource.offset                 = record.offset;
+		resource.size                   = record.size;
+		resource.constant_id            = record.constant_id;
+
+		resource.name.resize(record.name_size);
+		if (!read(data, offset, &resource.name[0], resource.name.size()))
+		{
+			return false;
+		}
+
+		offset = (offset + 3) & ~size_t{3};
+	}
+
+	spirv     = std::move(cached_spirv);
+	resources = std::move(cached_resources);
+
+	return true;
+}
+
+std::string SPIRVCache::get_manifest_entry(VkShaderStageFlagBits stage, const std::string &filename, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	auto stage_it = stage_names.find(stage);
+
+	std::string entry = stage_it != stage_names.end() ? stage_it->second : std::to_string(static_cast<uint32_t>(stage));
+	entry += ";" + filename + ";" + entry_point;
+
+	for (auto &process : shader_variant.get_processes())
+	{
+		entry += ";" + process;
+	}
+
+	return entry;
+}
+
+bool SPIRVCache::parse_manifest_entry(const std::string &line, VkShaderStageFlagBits &stage, std::string &filename, std::string &entry_point, ShaderVariant &shader_variant)
+{
+	if (line.empty() || line[0] == '#')
+	{
+		return false;
+	}
+
+	auto fields = split(line, ';');
+
+	if (fields.size() < 3)
+	{
+		return false;
+	}
+
+	auto stage_it = std::find_if(stage_names.begin(), stage_names.end(),
+	                             [&fields](const std::pair<const VkShaderStageFlagBits, std::string> &stage_name) { return stage_name.second == fields[0]; });
+
+	if (stage_it != stage_names.end())
+	{
+		stage = stage_it->first;
+	}
+	else
+	{
+		stage = static_cast<VkShaderStageFlagBits>(std::stoul(fields[0]));
+	}
+
+	filename    = fields[1];
+	entry_point = fields[2];
+
+	// Rebuild the variant the same way it was built at runtime, so that the preamble matches
+	shader_variant.clear();
+	for (size_t i = 3; i < fields.size(); ++i)
+	{
+		auto &process = fields[i];
+
+		if (process.size() < 2)
+		{
+			return false;
+		}
+
+		if (process[0] == 'D')
+		{
+			shader_variant.add_define(process.substr(1));
+		}
+		else if (process[0] == 'U')
+		{
+			shader_variant.add_undefine(process.substr(1));
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+}        // namespace vkb
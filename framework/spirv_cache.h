@@ -0,0 +1,112 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+/// Helper class to store compiled SPIRV code, along with its reflected resources,
+/// so that it can be reused by later runs. Entries are looked up first in the
+/// precompiled shaders packaged with the assets (see tools/shader_precompiler),
+/// then in the temporary directory.
+class SPIRVCache
+{
+  public:
+	/**
+	 * @brief Computes the key identifying the SPIRV code generated for a shader
+	 *        The key only depends on its inputs, so it is stable across platforms and runs
+	 * @param stage The Vulkan shader stage flag
+	 * @param glsl_source The GLSL source code
+	 * @param entry_point The entrypoint function name of the shader stage
+	 * @param shader_variant The shader variant
+	 */
+	uint64_t get_key(VkShaderStageFlagBits stage,
+	                 const ShaderSource &  glsl_source,
+	                 const std::string &   entry_point,
+	                 const ShaderVariant & shader_variant);
+
+	/**
+	 * @return The name of the file storing an entry
+	 */
+	std::string get_filename(uint64_t key);
+
+	/**
+	 * @brief Loads the SPIRV code and resources stored for a key
+	 * @param key The key of the shader
+	 * @param[out] spirv The cached SPIRV code
+	 * @param[out] resources The cached shader resources
+	 * @return False if nothing valid was stored for the key
+	 */
+	bool load(uint64_t key, std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Stores the SPIRV code and resources for a key in the temporary directory
+	 *        If the source was loaded from a file, the variant is also added to the
+	 *        temporary manifest so that it can be precompiled offline.
+	 * @param key The key of the shader
+	 * @param stage The Vulkan shader stage flag
+	 * @param glsl_source The GLSL source code
+	 * @param entry_point The entrypoint function name of the shader stage
+	 * @param shader_variant The shader variant
+	 * @param spirv The SPIRV code
+	 * @param resources The shader resources
+	 */
+	void store(uint64_t                           key,
+	           VkShaderStageFlagBits              stage,
+	           const ShaderSource &               glsl_source,
+	           const std::string &                entry_point,
+	           const ShaderVariant &              shader_variant,
+	           const std::vector<uint32_t> &      spirv,
+	           const std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Serializes an entry
+	 */
+	std::vector<uint8_t> encode(uint64_t key, const std::vector<uint32_t> &spirv, const std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Deserializes an entry
+	 * @return False if the data is truncated or does not belong to the key
+	 */
+	bool decode(uint64_t key, const std::vector<uint8_t> &data, std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Formats a shader variant as a manifest line:
+	 *        stage;filename;entry point;processes separated by ';'
+	 */
+	std::string get_manifest_entry(VkShaderStageFlagBits stage,
+	                               const std::string &   filename,
+	                               const std::string &   entry_point,
+	                               const ShaderVariant & shader_variant);
+
+	/**
+	 * @brief Parses a manifest line written by get_manifest_entry()
+	 * @return False if the line is empty, a comment or malformed
+	 */
+	bool parse_manifest_entry(const std::string &    line,
+	                          VkShaderStageFlagBits &stage,
+	                          std::string &          filename,
+	                          std::string &          entry_point,
+	                          ShaderVariant &        shader_variant);
+};
+}        // namespace vkb
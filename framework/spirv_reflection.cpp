@@ -369,6 +369,29 @@ inline void read_shader_resource<ShaderResourceType::BufferStorage>(const spirv_
 		resources.push_back(shader_resource);
 	}
 }
+
+template <>
+inline void read_shader_resource<ShaderResourceType::AccelerationStructure>(const spirv_cross::Compiler &compiler,
+                                                                            VkShaderStageFlagBits        stage,
+                                                                            std::vector<ShaderResource> &resources,
+                                                                            const ShaderVariant &        variant)
+{
+	auto acceleration_structure_resources = compiler.get_shader_resources().acceleration_structures;
+
+	for (auto &resource : acceleration_structure_resources)
+	{
+		ShaderResource shader_resource{};
+		shader_resource.type   = ShaderResourceType::AccelerationStructure;
+		shader_resource.stages = stage;
+		shader_resource.name   = resource.name;
+
+		read_resource_array_size(compiler, resource, shader_resource, variant);
+		read_resource_decoration<spv::DecorationDescriptorSet>(compiler, resource, shader_resource, variant);
+		read_resource_decoration<spv::DecorationBinding>(compiler, resource, shader_resource, variant);
+
+		resources.push_back(shader_resource);
+	}
+}
 }        // namespace
 
 bool SPIRVReflection::reflect_shader_resources(VkShaderStageFlagBits stage, const std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources, const ShaderVariant &variant)
@@ -398,6 +421,7 @@ void SPIRVReflection::parse_shader_resources(const spirv_cross::Compiler &compil
 	read_shader_resource<ShaderResourceType::Sampler>(compiler, stage, resources, variant);
 	read_shader_resource<ShaderResourceType::BufferUniform>(compiler, stage, resources, variant);
 	read_shader_resource<ShaderResourceType::BufferStorage>(compiler, stage, resources, variant);
+	read_shader_resource<ShaderResourceType::AccelerationStructure>(compiler, stage, resources, variant);
 }
 
 void SPIRVReflection::parse_push_constants(const spirv_cross::Compiler &compiler, VkShaderStageFlagBits stage, std::vector<ShaderResource> &resources, const ShaderVariant &variant)
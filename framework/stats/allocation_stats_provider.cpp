@@ -0,0 +1,67 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_stats_provider.h"
+
+namespace vkb
+{
+AllocationStatsProvider::AllocationStatsProvider(std::set<StatIndex> &requested_stats) :
+    last_total{AllocationTracker::get_total()}
+{
+	if (!AllocationTracker::is_enabled())
+	{
+		return;
+	}
+
+	for (auto index : {StatIndex::frame_allocations, StatIndex::frame_allocated_bytes})
+	{
+		// Remove any supported stats from the requested set.
+		// Subsequent providers will then only look for things that aren't already supported.
+		if (requested_stats.erase(index) > 0)
+		{
+			supported_stats.insert(index);
+		}
+	}
+}
+
+bool AllocationStatsProvider::is_available(StatIndex index) const
+{
+	return supported_stats.find(index) != supported_stats.end();
+}
+
+StatsProvider::Counters AllocationStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	auto total = AllocationTracker::get_total();
+
+	// Samples are taken once per frame, so the deltas are per frame
+	if (is_available(StatIndex::frame_allocations))
+	{
+		res[StatIndex::frame_allocations].result = static_cast<double>(total.count - last_total.count);
+	}
+
+	if (is_available(StatIndex::frame_allocated_bytes))
+	{
+		res[StatIndex::frame_allocated_bytes].result = static_cast<double>(total.bytes - last_total.bytes);
+	}
+
+	last_total = total;
+
+	return res;
+}
+}        // namespace vkb
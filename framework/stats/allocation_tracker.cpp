@@ -0,0 +1,148 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace vkb
+{
+namespace
+{
+std::atomic<uint64_t> total_count{0};
+
+std::atomic<uint64_t> total_bytes{0};
+
+// Plain integers so that reading them never allocates
+thread_local uint64_t thread_count{0};
+
+thread_local uint64_t thread_bytes{0};
+}        // namespace
+
+#if defined(VKB_ALLOCATION_TRACKING)
+namespace
+{
+void record_allocation(std::size_t size)
+{
+	// Only the totals matter, no ordering with other memory is needed
+	total_count.fetch_add(1, std::memory_order_relaxed);
+	total_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	++thread_count;
+	thread_bytes += size;
+}
+
+void *allocate(std::size_t size) noexcept
+{
+	record_allocation(size);
+
+	// A zero sized request must still return a unique pointer
+	return std::malloc(size > 0 ? size : 1);
+}
+}        // namespace
+#endif
+
+AllocationTracker::Scope::Scope() :
+    begin{get_thread_total()}
+{
+}
+
+AllocationTracker::Counts AllocationTracker::Scope::get() const
+{
+	auto end = get_thread_total();
+
+	return {end.count - begin.count, end.bytes - begin.bytes};
+}
+
+bool AllocationTracker::is_enabled()
+{
+#if defined(VKB_ALLOCATION_TRACKING)
+	return true;
+#else
+	return false;
+#endif
+}
+
+AllocationTracker::Counts AllocationTracker::get_total()
+{
+	return {total_count.load(std::memory_order_relaxed), total_bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationTracker::Counts AllocationTracker::get_thread_total()
+{
+	return {thread_count, thread_bytes};
+}
+}        // namespace vkb
+
+#if defined(VKB_ALLOCATION_TRACKING)
+void *operator new(std::size_t size)
+{
+	if (auto memory = vkb::allocate(size))
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	return vkb::allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	return vkb::allocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+	std::free(memory);
+}
+#endif
@@ -0,0 +1,72 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace vkb
+{
+/**
+ * @brief Counts the heap allocations made through the global operator new
+ *
+ * The replacement operators are only compiled when VKB_ALLOCATION_TRACKING is defined,
+ * otherwise every count stays at zero. Frees are not counted, the counts measure heap traffic rather than usage.
+ */
+class AllocationTracker
+{
+  public:
+	struct Counts
+	{
+		uint64_t count{0};
+
+		uint64_t bytes{0};
+	};
+
+	/**
+	 * @brief Counts the allocations of the calling thread until the end of the enclosing scope
+	 */
+	class Scope
+	{
+	  public:
+		Scope();
+
+		/**
+		 * @return The allocations of the calling thread since the scope began
+		 */
+		Counts get() const;
+
+	  private:
+		Counts begin;
+	};
+
+	/**
+	 * @return Whether the replacement operators are compiled in
+	 */
+	static bool is_enabled();
+
+	/**
+	 * @return The allocations of every thread since startup
+	 */
+	static Counts get_total();
+
+	/**
+	 * @return The allocations of the calling thread since it started
+	 */
+	static Counts get_thread_total();
+};
+}        // namespace vkb
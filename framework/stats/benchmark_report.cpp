@@ -0,0 +1,197 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+std::string escape_json(const std::string &text)
+{
+	std::string escaped;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+void write_statistics(std::ofstream &file, const std::vector<double> &values)
+{
+	if (values.empty())
+	{
+		file << "null";
+		return;
+	}
+
+	auto stats = BenchmarkReport::compute_statistics(values);
+
+	file << "{\"mean\":" << stats.mean << ",\"stddev\":" << stats.stddev
+	     << ",\"min\":" << stats.min << ",\"max\":" << stats.max
+	     << ",\"p50\":" << stats.p50 << ",\"p95\":" << stats.p95 << ",\"p99\":" << stats.p99 << "}";
+}
+}        // namespace
+
+BenchmarkReport::BenchmarkReport(uint32_t warmup_frames) :
+    warmup_frames{warmup_frames}
+{
+}
+
+void BenchmarkReport::begin_run(const std::string &name, const std::string &device)
+{
+	end_run();
+
+	Run run;
+	run.name   = name;
+	run.device = device;
+	runs.push_back(std::move(run));
+
+	frame_count = 0;
+	running     = true;
+}
+
+void BenchmarkReport::end_run()
+{
+	if (!running)
+	{
+		return;
+	}
+
+	running = false;
+
+	auto &run = runs.back();
+	if (run.cpu_times.empty())
+	{
+		LOGW("Benchmark run {} ended during its {} warmup frames", run.name, warmup_frames);
+		return;
+	}
+
+	auto cpu = compute_statistics(run.cpu_times);
+	LOGI("Benchmark {}: {} frames, CPU frame time mean {:.3f} ms, stddev {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}",
+	     run.name, run.cpu_times.size(), cpu.mean, cpu.stddev, cpu.p50, cpu.p95, cpu.p99);
+
+	if (!run.gpu_times.empty())
+	{
+		auto gpu = compute_statistics(run.gpu_times);
+		LOGI("Benchmark {}: GPU frame time mean {:.3f} ms, stddev {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}",
+		     run.name, gpu.mean, gpu.stddev, gpu.p50, gpu.p95, gpu.p99);
+	}
+}
+
+void BenchmarkReport::add_frame(double cpu_time, double gpu_time)
+{
+	if (!running || frame_count++ < warmup_frames)
+	{
+		return;
+	}
+
+	auto &run = runs.back();
+	run.cpu_times.push_back(cpu_time);
+
+	if (gpu_time >= 0.0)
+	{
+		run.gpu_times.push_back(gpu_time);
+	}
+}
+
+bool BenchmarkReport::write_json(const std::string &filename) const
+{
+	std::ofstream file{fs::path::get(fs::path::Type::Logs) + filename, std::ios::out | std::ios::trunc};
+
+	if (!file.good())
+	{
+		LOGE("Failed to open benchmark report file: {}", filename);
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(4) << "{\"warmup_frames\":" << warmup_frames << ",\"runs\":[";
+
+	for (size_t i = 0; i < runs.size(); ++i)
+	{
+		auto &run = runs[i];
+
+		file << (i == 0 ? "" : ",") << "\n{\"name\":\"" << escape_json(run.name) << "\",\"device\":\"" << escape_json(run.device)
+		     << "\",\"frames\":" << run.cpu_times.size() << ",\"cpu_frame_time_ms\":";
+		write_statistics(file, run.cpu_times);
+		file << ",\"gpu_frame_time_ms\":";
+		write_statistics(file, run.gpu_times);
+		file << "}";
+	}
+
+	file << "\n]}\n";
+
+	LOGI("Benchmark report written to {}", filename);
+
+	return file.good();
+}
+
+const std::vector<BenchmarkReport::Run> &BenchmarkReport::get_runs() const
+{
+	return runs;
+}
+
+BenchmarkReport::Statistics BenchmarkReport::compute_statistics(std::vector<double> values)
+{
+	Statistics stats;
+
+	if (values.empty())
+	{
+		return stats;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	double count = static_cast<double>(values.size());
+
+	stats.mean = std::accumulate(values.begin(), values.end(), 0.0) / count;
+
+	double variance = 0.0;
+	for (double value : values)
+	{
+		variance += (value - stats.mean) * (value - stats.mean);
+	}
+	stats.stddev = std::sqrt(variance / count);
+
+	stats.min = values.front();
+	stats.max = values.back();
+
+	auto percentile = [&values, count](double p) {
+		auto rank = static_cast<size_t>(std::ceil(p * count));
+		return values[std::max<size_t>(rank, 1) - 1];
+	};
+
+	stats.p50 = percentile(0.50);
+	stats.p95 = percentile(0.95);
+	stats.p99 = percentile(0.99);
+
+	return stats;
+}
+}        // namespace vkb
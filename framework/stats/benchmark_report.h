@@ -0,0 +1,120 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Collects the frame times of benchmark runs and reports their distribution
+ *
+ * A run is a sample, or one configuration of a sample in batch mode. Its first frames are
+ * warmup frames, they are not recorded. The report is written as JSON so runs can be
+ * compared across commits and devices.
+ */
+class BenchmarkReport
+{
+  public:
+	/**
+	 * @brief Distribution of a frame time, in milliseconds
+	 */
+	struct Statistics
+	{
+		double mean{0.0};
+
+		double stddev{0.0};
+
+		double min{0.0};
+
+		double max{0.0};
+
+		double p50{0.0};
+
+		double p95{0.0};
+
+		double p99{0.0};
+	};
+
+	struct Run
+	{
+		std::string name;
+
+		std::string device;
+
+		std::vector<double> cpu_times;
+
+		// Empty if the GPU time was not available
+		std::vector<double> gpu_times;
+	};
+
+	/**
+	 * @param warmup_frames Number of frames skipped at the start of every run
+	 */
+	BenchmarkReport(uint32_t warmup_frames = 0);
+
+	/**
+	 * @brief Ends the current run, if any, and starts a new one
+	 * @param name Name of the run
+	 * @param device Name of the GPU the run executes on
+	 */
+	void begin_run(const std::string &name, const std::string &device);
+
+	/**
+	 * @brief Ends the current run and logs its statistics
+	 */
+	void end_run();
+
+	/**
+	 * @brief Records a frame of the current run
+	 * @param cpu_time Frame time measured on the CPU, in milliseconds
+	 * @param gpu_time GPU time of the frame in milliseconds, negative if not available
+	 */
+	void add_frame(double cpu_time, double gpu_time);
+
+	/**
+	 * @brief Writes every run to a JSON file in the logs directory
+	 * @param filename The name of the file
+	 * @return Whether the file was written
+	 */
+	bool write_json(const std::string &filename) const;
+
+	/**
+	 * @return The runs recorded so far
+	 */
+	const std::vector<Run> &get_runs() const;
+
+	/**
+	 * @brief Computes the distribution of a set of values, percentiles use the nearest rank
+	 * @param values The values, they are sorted in place
+	 */
+	static Statistics compute_statistics(std::vector<double> values);
+
+  private:
+	uint32_t warmup_frames;
+
+	// Frames seen in the current run, warmup included
+	uint32_t frame_count{0};
+
+	bool running{false};
+
+	std::vector<Run> runs;
+};
+}        // namespace vkb
@@ -0,0 +1,74 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "command_buffer_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+CommandBufferStatsProvider::CommandBufferStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	// Remove any supported stats from the requested set.
+	// Subsequent providers will then only look for things that aren't already supported.
+	enabled = requested_stats.erase(StatIndex::command_buffer_redundant_calls) > 0;
+
+	if (enabled)
+	{
+		last_count = get_redundant_call_count();
+	}
+}
+
+bool CommandBufferStatsProvider::is_available(StatIndex index) const
+{
+	return enabled && index == StatIndex::command_buffer_redundant_calls;
+}
+
+StatsProvider::Counters CommandBufferStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	if (enabled)
+	{
+		uint64_t count = get_redundant_call_count();
+
+		res[StatIndex::command_buffer_redundant_calls].result = static_cast<double>(count - last_count);
+
+		last_count = count;
+	}
+
+	return res;
+}
+
+StatsProvider::Counters CommandBufferStatsProvider::continuous_sample(float delta_time)
+{
+	return sample(delta_time);
+}
+
+uint64_t CommandBufferStatsProvider::get_redundant_call_count() const
+{
+	uint64_t count = 0;
+
+	for (auto &frame : render_context.get_render_frames())
+	{
+		count += frame->get_redundant_call_count();
+	}
+
+	return count;
+}
+}        // namespace vkb
@@ -0,0 +1,70 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "stats_provider.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief Reports how many binding and dynamic state calls the command buffers of the
+ *        render frames skipped, as they would have set the state already bound
+ */
+class CommandBufferStatsProvider : public StatsProvider
+{
+  public:
+	/**
+	 * @brief Constructs a CommandBufferStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param render_context The render context
+	 */
+	CommandBufferStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 *        Stats are sampled once per frame when polling, so the count is per frame.
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+	/**
+	 * @brief Retrieve a new sample set from continuous sampling
+	 * @param delta_time Time since last sample
+	 */
+	Counters continuous_sample(float delta_time) override;
+
+  private:
+	uint64_t get_redundant_call_count() const;
+
+	RenderContext &render_context;
+
+	bool enabled{false};
+
+	// Redundant calls at the time of the last sample
+	uint64_t last_count{0};
+};
+}        // namespace vkb
@@ -0,0 +1,165 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpu_profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+struct Event
+{
+	const char *name;
+
+	uint64_t begin;
+
+	uint64_t end;
+
+	AllocationTracker::Counts allocations;
+};
+
+struct ThreadBuffer
+{
+	uint32_t thread_index;
+
+	/// Number of events written, the next one goes at head % RING_SIZE
+	std::atomic<uint64_t> head{0};
+
+	std::array<Event, CpuProfiler::RING_SIZE> events;
+};
+
+std::mutex &get_registry_mutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+/// Buffers outlive their threads so their zones can be exported
+std::vector<std::unique_ptr<ThreadBuffer>> &get_registry()
+{
+	static std::vector<std::unique_ptr<ThreadBuffer>> registry;
+	return registry;
+}
+
+ThreadBuffer &get_thread_buffer()
+{
+	thread_local ThreadBuffer *buffer = nullptr;
+
+	if (!buffer)
+	{
+		std::lock_guard<std::mutex> lock{get_registry_mutex()};
+
+		auto &registry = get_registry();
+		registry.emplace_back(std::make_unique<ThreadBuffer>());
+		registry.back()->thread_index = static_cast<uint32_t>(registry.size() - 1);
+
+		buffer = registry.back().get();
+	}
+
+	return *buffer;
+}
+}        // namespace
+
+CpuProfiler::Zone::Zone(const char *name) :
+    name{name},
+    begin{now()}
+{
+}
+
+CpuProfiler::Zone::~Zone()
+{
+	auto end = now();
+
+	// Read before registering the buffer, so that its allocation is not charged to the zone
+#if defined(VKB_ALLOCATION_TRACKING)
+	auto allocated = allocations.get();
+#else
+	AllocationTracker::Counts allocated;
+#endif
+
+	auto &buffer = get_thread_buffer();
+
+	// Only this thread writes its buffer, the release publishes the event to the exporter
+	auto head = buffer.head.load(std::memory_order_relaxed);
+
+	buffer.events[head % RING_SIZE] = {name, begin, end, allocated};
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t CpuProfiler::now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool CpuProfiler::write_chrome_trace(const std::string &filename)
+{
+	std::ofstream file{fs::path::get(fs::path::Type::Logs) + filename, std::ios::out | std::ios::trunc};
+
+	if (!file.good())
+	{
+		LOGE("Failed to open CPU trace file: {}", filename);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{get_registry_mutex()};
+
+	// Complete events, in microseconds
+	file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+	bool first = true;
+	for (auto &buffer : get_registry())
+	{
+		auto head  = buffer->head.load(std::memory_order_acquire);
+		auto count = std::min<uint64_t>(head, RING_SIZE);
+
+		for (auto i = head - count; i < head; ++i)
+		{
+			auto &event = buffer->events[i % RING_SIZE];
+
+			file << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_index
+			     << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0;
+
+			if (AllocationTracker::is_enabled())
+			{
+				file << ",\"args\":{\"allocations\":" << event.allocations.count << ",\"allocated_bytes\":" << event.allocations.bytes << "}";
+			}
+
+			file << "}";
+
+			first = false;
+		}
+	}
+
+	file << "\n]}\n";
+
+	LOGI("CPU trace written to {}", filename);
+
+	return true;
+}
+}        // namespace vkb
@@ -0,0 +1,93 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "allocation_tracker.h"
+
+namespace vkb
+{
+/**
+ * @brief Records scoped CPU zones into a ring buffer per thread, exported as a Chrome trace which Perfetto also reads
+ *
+ * Recording a zone reads the clock twice and writes an event into the buffer of its thread, without locks.
+ * Only the first zone of a thread locks, to register the buffer. Zones are compiled out unless VKB_CPU_PROFILING
+ * is defined, see VKB_PROFILE_ZONE. With VKB_ALLOCATION_TRACKING the heap allocations of each zone are recorded too.
+ */
+class CpuProfiler
+{
+  public:
+	/// Events kept per thread, the oldest are overwritten
+	static constexpr uint32_t RING_SIZE = 1 << 14;
+
+	class Zone
+	{
+	  public:
+		/**
+		 * @param name Name of the zone, it must outlive the profiler, e.g. a string literal
+		 */
+		Zone(const char *name);
+
+		Zone(const Zone &) = delete;
+
+		Zone(Zone &&) = delete;
+
+		~Zone();
+
+		Zone &operator=(const Zone &) = delete;
+
+		Zone &operator=(Zone &&) = delete;
+
+	  private:
+		const char *name;
+
+		uint64_t begin;
+
+#if defined(VKB_ALLOCATION_TRACKING)
+		AllocationTracker::Scope allocations;
+#endif
+	};
+
+	/**
+	 * @return The time in nanoseconds of a monotonic clock
+	 */
+	static uint64_t now();
+
+	/**
+	 * @brief Writes the recorded zones of every thread to a Chrome trace JSON file in the logs directory
+	 *        Zones recorded concurrently may be torn, so call it while the profiled threads are idle, e.g. on exit
+	 * @param filename The name of the file
+	 * @return Whether the file was written
+	 */
+	static bool write_chrome_trace(const std::string &filename);
+};
+}        // namespace vkb
+
+#if defined(VKB_CPU_PROFILING)
+#	define VKB_PROFILE_CONCAT_IMPL(a, b) a##b
+#	define VKB_PROFILE_CONCAT(a, b) VKB_PROFILE_CONCAT_IMPL(a, b)
+/**
+ * @brief Profiles the CPU time until the end of the enclosing scope
+ */
+#	define VKB_PROFILE_ZONE(name) ::vkb::CpuProfiler::Zone VKB_PROFILE_CONCAT(vkb_profile_zone_, __LINE__)(name)
+#else
+#	define VKB_PROFILE_ZONE(name)
+#endif
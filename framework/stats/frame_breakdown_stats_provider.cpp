@@ -0,0 +1,160 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_breakdown_stats_provider.h"
+
+#include <algorithm>
+
+#include "core/device.h"
+#include "gpu_profiler.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+FrameBreakdownStatsProvider::FrameBreakdownStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context, const GpuProfiler &gpu_profiler) :
+    render_context{render_context},
+    gpu_profiler{gpu_profiler}
+{
+	// The GPU time needs timestamps on the graphics queue
+	bool has_timestamps = render_context.get_device().get_gpu().get_properties().limits.timestampComputeAndGraphics;
+
+	// Remove any supported stats from the requested set.
+	// Subsequent providers will then only look for things that aren't already supported.
+	for (auto index : get_breakdown_stats())
+	{
+		if (index == StatIndex::frame_gpu_time && !has_timestamps)
+		{
+			continue;
+		}
+
+		if (requested_stats.erase(index) > 0)
+		{
+			enabled_stats.insert(index);
+		}
+	}
+
+	// The bubbles are not parts of the frame, they overlap the parts
+	if (requested_stats.erase(StatIndex::frame_cpu_bubble) > 0)
+	{
+		enabled_stats.insert(StatIndex::frame_cpu_bubble);
+	}
+
+	if (has_timestamps && requested_stats.erase(StatIndex::frame_gpu_bubble) > 0)
+	{
+		enabled_stats.insert(StatIndex::frame_gpu_bubble);
+	}
+
+#ifdef VK_KHR_present_wait
+	// The latency is measured by waiting for or polling the display of the frames
+	if (render_context.get_device().is_enabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		for (auto index : {StatIndex::frame_latency, StatIndex::frame_input_latency})
+		{
+			if (requested_stats.erase(index) > 0)
+			{
+				enabled_stats.insert(index);
+			}
+		}
+	}
+#endif
+
+	// The refresh cycles are counted by the swapchain or read back from the presentation timings
+	if (render_context.is_measuring_vblanks() && requested_stats.erase(StatIndex::frame_missed_vblanks) > 0)
+	{
+		enabled_stats.insert(StatIndex::frame_missed_vblanks);
+	}
+}
+
+bool FrameBreakdownStatsProvider::is_available(StatIndex index) const
+{
+	return enabled_stats.count(index) > 0;
+}
+
+StatsProvider::Counters FrameBreakdownStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	if (enabled_stats.empty())
+	{
+		return res;
+	}
+
+	const auto &timings = render_context.get_last_frame_timings();
+
+	const std::pair<StatIndex, double> parts[] = {{StatIndex::frame_pacing, timings.pacing},
+	                                              {StatIndex::frame_cpu_update, timings.cpu_update},
+	                                              {StatIndex::frame_acquire_wait, timings.acquire_wait},
+	                                              {StatIndex::frame_cpu_record, timings.cpu_record},
+	                                              {StatIndex::frame_submit, timings.submit},
+	                                              {StatIndex::frame_present_wait, timings.present_wait}};
+
+	for (const auto &part : parts)
+	{
+		if (is_available(part.first))
+		{
+			res[part.first].result = part.second;
+		}
+	}
+
+	if (is_available(StatIndex::frame_gpu_time) && !gpu_profiler.get_timings().empty())
+	{
+		// In seconds like the CPU parts
+		res[StatIndex::frame_gpu_time].result = gpu_profiler.get_frame_time() / 1000.0;
+	}
+
+	// Time the CPU is blocked on the GPU or the display, in the pacing and the acquisition
+	if (is_available(StatIndex::frame_cpu_bubble))
+	{
+		res[StatIndex::frame_cpu_bubble].result = timings.pacing + timings.acquire_wait;
+	}
+
+	// Time the GPU is idle between frames, the part of the frame not spent executing it
+	if (is_available(StatIndex::frame_gpu_bubble) && !gpu_profiler.get_timings().empty())
+	{
+		res[StatIndex::frame_gpu_bubble].result = std::max(delta_time - gpu_profiler.get_frame_time() / 1000.0, 0.0);
+	}
+
+	if (is_available(StatIndex::frame_latency))
+	{
+		res[StatIndex::frame_latency].result = timings.latency;
+	}
+
+	if (is_available(StatIndex::frame_input_latency))
+	{
+		res[StatIndex::frame_input_latency].result = timings.input_latency;
+	}
+
+	if (is_available(StatIndex::frame_missed_vblanks))
+	{
+		res[StatIndex::frame_missed_vblanks].result = timings.missed_vblanks;
+	}
+
+	return res;
+}
+
+const std::vector<StatIndex> &FrameBreakdownStatsProvider::get_breakdown_stats()
+{
+	static const std::vector<StatIndex> breakdown_stats = {StatIndex::frame_pacing,
+	                                                       StatIndex::frame_cpu_update,
+	                                                       StatIndex::frame_acquire_wait,
+	                                                       StatIndex::frame_cpu_record,
+	                                                       StatIndex::frame_submit,
+	                                                       StatIndex::frame_present_wait,
+	                                                       StatIndex::frame_gpu_time};
+	return breakdown_stats;
+}
+}        // namespace vkb
@@ -0,0 +1,69 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "stats_provider.h"
+
+namespace vkb
+{
+class GpuProfiler;
+class RenderContext;
+
+/**
+ * @brief Splits the frame time into the parts timed by the render context, plus the GPU
+ *        execution time of the profiled scopes, to tell whether a sample is CPU, GPU or
+ *        present bound
+ */
+class FrameBreakdownStatsProvider : public StatsProvider
+{
+  public:
+	/**
+	 * @brief Constructs a FrameBreakdownStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param render_context The render context timing the frames
+	 * @param gpu_profiler The profiler timing the GPU scopes of the frames
+	 */
+	FrameBreakdownStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context, const GpuProfiler &gpu_profiler);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 *        The CPU parts are those of the last frame that ended, the GPU time is a few frames older.
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+	/**
+	 * @return The stats this provider supplies, the CPU parts in frame order then the GPU time
+	 */
+	static const std::vector<StatIndex> &get_breakdown_stats();
+
+  private:
+	RenderContext &render_context;
+
+	const GpuProfiler &gpu_profiler;
+
+	std::set<StatIndex> enabled_stats;
+};
+}        // namespace vkb
@@ -17,19 +17,49 @@
 
 #include "frame_time_stats_provider.h"
 
+#include <algorithm>
+
+#include "job_system.h"
+
 namespace vkb
 {
-FrameTimeStatsProvider::FrameTimeStatsProvider(std::set<StatIndex> &requested_stats)
+FrameTimeStatsProvider::FrameTimeStatsProvider(std::set<StatIndex> &requested_stats, const JobSystem *job_system) :
+    job_system{job_system},
+    main_thread_timer{std::make_unique<ThreadCpuTimer>()}
 {
-	// We always, and only, support StatIndex::frame_times since it's handled directly by us.
+	// We always support StatIndex::frame_times since it's handled directly by us.
 	// Remove from requested set to stop other providers looking for it.
 	requested_stats.erase(StatIndex::frame_times);
+	supported_stats.insert(StatIndex::frame_times);
+
+	std::vector<StatIndex> thread_stats{StatIndex::cpu_main_thread_time, StatIndex::cpu_main_thread_busy};
+
+	if (job_system && !job_system->get_worker_cpu_timers().empty())
+	{
+		thread_stats.push_back(StatIndex::cpu_worker_thread_time);
+	}
+
+	if (main_thread_timer->counts_context_switches())
+	{
+		thread_stats.push_back(StatIndex::cpu_context_switches);
+	}
+
+	for (auto index : thread_stats)
+	{
+		if (requested_stats.erase(index) > 0)
+		{
+			supported_stats.insert(index);
+		}
+	}
+
+	last_main_cpu_time    = main_thread_timer->get_cpu_time();
+	last_worker_cpu_time  = get_worker_cpu_time();
+	last_context_switches = get_context_switches();
 }
 
 bool FrameTimeStatsProvider::is_available(StatIndex index) const
 {
-	// We only support StatIndex::frame_times
-	return index == StatIndex::frame_times;
+	return supported_stats.find(index) != supported_stats.end();
 }
 
 StatsProvider::Counters FrameTimeStatsProvider::sample(float delta_time)
@@ -37,7 +67,71 @@ StatsProvider::Counters FrameTimeStatsProvider::sample(float delta_time)
 	Counters res;
 	// frame_times comes directly from delta_time
 	res[StatIndex::frame_times].result = delta_time;
+
+	// Samples are taken once per frame on the main thread, so the deltas are per frame
+	auto main_cpu_time = main_thread_timer->get_cpu_time();
+
+	if (is_available(StatIndex::cpu_main_thread_time))
+	{
+		res[StatIndex::cpu_main_thread_time].result = main_cpu_time - last_main_cpu_time;
+	}
+
+	if (is_available(StatIndex::cpu_main_thread_busy))
+	{
+		res[StatIndex::cpu_main_thread_busy].result = delta_time > 0.0f ? std::min(1.0, (main_cpu_time - last_main_cpu_time) / delta_time) : 0.0;
+	}
+
+	last_main_cpu_time = main_cpu_time;
+
+	if (is_available(StatIndex::cpu_worker_thread_time))
+	{
+		auto worker_cpu_time = get_worker_cpu_time();
+
+		res[StatIndex::cpu_worker_thread_time].result = worker_cpu_time - last_worker_cpu_time;
+
+		last_worker_cpu_time = worker_cpu_time;
+	}
+
+	if (is_available(StatIndex::cpu_context_switches))
+	{
+		auto context_switches = get_context_switches();
+
+		res[StatIndex::cpu_context_switches].result = static_cast<double>(context_switches - last_context_switches);
+
+		last_context_switches = context_switches;
+	}
+
 	return res;
 }
 
+uint64_t FrameTimeStatsProvider::get_context_switches() const
+{
+	uint64_t count = main_thread_timer->get_context_switches();
+
+	if (job_system)
+	{
+		for (auto &timer : job_system->get_worker_cpu_timers())
+		{
+			count += timer->get_context_switches();
+		}
+	}
+
+	return count;
+}
+
+double FrameTimeStatsProvider::get_worker_cpu_time() const
+{
+	double cpu_time = 0.0;
+
+	if (job_system)
+	{
+		for (auto &timer : job_system->get_worker_cpu_timers())
+		{
+			cpu_time += timer->get_cpu_time();
+		}
+	}
+
+	return cpu_time;
+}
+
 }        // namespace vkb
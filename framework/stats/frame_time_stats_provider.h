@@ -17,18 +17,30 @@
 
 #pragma once
 
+#include <memory>
+
 #include "stats_provider.h"
+#include "thread_cpu_timer.h"
 
 namespace vkb
 {
+class JobSystem;
+
+/**
+ * @brief Reports the frame times, and the CPU time the main thread and the job workers ran for in each frame
+ *
+ * The CPU times come from the clocks of the threads, so a thread blocked on a fence or a present does not
+ * count as busy. The context switches of the threads are counted where ThreadCpuTimer supports them.
+ */
 class FrameTimeStatsProvider : public StatsProvider
 {
   public:
 	/**
-	 * @brief Constructs a FrameTimeStatsProvider
+	 * @brief Constructs a FrameTimeStatsProvider on the main thread, which it measures
 	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param job_system Optional job system whose workers are measured
 	 */
-	FrameTimeStatsProvider(std::set<StatIndex> &requested_stats);
+	FrameTimeStatsProvider(std::set<StatIndex> &requested_stats, const JobSystem *job_system = nullptr);
 	/**
 	 * @brief Checks if this provider can supply the given enabled stat
 	 * @param index The stat index
@@ -41,5 +53,28 @@ class FrameTimeStatsProvider : public StatsProvider
 	 * @param delta_time Time since last sample
 	 */
 	Counters sample(float delta_time) override;
+
+  private:
+	/**
+	 * @return The number of context switches of the main thread and the workers
+	 */
+	uint64_t get_context_switches() const;
+
+	/**
+	 * @return The CPU time of the workers in seconds
+	 */
+	double get_worker_cpu_time() const;
+
+	std::set<StatIndex> supported_stats;
+
+	const JobSystem *job_system;
+
+	std::unique_ptr<ThreadCpuTimer> main_thread_timer;
+
+	double last_main_cpu_time{0.0};
+
+	double last_worker_cpu_time{0.0};
+
+	uint64_t last_context_switches{0};
 };
 }        // namespace vkb
@@ -0,0 +1,156 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gpu_profiler.h"
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+GpuProfiler::GpuProfiler(RenderContext &render_context, uint32_t max_scopes) :
+    render_context{render_context},
+    max_scopes{max_scopes}
+{
+	auto &limits = render_context.get_device().get_gpu().get_properties().limits;
+
+	supported        = limits.timestampComputeAndGraphics;
+	timestamp_period = limits.timestampPeriod;
+}
+
+bool GpuProfiler::is_supported() const
+{
+	return supported;
+}
+
+GpuProfiler::FrameQueries &GpuProfiler::get_active_frame_queries()
+{
+	if (frames.size() != render_context.get_render_frames().size())
+	{
+		frames.clear();
+		frames.resize(render_context.get_render_frames().size());
+	}
+
+	return frames.at(render_context.get_active_frame_index());
+}
+
+void GpuProfiler::begin_frame(CommandBuffer &command_buffer)
+{
+	if (!supported)
+	{
+		return;
+	}
+
+	auto &frame = get_active_frame_queries();
+
+	if (!frame.query_pool)
+	{
+		VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		query_pool_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount = max_scopes * 2;
+
+		frame.query_pool = std::make_unique<QueryPool>(render_context.get_device(), query_pool_info);
+	}
+	else if (!frame.scopes.empty())
+	{
+		// The fence of the frame was waited on, the timestamps are available without waiting
+		std::vector<uint64_t> timestamps(frame.scopes.size() * 2);
+
+		auto result = frame.query_pool->get_results(0, to_u32(timestamps.size()),
+		                                            timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+		                                            VK_QUERY_RESULT_64_BIT);
+
+		if (result == VK_SUCCESS)
+		{
+			timings.clear();
+
+			for (size_t i = 0; i < frame.scopes.size(); ++i)
+			{
+				auto elapsed_ns = timestamp_period * static_cast<float>(timestamps[i * 2 + 1] - timestamps[i * 2]);
+
+				timings.push_back({frame.scopes[i].name, frame.scopes[i].depth, elapsed_ns / 1000000.0f});
+			}
+		}
+	}
+
+	frame.scopes.clear();
+	open_scopes.clear();
+
+	command_buffer.reset_query_pool(*frame.query_pool, 0, max_scopes * 2);
+}
+
+void GpuProfiler::push_scope(CommandBuffer &command_buffer, const std::string &name)
+{
+	if (!supported)
+	{
+		return;
+	}
+
+	auto &frame = get_active_frame_queries();
+
+	if (!frame.query_pool || frame.scopes.size() >= max_scopes)
+	{
+		open_scopes.push_back(max_scopes);
+		return;
+	}
+
+	auto index = to_u32(frame.scopes.size());
+
+	frame.scopes.push_back({name, to_u32(open_scopes.size())});
+	open_scopes.push_back(index);
+
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *frame.query_pool, index * 2);
+}
+
+void GpuProfiler::pop_scope(CommandBuffer &command_buffer)
+{
+	if (!supported)
+	{
+		return;
+	}
+
+	assert(!open_scopes.empty() && "No GPU scope to pop");
+
+	auto index = open_scopes.back();
+	open_scopes.pop_back();
+
+	if (index != max_scopes)
+	{
+		command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *get_active_frame_queries().query_pool, index * 2 + 1);
+	}
+}
+
+const std::vector<GpuProfiler::ScopeTiming> &GpuProfiler::get_timings() const
+{
+	return timings;
+}
+
+float GpuProfiler::get_frame_time() const
+{
+	// Nested scopes are already included in their outermost scope
+	float frame_time = 0.0f;
+	for (const auto &timing : timings)
+	{
+		if (timing.depth == 0)
+		{
+			frame_time += timing.gpu_time_ms;
+		}
+	}
+
+	return frame_time;
+}
+}        // namespace vkb
@@ -0,0 +1,128 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Times named scopes of the primary command buffer of each frame with GPU timestamps
+ *
+ * Each render frame has its own query pool. The scopes of a frame are resolved when the frame
+ * is recorded again, once its fence has been waited on, so reading the results never stalls.
+ * Scopes are opened through CommandBuffer::push_gpu_scope, which also labels them for debuggers.
+ */
+class GpuProfiler
+{
+  public:
+	struct ScopeTiming
+	{
+		std::string name;
+
+		/// Number of scopes enclosing the scope
+		uint32_t depth;
+
+		float gpu_time_ms;
+	};
+
+	static constexpr uint32_t DEFAULT_MAX_SCOPES = 128;
+
+	/**
+	 * @param render_context The context whose frames are profiled
+	 * @param max_scopes Maximum number of scopes per frame, the following ones are not timed
+	 */
+	GpuProfiler(RenderContext &render_context, uint32_t max_scopes = DEFAULT_MAX_SCOPES);
+
+	GpuProfiler(const GpuProfiler &) = delete;
+
+	GpuProfiler(GpuProfiler &&) = delete;
+
+	~GpuProfiler() = default;
+
+	GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+	GpuProfiler &operator=(GpuProfiler &&) = delete;
+
+	/**
+	 * @return Whether the queues support timestamps, the scopes are only labelled otherwise
+	 */
+	bool is_supported() const;
+
+	/**
+	 * @brief Resolves the scopes recorded the last time the active frame was used, and resets its queries
+	 * @param command_buffer The primary command buffer of the active frame, outside of a render pass
+	 */
+	void begin_frame(CommandBuffer &command_buffer);
+
+	void push_scope(CommandBuffer &command_buffer, const std::string &name);
+
+	void pop_scope(CommandBuffer &command_buffer);
+
+	/**
+	 * @return The timings of the last resolved frame, in the order the scopes were opened
+	 */
+	const std::vector<ScopeTiming> &get_timings() const;
+
+	/**
+	 * @return The GPU time of the outermost scopes of the last resolved frame, in milliseconds
+	 */
+	float get_frame_time() const;
+
+  private:
+	struct Scope
+	{
+		std::string name;
+
+		uint32_t depth;
+	};
+
+	struct FrameQueries
+	{
+		std::unique_ptr<QueryPool> query_pool;
+
+		/// Scope i is timed by queries 2i and 2i + 1
+		std::vector<Scope> scopes;
+	};
+
+	FrameQueries &get_active_frame_queries();
+
+	RenderContext &render_context;
+
+	uint32_t max_scopes;
+
+	float timestamp_period{1.0f};
+
+	bool supported{false};
+
+	std::vector<FrameQueries> frames;
+
+	/// Indices of the open scopes of the active frame, max_scopes for the untimed ones
+	std::vector<uint32_t> open_scopes;
+
+	std::vector<ScopeTiming> timings;
+};
+}        // namespace vkb
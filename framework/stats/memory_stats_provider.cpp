@@ -0,0 +1,110 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_stats_provider.h"
+
+#include <algorithm>
+
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+MemoryStatsProvider::MemoryStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	for (auto index : {StatIndex::memory_usage, StatIndex::memory_budget, StatIndex::memory_heap_pressure,
+	                   StatIndex::memory_allocation_count, StatIndex::memory_fragmentation})
+	{
+		// Remove any supported stats from the requested set.
+		// Subsequent providers will then only look for things that aren't already supported.
+		if (requested_stats.erase(index) > 0)
+		{
+			supported_stats.insert(index);
+		}
+	}
+}
+
+bool MemoryStatsProvider::is_available(StatIndex index) const
+{
+	return supported_stats.find(index) != supported_stats.end();
+}
+
+StatsProvider::Counters MemoryStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	auto allocator = render_context.get_device().get_memory_allocator();
+
+	const VkPhysicalDeviceMemoryProperties *memory_properties{nullptr};
+	vmaGetMemoryProperties(allocator, &memory_properties);
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+	vmaGetBudget(allocator, budgets);
+
+	VkDeviceSize usage{0};
+	VkDeviceSize budget{0};
+	double       heap_pressure{0.0};
+
+	for (uint32_t i = 0; i < memory_properties->memoryHeapCount; ++i)
+	{
+		usage += budgets[i].usage;
+		budget += budgets[i].budget;
+
+		if (budgets[i].budget > 0)
+		{
+			heap_pressure = std::max(heap_pressure, static_cast<double>(budgets[i].usage) / budgets[i].budget);
+		}
+	}
+
+	if (is_available(StatIndex::memory_usage))
+	{
+		res[StatIndex::memory_usage].result = static_cast<double>(usage);
+	}
+
+	if (is_available(StatIndex::memory_budget))
+	{
+		res[StatIndex::memory_budget].result = static_cast<double>(budget);
+	}
+
+	if (is_available(StatIndex::memory_heap_pressure))
+	{
+		res[StatIndex::memory_heap_pressure].result = heap_pressure;
+	}
+
+	// Calculating the stats walks all the allocations, only do it if needed
+	if (is_available(StatIndex::memory_allocation_count) || is_available(StatIndex::memory_fragmentation))
+	{
+		VmaStats stats{};
+		vmaCalculateStats(allocator, &stats);
+
+		res[StatIndex::memory_allocation_count].result = static_cast<double>(stats.total.allocationCount);
+
+		// Share of the memory blocks which is not used by any allocation
+		auto block_bytes = stats.total.usedBytes + stats.total.unusedBytes;
+
+		res[StatIndex::memory_fragmentation].result = block_bytes > 0 ? static_cast<double>(stats.total.unusedBytes) / block_bytes : 0.0;
+	}
+
+	return res;
+}
+
+StatsProvider::Counters MemoryStatsProvider::continuous_sample(float delta_time)
+{
+	return sample(delta_time);
+}
+}        // namespace vkb
@@ -0,0 +1,220 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipeline_statistics_stats_provider.h"
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+// Results are written in the order of the flag bits, lowest first
+const VkQueryPipelineStatisticFlags pipeline_statistics =
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+enum PipelineStatistic
+{
+	VertexInvocations,
+	ClippingPrimitives,
+	FragmentInvocations,
+	ComputeInvocations,
+	PipelineStatisticCount
+};
+
+const std::set<StatIndex> pipeline_statistic_stats = {StatIndex::gpu_vertex_invocations,
+                                                      StatIndex::gpu_clipping_primitives,
+                                                      StatIndex::gpu_fragment_invocations,
+                                                      StatIndex::gpu_compute_invocations,
+                                                      StatIndex::gpu_overdraw};
+}        // namespace
+
+PipelineStatisticsStatsProvider::PipelineStatisticsStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	Device &    device     = render_context.get_device();
+	const auto &features   = device.get_gpu().get_requested_features();
+	uint32_t    num_frames = to_u32(render_context.get_render_frames().size());
+
+	bool want_statistics = std::any_of(pipeline_statistic_stats.begin(), pipeline_statistic_stats.end(),
+	                                   [&requested_stats](StatIndex index) { return requested_stats.count(index) > 0; });
+
+	if (want_statistics && features.pipelineStatisticsQuery)
+	{
+		VkQueryPoolCreateInfo info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		info.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		info.queryCount         = 1;
+		info.pipelineStatistics = pipeline_statistics;
+
+		statistics_queries = std::make_unique<QueryPoolRing>(device, info, num_frames);
+
+		// Remove any supported stats from the requested set.
+		// Subsequent providers will then only look for things that aren't already supported.
+		for (auto index : pipeline_statistic_stats)
+		{
+			if (requested_stats.erase(index) > 0)
+			{
+				enabled_stats.insert(index);
+			}
+		}
+	}
+	else if (want_statistics)
+	{
+		LOGW("Pipeline statistics queries are not enabled, the pipeline statistics stats won't be collected");
+	}
+
+	if (requested_stats.count(StatIndex::gpu_samples_passed))
+	{
+		VkQueryPoolCreateInfo info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		info.queryType  = VK_QUERY_TYPE_OCCLUSION;
+		info.queryCount = 1;
+
+		occlusion_queries = std::make_unique<QueryPoolRing>(device, info, num_frames);
+
+		// Without precise occlusion queries the count is only guaranteed to be non-zero when samples pass
+		if (features.occlusionQueryPrecise)
+		{
+			occlusion_flags = VK_QUERY_CONTROL_PRECISE_BIT;
+		}
+		else
+		{
+			LOGW("Precise occlusion queries are not enabled, the samples passed count may be approximate");
+		}
+
+		requested_stats.erase(StatIndex::gpu_samples_passed);
+		enabled_stats.insert(StatIndex::gpu_samples_passed);
+	}
+}
+
+bool PipelineStatisticsStatsProvider::is_available(StatIndex index) const
+{
+	return enabled_stats.count(index) > 0;
+}
+
+void PipelineStatisticsStatsProvider::begin_sampling(CommandBuffer &cb)
+{
+	uint32_t active_frame_idx = render_context.get_active_frame_index();
+
+	// Queries must be reset outside of a render pass before they are begun
+	if (statistics_queries)
+	{
+		cb.begin_query(statistics_queries->get_pool(), statistics_queries->begin_range(cb, active_frame_idx), VkQueryControlFlags(0));
+	}
+
+	if (occlusion_queries)
+	{
+		cb.begin_query(occlusion_queries->get_pool(), occlusion_queries->begin_range(cb, active_frame_idx), occlusion_flags);
+	}
+}
+
+void PipelineStatisticsStatsProvider::end_sampling(CommandBuffer &cb)
+{
+	uint32_t active_frame_idx = render_context.get_active_frame_index();
+
+	if (statistics_queries)
+	{
+		cb.end_query(statistics_queries->get_pool(), active_frame_idx);
+		statistics_queries->end_range(active_frame_idx);
+	}
+
+	if (occlusion_queries)
+	{
+		cb.end_query(occlusion_queries->get_pool(), active_frame_idx);
+		occlusion_queries->end_range(active_frame_idx);
+	}
+}
+
+StatsProvider::Counters PipelineStatisticsStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	// The active frame was last submitted a full swapchain cycle ago, and its fence has been
+	// waited on, so its queries are normally complete already
+	uint32_t active_frame_idx = render_context.get_active_frame_index();
+
+	if (enabled_stats.empty())
+	{
+		return res;
+	}
+
+	sample_pipeline_statistics(active_frame_idx, res);
+	sample_occlusion(active_frame_idx, res);
+
+	return res;
+}
+
+void PipelineStatisticsStatsProvider::sample_pipeline_statistics(uint32_t frame_index, Counters &res)
+{
+	if (!statistics_queries)
+	{
+		return;
+	}
+
+	std::array<uint64_t, PipelineStatisticCount> results{};
+
+	if (!statistics_queries->get_results(frame_index, results.data(), results.size() * sizeof(uint64_t),
+	                                     results.size() * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT))
+	{
+		return;
+	}
+
+	const std::pair<StatIndex, PipelineStatistic> counters[] = {{StatIndex::gpu_vertex_invocations, VertexInvocations},
+	                                                            {StatIndex::gpu_clipping_primitives, ClippingPrimitives},
+	                                                            {StatIndex::gpu_fragment_invocations, FragmentInvocations},
+	                                                            {StatIndex::gpu_compute_invocations, ComputeInvocations}};
+
+	for (const auto &counter : counters)
+	{
+		if (is_available(counter.first))
+		{
+			res[counter.first].result = static_cast<double>(results[counter.second]);
+		}
+	}
+
+	if (is_available(StatIndex::gpu_overdraw))
+	{
+		// Fragment shader invocations per pixel of the surface, summed over every pass of the frame
+		VkExtent2D extent = render_context.get_surface_extent();
+		double     pixels = static_cast<double>(extent.width) * static_cast<double>(extent.height);
+
+		if (pixels > 0.0)
+		{
+			res[StatIndex::gpu_overdraw].result = static_cast<double>(results[FragmentInvocations]) / pixels;
+		}
+	}
+}
+
+void PipelineStatisticsStatsProvider::sample_occlusion(uint32_t frame_index, Counters &res)
+{
+	if (!occlusion_queries)
+	{
+		return;
+	}
+
+	uint64_t samples_passed = 0;
+
+	if (occlusion_queries->get_results(frame_index, &samples_passed, sizeof(uint64_t), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT))
+	{
+		res[StatIndex::gpu_samples_passed].result = static_cast<double>(samples_passed);
+	}
+}
+}        // namespace vkb
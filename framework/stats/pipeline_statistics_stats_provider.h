@@ -0,0 +1,90 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "core/query_pool.h"
+#include "stats_provider.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief Reports the shader invocation and primitive counts of the render frames, plus
+ *        the samples that passed the depth and stencil tests, using a pipeline statistics
+ *        and an occlusion query spanning each sampled command buffer
+ *
+ *        Vulkan does not allow two queries of the same type to be active at once, so the
+ *        counts cover whole frames. Secondary command buffers executed while sampling need
+ *        the inheritedQueries feature.
+ */
+class PipelineStatisticsStatsProvider : public StatsProvider
+{
+  public:
+	/**
+	 * @brief Constructs a PipelineStatisticsStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param render_context The render context
+	 */
+	PipelineStatisticsStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 *        Stats are sampled once per frame when polling, so the count is per frame.
+	 *        Results that are not available yet are skipped, the sample never waits on the GPU.
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+	/**
+	 * @brief A command buffer that we want stats about has just begun
+	 * @param cb The command buffer
+	 */
+	void begin_sampling(CommandBuffer &cb) override;
+
+	/**
+	 * @brief A command buffer that we want stats about is about to be ended
+	 * @param cb The command buffer
+	 */
+	void end_sampling(CommandBuffer &cb) override;
+
+  private:
+	void sample_pipeline_statistics(uint32_t frame_index, Counters &res);
+
+	void sample_occlusion(uint32_t frame_index, Counters &res);
+
+	RenderContext &render_context;
+
+	std::set<StatIndex> enabled_stats;
+
+	// One pipeline statistics query per render frame
+	std::unique_ptr<QueryPoolRing> statistics_queries;
+
+	// One occlusion query per render frame
+	std::unique_ptr<QueryPoolRing> occlusion_queries;
+
+	VkQueryControlFlags occlusion_flags{0};
+};
+}        // namespace vkb
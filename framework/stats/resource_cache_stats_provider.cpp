@@ -0,0 +1,121 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "resource_cache_stats_provider.h"
+
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+ResourceCacheStatsProvider::ResourceCacheStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	// clang-format off
+	StatDataMap cache_stats = {
+	    {StatIndex::cache_shader_module_contentions,         &ResourceCacheContention::shader_modules},
+	    {StatIndex::cache_pipeline_layout_contentions,       &ResourceCacheContention::pipeline_layouts},
+	    {StatIndex::cache_descriptor_set_layout_contentions, &ResourceCacheContention::descriptor_set_layouts},
+	    {StatIndex::cache_descriptor_set_contentions,        &ResourceCacheContention::descriptor_sets},
+	    {StatIndex::cache_render_pass_contentions,           &ResourceCacheContention::render_passes},
+	    {StatIndex::cache_graphics_pipeline_contentions,     &ResourceCacheContention::graphics_pipelines},
+	    {StatIndex::cache_compute_pipeline_contentions,      &ResourceCacheContention::compute_pipelines},
+	    {StatIndex::cache_framebuffer_contentions,           &ResourceCacheContention::framebuffers}};
+
+	EntriesDataMap entries_stats = {
+	    {StatIndex::cache_graphics_pipeline_count, &ResourceCacheEntries::graphics_pipelines},
+	    {StatIndex::cache_compute_pipeline_count,  &ResourceCacheEntries::compute_pipelines},
+	    {StatIndex::cache_descriptor_set_count,    &ResourceCacheEntries::descriptor_sets},
+	    {StatIndex::cache_framebuffer_count,       &ResourceCacheEntries::framebuffers},
+	    {StatIndex::cache_memory,                  &ResourceCacheEntries::bytes}};
+	// clang-format on
+
+	auto contention = render_context.get_device().get_resource_cache().get_contention();
+
+	for (const auto &stat : cache_stats)
+	{
+		if (requested_stats.find(stat.first) != requested_stats.end())
+		{
+			stat_data[stat.first]   = stat.second;
+			last_counts[stat.first] = contention.*stat.second;
+		}
+	}
+
+	for (const auto &stat : entries_stats)
+	{
+		if (requested_stats.find(stat.first) != requested_stats.end())
+		{
+			entries_data[stat.first] = stat.second;
+		}
+	}
+
+	// Remove any supported stats from the requested set.
+	// Subsequent providers will then only look for things that aren't already supported.
+	for (const auto &iter : stat_data)
+	{
+		requested_stats.erase(iter.first);
+	}
+
+	for (const auto &iter : entries_data)
+	{
+		requested_stats.erase(iter.first);
+	}
+}
+
+bool ResourceCacheStatsProvider::is_available(StatIndex index) const
+{
+	return stat_data.find(index) != stat_data.end() || entries_data.find(index) != entries_data.end();
+}
+
+StatsProvider::Counters ResourceCacheStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	auto contention = render_context.get_device().get_resource_cache().get_contention();
+
+	for (const auto &iter : stat_data)
+	{
+		uint64_t count = contention.*iter.second;
+
+		double d = static_cast<double>(count - last_counts[iter.first]);
+		if (delta_time != 0.0f)
+		{
+			d /= delta_time;
+		}
+
+		last_counts[iter.first] = count;
+		res[iter.first].result  = d;
+	}
+
+	if (!entries_data.empty())
+	{
+		auto entries = render_context.get_device().get_resource_cache().get_entries();
+
+		for (const auto &iter : entries_data)
+		{
+			res[iter.first].result = static_cast<double>(entries.*iter.second);
+		}
+	}
+
+	return res;
+}
+
+StatsProvider::Counters ResourceCacheStatsProvider::continuous_sample(float delta_time)
+{
+	return sample(delta_time);
+}
+}        // namespace vkb
@@ -0,0 +1,83 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "stats_provider.h"
+
+namespace vkb
+{
+class RenderContext;
+
+struct ResourceCacheContention;
+
+struct ResourceCacheEntries;
+
+/**
+ * @brief Reports how often the maps of the device ResourceCache were contended
+ *        by threads requesting resources concurrently, and how many entries they hold
+ */
+class ResourceCacheStatsProvider : public StatsProvider
+{
+  private:
+	using ContentionGetter = uint64_t ResourceCacheContention::*;
+
+	using StatDataMap = std::unordered_map<StatIndex, ContentionGetter, StatIndexHash>;
+
+	using EntriesGetter = uint64_t ResourceCacheEntries::*;
+
+	using EntriesDataMap = std::unordered_map<StatIndex, EntriesGetter, StatIndexHash>;
+
+  public:
+	/**
+	 * @brief Constructs a ResourceCacheStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param render_context The render context
+	 */
+	ResourceCacheStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+	/**
+	 * @brief Retrieve a new sample set from continuous sampling
+	 * @param delta_time Time since last sample
+	 */
+	Counters continuous_sample(float delta_time) override;
+
+  private:
+	RenderContext &render_context;
+
+	// Only stats which were requested end up in stat_data and entries_data
+	StatDataMap stat_data;
+
+	EntriesDataMap entries_data;
+
+	// Contention counts at the time of the last sample
+	std::unordered_map<StatIndex, uint64_t, StatIndexHash> last_counts;
+};
+}        // namespace vkb
@@ -18,16 +18,26 @@
 
 #include "stats/stats.h"
 #include "common/error.h"
+#include "core/command_buffer.h"
 #include "core/device.h"
+#include "platform/filesystem.h"
+#include "stats/cpu_profiler.h"
 
+#include "allocation_stats_provider.h"
+#include "command_buffer_stats_provider.h"
+#include "frame_breakdown_stats_provider.h"
 #include "frame_time_stats_provider.h"
 #include "hwcpipe_stats_provider.h"
+#include "memory_stats_provider.h"
+#include "pipeline_statistics_stats_provider.h"
+#include "resource_cache_stats_provider.h"
 #include "vulkan_stats_provider.h"
 
 namespace vkb
 {
 Stats::Stats(RenderContext &render_context, size_t buffer_size) :
     render_context(render_context),
+    gpu_profiler(std::make_unique<GpuProfiler>(render_context)),
     buffer_size(buffer_size)
 {
 	assert(buffer_size >= 2 && "Buffers size should be greater than 2");
@@ -63,9 +73,17 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 	// Initialize our list of providers (in priority order)
 	// All supported stats will be removed from the given 'stats' set by the provider's constructor
 	// so subsequent providers only see requests for stats that aren't already supported.
-	providers.emplace_back(std::make_unique<FrameTimeStatsProvider>(stats));
+	providers.emplace_back(std::make_unique<FrameTimeStatsProvider>(stats, job_system));
 	providers.emplace_back(std::make_unique<HWCPipeStatsProvider>(stats));
-	providers.emplace_back(std::make_unique<VulkanStatsProvider>(stats, sampling_config, render_context));
+	providers.emplace_back(std::make_unique<ResourceCacheStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<MemoryStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<CommandBufferStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<PipelineStatisticsStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<FrameBreakdownStatsProvider>(stats, render_context, *gpu_profiler));
+	providers.emplace_back(std::make_unique<AllocationStatsProvider>(stats));
+	auto vulkan_provider  = std::make_unique<VulkanStatsProvider>(stats, sampling_config, render_context, vulkan_counter_names);
+	vulkan_stats_provider = vulkan_provider.get();
+	providers.emplace_back(std::move(vulkan_provider));
 
 	// In continuous sampling mode we still need to update the frame times as if we are polling
 	// Store the frame time provider here so we can easily access it later.
@@ -76,8 +94,19 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 		counters[stat] = std::vector<float>(buffer_size, 0);
 	}
 
+	// Opened before the worker starts writing to it
+	if (!stream_filename.empty())
+	{
+		open_stream();
+	}
+
 	if (sampling_config.mode == CounterSamplingMode::Continuous)
 	{
+		// Preallocate the storage of the samples, so that neither thread allocates to hand them over
+		ContinuousSample slot;
+		slot.values.reserve(requested_stats.size());
+		continuous_samples = std::make_unique<SpscRing<ContinuousSample>>(MAX_PENDING_SAMPLES, slot);
+
 		// Start a thread for continuous sample capture
 		stop_worker = std::make_unique<std::promise<void>>();
 
@@ -147,54 +176,45 @@ void Stats::update(float delta_time)
 				sample.insert(s.begin(), s.end());
 			}
 			push_sample(sample);
+
+			if (stream)
+			{
+				stream_sample(sample);
+			}
 			break;
 		}
 		case CounterSamplingMode::Continuous:
 		{
-			// Check that we have no pending samples to be shown
-			if (pending_samples.size() == 0)
-			{
-				std::unique_lock<std::mutex> lock(continuous_sampling_mutex);
-				if (!should_add_to_continuous_samples)
-				{
-					// If we have no pending samples, we let the worker thread
-					// capture samples for the next frame
-					should_add_to_continuous_samples = true;
-				}
-				else
-				{
-					// The worker thread has captured a frame, so we stop it
-					// and read the samples
-					should_add_to_continuous_samples = false;
-					pending_samples                  = continuous_samples;
-					continuous_samples.clear();
-				}
-			}
+			// The ring is capped, so the worker stops adding samples while we are behind
+			size_t pending_count = continuous_samples->size();
 
-			if (pending_samples.size() == 0)
+			if (pending_count == 0)
 				return;
 
-			// Ensure the number of pending samples is capped at a reasonable value
-			if (pending_samples.size() > 100)
-				pending_samples.resize(100);
-
 			// Compute the number of samples to show this frame
-			size_t sample_count = static_cast<size_t>(sampling_config.speed * delta_time) * pending_samples.size();
+			size_t sample_count = static_cast<size_t>(sampling_config.speed * delta_time) * pending_count;
 
 			// Clamp the number of samples
-			sample_count = std::max<size_t>(1, std::min<size_t>(sample_count, pending_samples.size()));
+			sample_count = std::max<size_t>(1, std::min<size_t>(sample_count, pending_count));
 
 			// Get the frame time stats (not a continuous stat)
 			StatsProvider::Counters frame_time_sample = frame_time_provider->sample(delta_time);
 
-			// Push the samples to circular buffers
-			std::for_each(pending_samples.end() - sample_count, pending_samples.end(), [this, frame_time_sample](auto &s) {
-				// Write the correct frame time into the continuous stats
-				s.insert(frame_time_sample.begin(), frame_time_sample.end());
-				// Then push the sample to the counters list
-				this->push_sample(s);
-			});
-			pending_samples.erase(pending_samples.end() - sample_count, pending_samples.end());
+			// The worker streamed the continuous samples already
+			if (stream)
+			{
+				stream_sample(frame_time_sample);
+			}
+
+			// Push the oldest samples to circular buffers, and hand their slots back to the worker
+			for (size_t i = 0; i < sample_count; ++i)
+			{
+				push_sample(*continuous_samples->front());
+				continuous_samples->pop();
+
+				// Write the correct frame time along with the continuous stats
+				push_sample(frame_time_sample);
+			}
 
 			break;
 		}
@@ -220,18 +240,44 @@ void Stats::continuous_sampling_worker(std::future<void> should_terminate)
 			delta_time += static_cast<float>(worker_timer.tick());
 		}
 
-		// Sample counters
-		StatsProvider::Counters sample;
+		// Sample counters. The providers are sampled even when the ring is full, so their deltas stay consistent
+		ContinuousSample *sample = continuous_samples->begin_push();
+		if (sample)
+		{
+			sample->values.clear();
+		}
+
+		// The stream keeps the samples the ring drops
+		worker_stream_values.clear();
+		auto timestamp = CpuProfiler::now();
+
 		for (auto &p : providers)
 		{
 			StatsProvider::Counters s = p->continuous_sample(delta_time);
-			sample.insert(s.begin(), s.end());
+
+			if (sample)
+			{
+				for (const auto &c : s)
+				{
+					sample->values.emplace_back(c.first, c.second.result);
+				}
+			}
+
+			if (stream)
+			{
+				add_stream_values(s, worker_stream_values);
+			}
 		}
 
-		// Add the new sample to the vector of continuous samples
+		// Hand the new sample over to the main thread
+		if (sample)
 		{
-			std::unique_lock<std::mutex> lock(continuous_sampling_mutex);
-			continuous_samples.push_back(sample);
+			continuous_samples->end_push();
+		}
+
+		if (stream)
+		{
+			stream->write(timestamp, worker_stream_values);
 		}
 	}
 }
@@ -254,11 +300,27 @@ void Stats::push_sample(const StatsProvider::Counters &sample)
 	}
 }
 
+void Stats::push_sample(const ContinuousSample &sample)
+{
+	for (const auto &value : sample.values)
+	{
+		// Find the counter matching this StatIndex in the Sample
+		auto counter = counters.find(value.first);
+		if (counter == counters.end())
+			continue;
+
+		add_smoothed_value(counter->second, static_cast<float>(value.second), alpha_smoothing);
+	}
+}
+
 void Stats::begin_sampling(CommandBuffer &cb)
 {
 	// Inform the providers
 	for (auto &p : providers)
 		p->begin_sampling(cb);
+
+	gpu_profiler->begin_frame(cb);
+	cb.set_gpu_profiler(gpu_profiler.get());
 }
 
 void Stats::end_sampling(CommandBuffer &cb)
@@ -266,6 +328,122 @@ void Stats::end_sampling(CommandBuffer &cb)
 	// Inform the providers
 	for (auto &p : providers)
 		p->end_sampling(cb);
+
+	cb.set_gpu_profiler(nullptr);
+}
+
+void Stats::request_vulkan_counters(const std::vector<std::string> &counter_names)
+{
+	if (providers.size() != 0)
+	{
+		throw std::runtime_error("Vulkan counters must be requested before the stats");
+	}
+
+	vulkan_counter_names = counter_names;
+}
+
+void Stats::set_job_system(const JobSystem *job_system_)
+{
+	if (providers.size() != 0)
+	{
+		throw std::runtime_error("The job system must be set before the stats are requested");
+	}
+
+	job_system = job_system_;
+}
+
+void Stats::set_stream_file(const std::string &filename)
+{
+	if (providers.size() != 0)
+	{
+		throw std::runtime_error("The stats stream must be set before the stats are requested");
+	}
+
+	stream_filename = filename;
+}
+
+void Stats::open_stream()
+{
+	std::vector<std::string> columns;
+
+	for (auto stat_index : requested_stats)
+	{
+		if (!is_available(stat_index))
+		{
+			continue;
+		}
+
+		auto &graph_data = get_graph_data(stat_index);
+
+		// The unit follows the value in the format of the graph label, e.g. "{:3.1f} ms"
+		auto unit_begin = graph_data.format.find('}');
+		auto unit       = unit_begin == std::string::npos ? std::string() : graph_data.format.substr(unit_begin + 1);
+		unit.erase(0, unit.find_first_not_of(' '));
+
+		stream_columns[stat_index] = columns.size();
+		columns.push_back(unit.empty() ? graph_data.name : graph_data.name + " (" + unit + ")");
+	}
+
+	for (auto &counter : get_vulkan_counters())
+	{
+		columns.push_back(counter.unit.empty() ? counter.name : counter.name + " (" + counter.unit + ")");
+	}
+
+	stream_named_counter_count = get_vulkan_counters().size();
+
+	stream = std::make_unique<StatsStream>(fs::path::get(fs::path::Type::Logs) + stream_filename, StatsStream::get_format(stream_filename), columns);
+
+	if (!stream->is_open())
+	{
+		stream.reset();
+	}
+
+	stream_values.reserve(columns.size());
+	worker_stream_values.reserve(columns.size());
+}
+
+void Stats::add_stream_values(const StatsProvider::Counters &sample, std::vector<std::pair<size_t, double>> &values) const
+{
+	for (auto &counter : sample)
+	{
+		auto column_it = stream_columns.find(counter.first);
+
+		if (column_it != stream_columns.end())
+		{
+			values.emplace_back(column_it->second, counter.second.result * get_graph_data(counter.first).scale_factor);
+		}
+	}
+}
+
+void Stats::stream_sample(const StatsProvider::Counters &sample)
+{
+	stream_values.clear();
+
+	add_stream_values(sample, stream_values);
+
+	auto &named_counters = get_vulkan_counters();
+
+	for (size_t i = 0; i < std::min(named_counters.size(), stream_named_counter_count); ++i)
+	{
+		if (named_counters[i].has_value)
+		{
+			stream_values.emplace_back(stream_columns.size() + i, named_counters[i].value);
+		}
+	}
+
+	stream->write(CpuProfiler::now(), stream_values);
+}
+
+const std::vector<VulkanStatsProvider::NamedCounter> &Stats::get_vulkan_counters() const
+{
+	static const std::vector<VulkanStatsProvider::NamedCounter> no_counters;
+
+	return vulkan_stats_provider ? vulkan_stats_provider->get_named_counters() : no_counters;
+}
+
+const GpuProfiler &Stats::get_gpu_profiler() const
+{
+	return *gpu_profiler;
 }
 
 const StatGraphData &Stats::get_graph_data(StatIndex index) const
@@ -26,15 +26,20 @@
 #include <vector>
 
 #include "common/error.h"
+#include "common/spsc_ring.h"
 
+#include "gpu_profiler.h"
 #include "stats_common.h"
 #include "stats_provider.h"
+#include "stats_stream.h"
 #include "timer.h"
+#include "vulkan_stats_provider.h"
 
 namespace vkb
 {
 class Device;
 class CommandBuffer;
+class JobSystem;
 class RenderContext;
 
 /*
@@ -63,6 +68,33 @@ class Stats
 	void request_stats(const std::set<StatIndex> &requested_stats,
 	                   CounterSamplingConfig      sampling_config = {CounterSamplingMode::Polling});
 
+	/**
+	 * @brief Selects Vulkan performance counters to collect by name, for any vendor
+	 *        Must be called before request_stats
+	 * @param counter_names Regular expressions matching the names of the counters
+	 */
+	void request_vulkan_counters(const std::vector<std::string> &counter_names);
+
+	/**
+	 * @brief Selects the job system whose workers the CPU thread stats measure
+	 *        Must be called before request_stats, which measures the calling thread as the main thread
+	 */
+	void set_job_system(const JobSystem *job_system);
+
+	/**
+	 * @brief Streams every sample of the requested stats and of the Vulkan counters selected by name to a file
+	 *        in the logs directory, a CSV file for a .csv name, otherwise a Perfetto trace. Unlike the graphs, the
+	 *        values are neither smoothed nor limited to a history, and the continuous samples are written by the
+	 *        sampling worker. Must be called before request_stats
+	 * @param filename The name of the file, empty to not stream the stats
+	 */
+	void set_stream_file(const std::string &filename);
+
+	/**
+	 * @return The Vulkan performance counters selected by name, with their latest values
+	 */
+	const std::vector<VulkanStatsProvider::NamedCounter> &get_vulkan_counters() const;
+
 	/**
 	 * @brief Resizes the stats buffers according to the width of the screen
 	 * @param width The width of the screen
@@ -135,6 +167,12 @@ class Stats
 	 */
 	void end_sampling(CommandBuffer &cb);
 
+	/**
+	 * @brief Returns the profiler of the GPU scopes of the sampled command buffers
+	 *        Its timings are resolved a few frames late, see GpuProfiler
+	 */
+	const GpuProfiler &get_gpu_profiler() const;
+
   private:
 	/// The render context
 	RenderContext &render_context;
@@ -145,9 +183,38 @@ class Stats
 	/// Provider that tracks frame times
 	StatsProvider *frame_time_provider;
 
+	/// Provider of the Vulkan performance counters
+	VulkanStatsProvider *vulkan_stats_provider{nullptr};
+
+	/// Names of the Vulkan performance counters to collect
+	std::vector<std::string> vulkan_counter_names;
+
+	/// Job system whose workers are measured
+	const JobSystem *job_system{nullptr};
+
+	/// Name of the file the samples are streamed to
+	std::string stream_filename;
+
+	std::unique_ptr<StatsStream> stream;
+
+	/// Column of each streamed stat, the Vulkan counters selected by name follow
+	std::map<StatIndex, size_t> stream_columns;
+
+	/// Number of Vulkan counters selected by name with a column
+	size_t stream_named_counter_count{0};
+
+	/// Values of the sample streamed by the main thread
+	std::vector<std::pair<size_t, double>> stream_values;
+
+	/// Values of the sample streamed by the worker thread
+	std::vector<std::pair<size_t, double>> worker_stream_values;
+
 	/// A list of stats providers to use in priority order
 	std::vector<std::unique_ptr<StatsProvider>> providers;
 
+	/// Times the GPU scopes of the sampled command buffers
+	std::unique_ptr<GpuProfiler> gpu_profiler;
+
 	/// Counter sampling configuration
 	CounterSamplingConfig sampling_config;
 
@@ -172,17 +239,17 @@ class Stats
 	/// Promise to stop the worker thread
 	std::unique_ptr<std::promise<void>> stop_worker;
 
-	/// A mutex for accessing measurements during continuous sampling
-	std::mutex continuous_sampling_mutex;
-
-	/// The samples read during continuous sampling
-	std::vector<StatsProvider::Counters> continuous_samples;
+	/// A sample read during continuous sampling, its storage is reserved up front
+	struct ContinuousSample
+	{
+		std::vector<std::pair<StatIndex, double>> values;
+	};
 
-	/// A flag specifying if the worker thread should add entries to continuous_samples
-	bool should_add_to_continuous_samples{false};
+	/// Maximum number of continuous samples waiting to be displayed, the worker drops the following ones
+	static constexpr size_t MAX_PENDING_SAMPLES = 128;
 
-	/// The samples waiting to be displayed
-	std::vector<StatsProvider::Counters> pending_samples;
+	/// The samples read during continuous sampling, handed from the worker thread to the main thread
+	std::unique_ptr<SpscRing<ContinuousSample>> continuous_samples;
 
 	/// The worker thread function for continuous sampling;
 	/// it adds a new entry to continuous_samples at every interval
@@ -190,6 +257,18 @@ class Stats
 
 	/// Updates circular buffers for CPU and GPU counters
 	void push_sample(const StatsProvider::Counters &sample);
+
+	/// Opens the stream of the samples, with a column per available stat
+	void open_stream();
+
+	/// Adds the values of the streamed stats of a sample, in the units of their graphs
+	void add_stream_values(const StatsProvider::Counters &sample, std::vector<std::pair<size_t, double>> &values) const;
+
+	/// Streams the values of a sample of the main thread, with the Vulkan counters selected by name
+	void stream_sample(const StatsProvider::Counters &sample);
+
+	/// Updates circular buffers with a continuous sample
+	void push_sample(const ContinuousSample &sample);
 };
 
 }        // namespace vkb
@@ -59,6 +59,57 @@ enum class StatIndex
 	gpu_ext_read_bytes,
 	gpu_ext_write_bytes,
 	gpu_tex_cycles,
+
+	cache_shader_module_contentions,
+	cache_pipeline_layout_contentions,
+	cache_descriptor_set_layout_contentions,
+	cache_descriptor_set_contentions,
+	cache_render_pass_contentions,
+	cache_graphics_pipeline_contentions,
+	cache_compute_pipeline_contentions,
+	cache_framebuffer_contentions,
+
+	cache_graphics_pipeline_count,
+	cache_compute_pipeline_count,
+	cache_descriptor_set_count,
+	cache_framebuffer_count,
+	cache_memory,
+
+	memory_usage,
+	memory_budget,
+	memory_heap_pressure,
+	memory_allocation_count,
+	memory_fragmentation,
+
+	command_buffer_redundant_calls,
+
+	gpu_vertex_invocations,
+	gpu_clipping_primitives,
+	gpu_fragment_invocations,
+	gpu_compute_invocations,
+	gpu_overdraw,
+	gpu_samples_passed,
+
+	frame_pacing,
+	frame_cpu_update,
+	frame_acquire_wait,
+	frame_cpu_record,
+	frame_submit,
+	frame_present_wait,
+	frame_gpu_time,
+	frame_latency,
+	frame_input_latency,
+	frame_cpu_bubble,
+	frame_gpu_bubble,
+	frame_missed_vblanks,
+
+	frame_allocations,
+	frame_allocated_bytes,
+
+	cpu_main_thread_time,
+	cpu_main_thread_busy,
+	cpu_worker_thread_time,
+	cpu_context_switches,
 };
 
 struct StatIndexHash
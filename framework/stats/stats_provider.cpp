@@ -54,6 +54,57 @@ std::map<StatIndex, StatGraphData> StatsProvider::default_graph_map{
     {StatIndex::gpu_ext_write_stalls,  {"External Write Stalls",                       "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_ext_read_bytes,    {"External Read Bytes",                         "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
     {StatIndex::gpu_ext_write_bytes,   {"External Write Bytes",                        "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+
+    {StatIndex::cache_shader_module_contentions,         {"Shader Module Cache Contentions",         "{:4.0f}/s"}},
+    {StatIndex::cache_pipeline_layout_contentions,       {"Pipeline Layout Cache Contentions",       "{:4.0f}/s"}},
+    {StatIndex::cache_descriptor_set_layout_contentions, {"Descriptor Set Layout Cache Contentions", "{:4.0f}/s"}},
+    {StatIndex::cache_descriptor_set_contentions,        {"Descriptor Set Cache Contentions",        "{:4.0f}/s"}},
+    {StatIndex::cache_render_pass_contentions,           {"Render Pass Cache Contentions",           "{:4.0f}/s"}},
+    {StatIndex::cache_graphics_pipeline_contentions,     {"Graphics Pipeline Cache Contentions",     "{:4.0f}/s"}},
+    {StatIndex::cache_compute_pipeline_contentions,      {"Compute Pipeline Cache Contentions",      "{:4.0f}/s"}},
+    {StatIndex::cache_framebuffer_contentions,           {"Framebuffer Cache Contentions",           "{:4.0f}/s"}},
+
+    {StatIndex::cache_graphics_pipeline_count,           {"Cached Graphics Pipelines",               "{:4.0f}"}},
+    {StatIndex::cache_compute_pipeline_count,            {"Cached Compute Pipelines",                "{:4.0f}"}},
+    {StatIndex::cache_descriptor_set_count,              {"Cached Descriptor Sets",                  "{:4.0f}"}},
+    {StatIndex::cache_framebuffer_count,                 {"Cached Framebuffers",                     "{:4.0f}"}},
+    {StatIndex::cache_memory,                            {"Resource Cache Host Memory",              "{:4.1f} KiB",   1.0f / 1024.0f}},
+
+    {StatIndex::memory_usage,                            {"Device Memory Usage",                     "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::memory_budget,                           {"Device Memory Budget",                    "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::memory_heap_pressure,                    {"Most Used Heap (of Budget)",              "{:3.0f}%",      100.0f,                       true,     100.0f}},
+    {StatIndex::memory_allocation_count,                 {"Device Memory Allocations",               "{:4.0f}"}},
+    {StatIndex::memory_fragmentation,                    {"Unused Memory in Blocks",                 "{:3.0f}%",      100.0f,                       true,     100.0f}},
+
+    {StatIndex::command_buffer_redundant_calls,          {"Redundant Calls Skipped",                 "{:4.0f}/frame"}},
+
+    {StatIndex::gpu_vertex_invocations,                  {"Vertex Shader Invocations",               "{:4.1f} k/frame", float(1e-3)}},
+    {StatIndex::gpu_clipping_primitives,                 {"Primitives After Clipping",               "{:4.1f} k/frame", float(1e-3)}},
+    {StatIndex::gpu_fragment_invocations,                {"Fragment Shader Invocations",             "{:4.1f} M/frame", float(1e-6)}},
+    {StatIndex::gpu_compute_invocations,                 {"Compute Shader Invocations",              "{:4.1f} M/frame", float(1e-6)}},
+    {StatIndex::gpu_overdraw,                            {"Fragment Shading Overdraw",               "{:3.2f}x"}},
+    {StatIndex::gpu_samples_passed,                      {"Samples Passed Depth/Stencil",            "{:4.1f} M/frame", float(1e-6)}},
+
+    {StatIndex::frame_pacing,                            {"Frame Pacing",                            "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_cpu_update,                        {"CPU Update",                              "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_acquire_wait,                      {"Acquire Wait",                            "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_cpu_record,                        {"CPU Record",                              "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_submit,                            {"Submit",                                  "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_present_wait,                      {"Present Wait",                            "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_gpu_time,                          {"GPU Execution",                           "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_latency,                           {"Frame Latency",                           "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_input_latency,                     {"Input Latency",                           "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_cpu_bubble,                        {"CPU Bubble",                              "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_gpu_bubble,                        {"GPU Bubble",                              "{:3.2f} ms",    1000.0f}},
+    {StatIndex::frame_missed_vblanks,                    {"Missed VBlanks",                          "{:4.0f}/frame"}},
+
+    {StatIndex::frame_allocations,                       {"Heap Allocations",                        "{:4.0f}/frame"}},
+    {StatIndex::frame_allocated_bytes,                   {"Heap Allocated Bytes",                    "{:4.1f} KiB/frame", 1.0f / 1024.0f}},
+
+    {StatIndex::cpu_main_thread_time,                    {"Main Thread CPU Time",                    "{:3.2f} ms",    1000.0f}},
+    {StatIndex::cpu_main_thread_busy,                    {"Main Thread CPU Busy",                    "{:3.0f}%",      100.0f,                       true,     100.0f}},
+    {StatIndex::cpu_worker_thread_time,                  {"Job Workers CPU Time",                    "{:3.2f} ms",    1000.0f}},
+    {StatIndex::cpu_context_switches,                    {"Context Switches",                        "{:4.0f}/frame"}},
     // clang-format on
 };
 
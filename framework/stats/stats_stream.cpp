@@ -0,0 +1,172 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "stats_stream.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @return The text quoted for a CSV cell
+ */
+std::string quote_csv(const std::string &text)
+{
+	std::string quoted = "\"";
+
+	for (auto c : text)
+	{
+		quoted += c == '"' ? "\"\"" : std::string(1, c);
+	}
+
+	return quoted + "\"";
+}
+
+/**
+ * @return The text escaped for a JSON string
+ */
+std::string escape_json(const std::string &text)
+{
+	std::string escaped;
+
+	for (auto c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+
+	return escaped;
+}
+}        // namespace
+
+StatsStream::Format StatsStream::get_format(const std::string &filename)
+{
+	const std::string extension = ".csv";
+
+	bool is_csv = filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+
+	return is_csv ? Format::Csv : Format::Perfetto;
+}
+
+StatsStream::StatsStream(const std::string &path, Format format, const std::vector<std::string> &columns) :
+    format{format},
+    columns{columns},
+    file{path, std::ios::out | std::ios::trunc},
+    row(columns.size())
+{
+	if (!file.good())
+	{
+		LOGE("Failed to open stats stream file: {}", path);
+		return;
+	}
+
+	if (format == Format::Csv)
+	{
+		file << "time_ms";
+
+		for (auto &column : columns)
+		{
+			file << "," << quote_csv(column);
+		}
+
+		file << "\n";
+	}
+	else
+	{
+		file << "[";
+	}
+
+	LOGI("Streaming stats to {}", path);
+}
+
+StatsStream::~StatsStream()
+{
+	if (file.good() && format == Format::Perfetto)
+	{
+		file << "\n]\n";
+	}
+}
+
+bool StatsStream::is_open() const
+{
+	return file.good();
+}
+
+void StatsStream::write(uint64_t timestamp, const std::vector<std::pair<size_t, double>> &values)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (!file.good() || values.empty())
+	{
+		return;
+	}
+
+	if (format == Format::Csv)
+	{
+		for (auto &cell : row)
+		{
+			cell.clear();
+		}
+
+		for (auto &value : values)
+		{
+			if (!std::isfinite(value.second))
+			{
+				continue;
+			}
+
+			std::ostringstream cell;
+			cell << std::setprecision(9) << value.second;
+			row.at(value.first) = cell.str();
+		}
+
+		file << std::fixed << std::setprecision(6) << timestamp / 1e6;
+
+		for (auto &cell : row)
+		{
+			file << "," << cell;
+		}
+
+		file << "\n";
+		return;
+	}
+
+	for (auto &value : values)
+	{
+		// JSON has no representation of infinities
+		if (!std::isfinite(value.second))
+		{
+			continue;
+		}
+
+		file << (first_event ? "" : ",") << "\n{\"name\":\"" << escape_json(columns.at(value.first)) << "\",\"ph\":\"C\",\"pid\":0,\"ts\":"
+		     << std::fixed << std::setprecision(3) << timestamp / 1000.0 << ",\"args\":{\"value\":" << std::defaultfloat << std::setprecision(9) << value.second << "}}";
+
+		first_event = false;
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,86 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Streams counter samples to a file as they are taken, keeping the full history of a run
+ *
+ * The samples are timestamped with CpuProfiler::now(), so the Perfetto counter tracks line up with the zones
+ * of the CPU trace. The Perfetto format is the JSON array of the Chrome trace format, which stays readable if
+ * the run ends before the array is closed. Samples may be written from any thread.
+ */
+class StatsStream
+{
+  public:
+	enum class Format
+	{
+		/// A row per sample, with a column of milliseconds then a column per counter, empty if not sampled
+		Csv,
+
+		/// A counter event per value, in microseconds like the CPU trace
+		Perfetto
+	};
+
+	/**
+	 * @return Csv for a .csv file, otherwise Perfetto
+	 */
+	static Format get_format(const std::string &filename);
+
+	/**
+	 * @param path Path of the file, which is replaced
+	 * @param columns Names of the counters, the values are written by index in this list
+	 */
+	StatsStream(const std::string &path, Format format, const std::vector<std::string> &columns);
+
+	~StatsStream();
+
+	bool is_open() const;
+
+	/**
+	 * @brief Writes the values of some of the counters, sampled at the same time
+	 * @param timestamp Time of the sample in nanoseconds, from CpuProfiler::now()
+	 * @param values Index of the column of each value, with the value
+	 */
+	void write(uint64_t timestamp, const std::vector<std::pair<size_t, double>> &values);
+
+  private:
+	Format format;
+
+	std::vector<std::string> columns;
+
+	/// Guards the file, written by the sampling threads
+	std::mutex mutex;
+
+	std::ofstream file;
+
+	bool first_event{true};
+
+	/// Cells of the next CSV row
+	std::vector<std::string> row;
+};
+}        // namespace vkb
@@ -0,0 +1,129 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "stats/thread_cpu_timer.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#elif defined(__APPLE__)
+#	include <pthread.h>
+#else
+#	include <linux/perf_event.h>
+#	include <pthread.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+namespace vkb
+{
+ThreadCpuTimer::ThreadCpuTimer()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE handle = nullptr;
+	DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &handle, 0, FALSE, DUPLICATE_SAME_ACCESS);
+	thread_handle = handle;
+#elif defined(__APPLE__)
+	thread_port = pthread_mach_thread_np(pthread_self());
+#else
+	if (pthread_getcpuclockid(pthread_self(), &clock_id) != 0)
+	{
+		clock_id = CLOCK_THREAD_CPUTIME_ID;
+	}
+
+	perf_event_attr attributes{};
+	attributes.type   = PERF_TYPE_SOFTWARE;
+	attributes.size   = sizeof(perf_event_attr);
+	attributes.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+
+	// A pid of 0 counts the calling thread only, on any CPU
+	perf_fd = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+}
+
+ThreadCpuTimer::~ThreadCpuTimer()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	if (thread_handle)
+	{
+		CloseHandle(thread_handle);
+	}
+#elif !defined(__APPLE__)
+	if (perf_fd >= 0)
+	{
+		close(perf_fd);
+	}
+#endif
+}
+
+double ThreadCpuTimer::get_cpu_time() const
+{
+#if defined(_WIN32) || defined(_WIN64)
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+
+	if (!thread_handle || !GetThreadTimes(thread_handle, &creation_time, &exit_time, &kernel_time, &user_time))
+	{
+		return 0.0;
+	}
+
+	// The times are in units of 100 nanoseconds
+	auto to_ticks = [](const FILETIME &time) { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+
+	return static_cast<double>(to_ticks(kernel_time) + to_ticks(user_time)) * 1e-7;
+#elif defined(__APPLE__)
+	thread_basic_info_data_t info{};
+	mach_msg_type_number_t   count = THREAD_BASIC_INFO_COUNT;
+
+	if (thread_info(thread_port, THREAD_BASIC_INFO, reinterpret_cast<thread_info_t>(&info), &count) != KERN_SUCCESS)
+	{
+		return 0.0;
+	}
+
+	return static_cast<double>(info.user_time.seconds + info.system_time.seconds) +
+	       static_cast<double>(info.user_time.microseconds + info.system_time.microseconds) * 1e-6;
+#else
+	timespec time{};
+
+	if (clock_gettime(clock_id, &time) != 0)
+	{
+		return 0.0;
+	}
+
+	return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+}
+
+bool ThreadCpuTimer::counts_context_switches() const
+{
+	return perf_fd >= 0;
+}
+
+uint64_t ThreadCpuTimer::get_context_switches() const
+{
+	uint64_t count = 0;
+
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(__APPLE__)
+	if (perf_fd >= 0 && read(perf_fd, &count, sizeof(count)) != sizeof(count))
+	{
+		count = 0;
+	}
+#endif
+
+	return count;
+}
+}        // namespace vkb
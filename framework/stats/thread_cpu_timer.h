@@ -0,0 +1,84 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__APPLE__)
+#	include <mach/mach.h>
+#elif !defined(_WIN32) && !defined(_WIN64)
+#	include <ctime>
+#endif
+
+namespace vkb
+{
+/**
+ * @brief Measures the CPU time a thread spent running, as opposed to the wall clock time it existed for
+ *
+ * The timer is created on the thread it measures and can then be read from any thread, for as long as
+ * the thread runs. On Linux and Android it also counts how many times the thread was switched out, with
+ * a software perf event, provided perf_event_paranoid lets the process open it.
+ */
+class ThreadCpuTimer
+{
+  public:
+	/**
+	 * @brief Measures the calling thread
+	 */
+	ThreadCpuTimer();
+
+	ThreadCpuTimer(const ThreadCpuTimer &) = delete;
+
+	ThreadCpuTimer(ThreadCpuTimer &&) = delete;
+
+	~ThreadCpuTimer();
+
+	ThreadCpuTimer &operator=(const ThreadCpuTimer &) = delete;
+
+	ThreadCpuTimer &operator=(ThreadCpuTimer &&) = delete;
+
+	/**
+	 * @return The CPU time of the thread in seconds, in user and kernel mode
+	 */
+	double get_cpu_time() const;
+
+	/**
+	 * @return Whether the context switches of the thread are counted
+	 */
+	bool counts_context_switches() const;
+
+	/**
+	 * @return The number of times the thread was switched out since the timer was created, 0 if they are not counted
+	 */
+	uint64_t get_context_switches() const;
+
+  private:
+#if defined(_WIN32) || defined(_WIN64)
+	/// Handle of the thread, GetCurrentThread() only names the calling thread
+	void *thread_handle{nullptr};
+#elif defined(__APPLE__)
+	mach_port_t thread_port{MACH_PORT_NULL};
+#else
+	clockid_t clock_id{};
+#endif
+
+	/// File descriptor of the perf event counting the context switches, -1 if they are not counted
+	int perf_fd{-1};
+};
+}        // namespace vkb
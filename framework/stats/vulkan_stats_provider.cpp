@@ -26,9 +26,10 @@
 
 namespace vkb
 {
-VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_stats,
-                                         const CounterSamplingConfig &sampling_config,
-                                         RenderContext &              render_context) :
+VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &           requested_stats,
+                                         const CounterSamplingConfig &   sampling_config,
+                                         RenderContext &                 render_context,
+                                         const std::vector<std::string> &counter_names) :
     render_context(render_context)
 {
 	// Check all the Vulkan capabilities we require are present
@@ -69,7 +70,7 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 
 	// Every vendor has a different set of performance counters each
 	// with different names. Match them to the stats we want, where available.
-	if (!fill_vendor_data())
+	if (!fill_vendor_data() && counter_names.empty())
 		return;
 
 	bool performance_impact = false;
@@ -113,24 +114,35 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 			}
 
 			// Record the counter data
-			counter_indices.emplace_back(ctr_idx);
 			if (init.divisor_name == "")
 			{
+				counter_groups.push_back({ctr_idx});
 				stat_data[index] = StatData(ctr_idx, counters[ctr_idx].storage);
 			}
 			else
 			{
-				counter_indices.emplace_back(div_idx);
+				counter_groups.push_back({ctr_idx, div_idx});
 				stat_data[index] = StatData(ctr_idx, counters[ctr_idx].storage, init.scaling,
 				                            div_idx, counters[div_idx].storage);
 			}
 		}
 	}
 
+	// Then add the counters selected by name, whatever the vendor
+	add_named_counters(counter_names, counters, descs);
+
+	for (const auto &c : named_counters)
+	{
+		if (descs[c.counter_index].flags & VK_PERFORMANCE_COUNTER_DESCRIPTION_PERFORMANCE_IMPACTING_KHR)
+		{
+			performance_impact = true;
+		}
+	}
+
 	if (performance_impact)
 		LOGW("The collection of performance counters may impact performance");
 
-	if (counter_indices.size() == 0)
+	if (counter_groups.size() == 0)
 		return;        // No stats available
 
 	// Acquire the profiling lock, without which we can't collect stats
@@ -141,19 +153,41 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 	if (vkAcquireProfilingLockKHR(device.get_handle(), &info) != VK_SUCCESS)
 	{
 		stat_data.clear();
-		counter_indices.clear();
+		named_counters.clear();
 		LOGW("Profiling lock acquisition timed-out");
 		return;
 	}
 
-	// Now we know the counters and that we can collect them, make a query pool for the results.
+	has_profiling_lock = true;
+
+	// Now we know the counters and that we can collect them, make query pools for the results.
 	if (!create_query_pools(queue_family_index))
 	{
 		stat_data.clear();
-		counter_indices.clear();
+		named_counters.clear();
 		return;
 	}
 
+	// Drop anything whose counters could not be given a pass
+	auto in_a_pass = [this](uint32_t counter_index) {
+		return std::any_of(passes.begin(), passes.end(), [counter_index](const CounterPass &pass) {
+			return std::find(pass.counter_indices.begin(), pass.counter_indices.end(), counter_index) != pass.counter_indices.end();
+		});
+	};
+
+	for (auto it = stat_data.begin(); it != stat_data.end();)
+	{
+		bool need_divisor = (it->second.scaling == StatScaling::ByCounter);
+		if (!in_a_pass(it->second.counter_index) || (need_divisor && !in_a_pass(it->second.divisor_counter_index)))
+			it = stat_data.erase(it);
+		else
+			++it;
+	}
+
+	named_counters.erase(std::remove_if(named_counters.begin(), named_counters.end(),
+	                                    [&in_a_pass](const NamedCounter &c) { return !in_a_pass(c.counter_index); }),
+	                     named_counters.end());
+
 	// These stats are fully supported by this provider and in a single pass, so remove
 	// from the requested set.
 	// Subsequent providers will then only look for things that aren't already supported.
@@ -163,7 +197,7 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 
 VulkanStatsProvider::~VulkanStatsProvider()
 {
-	if (stat_data.size() > 0)
+	if (has_profiling_lock)
 	{
 		// Release profiling lock
 		vkReleaseProfilingLockKHR(render_context.get_device().get_handle());
@@ -212,48 +246,173 @@ bool VulkanStatsProvider::fill_vendor_data()
 	}
 }
 
+static std::string get_unit_string(VkPerformanceCounterUnitKHR unit)
+{
+	switch (unit)
+	{
+		case VK_PERFORMANCE_COUNTER_UNIT_PERCENTAGE_KHR:
+			return "%";
+		case VK_PERFORMANCE_COUNTER_UNIT_NANOSECONDS_KHR:
+			return "ns";
+		case VK_PERFORMANCE_COUNTER_UNIT_BYTES_KHR:
+			return "B";
+		case VK_PERFORMANCE_COUNTER_UNIT_BYTES_PER_SECOND_KHR:
+			return "B/s";
+		case VK_PERFORMANCE_COUNTER_UNIT_KELVIN_KHR:
+			return "K";
+		case VK_PERFORMANCE_COUNTER_UNIT_WATTS_KHR:
+			return "W";
+		case VK_PERFORMANCE_COUNTER_UNIT_VOLTS_KHR:
+			return "V";
+		case VK_PERFORMANCE_COUNTER_UNIT_AMPS_KHR:
+			return "A";
+		case VK_PERFORMANCE_COUNTER_UNIT_HERTZ_KHR:
+			return "Hz";
+		case VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR:
+			return "cycles";
+		default:
+			return "";
+	}
+}
+
+void VulkanStatsProvider::add_named_counters(const std::vector<std::string> &                       counter_names,
+                                             const std::vector<VkPerformanceCounterKHR> &           counters,
+                                             const std::vector<VkPerformanceCounterDescriptionKHR> &descs)
+{
+	bool all_found = true;
+
+	for (const auto &counter_name : counter_names)
+	{
+		// The names are regular expressions, so one name can select a whole family of counters
+		std::regex name_regex;
+		try
+		{
+			name_regex = std::regex(counter_name);
+		}
+		catch (const std::regex_error &e)
+		{
+			LOGE("Invalid Vulkan counter name \"{}\": {}", counter_name, e.what());
+			continue;
+		}
+
+		bool found = false;
+
+		for (uint32_t i = 0; i < descs.size(); i++)
+		{
+			if (!std::regex_match(descs[i].name, name_regex))
+				continue;
+
+			found = true;
+
+			bool already_added = std::any_of(named_counters.begin(), named_counters.end(),
+			                                 [i](const NamedCounter &c) { return c.counter_index == i; });
+			if (already_added)
+				continue;
+
+			NamedCounter counter;
+			counter.name          = descs[i].name;
+			counter.unit          = get_unit_string(counters[i].unit);
+			counter.counter_index = i;
+			counter.storage       = counters[i].storage;
+
+			named_counters.push_back(counter);
+			counter_groups.push_back({i});
+		}
+
+		if (!found)
+		{
+			LOGW("No Vulkan performance counter matches \"{}\"", counter_name);
+			all_found = false;
+		}
+	}
+
+	if (!all_found)
+	{
+		LOGI("Available Vulkan performance counters:");
+		for (const auto &desc : descs)
+		{
+			LOGI("    {} ({}): {}", desc.name, desc.category, desc.description);
+		}
+	}
+}
+
 bool VulkanStatsProvider::create_query_pools(uint32_t queue_family_index)
 {
 	Device &              device           = render_context.get_device();
 	const PhysicalDevice &gpu              = device.get_gpu();
 	uint32_t              num_framebuffers = uint32_t(render_context.get_render_frames().size());
 
-	// Now we know the available counters, we can build a query pool that will collect them.
-	// We will check that the counters can be collected in a single pass. Multi-pass would
-	// be a big performance hit so for these samples, we don't want to use it.
 	VkQueryPoolPerformanceCreateInfoKHR perf_create_info{};
-	perf_create_info.sType             = VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR;
-	perf_create_info.queueFamilyIndex  = queue_family_index;
-	perf_create_info.counterIndexCount = uint32_t(counter_indices.size());
-	perf_create_info.pCounterIndices   = counter_indices.data();
-
-	uint32_t passes_needed = gpu.get_queue_family_performance_query_passes(&perf_create_info);
-	if (passes_needed != 1)
+	perf_create_info.sType            = VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR;
+	perf_create_info.queueFamilyIndex = queue_family_index;
+
+	auto passes_needed = [&gpu, &perf_create_info](const std::vector<uint32_t> &indices) {
+		perf_create_info.counterIndexCount = to_u32(indices.size());
+		perf_create_info.pCounterIndices   = indices.data();
+		return gpu.get_queue_family_performance_query_passes(&perf_create_info);
+	};
+
+	// Now we know the available counters, split them into sets that can each be collected
+	// in a single pass. Multi-pass queries need every command buffer submitted once per pass,
+	// which would be a big performance hit for these samples, so instead each frame collects
+	// one of the sets in turn.
+	std::vector<std::vector<uint32_t>> pass_indices;
+
+	for (const auto &group : counter_groups)
 	{
-		// Needs more than one pass, remove all our supported stats
-		LOGW("Requested Vulkan stats require multiple passes, we won't collect them");
-		return false;
+		if (passes_needed(group) != 1)
+		{
+			LOGW("Requested Vulkan counters need multiple passes on their own, we won't collect them");
+			continue;
+		}
+
+		if (!pass_indices.empty())
+		{
+			auto candidate = pass_indices.back();
+			for (auto index : group)
+			{
+				if (std::find(candidate.begin(), candidate.end(), index) == candidate.end())
+					candidate.push_back(index);
+			}
+
+			if (passes_needed(candidate) == 1)
+			{
+				pass_indices.back() = std::move(candidate);
+				continue;
+			}
+		}
+
+		pass_indices.push_back(group);
 	}
 
-	// We will need a query pool to report the stats back to us
-	VkQueryPoolCreateInfo pool_create_info{};
-	pool_create_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-	pool_create_info.pNext      = &perf_create_info;
-	pool_create_info.queryType  = VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR;
-	pool_create_info.queryCount = num_framebuffers;
+	if (pass_indices.empty())
+		return false;
 
-	query_pool = std::make_unique<QueryPool>(device, pool_create_info);
+	if (pass_indices.size() > 1)
+		LOGI("Requested Vulkan counters need {} passes, each one is sampled every {} frames", pass_indices.size(), pass_indices.size());
 
-	if (!query_pool)
+	for (auto &indices : pass_indices)
 	{
-		LOGW("Failed to create performance query pool");
-		return false;
+		perf_create_info.counterIndexCount = to_u32(indices.size());
+		perf_create_info.pCounterIndices   = indices.data();
+
+		// We will need a query pool to report the stats back to us. The ring resets the queries
+		// from the host, as resetting them in the command buffer is invalid usage for performance
+		// queries due to the potential for multiple passes being required.
+		VkQueryPoolCreateInfo pool_create_info{};
+		pool_create_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_create_info.pNext      = &perf_create_info;
+		pool_create_info.queryType  = VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR;
+		pool_create_info.queryCount = 1;
+
+		CounterPass pass;
+		pass.queries         = std::make_unique<QueryPoolRing>(device, pool_create_info, num_framebuffers);
+		pass.counter_indices = std::move(indices);
+
+		passes.push_back(std::move(pass));
 	}
 
-	// Reset the query pool before first use. We cannot do these in the command buffer
-	// as that is invalid usage for performance queries due to the potential for multple
-	// passes being required.
-	query_pool->host_reset(0, num_framebuffers);
+	frame_passes.resize(num_framebuffers, -1);
 
 	if (has_timestamps)
 	{
@@ -263,9 +422,9 @@ bool VulkanStatsProvider::create_query_pools(uint32_t queue_family_index)
 		VkQueryPoolCreateInfo timestamp_pool_create_info{};
 		timestamp_pool_create_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
 		timestamp_pool_create_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
-		timestamp_pool_create_info.queryCount = num_framebuffers * 2;        // 2 timestamps per frame (start & end)
+		timestamp_pool_create_info.queryCount = 2;        // 2 timestamps per frame (start & end)
 
-		timestamp_pool = std::make_unique<QueryPool>(device, timestamp_pool_create_info);
+		timestamp_queries = std::make_unique<QueryPoolRing>(device, timestamp_pool_create_info, num_framebuffers);
 	}
 
 	return true;
@@ -319,26 +478,30 @@ const StatGraphData &VulkanStatsProvider::get_graph_data(StatIndex index) const
 void VulkanStatsProvider::begin_sampling(CommandBuffer &cb)
 {
 	uint32_t active_frame_idx = render_context.get_active_frame_index();
-	if (timestamp_pool)
+	if (timestamp_queries)
 	{
 		// We use TimestampQueries when available to provide a more accurate delta_time.
 		// This counters are from a single command buffer execution, but the passed
 		// delta time is a frame-to-frame s/w measure. A timestamp query in the the cmd
 		// buffer gives the actual elapsed time where the counters were measured.
-		cb.reset_query_pool(*timestamp_pool, active_frame_idx * 2, 1);
-		cb.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *timestamp_pool,
-		                   active_frame_idx * 2);
+		uint32_t first_query = timestamp_queries->begin_range(cb, active_frame_idx);
+		cb.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_queries->get_pool(), first_query);
 	}
 
-	if (query_pool)
-		cb.begin_query(*query_pool, active_frame_idx, VkQueryControlFlags(0));
+	if (!passes.empty())
+	{
+		auto &queries = *passes[next_pass].queries;
+
+		frame_passes[active_frame_idx] = static_cast<int32_t>(next_pass);
+		cb.begin_query(queries.get_pool(), queries.begin_range(cb, active_frame_idx), VkQueryControlFlags(0));
+	}
 }
 
 void VulkanStatsProvider::end_sampling(CommandBuffer &cb)
 {
 	uint32_t active_frame_idx = render_context.get_active_frame_index();
 
-	if (query_pool)
+	if (!passes.empty())
 	{
 		// Perform a barrier to ensure all previous commands complete before ending the query
 		// This does not block later commands from executing as we use BOTTOM_OF_PIPE in the
@@ -347,16 +510,20 @@ void VulkanStatsProvider::end_sampling(CommandBuffer &cb)
 		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
 		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
 		                     0, 0, nullptr, 0, nullptr, 0, nullptr);
-		cb.end_query(*query_pool, active_frame_idx);
+		auto &queries = *passes[frame_passes[active_frame_idx]].queries;
+
+		cb.end_query(queries.get_pool(), active_frame_idx * queries.get_range_size());
+		queries.end_range(active_frame_idx);
 
-		++queries_ready;
+		// The next frame collects the next set of counters
+		next_pass = (next_pass + 1) % to_u32(passes.size());
 	}
 
-	if (timestamp_pool)
+	if (timestamp_queries)
 	{
-		cb.reset_query_pool(*timestamp_pool, active_frame_idx * 2 + 1, 1);
-		cb.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *timestamp_pool,
-		                   active_frame_idx * 2 + 1);
+		cb.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_queries->get_pool(),
+		                   active_frame_idx * timestamp_queries->get_range_size() + 1);
+		timestamp_queries->end_range(active_frame_idx);
 	}
 }
 
@@ -383,9 +550,9 @@ static double get_counter_value(const VkPerformanceCounterResultKHR &result,
 	}
 }
 
-float VulkanStatsProvider::get_best_delta_time(float sw_delta_time) const
+float VulkanStatsProvider::get_best_delta_time(float sw_delta_time)
 {
-	if (!timestamp_pool)
+	if (!timestamp_queries)
 		return sw_delta_time;
 
 	float delta_time = sw_delta_time;
@@ -395,11 +562,8 @@ float VulkanStatsProvider::get_best_delta_time(float sw_delta_time) const
 
 	uint32_t active_frame_idx = render_context.get_active_frame_index();
 
-	VkResult r = timestamp_pool->get_results(active_frame_idx * 2, 2,
-	                                         timestamps.size() * sizeof(uint64_t),
-	                                         timestamps.data(), sizeof(uint64_t),
-	                                         VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_64_BIT);
-	if (r == VK_SUCCESS)
+	if (timestamp_queries->get_results(active_frame_idx, timestamps.data(), timestamps.size() * sizeof(uint64_t),
+	                                   sizeof(uint64_t), VK_QUERY_RESULT_64_BIT))
 	{
 		float elapsed_ns = timestamp_period * float(timestamps[1] - timestamps[0]);
 		delta_time       = elapsed_ns * 0.000000001f;
@@ -411,64 +575,81 @@ float VulkanStatsProvider::get_best_delta_time(float sw_delta_time) const
 StatsProvider::Counters VulkanStatsProvider::sample(float delta_time)
 {
 	Counters out;
-	if (!query_pool || queries_ready == 0)
+	if (passes.empty())
 		return out;
 
 	uint32_t active_frame_idx = render_context.get_active_frame_index();
 
-	VkDeviceSize stride = sizeof(VkPerformanceCounterResultKHR) * counter_indices.size();
+	int32_t pass_idx = frame_passes[active_frame_idx];
+	if (pass_idx < 0)
+		return out;
 
-	std::vector<VkPerformanceCounterResultKHR> results(counter_indices.size());
+	CounterPass &pass = passes[pass_idx];
 
-	VkResult r = query_pool->get_results(active_frame_idx, 1,
-	                                     results.size() * sizeof(VkPerformanceCounterResultKHR),
-	                                     results.data(), stride, VK_QUERY_RESULT_WAIT_BIT);
-	if (r != VK_SUCCESS)
-		return out;
+	VkDeviceSize stride = sizeof(VkPerformanceCounterResultKHR) * pass.counter_indices.size();
+
+	std::vector<VkPerformanceCounterResultKHR> results(pass.counter_indices.size());
+
+	// Counters which are not available yet are skipped rather than stalling the frame,
+	// the query is reset when the render frame records its next pass
+	if (pass.queries->get_results(active_frame_idx,
+	                              results.data(), results.size() * sizeof(VkPerformanceCounterResultKHR), stride, 0))
+	{
+		// Use timestamps to get a more accurate delta if available
+		delta_time = get_best_delta_time(delta_time);
+
+		read_pass_results(pass, results, delta_time, out);
+	}
+
+	frame_passes[active_frame_idx] = -1;
+
+	return out;
+}
 
-	// Use timestamps to get a more accurate delta if available
-	delta_time = get_best_delta_time(delta_time);
+void VulkanStatsProvider::read_pass_results(const CounterPass &pass, const std::vector<VkPerformanceCounterResultKHR> &results,
+                                            float delta_time, Counters &out)
+{
+	// Find where a counter is in the results - they are in the order we gave in counter_indices
+	auto find_result = [&pass](uint32_t counter_index, size_t &position) {
+		auto it  = std::find(pass.counter_indices.begin(), pass.counter_indices.end(), counter_index);
+		position = std::distance(pass.counter_indices.begin(), it);
+		return it != pass.counter_indices.end();
+	};
 
-	// Parse the results - they are in the order we gave in counter_indices
 	for (const auto &s : stat_data)
 	{
-		StatIndex si = s.first;
+		const StatData &data = s.second;
 
-		bool   need_divisor  = (stat_data[si].scaling == StatScaling::ByCounter);
-		double divisor_value = 1.0;
-		double value         = 0.0;
-		bool   found_ctr = false, found_div = !need_divisor;
+		bool   need_divisor = (data.scaling == StatScaling::ByCounter);
+		size_t ctr_pos = 0, div_pos = 0;
 
-		for (uint32_t i = 0; !(found_ctr && found_div) && i < counter_indices.size(); i++)
-		{
-			if (s.second.counter_index == counter_indices[i])
-			{
-				value     = get_counter_value(results[i], stat_data[si].storage);
-				found_ctr = true;
-			}
-			if (need_divisor && s.second.divisor_counter_index == counter_indices[i])
-			{
-				divisor_value = get_counter_value(results[i], stat_data[si].divisor_storage);
-				found_div     = true;
-			}
-		}
+		if (!find_result(data.counter_index, ctr_pos) || (need_divisor && !find_result(data.divisor_counter_index, div_pos)))
+			continue;        // Collected by another pass
 
-		if (found_ctr && found_div)
+		double value         = get_counter_value(results[ctr_pos], data.storage);
+		double divisor_value = need_divisor ? get_counter_value(results[div_pos], data.divisor_storage) : 1.0;
+
+		if (data.scaling == StatScaling::ByDeltaTime && delta_time != 0.0)
+			value /= delta_time;
+		else if (data.scaling == StatScaling::ByCounter && divisor_value != 0.0)
+			value /= divisor_value;
+		out[s.first].result = value;
+	}
+
+	for (auto &c : named_counters)
+	{
+		size_t pos = 0;
+		if (find_result(c.counter_index, pos))
 		{
-			if (stat_data[si].scaling == StatScaling::ByDeltaTime && delta_time != 0.0)
-				value /= delta_time;
-			else if (stat_data[si].scaling == StatScaling::ByCounter && divisor_value != 0.0)
-				value /= divisor_value;
-			out[si].result = value;
+			c.value     = get_counter_value(results[pos], c.storage);
+			c.has_value = true;
 		}
 	}
+}
 
-	// Now reset the query we just fetched the results from
-	query_pool->host_reset(active_frame_idx, 1);
-
-	--queries_ready;
-
-	return out;
+const std::vector<VulkanStatsProvider::NamedCounter> &VulkanStatsProvider::get_named_counters() const
+{
+	return named_counters;
 }
 
 }        // namespace vkb
@@ -24,8 +24,34 @@ namespace vkb
 {
 class RenderContext;
 
+/**
+ * @brief Collects VK_KHR_performance_query counters, either mapped to the stat indices
+ *        for known vendors or selected by name for any vendor
+ *
+ *        Counters which cannot be collected in a single pass are split into several
+ *        single pass sets, and the sets are sampled in turn on consecutive frames.
+ */
 class VulkanStatsProvider : public StatsProvider
 {
+  public:
+	/**
+	 * @brief The latest value of a counter selected by name
+	 */
+	struct NamedCounter
+	{
+		std::string name;
+
+		std::string unit;
+
+		uint32_t counter_index;
+
+		VkPerformanceCounterStorageKHR storage;
+
+		double value{0.0};
+
+		bool has_value{false};
+	};
+
   private:
 	struct StatData
 	{
@@ -73,6 +99,18 @@ class VulkanStatsProvider : public StatsProvider
 		StatGraphData graph_data;
 	};
 
+	/**
+	 * @brief A set of counters that can be collected in a single pass
+	 */
+	struct CounterPass
+	{
+		// An ordered list of the Vulkan counter ids
+		std::vector<uint32_t> counter_indices;
+
+		// The performance queries, one query per render frame
+		std::unique_ptr<QueryPoolRing> queries;
+	};
+
 	using StatDataMap   = std::unordered_map<StatIndex, StatData, StatIndexHash>;
 	using VendorStatMap = std::unordered_map<StatIndex, VendorStat, StatIndexHash>;
 
@@ -82,9 +120,10 @@ class VulkanStatsProvider : public StatsProvider
 	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
 	 * @param sampling_config Sampling mode configuration (polling or continuous)
 	 * @param render_context The render context
+	 * @param counter_names Regular expressions matching the names of additional counters to collect
 	 */
 	VulkanStatsProvider(std::set<StatIndex> &requested_stats, const CounterSamplingConfig &sampling_config,
-	                    RenderContext &render_context);
+	                    RenderContext &render_context, const std::vector<std::string> &counter_names = {});
 
 	/**
 	 * @brief Destructs a VulkanStatsProvider
@@ -122,21 +161,42 @@ class VulkanStatsProvider : public StatsProvider
 	 */
 	void end_sampling(CommandBuffer &cb) override;
 
+	/**
+	 * @return The counters selected by name, with their latest values
+	 */
+	const std::vector<NamedCounter> &get_named_counters() const;
+
   private:
 	bool is_supported(const CounterSamplingConfig &sampling_config) const;
 
 	bool fill_vendor_data();
 
+	void add_named_counters(const std::vector<std::string> &                       counter_names,
+	                        const std::vector<VkPerformanceCounterKHR> &           counters,
+	                        const std::vector<VkPerformanceCounterDescriptionKHR> &descs);
+
 	bool create_query_pools(uint32_t queue_family_index);
 
-	float get_best_delta_time(float sw_delta_time) const;
+	void read_pass_results(const CounterPass &pass, const std::vector<VkPerformanceCounterResultKHR> &results,
+	                       float delta_time, Counters &out);
+
+	float get_best_delta_time(float sw_delta_time);
 
   private:
 	// The render context
 	RenderContext &render_context;
 
-	// The query pool for the performance queries
-	std::unique_ptr<QueryPool> query_pool;
+	// The single pass sets the requested counters were split into
+	std::vector<CounterPass> passes;
+
+	// The pass each render frame recorded, or -1 if it did not record one
+	std::vector<int32_t> frame_passes;
+
+	// The pass the next sampled command buffer records
+	uint32_t next_pass{0};
+
+	// Whether we hold the device profiling lock
+	bool has_profiling_lock{false};
 
 	// Do we support timestamp queries
 	bool has_timestamps{false};
@@ -144,8 +204,8 @@ class VulkanStatsProvider : public StatsProvider
 	// The timestamp period
 	float timestamp_period{1.0f};
 
-	// Query pool for timestamps
-	std::unique_ptr<QueryPool> timestamp_pool;
+	// Start and end timestamps of each render frame
+	std::unique_ptr<QueryPoolRing> timestamp_queries;
 
 	// Map of vendor specific stat data
 	VendorStatMap vendor_data;
@@ -153,11 +213,11 @@ class VulkanStatsProvider : public StatsProvider
 	// Only stats which are available and were requested end up in stat_data
 	StatDataMap stat_data;
 
-	// An ordered list of the Vulkan counter ids
-	std::vector<uint32_t> counter_indices;
+	// Counters selected by name
+	std::vector<NamedCounter> named_counters;
 
-	// How many queries have been ended?
-	uint32_t queries_ready = 0;
+	// The Vulkan counter ids that need collecting, each group must land in the same pass
+	std::vector<std::vector<uint32_t>> counter_groups;
 };
 
 }        // namespace vkb
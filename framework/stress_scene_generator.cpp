@@ -0,0 +1,309 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stress_scene_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+#include <glm/gtc/constants.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/device.h"
+#include "scene_graph/components/geometry_arena.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+#include "timer.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr float SPHERE_RADIUS = 0.5f;
+
+// The meshes cycle through this many tessellations, from MIN_SPHERE_SEGMENTS segments up
+constexpr uint32_t SPHERE_TESSELLATIONS = 8;
+
+constexpr uint32_t MIN_SPHERE_SEGMENTS = 6;
+
+// Range of the point lights, in grid cells
+constexpr float LIGHT_RANGE = 4.0f;
+
+struct Sphere
+{
+	std::vector<glm::vec3> positions;
+
+	std::vector<glm::vec3> normals;
+
+	std::vector<uint32_t> indices;
+};
+
+Sphere generate_sphere(uint32_t segments, uint32_t rings)
+{
+	Sphere sphere;
+
+	for (uint32_t ring = 0; ring <= rings; ++ring)
+	{
+		float theta = glm::pi<float>() * ring / rings;
+
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			float phi = glm::two_pi<float>() * segment / segments;
+
+			glm::vec3 normal{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+
+			sphere.normals.push_back(normal);
+			sphere.positions.push_back(normal * SPHERE_RADIUS);
+		}
+	}
+
+	// Counter-clockwise triangles seen from outside of the sphere
+	for (uint32_t ring = 0; ring < rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < segments; ++segment)
+		{
+			uint32_t top    = ring * (segments + 1) + segment;
+			uint32_t bottom = top + segments + 1;
+
+			sphere.indices.insert(sphere.indices.end(), {top, top + 1, bottom, top + 1, bottom + 1, bottom});
+		}
+	}
+
+	return sphere;
+}
+
+/**
+ * @return The offset of the data in the arena, aligned to GeometryArena::RANGE_ALIGNMENT
+ */
+template <typename T>
+size_t append_to_arena(std::vector<uint8_t> &arena, const std::vector<T> &data)
+{
+	size_t offset = (arena.size() + sg::GeometryArena::RANGE_ALIGNMENT - 1) / sg::GeometryArena::RANGE_ALIGNMENT * sg::GeometryArena::RANGE_ALIGNMENT;
+
+	arena.resize(offset + data.size() * sizeof(T));
+	std::memcpy(arena.data() + offset, data.data(), data.size() * sizeof(T));
+
+	return offset;
+}
+
+glm::vec3 get_color(uint32_t index)
+{
+	// Golden ratio steps spread the hues of consecutive indices
+	float hue = std::fmod(index * 0.618034f, 1.0f) * glm::two_pi<float>();
+
+	return glm::vec3(0.5f) + 0.5f * glm::cos(glm::vec3(hue, hue - glm::two_pi<float>() / 3.0f, hue + glm::two_pi<float>() / 3.0f));
+}
+}        // namespace
+
+StressSceneGenerator::StressSceneGenerator(Device &device) :
+    device{device}
+{
+}
+
+std::unique_ptr<sg::Scene> StressSceneGenerator::generate(const StressSceneOptions &options)
+{
+	Timer timer;
+	timer.start();
+
+	auto scene = std::make_unique<sg::Scene>("stress_scene");
+
+	uint32_t node_count      = std::max(options.node_count, 1u);
+	uint32_t hierarchy_depth = std::max(options.hierarchy_depth, 1u);
+	uint32_t mesh_count      = std::min(std::max(options.mesh_count, 1u), node_count);
+	uint32_t material_count  = std::max(options.material_count, 1u);
+
+	std::vector<sg::PBRMaterial *> materials;
+
+	for (uint32_t i = 0; i < material_count; ++i)
+	{
+		auto material = std::make_unique<sg::PBRMaterial>("material_" + std::to_string(i));
+
+		material->base_color_factor = glm::vec4(get_color(i), 1.0f);
+		material->metallic_factor   = 0.0f;
+		material->roughness_factor  = 0.5f;
+
+		materials.push_back(material.get());
+		scene->add_component(std::move(material));
+	}
+
+	// The geometry of all the meshes is packed into one vertex and one index arena
+	std::vector<uint8_t>        vertex_data;
+	std::vector<uint8_t>        index_data;
+	std::vector<sg::SubMesh *> submeshes;
+	std::vector<sg::Mesh *>    meshes;
+
+	sg::AABB bounds{glm::vec3(-SPHERE_RADIUS), glm::vec3(SPHERE_RADIUS)};
+
+	for (uint32_t i = 0; i < mesh_count; ++i)
+	{
+		uint32_t segments = MIN_SPHERE_SEGMENTS + 2 * (i % SPHERE_TESSELLATIONS);
+
+		auto sphere = generate_sphere(segments, segments / 2);
+
+		auto submesh = std::make_unique<sg::SubMesh>();
+
+		submesh->vertices_count = to_u32(sphere.positions.size());
+		submesh->vertex_indices = to_u32(sphere.indices.size());
+		submesh->index_type     = VK_INDEX_TYPE_UINT32;
+
+		sg::VertexAttribute attribute;
+		attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+		attribute.stride = to_u32(sizeof(glm::vec3));
+		submesh->set_attribute("position", attribute);
+		submesh->set_attribute("normal", attribute);
+
+		submesh->vertex_arena_offsets["position"] = append_to_arena(vertex_data, sphere.positions);
+		submesh->vertex_arena_offsets["normal"]   = append_to_arena(vertex_data, sphere.normals);
+
+		// The index arena is bound at offset zero
+		submesh->first_index = to_u32(append_to_arena(index_data, sphere.indices) / sizeof(uint32_t));
+
+		submesh->set_material(*materials[i % material_count]);
+
+		auto mesh = std::make_unique<sg::Mesh>("mesh_" + std::to_string(i));
+		mesh->update_bounds(bounds);
+		mesh->add_submesh(*submesh);
+
+		submeshes.push_back(submesh.get());
+		meshes.push_back(mesh.get());
+
+		scene->add_component(std::move(submesh));
+		scene->add_component(std::move(mesh));
+	}
+
+	core::Buffer vertex_buffer{device, vertex_data.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+	vertex_buffer.update(vertex_data);
+
+	core::Buffer index_buffer{device, index_data.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+	index_buffer.update(index_data);
+
+	auto vertex_arena = std::make_unique<sg::GeometryArena>("vertex_arena_0", std::move(vertex_buffer));
+	auto index_arena  = std::make_unique<sg::GeometryArena>("index_arena_0", std::move(index_buffer));
+
+	for (auto submesh : submeshes)
+	{
+		submesh->vertex_arena = vertex_arena.get();
+		submesh->index_arena  = index_arena.get();
+	}
+
+	scene->add_component(std::move(vertex_arena));
+	scene->add_component(std::move(index_arena));
+
+	// The nodes fill a cube of grid cells, the meshes are assigned at random
+	std::mt19937                            random{options.seed};
+	std::uniform_int_distribution<uint32_t> mesh_distribution{0, mesh_count - 1};
+
+	auto grid_size = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(node_count))));
+	auto extent    = grid_size * options.spacing;
+
+	auto get_grid_position = [grid_size, &options](uint32_t index) {
+		glm::vec3 cell(index % grid_size, (index / grid_size) % grid_size, index / (grid_size * grid_size));
+		return (cell - glm::vec3(0.5f * (grid_size - 1))) * options.spacing;
+	};
+
+	std::vector<std::unique_ptr<sg::Node>> nodes;
+	nodes.reserve(node_count + 1);
+
+	auto root_node = std::make_unique<sg::Node>(0, "stress_scene");
+
+	for (uint32_t i = 0; i < node_count; ++i)
+	{
+		auto node = std::make_unique<sg::Node>(i + 1, "node_" + std::to_string(i));
+
+		auto position = get_grid_position(i);
+
+		// A node starting a chain is a child of the root, the others are placed relative to the previous node
+		if (i % hierarchy_depth == 0)
+		{
+			node->get_transform().set_translation(position);
+			node->set_parent(*root_node);
+			root_node->add_child(*node);
+		}
+		else
+		{
+			auto &parent = *nodes.back();
+			node->get_transform().set_translation(position - get_grid_position(i - 1));
+			node->set_parent(parent);
+			parent.add_child(*node);
+		}
+
+		auto mesh = meshes[mesh_distribution(random)];
+		node->set_component(*mesh);
+		mesh->add_node(*node);
+
+		nodes.push_back(std::move(node));
+	}
+
+	scene->set_root_node(*root_node);
+	nodes.push_back(std::move(root_node));
+
+	scene->set_nodes(std::move(nodes));
+
+	// The camera looks at the grid down the -z axis
+	auto camera_node = std::make_unique<sg::Node>(-1, "default_camera");
+	camera_node->get_transform().set_translation(glm::vec3(0.0f, 0.0f, 1.5f * extent));
+
+	auto camera = std::make_unique<sg::PerspectiveCamera>("default_camera");
+	camera->set_aspect_ratio(1.77f);
+	camera->set_field_of_view(1.0f);
+	camera->set_near_plane(0.1f);
+	camera->set_far_plane(4.0f * extent + 100.0f);
+	camera->set_node(*camera_node);
+	camera_node->set_component(*camera);
+	scene->add_component(std::move(camera));
+
+	scene->get_root_node().add_child(*camera_node);
+	scene->add_node(std::move(camera_node));
+
+	std::uniform_real_distribution<float> light_distribution{-0.5f * extent, 0.5f * extent};
+
+	for (uint32_t i = 0; i < options.light_count; ++i)
+	{
+		sg::LightProperties properties;
+		properties.color = get_color(i);
+		properties.range = LIGHT_RANGE * options.spacing;
+
+		glm::vec3 position{light_distribution(random), light_distribution(random), light_distribution(random)};
+		add_point_light(*scene, position, properties);
+	}
+
+	if (options.light_count == 0)
+	{
+		add_directional_light(*scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
+	}
+
+	LOGI("Generated a scene of {} nodes, {} meshes, {} materials and {} lights in {} seconds",
+	     node_count, mesh_count, material_count, options.light_count, vkb::to_string(timer.stop()));
+
+	return scene;
+}
+}        // namespace vkb
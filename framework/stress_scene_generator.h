@@ -0,0 +1,78 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Parameters of a procedurally generated scene
+ */
+struct StressSceneOptions
+{
+	/// Number of nodes drawing a mesh
+	uint32_t node_count{1000};
+
+	/// Number of nodes in every chain of parented nodes, 1 for a flat scene
+	uint32_t hierarchy_depth{1};
+
+	/// Number of unique meshes, at most node_count are created
+	uint32_t mesh_count{16};
+
+	/// Number of unique materials, assigned to the meshes in turn
+	uint32_t material_count{16};
+
+	/// Number of point lights, a directional light is added when there are none
+	uint32_t light_count{1};
+
+	/// Distance between the nodes, which are laid out on a grid
+	float spacing{2.0f};
+
+	/// Seed of the assignment of the meshes to the nodes
+	uint32_t seed{0};
+};
+
+/**
+ * @brief Generates scenes of configurable size, to measure how culling, sorting, descriptor
+ *        management and draw submission scale with the node, mesh, material and light counts
+ *
+ * The meshes are spheres of different tessellations, their vertices and indices are packed in
+ * a single vertex arena and a single index arena as the GLTFLoader does. The scene has a
+ * `default_camera` node looking at the whole grid.
+ */
+class StressSceneGenerator
+{
+  public:
+	StressSceneGenerator(Device &device);
+
+	std::unique_ptr<sg::Scene> generate(const StressSceneOptions &options);
+
+  private:
+	Device &device;
+};
+}        // namespace vkb
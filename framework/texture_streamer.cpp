@@ -0,0 +1,209 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "scene_graph/components/image.h"
+
+namespace vkb
+{
+TextureStreamer::TextureStreamer(Device &device, VkDeviceSize budget, uint32_t resident_levels) :
+    device{device},
+    upload_manager{device},
+    budget{budget},
+    resident_levels{std::max(resident_levels, 1u)}
+{
+}
+
+bool TextureStreamer::can_stream(const sg::Image &image) const
+{
+	return image.get_mipmaps().size() > resident_levels && !image.has_gpu_mipmaps() && !image.get_data().empty() &&
+	       image.get_layers() == 1 && image.get_extent().depth == 1;
+}
+
+uint32_t TextureStreamer::get_initial_base_level(const sg::Image &image) const
+{
+	return to_u32(image.get_mipmaps().size()) - resident_levels;
+}
+
+void TextureStreamer::add_image(sg::Image &image)
+{
+	assert(image_indices.find(&image) == image_indices.end() && "Image already streamed");
+
+	StreamedImage streamed_image{};
+	streamed_image.image           = &image;
+	streamed_image.requested_level = std::numeric_limits<uint32_t>::max();
+	streamed_image.wanted_level    = get_initial_base_level(image);
+
+	image_indices[&image] = images.size();
+	images.push_back(streamed_image);
+
+	resident_size += image.get_level_data_size(image.get_base_level());
+}
+
+void TextureStreamer::clear()
+{
+	images.clear();
+	image_indices.clear();
+
+	resident_size = 0;
+}
+
+void TextureStreamer::request_level(const sg::Image &image, uint32_t level)
+{
+	auto it = image_indices.find(&image);
+
+	if (it == image_indices.end())
+	{
+		return;
+	}
+
+	auto &streamed_image = images[it->second];
+
+	streamed_image.requested_level = std::min(streamed_image.requested_level, level);
+}
+
+bool TextureStreamer::update()
+{
+	++update_count;
+
+	bool changed = false;
+
+	std::vector<StreamedImage *> upgrades;
+
+	for (auto &streamed_image : images)
+	{
+		auto initial_level = get_initial_base_level(*streamed_image.image);
+
+		if (streamed_image.requested_level != std::numeric_limits<uint32_t>::max())
+		{
+			streamed_image.wanted_level = std::min(streamed_image.requested_level, initial_level);
+			streamed_image.last_request = update_count;
+		}
+		else if (update_count - streamed_image.last_request > REQUEST_TIMEOUT)
+		{
+			streamed_image.wanted_level = initial_level;
+		}
+
+		streamed_image.requested_level = std::numeric_limits<uint32_t>::max();
+
+		auto base_level = streamed_image.image->get_base_level();
+
+		if (streamed_image.wanted_level < base_level)
+		{
+			upgrades.push_back(&streamed_image);
+		}
+		else if (streamed_image.wanted_level > base_level && update_count - streamed_image.last_request > REQUEST_TIMEOUT)
+		{
+			// Images no longer sampled give their levels back right away
+			set_base_level(streamed_image, streamed_image.wanted_level);
+			changed = true;
+		}
+	}
+
+	// The finest requests are streamed first
+	std::sort(upgrades.begin(), upgrades.end(), [](const StreamedImage *lhs, const StreamedImage *rhs) {
+		return lhs->wanted_level < rhs->wanted_level;
+	});
+
+	VkDeviceSize upload_size = 0;
+
+	for (auto upgrade : upgrades)
+	{
+		auto &image      = *upgrade->image;
+		auto  base_level = image.get_base_level();
+
+		// Evicts the levels of the images sampled coarser than they are resident until the wanted levels fit
+		while (resident_size - image.get_level_data_size(base_level) + image.get_level_data_size(upgrade->wanted_level) > budget)
+		{
+			auto eviction = std::max_element(images.begin(), images.end(), [](const StreamedImage &lhs, const StreamedImage &rhs) {
+				return lhs.wanted_level - std::min(lhs.wanted_level, lhs.image->get_base_level()) <
+				       rhs.wanted_level - std::min(rhs.wanted_level, rhs.image->get_base_level());
+			});
+
+			if (eviction == images.end() || eviction->wanted_level <= eviction->image->get_base_level())
+			{
+				break;
+			}
+
+			set_base_level(*eviction, eviction->wanted_level);
+			changed = true;
+		}
+
+		// Streams the finest level that fits in the budget
+		auto level = upgrade->wanted_level;
+		while (level < base_level && resident_size - image.get_level_data_size(base_level) + image.get_level_data_size(level) > budget)
+		{
+			++level;
+		}
+
+		if (level == base_level)
+		{
+			continue;
+		}
+
+		set_base_level(*upgrade, level);
+		changed = true;
+
+		upload_size += image.get_level_data_size(level);
+		if (upload_size >= MAX_UPLOAD_SIZE)
+		{
+			break;
+		}
+	}
+
+	upload_manager.flush();
+
+	return changed;
+}
+
+void TextureStreamer::set_budget(VkDeviceSize budget_)
+{
+	budget = budget_;
+}
+
+VkDeviceSize TextureStreamer::get_budget() const
+{
+	return budget;
+}
+
+VkDeviceSize TextureStreamer::get_resident_size() const
+{
+	return resident_size;
+}
+
+void TextureStreamer::set_base_level(StreamedImage &streamed_image, uint32_t base_level)
+{
+	auto &image = *streamed_image.image;
+
+	resident_size -= image.get_level_data_size(image.get_base_level());
+
+	auto previous = image.recreate_vk_image(device, base_level);
+
+	image.upload(upload_manager);
+
+	resident_size += image.get_level_data_size(base_level);
+
+	// The frames recorded so far may still sample the previous image, the pair destroys its view first
+	device.get_deletion_queue().retire(std::move(previous));
+}
+}        // namespace vkb
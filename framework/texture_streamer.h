@@ -0,0 +1,164 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "upload_manager.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Image;
+}
+
+/**
+ * @brief Streams the finer mip levels of images under a memory budget
+ *
+ * Streamed images keep the data of all their levels on the CPU, while their Vulkan image only holds
+ * the levels from a base level on. They start with their coarsest levels resident. Each frame the
+ * renderers request the level they sample, and update() recreates the Vulkan images of the images
+ * whose requested level is finer than their base level, finest requests first, evicting the levels
+ * of images which are no longer requested when it runs out of budget.
+ *
+ * Recreated images leave the previous Vulkan image to be destroyed once the frames in flight have
+ * completed, and descriptor sets bound to the previous view have been recycled.
+ */
+class TextureStreamer
+{
+  public:
+	/**
+	 * @brief Default number of the coarsest levels resident in every streamed image
+	 */
+	static constexpr uint32_t DEFAULT_RESIDENT_LEVELS = 6;
+
+	/**
+	 * @brief Number of updates without a request after which an image falls back to its resident levels
+	 */
+	static constexpr uint64_t REQUEST_TIMEOUT = 120;
+
+	/**
+	 * @brief Maximum number of bytes uploaded by an update, so that streaming does not stall a frame
+	 */
+	static constexpr VkDeviceSize MAX_UPLOAD_SIZE = 16 * 1024 * 1024;
+
+	/**
+	 * @param device A valid Vulkan device
+	 * @param budget Memory budget of the levels of the streamed images in bytes
+	 * @param resident_levels Number of the coarsest levels always resident
+	 */
+	TextureStreamer(Device &device, VkDeviceSize budget, uint32_t resident_levels = DEFAULT_RESIDENT_LEVELS);
+
+	TextureStreamer(const TextureStreamer &) = delete;
+
+	TextureStreamer(TextureStreamer &&) = delete;
+
+	~TextureStreamer() = default;
+
+	TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+	TextureStreamer &operator=(TextureStreamer &&) = delete;
+
+	/**
+	 * @return Whether the levels of an image can be streamed, for 2D images with more levels
+	 *         than the resident ones and the data of each level
+	 */
+	bool can_stream(const sg::Image &image) const;
+
+	/**
+	 * @return The base level a streamable image is created with
+	 */
+	uint32_t get_initial_base_level(const sg::Image &image) const;
+
+	/**
+	 * @brief Starts streaming an image, created with its initial base level and uploaded
+	 */
+	void add_image(sg::Image &image);
+
+	/**
+	 * @brief Stops streaming the images, before they are destroyed
+	 */
+	void clear();
+
+	/**
+	 * @brief Requests a level of an image for the next update, the finest level requested since the last update is kept
+	 *        Images which are not streamed are ignored.
+	 */
+	void request_level(const sg::Image &image, uint32_t level);
+
+	/**
+	 * @brief Streams in or evicts levels following the requests
+	 *        Replaced Vulkan images go to the deletion queue of the device, until the frames which may sample them have completed.
+	 *        Submissions made on the graphics queue afterwards see the uploaded levels.
+	 * @return Whether a Vulkan image was replaced, so that recorded draws need to be invalidated
+	 */
+	bool update();
+
+	void set_budget(VkDeviceSize budget);
+
+	VkDeviceSize get_budget() const;
+
+	/**
+	 * @return Size in bytes of the resident levels of the streamed images
+	 */
+	VkDeviceSize get_resident_size() const;
+
+  private:
+	struct StreamedImage
+	{
+		sg::Image *image;
+
+		/// Finest level requested since the last update
+		uint32_t requested_level;
+
+		/// Level the image should have resident, following the requests
+		uint32_t wanted_level;
+
+		/// Update at which the image was last requested
+		uint64_t last_request{0};
+	};
+
+	/**
+	 * @brief Recreates the Vulkan image of a streamed image with the levels from a base level on, and uploads them
+	 */
+	void set_base_level(StreamedImage &streamed_image, uint32_t base_level);
+
+	Device &device;
+
+	UploadManager upload_manager;
+
+	VkDeviceSize budget;
+
+	uint32_t resident_levels;
+
+	std::vector<StreamedImage> images;
+
+	std::unordered_map<const sg::Image *, size_t> image_indices;
+
+	uint64_t update_count{0};
+
+	VkDeviceSize resident_size{0};
+};
+}        // namespace vkb
@@ -0,0 +1,67 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief A timeline semaphore counting the submissions of a frame
+ *        Each submission signals the next value, so waiting for the last requested value
+ *        replaces waiting on and resetting a fence per submission.
+ */
+class TimelineSemaphore
+{
+  public:
+	TimelineSemaphore(Device &device);
+
+	TimelineSemaphore(const TimelineSemaphore &) = delete;
+
+	TimelineSemaphore(TimelineSemaphore &&other) = delete;
+
+	~TimelineSemaphore();
+
+	TimelineSemaphore &operator=(const TimelineSemaphore &) = delete;
+
+	TimelineSemaphore &operator=(TimelineSemaphore &&) = delete;
+
+	VkSemaphore get_handle() const;
+
+	/**
+	 * @return The value to be signaled by the next submission
+	 */
+	uint64_t request_value();
+
+	/**
+	 * @brief Waits until the last requested value has been signaled
+	 */
+	VkResult wait(uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
+
+  private:
+	Device &device;
+
+	VkSemaphore handle{VK_NULL_HANDLE};
+
+	/// Last value requested for a submission
+	uint64_t value{0};
+};
+}        // namespace vkb
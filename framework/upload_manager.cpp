@@ -0,0 +1,532 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "upload_manager.h"
+
+#include <limits>
+
+#include "common/logging.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Finds a transfer queue outside of the graphics families, able to copy any mip level extent
+ * @return The transfer queue, or the graphics queue if there is none
+ */
+const Queue &find_transfer_queue(Device &device)
+{
+	auto &transfer_queue = device.get_queue(device.get_queue_family_index(VK_QUEUE_TRANSFER_BIT), 0);
+
+	auto  properties  = transfer_queue.get_properties();
+	auto &granularity = properties.minImageTransferGranularity;
+
+	if ((properties.queueFlags & VK_QUEUE_GRAPHICS_BIT) || granularity.width != 1 || granularity.height != 1 || granularity.depth != 1)
+	{
+		return device.get_suitable_graphics_queue();
+	}
+
+	return transfer_queue;
+}
+
+inline VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Blits each level of an image in transfer destination layout from the previous one, then transitions all levels to shader read only layout
+ */
+void record_mipmap_blits(CommandBuffer &command_buffer, const core::ImageView &image_view, VkPipelineStageFlags dst_stage_mask)
+{
+	auto &image = image_view.get_image();
+	auto  range = image_view.get_subresource_range();
+
+	VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image                       = image.get_handle();
+	barrier.subresourceRange            = range;
+	barrier.subresourceRange.levelCount = 1;
+
+	auto level_extent = [&image](uint32_t level) {
+		auto &extent = image.get_extent();
+		return VkOffset3D{std::max(1, static_cast<int32_t>(extent.width >> level)),
+		                  std::max(1, static_cast<int32_t>(extent.height >> level)),
+		                  std::max(1, static_cast<int32_t>(extent.depth >> level))};
+	};
+
+	for (uint32_t i = 1; i < range.levelCount; ++i)
+	{
+		auto src_level = range.baseMipLevel + i - 1;
+
+		// The previous level was written by the copy or the previous blit
+		barrier.subresourceRange.baseMipLevel = src_level;
+		barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout                     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask                 = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(command_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageBlit blit{};
+		blit.srcSubresource.aspectMask     = range.aspectMask;
+		blit.srcSubresource.mipLevel       = src_level;
+		blit.srcSubresource.baseArrayLayer = range.baseArrayLayer;
+		blit.srcSubresource.layerCount     = range.layerCount;
+		blit.srcOffsets[1]                 = level_extent(src_level);
+		blit.dstSubresource                = blit.srcSubresource;
+		blit.dstSubresource.mipLevel       = src_level + 1;
+		blit.dstOffsets[1]                 = level_extent(src_level + 1);
+
+		vkCmdBlitImage(command_buffer.get_handle(), image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		               image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+	}
+
+	// All levels but the last one were blitted from
+	std::array<VkImageMemoryBarrier, 2> read_barriers{barrier, barrier};
+
+	read_barriers[0].subresourceRange.baseMipLevel = range.baseMipLevel;
+	read_barriers[0].subresourceRange.levelCount   = range.levelCount - 1;
+	read_barriers[0].oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	read_barriers[0].newLayout                     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	read_barriers[0].srcAccessMask                 = VK_ACCESS_TRANSFER_READ_BIT;
+	read_barriers[0].dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
+
+	read_barriers[1].subresourceRange.baseMipLevel = range.baseMipLevel + range.levelCount - 1;
+	read_barriers[1].subresourceRange.levelCount   = 1;
+	read_barriers[1].oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	read_barriers[1].newLayout                     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	read_barriers[1].srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
+	read_barriers[1].dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(command_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage_mask, 0, 0, nullptr, 0, nullptr,
+	                     to_u32(read_barriers.size()), read_barriers.data());
+}
+}        // namespace
+
+UploadManager::UploadManager(Device &device, VkDeviceSize staging_size) :
+    device{device},
+    transfer_queue{find_transfer_queue(device)},
+    graphics_queue{device.get_suitable_graphics_queue()}
+{
+	ownership_transfer = transfer_queue.get_family_index() != graphics_queue.get_family_index();
+
+	// Copies to images need offsets aligned to the texel block size, 16 bytes covers all formats
+	staging_alignment = std::max<VkDeviceSize>(staging_alignment, device.get_gpu().get_properties().limits.optimalBufferCopyOffsetAlignment);
+
+	slot_size = align_up(staging_size / BATCH_COUNT, staging_alignment);
+
+	staging_buffer = std::make_unique<core::Buffer>(device, slot_size * BATCH_COUNT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+
+	for (auto &batch : batches)
+	{
+		batch.transfer_command_pool = std::make_unique<CommandPool>(device, transfer_queue.get_family_index());
+
+		if (ownership_transfer)
+		{
+			batch.graphics_command_pool = std::make_unique<CommandPool>(device, graphics_queue.get_family_index());
+
+			VkSemaphoreCreateInfo semaphore_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+			VK_CHECK(vkCreateSemaphore(device.get_handle(), &semaphore_info, nullptr, &batch.semaphore));
+		}
+
+		VkFenceCreateInfo fence_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+		VK_CHECK(vkCreateFence(device.get_handle(), &fence_info, nullptr, &batch.fence));
+	}
+
+	LOGI("Uploads use queue family {}{}", transfer_queue.get_family_index(), ownership_transfer ? " (dedicated transfer)" : "");
+}
+
+UploadManager::~UploadManager()
+{
+	wait();
+
+	for (auto &batch : batches)
+	{
+		if (batch.semaphore != VK_NULL_HANDLE)
+		{
+			vkDestroySemaphore(device.get_handle(), batch.semaphore, nullptr);
+		}
+
+		vkDestroyFence(device.get_handle(), batch.fence, nullptr);
+	}
+}
+
+void UploadManager::upload_buffer(const core::Buffer &buffer, const uint8_t *data, VkDeviceSize size, VkDeviceSize offset,
+                                  VkPipelineStageFlags dst_stage_mask, VkAccessFlags dst_access_mask)
+{
+	auto staging = stage(data, size);
+
+	auto &batch = get_recording_batch();
+
+	VkBufferCopy copy_region{};
+	copy_region.srcOffset = staging.second;
+	copy_region.dstOffset = offset;
+	copy_region.size      = size;
+
+	vkCmdCopyBuffer(batch.transfer_command_buffer->get_handle(), staging.first->get_handle(), buffer.get_handle(), 1, &copy_region);
+
+	VkBufferMemoryBarrier memory_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	memory_barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dstAccessMask       = dst_access_mask;
+	memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	memory_barrier.buffer              = buffer.get_handle();
+	memory_barrier.offset              = offset;
+	memory_barrier.size                = size;
+
+	add_release_barriers(batch, &memory_barrier, nullptr, dst_stage_mask);
+
+	batch.bytes += size;
+}
+
+void UploadManager::upload_image(const core::ImageView &image_view, const std::vector<uint8_t> &data, const std::vector<VkBufferImageCopy> &regions,
+                                 VkPipelineStageFlags dst_stage_mask, bool generate_mipmaps)
+{
+	auto staging = stage(data.data(), data.size());
+
+	auto &batch = get_recording_batch();
+
+	ImageCopy image_copy{&image_view, staging.first, regions, dst_stage_mask, generate_mipmaps && image_view.get_subresource_range().levelCount > 1};
+
+	for (auto &region : image_copy.regions)
+	{
+		region.bufferOffset += staging.second;
+	}
+
+	VkImageMemoryBarrier memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	memory_barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	memory_barrier.newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	memory_barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+	memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	memory_barrier.image               = image_view.get_image().get_handle();
+	memory_barrier.subresourceRange    = image_view.get_subresource_range();
+
+	if (image_copy.generate_mipmaps)
+	{
+		// Blits need a graphics queue, the transfer queue is the graphics queue without ownership transfer
+		if (ownership_transfer)
+		{
+			memory_barrier.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			add_release_barriers(batch, nullptr, &memory_barrier, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		}
+	}
+	else
+	{
+		add_release_barriers(batch, nullptr, &memory_barrier, dst_stage_mask);
+	}
+
+	batch.image_copies.push_back(std::move(image_copy));
+
+	batch.bytes += data.size();
+}
+
+void UploadManager::add_release_barriers(Batch &batch, VkBufferMemoryBarrier *buffer_barrier, VkImageMemoryBarrier *image_barrier, VkPipelineStageFlags dst_stage_mask)
+{
+	if (!ownership_transfer)
+	{
+		if (buffer_barrier)
+		{
+			batch.transfer_barriers.buffer_barriers.push_back(*buffer_barrier);
+		}
+		if (image_barrier)
+		{
+			batch.transfer_barriers.image_barriers.push_back(*image_barrier);
+		}
+
+		batch.transfer_barriers.src_stage_mask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		batch.transfer_barriers.dst_stage_mask |= dst_stage_mask;
+
+		return;
+	}
+
+	// The release only makes the writes available, the acquire makes them visible to the readers.
+	// Both halves of the transfer of an image perform the same layout transition, which happens once
+	auto release = [this](auto barrier) {
+		barrier.dstAccessMask       = 0;
+		barrier.srcQueueFamilyIndex = transfer_queue.get_family_index();
+		barrier.dstQueueFamilyIndex = graphics_queue.get_family_index();
+		return barrier;
+	};
+
+	auto acquire = [this](auto barrier) {
+		barrier.srcAccessMask       = 0;
+		barrier.srcQueueFamilyIndex = transfer_queue.get_family_index();
+		barrier.dstQueueFamilyIndex = graphics_queue.get_family_index();
+		return barrier;
+	};
+
+	if (buffer_barrier)
+	{
+		batch.transfer_barriers.buffer_barriers.push_back(release(*buffer_barrier));
+		batch.graphics_barriers.buffer_barriers.push_back(acquire(*buffer_barrier));
+	}
+	if (image_barrier)
+	{
+		batch.transfer_barriers.image_barriers.push_back(release(*image_barrier));
+		batch.graphics_barriers.image_barriers.push_back(acquire(*image_barrier));
+	}
+
+	batch.transfer_barriers.src_stage_mask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+	batch.transfer_barriers.dst_stage_mask |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+	batch.graphics_barriers.src_stage_mask |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	batch.graphics_barriers.dst_stage_mask |= dst_stage_mask;
+}
+
+void UploadManager::record_pending(Batch &batch)
+{
+	auto &transfer_command_buffer = *batch.transfer_command_buffer;
+
+	if (!batch.image_copies.empty())
+	{
+		// All the images of the batch move to transfer layout at once
+		Barriers layout_barriers;
+		layout_barriers.src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		layout_barriers.dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		for (auto &image_copy : batch.image_copies)
+		{
+			VkImageMemoryBarrier memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+			memory_barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			memory_barrier.srcAccessMask       = 0;
+			memory_barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			memory_barrier.image               = image_copy.image_view->get_image().get_handle();
+			memory_barrier.subresourceRange    = image_copy.image_view->get_subresource_range();
+
+			layout_barriers.image_barriers.push_back(memory_barrier);
+		}
+
+		layout_barriers.record(transfer_command_buffer);
+
+		for (auto &image_copy : batch.image_copies)
+		{
+			transfer_command_buffer.copy_buffer_to_image(*image_copy.staging_buffer, image_copy.image_view->get_image(), image_copy.regions);
+		}
+	}
+
+	batch.transfer_barriers.record(transfer_command_buffer);
+
+	// Mipmaps are blitted once the first levels are copied, on the graphics queue
+	auto &blit_command_buffer = ownership_transfer ? *batch.graphics_command_buffer : transfer_command_buffer;
+
+	if (ownership_transfer)
+	{
+		batch.graphics_barriers.record(blit_command_buffer);
+	}
+
+	for (auto &image_copy : batch.image_copies)
+	{
+		if (image_copy.generate_mipmaps)
+		{
+			record_mipmap_blits(blit_command_buffer, *image_copy.image_view, image_copy.dst_stage_mask);
+		}
+	}
+
+	batch.image_copies.clear();
+	batch.transfer_barriers = {};
+	batch.graphics_barriers = {};
+}
+
+void UploadManager::Barriers::record(CommandBuffer &command_buffer)
+{
+	if (buffer_barriers.empty() && image_barriers.empty())
+	{
+		return;
+	}
+
+	vkCmdPipelineBarrier(command_buffer.get_handle(), src_stage_mask, dst_stage_mask, 0, 0, nullptr,
+	                     to_u32(buffer_barriers.size()), buffer_barriers.data(),
+	                     to_u32(image_barriers.size()), image_barriers.data());
+}
+
+void UploadManager::flush()
+{
+	auto &batch = batches[batch_index];
+
+	if (!batch.transfer_command_buffer)
+	{
+		return;
+	}
+
+	record_pending(batch);
+
+	batch.transfer_command_buffer->end();
+
+	VkSubmitInfo transfer_submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	transfer_submit_info.commandBufferCount = 1;
+	transfer_submit_info.pCommandBuffers    = &batch.transfer_command_buffer->get_handle();
+
+	if (ownership_transfer)
+	{
+		batch.graphics_command_buffer->end();
+
+		transfer_submit_info.signalSemaphoreCount = 1;
+		transfer_submit_info.pSignalSemaphores    = &batch.semaphore;
+
+		VK_CHECK(transfer_queue.submit({transfer_submit_info}, VK_NULL_HANDLE));
+
+		// Graphics work submitted before keeps running, the acquisitions only wait for the copies
+		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		VkSubmitInfo graphics_submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+		graphics_submit_info.commandBufferCount = 1;
+		graphics_submit_info.pCommandBuffers    = &batch.graphics_command_buffer->get_handle();
+		graphics_submit_info.waitSemaphoreCount = 1;
+		graphics_submit_info.pWaitSemaphores    = &batch.semaphore;
+		graphics_submit_info.pWaitDstStageMask  = &wait_stage;
+
+		VK_CHECK(graphics_queue.submit({graphics_submit_info}, batch.fence));
+	}
+	else
+	{
+		VK_CHECK(transfer_queue.submit({transfer_submit_info}, batch.fence));
+	}
+
+	batch.transfer_command_buffer = nullptr;
+	batch.graphics_command_buffer = nullptr;
+	batch.in_flight               = true;
+
+	if (in_flight_count++ == 0)
+	{
+		busy_timer.start();
+	}
+
+	batch_index = (batch_index + 1) % BATCH_COUNT;
+}
+
+void UploadManager::wait()
+{
+	flush();
+
+	for (auto &batch : batches)
+	{
+		complete(batch);
+	}
+}
+
+bool UploadManager::uses_dedicated_transfer_queue() const
+{
+	return ownership_transfer;
+}
+
+uint64_t UploadManager::get_uploaded_bytes() const
+{
+	return uploaded_bytes;
+}
+
+double UploadManager::get_throughput() const
+{
+	if (busy_seconds <= 0.0)
+	{
+		return 0.0;
+	}
+
+	return uploaded_bytes / (1024.0 * 1024.0) / busy_seconds;
+}
+
+UploadManager::Batch &UploadManager::get_recording_batch()
+{
+	auto &batch = batches[batch_index];
+
+	if (!batch.transfer_command_buffer)
+	{
+		// The slot of the batch is reused, its previous copies must have completed
+		complete(batch);
+
+		batch.transfer_command_pool->reset_pool();
+		batch.transfer_command_buffer = &batch.transfer_command_pool->request_command_buffer();
+		batch.transfer_command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+		if (ownership_transfer)
+		{
+			batch.graphics_command_pool->reset_pool();
+			batch.graphics_command_buffer = &batch.graphics_command_pool->request_command_buffer();
+			batch.graphics_command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		}
+	}
+
+	return batch;
+}
+
+std::pair<const core::Buffer *, VkDeviceSize> UploadManager::stage(const uint8_t *data, VkDeviceSize size)
+{
+	if (size > slot_size)
+	{
+		auto &batch = get_recording_batch();
+
+		batch.dedicated_staging_buffers.emplace_back(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+
+		auto &buffer = batch.dedicated_staging_buffers.back();
+		buffer.update(data, size);
+
+		return {&buffer, 0};
+	}
+
+	auto offset = align_up(batches[batch_index].staging_used, staging_alignment);
+
+	if (batches[batch_index].transfer_command_buffer && offset + size > slot_size)
+	{
+		flush();
+
+		offset = 0;
+	}
+
+	auto &batch = get_recording_batch();
+
+	auto staging_offset = batch_index * slot_size + offset;
+
+	staging_buffer->update(data, size, staging_offset);
+
+	batch.staging_used = offset + size;
+
+	return {staging_buffer.get(), staging_offset};
+}
+
+void UploadManager::complete(Batch &batch)
+{
+	if (!batch.in_flight)
+	{
+		return;
+	}
+
+	VK_CHECK(vkWaitForFences(device.get_handle(), 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+	VK_CHECK(vkResetFences(device.get_handle(), 1, &batch.fence));
+
+	batch.dedicated_staging_buffers.clear();
+	batch.staging_used = 0;
+	batch.in_flight    = false;
+
+	uploaded_bytes += batch.bytes;
+	batch.bytes = 0;
+
+	if (--in_flight_count == 0)
+	{
+		busy_seconds += busy_timer.stop();
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,251 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/command_pool.h"
+#include "core/image_view.h"
+#include "timer.h"
+
+namespace vkb
+{
+class Device;
+class Queue;
+
+/**
+ * @brief Uploads buffers and images through a staging ring, on a dedicated transfer queue when the device has one
+ *
+ * Copies are batched into command buffers, each batch staging its data in its own slot of the ring.
+ * The image copies of a batch are recorded when it is submitted, between a single barrier moving all
+ * its images to transfer layout and a single barrier releasing all its resources to their readers.
+ * A submitted batch is only waited on when its slot is needed again, or by wait(), so the graphics
+ * queue keeps running while the copies execute. With a dedicated transfer queue, the resources are
+ * released by the transfer queue and acquired by a command buffer on the graphics queue, which waits
+ * on a semaphore signaled by the copies. Submissions made on the graphics queue after flush() see the
+ * uploaded data.
+ *
+ * The manager is not thread safe.
+ */
+class UploadManager
+{
+  public:
+	/**
+	 * @brief Default size of the staging ring in bytes
+	 */
+	static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32 * 1024 * 1024;
+
+	/**
+	 * @brief Number of batches, and of slots in the staging ring
+	 */
+	static constexpr uint32_t BATCH_COUNT = 3;
+
+	/**
+	 * @param device A valid Vulkan device
+	 * @param staging_size Size of the staging ring, larger uploads get a staging buffer of their own
+	 */
+	UploadManager(Device &device, VkDeviceSize staging_size = DEFAULT_STAGING_SIZE);
+
+	UploadManager(const UploadManager &) = delete;
+
+	UploadManager(UploadManager &&) = delete;
+
+	/**
+	 * @brief Waits for all the uploads to complete
+	 */
+	~UploadManager();
+
+	UploadManager &operator=(const UploadManager &) = delete;
+
+	UploadManager &operator=(UploadManager &&) = delete;
+
+	/**
+	 * @brief Copies data to a buffer which is not in use by the device
+	 * @param buffer The destination buffer
+	 * @param data The data to copy
+	 * @param size Size of the data in bytes
+	 * @param offset Offset of the data in the buffer
+	 * @param dst_stage_mask Stages reading the buffer once uploaded
+	 * @param dst_access_mask Accesses reading the buffer once uploaded
+	 */
+	void upload_buffer(const core::Buffer &buffer, const uint8_t *data, VkDeviceSize size, VkDeviceSize offset,
+	                   VkPipelineStageFlags dst_stage_mask, VkAccessFlags dst_access_mask);
+
+	/**
+	 * @brief Copies data to an image with undefined content, and leaves it in shader read only layout
+	 *        The copy is recorded when the batch is submitted, the view must stay valid until then
+	 * @param image_view The view of the subresources to upload
+	 * @param data The data to copy
+	 * @param regions The copies, with buffer offsets relative to the start of the data
+	 * @param dst_stage_mask Stages reading the image once uploaded
+	 * @param generate_mipmaps Whether the levels after the first one of the view are blitted from it on the graphics queue,
+	 *        the regions then only cover the first level
+	 */
+	void upload_image(const core::ImageView &image_view, const std::vector<uint8_t> &data, const std::vector<VkBufferImageCopy> &regions,
+	                  VkPipelineStageFlags dst_stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, bool generate_mipmaps = false);
+
+	/**
+	 * @brief Submits the copies recorded so far without waiting for them
+	 */
+	void flush();
+
+	/**
+	 * @brief Submits the copies recorded so far and waits for all the uploads to complete
+	 */
+	void wait();
+
+	/**
+	 * @return Whether the copies run on a transfer queue separate from the graphics queue
+	 */
+	bool uses_dedicated_transfer_queue() const;
+
+	/**
+	 * @return Number of bytes of the uploads completed so far
+	 */
+	uint64_t get_uploaded_bytes() const;
+
+	/**
+	 * @return Throughput of the completed uploads in MB/s, over the time uploads were in flight
+	 *         until their completion was waited on
+	 */
+	double get_throughput() const;
+
+  private:
+	/**
+	 * @brief Barriers recorded together in a single pipeline barrier
+	 */
+	struct Barriers
+	{
+		std::vector<VkBufferMemoryBarrier> buffer_barriers;
+
+		std::vector<VkImageMemoryBarrier> image_barriers;
+
+		VkPipelineStageFlags src_stage_mask{0};
+
+		VkPipelineStageFlags dst_stage_mask{0};
+
+		void record(CommandBuffer &command_buffer);
+	};
+
+	/**
+	 * @brief Copy to an image, recorded when its batch is submitted
+	 */
+	struct ImageCopy
+	{
+		const core::ImageView *image_view;
+
+		const core::Buffer *staging_buffer;
+
+		std::vector<VkBufferImageCopy> regions;
+
+		VkPipelineStageFlags dst_stage_mask;
+
+		bool generate_mipmaps;
+	};
+
+	struct Batch
+	{
+		std::unique_ptr<CommandPool> transfer_command_pool;
+
+		/// Acquires the uploaded resources on the graphics queue, only with a dedicated transfer queue
+		std::unique_ptr<CommandPool> graphics_command_pool;
+
+		CommandBuffer *transfer_command_buffer{nullptr};
+
+		CommandBuffer *graphics_command_buffer{nullptr};
+
+		VkFence fence{VK_NULL_HANDLE};
+
+		/// Signaled by the copies for the acquisition on the graphics queue
+		VkSemaphore semaphore{VK_NULL_HANDLE};
+
+		/// Bytes used in the batch's slot of the staging ring
+		VkDeviceSize staging_used{0};
+
+		/// Staging buffers of the uploads larger than a slot
+		std::vector<core::Buffer> dedicated_staging_buffers;
+
+		std::vector<ImageCopy> image_copies;
+
+		/// Makes the copies visible to their readers, or releases the resources with a dedicated transfer queue
+		Barriers transfer_barriers;
+
+		/// Acquires the resources on the graphics queue, only with a dedicated transfer queue
+		Barriers graphics_barriers;
+
+		uint64_t bytes{0};
+
+		bool in_flight{false};
+	};
+
+	/**
+	 * @brief Returns the batch recording copies, starting it if needed
+	 */
+	Batch &get_recording_batch();
+
+	/**
+	 * @brief Copies data to staging memory, flushing the recording batch if its slot is full
+	 * @return The staging buffer and the offset of the data in it
+	 */
+	std::pair<const core::Buffer *, VkDeviceSize> stage(const uint8_t *data, VkDeviceSize size);
+
+	/**
+	 * @brief Records the image copies and the barriers of a batch before its submission
+	 */
+	void record_pending(Batch &batch);
+
+	/**
+	 * @brief Adds the barriers making a resource written by the copies available to its readers
+	 * @param buffer_barrier Barrier of a buffer, or nullptr
+	 * @param image_barrier Barrier of an image, or nullptr
+	 */
+	void add_release_barriers(Batch &batch, VkBufferMemoryBarrier *buffer_barrier, VkImageMemoryBarrier *image_barrier, VkPipelineStageFlags dst_stage_mask);
+
+	/**
+	 * @brief Waits for a submitted batch, then releases its staging memory
+	 */
+	void complete(Batch &batch);
+
+	Device &device;
+
+	const Queue &transfer_queue;
+
+	const Queue &graphics_queue;
+
+	bool ownership_transfer{false};
+
+	std::unique_ptr<core::Buffer> staging_buffer;
+
+	VkDeviceSize slot_size{0};
+
+	VkDeviceSize staging_alignment{16};
+
+	std::array<Batch, BATCH_COUNT> batches;
+
+	uint32_t batch_index{0};
+
+	uint32_t in_flight_count{0};
+
+	uint64_t uploaded_bytes{0};
+
+	Timer busy_timer;
+
+	double busy_seconds{0.0};
+};
+}        // namespace vkb
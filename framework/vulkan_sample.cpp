@@ -30,12 +30,19 @@ VKBP_ENABLE_WARNINGS()
 #include "common/strings.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "device_profiles.h"
+#include "frame_capture.h"
 #include "gltf_loader.h"
+#include "rendering/gpu_skinning.h"
 #include "platform/platform.h"
 #include "platform/window.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/script.h"
+#include "scene_graph/scripts/camera_path.h"
 #include "scene_graph/scripts/free_camera.h"
+#include "shared_context.h"
+#include "stats/cpu_profiler.h"
+#include "texture_streamer.h"
 
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 #	include "platform/android/android_platform.h"
@@ -50,11 +57,32 @@ VulkanSample::~VulkanSample()
 		device->wait_idle();
 	}
 
+	// Streamed images may still be decoded on the job system
+	scene_loader.reset();
+	gpu_skinning.reset();
 	scene.reset();
 
+	texture_streamer.reset();
+	frame_capture.reset();
+	job_system.reset();
+
 	stats.reset();
 	gui.reset();
 	render_context.reset();
+
+	// Extension features requested on the GPU would be enabled by the next sample too
+	if (shared_context && device && device->get_gpu().get_extension_feature_chain() == nullptr)
+	{
+		give_shared_context();
+	}
+
+	if (persistent_pipeline_cache)
+	{
+		device->get_resource_cache().set_pipeline_cache(VK_NULL_HANDLE);
+		persistent_pipeline_cache->save();
+		persistent_pipeline_cache.reset();
+	}
+
 	device.reset();
 
 	if (surface != VK_NULL_HANDLE)
@@ -68,6 +96,11 @@ VulkanSample::~VulkanSample()
 void VulkanSample::set_render_pipeline(RenderPipeline &&rp)
 {
 	render_pipeline = std::make_unique<RenderPipeline>(std::move(rp));
+
+	if (shader_watcher)
+	{
+		render_pipeline->set_shader_watcher(shader_watcher.get());
+	}
 }
 
 RenderPipeline &VulkanSample::get_render_pipeline()
@@ -85,21 +118,110 @@ bool VulkanSample::prepare(Platform &platform)
 
 	LOGI("Initializing Vulkan sample");
 
+	// Measures the startup phases, reported once the render context is prepared
+	Timer startup_timer;
+
+	// Workers record into the frame resources matching their thread index
+	job_system = std::make_unique<JobSystem>(JobSystem::get_default_worker_count(), RenderFrame::set_thread_index);
+
 	// Creating the vulkan instance
 	add_instance_extension(platform.get_surface_extension());
-	instance = std::make_unique<Instance>(get_name(), get_instance_extensions(), get_validation_layers(), is_headless());
 
-	// Getting a valid vulkan surface from the platform
-	surface = platform.get_window().create_surface(*instance);
+#ifdef VK_EXT_display_surface_counter
+	// Direct-to-display swapchains can then count the refresh cycles, with VK_EXT_display_control
+	if (std::string{platform.get_surface_extension()} == VK_KHR_DISPLAY_EXTENSION_NAME)
+	{
+		add_instance_extension(VK_EXT_DISPLAY_SURFACE_COUNTER_EXTENSION_NAME, true);
+	}
+#endif
+
+#ifdef VK_EXT_descriptor_buffer
+	// Descriptor buffers are opt-in, every descriptor set layout and pipeline of the device is created for them
+	if (descriptor_buffers)
+	{
+		add_instance_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, true);
+		add_device_extension(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME, true);
+	}
+#endif
+
+	// The GPUs of a group are then found and the device created over all of them
+	if (device_group)
+	{
+		add_instance_extension(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_DEVICE_GROUP_EXTENSION_NAME, true);
+	}
+
+	if (shared_context && shared_context->is_instance_compatible(get_instance_extensions(), get_validation_layers(), is_headless(), api_version))
+	{
+		take_shared_context();
+	}
+	else
+	{
+		if (shared_context)
+		{
+			// The window can only have one surface
+			shared_context->reset();
+		}
+
+		instance = std::make_unique<Instance>(get_name(), get_instance_extensions(), get_validation_layers(), is_headless(), api_version);
+
+		// Getting a valid vulkan surface from the platform
+		surface = platform.get_window().create_surface(*instance);
+	}
+
+	auto instance_time = startup_timer.tick<Timer::Milliseconds>();
 
 	auto &gpu = instance->get_suitable_gpu();
 
+	// The features requested by a previous sample sharing the instance are not carried over
+	gpu.get_mutable_requested_features() = {};
+
+	if (device_profiles)
+	{
+		auto tuned_configuration = device_profiles->get_configuration(gpu.get_properties(), get_name());
+		if (tuned_configuration >= 0 && configuration.select(static_cast<uint32_t>(tuned_configuration)))
+		{
+			LOGI("Using configuration {} of the device profile", tuned_configuration);
+		}
+	}
+
 	// Request to enable ASTC
 	if (gpu.get_features().textureCompressionASTC_LDR)
 	{
 		gpu.get_mutable_requested_features().textureCompressionASTC_LDR = VK_TRUE;
 	}
 
+	// Request to index texture arrays, used by bindless materials
+	if (gpu.get_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		gpu.get_mutable_requested_features().shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+	}
+
+	// Request the queries used by the pipeline statistics stats
+	if (gpu.get_features().pipelineStatisticsQuery)
+	{
+		gpu.get_mutable_requested_features().pipelineStatisticsQuery = VK_TRUE;
+	}
+
+	if (gpu.get_features().occlusionQueryPrecise)
+	{
+		gpu.get_mutable_requested_features().occlusionQueryPrecise = VK_TRUE;
+	}
+
+	// Request the depth bounds test, used to reject pixels outside of deferred light volumes
+	if (gpu.get_features().depthBounds)
+	{
+		gpu.get_mutable_requested_features().depthBounds = VK_TRUE;
+	}
+
+	// Request indirect draws of many commands with their own first instance, used by multi-draw indirect
+	if (gpu.get_features().multiDrawIndirect && gpu.get_features().drawIndirectFirstInstance)
+	{
+		gpu.get_mutable_requested_features().multiDrawIndirect         = VK_TRUE;
+		gpu.get_mutable_requested_features().drawIndirectFirstInstance = VK_TRUE;
+	}
+
 	// Request sample required GPU features
 	request_gpu_features(gpu);
 
@@ -109,10 +231,48 @@ bool VulkanSample::prepare(Platform &platform)
 		add_device_extension(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 	}
 
-	device = std::make_unique<vkb::Device>(gpu, surface, get_device_extensions());
+	if (device && !is_device_compatible())
+	{
+		LOGI("The device of the previous sample lacks requested extensions or features, recreating it");
+
+		device->get_resource_cache().set_pipeline_cache(VK_NULL_HANDLE);
+		persistent_pipeline_cache->save();
+		persistent_pipeline_cache.reset();
+		device.reset();
+	}
+
+	if (!device)
+	{
+		device          = std::make_unique<vkb::Device>(gpu, surface, get_device_extensions());
+		device_features = gpu.get_requested_features();
+	}
+
+	auto device_time = startup_timer.tick<Timer::Milliseconds>();
+
+	if (!persistent_pipeline_cache)
+	{
+		// Reuse the pipelines compiled by previous runs
+		persistent_pipeline_cache = std::make_unique<vkb::PipelineCache>(*device);
+		device->get_resource_cache().set_pipeline_cache(*persistent_pipeline_cache);
+	}
+
+	if (shader_hot_reload)
+	{
+		shader_watcher = std::make_unique<ShaderWatcher>(device->get_resource_cache());
+	}
+
+	// A shared device keeps the setting of the previous sample otherwise
+	device->get_memory_defragmenter().set_enabled(memory_defragmentation);
+
+	// Every submission of the framework goes through core::Queue, which flushes the buffer writes of the frame at once
+	device->set_deferred_flushes(true);
+
+	auto pipeline_cache_time = startup_timer.tick<Timer::Milliseconds>();
 
 	// Preparing render context for rendering
 	render_context = std::make_unique<vkb::RenderContext>(*device, surface, platform.get_window().get_width(), platform.get_window().get_height());
+	render_context->set_display(platform.get_window().get_display());
+	render_context->set_alternate_frame_rendering(device_group);
 	render_context->set_present_mode_priority({VK_PRESENT_MODE_FIFO_KHR,
 	                                           VK_PRESENT_MODE_MAILBOX_KHR});
 
@@ -123,7 +283,15 @@ bool VulkanSample::prepare(Platform &platform)
 
 	prepare_render_context();
 
+	auto render_context_time = startup_timer.tick<Timer::Milliseconds>();
+
+	LOGI("Startup: instance {:.1f} ms, device {:.1f} ms (capabilities {}), pipeline cache {:.1f} ms, render context {:.1f} ms",
+	     instance_time, device_time, gpu.is_capability_cache_loaded() ? "cached" : "queried", pipeline_cache_time, render_context_time);
+
 	stats = std::make_unique<vkb::Stats>(*render_context);
+	stats->request_vulkan_counters(vulkan_counters);
+	stats->set_job_system(job_system.get());
+	stats->set_stream_file(stats_stream);
 
 	return true;
 }
@@ -138,15 +306,15 @@ void VulkanSample::update_scene(float delta_time)
 	if (scene)
 	{
 		//Update scripts
-		if (scene->has_component<sg::Script>())
+		for (auto script : scene->get_component_view<sg::Script>())
 		{
-			auto scripts = scene->get_components<sg::Script>();
-
-			for (auto script : scripts)
-			{
-				script->update(delta_time);
-			}
+			script->update(delta_time);
 		}
+
+		scene->update_animations(delta_time, job_system.get());
+
+		// The world matrices are read by the subpasses of the frame, possibly from several threads
+		scene->update_transforms(job_system.get());
 	}
 }
 
@@ -190,21 +358,82 @@ void VulkanSample::update_gui(float delta_time)
 
 void VulkanSample::update(float delta_time)
 {
+	// Waits before the scene reads the input, as the latency mode asks
+	render_context->pace_frame();
+
+	if (scene_loader && !scene_loader->update_streaming())
+	{
+		scene_loader.reset();
+
+		prepare_gpu_skinning();
+	}
+
+	// Recorded draws still bind the replaced images
+	if (texture_streamer && texture_streamer->update() && scene)
+	{
+		scene->invalidate();
+	}
+
+	// Recorded draws and static content still bind the old buffers
+	bool buffers_moved = device->get_memory_defragmenter().update();
+
+	if (buffers_moved && scene)
+	{
+		scene->invalidate();
+	}
+
+	bool shaders_reloaded = shader_watcher && shader_watcher->update(delta_time) > 0;
+
+	// The vertex inputs resolved by the subpasses are keyed by the destroyed pipeline layouts
+	if (shaders_reloaded && scene)
+	{
+		scene->invalidate();
+	}
+
+	if ((shaders_reloaded || buffers_moved) && render_pipeline)
+	{
+		// The static content of the subpasses binds the destroyed pipelines or buffers
+		for (auto &subpass : render_pipeline->get_subpasses())
+		{
+			subpass->invalidate_static_content();
+		}
+	}
+
 	update_scene(delta_time);
 
 	update_gui(delta_time);
 
 	auto &command_buffer = render_context->begin();
 
+	// The swapchain may have been recreated in another transform when the frame began
+	if (scene)
+	{
+		auto pre_rotation = render_context->get_pre_rotation();
+
+		for (auto camera : scene->get_components<sg::Camera>())
+		{
+			camera->set_pre_rotation(pre_rotation);
+		}
+	}
+
 	// Collect the performance data for the sample graphs
 	update_stats(delta_time);
 
 	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 	stats->begin_sampling(command_buffer);
 
+	// Every pass of the frame draws the deformed vertices
+	if (gpu_skinning)
+	{
+		gpu_skinning->update(command_buffer);
+	}
+
 	draw(command_buffer, render_context->get_active_frame().get_render_target());
 
 	stats->end_sampling(command_buffer);
+
+	get_frame_capture().record(command_buffer);
+
 	command_buffer.end();
 
 	render_context->submit(command_buffer);
@@ -229,6 +458,14 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 		// Skip 1 as it is handled later as a depth-stencil attachment
 		for (size_t i = 2; i < views.size(); ++i)
 		{
+#ifdef VK_KHR_fragment_shading_rate
+			// Shading rate attachments are transitioned by the pass writing the rates
+			if (views.at(i).get_image().get_usage() & VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR)
+			{
+				continue;
+			}
+#endif
+
 			command_buffer.image_memory_barrier(views.at(i), memory_barrier);
 		}
 	}
@@ -245,8 +482,12 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 		command_buffer.image_memory_barrier(views.at(1), memory_barrier);
 	}
 
+	command_buffer.push_gpu_scope("Render pipeline");
+
 	draw_renderpass(command_buffer, render_target);
 
+	command_buffer.pop_gpu_scope();
+
 	{
 		ImageMemoryBarrier memory_barrier{};
 		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -278,7 +519,29 @@ void VulkanSample::draw_renderpass(CommandBuffer &command_buffer, RenderTarget &
 
 	if (gui)
 	{
-		gui->draw(command_buffer);
+		// The last subpass may only contain secondary command buffers
+		if (render_pipeline && render_pipeline->get_subpasses().back()->records_secondary_command_buffers())
+		{
+			const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+			auto &secondary_command_buffer = render_context->get_active_frame().request_command_buffer(queue, command_buffer.get_reset_mode(), VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+			secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &command_buffer);
+
+			secondary_command_buffer.set_viewport(0, {viewport});
+
+			secondary_command_buffer.set_scissor(0, {scissor});
+
+			gui->draw(secondary_command_buffer);
+
+			secondary_command_buffer.end();
+
+			command_buffer.execute_commands(secondary_command_buffer);
+		}
+		else
+		{
+			gui->draw(command_buffer);
+		}
 	}
 
 	command_buffer.end_render_pass();
@@ -301,14 +564,9 @@ void VulkanSample::resize(uint32_t width, uint32_t height)
 		gui->resize(width, height);
 	}
 
-	if (scene->has_component<sg::Script>())
+	for (auto script : scene->get_component_view<sg::Script>())
 	{
-		auto scripts = scene->get_components<sg::Script>();
-
-		for (auto script : scripts)
-		{
-			script->resize(width, height);
-		}
+		script->resize(width, height);
 	}
 
 	if (stats)
@@ -321,6 +579,12 @@ void VulkanSample::input_event(const InputEvent &input_event)
 {
 	Application::input_event(input_event);
 
+	// The input latency of the frames is measured from the first event they see
+	if (render_context)
+	{
+		render_context->record_input();
+	}
+
 	bool gui_captures_event = false;
 
 	if (gui)
@@ -330,14 +594,9 @@ void VulkanSample::input_event(const InputEvent &input_event)
 
 	if (!gui_captures_event)
 	{
-		if (scene->has_component<sg::Script>())
+		for (auto script : scene->get_component_view<sg::Script>())
 		{
-			auto scripts = scene->get_components<sg::Script>();
-
-			for (auto script : scripts)
-			{
-				script->input_event(input_event);
-			}
+			script->input_event(input_event);
 		}
 	}
 
@@ -346,14 +605,27 @@ void VulkanSample::input_event(const InputEvent &input_event)
 		const auto &key_event = static_cast<const KeyInputEvent &>(input_event);
 		if (key_event.get_action() == KeyAction::Down && key_event.get_code() == KeyCode::PrintScreen)
 		{
-			screenshot(*render_context, "screenshot-" + get_name());
+			// Samples recording their own frames are captured synchronously
+			if (frame_capture)
+			{
+				frame_capture->request("screenshot-" + get_name());
+			}
+			else
+			{
+				screenshot(*render_context, "screenshot-" + get_name());
+			}
 		}
 
 		if (key_event.get_code() == KeyCode::F6 && key_event.get_action() == KeyAction::Down)
 		{
-			if (!graphs::generate_all(get_render_context(), *scene.get()))
+			if (!graph_writer)
+			{
+				graph_writer = std::make_unique<graphing::AsyncGraphWriter>();
+			}
+
+			if (!graphs::generate_all(get_render_context(), *scene.get(), *graph_writer))
 			{
-				LOGE("Failed to save Graphs");
+				LOGW("Graphs from a previous request are still being written, ignoring");
 			}
 		}
 	}
@@ -363,10 +635,19 @@ void VulkanSample::finish()
 {
 	Application::finish();
 
+	if (frame_capture)
+	{
+		frame_capture->flush();
+	}
+
 	if (device)
 	{
 		device->wait_idle();
 	}
+
+#if defined(VKB_CPU_PROFILING)
+	CpuProfiler::write_chrome_trace("cpu_trace.json");
+#endif
 }
 
 Device &VulkanSample::get_device()
@@ -400,6 +681,8 @@ void VulkanSample::update_debug_window()
 
 	get_debug_info().insert<field::Static, uint32_t>("texture_count", to_u32(scene->get_components<sg::Texture>().size()));
 
+	get_debug_info().insert<field::Static, uint32_t>("bundles_reused", render_context->get_last_rendered_frame().get_bundle_reuse_count());
+
 	if (auto camera = scene->get_components<vkb::sg::Camera>().at(0))
 	{
 		if (auto camera_node = camera->get_node())
@@ -410,17 +693,70 @@ void VulkanSample::update_debug_window()
 	}
 }
 
-void VulkanSample::load_scene(const std::string &path)
+void VulkanSample::load_scene(const std::string &path, bool streaming, uint32_t lod_levels)
 {
-	GLTFLoader loader{*device};
+	if (scene_loader)
+	{
+		// The files of the previous scene which are still streaming are no longer read
+		scene_loader->cancel_streaming();
+	}
+
+	if (texture_streamer)
+	{
+		// The images of the previous scene are released
+		texture_streamer->clear();
+	}
 
-	scene = loader.read_scene_from_file(path);
+	gpu_skinning.reset();
+
+	if (streaming)
+	{
+		scene_loader = std::make_unique<GLTFLoader>(*device);
+		scene_loader->set_lod_levels(lod_levels);
+		scene_loader->set_job_system(job_system.get());
+		scene_loader->set_texture_streamer(texture_streamer.get());
+
+		scene = scene_loader->stream_scene_from_file(path);
+	}
+	else
+	{
+		scene_loader.reset();
+
+		GLTFLoader loader{*device};
+		loader.set_lod_levels(lod_levels);
+		loader.set_job_system(job_system.get());
+		loader.set_texture_streamer(texture_streamer.get());
+		loader.set_scene_snapshots(scene_snapshots);
+
+		scene = loader.read_scene_from_file(path);
+	}
 
 	if (!scene)
 	{
 		LOGE("Cannot load scene: {}", path.c_str());
 		throw std::runtime_error("Cannot load scene: " + path);
 	}
+
+	// Streamed scenes are deformed once their geometry is loaded
+	if (!streaming)
+	{
+		prepare_gpu_skinning();
+	}
+}
+
+void VulkanSample::prepare_gpu_skinning()
+{
+	if (!scene || !render_context)
+	{
+		return;
+	}
+
+	gpu_skinning = std::make_unique<GpuSkinning>(*render_context);
+
+	if (gpu_skinning->prepare(*scene) == 0)
+	{
+		gpu_skinning.reset();
+	}
 }
 
 VkSurfaceKHR VulkanSample::get_surface()
@@ -459,6 +795,11 @@ void VulkanSample::add_instance_extension(const char *extension, bool optional)
 	instance_extensions[extension] = optional;
 }
 
+void VulkanSample::set_api_version(uint32_t version)
+{
+	api_version = version;
+}
+
 void VulkanSample::request_gpu_features(PhysicalDevice &gpu)
 {
 	// To be overriden by sample
@@ -470,4 +811,221 @@ sg::Scene &VulkanSample::get_scene()
 	return *scene;
 }
 
+JobSystem &VulkanSample::get_job_system()
+{
+	assert(job_system && "Job system not created");
+	return *job_system;
+}
+
+void VulkanSample::enable_texture_streaming(VkDeviceSize budget)
+{
+	assert(render_context && "Render context not created");
+
+	texture_streamer = std::make_unique<TextureStreamer>(*device, budget);
+}
+
+TextureStreamer *VulkanSample::get_texture_streamer()
+{
+	return texture_streamer.get();
+}
+
+FrameCapture &VulkanSample::get_frame_capture()
+{
+	if (!frame_capture)
+	{
+		assert(render_context && "Render context not created");
+		frame_capture = std::make_unique<FrameCapture>(*render_context, job_system.get());
+	}
+
+	return *frame_capture;
+}
+
+void VulkanSample::set_vulkan_counters(const std::vector<std::string> &counter_names)
+{
+	vulkan_counters = counter_names;
+}
+
+void VulkanSample::set_stats_stream(const std::string &filename)
+{
+	stats_stream = filename;
+}
+
+void VulkanSample::set_shader_hot_reload(bool enable)
+{
+	shader_hot_reload = enable;
+}
+
+void VulkanSample::set_memory_defragmentation(bool enable)
+{
+	memory_defragmentation = enable;
+}
+
+void VulkanSample::set_descriptor_buffers(bool enable)
+{
+	descriptor_buffers = enable;
+}
+
+void VulkanSample::set_device_group(bool enable)
+{
+	device_group = enable;
+}
+
+void VulkanSample::set_scene_snapshots(bool enable)
+{
+	scene_snapshots = enable;
+}
+
+void VulkanSample::set_shared_context(SharedContext *context)
+{
+	assert(!instance && "The shared context must be set before the sample is prepared");
+	shared_context = context;
+}
+
+void VulkanSample::set_device_profiles(const DeviceProfiles *profiles)
+{
+	assert(!instance && "The device profiles must be set before the sample is prepared");
+	device_profiles = profiles;
+}
+
+void VulkanSample::take_shared_context()
+{
+	LOGI("Reusing the Vulkan instance of the previous sample");
+
+	instance                  = std::move(shared_context->instance);
+	surface                   = shared_context->surface;
+	device                    = std::move(shared_context->device);
+	device_features           = shared_context->device_features;
+	persistent_pipeline_cache = std::move(shared_context->pipeline_cache);
+
+	shared_context->surface = VK_NULL_HANDLE;
+}
+
+void VulkanSample::give_shared_context()
+{
+	// Keeps the shader modules and pipelines, which only depend on the device
+	auto &resource_cache = device->get_resource_cache();
+	resource_cache.wait_for_async_pipelines();
+	resource_cache.clear_descriptor_sets();
+	resource_cache.clear_framebuffers();
+
+	shared_context->instance          = std::move(instance);
+	shared_context->surface           = surface;
+	shared_context->headless          = is_headless();
+	shared_context->device            = std::move(device);
+	shared_context->device_features   = device_features;
+	shared_context->pipeline_cache    = std::move(persistent_pipeline_cache);
+	shared_context->validation_layers = {};
+
+	for (auto layer : get_validation_layers())
+	{
+		shared_context->validation_layers.push_back(layer);
+	}
+
+	surface = VK_NULL_HANDLE;
+}
+
+bool VulkanSample::is_device_compatible()
+{
+	// The structures would be missing from the feature chain the device was created with
+	if (device->get_gpu().get_extension_feature_chain() != nullptr)
+	{
+		return false;
+	}
+
+	auto requested_features = device->get_gpu().get_requested_features();
+
+	auto requested = reinterpret_cast<const VkBool32 *>(&requested_features);
+	auto enabled   = reinterpret_cast<const VkBool32 *>(&device_features);
+
+	for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); ++i)
+	{
+		if (requested[i] && !enabled[i])
+		{
+			return false;
+		}
+	}
+
+	for (auto &extension : get_device_extensions())
+	{
+		if (!device->is_enabled(extension.first))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+double VulkanSample::get_gpu_frame_time() const
+{
+	if (!stats)
+	{
+		return -1.0;
+	}
+
+	const auto &gpu_profiler = stats->get_gpu_profiler();
+	if (gpu_profiler.get_timings().empty())
+	{
+		return -1.0;
+	}
+
+	return gpu_profiler.get_frame_time();
+}
+
+bool VulkanSample::play_camera_path(const std::string &filename)
+{
+	if (!scene)
+	{
+		LOGW("Sample has no scene, the camera path {} is not played", filename);
+		return false;
+	}
+
+	sg::Node *camera_node = nullptr;
+
+	for (auto script : scene->get_component_view<sg::Script>())
+	{
+		if (dynamic_cast<sg::FreeCamera *>(script))
+		{
+			camera_node = &script->get_node();
+			break;
+		}
+	}
+
+	if (!camera_node)
+	{
+		auto cameras = scene->get_components<sg::Camera>();
+		if (cameras.empty())
+		{
+			LOGW("Scene has no camera, the camera path {} is not played", filename);
+			return false;
+		}
+
+		camera_node = cameras.front()->get_node();
+	}
+
+	if (!camera_node)
+	{
+		LOGW("Camera is not attached to a node, the camera path {} is not played", filename);
+		return false;
+	}
+
+	std::unique_ptr<sg::CameraPath> camera_path;
+	try
+	{
+		camera_path = sg::CameraPath::load(*camera_node, filename);
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Failed to load camera path {}: {}", filename, e.what());
+		return false;
+	}
+
+	// Scripts update in the order they were added, so the path overrides the free camera
+	scene->add_component(std::move(camera_path), *camera_node);
+
+	LOGI("Playing camera path {}", filename);
+
+	return true;
+}
+
 }        // namespace vkb
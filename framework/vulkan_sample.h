@@ -21,17 +21,27 @@
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "core/instance.h"
+#include "core/pipeline_cache.h"
 #include "gui.h"
+#include "job_system.h"
 #include "platform/application.h"
 #include "rendering/render_context.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
 #include "scene_graph/scripts/node_animation.h"
+#include "shader_watcher.h"
 #include "stats/stats.h"
 
 namespace vkb
 {
+class DeviceProfiles;
+class FrameCapture;
+class GLTFLoader;
+class GpuSkinning;
+struct SharedContext;
+class TextureStreamer;
+
 /**
  * @mainpage Overview of the framework
  *
@@ -127,8 +137,17 @@ class VulkanSample : public Application
 	 * @brief Loads the scene
 	 *
 	 * @param path The path of the glTF file
+	 * @param streaming Whether the images and geometry stream in while the sample runs,
+	 *        see GLTFLoader::stream_scene_from_file()
+	 * @param lod_levels Number of levels of detail generated for the meshes, see GLTFLoader::set_lod_levels()
+	 */
+	void load_scene(const std::string &path, bool streaming = false, uint32_t lod_levels = 0);
+
+	/**
+	 * @brief Prepares the deformation of the meshes of the scene on the GPU, once its geometry is loaded
+	 *        The animations of the scene play in update_scene().
 	 */
-	void load_scene(const std::string &path);
+	void prepare_gpu_skinning();
 
 	VkSurfaceKHR get_surface();
 
@@ -144,6 +163,96 @@ class VulkanSample : public Application
 
 	sg::Scene &get_scene();
 
+	JobSystem &get_job_system();
+
+	/**
+	 * @brief Streams the mip levels of the images of the scenes loaded next under a memory budget,
+	 *        requested by the geometry subpasses given get_texture_streamer()
+	 * @param budget Memory budget of the streamed levels in bytes
+	 */
+	void enable_texture_streaming(VkDeviceSize budget);
+
+	/**
+	 * @return The texture streamer, nullptr unless texture streaming is enabled
+	 */
+	TextureStreamer *get_texture_streamer();
+
+	/**
+	 * @return The capture of the frames recorded by update(), created on first use
+	 */
+	FrameCapture &get_frame_capture();
+
+	/**
+	 * @brief Selects Vulkan performance counters by name, collected once the sample requests its stats
+	 *        Must be called before prepare
+	 * @param counter_names Regular expressions matching the names of the counters
+	 */
+	void set_vulkan_counters(const std::vector<std::string> &counter_names);
+
+	/**
+	 * @brief Streams the samples of the stats the sample requests to a file in the logs directory, see Stats::set_stream_file()
+	 *        Must be called before prepare
+	 */
+	void set_stats_stream(const std::string &filename);
+
+	/**
+	 * @brief Reloads the shaders of the render pipeline when their files change on disk, and rebuilds
+	 *        the pipelines using them. Must be called before prepare
+	 */
+	void set_shader_hot_reload(bool enable);
+
+	/**
+	 * @brief Compacts the memory of the buffers of the device between frames when it is fragmented,
+	 *        see MemoryDefragmenter. Must be called before prepare
+	 */
+	void set_memory_defragmentation(bool enable);
+
+	/**
+	 * @brief Writes the descriptors into descriptor buffers when the device supports them,
+	 *        see Device::uses_descriptor_buffers(). Must be called before prepare
+	 */
+	void set_descriptor_buffers(bool enable);
+
+	/**
+	 * @brief Creates the device over the GPUs of a device group and renders the frames on them in turn,
+	 *        see RenderContext::set_alternate_frame_rendering(). Must be called before prepare
+	 */
+	void set_device_group(bool enable);
+
+	/**
+	 * @brief Loads the scenes from snapshots in the temporary directory, written on their first load,
+	 *        see GLTFLoader::set_scene_snapshots(). Must be called before prepare
+	 */
+	void set_scene_snapshots(bool enable);
+
+	/**
+	 * @return The GPU time of the scopes of the last frame the GPU profiler resolved, in milliseconds,
+	 *         negative if no frame has been timed
+	 */
+	double get_gpu_frame_time() const;
+
+	/**
+	 * @brief Replaces the input of the camera of the scene with a keyframed track, see sg::CameraPath
+	 *        The camera is the node of the first FreeCamera, or else of the first camera of the scene
+	 * @param filename The path to the track, relative to the assets directory
+	 * @return Whether the track is played
+	 */
+	bool play_camera_path(const std::string &filename);
+
+	/**
+	 * @brief Takes the instance and device of the context when prepared, if they meet the requirements
+	 *        of the sample, and gives its own back when destroyed. Must be called before prepare
+	 * @param context The context handed over between the samples, which outlives them
+	 */
+	void set_shared_context(SharedContext *context);
+
+	/**
+	 * @brief Selects the configuration tuned for the GPU when prepared, if the profiles have one
+	 *        for the sample. Must be called before prepare
+	 * @param profiles The profiles of the devices, which outlive the sample
+	 */
+	void set_device_profiles(const DeviceProfiles *profiles);
+
   protected:
 	/**
 	 * @brief The Vulkan instance
@@ -155,6 +264,17 @@ class VulkanSample : public Application
 	 */
 	std::unique_ptr<Device> device{nullptr};
 
+	/**
+	 * @brief Pipeline cache used by the resource cache, persisted across runs
+	 */
+	std::unique_ptr<PipelineCache> persistent_pipeline_cache{nullptr};
+
+	/**
+	 * @brief Watches the shaders of the render pipeline if hot reload is enabled, samples may watch their own sources
+	 *        Declared before the render pipeline, which unwatches its shaders when destroyed
+	 */
+	std::unique_ptr<ShaderWatcher> shader_watcher{nullptr};
+
 	/**
 	 * @brief Context used for rendering, it is responsible for managing the frames and their underlying images
 	 */
@@ -170,10 +290,60 @@ class VulkanSample : public Application
 	 */
 	std::unique_ptr<sg::Scene> scene{nullptr};
 
+	/**
+	 * @brief Loader of the scene while its assets stream, released once they are loaded
+	 */
+	std::unique_ptr<GLTFLoader> scene_loader{nullptr};
+
 	std::unique_ptr<Gui> gui{nullptr};
 
 	std::unique_ptr<Stats> stats{nullptr};
 
+	/**
+	 * @brief Runs the parallel work of the sample, its workers map onto the RenderFrame thread indices
+	 */
+	std::unique_ptr<JobSystem> job_system{nullptr};
+
+	/**
+	 * @brief Streams the mip levels of the images of the scene, see TextureStreamer
+	 */
+	std::unique_ptr<TextureStreamer> texture_streamer{nullptr};
+
+	/**
+	 * @brief Deforms the skinned meshes and the meshes with morph targets of the scene, see GpuSkinning
+	 */
+	std::unique_ptr<GpuSkinning> gpu_skinning{nullptr};
+
+	/**
+	 * @brief Captures the frames recorded by update() to files, see FrameCapture
+	 */
+	std::unique_ptr<FrameCapture> frame_capture{nullptr};
+
+	/**
+	 * @brief Writes the graphs requested with F6 on a worker thread
+	 */
+	std::unique_ptr<graphing::AsyncGraphWriter> graph_writer{nullptr};
+
+	/**
+	 * @brief Names of the Vulkan performance counters given to the stats
+	 */
+	std::vector<std::string> vulkan_counters;
+
+	/**
+	 * @brief Name of the file the stats are streamed to, empty to not stream them
+	 */
+	std::string stats_stream;
+
+	bool shader_hot_reload{false};
+
+	bool memory_defragmentation{false};
+
+	bool descriptor_buffers{false};
+
+	bool device_group{false};
+
+	bool scene_snapshots{false};
+
 	/**
 	 * @brief Update scene
 	 * @param delta_time
@@ -247,6 +417,12 @@ class VulkanSample : public Application
 	 */
 	void add_instance_extension(const char *extension, bool optional = false);
 
+	/**
+	 * @brief Set the Vulkan version the sample uses, 1.0 by default (must be set in the derived constructor)
+	 * @param version The version, made with VK_MAKE_VERSION
+	 */
+	void set_api_version(uint32_t version);
+
 	/**
 	 * @brief Request features from the gpu based on what is supported
 	 */
@@ -292,5 +468,26 @@ class VulkanSample : public Application
 
 	/** @brief Set of instance extensions to be enabled for this example and whether they are optional (must be set in the derived constructor) */
 	std::unordered_map<const char *, bool> instance_extensions;
+
+	/** @brief The Vulkan version the instance is created with */
+	uint32_t api_version{VK_API_VERSION_1_0};
+
+	/** @brief Context the instance and device are taken from and given back to, if any */
+	SharedContext *shared_context{nullptr};
+
+	/** @brief The configurations tuned for each device, if they are applied */
+	const DeviceProfiles *device_profiles{nullptr};
+
+	/** @brief The features the device was created with */
+	VkPhysicalDeviceFeatures device_features{};
+
+	void take_shared_context();
+
+	void give_shared_context();
+
+	/**
+	 * @return True if the device was created with the extensions and features requested by the sample
+	 */
+	bool is_device_compatible();
 };
 }        // namespace vkb
@@ -21,11 +21,16 @@
 
 #include "compute_nbody.h"
 
+#include "glsl_compiler.h"
+
 ComputeNBody::ComputeNBody()
 {
 	title       = "Compute shader N-body system";
 	camera.type = vkb::CameraType::LookAt;
 
+	// Subgroup operations are core in Vulkan 1.1
+	set_api_version(VK_API_VERSION_1_1);
+
 	// Note: Using Revsered depth-buffer for increased precision, so Znear and Zfar are flipped
 	camera.set_perspective(60.0f, (float) width / (float) height, 512.0f, 0.1f);
 	camera.set_rotation(glm::vec3(-26.0f, 75.0f, 0.0f));
@@ -47,12 +52,28 @@ ComputeNBody::~ComputeNBody()
 		// Compute
 		compute.storage_buffer.reset();
 		compute.uniform_buffer.reset();
+		compute.cell_counts.reset();
+		compute.cell_offsets.reset();
+		compute.cell_masses.reset();
+		compute.particle_cells.reset();
+		compute.sorted_indices.reset();
 		vkDestroyPipelineLayout(get_device().get_handle(), compute.pipeline_layout, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), compute.descriptor_set_layout, nullptr);
 		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_calculate, nullptr);
 		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_integrate, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_bin, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_scan, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_scatter, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_cell_mass, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_calculate_cells, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_calculate_subgroup, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_scan_subgroup, nullptr);
 		vkDestroySemaphore(get_device().get_handle(), compute.semaphore, nullptr);
 		vkDestroyCommandPool(get_device().get_handle(), compute.command_pool, nullptr);
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(get_device().get_handle(), compute.query_pool, nullptr);
+		}
 
 		vkDestroySampler(get_device().get_handle(), textures.particle.sampler, nullptr);
 		vkDestroySampler(get_device().get_handle(), textures.gradient.sampler, nullptr);
@@ -179,6 +200,12 @@ void ComputeNBody::build_compute_command_buffer()
 
 	VK_CHECK(vkBeginCommandBuffer(compute.command_buffer, &command_buffer_begin_info));
 
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(compute.command_buffer, compute.query_pool, 0, 2);
+		vkCmdWriteTimestamp(compute.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, compute.query_pool, 0);
+	}
+
 	// Acquire
 	if (graphics.queue_family_index != compute.queue_family_index)
 	{
@@ -204,11 +231,51 @@ void ComputeNBody::build_compute_command_buffer()
 		    0, nullptr);
 	}
 
+	// Round up, the shaders skip the invocations past the last particle
+	uint32_t particle_groups = (num_particles + compute.work_group_size - 1) / compute.work_group_size;
+
+	// Makes the writes of one pass visible to the next one
+	auto compute_barrier = [&](VkPipelineStageFlags src_stage, VkAccessFlags src_access) {
+		VkMemoryBarrier barrier = vkb::initializers::memory_barrier();
+		barrier.srcAccessMask   = src_access;
+		barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(compute.command_buffer, src_stage, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_FLAGS_NONE, 1, &barrier, 0, nullptr, 0, nullptr);
+	};
+
 	// First pass: Calculate particle movement
 	// -------------------------------------------------------------------------------------------------------
-	vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_calculate);
 	vkCmdBindDescriptorSets(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_layout, 0, 1, &compute.descriptor_set, 0, 0);
-	vkCmdDispatch(compute.command_buffer, num_particles / 256, 1, 1);
+	bool subgroups = subgroup_operations && compute.pipeline_calculate_subgroup != VK_NULL_HANDLE;
+	if (cell_approximation)
+	{
+		// Sort the particles into the cell grid, reduce every cell to a single body and use those for the distant cells
+		vkCmdFillBuffer(compute.command_buffer, compute.cell_counts->get_handle(), 0, VK_WHOLE_SIZE, 0);
+		compute_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_bin);
+		vkCmdDispatch(compute.command_buffer, particle_groups, 1, 1);
+		compute_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, subgroups ? compute.pipeline_scan_subgroup : compute.pipeline_scan);
+		vkCmdDispatch(compute.command_buffer, 1, 1, 1);
+		compute_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_scatter);
+		vkCmdDispatch(compute.command_buffer, particle_groups, 1, 1);
+		compute_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_cell_mass);
+		vkCmdDispatch(compute.command_buffer, (CELL_COUNT + compute.work_group_size - 1) / compute.work_group_size, 1, 1);
+		compute_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_calculate_cells);
+		vkCmdDispatch(compute.command_buffer, particle_groups, 1, 1);
+	}
+	else
+	{
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, subgroups ? compute.pipeline_calculate_subgroup : compute.pipeline_calculate);
+		vkCmdDispatch(compute.command_buffer, particle_groups, 1, 1);
+	}
 
 	// Add memory barrier to ensure that the computer shader has finished writing to the buffer
 	VkBufferMemoryBarrier memory_barrier = vkb::initializers::buffer_memory_barrier();
@@ -231,7 +298,12 @@ void ComputeNBody::build_compute_command_buffer()
 	// Second pass: Integrate particles
 	// -------------------------------------------------------------------------------------------------------
 	vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_integrate);
-	vkCmdDispatch(compute.command_buffer, num_particles / 256, 1, 1);
+	vkCmdDispatch(compute.command_buffer, particle_groups, 1, 1);
+
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(compute.command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, compute.query_pool, 1);
+	}
 
 	// Release
 	if (graphics.queue_family_index != compute.queue_family_index)
@@ -280,7 +352,8 @@ void ComputeNBody::prepare_storage_buffers()
 	};
 #endif
 
-	num_particles = static_cast<uint32_t>(attractors.size()) * PARTICLES_PER_ATTRACTOR;
+	uint32_t attractor_particles = static_cast<uint32_t>(particles_per_attractor) * 1024;
+	num_particles                = static_cast<uint32_t>(attractors.size()) * attractor_particles;
 
 	// Initial particle positions
 	std::vector<Particle> particle_buffer(num_particles);
@@ -290,9 +363,9 @@ void ComputeNBody::prepare_storage_buffers()
 
 	for (uint32_t i = 0; i < static_cast<uint32_t>(attractors.size()); i++)
 	{
-		for (uint32_t j = 0; j < PARTICLES_PER_ATTRACTOR; j++)
+		for (uint32_t j = 0; j < attractor_particles; j++)
 		{
-			Particle &particle = particle_buffer[i * PARTICLES_PER_ATTRACTOR + j];
+			Particle &particle = particle_buffer[i * attractor_particles + j];
 
 			// First particle in group as heavy center of gravity
 			if (j == 0)
@@ -366,6 +439,196 @@ void ComputeNBody::prepare_storage_buffers()
 	}
 
 	device->flush_command_buffer(copy_command, queue, true);
+
+	// Cell grid of the approximated force calculation, only ever accessed by the compute queue
+	compute.cell_counts    = std::make_unique<vkb::core::Buffer>(get_device(), CELL_COUNT * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	compute.cell_offsets   = std::make_unique<vkb::core::Buffer>(get_device(), CELL_COUNT * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	compute.cell_masses    = std::make_unique<vkb::core::Buffer>(get_device(), CELL_COUNT * sizeof(glm::vec4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	compute.particle_cells = std::make_unique<vkb::core::Buffer>(get_device(), num_particles * sizeof(glm::uvec2), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	compute.sorted_indices = std::make_unique<vkb::core::Buffer>(get_device(), num_particles * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+}
+
+// If necessary, acquire and immediately release the storage buffer, so that the initial acquire
+// from the graphics command buffers are matched up properly.
+void ComputeNBody::initialize_storage_buffer_ownership()
+{
+	if (graphics.queue_family_index == compute.queue_family_index)
+	{
+		return;
+	}
+
+	VkCommandBuffer transfer_command;
+
+	// Create a transient command buffer for setting up the initial buffer transfer state
+	VkCommandBufferAllocateInfo command_buffer_allocate_info =
+	    vkb::initializers::command_buffer_allocate_info(
+	        compute.command_pool,
+	        VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+	        1);
+
+	VK_CHECK(vkAllocateCommandBuffers(get_device().get_handle(), &command_buffer_allocate_info, &transfer_command));
+
+	VkCommandBufferBeginInfo command_buffer_info{};
+	command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	VK_CHECK(vkBeginCommandBuffer(transfer_command, &command_buffer_info));
+
+	VkBufferMemoryBarrier acquire_buffer_barrier =
+	    {
+	        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+	        nullptr,
+	        0,
+	        VK_ACCESS_SHADER_WRITE_BIT,
+	        graphics.queue_family_index,
+	        compute.queue_family_index,
+	        compute.storage_buffer->get_handle(),
+	        0,
+	        compute.storage_buffer->get_size()};
+	vkCmdPipelineBarrier(
+	    transfer_command,
+	    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	    0,
+	    0, nullptr,
+	    1, &acquire_buffer_barrier,
+	    0, nullptr);
+
+	VkBufferMemoryBarrier release_buffer_barrier =
+	    {
+	        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+	        nullptr,
+	        VK_ACCESS_SHADER_WRITE_BIT,
+	        0,
+	        compute.queue_family_index,
+	        graphics.queue_family_index,
+	        compute.storage_buffer->get_handle(),
+	        0,
+	        compute.storage_buffer->get_size()};
+	vkCmdPipelineBarrier(
+	    transfer_command,
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+	    0,
+	    0, nullptr,
+	    1, &release_buffer_barrier,
+	    0, nullptr);
+
+	// Copied from Device::flush_command_buffer, which we can't use because it would be
+	// working with the wrong command pool
+	VK_CHECK(vkEndCommandBuffer(transfer_command));
+
+	// Submit compute commands
+	VkSubmitInfo submit_info{};
+	submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers    = &transfer_command;
+
+	// Create fence to ensure that the command buffer has finished executing
+	VkFenceCreateInfo fence_info{};
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.flags = VK_FLAGS_NONE;
+
+	VkFence fence;
+	VK_CHECK(vkCreateFence(device->get_handle(), &fence_info, nullptr, &fence));
+	// Submit to the *compute* queue
+	VkResult result = vkQueueSubmit(compute.queue, 1, &submit_info, fence);
+	// Wait for the fence to signal that command buffer has finished executing
+	VK_CHECK(vkWaitForFences(device->get_handle(), 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+	vkDestroyFence(device->get_handle(), fence, nullptr);
+
+	vkFreeCommandBuffers(device->get_handle(), compute.command_pool, 1, &transfer_command);
+}
+
+// Points the compute descriptor set at the particle and cell buffers, which are recreated when the particle count changes
+void ComputeNBody::update_compute_descriptor_set()
+{
+	VkDescriptorBufferInfo            storage_buffer_descriptor = create_descriptor(*compute.storage_buffer);
+	VkDescriptorBufferInfo            uniform_buffer_descriptor = create_descriptor(*compute.uniform_buffer);
+	VkDescriptorBufferInfo            cell_counts_descriptor    = create_descriptor(*compute.cell_counts);
+	VkDescriptorBufferInfo            cell_offsets_descriptor   = create_descriptor(*compute.cell_offsets);
+	VkDescriptorBufferInfo            cell_masses_descriptor    = create_descriptor(*compute.cell_masses);
+	VkDescriptorBufferInfo            particle_cells_descriptor = create_descriptor(*compute.particle_cells);
+	VkDescriptorBufferInfo            sorted_indices_descriptor = create_descriptor(*compute.sorted_indices);
+	std::vector<VkWriteDescriptorSet> compute_write_descriptor_sets =
+	    {
+	        // Binding 0 : Particle position storage buffer
+	        vkb::initializers::write_descriptor_set(
+	            compute.descriptor_set,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            0,
+	            &storage_buffer_descriptor),
+	        // Binding 1 : Uniform buffer
+	        vkb::initializers::write_descriptor_set(
+	            compute.descriptor_set,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            1,
+	            &uniform_buffer_descriptor),
+	        // Binding 2 to 6 : Cell grid
+	        vkb::initializers::write_descriptor_set(compute.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &cell_counts_descriptor),
+	        vkb::initializers::write_descriptor_set(compute.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, &cell_offsets_descriptor),
+	        vkb::initializers::write_descriptor_set(compute.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4, &cell_masses_descriptor),
+	        vkb::initializers::write_descriptor_set(compute.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5, &particle_cells_descriptor),
+	        vkb::initializers::write_descriptor_set(compute.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6, &sorted_indices_descriptor)};
+
+	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(compute_write_descriptor_sets.size()), compute_write_descriptor_sets.data(), 0, NULL);
+}
+
+// Recreates the particles after the particle count setting changed
+void ComputeNBody::update_particle_count()
+{
+	get_device().wait_idle();
+
+	prepare_storage_buffers();
+	compute.uniform_buffer->convert_and_update(compute.ubo);
+	update_compute_descriptor_set();
+	initialize_storage_buffer_ownership();
+	build_compute_command_buffer();
+	build_command_buffers();
+}
+
+// Largest power of two work group the device supports, the shared tiles of the force passes hold one vec4 per invocation
+uint32_t ComputeNBody::select_work_group_size()
+{
+	const VkPhysicalDeviceLimits &limits = get_device().get_gpu().get_properties().limits;
+
+	uint32_t max_size = std::min({static_cast<uint32_t>(MAX_WORK_GROUP_SIZE),
+	                              limits.maxComputeWorkGroupSize[0],
+	                              limits.maxComputeWorkGroupInvocations,
+	                              static_cast<uint32_t>(limits.maxComputeSharedMemorySize / sizeof(glm::vec4))});
+
+	uint32_t size = 1;
+	while (size * 2 <= max_size)
+	{
+		size *= 2;
+	}
+	return size;
+}
+
+// The subgroup variants need full subgroups of at least 16 invocations, with shuffles and arithmetic in compute shaders
+bool ComputeNBody::is_subgroup_supported()
+{
+	const auto &gpu        = get_device().get_gpu();
+	uint32_t    size       = gpu.get_subgroup_properties().subgroupSize;
+	auto        operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_SHUFFLE_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+
+	return gpu.is_subgroup_supported(VK_SHADER_STAGE_COMPUTE_BIT, operations) &&
+	       size >= 16 && size <= compute.work_group_size;
+}
+
+// Retrieves the GPU time of the compute work submitted in the previous frame, the frame waits for the device to be idle
+void ComputeNBody::get_compute_timing()
+{
+	if (compute.query_pool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	std::array<uint64_t, 2> timestamps{};
+	if (vkGetQueryPoolResults(get_device().get_handle(), compute.query_pool, 0, 2,
+	                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+	{
+		float period       = get_device().get_gpu().get_properties().limits.timestampPeriod;
+		compute.elapsed_ms = static_cast<float>(timestamps[1] - timestamps[0]) * period / 1000000.0f;
+	}
 }
 
 void ComputeNBody::setup_descriptor_pool()
@@ -373,7 +636,7 @@ void ComputeNBody::setup_descriptor_pool()
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)};
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
@@ -562,6 +825,12 @@ void ComputeNBody::prepare_compute()
 	        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	        VK_SHADER_STAGE_COMPUTE_BIT,
 	        1),
+	    // Binding 2 to 6 : Cell grid of the approximated force calculation
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 3),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 4),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 5),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 6),
 	};
 
 	VkDescriptorSetLayoutCreateInfo descriptor_layout =
@@ -586,24 +855,7 @@ void ComputeNBody::prepare_compute()
 
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &compute.descriptor_set));
 
-	VkDescriptorBufferInfo            storage_buffer_descriptor = create_descriptor(*compute.storage_buffer);
-	VkDescriptorBufferInfo            uniform_buffer_descriptor = create_descriptor(*compute.uniform_buffer);
-	std::vector<VkWriteDescriptorSet> compute_write_descriptor_sets =
-	    {
-	        // Binding 0 : Particle position storage buffer
-	        vkb::initializers::write_descriptor_set(
-	            compute.descriptor_set,
-	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-	            0,
-	            &storage_buffer_descriptor),
-	        // Binding 1 : Uniform buffer
-	        vkb::initializers::write_descriptor_set(
-	            compute.descriptor_set,
-	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-	            1,
-	            &uniform_buffer_descriptor)};
-
-	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(compute_write_descriptor_sets.size()), compute_write_descriptor_sets.data(), 0, NULL);
+	update_compute_descriptor_set();
 
 	// Create pipelines
 	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(compute.pipeline_layout, 0);
@@ -626,7 +878,9 @@ void ComputeNBody::prepare_compute()
 	specialization_map_entries.push_back(vkb::initializers::specialization_map_entry(2, offsetof(SpecializationData, power), sizeof(float)));
 	specialization_map_entries.push_back(vkb::initializers::specialization_map_entry(3, offsetof(SpecializationData, soften), sizeof(float)));
 
-	specialization_data.shaderd_data_size = std::min((uint32_t) 1024, (uint32_t)(get_device().get_gpu().get_properties().limits.maxComputeSharedMemorySize / sizeof(glm::vec4)));
+	// The work group size doubles as the shared tile size
+	compute.work_group_size               = select_work_group_size();
+	specialization_data.shaderd_data_size = compute.work_group_size;
 
 	specialization_data.gravity = 0.002f;
 	specialization_data.power   = 0.75f;
@@ -638,9 +892,42 @@ void ComputeNBody::prepare_compute()
 
 	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &compute.pipeline_calculate));
 
+	// All other passes share the work group size, the scan pass uses a fixed one
+	auto create_pipeline = [&](const std::string &file, VkPipeline *pipeline) {
+		compute_pipeline_create_info.stage                     = load_shader(file, VK_SHADER_STAGE_COMPUTE_BIT);
+		compute_pipeline_create_info.stage.pSpecializationInfo = &specialization_info;
+		VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, pipeline));
+	};
+
 	// 2nd pass
-	compute_pipeline_create_info.stage = load_shader("compute_nbody/particle_integrate.comp", VK_SHADER_STAGE_COMPUTE_BIT);
-	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &compute.pipeline_integrate));
+	create_pipeline("compute_nbody/particle_integrate.comp", &compute.pipeline_integrate);
+
+	// Cell approximation passes
+	create_pipeline("compute_nbody/particle_bin.comp", &compute.pipeline_bin);
+	create_pipeline("compute_nbody/particle_scan.comp", &compute.pipeline_scan);
+	create_pipeline("compute_nbody/particle_scatter.comp", &compute.pipeline_scatter);
+	create_pipeline("compute_nbody/particle_cell_mass.comp", &compute.pipeline_cell_mass);
+	create_pipeline("compute_nbody/particle_calculate_cells.comp", &compute.pipeline_calculate_cells);
+
+	// Subgroup variants, which glslang only compiles for SPIR-V 1.3
+	if (is_subgroup_supported())
+	{
+		vkb::GLSLCompiler::set_target_environment(glslang::EShTargetSpv, glslang::EShTargetSpv_1_3);
+		create_pipeline("compute_nbody/particle_calculate_subgroup.comp", &compute.pipeline_calculate_subgroup);
+		create_pipeline("compute_nbody/particle_scan_subgroup.comp", &compute.pipeline_scan_subgroup);
+		vkb::GLSLCompiler::reset_target_environment();
+	}
+
+	// Timestamps around the compute work, if the compute queue supports them
+	const auto &queue_families = get_device().get_gpu().get_queue_family_properties();
+	if (queue_families[compute.queue_family_index].timestampValidBits != 0)
+	{
+		VkQueryPoolCreateInfo query_pool_info = {};
+		query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		query_pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount            = 2;
+		VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, nullptr, &compute.query_pool));
+	}
 
 	// Separate command pool as queue family for compute may be different than graphics
 	VkCommandPoolCreateInfo command_pool_create_info = {};
@@ -672,90 +959,7 @@ void ComputeNBody::prepare_compute()
 	// Build a single command buffer containing the compute dispatch commands
 	build_compute_command_buffer();
 
-	// If necessary, acquire and immediately release the storage buffer, so that the initial acquire
-	// from the graphics command buffers are matched up properly.
-	if (graphics.queue_family_index != compute.queue_family_index)
-	{
-		VkCommandBuffer transfer_command;
-
-		// Create a transient command buffer for setting up the initial buffer transfer state
-		VkCommandBufferAllocateInfo command_buffer_allocate_info =
-		    vkb::initializers::command_buffer_allocate_info(
-		        compute.command_pool,
-		        VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-		        1);
-
-		VK_CHECK(vkAllocateCommandBuffers(get_device().get_handle(), &command_buffer_allocate_info, &transfer_command));
-
-		VkCommandBufferBeginInfo command_buffer_info{};
-		command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		VK_CHECK(vkBeginCommandBuffer(transfer_command, &command_buffer_info));
-
-		VkBufferMemoryBarrier acquire_buffer_barrier =
-		    {
-		        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-		        nullptr,
-		        0,
-		        VK_ACCESS_SHADER_WRITE_BIT,
-		        graphics.queue_family_index,
-		        compute.queue_family_index,
-		        compute.storage_buffer->get_handle(),
-		        0,
-		        compute.storage_buffer->get_size()};
-		vkCmdPipelineBarrier(
-		    transfer_command,
-		    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-		    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-		    0,
-		    0, nullptr,
-		    1, &acquire_buffer_barrier,
-		    0, nullptr);
-
-		VkBufferMemoryBarrier release_buffer_barrier =
-		    {
-		        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-		        nullptr,
-		        VK_ACCESS_SHADER_WRITE_BIT,
-		        0,
-		        compute.queue_family_index,
-		        graphics.queue_family_index,
-		        compute.storage_buffer->get_handle(),
-		        0,
-		        compute.storage_buffer->get_size()};
-		vkCmdPipelineBarrier(
-		    transfer_command,
-		    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-		    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-		    0,
-		    0, nullptr,
-		    1, &release_buffer_barrier,
-		    0, nullptr);
-
-		// Copied from Device::flush_command_buffer, which we can't use because it would be
-		// working with the wrong command pool
-		VK_CHECK(vkEndCommandBuffer(transfer_command));
-
-		// Submit compute commands
-		VkSubmitInfo submit_info{};
-		submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submit_info.commandBufferCount = 1;
-		submit_info.pCommandBuffers    = &transfer_command;
-
-		// Create fence to ensure that the command buffer has finished executing
-		VkFenceCreateInfo fence_info{};
-		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fence_info.flags = VK_FLAGS_NONE;
-
-		VkFence fence;
-		VK_CHECK(vkCreateFence(device->get_handle(), &fence_info, nullptr, &fence));
-		// Submit to the *compute* queue
-		VkResult result = vkQueueSubmit(compute.queue, 1, &submit_info, fence);
-		// Wait for the fence to signal that command buffer has finished executing
-		VK_CHECK(vkWaitForFences(device->get_handle(), 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
-		vkDestroyFence(device->get_handle(), fence, nullptr);
-
-		vkFreeCommandBuffers(device->get_handle(), compute.command_pool, 1, &transfer_command);
-	}
+	initialize_storage_buffer_ownership();
 }
 
 // Prepare and initialize uniform buffer containing shader uniforms
@@ -811,6 +1015,8 @@ void ComputeNBody::draw()
 
 	ApiVulkanSample::submit_frame();
 
+	get_compute_timing();
+
 	// Wait for rendering finished
 	VkPipelineStageFlags wait_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
@@ -857,6 +1063,41 @@ void ComputeNBody::render(float delta_time)
 	}
 }
 
+void ComputeNBody::on_update_ui_overlay(vkb::Drawer &drawer)
+{
+	if (drawer.header("Settings"))
+	{
+		if (drawer.slider_int("Particles per attractor (K)", &particles_per_attractor, 1, MAX_PARTICLES_PER_ATTRACTOR / 1024))
+		{
+			update_particle_count();
+		}
+		if (drawer.checkbox("Cell approximation", &cell_approximation))
+		{
+			// The compute command buffer may still be executing
+			get_device().wait_idle();
+			build_compute_command_buffer();
+		}
+		if (compute.pipeline_calculate_subgroup != VK_NULL_HANDLE && drawer.checkbox("Subgroup operations", &subgroup_operations))
+		{
+			get_device().wait_idle();
+			build_compute_command_buffer();
+		}
+	}
+	if (drawer.header("Statistics"))
+	{
+		drawer.text("Particles: %u", num_particles);
+		drawer.text("Work group size: %u", compute.work_group_size);
+		if (compute.pipeline_calculate_subgroup != VK_NULL_HANDLE)
+		{
+			drawer.text("Subgroup size: %u", get_device().get_gpu().get_subgroup_properties().subgroupSize);
+		}
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			drawer.text("Compute GPU time: %.3f ms", compute.elapsed_ms);
+		}
+	}
+}
+
 void ComputeNBody::resize(const uint32_t width, const uint32_t height)
 {
 	ApiVulkanSample::resize(width, height);
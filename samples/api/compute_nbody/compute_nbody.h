@@ -30,11 +30,34 @@
 #	define PARTICLES_PER_ATTRACTOR 4 * 1024
 #endif
 
+#if defined(__ANDROID__)
+#	define MAX_WORK_GROUP_SIZE 256
+#else
+#	define MAX_WORK_GROUP_SIZE 512
+#endif
+
+// Upper bound of the particle count setting, with six attractors this is past a million particles
+#define MAX_PARTICLES_PER_ATTRACTOR 192 * 1024
+
+// Uniform grid used by the approximated force calculation, spanning [-16, 16] on every axis.
+// This must match the defines in the particle_*.comp shaders
+#define CELL_GRID_DIM 32
+#define CELL_COUNT (CELL_GRID_DIM * CELL_GRID_DIM * CELL_GRID_DIM)
+
 class ComputeNBody : public ApiVulkanSample
 {
   public:
 	uint32_t num_particles;
 
+	// Particle count setting, in multiples of 1024 particles per attractor
+	int32_t particles_per_attractor = PARTICLES_PER_ATTRACTOR / 1024;
+
+	// Approximate the forces of distant particles by their cell's center of mass
+	bool cell_approximation = false;
+
+	// Use the subgroup variants of the force and scan passes, if the GPU supports them
+	bool subgroup_operations = true;
+
 	struct
 	{
 		Texture particle;
@@ -73,6 +96,21 @@ class ComputeNBody : public ApiVulkanSample
 		VkPipelineLayout                   pipeline_layout;              // Layout of the compute pipeline
 		VkPipeline                         pipeline_calculate;           // Compute pipeline for N-Body velocity calculation (1st pass)
 		VkPipeline                         pipeline_integrate;           // Compute pipeline for euler integration (2nd pass)
+		VkPipeline                         pipeline_bin;                 // Sorts the particles into the cell grid
+		VkPipeline                         pipeline_scan;                // Prefix sum of the cell particle counts
+		VkPipeline                         pipeline_scatter;             // Writes the particle indices in cell order
+		VkPipeline                         pipeline_cell_mass;           // Reduces each cell to its center of mass
+		VkPipeline                         pipeline_calculate_cells;     // Velocity calculation using the cell approximation
+		VkPipeline                         pipeline_calculate_subgroup = VK_NULL_HANDLE;  // 1st pass sharing the tiles with subgroup shuffles
+		VkPipeline                         pipeline_scan_subgroup      = VK_NULL_HANDLE;  // Prefix sum using subgroup arithmetic
+		std::unique_ptr<vkb::core::Buffer> cell_counts;                  // Number of particles in each cell
+		std::unique_ptr<vkb::core::Buffer> cell_offsets;                 // First index of each cell in the sorted particle indices
+		std::unique_ptr<vkb::core::Buffer> cell_masses;                  // Center of mass and total mass of each cell
+		std::unique_ptr<vkb::core::Buffer> particle_cells;               // Cell of each particle and its slot in that cell
+		std::unique_ptr<vkb::core::Buffer> sorted_indices;               // Particle indices sorted by cell
+		uint32_t                           work_group_size;              // Chosen from the device limits
+		VkQueryPool                        query_pool = VK_NULL_HANDLE;  // Timestamps around the compute work
+		float                              elapsed_ms = 0.0f;
 		VkPipeline                         blur;
 		VkPipelineLayout                   pipeline_layout_blur;
 		VkDescriptorSetLayout              descriptor_set_layout_blur;
@@ -99,6 +137,12 @@ class ComputeNBody : public ApiVulkanSample
 	void         build_command_buffers() override;
 	void         build_compute_command_buffer();
 	void         prepare_storage_buffers();
+	void         initialize_storage_buffer_ownership();
+	void         update_compute_descriptor_set();
+	void         update_particle_count();
+	void         get_compute_timing();
+	uint32_t     select_work_group_size();
+	bool         is_subgroup_supported();
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layout();
 	void         setup_descriptor_set();
@@ -111,6 +155,7 @@ class ComputeNBody : public ApiVulkanSample
 	void         draw();
 	bool         prepare(vkb::Platform &platform) override;
 	virtual void render(float delta_time) override;
+	virtual void on_update_ui_overlay(vkb::Drawer &drawer) override;
 	virtual void resize(const uint32_t width, const uint32_t height) override;
 };
 
@@ -24,10 +24,17 @@
  *
  * The used descriptor type VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC then allows to set a dynamic
  * offset used to pass data from the single uniform buffer to the connected shader binding point.
+ *
+ * The object count can be raised to show where dynamic offsets stop scaling, compared to a layout
+ * that packs the matrices tightly into a storage buffer indexed with the instance index.
  */
 
 #include "dynamic_uniform_buffers.h"
 
+#include <glm/gtc/quaternion.hpp>
+
+#include "timer.h"
+
 DynamicUniformBuffers::DynamicUniformBuffers()
 {
 	title = "Dynamic uniform buffers";
@@ -45,9 +52,12 @@ DynamicUniformBuffers ::~DynamicUniformBuffers()
 		// Clean up used Vulkan resources
 		// Note : Inherited destructor cleans up resources stored in base class
 		vkDestroyPipeline(get_device().get_handle(), pipeline, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), packed_pipeline, nullptr);
 
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layout, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), packed_pipeline_layout, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layout, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), packed_descriptor_set_layout, nullptr);
 	}
 }
 
@@ -92,6 +102,9 @@ void DynamicUniformBuffers::build_command_buffers()
 	render_pass_begin_info.clearValueCount          = 2;
 	render_pass_begin_info.pClearValues             = clear_values;
 
+	vkb::Timer timer;
+	timer.start();
+
 	for (int32_t i = 0; i < draw_cmd_buffers.size(); ++i)
 	{
 		render_pass_begin_info.framebuffer = framebuffers[i];
@@ -106,21 +119,35 @@ void DynamicUniformBuffers::build_command_buffers()
 		VkRect2D scissor = vkb::initializers::rect2D(width, height, 0, 0);
 		vkCmdSetScissor(draw_cmd_buffers[i], 0, 1, &scissor);
 
-		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, packed_layout ? packed_pipeline : pipeline);
 
 		VkDeviceSize offsets[1] = {0};
 		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, vertex_buffer->get(), offsets);
 		vkCmdBindIndexBuffer(draw_cmd_buffers[i], index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
 
-		// Render multiple objects using different model matrices by dynamically offsetting into one uniform buffer
-		for (uint32_t j = 0; j < OBJECT_INSTANCES; j++)
+		if (packed_layout)
+		{
+			// The descriptor set is bound once, the first instance of each draw selects the model matrix
+			// One draw per object is kept so only the cost of binding differs from the dynamic offsets
+			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, packed_pipeline_layout, 0, 1, &packed_descriptor_set, 0, nullptr);
+
+			for (uint32_t j = 0; j < static_cast<uint32_t>(object_count); j++)
+			{
+				vkCmdDrawIndexed(draw_cmd_buffers[i], index_count, 1, 0, 0, j);
+			}
+		}
+		else
 		{
-			// One dynamic offset per dynamic descriptor to offset into the ubo containing all model matrices
-			uint32_t dynamic_offset = j * static_cast<uint32_t>(dynamic_alignment);
-			// Bind the descriptor set for rendering a mesh using the dynamic offset
-			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_set, 1, &dynamic_offset);
+			// Render multiple objects using different model matrices by dynamically offsetting into one uniform buffer
+			for (uint32_t j = 0; j < static_cast<uint32_t>(object_count); j++)
+			{
+				// One dynamic offset per dynamic descriptor to offset into the ubo containing all model matrices
+				uint32_t dynamic_offset = j * static_cast<uint32_t>(dynamic_alignment);
+				// Bind the descriptor set for rendering a mesh using the dynamic offset
+				vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_set, 1, &dynamic_offset);
 
-			vkCmdDrawIndexed(draw_cmd_buffers[i], index_count, 1, 0, 0, 0);
+				vkCmdDrawIndexed(draw_cmd_buffers[i], index_count, 1, 0, 0, 0);
+			}
 		}
 
 		draw_ui(draw_cmd_buffers[i]);
@@ -129,6 +156,8 @@ void DynamicUniformBuffers::build_command_buffers()
 
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
 	}
+
+	record_time_ms = static_cast<float>(timer.stop<vkb::Timer::Milliseconds>() / draw_cmd_buffers.size());
 }
 
 void DynamicUniformBuffers::draw()
@@ -221,11 +250,12 @@ void DynamicUniformBuffers::generate_cube()
 
 void DynamicUniformBuffers::setup_descriptor_pool()
 {
-	// Example uses one ubo and one image sampler
+	// Example uses one ubo per layout, the dynamic ubo and the storage buffer of the packed layout, and one image sampler
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)};
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
@@ -258,6 +288,15 @@ void DynamicUniformBuffers::setup_descriptor_set_layout()
 	        1);
 
 	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &pipeline_layout));
+
+	// The packed layout reads the model matrices from a storage buffer
+	set_layout_bindings[1] = vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1);
+
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout, nullptr, &packed_descriptor_set_layout));
+
+	pipeline_layout_create_info.pSetLayouts = &packed_descriptor_set_layout;
+
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &packed_pipeline_layout));
 }
 
 void DynamicUniformBuffers::setup_descriptor_set()
@@ -270,14 +309,46 @@ void DynamicUniformBuffers::setup_descriptor_set()
 
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_set));
 
-	VkDescriptorBufferInfo            view_buffer_descriptor    = create_descriptor(*uniform_buffers.view);
-	VkDescriptorBufferInfo            dynamic_buffer_descriptor = create_descriptor(*uniform_buffers.dynamic);
-	std::vector<VkWriteDescriptorSet> write_descriptor_sets     = {
-        // Binding 0 : Projection/View matrix uniform buffer
-        vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &view_buffer_descriptor),
-        // Binding 1 : Instance matrix as dynamic uniform buffer
-        vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &dynamic_buffer_descriptor),
-    };
+	alloc_info.pSetLayouts = &packed_descriptor_set_layout;
+
+	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &packed_descriptor_set));
+
+	update_descriptor_sets();
+}
+
+// Point the descriptor sets to the buffers of the current object count and layout
+void DynamicUniformBuffers::update_descriptor_sets()
+{
+	VkDescriptorBufferInfo view_buffer_descriptor = create_descriptor(*uniform_buffers.view);
+
+	// The range of a dynamic uniform buffer is the part visible from a dynamic offset, a single matrix
+	VkDescriptorBufferInfo dynamic_buffer_descriptor;
+	VkDescriptorBufferInfo packed_buffer_descriptor;
+	if (packed_layout)
+	{
+		packed_buffer_descriptor = create_descriptor(*uniform_buffers.packed);
+	}
+	else
+	{
+		dynamic_buffer_descriptor = create_descriptor(*uniform_buffers.dynamic, sizeof(glm::mat4));
+	}
+
+	std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
+	    // Binding 0 : Projection/View matrix uniform buffer
+	    vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &view_buffer_descriptor),
+	    vkb::initializers::write_descriptor_set(packed_descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &view_buffer_descriptor),
+	};
+
+	// Binding 1 : Instance matrix as dynamic uniform buffer, or all instance matrices in a storage buffer
+	// Only the buffers of the current layout exist, the set of the other layout isn't used until it is rewritten
+	if (packed_layout)
+	{
+		write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(packed_descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &packed_buffer_descriptor));
+	}
+	else
+	{
+		write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &dynamic_buffer_descriptor));
+	}
 
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
 }
@@ -369,14 +440,16 @@ void DynamicUniformBuffers::prepare_pipelines()
 	pipeline_create_info.pStages             = shader_stages.data();
 
 	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline));
+
+	shader_stages[0]            = load_shader("dynamic_uniform_buffers/packed.vert", VK_SHADER_STAGE_VERTEX_BIT);
+	pipeline_create_info.layout = packed_pipeline_layout;
+
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &packed_pipeline));
 }
 
 // Prepare and initialize uniform buffer containing shader uniforms
 void DynamicUniformBuffers::prepare_uniform_buffers()
 {
-	// Allocate data for the dynamic uniform buffer object
-	// We allocate this manually as the alignment of the offset differs between GPUs
-
 	// Calculate required alignment based on minimum device offset alignment
 	size_t min_ubo_alignment = get_device().get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
 	dynamic_alignment        = sizeof(glm::mat4);
@@ -385,11 +458,6 @@ void DynamicUniformBuffers::prepare_uniform_buffers()
 		dynamic_alignment = (dynamic_alignment + min_ubo_alignment - 1) & ~(min_ubo_alignment - 1);
 	}
 
-	size_t buffer_size = OBJECT_INSTANCES * dynamic_alignment;
-
-	ubo_data_dynamic.model = (glm::mat4 *) aligned_alloc(buffer_size, dynamic_alignment);
-	assert(ubo_data_dynamic.model);
-
 	std::cout << "minUniformBufferOffsetAlignment = " << min_ubo_alignment << std::endl;
 	std::cout << "dynamicAlignment = " << dynamic_alignment << std::endl;
 
@@ -401,21 +469,58 @@ void DynamicUniformBuffers::prepare_uniform_buffers()
 	                                                           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 	                                                           VMA_MEMORY_USAGE_CPU_TO_GPU);
 
-	uniform_buffers.dynamic = std::make_unique<vkb::core::Buffer>(get_device(),
-	                                                              buffer_size,
-	                                                              VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                                                              VMA_MEMORY_USAGE_CPU_TO_GPU);
+	// Prepare per-object matrices with offsets and random rotations, for the largest object count
+	// so the objects keep their rotations when the count changes
+	rotations.resize(MAX_OBJECT_INSTANCES);
+	rotation_speeds.resize(MAX_OBJECT_INSTANCES);
 
-	// Prepare per-object matrices with offsets and random rotations
 	std::default_random_engine      rnd_engine(is_benchmark_mode() ? 0 : (unsigned) time(nullptr));
 	std::normal_distribution<float> rnd_dist(-1.0f, 1.0f);
-	for (uint32_t i = 0; i < OBJECT_INSTANCES; i++)
+	for (uint32_t i = 0; i < MAX_OBJECT_INSTANCES; i++)
 	{
 		rotations[i]       = glm::vec3(rnd_dist(rnd_engine), rnd_dist(rnd_engine), rnd_dist(rnd_engine)) * 2.0f * glm::pi<float>();
 		rotation_speeds[i] = glm::vec3(rnd_dist(rnd_engine), rnd_dist(rnd_engine), rnd_dist(rnd_engine));
 	}
 
+	prepare_object_buffers();
+
 	update_uniform_buffers();
+}
+
+// (Re)create the buffers holding the model matrices for the current object count and layout
+void DynamicUniformBuffers::prepare_object_buffers()
+{
+	if (ubo_data_dynamic.model)
+	{
+		aligned_free(ubo_data_dynamic.model);
+	}
+	uniform_buffers.dynamic.reset();
+	uniform_buffers.packed.reset();
+
+	// Allocate data for the dynamic uniform buffer object
+	// We allocate this manually as the alignment of the offset differs between GPUs
+	object_stride = packed_layout ? sizeof(glm::mat4) : dynamic_alignment;
+
+	size_t buffer_size = object_count * object_stride;
+
+	ubo_data_dynamic.model = (glm::mat4 *) aligned_alloc(buffer_size, object_stride);
+	assert(ubo_data_dynamic.model);
+
+	if (packed_layout)
+	{
+		uniform_buffers.packed = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                                             buffer_size,
+		                                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                             VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+	else
+	{
+		uniform_buffers.dynamic = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                                              buffer_size,
+		                                                              VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		                                                              VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+
 	update_dynamic_uniform_buffer(0.0f, true);
 }
 
@@ -437,10 +542,16 @@ void DynamicUniformBuffers::update_dynamic_uniform_buffer(float delta_time, bool
 		return;
 	}
 
+	vkb::Timer timer;
+	timer.start();
+
 	// Dynamic ubo with per-object model matrices indexed by offsets in the command buffer
-	uint32_t  dim = static_cast<uint32_t>(pow(OBJECT_INSTANCES, (1.0f / 3.0f)));
+	// The grid is the smallest cube holding all objects, the last layer is partially filled
+	uint32_t  dim = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<float>(object_count)) - 0.001f));
 	glm::vec3 offset(5.0f);
 
+	const glm::vec3 rotation_axis_x = glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f));
+
 	for (uint32_t x = 0; x < dim; x++)
 	{
 		for (uint32_t y = 0; y < dim; y++)
@@ -448,29 +559,49 @@ void DynamicUniformBuffers::update_dynamic_uniform_buffer(float delta_time, bool
 			for (uint32_t z = 0; z < dim; z++)
 			{
 				uint32_t index = x * dim * dim + y * dim + z;
+				if (index >= static_cast<uint32_t>(object_count))
+				{
+					continue;
+				}
 
 				// Aligned offset
-				glm::mat4 *model_mat = (glm::mat4 *) (((uint64_t) ubo_data_dynamic.model + (index * dynamic_alignment)));
+				glm::mat4 *model_mat = (glm::mat4 *) (((uint64_t) ubo_data_dynamic.model + (index * object_stride)));
 
 				// Update rotations
 				rotations[index] += animation_timer * rotation_speeds[index];
 
 				// Update matrices
 				glm::vec3 pos = glm::vec3(-((dim * offset.x) / 2.0f) + offset.x / 2.0f + x * offset.x, -((dim * offset.y) / 2.0f) + offset.y / 2.0f + y * offset.y, -((dim * offset.z) / 2.0f) + offset.z / 2.0f + z * offset.z);
-				*model_mat    = glm::translate(glm::mat4(1.0f), pos);
-				*model_mat    = glm::rotate(*model_mat, rotations[index].x, glm::vec3(1.0f, 1.0f, 0.0f));
-				*model_mat    = glm::rotate(*model_mat, rotations[index].y, glm::vec3(0.0f, 1.0f, 0.0f));
-				*model_mat    = glm::rotate(*model_mat, rotations[index].z, glm::vec3(0.0f, 0.0f, 1.0f));
+				if (fast_matrix_generation)
+				{
+					// Same matrix as below, the three rotations are combined as quaternions and converted once
+					glm::quat rotation = glm::angleAxis(rotations[index].x, rotation_axis_x) *
+					                     glm::angleAxis(rotations[index].y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+					                     glm::angleAxis(rotations[index].z, glm::vec3(0.0f, 0.0f, 1.0f));
+					*model_mat      = glm::mat4_cast(rotation);
+					(*model_mat)[3] = glm::vec4(pos, 1.0f);
+				}
+				else
+				{
+					*model_mat = glm::translate(glm::mat4(1.0f), pos);
+					*model_mat = glm::rotate(*model_mat, rotations[index].x, glm::vec3(1.0f, 1.0f, 0.0f));
+					*model_mat = glm::rotate(*model_mat, rotations[index].y, glm::vec3(0.0f, 1.0f, 0.0f));
+					*model_mat = glm::rotate(*model_mat, rotations[index].z, glm::vec3(0.0f, 0.0f, 1.0f));
+				}
 			}
 		}
 	}
 
 	animation_timer = 0.0f;
 
-	uniform_buffers.dynamic->update(ubo_data_dynamic.model, uniform_buffers.dynamic->get_size());
+	update_time_ms = 0.9f * update_time_ms + 0.1f * static_cast<float>(timer.stop<vkb::Timer::Milliseconds>());
+
+	auto &buffer = packed_layout ? uniform_buffers.packed : uniform_buffers.dynamic;
+
+	buffer->update(ubo_data_dynamic.model, buffer->get_size());
 
 	// Flush to make changes visible to the device
-	uniform_buffers.dynamic->flush();
+	buffer->flush();
 }
 
 bool DynamicUniformBuffers::prepare(vkb::Platform &platform)
@@ -521,6 +652,31 @@ void DynamicUniformBuffers::render(float delta_time)
 	}
 }
 
+void DynamicUniformBuffers::on_update_ui_overlay(vkb::Drawer &drawer)
+{
+	if (drawer.header("Settings"))
+	{
+		bool rebuild = drawer.slider_int("Objects", &object_count, 1, MAX_OBJECT_INSTANCES);
+		rebuild |= drawer.checkbox("Pack objects in storage buffer", &packed_layout);
+		if (rebuild)
+		{
+			// The buffers are in use by the frames in flight
+			vkDeviceWaitIdle(get_device().get_handle());
+			prepare_object_buffers();
+			update_descriptor_sets();
+			build_command_buffers();
+		}
+		drawer.checkbox("Fast matrix generation", &fast_matrix_generation);
+	}
+	if (drawer.header("Statistics"))
+	{
+		drawer.text("Object stride: %d bytes", static_cast<int>(object_stride));
+		drawer.text("Matrix buffer: %.2f MB", object_count * object_stride / (1024.0f * 1024.0f));
+		drawer.text("Matrix update: %.3f ms", update_time_ms);
+		drawer.text("Command buffer recording: %.3f ms", record_time_ms);
+	}
+}
+
 std::unique_ptr<vkb::Application> create_dynamic_uniform_buffers()
 {
 	return std::make_unique<DynamicUniformBuffers>();
@@ -24,6 +24,9 @@
  *
  * The used descriptor type VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC then allows to set a dynamic
  * offset used to pass data from the single uniform buffer to the connected shader binding point.
+ *
+ * The object count can be raised to show where dynamic offsets stop scaling, compared to a layout
+ * that packs the matrices tightly into a storage buffer indexed with the instance index.
  */
 
 #pragma once
@@ -31,6 +34,7 @@
 #include "api_vulkan_sample.h"
 
 #define OBJECT_INSTANCES 125
+#define MAX_OBJECT_INSTANCES 100000
 
 class DynamicUniformBuffers : public ApiVulkanSample
 {
@@ -53,6 +57,7 @@ class DynamicUniformBuffers : public ApiVulkanSample
 	{
 		std::unique_ptr<vkb::core::Buffer> view;
 		std::unique_ptr<vkb::core::Buffer> dynamic;
+		std::unique_ptr<vkb::core::Buffer> packed;
 	} uniform_buffers;
 
 	struct UboVS
@@ -62,8 +67,8 @@ class DynamicUniformBuffers : public ApiVulkanSample
 	} ubo_vs;
 
 	// Store random per-object rotations
-	glm::vec3 rotations[OBJECT_INSTANCES];
-	glm::vec3 rotation_speeds[OBJECT_INSTANCES];
+	std::vector<glm::vec3> rotations;
+	std::vector<glm::vec3> rotation_speeds;
 
 	// One big uniform buffer that contains all matrices
 	// Note that we need to manually allocate the data to cope for GPU-specific uniform buffer offset alignments
@@ -77,10 +82,30 @@ class DynamicUniformBuffers : public ApiVulkanSample
 	VkDescriptorSet       descriptor_set;
 	VkDescriptorSetLayout descriptor_set_layout;
 
+	// Packed layout, the matrices are stored without padding in a storage buffer indexed by the instance index
+	VkPipeline            packed_pipeline;
+	VkPipelineLayout      packed_pipeline_layout;
+	VkDescriptorSet       packed_descriptor_set;
+	VkDescriptorSetLayout packed_descriptor_set_layout;
+
 	float animation_timer = 0.0f;
 
 	size_t dynamic_alignment;
 
+	// Distance between two matrices in the buffers, the dynamic alignment or the size of a matrix when packed
+	size_t object_stride;
+
+	int32_t object_count = OBJECT_INSTANCES;
+
+	bool packed_layout = false;
+
+	// Build the model matrices from quaternions, instead of rotating a matrix three times
+	bool fast_matrix_generation = false;
+
+	// Averaged time spent generating the model matrices, and time spent recording the command buffers
+	float update_time_ms = 0.0f;
+	float record_time_ms = 0.0f;
+
 	DynamicUniformBuffers();
 	~DynamicUniformBuffers();
 	void         build_command_buffers() override;
@@ -88,14 +113,17 @@ class DynamicUniformBuffers : public ApiVulkanSample
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layout();
 	void         setup_descriptor_set();
+	void         update_descriptor_sets();
 	void         prepare_pipelines();
 	void         prepare_uniform_buffers();
+	void         prepare_object_buffers();
 	void         update_uniform_buffers();
 	void         update_dynamic_uniform_buffer(float delta_time, bool force = false);
 	void         draw();
 	bool         prepare(vkb::Platform &platform) override;
 	virtual void render(float delta_time) override;
 	virtual void resize(const uint32_t width, const uint32_t height) override;
+	virtual void on_update_ui_overlay(vkb::Drawer &drawer) override;
 };
 
 std::unique_ptr<vkb::Application> create_dynamic_uniform_buffers();
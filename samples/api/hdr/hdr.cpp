@@ -61,6 +61,28 @@ HDR::~HDR()
 
 		filter_pass.color[0].destroy(get_device().get_handle());
 
+		// The images are destroyed before the memory they are bound to
+		attachment_images.clear();
+		attachment_allocator.reset();
+
+		vkDestroyPipeline(get_device().get_handle(), bloom_chain.downsample, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), bloom_chain.upsample, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), bloom_chain.composite, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), bloom_chain.pipeline_layout, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), bloom_chain.descriptor_set_layout, nullptr);
+		vkDestroySampler(get_device().get_handle(), bloom_chain.sampler, nullptr);
+		for (auto view : bloom_chain.views)
+		{
+			vkDestroyImageView(get_device().get_handle(), view, nullptr);
+		}
+		vkDestroyImage(get_device().get_handle(), bloom_chain.image, nullptr);
+		vkFreeMemory(get_device().get_handle(), bloom_chain.mem, nullptr);
+
+		if (bloom_timing.query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(get_device().get_handle(), bloom_timing.query_pool, nullptr);
+		}
+
 		vkDestroySampler(get_device().get_handle(), textures.envmap.sampler, nullptr);
 	}
 }
@@ -93,6 +115,11 @@ void HDR::build_command_buffers()
 	{
 		VK_CHECK(vkBeginCommandBuffer(draw_cmd_buffers[i], &command_buffer_begin_info));
 
+		if (bloom_timing.query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(draw_cmd_buffers[i], bloom_timing.query_pool, static_cast<uint32_t>(i) * 4, 4);
+		}
+
 		{
 			/*
 				First pass: Render scene to offscreen framebuffer
@@ -139,11 +166,23 @@ void HDR::build_command_buffers()
 			vkCmdEndRenderPass(draw_cmd_buffers[i]);
 		}
 
+		/*
+			Second pass: Compute bloom chain
+		*/
+		if (bloom && compute_bloom)
+		{
+			write_bloom_timestamp(draw_cmd_buffers[i], i, 0);
+			record_compute_bloom(draw_cmd_buffers[i]);
+			write_bloom_timestamp(draw_cmd_buffers[i], i, 1);
+		}
+
 		/*
 			Second render pass: First bloom pass
 		*/
-		if (bloom)
+		if (bloom && !compute_bloom)
 		{
+			write_bloom_timestamp(draw_cmd_buffers[i], i, 0);
+
 			VkClearValue clear_values[2];
 			clear_values[0].color        = {{0.0f, 0.0f, 0.0f, 0.0f}};
 			clear_values[1].depthStencil = {0.0f, 0};
@@ -171,6 +210,8 @@ void HDR::build_command_buffers()
 			vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
 
 			vkCmdEndRenderPass(draw_cmd_buffers[i]);
+
+			write_bloom_timestamp(draw_cmd_buffers[i], i, 1);
 		}
 
 		/*
@@ -211,8 +252,20 @@ void HDR::build_command_buffers()
 			// Bloom
 			if (bloom)
 			{
-				vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.bloom[0]);
+				write_bloom_timestamp(draw_cmd_buffers[i], i, 2);
+
+				if (compute_bloom)
+				{
+					vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.composition, 0, 1, &bloom_chain.composition_set, 0, NULL);
+					vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, bloom_chain.composite);
+				}
+				else
+				{
+					vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.bloom[0]);
+				}
 				vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
+
+				write_bloom_timestamp(draw_cmd_buffers[i], i, 3);
 			}
 
 			draw_ui(draw_cmd_buffers[i]);
@@ -224,11 +277,105 @@ void HDR::build_command_buffers()
 	}
 }
 
-void HDR::create_attachment(VkFormat format, VkImageUsageFlagBits usage, FrameBufferAttachment *attachment)
+void HDR::record_compute_bloom(VkCommandBuffer command_buffer)
+{
+	auto level_barrier = [this](uint32_t level, VkImageLayout old_layout, VkAccessFlags src_access_mask, VkAccessFlags dst_access_mask) {
+		VkImageMemoryBarrier barrier = vkb::initializers::image_memory_barrier();
+		barrier.oldLayout            = old_layout;
+		barrier.newLayout            = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask        = src_access_mask;
+		barrier.dstAccessMask        = dst_access_mask;
+		barrier.image                = bloom_chain.image;
+		barrier.subresourceRange     = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+		return barrier;
+	};
+
+	// The bright colors of the offscreen pass are read by the first downsample, the previous contents of the chain are discarded
+	std::array<VkImageMemoryBarrier, 2> barriers;
+	barriers[0]                  = vkb::initializers::image_memory_barrier();
+	barriers[0].oldLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[0].newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[0].srcAccessMask    = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barriers[0].dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
+	barriers[0].image            = offscreen.color[1].image;
+	barriers[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+	barriers[1]                              = level_barrier(0, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_ACCESS_SHADER_WRITE_BIT);
+	barriers[1].subresourceRange.levelCount = bloom_chain.levels;
+
+	vkCmdPipelineBarrier(command_buffer,
+	                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+	                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                     0, 0, nullptr, 0, nullptr,
+	                     static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	// Downsample and blur into each level from the previous one
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_chain.downsample);
+	for (uint32_t level = 0; level < bloom_chain.levels; ++level)
+	{
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_chain.pipeline_layout, 0, 1, &bloom_chain.downsample_sets[level], 0, NULL);
+		vkCmdDispatch(command_buffer, (bloom_chain.extents[level].width + 15) / 16, (bloom_chain.extents[level].height + 15) / 16, 1);
+
+		auto barrier = level_barrier(level, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	// Accumulate the coarser levels back up into the first one
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_chain.upsample);
+	for (uint32_t level = bloom_chain.levels - 1; level-- > 0;)
+	{
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_chain.pipeline_layout, 0, 1, &bloom_chain.upsample_sets[level], 0, NULL);
+		vkCmdDispatch(command_buffer, (bloom_chain.extents[level].width + 15) / 16, (bloom_chain.extents[level].height + 15) / 16, 1);
+
+		if (level > 0)
+		{
+			auto barrier = level_barrier(level, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+	}
+
+	// The first level is blended over the composition
+	auto barrier = level_barrier(0, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void HDR::write_bloom_timestamp(VkCommandBuffer command_buffer, uint32_t buffer_index, uint32_t query)
+{
+	if (bloom_timing.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, bloom_timing.query_pool, buffer_index * 4 + query);
+	}
+}
+
+// Retrieves the GPU time of the bloom work of the command buffer just submitted, the frame waits for the device to be idle
+void HDR::get_bloom_timing()
+{
+	if (bloom_timing.query_pool == VK_NULL_HANDLE || !bloom)
+	{
+		return;
+	}
+
+	std::array<uint64_t, 4> timestamps{};
+	if (vkGetQueryPoolResults(get_device().get_handle(), bloom_timing.query_pool, current_buffer * 4, 4,
+	                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+	{
+		// The bloom passes are split around the start of the composition
+		auto  ticks  = (timestamps[1] - timestamps[0]) + (timestamps[3] - timestamps[2]);
+		float period = get_device().get_gpu().get_properties().limits.timestampPeriod;
+
+		bloom_timing.elapsed_ms = static_cast<float>(ticks) * period / 1000000.0f;
+	}
+}
+
+void HDR::create_attachment(vkb::core::Image &image, FrameBufferAttachment *attachment)
 {
 	VkImageAspectFlags aspect_mask = 0;
 	VkImageLayout      image_layout;
 
+	VkFormat          format = image.get_format();
+	VkImageUsageFlags usage  = image.get_usage();
+
+	attachment->image  = image.get_handle();
 	attachment->format = format;
 
 	if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
@@ -249,28 +396,6 @@ void HDR::create_attachment(VkFormat format, VkImageUsageFlagBits usage, FrameBu
 
 	assert(aspect_mask > 0);
 
-	VkImageCreateInfo image = vkb::initializers::image_create_info();
-	image.imageType         = VK_IMAGE_TYPE_2D;
-	image.format            = format;
-	image.extent.width      = offscreen.width;
-	image.extent.height     = offscreen.height;
-	image.extent.depth      = 1;
-	image.mipLevels         = 1;
-	image.arrayLayers       = 1;
-	image.samples           = VK_SAMPLE_COUNT_1_BIT;
-	image.tiling            = VK_IMAGE_TILING_OPTIMAL;
-	image.usage             = usage | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-	VkMemoryAllocateInfo memory_allocate_info = vkb::initializers::memory_allocate_info();
-	VkMemoryRequirements memory_requirements;
-
-	VK_CHECK(vkCreateImage(get_device().get_handle(), &image, nullptr, &attachment->image));
-	vkGetImageMemoryRequirements(get_device().get_handle(), attachment->image, &memory_requirements);
-	memory_allocate_info.allocationSize  = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = get_device().get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(get_device().get_handle(), &memory_allocate_info, nullptr, &attachment->mem));
-	VK_CHECK(vkBindImageMemory(get_device().get_handle(), attachment->image, attachment->mem, 0));
-
 	VkImageViewCreateInfo image_view_create_info           = vkb::initializers::image_view_create_info();
 	image_view_create_info.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
 	image_view_create_info.format                          = format;
@@ -287,18 +412,33 @@ void HDR::create_attachment(VkFormat format, VkImageUsageFlagBits usage, FrameBu
 // Prepare a new framebuffer and attachments for offscreen rendering (G-Buffer)
 void HDR::prepare_offscreen_buffer()
 {
+	// Passes of a frame: the attachments only need their memory in the passes using them
+	const uint32_t scene_pass       = 0;
+	const uint32_t bloom_pass       = 1;
+	const uint32_t composition_pass = 2;
+
+	// The depth buffer is dead once the scene is rendered, so it can share memory with the
+	// bloom filter target which is only written afterwards. Both are cleared on load.
+	attachment_allocator = std::make_unique<vkb::AttachmentAllocator>(get_device(), VkExtent3D{width, height, 1});
+
+	// We are using 128-Bit RGBA floating point color buffers for this sample
+	// In a performance or bandwith-limited scenario you should consider using a format with lower precision
+	auto scene_color  = attachment_allocator->request(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, scene_pass, composition_pass);
+	auto bright_color = attachment_allocator->request(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, scene_pass, bloom_pass);
+	auto scene_depth  = attachment_allocator->request(depth_format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, scene_pass, scene_pass);
+	auto filter_color = attachment_allocator->request(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, bloom_pass, composition_pass);
+
+	attachment_images = attachment_allocator->allocate();
+
 	{
 		offscreen.width  = width;
 		offscreen.height = height;
 
 		// Color attachments
-
-		// We are using two 128-Bit RGBA floating point color buffers for this sample
-		// In a performance or bandwith-limited scenario you should consider using a format with lower precision
-		create_attachment(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &offscreen.color[0]);
-		create_attachment(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &offscreen.color[1]);
+		create_attachment(attachment_images[scene_color], &offscreen.color[0]);
+		create_attachment(attachment_images[bright_color], &offscreen.color[1]);
 		// Depth attachment
-		create_attachment(depth_format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, &offscreen.depth);
+		create_attachment(attachment_images[scene_depth], &offscreen.depth);
 
 		// Set up separate renderpass with references to the colorand depth attachments
 		std::array<VkAttachmentDescription, 3> attachment_descriptions = {};
@@ -345,12 +485,13 @@ void HDR::prepare_offscreen_buffer()
 		// Use subpass dependencies for attachment layput transitions
 		std::array<VkSubpassDependency, 2> dependencies;
 
+		// The depth writes also wait for the previous frame to stop sampling the filter target aliasing the depth buffer
 		dependencies[0].srcSubpass      = VK_SUBPASS_EXTERNAL;
 		dependencies[0].dstSubpass      = 0;
 		dependencies[0].srcStageMask    = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		dependencies[0].dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		dependencies[0].srcAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
-		dependencies[0].dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
 		dependencies[1].srcSubpass      = 0;
@@ -411,8 +552,7 @@ void HDR::prepare_offscreen_buffer()
 
 		// Color attachments
 
-		// Two floating point color buffers
-		create_attachment(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &filter_pass.color[0]);
+		create_attachment(attachment_images[filter_color], &filter_pass.color[0]);
 
 		// Set up separate renderpass with references to the colorand depth attachments
 		std::array<VkAttachmentDescription, 1> attachment_descriptions = {};
@@ -438,11 +578,12 @@ void HDR::prepare_offscreen_buffer()
 		// Use subpass dependencies for attachment layput transitions
 		std::array<VkSubpassDependency, 2> dependencies;
 
+		// The depth writes of the scene pass land before the filter target aliasing the depth buffer is written
 		dependencies[0].srcSubpass      = VK_SUBPASS_EXTERNAL;
 		dependencies[0].dstSubpass      = 0;
-		dependencies[0].srcStageMask    = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		dependencies[0].srcStageMask    = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		dependencies[0].dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependencies[0].srcAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
+		dependencies[0].srcAccessMask   = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependencies[0].dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
@@ -496,6 +637,87 @@ void HDR::prepare_offscreen_buffer()
 	}
 }
 
+// Prepare the mip chain of the compute bloom, starting at half the resolution of the offscreen buffer
+void HDR::prepare_bloom_chain()
+{
+	bloom_chain.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	// Stop before the levels get smaller than a workgroup
+	VkExtent2D extent{static_cast<uint32_t>(std::max(offscreen.width / 2, 1)), static_cast<uint32_t>(std::max(offscreen.height / 2, 1))};
+	while (bloom_chain.extents.size() < MAX_BLOOM_LEVELS && std::min(extent.width, extent.height) >= 16)
+	{
+		bloom_chain.extents.push_back(extent);
+		extent = {extent.width / 2, extent.height / 2};
+	}
+	if (bloom_chain.extents.empty())
+	{
+		bloom_chain.extents.push_back(extent);
+	}
+	bloom_chain.levels = static_cast<uint32_t>(bloom_chain.extents.size());
+
+	VkImageCreateInfo image = vkb::initializers::image_create_info();
+	image.imageType         = VK_IMAGE_TYPE_2D;
+	image.format            = bloom_chain.format;
+	image.extent.width      = bloom_chain.extents[0].width;
+	image.extent.height     = bloom_chain.extents[0].height;
+	image.extent.depth      = 1;
+	image.mipLevels         = bloom_chain.levels;
+	image.arrayLayers       = 1;
+	image.samples           = VK_SAMPLE_COUNT_1_BIT;
+	image.tiling            = VK_IMAGE_TILING_OPTIMAL;
+	image.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+	VkMemoryAllocateInfo memory_allocate_info = vkb::initializers::memory_allocate_info();
+	VkMemoryRequirements memory_requirements;
+
+	VK_CHECK(vkCreateImage(get_device().get_handle(), &image, nullptr, &bloom_chain.image));
+	vkGetImageMemoryRequirements(get_device().get_handle(), bloom_chain.image, &memory_requirements);
+	memory_allocate_info.allocationSize  = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = get_device().get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK(vkAllocateMemory(get_device().get_handle(), &memory_allocate_info, nullptr, &bloom_chain.mem));
+	VK_CHECK(vkBindImageMemory(get_device().get_handle(), bloom_chain.image, bloom_chain.mem, 0));
+
+	// One view per level, each dispatch reads a level and writes the next
+	bloom_chain.views.resize(bloom_chain.levels);
+	for (uint32_t level = 0; level < bloom_chain.levels; ++level)
+	{
+		VkImageViewCreateInfo image_view_create_info = vkb::initializers::image_view_create_info();
+		image_view_create_info.viewType              = VK_IMAGE_VIEW_TYPE_2D;
+		image_view_create_info.format                = bloom_chain.format;
+		image_view_create_info.subresourceRange      = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+		image_view_create_info.image                 = bloom_chain.image;
+		VK_CHECK(vkCreateImageView(get_device().get_handle(), &image_view_create_info, nullptr, &bloom_chain.views[level]));
+	}
+
+	// Linear filtering of the coarser levels smooths the upsample
+	VkSamplerCreateInfo sampler = vkb::initializers::sampler_create_info();
+	sampler.magFilter           = VK_FILTER_LINEAR;
+	sampler.minFilter           = VK_FILTER_LINEAR;
+	sampler.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler.addressModeU        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler.addressModeV        = sampler.addressModeU;
+	sampler.addressModeW        = sampler.addressModeU;
+	sampler.maxAnisotropy       = 1.0f;
+	sampler.minLod              = 0.0f;
+	sampler.maxLod              = 0.0f;
+	sampler.borderColor         = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	VK_CHECK(vkCreateSampler(get_device().get_handle(), &sampler, nullptr, &bloom_chain.sampler));
+}
+
+void HDR::prepare_bloom_timing()
+{
+	if (!get_device().get_gpu().get_properties().limits.timestampComputeAndGraphics)
+	{
+		return;
+	}
+
+	VkQueryPoolCreateInfo query_pool_info = {};
+	query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_info.queryCount            = static_cast<uint32_t>(draw_cmd_buffers.size()) * 4;
+	VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, NULL, &bloom_timing.query_pool));
+}
+
 void HDR::load_assets()
 {
 	// Models
@@ -526,8 +748,9 @@ void HDR::setup_descriptor_pool()
 {
 	std::vector<VkDescriptorPoolSize> pool_sizes = {
 	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4),
-	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6)};
-	uint32_t                   num_descriptor_sets = 4;
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6 + 2 * bloom_chain.levels + 1),
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * bloom_chain.levels - 1)};
+	uint32_t                   num_descriptor_sets = 4 + 2 * bloom_chain.levels;
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
 	    vkb::initializers::descriptor_pool_create_info(static_cast<uint32_t>(pool_sizes.size()), pool_sizes.data(), num_descriptor_sets);
 	VK_CHECK(vkCreateDescriptorPool(get_device().get_handle(), &descriptor_pool_create_info, nullptr, &descriptor_pool));
@@ -576,6 +799,18 @@ void HDR::setup_descriptor_set_layout()
 
 	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&descriptor_set_layouts.composition, 1);
 	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &pipeline_layouts.composition));
+
+	// Compute bloom chain
+	set_layout_bindings = {
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+	};
+
+	descriptor_layout_create_info = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), static_cast<uint32_t>(set_layout_bindings.size()));
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout_create_info, nullptr, &bloom_chain.descriptor_set_layout));
+
+	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&bloom_chain.descriptor_set_layout, 1);
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &bloom_chain.pipeline_layout));
 }
 
 void HDR::setup_descriptor_sets()
@@ -641,6 +876,55 @@ void HDR::setup_descriptor_sets()
 	    vkb::initializers::write_descriptor_set(descriptor_sets.composition, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &color_descriptors[1]),
 	};
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+
+	// Compute bloom composition, blending the first level of the chain
+	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &bloom_chain.composition_set));
+
+	color_descriptors = {
+	    vkb::initializers::descriptor_image_info(offscreen.sampler, offscreen.color[0].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+	    vkb::initializers::descriptor_image_info(bloom_chain.sampler, bloom_chain.views[0], VK_IMAGE_LAYOUT_GENERAL),
+	};
+
+	write_descriptor_sets = {
+	    vkb::initializers::write_descriptor_set(bloom_chain.composition_set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &color_descriptors[0]),
+	    vkb::initializers::write_descriptor_set(bloom_chain.composition_set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &color_descriptors[1]),
+	};
+	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+
+	// Compute bloom chain, downsampling from the bright colors of the offscreen pass and upsampling from the coarser levels
+	alloc_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &bloom_chain.descriptor_set_layout, 1);
+
+	auto write_chain_set = [&](VkDescriptorSet descriptor_set, VkDescriptorImageInfo input_descriptor, uint32_t output_level) {
+		VkDescriptorImageInfo output_descriptor = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, bloom_chain.views[output_level], VK_IMAGE_LAYOUT_GENERAL);
+
+		std::vector<VkWriteDescriptorSet> chain_writes = {
+		    vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &input_descriptor),
+		    vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, &output_descriptor),
+		};
+		vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(chain_writes.size()), chain_writes.data(), 0, NULL);
+	};
+
+	bloom_chain.downsample_sets.resize(bloom_chain.levels);
+	for (uint32_t level = 0; level < bloom_chain.levels; ++level)
+	{
+		VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &bloom_chain.downsample_sets[level]));
+
+		auto input_descriptor = level == 0 ?
+		                            vkb::initializers::descriptor_image_info(offscreen.sampler, offscreen.color[1].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) :
+		                            vkb::initializers::descriptor_image_info(bloom_chain.sampler, bloom_chain.views[level - 1], VK_IMAGE_LAYOUT_GENERAL);
+
+		write_chain_set(bloom_chain.downsample_sets[level], input_descriptor, level);
+	}
+
+	bloom_chain.upsample_sets.resize(bloom_chain.levels - 1);
+	for (uint32_t level = 0; level + 1 < bloom_chain.levels; ++level)
+	{
+		VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &bloom_chain.upsample_sets[level]));
+
+		write_chain_set(bloom_chain.upsample_sets[level],
+		                vkb::initializers::descriptor_image_info(bloom_chain.sampler, bloom_chain.views[level + 1], VK_IMAGE_LAYOUT_GENERAL),
+		                level);
+	}
 }
 
 void HDR::prepare_pipelines()
@@ -760,6 +1044,21 @@ void HDR::prepare_pipelines()
 	dir                             = 0;
 	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.bloom[1]));
 
+	// Compute bloom composite, blended like the bloom pass
+	shader_stages[0]                = load_shader("hdr/composition.vert", VK_SHADER_STAGE_VERTEX_BIT);
+	shader_stages[1]                = load_shader("hdr/bloom_composite.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+	pipeline_create_info.renderPass = render_pass;
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &bloom_chain.composite));
+
+	// Compute bloom chain
+	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(bloom_chain.pipeline_layout, 0);
+
+	compute_pipeline_create_info.stage = load_shader("hdr/bloom_downsample.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &bloom_chain.downsample));
+
+	compute_pipeline_create_info.stage = load_shader("hdr/bloom_upsample.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &bloom_chain.upsample));
+
 	// Object rendering pipelines
 	rasterization_state.cullMode = VK_CULL_MODE_BACK_BIT;
 
@@ -872,6 +1171,8 @@ bool HDR::prepare(vkb::Platform &platform)
 	load_assets();
 	prepare_uniform_buffers();
 	prepare_offscreen_buffer();
+	prepare_bloom_chain();
+	prepare_bloom_timing();
 	setup_descriptor_set_layout();
 	prepare_pipelines();
 	setup_descriptor_pool();
@@ -886,6 +1187,7 @@ void HDR::render(float delta_time)
 	if (!prepared)
 		return;
 	draw();
+	get_bloom_timing();
 	if (camera.updated)
 		update_uniform_buffers();
 }
@@ -907,6 +1209,20 @@ void HDR::on_update_ui_overlay(vkb::Drawer &drawer)
 		{
 			build_command_buffers();
 		}
+		if (drawer.checkbox("Compute bloom", &compute_bloom))
+		{
+			build_command_buffers();
+		}
+		if (bloom && bloom_timing.query_pool != VK_NULL_HANDLE)
+		{
+			drawer.text("Bloom GPU time: %.3f ms", bloom_timing.elapsed_ms);
+		}
+		if (attachment_allocator)
+		{
+			drawer.text("Attachments: %.1f MB (%.1f MB unaliased)",
+			            static_cast<float>(attachment_allocator->get_aliased_size()) / (1024.0f * 1024.0f),
+			            static_cast<float>(attachment_allocator->get_naive_size()) / (1024.0f * 1024.0f));
+		}
 		if (drawer.checkbox("Skybox", &display_skybox))
 		{
 			build_command_buffers();
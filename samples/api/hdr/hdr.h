@@ -22,11 +22,13 @@
 #pragma once
 
 #include "api_vulkan_sample.h"
+#include "rendering/attachment_allocator.h"
 
 class HDR : public ApiVulkanSample
 {
   public:
 	bool bloom          = true;
+	bool compute_bloom  = false;
 	bool display_skybox = true;
 
 	struct
@@ -92,17 +94,15 @@ class HDR : public ApiVulkanSample
 	} descriptor_set_layouts;
 
 	// Framebuffer for offscreen rendering
+	// The image is owned by attachment_images
 	struct FrameBufferAttachment
 	{
-		VkImage        image;
-		VkDeviceMemory mem;
-		VkImageView    view;
-		VkFormat       format;
-		void           destroy(VkDevice device)
+		VkImage     image;
+		VkImageView view;
+		VkFormat    format;
+		void        destroy(VkDevice device)
 		{
 			vkDestroyImageView(device, view, nullptr);
-			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, mem, nullptr);
 		}
 	};
 	struct FrameBuffer
@@ -124,14 +124,52 @@ class HDR : public ApiVulkanSample
 		VkSampler             sampler;
 	} filter_pass;
 
+	// Places the offscreen and filter attachments, aliasing those used in disjoint passes
+	std::unique_ptr<vkb::AttachmentAllocator> attachment_allocator;
+	std::vector<vkb::core::Image>             attachment_images;
+
+	// Compute bloom on a downsample/upsample mip chain, one dispatch per level
+	static constexpr uint32_t MAX_BLOOM_LEVELS = 5;
+
+	struct
+	{
+		VkImage                      image;
+		VkDeviceMemory               mem;
+		VkFormat                     format;
+		uint32_t                     levels;
+		std::vector<VkExtent2D>      extents;
+		std::vector<VkImageView>     views;
+		VkSampler                    sampler;
+		VkDescriptorSetLayout        descriptor_set_layout;
+		VkPipelineLayout             pipeline_layout;
+		std::vector<VkDescriptorSet> downsample_sets;
+		std::vector<VkDescriptorSet> upsample_sets;
+		VkDescriptorSet              composition_set;
+		VkPipeline                   downsample;
+		VkPipeline                   upsample;
+		VkPipeline                   composite;
+	} bloom_chain;
+
+	// GPU timestamps around the bloom work, four per command buffer
+	struct
+	{
+		VkQueryPool query_pool = VK_NULL_HANDLE;
+		float       elapsed_ms = 0.0f;
+	} bloom_timing;
+
 	std::vector<std::string> object_names;
 
 	HDR();
 	~HDR();
 	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
 	void         build_command_buffers() override;
-	void         create_attachment(VkFormat format, VkImageUsageFlagBits usage, FrameBufferAttachment *attachment);
+	void         create_attachment(vkb::core::Image &image, FrameBufferAttachment *attachment);
 	void         prepare_offscreen_buffer();
+	void         prepare_bloom_chain();
+	void         prepare_bloom_timing();
+	void         record_compute_bloom(VkCommandBuffer command_buffer);
+	void         write_bloom_timestamp(VkCommandBuffer command_buffer, uint32_t buffer_index, uint32_t query);
+	void         get_bloom_timing();
 	void         load_assets();
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layout();
@@ -21,9 +21,17 @@
 
 #include "instancing.h"
 
+#include <limits>
+#include <unordered_map>
+
+#include "timer.h"
+
 Instancing::Instancing()
 {
 	title = "Instanced mesh rendering";
+
+	// The scene uniform buffers and descriptor sets are per swapchain image
+	serialize_frames = false;
 }
 
 Instancing::~Instancing()
@@ -33,10 +41,15 @@ Instancing::~Instancing()
 		vkDestroyPipeline(get_device().get_handle(), pipelines.instanced_rocks, nullptr);
 		vkDestroyPipeline(get_device().get_handle(), pipelines.planet, nullptr);
 		vkDestroyPipeline(get_device().get_handle(), pipelines.starfield, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), culling.pipeline, nullptr);
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layout, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), culling.pipeline_layout, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layout, nullptr);
-		vkDestroyBuffer(get_device().get_handle(), instance_buffer.buffer, nullptr);
-		vkFreeMemory(get_device().get_handle(), instance_buffer.memory, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), culling.descriptor_set_layout, nullptr);
+		if (query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(get_device().get_handle(), query_pool, nullptr);
+		}
 		vkDestroySampler(get_device().get_handle(), textures.rocks.sampler, nullptr);
 		vkDestroySampler(get_device().get_handle(), textures.planet.sampler, nullptr);
 	}
@@ -88,6 +101,51 @@ void Instancing::build_command_buffers()
 
 		VK_CHECK(vkBeginCommandBuffer(draw_cmd_buffers[i], &command_buffer_begin_info));
 
+		uint32_t first_query = 3 * static_cast<uint32_t>(i);
+		if (query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(draw_cmd_buffers[i], query_pool, first_query, 3);
+			vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, first_query);
+		}
+
+		if (gpu_culling)
+		{
+			// The draws and the statistics copy of the previous frame read the buffers rewritten by this frame
+			VkMemoryBarrier memory_barrier = vkb::initializers::memory_barrier();
+			vkCmdPipelineBarrier(draw_cmd_buffers[i], VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			                     VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+			// The culling counts the visible instances of each level of detail
+			std::array<VkDrawIndexedIndirectCommand, LOD_COUNT> draws{};
+			for (size_t lod = 0; lod < rock_lods.lods.size(); ++lod)
+			{
+				draws[lod].indexCount = rock_lods.lods[lod].index_count;
+				draws[lod].firstIndex = rock_lods.lods[lod].first_index;
+			}
+			vkCmdUpdateBuffer(draw_cmd_buffers[i], culling.draw_buffer->get_handle(), 0, sizeof(draws), draws.data());
+
+			memory_barrier               = vkb::initializers::memory_barrier();
+			memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(draw_cmd_buffers[i], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, culling.pipeline);
+			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, culling.pipeline_layout, 0, 1, &culling.descriptor_sets[i], 0, nullptr);
+			vkCmdDispatch(draw_cmd_buffers[i], (instance_count + 63) / 64, 1, 1);
+
+			// The visible instances and their counts are read by the draws
+			memory_barrier               = vkb::initializers::memory_barrier();
+			memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memory_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+			vkCmdPipelineBarrier(draw_cmd_buffers[i], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			                     0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+		}
+
+		if (query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, query_pool, first_query + 1);
+		}
+
 		vkCmdBeginRenderPass(draw_cmd_buffers[i], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
 		VkViewport viewport = vkb::initializers::viewport(static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f);
@@ -99,14 +157,14 @@ void Instancing::build_command_buffers()
 		VkDeviceSize offsets[1] = {0};
 
 		// Star field
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet, 0, NULL);
+		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet[i], 0, NULL);
 		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.starfield);
 		vkCmdDraw(draw_cmd_buffers[i], 4, 1, 0, 0);
 
 		// Planet
 		auto &planet_vertex_buffer = models.planet->vertex_buffers.at("vertex_buffer");
 		auto &planet_index_buffer  = models.planet->index_buffer;
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet, 0, NULL);
+		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet[i], 0, NULL);
 		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.planet);
 		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, planet_vertex_buffer.get(), offsets);
 		vkCmdBindIndexBuffer(draw_cmd_buffers[i], planet_index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
@@ -114,21 +172,54 @@ void Instancing::build_command_buffers()
 
 		// Instanced rocks
 		auto &rock_vertex_buffer = models.rock->vertex_buffers.at("vertex_buffer");
-		auto &rock_index_buffer  = models.rock->index_buffer;
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.instanced_rocks, 0, NULL);
+		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.instanced_rocks[i], 0, NULL);
 		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.instanced_rocks);
 		// Binding point 0 : Mesh vertex buffer
 		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, rock_vertex_buffer.get(), offsets);
-		// Binding point 1 : Instance data buffer
-		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 1, 1, &instance_buffer.buffer, offsets);
-		vkCmdBindIndexBuffer(draw_cmd_buffers[i], rock_index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
-		// Render instances
-		vkCmdDrawIndexed(draw_cmd_buffers[i], models.rock->vertex_indices, INSTANCE_COUNT, 0, 0, 0);
+		vkCmdBindIndexBuffer(draw_cmd_buffers[i], rock_lods.index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+		if (gpu_culling)
+		{
+			// One indirect draw per level of detail, with the visible instances of the level
+			for (uint32_t lod = 0; lod < vkb::to_u32(rock_lods.lods.size()); ++lod)
+			{
+				// Binding point 1 : Visible instances of the level
+				VkBuffer     culled_instances = culling.instance_buffer->get_handle();
+				VkDeviceSize region_offset    = lod * instance_buffer.size;
+				vkCmdBindVertexBuffers(draw_cmd_buffers[i], 1, 1, &culled_instances, &region_offset);
+				vkCmdDrawIndexedIndirect(draw_cmd_buffers[i], culling.draw_buffer->get_handle(), lod * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+			}
+		}
+		else
+		{
+			// Binding point 1 : Instance data buffer
+			VkBuffer instances = instance_buffer.buffer->get_handle();
+			vkCmdBindVertexBuffers(draw_cmd_buffers[i], 1, 1, &instances, offsets);
+			// Render instances
+			vkCmdDrawIndexed(draw_cmd_buffers[i], rock_lods.lods[0].index_count, instance_count, rock_lods.lods[0].first_index, 0, 0);
+		}
 
 		draw_ui(draw_cmd_buffers[i]);
 
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
+		if (gpu_culling)
+		{
+			// Keep the visible counts of the frame for the statistics
+			VkBufferCopy copy_region = {};
+			copy_region.size         = LOD_COUNT * sizeof(VkDrawIndexedIndirectCommand);
+			vkCmdCopyBuffer(draw_cmd_buffers[i], culling.draw_buffer->get_handle(), culling.statistics_buffers[i]->get_handle(), 1, &copy_region);
+
+			VkMemoryBarrier memory_barrier = vkb::initializers::memory_barrier();
+			memory_barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memory_barrier.dstAccessMask   = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(draw_cmd_buffers[i], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+		}
+
+		if (query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, first_query + 2);
+		}
+
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
 	}
 }
@@ -146,22 +237,118 @@ void Instancing::load_assets()
 
 	//textures.rocks.loadFromFile(getAssetPath() + "textures/texturearray_rocks_color_rgba.ktx", device.get(), queue);
 	//textures.planet.loadFromFile(getAssetPath() + "textures/lavaplanet_color_rgba.ktx", device.get(), queue);
+
+	generate_rock_lods();
+}
+
+void Instancing::generate_rock_lods()
+{
+	// The loader keeps no copy of the geometry, read it back from the GPU
+	auto &vertex_buffer = models.rock->vertex_buffers.at("vertex_buffer");
+	auto &index_buffer  = *models.rock->index_buffer;
+
+	vkb::core::Buffer vertex_readback{get_device(), vertex_buffer.get_size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU};
+	vkb::core::Buffer index_readback{get_device(), index_buffer.get_size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU};
+
+	VkCommandBuffer copy_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	VkBufferCopy copy_region = {};
+	copy_region.size         = vertex_buffer.get_size();
+	vkCmdCopyBuffer(copy_command, vertex_buffer.get_handle(), vertex_readback.get_handle(), 1, &copy_region);
+	copy_region.size = index_buffer.get_size();
+	vkCmdCopyBuffer(copy_command, index_buffer.get_handle(), index_readback.get_handle(), 1, &copy_region);
+
+	device->flush_command_buffer(copy_command, queue, true);
+
+	size_t vertex_count = vertex_buffer.get_size() / sizeof(Vertex);
+	auto  *vertices     = reinterpret_cast<const Vertex *>(vertex_readback.map());
+	auto  *indices      = reinterpret_cast<const uint32_t *>(index_readback.map());
+
+	glm::vec3 bounds_min{std::numeric_limits<float>::max()};
+	glm::vec3 bounds_max{std::numeric_limits<float>::lowest()};
+	rock_lods.radius = 0.0f;
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		bounds_min       = glm::min(bounds_min, vertices[i].pos);
+		bounds_max       = glm::max(bounds_max, vertices[i].pos);
+		rock_lods.radius = std::max(rock_lods.radius, glm::length(vertices[i].pos));
+	}
+	glm::vec3 extent = glm::max(bounds_max - bounds_min, glm::vec3(1e-6f));
+
+	// The coarser levels merge the vertices of each cell of a grid into the first one, and drop the
+	// triangles which become degenerate, so every level indexes the vertices of the model
+	const std::array<uint32_t, LOD_COUNT> grid_sizes{0, 12, 5};
+
+	std::vector<uint32_t> lod_indices;
+	rock_lods.lods.clear();
+	for (auto grid_size : grid_sizes)
+	{
+		Lod lod{vkb::to_u32(lod_indices.size()), 0};
+
+		if (grid_size == 0)
+		{
+			lod_indices.insert(lod_indices.end(), indices, indices + models.rock->vertex_indices);
+		}
+		else
+		{
+			std::unordered_map<uint32_t, uint32_t> cell_vertices;
+			std::vector<uint32_t>                  remap(vertex_count);
+			for (size_t i = 0; i < vertex_count; ++i)
+			{
+				glm::uvec3 cell = glm::min(glm::uvec3((vertices[i].pos - bounds_min) / extent * static_cast<float>(grid_size)), glm::uvec3(grid_size - 1));
+				uint32_t   key  = cell.x + grid_size * (cell.y + grid_size * cell.z);
+				remap[i]        = cell_vertices.emplace(key, vkb::to_u32(i)).first->second;
+			}
+
+			for (uint32_t i = 0; i + 2 < models.rock->vertex_indices; i += 3)
+			{
+				uint32_t a = remap[indices[i]];
+				uint32_t b = remap[indices[i + 1]];
+				uint32_t c = remap[indices[i + 2]];
+				if (a != b && b != c && a != c)
+				{
+					lod_indices.insert(lod_indices.end(), {a, b, c});
+				}
+			}
+		}
+
+		lod.index_count = vkb::to_u32(lod_indices.size()) - lod.first_index;
+		rock_lods.lods.push_back(lod);
+		LOGI("Rock level of detail {}: {} triangles", rock_lods.lods.size() - 1, lod.index_count / 3);
+	}
+
+	vertex_readback.unmap();
+	index_readback.unmap();
+
+	vkb::core::Buffer staging_buffer{get_device(), lod_indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+	staging_buffer.update(reinterpret_cast<const uint8_t *>(lod_indices.data()), lod_indices.size() * sizeof(uint32_t));
+
+	rock_lods.index_buffer = std::make_unique<vkb::core::Buffer>(get_device(), lod_indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+	copy_command     = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	copy_region.size = lod_indices.size() * sizeof(uint32_t);
+	vkCmdCopyBuffer(copy_command, staging_buffer.get_handle(), rock_lods.index_buffer->get_handle(), 1, &copy_region);
+	device->flush_command_buffer(copy_command, queue, true);
 }
 
 void Instancing::setup_descriptor_pool()
 {
-	// Example uses one ubo
+	// Example uses one ubo per swapchain image, with two sets each, and one culling set with a ubo and three storage buffers
+	const uint32_t image_count = vkb::to_u32(draw_cmd_buffers.size());
+	const uint32_t set_count   = 2 * image_count;
+
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, set_count + image_count),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * image_count),
 	    };
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
 	    vkb::initializers::descriptor_pool_create_info(
 	        vkb::to_u32(pool_sizes.size()),
 	        pool_sizes.data(),
-	        2);
+	        set_count + image_count);
 
 	VK_CHECK(vkCreateDescriptorPool(get_device().get_handle(), &descriptor_pool_create_info, nullptr, &descriptor_pool));
 }
@@ -195,6 +382,25 @@ void Instancing::setup_descriptor_set_layout()
 	        1);
 
 	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &pipeline_layout));
+
+	// Culling pre-pass
+	set_layout_bindings =
+	    {
+	        // Binding 0 : Culling uniform buffer
+	        vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+	        // Binding 1 : All instances
+	        vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+	        // Binding 2 : Visible instances of each level of detail
+	        vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2),
+	        // Binding 3 : Indirect draws of each level of detail
+	        vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 3),
+	    };
+
+	descriptor_layout_create_info = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), vkb::to_u32(set_layout_bindings.size()));
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout_create_info, nullptr, &culling.descriptor_set_layout));
+
+	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&culling.descriptor_set_layout, 1);
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &culling.pipeline_layout));
 }
 
 void Instancing::setup_descriptor_set()
@@ -204,25 +410,59 @@ void Instancing::setup_descriptor_set()
 
 	descriptor_set_alloc_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &descriptor_set_layout, 1);
 
-	// Instanced rocks
-	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*uniform_buffers.scene);
-	VkDescriptorImageInfo  image_descriptor  = create_descriptor(textures.rocks);
-	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_alloc_info, &descriptor_sets.instanced_rocks));
-	write_descriptor_sets = {
-	    vkb::initializers::write_descriptor_set(descriptor_sets.instanced_rocks, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &buffer_descriptor),              // Binding 0 : Vertex shader uniform buffer
-	    vkb::initializers::write_descriptor_set(descriptor_sets.instanced_rocks, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &image_descriptor)        // Binding 1 : Color map
-	};
-	vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
-
-	// Planet
-	buffer_descriptor = create_descriptor(*uniform_buffers.scene);
-	image_descriptor  = create_descriptor(textures.planet);
-	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_alloc_info, &descriptor_sets.planet));
-	write_descriptor_sets = {
-	    vkb::initializers::write_descriptor_set(descriptor_sets.planet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &buffer_descriptor),              // Binding 0 : Vertex shader uniform buffer
-	    vkb::initializers::write_descriptor_set(descriptor_sets.planet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &image_descriptor)        // Binding 1 : Color map
-	};
-	vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+	descriptor_sets.instanced_rocks.resize(uniform_buffers.scene.size());
+	descriptor_sets.planet.resize(uniform_buffers.scene.size());
+
+	for (size_t i = 0; i < uniform_buffers.scene.size(); ++i)
+	{
+		// Instanced rocks
+		VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*uniform_buffers.scene[i]);
+		VkDescriptorImageInfo  image_descriptor  = create_descriptor(textures.rocks);
+		VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_alloc_info, &descriptor_sets.instanced_rocks[i]));
+		write_descriptor_sets = {
+		    vkb::initializers::write_descriptor_set(descriptor_sets.instanced_rocks[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &buffer_descriptor),              // Binding 0 : Vertex shader uniform buffer
+		    vkb::initializers::write_descriptor_set(descriptor_sets.instanced_rocks[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &image_descriptor)        // Binding 1 : Color map
+		};
+		vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+
+		// Planet
+		image_descriptor = create_descriptor(textures.planet);
+		VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_alloc_info, &descriptor_sets.planet[i]));
+		write_descriptor_sets = {
+		    vkb::initializers::write_descriptor_set(descriptor_sets.planet[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &buffer_descriptor),              // Binding 0 : Vertex shader uniform buffer
+		    vkb::initializers::write_descriptor_set(descriptor_sets.planet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &image_descriptor)        // Binding 1 : Color map
+		};
+		vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+	}
+
+	descriptor_set_alloc_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &culling.descriptor_set_layout, 1);
+
+	culling.descriptor_sets.resize(uniform_buffers.culling.size());
+	for (auto &descriptor_set : culling.descriptor_sets)
+	{
+		VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_alloc_info, &descriptor_set));
+	}
+
+	update_culling_descriptor_sets();
+}
+
+void Instancing::update_culling_descriptor_sets()
+{
+	VkDescriptorBufferInfo instance_descriptor = create_descriptor(*instance_buffer.buffer);
+	VkDescriptorBufferInfo culled_descriptor   = create_descriptor(*culling.instance_buffer);
+	VkDescriptorBufferInfo draw_descriptor     = create_descriptor(*culling.draw_buffer);
+
+	for (size_t i = 0; i < culling.descriptor_sets.size(); ++i)
+	{
+		VkDescriptorBufferInfo uniform_descriptor = create_descriptor(*uniform_buffers.culling[i]);
+
+		std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
+		    vkb::initializers::write_descriptor_set(culling.descriptor_sets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniform_descriptor),
+		    vkb::initializers::write_descriptor_set(culling.descriptor_sets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &instance_descriptor),
+		    vkb::initializers::write_descriptor_set(culling.descriptor_sets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &culled_descriptor),
+		    vkb::initializers::write_descriptor_set(culling.descriptor_sets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, &draw_descriptor)};
+		vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+	}
 }
 
 void Instancing::prepare_pipelines()
@@ -357,19 +597,24 @@ void Instancing::prepare_pipelines()
 	input_state.vertexBindingDescriptionCount   = 0;
 	input_state.vertexAttributeDescriptionCount = 0;
 	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.starfield));
+
+	// Culling pipeline
+	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(culling.pipeline_layout, 0);
+	compute_pipeline_create_info.stage                       = load_shader("instancing/cull.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &culling.pipeline));
 }
 
 void Instancing::prepare_instance_data()
 {
 	std::vector<InstanceData> instance_data;
-	instance_data.resize(INSTANCE_COUNT);
+	instance_data.resize(instance_count);
 
 	std::default_random_engine              rnd_generator(is_benchmark_mode() ? 0 : (unsigned) time(nullptr));
 	std::uniform_real_distribution<float>   uniform_dist(0.0, 1.0);
 	std::uniform_int_distribution<uint32_t> rnd_texture_index(0, textures.rocks.image->get_vk_image().get_array_layer_count());
 
 	// Distribute rocks randomly on two different rings
-	for (auto i = 0; i < INSTANCE_COUNT / 2; i++)
+	for (uint32_t i = 0; i < instance_count / 2; i++)
 	{
 		glm::vec2 ring0{7.0f, 11.0f};
 		glm::vec2 ring1{14.0f, 18.0f};
@@ -388,11 +633,11 @@ void Instancing::prepare_instance_data()
 		// Outer ring
 		rho                                                                 = sqrt((pow(ring1[1], 2.0f) - pow(ring1[0], 2.0f)) * uniform_dist(rnd_generator) + pow(ring1[0], 2.0f));
 		theta                                                               = 2.0f * glm::pi<float>() * uniform_dist(rnd_generator);
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].pos      = glm::vec3(rho * cos(theta), uniform_dist(rnd_generator) * 0.5f - 0.25f, rho * sin(theta));
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].rot      = glm::vec3(glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator));
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].scale    = 1.5f + uniform_dist(rnd_generator) - uniform_dist(rnd_generator);
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].texIndex = rnd_texture_index(rnd_generator);
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].scale *= 0.75f;
+		instance_data[static_cast<size_t>(i + instance_count / 2)].pos      = glm::vec3(rho * cos(theta), uniform_dist(rnd_generator) * 0.5f - 0.25f, rho * sin(theta));
+		instance_data[static_cast<size_t>(i + instance_count / 2)].rot      = glm::vec3(glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator));
+		instance_data[static_cast<size_t>(i + instance_count / 2)].scale    = 1.5f + uniform_dist(rnd_generator) - uniform_dist(rnd_generator);
+		instance_data[static_cast<size_t>(i + instance_count / 2)].texIndex = rnd_texture_index(rnd_generator);
+		instance_data[static_cast<size_t>(i + instance_count / 2)].scale *= 0.75f;
 	}
 
 	instance_buffer.size = instance_data.size() * sizeof(InstanceData);
@@ -401,25 +646,14 @@ void Instancing::prepare_instance_data()
 	// Instanced data is static, copy to device local memory
 	// On devices with separate memory types for host visible and device local memory this will result in better performance
 	// On devices with unified memory types (DEVICE_LOCAL_BIT and HOST_VISIBLE_BIT supported at once) this isn't necessary and you could skip the staging
+	vkb::core::Buffer staging_buffer{get_device(), instance_buffer.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+	staging_buffer.update(reinterpret_cast<const uint8_t *>(instance_data.data()), instance_buffer.size);
 
-	struct
-	{
-		VkDeviceMemory memory;
-		VkBuffer       buffer;
-	} staging_buffer;
-
-	staging_buffer.buffer = get_device().create_buffer(
-	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	    instance_buffer.size,
-	    &staging_buffer.memory,
-	    instance_data.data());
-
-	instance_buffer.buffer = get_device().create_buffer(
-	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-	    instance_buffer.size,
-	    &instance_buffer.memory);
+	// The instances are also read by the culling pre-pass
+	instance_buffer.buffer = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                             instance_buffer.size,
+	                                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                             VMA_MEMORY_USAGE_GPU_ONLY);
 
 	// Copy to staging buffer
 	VkCommandBuffer copy_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -428,30 +662,53 @@ void Instancing::prepare_instance_data()
 	copy_region.size         = instance_buffer.size;
 	vkCmdCopyBuffer(
 	    copy_command,
-	    staging_buffer.buffer,
-	    instance_buffer.buffer,
+	    staging_buffer.get_handle(),
+	    instance_buffer.buffer->get_handle(),
 	    1,
 	    &copy_region);
 
 	device->flush_command_buffer(copy_command, queue, true);
 
-	instance_buffer.descriptor.range  = instance_buffer.size;
-	instance_buffer.descriptor.buffer = instance_buffer.buffer;
-	instance_buffer.descriptor.offset = 0;
-
-	// Destroy staging resources
-	vkDestroyBuffer(get_device().get_handle(), staging_buffer.buffer, nullptr);
-	vkFreeMemory(get_device().get_handle(), staging_buffer.memory, nullptr);
+	// Every level of detail can hold all the instances
+	culling.instance_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                              LOD_COUNT * instance_buffer.size,
+	                                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                              VMA_MEMORY_USAGE_GPU_ONLY);
+	culling.draw_buffer     = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                              LOD_COUNT * sizeof(VkDrawIndexedIndirectCommand),
+	                                                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                              VMA_MEMORY_USAGE_GPU_ONLY);
+
+	culling.statistics_buffers.resize(draw_cmd_buffers.size());
+	for (auto &statistics_buffer : culling.statistics_buffers)
+	{
+		statistics_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                                        LOD_COUNT * sizeof(VkDrawIndexedIndirectCommand),
+		                                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                                                        VMA_MEMORY_USAGE_GPU_TO_CPU);
+	}
+	visible_instances = {};
 }
 
 void Instancing::prepare_uniform_buffers()
 {
-	uniform_buffers.scene = std::make_unique<vkb::core::Buffer>(get_device(),
-	                                                            sizeof(ubo_vs),
-	                                                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+	uniform_buffers.scene.resize(draw_cmd_buffers.size());
+	for (auto &scene : uniform_buffers.scene)
+	{
+		scene = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                            sizeof(ubo_vs),
+		                                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
 
-	update_uniform_buffer(0.0f);
+	uniform_buffers.culling.resize(draw_cmd_buffers.size());
+	for (auto &culling : uniform_buffers.culling)
+	{
+		culling = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                              sizeof(ubo_culling),
+		                                              VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		                                              VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
 }
 
 void Instancing::update_uniform_buffer(float delta_time)
@@ -465,19 +722,70 @@ void Instancing::update_uniform_buffer(float delta_time)
 		ubo_vs.glob_speed += delta_time * 0.01f;
 	}
 
-	uniform_buffers.scene->convert_and_update(ubo_vs);
+	uniform_buffers.scene[current_buffer]->convert_and_update(ubo_vs);
+
+	// Side planes of the clip space, the near and far planes are left out as the depth is reversed
+	glm::mat4 view_projection = camera.matrices.perspective * camera.matrices.view;
+	for (int i = 0; i < 4; ++i)
+	{
+		int       axis  = i / 2;
+		float     sign  = (i % 2 == 0) ? 1.0f : -1.0f;
+		glm::vec4 plane = glm::vec4(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]) +
+		                  sign * glm::vec4(view_projection[0][axis], view_projection[1][axis], view_projection[2][axis], view_projection[3][axis]);
+
+		ubo_culling.planes[i] = plane / glm::length(glm::vec3(plane));
+	}
+
+	ubo_culling.camera_position = glm::inverse(camera.matrices.view)[3];
+	ubo_culling.lod_distances   = lod_selection ? glm::vec4(lod_distance, 2.0f * lod_distance, 0.0f, 0.0f) : glm::vec4(std::numeric_limits<float>::max());
+	ubo_culling.glob_speed      = ubo_vs.glob_speed;
+	ubo_culling.radius          = rock_lods.radius;
+	ubo_culling.instance_count  = instance_count;
+	ubo_culling.lod_count       = vkb::to_u32(rock_lods.lods.size());
+
+	uniform_buffers.culling[current_buffer]->convert_and_update(ubo_culling);
 }
 
-void Instancing::draw()
+void Instancing::read_statistics()
 {
-	ApiVulkanSample::prepare_frame();
+	// The last frame of the acquired image has completed, if the image was drawn since the command buffers were built
+	if (submitted_frames < draw_cmd_buffers.size())
+	{
+		return;
+	}
+
+	if (gpu_culling)
+	{
+		auto *draws = reinterpret_cast<const VkDrawIndexedIndirectCommand *>(culling.statistics_buffers[current_buffer]->map());
+		for (uint32_t lod = 0; lod < LOD_COUNT; ++lod)
+		{
+			visible_instances[lod] = draws[lod].instanceCount;
+		}
+		culling.statistics_buffers[current_buffer]->unmap();
+	}
 
+	if (query_pool != VK_NULL_HANDLE)
+	{
+		std::array<uint64_t, 3> timestamps{};
+		if (vkGetQueryPoolResults(get_device().get_handle(), query_pool, 3 * current_buffer, 3,
+		                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			float period    = get_device().get_gpu().get_properties().limits.timestampPeriod;
+			culling_time_ms = static_cast<float>(timestamps[1] - timestamps[0]) * period / 1000000.0f;
+			drawing_time_ms = static_cast<float>(timestamps[2] - timestamps[1]) * period / 1000000.0f;
+		}
+	}
+}
+
+void Instancing::draw()
+{
 	// Command buffer to be sumitted to the queue
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
 
 	// Submit to queue
 	VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE));
+	submitted_frames++;
 
 	ApiVulkanSample::submit_frame();
 }
@@ -495,6 +803,16 @@ bool Instancing::prepare(vkb::Platform &platform)
 	camera.set_rotation(glm::vec3(-17.2f, -4.7f, 0.0f));
 	camera.set_translation(glm::vec3(5.5f, -1.85f, -18.5f));
 
+	// Timestamps around the culling and the drawing, if the queue supports them
+	if (get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0).get_properties().timestampValidBits != 0)
+	{
+		VkQueryPoolCreateInfo query_pool_info = {};
+		query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		query_pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount            = 3 * vkb::to_u32(draw_cmd_buffers.size());
+		VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, nullptr, &query_pool));
+	}
+
 	load_assets();
 	prepare_instance_data();
 	prepare_uniform_buffers();
@@ -513,18 +831,67 @@ void Instancing::render(float delta_time)
 	{
 		return;
 	}
+	vkb::Timer timer;
+	timer.start();
+
+	ApiVulkanSample::prepare_frame();
+
+	// The buffer of the acquired image is no longer read by the GPU, the others may still be
+	read_statistics();
+	update_uniform_buffer(delta_time);
+
 	draw();
-	if (!paused || camera.updated)
-	{
-		update_uniform_buffer(delta_time);
-	}
+
+	cpu_time_ms = static_cast<float>(timer.stop<vkb::Timer::Milliseconds>());
 }
 
 void Instancing::on_update_ui_overlay(vkb::Drawer &drawer)
 {
+	if (drawer.header("Settings"))
+	{
+		std::vector<std::string> count_names;
+		for (auto count : instance_counts)
+		{
+			count_names.push_back(std::to_string(count));
+		}
+
+		bool rebuild = drawer.combo_box("Instances", &instance_count_index, count_names);
+		rebuild |= drawer.checkbox("GPU culling", &gpu_culling);
+		if (rebuild)
+		{
+			// The buffers are in use by the frames in flight
+			vkDeviceWaitIdle(get_device().get_handle());
+			instance_count = instance_counts[instance_count_index];
+			prepare_instance_data();
+			update_culling_descriptor_sets();
+			build_command_buffers();
+			submitted_frames = 0;
+		}
+		if (gpu_culling)
+		{
+			drawer.checkbox("Level of detail", &lod_selection);
+			if (lod_selection)
+			{
+				drawer.slider_float("LOD distance", &lod_distance, 2.0f, 40.0f);
+			}
+		}
+	}
 	if (drawer.header("Statistics"))
 	{
-		drawer.text("Instances: %d", INSTANCE_COUNT);
+		drawer.text("Instances: %u", instance_count);
+		if (gpu_culling)
+		{
+			for (uint32_t lod = 0; lod < vkb::to_u32(rock_lods.lods.size()); ++lod)
+			{
+				drawer.text("LOD %u: %u visible, %u triangles each", lod, visible_instances[lod], rock_lods.lods[lod].index_count / 3);
+			}
+		}
+		drawer.text("CPU time: %.3f ms", cpu_time_ms);
+		if (query_pool != VK_NULL_HANDLE)
+		{
+			drawer.text("Culling GPU time: %.3f ms", culling_time_ms);
+			drawer.text("Drawing GPU time: %.3f ms", drawing_time_ms);
+		}
 	}
 }
 
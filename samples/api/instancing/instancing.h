@@ -17,6 +17,8 @@
 
 /*
  * Instanced mesh rendering, uses a separate vertex buffer for instanced data
+ * A compute pre-pass culls the instances against the view frustum and selects their level of detail,
+ * writing the visible instances and the indirect draw of each level
  */
 
 #pragma once
@@ -29,6 +31,9 @@
 #	define INSTANCE_COUNT 8192
 #endif
 
+// Levels of detail of the rock model, generated at load time
+#define LOD_COUNT 3
+
 class Instancing : public ApiVulkanSample
 {
   public:
@@ -55,12 +60,53 @@ class Instancing : public ApiVulkanSample
 	// Contains the instanced data
 	struct InstanceBuffer
 	{
-		VkBuffer               buffer = VK_NULL_HANDLE;
-		VkDeviceMemory         memory = VK_NULL_HANDLE;
-		size_t                 size   = 0;
-		VkDescriptorBufferInfo descriptor;
+		std::unique_ptr<vkb::core::Buffer> buffer;
+		size_t                             size = 0;
 	} instance_buffer;
 
+	// Index range of a level of detail, all levels share the vertices of the rock model
+	struct Lod
+	{
+		uint32_t first_index;
+		uint32_t index_count;
+	};
+
+	struct RockLods
+	{
+		std::vector<Lod>                   lods;
+		std::unique_ptr<vkb::core::Buffer> index_buffer;
+		// Bounding sphere of the model, around its origin
+		float radius = 1.0f;
+	} rock_lods;
+
+	// Resources of the culling pre-pass
+	struct Culling
+	{
+		// Visible instances, in one region of the instance count per level of detail
+		std::unique_ptr<vkb::core::Buffer> instance_buffer;
+		// One VkDrawIndexedIndirectCommand per level of detail
+		std::unique_ptr<vkb::core::Buffer> draw_buffer;
+		// Copies of the draws per swapchain image, read back for the statistics
+		std::vector<std::unique_ptr<vkb::core::Buffer>> statistics_buffers;
+		VkDescriptorSetLayout                           descriptor_set_layout;
+		std::vector<VkDescriptorSet>                    descriptor_sets;
+		VkPipelineLayout                                pipeline_layout;
+		VkPipeline                                      pipeline;
+	} culling;
+
+	struct UBOCulling
+	{
+		// Side planes of the view frustum in world space
+		glm::vec4 planes[4];
+		glm::vec4 camera_position;
+		// Distances at which the levels of detail 1 and 2 start
+		glm::vec4 lod_distances;
+		float     glob_speed;
+		float     radius;
+		uint32_t  instance_count;
+		uint32_t  lod_count;
+	} ubo_culling;
+
 	struct UBOVS
 	{
 		glm::mat4 projection;
@@ -70,11 +116,34 @@ class Instancing : public ApiVulkanSample
 		float     glob_speed = 0.0f;
 	} ubo_vs;
 
+	// One scene buffer per swapchain image, so that a frame in flight is not overwritten
 	struct UniformBuffers
 	{
-		std::unique_ptr<vkb::core::Buffer> scene;
+		std::vector<std::unique_ptr<vkb::core::Buffer>> scene;
+		std::vector<std::unique_ptr<vkb::core::Buffer>> culling;
 	} uniform_buffers;
 
+	// Three timestamps per swapchain image: before and after the culling, after the render pass
+	VkQueryPool query_pool = VK_NULL_HANDLE;
+
+	// Instance counts selectable from the UI
+	const std::vector<uint32_t> instance_counts{INSTANCE_COUNT, 65536, 262144, 1048576};
+
+	int32_t  instance_count_index = 0;
+	uint32_t instance_count       = INSTANCE_COUNT;
+	bool     gpu_culling          = true;
+	bool     lod_selection        = true;
+	float    lod_distance         = 12.0f;
+
+	// Statistics of the last completed frame of the acquired swapchain image
+	std::array<uint32_t, LOD_COUNT> visible_instances{};
+	float                           cpu_time_ms     = 0.0f;
+	float                           culling_time_ms = 0.0f;
+	float                           drawing_time_ms = 0.0f;
+
+	// Frames submitted since the command buffers were built, the statistics of an image are valid once it was drawn
+	size_t submitted_frames = 0;
+
 	VkPipelineLayout pipeline_layout;
 	struct Pipelines
 	{
@@ -86,8 +155,8 @@ class Instancing : public ApiVulkanSample
 	VkDescriptorSetLayout descriptor_set_layout;
 	struct DescriptorSets
 	{
-		VkDescriptorSet instanced_rocks;
-		VkDescriptorSet planet;
+		std::vector<VkDescriptorSet> instanced_rocks;
+		std::vector<VkDescriptorSet> planet;
 	} descriptor_sets;
 
 	Instancing();
@@ -95,13 +164,16 @@ class Instancing : public ApiVulkanSample
 	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
 	void         build_command_buffers() override;
 	void         load_assets();
+	void         generate_rock_lods();
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layout();
 	void         setup_descriptor_set();
+	void         update_culling_descriptor_sets();
 	void         prepare_pipelines();
 	void         prepare_instance_data();
 	void         prepare_uniform_buffers();
 	void         update_uniform_buffer(float delta_time);
+	void         read_statistics();
 	void         draw();
 	bool         prepare(vkb::Platform &platform) override;
 	virtual void render(float delta_time) override;
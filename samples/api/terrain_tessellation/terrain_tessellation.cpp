@@ -39,13 +39,21 @@ TerrainTessellation::~TerrainTessellation()
 		{
 			vkDestroyPipeline(get_device().get_handle(), pipelines.wireframe, nullptr);
 		}
+		vkDestroyPipeline(get_device().get_handle(), pipelines.terrain_culled, nullptr);
+		if (pipelines.wireframe_culled != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(get_device().get_handle(), pipelines.wireframe_culled, nullptr);
+		}
 		vkDestroyPipeline(get_device().get_handle(), pipelines.skysphere, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), pipelines.cull, nullptr);
 
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layouts.skysphere, nullptr);
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layouts.terrain, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layouts.cull, nullptr);
 
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layouts.terrain, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layouts.skysphere, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layouts.cull, nullptr);
 
 		uniform_buffers.skysphere_vertex.reset();
 		uniform_buffers.terrain_tessellation.reset();
@@ -148,6 +156,15 @@ void TerrainTessellation::get_query_results()
 	    VK_QUERY_RESULT_64_BIT);
 }
 
+// Retrieves the statistics of the last frame culled on the GPU
+void TerrainTessellation::get_culling_results()
+{
+	const uint8_t *data = terrain.draw_args_readback->map();
+	terrain.draw_args_readback->invalidate();
+	memcpy(&culling_stats, data, sizeof(DrawArgs));
+	terrain.draw_args_readback->unmap();
+}
+
 void TerrainTessellation::load_assets()
 {
 	// @todo: sascha
@@ -230,6 +247,11 @@ void TerrainTessellation::build_command_buffers()
 			vkCmdResetQueryPool(draw_cmd_buffers[i], query_pool, 0, 2);
 		}
 
+		if (gpu_culling)
+		{
+			record_culling(draw_cmd_buffers[i]);
+		}
+
 		vkCmdBeginRenderPass(draw_cmd_buffers[i], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
 		VkViewport viewport = vkb::initializers::viewport((float) width, (float) height, 0.0f, 1.0f);
@@ -254,11 +276,21 @@ void TerrainTessellation::build_command_buffers()
 			vkCmdBeginQuery(draw_cmd_buffers[i], query_pool, 0, 0);
 		}
 		// Render
-		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.terrain);
 		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.terrain, 0, 1, &descriptor_sets.terrain, 0, NULL);
 		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, terrain.vertices->get(), offsets);
-		vkCmdBindIndexBuffer(draw_cmd_buffers[i], terrain.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(draw_cmd_buffers[i], terrain.index_count, 1, 0, 0, 0);
+		if (gpu_culling)
+		{
+			// Only the visible patches written by the culling shader are drawn
+			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe_culled : pipelines.terrain_culled);
+			vkCmdBindIndexBuffer(draw_cmd_buffers[i], terrain.culled_indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexedIndirect(draw_cmd_buffers[i], terrain.draw_args->get_handle(), 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.terrain);
+			vkCmdBindIndexBuffer(draw_cmd_buffers[i], terrain.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexed(draw_cmd_buffers[i], terrain.index_count, 1, 0, 0, 0);
+		}
 		if (get_device().get_gpu().get_features().pipelineStatisticsQuery)
 		{
 			// End pipeline statistics query
@@ -269,6 +301,23 @@ void TerrainTessellation::build_command_buffers()
 
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
+		if (gpu_culling)
+		{
+			// Copy the culling statistics for the overlay of the next frame
+			VkBufferCopy copy_region = {0, 0, sizeof(DrawArgs)};
+			vkCmdCopyBuffer(draw_cmd_buffers[i], terrain.draw_args->get_handle(), terrain.draw_args_readback->get_handle(), 1, &copy_region);
+
+			VkBufferMemoryBarrier barrier = vkb::initializers::buffer_memory_barrier();
+			barrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask         = VK_ACCESS_HOST_READ_BIT;
+			barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer                = terrain.draw_args_readback->get_handle();
+			barrier.offset                = 0;
+			barrier.size                  = VK_WHOLE_SIZE;
+			vkCmdPipelineBarrier(draw_cmd_buffers[i], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+		}
+
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
 	}
 }
@@ -344,14 +393,33 @@ void TerrainTessellation::generate_terrain()
 	}
 	terrain.index_count = index_count;
 
+	// Patch bounds for the GPU culling, with the range of heights the evaluation shader displaces them by
+	terrain.patch_count = w * w;
+	Patch *patches      = new Patch[terrain.patch_count];
+	for (auto x = 0; x < w; x++)
+	{
+		for (auto y = 0; y < w; y++)
+		{
+			Patch &patch       = patches[x + y * w];
+			patch.first_vertex = x + y * PATCH_SIZE;
+
+			const glm::vec3 &first_corner = vertices[patch.first_vertex].pos;
+			const glm::vec3 &last_corner  = vertices[patch.first_vertex + PATCH_SIZE + 1].pos;
+			patch.bounds                  = glm::vec4(first_corner.x, first_corner.z, last_corner.x, last_corner.z);
+
+			heightmap.get_height_range(x, y, patch.heights.x, patch.heights.y);
+		}
+	}
+
 	uint32_t vertex_buffer_size = vertex_count * sizeof(Vertex);
 	uint32_t index_buffer_size  = index_count * sizeof(uint32_t);
+	uint32_t patch_buffer_size  = terrain.patch_count * sizeof(Patch);
 
 	struct
 	{
 		VkBuffer       buffer;
 		VkDeviceMemory memory;
-	} vertex_staging, index_staging;
+	} vertex_staging, index_staging, patch_staging;
 
 	// Create staging buffers
 
@@ -369,6 +437,13 @@ void TerrainTessellation::generate_terrain()
 	    &index_staging.memory,
 	    indices);
 
+	patch_staging.buffer = get_device().create_buffer(
+	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	    patch_buffer_size,
+	    &patch_staging.memory,
+	    patches);
+
 	terrain.vertices = std::make_unique<vkb::core::Buffer>(get_device(),
 	                                                       vertex_buffer_size,
 	                                                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -379,6 +454,33 @@ void TerrainTessellation::generate_terrain()
 	                                                      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 	                                                      VMA_MEMORY_USAGE_GPU_ONLY);
 
+	terrain.patches = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                      patch_buffer_size,
+	                                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                      VMA_MEMORY_USAGE_GPU_ONLY);
+
+	// Written by the culling shader every frame
+	terrain.culled_indices = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                             index_buffer_size,
+	                                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+	                                                             VMA_MEMORY_USAGE_GPU_ONLY);
+
+	terrain.patch_levels = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                           terrain.patch_count * 2 * sizeof(glm::vec4),
+	                                                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                           VMA_MEMORY_USAGE_GPU_ONLY);
+
+	terrain.draw_args = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                        sizeof(DrawArgs),
+	                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                        VMA_MEMORY_USAGE_GPU_ONLY);
+
+	terrain.draw_args_readback = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                                 sizeof(DrawArgs),
+	                                                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                                 VMA_MEMORY_USAGE_GPU_TO_CPU);
+	terrain.draw_args_readback->convert_and_update(culling_stats);
+
 	// Copy from staging buffers
 	VkCommandBuffer copy_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 
@@ -400,29 +502,77 @@ void TerrainTessellation::generate_terrain()
 	    1,
 	    &copy_region);
 
+	copy_region.size = patch_buffer_size;
+	vkCmdCopyBuffer(
+	    copy_command,
+	    patch_staging.buffer,
+	    terrain.patches->get_handle(),
+	    1,
+	    &copy_region);
+
 	device->flush_command_buffer(copy_command, queue, true);
 
 	vkDestroyBuffer(get_device().get_handle(), vertex_staging.buffer, nullptr);
 	vkFreeMemory(get_device().get_handle(), vertex_staging.memory, nullptr);
 	vkDestroyBuffer(get_device().get_handle(), index_staging.buffer, nullptr);
 	vkFreeMemory(get_device().get_handle(), index_staging.memory, nullptr);
+	vkDestroyBuffer(get_device().get_handle(), patch_staging.buffer, nullptr);
+	vkFreeMemory(get_device().get_handle(), patch_staging.memory, nullptr);
 
 	delete[] vertices;
 	delete[] indices;
+	delete[] patches;
+}
+
+// Culls the patches against the frustum and selects their tessellation levels,
+// writing the indices and levels of the visible patches and the indirect draw arguments
+void TerrainTessellation::record_culling(VkCommandBuffer command_buffer)
+{
+	DrawArgs draw_args{};
+	draw_args.command.instanceCount = 1;
+	vkCmdUpdateBuffer(command_buffer, terrain.draw_args->get_handle(), 0, sizeof(DrawArgs), &draw_args);
+
+	VkBufferMemoryBarrier barrier = vkb::initializers::buffer_memory_barrier();
+	barrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask         = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer                = terrain.draw_args->get_handle();
+	barrier.offset                = 0;
+	barrier.size                  = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines.cull);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layouts.cull, 0, 1, &descriptor_sets.cull, 0, nullptr);
+
+	uint32_t push_constants[2] = {terrain.patch_count, PATCH_SIZE};
+	vkCmdPushConstants(command_buffer, pipeline_layouts.cull, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), push_constants);
+
+	vkCmdDispatch(command_buffer, (terrain.patch_count + 63) / 64, 1, 1);
+
+	// The draw reads the arguments, indices and levels, and the statistics are copied after it
+	VkMemoryBarrier memory_barrier = vkb::initializers::memory_barrier();
+	memory_barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask   = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(command_buffer,
+	                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                     0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
 }
 
 void TerrainTessellation::setup_descriptor_pool()
 {
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3),
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3)};
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5)};
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
 	    vkb::initializers::descriptor_pool_create_info(
 	        static_cast<uint32_t>(pool_sizes.size()),
 	        pool_sizes.data(),
-	        2);
+	        3);
 
 	VK_CHECK(vkCreateDescriptorPool(get_device().get_handle(), &descriptor_pool_create_info, nullptr, &descriptor_pool));
 }
@@ -451,6 +601,11 @@ void TerrainTessellation::setup_descriptor_set_layouts()
 	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 	            VK_SHADER_STAGE_FRAGMENT_BIT,
 	            2),
+	        // Binding 3 : Tessellation levels of the GPU culled patches
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+	            3),
 	    };
 
 	descriptor_layout = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), static_cast<uint32_t>(set_layout_bindings.size()));
@@ -477,6 +632,46 @@ void TerrainTessellation::setup_descriptor_set_layouts()
 	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout, nullptr, &descriptor_set_layouts.skysphere));
 	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&descriptor_set_layouts.skysphere, 1);
 	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &pipeline_layouts.skysphere));
+
+	// Patch culling
+	set_layout_bindings =
+	    {
+	        // Binding 0 : Shared tessellation shader ubo
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            0),
+	        // Binding 1 : Patch bounds
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            1),
+	        // Binding 2 : Indirect draw arguments
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            2),
+	        // Binding 3 : Indices of the visible patches
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            3),
+	        // Binding 4 : Tessellation levels of the visible patches
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            4),
+	    };
+
+	descriptor_layout = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), static_cast<uint32_t>(set_layout_bindings.size()));
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout, nullptr, &descriptor_set_layouts.cull));
+	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&descriptor_set_layouts.cull, 1);
+
+	// Patch count and vertices per row of the grid
+	VkPushConstantRange push_constant_range            = vkb::initializers::push_constant_range(VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(uint32_t), 0);
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges    = &push_constant_range;
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &pipeline_layouts.cull));
 }
 
 void TerrainTessellation::setup_descriptor_sets()
@@ -491,6 +686,7 @@ void TerrainTessellation::setup_descriptor_sets()
 	VkDescriptorBufferInfo terrain_buffer_descriptor   = create_descriptor(*uniform_buffers.terrain_tessellation);
 	VkDescriptorImageInfo  heightmap_image_descriptor  = create_descriptor(textures.heightmap);
 	VkDescriptorImageInfo  terrainmap_image_descriptor = create_descriptor(textures.terrain_array);
+	VkDescriptorBufferInfo patch_levels_descriptor     = create_descriptor(*terrain.patch_levels);
 	write_descriptor_sets =
 	    {
 	        // Binding 0 : Shared tessellation shader ubo
@@ -511,6 +707,12 @@ void TerrainTessellation::setup_descriptor_sets()
 	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 	            2,
 	            &terrainmap_image_descriptor),
+	        // Binding 3 : Tessellation levels of the GPU culled patches
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.terrain,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            3,
+	            &patch_levels_descriptor),
 	    };
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
 
@@ -536,6 +738,48 @@ void TerrainTessellation::setup_descriptor_sets()
 	            &skysphere_image_descriptor),
 	    };
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+
+	// Patch culling
+	alloc_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &descriptor_set_layouts.cull, 1);
+	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_sets.cull));
+
+	VkDescriptorBufferInfo patches_descriptor        = create_descriptor(*terrain.patches);
+	VkDescriptorBufferInfo draw_args_descriptor      = create_descriptor(*terrain.draw_args);
+	VkDescriptorBufferInfo culled_indices_descriptor = create_descriptor(*terrain.culled_indices);
+	write_descriptor_sets =
+	    {
+	        // Binding 0 : Shared tessellation shader ubo
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.cull,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            0,
+	            &terrain_buffer_descriptor),
+	        // Binding 1 : Patch bounds
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.cull,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            1,
+	            &patches_descriptor),
+	        // Binding 2 : Indirect draw arguments
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.cull,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            2,
+	            &draw_args_descriptor),
+	        // Binding 3 : Indices of the visible patches
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.cull,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            3,
+	            &culled_indices_descriptor),
+	        // Binding 4 : Tessellation levels of the visible patches
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.cull,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            4,
+	            &patch_levels_descriptor),
+	    };
+	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
 }
 
 void TerrainTessellation::prepare_pipelines()
@@ -645,6 +889,17 @@ void TerrainTessellation::prepare_pipelines()
 		VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.wireframe));
 	};
 
+	// GPU culled terrain pipelines, reading the tessellation levels selected by the culling shader
+	rasterization_state.polygonMode = VK_POLYGON_MODE_FILL;
+	shader_stages[2]                = load_shader("terrain_tessellation/terrain_culled.tesc", VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT);
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.terrain_culled));
+
+	if (get_device().get_gpu().get_features().fillModeNonSolid)
+	{
+		rasterization_state.polygonMode = VK_POLYGON_MODE_LINE;
+		VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.wireframe_culled));
+	}
+
 	// Skysphere pipeline
 
 	// Stride from glTF model vertex layout
@@ -662,6 +917,11 @@ void TerrainTessellation::prepare_pipelines()
 	shader_stages[0]                     = load_shader("terrain_tessellation/skysphere.vert", VK_SHADER_STAGE_VERTEX_BIT);
 	shader_stages[1]                     = load_shader("terrain_tessellation/skysphere.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
 	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.skysphere));
+
+	// Patch culling pipeline
+	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(pipeline_layouts.cull, 0);
+	compute_pipeline_create_info.stage                       = load_shader("terrain_tessellation/terrain_cull.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &pipelines.cull));
 }
 
 // Prepare and initialize uniform buffer containing shader uniforms
@@ -717,6 +977,12 @@ void TerrainTessellation::draw()
 {
 	ApiVulkanSample::prepare_frame();
 
+	if (gpu_culling)
+	{
+		// The previous frame has completed, so its statistics can be read
+		get_culling_results();
+	}
+
 	// Command buffer to be sumitted to the queue
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
@@ -794,6 +1060,18 @@ void TerrainTessellation::on_update_ui_overlay(vkb::Drawer &drawer)
 				build_command_buffers();
 			}
 		}
+		if (drawer.checkbox("GPU culling", &gpu_culling))
+		{
+			build_command_buffers();
+		}
+	}
+	if (gpu_culling)
+	{
+		if (drawer.header("GPU culling"))
+		{
+			drawer.text("Visible patches: %d / %d", culling_stats.command.indexCount / 4, terrain.patch_count);
+			drawer.text("Triangles: ~%d", culling_stats.triangle_count);
+		}
 	}
 	if (get_device().get_gpu().get_features().pipelineStatisticsQuery)
 	{
@@ -30,6 +30,7 @@ class TerrainTessellation : public ApiVulkanSample
   public:
 	bool wireframe    = false;
 	bool tessellation = true;
+	bool gpu_culling  = true;
 
 	struct
 	{
@@ -47,13 +48,40 @@ class TerrainTessellation : public ApiVulkanSample
 		glm::vec2 uv;
 	};
 
+	// Patch bounds read by the culling compute shader
+	struct Patch
+	{
+		glm::vec4 bounds;
+		glm::vec2 heights;
+		uint32_t  first_vertex;
+		uint32_t  padding;
+	};
+
+	// Indirect draw arguments written by the culling compute shader, followed by its statistics
+	struct DrawArgs
+	{
+		VkDrawIndexedIndirectCommand command;
+		uint32_t                     triangle_count;
+	};
+
 	struct Terrain
 	{
 		std::unique_ptr<vkb::core::Buffer> vertices;
 		std::unique_ptr<vkb::core::Buffer> indices;
 		uint32_t                           index_count;
+		uint32_t                           patch_count;
+
+		// GPU culling
+		std::unique_ptr<vkb::core::Buffer> patches;
+		std::unique_ptr<vkb::core::Buffer> culled_indices;
+		std::unique_ptr<vkb::core::Buffer> patch_levels;
+		std::unique_ptr<vkb::core::Buffer> draw_args;
+		std::unique_ptr<vkb::core::Buffer> draw_args_readback;
 	} terrain;
 
+	// Results of the GPU culling from the last frame
+	DrawArgs culling_stats{};
+
 	struct
 	{
 		std::unique_ptr<vkb::core::Buffer> terrain_tessellation;
@@ -84,25 +112,31 @@ class TerrainTessellation : public ApiVulkanSample
 	{
 		VkPipeline terrain;
 		VkPipeline wireframe = VK_NULL_HANDLE;
+		VkPipeline terrain_culled;
+		VkPipeline wireframe_culled = VK_NULL_HANDLE;
 		VkPipeline skysphere;
+		VkPipeline cull;
 	} pipelines;
 
 	struct
 	{
 		VkDescriptorSetLayout terrain;
 		VkDescriptorSetLayout skysphere;
+		VkDescriptorSetLayout cull;
 	} descriptor_set_layouts;
 
 	struct
 	{
 		VkPipelineLayout terrain;
 		VkPipelineLayout skysphere;
+		VkPipelineLayout cull;
 	} pipeline_layouts;
 
 	struct
 	{
 		VkDescriptorSet terrain;
 		VkDescriptorSet skysphere;
+		VkDescriptorSet cull;
 	} descriptor_sets;
 
 	// Pipeline statistics
@@ -122,8 +156,10 @@ class TerrainTessellation : public ApiVulkanSample
 	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
 	void         setup_query_result_buffer();
 	void         get_query_results();
+	void         get_culling_results();
 	void         load_assets();
 	void         build_command_buffers() override;
+	void         record_culling(VkCommandBuffer command_buffer);
 	void         generate_terrain();
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layouts();
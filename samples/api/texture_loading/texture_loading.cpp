@@ -21,11 +21,57 @@
 
 #include "texture_loading.h"
 
+#include <random>
+
+#include "timer.h"
+
+namespace
+{
+// Uploads of each path and format timed by the benchmark, the first one is not counted as it warms up the driver
+constexpr uint32_t upload_benchmark_iterations = 11;
+
+const char *to_string(TextureLoading::UploadPath path)
+{
+	switch (path)
+	{
+		case TextureLoading::UploadPath::OptimalStaging:
+			return "Optimal tiled, staging buffer";
+		case TextureLoading::UploadPath::LinearTiled:
+			return "Linear tiled";
+		case TextureLoading::UploadPath::TransferQueue:
+			return "Optimal tiled, transfer queue";
+		case TextureLoading::UploadPath::HostImageCopy:
+			return "Host image copy";
+		default:
+			return "Unknown";
+	}
+}
+
+// Size of a mip level, in 4x4 blocks of 16 bytes for the block compressed formats
+VkDeviceSize get_level_size(VkFormat format, uint32_t width, uint32_t height)
+{
+	if (format == VK_FORMAT_R8G8B8A8_UNORM)
+	{
+		return static_cast<VkDeviceSize>(width) * height * 4;
+	}
+
+	return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * 16;
+}
+}        // namespace
+
 TextureLoading::TextureLoading()
 {
 	zoom     = -2.5f;
 	rotation = {0.0f, 15.0f, 0.0f};
 	title    = "Texture loading";
+
+#ifdef VK_EXT_host_image_copy
+	// Only used by the upload benchmark
+	add_instance_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, true);
+	add_device_extension(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME, true);
+	add_device_extension(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME, true);
+	add_device_extension(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME, true);
+#endif
 }
 
 TextureLoading::~TextureLoading()
@@ -56,6 +102,15 @@ void TextureLoading::request_gpu_features(vkb::PhysicalDevice &gpu)
 	{
 		gpu.get_mutable_requested_features().samplerAnisotropy = VK_TRUE;
 	}
+
+#ifdef VK_EXT_host_image_copy
+	// Enable host image copies for the upload benchmark if supported
+	if (gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		auto &host_image_copy_features = gpu.request_extension_features<VkPhysicalDeviceHostImageCopyFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT);
+		host_image_copy_enabled        = host_image_copy_features.hostImageCopy;
+	}
+#endif
 }
 
 /*
@@ -395,6 +450,418 @@ void TextureLoading::load_texture()
 	VK_CHECK(vkCreateImageView(get_device().get_handle(), &view, nullptr, &texture.view));
 }
 
+/*
+	Upload benchmark
+
+	Times the upload of the texture through each path, for the uncompressed texture and for a block compressed format
+	supported by the device. The compressed data is generated, as the cost of an upload does not depend on the texel values.
+
+	Upload time:
+		From writing the data to the staging buffer (or the image) until the data is in the image.
+	Time to first use:
+		Until the image is in a layout the graphics queue can sample, including the queue family ownership transfer
+		of the transfer queue path. Each upload waits for the previous one, so these are latencies and not throughput
+		under load.
+*/
+void TextureLoading::run_upload_benchmark()
+{
+	std::vector<UploadSource> sources;
+
+	// Uncompressed texture, with its mip levels
+	{
+		std::string filename = vkb::fs::path::get(vkb::fs::path::Assets, "textures/metalplate01_rgba.ktx");
+
+		ktxTexture *ktx_texture = nullptr;
+		if (ktxTexture_CreateFromNamedFile(filename.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktx_texture) != KTX_SUCCESS || ktx_texture == nullptr)
+		{
+			throw std::runtime_error("Couldn't load texture");
+		}
+
+		UploadSource source{"R8G8B8A8_UNORM", VK_FORMAT_R8G8B8A8_UNORM, ktx_texture->baseWidth, ktx_texture->baseHeight};
+
+		auto *data = ktxTexture_GetData(ktx_texture);
+		source.data.assign(data, data + ktxTexture_GetSize(ktx_texture));
+
+		for (uint32_t i = 0; i < ktx_texture->numLevels; i++)
+		{
+			ktx_size_t offset;
+			ktxTexture_GetImageOffset(ktx_texture, i, 0, 0, &offset);
+			source.level_offsets.push_back(offset);
+			source.level_sizes.push_back(ktxTexture_GetImageSize(ktx_texture, i));
+		}
+
+		ktxTexture_Destroy(ktx_texture);
+
+		sources.push_back(std::move(source));
+	}
+
+	// Block compressed texture of the same size, in the first format the device samples
+	const std::vector<std::pair<VkFormat, const char *>> compressed_formats = {{VK_FORMAT_ASTC_4x4_UNORM_BLOCK, "ASTC_4x4_UNORM"},
+	                                                                           {VK_FORMAT_BC7_UNORM_BLOCK, "BC7_UNORM"},
+	                                                                           {VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, "ETC2_R8G8B8A8_UNORM"}};
+
+	for (auto &compressed_format : compressed_formats)
+	{
+		if (!get_device().is_image_format_supported(compressed_format.first))
+		{
+			continue;
+		}
+
+		auto &uncompressed = sources.front();
+
+		UploadSource source{compressed_format.second, compressed_format.first, uncompressed.width, uncompressed.height};
+
+		for (uint32_t i = 0; i < uncompressed.level_sizes.size(); i++)
+		{
+			source.level_offsets.push_back(source.data.size());
+			source.level_sizes.push_back(get_level_size(source.format, std::max(source.width >> i, 1u), std::max(source.height >> i, 1u)));
+			source.data.resize(source.data.size() + source.level_sizes.back());
+		}
+
+		std::mt19937 generator{0};
+		std::generate(source.data.begin(), source.data.end(), [&generator]() { return static_cast<uint8_t>(generator()); });
+
+		sources.push_back(std::move(source));
+		break;
+	}
+
+	if (sources.size() == 1)
+	{
+		LOGW("No block compressed format is supported, only the uncompressed texture will be uploaded");
+	}
+
+	upload_results.clear();
+
+	for (auto path : {UploadPath::OptimalStaging, UploadPath::LinearTiled, UploadPath::TransferQueue, UploadPath::HostImageCopy})
+	{
+		for (auto &source : sources)
+		{
+			double upload_total    = 0.0;
+			double first_use_total = 0.0;
+			bool   supported       = true;
+
+			for (uint32_t i = 0; i < upload_benchmark_iterations && supported; i++)
+			{
+				double upload_ms    = 0.0;
+				double first_use_ms = 0.0;
+
+				supported = time_upload(path, source, upload_ms, first_use_ms);
+
+				if (i > 0)
+				{
+					upload_total += upload_ms;
+					first_use_total += first_use_ms;
+				}
+			}
+
+			if (!supported)
+			{
+				continue;
+			}
+
+			// The linear path only uploads the base level
+			VkDeviceSize bytes = path == UploadPath::LinearTiled ? source.level_sizes.front() : source.data.size();
+
+			UploadResult result{to_string(path), source.name, bytes};
+			result.upload_ms            = upload_total / (upload_benchmark_iterations - 1);
+			result.first_use_ms         = first_use_total / (upload_benchmark_iterations - 1);
+			result.megabytes_per_second = (bytes / (1024.0 * 1024.0)) / (result.upload_ms / 1000.0);
+
+			LOGI("Upload {} ({}): {} KB, upload {:.3f} ms ({:.1f} MB/s), first use {:.3f} ms",
+			     result.path, result.format, bytes / 1024, result.upload_ms, result.megabytes_per_second, result.first_use_ms);
+
+			upload_results.push_back(std::move(result));
+		}
+	}
+}
+
+bool TextureLoading::time_upload(UploadPath path, const UploadSource &source, double &upload_ms, double &first_use_ms)
+{
+	switch (path)
+	{
+		case UploadPath::OptimalStaging:
+			return upload_staged(source, false, upload_ms, first_use_ms);
+		case UploadPath::LinearTiled:
+			return upload_linear(source, upload_ms, first_use_ms);
+		case UploadPath::TransferQueue:
+			return upload_staged(source, true, upload_ms, first_use_ms);
+		case UploadPath::HostImageCopy:
+			return upload_host_image_copy(source, upload_ms, first_use_ms);
+		default:
+			return false;
+	}
+}
+
+VkImage TextureLoading::create_upload_image(const UploadSource &source, VkImageTiling tiling, VkImageUsageFlags usage, uint32_t mip_levels, VkMemoryPropertyFlags memory_properties, VkDeviceMemory &memory)
+{
+	VkImageCreateInfo image_create_info = vkb::initializers::image_create_info();
+	image_create_info.imageType         = VK_IMAGE_TYPE_2D;
+	image_create_info.format            = source.format;
+	image_create_info.mipLevels         = mip_levels;
+	image_create_info.arrayLayers       = 1;
+	image_create_info.samples           = VK_SAMPLE_COUNT_1_BIT;
+	image_create_info.tiling            = tiling;
+	image_create_info.usage             = usage;
+	image_create_info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+	image_create_info.initialLayout     = tiling == VK_IMAGE_TILING_LINEAR ? VK_IMAGE_LAYOUT_PREINITIALIZED : VK_IMAGE_LAYOUT_UNDEFINED;
+	image_create_info.extent            = {source.width, source.height, 1};
+
+	VkImage image;
+	VK_CHECK(vkCreateImage(get_device().get_handle(), &image_create_info, nullptr, &image));
+
+	VkMemoryRequirements memory_requirements;
+	vkGetImageMemoryRequirements(get_device().get_handle(), image, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info = vkb::initializers::memory_allocate_info();
+	memory_allocate_info.allocationSize       = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex      = get_device().get_memory_type(memory_requirements.memoryTypeBits, memory_properties);
+	VK_CHECK(vkAllocateMemory(get_device().get_handle(), &memory_allocate_info, nullptr, &memory));
+	VK_CHECK(vkBindImageMemory(get_device().get_handle(), image, memory, 0));
+
+	return image;
+}
+
+bool TextureLoading::upload_staged(const UploadSource &source, bool transfer_queue, double &upload_ms, double &first_use_ms)
+{
+	auto graphics_family = get_device().get_suitable_graphics_queue().get_family_index();
+	auto upload_family   = transfer_queue ? get_device().get_queue_family_index(VK_QUEUE_TRANSFER_BIT) : graphics_family;
+
+	// Without a dedicated transfer queue family this would be the optimal staging path
+	if (transfer_queue && upload_family == graphics_family)
+	{
+		return false;
+	}
+
+	auto mip_levels = vkb::to_u32(source.level_sizes.size());
+
+	// The image is created ahead of the timing, as it would be for a streamed texture
+	VkDeviceMemory image_memory;
+	VkImage        image = create_upload_image(source, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, mip_levels, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_memory);
+
+	VkCommandPool command_pool = get_device().create_command_pool(upload_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+	// Submits a command buffer from the pool and waits for it
+	auto submit_and_wait = [this](VkCommandBuffer command_buffer, VkQueue submit_queue) {
+		VK_CHECK(vkEndCommandBuffer(command_buffer));
+
+		VkFenceCreateInfo fence_info = vkb::initializers::fence_create_info();
+		VkFence           fence;
+		VK_CHECK(vkCreateFence(get_device().get_handle(), &fence_info, nullptr, &fence));
+
+		VkSubmitInfo submit_info       = vkb::initializers::submit_info();
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers    = &command_buffer;
+		VK_CHECK(vkQueueSubmit(submit_queue, 1, &submit_info, fence));
+		VK_CHECK(vkWaitForFences(get_device().get_handle(), 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+
+		vkDestroyFence(get_device().get_handle(), fence, nullptr);
+	};
+
+	auto begin_command_buffer = [this](VkCommandPool pool) {
+		VkCommandBufferAllocateInfo allocate_info = vkb::initializers::command_buffer_allocate_info(pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+		VkCommandBuffer             command_buffer;
+		VK_CHECK(vkAllocateCommandBuffers(get_device().get_handle(), &allocate_info, &command_buffer));
+
+		VkCommandBufferBeginInfo begin_info = vkb::initializers::command_buffer_begin_info();
+		begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK(vkBeginCommandBuffer(command_buffer, &begin_info));
+
+		return command_buffer;
+	};
+
+	vkb::Timer timer;
+	timer.start();
+
+	vkb::core::Buffer staging_buffer{get_device(), source.data.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+	staging_buffer.update(source.data);
+
+	std::vector<VkBufferImageCopy> buffer_copy_regions;
+	for (uint32_t i = 0; i < mip_levels; i++)
+	{
+		VkBufferImageCopy buffer_copy_region           = {};
+		buffer_copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		buffer_copy_region.imageSubresource.mipLevel   = i;
+		buffer_copy_region.imageSubresource.layerCount = 1;
+		buffer_copy_region.imageExtent                 = {std::max(source.width >> i, 1u), std::max(source.height >> i, 1u), 1};
+		buffer_copy_region.bufferOffset                = source.level_offsets[i];
+		buffer_copy_regions.push_back(buffer_copy_region);
+	}
+
+	VkImageSubresourceRange subresource_range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mip_levels, 0, 1};
+
+	VkCommandBuffer copy_command = begin_command_buffer(command_pool);
+
+	vkb::insert_image_memory_barrier(copy_command, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+	                                 VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                                 VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, subresource_range);
+
+	vkCmdCopyBufferToImage(copy_command, staging_buffer.get_handle(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                       vkb::to_u32(buffer_copy_regions.size()), buffer_copy_regions.data());
+
+	// On the graphics queue the transition to the shader read layout goes in the same submission,
+	// the transfer queue releases the image to the graphics queue family instead
+	VkImageMemoryBarrier release_barrier = vkb::initializers::image_memory_barrier();
+	release_barrier.image                = image;
+	release_barrier.subresourceRange     = subresource_range;
+	release_barrier.srcAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+	release_barrier.dstAccessMask        = transfer_queue ? 0 : VK_ACCESS_SHADER_READ_BIT;
+	release_barrier.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	release_barrier.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	release_barrier.srcQueueFamilyIndex  = transfer_queue ? upload_family : VK_QUEUE_FAMILY_IGNORED;
+	release_barrier.dstQueueFamilyIndex  = transfer_queue ? graphics_family : VK_QUEUE_FAMILY_IGNORED;
+
+	vkCmdPipelineBarrier(copy_command, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                     transfer_queue ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+	                     0, 0, nullptr, 0, nullptr, 1, &release_barrier);
+
+	submit_and_wait(copy_command, get_device().get_queue(upload_family, 0).get_handle());
+
+	upload_ms = timer.elapsed<vkb::Timer::Milliseconds>();
+
+	VkCommandPool acquire_pool = VK_NULL_HANDLE;
+	if (transfer_queue)
+	{
+		// The graphics queue acquires the image with a matching barrier before sampling it
+		acquire_pool = get_device().create_command_pool(graphics_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+		VkCommandBuffer acquire_command = begin_command_buffer(acquire_pool);
+
+		VkImageMemoryBarrier acquire_barrier = release_barrier;
+		acquire_barrier.srcAccessMask        = 0;
+		acquire_barrier.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(acquire_command, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		                     0, 0, nullptr, 0, nullptr, 1, &acquire_barrier);
+
+		submit_and_wait(acquire_command, queue);
+	}
+
+	first_use_ms = timer.stop<vkb::Timer::Milliseconds>();
+
+	if (acquire_pool != VK_NULL_HANDLE)
+	{
+		vkDestroyCommandPool(get_device().get_handle(), acquire_pool, nullptr);
+	}
+	vkDestroyCommandPool(get_device().get_handle(), command_pool, nullptr);
+	vkDestroyImage(get_device().get_handle(), image, nullptr);
+	vkFreeMemory(get_device().get_handle(), image_memory, nullptr);
+
+	return true;
+}
+
+bool TextureLoading::upload_linear(const UploadSource &source, double &upload_ms, double &first_use_ms)
+{
+	// Linear tiled images are rarely sampled in block compressed formats
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(get_device().get_gpu().get_handle(), source.format, &format_properties);
+	if (!(format_properties.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+	{
+		return false;
+	}
+
+	VkDeviceMemory image_memory;
+	VkImage        image = create_upload_image(source, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT, 1, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, image_memory);
+
+	vkb::Timer timer;
+	timer.start();
+
+	// The rows of the image may be padded, so they are copied one by one
+	VkImageSubresource subresource{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0};
+	VkSubresourceLayout layout;
+	vkGetImageSubresourceLayout(get_device().get_handle(), image, &subresource, &layout);
+
+	uint8_t *data;
+	VK_CHECK(vkMapMemory(get_device().get_handle(), image_memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&data)));
+
+	auto block_rows = source.format == VK_FORMAT_R8G8B8A8_UNORM ? source.height : (source.height + 3) / 4;
+	auto row_size   = source.level_sizes.front() / block_rows;
+	for (uint32_t row = 0; row < block_rows; row++)
+	{
+		memcpy(data + layout.offset + row * layout.rowPitch, source.data.data() + source.level_offsets.front() + row * row_size, row_size);
+	}
+
+	vkUnmapMemory(get_device().get_handle(), image_memory);
+
+	upload_ms = timer.elapsed<vkb::Timer::Milliseconds>();
+
+	VkCommandBuffer copy_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	vkb::insert_image_memory_barrier(copy_command, image, VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+	                                 VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                                 VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
+
+	device->flush_command_buffer(copy_command, queue, true);
+
+	first_use_ms = timer.stop<vkb::Timer::Milliseconds>();
+
+	vkDestroyImage(get_device().get_handle(), image, nullptr);
+	vkFreeMemory(get_device().get_handle(), image_memory, nullptr);
+
+	return true;
+}
+
+bool TextureLoading::upload_host_image_copy(const UploadSource &source, double &upload_ms, double &first_use_ms)
+{
+#ifdef VK_EXT_host_image_copy
+	if (!host_image_copy_enabled)
+	{
+		return false;
+	}
+
+	// The format must support host transfers to optimal tiled images
+	VkImageFormatProperties image_format_properties;
+	if (vkGetPhysicalDeviceImageFormatProperties(get_device().get_gpu().get_handle(), source.format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL,
+	                                             VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT | VK_IMAGE_USAGE_SAMPLED_BIT, 0, &image_format_properties) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	auto mip_levels = vkb::to_u32(source.level_sizes.size());
+
+	VkDeviceMemory image_memory;
+	VkImage        image = create_upload_image(source, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT | VK_IMAGE_USAGE_SAMPLED_BIT, mip_levels, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_memory);
+
+	vkb::Timer timer;
+	timer.start();
+
+	// The general layout is always a valid destination of host copies, and can be sampled
+	VkHostImageLayoutTransitionInfoEXT transition_info{VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT};
+	transition_info.image            = image;
+	transition_info.oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
+	transition_info.newLayout        = VK_IMAGE_LAYOUT_GENERAL;
+	transition_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mip_levels, 0, 1};
+	VK_CHECK(vkTransitionImageLayoutEXT(get_device().get_handle(), 1, &transition_info));
+
+	std::vector<VkMemoryToImageCopyEXT> regions;
+	for (uint32_t i = 0; i < mip_levels; i++)
+	{
+		VkMemoryToImageCopyEXT region{VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT};
+		region.pHostPointer     = source.data.data() + source.level_offsets[i];
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1};
+		region.imageExtent      = {std::max(source.width >> i, 1u), std::max(source.height >> i, 1u), 1};
+		regions.push_back(region);
+	}
+
+	VkCopyMemoryToImageInfoEXT copy_info{VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT};
+	copy_info.dstImage       = image;
+	copy_info.dstImageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	copy_info.regionCount    = vkb::to_u32(regions.size());
+	copy_info.pRegions       = regions.data();
+	VK_CHECK(vkCopyMemoryToImageEXT(get_device().get_handle(), &copy_info));
+
+	// The copy is complete when the call returns, there is no queue submission before the first use
+	upload_ms    = timer.stop<vkb::Timer::Milliseconds>();
+	first_use_ms = upload_ms;
+
+	vkDestroyImage(get_device().get_handle(), image, nullptr);
+	vkFreeMemory(get_device().get_handle(), image_memory, nullptr);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
 // Free all Vulkan resources used by a texture object
 void TextureLoading::destroy_texture(Texture texture)
 {
@@ -712,6 +1179,18 @@ bool TextureLoading::prepare(vkb::Platform &platform)
 		return false;
 	}
 	load_texture();
+
+#ifdef VK_EXT_host_image_copy
+	// The feature is only usable if the device extension could be enabled too
+	host_image_copy_enabled = host_image_copy_enabled && get_device().is_enabled(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+#endif
+
+	// Compare the upload paths once at startup in benchmark mode, otherwise on request
+	if (is_benchmark_mode())
+	{
+		run_upload_benchmark();
+	}
+
 	generate_quad();
 	prepare_uniform_buffers();
 	setup_descriptor_set_layout();
@@ -744,6 +1223,17 @@ void TextureLoading::on_update_ui_overlay(vkb::Drawer &drawer)
 			update_uniform_buffers();
 		}
 	}
+	if (drawer.header("Upload benchmark"))
+	{
+		if (drawer.button("Run"))
+		{
+			run_upload_benchmark();
+		}
+		for (auto &result : upload_results)
+		{
+			drawer.text("%s, %s: %.1f MB/s, first use %.2f ms", result.path.c_str(), result.format.c_str(), result.megabytes_per_second, result.first_use_ms);
+		}
+	}
 }
 
 std::unique_ptr<vkb::Application> create_texture_loading()
@@ -72,11 +72,52 @@ class TextureLoading : public ApiVulkanSample
 	VkDescriptorSet       descriptor_set;
 	VkDescriptorSetLayout descriptor_set_layout;
 
+	// Ways of getting texture data into an image the shaders can sample, compared by the upload benchmark
+	enum class UploadPath
+	{
+		OptimalStaging,        // Staging buffer copied to an optimal tiled image on the graphics queue
+		LinearTiled,           // Host visible linear tiled image written directly, base level only
+		TransferQueue,         // Staging buffer copied on a dedicated transfer queue, then acquired by the graphics queue
+		HostImageCopy          // Data copied to an optimal tiled image by the host (VK_EXT_host_image_copy)
+	};
+
+	// Texture data to upload, with the offset and size of each mip level in the data
+	struct UploadSource
+	{
+		std::string               name;
+		VkFormat                  format;
+		uint32_t                  width, height;
+		std::vector<uint8_t>      data;
+		std::vector<VkDeviceSize> level_offsets;
+		std::vector<VkDeviceSize> level_sizes;
+	};
+
+	struct UploadResult
+	{
+		std::string  path;
+		std::string  format;
+		VkDeviceSize bytes;
+		double       upload_ms;           // Until the data is in the image
+		double       first_use_ms;        // Until the image can be sampled by the graphics queue
+		double       megabytes_per_second;
+	};
+
+	// Timings of the last upload benchmark, by path and format
+	std::vector<UploadResult> upload_results;
+
+	bool host_image_copy_enabled = false;
+
 	TextureLoading();
 	~TextureLoading();
 	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
 	void         load_texture();
 	void         destroy_texture(Texture texture);
+	void         run_upload_benchmark();
+	bool         time_upload(UploadPath path, const UploadSource &source, double &upload_ms, double &first_use_ms);
+	bool         upload_staged(const UploadSource &source, bool transfer_queue, double &upload_ms, double &first_use_ms);
+	bool         upload_linear(const UploadSource &source, double &upload_ms, double &first_use_ms);
+	bool         upload_host_image_copy(const UploadSource &source, double &upload_ms, double &first_use_ms);
+	VkImage      create_upload_image(const UploadSource &source, VkImageTiling tiling, VkImageUsageFlags usage, uint32_t mip_levels, VkMemoryPropertyFlags memory_properties, VkDeviceMemory &memory);
 	void         build_command_buffers() override;
 	void         draw();
 	void         generate_quad();
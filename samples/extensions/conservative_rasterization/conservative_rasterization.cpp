@@ -64,8 +64,25 @@ ConservativeRasterization::~ConservativeRasterization()
 
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layouts.scene, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layouts.fullscreen, nullptr);
+
+		destroy_voxel_grid();
+		vkDestroyRenderPass(get_device().get_handle(), voxelization.render_pass, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), voxelization.raster_pipeline, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), voxelization.compute_pipeline, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), voxelization.view_pipeline, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), voxelization.pipeline_layout, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), voxelization.view_pipeline_layout, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), voxelization.descriptor_set_layout, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), voxelization.view_descriptor_set_layout, nullptr);
+		if (voxelization.query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(get_device().get_handle(), voxelization.query_pool, nullptr);
+		}
 	}
 
+	voxelization.uniform_buffer.reset();
+	voxelization.mesh.positions.reset();
+	voxelization.mesh.indices.reset();
 	uniform_buffers.scene.reset();
 	triangle.vertices.reset();
 	triangle.indices.reset();
@@ -75,6 +92,16 @@ void ConservativeRasterization::request_gpu_features(vkb::PhysicalDevice &gpu)
 {
 	gpu.get_mutable_requested_features().fillModeNonSolid = gpu.get_features().fillModeNonSolid;
 	gpu.get_mutable_requested_features().wideLines        = gpu.get_features().wideLines;
+
+	// The voxelization mode writes the grid with image atomics from the fragment shader
+	if (gpu.get_features().fragmentStoresAndAtomics)
+	{
+		gpu.get_mutable_requested_features().fragmentStoresAndAtomics = VK_TRUE;
+	}
+	else
+	{
+		throw vkb::VulkanException(VK_ERROR_FEATURE_NOT_PRESENT, "Selected GPU does not support stores and atomic operations in fragment shaders");
+	}
 }
 
 // Setup offscreen framebuffer, attachments and render passes for lower resolution rendering of the scene
@@ -84,7 +111,7 @@ void ConservativeRasterization::prepare_offscreen()
 	offscreen_pass.height = height / ZOOM_FACTOR;
 
 	// Find a suitable depth format
-	VkFormat framebuffer_depth_format = vkb::get_suitable_depth_format(get_device().get_gpu().get_handle());
+	VkFormat framebuffer_depth_format = vkb::get_suitable_depth_format(get_device().get_gpu());
 
 	// Color attachment
 	VkImageCreateInfo image = vkb::initializers::image_create_info();
@@ -254,7 +281,13 @@ void ConservativeRasterization::build_command_buffers()
 	{
 		VK_CHECK(vkBeginCommandBuffer(draw_cmd_buffers[i], &command_buffer_begin_info));
 
+		if (voxelization_enabled)
+		{
+			record_voxelization(draw_cmd_buffers[i], i);
+		}
+
 		// First render pass: Render a low res triangle to an offscreen framebuffer to use for visualization in second pass
+		if (!voxelization_enabled)
 		{
 			VkClearValue clear_values[2];
 			clear_values[0].color        = {{0.25f, 0.25f, 0.25f, 0.0f}};
@@ -312,18 +345,28 @@ void ConservativeRasterization::build_command_buffers()
 			VkRect2D scissor = vkb::initializers::rect2D(width, height, 0, 0);
 			vkCmdSetScissor(draw_cmd_buffers[i], 0, 1, &scissor);
 
-			// Low-res triangle from offscreen framebuffer
-			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.fullscreen);
-			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.fullscreen, 0, 1, &descriptor_sets.fullscreen, 0, nullptr);
-			vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
-
-			// Overlay actual triangle
-			VkDeviceSize offsets[1] = {0};
-			vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, triangle.vertices->get(), offsets);
-			vkCmdBindIndexBuffer(draw_cmd_buffers[i], triangle.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
-			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.triangle_overlay);
-			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.scene, 0, 1, &descriptor_sets.scene, 0, nullptr);
-			vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
+			if (voxelization_enabled)
+			{
+				// Ray march the voxel grid
+				vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, voxelization.view_pipeline);
+				vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, voxelization.view_pipeline_layout, 0, 1, &voxelization.view_descriptor_set, 0, nullptr);
+				vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
+			}
+			else
+			{
+				// Low-res triangle from offscreen framebuffer
+				vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.fullscreen);
+				vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.fullscreen, 0, 1, &descriptor_sets.fullscreen, 0, nullptr);
+				vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
+
+				// Overlay actual triangle
+				VkDeviceSize offsets[1] = {0};
+				vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, triangle.vertices->get(), offsets);
+				vkCmdBindIndexBuffer(draw_cmd_buffers[i], triangle.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+				vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.triangle_overlay);
+				vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.scene, 0, 1, &descriptor_sets.scene, 0, nullptr);
+				vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
+			}
 
 			draw_ui(draw_cmd_buffers[i]);
 
@@ -375,13 +418,403 @@ void ConservativeRasterization::load_assets()
 	get_device().copy_buffer(index_staging_buffer, *triangle.indices, queue);
 }
 
+uint32_t ConservativeRasterization::get_voxel_grid_size() const
+{
+	return 32u << voxelization.grid_size_index;
+}
+
+// Generate a torus inside the [-1, 1] unit cube that is voxelized by both the raster and the compute path
+void ConservativeRasterization::load_voxelization_mesh()
+{
+	const uint32_t major_segments = 96;
+	const uint32_t minor_segments = 48;
+	const float    major_radius   = 0.6f;
+	const float    minor_radius   = 0.3f;
+
+	std::vector<glm::vec3> positions;
+	positions.reserve(major_segments * minor_segments);
+	for (uint32_t i = 0; i < major_segments; ++i)
+	{
+		float u = 2.0f * glm::pi<float>() * static_cast<float>(i) / static_cast<float>(major_segments);
+		for (uint32_t j = 0; j < minor_segments; ++j)
+		{
+			float v = 2.0f * glm::pi<float>() * static_cast<float>(j) / static_cast<float>(minor_segments);
+			float r = major_radius + minor_radius * std::cos(v);
+			// Tilt the torus so that no projection axis sees it edge-on
+			glm::vec3 p(r * std::cos(u), minor_radius * std::sin(v), r * std::sin(u));
+			positions.push_back(glm::vec3(p.x, 0.8f * p.y + 0.6f * p.z, -0.6f * p.y + 0.8f * p.z));
+		}
+	}
+
+	std::vector<uint32_t> indices;
+	indices.reserve(major_segments * minor_segments * 6);
+	for (uint32_t i = 0; i < major_segments; ++i)
+	{
+		for (uint32_t j = 0; j < minor_segments; ++j)
+		{
+			uint32_t a = i * minor_segments + j;
+			uint32_t b = ((i + 1) % major_segments) * minor_segments + j;
+			uint32_t c = ((i + 1) % major_segments) * minor_segments + (j + 1) % minor_segments;
+			uint32_t d = i * minor_segments + (j + 1) % minor_segments;
+			indices.insert(indices.end(), {a, b, c, a, c, d});
+		}
+	}
+	voxelization.mesh.index_count = vkb::to_u32(indices.size());
+
+	auto positions_size = vkb::to_u32(positions.size() * sizeof(glm::vec3));
+	auto indices_size   = vkb::to_u32(indices.size() * sizeof(uint32_t));
+
+	vkb::core::Buffer positions_staging_buffer{get_device(), positions_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+	positions_staging_buffer.update(positions.data(), positions_size);
+
+	vkb::core::Buffer indices_staging_buffer{get_device(), indices_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+	indices_staging_buffer.update(indices.data(), indices_size);
+
+	// The compute voxelizer fetches the triangles itself, so both buffers are also storage buffers
+	voxelization.mesh.positions = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                                  positions_size,
+	                                                                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                                  VMA_MEMORY_USAGE_GPU_ONLY);
+
+	voxelization.mesh.indices = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                                indices_size,
+	                                                                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                                VMA_MEMORY_USAGE_GPU_ONLY);
+
+	get_device().copy_buffer(positions_staging_buffer, *voxelization.mesh.positions, queue);
+	get_device().copy_buffer(indices_staging_buffer, *voxelization.mesh.indices, queue);
+}
+
+// Create the voxel grid for the current grid size along with the attachment-less framebuffer used by the raster voxelizer
+void ConservativeRasterization::prepare_voxel_grid()
+{
+	const uint32_t grid_size = get_voxel_grid_size();
+
+	VkImageCreateInfo image = vkb::initializers::image_create_info();
+	image.imageType         = VK_IMAGE_TYPE_3D;
+	image.format            = VK_FORMAT_R32_UINT;
+	image.extent            = {grid_size, grid_size, grid_size};
+	image.mipLevels         = 1;
+	image.arrayLayers       = 1;
+	image.samples           = VK_SAMPLE_COUNT_1_BIT;
+	image.tiling            = VK_IMAGE_TILING_OPTIMAL;
+	image.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	VkMemoryAllocateInfo memory_allocation_info = vkb::initializers::memory_allocate_info();
+	VkMemoryRequirements memory_requirements;
+
+	VK_CHECK(vkCreateImage(get_device().get_handle(), &image, nullptr, &voxelization.grid.image));
+	vkGetImageMemoryRequirements(get_device().get_handle(), voxelization.grid.image, &memory_requirements);
+	memory_allocation_info.allocationSize  = memory_requirements.size;
+	memory_allocation_info.memoryTypeIndex = get_device().get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK(vkAllocateMemory(get_device().get_handle(), &memory_allocation_info, nullptr, &voxelization.grid.mem));
+	VK_CHECK(vkBindImageMemory(get_device().get_handle(), voxelization.grid.image, voxelization.grid.mem, 0));
+
+	VkImageViewCreateInfo view = vkb::initializers::image_view_create_info();
+	view.viewType              = VK_IMAGE_VIEW_TYPE_3D;
+	view.format                = VK_FORMAT_R32_UINT;
+	view.subresourceRange      = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	view.image                 = voxelization.grid.image;
+	VK_CHECK(vkCreateImageView(get_device().get_handle(), &view, nullptr, &voxelization.grid.view));
+
+	// The grid stays in the general layout for clears, atomics and loads
+	VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	vkb::set_image_layout(command_buffer, voxelization.grid.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	get_device().flush_command_buffer(command_buffer, queue);
+
+	// Voxels are written from the fragment shader only, so the framebuffer has no attachments and just defines the grid resolution
+	VkFramebufferCreateInfo framebuffer_create_info = vkb::initializers::framebuffer_create_info();
+	framebuffer_create_info.renderPass              = voxelization.render_pass;
+	framebuffer_create_info.attachmentCount         = 0;
+	framebuffer_create_info.width                   = grid_size;
+	framebuffer_create_info.height                  = grid_size;
+	framebuffer_create_info.layers                  = 1;
+	VK_CHECK(vkCreateFramebuffer(get_device().get_handle(), &framebuffer_create_info, nullptr, &voxelization.grid.framebuffer));
+}
+
+void ConservativeRasterization::destroy_voxel_grid()
+{
+	vkDestroyFramebuffer(get_device().get_handle(), voxelization.grid.framebuffer, nullptr);
+	vkDestroyImageView(get_device().get_handle(), voxelization.grid.view, nullptr);
+	vkDestroyImage(get_device().get_handle(), voxelization.grid.image, nullptr);
+	vkFreeMemory(get_device().get_handle(), voxelization.grid.mem, nullptr);
+	voxelization.grid = {};
+}
+
+void ConservativeRasterization::prepare_voxelization()
+{
+	// Render pass without attachments for the raster voxelizer
+	VkSubpassDescription subpass_description = {};
+	subpass_description.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+	VkRenderPassCreateInfo render_pass_create_info = {};
+	render_pass_create_info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	render_pass_create_info.subpassCount           = 1;
+	render_pass_create_info.pSubpasses             = &subpass_description;
+	VK_CHECK(vkCreateRenderPass(get_device().get_handle(), &render_pass_create_info, nullptr, &voxelization.render_pass));
+
+	prepare_voxel_grid();
+
+	voxelization.uniform_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                                  sizeof(voxelization.ubo_view),
+	                                                                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	                                                                  VMA_MEMORY_USAGE_CPU_TO_GPU);
+	update_uniform_buffers_voxel_view();
+
+	// Descriptor set layouts and pipeline layouts
+	std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings = {
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 0),        // Binding 0: Voxel grid
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),                                     // Binding 1: Vertex positions
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2)                                      // Binding 2: Triangle indices
+	};
+	VkDescriptorSetLayoutCreateInfo descriptor_layout = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), vkb::to_u32(set_layout_bindings.size()));
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout, nullptr, &voxelization.descriptor_set_layout));
+
+	VkPushConstantRange        push_constant_range         = vkb::initializers::push_constant_range(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, sizeof(Voxelization::PushConstants), 0);
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&voxelization.descriptor_set_layout, 1);
+	pipeline_layout_create_info.pushConstantRangeCount     = 1;
+	pipeline_layout_create_info.pPushConstantRanges        = &push_constant_range;
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &voxelization.pipeline_layout));
+
+	set_layout_bindings = {
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0),        // Binding 0: Fragment shader uniform buffer
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT, 1)          // Binding 1: Voxel grid
+	};
+	descriptor_layout = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), vkb::to_u32(set_layout_bindings.size()));
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout, nullptr, &voxelization.view_descriptor_set_layout));
+	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&voxelization.view_descriptor_set_layout, 1);
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &voxelization.view_pipeline_layout));
+
+	// Descriptor sets
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &voxelization.descriptor_set_layout, 1);
+	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_allocate_info, &voxelization.descriptor_set));
+	descriptor_set_allocate_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &voxelization.view_descriptor_set_layout, 1);
+	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_allocate_info, &voxelization.view_descriptor_set));
+
+	VkDescriptorBufferInfo            positions_descriptor = create_descriptor(*voxelization.mesh.positions);
+	VkDescriptorBufferInfo            indices_descriptor   = create_descriptor(*voxelization.mesh.indices);
+	VkDescriptorBufferInfo            view_descriptor      = create_descriptor(*voxelization.uniform_buffer);
+	std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
+	    vkb::initializers::write_descriptor_set(voxelization.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &positions_descriptor),
+	    vkb::initializers::write_descriptor_set(voxelization.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &indices_descriptor),
+	    vkb::initializers::write_descriptor_set(voxelization.view_descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &view_descriptor)};
+	vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, nullptr);
+	update_voxel_descriptor_sets();
+
+	// Raster voxelizer: each triangle is drawn three times, once projected along every axis, with conservative rasterization
+	// so that every voxel column the triangle touches gets a fragment
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_state =
+	    vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+
+	VkPipelineRasterizationStateCreateInfo rasterization_state =
+	    vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE, 0);
+
+	VkPipelineRasterizationConservativeStateCreateInfoEXT conservative_rasterization_state{};
+	conservative_rasterization_state.sType                            = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_CONSERVATIVE_STATE_CREATE_INFO_EXT;
+	conservative_rasterization_state.conservativeRasterizationMode    = VK_CONSERVATIVE_RASTERIZATION_MODE_OVERESTIMATE_EXT;
+	conservative_rasterization_state.extraPrimitiveOverestimationSize = 0.0f;
+	rasterization_state.pNext                                         = &conservative_rasterization_state;
+
+	VkPipelineColorBlendStateCreateInfo color_blend_state =
+	    vkb::initializers::pipeline_color_blend_state_create_info(0, nullptr);
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_state =
+	    vkb::initializers::pipeline_depth_stencil_state_create_info(VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+
+	VkPipelineViewportStateCreateInfo viewport_state =
+	    vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+
+	VkPipelineMultisampleStateCreateInfo multisample_state =
+	    vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+
+	std::vector<VkDynamicState> dynamic_state_enables = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+	VkPipelineDynamicStateCreateInfo dynamic_state =
+	    vkb::initializers::pipeline_dynamic_state_create_info(dynamic_state_enables);
+
+	std::vector<VkVertexInputBindingDescription> vertex_input_bindings = {
+	    vkb::initializers::vertex_input_binding_description(0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX),
+	};
+	std::vector<VkVertexInputAttributeDescription> vertex_input_attributes = {
+	    vkb::initializers::vertex_input_attribute_description(0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0),        // Location 0: Position
+	};
+	VkPipelineVertexInputStateCreateInfo vertex_input_state = vkb::initializers::pipeline_vertex_input_state_create_info();
+	vertex_input_state.vertexBindingDescriptionCount        = vkb::to_u32(vertex_input_bindings.size());
+	vertex_input_state.pVertexBindingDescriptions           = vertex_input_bindings.data();
+	vertex_input_state.vertexAttributeDescriptionCount      = vkb::to_u32(vertex_input_attributes.size());
+	vertex_input_state.pVertexAttributeDescriptions         = vertex_input_attributes.data();
+
+	std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages;
+	shader_stages[0] = load_shader("conservative_rasterization/voxelize.vert", VK_SHADER_STAGE_VERTEX_BIT);
+	shader_stages[1] = load_shader("conservative_rasterization/voxelize.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	VkGraphicsPipelineCreateInfo pipeline_create_info =
+	    vkb::initializers::pipeline_create_info(voxelization.pipeline_layout, voxelization.render_pass, 0);
+	pipeline_create_info.pVertexInputState   = &vertex_input_state;
+	pipeline_create_info.pInputAssemblyState = &input_assembly_state;
+	pipeline_create_info.pRasterizationState = &rasterization_state;
+	pipeline_create_info.pColorBlendState    = &color_blend_state;
+	pipeline_create_info.pMultisampleState   = &multisample_state;
+	pipeline_create_info.pViewportState      = &viewport_state;
+	pipeline_create_info.pDepthStencilState  = &depth_stencil_state;
+	pipeline_create_info.pDynamicState       = &dynamic_state;
+	pipeline_create_info.stageCount          = vkb::to_u32(shader_stages.size());
+	pipeline_create_info.pStages             = shader_stages.data();
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &voxelization.raster_pipeline));
+
+	// Visualization of the grid, ray marched in a full screen pass
+	VkPipelineColorBlendAttachmentState blend_attachment_state =
+	    vkb::initializers::pipeline_color_blend_attachment_state(0xf, VK_FALSE);
+	color_blend_state         = vkb::initializers::pipeline_color_blend_state_create_info(1, &blend_attachment_state);
+	rasterization_state.pNext = nullptr;
+
+	VkPipelineVertexInputStateCreateInfo empty_input_state = vkb::initializers::pipeline_vertex_input_state_create_info();
+	pipeline_create_info.pVertexInputState                 = &empty_input_state;
+	pipeline_create_info.layout                            = voxelization.view_pipeline_layout;
+	pipeline_create_info.renderPass                        = render_pass;
+	shader_stages[0]                                       = load_shader("conservative_rasterization/fullscreen.vert", VK_SHADER_STAGE_VERTEX_BIT);
+	shader_stages[1]                                       = load_shader("conservative_rasterization/voxel_view.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &voxelization.view_pipeline));
+
+	// Compute voxelizer: one invocation per triangle testing every voxel of its bounding box
+	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(voxelization.pipeline_layout, 0);
+	compute_pipeline_create_info.stage                       = load_shader("conservative_rasterization/voxelize.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &voxelization.compute_pipeline));
+
+	// Timestamps need to be supported on both graphics and compute to compare the two voxelizers
+	if (get_device().get_gpu().get_properties().limits.timestampComputeAndGraphics)
+	{
+		VkQueryPoolCreateInfo query_pool_info = {};
+		query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		query_pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount            = vkb::to_u32(draw_cmd_buffers.size()) * 4;
+		VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, nullptr, &voxelization.query_pool));
+	}
+}
+
+// Point the descriptors at the voxel grid, needs to be called whenever the grid is recreated
+void ConservativeRasterization::update_voxel_descriptor_sets()
+{
+	VkDescriptorImageInfo             grid_descriptor       = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, voxelization.grid.view, VK_IMAGE_LAYOUT_GENERAL);
+	std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
+	    vkb::initializers::write_descriptor_set(voxelization.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0, &grid_descriptor),
+	    vkb::initializers::write_descriptor_set(voxelization.view_descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, &grid_descriptor)};
+	vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, nullptr);
+}
+
+// Run both voxelizers back to back, each bracketed by a pair of timestamps, the displayed one runs last
+void ConservativeRasterization::record_voxelization(VkCommandBuffer command_buffer, uint32_t buffer_index)
+{
+	const uint32_t          grid_size = get_voxel_grid_size();
+	VkImageSubresourceRange range     = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	VkClearColorValue       clear_value{};
+
+	voxelization.push_constants.grid_size      = grid_size;
+	voxelization.push_constants.triangle_count = voxelization.mesh.index_count / 3;
+
+	if (voxelization.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(command_buffer, voxelization.query_pool, buffer_index * 4, 4);
+	}
+
+	for (bool compute : {!voxelization.display_compute, voxelization.display_compute})
+	{
+		const VkPipelineStageFlags voxelize_stage = compute ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		const uint32_t             query          = buffer_index * 4 + (compute ? 2 : 0);
+
+		// Previous reads and writes of the grid have to finish before it is cleared
+		vkb::insert_image_memory_barrier(command_buffer, voxelization.grid.image,
+		                                 VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		                                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+		                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, range);
+		vkCmdClearColorImage(command_buffer, voxelization.grid.image, VK_IMAGE_LAYOUT_GENERAL, &clear_value, 1, &range);
+		vkb::insert_image_memory_barrier(command_buffer, voxelization.grid.image,
+		                                 VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+		                                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+		                                 VK_PIPELINE_STAGE_TRANSFER_BIT, voxelize_stage, range);
+
+		if (voxelization.query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, voxelization.query_pool, query);
+		}
+
+		if (compute)
+		{
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, voxelization.compute_pipeline);
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, voxelization.pipeline_layout, 0, 1, &voxelization.descriptor_set, 0, nullptr);
+			vkCmdPushConstants(command_buffer, voxelization.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+			                   0, sizeof(Voxelization::PushConstants), &voxelization.push_constants);
+			vkCmdDispatch(command_buffer, (voxelization.push_constants.triangle_count + 63) / 64, 1, 1);
+		}
+		else
+		{
+			VkRenderPassBeginInfo render_pass_begin_info    = vkb::initializers::render_pass_begin_info();
+			render_pass_begin_info.renderPass               = voxelization.render_pass;
+			render_pass_begin_info.framebuffer              = voxelization.grid.framebuffer;
+			render_pass_begin_info.renderArea.extent.width  = grid_size;
+			render_pass_begin_info.renderArea.extent.height = grid_size;
+			vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+			VkViewport viewport = vkb::initializers::viewport(static_cast<float>(grid_size), static_cast<float>(grid_size), 0.0f, 1.0f);
+			vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+			VkRect2D scissor = vkb::initializers::rect2D(grid_size, grid_size, 0, 0);
+			vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, voxelization.raster_pipeline);
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, voxelization.pipeline_layout, 0, 1, &voxelization.descriptor_set, 0, nullptr);
+			vkCmdPushConstants(command_buffer, voxelization.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+			                   0, sizeof(Voxelization::PushConstants), &voxelization.push_constants);
+
+			VkDeviceSize offsets[1] = {0};
+			vkCmdBindVertexBuffers(command_buffer, 0, 1, voxelization.mesh.positions->get(), offsets);
+			vkCmdBindIndexBuffer(command_buffer, voxelization.mesh.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+			// The instance index selects the projection axis
+			vkCmdDrawIndexed(command_buffer, voxelization.mesh.index_count, 3, 0, 0, 0);
+
+			vkCmdEndRenderPass(command_buffer);
+		}
+
+		if (voxelization.query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, voxelization.query_pool, query + 1);
+		}
+	}
+
+	// Make the final voxels visible to the ray marching pass
+	vkb::insert_image_memory_barrier(command_buffer, voxelization.grid.image,
+	                                 VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+	                                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+	                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, range);
+}
+
+// Retrieves the GPU time of both voxelizers of the command buffer just submitted, the frame waits for the device to be idle
+void ConservativeRasterization::get_voxelization_timing()
+{
+	if (voxelization.query_pool == VK_NULL_HANDLE || !voxelization_enabled)
+	{
+		return;
+	}
+
+	std::array<uint64_t, 4> timestamps{};
+	if (vkGetQueryPoolResults(get_device().get_handle(), voxelization.query_pool, current_buffer * 4, 4,
+	                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+	{
+		float period = get_device().get_gpu().get_properties().limits.timestampPeriod;
+
+		voxelization.raster_elapsed_ms  = static_cast<float>(timestamps[1] - timestamps[0]) * period / 1000000.0f;
+		voxelization.compute_elapsed_ms = static_cast<float>(timestamps[3] - timestamps[2]) * period / 1000000.0f;
+	}
+}
+
 void ConservativeRasterization::setup_descriptor_pool()
 {
 	std::vector<VkDescriptorPoolSize> pool_sizes = {
-	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3),
-	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)};
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4),
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2),
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2),
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2)};
 	VkDescriptorPoolCreateInfo descriptor_pool_info =
-	    vkb::initializers::descriptor_pool_create_info(pool_sizes, 2);
+	    vkb::initializers::descriptor_pool_create_info(pool_sizes, 4);
 	VK_CHECK(vkCreateDescriptorPool(get_device().get_handle(), &descriptor_pool_info, nullptr, &descriptor_pool));
 }
 
@@ -563,6 +996,19 @@ void ConservativeRasterization::update_uniform_buffers_scene()
 	ubo_scene.projection = camera.matrices.perspective;
 	ubo_scene.model      = camera.matrices.view;
 	uniform_buffers.scene->convert_and_update(ubo_scene);
+
+	if (voxelization.uniform_buffer)
+	{
+		update_uniform_buffers_voxel_view();
+	}
+}
+
+void ConservativeRasterization::update_uniform_buffers_voxel_view()
+{
+	voxelization.ubo_view.inverse_view_projection = glm::inverse(camera.matrices.perspective * camera.matrices.view);
+	voxelization.ubo_view.camera_position         = glm::inverse(camera.matrices.view)[3];
+	voxelization.ubo_view.grid_size               = get_voxel_grid_size();
+	voxelization.uniform_buffer->convert_and_update(voxelization.ubo_view);
 }
 
 void ConservativeRasterization::draw()
@@ -588,12 +1034,14 @@ bool ConservativeRasterization::prepare(vkb::Platform &platform)
 	camera.set_translation(glm::vec3(0.0f, 0.0f, -2.0f));
 
 	load_assets();
+	load_voxelization_mesh();
 	prepare_offscreen();
 	prepare_uniform_buffers();
 	setup_descriptor_set_layout();
 	prepare_pipelines();
 	setup_descriptor_pool();
 	setup_descriptor_set();
+	prepare_voxelization();
 	build_command_buffers();
 	prepared = true;
 	return true;
@@ -604,6 +1052,7 @@ void ConservativeRasterization::render(float delta_time)
 	if (!prepared)
 		return;
 	draw();
+	get_voxelization_timing();
 	if (camera.updated)
 		update_uniform_buffers_scene();
 }
@@ -616,6 +1065,32 @@ void ConservativeRasterization::on_update_ui_overlay(vkb::Drawer &drawer)
 		{
 			build_command_buffers();
 		}
+		if (drawer.checkbox("Voxelization", &voxelization_enabled))
+		{
+			build_command_buffers();
+		}
+	}
+	if (voxelization_enabled && drawer.header("Voxelization"))
+	{
+		const std::vector<std::string> grid_sizes = {"32", "64", "128", "256"};
+		if (drawer.combo_box("Grid size", &voxelization.grid_size_index, grid_sizes))
+		{
+			get_device().wait_idle();
+			destroy_voxel_grid();
+			prepare_voxel_grid();
+			update_voxel_descriptor_sets();
+			update_uniform_buffers_voxel_view();
+			build_command_buffers();
+		}
+		if (drawer.checkbox("Display compute result", &voxelization.display_compute))
+		{
+			build_command_buffers();
+		}
+		if (voxelization.query_pool != VK_NULL_HANDLE)
+		{
+			drawer.text("Conservative raster: %.3f ms", voxelization.raster_elapsed_ms);
+			drawer.text("Compute: %.3f ms", voxelization.compute_elapsed_ms);
+		}
 	}
 	if (drawer.header("Device properties"))
 	{
@@ -21,6 +21,9 @@
  * Note: Requires a device that supports the VK_EXT_conservative_rasterization extension
  *
  * Uses an offscreen buffer with lower resolution to demonstrate the effect of conservative rasterization
+ *
+ * The voxelization mode fills a 3D grid with a torus using conservative rasterization and atomic image writes,
+ * and compares it against a compute shader that does a triangle/box overlap test per voxel
  */
 
 #pragma once
@@ -37,6 +40,7 @@ class ConservativeRasterization : public ApiVulkanSample
 	VkPhysicalDeviceConservativeRasterizationPropertiesEXT conservative_raster_properties{};
 
 	bool conservative_raster_enabled = true;
+	bool voxelization_enabled        = false;
 
 	struct Vertex
 	{
@@ -107,18 +111,82 @@ class ConservativeRasterization : public ApiVulkanSample
 		VkDescriptorImageInfo descriptor;
 	} offscreen_pass;
 
+	// Voxelization of a torus into a grid_size^3 R32_UINT storage image, done with either conservative rasterization or compute
+	struct Voxelization
+	{
+		struct Mesh
+		{
+			std::unique_ptr<vkb::core::Buffer> positions;
+			std::unique_ptr<vkb::core::Buffer> indices;
+			uint32_t                           index_count;
+		} mesh;
+
+		struct Grid
+		{
+			VkImage        image       = VK_NULL_HANDLE;
+			VkDeviceMemory mem         = VK_NULL_HANDLE;
+			VkImageView    view        = VK_NULL_HANDLE;
+			VkFramebuffer  framebuffer = VK_NULL_HANDLE;
+		} grid;
+
+		// Shared by the voxelize.vert/frag and voxelize.comp shaders
+		struct PushConstants
+		{
+			uint32_t grid_size;
+			uint32_t triangle_count;
+		} push_constants;
+
+		struct UboView
+		{
+			glm::mat4 inverse_view_projection;
+			glm::vec4 camera_position;
+			uint32_t  grid_size;
+		} ubo_view;
+
+		std::unique_ptr<vkb::core::Buffer> uniform_buffer;
+
+		int32_t grid_size_index = 1;
+		bool    display_compute = false;
+
+		VkRenderPass          render_pass = VK_NULL_HANDLE;
+		VkDescriptorSetLayout descriptor_set_layout;
+		VkDescriptorSetLayout view_descriptor_set_layout;
+		VkDescriptorSet       descriptor_set;
+		VkDescriptorSet       view_descriptor_set;
+		VkPipelineLayout      pipeline_layout;
+		VkPipelineLayout      view_pipeline_layout;
+		VkPipeline            raster_pipeline  = VK_NULL_HANDLE;
+		VkPipeline            compute_pipeline = VK_NULL_HANDLE;
+		VkPipeline            view_pipeline    = VK_NULL_HANDLE;
+
+		// GPU timestamps around both voxelizers, four per command buffer
+		VkQueryPool query_pool         = VK_NULL_HANDLE;
+		float       raster_elapsed_ms  = 0.0f;
+		float       compute_elapsed_ms = 0.0f;
+	} voxelization;
+
+	uint32_t get_voxel_grid_size() const;
+
 	ConservativeRasterization();
 	~ConservativeRasterization();
 	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
 	void         build_command_buffers() override;
 	void         prepare_offscreen();
 	void         load_assets();
+	void         load_voxelization_mesh();
+	void         prepare_voxel_grid();
+	void         destroy_voxel_grid();
+	void         prepare_voxelization();
+	void         update_voxel_descriptor_sets();
+	void         record_voxelization(VkCommandBuffer command_buffer, uint32_t buffer_index);
+	void         get_voxelization_timing();
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layout();
 	void         setup_descriptor_set();
 	void         prepare_pipelines();
 	void         prepare_uniform_buffers();
 	void         update_uniform_buffers_scene();
+	void         update_uniform_buffers_voxel_view();
 	void         draw();
 	bool         prepare(vkb::Platform &platform) override;
 	virtual void render(float delta_time) override;
@@ -89,88 +89,66 @@ void DebugUtils::debug_check_extension()
 
 /*
  * Command buffer debug labeling functions
+ * These go through the framework's debug utils dispatch, which only labels while a debugging tool is detected
+ * or labelling is switched on from the UI, so rendering without a tool does not pay for the labels
  */
 
-void DebugUtils::cmd_begin_label(VkCommandBuffer command_buffer, const char *label_name, std::vector<float> color)
+void DebugUtils::cmd_begin_label(VkCommandBuffer command_buffer, const char *label_name, const std::array<float, 4> &color)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
-	label.pLabelName           = label_name;
-	label.color[0]             = color[0];
-	label.color[1]             = color[1];
-	label.color[2]             = color[2];
-	label.color[3]             = color[3];
-	vkCmdBeginDebugUtilsLabelEXT(command_buffer, &label);
+	vkb::debug_utils::cmd_begin_label(command_buffer, label_name, color.data());
 }
 
-void DebugUtils::cmd_insert_label(VkCommandBuffer command_buffer, const char *label_name, std::vector<float> color)
+void DebugUtils::cmd_insert_label(VkCommandBuffer command_buffer, const char *label_name, const std::array<float, 4> &color)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
-	label.pLabelName           = label_name;
-	label.color[0]             = color[0];
-	label.color[1]             = color[1];
-	label.color[2]             = color[2];
-	label.color[3]             = color[3];
-	vkCmdInsertDebugUtilsLabelEXT(command_buffer, &label);
+	vkb::debug_utils::cmd_insert_label(command_buffer, label_name, color.data());
 }
 
 void DebugUtils::cmd_end_label(VkCommandBuffer command_buffer)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	vkCmdEndDebugUtilsLabelEXT(command_buffer);
+	vkb::debug_utils::cmd_end_label(command_buffer);
 }
 
 /*
  * Queue debug labeling functions
  */
 
-void DebugUtils::queue_begin_label(VkQueue queue, const char *label_name, std::vector<float> color)
+void DebugUtils::queue_begin_label(VkQueue queue, const char *label_name, const std::array<float, 4> &color)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
-	label.pLabelName           = label_name;
-	label.color[0]             = color[0];
-	label.color[1]             = color[1];
-	label.color[2]             = color[2];
-	label.color[3]             = color[3];
-	vkQueueBeginDebugUtilsLabelEXT(queue, &label);
+	vkb::debug_utils::queue_begin_label(queue, label_name, color.data());
 }
 
-void DebugUtils::queue_insert_label(VkQueue queue, const char *label_name, std::vector<float> color)
+void DebugUtils::queue_insert_label(VkQueue queue, const char *label_name, const std::array<float, 4> &color)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
-	label.pLabelName           = label_name;
-	label.color[0]             = color[0];
-	label.color[1]             = color[1];
-	label.color[2]             = color[2];
-	label.color[3]             = color[3];
-	vkQueueInsertDebugUtilsLabelEXT(queue, &label);
+	vkb::debug_utils::queue_insert_label(queue, label_name, color.data());
 }
 
 void DebugUtils::queue_end_label(VkQueue queue)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	vkQueueEndDebugUtilsLabelEXT(queue);
+	vkb::debug_utils::queue_end_label(queue);
 }
 
 /*
@@ -179,15 +157,11 @@ void DebugUtils::queue_end_label(VkQueue queue)
 
 void DebugUtils::set_object_name(VkObjectType object_type, uint64_t object_handle, const char *object_name)
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
-	VkDebugUtilsObjectNameInfoEXT name_info = {VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT};
-	name_info.objectType                    = object_type;
-	name_info.objectHandle                  = object_handle;
-	name_info.pObjectName                   = object_name;
-	vkSetDebugUtilsObjectNameEXT(device->get_handle(), &name_info);
+	vkb::debug_utils::set_object_name(device->get_handle(), object_type, object_handle, object_name);
 }
 
 /*
@@ -204,21 +178,8 @@ VkPipelineShaderStageCreateInfo DebugUtils::debug_load_shader(const std::string
 	assert(shader_stage.module != VK_NULL_HANDLE);
 	shader_modules.push_back(shader_stage.module);
 
-	if (debug_utils_supported)
-	{
-		// Name the sader (by file name)
-		set_object_name(VK_OBJECT_TYPE_SHADER_MODULE, (uint64_t) shader_stage.module, std::string("Shader " + file).c_str());
-
-		std::vector<uint8_t> buffer = vkb::fs::read_shader(file);
-		// Pass the source GLSL shader code via an object tag
-		VkDebugUtilsObjectTagInfoEXT info = {VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_TAG_INFO_EXT};
-		info.objectType                   = VK_OBJECT_TYPE_SHADER_MODULE;
-		info.objectHandle                 = (uint64_t) shader_stage.module;
-		info.tagName                      = 1;
-		info.tagSize                      = buffer.size() * sizeof(uint8_t);
-		info.pTag                         = buffer.data();
-		vkSetDebugUtilsObjectTagEXT(device->get_handle(), &info);
-	}
+	// The shader is named and tagged in debug_name_objects, so the source is only read when labelling is enabled
+	named_shader_modules.emplace_back(shader_stage.module, file);
 
 	return shader_stage;
 }
@@ -226,13 +187,25 @@ VkPipelineShaderStageCreateInfo DebugUtils::debug_load_shader(const std::string
 /*
  * Name and tag some Vulkan objects
  * All objects named in this function will appear with the those names in a debugging tool
+ * This is deferred until labelling is enabled, so the names are not built when no tool is there to show them
  */
 void DebugUtils::debug_name_objects()
 {
-	if (!debug_utils_supported)
+	if (!vkb::debug_utils::is_enabled())
 	{
 		return;
 	}
+
+	for (auto &shader_module : named_shader_modules)
+	{
+		// Name the shader (by file name)
+		set_object_name(VK_OBJECT_TYPE_SHADER_MODULE, (uint64_t) shader_module.first, std::string("Shader " + shader_module.second).c_str());
+
+		// Pass the source GLSL shader code via an object tag
+		std::vector<uint8_t> buffer = vkb::fs::read_shader(shader_module.second);
+		vkb::debug_utils::set_object_tag(device->get_handle(), VK_OBJECT_TYPE_SHADER_MODULE, (uint64_t) shader_module.first, 1, buffer.data(), buffer.size() * sizeof(uint8_t));
+	}
+
 	set_object_name(VK_OBJECT_TYPE_BUFFER, (uint64_t) uniform_buffers.matrices->get_handle(), "Matrices uniform buffer");
 
 	set_object_name(VK_OBJECT_TYPE_PIPELINE, (uint64_t) pipelines.skysphere, "Skysphere pipeline");
@@ -264,8 +237,8 @@ void DebugUtils::debug_name_objects()
 	set_object_name(VK_OBJECT_TYPE_IMAGE, (uint64_t) depth_stencil.image, "Base depth/stencil image");
 	for (size_t i = 0; i < swapchain_buffers.size(); i++)
 	{
-		std::string name = "Swapchain image" + std::to_string(i);
-		set_object_name(VK_OBJECT_TYPE_IMAGE, (uint64_t) swapchain_buffers[i].image, name.c_str());
+		vkb::debug_utils::set_object_name_lazy(device->get_handle(), VK_OBJECT_TYPE_IMAGE, (uint64_t) swapchain_buffers[i].image,
+		                                       [i]() { return "Swapchain image" + std::to_string(i); });
 	}
 
 	set_object_name(VK_OBJECT_TYPE_SAMPLER, (uint64_t) offscreen.sampler, "Offscreen pass sampler");
@@ -1047,7 +1020,11 @@ void DebugUtils::update_uniform_buffers()
 
 void DebugUtils::draw()
 {
-	queue_begin_label(queue, std::string("Graphics queue command buffer " + std::to_string(current_buffer) + " submission").c_str(), {1.0f, 1.0f, 1.0f, 1.0f});
+	// Only build the per frame label name while labelling
+	if (vkb::debug_utils::is_enabled())
+	{
+		queue_begin_label(queue, std::string("Graphics queue command buffer " + std::to_string(current_buffer) + " submission").c_str(), {1.0f, 1.0f, 1.0f, 1.0f});
+	}
 	ApiVulkanSample::prepare_frame();
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
@@ -1097,7 +1074,14 @@ void DebugUtils::on_update_ui_overlay(vkb::Drawer &drawer)
 {
 	if (debug_utils_supported)
 	{
-		drawer.text("Debug utilities enabled");
+		bool labels = vkb::debug_utils::is_enabled();
+		if (drawer.checkbox("Debug labels and object names", &labels))
+		{
+			vkb::debug_utils::set_enabled(labels);
+			// Names are set when labelling gets switched on, and the command buffers are recorded again with or without labels
+			debug_name_objects();
+			build_command_buffers();
+		}
 	}
 	else
 	{
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "api_vulkan_sample.h"
+#include "common/debug_utils.h"
 
 class DebugUtils : public ApiVulkanSample
 {
@@ -31,6 +32,9 @@ class DebugUtils : public ApiVulkanSample
 	bool display_skysphere     = true;
 	bool debug_utils_supported = false;
 
+	// Shader modules and the files they were loaded from, named once labelling is enabled
+	std::vector<std::pair<VkShaderModule, std::string>> named_shader_modules;
+
 	struct
 	{
 		Texture skysphere;
@@ -128,11 +132,11 @@ class DebugUtils : public ApiVulkanSample
 	DebugUtils();
 	~DebugUtils();
 	void                            debug_check_extension();
-	void                            cmd_begin_label(VkCommandBuffer command_buffer, const char *label_name, std::vector<float> color);
-	void                            cmd_insert_label(VkCommandBuffer command_buffer, const char *label_name, std::vector<float> color);
+	void                            cmd_begin_label(VkCommandBuffer command_buffer, const char *label_name, const std::array<float, 4> &color);
+	void                            cmd_insert_label(VkCommandBuffer command_buffer, const char *label_name, const std::array<float, 4> &color);
 	void                            cmd_end_label(VkCommandBuffer command_buffer);
-	void                            queue_begin_label(VkQueue queue, const char *label_name, std::vector<float> color);
-	void                            queue_insert_label(VkQueue queue, const char *label_name, std::vector<float> color);
+	void                            queue_begin_label(VkQueue queue, const char *label_name, const std::array<float, 4> &color);
+	void                            queue_insert_label(VkQueue queue, const char *label_name, const std::array<float, 4> &color);
 	void                            queue_end_label(VkQueue queue);
 	void                            set_object_name(VkObjectType object_type, uint64_t object_handle, const char *object_name);
 	VkPipelineShaderStageCreateInfo debug_load_shader(const std::string &file, VkShaderStageFlagBits stage);
@@ -31,88 +31,6 @@
 
 #include "raytracing_basic.h"
 
-/*
-	Create a scratch buffer used as a temporary storage in various ray tracing structures
-*/
-RayTracingScratchBuffer::RayTracingScratchBuffer(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure) :
-    device(device)
-{
-	VkMemoryRequirements2 memory_requirements_2{};
-	memory_requirements_2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
-
-	VkAccelerationStructureMemoryRequirementsInfoKHR acceleration_memory_requirements{};
-	acceleration_memory_requirements.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR;
-	acceleration_memory_requirements.type                  = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_KHR;
-	acceleration_memory_requirements.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
-	acceleration_memory_requirements.accelerationStructure = acceleration_structure;
-	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &acceleration_memory_requirements, &memory_requirements_2);
-
-	VkBufferCreateInfo buffer_create_info{};
-	buffer_create_info.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size        = memory_requirements_2.memoryRequirements.size;
-	buffer_create_info.usage       = VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	VK_CHECK(vkCreateBuffer(device.get_handle(), &buffer_create_info, nullptr, &buffer));
-
-	VkMemoryRequirements memory_requirements{};
-	vkGetBufferMemoryRequirements(device.get_handle(), buffer, &memory_requirements);
-
-	VkMemoryAllocateFlagsInfo memory_allocate_flags_info{};
-	memory_allocate_flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-	memory_allocate_flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-
-	VkMemoryAllocateInfo memory_allocate_info{};
-	memory_allocate_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.pNext           = &memory_allocate_flags_info;
-	memory_allocate_info.allocationSize  = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = device.get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device.get_handle(), &memory_allocate_info, nullptr, &memory));
-	VK_CHECK(vkBindBufferMemory(device.get_handle(), buffer, memory, 0));
-
-	VkBufferDeviceAddressInfoKHR buffer_device_address_info{};
-	buffer_device_address_info.sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
-	buffer_device_address_info.buffer = buffer;
-	device_address                    = vkGetBufferDeviceAddressKHR(device.get_handle(), &buffer_device_address_info);
-}
-
-RayTracingScratchBuffer::~RayTracingScratchBuffer()
-{
-	// Scratch buffers can be safely deleted after the acceleration structure has been built
-	if (memory != VK_NULL_HANDLE)
-	{
-		vkFreeMemory(device.get_handle(), memory, nullptr);
-	}
-	if (buffer != VK_NULL_HANDLE)
-	{
-		vkDestroyBuffer(device.get_handle(), buffer, nullptr);
-	}
-}
-
-/*
-	Create memory that will be attached to an acceleration structure
-*/
-RayTracingObjectMemory::RayTracingObjectMemory(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure) :
-    device(device)
-{
-	VkMemoryRequirements2 memory_requirements_2{};
-	memory_requirements_2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
-
-	VkAccelerationStructureMemoryRequirementsInfoKHR acceleration_memory_requirements{};
-	acceleration_memory_requirements.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR;
-	acceleration_memory_requirements.type                  = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_OBJECT_KHR;
-	acceleration_memory_requirements.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
-	acceleration_memory_requirements.accelerationStructure = acceleration_structure;
-	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &acceleration_memory_requirements, &memory_requirements_2);
-
-	VkMemoryRequirements memory_requirements = memory_requirements_2.memoryRequirements;
-
-	VkMemoryAllocateInfo memory_allocate_info{};
-	memory_allocate_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize  = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = device.get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device.get_handle(), &memory_allocate_info, nullptr, &memory));
-}
-
 RaytracingBasic::RaytracingBasic()
 {
 	title = "VK_KHR_ray_tracing";
@@ -137,8 +55,8 @@ RaytracingBasic::~RaytracingBasic()
 		vkDestroyImageView(get_device().get_handle(), storage_image.view, nullptr);
 		vkDestroyImage(get_device().get_handle(), storage_image.image, nullptr);
 		vkFreeMemory(get_device().get_handle(), storage_image.memory, nullptr);
-		vkDestroyAccelerationStructureKHR(device->get_handle(), bottom_level_acceleration_structure, nullptr);
-		vkDestroyAccelerationStructureKHR(device->get_handle(), top_level_acceleration_structure, nullptr);
+		top_level_acceleration_structure.reset();
+		acceleration_structure_builder.reset();
 		vertex_buffer.reset();
 		index_buffer.reset();
 		shader_binding_table.reset();
@@ -258,194 +176,33 @@ void RaytracingBasic::create_scene()
 		                                                   VMA_MEMORY_USAGE_CPU_TO_GPU);
 		index_buffer->update(indices.data(), index_buffer_size);
 
-		VkDeviceOrHostAddressConstKHR vertex_data_device_address{};
-		VkDeviceOrHostAddressConstKHR index_data_device_address{};
-
-		vertex_data_device_address.deviceAddress = get_buffer_device_address(vertex_buffer->get_handle());
-		index_data_device_address.deviceAddress  = get_buffer_device_address(index_buffer->get_handle());
-
-		VkAccelerationStructureCreateGeometryTypeInfoKHR acceleration_create_geometry_info{};
-		acceleration_create_geometry_info.sType             = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR;
-		acceleration_create_geometry_info.geometryType      = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
-		acceleration_create_geometry_info.maxPrimitiveCount = 1;
-		acceleration_create_geometry_info.indexType         = VK_INDEX_TYPE_UINT32;
-		acceleration_create_geometry_info.maxVertexCount    = static_cast<uint32_t>(vertices.size());
-		acceleration_create_geometry_info.vertexFormat      = VK_FORMAT_R32G32B32_SFLOAT;
-		acceleration_create_geometry_info.allowsTransforms  = VK_FALSE;
-
-		VkAccelerationStructureCreateInfoKHR acceleration_create_info{};
-		acceleration_create_info.sType            = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
-		acceleration_create_info.type             = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
-		acceleration_create_info.flags            = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_create_info.maxGeometryCount = 1;
-		acceleration_create_info.pGeometryInfos   = &acceleration_create_geometry_info;
-		VK_CHECK(vkCreateAccelerationStructureKHR(device->get_handle(), &acceleration_create_info, nullptr, &bottom_level_acceleration_structure));
-
-		// Bind object memory to the top level acceleration structure
-		RayTracingObjectMemory object_memory(get_device(), bottom_level_acceleration_structure);
-
-		VkBindAccelerationStructureMemoryInfoKHR bind_acceleration_memory_info{};
-		bind_acceleration_memory_info.sType                 = VK_STRUCTURE_TYPE_BIND_ACCELERATION_STRUCTURE_MEMORY_INFO_KHR;
-		bind_acceleration_memory_info.accelerationStructure = bottom_level_acceleration_structure;
-		bind_acceleration_memory_info.memory                = object_memory.memory;
-		VK_CHECK(vkBindAccelerationStructureMemoryKHR(device->get_handle(), 1, &bind_acceleration_memory_info));
-
-		VkAccelerationStructureGeometryKHR acceleration_geometry{};
-		acceleration_geometry.sType                                       = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
-		acceleration_geometry.flags                                       = VK_GEOMETRY_OPAQUE_BIT_KHR;
-		acceleration_geometry.geometryType                                = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
-		acceleration_geometry.geometry.triangles.sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
-		acceleration_geometry.geometry.triangles.vertexFormat             = VK_FORMAT_R32G32B32_SFLOAT;
-		acceleration_geometry.geometry.triangles.vertexData.deviceAddress = vertex_data_device_address.deviceAddress;
-		acceleration_geometry.geometry.triangles.vertexStride             = sizeof(Vertex);
-		acceleration_geometry.geometry.triangles.indexType                = VK_INDEX_TYPE_UINT32;
-		acceleration_geometry.geometry.triangles.indexData.deviceAddress  = index_data_device_address.deviceAddress;
-
-		std::vector<VkAccelerationStructureGeometryKHR> acceleration_geometries           = {acceleration_geometry};
-		VkAccelerationStructureGeometryKHR *            acceleration_structure_geometries = acceleration_geometries.data();
-
-		// Create a small scratch buffer used during build of the bottom level acceleration structure
-		RayTracingScratchBuffer scratch_buffer(get_device(), bottom_level_acceleration_structure);
-
-		VkAccelerationStructureBuildGeometryInfoKHR acceleration_build_geometry_info{};
-		acceleration_build_geometry_info.sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
-		acceleration_build_geometry_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
-		acceleration_build_geometry_info.flags                     = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_build_geometry_info.update                    = VK_FALSE;
-		acceleration_build_geometry_info.dstAccelerationStructure  = bottom_level_acceleration_structure;
-		acceleration_build_geometry_info.geometryArrayOfPointers   = VK_FALSE;
-		acceleration_build_geometry_info.geometryCount             = 1;
-		acceleration_build_geometry_info.ppGeometries              = &acceleration_structure_geometries;
-		acceleration_build_geometry_info.scratchData.deviceAddress = scratch_buffer.device_address;
-
-		VkAccelerationStructureBuildOffsetInfoKHR acceleration_build_offset_info{};
-		acceleration_build_offset_info.primitiveCount  = 1;
-		acceleration_build_offset_info.primitiveOffset = 0x0;
-		acceleration_build_offset_info.firstVertex     = 0;
-		acceleration_build_offset_info.transformOffset = 0x0;
-
-		std::vector<VkAccelerationStructureBuildOffsetInfoKHR *> acceleration_build_offsets = {&acceleration_build_offset_info};
-
-		if (ray_tracing_features.rayTracingHostAccelerationStructureCommands)
-		{
-			// Implementation supports building acceleration structure building on host
-			VK_CHECK(vkBuildAccelerationStructureKHR(device->get_handle(), 1, &acceleration_build_geometry_info, acceleration_build_offsets.data()));
-		}
-		else
-		{
-			// Acceleration structure needs to be build on the device
-			VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-			vkCmdBuildAccelerationStructureKHR(command_buffer, 1, &acceleration_build_geometry_info, acceleration_build_offsets.data());
-			get_device().flush_command_buffer(command_buffer, queue);
-		}
+		vkb::core::BottomLevelGeometry geometry;
+		geometry.add_triangles(get_buffer_device_address(vertex_buffer->get_handle()), sizeof(Vertex), static_cast<uint32_t>(vertices.size()),
+		                       get_buffer_device_address(index_buffer->get_handle()), VK_INDEX_TYPE_UINT32, 1);
 
-		VkAccelerationStructureDeviceAddressInfoKHR acceleration_device_address_info{};
-		acceleration_device_address_info.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
-		acceleration_device_address_info.accelerationStructure = bottom_level_acceleration_structure;
+		// The builder batches the bottom level builds of a scene with a shared scratch buffer and compacts them afterwards
+		acceleration_structure_builder = std::make_unique<vkb::core::AccelerationStructureBuilder>(get_device());
+		bottom_level_index             = acceleration_structure_builder->add_bottom_level(std::move(geometry));
+		acceleration_structure_builder->build(queue);
 
-		bottom_level_acceleration_structure_handle = vkGetAccelerationStructureDeviceAddressKHR(device->get_handle(), &acceleration_device_address_info);
+		LOGI("Bottom level acceleration structures: {} bytes, {} bytes before compaction",
+		     acceleration_structure_builder->get_compacted_size(), acceleration_structure_builder->get_uncompacted_size());
 	}
 
 	/*
 		Create the top level acceleration structure containing geometry instances
 	*/
 	{
-		VkAccelerationStructureCreateGeometryTypeInfoKHR acceleration_create_geometry_info{};
-		acceleration_create_geometry_info.sType             = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR;
-		acceleration_create_geometry_info.geometryType      = VK_GEOMETRY_TYPE_INSTANCES_KHR;
-		acceleration_create_geometry_info.maxPrimitiveCount = 1;
-		acceleration_create_geometry_info.allowsTransforms  = VK_FALSE;
-
-		VkAccelerationStructureCreateInfoKHR acceleration_create_info{};
-		acceleration_create_info.sType            = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
-		acceleration_create_info.type             = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
-		acceleration_create_info.flags            = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_create_info.maxGeometryCount = 1;
-		acceleration_create_info.pGeometryInfos   = &acceleration_create_geometry_info;
-		VK_CHECK(vkCreateAccelerationStructureKHR(device->get_handle(), &acceleration_create_info, nullptr, &top_level_acceleration_structure));
-
-		// Bind object memory to the top level acceleration structure
-		RayTracingObjectMemory object_memory(get_device(), top_level_acceleration_structure);
-
-		VkBindAccelerationStructureMemoryInfoKHR bind_acceleration_memory_info{};
-		bind_acceleration_memory_info.sType                 = VK_STRUCTURE_TYPE_BIND_ACCELERATION_STRUCTURE_MEMORY_INFO_KHR;
-		bind_acceleration_memory_info.accelerationStructure = top_level_acceleration_structure;
-		bind_acceleration_memory_info.memory                = object_memory.memory;
-		VK_CHECK(vkBindAccelerationStructureMemoryKHR(device->get_handle(), 1, &bind_acceleration_memory_info));
-
-		VkTransformMatrixKHR transform_matrix = {
-		    1.0f, 0.0f, 0.0f, 0.0f,
-		    0.0f, 1.0f, 0.0f, 0.0f,
-		    0.0f, 0.0f, 1.0f, 0.0f};
-
-		VkAccelerationStructureInstanceKHR instance{};
-		instance.transform                              = transform_matrix;
-		instance.instanceCustomIndex                    = 0;
-		instance.mask                                   = 0xFF;
-		instance.instanceShaderBindingTableRecordOffset = 0;
-		instance.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-		instance.accelerationStructureReference         = bottom_level_acceleration_structure_handle;
-
-		std::unique_ptr<vkb::core::Buffer> instances_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
-		                                                                                          sizeof(instance),
-		                                                                                          VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-		                                                                                          VMA_MEMORY_USAGE_CPU_TO_GPU);
-		instances_buffer->update(&instance, sizeof(VkAccelerationStructureInstanceKHR));
-
-		VkDeviceOrHostAddressConstKHR instance_data_device_address{};
-		instance_data_device_address.deviceAddress = get_buffer_device_address(instances_buffer->get_handle());
-
-		VkAccelerationStructureGeometryKHR acceleration_geometry{};
-		acceleration_geometry.sType                                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
-		acceleration_geometry.flags                                 = VK_GEOMETRY_OPAQUE_BIT_KHR;
-		acceleration_geometry.geometryType                          = VK_GEOMETRY_TYPE_INSTANCES_KHR;
-		acceleration_geometry.geometry.instances.sType              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
-		acceleration_geometry.geometry.instances.arrayOfPointers    = VK_FALSE;
-		acceleration_geometry.geometry.instances.data.deviceAddress = instance_data_device_address.deviceAddress;
-
-		std::vector<VkAccelerationStructureGeometryKHR> acceleration_geometries           = {acceleration_geometry};
-		VkAccelerationStructureGeometryKHR *            acceleration_structure_geometries = acceleration_geometries.data();
-
-		// Create a small scratch buffer used during build of the top level acceleration structure
-		RayTracingScratchBuffer scratch_buffer(get_device(), top_level_acceleration_structure);
-
-		VkAccelerationStructureBuildGeometryInfoKHR acceleration_build_geometry_info{};
-		acceleration_build_geometry_info.sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
-		acceleration_build_geometry_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
-		acceleration_build_geometry_info.flags                     = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_build_geometry_info.update                    = VK_FALSE;
-		acceleration_build_geometry_info.srcAccelerationStructure  = VK_NULL_HANDLE;
-		acceleration_build_geometry_info.dstAccelerationStructure  = top_level_acceleration_structure;
-		acceleration_build_geometry_info.geometryArrayOfPointers   = VK_FALSE;
-		acceleration_build_geometry_info.geometryCount             = 1;
-		acceleration_build_geometry_info.ppGeometries              = &acceleration_structure_geometries;
-		acceleration_build_geometry_info.scratchData.deviceAddress = scratch_buffer.device_address;
-
-		VkAccelerationStructureBuildOffsetInfoKHR acceleration_build_offset_info{};
-		acceleration_build_offset_info.primitiveCount                                       = 1;
-		acceleration_build_offset_info.primitiveOffset                                      = 0x0;
-		acceleration_build_offset_info.firstVertex                                          = 0;
-		acceleration_build_offset_info.transformOffset                                      = 0x0;
-		std::vector<VkAccelerationStructureBuildOffsetInfoKHR *> acceleration_build_offsets = {&acceleration_build_offset_info};
-
-		if (ray_tracing_features.rayTracingHostAccelerationStructureCommands)
-		{
-			// Implementation supports building acceleration structure building on host
-			VK_CHECK(vkBuildAccelerationStructureKHR(device->get_handle(), 1, &acceleration_build_geometry_info, acceleration_build_offsets.data()));
-		}
-		else
-		{
-			// Acceleration structure needs to be build on the device
-			VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-			vkCmdBuildAccelerationStructureKHR(command_buffer, 1, &acceleration_build_geometry_info, acceleration_build_offsets.data());
-			get_device().flush_command_buffer(command_buffer, queue);
-		}
+		vkb::core::TopLevelAccelerationStructure::Instance instance;
+		instance.bottom_level = &acceleration_structure_builder->get_bottom_level(bottom_level_index);
+		instance.flags        = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
 
-		VkAccelerationStructureDeviceAddressInfoKHR acceleration_device_address_info{};
-		acceleration_device_address_info.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
-		acceleration_device_address_info.accelerationStructure = top_level_acceleration_structure;
+		// The instance never moves, so the structure doesn't need to support updates
+		top_level_acceleration_structure = std::make_unique<vkb::core::TopLevelAccelerationStructure>(get_device(), std::vector<vkb::core::TopLevelAccelerationStructure::Instance>{instance}, false);
 
-		top_level_acceleration_structure_handle = vkGetAccelerationStructureDeviceAddressKHR(device->get_handle(), &acceleration_device_address_info);
+		VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+		top_level_acceleration_structure->build(command_buffer);
+		get_device().flush_command_buffer(command_buffer, queue);
 	}
 }
 
@@ -481,10 +238,12 @@ void RaytracingBasic::create_descriptor_sets()
 	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &descriptor_set_layout, 1);
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_allocate_info, &descriptor_set));
 
+	VkAccelerationStructureKHR top_level_handle = top_level_acceleration_structure->get_structure().get_handle();
+
 	VkWriteDescriptorSetAccelerationStructureKHR descriptor_acceleration_structure_info{};
 	descriptor_acceleration_structure_info.sType                      = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
 	descriptor_acceleration_structure_info.accelerationStructureCount = 1;
-	descriptor_acceleration_structure_info.pAccelerationStructures    = &top_level_acceleration_structure;
+	descriptor_acceleration_structure_info.pAccelerationStructures    = &top_level_handle;
 
 	VkWriteDescriptorSet acceleration_structure_write{};
 	acceleration_structure_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -32,42 +32,22 @@
 #pragma once
 
 #include "api_vulkan_sample.h"
+#include "core/acceleration_structure.h"
 
 // Indices for the different ray tracing shader types used in this example
 #define INDEX_RAYGEN 0
 #define INDEX_CLOSEST_HIT 1
 #define INDEX_MISS 2
 
-// Holds data for a ray tracing scratch buffer that is used as a temporary storage
-struct RayTracingScratchBuffer
-{
-	vkb::Device &  device;
-	uint64_t       device_address = 0;
-	VkBuffer       buffer         = VK_NULL_HANDLE;
-	VkDeviceMemory memory         = VK_NULL_HANDLE;
-	RayTracingScratchBuffer(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure);
-	~RayTracingScratchBuffer();
-};
-
-// Holds data for a memory object bound to an acceleration structure
-struct RayTracingObjectMemory
-{
-	vkb::Device &  device;
-	uint64_t       device_address = 0;
-	VkDeviceMemory memory         = VK_NULL_HANDLE;
-	RayTracingObjectMemory(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure);
-};
-
 class RaytracingBasic : public ApiVulkanSample
 {
   public:
 	VkPhysicalDeviceRayTracingPropertiesKHR ray_tracing_properties{};
 	VkPhysicalDeviceRayTracingFeaturesKHR   ray_tracing_features{};
 
-	VkAccelerationStructureKHR bottom_level_acceleration_structure;
-	uint64_t                   bottom_level_acceleration_structure_handle = 0;
-	VkAccelerationStructureKHR top_level_acceleration_structure;
-	uint64_t                   top_level_acceleration_structure_handle = 0;
+	std::unique_ptr<vkb::core::AccelerationStructureBuilder>  acceleration_structure_builder;
+	uint32_t                                                  bottom_level_index = 0;
+	std::unique_ptr<vkb::core::TopLevelAccelerationStructure> top_level_acceleration_structure;
 
 	std::unique_ptr<vkb::core::Buffer> vertex_buffer;
 	std::unique_ptr<vkb::core::Buffer> index_buffer;
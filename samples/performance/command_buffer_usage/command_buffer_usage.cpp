@@ -28,6 +28,7 @@
 #include "platform/filesystem.h"
 #include "platform/platform.h"
 #include "stats/stats.h"
+#include "timer.h"
 
 CommandBufferUsage::CommandBufferUsage()
 {
@@ -36,18 +37,28 @@ CommandBufferUsage::CommandBufferUsage()
 	config.insert<vkb::IntSetting>(0, gui_secondary_cmd_buf_count, 0);
 	config.insert<vkb::BoolSetting>(0, gui_multi_threading, false);
 	config.insert<vkb::IntSetting>(0, gui_command_buffer_reset_mode, 0);
+	config.insert<vkb::BoolSetting>(0, gui_auto_tune, false);
 
 	config.insert<vkb::IntSetting>(1, gui_secondary_cmd_buf_count, 2);
 	config.insert<vkb::BoolSetting>(1, gui_multi_threading, true);
 	config.insert<vkb::IntSetting>(1, gui_command_buffer_reset_mode, 0);
+	config.insert<vkb::BoolSetting>(1, gui_auto_tune, false);
 
 	config.insert<vkb::IntSetting>(2, gui_secondary_cmd_buf_count, 2);
 	config.insert<vkb::BoolSetting>(2, gui_multi_threading, true);
 	config.insert<vkb::IntSetting>(2, gui_command_buffer_reset_mode, 1);
+	config.insert<vkb::BoolSetting>(2, gui_auto_tune, false);
 
 	config.insert<vkb::IntSetting>(3, gui_secondary_cmd_buf_count, 2);
 	config.insert<vkb::BoolSetting>(3, gui_multi_threading, true);
 	config.insert<vkb::IntSetting>(3, gui_command_buffer_reset_mode, 2);
+	config.insert<vkb::BoolSetting>(3, gui_auto_tune, false);
+
+	// Searches the thread and secondary command buffer counts of the device, starting from 2 buffers
+	config.insert<vkb::IntSetting>(4, gui_secondary_cmd_buf_count, 2);
+	config.insert<vkb::BoolSetting>(4, gui_multi_threading, true);
+	config.insert<vkb::IntSetting>(4, gui_command_buffer_reset_mode, 2);
+	config.insert<vkb::BoolSetting>(4, gui_auto_tune, true);
 }
 
 bool CommandBufferUsage::prepare(vkb::Platform &platform)
@@ -64,14 +75,17 @@ bool CommandBufferUsage::prepare(vkb::Platform &platform)
 
 	vkb::ShaderSource vert_shader("base.vert");
 	vkb::ShaderSource frag_shader("base.frag");
-	auto              scene_subpass = std::make_unique<ForwardSubpassSecondary>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+	auto              scene_subpass = std::make_unique<ForwardSubpassSecondary>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera, get_job_system());
 
 	auto render_pipeline = vkb::RenderPipeline();
 	render_pipeline.add_subpass(std::move(scene_subpass));
 
 	set_render_pipeline(std::move(render_pipeline));
 
-	stats->request_stats({vkb::StatIndex::frame_times, vkb::StatIndex::cpu_cycles});
+	stats->request_stats({vkb::StatIndex::frame_times,
+	                      vkb::StatIndex::cpu_cycles,
+	                      vkb::StatIndex::cache_graphics_pipeline_contentions,
+	                      vkb::StatIndex::cache_descriptor_set_contentions});
 
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
@@ -96,21 +110,39 @@ bool CommandBufferUsage::prepare(vkb::Platform &platform)
 
 void CommandBufferUsage::prepare_render_context()
 {
-	max_thread_count = std::max(std::thread::hardware_concurrency(), MIN_THREAD_COUNT);
+	// Every thread of the job system may record, including the main thread while it waits
+	max_thread_count = std::max(vkb::to_u32(get_job_system().get_thread_count()), MIN_THREAD_COUNT);
 	get_render_context().prepare(max_thread_count);
+
+	gui_thread_count = static_cast<int>(max_thread_count);
 }
 
 void CommandBufferUsage::update(float delta_time)
 {
 	auto &subpass_state = static_cast<ForwardSubpassSecondary *>(render_pipeline->get_active_subpass().get())->get_state();
 
+	// The tuner drives the GUI values, unchecking the option lets the next check tune again
+	if (!gui_auto_tune)
+	{
+		auto_tuning             = false;
+		has_tuned_configuration = false;
+	}
+	else if (auto_tuning)
+	{
+		update_auto_tune();
+	}
+	else if (!has_tuned_configuration)
+	{
+		start_auto_tune();
+	}
+
 	// Process GUI input
 	subpass_state.secondary_cmd_buf_count = vkb::to_u32(gui_secondary_cmd_buf_count);
 
 	use_secondary_command_buffers = subpass_state.secondary_cmd_buf_count > 0;
 
 	// If there are not enough command buffers to keep all threads busy, use fewer threads
-	subpass_state.thread_count = std::min(subpass_state.secondary_cmd_buf_count, max_thread_count);
+	subpass_state.thread_count = std::min(subpass_state.secondary_cmd_buf_count, std::max(vkb::to_u32(gui_thread_count), 1u));
 
 	subpass_state.command_buffer_reset_mode = static_cast<vkb::CommandBuffer::ResetMode>(gui_command_buffer_reset_mode);
 
@@ -137,10 +169,121 @@ void CommandBufferUsage::update(float delta_time)
 	render_context.submit(primary_command_buffer);
 }
 
+void CommandBufferUsage::start_auto_tune()
+{
+	auto_tune_results.clear();
+	auto_tune_candidates.clear();
+	auto_tune_samples.clear();
+	auto_tune_frame = 0;
+
+	// Start from the current configuration, with at least as many secondary command buffers as threads
+	auto_tune_best.secondary_cmd_buf_count = std::max(vkb::to_u32(gui_secondary_cmd_buf_count), 1u);
+	auto_tune_best.thread_count            = std::min(std::max(vkb::to_u32(gui_thread_count), 1u), auto_tune_best.secondary_cmd_buf_count);
+
+	auto_tune_candidates.push_back(auto_tune_best);
+	queue_auto_tune_candidates();
+
+	auto_tuning = true;
+
+	apply_configuration(auto_tune_candidates.back());
+}
+
+void CommandBufferUsage::update_auto_tune()
+{
+	const auto &subpass = static_cast<ForwardSubpassSecondary *>(render_pipeline->get_active_subpass().get());
+
+	// The command buffers recorded last frame were the ones of the configuration being measured
+	if (auto_tune_frame++ >= AUTO_TUNE_WARMUP_FRAMES)
+	{
+		auto_tune_samples.push_back(subpass->get_draw_time());
+	}
+
+	if (auto_tune_frame < AUTO_TUNE_WARMUP_FRAMES + AUTO_TUNE_FRAMES)
+	{
+		return;
+	}
+
+	// The median ignores the frames where the recording threads were preempted
+	std::nth_element(auto_tune_samples.begin(), auto_tune_samples.begin() + auto_tune_samples.size() / 2, auto_tune_samples.end());
+	auto_tune_results[auto_tune_candidates.back()] = auto_tune_samples[auto_tune_samples.size() / 2];
+
+	auto_tune_candidates.pop_back();
+	auto_tune_samples.clear();
+	auto_tune_frame = 0;
+
+	if (auto_tune_candidates.empty())
+	{
+		// Move to the fastest configuration measured so far, if it is significantly faster
+		auto previous_best = auto_tune_best;
+		for (auto &result : auto_tune_results)
+		{
+			if (result.second < auto_tune_results.at(auto_tune_best))
+			{
+				auto_tune_best = result.first;
+			}
+		}
+
+		if (auto_tune_results.at(auto_tune_best) > auto_tune_results.at(previous_best) * (1.0 - AUTO_TUNE_MIN_GAIN))
+		{
+			auto_tune_best = previous_best;
+		}
+
+		if (auto_tune_best == previous_best || !queue_auto_tune_candidates())
+		{
+			apply_configuration(auto_tune_best);
+
+			auto_tuning             = false;
+			has_tuned_configuration = true;
+
+			LOGI("Optimal recording configuration on {}: {} threads, {} secondary command buffers, {:.3f} ms per frame ({} configurations measured)",
+			     get_device().get_gpu().get_properties().deviceName, auto_tune_best.thread_count, auto_tune_best.secondary_cmd_buf_count,
+			     auto_tune_results.at(auto_tune_best), auto_tune_results.size());
+			return;
+		}
+	}
+
+	apply_configuration(auto_tune_candidates.back());
+}
+
+bool CommandBufferUsage::queue_auto_tune_candidates()
+{
+	auto thread_count = auto_tune_best.thread_count;
+	auto buffer_count = auto_tune_best.secondary_cmd_buf_count;
+
+	std::vector<RecordingConfiguration> neighbours{{thread_count / 2, buffer_count},
+	                                               {std::min(thread_count * 2, max_thread_count), buffer_count},
+	                                               {thread_count, buffer_count / 2},
+	                                               {thread_count, std::min(buffer_count * 2, max_secondary_command_buffer_count)}};
+
+	for (auto &neighbour : neighbours)
+	{
+		// Threads without a command buffer to record would stay idle
+		if (neighbour.thread_count == 0 || neighbour.secondary_cmd_buf_count < neighbour.thread_count)
+		{
+			continue;
+		}
+
+		if (auto_tune_results.find(neighbour) == auto_tune_results.end() &&
+		    std::find(auto_tune_candidates.begin(), auto_tune_candidates.end(), neighbour) == auto_tune_candidates.end())
+		{
+			auto_tune_candidates.push_back(neighbour);
+		}
+	}
+
+	return !auto_tune_candidates.empty();
+}
+
+void CommandBufferUsage::apply_configuration(const RecordingConfiguration &configuration)
+{
+	gui_thread_count            = static_cast<int>(configuration.thread_count);
+	gui_secondary_cmd_buf_count = static_cast<int>(configuration.secondary_cmd_buf_count);
+	gui_multi_threading         = true;
+}
+
 void CommandBufferUsage::draw_gui()
 {
 	const bool landscape = camera->get_aspect_ratio() > 1.0f;
-	uint32_t   lines     = landscape ? 3 : 5;
+	uint32_t   lines     = landscape ? 4 : 6;
 
 	const auto &subpass = static_cast<ForwardSubpassSecondary *>(render_pipeline->get_active_subpass().get());
 
@@ -155,7 +298,23 @@ void CommandBufferUsage::draw_gui()
 		    // Multi-threading (no effect if 0 secondary command buffers)
 		    ImGui::Checkbox("Multi-threading", &gui_multi_threading);
 		    ImGui::SameLine();
-		    ImGui::Text("(%d threads)", subpass->get_state().thread_count);
+		    ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.35f);
+		    ImGui::SliderInt("##thread-count", &gui_thread_count, 1, max_thread_count, "Threads: %d");
+		    ImGui::PopItemWidth();
+		    ImGui::SameLine();
+		    ImGui::Text("(%d used)", subpass->get_state().thread_count);
+
+		    // Searches the thread and command buffer counts with the lowest frame time
+		    ImGui::Checkbox("Auto-tune", &gui_auto_tune);
+		    ImGui::SameLine();
+		    if (auto_tuning)
+		    {
+			    ImGui::Text("Measuring configuration %d...", static_cast<int>(auto_tune_results.size()) + 1);
+		    }
+		    else
+		    {
+			    ImGui::Text("Chunk: %.3f ms, execute: %.3f ms", subpass->get_avg_chunk_time(), subpass->get_execute_time());
+		    }
 
 		    // Buffer management options
 		    ImGui::RadioButton("Allocate and free", &gui_command_buffer_reset_mode, static_cast<int>(vkb::CommandBuffer::ResetMode::AlwaysAllocate));
@@ -241,13 +400,14 @@ void CommandBufferUsage::draw_renderpass(vkb::CommandBuffer &primary_command_buf
 }
 
 CommandBufferUsage::ForwardSubpassSecondary::ForwardSubpassSecondary(vkb::RenderContext &render_context,
-                                                                     vkb::ShaderSource &&vertex_shader, vkb::ShaderSource &&fragment_shader, vkb::sg::Scene &scene_, vkb::sg::Camera &camera) :
-    vkb::ForwardSubpass{render_context, std::move(vertex_shader), std::move(fragment_shader), scene_, camera}
+                                                                     vkb::ShaderSource &&vertex_shader, vkb::ShaderSource &&fragment_shader, vkb::sg::Scene &scene_, vkb::sg::Camera &camera, vkb::JobSystem &job_system) :
+    vkb::ForwardSubpass{render_context, std::move(vertex_shader), std::move(fragment_shader), scene_, camera},
+    job_system{job_system}
 {
 }
 
-void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer &                                               command_buffer,
-                                                              const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
+void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer &             command_buffer,
+                                                              const vkb::CpuCulling::DrawList &nodes,
                                                               uint32_t mesh_start, uint32_t mesh_end, size_t thread_index)
 {
 	command_buffer.set_color_blend_state(color_blend_state);
@@ -264,13 +424,15 @@ void CommandBufferUsage::ForwardSubpassSecondary::record_draw(vkb::CommandBuffer
 	}
 }
 
-vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_secondary(vkb::CommandBuffer &                                               primary_command_buffer,
-                                                                                       const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
+vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_secondary(vkb::CommandBuffer &             primary_command_buffer,
+                                                                                       const vkb::CpuCulling::DrawList &nodes,
                                                                                        uint32_t mesh_start, uint32_t mesh_end, size_t thread_index)
 {
 	const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 
-	auto &secondary_command_buffer = render_context.get_active_frame().request_command_buffer(queue, state.command_buffer_reset_mode, VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+	auto &thread_context = render_context.get_active_frame().get_thread_context(thread_index);
+
+	auto &secondary_command_buffer = thread_context.request_command_buffer(queue, state.command_buffer_reset_mode, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
 
 	secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &primary_command_buffer);
 
@@ -286,27 +448,18 @@ vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_sec
 }
 void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &primary_command_buffer)
 {
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> opaque_nodes;
+	vkb::Timer draw_timer;
+	draw_timer.start();
 
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> transparent_nodes;
+	// Opaque objects are sorted in front-to-back order and transparent objects in back-to-front order
+	// Note: sorting objects does not help on PowerVR, so it can be avoided to save CPU cycles
+	vkb::CpuCulling::DrawList sorted_opaque_nodes;
+	vkb::CpuCulling::DrawList sorted_transparent_nodes;
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
+	get_sorted_nodes(sorted_opaque_nodes, sorted_transparent_nodes);
 
-	// Sort opaque objects in front-to-back order
-	// Note: sorting objects does not help on PowerVR, so it can be avoided to save CPU cycles
-	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_opaque_nodes;
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
-	{
-		sorted_opaque_nodes.push_back(node_it->second);
-	}
 	const auto opaque_submeshes = vkb::to_u32(sorted_opaque_nodes.size());
 
-	// Sort transparent objects in back-to-front order
-	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_transparent_nodes;
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
-	{
-		sorted_transparent_nodes.push_back(node_it->second);
-	}
 	const auto transparent_submeshes = vkb::to_u32(sorted_transparent_nodes.size());
 
 	light_buffer = allocate_lights<vkb::ForwardLights>(scene.get_components<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
@@ -321,20 +474,14 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 	std::vector<vkb::CommandBuffer *> secondary_command_buffers;
 	avg_draws_per_buffer = (state.secondary_cmd_buf_count > 0) ? static_cast<float>(opaque_submeshes) / state.secondary_cmd_buf_count : 0;
 
-	if (state.thread_count != thread_pool.size())
-	{
-		thread_pool.resize(state.thread_count);
-	}
-
 	if (use_secondary_command_buffers)
 	{
-		std::vector<std::future<vkb::CommandBuffer *>> secondary_cmd_buf_futures;
-
 		// Save the number of draws left over, these will be distributed among the first buffers
 		uint32_t draws_per_buffer = vkb::to_u32(std::floor(avg_draws_per_buffer));
 		uint32_t remainder_draws  = opaque_submeshes % state.secondary_cmd_buf_count;
 		uint32_t mesh_start       = 0;
 
+		std::vector<std::pair<uint32_t, uint32_t>> mesh_ranges;
 		for (uint32_t cb_count = 0; cb_count < state.secondary_cmd_buf_count; cb_count++)
 		{
 			// Latter command buffers may contain fewer draws
@@ -345,34 +492,60 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 				remainder_draws--;
 			}
 
-			if (state.multi_threading)
-			{
-				auto fut = thread_pool.push(
-				    [this, cb_count, &primary_command_buffer, &sorted_opaque_nodes, mesh_start, mesh_end](size_t thread_id) {
-					    return record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end, thread_id);
-				    });
-
-				secondary_cmd_buf_futures.push_back(std::move(fut));
-			}
-			else
-			{
-				secondary_command_buffers.push_back(record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_start, mesh_end));
-			}
+			mesh_ranges.emplace_back(mesh_start, mesh_end);
 
 			mesh_start = mesh_end;
 		}
 
+		// Jobs may finish in any order, each one stores its buffers and timings at their own index
+		std::vector<vkb::CommandBuffer *> recorded_command_buffers(state.secondary_cmd_buf_count, nullptr);
+		std::vector<double>               chunk_times(state.secondary_cmd_buf_count, 0.0);
+
+		auto record_chunk = [&](uint32_t cb_index, size_t thread_index) {
+			vkb::Timer chunk_timer;
+			chunk_timer.start();
+
+			recorded_command_buffers[cb_index] = record_draw_secondary(primary_command_buffer, sorted_opaque_nodes, mesh_ranges[cb_index].first, mesh_ranges[cb_index].second, thread_index);
+
+			chunk_times[cb_index] = chunk_timer.stop<vkb::Timer::Milliseconds>();
+		};
+
 		if (state.multi_threading)
 		{
-			for (auto &fut : secondary_cmd_buf_futures)
+			// Each job records every thread_count-th command buffer, so that the thread count is independent of the buffer count
+			vkb::JobSystem::TaskGroup recording_group{job_system};
+
+			for (uint32_t job = 0; job < state.thread_count; job++)
+			{
+				recording_group.run([this, job, &record_chunk]() {
+					auto thread_index = vkb::JobSystem::get_thread_index();
+
+					for (uint32_t cb_index = job; cb_index < state.secondary_cmd_buf_count; cb_index += state.thread_count)
+					{
+						record_chunk(cb_index, thread_index);
+					}
+				});
+			}
+
+			recording_group.wait();
+		}
+		else
+		{
+			for (uint32_t cb_index = 0; cb_index < state.secondary_cmd_buf_count; cb_index++)
 			{
-				secondary_command_buffers.push_back(fut.get());
+				record_chunk(cb_index, 0);
 			}
 		}
+
+		secondary_command_buffers = recorded_command_buffers;
+
+		avg_chunk_time = std::accumulate(chunk_times.begin(), chunk_times.end(), 0.0) / chunk_times.size();
 	}
 	else
 	{
 		record_draw(primary_command_buffer, sorted_opaque_nodes, 0, opaque_submeshes);
+
+		avg_chunk_time = 0.0;
 	}
 
 	// Enable alpha blending
@@ -396,10 +569,19 @@ void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &prima
 		}
 	}
 
+	execute_time = 0.0;
+
 	if (use_secondary_command_buffers)
 	{
+		vkb::Timer execute_timer;
+		execute_timer.start();
+
 		primary_command_buffer.execute_commands(secondary_command_buffers);
+
+		execute_time = execute_timer.stop<vkb::Timer::Milliseconds>();
 	}
+
+	draw_time = draw_timer.stop<vkb::Timer::Milliseconds>();
 }
 
 void CommandBufferUsage::ForwardSubpassSecondary::set_viewport(VkViewport &viewport)
@@ -417,6 +599,21 @@ float CommandBufferUsage::ForwardSubpassSecondary::get_avg_draws_per_buffer() co
 	return avg_draws_per_buffer;
 }
 
+double CommandBufferUsage::ForwardSubpassSecondary::get_draw_time() const
+{
+	return draw_time;
+}
+
+double CommandBufferUsage::ForwardSubpassSecondary::get_avg_chunk_time() const
+{
+	return avg_chunk_time;
+}
+
+double CommandBufferUsage::ForwardSubpassSecondary::get_execute_time() const
+{
+	return execute_time;
+}
+
 CommandBufferUsage::ForwardSubpassSecondaryState &CommandBufferUsage::ForwardSubpassSecondary::get_state()
 {
 	return state;
@@ -17,7 +17,8 @@
 
 #pragma once
 
-#include <ctpl_stl.h>
+#include <map>
+#include <tuple>
 
 #include "buffer_pool.h"
 #include "common/utils.h"
@@ -55,9 +56,30 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 		bool multi_threading = false;
 
+		// Number of recording jobs, each one records an equal share of the secondary command buffers
 		uint32_t thread_count = 0;
 	};
 
+	/**
+	 * @brief Number of recording threads and secondary command buffers the draws are split into
+	 */
+	struct RecordingConfiguration
+	{
+		uint32_t thread_count;
+
+		uint32_t secondary_cmd_buf_count;
+
+		bool operator<(const RecordingConfiguration &other) const
+		{
+			return std::tie(thread_count, secondary_cmd_buf_count) < std::tie(other.thread_count, other.secondary_cmd_buf_count);
+		}
+
+		bool operator==(const RecordingConfiguration &other) const
+		{
+			return thread_count == other.thread_count && secondary_cmd_buf_count == other.secondary_cmd_buf_count;
+		}
+	};
+
 	/**
 	 * @brief Overrides the draw method to allow for dividing draw calls
 	 *        into multiple secondary command buffers, optionally
@@ -68,7 +90,7 @@ class CommandBufferUsage : public vkb::VulkanSample
 	  public:
 		ForwardSubpassSecondary(vkb::RenderContext &render_context,
 		                        vkb::ShaderSource &&vertex_source, vkb::ShaderSource &&fragment_source,
-		                        vkb::sg::Scene &scene, vkb::sg::Camera &camera);
+		                        vkb::sg::Scene &scene, vkb::sg::Camera &camera, vkb::JobSystem &job_system);
 
 		void draw(vkb::CommandBuffer &primary_command_buffer) override;
 
@@ -78,6 +100,21 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 		float get_avg_draws_per_buffer() const;
 
+		/**
+		 * @return CPU time spent in the last draw, recording and executing the secondary command buffers, in milliseconds
+		 */
+		double get_draw_time() const;
+
+		/**
+		 * @return Average CPU time spent recording one secondary command buffer of opaque meshes in the last draw, in milliseconds
+		 */
+		double get_avg_chunk_time() const;
+
+		/**
+		 * @return CPU time spent recording vkCmdExecuteCommands in the last draw, in milliseconds
+		 */
+		double get_execute_time() const;
+
 		ForwardSubpassSecondaryState &get_state();
 
 	  private:
@@ -89,7 +126,7 @@ class CommandBufferUsage : public vkb::VulkanSample
 		 * @param mesh_end Index to the mesh where recording will stop (not included)
 		 * @param thread_index Identifies the resources allocated for this thread
 		 */
-		void record_draw(vkb::CommandBuffer &command_buffer, const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
+		void record_draw(vkb::CommandBuffer &command_buffer, const vkb::CpuCulling::DrawList &nodes,
 		                 uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
 
 		/**
@@ -103,7 +140,7 @@ class CommandBufferUsage : public vkb::VulkanSample
 		 * @param thread_index Identifies the resources allocated for this thread
 		 * @return a pointer to the recorded secondary command buffer
 		 */
-		vkb::CommandBuffer *record_draw_secondary(vkb::CommandBuffer &primary_command_buffer, const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
+		vkb::CommandBuffer *record_draw_secondary(vkb::CommandBuffer &primary_command_buffer, const vkb::CpuCulling::DrawList &nodes,
 		                                          uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
 
 		VkViewport viewport{};
@@ -118,7 +155,13 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 		float avg_draws_per_buffer{0};
 
-		ctpl::thread_pool thread_pool;
+		double draw_time{0.0};
+
+		double avg_chunk_time{0.0};
+
+		double execute_time{0.0};
+
+		vkb::JobSystem &job_system;
 
 		vkb::BufferAllocation light_buffer;
 	};
@@ -134,6 +177,26 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	void draw_gui() override;
 
+	/**
+	 * @brief Starts measuring recording configurations around the current one
+	 */
+	void start_auto_tune();
+
+	/**
+	 * @brief Records the draw time of the last frame for the configuration being measured,
+	 *        and moves on to the next configuration once it has rendered enough frames
+	 */
+	void update_auto_tune();
+
+	/**
+	 * @brief Adds the untested neighbours of the best configuration, the thread count and
+	 *        the secondary command buffer count halved and doubled
+	 * @return Whether any configuration is left to measure
+	 */
+	bool queue_auto_tune_candidates();
+
+	void apply_configuration(const RecordingConfiguration &configuration);
+
 	int gui_secondary_cmd_buf_count{0};
 
 	uint32_t max_secondary_command_buffer_count{100};
@@ -144,9 +207,36 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	bool gui_multi_threading{false};
 
+	int gui_thread_count{0};
+
+	bool gui_auto_tune{false};
+
 	const uint32_t MIN_THREAD_COUNT{4};
 
 	uint32_t max_thread_count{0};
+
+	// Frames skipped after switching configuration, while the command pools and caches settle
+	const uint32_t AUTO_TUNE_WARMUP_FRAMES{5};
+
+	const uint32_t AUTO_TUNE_FRAMES{30};
+
+	// A neighbour must be faster by this fraction to be moved to, so that noise does not make the search wander
+	const double AUTO_TUNE_MIN_GAIN{0.02};
+
+	bool auto_tuning{false};
+
+	// Median draw time of every configuration measured so far
+	std::map<RecordingConfiguration, double> auto_tune_results;
+
+	std::vector<RecordingConfiguration> auto_tune_candidates;
+
+	std::vector<double> auto_tune_samples;
+
+	uint32_t auto_tune_frame{0};
+
+	RecordingConfiguration auto_tune_best{};
+
+	bool has_tuned_configuration{false};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_command_buffer_usage();
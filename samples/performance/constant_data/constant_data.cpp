@@ -55,7 +55,7 @@ inline MVPUniform fill_mvp(vkb::sg::Node &node, vkb::sg::Camera &camera)
 
 	mvp.model = transform.get_world_matrix();
 
-	mvp.camera_view_proj = vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	mvp.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
 
 	mvp.scale = glm::mat4(1.0f);
 
@@ -79,6 +79,7 @@ ConstantData::ConstantData()
 	add_instance_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, true);
 	add_device_extension(VK_KHR_MAINTENANCE3_EXTENSION_NAME, true);
 	add_device_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, true);
+	add_device_extension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, true);
 }
 
 bool ConstantData::prepare(vkb::Platform &platform)
@@ -100,6 +101,29 @@ bool ConstantData::prepare(vkb::Platform &platform)
 		LOGW("Update-after-bind descriptor sets are not supported by your device, this sample option will be disabled.");
 	}
 
+	if (instance->is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) &&
+	    device->is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+	{
+		methods[Method::PushDescriptors].supported = true;
+	}
+	else
+	{
+		LOGW("Push descriptors are not supported by your device, this sample option will be disabled.");
+	}
+
+	// With descriptor buffers every descriptor set is written into a descriptor buffer, so the descriptor set methods would all measure the same path
+	if (device->uses_descriptor_buffers())
+	{
+		for (auto method : {Method::DescriptorSets, Method::DynamicDescriptorSets, Method::UpdateAfterBindDescriptorSets, Method::DeviceLocalDescriptorSets, Method::RingBufferDescriptorSets, Method::PushDescriptors})
+		{
+			methods[method].supported = false;
+		}
+
+		methods[Method::DescriptorBuffer].supported = true;
+
+		LOGI("Descriptor buffers are enabled, the descriptor set options will be disabled.");
+	}
+
 	// Load a scene from the assets folder
 	load_scene("scenes/bonza/Bonza4X.gltf");
 
@@ -116,9 +140,126 @@ bool ConstantData::prepare(vkb::Platform &platform)
 	stats->request_stats(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times, vkb::StatIndex::gpu_load_store_cycles});
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
+	// Benchmark every supported method in a single run
+	if (is_benchmark_mode())
+	{
+		for (size_t i = 0; i < methods.size(); ++i)
+		{
+			if (methods[static_cast<Method>(i)].supported)
+			{
+				sweep_methods.push_back(static_cast<Method>(i));
+			}
+		}
+
+		sweeping         = true;
+		gui_method_value = static_cast<int>(sweep_methods.front());
+
+		LOGI("Sweeping {} constant data methods, {} frames each", sweep_methods.size(), sweep_warmup_frames + sweep_frames);
+
+		sweep_report.begin_run(methods[sweep_methods.front()].description, get_device().get_gpu().get_properties().deviceName);
+		sweep_timer.tick();
+	}
+
 	return true;
 }
 
+void ConstantData::update(float delta_time)
+{
+	if (sweeping)
+	{
+		update_sweep();
+	}
+
+	// The rings can only be changed between frames, as the frame allocates its buffers from them
+	bool use_buffer_rings = get_active_method() == Method::RingBufferDescriptorSets;
+	if (use_buffer_rings != !get_render_context().get_buffer_rings().empty())
+	{
+		get_render_context().set_buffer_ring_size(use_buffer_rings ? ring_size : 0);
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+void ConstantData::finish()
+{
+	// The benchmark may end before every method was swept
+	if (sweeping)
+	{
+		sweep_report.end_run();
+		log_sweep_results();
+	}
+
+	VulkanSample::finish();
+}
+
+void ConstantData::update_sweep()
+{
+	// A batch run selects the method with its configurations
+	if (gui_method_value != static_cast<int>(sweep_methods[sweep_index]))
+	{
+		LOGI("Constant data method changed by the configuration, stopping the sweep");
+		sweep_report.end_run();
+		sweeping = false;
+		return;
+	}
+
+	// The CPU time covers the whole previous frame, the GPU time lags a few frames behind and is covered by the warmup
+	sweep_report.add_frame(sweep_timer.tick<vkb::Timer::Milliseconds>(), get_gpu_frame_time());
+
+	if (++sweep_frame < sweep_warmup_frames + sweep_frames)
+	{
+		return;
+	}
+
+	sweep_report.end_run();
+	sweep_frame = 0;
+
+	if (++sweep_index == sweep_methods.size())
+	{
+		log_sweep_results();
+		sweeping = false;
+		return;
+	}
+
+	gui_method_value = static_cast<int>(sweep_methods[sweep_index]);
+	sweep_report.begin_run(methods[sweep_methods[sweep_index]].description, get_device().get_gpu().get_properties().deviceName);
+}
+
+void ConstantData::log_sweep_results()
+{
+	auto &runs = sweep_report.get_runs();
+	if (runs.empty() || runs.front().cpu_times.empty())
+	{
+		return;
+	}
+
+	// Relative to the first method, push constants unless unsupported
+	auto reference = vkb::BenchmarkReport::compute_statistics(runs.front().cpu_times).mean;
+
+	LOGI("Constant data methods on {}:", get_device().get_gpu().get_properties().deviceName);
+	LOGI("{:<45} {:>13} {:>13} {:>13} {:>13} {:>10}", "Method", "CPU mean (ms)", "CPU p95 (ms)", "GPU mean (ms)", "GPU p95 (ms)", "CPU ratio");
+
+	for (auto &run : runs)
+	{
+		if (run.cpu_times.empty())
+		{
+			continue;
+		}
+
+		auto cpu = vkb::BenchmarkReport::compute_statistics(run.cpu_times);
+
+		if (run.gpu_times.empty())
+		{
+			LOGI("{:<45} {:>13.3f} {:>13.3f} {:>13} {:>13} {:>10.2f}", run.name, cpu.mean, cpu.p95, "n/a", "n/a", cpu.mean / reference);
+		}
+		else
+		{
+			auto gpu = vkb::BenchmarkReport::compute_statistics(run.gpu_times);
+			LOGI("{:<45} {:>13.3f} {:>13.3f} {:>13.3f} {:>13.3f} {:>10.2f}", run.name, cpu.mean, cpu.p95, gpu.mean, gpu.p95, cpu.mean / reference);
+		}
+	}
+}
+
 void ConstantData::request_gpu_features(vkb::PhysicalDevice &gpu)
 {
 	if (gpu.get_features().vertexPipelineStoresAndAtomics)
@@ -182,6 +323,9 @@ void ConstantData::draw_renderpass(vkb::CommandBuffer &command_buffer, vkb::Rend
 			// Set the command buffer to enable updating update-after-bind bindings if we are using update-after-binds
 			command_buffer.set_update_after_bind(selected_method == Method::UpdateAfterBindDescriptorSets);
 
+			// Allocate the uniforms from device local memory, they are copied from a staging buffer before the frame is drawn
+			get_render_context().set_device_local_uniforms(selected_method == Method::DeviceLocalDescriptorSets);
+
 			last_gui_method_value = gui_method_value;
 		}
 
@@ -372,7 +516,7 @@ vkb::PipelineLayout &ConstantData::DescriptorSetSubpass::prepare_pipeline_layout
 	 */
 	for (auto &shader_module : shader_modules)
 	{
-		if (method == Method::DescriptorSets)
+		if (method == Method::DescriptorSets || method == Method::DeviceLocalDescriptorSets || method == Method::RingBufferDescriptorSets || method == Method::DescriptorBuffer)
 		{
 			shader_module->set_resource_mode("MVPUniform", vkb::ShaderResourceMode::Static);
 		}
@@ -384,6 +528,10 @@ vkb::PipelineLayout &ConstantData::DescriptorSetSubpass::prepare_pipeline_layout
 		{
 			shader_module->set_resource_mode("MVPUniform", vkb::ShaderResourceMode::UpdateAfterBind);
 		}
+		else if (method == Method::PushDescriptors)
+		{
+			shader_module->set_resource_mode("MVPUniform", vkb::ShaderResourceMode::PushDescriptor);
+		}
 	}
 
 	return command_buffer.get_device().get_resource_cache().request_pipeline_layout(shader_modules);
@@ -490,9 +638,9 @@ void ConstantData::BufferArraySubpass::draw_submesh_command(vkb::CommandBuffer &
 	if (sub_mesh.vertex_indices != 0)
 	{
 		// Bind index buffer of submesh
-		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
+		command_buffer.bind_index_buffer(sub_mesh.get_index_buffer(), sub_mesh.index_offset, sub_mesh.index_type);
 
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, instance_index++);
+		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, sub_mesh.first_index, 0, instance_index++);
 	}
 	else
 	{
@@ -24,6 +24,8 @@
 #include "rendering/subpasses/forward_subpass.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/perspective_camera.h"
+#include "stats/benchmark_report.h"
+#include "timer.h"
 #include "vulkan_sample.h"
 
 /**
@@ -57,6 +59,10 @@ struct alignas(16) MVPUniform
  *     - Dynamic Descriptor Sets
  *     - Update-after-bind Descriptor Sets
  *     - Pre-allocated buffer array
+ *     - Descriptor Sets to device local buffers, uploaded from a staging buffer
+ *     - Descriptor Sets to buffers allocated from a persistent ring
+ *     - Push Descriptors
+ *     - Descriptor Buffers, when the sample runs with --descriptor-buffers
  *
  * The sample also shows the performance implications that these different methods would have on your
  * application or game. These performance deltas may differ between platforms and vendors.
@@ -80,6 +86,10 @@ class ConstantData : public vkb::VulkanSample
 		DynamicDescriptorSets,
 		UpdateAfterBindDescriptorSets,        // May be disabled if the device doesn't support
 		BufferArray,
+		DeviceLocalDescriptorSets,
+		RingBufferDescriptorSets,
+		PushDescriptors,         // May be disabled if the device doesn't support
+		DescriptorBuffer,        // Only enabled if the device writes descriptors into descriptor buffers
 		Undefined
 	};
 
@@ -99,6 +109,10 @@ class ConstantData : public vkb::VulkanSample
 
 	virtual bool prepare(vkb::Platform &platform) override;
 
+	virtual void update(float delta_time) override;
+
+	virtual void finish() override;
+
 	/**
 	 * @brief The base subpass to help prepare the shader variants and store the push constant limit
 	 */
@@ -250,6 +264,17 @@ class ConstantData : public vkb::VulkanSample
 	 */
 	inline Method get_active_method();
 
+	/**
+	 * @brief Records the frame time of the method being swept, and moves on to the next method
+	 *        once it has rendered enough frames
+	 */
+	void update_sweep();
+
+	/**
+	 * @brief Logs the frame times of the swept methods side by side
+	 */
+	void log_sweep_results();
+
 	vkb::sg::PerspectiveCamera *camera{};
 
 	// The render pipeline designed for using push constants
@@ -267,11 +292,36 @@ class ConstantData : public vkb::VulkanSample
 	    {Method::DescriptorSets, {"Descriptor Sets"}},
 	    {Method::DynamicDescriptorSets, {"Dynamic Descriptor Sets"}},
 	    {Method::UpdateAfterBindDescriptorSets, {"Update-after-bind Descriptor Sets", false}},
-	    {Method::BufferArray, {"Single Pre-allocated Buffer Array"}}};
+	    {Method::BufferArray, {"Single Pre-allocated Buffer Array"}},
+	    {Method::DeviceLocalDescriptorSets, {"Descriptor Sets (Staged to Device Local)"}},
+	    {Method::RingBufferDescriptorSets, {"Descriptor Sets (Persistent Ring Buffer)"}},
+	    {Method::PushDescriptors, {"Push Descriptors", false}},
+	    {Method::DescriptorBuffer, {"Descriptor Buffer", false}}};
 
 	int gui_method_value{static_cast<int>(Method::PushConstants)};
 
 	int last_gui_method_value{static_cast<int>(Method::PushConstants)};
+
+	// Size of the rings the frames allocate from with the ring buffer method, enough for the MVP data of a few frames
+	static constexpr VkDeviceSize ring_size = 4 * 1024 * 1024;
+
+	// Frames rendered with each method when sweeping, after its warmup frames
+	static constexpr uint32_t sweep_frames = 200;
+
+	static constexpr uint32_t sweep_warmup_frames = 20;
+
+	// In benchmark mode the sample renders every supported method in turn, batch configurations stop the sweep
+	bool sweeping{false};
+
+	std::vector<Method> sweep_methods;
+
+	size_t sweep_index{0};
+
+	uint32_t sweep_frame{0};
+
+	vkb::Timer sweep_timer;
+
+	vkb::BenchmarkReport sweep_report{sweep_warmup_frames};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_constant_data();
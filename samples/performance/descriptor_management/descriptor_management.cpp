@@ -22,7 +22,6 @@
 #include "gui.h"
 #include "platform/filesystem.h"
 #include "platform/platform.h"
-#include "rendering/subpasses/forward_subpass.h"
 #include "stats/stats.h"
 
 DescriptorManagement::DescriptorManagement()
@@ -34,6 +33,12 @@ DescriptorManagement::DescriptorManagement()
 
 	config.insert<vkb::IntSetting>(1, descriptor_caching.value, 1);
 	config.insert<vkb::IntSetting>(1, buffer_allocation.value, 1);
+
+	config.insert<vkb::IntSetting>(2, descriptor_caching.value, 2);
+	config.insert<vkb::IntSetting>(2, buffer_allocation.value, 1);
+
+	// Lets the per-draw uniform set be pushed instead of allocated
+	add_device_extension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, true);
 }
 
 bool DescriptorManagement::prepare(vkb::Platform &platform)
@@ -52,11 +57,18 @@ bool DescriptorManagement::prepare(vkb::Platform &platform)
 
 	vkb::ShaderSource vert_shader("base.vert");
 	vkb::ShaderSource frag_shader("base.frag");
-	auto              scene_subpass   = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+	auto              subpass         = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
 	auto              render_pipeline = vkb::RenderPipeline();
-	render_pipeline.add_subpass(std::move(scene_subpass));
+	scene_subpass                     = subpass.get();
+	render_pipeline.add_subpass(std::move(subpass));
 	set_render_pipeline(std::move(render_pipeline));
 
+	// Only offer push descriptors when the device supports them
+	if (!device->is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+	{
+		radio_buttons.erase(std::find(radio_buttons.begin(), radio_buttons.end(), &push_descriptors));
+	}
+
 	// Add a GUI with the stats you want to monitor
 	stats->request_stats({vkb::StatIndex::frame_times});
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
@@ -83,6 +95,15 @@ void DescriptorManagement::update(float delta_time)
 
 	render_context.get_active_frame().set_buffer_allocation_strategy(buffer_alloc_strategy);
 
+	// Recycle the descriptor sets which are no longer requested instead of growing the pools
+	render_context.get_active_frame().set_descriptor_set_recycling(descriptor_caching.value == 2);
+
+	// Compare the per-draw set pushed into the command buffer against pooled sets
+	if (scene_subpass->is_using_push_descriptors() != (push_descriptors.value == 1))
+	{
+		scene_subpass->set_push_descriptors(push_descriptors.value == 1);
+	}
+
 	if (descriptor_caching.value == 0)
 	{
 		// Clear descriptor pools for the current frame
@@ -109,6 +130,9 @@ void DescriptorManagement::draw_gui()
 		lines = lines * 2;
 	}
 
+	// Line for the descriptor write counters
+	lines += 1;
+
 	gui->show_options_window(
 	    /* body = */ [this, lines]() {
 		    // For every option set
@@ -140,6 +164,10 @@ void DescriptorManagement::draw_gui()
 
 			    ImGui::PopID();
 		    }
+
+		    auto &counters = get_render_context().get_last_rendered_frame().get_descriptor_write_counters();
+		    ImGui::Text("Descriptor writes: %u, skipped: %u, sets recycled: %u",
+		                vkb::to_u32(counters.writes.load()), vkb::to_u32(counters.writes_skipped.load()), vkb::to_u32(counters.sets_recycled.load()));
 	    },
 	    /* lines = */ vkb::to_u32(lines));
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "rendering/render_pipeline.h"
+#include "rendering/subpasses/forward_subpass.h"
 #include "scene_graph/components/perspective_camera.h"
 #include "vulkan_sample.h"
 
@@ -46,7 +47,7 @@ class DescriptorManagement : public vkb::VulkanSample
 
 	RadioButtonGroup descriptor_caching{
 	    "Descriptor set caching",
-	    {"Disabled", "Enabled"},
+	    {"Disabled", "Enabled", "Recycling"},
 	    0};
 
 	RadioButtonGroup buffer_allocation{
@@ -54,10 +55,17 @@ class DescriptorManagement : public vkb::VulkanSample
 	    {"Disabled", "Enabled"},
 	    0};
 
-	std::vector<RadioButtonGroup *> radio_buttons = {&descriptor_caching, &buffer_allocation};
+	RadioButtonGroup push_descriptors{
+	    "Push descriptors",
+	    {"Disabled", "Enabled"},
+	    0};
+
+	std::vector<RadioButtonGroup *> radio_buttons = {&descriptor_caching, &buffer_allocation, &push_descriptors};
 
 	vkb::sg::PerspectiveCamera *camera{nullptr};
 
+	vkb::ForwardSubpass *scene_subpass{nullptr};
+
 	virtual void draw_gui() override;
 };
 
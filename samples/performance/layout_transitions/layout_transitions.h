@@ -38,7 +38,8 @@ class LayoutTransitions : public vkb::VulkanSample
 	enum LayoutTransitionType : int
 	{
 		UNDEFINED,
-		LAST_LAYOUT
+		LAST_LAYOUT,
+		RENDER_GRAPH
 	};
 
 	vkb::sg::Camera *camera{nullptr};
@@ -53,10 +54,32 @@ class LayoutTransitions : public vkb::VulkanSample
 
 	VkImageLayout pick_old_layout(VkImageLayout last_layout);
 
+	/**
+	 * @brief Builds the same frame as the render pipelines with a render graph, which derives the transitions and load stores
+	 */
+	void prepare_render_graph();
+
+	/**
+	 * @return The bytes of attachments loaded and stored by the render pipelines per frame
+	 */
+	uint64_t get_attachment_traffic(const std::vector<vkb::RenderPipeline *> &pipelines, vkb::RenderTarget &render_target) const;
+
 	vkb::RenderPipeline gbuffer_pipeline;
 
 	vkb::RenderPipeline lighting_pipeline;
 
+	std::unique_ptr<vkb::RenderGraph> render_graph;
+
+	/// Image barriers recorded per frame by the manual transitions and by the render graph
+	size_t manual_barrier_count{0};
+
+	size_t graph_barrier_count{0};
+
+	/// Attachment load and store bytes per frame of the manual render pipelines and of the render graph
+	uint64_t manual_attachment_traffic{0};
+
+	uint64_t graph_attachment_traffic{0};
+
 	LayoutTransitionType layout_transition_type{LayoutTransitionType::UNDEFINED};
 };
 
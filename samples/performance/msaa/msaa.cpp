@@ -17,6 +17,10 @@
 
 #include "msaa.h"
 
+#include <fstream>
+
+#include <json.hpp>
+
 #include "common/vk_common.h"
 #include "gltf_loader.h"
 #include "gui.h"
@@ -24,10 +28,16 @@
 #include "platform/platform.h"
 #include "rendering/subpasses/forward_subpass.h"
 #include "rendering/subpasses/postprocessing_subpass.h"
+#include "stats/benchmark_report.h"
 #include "stats/stats.h"
 
 namespace
 {
+// Counters recorded by the sweep, the pipeline statistics stand in for bandwidth where the GPU counters are not available
+const std::vector<std::pair<vkb::StatIndex, const char *>> sweep_stats = {{vkb::StatIndex::gpu_ext_read_bytes, "gpu_ext_read_bytes"},
+                                                                          {vkb::StatIndex::gpu_ext_write_bytes, "gpu_ext_write_bytes"},
+                                                                          {vkb::StatIndex::gpu_fragment_invocations, "gpu_fragment_invocations"}};
+
 const std::string to_string(VkSampleCountFlagBits count)
 {
 	switch (count)
@@ -123,14 +133,31 @@ bool MSAASample::prepare(vkb::Platform &platform)
 	postprocessing_pipeline                  = std::make_unique<vkb::RenderPipeline>();
 	postprocessing_pipeline->add_subpass(std::move(postprocessing_subpass));
 
+	vkb::ShaderSource composite_vs(vkb::fs::read_shader("postprocessing/postprocessing.vert"));
+	vkb::ShaderSource composite_fs(vkb::fs::read_shader("postprocessing/composite.frag"));
+	auto              composite_subpass = std::make_unique<vkb::PostProcessingSubpass>(get_render_context(), std::move(composite_vs), std::move(composite_fs), *scene, *camera);
+	composite_pipeline                  = std::make_unique<vkb::RenderPipeline>();
+	composite_pipeline->add_subpass(std::move(composite_subpass));
+
 	update_pipelines();
 
-	stats->request_stats({vkb::StatIndex::frame_times,
-	                      vkb::StatIndex::gpu_ext_read_bytes,
-	                      vkb::StatIndex::gpu_ext_write_bytes});
+	std::set<vkb::StatIndex> requested_stats{vkb::StatIndex::frame_times,
+	                                         vkb::StatIndex::gpu_ext_read_bytes,
+	                                         vkb::StatIndex::gpu_ext_write_bytes};
+	if (is_benchmark_mode())
+	{
+		requested_stats.insert(vkb::StatIndex::gpu_fragment_invocations);
+	}
+	stats->request_stats(requested_stats);
 
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
+	// Benchmark every supported combination in a single run
+	if (is_benchmark_mode())
+	{
+		prepare_sweep();
+	}
+
 	return true;
 }
 
@@ -144,7 +171,7 @@ std::unique_ptr<vkb::RenderTarget> MSAASample::create_render_target(vkb::core::I
 	auto &device = swapchain_image.get_device();
 	auto &extent = swapchain_image.get_extent();
 
-	auto              depth_format        = vkb::get_suitable_depth_format(device.get_gpu().get_handle());
+	auto              depth_format        = vkb::get_suitable_depth_format(device.get_gpu());
 	bool              msaa_enabled        = sample_count != VK_SAMPLE_COUNT_1_BIT;
 	VkImageUsageFlags depth_usage         = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 	VkImageUsageFlags depth_resolve_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
@@ -277,6 +304,11 @@ std::unique_ptr<vkb::RenderTarget> MSAASample::create_render_target(vkb::core::I
 
 void MSAASample::update(float delta_time)
 {
+	if (sweeping)
+	{
+		update_sweep();
+	}
+
 	if ((gui_run_postprocessing != last_gui_run_postprocessing) ||
 	    (gui_sample_count != last_gui_sample_count) ||
 	    (gui_color_resolve_method != last_gui_color_resolve_method) ||
@@ -393,6 +425,7 @@ void MSAASample::update_for_scene_and_postprocessing(bool msaa_enabled)
 
 	// Update the postprocessing renderpass
 	postprocessing_pipeline->set_load_store(postprocessing_load_store);
+	composite_pipeline->set_load_store(postprocessing_load_store);
 }
 
 void MSAASample::use_multisampled_color(std::unique_ptr<vkb::Subpass> &subpass, std::vector<vkb::LoadStoreInfo> &load_store, uint32_t resolve_attachment)
@@ -580,7 +613,10 @@ void MSAASample::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &ren
 void MSAASample::postprocessing(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target,
                                 VkImageLayout &swapchain_layout, bool msaa_enabled)
 {
-	auto postprocessing_subpass = dynamic_cast<vkb::PostProcessingSubpass *>(postprocessing_pipeline->get_active_subpass().get());
+	// Both pipelines read the same attachments, only their fragment shaders differ
+	auto &pipeline = gui_composite_postprocessing ? *composite_pipeline : *postprocessing_pipeline;
+
+	auto postprocessing_subpass = dynamic_cast<vkb::PostProcessingSubpass *>(pipeline.get_active_subpass().get());
 	auto depth_attachment       = (msaa_enabled && depth_writeback_resolve_supported && resolve_depth_on_writeback) ? i_depth_resolve : i_depth;
 	bool multisampled_depth     = msaa_enabled && !(depth_writeback_resolve_supported && resolve_depth_on_writeback);
 
@@ -619,7 +655,7 @@ void MSAASample::postprocessing(vkb::CommandBuffer &command_buffer, vkb::RenderT
 	}
 
 	// Second render pass
-	postprocessing_pipeline->draw(command_buffer, render_target);
+	pipeline.draw(command_buffer, render_target);
 
 	if (gui)
 	{
@@ -796,6 +832,11 @@ void MSAASample::draw_gui()
 			    ImGui::SameLine();
 		    }
 		    ImGui::Checkbox("Post-processing (2 renderpasses)", &gui_run_postprocessing);
+		    if (run_postprocessing)
+		    {
+			    ImGui::SameLine();
+			    ImGui::Checkbox("Composite effects", &gui_composite_postprocessing);
+		    }
 
 		    ImGui::Text("Resolve color: ");
 		    ImGui::SameLine();
@@ -849,6 +890,210 @@ void MSAASample::draw_gui()
 	    lines);
 }
 
+void MSAASample::finish()
+{
+	// The benchmark may end before every combination was measured
+	if (sweeping)
+	{
+		write_sweep_report();
+	}
+
+	VulkanSample::finish();
+}
+
+void MSAASample::prepare_sweep()
+{
+	sweep_configurations.clear();
+
+	for (bool postprocessing : {false, true})
+	{
+		for (auto count : supported_sample_count_list)
+		{
+			// Without MSAA there is nothing to resolve
+			if (count == VK_SAMPLE_COUNT_1_BIT)
+			{
+				sweep_configurations.push_back({postprocessing, count, ColorResolve::OnWriteback, true, gui_depth_resolve_mode});
+				continue;
+			}
+
+			for (int color_resolve : {ColorResolve::OnWriteback, ColorResolve::SeparatePass})
+			{
+				// Depth is only stored for the postprocessing renderpass
+				if (postprocessing && depth_writeback_resolve_supported)
+				{
+					for (auto mode : supported_depth_resolve_mode_list)
+					{
+						sweep_configurations.push_back({postprocessing, count, color_resolve, true, mode});
+					}
+				}
+
+				sweep_configurations.push_back({postprocessing, count, color_resolve, !postprocessing, gui_depth_resolve_mode});
+			}
+		}
+	}
+
+	LOGI("Sweeping {} MSAA configurations, {} frames each", sweep_configurations.size(), SWEEP_WARMUP_FRAMES + SWEEP_FRAMES);
+
+	sweeping = true;
+	sweep_results.clear();
+	sweep_frame = 0;
+
+	sweep_results.push_back({sweep_configurations.front()});
+	apply_sweep_configuration(sweep_configurations.front());
+}
+
+void MSAASample::update_sweep()
+{
+	auto &result        = sweep_results.back();
+	auto &configuration = result.configuration;
+
+	// A batch run selects the options with its configurations
+	if (gui_run_postprocessing != configuration.run_postprocessing || gui_sample_count != configuration.sample_count ||
+	    gui_color_resolve_method != configuration.color_resolve_method || gui_resolve_depth_on_writeback != configuration.resolve_depth_on_writeback ||
+	    gui_depth_resolve_mode != configuration.depth_resolve_mode)
+	{
+		LOGI("MSAA options changed by the configuration, stopping the sweep");
+		write_sweep_report();
+		sweeping = false;
+		return;
+	}
+
+	// The stats and the GPU time of the previous frame were sampled by the previous update
+	if (sweep_frame++ >= SWEEP_WARMUP_FRAMES)
+	{
+		auto gpu_time = get_gpu_frame_time();
+		if (gpu_time >= 0.0)
+		{
+			result.gpu_times.push_back(gpu_time);
+		}
+
+		for (auto &stat : sweep_stats)
+		{
+			if (stats->is_available(stat.first))
+			{
+				result.counters[stat.first].push_back(stats->get_data(stat.first).back());
+			}
+		}
+	}
+
+	if (sweep_frame < SWEEP_WARMUP_FRAMES + SWEEP_FRAMES)
+	{
+		return;
+	}
+
+	sweep_frame = 0;
+
+	if (sweep_results.size() == sweep_configurations.size())
+	{
+		write_sweep_report();
+		sweeping = false;
+		return;
+	}
+
+	sweep_results.push_back({sweep_configurations[sweep_results.size()]});
+	apply_sweep_configuration(sweep_results.back().configuration);
+}
+
+void MSAASample::apply_sweep_configuration(const SweepConfiguration &configuration)
+{
+	gui_run_postprocessing         = configuration.run_postprocessing;
+	gui_sample_count               = configuration.sample_count;
+	gui_color_resolve_method       = configuration.color_resolve_method;
+	gui_resolve_depth_on_writeback = configuration.resolve_depth_on_writeback;
+	gui_depth_resolve_mode         = configuration.depth_resolve_mode;
+}
+
+void MSAASample::write_sweep_report()
+{
+	auto device_name = std::string{get_device().get_gpu().get_properties().deviceName};
+
+	nlohmann::json report;
+	report["device"]        = device_name;
+	report["warmup_frames"] = SWEEP_WARMUP_FRAMES;
+	report["frames"]        = SWEEP_FRAMES;
+
+	auto configurations_json = nlohmann::json::array();
+
+	LOGI("MSAA configurations on {}:", device_name);
+
+	for (auto &result : sweep_results)
+	{
+		auto &configuration = result.configuration;
+		bool  msaa_enabled  = configuration.sample_count != VK_SAMPLE_COUNT_1_BIT;
+
+		nlohmann::json configuration_json{{"name", describe(configuration)},
+		                                  {"postprocessing", configuration.run_postprocessing},
+		                                  {"sample_count", static_cast<uint32_t>(configuration.sample_count)},
+		                                  {"color_resolve", !msaa_enabled ? "none" : configuration.color_resolve_method == ColorResolve::OnWriteback ? "writeback" : "separate"},
+		                                  {"depth_resolve", !msaa_enabled || !configuration.run_postprocessing ? "none" : configuration.resolve_depth_on_writeback ? to_string(configuration.depth_resolve_mode) : "store"}};
+
+		std::string summary;
+
+		if (result.gpu_times.empty())
+		{
+			configuration_json["gpu_frame_time_ms"] = nullptr;
+		}
+		else
+		{
+			auto gpu = vkb::BenchmarkReport::compute_statistics(result.gpu_times);
+
+			configuration_json["gpu_frame_time_ms"] = {{"mean", gpu.mean}, {"p50", gpu.p50}, {"p95", gpu.p95}};
+
+			summary += fmt::format(" GPU {:.3f} ms", gpu.mean);
+		}
+
+		// Counters are reported as the mean of their per frame values
+		auto counters_json = nlohmann::json::object();
+		for (auto &stat : sweep_stats)
+		{
+			auto counter = result.counters.find(stat.first);
+			if (counter != result.counters.end() && !counter->second.empty())
+			{
+				auto mean = vkb::BenchmarkReport::compute_statistics(counter->second).mean;
+
+				counters_json[stat.second] = mean;
+
+				summary += fmt::format(", {} {:.0f}", stat.second, mean);
+			}
+		}
+		configuration_json["counters"] = std::move(counters_json);
+
+		configurations_json.push_back(std::move(configuration_json));
+
+		LOGI("{}:{}", describe(configuration), summary);
+	}
+
+	report["configurations"] = std::move(configurations_json);
+
+	std::ofstream file{vkb::fs::path::get(vkb::fs::path::Type::Logs) + "msaa_sweep.json", std::ios::out | std::ios::trunc};
+	if (!file.good())
+	{
+		LOGE("Failed to open MSAA sweep report file");
+		return;
+	}
+
+	file << report.dump(2) << "\n";
+
+	LOGI("MSAA sweep report written to msaa_sweep.json");
+}
+
+std::string MSAASample::describe(const SweepConfiguration &configuration) const
+{
+	auto name = to_string(configuration.sample_count);
+
+	if (configuration.sample_count != VK_SAMPLE_COUNT_1_BIT)
+	{
+		name += configuration.color_resolve_method == ColorResolve::OnWriteback ? ", color resolve on writeback" : ", color resolve in separate pass";
+
+		if (configuration.run_postprocessing)
+		{
+			name += configuration.resolve_depth_on_writeback ? ", depth resolve " + to_string(configuration.depth_resolve_mode) : ", multisampled depth stored";
+		}
+	}
+
+	return name + (configuration.run_postprocessing ? ", post-processing" : "");
+}
+
 std::unique_ptr<vkb::VulkanSample> create_msaa()
 {
 	return std::make_unique<MSAASample>();
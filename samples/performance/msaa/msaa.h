@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include <map>
+
 #include "rendering/render_pipeline.h"
 #include "scene_graph/components/perspective_camera.h"
+#include "stats/stats_common.h"
 #include "vulkan_sample.h"
 
 /**
@@ -70,6 +73,8 @@ class MSAASample : public vkb::VulkanSample
 
 	virtual void update(float delta_time) override;
 
+	virtual void finish() override;
+
 	virtual void draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarget &render_target) override;
 
 	void draw_gui() override;
@@ -94,6 +99,12 @@ class MSAASample : public vkb::VulkanSample
 	 */
 	std::unique_ptr<vkb::RenderPipeline> postprocessing_pipeline{};
 
+	/**
+	 * @brief Alternative postprocessing pipeline, tonemapping, color grading,
+	 *        vignette and FXAA fused in a single full screen pass
+	 */
+	std::unique_ptr<vkb::RenderPipeline> composite_pipeline{};
+
 	/**
 	 * @brief Update MSAA options and accordingly set the load/store
 	 *        attachment operations for the renderpasses
@@ -252,6 +263,9 @@ class MSAASample : public vkb::VulkanSample
 
 	bool last_gui_run_postprocessing{false};
 
+	/// Runs the composite effects instead of the outline in the postprocessing render pass
+	bool gui_composite_postprocessing{false};
+
 	VkSampleCountFlagBits gui_sample_count{VK_SAMPLE_COUNT_1_BIT};
 
 	VkSampleCountFlagBits last_gui_sample_count{VK_SAMPLE_COUNT_1_BIT};
@@ -267,6 +281,72 @@ class MSAASample : public vkb::VulkanSample
 	VkResolveModeFlagBits gui_depth_resolve_mode{VK_RESOLVE_MODE_NONE};
 
 	VkResolveModeFlagBits last_gui_depth_resolve_mode{VK_RESOLVE_MODE_NONE};
+
+	/* Benchmark sweep of the supported combinations */
+
+	/**
+	 * @brief One combination of the options, measured by the sweep
+	 */
+	struct SweepConfiguration
+	{
+		bool run_postprocessing;
+
+		VkSampleCountFlagBits sample_count;
+
+		int color_resolve_method;
+
+		bool resolve_depth_on_writeback;
+
+		VkResolveModeFlagBits depth_resolve_mode;
+	};
+
+	struct SweepResult
+	{
+		SweepConfiguration configuration;
+
+		std::vector<double> gpu_times;
+
+		// Samples of the bandwidth counters, or of the pipeline statistics if they are not available
+		std::map<vkb::StatIndex, std::vector<double>> counters;
+	};
+
+	/**
+	 * @brief Lists every supported combination of post-processing, sample count,
+	 *        color resolve and depth resolve, skipping the options which have no effect
+	 */
+	void prepare_sweep();
+
+	/**
+	 * @brief Records the GPU time and counters of the last frame for the configuration
+	 *        being measured, and moves on to the next one once it has rendered enough frames
+	 */
+	void update_sweep();
+
+	/**
+	 * @brief Sets the GUI values to a configuration, the pipelines are updated by update()
+	 */
+	void apply_sweep_configuration(const SweepConfiguration &configuration);
+
+	/**
+	 * @brief Writes the results of the sweep to a JSON file in the logs directory
+	 */
+	void write_sweep_report();
+
+	std::string describe(const SweepConfiguration &configuration) const;
+
+	// Frames skipped after changing configuration, as the swapchain and render targets are recreated
+	const uint32_t SWEEP_WARMUP_FRAMES{30};
+
+	const uint32_t SWEEP_FRAMES{120};
+
+	// In benchmark mode the sample measures every combination in turn, batch configurations stop the sweep
+	bool sweeping{false};
+
+	std::vector<SweepConfiguration> sweep_configurations;
+
+	std::vector<SweepResult> sweep_results;
+
+	uint32_t sweep_frame{0};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_msaa();
@@ -38,6 +38,9 @@ PipelineBarriers::PipelineBarriers()
 	config.insert<vkb::IntSetting>(0, reinterpret_cast<int &>(dependency_type), DependencyType::BOTTOM_TO_TOP);
 	config.insert<vkb::IntSetting>(1, reinterpret_cast<int &>(dependency_type), DependencyType::FRAG_TO_VERT);
 	config.insert<vkb::IntSetting>(2, reinterpret_cast<int &>(dependency_type), DependencyType::FRAG_TO_FRAG);
+
+	config.insert<vkb::BoolSetting>(0, synchronization2, false);
+	config.insert<vkb::BoolSetting>(1, synchronization2, true);
 }
 
 bool PipelineBarriers::prepare(vkb::Platform &platform)
@@ -47,6 +50,10 @@ bool PipelineBarriers::prepare(vkb::Platform &platform)
 		return false;
 	}
 
+#ifdef VK_KHR_synchronization2
+	synchronization2_supported = get_device().is_enabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+#endif
+
 	load_scene("scenes/sponza/Sponza01.gltf");
 
 	scene->clear_components<vkb::sg::Light>();
@@ -84,16 +91,16 @@ bool PipelineBarriers::prepare(vkb::Platform &platform)
 	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
 	camera            = &camera_node.get_component<vkb::sg::Camera>();
 
-	auto geometry_vs = vkb::ShaderSource{vkb::fs::read_shader("deferred/geometry.vert")};
-	auto geometry_fs = vkb::ShaderSource{vkb::fs::read_shader("deferred/geometry.frag")};
+	auto geometry_vs = vkb::ShaderSource{"deferred/geometry.vert"};
+	auto geometry_fs = vkb::ShaderSource{"deferred/geometry.frag"};
 
 	auto gbuffer_pass = std::make_unique<vkb::GeometrySubpass>(get_render_context(), std::move(geometry_vs), std::move(geometry_fs), *scene, *camera);
 	gbuffer_pass->set_output_attachments({1, 2, 3});
 	gbuffer_pipeline.add_subpass(std::move(gbuffer_pass));
 	gbuffer_pipeline.set_load_store(vkb::gbuffer::get_clear_store_all());
 
-	auto lighting_vs = vkb::ShaderSource{vkb::fs::read_shader("deferred/lighting.vert")};
-	auto lighting_fs = vkb::ShaderSource{vkb::fs::read_shader("deferred/lighting.frag")};
+	auto lighting_vs = vkb::ShaderSource{"deferred/lighting.vert"};
+	auto lighting_fs = vkb::ShaderSource{"deferred/lighting.frag"};
 
 	auto lighting_subpass = std::make_unique<vkb::LightingSubpass>(get_render_context(), std::move(lighting_vs), std::move(lighting_fs), *camera, *scene);
 	lighting_subpass->set_input_attachments({1, 2, 3});
@@ -101,6 +108,7 @@ bool PipelineBarriers::prepare(vkb::Platform &platform)
 	lighting_pipeline.set_load_store(vkb::gbuffer::get_load_all_store_swapchain());
 
 	stats->request_stats({vkb::StatIndex::frame_times,
+	                      vkb::StatIndex::frame_gpu_time,
 	                      vkb::StatIndex::gpu_vertex_cycles,
 	                      vkb::StatIndex::gpu_fragment_cycles},
 	                     vkb::CounterSamplingConfig{vkb::CounterSamplingMode::Continuous});
@@ -122,7 +130,7 @@ std::unique_ptr<vkb::RenderTarget> PipelineBarriers::create_render_target(vkb::c
 
 	vkb::core::Image depth_image{device,
 	                             extent,
-	                             vkb::get_suitable_depth_format(swapchain_image.get_device().get_gpu().get_handle()),
+	                             vkb::get_suitable_depth_format(swapchain_image.get_device().get_gpu()),
 	                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
 	                             VMA_MEMORY_USAGE_GPU_ONLY};
 
@@ -166,6 +174,10 @@ void PipelineBarriers::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarge
 	// More conservative barriers are shown, waiting for acquisition at either VERTEX_SHADER or even TOP_OF_PIPE.
 	//
 
+	// With synchronization2 the barriers recorded together keep their own stages,
+	// instead of all waiting for the union of the source stages before the union of the destination stages.
+	command_buffer.set_synchronization2(synchronization2);
+
 	auto &views = render_target.get_views();
 
 	{
@@ -260,6 +272,12 @@ void PipelineBarriers::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarge
 	// fragment shading for the first render pass. Again, more conservative barriers are shown, waiting for VERTEX_SHADER or even TOP_OF_PIPE.
 	// Those barriers will flush the GPU's pipeline, causing serialization between vertex and fragment work, potentially affecting performance.
 	//
+	// The depth and color barriers are recorded together, which makes them wait for both the fragment tests and the color outputs
+	// without synchronization2.
+	//
+	std::vector<const vkb::core::ImageView *> gbuffer_views;
+	std::vector<vkb::ImageMemoryBarrier>      gbuffer_barriers;
+
 	for (size_t i = 1; i < render_target.get_views().size(); ++i)
 	{
 		auto &view = render_target.get_views().at(i);
@@ -302,9 +320,12 @@ void PipelineBarriers::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarge
 				break;
 		}
 
-		command_buffer.image_memory_barrier(view, barrier);
+		gbuffer_views.push_back(&view);
+		gbuffer_barriers.push_back(barrier);
 	}
 
+	command_buffer.image_memory_barriers(gbuffer_views, gbuffer_barriers);
+
 	lighting_pipeline.draw(command_buffer, get_render_context().get_active_frame().get_render_target());
 
 	if (gui)
@@ -328,7 +349,7 @@ void PipelineBarriers::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarge
 
 void PipelineBarriers::draw_gui()
 {
-	int  lines         = 2;
+	int  lines         = 4;
 	bool portrait_mode = (reinterpret_cast<vkb::sg::PerspectiveCamera *>(camera)->get_aspect_ratio() < 1.0f);
 
 	if (portrait_mode)
@@ -350,6 +371,17 @@ void PipelineBarriers::draw_gui()
 		    }
 
 		    ImGui::RadioButton("Frag to frag", reinterpret_cast<int *>(&dependency_type), DependencyType::FRAG_TO_FRAG);
+
+		    if (synchronization2_supported)
+		    {
+			    ImGui::Checkbox("Synchronization2", &synchronization2);
+		    }
+		    else
+		    {
+			    ImGui::Text("Synchronization2 not supported");
+		    }
+
+		    ImGui::Text("GPU frame time: %.2f ms", stats->get_gpu_profiler().get_frame_time());
 	    },
 	    /* lines = */ lines);
 }
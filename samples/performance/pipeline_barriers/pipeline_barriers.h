@@ -57,6 +57,11 @@ class PipelineBarriers : public vkb::VulkanSample
 	vkb::RenderPipeline lighting_pipeline;
 
 	DependencyType dependency_type{DependencyType::BOTTOM_TO_TOP};
+
+	/// Records the barriers with vkCmdPipelineBarrier2KHR, each waiting for its own stages
+	bool synchronization2{false};
+
+	bool synchronization2_supported{false};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_pipeline_barriers();
@@ -17,6 +17,9 @@
 
 #include "pipeline_cache.h"
 
+#include <algorithm>
+#include <thread>
+
 #include <imgui_internal.h>
 
 #include "common/logging.h"
@@ -34,27 +37,22 @@ PipelineCache::PipelineCache()
 
 	config.insert<vkb::BoolSetting>(0, enable_pipeline_cache, true);
 	config.insert<vkb::BoolSetting>(1, enable_pipeline_cache, false);
+
+	// Compares the strategies on the pipeline permutations
+	config.insert<vkb::BoolSetting>(2, enable_pipeline_cache, true);
+	config.insert<vkb::BoolSetting>(2, run_stress_test, true);
 }
 
 PipelineCache::~PipelineCache()
 {
-	if (pipeline_cache != VK_NULL_HANDLE)
+	// The record then holds the stress test permutations, which the next start would warm up
+	if (stress_tested)
 	{
-		/* Get size of pipeline cache */
-		size_t size{};
-		VK_CHECK(vkGetPipelineCacheData(device->get_handle(), pipeline_cache, &size, nullptr));
-
-		/* Get data of pipeline cache */
-		std::vector<uint8_t> data(size);
-		VK_CHECK(vkGetPipelineCacheData(device->get_handle(), pipeline_cache, &size, data.data()));
-
-		/* Write pipeline cache data to a file in binary format */
-		vkb::fs::write_temp(data, "pipeline_cache.data");
-
-		/* Destroy Vulkan pipeline cache */
-		vkDestroyPipelineCache(device->get_handle(), pipeline_cache, nullptr);
+		LOGI("Not saving the data cache, it holds the pipelines of the stress test");
+		return;
 	}
 
+	// The pipeline cache itself is saved by VulkanSample
 	vkb::fs::write_temp(device->get_resource_cache().serialize(), "cache.data");
 }
 
@@ -65,30 +63,13 @@ bool PipelineCache::prepare(vkb::Platform &platform)
 		return false;
 	}
 
-	/* Try to read pipeline cache file if exists */
-	std::vector<uint8_t> pipeline_data;
+	vkb::ResourceCache &resource_cache = device->get_resource_cache();
 
-	try
+	// VulkanSample already loaded the pipeline cache from the previous run
+	if (!enable_pipeline_cache)
 	{
-		pipeline_data = vkb::fs::read_temp("pipeline_cache.data");
+		resource_cache.set_pipeline_cache(VK_NULL_HANDLE);
 	}
-	catch (std::runtime_error &ex)
-	{
-		LOGW("No pipeline cache found. {}", ex.what());
-	}
-
-	/* Add initial pipeline cache data from the cached file */
-	VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
-	create_info.initialDataSize = pipeline_data.size();
-	create_info.pInitialData    = pipeline_data.data();
-
-	/* Create Vulkan pipeline cache */
-	VK_CHECK(vkCreatePipelineCache(device->get_handle(), &create_info, nullptr, &pipeline_cache));
-
-	vkb::ResourceCache &resource_cache = device->get_resource_cache();
-
-	// Use pipeline cache to store pipelines
-	resource_cache.set_pipeline_cache(pipeline_cache);
 
 	std::vector<uint8_t> data_cache;
 
@@ -127,9 +108,256 @@ bool PipelineCache::prepare(vkb::Platform &platform)
 
 	set_render_pipeline(std::move(render_pipeline));
 
+	// The permutations draw a full screen triangle, they are created but never drawn
+	auto &stress_vert = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, vkb::ShaderSource("postprocessing/postprocessing.vert"));
+	auto &stress_frag = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, vkb::ShaderSource("pipeline_cache/permutation.frag"));
+
+	stress_pipeline_layout = &resource_cache.request_pipeline_layout({&stress_vert, &stress_frag});
+
+	std::vector<vkb::Attachment> attachments{
+	    {get_render_context().get_format(), VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT},
+	    {vkb::get_suitable_depth_format(device->get_gpu()), VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT}};
+
+	stress_render_pass = &resource_cache.request_render_pass(attachments, {vkb::LoadStoreInfo{}, vkb::LoadStoreInfo{}}, {});
+
+	if (run_stress_test)
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(StressStrategy::Count); ++i)
+		{
+			stress_queue.push_back(static_cast<StressStrategy>(i));
+		}
+	}
+
 	return true;
 }
 
+const char *PipelineCache::get_strategy_name(StressStrategy strategy)
+{
+	switch (strategy)
+	{
+		case StressStrategy::NoCache:
+			return "No cache";
+		case StressStrategy::DriverCache:
+			return "Driver pipeline cache";
+		case StressStrategy::Warmup:
+			return "Record/replay warmup";
+		case StressStrategy::AsyncCompilation:
+			return "Async compilation";
+		case StressStrategy::PipelineLibraries:
+			return "Pipeline libraries";
+		default:
+			return "Unknown";
+	}
+}
+
+void PipelineCache::set_permutation_state(uint32_t index, vkb::PipelineState &pipeline_state)
+{
+	static const VkColorComponentFlags rgba = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	static const VkCullModeFlags       cull_modes[]     = {VK_CULL_MODE_NONE, VK_CULL_MODE_FRONT_BIT, VK_CULL_MODE_BACK_BIT};
+	static const VkFrontFace           front_faces[]    = {VK_FRONT_FACE_COUNTER_CLOCKWISE, VK_FRONT_FACE_CLOCKWISE};
+	static const VkCompareOp           depth_compares[] = {VK_COMPARE_OP_GREATER, VK_COMPARE_OP_GREATER_OR_EQUAL, VK_COMPARE_OP_LESS, VK_COMPARE_OP_EQUAL};
+	static const VkColorComponentFlags write_masks[]    = {rgba, rgba & ~VK_COLOR_COMPONENT_A_BIT, VK_COLOR_COMPONENT_R_BIT, VK_COLOR_COMPONENT_A_BIT};
+	static const VkPrimitiveTopology   topologies[]     = {VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP};
+
+	// The index is decomposed in the digits of the states, 384 fixed function combinations per pattern
+
+	pipeline_state.reset();
+	pipeline_state.set_pipeline_layout(*stress_pipeline_layout);
+	pipeline_state.set_render_pass(*stress_render_pass);
+
+	pipeline_state.set_specialization_constant(0, vkb::to_bytes(static_cast<int32_t>(index % STRESS_PATTERN_COUNT)));
+	index /= STRESS_PATTERN_COUNT;
+
+	vkb::RasterizationState rasterization_state{};
+	rasterization_state.cull_mode = cull_modes[index % 3];
+	index /= 3;
+	rasterization_state.front_face = front_faces[index % 2];
+	index /= 2;
+	pipeline_state.set_rasterization_state(rasterization_state);
+
+	vkb::DepthStencilState depth_stencil_state{};
+	depth_stencil_state.depth_compare_op = depth_compares[index % 4];
+	index /= 4;
+	depth_stencil_state.depth_write_enable = index % 2;
+	index /= 2;
+	pipeline_state.set_depth_stencil_state(depth_stencil_state);
+
+	vkb::ColorBlendAttachmentState blend_attachment{};
+	blend_attachment.color_write_mask = write_masks[index % 4];
+	index /= 4;
+	vkb::ColorBlendState color_blend_state{};
+	color_blend_state.attachments = {blend_attachment};
+	pipeline_state.set_color_blend_state(color_blend_state);
+
+	vkb::InputAssemblyState input_assembly_state{};
+	input_assembly_state.topology = topologies[index % 2];
+	pipeline_state.set_input_assembly_state(input_assembly_state);
+}
+
+void PipelineCache::configure_cache(StressStrategy strategy)
+{
+	vkb::ResourceCache &resource_cache = device->get_resource_cache();
+
+	// The pipelines of the frames in flight are destroyed once they complete
+	resource_cache.clear_pipelines();
+
+	resource_cache.set_pipeline_library(strategy == StressStrategy::PipelineLibraries);
+
+	if (strategy == StressStrategy::DriverCache)
+	{
+		resource_cache.set_pipeline_cache(*persistent_pipeline_cache);
+	}
+	else
+	{
+		resource_cache.set_pipeline_cache(VK_NULL_HANDLE);
+	}
+
+	uint32_t thread_count = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	resource_cache.set_async_pipeline_compilation(strategy == StressStrategy::AsyncCompilation ? thread_count : 0);
+}
+
+void PipelineCache::restore_cache()
+{
+	vkb::ResourceCache &resource_cache = device->get_resource_cache();
+
+	resource_cache.set_async_pipeline_compilation(0);
+	resource_cache.set_pipeline_library(true);
+	resource_cache.clear_pipelines();
+
+	if (enable_pipeline_cache)
+	{
+		resource_cache.set_pipeline_cache(*persistent_pipeline_cache);
+	}
+	else
+	{
+		resource_cache.set_pipeline_cache(VK_NULL_HANDLE);
+	}
+}
+
+void PipelineCache::prime_stress_test(StressStrategy strategy)
+{
+	configure_cache(strategy);
+
+	vkb::ResourceCache &resource_cache = device->get_resource_cache();
+	vkb::PipelineState  pipeline_state;
+
+	for (uint32_t i = 0; i < vkb::to_u32(stress_permutation_count); ++i)
+	{
+		set_permutation_state(i, pipeline_state);
+		resource_cache.request_graphics_pipeline(pipeline_state);
+	}
+
+	if (strategy == StressStrategy::DriverCache)
+	{
+		driver_cache_primed = true;
+	}
+	else
+	{
+		// The resource record of the cache has seen every permutation now
+		warmup_data = resource_cache.serialize();
+	}
+
+	resource_cache.clear_pipelines();
+}
+
+void PipelineCache::start_stress_test(StressStrategy strategy)
+{
+	stress_tested           = true;
+	stress_current          = StressResult{strategy};
+	stress_next_permutation = 0;
+	stress_pending.clear();
+
+	if (strategy == StressStrategy::PipelineLibraries && !device->is_enabled("VK_EXT_graphics_pipeline_library"))
+	{
+		LOGW("Skipping the {} stress test, the device does not support VK_EXT_graphics_pipeline_library", get_strategy_name(strategy));
+		return;
+	}
+
+	bool needs_priming = (strategy == StressStrategy::DriverCache && !driver_cache_primed) ||
+	                     (strategy == StressStrategy::Warmup && warmup_data.empty());
+
+	// Priming stalls its frame, the run starts on the next one
+	if (needs_priming)
+	{
+		stress_phase = StressPhase::Prime;
+		return;
+	}
+
+	configure_cache(strategy);
+
+	stress_phase = StressPhase::Run;
+	stress_timer.start();
+
+	if (strategy == StressStrategy::Warmup)
+	{
+		device->get_resource_cache().warmup(warmup_data);
+		stress_current.creation_time_ms = stress_timer.elapsed<vkb::Timer::Milliseconds>();
+	}
+}
+
+void PipelineCache::update_stress_test()
+{
+	vkb::ResourceCache &resource_cache = device->get_resource_cache();
+	vkb::PipelineState  pipeline_state;
+
+	bool async = stress_current.strategy == StressStrategy::AsyncCompilation;
+
+	stress_pending.erase(std::remove_if(stress_pending.begin(), stress_pending.end(),
+	                                    [&](uint32_t index) {
+		                                    set_permutation_state(index, pipeline_state);
+		                                    return resource_cache.request_graphics_pipeline_async(pipeline_state) != nullptr;
+	                                    }),
+	                     stress_pending.end());
+
+	auto permutation_count = vkb::to_u32(stress_permutation_count);
+
+	if (stress_next_permutation == permutation_count && stress_pending.empty())
+	{
+		if (async)
+		{
+			stress_current.creation_time_ms = stress_timer.elapsed<vkb::Timer::Milliseconds>();
+		}
+
+		LOGI("Pipeline stress test, {}: {} pipelines in {:.1f} ms, worst frame {:.1f} ms over {} frames",
+		     get_strategy_name(stress_current.strategy), permutation_count, stress_current.creation_time_ms,
+		     stress_current.worst_frame_ms, stress_current.frame_count);
+
+		stress_results.push_back(stress_current);
+		stress_phase = StressPhase::Idle;
+
+		restore_cache();
+		return;
+	}
+
+	auto batch_end = std::min(stress_next_permutation + vkb::to_u32(stress_batch_size), permutation_count);
+
+	vkb::Timer batch_timer;
+	batch_timer.start();
+
+	for (; stress_next_permutation < batch_end; ++stress_next_permutation)
+	{
+		set_permutation_state(stress_next_permutation, pipeline_state);
+
+		if (async)
+		{
+			if (!resource_cache.request_graphics_pipeline_async(pipeline_state))
+			{
+				stress_pending.push_back(stress_next_permutation);
+			}
+		}
+		else
+		{
+			resource_cache.request_graphics_pipeline(pipeline_state);
+		}
+	}
+
+	if (!async)
+	{
+		stress_current.creation_time_ms += batch_timer.stop<vkb::Timer::Milliseconds>();
+	}
+}
+
 void PipelineCache::draw_gui()
 {
 	gui->show_options_window(
@@ -141,7 +369,7 @@ void PipelineCache::draw_gui()
 			    if (enable_pipeline_cache)
 			    {
 				    // Use pipeline cache to store pipelines
-				    resource_cache.set_pipeline_cache(pipeline_cache);
+				    resource_cache.set_pipeline_cache(*persistent_pipeline_cache);
 			    }
 			    else
 			    {
@@ -154,7 +382,6 @@ void PipelineCache::draw_gui()
 
 		    if (ImGui::Button("Destroy Pipelines", button_size))
 		    {
-			    device->wait_idle();
 			    device->get_resource_cache().clear_pipelines();
 			    record_frame_time_next_frame = true;
 		    }
@@ -167,8 +394,59 @@ void PipelineCache::draw_gui()
 		    {
 			    ImGui::Text("Pipeline rebuild frame time: N/A");
 		    }
+
+		    // Stress test over the pipeline permutations
+		    bool idle = stress_phase == StressPhase::Idle && stress_queue.empty();
+
+		    ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.3f);
+		    ImGui::SliderInt("##permutations", &stress_permutation_count, 256, 8192, "Pipelines: %d");
+		    ImGui::SameLine();
+		    ImGui::SliderInt("##batch", &stress_batch_size, 1, 512, "Per frame: %d");
+		    ImGui::PopItemWidth();
+
+		    ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.4f);
+		    const char *strategy_names[static_cast<int>(StressStrategy::Count)];
+		    for (int i = 0; i < static_cast<int>(StressStrategy::Count); ++i)
+		    {
+			    strategy_names[i] = get_strategy_name(static_cast<StressStrategy>(i));
+		    }
+		    ImGui::Combo("##strategy", &gui_stress_strategy, strategy_names, static_cast<int>(StressStrategy::Count));
+		    ImGui::PopItemWidth();
+
+		    ImGui::SameLine();
+		    if (ImGui::Button("Run", ImVec2(button_size.x * 0.5f, button_size.y)) && idle)
+		    {
+			    stress_queue.push_back(static_cast<StressStrategy>(gui_stress_strategy));
+		    }
+
+		    ImGui::SameLine();
+		    if (ImGui::Button("Run all", ImVec2(button_size.x * 0.5f, button_size.y)) && idle)
+		    {
+			    for (int i = 0; i < static_cast<int>(StressStrategy::Count); ++i)
+			    {
+				    stress_queue.push_back(static_cast<StressStrategy>(i));
+			    }
+		    }
+
+		    if (stress_phase == StressPhase::Prime)
+		    {
+			    ImGui::Text("Priming %s...", get_strategy_name(stress_current.strategy));
+		    }
+		    else if (stress_phase == StressPhase::Run)
+		    {
+			    ImGui::Text("Running %s: %u/%d pipelines", get_strategy_name(stress_current.strategy), stress_next_permutation, stress_permutation_count);
+		    }
+		    else
+		    {
+			    ImGui::Text("%-22s %12s %12s %7s", "Strategy", "Creation ms", "Worst frame", "Frames");
+		    }
+
+		    for (auto &result : stress_results)
+		    {
+			    ImGui::Text("%-22s %12.1f %12.1f %7u", get_strategy_name(result.strategy), result.creation_time_ms, result.worst_frame_ms, result.frame_count);
+		    }
 	    },
-	    /* lines = */ 2);
+	    /* lines = */ vkb::to_u32(5 + stress_results.size()));
 }
 
 void PipelineCache::update(float delta_time)
@@ -179,6 +457,42 @@ void PipelineCache::update(float delta_time)
 		record_frame_time_next_frame    = false;
 	}
 
+	// The frame time covers the previous frame, which requested the last batch
+	if (stress_phase == StressPhase::Run)
+	{
+		stress_current.worst_frame_ms = std::max(stress_current.worst_frame_ms, delta_time * 1000.0f);
+		stress_current.frame_count++;
+	}
+
+	switch (stress_phase)
+	{
+		case StressPhase::Idle:
+			if (!stress_queue.empty())
+			{
+				auto strategy = stress_queue.front();
+				stress_queue.pop_front();
+
+				start_stress_test(strategy);
+
+				if (stress_phase == StressPhase::Run)
+				{
+					update_stress_test();
+				}
+			}
+			break;
+		case StressPhase::Prime:
+			prime_stress_test(stress_current.strategy);
+			restore_cache();
+
+			// Started again on the next frame, without the priming stall
+			stress_queue.push_front(stress_current.strategy);
+			stress_phase = StressPhase::Idle;
+			break;
+		case StressPhase::Run:
+			update_stress_test();
+			break;
+	}
+
 	VulkanSample::update(delta_time);
 }
 
@@ -17,14 +17,21 @@
 
 #pragma once
 
+#include <deque>
+
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/components/camera.h"
+#include "timer.h"
 #include "vulkan_sample.h"
 
 /**
  * @brief Pipeline creation and caching
+ *
+ * The stress test creates thousands of pipeline permutations, a batch per frame as a streamed
+ * level would, with one strategy of the resource cache at a time. It reports the time spent
+ * creating them and the longest frame of the run, for each strategy.
  */
 class PipelineCache : public vkb::VulkanSample
 {
@@ -38,9 +45,84 @@ class PipelineCache : public vkb::VulkanSample
 	virtual void update(float delta_time) override;
 
   private:
-	vkb::sg::Camera *camera{nullptr};
+	/**
+	 * @brief How the pipelines of a stress test run are created
+	 */
+	enum class StressStrategy
+	{
+		/// Created on request, without a pipeline cache
+		NoCache,
+
+		/// Created on request, from a pipeline cache which already holds them
+		DriverCache,
+
+		/// Created up front by replaying the resources recorded by an earlier run
+		Warmup,
+
+		/// Queued to the compile threads, the frames do not wait for them
+		AsyncCompilation,
+
+		/// Linked from pipeline libraries, which the permutations share
+		PipelineLibraries,
+
+		Count
+	};
+
+	enum class StressPhase
+	{
+		Idle,
+
+		/// Fills the pipeline cache or the warmup data the run needs, not measured
+		Prime,
+
+		Run
+	};
+
+	struct StressResult
+	{
+		StressStrategy strategy;
+
+		/// Time spent creating the pipelines, or until the last one was ready with asynchronous compilation
+		double creation_time_ms{0.0};
+
+		float worst_frame_ms{0.0f};
+
+		uint32_t frame_count{0};
+	};
+
+	/// Number of specialization constant values of the permutation shader
+	static constexpr uint32_t STRESS_PATTERN_COUNT = 64;
+
+	static const char *get_strategy_name(StressStrategy strategy);
+
+	/**
+	 * @brief Sets up the state of a permutation, the pattern of the shader in the lowest digits of the index
+	 */
+	void set_permutation_state(uint32_t index, vkb::PipelineState &pipeline_state);
+
+	/**
+	 * @brief Applies the settings of a strategy to the resource cache, and removes its pipelines
+	 */
+	void configure_cache(StressStrategy strategy);
+
+	/**
+	 * @brief Restores the settings of the resource cache chosen in the options
+	 */
+	void restore_cache();
 
-	VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
+	/**
+	 * @brief Creates every permutation once, unmeasured, so that the cache or warmup data of a strategy holds them
+	 */
+	void prime_stress_test(StressStrategy strategy);
+
+	void start_stress_test(StressStrategy strategy);
+
+	/**
+	 * @brief Requests the next batch of permutations, and ends the run once they are all created
+	 */
+	void update_stress_test();
+
+	vkb::sg::Camera *camera{nullptr};
 
 	ImVec2 button_size{150, 30};
 
@@ -50,6 +132,41 @@ class PipelineCache : public vkb::VulkanSample
 
 	float rebuild_pipelines_frame_time_ms{0.0f};
 
+	/// Whether to run every strategy when the sample starts, for the batch mode
+	bool run_stress_test{false};
+
+	/// Whether the resource record of the cache holds the permutations
+	bool stress_tested{false};
+
+	int stress_permutation_count{4096};
+
+	int stress_batch_size{64};
+
+	int gui_stress_strategy{0};
+
+	vkb::PipelineLayout *stress_pipeline_layout{nullptr};
+
+	const vkb::RenderPass *stress_render_pass{nullptr};
+
+	StressPhase stress_phase{StressPhase::Idle};
+
+	std::deque<StressStrategy> stress_queue;
+
+	StressResult stress_current{};
+
+	uint32_t stress_next_permutation{0};
+
+	/// Permutations queued for asynchronous compilation which are not ready yet
+	std::vector<uint32_t> stress_pending;
+
+	vkb::Timer stress_timer;
+
+	bool driver_cache_primed{false};
+
+	std::vector<uint8_t> warmup_data;
+
+	std::vector<StressResult> stress_results;
+
 	virtual void draw_gui() override;
 };
 
@@ -34,21 +34,37 @@ RenderSubpasses::RenderSubpasses()
 	config.insert<vkb::IntSetting>(0, configs[Config::RenderTechnique].value, 0);
 	config.insert<vkb::IntSetting>(0, configs[Config::TransientAttachments].value, 0);
 	config.insert<vkb::IntSetting>(0, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(0, configs[Config::Precision].value, 0);
 
 	// Use two render passes
 	config.insert<vkb::IntSetting>(1, configs[Config::RenderTechnique].value, 1);
 	config.insert<vkb::IntSetting>(1, configs[Config::TransientAttachments].value, 0);
 	config.insert<vkb::IntSetting>(1, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(1, configs[Config::Precision].value, 0);
 
 	// Disable transient attachments
 	config.insert<vkb::IntSetting>(2, configs[Config::RenderTechnique].value, 0);
 	config.insert<vkb::IntSetting>(2, configs[Config::TransientAttachments].value, 1);
 	config.insert<vkb::IntSetting>(2, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(2, configs[Config::Precision].value, 0);
 
 	// Increase G-buffer size
 	config.insert<vkb::IntSetting>(3, configs[Config::RenderTechnique].value, 0);
 	config.insert<vkb::IntSetting>(3, configs[Config::TransientAttachments].value, 0);
 	config.insert<vkb::IntSetting>(3, configs[Config::GBufferSize].value, 1);
+	config.insert<vkb::IntSetting>(3, configs[Config::Precision].value, 0);
+
+	// Pack the G-buffer
+	config.insert<vkb::IntSetting>(4, configs[Config::RenderTechnique].value, 0);
+	config.insert<vkb::IntSetting>(4, configs[Config::TransientAttachments].value, 0);
+	config.insert<vkb::IntSetting>(4, configs[Config::GBufferSize].value, 2);
+	config.insert<vkb::IntSetting>(4, configs[Config::Precision].value, 0);
+
+	// Relax the shading to half precision
+	config.insert<vkb::IntSetting>(5, configs[Config::RenderTechnique].value, 0);
+	config.insert<vkb::IntSetting>(5, configs[Config::TransientAttachments].value, 0);
+	config.insert<vkb::IntSetting>(5, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(5, configs[Config::Precision].value, 1);
 }
 
 std::unique_ptr<vkb::RenderTarget> RenderSubpasses::create_render_target(vkb::core::Image &&swapchain_image)
@@ -56,29 +72,47 @@ std::unique_ptr<vkb::RenderTarget> RenderSubpasses::create_render_target(vkb::co
 	auto &device = swapchain_image.get_device();
 	auto &extent = swapchain_image.get_extent();
 
+	// The G-buffer can be transient when it is neither loaded nor stored by the render passes of the technique
+	std::vector<std::vector<vkb::LoadStoreInfo>> load_stores;
+	if (configs[Config::RenderTechnique].value == 0)
+	{
+		load_stores.push_back(vkb::gbuffer::get_clear_all_store_swapchain());
+	}
+	else
+	{
+		load_stores.push_back(vkb::gbuffer::get_clear_store_all());
+		load_stores.push_back(vkb::gbuffer::get_load_all_store_swapchain());
+	}
+
+	auto transient = vkb::RenderTarget::find_transient_attachments(load_stores);
+	for (size_t i = 0; i < transient.size(); ++i)
+	{
+		transient[i] = transient[i] && transient_attachments;
+	}
+
 	// G-Buffer should fit 128-bit budget for buffer color storage
 	// in order to enable subpasses merging by the driver
 	// Light (swapchain_image) RGBA8_UNORM   (32-bit)
 	// Albedo                  RGBA8_UNORM   (32-bit)
 	// Normal                  RGB10A2_UNORM (32-bit)
 
-	vkb::core::Image depth_image{device,
-	                             extent,
-	                             vkb::get_suitable_depth_format(swapchain_image.get_device().get_gpu().get_handle()),
-	                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | rt_usage_flags,
-	                             VMA_MEMORY_USAGE_GPU_ONLY};
+	auto depth_image = vkb::RenderTarget::create_attachment_image(device,
+	                                                              extent,
+	                                                              vkb::get_suitable_depth_format(swapchain_image.get_device().get_gpu()),
+	                                                              VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | rt_usage_flags,
+	                                                              transient[1]);
 
-	vkb::core::Image albedo_image{device,
-	                              extent,
-	                              albedo_format,
-	                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-	                              VMA_MEMORY_USAGE_GPU_ONLY};
+	auto albedo_image = vkb::RenderTarget::create_attachment_image(device,
+	                                                               extent,
+	                                                               albedo_format,
+	                                                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
+	                                                               transient[2]);
 
-	vkb::core::Image normal_image{device,
-	                              extent,
-	                              normal_format,
-	                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-	                              VMA_MEMORY_USAGE_GPU_ONLY};
+	auto normal_image = vkb::RenderTarget::create_attachment_image(device,
+	                                                               extent,
+	                                                               normal_format,
+	                                                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
+	                                                               transient[3]);
 
 	std::vector<vkb::core::Image> images;
 
@@ -168,34 +202,27 @@ bool RenderSubpasses::prepare(vkb::Platform &platform)
 
 void RenderSubpasses::update(float delta_time)
 {
-	// Check whether the user changed the render technique
-	if (configs[Config::RenderTechnique].value != last_render_technique)
+	// Check whether the user changed the render technique, which changes the attachments that can be transient
+	if (configs[Config::RenderTechnique].value != last_render_technique ||
+	    configs[Config::TransientAttachments].value != last_transient_attachment ||
+	    configs[Config::GBufferSize].value != last_g_buffer_size ||
+	    configs[Config::Precision].value != last_precision)
 	{
-		LOGI("Changing render technique");
-		last_render_technique = configs[Config::RenderTechnique].value;
+		bool recreate_pipelines = false;
 
-		// Reset frames, their synchronization objects and their command buffers
-		for (auto &frame : get_render_context().get_render_frames())
+		if (configs[Config::RenderTechnique].value != last_render_technique)
 		{
-			frame->reset();
+			LOGI("Changing render technique");
+			last_render_technique = configs[Config::RenderTechnique].value;
 		}
-	}
 
-	// Check whether the user switched the attachment or the G-buffer option
-	if (configs[Config::TransientAttachments].value != last_transient_attachment ||
-	    configs[Config::GBufferSize].value != last_g_buffer_size)
-	{
 		// If attachment option has changed
 		if (configs[Config::TransientAttachments].value != last_transient_attachment)
 		{
-			rt_usage_flags = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-
 			// If attachment should be transient
-			if (configs[Config::TransientAttachments].value == 0)
-			{
-				rt_usage_flags |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
-			}
-			else
+			transient_attachments = configs[Config::TransientAttachments].value == 0;
+
+			if (!transient_attachments)
 			{
 				LOGI("Creating non transient attachments");
 			}
@@ -205,6 +232,8 @@ void RenderSubpasses::update(float delta_time)
 		// It G-buffer option has changed
 		if (configs[Config::GBufferSize].value != last_g_buffer_size)
 		{
+			auto layout = configs[Config::GBufferSize].value == 2 ? vkb::gbuffer::Layout::Compact : vkb::gbuffer::Layout::Full;
+
 			if (configs[Config::GBufferSize].value == 0)
 			{
 				// Use less bits
@@ -213,14 +242,26 @@ void RenderSubpasses::update(float delta_time)
 			}
 			else
 			{
-				// Use more bits
-				albedo_format = VK_FORMAT_R16G16B16A16_SFLOAT;        // 64-bit
-				normal_format = VK_FORMAT_R16G16B16A16_SFLOAT;        // 64-bit
+				// Use more bits, or pack the normal and material in fewer
+				albedo_format = vkb::gbuffer::get_albedo_format(layout);
+				normal_format = vkb::gbuffer::get_normal_format(layout);
 			}
 
+			// The shaders of the pipelines write and read the packed layout
+			recreate_pipelines = layout != gbuffer_layout;
+			gbuffer_layout     = layout;
+
 			last_g_buffer_size = configs[Config::GBufferSize].value;
 		}
 
+		// The shaders of the pipelines are compiled for the precision
+		if (configs[Config::Precision].value != last_precision)
+		{
+			half_precision     = configs[Config::Precision].value == 1;
+			recreate_pipelines = true;
+			last_precision     = configs[Config::Precision].value;
+		}
+
 		// Reset frames, their synchronization objects and their command buffers
 		for (auto &frame : get_render_context().get_render_frames())
 		{
@@ -229,6 +270,13 @@ void RenderSubpasses::update(float delta_time)
 
 		LOGI("Recreating render target");
 		render_context->recreate();
+
+		if (recreate_pipelines)
+		{
+			render_pipeline          = create_one_renderpass_two_subpasses();
+			geometry_render_pipeline = create_geometry_renderpass();
+			lighting_render_pipeline = create_lighting_renderpass();
+		}
 	}
 
 	VulkanSample::update(delta_time);
@@ -288,6 +336,8 @@ std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_one_renderpass_two_
 
 	// Outputs are depth, albedo, and normal
 	scene_subpass->set_output_attachments({1, 2, 3});
+	scene_subpass->set_gbuffer_layout(gbuffer_layout);
+	scene_subpass->set_half_precision(half_precision);
 
 	// Lighting subpass
 	auto lighting_vs      = vkb::ShaderSource{"deferred/lighting.vert"};
@@ -296,6 +346,8 @@ std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_one_renderpass_two_
 
 	// Inputs are depth, albedo, and normal from the geometry subpass
 	lighting_subpass->set_input_attachments({1, 2, 3});
+	lighting_subpass->set_gbuffer_layout(gbuffer_layout);
+	lighting_subpass->set_half_precision(half_precision);
 
 	// Create subpasses pipeline
 	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
@@ -320,6 +372,8 @@ std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_geometry_renderpass
 
 	// Outputs are depth, albedo, and normal
 	scene_subpass->set_output_attachments({1, 2, 3});
+	scene_subpass->set_gbuffer_layout(gbuffer_layout);
+	scene_subpass->set_half_precision(half_precision);
 
 	// Create geomtry pipeline
 	std::vector<std::unique_ptr<vkb::Subpass>> scene_subpasses{};
@@ -343,6 +397,8 @@ std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_lighting_renderpass
 
 	// Inputs are depth, albedo, and normal from the geometry subpass
 	lighting_subpass->set_input_attachments({1, 2, 3});
+	lighting_subpass->set_gbuffer_layout(gbuffer_layout);
+	lighting_subpass->set_half_precision(half_precision);
 	// Create lighting pipeline
 	std::vector<std::unique_ptr<vkb::Subpass>> lighting_subpasses{};
 	lighting_subpasses.push_back(std::move(lighting_subpass));
@@ -97,7 +97,8 @@ class RenderSubpasses : public vkb::VulkanSample
 		{
 			RenderTechnique,
 			TransientAttachments,
-			GBufferSize
+			GBufferSize,
+			Precision
 		} type;
 
 		/// Used as label by the GUI
@@ -113,10 +114,20 @@ class RenderSubpasses : public vkb::VulkanSample
 	uint16_t last_render_technique{0};
 	uint16_t last_transient_attachment{0};
 	uint16_t last_g_buffer_size{0};
+	uint16_t last_precision{0};
 
 	VkFormat          albedo_format{VK_FORMAT_R8G8B8A8_UNORM};
 	VkFormat          normal_format{VK_FORMAT_A2B10G10R10_UNORM_PACK32};
-	VkImageUsageFlags rt_usage_flags{VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT};
+	VkImageUsageFlags rt_usage_flags{VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT};
+
+	/// Layout written and read by the shaders, the compact one packs the normal and material
+	vkb::gbuffer::Layout gbuffer_layout{vkb::gbuffer::Layout::Full};
+
+	/// Whether the shaders are compiled with the HALF_PRECISION variant
+	bool half_precision{false};
+
+	/// Whether the attachments which are neither loaded nor stored are created transient
+	bool transient_attachments{true};
 
 	std::vector<Config> configs = {
 	    {/* config      = */ Config::RenderTechnique,
@@ -129,7 +140,11 @@ class RenderSubpasses : public vkb::VulkanSample
 	     /* value       = */ 0},
 	    {/* config      = */ Config::GBufferSize,
 	     /* description = */ "G-Buffer size",
-	     /* options     = */ {"128-bit", "More"},
+	     /* options     = */ {"128-bit", "More", "Compact"},
+	     /* value       = */ 0},
+	    {/* config      = */ Config::Precision,
+	     /* description = */ "Shader precision",
+	     /* options     = */ {"Full", "Half"},
 	     /* value       = */ 0}};
 };
 
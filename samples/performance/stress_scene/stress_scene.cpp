@@ -0,0 +1,171 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stress_scene.h"
+
+#include "common/utils.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/node.h"
+#include "stats/stats.h"
+
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+#	include "platform/android/android_platform.h"
+#endif
+
+StressScene::StressScene()
+{
+	auto &config = get_configuration();
+
+	// The batch mode draws the scene at every node count
+	for (size_t i = 0; i < node_counts.size(); ++i)
+	{
+		config.insert<vkb::IntSetting>(vkb::to_u32(i), node_count_index, static_cast<int>(i));
+	}
+}
+
+bool StressScene::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	generate_scene();
+
+	stats->request_stats({vkb::StatIndex::frame_times,
+	                      vkb::StatIndex::frame_cpu_update,
+	                      vkb::StatIndex::frame_cpu_record,
+	                      vkb::StatIndex::frame_gpu_time});
+
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	return true;
+}
+
+void StressScene::update(float delta_time)
+{
+	auto selected_options = get_selected_options();
+
+	if (selected_options.node_count != scene_options.node_count ||
+	    selected_options.hierarchy_depth != scene_options.hierarchy_depth ||
+	    selected_options.mesh_count != scene_options.mesh_count ||
+	    selected_options.material_count != scene_options.material_count ||
+	    selected_options.light_count != scene_options.light_count)
+	{
+		generate_scene();
+	}
+
+	VulkanSample::update(delta_time);
+}
+
+vkb::StressSceneOptions StressScene::get_selected_options() const
+{
+	vkb::StressSceneOptions options;
+
+	options.node_count      = node_counts[node_count_index];
+	options.hierarchy_depth = hierarchy_depths[hierarchy_depth_index];
+	options.mesh_count      = mesh_counts[mesh_count_index];
+	options.material_count  = material_counts[material_count_index];
+	options.light_count     = light_counts[light_count_index];
+
+	return options;
+}
+
+void StressScene::generate_scene()
+{
+	scene_options = get_selected_options();
+
+	// The frames in flight may still draw the previous scene, which the render pipeline references
+	get_device().wait_idle();
+	render_pipeline.reset();
+
+	vkb::StressSceneGenerator generator{get_device()};
+	scene = generator.generate(scene_options);
+
+	auto &camera_node = vkb::add_free_camera(*scene, "default_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+
+	auto scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	// The light uniform holds MAX_FORWARD_LIGHT_COUNT lights, more lights are assigned to clusters
+	scene_subpass->set_clustered_lights(scene_options.light_count > MAX_FORWARD_LIGHT_COUNT);
+
+	auto render_pipeline = vkb::RenderPipeline();
+	render_pipeline.add_subpass(std::move(scene_subpass));
+	set_render_pipeline(std::move(render_pipeline));
+}
+
+void StressScene::draw_gui()
+{
+	auto draw_option = [](const char *label, int &index, const auto &values) {
+		ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.15f);
+		if (ImGui::BeginCombo(label, std::to_string(values[index]).c_str()))
+		{
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				bool is_selected = index == static_cast<int>(i);
+				if (ImGui::Selectable(std::to_string(values[i]).c_str(), is_selected))
+				{
+					index = static_cast<int>(i);
+				}
+
+				if (is_selected)
+				{
+					ImGui::SetItemDefaultFocus();
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::PopItemWidth();
+	};
+
+	bool     landscape = camera->get_aspect_ratio() > 1.0f;
+	uint32_t lines     = landscape ? 2 : 3;
+
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    draw_option("Nodes", node_count_index, node_counts);
+		    ImGui::SameLine();
+		    draw_option("Depth", hierarchy_depth_index, hierarchy_depths);
+		    if (landscape)
+		    {
+			    ImGui::SameLine();
+		    }
+		    draw_option("Meshes", mesh_count_index, mesh_counts);
+		    if (!landscape)
+		    {
+			    ImGui::SameLine();
+		    }
+		    draw_option("Materials", material_count_index, material_counts);
+		    if (landscape)
+		    {
+			    ImGui::SameLine();
+		    }
+		    draw_option("Lights", light_count_index, light_counts);
+	    },
+	    /* lines = */ lines);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_stress_scene()
+{
+	return std::make_unique<StressScene>();
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "rendering/render_pipeline.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "stress_scene_generator.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Draws a generated scene whose node, mesh, material and light counts are set from the GUI,
+ *        to find where culling, sorting, descriptor management and draw submission stop scaling
+ */
+class StressScene : public vkb::VulkanSample
+{
+  public:
+	StressScene();
+
+	virtual ~StressScene() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	/**
+	 * @return The options selected from the GUI
+	 */
+	vkb::StressSceneOptions get_selected_options() const;
+
+	/**
+	 * @brief Generates the scene from the selected options and creates the render pipeline drawing it
+	 */
+	void generate_scene();
+
+	virtual void draw_gui() override;
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	// Choices of every option, selected by index from the GUI or the batch mode configurations
+	const std::array<uint32_t, 4> node_counts{1000, 10000, 100000, 1000000};
+
+	const std::array<uint32_t, 3> hierarchy_depths{1, 4, 16};
+
+	const std::array<uint32_t, 4> mesh_counts{1, 16, 256, 4096};
+
+	const std::array<uint32_t, 3> material_counts{1, 16, 256};
+
+	const std::array<uint32_t, 4> light_counts{1, 16, 64, 256};
+
+	int node_count_index{0};
+
+	int hierarchy_depth_index{0};
+
+	int mesh_count_index{1};
+
+	int material_count_index{1};
+
+	int light_count_index{0};
+
+	// Options of the scene being drawn, it is generated again when they change
+	vkb::StressSceneOptions scene_options;
+};
+
+std::unique_ptr<vkb::VulkanSample> create_stress_scene();
@@ -19,11 +19,6 @@
 
 #include "common/error.h"
 
-VKBP_DISABLE_WARNINGS()
-#include "common/glm_common.h"
-#include <glm/gtc/matrix_transform.hpp>
-VKBP_ENABLE_WARNINGS()
-
 #include "core/device.h"
 #include "core/pipeline_layout.h"
 #include "core/shader_module.h"
@@ -81,41 +76,14 @@ bool SurfaceRotation::prepare(vkb::Platform &platform)
 void SurfaceRotation::update(float delta_time)
 {
 	// Process GUI input, recreating the swapchain if pre-rotate mode was
-	// enabled/disabled by the user. Otherwise it might still be recreated if
-	// a 180 degree change in orientation is detected
-	if (pre_rotate != last_pre_rotate)
+	// enabled/disabled by the user. While it is enabled the render context
+	// follows the transform of the surface, including 180 degree rotations,
+	// and the cameras and GUI get the matching rotation matrix
+	if (pre_rotate != get_render_context().is_using_pre_rotation())
 	{
 		recreate_swapchain();
-
-		last_pre_rotate = pre_rotate;
-	}
-	else
-	{
-		handle_no_resize_rotations();
-	}
-
-	// In pre-rotate mode, the application has to handle the rotation.
-	// The swapchain preTransform attribute will now be something other than
-	// identity only if pre-rotate mode is enabled
-	glm::mat4   pre_rotate_mat = glm::mat4(1.0f);
-	glm::vec3   rotation_axis  = glm::vec3(0.0f, 0.0f, 1.0f);
-	const auto &swapchain      = get_render_context().get_swapchain();
-
-	if (swapchain.get_transform() & VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR)
-	{
-		pre_rotate_mat = glm::rotate(pre_rotate_mat, glm::radians(90.0f), rotation_axis);
-	}
-	else if (swapchain.get_transform() & VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
-	{
-		pre_rotate_mat = glm::rotate(pre_rotate_mat, glm::radians(270.0f), rotation_axis);
-	}
-	else if (swapchain.get_transform() & VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR)
-	{
-		pre_rotate_mat = glm::rotate(pre_rotate_mat, glm::radians(180.0f), rotation_axis);
 	}
 
-	camera->set_pre_rotation(pre_rotate_mat);
-
 	VulkanSample::update(delta_time);
 }
 
@@ -156,58 +124,15 @@ void SurfaceRotation::draw_gui()
 	}
 }
 
-VkSurfaceTransformFlagBitsKHR SurfaceRotation::select_pre_transform()
-{
-	VkSurfaceTransformFlagBitsKHR pre_transform;
-
-	if (pre_rotate)
-	{
-		VkSurfaceCapabilitiesKHR surface_properties;
-		VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(get_device().get_gpu().get_handle(),
-		                                                   get_surface(),
-		                                                   &surface_properties));
-
-		// Best practice: adjust the preTransform attribute in the swapchain properties
-		// so that it matches the value in the surface properties. This is to
-		// communicate to the presentation engine that the application is pre-rotating
-		pre_transform = surface_properties.currentTransform;
-	}
-	else
-	{
-		// Bad practice: keep preTransform as identity
-		pre_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
-	}
-
-	return pre_transform;
-}
-
-void SurfaceRotation::handle_no_resize_rotations()
-{
-	// The render context recreates the swapchain if it detects a change of dimensions or an
-	// out-of-date swapchain. However 180 degree rotations do not currently trigger a resize.
-	// If pre-rotate mode is enabled, the sample will detect a 180 degree change in orientation
-	// and re-create the swapchain
-	VkSurfaceCapabilitiesKHR surface_properties;
-	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(get_device().get_gpu().get_handle(),
-	                                                   get_surface(),
-	                                                   &surface_properties));
-
-	if (surface_properties.currentExtent.width == get_render_context().get_surface_extent().width &&
-	    surface_properties.currentExtent.height == get_render_context().get_surface_extent().height &&
-	    (pre_rotate && surface_properties.currentTransform != get_render_context().get_swapchain().get_transform()))
-	{
-		recreate_swapchain();
-	}
-}
-
 void SurfaceRotation::recreate_swapchain()
 {
-	get_device().wait_idle();
+	// Best practice: create the swapchain with the preTransform of the surface, so the
+	// presentation engine knows the application is pre-rotating.
+	// Bad practice: keep preTransform as identity, so the compositor rotates every frame
+	get_render_context().set_pre_rotation(pre_rotate);
 
 	auto surface_extent = get_render_context().get_surface_extent();
 
-	get_render_context().update_swapchain(surface_extent, select_pre_transform());
-
 	if (gui)
 	{
 		gui->resize(surface_extent.width, surface_extent.height);
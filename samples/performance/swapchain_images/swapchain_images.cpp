@@ -62,7 +62,15 @@ bool SwapchainImages::prepare(vkb::Platform &platform)
 
 	set_render_pipeline(std::move(render_pipeline));
 
-	stats->request_stats({vkb::StatIndex::frame_times});
+	// Measure the latency of the frames without changing how far the CPU runs ahead
+	auto latency_mode            = get_render_context().get_latency_mode();
+	latency_mode.measure_latency = true;
+	get_render_context().set_latency_mode(latency_mode);
+
+	stats->request_stats({vkb::StatIndex::frame_times,
+	                      vkb::StatIndex::frame_input_latency,
+	                      vkb::StatIndex::frame_cpu_bubble,
+	                      vkb::StatIndex::frame_gpu_bubble});
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
 	return true;
@@ -61,8 +61,17 @@ bool WaitIdle::prepare(vkb::Platform &plat)
 	render_pipeline.add_subpass(std::move(scene_subpass));
 	set_render_pipeline(std::move(render_pipeline));
 
+	// Measure the latency of the frames without changing how far the CPU runs ahead
+	auto latency_mode            = get_render_context().get_latency_mode();
+	latency_mode.measure_latency = true;
+	get_render_context().set_latency_mode(latency_mode);
+
 	// Add a GUI with the stats you want to monitor
-	stats->request_stats({vkb::StatIndex::frame_times});
+	stats->request_stats({vkb::StatIndex::frame_times,
+	                      vkb::StatIndex::frame_input_latency,
+	                      vkb::StatIndex::frame_cpu_bubble,
+	                      vkb::StatIndex::frame_gpu_bubble,
+	                      vkb::StatIndex::cpu_main_thread_busy});
 	gui = std::make_unique<vkb::Gui>(*this, plat.get_window(), stats.get());
 
 	return true;
@@ -16,43 +16,131 @@
  * limitations under the License.
  */
 
+#ifdef HALF_PRECISION
+// The shading math may run in 16-bit floats, the positions and texture coordinates are declared highp
+precision mediump float;
+#else
 precision highp float;
+#endif
+
+#ifdef BINDLESS_MATERIALS
+#	if BINDLESS_TEXTURE_COUNT > 0
+layout(set = 1, binding = 0) uniform sampler2D bindless_textures[BINDLESS_TEXTURE_COUNT];
+#	endif
+
+// Texture index of the materials without the texture
+#	define NO_TEXTURE 0xFFFFFFFFU
+
+// Flags of the materials
+#	define MATERIAL_ALPHA_MASK 1U
+#	define MATERIAL_ALPHA_BLEND 2U
+#	define MATERIAL_DOUBLE_SIDED 4U
+
+struct BindlessMaterial
+{
+	vec4  base_color_factor;
+	vec3  emissive_factor;
+	float alpha_cutoff;
+	float metallic_factor;
+	float roughness_factor;
+	uint  base_color_texture;
+	uint  normal_texture;
+	uint  metallic_roughness_texture;
+	uint  occlusion_texture;
+	uint  emissive_texture;
+	uint  flags;
+};
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+layout(set = 1, binding = 1, std430) readonly buffer BindlessMaterials
+{
+	BindlessMaterial materials[];
+}
+bindless_materials;
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 layout(set = 0, binding = 0) uniform sampler2D base_color_texture;
 #endif
 
-layout(location = 0) in vec4 in_pos;
-layout(location = 1) in vec2 in_uv;
+layout(location = 0) in highp vec4 in_pos;
+layout(location = 1) in highp vec2 in_uv;
 layout(location = 2) in vec3 in_normal;
 
 layout(location = 0) out vec4 o_color;
 
+#ifdef WEIGHTED_BLENDED_OIT
+// Weighted sum of the premultiplied colors and coverages, and product of the transmittances
+layout(location = 1) out vec4 o_accumulation;
+layout(location = 2) out float o_revealage;
+#endif
+
 layout(set = 0, binding = 1) uniform GlobalUniform
 {
-	mat4 model;
-	mat4 view_proj;
-	vec3 camera_position;
+	highp mat4 model;
+	highp mat4 view_proj;
+	highp vec3 camera_position;
 }
 global_uniform;
 
 struct Light
 {
-	vec4 position;         // position.w represents type of light
-	vec4 color;            // color.w represents light intensity
-	vec4 direction;        // direction.w represents range
-	vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
+	highp vec4 position;         // position.w represents type of light
+	vec4       color;            // color.w represents light intensity
+	vec4       direction;        // direction.w represents range
+	vec2       info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
+#ifdef CLUSTERED_LIGHTS
+// Lights reaching every cluster come first, then the lights listed by the clusters
+layout(set = 0, binding = 4, std430) readonly buffer LightsInfo
+{
+	Light light[];
+}
+lights;
+
+layout(set = 0, binding = 5) uniform LightClusterUniform
+{
+	highp mat4  view;
+	highp vec2  inv_resolution;
+	highp float depth_scale;
+	highp float depth_bias;
+	uint        global_light_count;
+}
+light_clusters;
+
+// Offset and count in indices of the lights of each cluster
+layout(set = 0, binding = 6, std430) readonly buffer LightClusters
+{
+	uvec2 ranges[LIGHT_CLUSTER_COUNT];
+	uint  indices[];
+}
+clusters;
+#else
 layout(set = 0, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light light[MAX_FORWARD_LIGHT_COUNT];
 }
 lights;
+#endif
+
+// Baked by the subpass, ~0 reads the count of the light uniform and keeps the branches of every light type
+layout(constant_id = 16) const uint LIGHT_COUNT     = 0xFFFFFFFFU;
+layout(constant_id = 17) const uint LIGHT_TYPE_MASK = 0xFFFFFFFFU;
+
+// Whether the lights can be of a type, the test folds to a constant once specialized
+bool has_light_type(float type)
+{
+	return (LIGHT_TYPE_MASK & (1U << uint(type))) != 0U;
+}
 
 // Push constants come with a limitation in the size of data.
 // The standard requires at least 128 bytes
+#ifdef BINDLESS_MATERIALS
+layout(push_constant, std430) uniform BindlessMaterialIndex
+{
+	uint material_index;
+}
+bindless_material_index;
+#else
 layout(push_constant, std430) uniform PBRMaterialUniform
 {
 	vec4  base_color_factor;
@@ -60,6 +148,7 @@ layout(push_constant, std430) uniform PBRMaterialUniform
 	float roughness_factor;
 }
 pbr_material_uniform;
+#endif
 
 vec3 apply_directional_light(uint index, vec3 normal)
 {
@@ -74,9 +163,9 @@ vec3 apply_directional_light(uint index, vec3 normal)
 
 vec3 apply_point_light(uint index, vec3 normal)
 {
-	vec3 world_to_light = lights.light[index].position.xyz - in_pos.xyz;
+	highp vec3 world_to_light = lights.light[index].position.xyz - in_pos.xyz;
 
-	float dist = length(world_to_light);
+	highp float dist = length(world_to_light);
 
 	float atten = 1.0 / (dist * dist);
 
@@ -87,27 +176,72 @@ vec3 apply_point_light(uint index, vec3 normal)
 	return ndotl * lights.light[index].color.w * atten * lights.light[index].color.rgb;
 }
 
+vec3 apply_light(uint index, vec3 normal)
+{
+	if (has_light_type(DIRECTIONAL_LIGHT) && lights.light[index].position.w == DIRECTIONAL_LIGHT)
+	{
+		return apply_directional_light(index, normal);
+	}
+	if (has_light_type(POINT_LIGHT) && lights.light[index].position.w == POINT_LIGHT)
+	{
+		return apply_point_light(index, normal);
+	}
+
+	return vec3(0.0);
+}
+
+#ifdef CLUSTERED_LIGHTS
+uint get_light_cluster(highp vec3 pos)
+{
+	highp float depth = -(light_clusters.view * vec4(pos, 1.0)).z;
+
+	uvec2 tile  = uvec2(clamp(gl_FragCoord.xy * light_clusters.inv_resolution, 0.0, 0.999) * vec2(LIGHT_CLUSTER_TILE_COUNT_X, LIGHT_CLUSTER_TILE_COUNT_Y));
+	uint  slice = uint(clamp(log(max(depth, 1e-4)) * light_clusters.depth_scale + light_clusters.depth_bias, 0.0, float(LIGHT_CLUSTER_SLICE_COUNT - 1)));
+
+	return (slice * LIGHT_CLUSTER_TILE_COUNT_Y + tile.y) * LIGHT_CLUSTER_TILE_COUNT_X + tile.x;
+}
+#endif
+
 void main(void)
 {
 	vec3 normal = normalize(in_normal);
 
 	vec3 light_contribution = vec3(0.0);
 
-	for (uint i = 0U; i < lights.count; i++)
+#ifdef CLUSTERED_LIGHTS
+	for (uint i = 0U; i < light_clusters.global_light_count; i++)
 	{
-		if (lights.light[i].position.w == DIRECTIONAL_LIGHT)
-		{
-			light_contribution += apply_directional_light(i, normal);
-		}
-		if (lights.light[i].position.w == POINT_LIGHT)
-		{
-			light_contribution += apply_point_light(i, normal);
-		}
+		light_contribution += apply_light(i, normal);
 	}
 
+	uvec2 range = clusters.ranges[get_light_cluster(in_pos.xyz)];
+
+	for (uint i = 0U; i < range.y; i++)
+	{
+		light_contribution += apply_light(clusters.indices[range.x + i], normal);
+	}
+#else
+	uint light_count = LIGHT_COUNT == 0xFFFFFFFFU ? lights.count : LIGHT_COUNT;
+	for (uint i = 0U; i < light_count; i++)
+	{
+		light_contribution += apply_light(i, normal);
+	}
+#endif
+
 	vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#ifdef BINDLESS_MATERIALS
+	// The index is the same for the whole draw, so dynamic indexing is enough
+	BindlessMaterial material = bindless_materials.materials[bindless_material_index.material_index];
+
+	base_color = material.base_color_factor;
+#	if BINDLESS_TEXTURE_COUNT > 0
+	if (material.base_color_texture != NO_TEXTURE)
+	{
+		base_color = texture(bindless_textures[material.base_color_texture], in_uv);
+	}
+#	endif
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 	base_color = texture(base_color_texture, in_uv);
 #else
 	base_color = pbr_material_uniform.base_color_factor;
@@ -116,4 +250,12 @@ void main(void)
 	vec3 ambient_color = vec3(0.2) * base_color.xyz;
 
 	o_color = vec4(ambient_color + light_contribution * base_color.xyz, base_color.w);
+
+#ifdef WEIGHTED_BLENDED_OIT
+	// Weight of McGuire and Bavoil's depth based function, the depth is reversed so nearer surfaces have a larger one
+	highp float weight = clamp(pow(min(1.0, o_color.a * 10.0) + 0.01, 3.0) * (1e8 * pow(0.1 + gl_FragCoord.z * 0.9, 3.0)), 1e-2, 3e3);
+
+	o_accumulation = vec4(o_color.rgb * o_color.a, o_color.a) * weight;
+	o_revealage    = o_color.a;
+#endif
 }
@@ -16,6 +16,10 @@
  * limitations under the License.
  */
 
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#endif
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texcoord_0;
 layout(location = 2) in vec3 normal;
@@ -26,17 +30,71 @@ layout(set = 0, binding = 1) uniform GlobalUniform {
     vec3 camera_position;
 } global_uniform;
 
+#ifdef INSTANCE_MODELS
+// Model matrix of each instance, the instance index includes the first instance of the draw
+layout(set = 0, binding = 7, std430) readonly buffer DrawModels {
+    mat4 models[];
+} draw_models;
+#endif
+
+#ifdef TRANSFORM_BUFFER
+struct Transform {
+    vec4 rows[3];
+};
+
+// Rows of the world matrix of each node, the instance index is the slot of the node
+layout(set = 0, binding = 15, std430) readonly buffer DrawTransforms {
+    Transform transforms[];
+} draw_transforms;
+#endif
+
+#ifdef MULTIVIEW
+// View projection of each view of the subpass, the view being rendered is selected by gl_ViewIndex
+layout(set = 0, binding = 14) uniform ViewUniform {
+    mat4 view_proj[6];
+} view_uniform;
+#endif
+
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef TRANSFORM_BUFFER
+    Transform transform = draw_transforms.transforms[gl_InstanceIndex];
+
+    mat3 rotation = transpose(mat3(transform.rows[0].xyz, transform.rows[1].xyz, transform.rows[2].xyz));
+
+    // Relative to the camera before adding the vertex, so large translations do not lose its precision
+    vec3 translation = vec3(transform.rows[0].w, transform.rows[1].w, transform.rows[2].w) - global_uniform.camera_position;
+    vec3 relative    = rotation * position + translation;
+
+    o_pos = vec4(relative + global_uniform.camera_position, 1.0);
+
+    o_uv = texcoord_0;
+
+    o_normal = rotation * normal;
+
+    // The view projection of the variant leaves out the camera translation
+    gl_Position = global_uniform.view_proj * vec4(relative, 1.0);
+#else
+#ifdef INSTANCE_MODELS
+    mat4 model = draw_models.models[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+    o_pos = model * vec4(position, 1.0);
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+    o_normal = mat3(model) * normal;
 
+#ifdef MULTIVIEW
+    gl_Position = view_uniform.view_proj[gl_ViewIndex] * o_pos;
+#else
     gl_Position = global_uniform.view_proj * o_pos;
+#endif
+#endif
 }
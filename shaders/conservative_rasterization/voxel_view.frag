@@ -0,0 +1,93 @@
+#version 450
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout (binding = 0) uniform UBO
+{
+	mat4 inverseViewProjection;
+	vec4 cameraPosition;
+	uint gridSize;
+} ubo;
+
+layout (binding = 1, r32ui) uniform readonly uimage3D voxelGrid;
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outFragColor;
+
+void main()
+{
+	// Reconstruct the view ray through this pixel
+	vec4 target    = ubo.inverseViewProjection * vec4(inUV * 2.0 - 1.0, 0.5, 1.0);
+	vec3 origin    = ubo.cameraPosition.xyz;
+	vec3 direction = normalize(target.xyz / target.w - origin);
+
+	outFragColor = vec4(0.25, 0.25, 0.25, 1.0);
+
+	// Intersect with the [-1, 1] grid bounds
+	vec3  t0   = (vec3(-1.0) - origin) / direction;
+	vec3  t1   = (vec3(1.0) - origin) / direction;
+	vec3  tmin = min(t0, t1);
+	vec3  tmax = max(t0, t1);
+	float near = max(max(tmin.x, tmin.y), max(tmin.z, 0.0));
+	float far  = min(tmax.x, min(tmax.y, tmax.z));
+	if (far < near)
+	{
+		return;
+	}
+
+	// Walk the voxels along the ray in grid space (3D DDA)
+	vec3  start   = (origin + direction * near + 1.0) * 0.5 * float(ubo.gridSize);
+	ivec3 voxel   = clamp(ivec3(floor(start)), ivec3(0), ivec3(ubo.gridSize - 1));
+	ivec3 stepDir = ivec3(sign(direction));
+	vec3  delta   = abs(1.0 / direction);
+	vec3  next    = (vec3(voxel) + max(vec3(stepDir), 0.0) - start) / direction;
+	int   axis    = 0;
+
+	for (uint i = 0; i < ubo.gridSize * 3; i++)
+	{
+		if (any(lessThan(voxel, ivec3(0))) || any(greaterThanEqual(voxel, ivec3(ubo.gridSize))))
+		{
+			break;
+		}
+		if (imageLoad(voxelGrid, voxel).r != 0u)
+		{
+			// Shade by the axis of the face the ray entered through
+			float shade  = axis == 0 ? 1.0 : (axis == 1 ? 0.8 : 0.6);
+			outFragColor = vec4(vec3(0.3, 0.6, 0.9) * shade, 1.0);
+			return;
+		}
+		if (next.x < next.y && next.x < next.z)
+		{
+			voxel.x += stepDir.x;
+			next.x += delta.x;
+			axis = 0;
+		}
+		else if (next.y < next.z)
+		{
+			voxel.y += stepDir.y;
+			next.y += delta.y;
+			axis = 1;
+		}
+		else
+		{
+			voxel.z += stepDir.z;
+			next.z += delta.z;
+			axis = 2;
+		}
+	}
+}
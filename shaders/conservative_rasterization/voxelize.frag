@@ -0,0 +1,35 @@
+#version 450
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout (binding = 0, r32ui) uniform uimage3D voxelGrid;
+
+layout (push_constant) uniform PushConstants
+{
+	uint gridSize;
+	uint triangleCount;
+} params;
+
+layout (location = 0) flat in uint inAxis;
+
+void main()
+{
+	// Conservative rasterization generates a fragment for every voxel column the triangle touches
+	ivec3 s     = ivec3(gl_FragCoord.xy, min(uint(gl_FragCoord.z * float(params.gridSize)), params.gridSize - 1));
+	ivec3 voxel = inAxis == 0 ? s.zxy : (inAxis == 1 ? s.yzx : s);
+	imageAtomicOr(voxelGrid, voxel, 1u);
+}
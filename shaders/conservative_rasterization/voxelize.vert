@@ -0,0 +1,34 @@
+#version 450
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout (location = 0) in vec3 inPos;
+
+layout (location = 0) flat out uint outAxis;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main()
+{
+	// Project along X, Y or Z depending on the instance, the dropped axis becomes the depth
+	outAxis = uint(gl_InstanceIndex);
+	vec3 p  = outAxis == 0 ? inPos.yzx : (outAxis == 1 ? inPos.zxy : inPos);
+	gl_Position = vec4(p.xy, p.z * 0.5 + 0.5, 1.0);
+}
@@ -16,23 +16,41 @@
  * limitations under the License.
  */
 
+#ifdef HALF_PRECISION
+// The G-buffer values may be computed in 16-bit floats, the positions and texture coordinates are declared highp
+precision mediump float;
+#else
 precision highp float;
+#endif
 
 #ifdef HAS_BASE_COLOR_TEXTURE
 layout (set=0, binding=0) uniform sampler2D base_color_texture;
 #endif
 
-layout (location = 0) in vec4 in_pos;
-layout (location = 1) in vec2 in_uv;
+layout (location = 0) in highp vec4 in_pos;
+layout (location = 1) in highp vec2 in_uv;
 layout (location = 2) in vec3 in_normal;
 
 layout (location = 0) out vec4 o_albedo;
 layout (location = 1) out vec4 o_normal;
 
+#ifdef MOTION_VECTORS
+layout (location = 3) in highp vec4 in_clip_pos;
+layout (location = 4) in highp vec4 in_previous_clip_pos;
+
+// Motion since the previous frame in normalized device coordinates
+layout (location = 2) out highp vec2 o_motion;
+#endif
+
 layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+#ifdef MOTION_VECTORS
+    mat4 previous_model;
+    mat4 previous_view_proj;
+    vec2 jitter;
+#endif
 } global_uniform;
 
 layout(push_constant, std430) uniform PBRMaterialUniform {
@@ -41,11 +59,30 @@ layout(push_constant, std430) uniform PBRMaterialUniform {
     float roughness_factor;
 } pbr_material_uniform;
 
+#ifdef COMPACT_GBUFFER
+// Projects a unit vector on the octahedron, then folds its lower half over the upper one
+vec2 encode_octahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return n.xy;
+}
+#endif
+
 void main(void)
 {
     vec3 normal = normalize(in_normal);
+#ifdef COMPACT_GBUFFER
+    o_normal = vec4(encode_octahedral(normal), 0.0, 0.0);
+#else
     // Transform normals from [-1, 1] to [0, 1]
     o_normal = vec4(0.5 * normal + 0.5, 1.0);
+#endif
 
     vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
@@ -55,5 +92,16 @@ void main(void)
     base_color = pbr_material_uniform.base_color_factor;
 #endif
 
+#ifdef COMPACT_GBUFFER
+    // The metallic and roughness factors take four bits each of the alpha
+    float metallic  = round(clamp(pbr_material_uniform.metallic_factor, 0.0, 1.0) * 15.0);
+    float roughness = round(clamp(pbr_material_uniform.roughness_factor, 0.0, 1.0) * 15.0);
+    o_albedo        = vec4(base_color.rgb, (metallic * 16.0 + roughness) / 255.0);
+#else
     o_albedo = base_color;
+#endif
+
+#ifdef MOTION_VECTORS
+    o_motion = in_clip_pos.xy / in_clip_pos.w - in_previous_clip_pos.xy / in_previous_clip_pos.w;
+#endif
 }
@@ -24,19 +24,62 @@ layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+#ifdef MOTION_VECTORS
+    mat4 previous_model;
+    mat4 previous_view_proj;
+    vec2 jitter;
+#endif
 } global_uniform;
 
+#ifdef INSTANCE_MODELS
+// Model matrix of each instance, the instance index includes the first instance of the draw
+layout(set = 0, binding = 7, std430) readonly buffer DrawModels {
+    mat4 models[];
+} draw_models;
+
+#ifdef MOTION_VECTORS
+layout(set = 0, binding = 13, std430) readonly buffer DrawPreviousModels {
+    mat4 previous_models[];
+} draw_previous_models;
+#endif
+#endif
+
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
 
+#ifdef MOTION_VECTORS
+// Unjittered positions of the vertex in this frame and in the previous one
+layout (location = 3) out vec4 o_clip_pos;
+layout (location = 4) out vec4 o_previous_clip_pos;
+#endif
+
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef INSTANCE_MODELS
+    mat4 model = draw_models.models[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+    o_pos = model * vec4(position, 1.0);
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+    o_normal = mat3(model) * normal;
 
     gl_Position = global_uniform.view_proj * o_pos;
+
+#ifdef MOTION_VECTORS
+#ifdef INSTANCE_MODELS
+    mat4 previous_model = draw_previous_models.previous_models[gl_InstanceIndex];
+#else
+    mat4 previous_model = global_uniform.previous_model;
+#endif
+
+    o_clip_pos = gl_Position;
+    o_clip_pos.xy -= global_uniform.jitter * gl_Position.w;
+
+    o_previous_clip_pos = global_uniform.previous_view_proj * previous_model * vec4(position, 1.0);
+#endif
 }
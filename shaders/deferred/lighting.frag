@@ -15,36 +15,128 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#ifdef RAY_QUERY
+#extension GL_EXT_ray_query : require
+#endif
+
+#ifdef HALF_PRECISION
+// The shading math may run in 16-bit floats, the positions, depths and shadow lookups are declared highp
+precision mediump float;
+#else
 precision highp float;
+#endif
 
-layout(input_attachment_index = 0, binding = 0) uniform subpassInput i_depth;
+layout(input_attachment_index = 0, binding = 0) uniform highp subpassInput i_depth;
 layout(input_attachment_index = 1, binding = 1) uniform subpassInput i_albedo;
 layout(input_attachment_index = 2, binding = 2) uniform subpassInput i_normal;
 
-layout(location = 0) in vec2 in_uv;
+layout(location = 0) in highp vec2 in_uv;
 layout(location = 0) out vec4 o_color;
 
 layout(set = 0, binding = 3) uniform GlobalUniform
 {
-    mat4 inv_view_proj;
-    vec2 inv_resolution;
+    highp mat4 inv_view_proj;
+    highp vec2 inv_resolution;
+#if defined(LIGHT_VOLUMES) || defined(RAY_QUERY)
+    highp mat4 view_proj;
+#endif
+#ifdef RAY_QUERY
+    highp float ray_bias;
+    highp float occlusion_radius;
+    uint        shadow_rays;
+    uint        occlusion_ray_count;
+#endif
 }
 global_uniform;
 
+#ifdef RAY_QUERY
+layout(set = 1, binding = 0) uniform accelerationStructureEXT scene_acceleration_structure;
+#endif
+
+#ifdef LIGHT_VOLUMES
+// A bounds extent of 0 draws the full screen triangle, otherwise a box around the light
+layout(push_constant, std430) uniform LightVolume
+{
+    highp vec4 bounds;
+    uint       first_light;
+    uint       light_count;
+}
+light_volume;
+#endif
+
 struct Light
 {
-    vec4 position;         // position.w represents type of light
-    vec4 color;            // color.w represents light intensity
-    vec4 direction;        // direction.w represents range
-    vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
+    highp vec4 position;         // position.w represents type of light
+    vec4       color;            // color.w represents light intensity
+    vec4       direction;        // direction.w represents range
+    vec2       info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
+#ifdef CLUSTERED_LIGHTS
+// Lights reaching every cluster come first, then the lights listed by the clusters
+layout(set = 0, binding = 4, std430) readonly buffer LightsInfo
+{
+    Light lights[];
+}
+lights;
+
+layout(set = 0, binding = 5) uniform LightClusterUniform
+{
+    highp mat4  view;
+    highp vec2  inv_resolution;
+    highp float depth_scale;
+    highp float depth_bias;
+    uint        global_light_count;
+}
+light_clusters;
+
+// Offset and count in indices of the lights of each cluster
+layout(set = 0, binding = 6, std430) readonly buffer LightClusters
+{
+    uvec2 ranges[LIGHT_CLUSTER_COUNT];
+    uint  indices[];
+}
+clusters;
+#else
 layout(set = 0, binding = 4) uniform LightsInfo
 {
     uint  count;
     Light lights[MAX_DEFERRED_LIGHT_COUNT];
 }
 lights;
+#endif
+
+#ifdef SHADOWS
+// Depth of the shadow casters in the tiles of an atlas, compared with the depth of the fragment
+layout(set = 0, binding = 7) uniform highp sampler2DShadow shadow_atlas;
+
+struct ShadowTile
+{
+    highp mat4 view_proj;
+    highp vec4 rect;         // rect.xy is the offset of the tile in the atlas, rect.zw its size, in UVs
+};
+
+layout(set = 0, binding = 8) uniform ShadowUniform
+{
+    highp mat4  view;
+    highp vec4  cascade_splits;          // View depth where each cascade of the directional lights ends
+    highp vec2  texel_size;
+    highp float normal_offset;
+    uvec4       light_tiles[SHADOW_LIGHT_COUNT];        // x is the first tile of each light, y its tile count
+    ShadowTile tiles[SHADOW_TILE_COUNT];
+}
+shadows;
+#endif
+
+// Baked by the subpass, ~0 reads the count of the light uniform and keeps the branches of every light type
+layout(constant_id = 16) const uint LIGHT_COUNT     = 0xFFFFFFFFU;
+layout(constant_id = 17) const uint LIGHT_TYPE_MASK = 0xFFFFFFFFU;
+
+// Whether the lights can be of a type, the test folds to a constant once specialized
+bool has_light_type(float type)
+{
+    return (LIGHT_TYPE_MASK & (1U << uint(type))) != 0U;
+}
 
 vec3 apply_directional_light(uint index, vec3 normal)
 {
@@ -54,44 +146,279 @@ vec3 apply_directional_light(uint index, vec3 normal)
     return ndotl * lights.lights[index].color.w * lights.lights[index].color.rgb;
 }
 
-vec3 apply_point_light(uint index, vec3 pos, vec3 normal)
+vec3 apply_point_light(uint index, highp vec3 pos, vec3 normal)
 {
-    vec3 world_to_light = lights.lights[index].position.xyz - pos;
-    float dist = length(world_to_light) * 0.005;
+    highp vec3 world_to_light = lights.lights[index].position.xyz - pos;
+    highp float dist = length(world_to_light) * 0.005;
     float atten = 1.0 / (dist * dist);
     world_to_light = normalize(world_to_light);
     float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
     return ndotl * lights.lights[index].color.w * atten * lights.lights[index].color.rgb;
 }
 
+vec3 apply_light(uint index, highp vec3 pos, vec3 normal)
+{
+    if (has_light_type(DIRECTIONAL_LIGHT) && lights.lights[index].position.w == DIRECTIONAL_LIGHT)
+    {
+        return apply_directional_light(index, normal);
+    }
+    if (has_light_type(POINT_LIGHT) && lights.lights[index].position.w == POINT_LIGHT)
+    {
+        return apply_point_light(index, pos, normal);
+    }
+
+    return vec3(0.0);
+}
+
+#ifdef RAY_QUERY
+// Whether no geometry of the scene lies along the ray, up to t_max
+bool is_unoccluded(highp vec3 origin, highp vec3 direction, highp float t_max)
+{
+    rayQueryEXT ray_query;
+    rayQueryInitializeEXT(ray_query, scene_acceleration_structure, gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsOpaqueEXT, 0xFF,
+                          origin, 0.0, direction, t_max);
+
+    // All the geometry is opaque, there are no candidates to confirm
+    while (rayQueryProceedEXT(ray_query))
+    {
+    }
+
+    return rayQueryGetIntersectionTypeEXT(ray_query, true) == gl_RayQueryCommittedIntersectionNoneEXT;
+}
+
+// Cosine weighted hemisphere rays around the normal, returns the fraction of rays that escape the occlusion radius
+float trace_occlusion(highp vec3 pos, vec3 normal)
+{
+    vec3 up        = abs(normal.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent   = normalize(cross(up, normal));
+    vec3 bitangent = cross(normal, tangent);
+
+    // Interleaved gradient noise rotates the pattern of each pixel, turning the banding of few rays into noise
+    float rotation = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+
+    highp vec3 origin     = pos + normal * global_uniform.ray_bias;
+    uint       unoccluded = 0U;
+    for (uint i = 0U; i < global_uniform.occlusion_ray_count; i++)
+    {
+        // Spiral of golden angle steps over the projected disk
+        float r   = sqrt((float(i) + 0.5) / float(global_uniform.occlusion_ray_count));
+        float phi = float(i) * 2.3999632 + rotation;
+
+        vec3 direction = tangent * (r * cos(phi)) + bitangent * (r * sin(phi)) + normal * sqrt(1.0 - r * r);
+        if (is_unoccluded(origin, direction, global_uniform.occlusion_radius))
+        {
+            unoccluded++;
+        }
+    }
+
+    return float(unoccluded) / float(global_uniform.occlusion_ray_count);
+}
+#endif
+
+#ifdef SHADOWS
+// Fraction of the light reaching the position, from the tile of the light covering it
+float compute_shadow(uint index, highp vec3 pos, vec3 normal)
+{
+    if (index >= uint(SHADOW_LIGHT_COUNT))
+    {
+        return 1.0;
+    }
+
+    uvec2 light_tiles = shadows.light_tiles[index].xy;
+    if (light_tiles.y == 0U)
+    {
+        return 1.0;
+    }
+
+    uint tile = light_tiles.x;
+    if (lights.lights[index].position.w == DIRECTIONAL_LIGHT)
+    {
+        // Cascades cover consecutive ranges of the view depth, the shadows end after the last one
+        highp float depth   = -(shadows.view * vec4(pos, 1.0)).z;
+        uint        cascade = 0U;
+        while (cascade < light_tiles.y && depth > shadows.cascade_splits[cascade])
+        {
+            cascade++;
+        }
+        if (cascade == light_tiles.y)
+        {
+            return 1.0;
+        }
+        tile += cascade;
+    }
+    else if (lights.lights[index].position.w == POINT_LIGHT)
+    {
+        // Faces of the cube around the light, in the order +X, -X, +Y, -Y, +Z, -Z
+        highp vec3 to_pos = pos - lights.lights[index].position.xyz;
+        highp vec3 extent = abs(to_pos);
+        uint face   = extent.x >= extent.y && extent.x >= extent.z ? (to_pos.x > 0.0 ? 0U : 1U) :
+                                                                     extent.y >= extent.z ? (to_pos.y > 0.0 ? 2U : 3U) : (to_pos.z > 0.0 ? 4U : 5U);
+        tile += face;
+    }
+
+    highp vec4 clip = shadows.tiles[tile].view_proj * vec4(pos + normal * shadows.normal_offset, 1.0);
+    highp vec3 ndc  = clip.xyz / clip.w;
+
+    // Reversed depth as the scene, positions past the far plane of the tile are lit
+    if (any(greaterThan(abs(ndc.xy), vec2(1.0))) || ndc.z < 0.0)
+    {
+        return 1.0;
+    }
+
+    // 3x3 percentage closer filter, kept within the tile
+    highp vec4 rect   = shadows.tiles[tile].rect;
+    highp vec2 uv     = (ndc.xy * 0.5 + 0.5) * rect.zw + rect.xy;
+    highp vec2 uv_min = rect.xy + shadows.texel_size * 1.5;
+    highp vec2 uv_max = rect.xy + rect.zw - shadows.texel_size * 1.5;
+
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            lit += texture(shadow_atlas, vec3(clamp(uv + vec2(x, y) * shadows.texel_size, uv_min, uv_max), ndc.z));
+        }
+    }
+
+    return lit / 9.0;
+}
+#endif
+
+// Applies a light, with a shadow ray towards it in the RAY_QUERY variant, or its shadow map in the SHADOWS variant
+vec3 shade_light(uint index, highp vec3 pos, vec3 normal)
+{
+    vec3 light = apply_light(index, pos, normal);
+#ifdef SHADOWS
+    if (any(notEqual(light, vec3(0.0))))
+    {
+        light *= compute_shadow(index, pos, normal);
+    }
+#endif
+#ifdef RAY_QUERY
+    if (global_uniform.shadow_rays == 0U || all(equal(light, vec3(0.0))))
+    {
+        return light;
+    }
+
+    highp vec3  origin = pos + normal * global_uniform.ray_bias;
+    highp vec3  direction;
+    highp float t_max;
+    if (lights.lights[index].position.w == DIRECTIONAL_LIGHT)
+    {
+        direction = normalize(-lights.lights[index].direction.xyz);
+        t_max     = 1e30;
+    }
+    else
+    {
+        highp vec3 to_light = lights.lights[index].position.xyz - origin;
+        t_max         = length(to_light);
+        direction     = to_light / t_max;
+    }
+
+    if (!is_unoccluded(origin, direction, t_max))
+    {
+        return vec3(0.0);
+    }
+#endif
+    return light;
+}
+
+#ifdef CLUSTERED_LIGHTS
+uint get_light_cluster(highp vec3 pos)
+{
+    highp float depth = -(light_clusters.view * vec4(pos, 1.0)).z;
+
+    uvec2 tile  = uvec2(clamp(gl_FragCoord.xy * light_clusters.inv_resolution, 0.0, 0.999) * vec2(LIGHT_CLUSTER_TILE_COUNT_X, LIGHT_CLUSTER_TILE_COUNT_Y));
+    uint  slice = uint(clamp(log(max(depth, 1e-4)) * light_clusters.depth_scale + light_clusters.depth_bias, 0.0, float(LIGHT_CLUSTER_SLICE_COUNT - 1)));
+
+    return (slice * LIGHT_CLUSTER_TILE_COUNT_Y + tile.y) * LIGHT_CLUSTER_TILE_COUNT_X + tile.x;
+}
+#endif
+
+#ifdef COMPACT_GBUFFER
+// Unfolds the lower half of the octahedron written by deferred/geometry.frag
+vec3 decode_octahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(n);
+}
+#endif
+
 void main()
 {
+#ifdef LIGHT_VOLUMES
+    // Box faces have no meaningful uv
+    highp vec2 uv = gl_FragCoord.xy * global_uniform.inv_resolution;
+#else
+    highp vec2 uv = in_uv;
+#endif
+
     // Retrieve position from depth
-    vec4  clip         = vec4(in_uv * 2.0 - 1.0, subpassLoad(i_depth).x, 1.0);
+    highp vec4 clip    = vec4(uv * 2.0 - 1.0, subpassLoad(i_depth).x, 1.0);
     highp vec4 world_w = global_uniform.inv_view_proj * clip;
     highp vec3 pos     = world_w.xyz / world_w.w;
 
     vec4 albedo = subpassLoad(i_albedo);
 
+#ifdef COMPACT_GBUFFER
+    vec3 normal = decode_octahedral(subpassLoad(i_normal).xy);
+#else
     // Transform from [0,1] to [-1,1]
     vec3 normal = subpassLoad(i_normal).xyz;
     normal      = normalize(2.0 * normal - 1.0);
+#endif
 
     // Calculate lighting
     vec3 L = vec3(0.0);
-    for (uint i = 0U; i < lights.count; i++)
+#ifdef CLUSTERED_LIGHTS
+    for (uint i = 0U; i < light_clusters.global_light_count; i++)
     {
-        if (lights.lights[i].position.w == DIRECTIONAL_LIGHT)
-        {
-            L += apply_directional_light(i, normal);
-        }
-        if (lights.lights[i].position.w == POINT_LIGHT)
+        L += shade_light(i, pos, normal);
+    }
+
+    uvec2 range = clusters.ranges[get_light_cluster(pos)];
+    for (uint i = 0U; i < range.y; i++)
+    {
+        L += shade_light(clusters.indices[range.x + i], pos, normal);
+    }
+#elif defined(LIGHT_VOLUMES)
+    if (light_volume.bounds.w > 0.0)
+    {
+        // The box corners are out of the light range
+        if (distance(pos, light_volume.bounds.xyz) > light_volume.bounds.w)
         {
-            L += apply_point_light(i, pos, normal);
+            discard;
         }
+
+        o_color = vec4(shade_light(light_volume.first_light, pos, normal) * albedo.xyz, 0.0);
+        return;
     }
 
+    for (uint i = light_volume.first_light; i < light_volume.first_light + light_volume.light_count; i++)
+    {
+        L += shade_light(i, pos, normal);
+    }
+#else
+    uint light_count = LIGHT_COUNT == 0xFFFFFFFFU ? lights.count : LIGHT_COUNT;
+    for (uint i = 0U; i < light_count; i++)
+    {
+        L += shade_light(i, pos, normal);
+    }
+#endif
+
     vec3 ambient_color = vec3(0.2) * albedo.xyz;
+#ifdef RAY_QUERY
+    if (global_uniform.occlusion_ray_count > 0U)
+    {
+        ambient_color *= trace_occlusion(pos, normal);
+    }
+#endif
     
     o_color = vec4(ambient_color + L * albedo.xyz, 1.0);
 }
\ No newline at end of file
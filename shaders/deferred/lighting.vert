@@ -18,8 +18,47 @@
 
 layout (location = 0) out vec2 outUV;
 
+#ifdef LIGHT_VOLUMES
+layout(set = 0, binding = 3) uniform GlobalUniform
+{
+    mat4 inv_view_proj;
+    vec2 inv_resolution;
+    mat4 view_proj;
+}
+global_uniform;
+
+// A bounds extent of 0 draws the full screen triangle, otherwise a box around the light
+layout(push_constant, std430) uniform LightVolume
+{
+    vec4 bounds;
+    uint first_light;
+    uint light_count;
+}
+light_volume;
+
+// Corner i of the box is at ((i & 1), (i >> 1) & 1, (i >> 2) & 1) * 2 - 1, faces are counter clock-wise from outside
+const int box_corners[36] = int[](4, 5, 7, 4, 7, 6,
+                                  0, 2, 3, 0, 3, 1,
+                                  1, 3, 7, 1, 7, 5,
+                                  0, 4, 6, 0, 6, 2,
+                                  2, 6, 7, 2, 7, 3,
+                                  0, 1, 5, 0, 5, 4);
+#endif
+
 void main()
 {
+#ifdef LIGHT_VOLUMES
+	if (light_volume.bounds.w > 0.0f)
+	{
+		int  corner   = box_corners[gl_VertexIndex];
+		vec3 position = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0f - 1.0f;
+
+		outUV       = vec2(0.0f);
+		gl_Position = global_uniform.view_proj * vec4(light_volume.bounds.xyz + position * light_volume.bounds.w, 1.0f);
+		return;
+	}
+#endif
+
 	outUV = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
 	gl_Position = vec4(outUV * 2.0f - 1.0f, 0.0f, 1.0f);
 }
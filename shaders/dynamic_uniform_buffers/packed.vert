@@ -0,0 +1,48 @@
+#version 450
+/* Copyright (c) 2019, Sascha Willems
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inColor;
+
+layout (binding = 0) uniform UboView 
+{
+	mat4 projection;
+	mat4 view;
+} uboView;
+
+// All model matrices packed without padding, the first instance of each draw selects the object
+layout (std430, binding = 1) readonly buffer Instances 
+{
+	mat4 models[];
+};
+
+layout (location = 0) out vec3 outColor;
+
+out gl_PerVertex 
+{
+	vec4 gl_Position;   
+};
+
+void main() 
+{
+	outColor = inColor;
+	// To avoid calculating this for every vertex, matrix multiplications could be moved to the CPU-side
+	mat4 modelView = uboView.view * models[gl_InstanceIndex];
+	vec3 worldPos = vec3(modelView * vec4(inPos, 1.0));
+	gl_Position = uboView.projection * modelView * vec4(inPos.xyz, 1.0);
+}
@@ -0,0 +1,63 @@
+#version 450
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+struct Particle
+{
+	vec4 position;        // xyz: position, w: age
+	vec4 velocity;        // xyz: velocity, w: lifetime
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles
+{
+	Particle particles[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer AliveList
+{
+	uint alive_list[];
+};
+
+layout(set = 0, binding = 2) uniform ParticleUniform
+{
+	mat4 view_proj;
+	vec4 camera_right;
+	vec4 camera_up;
+	vec4 color;
+	float size;
+} particle_uniform;
+
+layout(location = 0) out vec2 o_uv;
+layout(location = 1) out vec4 o_color;
+
+const vec2 corners[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                               vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+// Draws each particle as a camera facing quad
+void main(void)
+{
+	Particle particle = particles[alive_list[gl_InstanceIndex]];
+	vec2     corner   = corners[gl_VertexIndex];
+
+	vec3 position = particle.position.xyz + (particle_uniform.camera_right.xyz * corner.x + particle_uniform.camera_up.xyz * corner.y) * particle_uniform.size;
+
+	float fade = 1.0 - clamp(particle.position.w / particle.velocity.w, 0.0, 1.0);
+
+	o_uv        = corner;
+	o_color     = vec4(particle_uniform.color.rgb, particle_uniform.color.a * fade);
+	gl_Position = particle_uniform.view_proj * vec4(position, 1.0);
+}
@@ -0,0 +1,51 @@
+#version 450
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+precision highp float;
+
+// Each permutation of the stress test sets its own pattern, so that the driver compiles the shader again
+layout(constant_id = 0) const int PATTERN = 0;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+	vec2 cell = floor(in_uv * float(PATTERN % 16 + 2));
+
+	float value = 0.0;
+	if (PATTERN % 4 == 0)
+	{
+		value = mod(cell.x + cell.y, 2.0);
+	}
+	else if (PATTERN % 4 == 1)
+	{
+		value = fract(sin(dot(cell, vec2(12.9898, 78.233))) * 43758.5453);
+	}
+	else if (PATTERN % 4 == 2)
+	{
+		value = length(fract(in_uv * float(PATTERN / 4 + 1)) - 0.5);
+	}
+	else
+	{
+		value = step(0.5, fract((in_uv.x + in_uv.y) * float(PATTERN / 4 + 1)));
+	}
+
+	o_color = vec4(vec3(value), 1.0);
+}
@@ -0,0 +1,128 @@
+#version 450
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HALF_PRECISION
+// The color math may run in 16-bit floats, the texture coordinates are declared highp
+precision mediump float;
+#else
+precision highp float;
+#endif
+
+// Tonemapping, color grading, vignette and FXAA fused in a single full screen pass.
+// FXAA needs the graded colors of the neighbouring texels, so every tap applies the
+// per-texel effects to the scene color again instead of reading them from an
+// intermediate image: a few more ALU operations for one full resolution write and
+// read less per effect.
+
+layout(set = 0, binding = 1) uniform sampler2D color_sampler;
+
+layout(location = 0) in highp vec2 in_uv;
+
+layout(location = 0) out vec4 o_color;
+
+layout(set = 0, binding = 2) uniform PostprocessingUniform
+{
+	highp vec2 near_far;
+	highp vec2 source_uv_scale;
+	highp vec2 source_uv_max;
+	highp vec2 source_coord_scale;
+} postprocessing_uniform;
+
+const float exposure        = 1.2;
+const float saturation      = 1.1;
+const float contrast        = 1.05;
+const vec3  lift            = vec3(0.0, 0.0, 0.01);
+const vec3  gain            = vec3(1.0, 0.98, 0.95);
+const float vignette_radius = 0.75;
+const float vignette_amount = 0.35;
+
+const float fxaa_reduce_min = 1.0 / 128.0;
+const float fxaa_reduce_mul = 1.0 / 8.0;
+const float fxaa_span_max   = 8.0;
+
+float luma(vec3 color)
+{
+	return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 tonemap(vec3 color)
+{
+	color *= exposure;
+	return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 grade(vec3 color)
+{
+	color = mix(vec3(luma(color)), color, saturation);
+	color = (color - 0.5) * contrast + 0.5;
+	return clamp(color * gain + lift * (1.0 - color), 0.0, 1.0);
+}
+
+// Scene color with the per-texel effects applied, uv in the space of the region drawn by the scene
+vec3 graded_color(highp vec2 uv)
+{
+	return grade(tonemap(texture(color_sampler, min(uv, postprocessing_uniform.source_uv_max)).rgb));
+}
+
+vec3 fxaa(highp vec2 uv)
+{
+	highp vec2 texel = 1.0 / vec2(textureSize(color_sampler, 0));
+
+	vec3 rgb_nw = graded_color(uv + vec2(-1.0, -1.0) * texel);
+	vec3 rgb_ne = graded_color(uv + vec2(1.0, -1.0) * texel);
+	vec3 rgb_sw = graded_color(uv + vec2(-1.0, 1.0) * texel);
+	vec3 rgb_se = graded_color(uv + vec2(1.0, 1.0) * texel);
+	vec3 rgb_m  = graded_color(uv);
+
+	float luma_nw = luma(rgb_nw);
+	float luma_ne = luma(rgb_ne);
+	float luma_sw = luma(rgb_sw);
+	float luma_se = luma(rgb_se);
+	float luma_m  = luma(rgb_m);
+
+	float luma_min = min(luma_m, min(min(luma_nw, luma_ne), min(luma_sw, luma_se)));
+	float luma_max = max(luma_m, max(max(luma_nw, luma_ne), max(luma_sw, luma_se)));
+
+	// Blur along the edge, perpendicular to the luma gradient
+	vec2 dir = vec2(-((luma_nw + luma_ne) - (luma_sw + luma_se)), (luma_nw + luma_sw) - (luma_ne + luma_se));
+
+	float dir_reduce  = max((luma_nw + luma_ne + luma_sw + luma_se) * (0.25 * fxaa_reduce_mul), fxaa_reduce_min);
+	float rcp_dir_min = 1.0 / (min(abs(dir.x), abs(dir.y)) + dir_reduce);
+
+	dir = clamp(dir * rcp_dir_min, vec2(-fxaa_span_max), vec2(fxaa_span_max)) * texel;
+
+	vec3 rgb_a = 0.5 * (graded_color(uv + dir * (1.0 / 3.0 - 0.5)) + graded_color(uv + dir * (2.0 / 3.0 - 0.5)));
+	vec3 rgb_b = rgb_a * 0.5 + 0.25 * (graded_color(uv - dir * 0.5) + graded_color(uv + dir * 0.5));
+
+	float luma_b = luma(rgb_b);
+
+	// The wider blur crossed another edge, keep the narrow one
+	return (luma_b < luma_min || luma_b > luma_max) ? rgb_a : rgb_b;
+}
+
+void main(void)
+{
+	vec3 color = fxaa(in_uv * postprocessing_uniform.source_uv_scale);
+
+	// The vignette only depends on the position on screen, not on the neighbouring texels
+	float radius = length(in_uv - 0.5) * 1.41421356;
+	color *= 1.0 - vignette_amount * smoothstep(vignette_radius * 0.5, vignette_radius * 1.25, radius);
+
+	o_color = vec4(color, 1.0);
+}
@@ -32,6 +32,9 @@ layout(location = 0) out vec4 o_color;
 layout(set = 0, binding = 2) uniform PostprocessingUniform
 {
 	vec2 near_far;
+	vec2 source_uv_scale;
+	vec2 source_uv_max;
+	vec2 source_coord_scale;
 } postprocessing_uniform;
 
 float linearizeDepth(float depth, float near, float far)
@@ -42,17 +45,19 @@ float linearizeDepth(float depth, float near, float far)
 float getDepth(ivec2 offset)
 {
 	float depth;
+	// Texel of the region drawn by the scene
+	ivec2 coord = ivec2(gl_FragCoord.xy * postprocessing_uniform.source_coord_scale) + offset;
 #ifdef MS_DEPTH
-	depth = texelFetch(ms_depth_sampler, ivec2(gl_FragCoord.xy) + offset, 0).r;
+	depth = texelFetch(ms_depth_sampler, coord, 0).r;
 #else
-	depth = texelFetch(depth_sampler, ivec2(gl_FragCoord.xy) + offset, 0).r;
+	depth = texelFetch(depth_sampler, coord, 0).r;
 #endif
 	return linearizeDepth(depth, postprocessing_uniform.near_far.x, postprocessing_uniform.near_far.y);
 }
 
 void main(void)
 {
-	vec4 color = texture(color_sampler, in_uv);
+	vec4 color = texture(color_sampler, min(in_uv * postprocessing_uniform.source_uv_scale, postprocessing_uniform.source_uv_max));
 	float depth = getDepth(ivec2(0, 0));
 
 	vec3 outline_color = vec3(0.0, 0.0, 0.0);
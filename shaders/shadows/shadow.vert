@@ -0,0 +1,29 @@
+#version 320 es
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout(location = 0) in vec3 position;
+
+// Model matrix of the caster projected by the view projection of the light tile
+layout(push_constant, std430) uniform ShadowCaster {
+    mat4 model_view_proj;
+} shadow_caster;
+
+void main(void)
+{
+    gl_Position = shadow_caster.model_view_proj * vec4(position, 1.0);
+}
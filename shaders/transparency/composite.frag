@@ -0,0 +1,44 @@
+#version 450
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+precision highp float;
+
+layout(input_attachment_index = 0, binding = 0) uniform highp subpassInput i_accumulation;
+layout(input_attachment_index = 1, binding = 1) uniform highp subpassInput i_revealage;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 0) out vec4 o_color;
+
+void main(void)
+{
+	float revealage = subpassLoad(i_revealage).r;
+
+	// No transparent surface covers the pixel
+	if (revealage >= 1.0)
+	{
+		discard;
+	}
+
+	vec4 accumulation = subpassLoad(i_accumulation);
+
+	// Weighted average of the colors, clamped so that an overflowing half float sum stays finite
+	vec3 average_color = accumulation.rgb / clamp(accumulation.a, 1e-4, 5e4);
+
+	// Blended over the opaque color by the coverage of all the surfaces
+	o_color = vec4(average_color, 1.0 - revealage);
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "allocation_free_frames.h"
+
+#include "common/utils.h"
+#include "platform/platform.h"
+#include "rendering/render_pipeline.h"
+#include "scene_graph/components/camera.h"
+#include "stats/stats.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+#include <glm/gtx/quaternion.hpp>
+VKBP_ENABLE_WARNINGS()
+
+void CountingForwardSubpass::draw(vkb::CommandBuffer &command_buffer)
+{
+	vkb::AllocationTracker::Scope scope;
+
+	ForwardSubpass::draw(command_buffer);
+
+	auto counts = scope.get();
+	allocations.count += counts.count;
+	allocations.bytes += counts.bytes;
+}
+
+const vkb::AllocationTracker::Counts &CountingForwardSubpass::get_allocations() const
+{
+	return allocations;
+}
+
+void CountingForwardSubpass::reset_allocations()
+{
+	allocations = {};
+}
+
+bool AllocationFreeFramesTest::prepare(vkb::Platform &platform)
+{
+	if (!vkbtest::VulkanTest::prepare(platform))
+	{
+		return false;
+	}
+
+	// Without the replacement operators every count is zero, which would always pass
+	if (!vkb::AllocationTracker::is_enabled())
+	{
+		LOGE("The allocation_free_frames test needs the framework built with VKB_ALLOCATION_TRACKING");
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	scene->clear_components<vkb::sg::Light>();
+
+	vkb::add_directional_light(get_scene(), glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
+
+	auto camera_node = scene->find_node("main_camera");
+
+	if (!camera_node)
+	{
+		camera_node = scene->find_node("default_camera");
+	}
+
+	auto &camera = camera_node->get_component<vkb::sg::Camera>();
+
+	auto scene_subpass = std::make_unique<CountingForwardSubpass>(get_render_context(), vkb::ShaderSource{"base.vert"}, vkb::ShaderSource{"base.frag"}, *scene, camera);
+	checked_subpasses.push_back(scene_subpass.get());
+
+	auto render_pipeline = vkb::RenderPipeline();
+	render_pipeline.add_subpass(std::move(scene_subpass));
+
+	set_render_pipeline(std::move(render_pipeline));
+
+	stats->request_stats({vkb::StatIndex::frame_allocations});
+
+	return true;
+}
+
+void AllocationFreeFramesTest::update(float delta_time)
+{
+	for (auto subpass : checked_subpasses)
+	{
+		subpass->reset_allocations();
+	}
+
+	// Draws the frame without the screenshot of VulkanTest, the test has no gold image
+	VulkanSample::update(delta_time);
+
+	if (++frame_index <= WARMUP_FRAMES)
+	{
+		return;
+	}
+
+	bool allocated = false;
+
+	for (size_t i = 0; i < checked_subpasses.size(); ++i)
+	{
+		auto &allocations = checked_subpasses[i]->get_allocations();
+
+		if (allocations.count > 0)
+		{
+			LOGE("Frame {}: subpass {} made {} allocations of {} bytes", frame_index, i, allocations.count, allocations.bytes);
+			allocated = true;
+		}
+	}
+
+	if (allocated)
+	{
+		++allocating_frames;
+	}
+
+	if (frame_index < WARMUP_FRAMES + MEASURED_FRAMES)
+	{
+		return;
+	}
+
+	LOGI("Heap allocations of the last frame on every thread: {:.0f}", stats->get_data(vkb::StatIndex::frame_allocations).back());
+
+	if (allocating_frames > 0)
+	{
+		LOGE("The checked subpasses allocated in {} of {} frames", allocating_frames, MEASURED_FRAMES);
+		end(vkb::ExitCode::FatalError);
+	}
+
+	LOGI("The checked subpasses drew {} frames without allocating", MEASURED_FRAMES);
+	end();
+}
+
+std::unique_ptr<vkb::VulkanSample> create_allocation_free_frames_test()
+{
+	return std::make_unique<AllocationFreeFramesTest>();
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2026, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "rendering/subpasses/forward_subpass.h"
+#include "stats/allocation_tracker.h"
+#include "vulkan_test.h"
+
+/**
+ * @brief Forward subpass counting the heap allocations of its draws, made on the recording thread
+ */
+class CountingForwardSubpass : public vkb::ForwardSubpass
+{
+  public:
+	using vkb::ForwardSubpass::ForwardSubpass;
+
+	virtual void draw(vkb::CommandBuffer &command_buffer) override;
+
+	/**
+	 * @return The allocations of the draws since the last reset
+	 */
+	const vkb::AllocationTracker::Counts &get_allocations() const;
+
+	void reset_allocations();
+
+  private:
+	vkb::AllocationTracker::Counts allocations;
+};
+
+/**
+ * @brief Checks that the selected subpasses draw the frames of a steady scene without allocating
+ *
+ * The Sponza scene is drawn by a forward subpass counting its allocations. Once the warm-up frames
+ * have filled the caches, every measured frame must draw without allocating, otherwise the test
+ * exits with an error. The per-frame allocations of all the threads, the frame_allocations stat,
+ * are logged for reference. It needs no gold screenshot, and the counts are only taken when the
+ * framework is built with VKB_ALLOCATION_TRACKING.
+ */
+class AllocationFreeFramesTest : public vkbtest::VulkanTest
+{
+  public:
+	virtual ~AllocationFreeFramesTest() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	/// Frames drawn before the allocations are counted
+	static constexpr uint32_t WARMUP_FRAMES = 30;
+
+	/// Frames whose allocations are counted
+	static constexpr uint32_t MEASURED_FRAMES = 60;
+
+  private:
+	/// Subpasses of the render pipeline that must not allocate
+	std::vector<CountingForwardSubpass *> checked_subpasses;
+
+	uint32_t frame_index{0};
+
+	/// Frames in which a checked subpass allocated
+	uint32_t allocating_frames{0};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_allocation_free_frames_test();
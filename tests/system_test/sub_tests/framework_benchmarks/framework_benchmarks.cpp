@@ -0,0 +1,729 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "framework_benchmarks.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "buffer_pool.h"
+#include "common/glm_common.h"
+#include "common/logging.h"
+#include "common/resource_caching.h"
+#include "core/command_buffer.h"
+#include "geometry/bounds_kernels.h"
+#include "geometry/frustum.h"
+#include "gltf_loader.h"
+#include "job_system.h"
+#include "platform/platform.h"
+#include "rendering/cpu_culling.h"
+#include "rendering/pipeline_state.h"
+#include "rendering/render_frame.h"
+#include "rendering/subpasses/geometry_subpass.h"
+#include "resource_cache.h"
+#include "scene_graph/bvh.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+#include "stress_scene_generator.h"
+
+namespace
+{
+// Depth of the node hierarchy of the transform benchmarks
+constexpr uint32_t NODE_CHAIN_DEPTH = 16;
+
+// Node counts of the generated scenes
+constexpr uint32_t STRESS_SCENE_NODE_COUNTS[] = {1000, 10000, 100000};
+
+// Key counts of the GPU sorts
+constexpr uint32_t GPU_SORT_KEY_COUNTS[] = {1u << 16, 1u << 20, 1u << 22};
+
+// Number of rays cast at the hierarchy of a scene, one per iteration in turn
+constexpr size_t BVH_RAY_COUNT = 1024;
+
+// Number of boxes and points processed by every iteration of the bounds kernels
+constexpr size_t BOUNDS_BOX_COUNT   = 16384;
+constexpr size_t BOUNDS_POINT_COUNT = 65536;
+
+/**
+ * @brief Exposes the sorting of the nodes, it is called by the draw of the subpass otherwise
+ */
+class SortingSubpass : public vkb::GeometrySubpass
+{
+  public:
+	using vkb::GeometrySubpass::GeometrySubpass;
+
+	using vkb::GeometrySubpass::get_sorted_nodes;
+};
+
+std::vector<std::unique_ptr<vkb::sg::Node>> create_node_chain(uint32_t depth)
+{
+	std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+
+	for (uint32_t i = 0; i < depth; ++i)
+	{
+		nodes.push_back(std::make_unique<vkb::sg::Node>(i, "node_" + std::to_string(i)));
+
+		auto &node = *nodes.back();
+		node.get_transform().set_translation(glm::vec3(1.0f, 0.0f, 0.0f));
+		node.get_transform().set_rotation(glm::quat(glm::vec3(0.0f, 0.1f, 0.0f)));
+
+		if (i > 0)
+		{
+			node.set_parent(*nodes[i - 1]);
+			nodes[i - 1]->add_child(node);
+		}
+	}
+
+	return nodes;
+}
+
+const char *to_string(vkb::bounds::InstructionSet instruction_set)
+{
+	switch (instruction_set)
+	{
+		case vkb::bounds::InstructionSet::SSE:
+			return "SSE";
+		case vkb::bounds::InstructionSet::AVX2:
+			return "AVX2";
+		case vkb::bounds::InstructionSet::NEON:
+			return "NEON";
+		default:
+			return "scalar";
+	}
+}
+
+std::vector<glm::vec3> create_random_points(size_t count, float range, uint32_t seed)
+{
+	std::mt19937                          generator{seed};
+	std::uniform_real_distribution<float> distribution{-range, range};
+
+	std::vector<glm::vec3> points(count);
+	for (auto &point : points)
+	{
+		point = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+	}
+
+	return points;
+}
+
+/**
+ * @brief Splits a buffer of six floats per box into the arrays of the bounds kernels
+ */
+vkb::bounds::BoxArrays get_box_arrays(std::vector<float> &storage, size_t count)
+{
+	storage.resize(6 * count);
+
+	return {storage.data(), storage.data() + count, storage.data() + 2 * count,
+	        storage.data() + 3 * count, storage.data() + 4 * count, storage.data() + 5 * count};
+}
+
+/**
+ * @brief Creates a frame outside of the render context
+ *        The command buffers flushing descriptor sets must come from a frame, which holds the sets.
+ */
+std::unique_ptr<vkb::RenderFrame> create_benchmark_frame(vkb::Device &device)
+{
+	vkb::core::Image target_image{device, VkExtent3D{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VMA_MEMORY_USAGE_GPU_ONLY};
+
+	return std::make_unique<vkb::RenderFrame>(device, vkb::RenderTarget::DEFAULT_CREATE_FUNC(std::move(target_image)));
+}
+
+VkSamplerCreateInfo get_sampler_info(float max_lod)
+{
+	VkSamplerCreateInfo info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	info.magFilter    = VK_FILTER_LINEAR;
+	info.minFilter    = VK_FILTER_LINEAR;
+	info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	info.maxLod       = max_lod;
+	return info;
+}
+}        // namespace
+
+FrameworkBenchmarks::FrameworkBenchmarks() :
+    vkbtest::GLTFLoaderTest("scenes/sponza/Sponza01.gltf")
+{
+}
+
+bool FrameworkBenchmarks::prepare(vkb::Platform &platform)
+{
+	if (!GLTFLoaderTest::prepare(platform))
+	{
+		return false;
+	}
+
+	add_resource_cache_benchmarks();
+	add_pipeline_state_benchmarks();
+	add_command_buffer_benchmarks();
+	add_buffer_block_benchmarks();
+	add_scene_benchmarks();
+	add_stress_scene_benchmarks();
+	add_bvh_benchmarks();
+	add_gpu_primitives_benchmarks();
+	add_bounds_benchmarks();
+
+	runner.run();
+
+	log_gpu_sort_throughput();
+
+	return runner.write_json("framework_benchmarks.json", get_device().get_gpu().get_properties().deviceName);
+}
+
+void FrameworkBenchmarks::add_resource_cache_benchmarks()
+{
+	auto &device = get_device();
+
+	runner.add("resource_cache/request_shader_module/hit", [&device](vkbtest::BenchmarkState &state) {
+		auto &resource_cache = device.get_resource_cache();
+
+		vkb::ShaderSource  source{"base.vert"};
+		vkb::ShaderVariant variant;
+		resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, source, variant);
+
+		while (state.keep_running())
+		{
+			vkbtest::do_not_optimize(resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, source, variant));
+		}
+	});
+
+	runner.add("resource_cache/request_pipeline_layout/hit", [&device](vkbtest::BenchmarkState &state) {
+		auto &resource_cache = device.get_resource_cache();
+
+		std::vector<vkb::ShaderModule *> shader_modules{
+		    &resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, vkb::ShaderSource{"base.vert"}),
+		    &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, vkb::ShaderSource{"base.frag"})};
+		resource_cache.request_pipeline_layout(shader_modules);
+
+		while (state.keep_running())
+		{
+			vkbtest::do_not_optimize(resource_cache.request_pipeline_layout(shader_modules));
+		}
+	});
+
+	runner.add("resource_cache/request_sampler/hit", [&device](vkbtest::BenchmarkState &state) {
+		auto &resource_cache = device.get_resource_cache();
+
+		auto info = get_sampler_info(VK_LOD_CLAMP_NONE);
+		resource_cache.request_sampler(info);
+
+		while (state.keep_running())
+		{
+			vkbtest::do_not_optimize(resource_cache.request_sampler(info));
+		}
+	});
+
+	// Every request creates a sampler, the cache of the run is destroyed with its samplers
+	// so that the iterations stay below the sampler allocation limit of the device
+	runner.add(
+	    "resource_cache/request_sampler/miss", [&device](vkbtest::BenchmarkState &state) {
+		    vkb::ResourceCache resource_cache{device};
+
+		    while (state.keep_running())
+		    {
+			    vkbtest::do_not_optimize(resource_cache.request_sampler(get_sampler_info(static_cast<float>(state.get_iteration()))));
+		    }
+	    },
+	    1024);
+}
+
+void FrameworkBenchmarks::add_pipeline_state_benchmarks()
+{
+	runner.add("pipeline_state/get_hash", [](vkbtest::BenchmarkState &state) {
+		vkb::PipelineState pipeline_state;
+
+		while (state.keep_running())
+		{
+			vkbtest::do_not_optimize(pipeline_state.get_hash());
+		}
+	});
+
+	// Rehashes every state, as a pipeline lookup did before the setters kept the hashes of the states
+	runner.add("pipeline_state/hash_all_states", [](vkbtest::BenchmarkState &state) {
+		vkb::PipelineState pipeline_state;
+
+		while (state.keep_running())
+		{
+			size_t hash = 0;
+
+			vkb::hash_combine(hash, pipeline_state.get_subpass_index());
+			vkb::hash_combine(hash, pipeline_state.get_specialization_constant_state());
+			vkb::hash_combine(hash, pipeline_state.get_vertex_input_state());
+			vkb::hash_combine(hash, pipeline_state.get_input_assembly_state());
+			vkb::hash_combine(hash, pipeline_state.get_rasterization_state());
+			vkb::hash_combine(hash, pipeline_state.get_viewport_state());
+			vkb::hash_combine(hash, pipeline_state.get_multisample_state());
+			vkb::hash_combine(hash, pipeline_state.get_depth_stencil_state());
+			vkb::hash_combine(hash, pipeline_state.get_color_blend_state());
+			vkb::hash_combine(hash, pipeline_state.get_fragment_shading_rate_state());
+
+			vkbtest::do_not_optimize(hash);
+		}
+	});
+
+	// The state changes on every iteration, so the setter rehashes it
+	runner.add("pipeline_state/set_rasterization_state", [](vkbtest::BenchmarkState &state) {
+		vkb::PipelineState      pipeline_state;
+		vkb::RasterizationState rasterization_state;
+
+		while (state.keep_running())
+		{
+			rasterization_state.cull_mode = (state.get_iteration() & 1) ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
+			pipeline_state.set_rasterization_state(rasterization_state);
+
+			vkbtest::do_not_optimize(pipeline_state.get_hash());
+		}
+	});
+}
+
+void FrameworkBenchmarks::add_command_buffer_benchmarks()
+{
+	auto &device = get_device();
+
+	// A binding changes on every iteration, the dispatch flushes the descriptor state and
+	// looks up the compute pipeline in the resource cache. The command buffer is never submitted
+	runner.add(
+	    "command_buffer/flush_descriptor_state", [&device](vkbtest::BenchmarkState &state) {
+		    auto &resource_cache  = device.get_resource_cache();
+		    auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, vkb::ShaderSource{"compute_nbody/particle_integrate.comp"});
+		    auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+		    auto alignment = device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
+
+		    vkb::core::Buffer storage_buffer{device, 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY};
+		    vkb::core::Buffer uniform_buffer{device, 2 * alignment, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+
+		    auto render_frame = create_benchmark_frame(device);
+
+		    auto &command_buffer = render_frame->request_command_buffer(device.get_queue_by_flags(VK_QUEUE_COMPUTE_BIT, 0));
+		    command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		    command_buffer.bind_pipeline_layout(pipeline_layout);
+		    command_buffer.bind_buffer(storage_buffer, 0, storage_buffer.get_size(), 0, 0, 0);
+
+		    while (state.keep_running())
+		    {
+			    command_buffer.bind_buffer(uniform_buffer, (state.get_iteration() & 1) * alignment, 8, 0, 1, 0);
+			    command_buffer.dispatch(1, 1, 1);
+		    }
+
+		    command_buffer.end();
+	    },
+	    100000);
+
+	// Records the same command through the function table of the device, as CommandBuffer does,
+	// and through the global entry point, which goes through the dispatch of the loader
+	for (bool device_table : {true, false})
+	{
+		runner.add(
+		    std::string{"command_buffer/set_viewport/"} + (device_table ? "device_table" : "loader"), [&device, device_table](vkbtest::BenchmarkState &state) {
+			    auto &command_buffer = device.request_command_buffer();
+			    command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+			    auto       handle   = command_buffer.get_handle();
+			    auto       cmd      = device_table ? device.get_table().vkCmdSetViewport : vkCmdSetViewport;
+			    VkViewport viewport = {0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f};
+
+			    while (state.keep_running())
+			    {
+				    viewport.width = static_cast<float>(1920 + (state.get_iteration() & 1));
+				    cmd(handle, 0, 1, &viewport);
+			    }
+
+			    command_buffer.end();
+			    device.get_command_pool().reset_pool();
+		    },
+		    100000);
+	}
+}
+
+void FrameworkBenchmarks::add_buffer_block_benchmarks()
+{
+	auto &device = get_device();
+
+	runner.add("buffer_block/allocate", [&device](vkbtest::BenchmarkState &state) {
+		vkb::BufferBlock block{device, 4 * 1024 * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+
+		while (state.keep_running())
+		{
+			auto allocation = block.allocate(256);
+
+			if (allocation.empty())
+			{
+				block.reset();
+			}
+
+			vkbtest::do_not_optimize(allocation.get_offset());
+		}
+	});
+}
+
+void FrameworkBenchmarks::add_scene_benchmarks()
+{
+	auto  cameras = get_scene().get_components<vkb::sg::Camera>();
+	auto &camera  = *cameras.front();
+
+	runner.add("geometry_subpass/get_sorted_nodes", [this, &camera](vkbtest::BenchmarkState &state) {
+		SortingSubpass subpass{get_render_context(), vkb::ShaderSource{"base.vert"}, vkb::ShaderSource{"base.frag"}, get_scene(), camera};
+
+		vkb::CpuCulling::DrawList opaque_nodes;
+		vkb::CpuCulling::DrawList transparent_nodes;
+
+		while (state.keep_running())
+		{
+			opaque_nodes.clear();
+			transparent_nodes.clear();
+
+			subpass.get_sorted_nodes(opaque_nodes, transparent_nodes);
+		}
+	});
+
+	runner.add("transform/get_world_matrix/cached", [](vkbtest::BenchmarkState &state) {
+		auto  nodes = create_node_chain(NODE_CHAIN_DEPTH);
+		auto &leaf  = nodes.back()->get_transform();
+
+		while (state.keep_running())
+		{
+			vkbtest::do_not_optimize(leaf.get_world_matrix());
+		}
+	});
+
+	// Every transform of the hierarchy is invalidated, the leaf recomputes the whole chain
+	runner.add("transform/get_world_matrix/dirty", [](vkbtest::BenchmarkState &state) {
+		auto  nodes = create_node_chain(NODE_CHAIN_DEPTH);
+		auto &leaf  = nodes.back()->get_transform();
+
+		while (state.keep_running())
+		{
+			for (auto &node : nodes)
+			{
+				node->get_transform().invalidate_world_matrix();
+			}
+
+			vkbtest::do_not_optimize(leaf.get_world_matrix());
+		}
+	});
+
+	runner.add(
+	    "gltf_loader/load_scene", [this](vkbtest::BenchmarkState &state) {
+		    while (state.keep_running())
+		    {
+			    vkb::GLTFLoader loader{get_device()};
+			    vkbtest::do_not_optimize(loader.read_scene_from_file(scene_path));
+		    }
+	    },
+	    1);
+}
+
+void FrameworkBenchmarks::add_stress_scene_benchmarks()
+{
+	vkb::StressSceneGenerator generator{get_device()};
+
+	for (auto node_count : STRESS_SCENE_NODE_COUNTS)
+	{
+		vkb::StressSceneOptions options;
+		options.node_count = node_count;
+		options.mesh_count = 256;
+
+		stress_scenes.push_back(generator.generate(options));
+
+		auto &stress_scene = *stress_scenes.back();
+		auto &camera       = stress_scene.find_node("default_camera")->get_component<vkb::sg::Camera>();
+
+		runner.add("stress_scene/get_sorted_nodes/" + std::to_string(node_count), [this, &stress_scene, &camera](vkbtest::BenchmarkState &state) {
+			SortingSubpass subpass{get_render_context(), vkb::ShaderSource{"base.vert"}, vkb::ShaderSource{"base.frag"}, stress_scene, camera};
+
+			vkb::CpuCulling::DrawList opaque_nodes;
+			vkb::CpuCulling::DrawList transparent_nodes;
+
+			while (state.keep_running())
+			{
+				opaque_nodes.clear();
+				transparent_nodes.clear();
+
+				subpass.get_sorted_nodes(opaque_nodes, transparent_nodes);
+			}
+		});
+
+		// Culls the instances on the recording thread alone, then in chunks on the job system
+		for (bool parallel : {false, true})
+		{
+			std::string name = fmt::format("stress_scene/cpu_culling/{}/{}", parallel ? "parallel" : "serial", node_count);
+
+			runner.add(name, [this, &stress_scene, &camera, parallel](vkbtest::BenchmarkState &state) {
+				auto meshes          = stress_scene.get_components<vkb::sg::Mesh>();
+				auto view_proj       = vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+				auto camera_position = glm::vec3(camera.get_node()->get_transform().get_world_matrix()[3]);
+
+				vkb::JobSystem *job_system = parallel ? &get_job_system() : nullptr;
+
+				vkb::CpuCulling           culling;
+				vkb::CpuCulling::DrawList opaque_draws;
+				vkb::CpuCulling::DrawList transparent_draws;
+
+				while (state.keep_running())
+				{
+					opaque_draws.clear();
+					transparent_draws.clear();
+
+					culling.cull(meshes, view_proj, camera_position, opaque_draws, transparent_draws, job_system);
+					vkbtest::do_not_optimize(opaque_draws.size());
+				}
+			});
+		}
+	}
+}
+
+void FrameworkBenchmarks::add_bvh_benchmarks()
+{
+	// The generated scenes are in the order of their node counts
+	for (size_t i = 0; i < stress_scenes.size(); ++i)
+	{
+		auto &stress_scene = stress_scenes[i];
+		auto &camera       = stress_scene->find_node("default_camera")->get_component<vkb::sg::Camera>();
+		auto  node_count   = std::to_string(STRESS_SCENE_NODE_COUNTS[i]);
+
+		runner.add("bvh/build/" + node_count, [&stress_scene](vkbtest::BenchmarkState &state) {
+			auto meshes = stress_scene->get_components<vkb::sg::Mesh>();
+
+			while (state.keep_running())
+			{
+				vkb::sg::BVH bvh;
+				bvh.build(meshes);
+				vkbtest::do_not_optimize(bvh.get_node_count());
+			}
+		});
+
+		// The world matrices do not change, so every refit visits the whole tree with the same bounds
+		runner.add("bvh/refit/" + node_count, [&stress_scene](vkbtest::BenchmarkState &state) {
+			vkb::sg::BVH bvh;
+			bvh.build(stress_scene->get_components<vkb::sg::Mesh>());
+
+			while (state.keep_running())
+			{
+				bvh.refit();
+			}
+		});
+
+		runner.add("bvh/query_frustum/" + node_count, [&stress_scene, &camera](vkbtest::BenchmarkState &state) {
+			auto &bvh = stress_scene->get_bvh();
+
+			vkb::Frustum frustum;
+			frustum.update(vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view());
+
+			std::vector<vkb::sg::BVH::Instance> instances;
+
+			while (state.keep_running())
+			{
+				instances.clear();
+
+				bvh.query_frustum(frustum, instances);
+				vkbtest::do_not_optimize(instances.size());
+			}
+		});
+
+		// Picks along random directions from the camera, as a click anywhere on the screen would
+		runner.add("bvh/raycast/" + node_count, [&stress_scene, &camera](vkbtest::BenchmarkState &state) {
+			auto &bvh    = stress_scene->get_bvh();
+			auto  origin = glm::vec3(camera.get_node()->get_transform().get_world_matrix()[3]);
+
+			auto directions = create_random_points(BVH_RAY_COUNT, 1.0f, 6);
+			for (auto &direction : directions)
+			{
+				direction = glm::normalize(direction + glm::vec3(0.0f, 0.0f, 1e-3f));
+			}
+
+			while (state.keep_running())
+			{
+				vkbtest::do_not_optimize(bvh.raycast(origin, directions[state.get_iteration() % BVH_RAY_COUNT]));
+			}
+		});
+	}
+}
+
+void FrameworkBenchmarks::add_gpu_primitives_benchmarks()
+{
+	auto &device = get_device();
+
+	gpu_primitives = std::make_unique<vkb::GpuPrimitives>(device, *std::max_element(std::begin(GPU_SORT_KEY_COUNTS), std::end(GPU_SORT_KEY_COUNTS)));
+
+	for (auto key_type : {vkb::GpuPrimitives::KeyType::Uint32, vkb::GpuPrimitives::KeyType::Uint64})
+	{
+		for (auto key_count : GPU_SORT_KEY_COUNTS)
+		{
+			std::string name = fmt::format("gpu_primitives/radix_sort/{}/{}", key_type == vkb::GpuPrimitives::KeyType::Uint64 ? 64 : 32, key_count);
+			gpu_sort_key_counts.emplace_back(name, key_count);
+
+			// Every iteration sorts the same random keys, copied from a source buffer, and waits for the GPU
+			runner.add(
+			    name, [this, &device, key_type, key_count](vkbtest::BenchmarkState &state) {
+				    size_t key_size = key_type == vkb::GpuPrimitives::KeyType::Uint64 ? sizeof(uint64_t) : sizeof(uint32_t);
+				    auto   size     = key_count * key_size;
+
+				    std::mt19937                            generator{42};
+				    std::uniform_int_distribution<uint32_t> distribution;
+
+				    std::vector<uint8_t> random_keys(size);
+				    for (size_t i = 0; i < size; i += sizeof(uint32_t))
+				    {
+					    uint32_t key = distribution(generator);
+					    std::memcpy(random_keys.data() + i, &key, sizeof(uint32_t));
+				    }
+
+				    vkb::core::Buffer source_keys{device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+				    source_keys.update(random_keys);
+
+				    vkb::core::Buffer keys{device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY};
+
+				    vkb::BufferMemoryBarrier copy_barrier{};
+				    copy_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				    copy_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				    copy_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				    copy_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+				    auto &queue        = device.get_suitable_graphics_queue();
+				    auto  render_frame = create_benchmark_frame(device);
+
+				    while (state.keep_running())
+				    {
+					    auto &command_buffer = render_frame->request_command_buffer(queue);
+					    command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+					    command_buffer.copy_buffer(source_keys, keys, size);
+					    command_buffer.buffer_memory_barrier(keys, 0, VK_WHOLE_SIZE, copy_barrier);
+					    gpu_primitives->radix_sort(command_buffer, keys, nullptr, key_count, key_type);
+					    command_buffer.end();
+
+					    queue.submit(command_buffer, VK_NULL_HANDLE);
+					    queue.wait_idle();
+
+					    render_frame->reset();
+				    }
+			    },
+			    1000);
+		}
+	}
+}
+
+void FrameworkBenchmarks::add_bounds_benchmarks()
+{
+	LOGI("Bounds kernels use {}", to_string(vkb::bounds::get_instruction_set()));
+
+	for (bool scalar : {false, true})
+	{
+		std::string variant = scalar ? "scalar" : "simd";
+
+		runner.add("bounds/transform_boxes/" + variant, [scalar](vkbtest::BenchmarkState &state) {
+			auto centers = create_random_points(BOUNDS_BOX_COUNT, 100.0f, 1);
+			auto extents = create_random_points(BOUNDS_BOX_COUNT, 2.0f, 2);
+			auto offsets = create_random_points(BOUNDS_BOX_COUNT, 100.0f, 3);
+
+			std::vector<glm::mat4> matrices(BOUNDS_BOX_COUNT);
+			for (size_t i = 0; i < BOUNDS_BOX_COUNT; ++i)
+			{
+				matrices[i] = glm::translate(offsets[i]) * glm::rotate(offsets[i].x * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+			}
+
+			std::vector<float> storage;
+			auto               boxes = get_box_arrays(storage, BOUNDS_BOX_COUNT);
+
+			vkb::bounds::force_scalar(scalar);
+
+			while (state.keep_running())
+			{
+				vkb::bounds::transform_boxes(matrices.data(), centers.data(), extents.data(), BOUNDS_BOX_COUNT, boxes);
+				vkbtest::do_not_optimize(storage.front());
+			}
+
+			vkb::bounds::force_scalar(false);
+		});
+
+		// The visibility flags are set again every iteration, as the test only clears them
+		runner.add("bounds/test_boxes/" + variant, [scalar](vkbtest::BenchmarkState &state) {
+			auto mins = create_random_points(BOUNDS_BOX_COUNT, 100.0f, 4);
+
+			std::vector<float> storage;
+			auto               boxes = get_box_arrays(storage, BOUNDS_BOX_COUNT);
+			for (size_t i = 0; i < BOUNDS_BOX_COUNT; ++i)
+			{
+				boxes.min_x[i] = mins[i].x;
+				boxes.min_y[i] = mins[i].y;
+				boxes.min_z[i] = mins[i].z;
+				boxes.max_x[i] = mins[i].x + 2.0f;
+				boxes.max_y[i] = mins[i].y + 2.0f;
+				boxes.max_z[i] = mins[i].z + 2.0f;
+			}
+
+			vkb::Frustum frustum;
+			frustum.update(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f) *
+			               glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+			std::vector<uint8_t> visible(BOUNDS_BOX_COUNT);
+
+			vkb::bounds::force_scalar(scalar);
+
+			while (state.keep_running())
+			{
+				std::fill(visible.begin(), visible.end(), static_cast<uint8_t>(1));
+				vkb::bounds::test_boxes(frustum.get_planes(), boxes, BOUNDS_BOX_COUNT, visible.data());
+				vkbtest::do_not_optimize(visible.front());
+			}
+
+			vkb::bounds::force_scalar(false);
+		});
+
+		runner.add("bounds/compute_bounds/" + variant, [scalar](vkbtest::BenchmarkState &state) {
+			auto points = create_random_points(BOUNDS_POINT_COUNT, 100.0f, 5);
+
+			vkb::bounds::force_scalar(scalar);
+
+			while (state.keep_running())
+			{
+				glm::vec3 min{std::numeric_limits<float>::max()};
+				glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+				vkb::bounds::compute_bounds(points.data(), BOUNDS_POINT_COUNT, min, max);
+				vkbtest::do_not_optimize(min);
+				vkbtest::do_not_optimize(max);
+			}
+
+			vkb::bounds::force_scalar(false);
+		});
+	}
+}
+
+void FrameworkBenchmarks::log_gpu_sort_throughput() const
+{
+	for (auto &result : runner.get_results())
+	{
+		auto it = std::find_if(gpu_sort_key_counts.begin(), gpu_sort_key_counts.end(),
+		                       [&result](const std::pair<std::string, uint32_t> &key_count) { return key_count.first == result.name; });
+
+		if (it != gpu_sort_key_counts.end() && result.time.p50 > 0.0)
+		{
+			// The median time per iteration is in nanoseconds
+			LOGI("Benchmark {}: {:.1f} million keys per second", result.name, it->second * 1e3 / result.time.p50);
+		}
+	}
+}
+
+std::unique_ptr<vkb::VulkanSample> create_framework_benchmarks_test()
+{
+	return std::make_unique<FrameworkBenchmarks>();
+}
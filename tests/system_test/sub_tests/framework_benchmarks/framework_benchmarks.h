@@ -0,0 +1,83 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "benchmark_runner.h"
+#include "gltf_loader_test.h"
+#include "rendering/gpu_primitives.h"
+
+/**
+ * @brief Microbenchmarks of the framework hot paths, run on the device of the test
+ *
+ * The benchmarks cover the resource cache lookups, the pipeline state hashing, the flush of the
+ * descriptor state, the buffer block allocations, the sorting of the scene nodes, the world
+ * matrices and the glTF loading. The sorting, and the culling and sorting of CpuCulling on one
+ * thread and on the job system, are also measured on generated scenes of 1k to 100k nodes, as
+ * are the build, refit, frustum queries and ray picks of their bounding volume hierarchy. The
+ * GPU radix sort is measured on 64k to 4M keys of 32 and 64 bits, and its throughput logged in
+ * keys per second. The batched bounds kernels are measured with their SIMD and their scalar
+ * code. The results are written to framework_benchmarks.json in the logs directory.
+ */
+class FrameworkBenchmarks : public vkbtest::GLTFLoaderTest
+{
+  public:
+	FrameworkBenchmarks();
+
+	virtual ~FrameworkBenchmarks() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+  private:
+	void add_resource_cache_benchmarks();
+
+	void add_pipeline_state_benchmarks();
+
+	void add_command_buffer_benchmarks();
+
+	void add_buffer_block_benchmarks();
+
+	void add_scene_benchmarks();
+
+	void add_stress_scene_benchmarks();
+
+	/**
+	 * @brief Measures the bounding volume hierarchy of the generated scenes, which must be added first
+	 */
+	void add_bvh_benchmarks();
+
+	void add_gpu_primitives_benchmarks();
+
+	void add_bounds_benchmarks();
+
+	/**
+	 * @brief Logs the sorted keys per second of the GPU sorts, from their median times
+	 */
+	void log_gpu_sort_throughput() const;
+
+	vkbtest::BenchmarkRunner runner;
+
+	// Generated scenes of growing sizes, to measure how the sorting scales
+	std::vector<std::unique_ptr<vkb::sg::Scene>> stress_scenes;
+
+	std::unique_ptr<vkb::GpuPrimitives> gpu_primitives;
+
+	// Name and key count of every GPU sort benchmark
+	std::vector<std::pair<std::string, uint32_t>> gpu_sort_key_counts;
+};
+
+std::unique_ptr<vkb::VulkanSample> create_framework_benchmarks_test();
@@ -16,7 +16,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 '''
 
-import sys, os, math, platform, threading, datetime, subprocess, zipfile, argparse, shutil, struct, imghdr
+import sys, os, math, platform, threading, datetime, subprocess, zipfile, argparse, shutil, struct, imghdr, json, re
 from time import sleep
 from threading import Thread
 
@@ -24,6 +24,10 @@ from threading import Thread
 dependencies      = ("magick", "cmake", "git", "adb")
 multithread       = False
 sub_tests         = []
+# Sub tests without a gold screenshot, they are run explicitly with --test
+benchmark_tests   = ["framework_benchmarks"]
+# Sub tests without a gold screenshot which check their own results, they pass when the application exits with 0
+exit_code_tests   = ["allocation_free_frames"]
 test_desktop      = True
 test_android      = True
 comparison_metric = "MAE"
@@ -33,15 +37,26 @@ root_path         = os.path.join(script_path, "../../")
 build_path        = ""
 build_config      = ""
 outputs_path      = "output/images/"
+logs_path         = "output/logs/"
+baselines_path    = os.path.join(script_path, "baselines/")
 tmp_path          = os.path.join(script_path, "tmp/")
 archive_path      = os.path.join(script_path, "artifacts/")
 image_ext         = ".png"
 android_timeout   = 60 # How long in seconds should we wait before timing out on Android
 check_step        = 5
 threshold         = 0.999 # How similar the images are allowed to be before they pass
+benchmark_frames  = 300 # Frames recorded by the benchmark of each sub test, 0 disables the performance test
+benchmark_warmup  = 30 # Frames run before the benchmark starts recording
+perf_tolerance    = 0.1 # How much slower than the baseline a frame time percentile may be before it fails
+perf_flag_only    = False # Report the regressions without failing the tests
+update_baselines  = False # Store the measured frame times as the baselines of the device
+frame_time_stats  = ("cpu_frame_time_ms", "gpu_frame_time_ms")
+percentiles       = ("p50", "p95")
+baseline_lock     = threading.Lock()
 
 class Subtest:
     result = False
+    returncode = 0
     test_name = ""
     platform = ""
 
@@ -53,8 +68,10 @@ class Subtest:
         result = True
         path = root_path + application_path
         arguments = ["--test", "{}".format(self.test_name), "--headless"]
+        if benchmark_frames > 0 and self.test_name not in exit_code_tests:
+            arguments += ["--benchmark", str(benchmark_frames + benchmark_warmup), "--warmup", str(benchmark_warmup), "--benchmark-report", self.get_report_name()]
         try:
-            subprocess.run([path] + arguments, cwd=root_path)
+            self.returncode = subprocess.run([path] + arguments, cwd=root_path).returncode
         except FileNotFoundError:
             print("\t\t\t(Error) Couldn't find application ({})".format(path))
             result = False
@@ -66,6 +83,12 @@ class Subtest:
     def test(self):
         print("\t\t=== Test started: {} ===".format(self.test_name))
         self.result = True
+        if self.test_name in exit_code_tests:
+            if self.returncode != 0:
+                print("\t\t\t(Error) Application exited with code {}".format(self.returncode))
+                self.result = False
+            self.print_result()
+            return
         screenshot_path = tmp_path + self.platform + "/"
         try:
             shutil.move(os.path.join(root_path, outputs_path) + self.test_name + image_ext, screenshot_path + self.test_name + image_ext)
@@ -75,6 +98,19 @@ class Subtest:
             return
         if not test(self.test_name, screenshot_path):
             self.result = False
+        if benchmark_frames > 0 and self.platform != "Android":
+            report_file = screenshot_path + self.get_report_name()
+            try:
+                shutil.move(os.path.join(root_path, logs_path) + self.get_report_name(), report_file)
+            except FileNotFoundError:
+                print("\t\t\t(Error) Couldn't find benchmark report ({}), perhaps test crashed".format(os.path.join(root_path, logs_path) + self.get_report_name()))
+                self.result = False
+                return
+            if not test_performance(self.test_name, report_file):
+                self.result = False
+        self.print_result()
+
+    def print_result(self):
         if self.result:
             print("\t\t=== Passed! ===")
         else:
@@ -83,6 +119,9 @@ class Subtest:
     def passed(self):
         return self.result
 
+    def get_report_name(self):
+        return self.test_name + "_benchmark.json"
+
 class WindowsSubtest(Subtest):
     def __init__(self, test_name):
         super().__init__(test_name, "Windows")
@@ -200,6 +239,62 @@ def test(test_name, screenshot_path):
         result = True
     return result
 
+def get_baseline_file(device):
+    """
+    @brief   Gets the baseline file of a device
+    @param   device The name of the device, as written in the benchmark report
+    @return  The path to the file holding the baselines of every sub test on the device
+    """
+    return baselines_path + re.sub("[^a-z0-9]+", "_", device.lower()).strip("_") + ".json"
+
+def test_performance(test_name, report_file):
+    """
+    @brief   Compares the frame time percentiles of a benchmark report with the baseline of the device
+    @param   test_name   The name of the test, used to retrieve its baseline
+    @param   report_file The path to the benchmark report of the test
+    @return  True if no percentile is slower than the baseline by more than the tolerance
+    """
+    try:
+        with open(report_file) as file:
+            runs = json.load(file)["runs"]
+    except (OSError, ValueError, KeyError):
+        print("\t\t\t(Error) Couldn't read benchmark report ({})".format(report_file))
+        return False
+    if not runs:
+        print("\t\t\t(Error) Benchmark report has no run ({})".format(report_file))
+        return False
+    run = runs[0]
+    # The GPU frame times are null when the device has no timestamp queries
+    measured = {stat: {p: run[stat][p] for p in percentiles} for stat in frame_time_stats if run.get(stat)}
+    baseline_file = get_baseline_file(run["device"])
+    with baseline_lock:
+        baselines = {}
+        if os.path.isfile(baseline_file):
+            with open(baseline_file) as file:
+                baselines = json.load(file)
+        if update_baselines:
+            baselines[test_name] = measured
+            os.makedirs(baselines_path, exist_ok=True)
+            with open(baseline_file, "w") as file:
+                json.dump(baselines, file, indent=4, sort_keys=True)
+            print("\t\t\t(Baseline updated) '{}' in '{}'".format(test_name, baseline_file))
+            return True
+    if test_name not in baselines:
+        print("\t\t\t(Warning) No baseline for '{}' on '{}', run with --update-baselines to store one".format(test_name, run["device"]))
+        return True
+    result = True
+    for stat, values in measured.items():
+        for percentile, value in values.items():
+            baseline = baselines[test_name].get(stat, {}).get(percentile)
+            if not baseline:
+                continue
+            change = value / baseline - 1.0
+            print("\t\t\t{} {}: {:.3f} ms, baseline {:.3f} ms ({:+.1f}%)".format(stat, percentile, value, baseline, 100 * change))
+            if change > perf_tolerance:
+                print("\t\t\t(Regression) {} {} is more than {:.0f}% slower than the baseline".format(stat, percentile, 100 * perf_tolerance))
+                result = False
+    return result or perf_flag_only
+
 def execute(app):
     print("\t=== Running {} on {} ===".format(app.test_name, app.platform))
     if app.run():
@@ -220,7 +315,8 @@ def main():
     # Create tests
     apps = []
     for test_name in sub_tests:
-        if test_android:
+        # The exit code of the application is not returned by the activity
+        if test_android and test_name not in exit_code_tests:
             apps.append(create_app("Android", test_name))
         if test_desktop:
             apps.append(create_app(platform.system(), test_name))
@@ -268,19 +364,29 @@ if __name__ == "__main__":
     argparser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter, description="A simple script that runs, screenshots, and tests your apps against a pre-existing gold")
     argparser.add_argument("-B", "--build", required=True, help="relative path to the cmake build directory")
     argparser.add_argument("-C", "--config", required=True, help="build configuration to use")
-    argparser.add_argument("-S", "--subtests", default=os.listdir(os.path.join(script_path, "sub_tests")), nargs="+", help="if set the specified sub tests will be run instead")
+    argparser.add_argument("-S", "--subtests", default=[t for t in os.listdir(os.path.join(script_path, "sub_tests")) if t not in benchmark_tests], nargs="+", help="if set the specified sub tests will be run instead")
     argparser.add_argument("-P", "--parallel", action='store_true', help="flag to deploy tests in parallel")
+    argparser.add_argument("-F", "--frames", type=int, default=benchmark_frames, help="number of frames recorded by the benchmark of each sub test, 0 disables the performance test")
+    argparser.add_argument("-W", "--warmup", type=int, default=benchmark_warmup, help="number of frames run before the benchmark starts recording")
+    argparser.add_argument("-T", "--tolerance", type=float, default=perf_tolerance, help="fraction by which a frame time percentile may exceed its baseline")
+    argparser.add_argument("--flag-only", action='store_true', help="flag to report performance regressions without failing the tests")
+    argparser.add_argument("--update-baselines", action='store_true', help="flag to store the measured frame times as the baselines of the device")
     build_group = argparser.add_mutually_exclusive_group()
     build_group.add_argument("-D", "--desktop", action='store_false', help="flag to only deploy tests on desktop")
     build_group.add_argument("-A", "--android", action='store_false', help="flag to only deploy tests on android")
 
     args = vars(argparser.parse_args())
-    build_path    = args["build"]
-    build_config  = args["config"]
-    sub_tests     = args["subtests"]
-    test_desktop  = args["android"]
-    test_android  = args["desktop"]
-    multithread   = args["parallel"]
+    build_path       = args["build"]
+    build_config     = args["config"]
+    sub_tests        = args["subtests"]
+    test_desktop     = args["android"]
+    test_android     = args["desktop"]
+    multithread      = args["parallel"]
+    benchmark_frames = args["frames"]
+    benchmark_warmup = args["warmup"]
+    perf_tolerance   = args["tolerance"]
+    perf_flag_only   = args["flag_only"]
+    update_baselines = args["update_baselines"]
 
     if build_path[-1] != "/":
         build_path += "/"
@@ -0,0 +1,185 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark_runner.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <json.hpp>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkbtest
+{
+BenchmarkState::BenchmarkState(uint64_t iterations) :
+    iterations{iterations}
+{
+}
+
+bool BenchmarkState::keep_running()
+{
+	if (!started)
+	{
+		started    = true;
+		start_time = Clock::now();
+	}
+	else
+	{
+		++iteration;
+	}
+
+	if (iteration < iterations)
+	{
+		return true;
+	}
+
+	pause_timing();
+
+	return false;
+}
+
+void BenchmarkState::pause_timing()
+{
+	if (!paused)
+	{
+		elapsed += Clock::now() - start_time;
+		paused = true;
+	}
+}
+
+void BenchmarkState::resume_timing()
+{
+	if (paused)
+	{
+		start_time = Clock::now();
+		paused     = false;
+	}
+}
+
+uint64_t BenchmarkState::get_iteration() const
+{
+	return iteration;
+}
+
+uint64_t BenchmarkState::get_iterations() const
+{
+	return iterations;
+}
+
+double BenchmarkState::get_elapsed() const
+{
+	return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+BenchmarkRunner::BenchmarkRunner(double min_time, uint32_t repetitions) :
+    min_time{min_time},
+    repetitions{std::max(repetitions, 1u)}
+{
+}
+
+void BenchmarkRunner::add(const std::string &name, Function function, uint64_t max_iterations)
+{
+	benchmarks.push_back({name, std::move(function), std::max<uint64_t>(max_iterations, 1)});
+}
+
+void BenchmarkRunner::run()
+{
+	const double min_time_ns = min_time * 1e9;
+
+	for (auto &benchmark : benchmarks)
+	{
+		// Grows the iteration count until a run lasts the minimum time, as Google Benchmark does
+		uint64_t iterations = 1;
+		while (iterations < benchmark.max_iterations)
+		{
+			BenchmarkState state{iterations};
+			benchmark.function(state);
+
+			double elapsed = state.get_elapsed();
+			if (elapsed >= min_time_ns)
+			{
+				break;
+			}
+
+			double multiplier = elapsed > 0.0 ? std::min(10.0, 1.4 * min_time_ns / elapsed) : 10.0;
+			iterations        = std::min(benchmark.max_iterations, std::max(iterations + 1, static_cast<uint64_t>(iterations * multiplier)));
+		}
+
+		std::vector<double> times;
+		for (uint32_t i = 0; i < repetitions; ++i)
+		{
+			BenchmarkState state{iterations};
+			benchmark.function(state);
+
+			times.push_back(state.get_elapsed() / static_cast<double>(iterations));
+		}
+
+		Result result;
+		result.name       = benchmark.name;
+		result.iterations = iterations;
+		result.time       = vkb::BenchmarkReport::compute_statistics(std::move(times));
+
+		LOGI("Benchmark {}: {} iterations, {:.1f} ns mean, stddev {:.1f}, min {:.1f}, p50 {:.1f}",
+		     result.name, result.iterations, result.time.mean, result.time.stddev, result.time.min, result.time.p50);
+
+		results.push_back(std::move(result));
+	}
+}
+
+bool BenchmarkRunner::write_json(const std::string &filename, const std::string &device) const
+{
+	nlohmann::json report;
+
+	report["context"] = {{"device", device}, {"repetitions", repetitions}, {"min_time", min_time}};
+
+	auto benchmarks_json = nlohmann::json::array();
+	for (auto &result : results)
+	{
+		benchmarks_json.push_back({{"name", result.name},
+		                           {"iterations", result.iterations},
+		                           {"time_unit", "ns"},
+		                           {"mean", result.time.mean},
+		                           {"stddev", result.time.stddev},
+		                           {"min", result.time.min},
+		                           {"max", result.time.max},
+		                           {"p50", result.time.p50},
+		                           {"p95", result.time.p95}});
+	}
+	report["benchmarks"] = std::move(benchmarks_json);
+
+	std::ofstream file{vkb::fs::path::get(vkb::fs::path::Type::Logs) + filename, std::ios::out | std::ios::trunc};
+
+	if (!file.good())
+	{
+		LOGE("Failed to open benchmark results file: {}", filename);
+		return false;
+	}
+
+	file << report.dump(1) << "\n";
+
+	LOGI("Benchmark results written to {}", filename);
+
+	return file.good();
+}
+
+const std::vector<BenchmarkRunner::Result> &BenchmarkRunner::get_results() const
+{
+	return results;
+}
+}        // namespace vkbtest
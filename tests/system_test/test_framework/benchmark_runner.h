@@ -0,0 +1,158 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "stats/benchmark_report.h"
+
+namespace vkbtest
+{
+/**
+ * @brief Times the iterations of a benchmark, the function under test loops on keep_running()
+ */
+class BenchmarkState
+{
+  public:
+	BenchmarkState(uint64_t iterations);
+
+	/**
+	 * @brief Starts the timer on the first call and stops it after the last iteration
+	 * @return Whether another iteration has to run
+	 */
+	bool keep_running();
+
+	/**
+	 * @brief Stops the timer, the setup done until resume_timing() is not measured
+	 */
+	void pause_timing();
+
+	void resume_timing();
+
+	/**
+	 * @return The index of the current iteration
+	 */
+	uint64_t get_iteration() const;
+
+	uint64_t get_iterations() const;
+
+	/**
+	 * @return The time measured so far, in nanoseconds
+	 */
+	double get_elapsed() const;
+
+  private:
+	using Clock = std::chrono::high_resolution_clock;
+
+	uint64_t iterations;
+
+	uint64_t iteration{0};
+
+	bool started{false};
+
+	bool paused{false};
+
+	Clock::time_point start_time;
+
+	Clock::duration elapsed{0};
+};
+
+/**
+ * @brief Runs microbenchmarks in the manner of Google Benchmark and writes their results as JSON
+ *
+ * The iteration count of a benchmark grows until its run lasts the minimum time, then the
+ * benchmark is repeated with that count. The report gives the distribution of the time per
+ * iteration over the repetitions.
+ */
+class BenchmarkRunner
+{
+  public:
+	using Function = std::function<void(BenchmarkState &)>;
+
+	struct Result
+	{
+		std::string name;
+
+		uint64_t iterations{0};
+
+		// Time per iteration over the repetitions, in nanoseconds
+		vkb::BenchmarkReport::Statistics time;
+	};
+
+	/**
+	 * @param min_time Minimum duration of a repetition, in seconds
+	 * @param repetitions Number of timed repetitions of every benchmark
+	 */
+	BenchmarkRunner(double min_time = 0.1, uint32_t repetitions = 5);
+
+	/**
+	 * @brief Registers a benchmark
+	 * @param max_iterations Upper bound of the iteration count, for benchmarks creating Vulkan objects
+	 */
+	void add(const std::string &name, Function function, uint64_t max_iterations = std::numeric_limits<uint64_t>::max());
+
+	/**
+	 * @brief Runs the benchmarks in the order they were added and logs their results
+	 */
+	void run();
+
+	/**
+	 * @brief Writes the results to a JSON file in the logs directory
+	 * @param filename The name of the file
+	 * @param device Name of the GPU the benchmarks ran on
+	 * @return Whether the file was written
+	 */
+	bool write_json(const std::string &filename, const std::string &device) const;
+
+	const std::vector<Result> &get_results() const;
+
+  private:
+	struct Benchmark
+	{
+		std::string name;
+
+		Function function;
+
+		uint64_t max_iterations;
+	};
+
+	double min_time;
+
+	uint32_t repetitions;
+
+	std::vector<Benchmark> benchmarks;
+
+	std::vector<Result> results;
+};
+
+/**
+ * @brief Keeps the compiler from discarding a value computed by a benchmark
+ */
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+	static volatile const void *sink;
+	sink = &value;
+	(void) sink;
+}
+}        // namespace vkbtest
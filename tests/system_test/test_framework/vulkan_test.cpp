@@ -17,6 +17,7 @@
 
 #include "vulkan_test.h"
 
+#include "frame_capture.h"
 #include "gltf_loader.h"
 #include "gui.h"
 #include "platform/platform.h"
@@ -41,16 +42,30 @@ bool VulkanTest::prepare(vkb::Platform &platform)
 
 void VulkanTest::update(float delta_time)
 {
+	if (!captured)
+	{
+		get_frame_capture().request(get_name());
+	}
+
 	VulkanSample::update(delta_time);
 
-	screenshot(get_render_context(), get_name());
+	if (!captured)
+	{
+		get_frame_capture().flush();
+		captured = true;
+	}
 
-	end();
+	// The test exits after the first frame, unless it is benchmarked: the platform then
+	// closes it after the benchmark frames, so that the benchmark report is written
+	if (!is_benchmark_mode())
+	{
+		end();
+	}
 }
 
-void VulkanTest::end()
+void VulkanTest::end(vkb::ExitCode code)
 {
 	platform->close();
-	exit(0);
+	exit(static_cast<int>(code));
 }
 }        // namespace vkbtest
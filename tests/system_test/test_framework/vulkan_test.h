@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "platform/platform.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/components/camera.h"
 #include "vulkan_sample.h"
@@ -34,9 +35,16 @@ class VulkanTest : public vkb::VulkanSample
 
 	virtual void update(float delta_time) override;
 
-	virtual void end();
+	/**
+	 * @brief Closes the platform and exits the test
+	 * @param code The exit code of the test, telling whether it passed
+	 */
+	virtual void end(vkb::ExitCode code = vkb::ExitCode::Success);
 
   private:
 	vkb::Platform *platform;
+
+	/// Whether the screenshot of the first frame was taken
+	bool captured{false};
 };
 }        // namespace vkbtest
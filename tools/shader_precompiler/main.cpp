@@ -0,0 +1,161 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/shader_module.h"
+#include "glsl_compiler.h"
+#include "platform/filesystem.h"
+#include "spirv_cache.h"
+#include "spirv_reflection.h"
+
+/**
+ * @brief Compiles the shader variants listed in manifests to SPIRV entries
+ *        that ShaderModule loads instead of invoking glslang at runtime
+ *
+ * Usage: shader_precompiler <shaders directory> <output directory> <manifest>...
+ *
+ * Each manifest line is stage;filename;entry point;processes..., as written
+ * by SPIRVCache::get_manifest_entry(). Lines starting with '#' are ignored.
+ */
+namespace
+{
+bool read_file(const std::string &filename, std::vector<uint8_t> &data)
+{
+	std::ifstream file{filename, std::ios::in | std::ios::binary};
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	data.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+
+	return true;
+}
+
+bool write_file(const std::string &filename, const std::vector<uint8_t> &data)
+{
+	std::ofstream file{filename, std::ios::out | std::ios::binary | std::ios::trunc};
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char *>(data.data()), data.size());
+
+	return file.good();
+}
+}        // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc < 4)
+	{
+		std::cerr << "Usage: " << argv[0] << " <shaders directory> <output directory> <manifest>..." << std::endl;
+		return 1;
+	}
+
+	std::string shaders_directory{argv[1]};
+	std::string output_directory{argv[2]};
+
+	if (!vkb::fs::is_directory(output_directory))
+	{
+		vkb::fs::create_directory(output_directory);
+	}
+
+	vkb::SPIRVCache spirv_cache;
+
+	uint32_t compiled_count{0};
+	uint32_t failed_count{0};
+
+	for (int i = 3; i < argc; ++i)
+	{
+		std::ifstream manifest{argv[i]};
+
+		if (!manifest.is_open())
+		{
+			std::cerr << "Failed to open manifest " << argv[i] << std::endl;
+			++failed_count;
+			continue;
+		}
+
+		std::string line;
+		while (std::getline(manifest, line))
+		{
+			VkShaderStageFlagBits stage{};
+			std::string           filename;
+			std::string           entry_point;
+			vkb::ShaderVariant    shader_variant;
+
+			if (!spirv_cache.parse_manifest_entry(line, stage, filename, entry_point, shader_variant))
+			{
+				continue;
+			}
+
+			std::vector<uint8_t> source_data;
+			if (!read_file(shaders_directory + filename, source_data))
+			{
+				std::cerr << "Failed to read shader " << filename << std::endl;
+				++failed_count;
+				continue;
+			}
+
+			vkb::ShaderSource glsl_source{std::move(source_data)};
+
+			auto key = spirv_cache.get_key(stage, glsl_source, entry_point, shader_variant);
+
+			std::vector<uint32_t>            spirv;
+			std::vector<vkb::ShaderResource> resources;
+			std::string                      info_log;
+
+			vkb::GLSLCompiler glsl_compiler;
+			if (!glsl_compiler.compile_to_spirv(stage, glsl_source.get_data(), entry_point, shader_variant, spirv, info_log))
+			{
+				std::cerr << "Shader compilation failed for " << line << std::endl
+				          << info_log << std::endl;
+				++failed_count;
+				continue;
+			}
+
+			vkb::SPIRVReflection spirv_reflection;
+			if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+			{
+				std::cerr << "Shader reflection failed for " << line << std::endl;
+				++failed_count;
+				continue;
+			}
+
+			if (!write_file(output_directory + spirv_cache.get_filename(key), spirv_cache.encode(key, spirv, resources)))
+			{
+				std::cerr << "Failed to write " << spirv_cache.get_filename(key) << std::endl;
+				++failed_count;
+				continue;
+			}
+
+			++compiled_count;
+		}
+	}
+
+	std::cout << "Precompiled " << compiled_count << " shader variants, " << failed_count << " failed" << std::endl;
+
+	return failed_count == 0 ? 0 : 1;
+}